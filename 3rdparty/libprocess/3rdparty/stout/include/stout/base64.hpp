@@ -13,63 +13,82 @@
 #ifndef __STOUT_BASE64_HPP__
 #define __STOUT_BASE64_HPP__
 
-#include <cctype>
-#include <functional>
+#include <stdint.h>
+
+#include <algorithm>
 #include <string>
 
-#include <stout/foreach.hpp>
 #include <stout/stringify.hpp>
 #include <stout/try.hpp>
 
 namespace base64 {
 
-// This slightly modified base64 implementation from
-// cplusplus.com answer by modoran can be found at:
-// http://www.cplusplus.com/forum/beginner/51572/
-
 static const std::string chars =
   "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
   "abcdefghijklmnopqrstuvwxyz"
   "0123456789+/";
 
 
+namespace internal {
+
+// Value of each base64 character for decoding, or -1 for characters
+// that are not part of the alphabet.
+static const signed char values[256] = {
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
+  52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+  -1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+  15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+  -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+  41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+  -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+} // namespace internal {
+
+
+// Encodes the string, padding the result with '=' to a multiple of
+// 4 characters. The result is written in place into a preallocated
+// string, 3 bytes of input (i.e., 4 characters of output) at a time.
 inline std::string encode(const std::string& s)
 {
-  std::string result;
-  int i = 0;
-  int j = 0;
-  unsigned char array3[3];
-  unsigned char array4[4];
-  const char* bytesToEncode = s.c_str();
-  size_t length = s.size();
-
-  while (length--) {
-    array3[i++] = *(bytesToEncode++);
-    if (i == 3) {
-      array4[0] = (array3[0] & 0xfc) >> 2;
-      array4[1] = ((array3[0] & 0x03) << 4) + ((array3[1] & 0xf0) >> 4);
-      array4[2] = ((array3[1] & 0x0f) << 2) + ((array3[2] & 0xc0) >> 6);
-      array4[3] = array3[2] & 0x3f;
-      for (i = 0; i < 4; i++) {
-        result += chars[array4[i]];
-      }
-      i = 0;
-    }
+  const unsigned char* input =
+    reinterpret_cast<const unsigned char*>(s.data());
+  const size_t length = s.size();
+
+  std::string result(((length + 2) / 3) * 4, '=');
+  char* output = &result[0];
+
+  size_t i = 0;
+  for (; i + 3 <= length; i += 3) {
+    const uint32_t block =
+      (input[i] << 16) | (input[i + 1] << 8) | input[i + 2];
+
+    *output++ = chars[(block >> 18) & 0x3f];
+    *output++ = chars[(block >> 12) & 0x3f];
+    *output++ = chars[(block >> 6) & 0x3f];
+    *output++ = chars[block & 0x3f];
   }
 
-  if (i != 0) {
-    for (j = i; j < 3; j++) {
-      array3[j] = '\0';
+  // Encode the remaining 1 or 2 bytes, the padding is already there.
+  if (i < length) {
+    uint32_t block = input[i] << 16;
+    if (i + 1 < length) {
+      block |= input[i + 1] << 8;
     }
-    array4[0] = (array3[0] & 0xfc) >> 2;
-    array4[1] = ((array3[0] & 0x03) << 4) + ((array3[1] & 0xf0) >> 4);
-    array4[2] = ((array3[1] & 0x0f) << 2) + ((array3[2] & 0xc0) >> 6);
-    array4[3] = array3[2] & 0x3f;
-    for (j = 0; j < i + 1; j++) {
-      result += chars[array4[j]];
-    }
-    while (i++ < 3) {
-      result += '=';
+
+    *output++ = chars[(block >> 18) & 0x3f];
+    *output++ = chars[(block >> 12) & 0x3f];
+    if (i + 1 < length) {
+      *output++ = chars[(block >> 6) & 0x3f];
     }
   }
 
@@ -77,59 +96,46 @@ inline std::string encode(const std::string& s)
 }
 
 
+// Decodes the string, which may or may not be padded. Decoding stops
+// at the first '=' character.
 inline Try<std::string> decode(const std::string& s)
 {
-  auto isBase64 = [](unsigned char c) -> bool {
-    return (isalnum(c) || (c == '+') || (c == '/'));
-  };
+  // TODO(bmahler): Note that this does not validate that there are
+  // the correct number of '=' characters!
+  const size_t length = std::min(s.find('='), s.size());
 
-  size_t i = 0;
-  unsigned char array3[3];
-  unsigned char array4[4];
   std::string result;
+  result.reserve((length / 4) * 3 + 2);
 
-  foreach (unsigned char c, s) {
-    if (c == '=') {
-      // TODO(bmahler): Note that this does not validate that
-      // there are the correct number of '=' characters!
-      break; // Reached the padding.
-    }
+  uint32_t block = 0;
+  size_t count = 0;
 
-    if (!isBase64(c)) {
+  for (size_t i = 0; i < length; i++) {
+    const unsigned char c = s[i];
+    const signed char value = internal::values[c];
+
+    if (value < 0) {
       return Error("Invalid character '" + stringify(c) + "'");
     }
 
-    array4[i++] = c;
-
-    if (i == 4) {
-      for (i = 0; i < 4; i++) {
-        array4[i] = static_cast<unsigned char>(chars.find(array4[i]));
-      }
-      array3[0] = (array4[0] << 2) + ((array4[1] & 0x30) >> 4);
-      array3[1] = ((array4[1] & 0xf) << 4) + ((array4[2] & 0x3c) >> 2);
-      array3[2] = ((array4[2] & 0x3) << 6) + array4[3];
-      for (i = 0; i < 3; i++) {
-        result += array3[i];
-      }
-      i = 0;
+    block = (block << 6) | value;
+
+    if (++count == 4) {
+      result += static_cast<char>((block >> 16) & 0xff);
+      result += static_cast<char>((block >> 8) & 0xff);
+      result += static_cast<char>(block & 0xff);
+      block = 0;
+      count = 0;
     }
   }
 
-  if (i != 0) {
-    size_t j;
-
-    for (j = i; j < 4; j++) {
-      array4[j] = 0;
-    }
-    for (j = 0; j < 4; j++) {
-      array4[j] = static_cast<unsigned char>(chars.find(array4[j]));
-    }
-    array3[0] = (array4[0] << 2) + ((array4[1] & 0x30) >> 4);
-    array3[1] = ((array4[1] & 0xf) << 4) + ((array4[2] & 0x3c) >> 2);
-    array3[2] = ((array4[2] & 0x3) << 6) + array4[3];
-    for (j = 0; (j < i - 1); j++) {
-      result += array3[j];
-    }
+  // The remaining 2 or 3 characters encode 1 or 2 bytes, a single
+  // remaining character does not encode a full byte.
+  if (count == 2) {
+    result += static_cast<char>((block >> 4) & 0xff);
+  } else if (count == 3) {
+    result += static_cast<char>((block >> 10) & 0xff);
+    result += static_cast<char>((block >> 2) & 0xff);
   }
 
   return result;
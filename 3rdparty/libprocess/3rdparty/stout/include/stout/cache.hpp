@@ -13,6 +13,7 @@
 #ifndef __STOUT_CACHE_HPP__
 #define __STOUT_CACHE_HPP__
 
+#include <chrono>
 #include <functional>
 #include <iostream>
 #include <list>
@@ -22,6 +23,7 @@
 
 #include <glog/logging.h>
 
+#include "duration.hpp"
 #include "none.hpp"
 #include "option.hpp"
 
@@ -35,16 +37,43 @@ std::ostream& operator<<(std::ostream& stream, const Cache<Key, Value>& c);
 
 
 // Provides a least-recently used (LRU) cache of some predefined
-// capacity. A "write" and a "read" both count as uses.
+// capacity. A "write" and a "read" both count as uses. Optionally,
+// values expire after a time to live (TTL) since they were written,
+// e.g., for values that are derived from state that might change.
 template <typename Key, typename Value>
 class Cache
 {
 public:
   typedef std::list<Key> list;
-  typedef std::unordered_map<
-    Key, std::pair<Value, typename list::iterator>> map;
 
-  explicit Cache(size_t _capacity) : capacity(_capacity) {}
+  struct Entry
+  {
+    Value value;
+
+    // "Pointer" into the lru list.
+    typename list::iterator position;
+
+    // When the value expires, if the cache has a TTL.
+    std::chrono::steady_clock::time_point deadline;
+  };
+
+  typedef std::unordered_map<Key, Entry> map;
+
+  // Counts the lookups that did (not) find a value, as well as the
+  // values that were evicted to make room for others and those that
+  // were found to have expired.
+  struct Statistics
+  {
+    Statistics() : hits(0), misses(0), evictions(0), expirations(0) {}
+
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    size_t expirations;
+  };
+
+  explicit Cache(size_t _capacity, const Option<Duration>& _ttl = None())
+    : capacity(_capacity), ttl(_ttl) {}
 
   void put(const Key& key, const Value& value)
   {
@@ -52,7 +81,8 @@ public:
     if (i == values.end()) {
       insert(key, value);
     } else {
-      (*i).second.first = value;
+      (*i).second.value = value;
+      (*i).second.deadline = deadline();
       use(i);
     }
   }
@@ -61,11 +91,20 @@ public:
   {
     typename map::iterator i = values.find(key);
 
+    if (i != values.end() && expired(i)) {
+      keys.erase(i->second.position);
+      values.erase(i);
+      i = values.end();
+      stats.expirations++;
+    }
+
     if (i != values.end()) {
       use(i);
-      return (*i).second.first;
+      stats.hits++;
+      return (*i).second.value;
     }
 
+    stats.misses++;
     return None();
   }
 
@@ -74,8 +113,8 @@ public:
     typename map::iterator i = values.find(key);
 
     if (i != values.end()) {
-      Value value = i->second.first;
-      keys.erase(i->second.second);
+      Value value = i->second.value;
+      keys.erase(i->second.position);
       values.erase(i);
       return value;
     }
@@ -83,8 +122,18 @@ public:
     return None();
   }
 
+  void clear()
+  {
+    values.clear();
+    keys.clear();
+  }
+
+  // NOTE: This includes the values that expired but were not looked
+  // up or evicted since.
   size_t size() const { return keys.size(); }
 
+  const Statistics& statistics() const { return stats; }
+
 private:
   // Not copyable, not assignable.
   Cache(const Cache&);
@@ -106,17 +155,17 @@ private:
     typename list::iterator i = keys.insert(keys.end(), key);
 
     // Save key/value and "pointer" into lru list.
-    values.insert(std::make_pair(key, std::make_pair(value, i)));
+    values.insert(std::make_pair(key, Entry{value, i, deadline()}));
   }
 
   // Updates the LRU ordering in the cache for the given iterator.
   void use(const typename map::iterator& i)
   {
     // Move the "pointer" to the end of the lru list.
-    keys.splice(keys.end(), keys, (*i).second.second);
+    keys.splice(keys.end(), keys, (*i).second.position);
 
     // Now update the "pointer" so we can do this again.
-    (*i).second.second = --keys.end();
+    (*i).second.position = --keys.end();
   }
 
   // Evict the least-recently used element from the cache.
@@ -126,16 +175,39 @@ private:
     CHECK(i != values.end());
     values.erase(i);
     keys.pop_front();
+    stats.evictions++;
+  }
+
+  // Returns when a value written now expires.
+  std::chrono::steady_clock::time_point deadline() const
+  {
+    if (ttl.isNone()) {
+      return std::chrono::steady_clock::time_point::max();
+    }
+
+    return std::chrono::steady_clock::now() +
+      std::chrono::nanoseconds(ttl.get().ns());
+  }
+
+  bool expired(const typename map::iterator& i) const
+  {
+    return ttl.isSome() &&
+      (*i).second.deadline <= std::chrono::steady_clock::now();
   }
 
   // Size of the cache.
   const size_t capacity;
 
+  // Time to live of the values, if any.
+  const Option<Duration> ttl;
+
   // Cache of values and "pointers" into the least-recently used list.
   map values;
 
   // Keys ordered by least-recently used.
   list keys;
+
+  Statistics stats;
 };
 
 
@@ -148,7 +220,7 @@ std::ostream& operator<<(std::ostream& stream, const Cache<Key, Value>& c)
     typename Cache<Key, Value>::map::const_iterator i2;
     i2 = c.values.find(*i1);
     CHECK(i2 != c.values.end());
-    stream << *i2 << std::endl;
+    stream << i2->second.value << std::endl;
   }
   return stream;
 }
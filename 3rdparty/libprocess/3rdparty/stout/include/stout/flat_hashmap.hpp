@@ -0,0 +1,574 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __STOUT_FLAT_HASHMAP_HPP__
+#define __STOUT_FLAT_HASHMAP_HPP__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <list>
+#include <map>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "foreach.hpp"
+#include "hashset.hpp"
+#include "none.hpp"
+#include "option.hpp"
+
+
+// Provides a hash map with the interface of 'hashmap' that stores its
+// entries in a single array using open addressing with linear probing,
+// rather than in a node per entry like 'std::unordered_map'. This
+// saves an allocation per insertion and makes lookups and iterations
+// cache friendly, which pays off for frequently accessed maps of
+// small entries (e.g., ids to pointers).
+//
+// NOTE: Unlike with 'hashmap', an insertion invalidates all iterators
+// and references into the map if it grows the map (see 'reserve').
+// An erasure only invalidates the iterators and references to the
+// erased entry, just like with 'hashmap', so erasing entries while
+// iterating over the map works the same way.
+template <typename Key,
+          typename Value,
+          typename Hash = std::hash<Key>,
+          typename Equal = std::equal_to<Key>>
+class flat_hashmap
+{
+public:
+  typedef Key key_type;
+  typedef Value mapped_type;
+  typedef std::pair<const Key, Value> value_type;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef Hash hasher;
+  typedef Equal key_equal;
+  typedef value_type& reference;
+  typedef const value_type& const_reference;
+
+private:
+  template <typename Map, typename T>
+  class Iterator : public std::iterator<std::forward_iterator_tag, T>
+  {
+  public:
+    Iterator() : map(NULL), index(0) {}
+
+    // Allows converting an 'iterator' into a 'const_iterator'.
+    template <typename M,
+              typename U,
+              typename = typename std::enable_if<
+                  std::is_convertible<U*, T*>::value>::type>
+    Iterator(const Iterator<M, U>& that) : map(that.map), index(that.index) {}
+
+    T& operator*() const { return map->entry(index); }
+    T* operator->() const { return &map->entry(index); }
+
+    Iterator& operator++()
+    {
+      index = map->next(index + 1);
+      return *this;
+    }
+
+    Iterator operator++(int)
+    {
+      Iterator result = *this;
+      ++(*this);
+      return result;
+    }
+
+    bool operator==(const Iterator& that) const { return index == that.index; }
+    bool operator!=(const Iterator& that) const { return index != that.index; }
+
+  private:
+    friend class flat_hashmap;
+
+    template <typename M, typename U>
+    friend class Iterator;
+
+    Iterator(Map* _map, size_t _index) : map(_map), index(_index) {}
+
+    Map* map;
+    size_t index;
+  };
+
+public:
+  typedef Iterator<flat_hashmap, value_type> iterator;
+  typedef Iterator<const flat_hashmap, const value_type> const_iterator;
+
+  // An explicit default constructor is needed so
+  // 'const flat_hashmap<T> map;' is not an error.
+  flat_hashmap() : entries(0), tombstones(0) {}
+
+  flat_hashmap(const flat_hashmap& that) : entries(0), tombstones(0)
+  {
+    reserve(that.size());
+    for (auto iterator = that.begin(); iterator != that.end(); ++iterator) {
+      emplace(*iterator);
+    }
+  }
+
+  flat_hashmap(flat_hashmap&& that)
+    : states(std::move(that.states)),
+      slots(std::move(that.slots)),
+      entries(that.entries),
+      tombstones(that.tombstones)
+  {
+    that.states.clear();
+    that.slots.clear();
+    that.entries = 0;
+    that.tombstones = 0;
+  }
+
+  // An implicit constructor for converting from a std::map.
+  flat_hashmap(const std::map<Key, Value>& map) : entries(0), tombstones(0)
+  {
+    reserve(map.size());
+    for (auto iterator = map.begin(); iterator != map.end(); ++iterator) {
+      emplace(iterator->first, iterator->second);
+    }
+  }
+
+  // Allow simple construction via initializer list.
+  flat_hashmap(std::initializer_list<std::pair<Key, Value>> list)
+    : entries(0), tombstones(0)
+  {
+    reserve(list.size());
+    for (auto iterator = list.begin(); iterator != list.end(); ++iterator) {
+      emplace(iterator->first, iterator->second);
+    }
+  }
+
+  ~flat_hashmap()
+  {
+    destroy();
+  }
+
+  flat_hashmap& operator=(const flat_hashmap& that)
+  {
+    if (this != &that) {
+      flat_hashmap copy(that);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  flat_hashmap& operator=(flat_hashmap&& that)
+  {
+    if (this != &that) {
+      clear();
+      swap(that);
+    }
+    return *this;
+  }
+
+  void swap(flat_hashmap& that)
+  {
+    states.swap(that.states);
+    slots.swap(that.slots);
+    std::swap(entries, that.entries);
+    std::swap(tombstones, that.tombstones);
+  }
+
+  iterator begin() { return iterator(this, next(0)); }
+  iterator end() { return iterator(this, capacity()); }
+
+  const_iterator begin() const { return const_iterator(this, next(0)); }
+  const_iterator end() const { return const_iterator(this, capacity()); }
+
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  size_t size() const { return entries; }
+  bool empty() const { return entries == 0; }
+
+  iterator find(const Key& key)
+  {
+    return iterator(this, lookup(key));
+  }
+
+  const_iterator find(const Key& key) const
+  {
+    return const_iterator(this, lookup(key));
+  }
+
+  size_t count(const Key& key) const
+  {
+    return lookup(key) != capacity() ? 1 : 0;
+  }
+
+  Value& at(const Key& key)
+  {
+    const size_t index = lookup(key);
+    if (index == capacity()) {
+      throw std::out_of_range("flat_hashmap::at");
+    }
+    return entry(index).second;
+  }
+
+  const Value& at(const Key& key) const
+  {
+    const size_t index = lookup(key);
+    if (index == capacity()) {
+      throw std::out_of_range("flat_hashmap::at");
+    }
+    return entry(index).second;
+  }
+
+  Value& operator[](const Key& key)
+  {
+    const size_t index = lookup(key);
+    if (index != capacity()) {
+      return entry(index).second;
+    }
+    return _insert(Entry(key, Value())).first->second;
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value)
+  {
+    return _insert(Entry(value.first, value.second));
+  }
+
+  std::pair<iterator, bool> insert(value_type&& value)
+  {
+    return _insert(Entry(value.first, std::move(value.second)));
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args&&... args)
+  {
+    return _insert(Entry(std::forward<Args>(args)...));
+  }
+
+  iterator erase(const_iterator position)
+  {
+    const size_t index = position.index;
+
+    stored(index).~Entry();
+    entries--;
+
+    // If the next slot is empty no probe continues past this slot,
+    // so we don't need to leave a "tombstone" behind.
+    if (states[(index + 1) & (capacity() - 1)] == EMPTY) {
+      states[index] = EMPTY;
+    } else {
+      states[index] = DELETED;
+      tombstones++;
+    }
+
+    return iterator(this, next(index + 1));
+  }
+
+  iterator erase(iterator position)
+  {
+    return erase(const_iterator(position));
+  }
+
+  size_t erase(const Key& key)
+  {
+    const size_t index = lookup(key);
+    if (index == capacity()) {
+      return 0;
+    }
+
+    erase(const_iterator(this, index));
+    return 1;
+  }
+
+  void clear()
+  {
+    destroy();
+    std::fill(states.begin(), states.end(), EMPTY);
+    entries = 0;
+    tombstones = 0;
+  }
+
+  // Makes room for 'size' entries, i.e., inserting up to 'size'
+  // entries will not invalidate any iterators or references.
+  void reserve(size_t size)
+  {
+    if (size > 0 && capacityFor(size) > capacity()) {
+      rehash(capacityFor(size));
+    }
+  }
+
+  bool operator==(const flat_hashmap& that) const
+  {
+    if (size() != that.size()) {
+      return false;
+    }
+
+    for (auto iterator = begin(); iterator != end(); ++iterator) {
+      const size_t index = that.lookup(iterator->first);
+      if (index == that.capacity() ||
+          !(that.entry(index).second == iterator->second)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  bool operator!=(const flat_hashmap& that) const
+  {
+    return !(*this == that);
+  }
+
+  // Checks whether this map contains a binding for a key.
+  bool contains(const Key& key) const
+  {
+    return lookup(key) != capacity();
+  }
+
+  // Checks whether there exists a bound value in this map.
+  bool containsValue(const Value& v) const
+  {
+    foreachvalue (const Value& value, *this) {
+      if (value == v) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Inserts a key, value pair into the map replacing an old value
+  // if the key is already present.
+  void put(const Key& key, const Value& value)
+  {
+    const size_t index = lookup(key);
+    if (index != capacity()) {
+      entry(index).second = value;
+    } else {
+      _insert(Entry(key, value));
+    }
+  }
+
+  // Returns an Option for the binding to the key.
+  Option<Value> get(const Key& key) const
+  {
+    const size_t index = lookup(key);
+    if (index == capacity()) {
+      return None();
+    }
+    return entry(index).second;
+  }
+
+  // Returns the set of keys in this map.
+  hashset<Key> keys() const
+  {
+    hashset<Key> result;
+    result.reserve(size());
+    foreachkey (const Key& key, *this) {
+      result.insert(key);
+    }
+    return result;
+  }
+
+  // Returns the list of values in this map.
+  std::list<Value> values() const
+  {
+    std::list<Value> result;
+    foreachvalue (const Value& value, *this) {
+      result.push_back(value);
+    }
+    return result;
+  }
+
+private:
+  // We store a 'std::pair<Key, Value>' in each slot so that growing the
+  // map can move the keys, but we hand out references to them as a
+  // 'std::pair<const Key, Value>' (which has the same layout) so that
+  // the keys can't be modified.
+  typedef std::pair<Key, Value> Entry;
+
+  typedef typename std::aligned_storage<
+      sizeof(Entry), std::alignment_of<Entry>::value>::type Slot;
+
+  // The state of a slot is either empty, erased, or (if the high bit
+  // is set) the top 7 bits of the hash of its entry, which lets the
+  // probing skip most of the entries with a different key without
+  // comparing the keys.
+  enum : uint8_t
+  {
+    EMPTY = 0,
+    DELETED = 1,
+    FULL = 0x80
+  };
+
+  static bool full(uint8_t state) { return (state & FULL) != 0; }
+
+  static uint8_t tag(uint64_t hash) { return FULL | (hash >> 57); }
+
+  size_t capacity() const { return states.size(); }
+
+  Entry& stored(size_t index)
+  {
+    return *reinterpret_cast<Entry*>(&slots[index]);
+  }
+
+  value_type& entry(size_t index)
+  {
+    return *reinterpret_cast<value_type*>(&slots[index]);
+  }
+
+  const value_type& entry(size_t index) const
+  {
+    return *reinterpret_cast<const value_type*>(&slots[index]);
+  }
+
+  // Returns the index of the first entry at or after 'index', or the
+  // capacity if there is none.
+  size_t next(size_t index) const
+  {
+    while (index < capacity() && !full(states[index])) {
+      index++;
+    }
+    return index;
+  }
+
+  // Returns the hash of the key. It is mixed since we use its lower
+  // bits to pick the slot and its upper bits for the state, while
+  // 'std::hash' is the identity for integers.
+  static uint64_t hash(const Key& key)
+  {
+    uint64_t hash = Hash()(key);
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+  }
+
+  size_t lookup(const Key& key) const
+  {
+    return entries == 0 ? capacity() : lookup(key, hash(key));
+  }
+
+  // Returns the index of the entry for the key, or the capacity if
+  // there is none.
+  size_t lookup(const Key& key, uint64_t hash) const
+  {
+    if (entries == 0) {
+      return capacity();
+    }
+
+    const size_t mask = capacity() - 1;
+    const uint8_t state = tag(hash);
+
+    for (size_t index = hash & mask; ; index = (index + 1) & mask) {
+      if (states[index] == EMPTY) {
+        return capacity();
+      } else if (states[index] == state && Equal()(entry(index).first, key)) {
+        return index;
+      }
+    }
+  }
+
+  std::pair<iterator, bool> _insert(Entry&& entry)
+  {
+    const uint64_t hash = flat_hashmap::hash(entry.first);
+
+    const size_t index = lookup(entry.first, hash);
+    if (index != capacity()) {
+      return std::make_pair(iterator(this, index), false);
+    }
+
+    // Grow (or purge the tombstones) to keep the load factor below
+    // 3/4, which also guarantees that there is at least one empty
+    // slot to terminate the probing in 'lookup'.
+    if ((entries + tombstones + 1) * 4 > capacity() * 3) {
+      rehash(capacityFor((entries + 1) * 2));
+    }
+
+    return std::make_pair(
+        iterator(this, place(std::move(entry), hash)),
+        true);
+  }
+
+  // Moves the entry (whose key must not be in the map) into the first
+  // free slot of its probe sequence, which must exist.
+  size_t place(Entry&& entry, uint64_t hash)
+  {
+    const size_t mask = capacity() - 1;
+
+    size_t index = hash & mask;
+    while (full(states[index])) {
+      index = (index + 1) & mask;
+    }
+
+    if (states[index] == DELETED) {
+      tombstones--;
+    }
+
+    new (&slots[index]) Entry(std::move(entry));
+    states[index] = tag(hash);
+    entries++;
+
+    return index;
+  }
+
+  // Returns the smallest capacity that keeps 'size' entries within
+  // the maximum load factor.
+  static size_t capacityFor(size_t size)
+  {
+    size_t capacity = 8;
+    while (size * 4 > capacity * 3) {
+      capacity *= 2;
+    }
+    return capacity;
+  }
+
+  void rehash(size_t _capacity)
+  {
+    std::vector<uint8_t> _states(_capacity, EMPTY);
+    std::vector<Slot> _slots(_capacity);
+
+    _states.swap(states);
+    _slots.swap(slots);
+
+    entries = 0;
+    tombstones = 0;
+
+    for (size_t index = 0; index < _states.size(); index++) {
+      if (full(_states[index])) {
+        Entry* entry = reinterpret_cast<Entry*>(&_slots[index]);
+        place(std::move(*entry), hash(entry->first));
+        entry->~Entry();
+      }
+    }
+  }
+
+  void destroy()
+  {
+    for (size_t index = 0; index < capacity(); index++) {
+      if (full(states[index])) {
+        stored(index).~Entry();
+      }
+    }
+  }
+
+  std::vector<uint8_t> states;
+  std::vector<Slot> slots;
+
+  // Number of entries, and of slots of erased entries ("tombstones")
+  // that are not empty so that the probing continues past them.
+  size_t entries;
+  size_t tombstones;
+};
+
+#endif // __STOUT_FLAT_HASHMAP_HPP__
@@ -22,6 +22,10 @@
 #include <picojson.h>
 #define __STDC_FORMAT_MACROS
 
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdlib>
 #include <iomanip>
 #include <iostream>
 #include <limits>
@@ -36,8 +40,10 @@
 
 #include <stout/check.hpp>
 #include <stout/foreach.hpp>
+#include <stout/nothing.hpp>
 #include <stout/numify.hpp>
 #include <stout/result.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
 #include <stout/unreachable.hpp>
@@ -617,27 +623,41 @@ inline std::ostream& operator<<(std::ostream& out, const String& string)
 }
 
 
+namespace internal {
+
+// Returns the JSON of a floating point value.
+inline std::string format(double value)
+{
+  // Prints a floating point value, with the specified precision, see:
+  // http://www.open-std.org/jtc1/sc22/wg21/docs/papers/2006/n2005.pdf
+  // Additionally ensures that a decimal point is in the output.
+  char buffer[50] {}; // More than long enough for the specified precision.
+  snprintf(
+      buffer,
+      sizeof(buffer),
+      "%#.*g",
+      std::numeric_limits<double>::digits10,
+      value);
+
+  // Get rid of excess trailing zeroes before outputting.
+  // Otherwise, printing 1.0 would result in "1.00000000000000".
+  // NOTE: valid JSON numbers cannot end with a '.'.
+  std::string trimmed = strings::trim(buffer, strings::SUFFIX, "0");
+  if (trimmed.back() == '.') {
+    trimmed += "0";
+  }
+
+  return trimmed;
+}
+
+} // namespace internal {
+
+
 inline std::ostream& operator<<(std::ostream& out, const Number& number)
 {
   switch (number.type) {
-    case Number::FLOATING: {
-      // Prints a floating point value, with the specified precision, see:
-      // http://www.open-std.org/jtc1/sc22/wg21/docs/papers/2006/n2005.pdf
-      // Additionally ensures that a decimal point is in the output.
-      char buffer[50] {}; // More than long enough for the specified precision.
-      snprintf(
-          buffer,
-          sizeof(buffer),
-          "%#.*g",
-          std::numeric_limits<double>::digits10,
-          number.value);
-
-      // Get rid of excess trailing zeroes before outputting.
-      // Otherwise, printing 1.0 would result in "1.00000000000000".
-      // NOTE: valid JSON numbers cannot end with a '.'.
-      std::string trimmed = strings::trim(buffer, strings::SUFFIX, "0");
-      return out << trimmed << (trimmed.back() == '.' ? "0" : "");
-    }
+    case Number::FLOATING:
+      return out << internal::format(number.value);
     case Number::SIGNED_INTEGER:
       return out << number.signed_integer;
     case Number::UNSIGNED_INTEGER:
@@ -697,44 +717,11 @@ inline std::ostream& operator<<(std::ostream& out, const Null&)
 
 namespace internal {
 
-inline Value convert(const picojson::value& value)
-{
-  if (value.is<picojson::null>()) {
-    return Null();
-  } else if (value.is<bool>()) {
-    return Boolean(value.get<bool>());
-  } else if (value.is<picojson::value::object>()) {
-    Object object;
-    foreachpair (const std::string& name,
-                 const picojson::value& value,
-                 value.get<picojson::value::object>()) {
-      object.values[name] = convert(value);
-    }
-    return object;
-  } else if (value.is<picojson::value::array>()) {
-    Array array;
-    foreach (const picojson::value& value,
-             value.get<picojson::value::array>()) {
-      array.values.push_back(convert(value));
-    }
-    return array;
-  } else if (value.is<int64_t>()) {
-    return Number(value.get<int64_t>());
-  } else if (value.is<double>()) {
-    return Number(value.get<double>());
-  } else if (value.is<std::string>()) {
-    return String(value.get<std::string>());
-  }
-  return Null();
-}
-
-} // namespace internal {
-
-
-inline Try<Value> parse(const std::string& s)
+// Parses the string into a picojson::value. Used to parse strings
+// directly into protobuf messages (see stout/protobuf.hpp).
+inline Try<Nothing> parse(const std::string& s, picojson::value* value)
 {
   const char* parseBegin = s.c_str();
-  picojson::value value;
   std::string error;
 
   // Because PicoJson supports repeated parsing of multiple objects/arrays in a
@@ -746,7 +733,7 @@ inline Try<Value> parse(const std::string& s)
   // Parse the string, returning a pointer to the character
   // immediately following the last one parsed.
   const char* parseEnd =
-    picojson::parse(value, parseBegin, parseBegin + s.size(), &error);
+    picojson::parse(*value, parseBegin, parseBegin + s.size(), &error);
 
   if (!error.empty()) {
     return Error(error);
@@ -756,7 +743,355 @@ inline Try<Value> parse(const std::string& s)
         + s.substr(parseEnd - parseBegin, lastVisibleChar + 1 - parseEnd));
   }
 
-  return internal::convert(value);
+  return Nothing();
+}
+
+} // namespace internal {
+
+
+namespace internal {
+
+// A single pass recursive descent parser which builds the JSON::Value
+// in place, rather than parsing into a picojson::value first and then
+// converting it. It accepts the same documents as picojson and reports
+// the same errors, so the two are interchangeable. Strings are copied
+// in runs of unescaped characters rather than character by character.
+class Parser
+{
+public:
+  Parser(const char* _begin, const char* _end)
+    : begin(_begin), cursor(_begin), end(_end) {}
+
+  Try<Nothing> parse(Value* out)
+  {
+    if (!value(out)) {
+      return Error(error());
+    }
+
+    // Like picojson we stop after the first value, but we would rather
+    // return an error than quietly ignore any trailing characters.
+    const char* last = cursor;
+    whitespace();
+    if (cursor != end) {
+      const std::string rest(last, end);
+      return Error(
+          "Parsed JSON included non-whitespace trailing characters: " +
+          rest.substr(0, rest.find_last_not_of(strings::WHITESPACE) + 1));
+    }
+
+    return Nothing();
+  }
+
+private:
+  bool value(Value* out)
+  {
+    whitespace();
+
+    if (cursor == end) {
+      return false;
+    }
+
+    switch (*cursor) {
+      case 'n':
+        if (!match("null")) {
+          return false;
+        }
+        *out = Null();
+        return true;
+      case 'f':
+        if (!match("false")) {
+          return false;
+        }
+        *out = Boolean(false);
+        return true;
+      case 't':
+        if (!match("true")) {
+          return false;
+        }
+        *out = Boolean(true);
+        return true;
+      case '"':
+        ++cursor;
+        *out = String();
+        return string(&boost::get<String>(*out).value);
+      case '[':
+        ++cursor;
+        return array(out);
+      case '{':
+        ++cursor;
+        return object(out);
+      default:
+        if (('0' <= *cursor && *cursor <= '9') || *cursor == '-') {
+          return number(out);
+        }
+        return false;
+    }
+  }
+
+  bool object(Value* out)
+  {
+    *out = Object();
+    std::map<std::string, Value>& values = boost::get<Object>(*out).values;
+
+    if (expect('}')) {
+      return true;
+    }
+
+    // NOTE: As with picojson, the last value of a duplicate key wins.
+    std::string key;
+    do {
+      key.clear();
+      if (!expect('"') || !string(&key) || !expect(':')) {
+        return false;
+      }
+
+      if (!value(&values[key])) {
+        return false;
+      }
+    } while (expect(','));
+
+    return expect('}');
+  }
+
+  bool array(Value* out)
+  {
+    *out = Array();
+    std::vector<Value>& values = boost::get<Array>(*out).values;
+
+    if (expect(']')) {
+      return true;
+    }
+
+    do {
+      values.push_back(Value());
+      if (!value(&values.back())) {
+        return false;
+      }
+    } while (expect(','));
+
+    return expect(']');
+  }
+
+  // Parses the rest of a string whose opening quote has been consumed.
+  bool string(std::string* out)
+  {
+    while (true) {
+      const char* run = cursor;
+      while (cursor != end &&
+             *cursor != '"' &&
+             *cursor != '\\' &&
+             static_cast<unsigned char>(*cursor) >= ' ') {
+        ++cursor;
+      }
+
+      out->append(run, cursor - run);
+
+      // Control characters must be escaped.
+      if (cursor == end || (*cursor != '"' && *cursor != '\\')) {
+        return false;
+      }
+
+      if (*cursor++ == '"') {
+        return true;
+      }
+
+      if (cursor == end) {
+        return false;
+      }
+
+      switch (*cursor++) {
+        case '"':  out->push_back('"');  break;
+        case '\\': out->push_back('\\'); break;
+        case '/':  out->push_back('/');  break;
+        case 'b':  out->push_back('\b'); break;
+        case 'f':  out->push_back('\f'); break;
+        case 'n':  out->push_back('\n'); break;
+        case 'r':  out->push_back('\r'); break;
+        case 't':  out->push_back('\t'); break;
+        case 'u':
+          if (!codepoint(out)) {
+            return false;
+          }
+          break;
+        default:
+          --cursor;
+          return false;
+      }
+    }
+  }
+
+  // Decodes the code point of a '\\u' escape, which might be the first
+  // half of a UTF-16 surrogate pair, into UTF-8.
+  bool codepoint(std::string* out)
+  {
+    int code;
+    if (!quadhex(&code)) {
+      return false;
+    }
+
+    if (0xd800 <= code && code <= 0xdfff) {
+      // A second half of a surrogate pair without the first one.
+      if (code >= 0xdc00) {
+        return false;
+      }
+
+      if (end - cursor < 2 || cursor[0] != '\\' || cursor[1] != 'u') {
+        return false;
+      }
+
+      cursor += 2;
+
+      int second;
+      if (!quadhex(&second) || second < 0xdc00 || second > 0xdfff) {
+        return false;
+      }
+
+      code = 0x10000 + (((code - 0xd800) << 10) | (second - 0xdc00));
+    }
+
+    if (code < 0x80) {
+      out->push_back(static_cast<char>(code));
+    } else if (code < 0x800) {
+      out->push_back(static_cast<char>(0xc0 | (code >> 6)));
+      out->push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    } else if (code < 0x10000) {
+      out->push_back(static_cast<char>(0xe0 | (code >> 12)));
+      out->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+      out->push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    } else {
+      out->push_back(static_cast<char>(0xf0 | (code >> 18)));
+      out->push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3f)));
+      out->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+      out->push_back(static_cast<char>(0x80 | (code & 0x3f)));
+    }
+
+    return true;
+  }
+
+  bool quadhex(int* code)
+  {
+    *code = 0;
+    for (int i = 0; i < 4; i++, ++cursor) {
+      if (cursor == end) {
+        return false;
+      }
+
+      const char c = *cursor;
+      if ('0' <= c && c <= '9') {
+        *code = *code * 16 + (c - '0');
+      } else if ('a' <= c && c <= 'f') {
+        *code = *code * 16 + (c - 'a' + 10);
+      } else if ('A' <= c && c <= 'F') {
+        *code = *code * 16 + (c - 'A' + 10);
+      } else {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  // Like picojson, takes the longest run of characters which can be
+  // part of a number and parses it as an integer if it fits into an
+  // int64_t, or as a double otherwise.
+  bool number(Value* out)
+  {
+    const char* start = cursor;
+    while (cursor != end &&
+           (('0' <= *cursor && *cursor <= '9') ||
+            *cursor == '+' || *cursor == '-' || *cursor == '.' ||
+            *cursor == 'e' || *cursor == 'E')) {
+      ++cursor;
+    }
+
+    // The run is not null terminated, so copy it for 'strto*'.
+    const std::string text(start, cursor);
+    char* last;
+
+    errno = 0;
+    const intmax_t integer = strtoimax(text.c_str(), &last, 10);
+    if (errno == 0 && last == text.c_str() + text.size()) {
+      *out = Number(static_cast<int64_t>(integer));
+      return true;
+    }
+
+    const double floating = strtod(text.c_str(), &last);
+    if (last == text.c_str() + text.size()) {
+      *out = Number(floating);
+      return true;
+    }
+
+    cursor = start;
+    return false;
+  }
+
+  void whitespace()
+  {
+    while (cursor != end &&
+           (*cursor == ' ' ||
+            *cursor == '\t' ||
+            *cursor == '\n' ||
+            *cursor == '\r')) {
+      ++cursor;
+    }
+  }
+
+  bool expect(char c)
+  {
+    whitespace();
+    if (cursor != end && *cursor == c) {
+      ++cursor;
+      return true;
+    }
+    return false;
+  }
+
+  bool match(const char* literal)
+  {
+    for (; *literal != '\0'; ++literal, ++cursor) {
+      if (cursor == end || *cursor != *literal) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Formats the error the same way as picojson: the line of the
+  // failure and the rest of that line.
+  std::string error() const
+  {
+    const int line = 1 + std::count(begin, cursor, '\n');
+
+    std::string context;
+    for (const char* c = cursor; c != end && *c != '\n'; ++c) {
+      if (static_cast<unsigned char>(*c) >= ' ') {
+        context.push_back(*c);
+      }
+    }
+
+    return "syntax error at line " + stringify(line) + " near: " + context;
+  }
+
+  const char* const begin;
+  const char* cursor;
+  const char* const end;
+};
+
+} // namespace internal {
+
+
+inline Try<Value> parse(const std::string& s)
+{
+  Value value;
+
+  Try<Nothing> parse =
+    internal::Parser(s.data(), s.data() + s.size()).parse(&value);
+
+  if (parse.isError()) {
+    return Error(parse.error());
+  }
+
+  return value;
 }
 
 
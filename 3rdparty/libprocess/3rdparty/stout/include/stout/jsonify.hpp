@@ -0,0 +1,606 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __STOUT_JSONIFY__
+#define __STOUT_JSONIFY__
+
+#include <stdint.h>
+
+#include <functional>
+#include <iterator>
+#include <new>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <boost/variant.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/json.hpp>
+
+// Serializes values as JSON directly into a stream, rather than first
+// building a tree of JSON::Value nodes and then stringifying it. This
+// is meant for large documents (e.g., the state of a cluster) where
+// the tree would cost (much) more memory and time than the output.
+//
+// The JSON for a value of type T is written by an overload of 'json'
+// which is found via argument dependent lookup, i.e., it needs to be
+// declared in the namespace of T (or in JSON for the basic types).
+// The first argument of the overload is the writer for the JSON type
+// that gets written, for example:
+//
+//   void json(JSON::ObjectWriter* writer, const Task& task)
+//   {
+//     writer->field("id", task.task_id().value());
+//     writer->field("name", task.name());
+//     writer->field("resources", task.resources());
+//   }
+//
+// Where the resources are written by yet another overload of 'json'.
+// Fields (or elements) can also be written by any function taking an
+// ObjectWriter* (or an ArrayWriter*), e.g., a lambda:
+//
+//   writer->field("statuses", [&task](JSON::ArrayWriter* writer) {
+//     foreach (const TaskStatus& status, task.statuses()) {
+//       writer->element(status);
+//     }
+//   });
+//
+// The output of a value is produced with 'jsonify', which gets either
+// written into a stream or converted to a string:
+//
+//   std::string s = jsonify(task);
+//
+// NOTE: Fields are written in the order they get added (rather than
+// sorted by name as for JSON::Object) and are not deduplicated.
+namespace JSON {
+
+class Proxy;
+
+} // namespace JSON {
+
+
+template <typename T>
+JSON::Proxy jsonify(const T& value);
+
+
+namespace JSON {
+
+
+class BooleanWriter
+{
+public:
+  explicit BooleanWriter(std::ostream* _stream)
+    : stream(_stream), value(false) {}
+
+  ~BooleanWriter() { *stream << (value ? "true" : "false"); }
+
+  void set(bool _value) { value = _value; }
+
+private:
+  BooleanWriter(const BooleanWriter&) = delete;
+  BooleanWriter& operator=(const BooleanWriter&) = delete;
+
+  std::ostream* stream;
+  bool value;
+};
+
+
+class NumberWriter
+{
+public:
+  explicit NumberWriter(std::ostream* _stream)
+    : stream(_stream), value(0) {}
+
+  ~NumberWriter() { *stream << value; }
+
+  template <typename T>
+  void set(T _value) { value = Number(_value); }
+
+private:
+  NumberWriter(const NumberWriter&) = delete;
+  NumberWriter& operator=(const NumberWriter&) = delete;
+
+  std::ostream* stream;
+  Number value;
+};
+
+
+class StringWriter
+{
+public:
+  explicit StringWriter(std::ostream* _stream)
+    : stream(_stream), empty(true) {}
+
+  ~StringWriter()
+  {
+    if (empty) {
+      *stream << "\"\"";
+    }
+  }
+
+  // NOTE: Can only be set once.
+  void set(const std::string& value)
+  {
+    CHECK(empty);
+    empty = false;
+
+    // Use the same escaping as JSON::String.
+    picojson::serialize_str(value, std::ostreambuf_iterator<char>(*stream));
+  }
+
+private:
+  StringWriter(const StringWriter&) = delete;
+  StringWriter& operator=(const StringWriter&) = delete;
+
+  std::ostream* stream;
+  bool empty;
+};
+
+
+class NullWriter
+{
+public:
+  explicit NullWriter(std::ostream* _stream) : stream(_stream) {}
+
+  ~NullWriter() { *stream << "null"; }
+
+private:
+  NullWriter(const NullWriter&) = delete;
+  NullWriter& operator=(const NullWriter&) = delete;
+
+  std::ostream* stream;
+};
+
+
+class ArrayWriter
+{
+public:
+  explicit ArrayWriter(std::ostream* _stream)
+    : stream(_stream), count(0)
+  {
+    *stream << '[';
+  }
+
+  ~ArrayWriter() { *stream << ']'; }
+
+  template <typename T>
+  void element(const T& value);
+
+private:
+  ArrayWriter(const ArrayWriter&) = delete;
+  ArrayWriter& operator=(const ArrayWriter&) = delete;
+
+  std::ostream* stream;
+  size_t count;
+};
+
+
+class ObjectWriter
+{
+public:
+  explicit ObjectWriter(std::ostream* _stream)
+    : stream(_stream), count(0)
+  {
+    *stream << '{';
+  }
+
+  ~ObjectWriter() { *stream << '}'; }
+
+  template <typename T>
+  void field(const std::string& key, const T& value);
+
+private:
+  ObjectWriter(const ObjectWriter&) = delete;
+  ObjectWriter& operator=(const ObjectWriter&) = delete;
+
+  std::ostream* stream;
+  size_t count;
+};
+
+
+// Passed as the first argument to the 'json' overloads, where it
+// gets converted into the writer of the overload. The writer lives
+// (and thus the value is complete) until the proxy is destroyed. If
+// the proxy never gets converted it writes 'null'.
+class WriterProxy
+{
+public:
+  explicit WriterProxy(std::ostream* _stream)
+    : stream(_stream), type(NONE) {}
+
+  ~WriterProxy()
+  {
+    switch (type) {
+      case NONE: *stream << "null"; break;
+      case BOOLEAN: writer.boolean.~BooleanWriter(); break;
+      case NUMBER: writer.number.~NumberWriter(); break;
+      case STRING: writer.string.~StringWriter(); break;
+      case ARRAY: writer.array.~ArrayWriter(); break;
+      case OBJECT: writer.object.~ObjectWriter(); break;
+      case NULL_: writer.null.~NullWriter(); break;
+    }
+  }
+
+  operator BooleanWriter*() &&
+  {
+    CHECK(type == NONE);
+    type = BOOLEAN;
+    return new (&writer.boolean) BooleanWriter(stream);
+  }
+
+  operator NumberWriter*() &&
+  {
+    CHECK(type == NONE);
+    type = NUMBER;
+    return new (&writer.number) NumberWriter(stream);
+  }
+
+  operator StringWriter*() &&
+  {
+    CHECK(type == NONE);
+    type = STRING;
+    return new (&writer.string) StringWriter(stream);
+  }
+
+  operator ArrayWriter*() &&
+  {
+    CHECK(type == NONE);
+    type = ARRAY;
+    return new (&writer.array) ArrayWriter(stream);
+  }
+
+  operator ObjectWriter*() &&
+  {
+    CHECK(type == NONE);
+    type = OBJECT;
+    return new (&writer.object) ObjectWriter(stream);
+  }
+
+  operator NullWriter*() &&
+  {
+    CHECK(type == NONE);
+    type = NULL_;
+    return new (&writer.null) NullWriter(stream);
+  }
+
+private:
+  WriterProxy(const WriterProxy&) = delete;
+  WriterProxy& operator=(const WriterProxy&) = delete;
+
+  std::ostream* stream;
+
+  enum
+  {
+    NONE,
+    BOOLEAN,
+    NUMBER,
+    STRING,
+    ARRAY,
+    OBJECT,
+    NULL_
+  } type;
+
+  union Writer
+  {
+    Writer() {}
+    ~Writer() {}
+
+    BooleanWriter boolean;
+    NumberWriter number;
+    StringWriter string;
+    ArrayWriter array;
+    ObjectWriter object;
+    NullWriter null;
+  } writer;
+};
+
+
+// The 'json' overloads for the basic types.
+
+template <
+    typename T,
+    typename std::enable_if<std::is_same<T, bool>::value, int>::type = 0>
+void json(BooleanWriter* writer, const T& value)
+{
+  writer->set(value);
+}
+
+
+template <
+    typename T,
+    typename std::enable_if<
+        std::is_arithmetic<T>::value && !std::is_same<T, bool>::value,
+        int>::type = 0>
+void json(NumberWriter* writer, const T& value)
+{
+  writer->set(value);
+}
+
+
+inline void json(StringWriter* writer, const std::string& value)
+{
+  writer->set(value);
+}
+
+
+inline void json(StringWriter* writer, const char* value)
+{
+  writer->set(value);
+}
+
+
+namespace internal {
+
+// Detects whether the elements of an iterable are pairs, i.e.,
+// whether the iterable is a dictionary.
+template <typename Iterable>
+struct IsDictionary
+{
+  template <typename T>
+  static std::true_type test(
+      typename std::decay<decltype(
+          std::declval<T>().begin()->second)>::type*);
+
+  template <typename T>
+  static std::false_type test(...);
+
+  static const bool value = decltype(test<Iterable>(NULL))::value;
+};
+
+
+template <typename Iterable>
+struct IsIterable
+{
+  template <typename T>
+  static std::true_type test(
+      typename std::decay<decltype(*std::declval<T>().begin())>::type*);
+
+  template <typename T>
+  static std::false_type test(...);
+
+  static const bool value = decltype(test<Iterable>(NULL))::value;
+};
+
+} // namespace internal {
+
+
+// Any iterable (e.g., std::vector, hashset) except for strings and
+// dictionaries, which are written as strings and objects.
+template <
+    typename Iterable,
+    typename std::enable_if<
+        internal::IsIterable<Iterable>::value &&
+        !internal::IsDictionary<Iterable>::value &&
+        !std::is_same<Iterable, std::string>::value,
+        int>::type = 0>
+void json(ArrayWriter* writer, const Iterable& iterable)
+{
+  foreach (const auto& value, iterable) {
+    writer->element(value);
+  }
+}
+
+
+// Any dictionary with keys that can be converted to a string (e.g.,
+// std::map<std::string, T>, hashmap<std::string, T>).
+template <
+    typename Dictionary,
+    typename std::enable_if<
+        internal::IsDictionary<Dictionary>::value,
+        int>::type = 0>
+void json(ObjectWriter* writer, const Dictionary& dictionary)
+{
+  foreach (const auto& pair, dictionary) {
+    writer->field(pair.first, pair.second);
+  }
+}
+
+
+// The 'json' overloads for JSON::Value and its types, which allow
+// embedding already built values.
+
+inline void json(BooleanWriter* writer, const Boolean& boolean)
+{
+  writer->set(boolean.value);
+}
+
+
+inline void json(NumberWriter* writer, const Number& number)
+{
+  switch (number.type) {
+    case Number::FLOATING:
+      writer->set(number.as<double>());
+      break;
+    case Number::SIGNED_INTEGER:
+      writer->set(number.as<int64_t>());
+      break;
+    case Number::UNSIGNED_INTEGER:
+      writer->set(number.as<uint64_t>());
+      break;
+  }
+}
+
+
+inline void json(StringWriter* writer, const String& string)
+{
+  writer->set(string.value);
+}
+
+
+inline void json(ArrayWriter* writer, const Array& array)
+{
+  foreach (const Value& value, array.values) {
+    writer->element(value);
+  }
+}
+
+
+inline void json(ObjectWriter* writer, const Object& object)
+{
+  foreachpair (const std::string& key, const Value& value, object.values) {
+    writer->field(key, value);
+  }
+}
+
+
+inline void json(NullWriter*, const Null&) {}
+
+
+// NOTE: This only takes a JSON::Value rather than all the types that
+// can be converted into one, which have their own overloads.
+template <
+    typename T,
+    typename std::enable_if<std::is_same<T, Value>::value, int>::type = 0>
+void json(WriterProxy&& writer, const T& value);
+
+
+namespace internal {
+
+struct Prefer {};
+struct LessPrefer { LessPrefer(Prefer) {} };
+
+
+// Writes 'value' using the function itself if it takes a writer,
+// otherwise using the 'json' overload for its type.
+template <typename F>
+auto write(WriterProxy&& writer, const F& f, Prefer)
+  -> decltype(f(std::declval<ObjectWriter*>()), void())
+{
+  f(std::move(writer));
+}
+
+
+template <typename F>
+auto write(WriterProxy&& writer, const F& f, Prefer)
+  -> decltype(f(std::declval<ArrayWriter*>()), void())
+{
+  f(std::move(writer));
+}
+
+
+template <typename T>
+void write(WriterProxy&& writer, const T& value, LessPrefer)
+{
+  json(std::move(writer), value);
+}
+
+
+template <typename T>
+void write(std::ostream* stream, const T& value)
+{
+  WriterProxy writer(stream);
+  write(std::move(writer), value, Prefer());
+}
+
+
+struct ValueWriter : boost::static_visitor<>
+{
+  explicit ValueWriter(WriterProxy* _writer) : writer(_writer) {}
+
+  template <typename T>
+  void operator()(const T& value) const
+  {
+    json(std::move(*writer), value);
+  }
+
+  WriterProxy* writer;
+};
+
+} // namespace internal {
+
+
+template <
+    typename T,
+    typename std::enable_if<std::is_same<T, Value>::value, int>::type>
+void json(WriterProxy&& writer, const T& value)
+{
+  boost::apply_visitor(internal::ValueWriter(&writer), value);
+}
+
+
+template <typename T>
+void ArrayWriter::element(const T& value)
+{
+  if (count > 0) {
+    *stream << ',';
+  }
+
+  internal::write(stream, value);
+  count++;
+}
+
+
+template <typename T>
+void ObjectWriter::field(const std::string& key, const T& value)
+{
+  if (count > 0) {
+    *stream << ',';
+  }
+
+  picojson::serialize_str(key, std::ostreambuf_iterator<char>(*stream));
+  *stream << ':';
+
+  internal::write(stream, value);
+  count++;
+}
+
+
+// The result of 'jsonify', which writes the value when it gets
+// written into a stream or converted to a string.
+//
+// NOTE: Only a reference to the value is kept, so the proxy needs to
+// be used before the value goes away, e.g., in the same expression.
+class Proxy
+{
+public:
+  operator std::string() &&
+  {
+    std::ostringstream stream;
+    write(&stream);
+    return stream.str();
+  }
+
+private:
+  template <typename T>
+  friend Proxy (::jsonify)(const T&);
+
+  friend std::ostream& operator<<(std::ostream& stream, Proxy&& proxy);
+
+  explicit Proxy(const std::function<void(std::ostream*)>& _write)
+    : write(_write) {}
+
+  std::function<void(std::ostream*)> write;
+};
+
+
+inline std::ostream& operator<<(std::ostream& stream, Proxy&& proxy)
+{
+  proxy.write(&stream);
+  return stream;
+}
+
+
+} // namespace JSON {
+
+
+template <typename T>
+JSON::Proxy jsonify(const T& value)
+{
+  return JSON::Proxy([&value](std::ostream* stream) {
+    JSON::internal::write(stream, value);
+  });
+}
+
+#endif // __STOUT_JSONIFY__
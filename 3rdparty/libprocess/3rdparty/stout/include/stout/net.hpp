@@ -51,6 +51,7 @@
 #include <stout/try.hpp>
 
 #include <stout/os/open.hpp>
+#include <stout/os/stat.hpp>
 
 
 // Network utilities.
@@ -124,20 +125,39 @@ inline Try<Bytes> contentLength(const std::string& url)
 
 // Returns the HTTP response code resulting from attempting to
 // download the specified HTTP or FTP URL into a file at the specified
-// path.
-inline Try<int> download(const std::string& url, const std::string& path)
+// path. If 'resume' is true, the download continues at the end of the
+// existing file with a range request, which fails if the server does
+// not support ranges. The status code of a successful resumed HTTP
+// download is 206 (Partial Content).
+inline Try<int> download(
+    const std::string& url,
+    const std::string& path,
+    bool resume = false)
 {
   initialize();
 
   Try<int> fd = os::open(
       path,
-      O_CREAT | O_WRONLY | O_CLOEXEC,
+      O_CREAT | O_WRONLY | O_CLOEXEC | (resume ? O_APPEND : 0),
       S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
 
   if (fd.isError()) {
     return Error(fd.error());
   }
 
+  curl_off_t offset = 0;
+
+  if (resume) {
+    Try<Bytes> size = os::stat::size(path);
+    if (size.isError()) {
+      os::close(fd.get());
+      return Error(
+          "Failed to determine the size of '" + path + "': " + size.error());
+    }
+
+    offset = size.get().bytes();
+  }
+
   CURL* curl = curl_easy_init();
 
   if (curl == NULL) {
@@ -150,7 +170,11 @@ inline Try<int> download(const std::string& url, const std::string& path)
   curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, NULL);
   curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, true);
 
-  FILE* file = fdopen(fd.get(), "w");
+  if (offset > 0) {
+    curl_easy_setopt(curl, CURLOPT_RESUME_FROM_LARGE, offset);
+  }
+
+  FILE* file = fdopen(fd.get(), resume ? "a" : "w");
   if (file == NULL) {
     return ErrnoError("Failed to open file handle of '" + path + "'");
   }
@@ -16,6 +16,8 @@
 #include <assert.h>
 
 #include <algorithm>
+#include <type_traits>
+#include <utility>
 
 #include <stout/none.hpp>
 #include <stout/some.hpp>
@@ -105,14 +107,18 @@ public:
   bool isSome() const { return state == SOME; }
   bool isNone() const { return state == NONE; }
 
-  const T& get() const { assert(isSome()); return t; }
-  T& get() { assert(isSome()); return t; }
+  // The value of a temporary (e.g., of an option returned from a
+  // function) can be moved out of it.
+  const T& get() const & { assert(isSome()); return t; }
+  T& get() & { assert(isSome()); return t; }
+  T&& get() && { assert(isSome()); return std::move(t); }
 
   const T* operator->() const { return &get(); }
   T* operator->() { return &get(); }
 
   // This must return a copy to avoid returning a reference to a temporary.
-  T getOrElse(const T& _t) const { return isNone() ? _t : t; }
+  T getOrElse(const T& _t) const & { return isNone() ? _t : t; }
+  T getOrElse(const T& _t) && { return isNone() ? _t : std::move(t); }
 
   bool operator==(const Option<T>& that) const
   {
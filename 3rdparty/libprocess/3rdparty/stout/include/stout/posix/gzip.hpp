@@ -17,6 +17,7 @@
 
 #include <string>
 
+#include <stout/abort.hpp>
 #include <stout/error.hpp>
 #include <stout/stringify.hpp>
 #include <stout/try.hpp>
@@ -144,6 +145,225 @@ inline Try<std::string> decompress(const std::string& compressed)
   return result;
 }
 
+
+// Provides the ability to incrementally decompress a stream of
+// compressed input data (e.g., the chunks of an HTTP body), so that
+// the compressed data never has to be buffered in full.
+class Decompressor
+{
+public:
+  Decompressor() : _finished(false)
+  {
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+
+    int code = inflateInit2(
+        &stream,
+        MAX_WBITS + 16); // Zlib magic for gzip compression / decompression.
+
+    if (code != Z_OK) {
+      ABORT("Failed to initialize zlib: " + std::string(stream.msg));
+    }
+  }
+
+  ~Decompressor()
+  {
+    inflateEnd(&stream);
+  }
+
+  // Returns the output for the given input data. Returns an error if
+  // the input is not valid gzip data, or if data is provided after
+  // the end of the compressed stream.
+  Try<std::string> decompress(const std::string& compressed)
+  {
+    if (compressed.empty()) {
+      return std::string();
+    }
+
+    if (_finished) {
+      return Error("Received data after the end of the compressed stream");
+    }
+
+    stream.next_in =
+      const_cast<Bytef*>(reinterpret_cast<const Bytef*>(compressed.data()));
+    stream.avail_in = compressed.length();
+
+    // Build up the decompressed result.
+    Bytef buffer[GZIP_BUFFER_SIZE];
+    std::string result = "";
+    while (stream.avail_in > 0) {
+      stream.next_out = buffer;
+      stream.avail_out = GZIP_BUFFER_SIZE;
+      int code = inflate(&stream, Z_SYNC_FLUSH);
+
+      if (code != Z_OK && code != Z_STREAM_END) {
+        return Error(stream.msg != NULL
+                     ? std::string(stream.msg)
+                     : "Failed to decompress: " + stringify(code));
+      }
+
+      // Consume output and reset the buffer.
+      result.append(
+          reinterpret_cast<char*>(buffer),
+          GZIP_BUFFER_SIZE - stream.avail_out);
+
+      if (code == Z_STREAM_END) {
+        _finished = true;
+        if (stream.avail_in > 0) {
+          return Error(
+              "Received data after the end of the compressed stream");
+        }
+        break;
+      }
+    }
+
+    // NOTE: Inflating with 'Z_SYNC_FLUSH' may leave output behind
+    // even after all the input has been consumed if the output
+    // buffer was filled up on the last call to 'inflate'.
+    while (!_finished && stream.avail_out == 0) {
+      stream.next_out = buffer;
+      stream.avail_out = GZIP_BUFFER_SIZE;
+      int code = inflate(&stream, Z_SYNC_FLUSH);
+
+      if (code == Z_BUF_ERROR) {
+        break; // No progress possible, i.e., no pending output.
+      } else if (code != Z_OK && code != Z_STREAM_END) {
+        return Error(stream.msg != NULL
+                     ? std::string(stream.msg)
+                     : "Failed to decompress: " + stringify(code));
+      }
+
+      result.append(
+          reinterpret_cast<char*>(buffer),
+          GZIP_BUFFER_SIZE - stream.avail_out);
+
+      if (code == Z_STREAM_END) {
+        _finished = true;
+      }
+    }
+
+    return result;
+  }
+
+  // Returns true if the end of the compressed stream was reached.
+  bool finished() const
+  {
+    return _finished;
+  }
+
+private:
+  Decompressor(const Decompressor&) = delete;
+  Decompressor& operator=(const Decompressor&) = delete;
+
+  z_stream_s stream;
+  bool _finished;
+};
+
+
+// Provides the ability to incrementally compress a stream of data
+// (e.g., the chunks of a streamed HTTP body). Each piece of input is
+// flushed, so that the output for it can be decompressed without
+// waiting for more input, and 'finish' ends the compressed stream.
+class Compressor
+{
+public:
+  explicit Compressor(int level = Z_DEFAULT_COMPRESSION) : _finished(false)
+  {
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+
+    int code = deflateInit2(
+        &stream,
+        level,          // Compression level.
+        Z_DEFLATED,     // Compression method.
+        MAX_WBITS + 16, // Zlib magic for gzip compression / decompression.
+        8,              // Default memLevel value.
+        Z_DEFAULT_STRATEGY);
+
+    if (code != Z_OK) {
+      ABORT("Failed to initialize zlib: " +
+            (stream.msg != NULL ? std::string(stream.msg) : stringify(code)));
+    }
+  }
+
+  ~Compressor()
+  {
+    deflateEnd(&stream);
+  }
+
+  // Returns the compressed output for the given input data. Returns
+  // an error if the stream was already finished.
+  Try<std::string> compress(const std::string& decompressed)
+  {
+    if (_finished) {
+      return Error("Received data after the end of the compressed stream");
+    }
+
+    if (decompressed.empty()) {
+      return std::string();
+    }
+
+    return deflate(decompressed, Z_SYNC_FLUSH);
+  }
+
+  // Returns the remaining output which ends the compressed stream.
+  Try<std::string> finish()
+  {
+    if (_finished) {
+      return Error("The compressed stream was already finished");
+    }
+
+    Try<std::string> result = deflate(std::string(), Z_FINISH);
+    _finished = true;
+    return result;
+  }
+
+private:
+  Compressor(const Compressor&) = delete;
+  Compressor& operator=(const Compressor&) = delete;
+
+  Try<std::string> deflate(const std::string& decompressed, int flush)
+  {
+    stream.next_in =
+      const_cast<Bytef*>(reinterpret_cast<const Bytef*>(decompressed.data()));
+    stream.avail_in = decompressed.length();
+
+    // Build up the compressed result. With 'Z_SYNC_FLUSH' all output
+    // has been produced once 'deflate' leaves space in the buffer.
+    Bytef buffer[GZIP_BUFFER_SIZE];
+    std::string result = "";
+    int code;
+    do {
+      stream.next_out = buffer;
+      stream.avail_out = GZIP_BUFFER_SIZE;
+      code = ::deflate(&stream, flush);
+
+      if (code == Z_BUF_ERROR && flush == Z_SYNC_FLUSH) {
+        break; // No progress possible, i.e., no pending output.
+      } else if (code != Z_OK && code != Z_STREAM_END) {
+        return Error(stream.msg != NULL
+                     ? std::string(stream.msg)
+                     : "Failed to compress: " + stringify(code));
+      }
+
+      result.append(
+          reinterpret_cast<char*>(buffer),
+          GZIP_BUFFER_SIZE - stream.avail_out);
+    } while (flush == Z_FINISH ? code != Z_STREAM_END : stream.avail_out == 0);
+
+    return result;
+  }
+
+  z_stream_s stream;
+  bool _finished;
+};
+
 } // namespace gzip {
 
 #endif // __STOUT_POSIX_GZIP_HPP__
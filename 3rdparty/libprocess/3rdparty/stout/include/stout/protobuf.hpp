@@ -18,10 +18,17 @@
 #include <stdint.h>
 #ifndef __WINDOWS__
 #include <unistd.h>
+
+#include <sys/mman.h>
 #endif // __WINDOWS__
 
+#include <sys/stat.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <mutex>
 #include <string>
 #include <type_traits>
 #include <vector>
@@ -30,17 +37,22 @@
 #include <google/protobuf/message.h>
 #include <google/protobuf/repeated_field.h>
 
+#include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 
 #include <stout/abort.hpp>
 #include <stout/base64.hpp>
 #include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/json.hpp>
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
 #include <stout/result.hpp>
 #include <stout/stringify.hpp>
+#include <stout/synchronized.hpp>
 #include <stout/try.hpp>
+#include <stout/unreachable.hpp>
 
 #include <stout/os/close.hpp>
 #include <stout/os/open.hpp>
@@ -312,142 +324,324 @@ Result<T> read(const std::string& path)
 }
 
 
+#ifndef __WINDOWS__
+// Reads a sequence of messages in the format written by write() above
+// from a memory mapping of a file, rather than with a pair of read()
+// calls and a copy of each message. The messages are parsed straight
+// from the mapping.
+//
+// Failed reads do not move the reader, so 'offset()' is always the
+// offset in the file past the last message read successfully (e.g.,
+// for truncating a partial write at the end of the file).
+//
+// NOTE: The file must not be truncated while it is mapped, since
+// reading a page past the end of the file raises SIGBUS.
+class Reader
+{
+public:
+  Reader() : data(NULL), length(0), position(0) {}
+
+  ~Reader()
+  {
+    if (data != NULL) {
+      munmap(data, length);
+    }
+  }
+
+  // Maps the file open at 'fd', and starts reading at the current
+  // offset of 'fd'. The file descriptor is not used after this
+  // returns and can be closed.
+  Try<Nothing> open(int fd)
+  {
+    if (data != NULL) {
+      return Error("Reader already opened");
+    }
+
+    const off_t offset = lseek(fd, 0, SEEK_CUR);
+    if (offset == -1) {
+      return ErrnoError("Failed to lseek to SEEK_CUR");
+    }
+
+    struct stat s;
+    if (fstat(fd, &s) < 0) {
+      return ErrnoError("Failed to fstat");
+    }
+
+    position = std::min(offset, s.st_size);
+
+    // NOTE: Mapping an empty file fails, but there is nothing to read
+    // from one anyway.
+    if (s.st_size > 0) {
+      void* mapping =
+        mmap(NULL, s.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+      if (mapping == MAP_FAILED) {
+        return ErrnoError("Failed to mmap");
+      }
+
+      data = static_cast<char*>(mapping);
+      length = s.st_size;
+
+      // Checkpoints are read once, from front to back.
+      madvise(data, length, MADV_SEQUENTIAL);
+    }
+
+    return Nothing();
+  }
+
+  // Reads the next message. Returns None() at the end of the file,
+  // or, if 'ignorePartial' is true, when the file ends in the middle
+  // of the message (e.g., partial write).
+  template <typename T>
+  Result<T> read(bool ignorePartial = false)
+  {
+    uint32_t size;
+
+    if (position == length) {
+      return None(); // No more protobufs to read.
+    } else if (length - position < sizeof(size)) {
+      if (ignorePartial) {
+        return None();
+      }
+      return Error(
+          "Failed to read size: hit EOF unexpectedly, possible corruption");
+    }
+
+    memcpy((void*) &size, (void*) (data + position), sizeof(size));
+
+    if (length - position - sizeof(size) < size) {
+      if (ignorePartial) {
+        return None();
+      }
+      return Error("Failed to read message of size " + stringify(size) +
+                   " bytes: hit EOF unexpectedly, possible corruption");
+    }
+
+    T message;
+    google::protobuf::io::CodedInputStream stream(
+        reinterpret_cast<const uint8_t*>(data + position + sizeof(size)),
+        size);
+
+    if (!message.ParseFromCodedStream(&stream) ||
+        !stream.ConsumedEntireMessage()) {
+      return Error("Failed to deserialize message");
+    }
+
+    position += sizeof(size) + size;
+
+    return message;
+  }
+
+  // Returns the offset in the file of the next message.
+  off_t offset() const { return position; }
+
+private:
+  Reader(const Reader&) = delete;
+  Reader& operator=(const Reader&) = delete;
+
+  char* data;
+  size_t length;
+  size_t position;
+};
+#endif // __WINDOWS__
+
+
 namespace internal {
 
-// Forward declaration.
+// Forward declarations.
 Try<Nothing> parse(
     google::protobuf::Message* message,
     const JSON::Object& object);
 
+Try<Nothing> parse(
+    google::protobuf::Message* message,
+    const picojson::value::object& object);
+
+
+// The setters of a field for each type of JSON value, which are
+// shared by the parsers of a JSON::Value and of a picojson::value.
+template <typename Object>
+Try<Nothing> setObject(
+    google::protobuf::Message* message,
+    const google::protobuf::FieldDescriptor* field,
+    const Object& object)
+{
+  const google::protobuf::Reflection* reflection = message->GetReflection();
+
+  switch (field->type()) {
+    case google::protobuf::FieldDescriptor::TYPE_MESSAGE:
+      if (field->is_repeated()) {
+        return parse(reflection->AddMessage(message, field), object);
+      } else {
+        return parse(reflection->MutableMessage(message, field), object);
+      }
+    default:
+      return Error("Not expecting a JSON object for field '" +
+                   field->name() + "'");
+  }
+}
+
+
+inline Try<Nothing> setString(
+    google::protobuf::Message* message,
+    const google::protobuf::FieldDescriptor* field,
+    const std::string& string)
+{
+  const google::protobuf::Reflection* reflection = message->GetReflection();
+
+  switch (field->type()) {
+    case google::protobuf::FieldDescriptor::TYPE_STRING:
+      if (field->is_repeated()) {
+        reflection->AddString(message, field, string);
+      } else {
+        reflection->SetString(message, field, string);
+      }
+      break;
+    case google::protobuf::FieldDescriptor::TYPE_BYTES: {
+      Try<std::string> decode = base64::decode(string);
+
+      if (decode.isError()) {
+        return Error("Failed to base64 decode bytes field"
+                     " '" + field->name() + "': " + decode.error());
+      }
+
+      if (field->is_repeated()) {
+        reflection->AddString(message, field, decode.get());
+      } else {
+        reflection->SetString(message, field, decode.get());
+      }
+      break;
+    }
+    case google::protobuf::FieldDescriptor::TYPE_ENUM: {
+      const google::protobuf::EnumValueDescriptor* descriptor =
+        field->enum_type()->FindValueByName(string);
+
+      if (descriptor == NULL) {
+        return Error("Failed to find enum for '" + string + "'");
+      }
+
+      if (field->is_repeated()) {
+        reflection->AddEnum(message, field, descriptor);
+      } else {
+        reflection->SetEnum(message, field, descriptor);
+      }
+      break;
+    }
+    default:
+      return Error("Not expecting a JSON string for field '" +
+                   field->name() + "'");
+  }
+  return Nothing();
+}
+
+
+inline Try<Nothing> setNumber(
+    google::protobuf::Message* message,
+    const google::protobuf::FieldDescriptor* field,
+    const JSON::Number& number)
+{
+  const google::protobuf::Reflection* reflection = message->GetReflection();
+
+  switch (field->type()) {
+    case google::protobuf::FieldDescriptor::TYPE_DOUBLE:
+      if (field->is_repeated()) {
+        reflection->AddDouble(message, field, number.as<double>());
+      } else {
+        reflection->SetDouble(message, field, number.as<double>());
+      }
+      break;
+    case google::protobuf::FieldDescriptor::TYPE_FLOAT:
+      if (field->is_repeated()) {
+        reflection->AddFloat(message, field, number.as<float>());
+      } else {
+        reflection->SetFloat(message, field, number.as<float>());
+      }
+      break;
+    case google::protobuf::FieldDescriptor::TYPE_INT64:
+    case google::protobuf::FieldDescriptor::TYPE_SINT64:
+    case google::protobuf::FieldDescriptor::TYPE_SFIXED64:
+      if (field->is_repeated()) {
+        reflection->AddInt64(message, field, number.as<int64_t>());
+      } else {
+        reflection->SetInt64(message, field, number.as<int64_t>());
+      }
+      break;
+    case google::protobuf::FieldDescriptor::TYPE_UINT64:
+    case google::protobuf::FieldDescriptor::TYPE_FIXED64:
+      if (field->is_repeated()) {
+        reflection->AddUInt64(message, field, number.as<uint64_t>());
+      } else {
+        reflection->SetUInt64(message, field, number.as<uint64_t>());
+      }
+      break;
+    case google::protobuf::FieldDescriptor::TYPE_INT32:
+    case google::protobuf::FieldDescriptor::TYPE_SINT32:
+    case google::protobuf::FieldDescriptor::TYPE_SFIXED32:
+      if (field->is_repeated()) {
+        reflection->AddInt32(message, field, number.as<int32_t>());
+      } else {
+        reflection->SetInt32(message, field, number.as<int32_t>());
+      }
+      break;
+    case google::protobuf::FieldDescriptor::TYPE_UINT32:
+    case google::protobuf::FieldDescriptor::TYPE_FIXED32:
+      if (field->is_repeated()) {
+        reflection->AddUInt32(message, field, number.as<uint32_t>());
+      } else {
+        reflection->SetUInt32(message, field, number.as<uint32_t>());
+      }
+      break;
+    default:
+      return Error("Not expecting a JSON number for field '" +
+                   field->name() + "'");
+  }
+  return Nothing();
+}
+
+
+inline Try<Nothing> setBoolean(
+    google::protobuf::Message* message,
+    const google::protobuf::FieldDescriptor* field,
+    bool boolean)
+{
+  const google::protobuf::Reflection* reflection = message->GetReflection();
+
+  switch (field->type()) {
+    case google::protobuf::FieldDescriptor::TYPE_BOOL:
+      if (field->is_repeated()) {
+        reflection->AddBool(message, field, boolean);
+      } else {
+        reflection->SetBool(message, field, boolean);
+      }
+      break;
+    default:
+      return Error("Not expecting a JSON boolean for field '" +
+                   field->name() + "'");
+  }
+  return Nothing();
+}
+
 
 struct Parser : boost::static_visitor<Try<Nothing> >
 {
   Parser(google::protobuf::Message* _message,
          const google::protobuf::FieldDescriptor* _field)
     : message(_message),
-      reflection(message->GetReflection()),
       field(_field) {}
 
   Try<Nothing> operator()(const JSON::Object& object) const
   {
-    switch (field->type()) {
-      case google::protobuf::FieldDescriptor::TYPE_MESSAGE:
-        if (field->is_repeated()) {
-          parse(reflection->AddMessage(message, field), object);
-        } else {
-          parse(reflection->MutableMessage(message, field), object);
-        }
-        break;
-      default:
-        return Error("Not expecting a JSON object for field '" +
-                     field->name() + "'");
-    }
-    return Nothing();
+    return setObject(message, field, object);
   }
 
   Try<Nothing> operator()(const JSON::String& string) const
   {
-    switch (field->type()) {
-      case google::protobuf::FieldDescriptor::TYPE_STRING:
-        if (field->is_repeated()) {
-          reflection->AddString(message, field, string.value);
-        } else {
-          reflection->SetString(message, field, string.value);
-        }
-        break;
-      case google::protobuf::FieldDescriptor::TYPE_BYTES: {
-        Try<std::string> decode = base64::decode(string.value);
-
-        if (decode.isError()) {
-          return Error("Failed to base64 decode bytes field"
-                       " '" + field->name() + "': " + decode.error());
-        }
-
-        if (field->is_repeated()) {
-          reflection->AddString(message, field, decode.get());
-        } else {
-          reflection->SetString(message, field, decode.get());
-        }
-        break;
-      }
-      case google::protobuf::FieldDescriptor::TYPE_ENUM: {
-        const google::protobuf::EnumValueDescriptor* descriptor =
-          field->enum_type()->FindValueByName(string.value);
-
-        if (descriptor == NULL) {
-          return Error("Failed to find enum for '" + string.value + "'");
-        }
-
-        if (field->is_repeated()) {
-          reflection->AddEnum(message, field, descriptor);
-        } else {
-          reflection->SetEnum(message, field, descriptor);
-        }
-        break;
-      }
-      default:
-        return Error("Not expecting a JSON string for field '" +
-                     field->name() + "'");
-    }
-    return Nothing();
+    return setString(message, field, string.value);
   }
 
   Try<Nothing> operator()(const JSON::Number& number) const
   {
-    switch (field->type()) {
-      case google::protobuf::FieldDescriptor::TYPE_DOUBLE:
-        if (field->is_repeated()) {
-          reflection->AddDouble(message, field, number.as<double>());
-        } else {
-          reflection->SetDouble(message, field, number.as<double>());
-        }
-        break;
-      case google::protobuf::FieldDescriptor::TYPE_FLOAT:
-        if (field->is_repeated()) {
-          reflection->AddFloat(message, field, number.as<float>());
-        } else {
-          reflection->SetFloat(message, field, number.as<float>());
-        }
-        break;
-      case google::protobuf::FieldDescriptor::TYPE_INT64:
-      case google::protobuf::FieldDescriptor::TYPE_SINT64:
-      case google::protobuf::FieldDescriptor::TYPE_SFIXED64:
-        if (field->is_repeated()) {
-          reflection->AddInt64(message, field, number.as<int64_t>());
-        } else {
-          reflection->SetInt64(message, field, number.as<int64_t>());
-        }
-        break;
-      case google::protobuf::FieldDescriptor::TYPE_UINT64:
-      case google::protobuf::FieldDescriptor::TYPE_FIXED64:
-        if (field->is_repeated()) {
-          reflection->AddUInt64(message, field, number.as<uint64_t>());
-        } else {
-          reflection->SetUInt64(message, field, number.as<uint64_t>());
-        }
-        break;
-      case google::protobuf::FieldDescriptor::TYPE_INT32:
-      case google::protobuf::FieldDescriptor::TYPE_SINT32:
-      case google::protobuf::FieldDescriptor::TYPE_SFIXED32:
-        if (field->is_repeated()) {
-          reflection->AddInt32(message, field, number.as<int32_t>());
-        } else {
-          reflection->SetInt32(message, field, number.as<int32_t>());
-        }
-        break;
-      case google::protobuf::FieldDescriptor::TYPE_UINT32:
-      case google::protobuf::FieldDescriptor::TYPE_FIXED32:
-        if (field->is_repeated()) {
-          reflection->AddUInt32(message, field, number.as<uint32_t>());
-        } else {
-          reflection->SetUInt32(message, field, number.as<uint32_t>());
-        }
-        break;
-      default:
-        return Error("Not expecting a JSON number for field '" +
-                     field->name() + "'");
-    }
-    return Nothing();
+    return setNumber(message, field, number);
   }
 
   Try<Nothing> operator()(const JSON::Array& array) const
@@ -471,19 +665,7 @@ struct Parser : boost::static_visitor<Try<Nothing> >
 
   Try<Nothing> operator()(const JSON::Boolean& boolean) const
   {
-    switch (field->type()) {
-      case google::protobuf::FieldDescriptor::TYPE_BOOL:
-        if (field->is_repeated()) {
-          reflection->AddBool(message, field, boolean.value);
-        } else {
-          reflection->SetBool(message, field, boolean.value);
-        }
-        break;
-      default:
-        return Error("Not expecting a JSON boolean for field '" +
-                     field->name() + "'");
-    }
-    return Nothing();
+    return setBoolean(message, field, boolean.value);
   }
 
   Try<Nothing> operator()(const JSON::Null&) const
@@ -493,7 +675,6 @@ struct Parser : boost::static_visitor<Try<Nothing> >
 
 private:
   google::protobuf::Message* message;
-  const google::protobuf::Reflection* reflection;
   const google::protobuf::FieldDescriptor* field;
 };
 
@@ -522,25 +703,103 @@ inline Try<Nothing> parse(
 }
 
 
-// Parses a single protobuf message of type T from a JSON::Object.
+// Same as the Parser above but for a picojson::value, which avoids
+// converting (i.e., copying) all of the values into a JSON::Value
+// when parsing a message from a string.
+inline Try<Nothing> parse(
+    google::protobuf::Message* message,
+    const google::protobuf::FieldDescriptor* field,
+    const picojson::value& value)
+{
+  if (value.is<picojson::value::object>()) {
+    return setObject(message, field, value.get<picojson::value::object>());
+  } else if (value.is<std::string>()) {
+    return setString(message, field, value.get<std::string>());
+  } else if (value.is<int64_t>()) {
+    return setNumber(message, field, JSON::Number(value.get<int64_t>()));
+  } else if (value.is<double>()) {
+    return setNumber(message, field, JSON::Number(value.get<double>()));
+  } else if (value.is<picojson::value::array>()) {
+    if (!field->is_repeated()) {
+      return Error("Not expecting a JSON array for field '" +
+                   field->name() + "'");
+    }
+
+    foreach (const picojson::value& element,
+             value.get<picojson::value::array>()) {
+      Try<Nothing> apply = parse(message, field, element);
+      if (apply.isError()) {
+        return Error(apply.error());
+      }
+    }
+
+    return Nothing();
+  } else if (value.is<bool>()) {
+    return setBoolean(message, field, value.get<bool>());
+  }
+
+  return Error("Not expecting a JSON null");
+}
+
+
+inline Try<Nothing> parse(
+    google::protobuf::Message* message,
+    const picojson::value::object& object)
+{
+  foreachpair (
+      const std::string& name, const picojson::value& value, object) {
+    // Look for a field by this name.
+    const google::protobuf::FieldDescriptor* field =
+      message->GetDescriptor()->FindFieldByName(name);
+
+    if (field != NULL) {
+      Try<Nothing> apply = parse(message, field, value);
+      if (apply.isError()) {
+        return Error(apply.error());
+      }
+    }
+  }
+
+  return Nothing();
+}
+
+
+// Parses a single protobuf message of type T from a JSON::Object (or
+// a picojson object).
 // NOTE: This struct is used by the public parse<T>() function below. See
 // comments there for the reason why we opted for this design.
 template <typename T>
 struct Parse
 {
+  static_assert(std::is_convertible<T*, google::protobuf::Message*>::value,
+                "T must be a protobuf message");
+
   Try<T> operator()(const JSON::Value& value)
   {
-    static_assert(std::is_convertible<T*, google::protobuf::Message*>::value,
-                  "T must be a protobuf message");
-
     const JSON::Object* object = boost::get<JSON::Object>(&value);
     if (object == NULL) {
       return Error("Expecting a JSON object");
     }
 
+    return message(*object);
+  }
+
+  Try<T> operator()(const picojson::value& value)
+  {
+    if (!value.is<picojson::value::object>()) {
+      return Error("Expecting a JSON object");
+    }
+
+    return message(value.get<picojson::value::object>());
+  }
+
+private:
+  template <typename Object>
+  Try<T> message(const Object& object)
+  {
     T message;
 
-    Try<Nothing> parse = internal::parse(&message, *object);
+    Try<Nothing> parse = internal::parse(&message, object);
     if (parse.isError()) {
       return Error(parse.error());
     }
@@ -563,22 +822,39 @@ struct Parse
 template <typename T>
 struct Parse<google::protobuf::RepeatedPtrField<T>>
 {
+  static_assert(std::is_convertible<T*, google::protobuf::Message*>::value,
+                "T must be a protobuf message");
+
   Try<google::protobuf::RepeatedPtrField<T>> operator()(
       const JSON::Value& value)
   {
-    static_assert(std::is_convertible<T*, google::protobuf::Message*>::value,
-                  "T must be a protobuf message");
-
     const JSON::Array* array = boost::get<JSON::Array>(&value);
     if (array == NULL) {
       return Error("Expecting a JSON array");
     }
 
+    return collection(array->values);
+  }
+
+  Try<google::protobuf::RepeatedPtrField<T>> operator()(
+      const picojson::value& value)
+  {
+    if (!value.is<picojson::value::array>()) {
+      return Error("Expecting a JSON array");
+    }
+
+    return collection(value.get<picojson::value::array>());
+  }
+
+private:
+  template <typename Values>
+  Try<google::protobuf::RepeatedPtrField<T>> collection(const Values& values)
+  {
     google::protobuf::RepeatedPtrField<T> collection;
-    collection.Reserve(static_cast<int>(array->values.size()));
+    collection.Reserve(static_cast<int>(values.size()));
 
     // Parse messages one by one and propagate an error if it happens.
-    foreach (const JSON::Value& elem, array->values) {
+    foreach (const auto& elem, values) {
       Try<T> message = Parse<T>()(elem);
       if (message.isError()) {
         return Error(message.error());
@@ -607,6 +883,32 @@ Try<T> parse(const JSON::Value& value)
   return internal::Parse<T>()(value);
 }
 
+
+// Parses protobuf message(s) from a JSON string, i.e., the same as
+// 'parse<T>(JSON::parse(s).get())' but without first building (and
+// copying the string into) a JSON::Value.
+template <typename T>
+Try<T> parse(const std::string& s)
+{
+  picojson::value value;
+
+  Try<Nothing> parse = JSON::internal::parse(s, &value);
+  if (parse.isError()) {
+    return Error(parse.error());
+  }
+
+  return internal::Parse<T>()(value);
+}
+
+
+// NOTE: Needed to disambiguate the above for string literals, which
+// would also convert into a JSON::Value.
+template <typename T>
+Try<T> parse(const char* s)
+{
+  return parse<T>(std::string(s));
+}
+
 } // namespace protobuf {
 
 namespace JSON {
@@ -791,6 +1093,276 @@ Array protobuf(const google::protobuf::RepeatedPtrField<T>& repeated)
   return array;
 }
 
+namespace internal {
+
+// How to serialize the messages of a type into JSON (see 'serialize'
+// below), which gets computed once per type instead of consulting
+// the descriptor of each field for every message.
+struct Plan
+{
+  struct Field
+  {
+    const google::protobuf::FieldDescriptor* descriptor;
+
+    // The (escaped) name followed by a colon, e.g., "\"name\":".
+    std::string key;
+
+    // The plan for the type of a message field, otherwise NULL.
+    const Plan* message;
+  };
+
+  // Sorted by name, i.e., in the same order as in a JSON::Object.
+  std::vector<Field> fields;
+};
+
+
+// Returns the plan for the type, computing the plans of the type and
+// its (transitively) nested message types if they are not cached yet.
+// NOTE: Plans are never deleted, since the descriptors of generated
+// messages are never deleted either.
+inline const Plan* plan(const google::protobuf::Descriptor* descriptor)
+{
+  static std::mutex* mutex = new std::mutex();
+  static hashmap<const google::protobuf::Descriptor*, Plan*>* plans =
+    new hashmap<const google::protobuf::Descriptor*, Plan*>();
+
+  // Computes the plan (and adds it to 'plans' before the plans of
+  // its fields so that recursive types terminate).
+  std::function<Plan*(const google::protobuf::Descriptor*)> compute =
+    [&compute](const google::protobuf::Descriptor* descriptor) -> Plan* {
+      if (plans->contains(descriptor)) {
+        return plans->at(descriptor);
+      }
+
+      Plan* plan = new Plan();
+      (*plans)[descriptor] = plan;
+
+      std::vector<const google::protobuf::FieldDescriptor*> fields;
+      fields.reserve(descriptor->field_count());
+      for (int i = 0; i < descriptor->field_count(); i++) {
+        fields.push_back(descriptor->field(i));
+      }
+
+      std::sort(
+          fields.begin(),
+          fields.end(),
+          [](const google::protobuf::FieldDescriptor* left,
+             const google::protobuf::FieldDescriptor* right) {
+            return left->name() < right->name();
+          });
+
+      plan->fields.reserve(fields.size());
+      foreach (const google::protobuf::FieldDescriptor* field, fields) {
+        Plan::Field entry;
+        entry.descriptor = field;
+        entry.key = stringify(String(field->name())) + ":";
+        entry.message =
+          field->type() == google::protobuf::FieldDescriptor::TYPE_MESSAGE
+            ? compute(field->message_type())
+            : NULL;
+
+        plan->fields.push_back(entry);
+      }
+
+      return plan;
+    };
+
+  synchronized (mutex) {
+    return compute(descriptor);
+  }
+
+  UNREACHABLE();
+}
+
+
+inline void serialize(
+    const google::protobuf::Message& message,
+    const Plan& plan,
+    std::string* out);
+
+
+// Appends the value of a (singular) field if 'index' is negative,
+// otherwise the value at 'index' of a repeated field.
+inline void serialize(
+    const google::protobuf::Message& message,
+    const google::protobuf::Reflection* reflection,
+    const Plan::Field& field,
+    int index,
+    std::string* out)
+{
+  const google::protobuf::FieldDescriptor* descriptor = field.descriptor;
+
+  switch (descriptor->type()) {
+    case google::protobuf::FieldDescriptor::TYPE_DOUBLE:
+      out->append(format(index < 0
+        ? reflection->GetDouble(message, descriptor)
+        : reflection->GetRepeatedDouble(message, descriptor, index)));
+      break;
+    case google::protobuf::FieldDescriptor::TYPE_FLOAT:
+      out->append(format(index < 0
+        ? reflection->GetFloat(message, descriptor)
+        : reflection->GetRepeatedFloat(message, descriptor, index)));
+      break;
+    case google::protobuf::FieldDescriptor::TYPE_INT64:
+    case google::protobuf::FieldDescriptor::TYPE_SINT64:
+    case google::protobuf::FieldDescriptor::TYPE_SFIXED64:
+      out->append(std::to_string(index < 0
+        ? reflection->GetInt64(message, descriptor)
+        : reflection->GetRepeatedInt64(message, descriptor, index)));
+      break;
+    case google::protobuf::FieldDescriptor::TYPE_UINT64:
+    case google::protobuf::FieldDescriptor::TYPE_FIXED64:
+      out->append(std::to_string(index < 0
+        ? reflection->GetUInt64(message, descriptor)
+        : reflection->GetRepeatedUInt64(message, descriptor, index)));
+      break;
+    case google::protobuf::FieldDescriptor::TYPE_INT32:
+    case google::protobuf::FieldDescriptor::TYPE_SINT32:
+    case google::protobuf::FieldDescriptor::TYPE_SFIXED32:
+      out->append(std::to_string(index < 0
+        ? reflection->GetInt32(message, descriptor)
+        : reflection->GetRepeatedInt32(message, descriptor, index)));
+      break;
+    case google::protobuf::FieldDescriptor::TYPE_UINT32:
+    case google::protobuf::FieldDescriptor::TYPE_FIXED32:
+      out->append(std::to_string(index < 0
+        ? reflection->GetUInt32(message, descriptor)
+        : reflection->GetRepeatedUInt32(message, descriptor, index)));
+      break;
+    case google::protobuf::FieldDescriptor::TYPE_BOOL:
+      out->append((index < 0
+        ? reflection->GetBool(message, descriptor)
+        : reflection->GetRepeatedBool(message, descriptor, index))
+        ? "true" : "false");
+      break;
+    case google::protobuf::FieldDescriptor::TYPE_STRING:
+      // NOTE: Uses the same escaping as JSON::String.
+      picojson::serialize_str(
+          index < 0
+            ? reflection->GetString(message, descriptor)
+            : reflection->GetRepeatedString(message, descriptor, index),
+          std::back_inserter(*out));
+      break;
+    case google::protobuf::FieldDescriptor::TYPE_BYTES:
+      picojson::serialize_str(
+          base64::encode(index < 0
+            ? reflection->GetString(message, descriptor)
+            : reflection->GetRepeatedString(message, descriptor, index)),
+          std::back_inserter(*out));
+      break;
+    case google::protobuf::FieldDescriptor::TYPE_MESSAGE:
+      serialize(
+          index < 0
+            ? reflection->GetMessage(message, descriptor)
+            : reflection->GetRepeatedMessage(message, descriptor, index),
+          *field.message,
+          out);
+      break;
+    case google::protobuf::FieldDescriptor::TYPE_ENUM:
+      picojson::serialize_str(
+          (index < 0
+            ? reflection->GetEnum(message, descriptor)
+            : reflection->GetRepeatedEnum(message, descriptor, index))
+            ->name(),
+          std::back_inserter(*out));
+      break;
+    case google::protobuf::FieldDescriptor::TYPE_GROUP:
+      // Deprecated! We abort here instead of using a Try as return value,
+      // because we expect this code path to never be taken.
+      ABORT("Unhandled protobuf field type: " +
+            stringify(descriptor->type()));
+  }
+}
+
+
+inline void serialize(
+    const google::protobuf::Message& message,
+    const Plan& plan,
+    std::string* out)
+{
+  const google::protobuf::Reflection* reflection = message.GetReflection();
+
+  out->push_back('{');
+
+  bool first = true;
+  foreach (const Plan::Field& field, plan.fields) {
+    // Same as for 'protobuf' above, only repeated fields with members
+    // and optional fields which are set or have a default are output.
+    int size = 0;
+    if (field.descriptor->is_repeated()) {
+      size = reflection->FieldSize(message, field.descriptor);
+      if (size == 0) {
+        continue;
+      }
+    } else if (!reflection->HasField(message, field.descriptor) &&
+               !field.descriptor->has_default_value()) {
+      continue;
+    }
+
+    if (!first) {
+      out->push_back(',');
+    }
+    first = false;
+
+    out->append(field.key);
+
+    if (field.descriptor->is_repeated()) {
+      out->push_back('[');
+      for (int i = 0; i < size; i++) {
+        if (i > 0) {
+          out->push_back(',');
+        }
+        serialize(message, reflection, field, i, out);
+      }
+      out->push_back(']');
+    } else {
+      serialize(message, reflection, field, -1, out);
+    }
+  }
+
+  out->push_back('}');
+}
+
+} // namespace internal {
+
+
+// Appends the JSON of the message to 'out', which is the same as
+// 'stringify(JSON::protobuf(message))' but without building (and
+// then stringifying) a JSON::Object.
+inline void serialize(
+    const google::protobuf::Message& message,
+    std::string* out)
+{
+  internal::serialize(
+      message,
+      *internal::plan(message.GetDescriptor()),
+      out);
+}
+
+
+template <typename T>
+void serialize(
+    const google::protobuf::RepeatedPtrField<T>& repeated,
+    std::string* out)
+{
+  static_assert(std::is_convertible<T*, google::protobuf::Message*>::value,
+                "T must be a protobuf message");
+
+  out->push_back('[');
+
+  bool first = true;
+  foreach (const T& elem, repeated) {
+    if (!first) {
+      out->push_back(',');
+    }
+    first = false;
+
+    serialize(elem, out);
+  }
+
+  out->push_back(']');
+}
+
 } // namespace JSON {
 
 #endif // __STOUT_PROTOBUF_HPP__
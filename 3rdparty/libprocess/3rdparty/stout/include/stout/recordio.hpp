@@ -15,6 +15,7 @@
 
 #include <stdlib.h>
 
+#include <algorithm>
 #include <deque>
 #include <functional>
 #include <string>
@@ -105,14 +106,26 @@ public:
 
     std::deque<Try<T>> records;
 
-    foreach (char c, data) {
+    // Rather than going through the data a character at a time, we
+    // look for the end of each header and take each record (or as
+    // much of it as is available) in one go. Records contained in
+    // 'data' entirely are deserialized straight from it, 'buffer'
+    // only holds the headers and records spanning multiple chunks.
+    size_t position = 0;
+
+    while (position < data.size()) {
       if (state == HEADER) {
         // Keep reading until we have the entire header.
-        if (c != '\n') {
-          buffer += c;
-          continue;
+        size_t newline = data.find('\n', position);
+
+        if (newline == std::string::npos) {
+          buffer.append(data, position, std::string::npos);
+          break;
         }
 
+        buffer.append(data, position, newline - position);
+        position = newline + 1;
+
         Try<size_t> numify = ::numify<size_t>(buffer);
 
         // If we were unable to decode the length header, do not
@@ -137,7 +150,19 @@ public:
         CHECK_SOME(length);
         CHECK_LT(buffer.size(), length.get());
 
-        buffer += c;
+        const size_t remaining = length.get() - buffer.size();
+        const size_t available = data.size() - position;
+
+        if (buffer.empty() && available >= remaining) {
+          records.push_back(deserialize(data.substr(position, remaining)));
+          position += remaining;
+          state = HEADER;
+          continue;
+        }
+
+        const size_t size = std::min(remaining, available);
+        buffer.append(data, position, size);
+        position += size;
 
         if (buffer.size() == length.get()) {
           records.push_back(deserialize(buffer));
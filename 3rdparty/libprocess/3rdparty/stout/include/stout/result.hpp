@@ -17,6 +17,7 @@
 
 #include <iostream>
 #include <string>
+#include <utility>
 
 #include <stout/abort.hpp>
 #include <stout/error.hpp>
@@ -58,6 +59,9 @@ public:
   Result(const T& _t)
     : data(Some(_t)) {}
 
+  Result(T&& _t)
+    : data(Option<T>(std::move(_t))) {}
+
   template <typename U>
   Result(const U& u)
     : data(Some(u)) {}
@@ -91,8 +95,10 @@ public:
   // We don't need to implement these because we are leveraging
   // Try<Option<T>>.
   Result(const Result<T>& that) = default;
+  Result(Result<T>&& that) = default;
   ~Result() = default;
   Result<T>& operator=(const Result<T>& that) = default;
+  Result<T>& operator=(Result<T>&& that) = default;
 
   // 'isSome', 'isNone', and 'isError' are mutually exclusive. They
   // correspond to the underlying unioned state of the Option and Try.
@@ -100,7 +106,7 @@ public:
   bool isNone() const { return data.isSome() && data.get().isNone(); }
   bool isError() const { return data.isError(); }
 
-  const T& get() const
+  const T& get() const &
   {
     if (!isSome()) {
       std::string errorMessage = "Result::get() but state == ";
@@ -114,11 +120,17 @@ public:
     return data.get().get();
   }
 
-  T& get()
+  T& get() &
   {
     return const_cast<T&>(static_cast<const Result&>(*this).get());
   }
 
+  // The value of a temporary can be moved out of it.
+  T&& get() &&
+  {
+    return std::move(get());
+  }
+
   const T* operator->() const { return &get(); }
   T* operator->() { return &get(); }
 
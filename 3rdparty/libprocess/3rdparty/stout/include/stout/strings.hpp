@@ -53,9 +53,14 @@ inline std::string remove(
       result = from.substr(0, from.size() - substring.size());
     }
   } else {
-    size_t index;
-    while ((index = result.find(substring)) != std::string::npos) {
-      result = result.erase(index, substring.size());
+    // NOTE: Erasing a substring can form a new occurrence, but only
+    // one that starts less than 'substring.size()' characters before
+    // the erased one, so there is no need to search from the start.
+    size_t index = 0;
+    while (!substring.empty() &&
+           (index = result.find(substring, index)) != std::string::npos) {
+      result.erase(index, substring.size());
+      index = index >= substring.size() ? index - substring.size() + 1 : 0;
     }
   }
 
@@ -114,17 +119,25 @@ inline std::string replace(
     const std::string& from,
     const std::string& to)
 {
-  std::string result = s;
-  size_t index = 0;
-
   if (from.empty()) {
-    return result;
+    return s;
   }
 
-  while ((index = result.find(from, index)) != std::string::npos) {
-    result.replace(index, from.length(), to);
-    index += to.length();
+  // Build the result in a single pass rather than replacing in place,
+  // which would shift the rest of the string on every occurrence.
+  std::string result;
+  result.reserve(s.size());
+
+  size_t offset = 0;
+  size_t index = 0;
+
+  while ((index = s.find(from, offset)) != std::string::npos) {
+    result.append(s, offset, index - offset);
+    result.append(to);
+    offset = index + from.length();
   }
+
+  result.append(s, offset, std::string::npos);
   return result;
 }
 
@@ -148,12 +161,11 @@ inline std::vector<std::string> tokenize(
 
     size_t j = s.find_first_of(delims, i);
     if (std::string::npos == j) {
-      tokens.push_back(s.substr(i));
-      offset = s.length();
-      continue;
+      tokens.emplace_back(s, i);
+      break;
     }
 
-    tokens.push_back(s.substr(i, j - i));
+    tokens.emplace_back(s, i, j - i);
     offset = j;
   }
   return tokens;
@@ -178,16 +190,16 @@ inline std::vector<std::string> split(
   while (n.isNone() || n.get() > 0) {
     next = s.find_first_of(delims, offset);
     if (next == std::string::npos) {
-      tokens.push_back(s.substr(offset));
+      tokens.emplace_back(s, offset);
       break;
     }
 
-    tokens.push_back(s.substr(offset, next - offset));
+    tokens.emplace_back(s, offset, next - offset);
     offset = next + 1;
 
     // Finish splitting if we've found enough tokens.
     if (n.isSome() && tokens.size() == n.get() - 1) {
-      tokens.push_back(s.substr(offset));
+      tokens.emplace_back(s, offset);
       break;
     }
   }
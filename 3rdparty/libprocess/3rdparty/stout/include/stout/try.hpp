@@ -17,6 +17,7 @@
 
 #include <iostream>
 #include <string>
+#include <utility>
 
 #include <stout/abort.hpp>
 #include <stout/error.hpp>
@@ -51,6 +52,9 @@ public:
   Try(const T& t)
     : data(Some(t)) {}
 
+  Try(T&& t)
+    : data(Some(std::move(t))) {}
+
   template <typename U>
   Try(const U& u)
     : data(Some(u)) {}
@@ -69,20 +73,20 @@ public:
     : message(error.message) {}
 #endif // __WINDOWS__
 
-  // TODO(bmahler): Add move constructor.
-
   // We don't need to implement these because we are leveraging
   // Option<T>.
   Try(const Try<T>& that) = default;
+  Try(Try<T>&& that) = default;
   ~Try() = default;
   Try<T>& operator=(const Try<T>& that) = default;
+  Try<T>& operator=(Try<T>&& that) = default;
 
   // 'isSome' and 'isError' are mutually exclusive. They correspond
   // to the underlying state of the Option.
   bool isSome() const { return data.isSome(); }
   bool isError() const { return data.isNone(); }
 
-  const T& get() const
+  const T& get() const &
   {
     if (!data.isSome()) {
       ABORT("Try::get() but state == ERROR: " + message);
@@ -90,11 +94,17 @@ public:
     return data.get();
   }
 
-  T& get()
+  T& get() &
   {
     return const_cast<T&>(static_cast<const Try&>(*this).get());
   }
 
+  // The value of a temporary can be moved out of it.
+  T&& get() &&
+  {
+    return std::move(get());
+  }
+
   const T* operator->() const { return &get(); }
   T* operator->() { return &get(); }
 
@@ -41,6 +41,38 @@ inline Try<std::string> decompress(const std::string& compressed)
   UNIMPLEMENTED;
 }
 
+
+class Decompressor
+{
+public:
+  Try<std::string> decompress(const std::string& compressed)
+  {
+    UNIMPLEMENTED;
+  }
+
+  bool finished() const
+  {
+    UNIMPLEMENTED;
+  }
+};
+
+
+class Compressor
+{
+public:
+  explicit Compressor(int level = Z_DEFAULT_COMPRESSION) {}
+
+  Try<std::string> compress(const std::string& decompressed)
+  {
+    UNIMPLEMENTED;
+  }
+
+  Try<std::string> finish()
+  {
+    UNIMPLEMENTED;
+  }
+};
+
 } // namespace gzip {
 
 #endif // __STOUT_WINDOWS_GZIP_HPP__
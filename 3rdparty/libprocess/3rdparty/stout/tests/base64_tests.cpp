@@ -10,15 +10,31 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <string>
+
 #include <gtest/gtest.h>
 
 #include <stout/base64.hpp>
 #include <stout/gtest.hpp>
 
+using std::string;
+
 
 TEST(Base64Test, Encode)
 {
   EXPECT_EQ("dXNlcjpwYXNzd29yZA==", base64::encode("user:password"));
+
+  // Test vectors from RFC 4648.
+  EXPECT_EQ("", base64::encode(""));
+  EXPECT_EQ("Zg==", base64::encode("f"));
+  EXPECT_EQ("Zm8=", base64::encode("fo"));
+  EXPECT_EQ("Zm9v", base64::encode("foo"));
+  EXPECT_EQ("Zm9vYg==", base64::encode("foob"));
+  EXPECT_EQ("Zm9vYmE=", base64::encode("fooba"));
+  EXPECT_EQ("Zm9vYmFy", base64::encode("foobar"));
+
+  EXPECT_EQ("AP8=", base64::encode(string("\x00\xff", 2)));
+  EXPECT_EQ("+/+/", base64::encode("\xfb\xff\xbf"));
 }
 
 
@@ -43,3 +59,16 @@ TEST(Base64Test, Decode)
   //  EXPECT_ERROR(base64::decode("ab=,"));
   //  EXPECT_ERROR(base64::decode("ab==="));
 }
+
+
+// Tests that decoding reverses encoding for all the byte values and
+// for all the possible padding lengths.
+TEST(Base64Test, RoundTrip)
+{
+  string s;
+  for (int i = 0; i < 256 + 3; i++) {
+    s += static_cast<char>(i % 256);
+
+    EXPECT_SOME_EQ(s, base64::decode(base64::encode(s)));
+  }
+}
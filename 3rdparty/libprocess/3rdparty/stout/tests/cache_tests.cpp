@@ -15,7 +15,9 @@
 #include <gtest/gtest.h>
 
 #include <stout/cache.hpp>
+#include <stout/duration.hpp>
 #include <stout/gtest.hpp>
+#include <stout/os.hpp>
 
 
 TEST(CacheTest, Insert)
@@ -86,3 +88,51 @@ TEST(CacheTest, LRUEviction)
   cache.put(7, "g");
   EXPECT_NONE(cache.get(5));
 }
+
+
+TEST(CacheTest, Statistics)
+{
+  Cache<int, std::string> cache(2);
+  cache.put(1, "a");
+  cache.put(2, "b");
+
+  EXPECT_SOME_EQ("a", cache.get(1));
+  EXPECT_NONE(cache.get(3));
+
+  // Evicts '2', the least-recently used.
+  cache.put(3, "c");
+  EXPECT_NONE(cache.get(2));
+
+  EXPECT_EQ(1u, cache.statistics().hits);
+  EXPECT_EQ(2u, cache.statistics().misses);
+  EXPECT_EQ(1u, cache.statistics().evictions);
+  EXPECT_EQ(0u, cache.statistics().expirations);
+
+  cache.clear();
+  EXPECT_EQ(0u, cache.size());
+  EXPECT_NONE(cache.get(1));
+  EXPECT_EQ(3u, cache.statistics().misses);
+}
+
+
+TEST(CacheTest, TTL)
+{
+  Cache<int, std::string> cache(2, Milliseconds(10));
+  cache.put(1, "a");
+  cache.put(2, "b");
+
+  EXPECT_SOME_EQ("a", cache.get(1));
+
+  ASSERT_SOME(os::sleep(Milliseconds(20)));
+
+  // Writing a value resets its time to live.
+  cache.put(2, "x");
+
+  EXPECT_NONE(cache.get(1));
+  EXPECT_SOME_EQ("x", cache.get(2));
+  EXPECT_EQ(1u, cache.size());
+
+  EXPECT_EQ(2u, cache.statistics().hits);
+  EXPECT_EQ(1u, cache.statistics().misses);
+  EXPECT_EQ(1u, cache.statistics().expirations);
+}
@@ -0,0 +1,216 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <stout/flat_hashmap.hpp>
+#include <stout/foreach.hpp>
+#include <stout/gtest.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/stringify.hpp>
+
+using std::string;
+
+
+TEST(FlatHashMapTest, InitializerList)
+{
+  flat_hashmap<string, int> map{{"hello", 1}};
+  EXPECT_EQ(1u, map.size());
+
+  EXPECT_TRUE((flat_hashmap<int, int>{}.empty()));
+
+  flat_hashmap<int, int> map2{{1, 2}, {2, 3}, {3, 4}};
+  EXPECT_EQ(3u, map2.size());
+  EXPECT_SOME_EQ(2, map2.get(1));
+  EXPECT_SOME_EQ(3, map2.get(2));
+  EXPECT_SOME_EQ(4, map2.get(3));
+  EXPECT_NONE(map2.get(4));
+}
+
+
+TEST(FlatHashMapTest, FromStdMap)
+{
+  std::map<int, int> map1{{1, 2}, {2, 3}};
+
+  flat_hashmap<int, int> map2(map1);
+
+  EXPECT_EQ(2u, map2.size());
+  EXPECT_SOME_EQ(2, map2.get(1));
+  EXPECT_SOME_EQ(3, map2.get(2));
+}
+
+
+TEST(FlatHashMapTest, Insert)
+{
+  flat_hashmap<string, int> map;
+  map["abc"] = 1;
+  map.put("def", 2);
+
+  ASSERT_SOME_EQ(1, map.get("abc"));
+  ASSERT_SOME_EQ(2, map.get("def"));
+
+  map.put("def", 4);
+  ASSERT_SOME_EQ(4, map.get("def"));
+  ASSERT_EQ(2u, map.size());
+
+  EXPECT_FALSE(map.insert({"abc", 5}).second);
+  EXPECT_TRUE(map.emplace("ghi", 6).second);
+
+  EXPECT_EQ(1, map.at("abc"));
+  EXPECT_EQ(6, map.at("ghi"));
+  EXPECT_EQ(3u, map.size());
+}
+
+
+TEST(FlatHashMapTest, Contains)
+{
+  flat_hashmap<string, int> map;
+  map["abc"] = 1;
+
+  ASSERT_TRUE(map.contains("abc"));
+  ASSERT_TRUE(map.containsValue(1));
+
+  ASSERT_FALSE(map.contains("def"));
+  ASSERT_FALSE(map.containsValue(2));
+}
+
+
+TEST(FlatHashMapTest, Erase)
+{
+  flat_hashmap<int, string> map;
+
+  for (int i = 0; i < 1000; i++) {
+    map[i] = stringify(i);
+  }
+
+  EXPECT_EQ(1000u, map.size());
+
+  // Erasing entries while iterating only invalidates the iterator to
+  // the erased entry.
+  for (auto iterator = map.begin(); iterator != map.end();) {
+    if (iterator->first % 2 == 0) {
+      iterator = map.erase(iterator);
+    } else {
+      ++iterator;
+    }
+  }
+
+  EXPECT_EQ(500u, map.size());
+
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_EQ(i % 2 == 1, map.contains(i));
+  }
+
+  EXPECT_EQ(0u, map.erase(0));
+  EXPECT_EQ(1u, map.erase(1));
+  EXPECT_EQ(499u, map.size());
+
+  // Reinsert the erased entries, which reuses their slots.
+  for (int i = 0; i < 1000; i += 2) {
+    map[i] = stringify(i);
+  }
+
+  EXPECT_EQ(999u, map.size());
+  EXPECT_SOME_EQ("998", map.get(998));
+  EXPECT_NONE(map.get(1));
+
+  map.clear();
+
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.begin() == map.end());
+  EXPECT_NONE(map.get(998));
+}
+
+
+// Tests that interleaved insertions and erasures keep the map
+// consistent with 'hashmap', e.g., when reusing erased slots.
+TEST(FlatHashMapTest, Equivalence)
+{
+  flat_hashmap<int, int> map;
+  hashmap<int, int> expected;
+
+  for (int i = 0; i < 10000; i++) {
+    const int key = (i * 7919) % 997;
+
+    if (i % 3 == 0) {
+      EXPECT_EQ(expected.erase(key), map.erase(key));
+    } else {
+      map[key] += i;
+      expected[key] += i;
+    }
+  }
+
+  EXPECT_EQ(expected.size(), map.size());
+
+  size_t size = 0;
+  foreachpair (int key, int value, map) {
+    EXPECT_SOME_EQ(value, expected.get(key));
+    size++;
+  }
+
+  EXPECT_EQ(expected.size(), size);
+  EXPECT_EQ(expected.keys(), map.keys());
+}
+
+
+TEST(FlatHashMapTest, Copy)
+{
+  flat_hashmap<string, std::shared_ptr<int>> map;
+  map["abc"] = std::make_shared<int>(1);
+
+  flat_hashmap<string, std::shared_ptr<int>> copy = map;
+
+  EXPECT_TRUE(copy == map);
+  EXPECT_EQ(2, map["abc"].use_count());
+
+  flat_hashmap<string, std::shared_ptr<int>> moved = std::move(copy);
+
+  EXPECT_TRUE(copy.empty());
+  EXPECT_TRUE(moved == map);
+  EXPECT_EQ(2, map["abc"].use_count());
+
+  moved.clear();
+
+  EXPECT_EQ(1, map["abc"].use_count());
+
+  copy["def"] = std::make_shared<int>(2);
+  copy = map;
+
+  EXPECT_TRUE(copy == map);
+  EXPECT_FALSE(copy.contains("def"));
+}
+
+
+TEST(FlatHashMapTest, Foreach)
+{
+  const flat_hashmap<string, int> map{{"a", 1}, {"b", 2}, {"c", 3}};
+
+  int sum = 0;
+  foreachvalue (int value, map) {
+    sum += value;
+  }
+
+  EXPECT_EQ(6, sum);
+
+  string keys;
+  foreachkey (const string& key, map) {
+    keys += key;
+  }
+
+  EXPECT_EQ(3u, keys.size());
+  EXPECT_EQ(3u, map.values().size());
+  EXPECT_EQ(hashset<string>({"a", "b", "c"}), map.keys());
+}
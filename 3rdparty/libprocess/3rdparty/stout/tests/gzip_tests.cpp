@@ -62,4 +62,79 @@ TEST(GzipTest, CompressDecompressString)
   ASSERT_SOME(decompressed);
   ASSERT_EQ(s, decompressed.get());
 }
+
+
+TEST(GzipTest, Decompressor)
+{
+  // Use a 1MB random string so that the output of a single piece of
+  // input can exceed the size of the internal buffer.
+  string s = "";
+  while (s.length() < (1024 * 1024)) {
+    s.append(1, ' ' + (rand() % ('~' - ' ')));
+  }
+
+  Try<string> compressed = gzip::compress(s);
+  ASSERT_SOME(compressed);
+
+  // Feed the compressed data in pieces of varying sizes.
+  gzip::Decompressor decompressor;
+  string decompressed = "";
+  size_t offset = 0;
+  size_t size = 1;
+  while (offset < compressed.get().size()) {
+    Try<string> piece =
+      decompressor.decompress(compressed.get().substr(offset, size));
+    ASSERT_SOME(piece);
+    decompressed += piece.get();
+    offset += size;
+    size = size * 2 + 1;
+  }
+
+  EXPECT_TRUE(decompressor.finished());
+  EXPECT_EQ(s, decompressed);
+
+  // Data after the end of the stream is an error.
+  EXPECT_ERROR(decompressor.decompress("trailing"));
+
+  // Invalid input is an error.
+  gzip::Decompressor invalid;
+  EXPECT_ERROR(invalid.decompress("not gzip data"));
+  EXPECT_FALSE(invalid.finished());
+}
+
+
+TEST(GzipTest, Compressor)
+{
+  string s = "";
+  while (s.length() < (1024 * 1024)) {
+    s.append(1, ' ' + (rand() % ('~' - ' ')));
+  }
+
+  // Compress the data in pieces of varying sizes, each of which can
+  // be decompressed as soon as it has been compressed.
+  gzip::Compressor compressor;
+  gzip::Decompressor decompressor;
+  size_t offset = 0;
+  size_t size = 1;
+  while (offset < s.size()) {
+    const string piece = s.substr(offset, size);
+
+    Try<string> compressed = compressor.compress(piece);
+    ASSERT_SOME(compressed);
+    EXPECT_SOME_EQ(piece, decompressor.decompress(compressed.get()));
+
+    offset += size;
+    size = size * 2 + 1;
+  }
+
+  EXPECT_FALSE(decompressor.finished());
+
+  Try<string> end = compressor.finish();
+  ASSERT_SOME(end);
+  EXPECT_SOME_EQ("", decompressor.decompress(end.get()));
+  EXPECT_TRUE(decompressor.finished());
+
+  // Data after the end of the stream is an error.
+  EXPECT_ERROR(compressor.compress("trailing"));
+}
 #endif // HAVE_LIBZ
@@ -241,6 +241,79 @@ TEST(JsonTest, Parse)
 }
 
 
+TEST(JsonTest, ParseValues)
+{
+  Try<JSON::Value> value = JSON::parse(
+      "{"
+      "  \"null\": null,"
+      "  \"true\": true,"
+      "  \"false\": false,"
+      "  \"integer\": -42,"
+      "  \"double\": 1.5e3,"
+      "  \"large\": 9223372036854775808,"
+      "  \"escaped\": \"\\\"\\\\\\/\\b\\f\\n\\r\\t\","
+      "  \"unicode\": \"\\u0041\\u00e9\\u20ac\\ud83d\\ude00\","
+      "  \"utf8\": \"\xc3\xa9\","
+      "  \"nested\": [[], {}, [1, {\"a\": [\"b\"]}]],"
+      "  \"duplicate\": 1,"
+      "  \"duplicate\": 2"
+      "}");
+
+  ASSERT_SOME(value);
+  ASSERT_TRUE(value->is<JSON::Object>());
+
+  const JSON::Object& object = value->as<JSON::Object>();
+
+  EXPECT_SOME_EQ(JSON::Null(), object.find<JSON::Null>("null"));
+  EXPECT_SOME_EQ(JSON::True(), object.find<JSON::Boolean>("true"));
+  EXPECT_SOME_EQ(JSON::False(), object.find<JSON::Boolean>("false"));
+
+  Result<JSON::Number> integer = object.find<JSON::Number>("integer");
+  ASSERT_SOME(integer);
+  EXPECT_EQ(JSON::Number::SIGNED_INTEGER, integer->type);
+  EXPECT_EQ(-42, integer->as<int64_t>());
+
+  Result<JSON::Number> floating = object.find<JSON::Number>("double");
+  ASSERT_SOME(floating);
+  EXPECT_EQ(JSON::Number::FLOATING, floating->type);
+  EXPECT_EQ(1500.0, floating->as<double>());
+
+  // Integers which do not fit into an int64_t are parsed as doubles.
+  Result<JSON::Number> large = object.find<JSON::Number>("large");
+  ASSERT_SOME(large);
+  EXPECT_EQ(JSON::Number::FLOATING, large->type);
+
+  EXPECT_SOME_EQ(
+      JSON::String("\"\\/\b\f\n\r\t"),
+      object.find<JSON::String>("escaped"));
+
+  EXPECT_SOME_EQ(
+      JSON::String("A\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80"),
+      object.find<JSON::String>("unicode"));
+
+  EXPECT_SOME_EQ(JSON::String("\xc3\xa9"), object.find<JSON::String>("utf8"));
+
+  JSON::Array inner;
+  inner.values.push_back("b");
+
+  JSON::Object a;
+  a.values["a"] = inner;
+
+  JSON::Array last;
+  last.values.push_back(1);
+  last.values.push_back(a);
+
+  JSON::Array nested;
+  nested.values.push_back(JSON::Array());
+  nested.values.push_back(JSON::Object());
+  nested.values.push_back(last);
+
+  EXPECT_SOME_EQ(nested, object.find<JSON::Array>("nested"));
+
+  EXPECT_SOME_EQ(JSON::Number(2), object.find<JSON::Number>("duplicate"));
+}
+
+
 TEST(JsonTest, ParseError)
 {
   string jsonString =
@@ -270,6 +343,24 @@ TEST(JsonTest, ParseError)
     " ";
 
   EXPECT_ERROR(JSON::parse<JSON::Object>(jsonString));
+
+  EXPECT_ERROR(JSON::parse(""));
+  EXPECT_ERROR(JSON::parse("  "));
+  EXPECT_ERROR(JSON::parse("nul"));
+  EXPECT_ERROR(JSON::parse("[1,]"));
+  EXPECT_ERROR(JSON::parse("{\"key\" 1}"));
+  EXPECT_ERROR(JSON::parse("{key: 1}"));
+  EXPECT_ERROR(JSON::parse("1.2.3"));
+  EXPECT_ERROR(JSON::parse("\"unterminated"));
+  EXPECT_ERROR(JSON::parse("\"control\ncharacter\""));
+  EXPECT_ERROR(JSON::parse("\"\\x\""));
+  EXPECT_ERROR(JSON::parse("\"\\u12\""));
+  EXPECT_ERROR(JSON::parse("\"\\ude00\""));
+  EXPECT_ERROR(JSON::parse("\"\\ud83d\""));
+
+  Try<JSON::Value> value = JSON::parse("{\n  \"key\": value\n}");
+  ASSERT_ERROR(value);
+  EXPECT_EQ("syntax error at line 2 near: value", value.error());
 }
 
 
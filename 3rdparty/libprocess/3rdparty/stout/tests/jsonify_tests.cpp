@@ -0,0 +1,145 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <stout/foreach.hpp>
+#include <stout/gtest.hpp>
+#include <stout/json.hpp>
+#include <stout/jsonify.hpp>
+#include <stout/stringify.hpp>
+
+using std::map;
+using std::string;
+using std::vector;
+
+
+namespace geometry {
+
+struct Point
+{
+  int x;
+  int y;
+};
+
+
+void json(JSON::ObjectWriter* writer, const Point& point)
+{
+  writer->field("x", point.x);
+  writer->field("y", point.y);
+}
+
+} // namespace geometry {
+
+
+TEST(JsonifyTest, Basic)
+{
+  EXPECT_EQ("true", string(jsonify(true)));
+  EXPECT_EQ("false", string(jsonify(false)));
+  EXPECT_EQ("-2", string(jsonify(-2)));
+  EXPECT_EQ("42", string(jsonify(42u)));
+  EXPECT_EQ("1.5", string(jsonify(1.5)));
+  EXPECT_EQ("1.0", string(jsonify(1.0)));
+  EXPECT_EQ("\"hello\"", string(jsonify("hello")));
+  EXPECT_EQ("\"hello\"", string(jsonify(string("hello"))));
+  EXPECT_EQ("null", string(jsonify(JSON::Null())));
+}
+
+
+TEST(JsonifyTest, Escaping)
+{
+  // The escaping is the same as for JSON::String.
+  const string s("\"\\/\b\f\n\r\t\x00\x19 !#[]\x7F\xFF", 17);
+
+  EXPECT_EQ(stringify(JSON::String(s)), string(jsonify(s)));
+
+  map<string, int> object = {{s, 1}};
+  EXPECT_EQ("{" + stringify(JSON::String(s)) + ":1}", string(jsonify(object)));
+}
+
+
+TEST(JsonifyTest, Containers)
+{
+  EXPECT_EQ("[]", string(jsonify(vector<int>())));
+  EXPECT_EQ("[1,2,3]", string(jsonify(vector<int>({1, 2, 3}))));
+  EXPECT_EQ("{}", string(jsonify(map<string, int>())));
+
+  map<string, vector<string>> object =
+    {{"a", {"x", "y"}}, {"b", {}}};
+
+  EXPECT_EQ("{\"a\":[\"x\",\"y\"],\"b\":[]}", string(jsonify(object)));
+}
+
+
+TEST(JsonifyTest, Overload)
+{
+  vector<geometry::Point> points = {{1, 2}, {3, 4}};
+
+  EXPECT_EQ(
+      "[{\"x\":1,\"y\":2},{\"x\":3,\"y\":4}]",
+      string(jsonify(points)));
+}
+
+
+TEST(JsonifyTest, Function)
+{
+  vector<geometry::Point> points = {{1, 2}, {3, 4}};
+
+  auto object = [&points](JSON::ObjectWriter* writer) {
+    writer->field("name", "points");
+    writer->field("points", [&points](JSON::ArrayWriter* writer) {
+      foreach (const geometry::Point& point, points) {
+        if (point.x > 1) {
+          writer->element(point);
+        }
+      }
+    });
+  };
+
+  EXPECT_EQ(
+      "{\"name\":\"points\",\"points\":[{\"x\":3,\"y\":4}]}",
+      string(jsonify(object)));
+}
+
+
+// Values that were built as a JSON::Value produce the same JSON.
+TEST(JsonifyTest, Value)
+{
+  Try<JSON::Value> value = JSON::parse(
+      "{"
+      "  \"array\": [1, -1, 1.5, \"string\", true, false, null],"
+      "  \"empty\": {},"
+      "  \"nested\": {\"a\": [], \"b\": {\"c\": 18446744073709551615}}"
+      "}");
+
+  ASSERT_SOME(value);
+
+  EXPECT_EQ(stringify(value.get()), string(jsonify(value.get())));
+
+  JSON::Object object = value->as<JSON::Object>();
+  EXPECT_EQ(stringify(object), string(jsonify(object)));
+}
+
+
+TEST(JsonifyTest, Stream)
+{
+  std::ostringstream stream;
+  stream << "(" << jsonify(vector<int>({1})) << ")";
+
+  EXPECT_EQ("([1])", stream.str());
+}
@@ -11,6 +11,7 @@
 // limitations under the License
 
 #include <algorithm>
+#include <memory>
 #include <string>
 
 #include <gmock/gmock.h>
@@ -173,3 +174,17 @@ TEST(OptionTest, GetOrElse)
   EXPECT_EQ("Something", something.getOrElse("Else"));
   EXPECT_EQ("Else", none.getOrElse("Else"));
 }
+
+
+TEST(OptionTest, MoveGet)
+{
+  // The value of a temporary can be moved out of it.
+  Option<std::unique_ptr<int>> o = std::unique_ptr<int>(new int(42));
+
+  std::unique_ptr<int> p = std::move(o).get();
+  ASSERT_TRUE(p.get() != NULL);
+  EXPECT_EQ(42, *p);
+
+  Option<string> s = string("moved");
+  EXPECT_EQ("moved", std::move(s).getOrElse("else"));
+}
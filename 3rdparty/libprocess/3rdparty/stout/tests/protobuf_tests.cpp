@@ -24,6 +24,14 @@
 #include <stout/strings.hpp>
 #include <stout/uuid.hpp>
 
+#include <stout/os/close.hpp>
+#include <stout/os/ftruncate.hpp>
+#include <stout/os/open.hpp>
+#include <stout/os/stat.hpp>
+#include <stout/os/write.hpp>
+
+#include <stout/tests/utils.hpp>
+
 #include "protobuf_tests.pb.h"
 
 using std::string;
@@ -339,3 +347,148 @@ TEST(ProtobufTest, ParseJSONArray)
   EXPECT_EQ(message, repeated.Get(0));
   EXPECT_EQ(message, repeated.Get(1));
 }
+
+
+// Tests that 'JSON::serialize' produces the same JSON as stringifying
+// the JSON::Object of a message, and that parsing messages directly
+// from the JSON string produces the same messages.
+TEST(ProtobufTest, Serialize)
+{
+  tests::Message message;
+  message.set_b(true);
+  message.set_str("\"escaped\"\n");
+  message.set_bytes(UUID::random().toBytes());
+  message.set_int32(-2147483647);
+  message.set_int64(-9223372036854775807);
+  message.set_uint32(4294967295U);
+  message.set_uint64(9223372036854775807);
+  message.set_f(1.5);
+  message.set_d(0.1);
+  message.set_e(tests::ONE);
+  message.mutable_nested()->set_str("nested");
+  message.add_repeated_bool(true);
+  message.add_repeated_bool(false);
+  message.add_repeated_string("repeated_string");
+  message.add_repeated_bytes("repeated_bytes");
+  message.add_repeated_sint32(-2);
+  message.add_repeated_float(1.0);
+  message.add_repeated_double(2.5);
+  message.add_repeated_enum(tests::TWO);
+  message.add_repeated_nested()->set_str("repeated_nested");
+  message.add_repeated_nested();
+
+  string json;
+  JSON::serialize(message, &json);
+
+  EXPECT_EQ(stringify(JSON::protobuf(message)), json);
+
+  Try<tests::Message> parse = protobuf::parse<tests::Message>(json);
+  ASSERT_SOME(parse);
+
+  EXPECT_EQ(JSON::protobuf(message), JSON::protobuf(parse.get()));
+
+  // Serializing appends to the string.
+  JSON::serialize(message, &json);
+  EXPECT_EQ(2 * stringify(JSON::protobuf(message)).size(), json.size());
+
+  tests::ArrayMessage arrayMessage;
+  arrayMessage.add_values()->set_id("message1");
+  arrayMessage.add_values()->set_id("message2");
+  arrayMessage.mutable_values(1)->add_numbers(1);
+
+  json.clear();
+  JSON::serialize(arrayMessage.values(), &json);
+
+  EXPECT_EQ(stringify(JSON::protobuf(arrayMessage.values())), json);
+
+  auto repeated =
+    protobuf::parse<RepeatedPtrField<tests::SimpleMessage>>(json);
+  ASSERT_SOME(repeated);
+  ASSERT_EQ(2, repeated->size());
+  EXPECT_EQ(arrayMessage.values(0), repeated->Get(0));
+  EXPECT_EQ(arrayMessage.values(1), repeated->Get(1));
+}
+
+
+TEST(ProtobufTest, ParseString)
+{
+  EXPECT_ERROR(protobuf::parse<tests::SimpleMessage>("{\"id\":"));
+  EXPECT_ERROR(protobuf::parse<tests::SimpleMessage>("{\"id\":\"1\"} x"));
+  EXPECT_ERROR(protobuf::parse<tests::SimpleMessage>("[]"));
+  EXPECT_ERROR(protobuf::parse<tests::SimpleMessage>("{\"id\":1}"));
+  EXPECT_ERROR(protobuf::parse<tests::SimpleMessage>("{\"numbers\":[1]}"));
+  EXPECT_ERROR(
+      protobuf::parse<RepeatedPtrField<tests::SimpleMessage>>("{}"));
+
+  // Unknown fields are ignored.
+  Try<tests::SimpleMessage> parse = protobuf::parse<tests::SimpleMessage>(
+      "{\"id\": \"1\", \"numbers\": [1, 2], \"unknown\": null}");
+
+  ASSERT_SOME(parse);
+  EXPECT_EQ("1", parse->id());
+  ASSERT_EQ(2, parse->numbers_size());
+  EXPECT_EQ(2, parse->numbers(1));
+
+  // Errors in nested messages are propagated.
+  EXPECT_ERROR(protobuf::parse<tests::ArrayMessage>(
+      "{\"values\": [{\"id\": \"1\", \"numbers\": [\"x\"]}]}"));
+}
+
+
+#ifndef __WINDOWS__
+class ProtobufReaderTest : public TemporaryDirectoryTest {};
+
+
+// Tests that the reader reads back the messages written by
+// 'protobuf::append', and stops before a partially written one.
+TEST_F(ProtobufReaderTest, Read)
+{
+  const string path = "messages";
+
+  tests::SimpleMessage message1;
+  message1.set_id("message1");
+  message1.add_numbers(1);
+
+  tests::SimpleMessage message2;
+  message2.set_id("message2");
+
+  ASSERT_SOME(protobuf::append(path, message1));
+  ASSERT_SOME(protobuf::append(path, message2));
+
+  Try<Bytes> size = os::stat::size(path);
+  ASSERT_SOME(size);
+
+  // Append a partial message.
+  ASSERT_SOME(protobuf::append(path, message1));
+
+  Try<int> fd = os::open(path, O_RDWR | O_CLOEXEC);
+  ASSERT_SOME(fd);
+  ASSERT_SOME(os::ftruncate(fd.get(), size->bytes() + 6));
+
+  protobuf::Reader reader;
+  ASSERT_SOME(reader.open(fd.get()));
+  ASSERT_SOME(os::close(fd.get()));
+
+  EXPECT_SOME_EQ(message1, reader.read<tests::SimpleMessage>());
+  EXPECT_SOME_EQ(message2, reader.read<tests::SimpleMessage>());
+  EXPECT_EQ(size->bytes(), static_cast<uint64_t>(reader.offset()));
+
+  EXPECT_ERROR(reader.read<tests::SimpleMessage>());
+  EXPECT_NONE(reader.read<tests::SimpleMessage>(true));
+
+  // Failed reads do not move the reader.
+  EXPECT_EQ(size->bytes(), static_cast<uint64_t>(reader.offset()));
+
+  // An empty file has nothing to read.
+  ASSERT_SOME(os::write("empty", ""));
+
+  fd = os::open("empty", O_RDONLY | O_CLOEXEC);
+  ASSERT_SOME(fd);
+
+  protobuf::Reader empty;
+  ASSERT_SOME(empty.open(fd.get()));
+  ASSERT_SOME(os::close(fd.get()));
+
+  EXPECT_NONE(empty.read<tests::SimpleMessage>());
+}
+#endif // __WINDOWS__
@@ -10,6 +10,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <memory>
 #include <string>
 
 #include <gmock/gmock.h>
@@ -57,3 +58,15 @@ TEST(ResultTest, ArrowOperator)
   s->clear();
   EXPECT_TRUE(s->empty());
 }
+
+
+TEST(ResultTest, Move)
+{
+  // A value can be moved into a result and out of a temporary one.
+  Result<std::unique_ptr<int>> r = std::unique_ptr<int>(new int(42));
+  ASSERT_TRUE(r.isSome());
+
+  std::unique_ptr<int> p = std::move(r).get();
+  ASSERT_TRUE(p.get() != NULL);
+  EXPECT_EQ(42, *p);
+}
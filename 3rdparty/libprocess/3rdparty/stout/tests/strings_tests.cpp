@@ -52,6 +52,13 @@ TEST(StringsTest, Remove)
   EXPECT_EQ("hel world", strings::remove("hello world", "lo"));
   EXPECT_EQ("home/", strings::remove("/home/", "/", strings::PREFIX));
   EXPECT_EQ("/home", strings::remove("/home/", "/", strings::SUFFIX));
+
+  // Removing a substring can form new occurrences, which are
+  // removed as well.
+  EXPECT_EQ("", strings::remove("aabb", "ab"));
+  EXPECT_EQ("c", strings::remove("aaabbbc", "ab"));
+  EXPECT_EQ("xy", strings::remove("xabcabcy", "abc"));
+  EXPECT_EQ("hello", strings::remove("hello", ""));
 }
 
 
@@ -10,6 +10,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <memory>
 #include <string>
 
 #include <gtest/gtest.h>
@@ -26,3 +27,18 @@ TEST(TryTest, ArrowOperator)
   s->clear();
   EXPECT_TRUE(s->empty());
 }
+
+
+TEST(TryTest, Move)
+{
+  // A value can be moved into a try and out of a temporary one.
+  Try<std::unique_ptr<int>> t = std::unique_ptr<int>(new int(42));
+  ASSERT_TRUE(t.isSome());
+
+  Try<std::unique_ptr<int>> moved = std::move(t);
+  ASSERT_TRUE(moved.isSome());
+
+  std::unique_ptr<int> p = std::move(moved).get();
+  ASSERT_TRUE(p.get() != NULL);
+  EXPECT_EQ(42, *p);
+}
@@ -56,11 +56,11 @@ set(PROCESS_DEPENDENCIES
   ${PROTOBUF_TARGET}
   )
 
-if (NOT ENABLE_LIBEVENT)
+if (NOT ENABLE_LIBEVENT AND NOT ENABLE_EPOLL)
   set(PROCESS_DEPENDENCIES ${PROCESS_DEPENDENCIES} ${LIBEV_TARGET})
 elseif (ENABLE_LIBEVENT)
   set(PROCESS_DEPENDENCIES ${PROCESS_DEPENDENCIES} ${LIBEVENT_TARGET})
-endif (NOT ENABLE_LIBEVENT)
+endif (NOT ENABLE_LIBEVENT AND NOT ENABLE_EPOLL)
 
 if (WIN32)
   set(PROCESS_DEPENDENCIES ${PROCESS_DEPENDENCIES} ${CURL_TARGET})
@@ -79,11 +79,11 @@ set(PROCESS_INCLUDE_DIRS
   ${HTTP_PARSER_INCLUDE_DIR}
   )
 
-if (NOT ENABLE_LIBEVENT)
+if (NOT ENABLE_LIBEVENT AND NOT ENABLE_EPOLL)
   set(PROCESS_INCLUDE_DIRS ${PROCESS_INCLUDE_DIRS} ${LIBEV_INCLUDE_DIR})
 elseif (ENABLE_LIBEVENT)
   set(PROCESS_INCLUDE_DIRS ${PROCESS_INCLUDE_DIRS} ${LIBEVENT_INCLUDE_DIR})
-endif (NOT ENABLE_LIBEVENT)
+endif (NOT ENABLE_LIBEVENT AND NOT ENABLE_EPOLL)
 
 if (HAS_GPERFTOOLS)
   set(PROCESS_INCLUDE_DIRS ${PROCESS_INCLUDE_DIRS} ${GPERFTOOLS_INCLUDE_DIR})
@@ -103,11 +103,11 @@ set(PROCESS_LIB_DIRS
   ${HTTP_PARSER_LIB_DIR}
   )
 
-if (NOT ENABLE_LIBEVENT)
+if (NOT ENABLE_LIBEVENT AND NOT ENABLE_EPOLL)
   set(PROCESS_LIB_DIRS ${PROCESS_LIB_DIRS} ${LIBEV_LIB_DIR})
 elseif (ENABLE_LIBEVENT)
   set(PROCESS_LIB_DIRS ${PROCESS_LIB_DIRS} ${LIBEVENT_LIB_DIR})
-endif (NOT ENABLE_LIBEVENT)
+endif (NOT ENABLE_LIBEVENT AND NOT ENABLE_EPOLL)
 
 if (WIN32)
   set(PROCESS_LIB_DIRS ${PROCESS_LIB_DIRS} ${CURL_LIB_DIR})
@@ -127,11 +127,21 @@ set(PROCESS_LIBS
   ${CMAKE_THREAD_LIBS_INIT}
   )
 
-if (NOT ENABLE_LIBEVENT)
+if (NOT ENABLE_LIBEVENT AND NOT ENABLE_EPOLL)
   set(PROCESS_LIBS ${PROCESS_LIBS} ${LIBEV_LFLAG})
 elseif (ENABLE_LIBEVENT)
   set(PROCESS_LIBS ${PROCESS_LIBS} ${LIBEVENT_LFLAG})
-endif (NOT ENABLE_LIBEVENT)
+endif (NOT ENABLE_LIBEVENT AND NOT ENABLE_EPOLL)
+
+if (ENABLE_JEMALLOC)
+  find_library(JEMALLOC_LIB jemalloc)
+  if (NOT JEMALLOC_LIB)
+    message(FATAL_ERROR "Cannot find libjemalloc for `ENABLE_JEMALLOC`.")
+  endif (NOT JEMALLOC_LIB)
+
+  add_definitions(-DENABLE_JEMALLOC)
+  set(PROCESS_LIBS ${PROCESS_LIBS} ${JEMALLOC_LIB})
+endif (ENABLE_JEMALLOC)
 
 if (WIN32)
   set(PROCESS_LIBS ${PROCESS_LIBS} ${CURL_LFLAG})
@@ -149,5 +159,6 @@ elseif (NOT WIN32)
   set(PROCESS_LIBS
     ${PROCESS_LIBS}
     ${ZLIB_LIBRARIES}
+    ${CMAKE_DL_LIBS}
     )
 endif (WIN32)
@@ -20,8 +20,11 @@
 
 #ifndef __WINDOWS__
 #include <arpa/inet.h>
+#include <sys/un.h>
 #endif // __WINDOWS__
 
+#include <string.h>
+
 #include <glog/logging.h>
 
 #include <sstream>
@@ -31,13 +34,17 @@
 #include <stout/abort.hpp>
 #include <stout/ip.hpp>
 #include <stout/net.hpp>
+#include <stout/option.hpp>
 #include <stout/stringify.hpp>
+#include <stout/try.hpp>
 
 namespace process {
 namespace network {
 
 // Represents a network "address", subsuming the struct addrinfo and
 // struct sockaddr* that typically is used to encapsulate IP and port.
+// An address with a 'path' is the address of a unix domain socket,
+// its 'ip' and 'port' are then unused.
 //
 // TODO(benh): Create a Family enumeration to replace sa_family_t.
 // TODO(jieyu): Move this class to stout.
@@ -53,6 +60,21 @@ public:
     return Address(net::IP(INADDR_ANY), 0);
   }
 
+#ifndef __WINDOWS__
+  // Returns the address of the unix domain socket at 'path', e.g.,
+  // "/var/run/docker.sock".
+  static Try<Address> create(const std::string& path)
+  {
+    if (path.size() >= sizeof(((struct sockaddr_un*) 0)->sun_path)) {
+      return Error("Path '" + path + "' is too long for a unix domain socket");
+    }
+
+    Address address;
+    address.path = path;
+    return address;
+  }
+#endif // __WINDOWS__
+
   static Try<Address> create(const struct sockaddr_storage& storage)
   {
     switch (storage.ss_family) {
@@ -60,6 +82,19 @@ public:
          struct sockaddr_in addr = *(struct sockaddr_in*) &storage;
          return Address(net::IP(addr.sin_addr), ntohs(addr.sin_port));
        }
+#ifndef __WINDOWS__
+       case AF_UNIX: {
+         // NOTE: An unnamed socket (e.g., the client side of a
+         // connection) has an empty path, assuming the storage was
+         // zeroed before it was filled in.
+         const struct sockaddr_un* addr = (struct sockaddr_un*) &storage;
+         Address address;
+         address.path = std::string(
+             addr->sun_path,
+             strnlen(addr->sun_path, sizeof(addr->sun_path)));
+         return address;
+       }
+#endif // __WINDOWS__
        default: {
          return Error(
              "Unsupported family type: " +
@@ -70,9 +105,36 @@ public:
 
   int family() const
   {
+#ifndef __WINDOWS__
+    if (path.isSome()) {
+      return AF_UNIX;
+    }
+#endif // __WINDOWS__
+
     return ip.family();
   }
 
+  // Returns the storage of this address, as expected by bind(2) and
+  // connect(2) together with size().
+  struct sockaddr_storage storage() const
+  {
+#ifndef __WINDOWS__
+    if (path.isSome()) {
+      struct sockaddr_storage storage;
+      memset(&storage, 0, sizeof(storage));
+
+      struct sockaddr_un* addr = (struct sockaddr_un*) &storage;
+      addr->sun_family = AF_UNIX;
+
+      // Truncation is ruled out by 'create'.
+      strncpy(addr->sun_path, path->c_str(), sizeof(addr->sun_path) - 1);
+      return storage;
+    }
+#endif // __WINDOWS__
+
+    return net::createSockaddrStorage(ip, port);
+  }
+
   /**
    * Returns the hostname of this address's IP.
    *
@@ -82,6 +144,10 @@ public:
   // deal with slow name resolution.
   Try<std::string> hostname() const
   {
+    if (path.isSome()) {
+      return Error("A unix domain socket address has no hostname");
+    }
+
     const Try<std::string> hostname = ip == net::IP(INADDR_ANY)
       ? net::hostname()
       : net::getHostname(ip);
@@ -100,6 +166,10 @@ public:
     switch (family()) {
       case AF_INET:
         return sizeof(sockaddr_in);
+#ifndef __WINDOWS__
+      case AF_UNIX:
+        return sizeof(sockaddr_un);
+#endif // __WINDOWS__
       default:
         ABORT("Unsupported family type: " + stringify(family()));
     }
@@ -107,7 +177,9 @@ public:
 
   bool operator<(const Address& that) const
   {
-    if (ip == that.ip) {
+    if (path != that.path) {
+      return path.getOrElse("") < that.path.getOrElse("");
+    } else if (ip == that.ip) {
       return port < that.port;
     } else {
       return ip < that.ip;
@@ -116,16 +188,12 @@ public:
 
   bool operator>(const Address& that) const
   {
-    if (ip == that.ip) {
-      return port > that.port;
-    } else {
-      return ip > that.ip;
-    }
+    return that < *this;
   }
 
   bool operator==(const Address& that) const
   {
-    return (ip == that.ip && port == that.port);
+    return (ip == that.ip && port == that.port && path == that.path);
   }
 
   bool operator!=(const Address& that) const
@@ -135,12 +203,19 @@ public:
 
   net::IP ip;
   uint16_t port;
+
+  // The path of a unix domain socket, see 'create(path)'.
+  Option<std::string> path;
 };
 
 
 inline std::ostream& operator<<(std::ostream& stream, const Address& address)
 {
-  stream << address.ip << ":" << address.port;
+  if (address.path.isSome()) {
+    stream << "unix:" << address.path.get();
+  } else {
+    stream << address.ip << ":" << address.port;
+  }
   return stream;
 }
 
@@ -161,6 +236,7 @@ struct hash<process::network::Address>
     size_t seed = 0;
     boost::hash_combine(seed, std::hash<net::IP>()(address.ip));
     boost::hash_combine(seed, address.port);
+    boost::hash_combine(seed, address.path.getOrElse(""));
     return seed;
   }
 };
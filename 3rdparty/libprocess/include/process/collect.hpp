@@ -13,8 +13,11 @@
 #ifndef __PROCESS_COLLECT_HPP__
 #define __PROCESS_COLLECT_HPP__
 
+#include <atomic>
 #include <list>
+#include <memory>
 #include <tuple>
+#include <vector>
 
 #include <process/check.hpp>
 #include <process/defer.hpp>
@@ -22,6 +25,7 @@
 #include <process/owned.hpp>
 #include <process/process.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
 
 // TODO(bmahler): Move these into a futures.hpp header to group Future
@@ -37,6 +41,14 @@ template <typename T>
 Future<std::list<T>> collect(const std::list<Future<T>>& futures);
 
 
+// Like 'collect' above, but for a vector of futures. Rather than
+// spawning a process and dispatching to it for each future, this
+// counts the futures down in their callbacks and completes the result
+// in the callback of the last one, which is cheaper for many futures.
+template <typename T>
+Future<std::vector<T>> collect(const std::vector<Future<T>>& futures);
+
+
 // Waits on each future specified and returns the wrapping future
 // typed of a tuple of values.
 // TODO(jieyu): Investigate the use of variadic templates here.
@@ -52,6 +64,12 @@ template <typename T>
 Future<std::list<Future<T>>> await(const std::list<Future<T>>& futures);
 
 
+// Like 'await' above, but for a vector of futures, without spawning a
+// process, see 'collect' for a vector of futures.
+template <typename T>
+Future<std::vector<Future<T>>> await(const std::vector<Future<T>>& futures);
+
+
 // Waits on each future specified and returns the wrapping future
 // typed of a tuple of futures.
 // TODO(jieyu): Investigate the use of variadic templates here.
@@ -191,6 +209,38 @@ private:
 };
 
 
+// The state shared by the callbacks of the futures that 'collect' and
+// 'await' wait on for a vector of futures. Only the callback of the
+// result holds a strong reference, the callbacks of the futures hold
+// weak references: the state holds the futures, so a strong reference
+// from a future that stays pending would keep the state (and every
+// other future) alive even after the result completed.
+template <typename T, typename R>
+struct Waiter
+{
+  explicit Waiter(const std::vector<Future<T>>& _futures)
+    : futures(_futures),
+      pending(_futures.size()) {}
+
+  // Stop this nonsense if nobody cares.
+  static void discarded(const std::weak_ptr<Waiter>& reference)
+  {
+    std::shared_ptr<Waiter> waiter = reference.lock();
+
+    if (waiter) {
+      waiter->promise.discard();
+
+      foreach (Future<T> future, waiter->futures) {
+        future.discard();
+      }
+    }
+  }
+
+  const std::vector<Future<T>> futures;
+  Promise<R> promise;
+  std::atomic<size_t> pending;
+};
+
 } // namespace internal {
 
 
@@ -209,6 +259,55 @@ inline Future<std::list<T>> collect(
 }
 
 
+template <typename T>
+inline Future<std::vector<T>> collect(
+    const std::vector<Future<T>>& futures)
+{
+  if (futures.empty()) {
+    return std::vector<T>();
+  }
+
+  typedef internal::Waiter<T, std::vector<T>> Waiter;
+
+  std::shared_ptr<Waiter> waiter(new Waiter(futures));
+  Future<std::vector<T>> result = waiter->promise.future();
+
+  std::weak_ptr<Waiter> reference(waiter);
+
+  result.onDiscard(lambda::bind(&Waiter::discarded, reference));
+
+  // Release the state once the result completes.
+  result.onAny([waiter]() {});
+
+  foreach (const Future<T>& future, futures) {
+    future.onAny([reference](const Future<T>& future) {
+      std::shared_ptr<Waiter> waiter = reference.lock();
+
+      if (!waiter) {
+        return;
+      } else if (future.isFailed()) {
+        waiter->promise.fail("Collect failed: " + future.failure());
+      } else if (future.isDiscarded()) {
+        waiter->promise.fail("Collect failed: future discarded");
+      } else if (--waiter->pending == 0) {
+        // Only the last future to complete gets here, by which time
+        // all of the futures are ready.
+        std::vector<T> values;
+        values.reserve(waiter->futures.size());
+
+        foreach (const Future<T>& future, waiter->futures) {
+          values.push_back(future.get());
+        }
+
+        waiter->promise.set(std::move(values));
+      }
+    });
+  }
+
+  return result;
+}
+
+
 template <typename T1, typename T2>
 Future<std::tuple<T1, T2>> collect(
     const Future<T1>& future1,
@@ -243,6 +342,40 @@ inline Future<std::list<Future<T>>> await(
 }
 
 
+template <typename T>
+inline Future<std::vector<Future<T>>> await(
+    const std::vector<Future<T>>& futures)
+{
+  if (futures.empty()) {
+    return futures;
+  }
+
+  typedef internal::Waiter<T, std::vector<Future<T>>> Waiter;
+
+  std::shared_ptr<Waiter> waiter(new Waiter(futures));
+  Future<std::vector<Future<T>>> result = waiter->promise.future();
+
+  std::weak_ptr<Waiter> reference(waiter);
+
+  result.onDiscard(lambda::bind(&Waiter::discarded, reference));
+
+  // Release the state once the result completes.
+  result.onAny([waiter]() {});
+
+  foreach (const Future<T>& future, futures) {
+    future.onAny([reference]() {
+      std::shared_ptr<Waiter> waiter = reference.lock();
+
+      if (waiter && --waiter->pending == 0) {
+        waiter->promise.set(waiter->futures);
+      }
+    });
+  }
+
+  return result;
+}
+
+
 template <typename T1, typename T2>
 Future<std::tuple<Future<T1>, Future<T2>>> await(
     const Future<T1>& future1,
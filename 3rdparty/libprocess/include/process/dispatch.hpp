@@ -13,9 +13,13 @@
 #ifndef __PROCESS_DISPATCH_HPP__
 #define __PROCESS_DISPATCH_HPP__
 
+#include <stdint.h>
+#include <string.h>
+
 #include <functional>
 #include <memory> // TODO(benh): Replace shared_ptr with unique_ptr.
 #include <string>
+#include <utility>
 
 #include <process/process.hpp>
 
@@ -58,12 +62,45 @@ namespace internal {
 // this routine does not expect anything in particular about the
 // specified function (second argument). The semantics are simple: the
 // function gets applied/invoked with the process as its first
-// argument. Currently we wrap the function in a shared_ptr but this
-// will probably change in the future to unique_ptr (or a variant).
+// argument. The function is stored inline in the DispatchEvent (see
+// DispatchEvent::Function) so a dispatch does not need to allocate
+// anything besides the (recycled) event itself.
+void dispatch(DispatchEvent* event);
+
+
+template <typename F>
 void dispatch(
     const UPID& pid,
-    const std::shared_ptr<std::function<void(ProcessBase*)>>& f,
-    const Option<const std::type_info*>& functionType = None());
+    F&& f,
+    const Option<const std::type_info*>& functionType = None(),
+    const void* function = NULL)
+{
+  dispatch(new DispatchEvent(
+      pid, std::forward<F>(f), functionType, function));
+}
+
+
+// Returns the address of the member function that 'method' points
+// to, or NULL if it can not be determined (e.g., if it is virtual),
+// so that dispatches can be attributed to the dispatched function
+// when profiling (see Profiler).
+template <typename Method>
+const void* address(Method method)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  // With the Itanium C++ ABI a pointer to a member function is the
+  // address of the function (or one plus the offset of a virtual
+  // function in the vtable) followed by the adjustment of 'this'.
+  uintptr_t words[2];
+  if (sizeof(method) == sizeof(words)) {
+    memcpy(words, &method, sizeof(words));
+    if ((words[0] & 1) == 0) {
+      return reinterpret_cast<const void*>(words[0]);
+    }
+  }
+#endif
+  return NULL;
+}
 
 } // namespace internal {
 
@@ -81,16 +118,15 @@ void dispatch(
     const PID<T>& pid,
     void (T::*method)())
 {
-  std::shared_ptr<std::function<void(ProcessBase*)>> f(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase* process) {
-            assert(process != NULL);
-            T* t = dynamic_cast<T*>(process);
-            assert(t != NULL);
-            (t->*method)();
-          }));
-
-  internal::dispatch(pid, f, &typeid(method));
+  auto f = [=](ProcessBase* process) {
+    assert(process != NULL);
+    T* t = dynamic_cast<T*>(process);
+    assert(t != NULL);
+    (t->*method)();
+  };
+
+  internal::dispatch(
+      pid, std::move(f), &typeid(method), internal::address(method));
 }
 
 template <typename T>
@@ -121,16 +157,15 @@ void dispatch(
       void (T::*method)(ENUM_PARAMS(N, P)),                             \
       ENUM_BINARY_PARAMS(N, A, a))                                      \
   {                                                                     \
-    std::shared_ptr<std::function<void(ProcessBase*)>> f(               \
-        new std::function<void(ProcessBase*)>(                          \
-            [=](ProcessBase* process) {                                 \
-              assert(process != NULL);                                  \
-              T* t = dynamic_cast<T*>(process);                         \
-              assert(t != NULL);                                        \
-              (t->*method)(ENUM_PARAMS(N, a));                          \
-            }));                                                        \
+    auto f = [=](ProcessBase* process) {                                \
+      assert(process != NULL);                                          \
+      T* t = dynamic_cast<T*>(process);                                 \
+      assert(t != NULL);                                                \
+      (t->*method)(ENUM_PARAMS(N, a));                                  \
+    };                                                                  \
                                                                         \
-    internal::dispatch(pid, f, &typeid(method));                        \
+    internal::dispatch(                                                 \
+        pid, std::move(f), &typeid(method), internal::address(method)); \
   }                                                                     \
                                                                         \
   template <typename T,                                                 \
@@ -166,18 +201,17 @@ Future<R> dispatch(
     const PID<T>& pid,
     Future<R> (T::*method)())
 {
-  std::shared_ptr<Promise<R>> promise(new Promise<R>());
+  auto promise = std::make_shared<Promise<R>>();
 
-  std::shared_ptr<std::function<void(ProcessBase*)>> f(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase* process) {
-            assert(process != NULL);
-            T* t = dynamic_cast<T*>(process);
-            assert(t != NULL);
-            promise->associate((t->*method)());
-          }));
+  auto f = [=](ProcessBase* process) {
+    assert(process != NULL);
+    T* t = dynamic_cast<T*>(process);
+    assert(t != NULL);
+    promise->associate((t->*method)());
+  };
 
-  internal::dispatch(pid, f, &typeid(method));
+  internal::dispatch(
+      pid, std::move(f), &typeid(method), internal::address(method));
 
   return promise->future();
 }
@@ -208,18 +242,17 @@ Future<R> dispatch(
       Future<R> (T::*method)(ENUM_PARAMS(N, P)),                        \
       ENUM_BINARY_PARAMS(N, A, a))                                      \
   {                                                                     \
-    std::shared_ptr<Promise<R>> promise(new Promise<R>());              \
+    auto promise = std::make_shared<Promise<R>>();                      \
                                                                         \
-    std::shared_ptr<std::function<void(ProcessBase*)>> f(               \
-        new std::function<void(ProcessBase*)>(                          \
-            [=](ProcessBase* process) {                                 \
-              assert(process != NULL);                                  \
-              T* t = dynamic_cast<T*>(process);                         \
-              assert(t != NULL);                                        \
-              promise->associate((t->*method)(ENUM_PARAMS(N, a)));      \
-            }));                                                        \
+    auto f = [=](ProcessBase* process) {                                \
+      assert(process != NULL);                                          \
+      T* t = dynamic_cast<T*>(process);                                 \
+      assert(t != NULL);                                                \
+      promise->associate((t->*method)(ENUM_PARAMS(N, a)));              \
+    };                                                                  \
                                                                         \
-    internal::dispatch(pid, f, &typeid(method));                        \
+    internal::dispatch(                                                 \
+        pid, std::move(f), &typeid(method), internal::address(method)); \
                                                                         \
     return promise->future();                                           \
   }                                                                     \
@@ -259,18 +292,17 @@ Future<R> dispatch(
     const PID<T>& pid,
     R (T::*method)(void))
 {
-  std::shared_ptr<Promise<R>> promise(new Promise<R>());
+  auto promise = std::make_shared<Promise<R>>();
 
-  std::shared_ptr<std::function<void(ProcessBase*)>> f(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase* process) {
-            assert(process != NULL);
-            T* t = dynamic_cast<T*>(process);
-            assert(t != NULL);
-            promise->set((t->*method)());
-          }));
+  auto f = [=](ProcessBase* process) {
+    assert(process != NULL);
+    T* t = dynamic_cast<T*>(process);
+    assert(t != NULL);
+    promise->set((t->*method)());
+  };
 
-  internal::dispatch(pid, f, &typeid(method));
+  internal::dispatch(
+      pid, std::move(f), &typeid(method), internal::address(method));
 
   return promise->future();
 }
@@ -301,18 +333,17 @@ Future<R> dispatch(
       R (T::*method)(ENUM_PARAMS(N, P)),                                \
       ENUM_BINARY_PARAMS(N, A, a))                                      \
   {                                                                     \
-    std::shared_ptr<Promise<R>> promise(new Promise<R>());              \
+    auto promise = std::make_shared<Promise<R>>();                      \
                                                                         \
-    std::shared_ptr<std::function<void(ProcessBase*)>> f(               \
-        new std::function<void(ProcessBase*)>(                          \
-            [=](ProcessBase* process) {                                 \
-              assert(process != NULL);                                  \
-              T* t = dynamic_cast<T*>(process);                         \
-              assert(t != NULL);                                        \
-              promise->set((t->*method)(ENUM_PARAMS(N, a)));            \
-            }));                                                        \
+    auto f = [=](ProcessBase* process) {                                \
+      assert(process != NULL);                                          \
+      T* t = dynamic_cast<T*>(process);                                 \
+      assert(t != NULL);                                                \
+      promise->set((t->*method)(ENUM_PARAMS(N, a)));                    \
+    };                                                                  \
                                                                         \
-    internal::dispatch(pid, f, &typeid(method));                        \
+    internal::dispatch(                                                 \
+        pid, std::move(f), &typeid(method), internal::address(method)); \
                                                                         \
     return promise->future();                                           \
   }                                                                     \
@@ -349,13 +380,11 @@ inline void dispatch(
     const UPID& pid,
     const std::function<void()>& f)
 {
-  std::shared_ptr<std::function<void(ProcessBase*)>> f_(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase*) {
-            f();
-          }));
+  auto f_ = [=](ProcessBase*) {
+    f();
+  };
 
-  internal::dispatch(pid, f_);
+  internal::dispatch(pid, std::move(f_));
 }
 
 
@@ -364,15 +393,13 @@ Future<R> dispatch(
     const UPID& pid,
     const std::function<Future<R>()>& f)
 {
-  std::shared_ptr<Promise<R>> promise(new Promise<R>());
+  auto promise = std::make_shared<Promise<R>>();
 
-  std::shared_ptr<std::function<void(ProcessBase*)>> f_(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase*) {
-            promise->associate(f());
-          }));
+  auto f_ = [=](ProcessBase*) {
+    promise->associate(f());
+  };
 
-  internal::dispatch(pid, f_);
+  internal::dispatch(pid, std::move(f_));
 
   return promise->future();
 }
@@ -383,15 +410,13 @@ Future<R> dispatch(
     const UPID& pid,
     const std::function<R()>& f)
 {
-  std::shared_ptr<Promise<R>> promise(new Promise<R>());
+  auto promise = std::make_shared<Promise<R>>();
 
-  std::shared_ptr<std::function<void(ProcessBase*)>> f_(
-      new std::function<void(ProcessBase*)>(
-          [=](ProcessBase*) {
-            promise->set(f());
-          }));
+  auto f_ = [=](ProcessBase*) {
+    promise->set(f());
+  };
 
-  internal::dispatch(pid, f_);
+  internal::dispatch(pid, std::move(f_));
 
   return promise->future();
 }
@@ -13,7 +13,14 @@
 #ifndef __PROCESS_EVENT_HPP__
 #define __PROCESS_EVENT_HPP__
 
+#include <stdint.h>
+
+#include <atomic>
+#include <cstddef>
 #include <memory> // TODO(benh): Replace shared_ptr with unique_ptr.
+#include <new>
+#include <type_traits>
+#include <utility>
 
 #include <process/future.hpp>
 #include <process/http.hpp>
@@ -26,6 +33,7 @@
 namespace process {
 
 // Forward declarations.
+class EventQueue;
 class ProcessBase;
 struct MessageEvent;
 struct DispatchEvent;
@@ -47,6 +55,11 @@ struct EventVisitor
 
 struct Event
 {
+  Event() : next(NULL), enqueued(0) {}
+
+  // NOTE: A copy of an event is not part of any event queue.
+  Event(const Event& that) : next(NULL), enqueued(0) {}
+
   virtual ~Event() {}
 
   virtual void visit(EventVisitor* visitor) const = 0;
@@ -81,6 +94,17 @@ struct Event
     }
     return *result;
   }
+
+private:
+  friend class EventQueue;
+
+  // Link to the next event in the (intrusive) event queue of the
+  // process this event has been enqueued on.
+  std::atomic<Event*> next;
+
+  // Monotonic time (in nanoseconds) at which this event got enqueued,
+  // only set if the event queue is instrumented (see MailboxMetrics).
+  int64_t enqueued;
 };
 
 
@@ -102,6 +126,10 @@ struct MessageEvent : Event
     visitor->visit(*this);
   }
 
+  // See the comment on Message::operator new.
+  static void* operator new(size_t size);
+  static void operator delete(void* pointer, size_t size);
+
   Message* const message;
 
 private:
@@ -147,13 +175,104 @@ private:
 
 struct DispatchEvent : Event
 {
+  // A type erased 'void(ProcessBase*)' function which stores the
+  // callable object inline when it fits (as is the case for the
+  // lambdas created in dispatch.hpp with a few arguments), rather
+  // than allocating it on the heap like 'std::function' would.
+  class Function
+  {
+  public:
+    template <typename F>
+    explicit Function(F&& f)
+    {
+      typedef typename std::decay<F>::type T;
+
+      // NOTE: Inline or heap storage is chosen at compile time so
+      // that the placement new is only instantiated for callable
+      // objects which fit the storage.
+      construct<T>(
+          std::forward<F>(f),
+          std::integral_constant<
+              bool,
+              sizeof(T) <= STORAGE_SIZE &&
+              alignof(T) <= alignof(std::max_align_t) &&
+              std::is_nothrow_move_constructible<T>::value>());
+    }
+
+    ~Function()
+    {
+      destroyer(storage);
+    }
+
+    void operator()(ProcessBase* process) const
+    {
+      invoker(storage, process);
+    }
+
+  private:
+    Function(const Function&) = delete;
+    Function& operator=(const Function&) = delete;
+
+    template <typename T, typename F>
+    void construct(F&& f, std::true_type)
+    {
+      new (storage) T(std::forward<F>(f));
+      invoker = &Function::invokeInline<T>;
+      destroyer = &Function::destroyInline<T>;
+    }
+
+    template <typename T, typename F>
+    void construct(F&& f, std::false_type)
+    {
+      *reinterpret_cast<T**>(storage) = new T(std::forward<F>(f));
+      invoker = &Function::invokeHeap<T>;
+      destroyer = &Function::destroyHeap<T>;
+    }
+
+    template <typename T>
+    static void invokeInline(void* storage, ProcessBase* process)
+    {
+      (*reinterpret_cast<T*>(storage))(process);
+    }
+
+    template <typename T>
+    static void destroyInline(void* storage)
+    {
+      reinterpret_cast<T*>(storage)->~T();
+    }
+
+    template <typename T>
+    static void invokeHeap(void* storage, ProcessBase* process)
+    {
+      (**reinterpret_cast<T**>(storage))(process);
+    }
+
+    template <typename T>
+    static void destroyHeap(void* storage)
+    {
+      delete *reinterpret_cast<T**>(storage);
+    }
+
+    static const size_t STORAGE_SIZE = 96;
+
+    void (*invoker)(void*, ProcessBase*);
+    void (*destroyer)(void*);
+
+    // NOTE: Mutable since invoking the stored function may mutate
+    // it, just like invoking a 'const std::function'.
+    alignas(std::max_align_t) mutable unsigned char storage[STORAGE_SIZE];
+  };
+
+  template <typename F>
   DispatchEvent(
       const UPID& _pid,
-      const std::shared_ptr<lambda::function<void(ProcessBase*)>>& _f,
-      const Option<const std::type_info*>& _functionType)
+      F&& _f,
+      const Option<const std::type_info*>& _functionType,
+      const void* _function = NULL)
     : pid(_pid),
-      f(_f),
-      functionType(_functionType)
+      f(std::forward<F>(_f)),
+      functionType(_functionType),
+      function(_function)
   {}
 
   virtual void visit(EventVisitor* visitor) const
@@ -161,14 +280,26 @@ struct DispatchEvent : Event
     visitor->visit(*this);
   }
 
+  // Dispatch events are allocated (and deleted) for every dispatch,
+  // so they come from a pool rather than going through the global
+  // allocator each time (see process.cpp).
+  static void* operator new(size_t size);
+  static void operator delete(void* pointer, size_t size);
+
   // PID receiving the dispatch.
   const UPID pid;
 
   // Function to get invoked as a result of this dispatch event.
-  const std::shared_ptr<lambda::function<void(ProcessBase*)>> f;
+  const Function f;
 
+  // Canonical "byte" representation of a pointer to a member function
+  // that is being dispatched.
   const Option<const std::type_info*> functionType;
 
+  // Address of the member function that is being dispatched, if
+  // known, used to name the function when profiling.
+  const void* const function;
+
 private:
   // Not copyable, not assignable.
   DispatchEvent(const DispatchEvent&);
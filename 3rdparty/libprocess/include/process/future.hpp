@@ -59,6 +59,54 @@ template <typename T>
 class Future;
 
 
+namespace internal {
+
+// A list of callbacks which stores the first callback inline rather
+// than in a 'std::vector', since most futures only ever get a single
+// callback (e.g., the continuation of a 'then'), so that adding that
+// callback does not require allocating the storage for it.
+template <typename C>
+class Callbacks
+{
+public:
+  void emplace_back(C&& callback)
+  {
+    if (first.isNone()) {
+      first = std::move(callback);
+    } else {
+      rest.emplace_back(std::move(callback));
+    }
+  }
+
+  size_t size() const
+  {
+    return first.isNone() ? 0 : 1 + rest.size();
+  }
+
+  bool empty() const
+  {
+    return first.isNone();
+  }
+
+  const C& operator[](size_t i) const
+  {
+    return i == 0 ? first.get() : rest[i - 1];
+  }
+
+  void clear()
+  {
+    first = None();
+    rest.clear();
+  }
+
+private:
+  Option<C> first;
+  std::vector<C> rest;
+};
+
+} // namespace internal {
+
+
 namespace internal {
 
 template <typename T>
@@ -96,6 +144,7 @@ public:
   Future();
 
   /*implicit*/ Future(const T& _t);
+  /*implicit*/ Future(T&& _t);
 
   template <typename U>
   /*implicit*/ Future(const U& u);
@@ -438,16 +487,20 @@ private:
     //   3. Error, the state is FAILED; 'error()' stores the message.
     Result<T> result;
 
-    std::vector<DiscardCallback> onDiscardCallbacks;
-    std::vector<ReadyCallback> onReadyCallbacks;
-    std::vector<FailedCallback> onFailedCallbacks;
-    std::vector<DiscardedCallback> onDiscardedCallbacks;
-    std::vector<AnyCallback> onAnyCallbacks;
+    internal::Callbacks<DiscardCallback> onDiscardCallbacks;
+    internal::Callbacks<ReadyCallback> onReadyCallbacks;
+    internal::Callbacks<FailedCallback> onFailedCallbacks;
+    internal::Callbacks<DiscardedCallback> onDiscardedCallbacks;
+    internal::Callbacks<AnyCallback> onAnyCallbacks;
   };
 
   // Sets the value for this future, unless the future is already set,
   // failed, or discarded, in which case it returns false.
   bool set(const T& _t);
+  bool set(T&& _t);
+
+  template <typename U>
+  bool _set(U&& _u);
 
   // Sets this future as failed, unless the future is already set,
   // failed, or discarded, in which case it returns false.
@@ -463,7 +516,7 @@ namespace internal {
 //
 // TODO(*): Invoke callbacks in another execution context.
 template <typename C, typename... Arguments>
-void run(const std::vector<C>& callbacks, Arguments&&... arguments)
+void run(const Callbacks<C>& callbacks, Arguments&&... arguments)
 {
   for (size_t i = 0; i < callbacks.size(); ++i) {
     callbacks[i](std::forward<Arguments>(arguments)...);
@@ -539,6 +592,7 @@ public:
 
   bool discard();
   bool set(const T& _t);
+  bool set(T&& _t);
   bool set(const Future<T>& future); // Alias for associate.
   bool associate(const Future<T>& future);
   bool fail(const std::string& message);
@@ -642,6 +696,16 @@ bool Promise<T>::set(const T& t)
 }
 
 
+template <typename T>
+bool Promise<T>::set(T&& t)
+{
+  if (!f.data->associated) {
+    return f.set(std::move(t));
+  }
+  return false;
+}
+
+
 template <typename T>
 bool Promise<T>::set(const Future<T>& future)
 {
@@ -687,7 +751,10 @@ bool Promise<T>::associate(const Future<T>& future)
     f.onDiscard(lambda::bind(&internal::discard<T>, WeakFuture<T>(future)));
 
     future
-      .onReady(lambda::bind(&Future<T>::set, f, lambda::_1))
+      .onReady(lambda::bind(
+          static_cast<bool(Future<T>::*)(const T&)>(&Future<T>::set),
+          f,
+          lambda::_1))
       .onFailed(lambda::bind(&Future<T>::fail, f, lambda::_1))
       .onDiscarded(lambda::bind(&internal::discarded<T>, f));
   }
@@ -769,7 +836,7 @@ void select(
 template <typename T>
 Future<Future<T>> select(const std::set<Future<T>>& futures)
 {
-  std::shared_ptr<Promise<Future<T>>> promise(new Promise<Future<T>>());
+  auto promise = std::make_shared<Promise<Future<T>>>();
 
   promise->future().onDiscard(
       lambda::bind(&internal::discarded<Future<T>>, promise->future()));
@@ -868,21 +935,29 @@ void Future<T>::Data::clearAllCallbacks()
 
 template <typename T>
 Future<T>::Future()
-  : data(new Data()) {}
+  : data(std::make_shared<Data>()) {}
 
 
 template <typename T>
 Future<T>::Future(const T& _t)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   set(_t);
 }
 
 
+template <typename T>
+Future<T>::Future(T&& _t)
+  : data(std::make_shared<Data>())
+{
+  set(std::move(_t));
+}
+
+
 template <typename T>
 template <typename U>
 Future<T>::Future(const U& u)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   set(u);
 }
@@ -890,7 +965,7 @@ Future<T>::Future(const U& u)
 
 template <typename T>
 Future<T>::Future(const Failure& failure)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   fail(failure.message);
 }
@@ -908,7 +983,7 @@ Future<T>::Future(Future<T>&& that)
 
 template <typename T>
 Future<T>::Future(const Try<T>& t)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   if (t.isSome()){
     set(t.get());
@@ -954,12 +1029,12 @@ bool Future<T>::discard()
 {
   bool result = false;
 
-  std::vector<DiscardCallback> callbacks;
+  internal::Callbacks<DiscardCallback> callbacks;
   synchronized (data->lock) {
     if (!data->discard && data->state == PENDING) {
       result = data->discard = true;
 
-      // NOTE: We make a copy of the onDiscard callbacks here
+      // NOTE: We move the onDiscard callbacks out of the data here
       // because it is possible that another thread completes this
       // future (ready, failed or discarded) when the current thread
       // is out of this critical section but *before* it executed the
@@ -967,8 +1042,7 @@ bool Future<T>::discard()
       // be clearing the onDiscard callbacks (via clearAllCallbacks())
       // while the current thread is executing or clearing the
       // onDiscard callbacks, causing thread safety issue.
-      callbacks = data->onDiscardCallbacks;
-      data->onDiscardCallbacks.clear();
+      std::swap(callbacks, data->onDiscardCallbacks);
     }
   }
 
@@ -1051,7 +1125,8 @@ bool Future<T>::await(const Duration& duration) const
   synchronized (data->lock) {
     if (data->state == PENDING) {
       pending = true;
-      data->onAnyCallbacks.push_back(lambda::bind(&internal::awaited, latch));
+      data->onAnyCallbacks.emplace_back(
+          lambda::bind(&internal::awaited, latch));
     }
   }
 
@@ -1309,12 +1384,9 @@ template <typename T>
 template <typename X>
 Future<X> Future<T>::then(const lambda::function<Future<X>(const T&)>& f) const
 {
-  std::shared_ptr<Promise<X>> promise(new Promise<X>());
+  auto promise = std::make_shared<Promise<X>>();
 
-  lambda::function<void(const Future<T>&)> thenf =
-    lambda::bind(&internal::thenf<T, X>, f, promise, lambda::_1);
-
-  onAny(thenf);
+  onAny(lambda::bind(&internal::thenf<T, X>, f, promise, lambda::_1));
 
   // Propagate discarding up the chain. To avoid cyclic dependencies,
   // we keep a weak future in the callback.
@@ -1329,12 +1401,9 @@ template <typename T>
 template <typename X>
 Future<X> Future<T>::then(const lambda::function<X(const T&)>& f) const
 {
-  std::shared_ptr<Promise<X>> promise(new Promise<X>());
-
-  lambda::function<void(const Future<T>&)> then =
-    lambda::bind(&internal::then<T, X>, f, promise, lambda::_1);
+  auto promise = std::make_shared<Promise<X>>();
 
-  onAny(then);
+  onAny(lambda::bind(&internal::then<T, X>, f, promise, lambda::_1));
 
   // Propagate discarding up the chain. To avoid cyclic dependencies,
   // we keep a weak future in the callback.
@@ -1349,7 +1418,7 @@ template <typename T>
 Future<T> Future<T>::repair(
     const lambda::function<Future<T>(const Future<T>&)>& f) const
 {
-  std::shared_ptr<Promise<T>> promise(new Promise<T>());
+  auto promise = std::make_shared<Promise<T>>();
 
   onAny(lambda::bind(&internal::repair<T>, f, promise, lambda::_1));
 
@@ -1371,7 +1440,7 @@ Future<T> Future<T>::after(
   // Unfortunately, Once depends on Future so we can't easily use it
   // from here.
   std::shared_ptr<Latch> latch(new Latch());
-  std::shared_ptr<Promise<T>> promise(new Promise<T>());
+  auto promise = std::make_shared<Promise<T>>();
 
   // Set up a timer to invoke the callback if this future has not
   // completed. Note that we do not pass a weak reference for this
@@ -1394,12 +1463,27 @@ Future<T> Future<T>::after(
 
 template <typename T>
 bool Future<T>::set(const T& _t)
+{
+  return _set(_t);
+}
+
+
+template <typename T>
+bool Future<T>::set(T&& _t)
+{
+  return _set(std::move(_t));
+}
+
+
+template <typename T>
+template <typename U>
+bool Future<T>::_set(U&& u)
 {
   bool result = false;
 
   synchronized (data->lock) {
     if (data->state == PENDING) {
-      data->result = _t;
+      data->result = std::forward<U>(u);
       data->state = READY;
       result = true;
     }
@@ -31,10 +31,13 @@
 #include <process/owned.hpp>
 #include <process/pid.hpp>
 
+#include <stout/bytes.hpp>
+#include <stout/duration.hpp>
 #include <stout/error.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/ip.hpp>
 #include <stout/json.hpp>
+#include <stout/jsonify.hpp>
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
 #include <stout/option.hpp>
@@ -194,49 +197,10 @@ typedef hashmap<std::string,
                 CaseInsensitiveEqual> Headers;
 
 
-struct Request
-{
-  std::string method;
-
-  // TODO(benh): Add major/minor version.
-
-  // For client requests, the URL should be a URI.
-  // For server requests, the URL may be a URI or a relative reference.
-  URL url;
-
-  Headers headers;
-
-  // TODO(bmahler): Add a 'query' field which contains both
-  // the URL query and the parsed form data from the body.
-
-  std::string body;
-
-  // TODO(bmahler): Ensure this is consistent with the 'Connection'
-  // header; perhaps make this a function that checks the header.
-  bool keepAlive;
-
-  // For server requests, this contains the address of the client.
-  // Note that this may correspond to a proxy or load balancer address.
-  network::Address client;
-
-  /**
-   * Returns whether the encoding is considered acceptable in the
-   * response. See RFC 2616 section 14.3 for details.
-   */
-  bool acceptsEncoding(const std::string& encoding) const;
-
-  /**
-   * Returns whether the media type is considered acceptable in the
-   * response. See RFC 2616, section 14.1 for the details.
-   */
-  bool acceptsMediaType(const std::string& mediaType) const;
-};
-
-
 // Represents an asynchronous in-memory unbuffered Pipe, currently
-// used for streaming HTTP responses via chunked encoding. Note that
-// being an in-memory pipe means that this cannot be used across OS
-// processes.
+// used for streaming HTTP request and response bodies (e.g., via
+// chunked encoding). Note that being an in-memory pipe means that
+// this cannot be used across OS processes.
 //
 // Much like unix pipes, data is read until end-of-file is
 // encountered; this occurs when the the write-end of the pipe is
@@ -253,6 +217,12 @@ struct Request
 // reader must "keep up" with the writer in order to avoid
 // unbounded memory growth.
 //
+// To bound the memory growth, a pipe can be given a "high-water
+// mark" for the amount of data written but not yet read. Writes
+// beyond the high-water mark still succeed, but the writer can wait
+// for the reader to catch up via 'Writer::writable()' (or drop data,
+// or give up on the reader, if it does not).
+//
 // The writer can induce a failure on the reader in order to signal
 // that an error has occurred. For example, if we are receiving a
 // response but a disconnection occurs before the response is
@@ -289,6 +259,10 @@ public:
     // interested. Returns false if the read-end was already closed.
     bool close();
 
+    // Reads until end-of-file and returns all of the data that was
+    // written to the pipe. Returns Failure if any of the reads fail.
+    Future<std::string> readAll();
+
     // Comparison operators useful for checking connection equality.
     bool operator==(const Reader& other) const { return data == other.data; }
     bool operator!=(const Reader& other) const { return !(*this == other); }
@@ -330,6 +304,15 @@ public:
     // was unable to continue reading!
     Future<Nothing> readerClosed() const;
 
+    // Returns Nothing once less than the high-water mark of the pipe
+    // is buffered (i.e., written but not yet read), immediately if
+    // the pipe doesn't have a high-water mark. Returns Failure if
+    // either end of the pipe is closed (or failed) before then.
+    Future<Nothing> writable() const;
+
+    // Returns the number of bytes written but not yet read.
+    size_t buffered() const;
+
     // Comparison operators useful for checking connection equality.
     bool operator==(const Writer& other) const { return data == other.data; }
     bool operator!=(const Writer& other) const { return !(*this == other); }
@@ -348,7 +331,8 @@ public:
     std::shared_ptr<Data> data;
   };
 
-  Pipe() : data(new Data()) {}
+  explicit Pipe(const Option<Bytes>& highWaterMark = None())
+    : data(new Data(highWaterMark)) {}
 
   Reader reader() const;
   Writer writer() const;
@@ -359,9 +343,11 @@ public:
 private:
   struct Data
   {
-    Data()
+    explicit Data(const Option<Bytes>& _highWaterMark)
       : readEnd(Reader::OPEN),
-        writeEnd(Writer::OPEN) {}
+        writeEnd(Writer::OPEN),
+        highWaterMark(_highWaterMark),
+        size(0) {}
 
     // Rather than use a process to serialize access to the pipe's
     // internal data we use a 'std::atomic_flag'.
@@ -377,6 +363,13 @@ private:
     // empty strings as they serve as a signal for end-of-file.
     std::queue<std::string> writes;
 
+    // The high-water mark (if any) for the total 'size' of 'writes'.
+    Option<Bytes> highWaterMark;
+    size_t size;
+
+    // Represents writers waiting for the pipe to become writable.
+    std::queue<Owned<Promise<Nothing>>> writables;
+
     // Signals when the read-end is closed before the write-end.
     Promise<Nothing> readerClosure;
 
@@ -388,6 +381,78 @@ private:
 };
 
 
+struct Request
+{
+  Request()
+    : type(BODY),
+      keepAlive(false) {}
+
+  std::string method;
+
+  // TODO(benh): Add major/minor version.
+
+  // For client requests, the URL should be a URI.
+  // For server requests, the URL may be a URI or a relative reference.
+  URL url;
+
+  Headers headers;
+
+  // TODO(bmahler): Add a 'query' field which contains both
+  // the URL query and the parsed form data from the body.
+
+  // Either the whole body is available in 'body', or the body is
+  // streamed through the Pipe 'reader' as it arrives. Distinguish
+  // between the cases using 'type' below.
+  //
+  // BODY: Uses 'body' as the body of the request. When the request
+  // was sent with a 'Content-Encoding' of gzip, 'body' contains the
+  // decompressed body.
+  //
+  // PIPE: Reads the (decompressed) body from the Pipe 'reader' until
+  // end-of-file, in which case 'body' is empty. A failed read means
+  // that the body could not be received in full (e.g., the client
+  // disconnected or the body exceeded the maximum size). Currently
+  // only server requests to routes that opt into request streaming
+  // (see 'ProcessBase::route') are of this type.
+  enum
+  {
+    BODY,
+    PIPE
+  } type;
+
+  std::string body;
+  Option<Pipe::Reader> reader;
+
+  // TODO(bmahler): Ensure this is consistent with the 'Connection'
+  // header; perhaps make this a function that checks the header.
+  bool keepAlive;
+
+  // For server requests, this contains the address of the client.
+  // Note that this may correspond to a proxy or load balancer address.
+  network::Address client;
+
+  /**
+   * Returns whether the encoding is considered acceptable in the
+   * response. See RFC 2616 section 14.3 for details.
+   */
+  bool acceptsEncoding(const std::string& encoding) const;
+
+  /**
+   * Returns whether the media type is considered acceptable in the
+   * response. See RFC 2616, section 14.1 for the details.
+   */
+  bool acceptsMediaType(const std::string& mediaType) const;
+
+  // Server requests are allocated by the event loop and deleted by
+  // the process serving them, so they come from a pool (see http.cpp).
+  static void* operator new(size_t size);
+  static void operator delete(void* pointer, size_t size);
+
+  // The above hide placement new (used by Option, for example).
+  static void* operator new(size_t size, void* place) { return place; }
+  static void operator delete(void* pointer, void* place) {}
+};
+
 struct Response
 {
   Response()
@@ -425,7 +490,10 @@ struct Response
   // already specified.
   //
   // PATH: Attempts to perform a 'sendfile' operation on the file
-  // found at 'path'.
+  // found at 'path'. If the response is '200 OK' and the request has
+  // a 'Range' header for a single range of bytes (e.g., 'bytes=0-99'
+  // or 'bytes=-100'), only that range gets sent as a '206 Partial
+  // Content' response (or '416 Requested range not satisfiable').
   //
   // PIPE: Splices data from the Pipe 'reader' using a "chunked"
   // 'Transfer-Encoding'. The writer uses a Pipe::Writer to
@@ -485,6 +553,32 @@ struct OK : Response
     headers["Content-Length"] = stringify(out.str().size());
     body = out.str().data();
   }
+
+  // Writes the JSON directly into the body (see stout/jsonify.hpp),
+  // e.g., 'OK(jsonify(value), jsonp)'.
+  OK(JSON::Proxy&& value, const Option<std::string>& jsonp = None())
+    : Response(Status::OK)
+  {
+    type = BODY;
+
+    std::ostringstream out;
+
+    if (jsonp.isSome()) {
+      out << jsonp.get() << "(";
+    }
+
+    out << std::move(value);
+
+    if (jsonp.isSome()) {
+      out << ");";
+      headers["Content-Type"] = "text/javascript";
+    } else {
+      headers["Content-Type"] = "application/json";
+    }
+
+    body = out.str();
+    headers["Content-Length"] = stringify(body.size());
+  }
 };
 
 
@@ -497,6 +591,12 @@ struct Accepted : Response
 };
 
 
+struct NotModified : Response
+{
+  NotModified() : Response(Status::NOT_MODIFIED) {}
+};
+
+
 struct TemporaryRedirect : Response
 {
   explicit TemporaryRedirect(const std::string& url)
@@ -755,6 +855,7 @@ public:
 private:
   Connection(const network::Socket& s);
   friend Future<Connection> connect(const URL&);
+  friend Future<Connection> connect(const network::Address&);
 
   // Forward declaration.
   struct Data;
@@ -766,6 +867,71 @@ private:
 Future<Connection> connect(const URL& url);
 
 
+/**
+ * Connects to the server at 'address' using plain 'http', e.g., to
+ * the unix domain socket of a local daemon. The requests sent over
+ * the connection still need their 'url' to set the 'Host' header.
+ */
+Future<Connection> connect(const network::Address& address);
+
+
+/**
+ * A pool of persistent (i.e., keep-alive) connections, which can be
+ * shared by any number of callers sending requests to the same
+ * servers (copies of a pool share the same connections). Connections
+ * are keyed by the scheme, host, and port of the request URL.
+ *
+ * A request is sent on an idle connection if there is one, otherwise
+ * on a new connection, unless there are already the maximum number
+ * of connections to the server, in which case it gets pipelined on
+ * the connection with the fewest requests in flight. A connection
+ * with a streamed response in flight is busy until the response body
+ * has been read in full. Connections which have been idle for the
+ * idle timeout get closed.
+ */
+class ConnectionPool
+{
+public:
+  struct Options
+  {
+    Options() : maxConnections(4), idleTimeout(Seconds(30)) {}
+
+    /**
+     * The maximum number of connections to each server.
+     */
+    size_t maxConnections;
+
+    /**
+     * How long to keep idle connections open for (at least).
+     */
+    Duration idleTimeout;
+  };
+
+  explicit ConnectionPool(const Options& options = Options());
+
+  /**
+   * Sends a request on one of the pooled connections, see
+   * `Connection::send`. The request is always sent with `keepAlive`
+   * set, unless the caller explicitly asks for 'Connection: close'
+   * in which case the connection leaves the pool. Note that a
+   * pipelined request fails if the connection closes before the
+   * response is received, even if the request was never processed.
+   */
+  Future<Response> send(
+      const Request& request,
+      bool streamedResponse = false) const;
+
+  bool operator==(const ConnectionPool& p) const { return data == p.data; }
+  bool operator!=(const ConnectionPool& p) const { return !(*this == p); }
+
+private:
+  // Forward declaration.
+  struct Data;
+
+  std::shared_ptr<Data> data;
+};
+
+
 // TODO(bmahler): Consolidate these functions into a single
 // http::request function that takes a 'Request' object.
 
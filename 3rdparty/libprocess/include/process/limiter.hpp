@@ -13,14 +13,18 @@
 #ifndef __PROCESS_LIMITER_HPP__
 #define __PROCESS_LIMITER_HPP__
 
+#include <algorithm>
+#include <atomic>
 #include <deque>
 
+#include <process/clock.hpp>
 #include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/dispatch.hpp>
 #include <process/id.hpp>
 #include <process/future.hpp>
 #include <process/process.hpp>
+#include <process/time.hpp>
 #include <process/timeout.hpp>
 
 #include <stout/duration.hpp>
@@ -63,18 +67,24 @@ class RateLimiterProcess : public Process<RateLimiterProcess>
 {
 public:
   RateLimiterProcess(int permits, const Duration& duration)
-    : ProcessBase(ID::generate("__limiter__"))
+    : ProcessBase(ID::generate("__limiter__")),
+      next(0),
+      queued(0)
   {
     CHECK_GT(permits, 0);
     CHECK_GT(duration.secs(), 0);
     permitsPerSecond = permits / duration.secs();
+    interval = (Seconds(1) / permitsPerSecond).ns();
   }
 
   explicit RateLimiterProcess(double _permitsPerSecond)
     : ProcessBase(ID::generate("__limiter__")),
-      permitsPerSecond(_permitsPerSecond)
+      permitsPerSecond(_permitsPerSecond),
+      next(0),
+      queued(0)
   {
     CHECK_GT(permitsPerSecond, 0);
+    interval = (Seconds(1) / permitsPerSecond).ns();
   }
 
   virtual void finalize()
@@ -84,30 +94,39 @@ public:
       delete promise;
     }
     promises.clear();
+    queued = 0;
+  }
+
+  // Takes a permit if one is available and nobody is queued for one.
+  // Unlike the other functions this does not need to be dispatched,
+  // it can be called from any thread, which lets 'RateLimiter' hand
+  // out permits without a dispatch while it is not throttling.
+  // NOTE: An acquisition from another thread might take a permit
+  // before an acquisition which was dispatched, but not yet queued.
+  bool tryAcquire()
+  {
+    return queued.load() == 0 && take();
   }
 
   Future<Nothing> acquire()
   {
-    if (!promises.empty()) {
-      // Need to wait for others to get permits first.
-      Promise<Nothing>* promise = new Promise<Nothing>();
-      promises.push_back(promise);
-      return promise->future()
-        .onDiscard(defer(self(), &Self::discard, promise->future()));
+    if (promises.empty() && take()) {
+      return Nothing(); // No need to wait!
     }
 
-    if (timeout.remaining() > Seconds(0)) {
-      // Need to wait a bit longer, but first one in the queue.
-      Promise<Nothing>* promise = new Promise<Nothing>();
-      promises.push_back(promise);
-      delay(timeout.remaining(), self(), &Self::_acquire);
-      return promise->future()
-        .onDiscard(defer(self(), &Self::discard, promise->future()));
+    // Need to wait for the next permit, or for others to get permits
+    // first. Only the first one in the queue needs to wait for the
+    // next permit, the others wait for it to get its permit.
+    Promise<Nothing>* promise = new Promise<Nothing>();
+    promises.push_back(promise);
+    queued++;
+
+    if (promises.size() == 1) {
+      delay(remaining(), self(), &Self::_acquire);
     }
 
-    // No need to wait!
-    timeout = Seconds(1) / permitsPerSecond;
-    return Nothing();
+    return promise->future()
+      .onDiscard(defer(self(), &Self::discard, promise->future()));
   }
 
 private:
@@ -115,28 +134,54 @@ private:
   RateLimiterProcess(const RateLimiterProcess&);
   RateLimiterProcess& operator=(const RateLimiterProcess&);
 
+  // Takes the next permit if it is due, i.e., the permit after it is
+  // due one interval from now. Lock-free, see 'tryAcquire'.
+  bool take()
+  {
+    const int64_t now = Clock::now(this).duration().ns();
+
+    int64_t due = next.load();
+    while (due <= now) {
+      if (next.compare_exchange_weak(due, now + interval)) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  // Returns the time until the next permit is due.
+  Duration remaining()
+  {
+    const int64_t now = Clock::now(this).duration().ns();
+    return Nanoseconds(std::max<int64_t>(next.load() - now, 0));
+  }
+
   void _acquire()
   {
     CHECK(!promises.empty());
 
     // Keep removing the top of the queue until we find a promise
     // whose future is not discarded.
-    while (!promises.empty()) {
+    while (!promises.empty() && promises.front()->future().isDiscarded()) {
+      delete promises.front();
+      promises.pop_front();
+      queued--;
+    }
+
+    // An acquisition that was not queued might have taken the permit
+    // we were waiting for, in which case we wait for the next one.
+    if (!promises.empty() && take()) {
       Promise<Nothing>* promise = promises.front();
       promises.pop_front();
-      if (!promise->future().isDiscarded()) {
-        promise->set(Nothing());
-        delete promise;
-        timeout = Seconds(1) / permitsPerSecond;
-        break;
-      } else {
-        delete promise;
-      }
+      queued--;
+      promise->set(Nothing());
+      delete promise;
     }
 
     // Repeat if necessary.
     if (!promises.empty()) {
-      delay(timeout.remaining(), self(), &Self::_acquire);
+      delay(remaining(), self(), &Self::_acquire);
     }
   }
 
@@ -151,9 +196,17 @@ private:
 
   double permitsPerSecond;
 
-  Timeout timeout;
+  // The interval between two permits, in nanoseconds.
+  int64_t interval;
+
+  // The time (in nanoseconds) at which the next permit is due. This
+  // is shared with the threads calling 'tryAcquire', hence atomic.
+  std::atomic<int64_t> next;
 
   std::deque<Promise<Nothing>*> promises;
+
+  // The size of 'promises', for 'tryAcquire'.
+  std::atomic<size_t> queued;
 };
 
 
@@ -181,6 +234,11 @@ inline RateLimiter::~RateLimiter()
 
 inline Future<Nothing> RateLimiter::acquire()
 {
+  // Only dispatch when we need to wait for a permit.
+  if (process->tryAcquire()) {
+    return Nothing();
+  }
+
   return dispatch(process, &RateLimiterProcess::acquire);
 }
 
@@ -13,6 +13,8 @@
 #ifndef __PROCESS_MESSAGE_HPP__
 #define __PROCESS_MESSAGE_HPP__
 
+#include <stddef.h>
+
 #include <string>
 
 #include <process/pid.hpp>
@@ -25,6 +27,16 @@ struct Message
   UPID from;
   UPID to;
   std::string body;
+
+  // Messages are allocated for every message sent or received and
+  // typically deleted by another thread, so they come from a pool
+  // (see process.cpp).
+  static void* operator new(size_t size);
+  static void operator delete(void* pointer, size_t size);
+
+  // The above hide placement new (used by Option, for example).
+  static void* operator new(size_t size, void* place) { return place; }
+  static void operator delete(void* pointer, void* place) {}
 };
 
 } // namespace process {
@@ -14,6 +14,7 @@
 #define __PROCESS_METRICS_METRIC_HPP__
 
 #include <atomic>
+#include <map>
 #include <memory>
 #include <string>
 
@@ -36,18 +37,48 @@ public:
 
   virtual Future<double> value() const = 0;
 
+  typedef std::map<std::string, std::string> Labels;
+
   const std::string& name() const
   {
     return data->name;
   }
 
+  // Exposes this metric in the Prometheus format as one member,
+  // distinguished by 'labels', of the metric family 'family' (e.g.,
+  // "frameworks/messages_received" with a "principal" label) rather
+  // than as a family of its own named after 'name'. Must be called
+  // before the metric is added.
+  void label(const std::string& family, const Labels& labels)
+  {
+    data->family = family;
+    data->labels = labels;
+  }
+
+  const Option<std::string>& family() const
+  {
+    return data->family;
+  }
+
+  const Labels& labels() const
+  {
+    return data->labels;
+  }
+
   Option<Statistics<double>> statistics() const
   {
     Option<Statistics<double>> statistics = None();
 
     if (data->history.isSome()) {
       synchronized (data->lock) {
-        statistics = Statistics<double>::from(*data->history.get());
+        // The history only changes when a value is pushed, so we
+        // only recompute the statistics after that.
+        if (data->stale) {
+          data->statistics = Statistics<double>::from(*data->history.get());
+          data->stale = false;
+        }
+
+        statistics = data->statistics;
       }
     }
 
@@ -66,6 +97,7 @@ protected:
 
       synchronized (data->lock) {
         data->history.get()->set(value, now);
+        data->stale = true;
       }
     }
   }
@@ -74,7 +106,8 @@ private:
   struct Data {
     Data(const std::string& _name, const Option<Duration>& window)
       : name(_name),
-        history(None())
+        history(None()),
+        stale(true)
     {
       if (window.isSome()) {
         history =
@@ -84,9 +117,17 @@ private:
 
     const std::string name;
 
+    Option<std::string> family;
+    Labels labels;
+
     std::atomic_flag lock = ATOMIC_FLAG_INIT;
 
     Option<Owned<TimeSeries<double>>> history;
+
+    // The statistics of the history, as of the last call to
+    // 'statistics', unless the history has changed since.
+    Option<Statistics<double>> statistics;
+    bool stale;
   };
 
   std::shared_ptr<Data> data;
@@ -14,6 +14,7 @@
 #define __PROCESS_METRICS_METRICS_HPP__
 
 #include <string>
+#include <vector>
 
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
@@ -46,6 +47,14 @@ protected:
 
 private:
   static std::string help();
+  static std::string prometheusHelp();
+
+  // The formats of a snapshot of the metrics.
+  enum Format
+  {
+    SNAPSHOT,  // A JSON object, see '/metrics/snapshot'.
+    PROMETHEUS // The Prometheus text format, see '/metrics/prometheus'.
+  };
 
   MetricsProcess()
     : ProcessBase("metrics"),
@@ -57,14 +66,23 @@ private:
   MetricsProcess& operator=(const MetricsProcess&);
 
   Future<http::Response> snapshot(const http::Request& request);
-  Future<http::Response> _snapshot(const http::Request& request);
-  static std::list<Future<double> > _snapshotTimeout(
-      const std::list<Future<double> >& futures);
+  Future<http::Response> prometheus(const http::Request& request);
+  Future<http::Response> _snapshot(
+      const http::Request& request,
+      Format format);
+  static std::vector<Future<double> > _snapshotTimeout(
+      const std::vector<Future<double> >& futures);
   static Future<http::Response> __snapshot(
       const http::Request& request,
       const Option<Duration>& timeout,
       const hashmap<std::string, Future<double> >& metrics,
       const hashmap<std::string, Option<Statistics<double> > >& statistics);
+  static Future<http::Response> __prometheus(
+      const Option<Duration>& timeout,
+      const hashmap<std::string, Future<double> >& metrics,
+      const hashmap<std::string, Option<Statistics<double> > >& statistics,
+      const hashmap<std::string, std::string>& families,
+      const hashmap<std::string, Metric::Labels>& labels);
 
   // The Owned<Metric> is an explicit copy of the Metric passed to 'add'.
   hashmap<std::string, Owned<Metric> > metrics;
@@ -0,0 +1,98 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESS_METRICS_PUSH_GAUGE_HPP__
+#define __PROCESS_METRICS_PUSH_GAUGE_HPP__
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include <process/metrics/metric.hpp>
+
+namespace process {
+namespace metrics {
+
+// A Metric that represents an instantaneous value which its owner
+// updates ("pushes") whenever the value changes, unlike a Gauge
+// which is evaluated when 'value' is called. Reading a PushGauge
+// does not dispatch into the owning process, so a snapshot does not
+// have to wait for that process to get through its queued events.
+// Prefer a PushGauge for values that are cheap to keep up to date.
+class PushGauge : public Metric
+{
+public:
+  // 'name' is the unique name for the instance of PushGauge being
+  // constructed. It will be the key exposed in the JSON endpoint.
+  // 'window' is the amount of history to keep for this Metric.
+  explicit PushGauge(
+      const std::string& name,
+      const Option<Duration>& window = None())
+    : Metric(name, window),
+      data(new Data())
+  {
+    push(data->value.load());
+  }
+
+  virtual ~PushGauge() {}
+
+  virtual Future<double> value() const
+  {
+    return data->value.load();
+  }
+
+  PushGauge& operator=(double v)
+  {
+    data->value.store(v);
+    push(v);
+    return *this;
+  }
+
+  PushGauge& operator++()
+  {
+    return *this += 1;
+  }
+
+  PushGauge& operator--()
+  {
+    return *this -= 1;
+  }
+
+  PushGauge& operator+=(double v)
+  {
+    // There is no 'fetch_add' for atomic floating point values.
+    double prev = data->value.load();
+    while (!data->value.compare_exchange_weak(prev, prev + v)) {}
+    push(prev + v);
+    return *this;
+  }
+
+  PushGauge& operator-=(double v)
+  {
+    return *this += -v;
+  }
+
+private:
+  struct Data
+  {
+    explicit Data() : value(0) {}
+
+    std::atomic<double> value;
+  };
+
+  std::shared_ptr<Data> data;
+};
+
+} // namespace metrics {
+} // namespace process {
+
+#endif // __PROCESS_METRICS_PUSH_GAUGE_HPP__
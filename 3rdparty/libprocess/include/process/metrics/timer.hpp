@@ -87,6 +87,22 @@ public:
     return t;
   }
 
+  // Record a duration which was measured otherwise, e.g., with a
+  // Stopwatch rather than the (possibly paused) Clock, or by
+  // concurrent callers which each measure their own.
+  void record(const Duration& duration)
+  {
+    double value = 0.0;
+
+    synchronized (data->lock) {
+      data->lastValue = T(duration).value();
+
+      value = data->lastValue.get();
+    }
+
+    push(value);
+  }
+
   // Time an asynchronous event.
   template <typename U>
   Future<U> time(const Future<U>& future)
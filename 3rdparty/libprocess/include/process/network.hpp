@@ -13,6 +13,8 @@
 #ifndef __PROCESS_NETWORK_HPP__
 #define __PROCESS_NETWORK_HPP__
 
+#include <string.h>
+
 #include <process/address.hpp>
 
 #include <stout/net.hpp>
@@ -65,8 +67,7 @@ inline Try<int> accept(int s)
 // TODO(benh): Remove and defer to Socket::bind.
 inline Try<int> bind(int s, const Address& address)
 {
-  struct sockaddr_storage storage =
-    net::createSockaddrStorage(address.ip, address.port);
+  struct sockaddr_storage storage = address.storage();
 
   int error = ::bind(s, (struct sockaddr*) &storage, address.size());
   if (error < 0) {
@@ -80,8 +81,7 @@ inline Try<int> bind(int s, const Address& address)
 // TODO(benh): Remove and defer to Socket::connect.
 inline Try<int> connect(int s, const Address& address)
 {
-  struct sockaddr_storage storage =
-    net::createSockaddrStorage(address.ip, address.port);
+  struct sockaddr_storage storage = address.storage();
 
   int error = ::connect(s, (struct sockaddr*) &storage, address.size());
   if (error < 0) {
@@ -103,6 +103,9 @@ inline Try<Address> address(int s)
   struct sockaddr_storage storage;
   socklen_t storagelen = sizeof(storage);
 
+  // Zeroed so that the path of an unnamed unix domain socket is empty.
+  memset(&storage, 0, sizeof(storage));
+
   if (::getsockname(s, (struct sockaddr*) &storage, &storagelen) < 0) {
     return ErrnoError("Failed to getsockname");
   }
@@ -122,6 +125,9 @@ inline Try<Address> peer(int s)
   struct sockaddr_storage storage;
   socklen_t storagelen = sizeof(storage);
 
+  // Zeroed so that the path of an unnamed unix domain socket is empty.
+  memset(&storage, 0, sizeof(storage));
+
   if (::getpeername(s, (struct sockaddr*) &storage, &storagelen) < 0) {
     return ErrnoError("Failed to getpeername");
   }
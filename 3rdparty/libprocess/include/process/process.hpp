@@ -16,7 +16,10 @@
 #include <stdint.h>
 
 #include <map>
+#include <memory>
 #include <queue>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include <process/address.hpp>
@@ -61,6 +64,15 @@ void install(std::vector<Owned<FirewallRule>>&& rules);
 
 } // namespace firewall {
 
+// The thread of a dedicated process (see `SpawnOptions`), defined in
+// process.cpp.
+class DedicatedThread;
+
+// The instrumentation of the event queue of a process (see
+// `SpawnOptions`), defined in mailbox_metrics.hpp.
+class MailboxMetrics;
+
+
 class ProcessBase : public EventVisitor
 {
 public:
@@ -186,6 +198,20 @@ protected:
     install(name, handler);
   }
 
+  /**
+   * Prioritizes messages with the specified name, i.e., "control
+   * plane" messages, over all other (i.e., "bulk") events of this
+   * process. Once this has been called, prioritized messages get
+   * served before any bulk events that were enqueued before them,
+   * except that a bulk event gets served after every few consecutive
+   * prioritized messages so that bulk events are never starved.
+   *
+   * NOTE: Events are only ordered within each class, i.e., a
+   * prioritized message may get served before a message or dispatch
+   * that was sent before it by the same sender.
+   */
+  void prioritize(const std::string& name);
+
   /**
    * Delegates incoming messages, with the specified name, to the `UPID`.
    */
@@ -206,6 +232,25 @@ protected:
   typedef lambda::function<Future<http::Response>(const http::Request&)>
   HttpRequestHandler;
 
+  /**
+   * Options for an HTTP route.
+   *
+   * @see process::ProcessBase::route
+   */
+  struct RouteOptions
+  {
+    RouteOptions() : requestStreaming(false) {}
+
+    /**
+     * Whether the handler receives requests as soon as their headers
+     * have been received, with a type of `http::Request::PIPE`, and
+     * reads the body from the request's `reader` as it arrives
+     * (rather than once the whole body has been received and
+     * buffered in the request's `body`).
+     */
+    bool requestStreaming;
+  };
+
   /**
    * Sets up a handler for HTTP requests with the specified name.
    *
@@ -215,7 +260,8 @@ protected:
   void route(
       const std::string& name,
       const Option<std::string>& help,
-      const HttpRequestHandler& handler);
+      const HttpRequestHandler& handler,
+      const RouteOptions& options = RouteOptions());
 
   /**
    * @copydoc process::ProcessBase::route
@@ -224,14 +270,15 @@ protected:
   void route(
       const std::string& name,
       const Option<std::string>& help,
-      Future<http::Response> (T::*method)(const http::Request&))
+      Future<http::Response> (T::*method)(const http::Request&),
+      const RouteOptions& options = RouteOptions())
   {
     // Note that we use dynamic_cast here so a process can use
     // multiple inheritance if it sees so fit (e.g., to implement
     // multiple callback interfaces).
     HttpRequestHandler handler =
       lambda::bind(method, dynamic_cast<T*>(this), lambda::_1);
-    route(name, help, handler);
+    route(name, help, handler, options);
   }
 
   /**
@@ -268,13 +315,7 @@ protected:
   template <typename T>
   size_t eventCount()
   {
-    size_t count = 0U;
-
-    synchronized (mutex) {
-      count = std::count_if(events.begin(), events.end(), isEventType<T>);
-    }
-
-    return count;
+    return eventCount(isEventType<T>);
   }
 
 private:
@@ -284,7 +325,9 @@ private:
   friend void* schedule(void*);
 
   // Process states.
-  enum
+  // NOTE: Not named 'State' which would hide the 'State' types used
+  // by subclasses (e.g., the registrar's).
+  enum ProcessState
   {
     BOTTOM,
     READY,
@@ -292,7 +335,11 @@ private:
     BLOCKED,
     TERMINATING,
     TERMINATED
-  } state;
+  };
+
+  // NOTE: The state is atomic rather than protected by a lock so
+  // that enqueueing an event never blocks (see 'enqueue').
+  std::atomic<ProcessState> state;
 
   template <typename T>
   static bool isEventType(const Event* event)
@@ -300,9 +347,8 @@ private:
     return event->is<T>();
   }
 
-  // Mutex protecting internals.
-  // TODO(benh): Consider replacing with a spinlock, on multi-core systems.
-  std::recursive_mutex mutex;
+  // Returns the number of queued events satisfying 'predicate'.
+  size_t eventCount(bool (*predicate)(const Event*));
 
   // Enqueue the specified message, request, or function call.
   void enqueue(Event* event, bool inject = false);
@@ -314,8 +360,27 @@ private:
   struct {
     std::map<std::string, MessageHandler> message;
     std::map<std::string, HttpRequestHandler> http;
+
+    // Options of the HTTP handlers.
+    std::map<std::string, RouteOptions> options;
   } handlers;
 
+  // The names of the HTTP handlers as a trie over their '/' separated
+  // components, which is built as the routes are installed so that a
+  // request can be dispatched to the route with the longest matching
+  // prefix of its path without building the prefixes.
+  struct Routes
+  {
+    // The name of the route which ends at this node, if any.
+    Option<std::string> name;
+
+    std::vector<std::pair<std::string, std::shared_ptr<Routes>>> children;
+  } routes;
+
+  // Returns the name of the route which handles the path below this
+  // process that starts at 'position' of 'path', or NULL.
+  const std::string* match(const std::string& path, size_t position) const;
+
   // Definition of a static asset.
   struct Asset
   {
@@ -326,12 +391,28 @@ private:
   // Static assets(s) to provide.
   std::map<std::string, Asset> assets;
 
-  // Queue of received events, requires lock()ed access!
-  std::deque<Event*> events;
+  // Queue of received events (see EventQueue for which operations
+  // are safe to call from which threads).
+  EventQueue* events;
 
   // Active references.
   std::atomic_long refs;
 
+  // Index of the processing thread that last ran this process (or -1
+  // if it has not run yet), used by the ProcessManager to enqueue the
+  // process back onto that thread's run queue.
+  std::atomic_long worker;
+
+  // The thread that runs this process if it was spawned as a
+  // dedicated process (see `SpawnOptions`), otherwise NULL. Set
+  // before the process gets spawned and immutable afterwards.
+  DedicatedThread* dedicated;
+
+  // The instrumentation of this process' event queue if it was
+  // spawned with `SpawnOptions::mailboxMetrics`. Set before the
+  // process gets spawned and immutable afterwards.
+  std::shared_ptr<MailboxMetrics> mailbox;
+
   // Process PID.
   UPID pid;
 };
@@ -422,6 +503,81 @@ PID<T> spawn(T& t, bool manage = false)
 }
 
 
+/**
+ * Options for spawning a process.
+ */
+struct SpawnOptions
+{
+  SpawnOptions() : dedicated(false), mailboxMetrics(false) {}
+
+  /**
+   * Whether the process should run on its own thread rather than on
+   * the processing threads shared by all other processes, so that it
+   * never waits behind other runnable processes (e.g., for latency
+   * sensitive processes). Such a process is never stolen by another
+   * thread, nor does a thread waiting for it get donated to it.
+   */
+  bool dedicated;
+
+  /**
+   * The CPU that the thread of a dedicated process gets pinned to, if
+   * any. Ignored unless `dedicated` is true. Pinning is only
+   * supported on Linux.
+   */
+  Option<int> cpu;
+
+  /**
+   * Whether to instrument the event queue (i.e., the "mailbox") of
+   * the process: the number of queued events, how long events wait
+   * before the process serves them, and how long it takes to serve
+   * each type of event. These get exported by the metrics (prefixed
+   * by `libprocess/processes/<id>/mailbox/`) and by
+   * `/__processes__`. This adds a couple of clock reads per event.
+   */
+  bool mailboxMetrics;
+};
+
+
+/**
+ * Spawn a new process with the specified options.
+ *
+ * @param process Process to be spawned.
+ * @param options Options for spawning the process.
+ * @param manage Whether process should get garbage collected.
+ */
+UPID spawn(
+    ProcessBase* process,
+    const SpawnOptions& options,
+    bool manage = false);
+
+inline UPID spawn(
+    ProcessBase& process,
+    const SpawnOptions& options,
+    bool manage = false)
+{
+  return spawn(&process, options, manage);
+}
+
+template <typename T>
+PID<T> spawn(T* t, const SpawnOptions& options, bool manage = false)
+{
+  // See the comment in 'spawn' above.
+  PID<T> pid(t);
+
+  if (!spawn(static_cast<ProcessBase*>(t), options, manage)) {
+    return PID<T>();
+  }
+
+  return pid;
+}
+
+template <typename T>
+PID<T> spawn(T& t, const SpawnOptions& options, bool manage = false)
+{
+  return spawn(&t, options, manage);
+}
+
+
 /**
  * Sends a `TerminateEvent` to the given process.
  *
@@ -17,6 +17,7 @@
 
 #include <process/future.hpp>
 #include <process/http.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 
 namespace process {
@@ -33,11 +34,13 @@ protected:
   {
     route("/start", START_HELP(), &Profiler::start);
     route("/stop", STOP_HELP(), &Profiler::stop);
+    route("/actors", ACTORS_HELP(), &Profiler::actors);
   }
 
 private:
   static const std::string START_HELP();
   static const std::string STOP_HELP();
+  static const std::string ACTORS_HELP();
 
   // HTTP endpoints.
 
@@ -49,6 +52,13 @@ private:
   // in the working directory.
   Future<http::Response> stop(const http::Request& request);
 
+  // Profiles the CPU time spent by each process serving events for
+  // the requested 'duration', independently of perftools. This
+  // returns the profile in the "folded stacks" format.
+  Future<http::Response> actors(const http::Request& request);
+
+  void _actors(const Owned<Promise<http::Response>>& promise);
+
   bool started;
 };
 
@@ -19,14 +19,24 @@
 #include <google/protobuf/repeated_field.h>
 
 #include <set>
+#include <string>
 #include <vector>
 
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
+#include <stout/option.hpp>
+#include <stout/thread_local.hpp>
 
 
 // Provides an implementation of process::post that for a protobuf.
@@ -50,6 +60,72 @@ inline void post(const process::UPID& from,
   post(from, to, message.GetTypeName(), data.data(), data.size());
 }
 
+
+namespace internal {
+
+// A message of type M parsed for a handler of a ProtobufProcess (see
+// below). Rather than allocating (and freeing) a message including
+// all of its sub-messages and strings for every message, a message
+// gets recycled by the handlers running on the same thread, since
+// 'Clear' keeps the memory of the message around for the next one
+// (e.g., the elements of repeated fields and the capacity of strings).
+//
+// NOTE: This serves the purpose of protobuf arenas, which are not
+// supported by the protobuf library that we bundle.
+//
+// NOTE: Messages larger than 'RECYCLE_LIMIT' bytes are not recycled so
+// that a thread doesn't hold on to the memory of a rare large message.
+// A handler that gets invoked while the recycled message is in use on
+// the same thread (e.g., by a process that gets run by 'wait' within
+// another handler) parses a message of its own.
+template <typename M>
+class Parsed
+{
+public:
+  static const size_t RECYCLE_LIMIT = 64 * 1024;
+
+  explicit Parsed(const std::string& data)
+    : message(NULL),
+      recycle(data.size() <= RECYCLE_LIMIT)
+  {
+    if (recycle && recycled() != NULL) {
+      message = recycled();
+      recycled() = NULL;
+    } else {
+      message = new M();
+    }
+
+    message->ParseFromString(data);
+  }
+
+  ~Parsed()
+  {
+    if (recycle && recycled() == NULL) {
+      message->Clear();
+      recycled() = message;
+    } else {
+      delete message;
+    }
+  }
+
+  M& get() { return *message; }
+
+private:
+  Parsed(const Parsed&) = delete;
+  Parsed& operator=(const Parsed&) = delete;
+
+  // NOTE: The recycled message of a thread is never deleted.
+  static M*& recycled()
+  {
+    static THREAD_LOCAL M* message = NULL;
+    return message;
+  }
+
+  M* message;
+  const bool recycle;
+};
+
+} // namespace internal {
 } // namespace process {
 
 
@@ -92,21 +168,62 @@ template <typename T>
 class ProtobufProcess : public process::Process<T>
 {
 public:
-  virtual ~ProtobufProcess() {}
+  virtual ~ProtobufProcess()
+  {
+    foreachvalue (const process::Owned<MessageMetrics>& metrics,
+                  messageMetrics) {
+      process::metrics::remove(metrics->messages);
+      process::metrics::remove(metrics->bytes);
+      process::metrics::remove(metrics->time);
+    }
+  }
 
 protected:
   virtual void visit(const process::MessageEvent& event)
   {
     if (protobufHandlers.count(event.message->name) > 0) {
+      MessageMetrics* metrics = NULL;
+      bool sampled = false;
+
+      if (instrumentation.isSome()) {
+        metrics = instrumented(event.message->name);
+
+        ++metrics->messages;
+        metrics->bytes += event.message->body.size();
+
+        sampled = metrics->sample++ % instrumentation.get().sampling == 0;
+        if (sampled) {
+          metrics->time.start();
+        }
+      }
+
       from = event.message->from; // For 'reply'.
       protobufHandlers[event.message->name](
           event.message->from, event.message->body);
       from = process::UPID();
+
+      if (sampled) {
+        metrics->time.stop();
+      }
     } else {
       process::Process<T>::visit(event);
     }
   }
 
+  // Keeps metrics of the protobuf messages handled by this process,
+  // per message type: the number of messages ('<prefix>/<type>/
+  // messages') and of their bytes ('<prefix>/<type>/bytes'), and the
+  // time the handler took ('<prefix>/<type>/time_ms') for one in
+  // every 'sampling' messages of the type, which keeps the cost of
+  // reading the clock and updating the time series off the others.
+  // The metrics of a type are added when the first message of that
+  // type arrives, and are labeled with the type.
+  void instrument(const std::string& prefix, size_t sampling = 1)
+  {
+    CHECK_GT(sampling, 0u);
+    instrumentation = Instrumentation(prefix, sampling);
+  }
+
   void send(const process::UPID& to,
             const google::protobuf::Message& message)
   {
@@ -421,6 +538,17 @@ protected:
 
   using process::Process<T>::install;
 
+  // Prioritizes the messages of type 'M' over "bulk" messages and
+  // other events (see ProcessBase::prioritize), e.g., for messages
+  // which must be handled promptly even when the process is flooded.
+  template <typename M>
+  void prioritize()
+  {
+    process::Process<T>::prioritize(M().GetTypeName());
+  }
+
+  using process::Process<T>::prioritize;
+
 private:
   // Handlers that take the sender as the first argument.
   template <typename M>
@@ -430,8 +558,8 @@ private:
       const process::UPID& sender,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    process::internal::Parsed<M> parsed(data);
+    M& m = parsed.get();
     if (m.IsInitialized()) {
       (t->*method)(sender, m);
     } else {
@@ -458,8 +586,8 @@ private:
       const process::UPID& sender,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    process::internal::Parsed<M> parsed(data);
+    M& m = parsed.get();
     if (m.IsInitialized()) {
       (t->*method)(sender, google::protobuf::convert((&m->*p1)()));
     } else {
@@ -479,8 +607,8 @@ private:
       const process::UPID& sender,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    process::internal::Parsed<M> parsed(data);
+    M& m = parsed.get();
     if (m.IsInitialized()) {
       (t->*method)(sender,
                    google::protobuf::convert((&m->*p1)()),
@@ -504,8 +632,8 @@ private:
       const process::UPID& sender,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    process::internal::Parsed<M> parsed(data);
+    M& m = parsed.get();
     if (m.IsInitialized()) {
       (t->*method)(sender,
                    google::protobuf::convert((&m->*p1)()),
@@ -532,8 +660,8 @@ private:
       const process::UPID& sender,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    process::internal::Parsed<M> parsed(data);
+    M& m = parsed.get();
     if (m.IsInitialized()) {
       (t->*method)(sender,
                    google::protobuf::convert((&m->*p1)()),
@@ -563,8 +691,8 @@ private:
       const process::UPID& sender,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    process::internal::Parsed<M> parsed(data);
+    M& m = parsed.get();
     if (m.IsInitialized()) {
       (t->*method)(sender,
                    google::protobuf::convert((&m->*p1)()),
@@ -597,8 +725,8 @@ private:
       const process::UPID& sender,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    process::internal::Parsed<M> parsed(data);
+    M& m = parsed.get();
     if (m.IsInitialized()) {
       (t->*method)(sender,
                    google::protobuf::convert((&m->*p1)()),
@@ -622,8 +750,8 @@ private:
       const process::UPID&,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    process::internal::Parsed<M> parsed(data);
+    M& m = parsed.get();
     if (m.IsInitialized()) {
       (t->*method)(m);
     } else {
@@ -650,8 +778,8 @@ private:
       const process::UPID&,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    process::internal::Parsed<M> parsed(data);
+    M& m = parsed.get();
     if (m.IsInitialized()) {
       (t->*method)(google::protobuf::convert((&m->*p1)()));
     } else {
@@ -671,8 +799,8 @@ private:
       const process::UPID&,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    process::internal::Parsed<M> parsed(data);
+    M& m = parsed.get();
     if (m.IsInitialized()) {
       (t->*method)(google::protobuf::convert((&m->*p1)()),
                    google::protobuf::convert((&m->*p2)()));
@@ -695,8 +823,8 @@ private:
       const process::UPID&,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    process::internal::Parsed<M> parsed(data);
+    M& m = parsed.get();
     if (m.IsInitialized()) {
       (t->*method)(google::protobuf::convert((&m->*p1)()),
                    google::protobuf::convert((&m->*p2)()),
@@ -722,8 +850,8 @@ private:
       const process::UPID&,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    process::internal::Parsed<M> parsed(data);
+    M& m = parsed.get();
     if (m.IsInitialized()) {
       (t->*method)(google::protobuf::convert((&m->*p1)()),
                    google::protobuf::convert((&m->*p2)()),
@@ -752,8 +880,8 @@ private:
       const process::UPID&,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    process::internal::Parsed<M> parsed(data);
+    M& m = parsed.get();
     if (m.IsInitialized()) {
       (t->*method)(google::protobuf::convert((&m->*p1)()),
                    google::protobuf::convert((&m->*p2)()),
@@ -785,8 +913,8 @@ private:
       const process::UPID&,
       const std::string& data)
   {
-    M m;
-    m.ParseFromString(data);
+    process::internal::Parsed<M> parsed(data);
+    M& m = parsed.get();
     if (m.IsInitialized()) {
       (t->*method)(google::protobuf::convert((&m->*p1)()),
                    google::protobuf::convert((&m->*p2)()),
@@ -804,6 +932,57 @@ private:
       void(const process::UPID&, const std::string&)> handler;
   hashmap<std::string, handler> protobufHandlers;
 
+  struct Instrumentation
+  {
+    Instrumentation(const std::string& _prefix, size_t _sampling)
+      : prefix(_prefix), sampling(_sampling) {}
+
+    std::string prefix;
+    size_t sampling;
+  };
+
+  struct MessageMetrics
+  {
+    MessageMetrics(const std::string& prefix, const std::string& type)
+      : messages(prefix + "/" + type + "/messages"),
+        bytes(prefix + "/" + type + "/bytes"),
+        time(prefix + "/" + type + "/time", Hours(1)),
+        sample(0)
+    {
+      const process::metrics::Metric::Labels labels = {{"type", type}};
+
+      messages.label(prefix + "/messages", labels);
+      bytes.label(prefix + "/bytes", labels);
+      time.label(prefix + "/time_" + Milliseconds::units(), labels);
+
+      process::metrics::add(messages);
+      process::metrics::add(bytes);
+      process::metrics::add(time);
+    }
+
+    process::metrics::Counter messages;
+    process::metrics::Counter bytes;
+    process::metrics::Timer<Milliseconds> time;
+
+    // The number of messages seen so far, for sampling.
+    size_t sample;
+  };
+
+  MessageMetrics* instrumented(const std::string& type)
+  {
+    CHECK_SOME(instrumentation);
+
+    if (!messageMetrics.contains(type)) {
+      messageMetrics[type] = process::Owned<MessageMetrics>(
+          new MessageMetrics(instrumentation.get().prefix, type));
+    }
+
+    return messageMetrics[type].get();
+  }
+
+  Option<Instrumentation> instrumentation;
+  hashmap<std::string, process::Owned<MessageMetrics>> messageMetrics;
+
   // Sender of "current" message, inaccessible by subclasses.
   // This is only used for reply().
   process::UPID from;
@@ -15,6 +15,7 @@
 
 #ifndef __WINDOWS__
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 #endif // __WINDOWS__
 
@@ -63,10 +64,16 @@ public:
    *
    * @param kind Optional. The desired `Socket` implementation.
    * @param s Optional.  The file descriptor to wrap with the `Socket`.
+   * @param family Optional. The address family of the socket to create
+   *     if no file descriptor is passed, e.g., `AF_UNIX` for a unix
+   *     domain socket.
    *
    * @return An instance of a `Socket`.
    */
-  static Try<Socket> create(Kind kind = DEFAULT_KIND(), Option<int> s = None());
+  static Try<Socket> create(
+      Kind kind = DEFAULT_KIND(),
+      Option<int> s = None(),
+      int family = AF_INET);
 
   /**
    * Returns the default `Kind` of implementation of `Socket`.
@@ -143,6 +150,23 @@ public:
     virtual Future<size_t> send(const char* data, size_t size) = 0;
     virtual Future<size_t> sendfile(int fd, off_t offset, size_t size) = 0;
 
+    /**
+     * An overload of `send`, which sends the data of the specified
+     * buffers with a single "gather" write (i.e., without copying the
+     * buffers into contiguous memory first).
+     *
+     * Like `send`, this may send less than all of the data, and the
+     * buffers (and the `iovec` array itself) must remain valid until
+     * the returned future has completed.
+     *
+     * The default implementation only sends (part of) the first
+     * non-empty buffer.
+     *
+     * @return The number of bytes sent or an error in case the
+     *     sending fails.
+     */
+    virtual Future<size_t> send(const struct iovec* iov, int iovcnt);
+
     /**
      * An overload of `recv`, which receives data based on the specified
      * 'size' parameter.
@@ -288,6 +312,11 @@ public:
     return impl->sendfile(fd, offset, size);
   }
 
+  Future<size_t> send(const struct iovec* iov, int iovcnt) const
+  {
+    return impl->send(iov, iovcnt);
+  }
+
   Future<std::string> recv(const Option<ssize_t>& size = None())
   {
     return impl->recv(size);
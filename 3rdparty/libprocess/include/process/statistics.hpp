@@ -49,7 +49,9 @@ struct Statistics
       values.push_back(value.data);
     }
 
-    std::sort(values.begin(), values.end());
+    const double percentiles[] = {0.5, 0.90, 0.95, 0.99, 0.999, 0.9999};
+
+    select(&values, percentiles);
 
     Statistics statistics;
 
@@ -58,12 +60,12 @@ struct Statistics
     statistics.min = values.front();
     statistics.max = values.back();
 
-    statistics.p50 = percentile(values, 0.5);
-    statistics.p90 = percentile(values, 0.90);
-    statistics.p95 = percentile(values, 0.95);
-    statistics.p99 = percentile(values, 0.99);
-    statistics.p999 = percentile(values, 0.999);
-    statistics.p9999 = percentile(values, 0.9999);
+    statistics.p50 = percentile(values, percentiles[0]);
+    statistics.p90 = percentile(values, percentiles[1]);
+    statistics.p95 = percentile(values, percentiles[2]);
+    statistics.p99 = percentile(values, percentiles[3]);
+    statistics.p999 = percentile(values, percentiles[4]);
+    statistics.p9999 = percentile(values, percentiles[5]);
 
     return statistics;
   }
@@ -82,7 +84,45 @@ struct Statistics
   T p9999;
 
 private:
-  // Returns the requested percentile from the sorted values.
+  // Moves the minimum, the maximum, and the values which the given
+  // percentiles interpolate between to where sorting the values
+  // would put them. Rather than sorting all of the values, which
+  // takes O(n log n), we only select these few ranks, each in linear
+  // time over the values not below the previously selected rank.
+  template <size_t N>
+  static void select(std::vector<T>* values, const double (&percentiles)[N])
+  {
+    CHECK_GE(values->size(), 2u);
+
+    std::vector<size_t> ranks;
+    ranks.reserve(2 * N + 2);
+
+    ranks.push_back(0);
+    ranks.push_back(values->size() - 1);
+
+    for (size_t i = 0; i < N; i++) {
+      const size_t index =
+        static_cast<size_t>(floor(percentiles[i] * (values->size() - 1)));
+
+      ranks.push_back(std::min(index, values->size() - 1));
+      ranks.push_back(std::min(index + 1, values->size() - 1));
+    }
+
+    std::sort(ranks.begin(), ranks.end());
+    ranks.erase(std::unique(ranks.begin(), ranks.end()), ranks.end());
+
+    // After selecting a rank, all of the values after it are not
+    // below it, so the next rank only needs to look at those.
+    typename std::vector<T>::iterator begin = values->begin();
+
+    foreach (size_t rank, ranks) {
+      std::nth_element(begin, values->begin() + rank, values->end());
+      begin = values->begin() + rank + 1;
+    }
+  }
+
+  // Returns the requested percentile from the values, as selected by
+  // 'select' for this percentile.
   // Note that we need at least two values to compute percentiles!
   // TODO(dhamon): Use a 'Percentage' abstraction.
   static T percentile(const std::vector<T>& values, double percentile)
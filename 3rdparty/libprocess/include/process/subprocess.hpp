@@ -61,6 +61,17 @@ public:
     bool isPath() const { return mode == PATH; }
     bool isFd() const { return mode == FD; }
 
+    /**
+     * @return The file descriptor of an IO::FD redirector, e.g., to
+     *     hand it to another process which launches the subprocess.
+     */
+    const Option<int>& getFd() const { return fd; }
+
+    /**
+     * @return The path of an IO::PATH redirector.
+     */
+    const Option<std::string>& getPath() const { return path; }
+
   private:
     friend class Subprocess;
 
@@ -0,0 +1,67 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESS_ACTOR_PROFILER_HPP__
+#define __PROCESS_ACTOR_PROFILER_HPP__
+
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+
+#include <process/event.hpp>
+#include <process/pid.hpp>
+
+#include <stout/hashmap.hpp>
+
+namespace process {
+
+// Attributes the CPU time that processes spend serving events to the
+// process and to the event, e.g., to the name of a message, to the
+// function of a dispatch, or to the path of an HTTP request. Used to
+// implement the '/profiler/actors' endpoint (see Profiler).
+//
+// While profiling, the processing threads measure their CPU time
+// around serving each event (see ProcessManager::resume) and
+// accumulate it in per thread samples, otherwise this only costs
+// checking 'running' for each event.
+class ActorProfiler
+{
+public:
+  // Starts profiling, returns false if already profiling.
+  static bool start();
+
+  // Stops profiling and returns the CPU time (in nanoseconds) spent
+  // in each "stack", which consists of the id of the process (without
+  // the "(N)" suffix of generated ids), the type of the event, and
+  // the name of the event (if any), separated by ';'.
+  static hashmap<std::string, uint64_t> stop();
+
+  static bool running()
+  {
+    return profiling.load(std::memory_order_relaxed);
+  }
+
+  // Returns the CPU time (in nanoseconds) of the calling thread.
+  static int64_t cpu();
+
+  // Records that the process 'pid' spent 'nanoseconds' of CPU time
+  // serving 'event'. Must be called by the thread that served it.
+  static void record(const UPID& pid, const Event& event, int64_t nanoseconds);
+
+private:
+  static std::atomic_bool profiling;
+};
+
+} // namespace process {
+
+#endif // __PROCESS_ACTOR_PROFILER_HPP__
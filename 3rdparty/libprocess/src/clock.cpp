@@ -10,12 +10,19 @@
 // See the License for the specific language governing permissions and
 // limitations under the License
 
+#include <unistd.h>
+
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <atomic>
+#include <limits>
 #include <list>
 #include <map>
 #include <mutex>
 #include <set>
+#include <utility>
+#include <vector>
 
 #include <process/clock.hpp>
 #include <process/pid.hpp>
@@ -27,22 +34,53 @@
 #include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
 #include <stout/synchronized.hpp>
+#include <stout/thread_local.hpp>
 #include <stout/try.hpp>
 #include <stout/unreachable.hpp>
 
 #include "event_loop.hpp"
+#include "timer_wheel.hpp"
 
 using std::list;
 using std::map;
+using std::pair;
 using std::recursive_mutex;
 using std::set;
+using std::vector;
 
 namespace process {
 
-// We store the timers in a map of lists indexed by the timeout of the
-// timer so that we can have two timers that have the same timeout. We
-// exploit that the map is SORTED!
-static map<Time, list<Timer>>* timers = new map<Time, list<Timer>>();
+// We store the timers in timer wheels which are sharded (with a lock
+// per shard) so that threads creating or canceling timers don't
+// contend with each other. Each thread adds its timers to "its" shard
+// (there are as many shards as processing threads) and the shard of a
+// timer is encoded in its id so that it can be canceled from any
+// thread.
+struct TimerShard
+{
+  std::mutex mutex;
+  TimerWheel wheel;
+};
+
+
+static vector<TimerShard*>* createTimerShards()
+{
+  const long shards = std::max(8L, sysconf(_SC_NPROCESSORS_ONLN));
+
+  vector<TimerShard*>* result = new vector<TimerShard*>();
+  for (long i = 0; i < shards; i++) {
+    result->push_back(new TimerShard());
+  }
+
+  return result;
+}
+
+
+static vector<TimerShard*>* timers = createTimerShards();
+
+// Protects all of the clock state below, and must be acquired before
+// the mutex of any shard. Note that the shards may be modified
+// without holding this mutex (see Clock::timer).
 static recursive_mutex* timers_mutex = new recursive_mutex();
 
 
@@ -76,33 +114,67 @@ lambda::function<void(const list<Timer>&)>* callback =
 // scheduled 'ticks'.
 set<Time>* ticks = new set<Time>();
 
+// The time (in nanoseconds) of the earliest scheduled 'tick', or the
+// maximum value if no 'tick' is scheduled. This lets Clock::timer
+// determine whether a new timer requires scheduling a 'tick' without
+// acquiring 'timers_mutex'. A 'tick' updates this _before_ inspecting
+// the shards, so a timer is either seen by a 'tick' or the thread
+// adding it observes a value which makes it schedule a 'tick' itself.
+std::atomic<int64_t> scheduled(std::numeric_limits<int64_t>::max());
+
+
+// Helper for updating 'scheduled' after 'ticks' is modified, must be
+// called within a 'synchronized (timers_mutex)' block.
+void updateScheduled(const set<Time>& ticks)
+{
+  if (ticks.empty()) {
+    scheduled.store(std::numeric_limits<int64_t>::max());
+  } else {
+    scheduled.store(ticks.begin()->duration().ns());
+  }
+}
+
+
+// Helper for determining the time of the earliest timer across all
+// of the shards, or None if no timers are pending.
+Option<Time> earliest()
+{
+  Option<Time> result = None();
+
+  foreach (TimerShard* shard, *timers) {
+    synchronized (shard->mutex) {
+      Option<Time> next = shard->wheel.next();
+      if (next.isSome() && (result.isNone() || next.get() < result.get())) {
+        result = next;
+      }
+    }
+  }
+
+  return result;
+}
+
 
 // Helper for determining the time when the next timer elapses,
 // or None if no timers are pending, or the clock is paused and no
-// timers are expired. Note that we don't manipulate 'timers' directly
-// so that it's clear from the callsite that the use of 'timers' is
-// within a 'synchronized' block.
-//
-// TODO(benh): Create a generic 'Timers' abstraction which hides this
-// and more away (i.e., all manipulations of 'timers' below).
-Option<Time> next(const map<Time, list<Timer>>& timers)
+// timers are expired. Must be called within a
+// 'synchronized (timers_mutex)' block.
+Option<Time> next()
 {
-  if (!timers.empty()) {
-    Time first = timers.begin()->first;
+  Option<Time> first = earliest();
+
+  if (first.isSome()) {
 
     // If the clock is paused and no timers are expired, the
     // timers cannot fire until the clock is advanced, so we
     // return None() here. Note that we pass NULL to ensure
     // that this looks at the global clock, since this can be
     // called from a Process context through Clock::timer.
-    if (Clock::paused() && first > Clock::now(NULL)) {
+    if (Clock::paused() && first.get() > Clock::now(NULL)) {
       return None();
     }
-
-    return first;
   }
 
-  return None();
+  return first;
 }
 
 
@@ -111,21 +183,22 @@ void tick(const Time& time);
 
 
 // Helper for scheduling the next clock tick, if applicable. Note
-// that we don't manipulate 'timers' or 'ticks' directly so that
-// it's clear from the callsite that this needs to be called within
-// a 'synchronized' block.
+// that we don't manipulate 'ticks' directly so that it's clear from
+// the callsite that this needs to be called within a 'synchronized'
+// block.
 // TODO(bmahler): Consider taking an optional 'now' to avoid
 // excessive syscalls via Clock::now(NULL).
-void scheduleTick(const map<Time, list<Timer>>& timers, set<Time>* ticks)
+void scheduleTick(set<Time>* ticks)
 {
   // Determine when the next 'tick' should fire.
-  const Option<Time> next = clock::next(timers);
+  const Option<Time> next = clock::next();
 
   if (next.isSome()) {
     // Don't schedule a 'tick' if there is a 'tick' scheduled for
     // an earlier time, to avoid excessive pending timers.
     if (ticks->empty() || next.get() < (*ticks->begin())) {
       ticks->insert(next.get());
+      updateScheduled(*ticks);
 
       // The delay can be negative if the timer is expired, this
       // is expected will result in a 'tick' firing immediately.
@@ -151,13 +224,23 @@ void tick(const Time& time)
 
     VLOG(3) << "Handling timers up to " << now;
 
-    foreachkey (const Time& timeout, *timers) {
-      if (timeout > now) {
-        break;
-      }
+    // Remove this tick from the scheduled 'ticks', it may have
+    // been removed already if the clock was paused / manipulated
+    // in the interim. NOTE: We do this before looking at the shards
+    // so that any timer added after we've looked at its shard will
+    // schedule another "tick" itself (see Clock::timer).
+    ticks->erase(time);
+    updateScheduled(*ticks);
 
-      VLOG(3) << "Have timeout(s) at " << timeout;
+    vector<pair<uint64_t, Timer>> expired;
 
+    foreach (TimerShard* shard, *timers) {
+      synchronized (shard->mutex) {
+        shard->wheel.expire(now, &expired);
+      }
+    }
+
+    if (!expired.empty()) {
       // Need to toggle 'settling' so that we don't prematurely say
       // we're settled until after the timers are executed below,
       // outside of the critical section.
@@ -165,24 +248,29 @@ void tick(const Time& time)
         clock::settling = true;
       }
 
-      foreach (const Timer& timer, (*timers)[timeout]) {
-        timedout.push_back(timer);
+      // Invoke the timers in the order of their timeouts, and in the
+      // order they were created for equal timeouts.
+      std::sort(
+          expired.begin(),
+          expired.end(),
+          [](const pair<uint64_t, Timer>& left,
+             const pair<uint64_t, Timer>& right) {
+            const Time leftTime = left.second.timeout().time();
+            const Time rightTime = right.second.timeout().time();
+            if (leftTime != rightTime) {
+              return leftTime < rightTime;
+            }
+            return left.first < right.first;
+          });
+
+      foreach (const auto& timer, expired) {
+        VLOG(3) << "Have timeout(s) at " << timer.second.timeout().time();
+        timedout.push_back(timer.second);
       }
     }
 
-    // Now erase the range of timers that timed out.
-    timers->erase(timers->begin(), timers->upper_bound(now));
-
-    // Okay, so the timeout for the next timer should not have fired.
-    CHECK(timers->empty() || (timers->begin()->first > now));
-
-    // Remove this tick from the scheduled 'ticks', it may have
-    // been removed already if the clock was paused / manipulated
-    // in the interim.
-    ticks->erase(time);
-
     // Schedule another "tick" if necessary.
-    scheduleTick(*timers, ticks);
+    scheduleTick(ticks);
   }
 
   (*clock::callback)(timedout);
@@ -191,11 +279,12 @@ void tick(const Time& time)
   // that will expire before the paused time and we've finished
   // executing expired timers.
   synchronized (timers_mutex) {
-    if (clock::paused &&
-        (timers->size() == 0 ||
-         timers->begin()->first > *clock::current)) {
-      VLOG(3) << "Clock has settled";
-      clock::settling = false;
+    if (clock::paused) {
+      Option<Time> next = earliest();
+      if (next.isNone() || next.get() > *clock::current) {
+        VLOG(3) << "Clock has settled";
+        clock::settling = false;
+      }
     }
   }
 }
@@ -220,9 +309,13 @@ void Clock::finalize()
 
     // This, along with the `timers_mutex`, is all that is required to clean
     // up any pending timers.  Timers are triggered via "ticks".  However,
-    // we do not need to clear `ticks` because a "tick" with an empty `timers`
-    // map will effectively be a no-op.
-    timers->clear();
+    // we do not need to clear `ticks` because a "tick" with empty `timers`
+    // will effectively be a no-op.
+    foreach (TimerShard* shard, *timers) {
+      synchronized (shard->mutex) {
+        shard->wheel.clear();
+      }
+    }
   }
 }
 
@@ -269,29 +362,38 @@ Timer Clock::timer(
   // Start at 1 since Timer() instances use id 0.
   static std::atomic<uint64_t> id(1);
 
+  // Index of the shard used by this thread, assigned the first time
+  // the thread creates a timer.
+  static std::atomic<long> next(0);
+  static THREAD_LOCAL long shard = -1;
+
+  if (shard < 0) {
+    shard = next.fetch_add(1) % timers->size();
+  }
+
   // Assumes Clock::now() does Clock::now(__process__).
   Timeout timeout = Timeout::in(duration);
 
   UPID pid = __process__ != NULL ? __process__->self() : UPID();
 
-  Timer timer(id.fetch_add(1), timeout, pid, thunk);
+  // Encode the shard in the id (see Clock::cancel).
+  Timer timer(
+      id.fetch_add(1) * timers->size() + shard, timeout, pid, thunk);
 
   VLOG(3) << "Created a timer for " << pid << " in " << stringify(duration)
           << " in the future (" << timeout.time() << ")";
 
   // Add the timer.
-  synchronized (timers_mutex) {
-    if (timers->size() == 0 ||
-        timer.timeout().time() < timers->begin()->first) {
-      // Need to interrupt the loop to update/set timer repeat.
-      (*timers)[timer.timeout().time()].push_back(timer);
+  synchronized ((*timers)[shard]->mutex) {
+    (*timers)[shard]->wheel.add(timer.id, timer);
+  }
 
+  // Only if the timer expires before every scheduled "tick" do we
+  // need to interrupt the loop to update/set timer repeat.
+  if (timeout.time().duration().ns() < clock::scheduled.load()) {
+    synchronized (timers_mutex) {
       // Schedule another "tick" if necessary.
-      clock::scheduleTick(*timers, clock::ticks);
-    } else {
-      // Timer repeat is adequate, just add the timeout.
-      CHECK(timers->size() >= 1);
-      (*timers)[timer.timeout().time()].push_back(timer);
+      clock::scheduleTick(clock::ticks);
     }
   }
 
@@ -301,22 +403,14 @@ Timer Clock::timer(
 
 bool Clock::cancel(const Timer& timer)
 {
-  bool canceled = false;
-  synchronized (timers_mutex) {
-    // Check if the timeout is still pending, and if so, erase it. In
-    // addition, erase an empty list if we just removed the last
-    // timeout.
-    Time time = timer.timeout().time();
-    if (timers->count(time) > 0) {
-      canceled = true;
-      (*timers)[time].remove(timer);
-      if ((*timers)[time].empty()) {
-        timers->erase(time);
-      }
-    }
+  // Check if the timeout is still pending, and if so, erase it.
+  TimerShard* shard = (*timers)[timer.id % timers->size()];
+
+  synchronized (shard->mutex) {
+    return shard->wheel.cancel(timer.id);
   }
 
-  return canceled;
+  UNREACHABLE();
 }
 
 
@@ -337,6 +431,7 @@ void Clock::pause()
       // that fire immediately will be scheduled while the clock
       // is paused.
       clock::ticks->clear();
+      clock::updateScheduled(*clock::ticks);
     }
   }
 
@@ -365,7 +460,7 @@ void Clock::resume()
       clock::currents->clear();
 
       // Schedule another "tick" if necessary.
-      clock::scheduleTick(*timers, clock::ticks);
+      clock::scheduleTick(clock::ticks);
     }
   }
 }
@@ -383,7 +478,7 @@ void Clock::advance(const Duration& duration)
       // Schedule another "tick" if necessary. Only "ticks" that
       // fire immediately will be scheduled here, since the clock
       // is paused.
-      clock::scheduleTick(*timers, clock::ticks);
+      clock::scheduleTick(clock::ticks);
     }
   }
 }
@@ -420,7 +515,7 @@ void Clock::update(const Time& time)
         // Schedule another "tick" if necessary. Only "ticks" that
         // fire immediately will be scheduled here, since the clock
         // is paused.
-        clock::scheduleTick(*timers, clock::ticks);
+        clock::scheduleTick(clock::ticks);
       }
     }
   }
@@ -460,8 +555,10 @@ bool Clock::settled()
     if (clock::settling) {
       VLOG(3) << "Clock still not settled";
       return false;
-    } else if (timers->size() == 0 ||
-               timers->begin()->first > *clock::current) {
+    }
+
+    Option<Time> next = clock::earliest();
+    if (next.isNone() || next.get() > *clock::current) {
       VLOG(3) << "Clock is settled";
       return true;
     }
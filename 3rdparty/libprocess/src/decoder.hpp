@@ -22,11 +22,15 @@
 #include <vector>
 
 #include <process/http.hpp>
+#include <process/owned.hpp>
 #include <process/socket.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/foreach.hpp>
 #include <stout/gzip.hpp>
+#include <stout/lambda.hpp>
 #include <stout/option.hpp>
+#include <stout/stringify.hpp>
 #include <stout/try.hpp>
 
 
@@ -37,11 +41,30 @@ namespace process {
 
 // TODO(benh): Make DataDecoder abstract and make RequestDecoder a
 // concrete subclass.
+//
+// Requests for which 'streaming' returns true (which gets invoked
+// once the headers have been decoded) are returned as soon as their
+// headers are decoded, with a type of 'http::Request::PIPE', and
+// their body gets written to the request's pipe as it is decoded.
+// All other requests are returned once the whole body is decoded.
+//
+// In both cases a gzip encoded body gets decompressed incrementally
+// and a body (after decompression) larger than 'maxBodySize' causes
+// the decoder to fail.
 class DataDecoder
 {
 public:
-  explicit DataDecoder(const network::Socket& _s)
-    : s(_s), failure(false), request(NULL)
+  explicit DataDecoder(
+      const network::Socket& _s,
+      const lambda::function<bool(const http::Request&)>& _streaming =
+        lambda::function<bool(const http::Request&)>(),
+      const Option<Bytes>& _maxBodySize = None())
+    : s(_s),
+      streaming(_streaming),
+      maxBodySize(_maxBodySize),
+      failure(false),
+      request(NULL),
+      length(0)
   {
     settings.on_message_begin = &DataDecoder::on_message_begin;
 
@@ -63,6 +86,17 @@ public:
     parser.data = this;
   }
 
+  ~DataDecoder()
+  {
+    // Let the reader of a partially decoded body know that the rest
+    // of the body will never arrive.
+    if (writer.isSome()) {
+      writer->fail("Failed to decode the request body");
+    }
+
+    delete request;
+  }
+
   std::deque<http::Request*> decode(const char* data, size_t length)
   {
     size_t parsed = http_parser_execute(&parser, &settings, data, length);
@@ -72,6 +106,11 @@ public:
       failure = true;
     }
 
+    if (failure && writer.isSome()) {
+      writer->fail("Failed to decode the request body");
+      writer = None();
+    }
+
     if (!requests.empty()) {
       std::deque<http::Request*> result = requests;
       requests.clear();
@@ -218,14 +257,85 @@ private:
 
     decoder->request->keepAlive = http_should_keep_alive(&decoder->parser);
 
+    // Parse the query key/values.
+    Try<hashmap<std::string, std::string>> decoded =
+      http::query::decode(decoder->query);
+
+    if (decoded.isError()) {
+      decoder->failure = true;
+      return -1;
+    }
+
+    decoder->request->url.query = decoded.get();
+
+    decoder->length = 0;
+
+    Option<std::string> encoding =
+      decoder->request->headers.get("Content-Encoding");
+
+    if (encoding.isSome() && encoding.get() == "gzip") {
+      decoder->decompressor.reset(new gzip::Decompressor());
+    }
+
+    if (decoder->streaming && decoder->streaming(*decoder->request)) {
+      // The length of a decompressed body is not known up front.
+      if (decoder->decompressor.get() != NULL) {
+        decoder->request->headers.erase("Content-Length");
+      }
+
+      http::Pipe pipe;
+      decoder->writer = pipe.writer();
+
+      decoder->request->type = http::Request::PIPE;
+      decoder->request->reader = pipe.reader();
+
+      decoder->requests.push_back(decoder->request);
+      decoder->request = NULL;
+    }
+
     return 0;
   }
 
   static int on_body(http_parser* p, const char* data, size_t length)
   {
     DataDecoder* decoder = (DataDecoder*) p->data;
-    CHECK_NOTNULL(decoder->request);
-    decoder->request->body.append(data, length);
+
+    // NOTE: Some versions of the parser ignore the return value of
+    // 'on_body', so we also remember the failure to fail the rest of
+    // the request (see 'on_message_complete').
+    if (decoder->failure) {
+      return 1;
+    }
+
+    CHECK(decoder->request != NULL || decoder->writer.isSome());
+
+    std::string body(data, length);
+
+    if (decoder->decompressor.get() != NULL) {
+      Try<std::string> decompressed = decoder->decompressor->decompress(body);
+      if (decompressed.isError()) {
+        decoder->failure = true;
+        return 1;
+      }
+      body = decompressed.get();
+    }
+
+    decoder->length += body.size();
+
+    if (decoder->maxBodySize.isSome() &&
+        decoder->length > decoder->maxBodySize->bytes()) {
+      decoder->failure = true;
+      return 1;
+    }
+
+    if (decoder->writer.isSome()) {
+      // NOTE: We ignore a closed read-end since we still need to
+      // decode the rest of the body to get to the next request.
+      decoder->writer->write(body);
+    } else {
+      decoder->request->body.append(body);
+    }
+
     return 0;
   }
 
@@ -233,29 +343,32 @@ private:
   {
     DataDecoder* decoder = (DataDecoder*) p->data;
 
-    // Parse the query key/values.
-    Try<hashmap<std::string, std::string>> decoded =
-      http::query::decode(decoder->query);
+    if (decoder->failure) {
+      return 1;
+    }
 
-    if (decoded.isError()) {
+    if (decoder->decompressor.get() != NULL &&
+        !decoder->decompressor->finished()) {
+      decoder->failure = true; // Truncated (or empty) gzip body.
       return 1;
     }
 
-    CHECK_NOTNULL(decoder->request);
+    decoder->decompressor.reset();
 
-    decoder->request->url.query = decoded.get();
+    if (decoder->writer.isSome()) {
+      decoder->writer->close();
+      decoder->writer = None();
+      return 0;
+    }
+
+    CHECK_NOTNULL(decoder->request);
 
     Option<std::string> encoding =
       decoder->request->headers.get("Content-Encoding");
 
     if (encoding.isSome() && encoding.get() == "gzip") {
-      Try<std::string> decompressed = gzip::decompress(decoder->request->body);
-      if (decompressed.isError()) {
-        return 1;
-      }
-      decoder->request->body = decompressed.get();
       decoder->request->headers["Content-Length"] =
-        decoder->request->body.length();
+        stringify(decoder->request->body.length());
     }
 
     decoder->requests.push_back(decoder->request);
@@ -263,8 +376,16 @@ private:
     return 0;
   }
 
+  DataDecoder(const DataDecoder&) = delete;
+  DataDecoder& operator=(const DataDecoder&) = delete;
+
   const network::Socket s; // The socket this decoder is associated with.
 
+  // Determines whether the body of a request should be streamed.
+  const lambda::function<bool(const http::Request&)> streaming;
+
+  const Option<Bytes> maxBodySize;
+
   bool failure;
 
   http_parser parser;
@@ -282,6 +403,18 @@ private:
 
   http::Request* request;
 
+  // The write-end of the pipe of the request whose body is currently
+  // being streamed, if any (in which case 'request' is NULL since it
+  // has already been returned).
+  Option<http::Pipe::Writer> writer;
+
+  // Decompresses the body of the current request if it is encoded
+  // using gzip.
+  Owned<gzip::Decompressor> decompressor;
+
+  // Number of (decompressed) body bytes of the current request.
+  size_t length;
+
   std::deque<http::Request*> requests;
 };
 
@@ -658,12 +791,12 @@ private:
       return 1;
     }
 
-    // We cannot provide streaming gzip decompression!
+    // We can only provide the gzip encoding, which we decompress
+    // incrementally as the body gets streamed.
     Option<std::string> encoding =
       decoder->response->headers.get("Content-Encoding");
     if (encoding.isSome() && encoding.get() == "gzip") {
-      decoder->failure = true;
-      return 1;
+      decoder->decompressor.reset(new gzip::Decompressor());
     }
 
     CHECK_NONE(decoder->writer);
@@ -687,7 +820,27 @@ private:
     CHECK_SOME(decoder->writer);
 
     http::Pipe::Writer writer = decoder->writer.get(); // Remove const.
-    writer.write(std::string(data, length));
+
+    std::string body(data, length);
+
+    if (decoder->decompressor.get() != NULL) {
+      Try<std::string> decompressed = decoder->decompressor->decompress(body);
+      if (decompressed.isError()) {
+        decoder->failure = true;
+        writer.fail("failed to decompress body: " + decompressed.error());
+        decoder->writer = None();
+        return 1;
+      }
+
+      body = decompressed.get();
+
+      // The body of a chunk might not decompress to any data yet.
+      if (body.empty()) {
+        return 0;
+      }
+    }
+
+    writer.write(body);
 
     return 0;
   }
@@ -699,6 +852,18 @@ private:
     CHECK_SOME(decoder->writer);
 
     http::Pipe::Writer writer = decoder->writer.get(); // Remove const.
+
+    // A truncated (or empty) gzip body fails the writer.
+    if (decoder->decompressor.get() != NULL &&
+        !decoder->decompressor->finished()) {
+      decoder->failure = true;
+      writer.fail("failed to decompress body: truncated");
+      decoder->writer = None();
+      return 1;
+    }
+
+    decoder->decompressor.reset();
+
     writer.close();
 
     decoder->writer = None();
@@ -723,6 +888,10 @@ private:
   http::Response* response;
   Option<http::Pipe::Writer> writer;
 
+  // Decompresses the body of the current response if it is encoded
+  // using gzip.
+  Owned<gzip::Decompressor> decompressor;
+
   std::deque<http::Response*> responses;
 };
 
@@ -13,11 +13,17 @@
 #ifndef __ENCODER_HPP__
 #define __ENCODER_HPP__
 
+#include <limits.h>
 #include <stdint.h>
 #include <time.h>
 
+#include <sys/uio.h>
+
 #include <map>
+#include <memory>
 #include <sstream>
+#include <string>
+#include <vector>
 
 #include <process/http.hpp>
 #include <process/process.hpp>
@@ -28,9 +34,14 @@
 #include <stout/numify.hpp>
 #include <stout/os.hpp>
 
+#include "slab_pool.hpp"
+
 
 namespace process {
 
+// The default minimum size of the HTTP response bodies that get
+// compressed for the clients that accept it, see
+// LIBPROCESS_COMPRESS_RESPONSE_BYTES.
 const uint32_t GZIP_MINIMUM_BODY_LENGTH = 1024;
 
 // Forward declarations.
@@ -65,25 +76,74 @@ private:
 };
 
 
-class DataEncoder : public Encoder
+// Encodes data which is split across multiple (shared) buffers, which
+// get sent using a single "gather" write rather than being copied
+// into one contiguous buffer first.
+class VectorEncoder : public Encoder
 {
 public:
-  DataEncoder(const network::Socket& s, const std::string& _data)
-    : Encoder(s), data(_data), index(0) {}
+  explicit VectorEncoder(const network::Socket& s)
+    : Encoder(s), size(0), index(0), first(0), offset(0) {}
 
-  virtual ~DataEncoder() {}
+  virtual ~VectorEncoder() {}
 
   virtual Kind kind() const
   {
     return Encoder::DATA;
   }
 
-  virtual const char* next(size_t* length)
+  // Appends a buffer, which is shared rather than copied.
+  void append(const std::shared_ptr<const std::string>& buffer)
+  {
+    if (!buffer->empty()) {
+      buffers.push_back(buffer);
+      size += buffer->size();
+    }
+  }
+
+  // Appends the buffers of another encoder, which must not have sent
+  // any of its data yet.
+  void append(const VectorEncoder& that)
   {
-    size_t temp = index;
-    index = data.size();
-    *length = data.size() - temp;
-    return data.data() + temp;
+    CHECK_EQ(0u, that.index);
+
+    foreach (const std::shared_ptr<const std::string>& buffer, that.buffers) {
+      append(buffer);
+    }
+  }
+
+  // Returns the number of buffers that have not been sent completely.
+  size_t count() const
+  {
+    return buffers.size() - first;
+  }
+
+  virtual const struct iovec* next(int* iovcnt, size_t* length)
+  {
+    // Skip the buffers that have been sent completely.
+    while (first < buffers.size() &&
+           index >= offset + buffers[first]->size()) {
+      offset += buffers[first]->size();
+      first++;
+    }
+
+    iov.clear();
+    *length = 0;
+
+    for (size_t i = first; i < buffers.size() && iov.size() < MAX_IOVCNT; i++) {
+      const size_t skip = i == first ? index - offset : 0;
+
+      struct iovec buffer;
+      buffer.iov_base = const_cast<char*>(buffers[i]->data() + skip);
+      buffer.iov_len = buffers[i]->size() - skip;
+
+      iov.push_back(buffer);
+      *length += buffer.iov_len;
+    }
+
+    index += *length;
+    *iovcnt = static_cast<int>(iov.size());
+    return iov.data();
   }
 
   virtual void backup(size_t length)
@@ -95,66 +155,147 @@ public:
 
   virtual size_t remaining() const
   {
-    return data.size() - index;
+    return size - index;
   }
 
 private:
-  const std::string data;
+  // The maximum number of buffers passed to a single gather write.
+  static const size_t MAX_IOVCNT = IOV_MAX;
+
+  std::vector<std::shared_ptr<const std::string>> buffers;
+
+  // The total size of the buffers.
+  size_t size;
+
+  // The number of bytes returned by 'next'.
   size_t index;
+
+  // The first buffer that has not been sent completely, and the total
+  // size of the buffers before it.
+  size_t first;
+  size_t offset;
+
+  // Storage for the 'iovec' array returned by 'next', which must
+  // remain valid until the data has been sent.
+  std::vector<struct iovec> iov;
 };
 
 
-class MessageEncoder : public DataEncoder
+class DataEncoder : public VectorEncoder
 {
 public:
-  MessageEncoder(const network::Socket& s, Message* _message)
-    : DataEncoder(s, encode(_message)), message(_message) {}
+  DataEncoder(const network::Socket& s, const std::string& data)
+    : VectorEncoder(s)
+  {
+    append(std::make_shared<const std::string>(data));
+  }
 
-  virtual ~MessageEncoder()
+  virtual ~DataEncoder() {}
+};
+
+
+// Encodes a message as an HTTP request, keeping the (already
+// serialized) body of the message in its own buffer rather than
+// copying it.
+class MessageEncoder : public VectorEncoder
+{
+public:
+  // If 'compressed' is set, the body of the message has been
+  // compressed using gzip already (see SocketManager::send).
+  MessageEncoder(
+      const network::Socket& s,
+      Message* message,
+      bool compressed = false)
+    : VectorEncoder(s)
   {
     if (message != NULL) {
-      delete message;
+      // NOTE: The encoder takes ownership of the message, the body is
+      // kept alive by sharing ownership of the message with it.
+      std::shared_ptr<Message> shared(message);
+
+      append(std::make_shared<const std::string>(
+          header(*message, compressed)));
+
+      if (message->body.size() > 0) {
+        append(std::shared_ptr<const std::string>(shared, &shared->body));
+        append(trailer());
+      }
     }
   }
 
-  static std::string encode(Message* message)
+  // Encoders are allocated for every message sent, so they come from
+  // a pool (see SlabPool).
+  static void* operator new(size_t size)
   {
-    std::ostringstream out;
+    return SlabPool<MessageEncoder>::allocate(size);
+  }
 
-    if (message != NULL) {
-      out << "POST ";
-      // Nothing keeps the 'id' component of a PID from being an empty
-      // string which would create a malformed path that has two
-      // '//' unless we check for it explicitly.
-      // TODO(benh): Make the 'id' part of a PID optional so when it's
-      // missing it's clear that we're simply addressing an ip:port.
-      if (message->to.id != "") {
-        out << "/" << message->to.id;
-      }
+  static void operator delete(void* pointer, size_t size)
+  {
+    SlabPool<MessageEncoder>::deallocate(pointer, size);
+  }
 
-      out << "/" << message->name << " HTTP/1.1\r\n"
-          << "User-Agent: libprocess/" << message->from << "\r\n"
-          << "Libprocess-From: " << message->from << "\r\n"
-          << "Connection: Keep-Alive\r\n"
-          << "Host: \r\n";
+  static std::string encode(Message* message, bool compressed = false)
+  {
+    std::string result;
+
+    if (message != NULL) {
+      result = header(*message, compressed);
 
       if (message->body.size() > 0) {
-        out << "Transfer-Encoding: chunked\r\n\r\n"
-            << std::hex << message->body.size() << "\r\n";
-        out.write(message->body.data(), message->body.size());
-        out << "\r\n"
-            << "0\r\n"
-            << "\r\n";
-      } else {
-        out << "\r\n";
+        result += message->body;
+        result += *trailer();
       }
     }
 
-    return out.str();
+    return result;
   }
 
 private:
-  Message* message;
+  static std::string header(const Message& message, bool compressed)
+  {
+    std::ostringstream out;
+
+    out << "POST ";
+    // Nothing keeps the 'id' component of a PID from being an empty
+    // string which would create a malformed path that has two
+    // '//' unless we check for it explicitly.
+    // TODO(benh): Make the 'id' part of a PID optional so when it's
+    // missing it's clear that we're simply addressing an ip:port.
+    if (message.to.id != "") {
+      out << "/" << message.to.id;
+    }
+
+    out << "/" << message.name << " HTTP/1.1\r\n"
+        << "User-Agent: libprocess/" << message.from << "\r\n"
+        << "Libprocess-From: " << message.from << "\r\n"
+        << "Libprocess-Accept-Encoding: gzip\r\n"
+        << "Connection: Keep-Alive\r\n"
+        << "Host: \r\n";
+
+    if (compressed) {
+      out << "Content-Encoding: gzip\r\n";
+    }
+
+    if (message.body.size() > 0) {
+      out << "Transfer-Encoding: chunked\r\n\r\n"
+          << std::hex << message.body.size() << "\r\n";
+    } else {
+      out << "\r\n";
+    }
+
+    return out.str();
+  }
+
+  // Ends the (only) chunk of the body and the body itself.
+  static const std::shared_ptr<const std::string>& trailer()
+  {
+    static const std::shared_ptr<const std::string>* trailer =
+      new std::shared_ptr<const std::string>(
+          new std::string("\r\n0\r\n\r\n"));
+
+    return *trailer;
+  }
 };
 
 
@@ -196,22 +337,9 @@ public:
 
     headers["Date"] = date;
 
-    // Should we compress this response?
-    std::string body = response.body;
-
-    if (response.type == http::Response::BODY &&
-        response.body.length() >= GZIP_MINIMUM_BODY_LENGTH &&
-        !headers.contains("Content-Encoding") &&
-        request.acceptsEncoding("gzip")) {
-      Try<std::string> compressed = gzip::compress(body);
-      if (compressed.isError()) {
-        LOG(WARNING) << "Failed to gzip response body: " << compressed.error();
-      } else {
-        body = compressed.get();
-        headers["Content-Length"] = stringify(body.length());
-        headers["Content-Encoding"] = "gzip";
-      }
-    }
+    // NOTE: The body is expected to be compressed already, if it
+    // should be, see 'HttpProxy::process'.
+    const std::string& body = response.body;
 
     foreachpair (const std::string& key, const std::string& value, headers) {
       out << key << ": " << value << "\r\n";
@@ -247,11 +375,17 @@ public:
 };
 
 
+// Encodes 'size' bytes of the file 'fd' starting at 'offset', e.g.,
+// for the range of a file requested via a 'Range' header.
 class FileEncoder : public Encoder
 {
 public:
-  FileEncoder(const network::Socket& s, int _fd, size_t _size)
-    : Encoder(s), fd(_fd), size(_size), index(0) {}
+  FileEncoder(
+      const network::Socket& s,
+      int _fd,
+      size_t _size,
+      off_t _offset = 0)
+    : Encoder(s), fd(_fd), size(_size), start(_offset), index(0) {}
 
   virtual ~FileEncoder()
   {
@@ -267,7 +401,7 @@ public:
   {
     off_t temp = index;
     index = size;
-    *offset = temp;
+    *offset = start + temp;
     *length = size - temp;
     return fd;
   }
@@ -287,6 +421,7 @@ public:
 private:
   int fd;
   size_t size;
+  off_t start;
   off_t index;
 };
 
@@ -0,0 +1,515 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <errno.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/time.h>
+
+#include <atomic>
+#include <cmath>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <process/io.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/lambda.hpp>
+#include <stout/nothing.hpp>
+#include <stout/numify.hpp>
+#include <stout/option.hpp>
+#include <stout/os.hpp>
+#include <stout/synchronized.hpp>
+#include <stout/thread_local.hpp>
+#include <stout/try.hpp>
+
+#include "epoll.hpp"
+#include "event_loop.hpp"
+
+namespace process {
+
+// Maximum number of events returned by a single 'epoll_wait'.
+static const int MAX_EVENTS = 256;
+
+// The watchers for each file descriptor being watched, along with
+// the events that the file descriptor is registered for. Only
+// accessed within the loop of the file descriptor.
+struct Watchers
+{
+  Watchers() : registered(0) {}
+
+  std::list<std::shared_ptr<Watcher>> watchers;
+  uint32_t registered;
+};
+
+
+struct Loop
+{
+  Loop() : epoll_fd(-1), interrupt_fd(-1), interrupted(false) {}
+
+  // The epoll instance of the loop.
+  int epoll_fd;
+
+  // An eventfd that gets written to in order to interrupt the loop,
+  // the loop only reads from it when 'interrupted' is true so that we
+  // do at most one write per loop iteration.
+  int interrupt_fd;
+  std::atomic_bool interrupted;
+
+  // Queue of functions to be invoked asynchronously within the loop
+  // (protected by 'mutex').
+  std::queue<lambda::function<void(void)>> functions;
+  std::mutex mutex;
+
+  // The file descriptors pinned to this loop which are being watched.
+  // Only accessed within the loop.
+  hashmap<int, Watchers> fds;
+
+  // Pending delays, keyed by the (monotonic) time at which they
+  // should be invoked. Only accessed within the loop.
+  std::multimap<double, lambda::function<void(void)>> delays;
+};
+
+
+// The loops, created by 'EventLoop::initialize' and never deleted.
+static std::vector<Loop*>* loops = new std::vector<Loop*>();
+
+static std::atomic_bool stopping(false);
+
+THREAD_LOCAL Loop* __loop__ = NULL;
+
+
+Loop* loop(int fd)
+{
+  return (*loops)[static_cast<size_t>(fd) % loops->size()];
+}
+
+
+Loop* timers()
+{
+  return loops->front();
+}
+
+
+// Returns the current monotonic time in seconds, used for timers so
+// that changes to the system time do not affect them.
+static double monotonic()
+{
+  struct timespec ts;
+  if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+    PLOG(FATAL) << "Failed to get the monotonic time";
+  }
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+// Updates the events that the file descriptor is registered for to
+// be the union of the events of its watchers. Returns false if the
+// file descriptor can not be watched using epoll, e.g., because it
+// is a regular file (always "ready") or has been closed.
+//
+// NOTE: Unless 'force' is true we skip updating the registration if
+// the events did not change. Since closing a file descriptor removes
+// it from the epoll instance without us knowing, a new watcher always
+// forces the update in case the file descriptor got closed and reused.
+static bool update(
+    Loop* loop,
+    int fd,
+    Watchers* watchers,
+    bool force = false)
+{
+  uint32_t events = 0;
+  foreach (const std::shared_ptr<Watcher>& watcher, watchers->watchers) {
+    if (watcher->events & io::READ) {
+      events |= EPOLLIN;
+    }
+    if (watcher->events & io::WRITE) {
+      events |= EPOLLOUT;
+    }
+  }
+
+  if (events == watchers->registered && !force) {
+    return true;
+  }
+
+  struct epoll_event event;
+  event.events = events;
+  event.data.fd = fd;
+
+  int result = 0;
+
+  if (events == 0) {
+    // NOTE: The file descriptor might have already been closed (which
+    // removes it from the epoll instance), so we ignore any errors.
+    epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, fd, &event);
+  } else if (watchers->registered == 0) {
+    result = epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, fd, &event);
+    if (result < 0 && errno == EEXIST) {
+      result = epoll_ctl(loop->epoll_fd, EPOLL_CTL_MOD, fd, &event);
+    }
+  } else {
+    result = epoll_ctl(loop->epoll_fd, EPOLL_CTL_MOD, fd, &event);
+    if (result < 0 && errno == ENOENT) {
+      // The file descriptor was closed (and possibly reused) since
+      // it got registered.
+      result = epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, fd, &event);
+    }
+  }
+
+  if (result < 0) {
+    watchers->registered = 0;
+    return false;
+  }
+
+  watchers->registered = events;
+  return true;
+}
+
+
+void watch(const std::shared_ptr<Watcher>& watcher)
+{
+  Loop* loop = process::loop(watcher->fd);
+
+  CHECK_EQ(loop, __loop__);
+
+  Watchers& watchers = loop->fds[watcher->fd];
+  watchers.watchers.push_back(watcher);
+
+  if (!update(loop, watcher->fd, &watchers, true)) {
+    // Like libev, we consider a file descriptor that can not be
+    // watched (e.g., a regular file, or a closed file descriptor) to
+    // be ready so that the subsequent I/O reports the actual error.
+    watchers.watchers.pop_back();
+
+    if (watchers.watchers.empty()) {
+      loop->fds.erase(watcher->fd);
+    }
+
+    watcher->promise.set(watcher->events);
+  }
+}
+
+
+bool unwatch(const std::shared_ptr<Watcher>& watcher)
+{
+  Loop* loop = process::loop(watcher->fd);
+
+  CHECK_EQ(loop, __loop__);
+
+  if (!loop->fds.contains(watcher->fd)) {
+    return false;
+  }
+
+  Watchers& watchers = loop->fds[watcher->fd];
+
+  for (auto it = watchers.watchers.begin();
+       it != watchers.watchers.end();
+       ++it) {
+    if (*it == watcher) {
+      watchers.watchers.erase(it);
+
+      update(loop, watcher->fd, &watchers);
+
+      if (watchers.watchers.empty()) {
+        loop->fds.erase(watcher->fd);
+      }
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+static void interrupt(Loop* loop)
+{
+  if (!loop->interrupted.exchange(true)) {
+    const uint64_t value = 1;
+    while (::write(loop->interrupt_fd, &value, sizeof(value)) < 0) {
+      if (errno != EINTR) {
+        PLOG(FATAL) << "Failed to interrupt the event loop";
+      }
+    }
+  }
+}
+
+
+void enqueue(Loop* loop, const lambda::function<void(void)>& function)
+{
+  synchronized (loop->mutex) {
+    loop->functions.push(function);
+  }
+
+  interrupt(loop);
+}
+
+
+// Invoked when a file descriptor has the specified ready events.
+static void handle(Loop* loop, int fd, uint32_t events)
+{
+  if (!loop->fds.contains(fd)) {
+    return; // No longer watched.
+  }
+
+  short ready = 0;
+
+  // NOTE: Errors and hang ups make both reads and writes "ready" so
+  // that the subsequent I/O reports them.
+  if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+    ready |= io::READ;
+  }
+  if (events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+    ready |= io::WRITE;
+  }
+
+  Watchers& watchers = loop->fds[fd];
+
+  std::vector<std::pair<std::shared_ptr<Watcher>, short>> triggered;
+
+  for (auto it = watchers.watchers.begin(); it != watchers.watchers.end();) {
+    if ((*it)->events & ready) {
+      triggered.push_back(std::make_pair(*it, (*it)->events & ready));
+      it = watchers.watchers.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  update(loop, fd, &watchers);
+
+  if (watchers.watchers.empty()) {
+    loop->fds.erase(fd);
+  }
+
+  // NOTE: We set the promises after updating 'fds' since the
+  // callbacks might watch (or unwatch) file descriptors.
+  foreach (auto& watcher, triggered) {
+    watcher.first->promise.set(watcher.second);
+  }
+}
+
+
+static void run_functions(Loop* loop)
+{
+  std::queue<lambda::function<void(void)>> run_functions;
+
+  // NOTE: We reset 'interrupted' before swapping out the functions
+  // so that a function enqueued afterwards either gets swapped out
+  // below or causes another interrupt.
+  loop->interrupted.store(false);
+
+  synchronized (loop->mutex) {
+    std::swap(run_functions, loop->functions);
+  }
+
+  // Running the functions outside of the mutex reduces locking
+  // contention and avoids deadlocks, see 'handle_async' in libev.cpp.
+  while (!run_functions.empty()) {
+    (run_functions.front())();
+    run_functions.pop();
+  }
+}
+
+
+static void run_timers(Loop* loop)
+{
+  const double now = monotonic();
+
+  while (!loop->delays.empty() && loop->delays.begin()->first <= now) {
+    lambda::function<void(void)> function = loop->delays.begin()->second;
+    loop->delays.erase(loop->delays.begin());
+    function();
+  }
+}
+
+
+void EventLoop::initialize()
+{
+  // The number of loops to distribute the file descriptors between,
+  // each run by its own thread.
+  size_t count = 1;
+
+  Option<std::string> value = os::getenv("LIBPROCESS_NUM_EVENT_LOOPS");
+  if (value.isSome()) {
+    Try<size_t> result = numify<size_t>(value.get());
+    if (result.isError() || result.get() == 0) {
+      LOG(FATAL) << "LIBPROCESS_NUM_EVENT_LOOPS=" << value.get()
+                 << " is not a positive number";
+    }
+    count = result.get();
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    Loop* loop = new Loop();
+
+    loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (loop->epoll_fd < 0) {
+      PLOG(FATAL) << "Failed to create epoll instance";
+    }
+
+    loop->interrupt_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (loop->interrupt_fd < 0) {
+      PLOG(FATAL) << "Failed to create eventfd";
+    }
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = loop->interrupt_fd;
+
+    if (epoll_ctl(
+            loop->epoll_fd, EPOLL_CTL_ADD, loop->interrupt_fd, &event) < 0) {
+      PLOG(FATAL) << "Failed to add eventfd to epoll instance";
+    }
+
+    loops->push_back(loop);
+  }
+}
+
+
+size_t EventLoop::count()
+{
+  return loops->size();
+}
+
+
+namespace internal {
+
+Future<Nothing> delay(
+    const Duration& duration,
+    const lambda::function<void(void)>& function)
+{
+  // Negative durations get invoked on the next loop iteration.
+  double after = duration.secs();
+
+  if (after < 0) {
+    after = 0;
+  }
+
+  timers()->delays.insert(std::make_pair(monotonic() + after, function));
+
+  return Nothing();
+}
+
+} // namespace internal {
+
+
+void EventLoop::delay(
+    const Duration& duration,
+    const lambda::function<void(void)>& function)
+{
+  run_in_event_loop<Nothing>(
+      timers(),
+      lambda::bind(&internal::delay, duration, function));
+}
+
+
+double EventLoop::time()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+
+static void run(Loop* loop)
+{
+  __loop__ = loop;
+
+  struct epoll_event events[MAX_EVENTS];
+
+  while (!stopping.load()) {
+    // Wait until the earliest timer, or indefinitely.
+    int timeout = -1;
+    if (!loop->delays.empty()) {
+      const double after = loop->delays.begin()->first - monotonic();
+      timeout = after <= 0 ? 0 : static_cast<int>(std::ceil(after * 1000));
+    }
+
+    int count = epoll_wait(loop->epoll_fd, events, MAX_EVENTS, timeout);
+
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      PLOG(FATAL) << "Failed to wait for events";
+    }
+
+    bool interrupt = false;
+
+    for (int i = 0; i < count; i++) {
+      if (events[i].data.fd == loop->interrupt_fd) {
+        uint64_t value;
+        while (::read(loop->interrupt_fd, &value, sizeof(value)) < 0 &&
+               errno == EINTR);
+        interrupt = true;
+      } else {
+        handle(loop, events[i].data.fd, events[i].events);
+      }
+    }
+
+    if (interrupt) {
+      run_functions(loop);
+    }
+
+    run_timers(loop);
+  }
+
+  __loop__ = NULL;
+}
+
+
+void EventLoop::run()
+{
+  // This thread runs the first loop, which also runs the delays, and
+  // each of the other loops gets a thread of its own.
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < loops->size(); i++) {
+    threads.emplace_back(&process::run, (*loops)[i]);
+  }
+
+  process::run(loops->front());
+
+  foreach (std::thread& thread, threads) {
+    thread.join();
+  }
+}
+
+
+void EventLoop::stop()
+{
+  stopping.store(true);
+
+  // Make sure each loop observes 'stopping' even if it is currently
+  // interrupted (see 'interrupt').
+  foreach (Loop* loop, *loops) {
+    const uint64_t value = 1;
+    while (::write(loop->interrupt_fd, &value, sizeof(value)) < 0 &&
+           errno == EINTR);
+  }
+}
+
+} // namespace process {
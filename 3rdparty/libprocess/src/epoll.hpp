@@ -0,0 +1,115 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __EPOLL_HPP__
+#define __EPOLL_HPP__
+
+#include <memory>
+
+#include <process/future.hpp>
+#include <process/owned.hpp>
+
+#include <stout/lambda.hpp>
+#include <stout/thread_local.hpp>
+
+namespace process {
+
+// A request to get notified when a file descriptor becomes readable
+// and/or writable (see io::poll). Only accessed within the event loop.
+struct Watcher
+{
+  Watcher(int _fd, short _events) : fd(_fd), events(_events) {}
+
+  const int fd;
+
+  // The events of interest, i.e., io::READ and/or io::WRITE.
+  const short events;
+
+  // Gets set to the events that are ready.
+  Promise<short> promise;
+};
+
+
+// An epoll instance and the thread that waits on it. There are
+// 'EventLoop::count()' loops, and each file descriptor is pinned to
+// one of them by its number, so that all the watchers of a file
+// descriptor are in the same epoll instance and only ever get
+// triggered by the same thread.
+struct Loop;
+
+// Returns the loop that the file descriptor is pinned to.
+Loop* loop(int fd);
+
+// Returns the loop that runs the delays (see 'EventLoop::delay').
+Loop* timers();
+
+
+// Starts watching the file descriptor of the watcher, the promise of
+// the watcher gets set the first time any of its events are ready.
+// Must be called within the loop of the file descriptor.
+void watch(const std::shared_ptr<Watcher>& watcher);
+
+
+// Stops watching the file descriptor of the watcher. Returns false
+// if the watcher was not being watched (e.g., because its promise
+// has already been set). Must be called within the loop of the file
+// descriptor.
+bool unwatch(const std::shared_ptr<Watcher>& watcher);
+
+
+// Enqueues the function to be invoked asynchronously within the
+// loop, and interrupts the loop to invoke it.
+void enqueue(Loop* loop, const lambda::function<void(void)>& function);
+
+
+// The loop run by this thread, if any.
+extern THREAD_LOCAL Loop* __loop__;
+
+
+// Wrapper around function we want to run in the event loop.
+template <typename T>
+void _run_in_event_loop(
+    const lambda::function<Future<T>(void)>& f,
+    const Owned<Promise<T>>& promise)
+{
+  // Don't bother running the function if the future has been discarded.
+  if (promise->future().hasDiscard()) {
+    promise->discard();
+  } else {
+    promise->set(f());
+  }
+}
+
+
+// Helper for running a function in the given event loop.
+template <typename T>
+Future<T> run_in_event_loop(
+    Loop* loop,
+    const lambda::function<Future<T>(void)>& f)
+{
+  // If this is already the event loop then just run the function.
+  if (__loop__ == loop) {
+    return f();
+  }
+
+  Owned<Promise<T>> promise(new Promise<T>());
+
+  Future<T> future = promise->future();
+
+  enqueue(loop, lambda::bind(&_run_in_event_loop<T>, f, promise));
+
+  return future;
+}
+
+} // namespace process {
+
+#endif // __EPOLL_HPP__
@@ -0,0 +1,84 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <memory>
+
+#include <process/future.hpp>
+#include <process/io.hpp>
+#include <process/process.hpp> // For process::initialize.
+
+#include <stout/lambda.hpp>
+#include <stout/nothing.hpp>
+
+#include "epoll.hpp"
+
+namespace process {
+namespace io {
+namespace internal {
+
+// Event loop callback when the future associated with polling a
+// file descriptor has been discarded.
+Future<Nothing> discard_poll(const std::weak_ptr<Watcher>& weak)
+{
+  std::shared_ptr<Watcher> watcher = weak.lock();
+
+  // If the watcher has already been triggered we let it "win".
+  if (watcher && unwatch(watcher)) {
+    watcher->promise.discard();
+  }
+
+  return Nothing();
+}
+
+
+// Helper/continuation of 'poll' on future discard.
+void _poll(int fd, const std::weak_ptr<Watcher>& watcher)
+{
+  run_in_event_loop<Nothing>(loop(fd), lambda::bind(&discard_poll, watcher));
+}
+
+
+Future<short> poll(int fd, short events)
+{
+  std::shared_ptr<Watcher> watcher(new Watcher(fd, events));
+
+  // Get a copy of the future to avoid any races with the event loop.
+  Future<short> future = watcher->promise.future();
+
+  // Make sure we stop polling if a discard occurs on our future.
+  // NOTE: We only keep a weak pointer so that a triggered watcher
+  // can get deleted even if the future never gets discarded.
+  future.onDiscard(
+      lambda::bind(&_poll, fd, std::weak_ptr<Watcher>(watcher)));
+
+  watch(watcher);
+
+  return future;
+}
+
+} // namespace internal {
+
+
+Future<short> poll(int fd, short events)
+{
+  process::initialize();
+
+  // TODO(benh): Check if the file descriptor is non-blocking?
+
+  // Poll within the loop that the file descriptor is pinned to.
+  return run_in_event_loop<short>(
+      loop(fd),
+      lambda::bind(&internal::poll, fd, events));
+}
+
+} // namespace io {
+} // namespace process {
@@ -27,6 +27,12 @@ public:
   // Initializes the event loop.
   static void initialize();
 
+  // Returns the number of event loops, each run by a thread of its
+  // own, between which the file descriptors are distributed. Only the
+  // epoll event loop supports more than one (see
+  // LIBPROCESS_NUM_EVENT_LOOPS).
+  static size_t count();
+
   // Invoke the specified function in the event loop after the
   // specified duration.
   // TODO(bmahler): Update this to use rvalue references.
@@ -37,7 +43,7 @@ public:
   // Returns the current time w.r.t. the event loop.
   static double time();
 
-  // Runs the event loop.
+  // Runs the event loop(s), returns once they have been stopped.
   static void run();
 
   // Asynchronously tells the event loop to stop and then returns.
@@ -0,0 +1,432 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESS_EVENT_QUEUE_HPP__
+#define __PROCESS_EVENT_QUEUE_HPP__
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+#include <process/event.hpp>
+
+#include <stout/hashset.hpp>
+#include <stout/synchronized.hpp>
+
+#include "mailbox_metrics.hpp"
+
+namespace process {
+
+// The queue of events of a process. Any number of threads (the
+// producers) can enqueue events without ever blocking each other,
+// while only the thread currently running the process (the consumer)
+// dequeues events.
+//
+// Each queue is an intrusive multi-producer/single-consumer queue
+// (see Dmitry Vyukov's "Intrusive MPSC node-based queue") linked
+// through 'Event::next', so enqueueing an event never allocates.
+//
+// Injected events (e.g., a TerminateEvent with 'inject == true') are
+// kept on a separate queue which always gets dequeued first.
+//
+// In addition to the consumer, other threads may want to inspect the
+// events (e.g., for 'ProcessBase::eventCount' or '/__processes__').
+// Since events get deleted by the consumer once they have been
+// served, inspecting threads and the consumer synchronize on a mutex
+// which the producers never acquire.
+//
+// Messages can be prioritized by name (see 'prioritize'), e.g., for
+// the "control plane" messages of a process which must not wait
+// behind a flood of "bulk" messages. Once any message has been
+// prioritized the consumer moves the enqueued events onto a control
+// list (prioritized messages) and a bulk list (every other event)
+// which preserve the order of the events within each list, and
+// dequeues from the control list first. To protect the bulk events
+// from starvation a bulk event gets dequeued after every
+// 'CONTROL_BURST' consecutive control events.
+//
+// An event queue can optionally be instrumented (see MailboxMetrics)
+// to keep track of the number of queued events and how long each
+// event was queued for.
+class EventQueue
+{
+public:
+  EventQueue() : bursts(0), metrics(NULL) {}
+
+  ~EventQueue()
+  {
+    // Delete any events that were never dequeued (e.g., when a
+    // process gets deleted without ever having been spawned).
+    Event* event = NULL;
+    while ((event = dequeue()) != NULL) {
+      delete event;
+    }
+  }
+
+  // Instruments the queue, must be called before any events get
+  // enqueued. The metrics must outlive the queue.
+  void instrument(MailboxMetrics* _metrics)
+  {
+    metrics = _metrics;
+  }
+
+  // Prioritizes messages with the specified name over all other
+  // (non injected) events. Can be called from any thread, but note
+  // that events which were enqueued before may already have been
+  // dequeued as bulk events.
+  void prioritize(const std::string& name)
+  {
+    synchronized (mutex) {
+      prioritized.insert(name);
+    }
+  }
+
+  // Producer side, can be called concurrently from any thread.
+  void enqueue(Event* event, bool inject = false)
+  {
+    if (metrics != NULL) {
+      event->enqueued = MailboxMetrics::now();
+      metrics->depth.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (!inject) {
+      events.push(event);
+    } else {
+      injected.push(event);
+    }
+  }
+
+  // Consumer side, returns NULL if there are no events or the only
+  // events are still in the middle of being enqueued (see 'empty').
+  Event* dequeue()
+  {
+    synchronized (mutex) {
+      Event* event = injected.pop();
+      if (event == NULL) {
+        event = prioritized.empty() ? events.pop() : dequeuePrioritized();
+      }
+
+      if (event != NULL && metrics != NULL) {
+        metrics->depth.fetch_sub(1, std::memory_order_relaxed);
+        metrics->latency.record(MailboxMetrics::now() - event->enqueued);
+      }
+
+      return event;
+    }
+  }
+
+  // Consumer side, returns true only if no events have been, or are
+  // in the middle of being, enqueued. Note that 'dequeue' may still
+  // return NULL after this returns false if a producer has not yet
+  // finished linking its event into the queue.
+  bool empty()
+  {
+    synchronized (mutex) {
+      return injected.empty() &&
+        control.empty() &&
+        bulk.empty() &&
+        events.empty();
+    }
+  }
+
+  // Returns the number of events for which 'predicate' returns true.
+  // Can be called from any thread.
+  size_t count(bool (*predicate)(const Event*))
+  {
+    size_t count = 0;
+
+    synchronized (mutex) {
+      count += injected.count(predicate);
+      count += control.count(predicate);
+      count += bulk.count(predicate);
+      count += events.count(predicate);
+    }
+
+    return count;
+  }
+
+  // Visits every event in the order they will be dequeued (ignoring
+  // starvation protection and the prioritization of events which are
+  // still on the queue). Can be called from any thread.
+  void visit(EventVisitor* visitor)
+  {
+    synchronized (mutex) {
+      injected.visit(visitor);
+      control.visit(visitor);
+      bulk.visit(visitor);
+      events.visit(visitor);
+    }
+  }
+
+private:
+  // The "stub" node which is linked into a queue whenever the
+  // consumer needs to dequeue the last event.
+  struct Stub : Event
+  {
+    virtual void visit(EventVisitor* visitor) const {}
+  };
+
+  class Queue
+  {
+  public:
+    Queue() : head(&stub), tail(&stub) {}
+
+    void push(Event* event)
+    {
+      event->next.store(NULL, std::memory_order_relaxed);
+
+      // NOTE: Exchanging the head must be sequentially consistent
+      // with respect to the process state so that the consumer
+      // either observes this event after marking the process BLOCKED
+      // or the producer observes BLOCKED (see ProcessManager::resume
+      // and ProcessBase::enqueue).
+      Event* previous = head.exchange(event);
+
+      // The queue is "broken" between the exchange above and the
+      // store below, during which 'pop' returns NULL but 'empty'
+      // returns false.
+      previous->next.store(event, std::memory_order_release);
+    }
+
+    Event* pop()
+    {
+      Event* first = tail;
+      Event* next = first->next.load(std::memory_order_acquire);
+
+      if (first == &stub) {
+        if (next == NULL) {
+          return NULL;
+        }
+        tail = next;
+        first = next;
+        next = next->next.load(std::memory_order_acquire);
+      }
+
+      if (next != NULL) {
+        tail = next;
+        return first;
+      }
+
+      if (first != head.load()) {
+        // A producer is in the middle of enqueueing an event.
+        return NULL;
+      }
+
+      // 'first' is the last event, put the stub back on the queue so
+      // that 'first' can be dequeued.
+      push(&stub);
+
+      next = first->next.load(std::memory_order_acquire);
+
+      if (next != NULL) {
+        tail = next;
+        return first;
+      }
+
+      return NULL;
+    }
+
+    bool empty() const
+    {
+      return tail == &stub && head.load() == &stub;
+    }
+
+    size_t count(bool (*predicate)(const Event*)) const
+    {
+      size_t count = 0;
+
+      for (const Event* event = tail;
+           event != NULL;
+           event = event->next.load(std::memory_order_acquire)) {
+        if (event != &stub && predicate(event)) {
+          count++;
+        }
+      }
+
+      return count;
+    }
+
+    void visit(EventVisitor* visitor) const
+    {
+      for (const Event* event = tail;
+           event != NULL;
+           event = event->next.load(std::memory_order_acquire)) {
+        if (event != &stub) {
+          event->visit(visitor);
+        }
+      }
+    }
+
+  private:
+    Queue(const Queue&) = delete;
+    Queue& operator=(const Queue&) = delete;
+
+    Stub stub;
+
+    // Most recently enqueued event, shared by all producers.
+    std::atomic<Event*> head;
+
+    // Next event to dequeue, only accessed by the consumer.
+    Event* tail;
+  };
+
+  // A FIFO list of events which have been dequeued from 'events',
+  // linked through 'Event::next' (which is no longer used by the
+  // queue) so that prioritizing never allocates. Only accessed while
+  // holding the mutex.
+  class List
+  {
+  public:
+    List() : front(NULL), back(NULL) {}
+
+    void push(Event* event)
+    {
+      event->next.store(NULL, std::memory_order_relaxed);
+
+      if (back == NULL) {
+        front = event;
+      } else {
+        back->next.store(event, std::memory_order_relaxed);
+      }
+
+      back = event;
+    }
+
+    Event* pop()
+    {
+      Event* event = front;
+
+      if (event != NULL) {
+        front = event->next.load(std::memory_order_relaxed);
+        if (front == NULL) {
+          back = NULL;
+        }
+      }
+
+      return event;
+    }
+
+    bool empty() const
+    {
+      return front == NULL;
+    }
+
+    size_t count(bool (*predicate)(const Event*)) const
+    {
+      size_t count = 0;
+
+      for (const Event* event = front;
+           event != NULL;
+           event = event->next.load(std::memory_order_relaxed)) {
+        if (predicate(event)) {
+          count++;
+        }
+      }
+
+      return count;
+    }
+
+    void visit(EventVisitor* visitor) const
+    {
+      for (const Event* event = front;
+           event != NULL;
+           event = event->next.load(std::memory_order_relaxed)) {
+        event->visit(visitor);
+      }
+    }
+
+  private:
+    List(const List&) = delete;
+    List& operator=(const List&) = delete;
+
+    Event* front;
+    Event* back;
+  };
+
+  // Maximum number of consecutive control events to dequeue while
+  // there are bulk events.
+  static const int CONTROL_BURST = 8;
+
+  // Moves the enqueued events onto the control and bulk lists, and
+  // returns the next event to serve (or NULL if there are none).
+  // Must be called while holding the mutex.
+  Event* dequeuePrioritized()
+  {
+    Event* event = NULL;
+    while ((event = events.pop()) != NULL) {
+      if (isControl(event)) {
+        control.push(event);
+      } else {
+        bulk.push(event);
+      }
+    }
+
+    if (bulk.empty()) {
+      bursts = 0;
+      return control.pop();
+    }
+
+    if (!control.empty() && bursts < CONTROL_BURST) {
+      bursts++;
+      return control.pop();
+    }
+
+    bursts = 0;
+    return bulk.pop();
+  }
+
+  // Returns true if the event is a prioritized message.
+  bool isControl(const Event* event) const
+  {
+    struct ControlVisitor : EventVisitor
+    {
+      explicit ControlVisitor(const hashset<std::string>* _prioritized)
+        : prioritized(_prioritized), result(false) {}
+
+      virtual void visit(const MessageEvent& event)
+      {
+        result = prioritized->contains(event.message->name);
+      }
+
+      const hashset<std::string>* prioritized;
+      bool result;
+    } visitor(&prioritized);
+
+    event->visit(&visitor);
+
+    return visitor.result;
+  }
+
+  EventQueue(const EventQueue&) = delete;
+  EventQueue& operator=(const EventQueue&) = delete;
+
+  Queue events;
+  Queue injected;
+
+  // Names of the prioritized messages, and the events which have
+  // been moved off of 'events' (see 'dequeuePrioritized').
+  hashset<std::string> prioritized;
+  List control;
+  List bulk;
+
+  // Number of consecutive control events dequeued while there were
+  // bulk events (see 'CONTROL_BURST').
+  int bursts;
+
+  std::mutex mutex;
+
+  MailboxMetrics* metrics;
+};
+
+} // namespace process {
+
+#endif // __PROCESS_EVENT_QUEUE_HPP__
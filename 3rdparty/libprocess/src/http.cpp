@@ -30,7 +30,9 @@
 #include <vector>
 
 #include <process/async.hpp>
+#include <process/clock.hpp>
 #include <process/defer.hpp>
+#include <process/delay.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/http.hpp>
@@ -51,6 +53,7 @@
 #include <stout/try.hpp>
 
 #include "decoder.hpp"
+#include "slab_pool.hpp"
 
 using std::deque;
 using std::istringstream;
@@ -297,6 +300,18 @@ bool Request::acceptsMediaType(const string& mediaType) const
 }
 
 
+void* Request::operator new(size_t size)
+{
+  return SlabPool<Request>::allocate(size);
+}
+
+
+void Request::operator delete(void* pointer, size_t size)
+{
+  SlabPool<Request>::deallocate(pointer, size);
+}
+
+
 Pipe::Reader Pipe::reader() const
 {
   return Pipe::Reader(data);
@@ -312,13 +327,22 @@ Pipe::Writer Pipe::writer() const
 Future<string> Pipe::Reader::read()
 {
   Future<string> future;
+  queue<Owned<Promise<Nothing>>> writables;
 
   synchronized (data->lock) {
     if (data->readEnd == Reader::CLOSED) {
       future = Failure("closed");
     } else if (!data->writes.empty()) {
       future = data->writes.front();
+      data->size -= data->writes.front().size();
       data->writes.pop();
+
+      // Extract the waiting writers if we're below the high-water
+      // mark again so we can notify them.
+      if (data->highWaterMark.isSome() &&
+          data->size < data->highWaterMark->bytes()) {
+        std::swap(data->writables, writables);
+      }
     } else if (data->writeEnd == Writer::CLOSED) {
       future = ""; // End-of-file.
     } else if (data->writeEnd == Writer::FAILED) {
@@ -330,6 +354,13 @@ Future<string> Pipe::Reader::read()
     }
   }
 
+  // NOTE: We set the promises outside the critical section to avoid
+  // triggering callbacks that try to reacquire the lock.
+  while (!writables.empty()) {
+    writables.front()->set(Nothing());
+    writables.pop();
+  }
+
   return future;
 }
 
@@ -339,6 +370,7 @@ bool Pipe::Reader::close()
   bool closed = false;
   bool notify = false;
   queue<Owned<Promise<string>>> reads;
+  queue<Owned<Promise<Nothing>>> writables;
 
   synchronized (data->lock) {
     if (data->readEnd == Reader::OPEN) {
@@ -346,9 +378,12 @@ bool Pipe::Reader::close()
       while (!data->writes.empty()) {
         data->writes.pop();
       }
+      data->size = 0;
 
-      // Extract the pending reads so we can fail them.
+      // Extract the pending reads and the waiting writers so we can
+      // fail them.
       std::swap(data->reads, reads);
+      std::swap(data->writables, writables);
 
       closed = true;
       data->readEnd = Reader::CLOSED;
@@ -366,6 +401,11 @@ bool Pipe::Reader::close()
       reads.pop();
     }
 
+    while (!writables.empty()) {
+      writables.front()->fail("closed");
+      writables.pop();
+    }
+
     if (notify) {
       data->readerClosure.set(Nothing());
     }
@@ -375,6 +415,34 @@ bool Pipe::Reader::close()
 }
 
 
+namespace internal {
+
+// Continues reading from the pipe until end-of-file, accumulating
+// the data that was read so far in 'buffer'.
+Future<string> _readAll(
+    Pipe::Reader reader,
+    const std::shared_ptr<string>& buffer)
+{
+  return reader.read()
+    .then([=](const string& data) mutable -> Future<string> {
+      if (data.empty()) {
+        return *buffer; // End-of-file.
+      }
+
+      buffer->append(data);
+      return _readAll(reader, buffer);
+    });
+}
+
+} // namespace internal {
+
+
+Future<string> Pipe::Reader::readAll()
+{
+  return internal::_readAll(*this, std::make_shared<string>());
+}
+
+
 bool Pipe::Writer::write(const string& s)
 {
   bool written = false;
@@ -387,6 +455,7 @@ bool Pipe::Writer::write(const string& s)
       if (!s.empty()) {
         if (data->reads.empty()) {
           data->writes.push(s);
+          data->size += s.size();
         } else {
           read = data->reads.front();
           data->reads.pop();
@@ -410,11 +479,14 @@ bool Pipe::Writer::close()
 {
   bool closed = false;
   queue<Owned<Promise<string>>> reads;
+  queue<Owned<Promise<Nothing>>> writables;
 
   synchronized (data->lock) {
     if (data->writeEnd == Writer::OPEN) {
-      // Extract all the pending reads so we can complete them.
+      // Extract all the pending reads so we can complete them, and
+      // the waiting writers so we can fail them.
       std::swap(data->reads, reads);
+      std::swap(data->writables, writables);
 
       data->writeEnd = Writer::CLOSED;
       closed = true;
@@ -428,6 +500,11 @@ bool Pipe::Writer::close()
     reads.pop();
   }
 
+  while (!writables.empty()) {
+    writables.front()->fail("closed");
+    writables.pop();
+  }
+
   return closed;
 }
 
@@ -436,11 +513,14 @@ bool Pipe::Writer::fail(const string& message)
 {
   bool failed = false;
   queue<Owned<Promise<string>>> reads;
+  queue<Owned<Promise<Nothing>>> writables;
 
   synchronized (data->lock) {
     if (data->writeEnd == Writer::OPEN) {
-      // Extract all the pending reads so we can fail them.
+      // Extract all the pending reads and the waiting writers so we
+      // can fail them.
       std::swap(data->reads, reads);
+      std::swap(data->writables, writables);
 
       data->writeEnd = Writer::FAILED;
       data->failure = Failure(message);
@@ -455,6 +535,11 @@ bool Pipe::Writer::fail(const string& message)
     reads.pop();
   }
 
+  while (!writables.empty()) {
+    writables.front()->fail("closed");
+    writables.pop();
+  }
+
   return failed;
 }
 
@@ -465,6 +550,38 @@ Future<Nothing> Pipe::Writer::readerClosed() const
 }
 
 
+Future<Nothing> Pipe::Writer::writable() const
+{
+  Future<Nothing> future;
+
+  synchronized (data->lock) {
+    if (data->writeEnd != Writer::OPEN || data->readEnd != Reader::OPEN) {
+      future = Failure("closed");
+    } else if (data->highWaterMark.isNone() ||
+               data->size < data->highWaterMark->bytes()) {
+      future = Nothing();
+    } else {
+      data->writables.push(Owned<Promise<Nothing>>(new Promise<Nothing>()));
+      future = data->writables.back()->future();
+    }
+  }
+
+  return future;
+}
+
+
+size_t Pipe::Writer::buffered() const
+{
+  size_t size = 0;
+
+  synchronized (data->lock) {
+    size = data->size;
+  }
+
+  return size;
+}
+
+
 namespace path {
 
 Try<hashmap<string, string>> parse(const string& pattern, const string& path)
@@ -1111,6 +1228,308 @@ Future<Connection> connect(const URL& url)
 }
 
 
+Future<Connection> connect(const Address& address)
+{
+  Try<Socket> socket =
+    Socket::create(Socket::POLL, None(), address.family());
+
+  if (socket.isError()) {
+    return Failure("Failed to create socket: " + socket.error());
+  }
+
+  return socket->connect(address)
+    .then([socket]() {
+      return Connection(socket.get());
+    });
+}
+
+
+namespace internal {
+
+// Continues copying the body of a streamed response from 'reader' to
+// 'writer' until end-of-file, or until the reader of 'writer' gets
+// closed.
+Future<Nothing> _forward(Pipe::Reader reader, Pipe::Writer writer)
+{
+  return reader.read()
+    .then([=](const string& data) mutable -> Future<Nothing> {
+      if (data.empty()) {
+        writer.close(); // End-of-file.
+        return Nothing();
+      }
+
+      if (!writer.write(data)) {
+        // Nobody is interested in the rest of the body, but we still
+        // need to read it before the next response can be read.
+        reader.readAll();
+        return Nothing();
+      }
+
+      return _forward(reader, writer);
+    });
+}
+
+
+class ConnectionPoolProcess : public Process<ConnectionPoolProcess>
+{
+public:
+  explicit ConnectionPoolProcess(const ConnectionPool::Options& _options)
+    : ProcessBase(ID::generate("__http_connection_pool__")),
+      options(_options),
+      nextId(0) {}
+
+  Future<Response> send(Request request, bool streamedResponse)
+  {
+    if (request.url.ip.isNone() && request.url.domain.isNone()) {
+      return Failure("Expected URL.ip or URL.domain to be set");
+    }
+
+    const string key = strings::join(
+        ":",
+        request.url.scheme.getOrElse("http"),
+        request.url.ip.isSome()
+          ? stringify(request.url.ip.get())
+          : request.url.domain.get(),
+        stringify(request.url.port.getOrElse(0)));
+
+    hashmap<uint64_t, Pooled>& server = servers[key];
+
+    // Pick the (open) connection with the fewest requests in flight.
+    Option<uint64_t> id;
+    size_t open = 0;
+    foreachpair (uint64_t id_, const Pooled& pooled, server) {
+      if (pooled.closing) {
+        continue;
+      }
+
+      open++;
+
+      if (id.isNone() || pooled.requests < server.at(id.get()).requests) {
+        id = id_;
+      }
+    }
+
+    if (id.isNone() ||
+        (server.at(id.get()).requests > 0 && open < options.maxConnections)) {
+      id = nextId++;
+
+      Future<Connection> connection = http::connect(request.url);
+
+      server.put(id.get(), Pooled(connection));
+
+      connection
+        .onAny(defer(self(), &Self::connected, key, id.get(), lambda::_1));
+    }
+
+    Pooled& pooled = server.at(id.get());
+    pooled.requests++;
+
+    // Unless asked to close the connection, keep it alive for the
+    // requests that follow.
+    if (!request.keepAlive &&
+        (!request.headers.contains("Connection") ||
+         request.headers.at("Connection") != "close")) {
+      request.keepAlive = true;
+    }
+
+    if (!request.keepAlive) {
+      // Don't send any more requests on this connection.
+      pooled.closing = true;
+    }
+
+    Future<Response> response = pooled.connection
+      .then([request, streamedResponse](Connection connection) {
+        return connection.send(request, streamedResponse);
+      });
+
+    if (!streamedResponse) {
+      response
+        .onAny(defer(self(), &Self::completed, key, id.get(), lambda::_1));
+
+      return response;
+    }
+
+    // The connection is busy until the body has been read in full,
+    // so we read the body, on behalf of the caller, into another
+    // pipe to find out when we're done.
+    const uint64_t id_ = id.get();
+
+    return response
+      .then(defer(self(), [=](Response response) {
+        CHECK_EQ(Response::PIPE, response.type);
+        CHECK_SOME(response.reader);
+
+        Pipe pipe;
+        Pipe::Writer writer = pipe.writer();
+
+        _forward(response.reader.get(), writer)
+          .onAny(defer(self(), [=](const Future<Nothing>& future) {
+            if (!future.isReady()) {
+              Pipe::Writer writer_ = writer;
+              writer_.fail(
+                  future.isFailed() ? future.failure() : "discarded");
+            }
+
+            completed(key, id_, response);
+          }));
+
+        response.reader = pipe.reader();
+        return response;
+      }))
+      .onFailed(defer(self(), [=](const string&) {
+        completed(key, id_, Failure("Failed to send the request"));
+      }));
+  }
+
+protected:
+  virtual void initialize()
+  {
+    delay(options.idleTimeout, self(), &Self::evict);
+  }
+
+private:
+  struct Pooled
+  {
+    explicit Pooled(const Future<Connection>& _connection)
+      : connection(_connection), requests(0), closing(false) {}
+
+    Future<Connection> connection;
+
+    // Number of requests in flight.
+    size_t requests;
+
+    // Whether the connection is closing (e.g., after a request or a
+    // response with 'Connection: close').
+    bool closing;
+
+    // When the last request in flight completed.
+    Time idle;
+  };
+
+  void connected(
+      const string& key,
+      uint64_t id,
+      const Future<Connection>& connection)
+  {
+    if (!connection.isReady()) {
+      remove(key, id);
+      return;
+    }
+
+    // NOTE: We don't capture the connection here, since we must not
+    // delete the last copy of the connection from within the
+    // connection's execution context.
+    Connection(connection.get()).disconnected()
+      .onAny(defer(self(), &Self::remove, key, id));
+  }
+
+  void completed(
+      const string& key,
+      uint64_t id,
+      const Future<Response>& response)
+  {
+    if (!servers.contains(key) || !servers[key].contains(id)) {
+      return; // Already disconnected.
+    }
+
+    Pooled& pooled = servers[key].at(id);
+
+    CHECK_GT(pooled.requests, 0u);
+    pooled.requests--;
+
+    if (!response.isReady() ||
+        (response->headers.contains("Connection") &&
+         response->headers.at("Connection") == "close")) {
+      pooled.closing = true;
+    }
+
+    if (pooled.requests == 0) {
+      pooled.idle = Clock::now();
+
+      if (pooled.closing) {
+        remove(key, id);
+      }
+    }
+  }
+
+  void remove(const string& key, uint64_t id)
+  {
+    if (servers.contains(key)) {
+      servers[key].erase(id);
+
+      if (servers[key].empty()) {
+        servers.erase(key);
+      }
+    }
+  }
+
+  // Closes the connections which have been idle for the idle timeout.
+  void evict()
+  {
+    const Time now = Clock::now();
+
+    foreach (const string& key, servers.keys()) {
+      foreach (uint64_t id, servers[key].keys()) {
+        const Pooled& pooled = servers[key].at(id);
+
+        if (pooled.requests == 0 && now - pooled.idle >= options.idleTimeout) {
+          if (pooled.connection.isReady()) {
+            Connection(pooled.connection.get()).disconnect();
+          }
+
+          remove(key, id);
+        }
+      }
+    }
+
+    delay(options.idleTimeout, self(), &Self::evict);
+  }
+
+  const ConnectionPool::Options options;
+
+  // The pooled connections of each server, by their id.
+  hashmap<string, hashmap<uint64_t, Pooled>> servers;
+
+  uint64_t nextId;
+};
+
+} // namespace internal {
+
+
+struct ConnectionPool::Data
+{
+  explicit Data(const ConnectionPool::Options& options)
+    : process(new internal::ConnectionPoolProcess(options))
+  {
+    spawn(process.get());
+  }
+
+  ~Data()
+  {
+    terminate(process.get());
+    wait(process.get());
+  }
+
+  Owned<internal::ConnectionPoolProcess> process;
+};
+
+
+ConnectionPool::ConnectionPool(const ConnectionPool::Options& options)
+  : data(std::make_shared<ConnectionPool::Data>(options)) {}
+
+
+Future<Response> ConnectionPool::send(
+    const Request& request,
+    bool streamedResponse) const
+{
+  return dispatch(
+      data->process.get(),
+      &internal::ConnectionPoolProcess::send,
+      request,
+      streamedResponse);
+}
+
+
 namespace internal {
 
 Future<Response> request(const Request& request, bool streamedResponse)
@@ -10,6 +10,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License
 
+#ifdef __linux__
+#include <fcntl.h>
+#endif // __linux__
+
+#include <sys/stat.h>
+
+#include <algorithm>
 #include <memory>
 #include <string>
 
@@ -359,8 +366,129 @@ void _splice(
 }
 
 
+#ifdef __linux__
+// The most data moved by a single splice(2), the default capacity of
+// a pipe.
+static const size_t SPLICE_SIZE = 65536;
+
+
+// The most splice(2) calls in a row before going back through the
+// event loop, so that a fast writer does not hog the thread.
+static const size_t SPLICES = 16;
+
+
+// Returns whether the file descriptor can be polled, i.e., it is not
+// a regular file (which is always ready).
+static bool pollable(int fd)
+{
+  struct stat s;
+  return ::fstat(fd, &s) != 0 || !S_ISREG(s.st_mode);
+}
+
+
+// Returns whether the file descriptor is a pipe.
+static bool isPipe(int fd)
+{
+  struct stat s;
+  return ::fstat(fd, &s) == 0 && S_ISFIFO(s.st_mode);
+}
+
+
+// Splices with splice(2), which moves the data out of or into a pipe
+// within the kernel rather than copying it into and out of a buffer
+// in user space, and without a read and a write per chunk. Falls back
+// to '_splice' (see below) if the kernel cannot splice between the
+// file descriptors, e.g., to a file opened with O_APPEND.
+void kernelSplice(
+    int from,
+    int to,
+    size_t chunk,
+    std::shared_ptr<Promise<Nothing>> promise)
+{
+  // Stop splicing if a discard occured on our future.
+  if (promise->future().hasDiscard()) {
+    promise->discard();
+    return;
+  }
+
+  ssize_t length = -1;
+
+  for (size_t splices = 0; splices < SPLICES; splices++) {
+    do {
+      length = ::splice(
+          from,
+          NULL,
+          to,
+          NULL,
+          std::max(chunk, SPLICE_SIZE),
+          SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    } while (length < 0 && errno == EINTR);
+
+    if (length <= 0) {
+      break;
+    }
+  }
+
+  if (length == 0) { // EOF.
+    promise->set(Nothing());
+    return;
+  }
+
+  if (length < 0 && errno == EINVAL) {
+    // Nothing has been spliced by this call, so the rest can still
+    // go through user space.
+    _splice(from, to, chunk, boost::shared_array<char>(new char[chunk]),
+            promise);
+    return;
+  }
+
+  if (length < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+    promise->fail(os::strerror(errno));
+    return;
+  }
+
+  // Either 'from' has no data or 'to' has no room (or we spliced a
+  // while), so wait for both before splicing again. Regular files are
+  // never waited for.
+  Future<short> ready = pollable(from)
+    ? io::poll(from, io::READ)
+    : Future<short>(io::READ);
+
+  ready = ready.then([=](short) -> Future<short> {
+    return pollable(to)
+      ? io::poll(to, io::WRITE)
+      : Future<short>(io::WRITE);
+  });
+
+  // Stop polling if a discard occurs on our future.
+  promise->future().onDiscard(
+      lambda::bind(&process::internal::discard<short>,
+                   WeakFuture<short>(ready)));
+
+  ready
+    .onReady([=]() { kernelSplice(from, to, chunk, promise); })
+    .onFailed([=](const string& message) { promise->fail(message); })
+    .onDiscarded([=]() { promise->discard(); });
+}
+#endif // __linux__
+
+
 Future<Nothing> splice(int from, int to, size_t chunk)
 {
+#ifdef __linux__
+  // The kernel can only splice out of or into a pipe, e.g., the
+  // output of a subprocess.
+  if (isPipe(from) || isPipe(to)) {
+    std::shared_ptr<Promise<Nothing>> promise(new Promise<Nothing>());
+
+    Future<Nothing> future = promise->future();
+
+    kernelSplice(from, to, chunk, promise);
+
+    return future;
+  }
+#endif // __linux__
+
   boost::shared_array<char> data(new char[chunk]);
 
   // Rather than having internal::_splice return a future and
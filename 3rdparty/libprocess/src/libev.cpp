@@ -143,6 +143,12 @@ void EventLoop::delay(
 }
 
 
+size_t EventLoop::count()
+{
+  return 1;
+}
+
+
 double EventLoop::time()
 {
   // TODO(benh): Versus ev_now()?
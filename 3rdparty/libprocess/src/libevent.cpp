@@ -160,6 +160,12 @@ void EventLoop::delay(
 }
 
 
+size_t EventLoop::count()
+{
+  return 1;
+}
+
+
 double EventLoop::time()
 {
   // We explicitly call `evutil_gettimeofday()` for now to avoid any
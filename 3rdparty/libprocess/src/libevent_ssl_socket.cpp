@@ -20,10 +20,14 @@
 #include <openssl/ssl.h>
 #include <openssl/err.h>
 
+#include <vector>
+
 #include <process/queue.hpp>
 #include <process/socket.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/net.hpp>
+#include <stout/stringify.hpp>
 #include <stout/synchronized.hpp>
 
 #include "libevent.hpp"
@@ -62,6 +66,7 @@
 
 using std::queue;
 using std::string;
+using std::vector;
 
 // Specialization of 'synchronize' to use bufferevent with the
 // 'synchronized' macro.
@@ -76,6 +81,25 @@ static Synchronized<bufferevent> synchronize(bufferevent* bev)
 namespace process {
 namespace network {
 
+LibeventSSLSocketImpl::Metrics& LibeventSSLSocketImpl::metrics()
+{
+  static Metrics* metrics = new Metrics();
+  return *metrics;
+}
+
+
+// Returns whether the kernel encrypts the records that are written
+// to the socket of the connected 'ssl', see 'SSL_ENABLE_KTLS'.
+static bool ktls(SSL* ssl)
+{
+#ifdef SSL_OP_ENABLE_KTLS
+  return BIO_get_ktls_send(SSL_get_wbio(ssl)) != 0;
+#else
+  return false;
+#endif // SSL_OP_ENABLE_KTLS
+}
+
+
 Try<std::shared_ptr<Socket::Impl>> LibeventSSLSocketImpl::create(int s)
 {
   openssl::initialize();
@@ -341,6 +365,7 @@ void LibeventSSLSocketImpl::event_callback(short events)
     }
 
     if (current_send_request.get() != NULL) {
+      drain();
       current_send_request->promise.set(0);
     }
 
@@ -349,6 +374,7 @@ void LibeventSSLSocketImpl::event_callback(short events)
       SSL_free(ssl);
       bufferevent_free(CHECK_NOTNULL(bev));
       bev = NULL;
+      forget();
       current_connect_request->promise.fail(
           "Failed connect: connection closed");
     }
@@ -372,10 +398,28 @@ void LibeventSSLSocketImpl::event_callback(short events)
       SSL_free(ssl);
       bufferevent_free(bev);
       bev = NULL;
+      forget();
       current_connect_request->promise.fail(verify.error());
       return;
     }
 
+    ++metrics().client_handshakes;
+
+    if (SSL_session_reused(ssl)) {
+      ++metrics().client_resumptions;
+    }
+
+    if (ktls(ssl)) {
+      ++metrics().ktls_connections;
+    }
+
+    // Cache the (possibly new) session so that the next connection
+    // to this peer can resume it.
+    if (peer_session.isSome()) {
+      openssl::remember(ssl, peer_session.get());
+    }
+
+    current_connect_request->handshake.set(Nothing());
     current_connect_request->promise.set(Nothing());
   } else if (events & BEV_EVENT_ERROR) {
     CHECK(EVUTIL_SOCKET_ERROR() != 0);
@@ -392,6 +436,7 @@ void LibeventSSLSocketImpl::event_callback(short events)
     }
 
     if (current_send_request.get() != NULL) {
+      drain();
       current_send_request->promise.fail(
           "Failed send, connection error: " +
           error_stream.str());
@@ -402,6 +447,7 @@ void LibeventSSLSocketImpl::event_callback(short events)
       SSL_free(ssl);
       bufferevent_free(CHECK_NOTNULL(bev));
       bev = NULL;
+      forget();
       current_connect_request->promise.fail(
           "Failed connect, connection error: " +
           error_stream.str());
@@ -410,6 +456,31 @@ void LibeventSSLSocketImpl::event_callback(short events)
 }
 
 
+// Only runs in event loop. See 'Locking' note at top of file.
+void LibeventSSLSocketImpl::drain()
+{
+  CHECK(__in_event_loop__);
+
+  // The output buffer references the data of the failed send request
+  // (see 'send'), which the caller may release once the request has
+  // completed, so make sure that we never write it afterwards.
+  if (bev != NULL) {
+    evbuffer* output = bufferevent_get_output(bev);
+    evbuffer_drain(output, evbuffer_get_length(output));
+  }
+}
+
+
+void LibeventSSLSocketImpl::forget()
+{
+  // Don't offer the session again if it might be what made the
+  // connection fail, e.g., since the peer has been reconfigured.
+  if (peer_session.isSome()) {
+    openssl::forget(peer_session.get());
+  }
+}
+
+
 LibeventSSLSocketImpl::LibeventSSLSocketImpl(int _s)
   : Socket::Impl(_s),
     bev(NULL),
@@ -451,6 +522,12 @@ Future<Nothing> LibeventSSLSocketImpl::connect(const Address& address)
     return Failure("Failed to connect: SSL_new");
   }
 
+  // Offer the session of the last connection to this peer (if any)
+  // to abbreviate the handshake, e.g., when all agents reconnect to a
+  // new leading master at once.
+  peer_session = stringify(address);
+  openssl::resume(ssl, peer_session.get());
+
   // Construct the bufferevent in the connecting state.
   // We set 'BEV_OPT_DEFER_CALLBACKS' to avoid calling the
   // 'event_callback' before 'bufferevent_socket_connect' returns.
@@ -484,6 +561,8 @@ Future<Nothing> LibeventSSLSocketImpl::connect(const Address& address)
   Owned<ConnectRequest> request(new ConnectRequest());
   Future<Nothing> future = request->promise.future();
 
+  metrics().client_handshake.time(request->handshake.future());
+
   // Assign 'connect_request' under lock, fail on error.
   synchronized (lock) {
     if (connect_request.get() != NULL) {
@@ -504,8 +583,7 @@ Future<Nothing> LibeventSSLSocketImpl::connect(const Address& address)
 
   run_in_event_loop(
       [self, address]() {
-        sockaddr_storage addr =
-          net::createSockaddrStorage(address.ip, address.port);
+        sockaddr_storage addr = address.storage();
 
           // Assign the callbacks for the bufferevent. We do this
           // before the 'bufferevent_socket_connect()' call to avoid
@@ -683,7 +761,89 @@ Future<size_t> LibeventSSLSocketImpl::send(const char* data, size_t size)
           CHECK_NOTNULL(self->send_request.get());
         }
 
-        bufferevent_write(self->bev, data, size);
+        // We add the data by reference rather than copying it into
+        // the output buffer since the caller keeps it around until
+        // the request completes, which happens once the output buffer
+        // has been drained (see 'send_callback' and 'drain').
+        evbuffer_add_reference(
+            bufferevent_get_output(self->bev),
+            data,
+            size,
+            NULL,
+            NULL);
+      },
+      DISALLOW_SHORT_CIRCUIT);
+
+  return future;
+}
+
+
+Future<size_t> LibeventSSLSocketImpl::send(const struct iovec* iov, int iovcnt)
+{
+  // Copy the array, only the buffers need to remain valid.
+  vector<struct iovec> buffers;
+  size_t size = 0;
+
+  for (int i = 0; i < iovcnt; i++) {
+    if (iov[i].iov_len > 0) {
+      buffers.push_back(iov[i]);
+      size += iov[i].iov_len;
+    }
+  }
+
+  if (buffers.empty()) {
+    return Failure("No data to send");
+  }
+
+  // Optimistically construct a 'SendRequest' and future.
+  Owned<SendRequest> request(new SendRequest(size));
+  Future<size_t> future = request->promise.future();
+
+  // See 'send' above for why we don't support discarding.
+
+  // Assign 'send_request' under lock, fail on error.
+  synchronized (lock) {
+    if (send_request.get() != NULL) {
+      return Failure("Socket is already sending");
+    }
+    std::swap(request, send_request);
+  }
+
+  // Extend the life-time of 'this' through the execution of the
+  // lambda in the event loop. Note: The 'self' needs to be explicitly
+  // captured because we're not using it in the body of the lambda. We
+  // can use a 'shared_ptr' because run_in_event_loop is guaranteed to
+  // execute.
+  auto self = shared(this);
+
+  run_in_event_loop(
+      [self, buffers]() {
+        CHECK(__in_event_loop__);
+        CHECK(self);
+
+        // We check that send_request is valid, because we do not
+        // allow discards. This means there is no race between the
+        // entry of 'send' and the execution of this lambda.
+        synchronized (self->lock) {
+          CHECK_NOTNULL(self->send_request.get());
+        }
+
+        // Add all of the buffers by reference (see 'send' above)
+        // while holding the lock of the bufferevent so that they get
+        // encrypted into as few records as possible and the request
+        // completes only once all of them have been written.
+        synchronized (self->bev) {
+          evbuffer* output = bufferevent_get_output(self->bev);
+
+          foreach (const struct iovec& buffer, buffers) {
+            evbuffer_add_reference(
+                output,
+                buffer.iov_base,
+                buffer.iov_len,
+                NULL,
+                NULL);
+          }
+        }
       },
       DISALLOW_SHORT_CIRCUIT);
 
@@ -727,11 +887,45 @@ Future<size_t> LibeventSSLSocketImpl::sendfile(
           CHECK_NOTNULL(self->send_request.get());
         }
 
-        evbuffer_add_file(
-            bufferevent_get_output(self->bev),
-            fd,
-            offset,
-            size);
+        synchronized (self->bev) {
+          evbuffer* output = bufferevent_get_output(self->bev);
+
+          // With kTLS the kernel encrypts the file as it sends it, so
+          // rather than copying it through the output buffer we let
+          // the kernel send as much of it as the socket takes right
+          // away. We only do so when nothing is queued in front of it.
+          size_t sent = 0;
+
+#ifdef SSL_OP_ENABLE_KTLS
+          SSL* ssl = bufferevent_openssl_get_ssl(self->bev);
+
+          if (evbuffer_get_length(output) == 0 && ktls(ssl)) {
+            ossl_ssize_t result = SSL_sendfile(ssl, fd, offset, size, 0);
+
+            if (result > 0) {
+              sent = result;
+            } else {
+              // Leave it to the output buffer to retry, or to surface
+              // the error, rather than leaving ours in the error queue
+              // that libevent checks after its own calls.
+              ERR_clear_error();
+            }
+          }
+#endif // SSL_OP_ENABLE_KTLS
+
+          if (sent == size) {
+            Owned<SendRequest> request;
+
+            synchronized (self->lock) {
+              std::swap(request, self->send_request);
+            }
+
+            request->promise.set(request->size);
+            return;
+          }
+
+          evbuffer_add_file(output, fd, offset + sent, size - sent);
+        }
       },
       DISALLOW_SHORT_CIRCUIT);
 
@@ -910,6 +1104,8 @@ void LibeventSSLSocketImpl::accept_SSL_callback(AcceptRequest* request)
     return;
   }
 
+  metrics().server_handshake.time(request->handshake.future());
+
   // We use 'request->listener' because 'this->listener' may not have
   // been set by the time this function is executed. See comment in
   // the lambda for evconnlistener_new in
@@ -985,6 +1181,18 @@ void LibeventSSLSocketImpl::accept_SSL_callback(AcceptRequest* request)
             return;
           }
 
+          ++metrics().server_handshakes;
+
+          if (SSL_session_reused(ssl)) {
+            ++metrics().server_resumptions;
+          }
+
+          if (ktls(ssl)) {
+            ++metrics().ktls_connections;
+          }
+
+          request->handshake.set(Nothing());
+
           auto impl = std::shared_ptr<LibeventSSLSocketImpl>(
               new LibeventSSLSocketImpl(
                   request->socket,
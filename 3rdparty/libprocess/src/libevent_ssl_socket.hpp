@@ -25,6 +25,11 @@
 #include <process/queue.hpp>
 #include <process/socket.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/timer.hpp>
+
+#include <stout/duration.hpp>
+
 namespace process {
 namespace network {
 
@@ -43,6 +48,7 @@ public:
   virtual Future<size_t> recv(char* data, size_t size);
   // Send does not currently support discard. See implementation.
   virtual Future<size_t> send(const char* data, size_t size);
+  virtual Future<size_t> send(const struct iovec* iov, int iovcnt);
   virtual Future<size_t> sendfile(int fd, off_t offset, size_t size);
   virtual Try<Nothing> listen(int backlog);
   virtual Future<Socket> accept();
@@ -57,6 +63,40 @@ public:
   // valid until the constructor has finished.
   void initialize();
 
+  // Metrics of the SSL handshakes of all sockets, which get added
+  // when initializing libprocess. The resumption hit rate is the
+  // number of resumptions divided by the number of handshakes.
+  struct Metrics
+  {
+    Metrics()
+      : client_handshake("ssl_socket/client_handshake"),
+        server_handshake("ssl_socket/server_handshake"),
+        client_handshakes("ssl_socket/client_handshakes"),
+        server_handshakes("ssl_socket/server_handshakes"),
+        client_resumptions("ssl_socket/client_resumptions"),
+        server_resumptions("ssl_socket/server_resumptions"),
+        ktls_connections("ssl_socket/ktls_connections") {}
+
+    // Duration of the successful handshakes of connecting (including
+    // establishing the TCP connection) and of accepted sockets.
+    process::metrics::Timer<Milliseconds> client_handshake;
+    process::metrics::Timer<Milliseconds> server_handshake;
+
+    // Number of successful handshakes.
+    process::metrics::Counter client_handshakes;
+    process::metrics::Counter server_handshakes;
+
+    // Number of successful handshakes that resumed a session.
+    process::metrics::Counter client_resumptions;
+    process::metrics::Counter server_resumptions;
+
+    // Number of successful handshakes after which the kernel encrypts
+    // the records that we send, see 'SSL_ENABLE_KTLS'.
+    process::metrics::Counter ktls_connections;
+  };
+
+  static Metrics& metrics();
+
 private:
   // A set of helper functions that transitions an accepted socket to
   // an SSL connected socket. With the libevent-openssl library, once
@@ -75,6 +115,8 @@ private:
         ip(_ip) {}
     event* peek_event;
     Promise<Socket> promise;
+    // Only gets set for established connections, see 'Metrics'.
+    Promise<Nothing> handshake;
     evconnlistener* listener;
     int socket;
     Option<net::IP> ip;
@@ -100,6 +142,8 @@ private:
   struct ConnectRequest
   {
     Promise<Nothing> promise;
+    // Only gets set for established connections, see 'Metrics'.
+    Promise<Nothing> handshake;
   };
 
   // This is a private constructor used by the accept helper
@@ -139,6 +183,13 @@ private:
   static void event_callback(bufferevent* bev, short events, void* arg);
   void event_callback(short events);
 
+  // Discards the data that has not been written yet when failing a
+  // send request.
+  void drain();
+
+  // Drops the cached session of the peer when failing to connect.
+  void forget();
+
   bufferevent* bev;
 
   evconnlistener* listener;
@@ -178,6 +229,10 @@ private:
   Queue<Future<Socket>> accept_queue;
 
   Option<std::string> peer_hostname;
+
+  // The address of the peer of a connecting socket, under which its
+  // session gets cached for resumption, see 'openssl::resume'.
+  Option<std::string> peer_session;
 };
 
 } // namespace network {
@@ -0,0 +1,373 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESS_MAILBOX_METRICS_HPP__
+#define __PROCESS_MAILBOX_METRICS_HPP__
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <process/defer.hpp>
+#include <process/event.hpp>
+#include <process/future.hpp>
+#include <process/pid.hpp>
+
+#include <process/metrics/gauge.hpp>
+
+#include <stout/json.hpp>
+#include <stout/option.hpp>
+
+namespace process {
+
+// A histogram of durations (in nanoseconds) which can be recorded to
+// and read from any number of threads without locking.
+//
+// Durations are bucketed by their most significant bit and the two
+// bits after it, so a percentile is accurate to within 25% of its
+// value, which is plenty to tell whether events wait for microseconds
+// or for seconds.
+class Histogram
+{
+public:
+  Histogram() : count_(0), max_(0)
+  {
+    for (int i = 0; i < BUCKETS; i++) {
+      buckets[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  void record(int64_t nanoseconds)
+  {
+    const uint64_t value = nanoseconds > 0 ? nanoseconds : 0;
+
+    buckets[bucket(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (value > max &&
+           !max_.compare_exchange_weak(max, value, std::memory_order_relaxed));
+  }
+
+  uint64_t count() const
+  {
+    return count_.load(std::memory_order_relaxed);
+  }
+
+  // Returns the maximum recorded duration, in nanoseconds.
+  uint64_t max() const
+  {
+    return max_.load(std::memory_order_relaxed);
+  }
+
+  // Returns the upper bound (in nanoseconds) of the bucket containing
+  // the specified percentile (in [0, 1]), or None if nothing has been
+  // recorded. Since the buckets are read while others might be
+  // recording, this is only approximate.
+  Option<uint64_t> percentile(double percentile) const
+  {
+    uint64_t total = 0;
+    uint64_t counts[BUCKETS];
+
+    for (int i = 0; i < BUCKETS; i++) {
+      counts[i] = buckets[i].load(std::memory_order_relaxed);
+      total += counts[i];
+    }
+
+    if (total == 0) {
+      return None();
+    }
+
+    // The rank of the percentile, at least 1 so that we never pick
+    // an empty bucket.
+    uint64_t rank = static_cast<uint64_t>(percentile * total + 0.5);
+    if (rank == 0) {
+      rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+      seen += counts[i];
+      if (seen >= rank) {
+        // Don't exceed the actual maximum for the highest bucket.
+        return std::min(upper(i), max());
+      }
+    }
+
+    return max();
+  }
+
+  // Returns the count, maximum, and the 50th, 90th, and 99th
+  // percentiles (in milliseconds).
+  JSON::Object json() const
+  {
+    JSON::Object object;
+    object.values["count"] = count();
+
+    const std::string names[] = {"p50", "p90", "p99"};
+    const double percentiles[] = {0.5, 0.9, 0.99};
+
+    for (int i = 0; i < 3; i++) {
+      Option<uint64_t> value = percentile(percentiles[i]);
+      if (value.isSome()) {
+        object.values[names[i]] = milliseconds(value.get());
+      }
+    }
+
+    if (count() > 0) {
+      object.values["max"] = milliseconds(max());
+    }
+
+    return object;
+  }
+
+  static double milliseconds(uint64_t nanoseconds)
+  {
+    return nanoseconds / 1000000.0;
+  }
+
+private:
+  // Number of bits after the most significant bit used to bucket.
+  static const int SUB_BITS = 2;
+  static const int SUB_BUCKETS = 1 << SUB_BITS;
+  static const int BUCKETS = 64 * SUB_BUCKETS;
+
+  static int bucket(uint64_t value)
+  {
+    if (value < SUB_BUCKETS) {
+      return static_cast<int>(value);
+    }
+
+    const int msb = 63 - __builtin_clzll(value);
+    const int sub = (value >> (msb - SUB_BITS)) & (SUB_BUCKETS - 1);
+
+    return (msb - SUB_BITS + 1) * SUB_BUCKETS + sub;
+  }
+
+  // Returns the largest value that falls into the bucket.
+  static uint64_t upper(int bucket)
+  {
+    if (bucket < SUB_BUCKETS) {
+      return bucket;
+    }
+
+    const int msb = bucket / SUB_BUCKETS + SUB_BITS - 1;
+    const uint64_t sub = bucket % SUB_BUCKETS;
+
+    const uint64_t lower =
+      (UINT64_C(1) << msb) | (sub << (msb - SUB_BITS));
+
+    return lower + (UINT64_C(1) << (msb - SUB_BITS)) - 1;
+  }
+
+  Histogram(const Histogram&) = delete;
+  Histogram& operator=(const Histogram&) = delete;
+
+  std::atomic<uint64_t> buckets[BUCKETS];
+  std::atomic<uint64_t> count_;
+  std::atomic<uint64_t> max_;
+};
+
+
+// Instrumentation of the event queue (i.e., the "mailbox") of a
+// process that was spawned with 'SpawnOptions::mailboxMetrics': the
+// number of queued events, how long events wait to get dequeued, and
+// how long it takes to serve each type of event. Everything can be
+// read without synchronizing with the process (or its event queue).
+class MailboxMetrics
+{
+public:
+  MailboxMetrics() : depth(0) {}
+
+  // Returns a monotonic time (in nanoseconds) for timing events.
+  static int64_t now()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  // Records the time it took to serve the event.
+  void served(const Event& event, int64_t nanoseconds)
+  {
+    struct ServedVisitor : EventVisitor
+    {
+      explicit ServedVisitor(MailboxMetrics* _metrics)
+        : metrics(_metrics), histogram(NULL) {}
+
+      virtual void visit(const MessageEvent&)
+      {
+        histogram = &metrics->message;
+      }
+
+      virtual void visit(const DispatchEvent&)
+      {
+        histogram = &metrics->dispatch;
+      }
+
+      virtual void visit(const HttpEvent&)
+      {
+        histogram = &metrics->http;
+      }
+
+      MailboxMetrics* metrics;
+      Histogram* histogram;
+    } visitor(this);
+
+    event.visit(&visitor);
+
+    if (visitor.histogram != NULL) {
+      visitor.histogram->record(nanoseconds);
+    }
+  }
+
+  JSON::Object json() const
+  {
+    JSON::Object service;
+    service.values["message"] = message.json();
+    service.values["dispatch"] = dispatch.json();
+    service.values["http"] = http.json();
+
+    JSON::Object object;
+    object.values["depth"] = depth.load(std::memory_order_relaxed);
+    object.values["latency_ms"] = latency.json();
+    object.values["service_time_ms"] = service;
+
+    return object;
+  }
+
+  // Returns the gauges which export these metrics with the specified
+  // prefix. The gauges get evaluated by the process 'pid' (rather
+  // than the instrumented process so that collecting the metrics does
+  // not interfere with the process) and fail once 'mailbox' has been
+  // deleted.
+  static std::vector<metrics::Gauge> createGauges(
+      const std::string& prefix,
+      const std::weak_ptr<MailboxMetrics>& mailbox,
+      const UPID& pid)
+  {
+    std::vector<metrics::Gauge> gauges;
+
+    gauges.push_back(metrics::Gauge(
+        prefix + "depth",
+        defer(pid, [mailbox]() -> Future<double> {
+          std::shared_ptr<MailboxMetrics> shared = mailbox.lock();
+          if (!shared) {
+            return Failure("Process has terminated");
+          }
+          return shared->depth.load(std::memory_order_relaxed);
+        })));
+
+    add(&gauges, prefix + "latency_ms", mailbox, &MailboxMetrics::latency, pid);
+
+    add(&gauges,
+        prefix + "service_time_ms/message",
+        mailbox,
+        &MailboxMetrics::message,
+        pid);
+
+    add(&gauges,
+        prefix + "service_time_ms/dispatch",
+        mailbox,
+        &MailboxMetrics::dispatch,
+        pid);
+
+    add(&gauges,
+        prefix + "service_time_ms/http",
+        mailbox,
+        &MailboxMetrics::http,
+        pid);
+
+    return gauges;
+  }
+
+  // Number of events on the event queue (see EventQueue).
+  std::atomic_long depth;
+
+  // Time between enqueueing and dequeueing an event.
+  Histogram latency;
+
+  // Time it takes to serve each type of event.
+  Histogram message;
+  Histogram dispatch;
+  Histogram http;
+
+  // The gauges exporting these metrics, if any (see 'createGauges').
+  std::vector<metrics::Gauge> gauges;
+
+private:
+  // Adds the gauges of the histogram: the count, the maximum, and the
+  // 50th, 90th, and 99th percentiles.
+  static void add(
+      std::vector<metrics::Gauge>* gauges,
+      const std::string& name,
+      const std::weak_ptr<MailboxMetrics>& mailbox,
+      Histogram MailboxMetrics::*histogram,
+      const UPID& pid)
+  {
+    gauges->push_back(metrics::Gauge(
+        name + "/count",
+        defer(pid, [=]() -> Future<double> {
+          std::shared_ptr<MailboxMetrics> shared = mailbox.lock();
+          if (!shared) {
+            return Failure("Process has terminated");
+          }
+          return (shared.get()->*histogram).count();
+        })));
+
+    gauges->push_back(metrics::Gauge(
+        name + "/max",
+        defer(pid, [=]() -> Future<double> {
+          std::shared_ptr<MailboxMetrics> shared = mailbox.lock();
+          if (!shared) {
+            return Failure("Process has terminated");
+          }
+          return Histogram::milliseconds((shared.get()->*histogram).max());
+        })));
+
+    const std::string names[] = {"p50", "p90", "p99"};
+    const double percentiles[] = {0.5, 0.9, 0.99};
+
+    for (int i = 0; i < 3; i++) {
+      const double percentile = percentiles[i];
+
+      gauges->push_back(metrics::Gauge(
+          name + "/" + names[i],
+          defer(pid, [=]() -> Future<double> {
+            std::shared_ptr<MailboxMetrics> shared = mailbox.lock();
+            if (!shared) {
+              return Failure("Process has terminated");
+            }
+
+            Option<uint64_t> value =
+              (shared.get()->*histogram).percentile(percentile);
+
+            if (value.isNone()) {
+              return Failure("No events");
+            }
+
+            return Histogram::milliseconds(value.get());
+          })));
+    }
+  }
+
+  MailboxMetrics(const MailboxMetrics&) = delete;
+  MailboxMetrics& operator=(const MailboxMetrics&) = delete;
+};
+
+} // namespace process {
+
+#endif // __PROCESS_MAILBOX_METRICS_HPP__
@@ -12,8 +12,15 @@
 
 #include <glog/logging.h>
 
+#include <ctype.h>
+
+#include <algorithm>
+#include <cmath>
 #include <list>
+#include <map>
+#include <sstream>
 #include <string>
+#include <vector>
 
 #include <process/collect.hpp>
 #include <process/dispatch.hpp>
@@ -25,9 +32,13 @@
 
 #include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/json.hpp>
 
 using std::list;
+using std::map;
+using std::ostringstream;
 using std::string;
+using std::vector;
 
 namespace process {
 namespace metrics {
@@ -59,6 +70,7 @@ MetricsProcess* MetricsProcess::instance()
 void MetricsProcess::initialize()
 {
   route("/snapshot", help(), &MetricsProcess::snapshot);
+  route("/prometheus", prometheusHelp(), &MetricsProcess::prometheus);
 }
 
 
@@ -78,6 +90,27 @@ string MetricsProcess::help()
 }
 
 
+string MetricsProcess::prometheusHelp()
+{
+  return HELP(
+      TLDR("Provides a snapshot of the current metrics for Prometheus."),
+      DESCRIPTION(
+          "This endpoint provides the same metrics as '/metrics/snapshot' ",
+          "in the Prometheus text exposition format. A metric is exposed ",
+          "as a metric family named after the metric, with any characters ",
+          "other than letters, digits, '_' and ':' replaced by '_', unless ",
+          "it is labeled as a member of a family (e.g., one family with a ",
+          "'principal' label rather than one metric per principal).",
+          "",
+          "The percentiles of metrics that keep a history are exposed as ",
+          "summaries named after the family with a '_window' suffix.",
+          "",
+          "The optional query parameter 'timeout' determines the maximum ",
+          "amount of time the endpoint will take to respond. If the timeout ",
+          "is exceeded, some metrics may not be included in the response."));
+}
+
+
 Future<Nothing> MetricsProcess::add(Owned<Metric> metric)
 {
   if (metrics.contains(metric->name())) {
@@ -104,11 +137,21 @@ Future<Nothing> MetricsProcess::remove(const std::string& name)
 Future<http::Response> MetricsProcess::snapshot(const http::Request& request)
 {
   return limiter.acquire()
-    .then(defer(self(), &Self::_snapshot, request));
+    .then(defer(self(), &Self::_snapshot, request, SNAPSHOT));
 }
 
 
-Future<http::Response> MetricsProcess::_snapshot(const http::Request& request)
+Future<http::Response> MetricsProcess::prometheus(
+    const http::Request& request)
+{
+  return limiter.acquire()
+    .then(defer(self(), &Self::_snapshot, request, PROMETHEUS));
+}
+
+
+Future<http::Response> MetricsProcess::_snapshot(
+    const http::Request& request,
+    Format format)
 {
   // Parse the 'timeout' parameter.
   Option<Duration> timeout;
@@ -129,29 +172,52 @@ Future<http::Response> MetricsProcess::_snapshot(const http::Request& request)
   hashmap<string, Future<double> > futures;
   hashmap<string, Option<Statistics<double> > > statistics;
 
+  // The values are awaited as a vector since there can be thousands
+  // of metrics.
+  vector<Future<double> > values_;
+  values_.reserve(metrics.size());
+
   foreachkey (const string& metric, metrics) {
     CHECK_NOTNULL(metrics[metric].get());
     futures[metric] = metrics[metric]->value();
+    values_.push_back(futures[metric]);
     // TODO(dhamon): It would be nice to compute these asynchronously.
     statistics[metric] = metrics[metric]->statistics();
   }
 
+  Future<vector<Future<double> > > values = await(values_);
+
   if (timeout.isSome()) {
-    return await(futures.values())
-      .after(timeout.get(), lambda::bind(_snapshotTimeout, futures.values()))
-      .then(lambda::bind(__snapshot, request, timeout, futures, statistics));
-  } else {
-    return await(futures.values())
+    values = values
+      .after(timeout.get(), lambda::bind(_snapshotTimeout, values_));
+  }
+
+  if (format == SNAPSHOT) {
+    return values
       .then(lambda::bind(__snapshot, request, timeout, futures, statistics));
   }
+
+  CHECK_EQ(PROMETHEUS, format);
+
+  hashmap<string, string> families;
+  hashmap<string, Metric::Labels> labels;
+
+  foreachpair (const string& metric, const Owned<Metric>& owned, metrics) {
+    families[metric] = owned->family().getOrElse(metric);
+    labels[metric] = owned->labels();
+  }
+
+  return values
+    .then(lambda::bind(
+        __prometheus, timeout, futures, statistics, families, labels));
 }
 
 
-list<Future<double> > MetricsProcess::_snapshotTimeout(
-    const list<Future<double> >& futures)
+vector<Future<double> > MetricsProcess::_snapshotTimeout(
+    const vector<Future<double> >& futures)
 {
   // Stop waiting for all futures to transition and return a 'ready'
-  // list to proceed handling the request.
+  // vector to proceed handling the request.
   return futures;
 }
 
@@ -193,6 +259,170 @@ Future<http::Response> MetricsProcess::__snapshot(
   return http::OK(object, request.url.query.get("jsonp"));
 }
 
+
+// Returns the name of a metric family as Prometheus allows it, i.e.,
+// '[a-zA-Z_:][a-zA-Z0-9_:]*'.
+static string sanitize(const string& family)
+{
+  string result = family;
+
+  foreach (char& c, result) {
+    if (!isalnum(c) && c != '_' && c != ':') {
+      c = '_';
+    }
+  }
+
+  if (result.empty() || isdigit(result[0])) {
+    result = "_" + result;
+  }
+
+  return result;
+}
+
+
+// Returns the labels of a sample, with the 'quantile' label of a
+// summary if any, in the Prometheus format, e.g., '{principal="foo"}'.
+static string format(
+    const Metric::Labels& labels,
+    const Option<string>& quantile = None())
+{
+  Metric::Labels all = labels;
+
+  if (quantile.isSome()) {
+    all["quantile"] = quantile.get();
+  }
+
+  if (all.empty()) {
+    return "";
+  }
+
+  string result = "{";
+
+  foreachpair (const string& key, const string& value, all) {
+    if (result.size() > 1) {
+      result += ",";
+    }
+
+    result += sanitize(key) + "=\"";
+
+    foreach (char c, value) {
+      switch (c) {
+        case '\\': result += "\\\\"; break;
+        case '"':  result += "\\\""; break;
+        case '\n': result += "\\n"; break;
+        default:   result += c; break;
+      }
+    }
+
+    result += "\"";
+  }
+
+  return result + "}";
+}
+
+
+// Returns a sample value in the Prometheus format.
+static string format(double value)
+{
+  if (std::isnan(value)) {
+    return "NaN";
+  } else if (std::isinf(value)) {
+    return value > 0 ? "+Inf" : "-Inf";
+  }
+
+  return JSON::internal::format(value);
+}
+
+
+Future<http::Response> MetricsProcess::__prometheus(
+    const Option<Duration>& timeout,
+    const hashmap<string, Future<double> >& metrics,
+    const hashmap<string, Option<Statistics<double> > >& statistics,
+    const hashmap<string, string>& families,
+    const hashmap<string, Metric::Labels>& labels)
+{
+  // The samples of a family must be output together, so we group
+  // the metrics by family, in order.
+  map<string, vector<string> > members;
+
+  foreachpair (const string& metric, const string& family, families) {
+    members[sanitize(family)].push_back(metric);
+  }
+
+  foreachvalue (vector<string>& keys, members) {
+    std::sort(keys.begin(), keys.end());
+  }
+
+  // We write the text directly rather than building (and then
+  // serializing) a tree of all of the metrics first.
+  ostringstream out;
+
+  foreachpair (const string& family, const vector<string>& keys, members) {
+    out << "# TYPE " << family << " untyped\n";
+
+    foreach (const string& key, keys) {
+      const Future<double>& value = metrics.get(key).get();
+
+      if (value.isPending()) {
+        CHECK_SOME(timeout);
+        VLOG(1) << "Exceeded timeout of " << timeout.get() << " when "
+                << "attempting to get metric '" << key << "'";
+      } else if (value.isReady()) {
+        out << family << format(labels.get(key).get()) << " "
+            << format(value.get()) << "\n";
+      }
+    }
+  }
+
+  // The percentiles of the metrics with a history are separate
+  // families, since a family can only be of one type.
+  const double quantiles[] = {0.5, 0.9, 0.95, 0.99, 0.999, 0.9999};
+
+  foreachpair (const string& family, const vector<string>& keys, members) {
+    bool first = true;
+
+    foreach (const string& key, keys) {
+      const Option<Statistics<double> >& statistics_ =
+        statistics.get(key).get();
+
+      if (statistics_.isNone()) {
+        continue;
+      }
+
+      const string summary = family + "_window";
+
+      if (first) {
+        out << "# TYPE " << summary << " summary\n";
+        first = false;
+      }
+
+      const Metric::Labels& labels_ = labels.get(key).get();
+      const Statistics<double>& s = statistics_.get();
+
+      const double values[] = {s.p50, s.p90, s.p95, s.p99, s.p999, s.p9999};
+
+      out << summary << format(labels_, string("0"))
+          << " " << format(s.min) << "\n";
+
+      for (size_t i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); i++) {
+        out << summary << format(labels_, format(quantiles[i]))
+            << " " << format(values[i]) << "\n";
+      }
+
+      out << summary << format(labels_, string("1"))
+          << " " << format(s.max) << "\n";
+
+      out << summary << "_count" << format(labels_) << " "
+          << s.count << "\n";
+    }
+  }
+
+  http::OK response(out.str());
+  response.headers["Content-Type"] = "text/plain; version=0.0.4";
+
+  return response;
+}
+
 }  // namespace internal {
 }  // namespace metrics {
 }  // namespace process {
@@ -26,6 +26,9 @@
 #include <process/once.hpp>
 
 #include <stout/flags.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/synchronized.hpp>
 
 using std::ostringstream;
 using std::string;
@@ -47,6 +50,14 @@ namespace openssl {
 static SSL_CTX* ctx = NULL;
 
 
+// The sessions of connecting sockets by peer, see 'resume'. OpenSSL
+// only caches sessions for accepted sockets by itself (it has no
+// notion of which peer a connecting socket is connecting to).
+static std::mutex* sessions_mutex = new std::mutex();
+static hashmap<string, SSL_SESSION*>* sessions =
+  new hashmap<string, SSL_SESSION*>();
+
+
 Flags::Flags()
 {
   add(&Flags::enabled,
@@ -127,6 +138,29 @@ Flags::Flags()
       "enable_tls_v1_2",
       "Enable SSLV1.2.",
       true);
+
+  add(&Flags::session_cache,
+      "session_cache",
+      "Whether to resume SSL sessions, i.e., to abbreviate the handshake "
+      "of a connection to a peer that we have connected to before (using "
+      "session ids or session tickets). When this is enabled, accepted "
+      "sockets resume the sessions they have issued, and connecting "
+      "sockets offer the last session to the peer.",
+      true);
+
+  add(&Flags::session_cache_size,
+      "session_cache_size",
+      "Maximum number of sessions that are cached for resumption, for "
+      "accepted and for connecting sockets each.",
+      1024);
+
+  add(&Flags::enable_ktls,
+      "enable_ktls",
+      "Whether to offload the encryption of the records to the kernel "
+      "(kTLS) once the handshake has completed, if both OpenSSL and the "
+      "kernel support it for the negotiated cipher. Files are then sent "
+      "without copying them through the process.",
+      false);
 }
 
 
@@ -339,12 +373,31 @@ void reinitialize()
   CHECK(ctx) << "Failed to create SSL context: "
              << ERR_error_string(ERR_get_error(), NULL);
 
-  // Disable SSL session caching.
-  SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+  // Drop the sessions of the previous SSL context, if any, since they
+  // were negotiated with the previous settings.
+  synchronized (sessions_mutex) {
+    foreachvalue (SSL_SESSION* session, *sessions) {
+      SSL_SESSION_free(session);
+    }
+    sessions->clear();
+  }
+
+  if (ssl_flags->session_cache) {
+    // Let OpenSSL cache the sessions of accepted sockets, the
+    // sessions of connecting sockets get cached by 'remember'. We
+    // also keep session tickets enabled (the OpenSSL default) so
+    // that peers supporting them don't need a server side lookup.
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(ctx, ssl_flags->session_cache_size);
+  } else {
+    // Disable SSL session caching.
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+  }
 
-  // Set a session id to avoid connection termination upon
-  // re-connect. We can use something more relevant when we care
-  // about session caching.
+  // Set a session id context, which is required for resuming
+  // sessions of accepted sockets when verifying peer certificates.
+  // Sessions are only shared within the same (global) context, so a
+  // constant suffices.
   const uint64_t session_ctx = 7;
 
   const unsigned char* session_id =
@@ -511,6 +564,20 @@ void reinitialize()
   // Disable TLSv1.2.
   if (!ssl_flags->enable_tls_v1_2) { ssl_options |= SSL_OP_NO_TLSv1_2; }
 
+  // Disable session tickets if we don't resume sessions.
+  if (!ssl_flags->session_cache) { ssl_options |= SSL_OP_NO_TICKET; }
+
+  // Let OpenSSL hand the session keys to the kernel after the
+  // handshake. It silently keeps encrypting in user space if the
+  // kernel does not support the negotiated cipher.
+  if (ssl_flags->enable_ktls) {
+#ifdef SSL_OP_ENABLE_KTLS
+    ssl_options |= SSL_OP_ENABLE_KTLS;
+#else
+    LOG(WARNING) << "Kernel TLS is not supported by this version of OpenSSL";
+#endif // SSL_OP_ENABLE_KTLS
+  }
+
   SSL_CTX_set_options(ctx, ssl_options);
 }
 
@@ -538,6 +605,65 @@ SSL_CTX* context()
 }
 
 
+bool resume(SSL* ssl, const string& peer)
+{
+  if (!ssl_flags->session_cache) {
+    return false;
+  }
+
+  synchronized (sessions_mutex) {
+    Option<SSL_SESSION*> session = sessions->get(peer);
+    if (session.isSome()) {
+      // NOTE: 'SSL_set_session' takes its own reference.
+      return SSL_set_session(ssl, session.get()) == 1;
+    }
+  }
+
+  return false;
+}
+
+
+void remember(SSL* ssl, const string& peer)
+{
+  if (!ssl_flags->session_cache) {
+    return;
+  }
+
+  SSL_SESSION* session = SSL_get1_session(ssl);
+  if (session == NULL) {
+    return;
+  }
+
+  synchronized (sessions_mutex) {
+    Option<SSL_SESSION*> previous = sessions->get(peer);
+    if (previous.isSome()) {
+      SSL_SESSION_free(previous.get());
+      sessions->erase(peer);
+    } else if (sessions->size() >= ssl_flags->session_cache_size &&
+               !sessions->empty()) {
+      // Evict an arbitrary session, which is sufficient to bound the
+      // cache since peers are expected to be long lived.
+      SSL_SESSION_free(sessions->begin()->second);
+      sessions->erase(sessions->begin());
+    }
+
+    sessions->put(peer, session);
+  }
+}
+
+
+void forget(const string& peer)
+{
+  synchronized (sessions_mutex) {
+    Option<SSL_SESSION*> session = sessions->get(peer);
+    if (session.isSome()) {
+      SSL_SESSION_free(session.get());
+      sessions->erase(peer);
+    }
+  }
+}
+
+
 Try<Nothing> verify(const SSL* const ssl, const Option<string>& hostname)
 {
   // Return early if we don't need to verify.
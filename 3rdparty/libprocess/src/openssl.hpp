@@ -47,6 +47,9 @@ public:
   bool enable_tls_v1_0;
   bool enable_tls_v1_1;
   bool enable_tls_v1_2;
+  bool session_cache;
+  unsigned int session_cache_size;
+  bool enable_ktls;
 };
 
 const Flags& flags();
@@ -69,6 +72,9 @@ const Flags& flags();
 //    SSL_ENABLE_TLS_V1_0=(false|0,true|1)
 //    SSL_ENABLE_TLS_V1_1=(false|0,true|1)
 //    SSL_ENABLE_TLS_V1_2=(false|0,true|1)
+//    SSL_SESSION_CACHE=(false|0,true|1)
+//    SSL_SESSION_CACHE_SIZE=(1024)
+//    SSL_ENABLE_KTLS=(false|0,true|1)
 //
 // TODO(benh): When/If we need to support multiple contexts in the
 // same process, for example for Server Name Indication (SNI), then
@@ -80,6 +86,20 @@ void initialize();
 // Returns the _global_ OpenSSL context.
 SSL_CTX* context();
 
+// Offers the session last established with 'peer' (see 'remember')
+// to be resumed by the not yet connected SSL connection. Returns true
+// if there was such a session. Use 'SSL_session_reused' once
+// connected to determine whether the peer actually resumed it.
+bool resume(SSL* ssl, const std::string& peer);
+
+// Caches the session of the connected SSL connection to 'peer' so
+// that later connections to 'peer' can resume it.
+void remember(SSL* ssl, const std::string& peer);
+
+// Drops the cached session of 'peer', if any, e.g., after failing to
+// establish a connection with it.
+void forget(const std::string& peer);
+
 // Verify that the hostname is properly associated with the peer
 // certificate associated with the specified SSL connection.
 Try<Nothing> verify(const SSL* const ssl, const Option<std::string>& hostname);
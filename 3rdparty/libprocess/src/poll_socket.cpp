@@ -10,6 +10,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License
 
+#include <string.h>
 
 #include <process/io.hpp>
 #include <process/network.hpp>
@@ -68,9 +69,14 @@ Future<Socket> accept(int fd)
     return Failure("Failed to accept, cloexec: " + cloexec.error());
   }
 
+  // Unix domain sockets have no Nagle algorithm to turn off.
+  Try<Address> address = network::address(s);
+  bool unix_domain = address.isSome() && address->family() == AF_UNIX;
+
   // Turn off Nagle (TCP_NODELAY) so pipelined requests don't wait.
   int on = 1;
-  if (os::setsockopt(s, SOL_TCP, TCP_NODELAY, &on, sizeof(on)) < 0) {
+  if (!unix_domain &&
+      os::setsockopt(s, SOL_TCP, TCP_NODELAY, &on, sizeof(on)) < 0) {
     const string error = os::strerror(errno);
     VLOG(1) << "Failed to turn off the Nagle algorithm: " << error;
     os::close(s);
@@ -177,6 +183,49 @@ Future<size_t> socket_send_data(int s, const char* data, size_t size)
 }
 
 
+Future<size_t> socket_send_vector(int s, const struct iovec* iov, int iovcnt)
+{
+  CHECK(iovcnt > 0);
+
+  // NOTE: We use 'sendmsg' rather than 'writev' so that we can pass
+  // MSG_NOSIGNAL, just like for 'send' above.
+  struct msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = const_cast<struct iovec*>(iov);
+  message.msg_iovlen = iovcnt;
+
+  while (true) {
+    ssize_t length = sendmsg(s, &message, MSG_NOSIGNAL);
+
+    if (length < 0 && (errno == EINTR)) {
+      // Interrupted, try again now.
+      continue;
+    } else if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      // Might block, try again later.
+      return io::poll(s, io::WRITE)
+        .then(lambda::bind(&internal::socket_send_vector, s, iov, iovcnt));
+    } else if (length <= 0) {
+      // Socket error or closed.
+      if (length < 0) {
+        const string error = os::strerror(errno);
+        VLOG(1) << "Socket error while sending: " << error;
+      } else {
+        VLOG(1) << "Socket closed while sending";
+      }
+      if (length == 0) {
+        return length;
+      } else {
+        return Failure(ErrnoError("Socket sendmsg failed"));
+      }
+    } else {
+      CHECK(length > 0);
+
+      return length;
+    }
+  }
+}
+
+
 Future<size_t> socket_send_file(int s, int fd, off_t offset, size_t size)
 {
   CHECK(size > 0);
@@ -228,5 +277,12 @@ Future<size_t> PollSocketImpl::sendfile(int fd, off_t offset, size_t size)
     .then(lambda::bind(&internal::socket_send_file, get(), fd, offset, size));
 }
 
+
+Future<size_t> PollSocketImpl::send(const struct iovec* iov, int iovcnt)
+{
+  return io::poll(get(), io::WRITE)
+    .then(lambda::bind(&internal::socket_send_vector, get(), iov, iovcnt));
+}
+
 } // namespace network {
 } // namespace process {
@@ -35,6 +35,7 @@ public:
   virtual Future<size_t> recv(char* data, size_t size);
   virtual Future<size_t> send(const char* data, size_t size);
   virtual Future<size_t> sendfile(int fd, off_t offset, size_t size);
+  virtual Future<size_t> send(const struct iovec* iov, int iovcnt);
 
   virtual Socket::Kind kind() const { return Socket::POLL; }
 };
@@ -13,6 +13,7 @@
 #include <errno.h>
 #include <limits.h>
 #include <netdb.h>
+#include <pthread.h>
 #include <signal.h>
 #include <stdarg.h>
 #include <stdint.h>
@@ -25,6 +26,10 @@
 
 #include <glog/logging.h>
 
+#ifdef ENABLE_JEMALLOC
+#include <jemalloc/jemalloc.h>
+#endif
+
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 
@@ -78,10 +83,15 @@
 #include <process/time.hpp>
 #include <process/timer.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
 
+#include <stout/bytes.hpp>
+#include <stout/cache.hpp>
 #include <stout/duration.hpp>
 #include <stout/foreach.hpp>
+#include <stout/gzip.hpp>
 #include <stout/lambda.hpp>
 #include <stout/net.hpp>
 #include <stout/numify.hpp>
@@ -89,20 +99,28 @@
 #include <stout/os.hpp>
 #include <stout/os/strerror.hpp>
 #include <stout/path.hpp>
+#include <stout/result.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 #include <stout/synchronized.hpp>
 #include <stout/thread_local.hpp>
+#include <stout/try.hpp>
 #include <stout/unreachable.hpp>
 
+#include "actor_profiler.hpp"
 #include "config.hpp"
 #include "decoder.hpp"
 #include "encoder.hpp"
 #include "event_loop.hpp"
+#include "event_queue.hpp"
 #include "gate.hpp"
+#include "mailbox_metrics.hpp"
 #ifdef USE_SSL_SOCKET
+#include "libevent_ssl_socket.hpp"
 #include "openssl.hpp"
 #endif
 #include "process_reference.hpp"
+#include "slab_pool.hpp"
 
 namespace firewall = process::firewall;
 namespace metrics = process::metrics;
@@ -167,41 +185,43 @@ map<string, string> types;
 // satisfy HTTP/1.1 pipelining. Each request should either enqueue a
 // response, or ask the proxy to handle a future response. The process
 // is responsible for making sure the responses are sent in the same
-// order as the requests. Note that we use a 'Socket' in order to keep
-// the underyling file descriptor from getting closed while there
-// might still be outstanding responses even though the client might
-// have closed the connection (see more discussion in
-// SocketManger::close and SocketManager::proxy).
+// order as the requests of each connection (i.e., socket). A fixed
+// pool of proxies is shared by all the connections, which are served
+// by the proxy picked by their socket (see SocketManager::proxy), so
+// that accepting or closing a connection does not spawn or terminate
+// a process. Note that we use a 'Socket' in order to keep the
+// underyling file descriptor from getting closed while there might
+// still be outstanding responses even though the client might have
+// closed the connection (see more discussion in SocketManger::close
+// and SocketManager::proxy).
 class HttpProxy : public Process<HttpProxy>
 {
 public:
-  explicit HttpProxy(const Socket& _socket);
+  HttpProxy();
   virtual ~HttpProxy();
 
   // Enqueues the response to be sent once all previously enqueued
-  // responses have been processed (e.g., waited for and sent).
-  void enqueue(const Response& response, const Request& request);
+  // responses of the socket have been processed (e.g., waited for
+  // and sent).
+  void enqueue(
+      const Socket& socket,
+      const Response& response,
+      const Request& request);
 
   // Enqueues a future to a response that will get waited on (up to
   // some timeout) and then sent once all previously enqueued
-  // responses have been processed (e.g., waited for and sent).
-  void handle(const Future<Response>& future, const Request& request);
-
-private:
-  // Starts "waiting" on the next available future response.
-  void next();
-
-  // Invoked once a future response has been satisfied.
-  void waited(const Future<Response>& future);
-
-  // Demuxes and handles a response.
-  bool process(const Future<Response>& future, const Request& request);
-
-  // Handles stream based responses.
-  void stream(const Request& request, const Future<string>& chunk);
+  // responses of the socket have been processed (e.g., waited for
+  // and sent).
+  void handle(
+      const Socket& socket,
+      const Future<Response>& future,
+      const Request& request);
 
-  Socket socket; // Wrap the socket to keep it from getting closed.
+  // Forgets the connection on the socket (e.g., after it was closed),
+  // discarding its outstanding responses.
+  void close(int s);
 
+private:
   // Describes a queue "item" that wraps the future to the response
   // and the original request.
   // The original request contains needed information such as what encodings
@@ -215,9 +235,112 @@ private:
     Future<Response> future; // Make a copy.
   };
 
-  queue<Item*> items;
+  struct Connection
+  {
+    Connection(const Socket& _socket, uint64_t _id)
+      : socket(_socket), id(_id) {}
+
+    ~Connection();
+
+    Socket socket; // Wrap the socket to keep it from getting closed.
+
+    // Distinguishes the connection from the earlier connections on
+    // the same file descriptor, whose deferred callbacks might still
+    // be pending (see 'find').
+    const uint64_t id;
+
+    queue<Item*> items;
+
+    Option<http::Pipe::Reader> pipe; // Current pipe, if streaming.
+
+    // Compresses the body of the current pipe, if it gets compressed.
+    Owned<gzip::Compressor> compressor;
+  };
+
+  // Returns the connection on the socket with the given id, or NULL
+  // if the connection was closed in the meantime.
+  Connection* find(int s, uint64_t id);
+
+  // Starts "waiting" on the next available future response.
+  void next(Connection* connection);
+
+  // Invoked once a future response has been satisfied.
+  void waited(int s, uint64_t id, const Future<Response>& future);
+
+  // Demuxes and handles a response.
+  bool process(
+      Connection* connection,
+      const Future<Response>& future,
+      const Request& request);
+
+  // Handles stream based responses.
+  void stream(
+      int s,
+      uint64_t id,
+      const Request& request,
+      const Future<string>& chunk);
+
+  // Sends the response once its body has been compressed, or as is
+  // if compressing it failed.
+  void compressed(
+      int s,
+      uint64_t id,
+      Response response,
+      const Request& request,
+      const Future<string>& body);
+
+  map<int, Connection*> connections;
+
+  uint64_t nextId;
+};
+
+
+// Compresses the bodies of HTTP responses on behalf of the HTTP
+// proxies, so that a proxy keeps sending the responses of its other
+// connections while a large body gets compressed, and so that at most
+// the (fixed) pool of compressors keeps worker threads busy with
+// compressing at a time (see LIBPROCESS_NUM_HTTP_COMPRESSORS). The
+// compressed bodies of the last responses with an 'ETag' are kept,
+// so that a version of a response that is served repeatedly (e.g.,
+// the master's '/state' served from its cache) is compressed once.
+class HttpCompressor : public Process<HttpCompressor>
+{
+public:
+  explicit HttpCompressor(int _level)
+    : ProcessBase(ID::generate("__gzip__")),
+      level(_level),
+      bodies(COMPRESSED_BODIES) {}
+
+  // Returns the body compressed using gzip. The key, if any, must
+  // identify the body, e.g., the path and the 'ETag' of the response.
+  Future<string> compress(const string& body, const Option<string>& key)
+  {
+    if (key.isSome()) {
+      Option<string> compressed = bodies.get(key.get());
+      if (compressed.isSome()) {
+        return compressed.get();
+      }
+    }
+
+    Try<string> compressed = gzip::compress(body, level);
+    if (compressed.isError()) {
+      return Failure(compressed.error());
+    }
+
+    if (key.isSome()) {
+      bodies.put(key.get(), compressed.get());
+    }
+
+    return compressed.get();
+  }
+
+private:
+  // The number of compressed bodies that each compressor keeps.
+  static const size_t COMPRESSED_BODIES = 8;
+
+  const int level;
 
-  Option<http::Pipe::Reader> pipe; // Current pipe, if streaming.
+  Cache<string, string> bodies;
 };
 
 
@@ -283,8 +406,32 @@ public:
             const UPID& to,
             const Socket::Kind& kind = Socket::DEFAULT_KIND());
 
+  // Spawns the pool of HTTP proxies shared by the connections, and
+  // the pool of compressors of their responses.
+  void spawnProxies(size_t count);
+
+  // Returns the HTTP proxy of the connection on the socket, or an
+  // empty PID if the socket was closed.
   PID<HttpProxy> proxy(const Socket& socket);
 
+  // Returns whether the socket has a connection in its HTTP proxy
+  // which the proxy is going to be asked to close (i.e., the socket
+  // was not closed since the HTTP proxy was returned for it).
+  bool proxied(int s);
+
+  // Returns whether the body of the response to the request should
+  // get compressed, i.e., whether the client accepts gzip and either
+  // the body is large enough (see LIBPROCESS_COMPRESS_RESPONSE_BYTES)
+  // or the body is streamed and LIBPROCESS_COMPRESS_STREAMS is set.
+  bool compressible(const Response& response, const Request& request);
+
+  // Compresses the body of the response to the request using one of
+  // the pool of compressors.
+  Future<string> compress(const Response& response, const Request& request);
+
+  // Returns a new compressor for streaming the body of a response.
+  gzip::Compressor* compressor();
+
   void send(Encoder* encoder, bool persist);
   void send(const Response& response,
             const Request& request,
@@ -292,6 +439,10 @@ public:
   void send(Message* message,
             const Socket::Kind& kind = Socket::DEFAULT_KIND());
 
+  // Remembers whether the peer at the address accepts gzip compressed
+  // message bodies, based on the latest message received from it.
+  void negotiate(const Address& address, const Request& request);
+
   Encoder* next(int s);
 
   void close(int s);
@@ -299,26 +450,136 @@ public:
   void exited(const Address& address);
   void exited(ProcessBase* process);
 
+  struct Metrics
+  {
+    Metrics()
+      : coalesced_writes("socket_manager/coalesced_writes"),
+        coalesced_encoders("socket_manager/coalesced_encoders") {}
+
+    // Number of writes that included the data of more than one
+    // encoder (e.g., more than one message).
+    process::metrics::Counter coalesced_writes;
+
+    // Number of encoders whose data got coalesced into the write of
+    // a preceding encoder.
+    process::metrics::Counter coalesced_encoders;
+  } metrics;
+
 private:
-  // TODO(bmahler): Leverage a bidirectional multimap instead, or
-  // hide the complexity of manipulating 'links' through methods.
-  struct
+  // The state is sharded so that sending to (or linking with, or
+  // losing) independent peers does not contend on a single mutex.
+  // The state of a peer (i.e., a socket address) lives in the peer
+  // shard of the address, and the state of a socket lives in the
+  // socket shard of its file descriptor.
+  //
+  // To avoid deadlocks, a peer shard is always locked before a socket
+  // shard, at most one peer shard is locked at a time, and socket
+  // shards are locked in the order of their index (the mutexes are
+  // recursive since, e.g., 'close' can end up calling 'exited').
+  static const size_t SHARDS = 64;
+
+  struct PeerShard
+  {
+    // Maps from socket address (ip, port) to temporary sockets (i.e.,
+    // they will get closed once there is no more data to send on
+    // them).
+    map<Address, int> temps;
+
+    // Maps from socket address (ip, port) to persistent sockets (i.e.,
+    // they will remain open even if there is no more data to send on
+    // them). We distinguish these from the 'temps' collection so we
+    // can tell when a persistant socket has been lost (and thus
+    // generate ExitedEvents).
+    map<Address, int> persists;
+
+    // TODO(bmahler): Leverage a bidirectional multimap instead, or
+    // hide the complexity of manipulating 'links' through methods.
+    struct
+    {
+      // For links, we maintain a bidirectional mapping between the
+      // "linkers" (Processes) and the "linkees" (remote / local
+      // UPIDs). For remote socket addresses, we also need a mapping
+      // to the linkees for that socket address, because socket
+      // closure only notifies at the address level. Links are kept
+      // in the shard of the address of the linkee, so the linkees of
+      // a linker are spread across all shards.
+      hashmap<UPID, hashset<ProcessBase*>> linkers;
+      hashmap<ProcessBase*, hashset<UPID>> linkees;
+      hashmap<Address, hashset<UPID>> remotes;
+    } links;
+
+    // The peers that accept gzip compressed message bodies.
+    set<Address> gzip;
+
+    std::recursive_mutex mutex;
+  };
+
+  struct SocketShard
+  {
+    // Collection of all actice sockets.
+    map<int, Socket*> sockets;
+
+    // Collection of sockets that should be disposed when they are
+    // finished being used (e.g., when there is no more data to send
+    // on them).
+    set<int> dispose;
+
+    // Map from socket to socket address (ip, port), for the sockets
+    // that we connected to a peer. The state of such a socket is
+    // also tracked by the peer shard of its address, which must be
+    // locked before removing the socket.
+    map<int, Address> addresses;
+
+    // Map from socket to outgoing queue.
+    map<int, queue<Encoder*>> outgoing;
+
+    // The sockets that have a connection in their HTTP proxy.
+    set<int> proxies;
+
+    std::recursive_mutex mutex;
+  };
+
+  PeerShard& peerShard(const Address& address)
+  {
+    return peerShards[std::hash<Address>()(address) % SHARDS];
+  }
+
+  SocketShard& socketShard(int s)
   {
-    // For links, we maintain a bidirectional mapping between the
-    // "linkers" (Processes) and the "linkees" (remote / local UPIDs).
-    // For remote socket addresses, we also need a mapping to the
-    // linkees for that socket address, because socket closure only
-    // notifies at the address level.
-    hashmap<UPID, hashset<ProcessBase*>> linkers;
-    hashmap<ProcessBase*, hashset<UPID>> linkees;
-    hashmap<Address, hashset<UPID>> remotes;
-  } links;
+    return socketShards[static_cast<size_t>(s) % SHARDS];
+  }
+
+  // Returns the address of the peer if 's' is a socket that we
+  // connected to a peer (see 'SocketShard::addresses').
+  Option<Address> remote(int s);
+
+  // Returns whether the caller holds the lock of the peer shard of
+  // the socket (if any), given the 'address' it got from 'remote'
+  // before locking that peer shard. This might not be the case if the
+  // socket got closed and its file descriptor reused for another peer
+  // in between. Must be called while holding the lock of the socket
+  // shard of 's'.
+  bool locked(int s, const Option<Address>& address);
+
+  // Helpers for 'next' and 'close', which must be called while
+  // holding the lock of the peer shard of the socket (if any). They
+  // return false, without doing anything, if the caller does not hold
+  // that lock (see 'locked'), in which case the caller must retry.
+  bool _next(
+      int s,
+      const Option<Address>& address,
+      Encoder** encoder,
+      bool* proxied);
+  bool _close(int s, const Option<Address>& address, bool* proxied);
 
   // Switch the underlying socket that a remote end is talking to.
   // This manipulates the datastructures below by swapping all data
   // mapped to 'from' to being mapped to 'to'. This is useful for
   // downgrading a socket from SSL to POLL based.
-  void swap_implementing_socket(const Socket& from, Socket* to);
+  void swap_implementing_socket(
+      const Address& address,
+      const Socket& from,
+      Socket* to);
 
   // Helper function for link().
   void link_connect(
@@ -330,38 +591,90 @@ private:
   void send_connect(
       const Future<Nothing>& future,
       Socket* socket,
-      Message* message);
+      Message* message,
+      bool compressed);
+
+  // Compresses the body of the message using gzip if it is large
+  // enough and the peer accepts it, returns whether it did.
+  bool compress(Message* message);
+
+  PeerShard peerShards[SHARDS];
+  SocketShard socketShards[SHARDS];
+
+  // The pool of HTTP proxies, the proxy of a connection is picked by
+  // the file descriptor of its socket.
+  vector<PID<HttpProxy>> proxies;
+
+  // The maximum number of bytes of queued data to coalesce into a
+  // single write (see SocketManager::next), zero disables coalescing.
+  Bytes coalesce;
+
+  // The minimum size of the message bodies to compress for the peers
+  // that accept it, if any.
+  Option<Bytes> compression;
+
+  // The pool of compressors of the bodies of HTTP responses, which
+  // contains 'httpCompressors' processes once spawned (by default a
+  // quarter of the HTTP proxies).
+  vector<PID<HttpCompressor>> compressors;
+  Option<size_t> httpCompressors;
+  std::atomic_ulong nextCompressor;
+
+  // The minimum size of the HTTP response bodies to compress for the
+  // clients that accept it, the compression level, and whether to
+  // compress streamed bodies as well.
+  Bytes httpCompression;
+  int httpCompressionLevel;
+  bool httpCompressStreams;
+};
 
-  // Collection of all actice sockets.
-  map<int, Socket*> sockets;
 
-  // Collection of sockets that should be disposed when they are
-  // finished being used (e.g., when there is no more data to send on
-  // them).
-  set<int> dispose;
+// The thread of a dedicated process, which only ever runs that
+// process (see 'SpawnOptions::dedicated'). Deleting it stops and
+// joins the thread, which must only happen once the process has been
+// cleaned up (or if the process never got spawned).
+class DedicatedThread
+{
+public:
+  explicit DedicatedThread(ProcessBase* _process)
+    : process(_process),
+      thread(NULL),
+      ready(false),
+      terminated(false) {}
+
+  ~DedicatedThread()
+  {
+    terminated.store(true);
+    gate.open();
 
-  // Map from socket to socket address (ip, port).
-  map<int, Address> addresses;
+    if (thread != NULL) {
+      thread->join();
+      delete thread;
+    }
+  }
 
-  // Maps from socket address (ip, port) to temporary sockets (i.e.,
-  // they will get closed once there is no more data to send on them).
-  map<Address, int> temps;
+  // NOTE: Only dereferenced by 'thread' until the process has been
+  // cleaned up.
+  ProcessBase* const process;
 
-  // Maps from socket address (ip, port) to persistent sockets (i.e., they will
-  // remain open even if there is no more data to send on them).  We
-  // distinguish these from the 'temps' collection so we can tell when
-  // a persistant socket has been lost (and thus generate
-  // ExitedEvents).
-  map<Address, int> persists;
+  std::thread* thread;
 
-  // Map from socket to outgoing queue.
-  map<int, queue<Encoder*>> outgoing;
+  // The CPU that the thread is pinned to, if any.
+  Option<int> cpu;
 
-  // HTTP proxies.
-  map<int, HttpProxy*> proxies;
+  // Set when the process gets enqueued, so at most once until the
+  // thread resumes the process. The thread waits at 'gate' while
+  // the process is not runnable.
+  std::atomic_bool ready;
+  Gate gate;
 
-  // Protects instance variables.
-  std::recursive_mutex mutex;
+  // Set once the process has been cleaned up, after which the thread
+  // exits.
+  std::atomic_bool terminated;
+
+  // Exposes the CPU that the thread is pinned to (or -1) so that the
+  // metrics show which processes are dedicated.
+  Option<metrics::Gauge> gauge;
 };
 
 
@@ -391,7 +704,11 @@ public:
       Event* event,
       ProcessBase* sender = NULL);
 
-  UPID spawn(ProcessBase* process, bool manage);
+  UPID spawn(
+      ProcessBase* process,
+      bool manage,
+      const SpawnOptions& options = SpawnOptions());
+
   void resume(ProcessBase* process);
   void cleanup(ProcessBase* process);
   void link(ProcessBase* process, const UPID& to);
@@ -401,8 +718,24 @@ public:
   void installFirewall(vector<Owned<firewall::FirewallRule>>&& rules);
   string absolutePath(const string& path);
 
+  // Adds or removes the route with the specified absolute path
+  // (i.e., '/id/name') to the routes which stream request bodies.
+  void stream(const string& path, bool streaming);
+
+  // Returns true if the body of the request should be streamed, i.e.,
+  // if the request's path is (or is below) a route which opted into
+  // request streaming (see 'ProcessBase::RouteOptions'). Invoked by
+  // the request decoder once the headers of a request are decoded.
+  bool streaming(const Request& request);
+
+  // Maximum size of a request body, if any.
+  Option<Bytes> maxRequestBodySize() const
+  {
+    return max_request_body_size;
+  }
+
   void enqueue(ProcessBase* process);
-  ProcessBase* dequeue();
+  ProcessBase* dequeue(long worker);
 
   void settle();
 
@@ -420,22 +753,69 @@ private:
   // Gates for waiting threads (protected by processes_mutex).
   map<ProcessBase*, Gate*> gates;
 
-  // Queue of runnable processes (implemented using list).
-  list<ProcessBase*> runq;
-  std::recursive_mutex runq_mutex;
+  // Queue of runnable processes for a single processing thread. A
+  // process gets enqueued on the run queue of the thread that last
+  // ran it and idle threads steal from the other threads' run queues.
+  struct RunQueue
+  {
+    RunQueue() : size(0) {}
+
+    std::deque<ProcessBase*> processes;
+    std::mutex mutex;
+
+    // Number of processes in 'processes', so that idle threads can
+    // skip empty run queues without acquiring 'mutex'.
+    std::atomic_long size;
+  };
+
+  // Removes the process from whichever run queue it is on, returns
+  // false if it was not found on any run queue.
+  bool remove(ProcessBase* process);
+
+  // Runs the process of a dedicated thread until it terminates.
+  void run(DedicatedThread* thread);
+
+  // Joins and deletes the threads of the dedicated processes that
+  // have terminated.
+  void reap();
 
-  // Number of running processes, to support Clock::settle operation.
-  std::atomic_long running;
+  // Run queues, one per processing thread (immutable once the
+  // processing threads have been created).
+  vector<RunQueue*> runqs;
+
+  // Used to pick a run queue for processes that have not yet run and
+  // are enqueued from a non-processing thread.
+  std::atomic_ulong next_runq;
+
+  // Number of processes that are either on a run queue or currently
+  // running, to support Clock::settle operation. This gets
+  // incremented before a process is added to a run queue and only
+  // decremented after the process has been resumed so that it can
+  // be checked without synchronizing on every run queue.
+  std::atomic_long runnable;
 
   // Stores the thread handles so that we can join during shutdown.
   vector<std::thread*> threads;
 
+  // Threads of the dedicated processes, which get deleted once their
+  // process has terminated (see 'reap').
+  list<DedicatedThread*> dedicated_threads;
+  std::mutex dedicated_threads_mutex;
+
   // Boolean used to signal processing threads to stop running.
   std::atomic_bool joining_threads;
 
   // List of rules applied to all incoming HTTP requests.
   vector<Owned<firewall::FirewallRule>> firewallRules;
   std::recursive_mutex firewall_mutex;
+
+  // Absolute paths of the routes which stream request bodies.
+  set<string> streaming_routes;
+  std::mutex streaming_mutex;
+
+  // Requests with a larger body get rejected by closing the
+  // connection, see 'LIBPROCESS_MAX_REQUEST_BODY_BYTES'.
+  Option<Bytes> max_request_body_size;
 };
 
 
@@ -445,8 +825,11 @@ static uint32_t __id__ = 0;
 // Server socket listen backlog.
 static const int LISTEN_BACKLOG = 500000;
 
-// Local server socket.
-static Socket* __s__ = NULL;
+// Local server sockets, all bound to the same address. There is one
+// for each event loop (see 'EventLoop::count()'), so that with more
+// than one the kernel distributes the connections between them
+// (using SO_REUSEPORT) and they get accepted in parallel.
+static vector<Socket>* __s__ = NULL;
 
 // Local socket address.
 static Address __address__;
@@ -478,6 +861,10 @@ THREAD_LOCAL ProcessBase* __process__ = NULL;
 // Per thread executor pointer.
 THREAD_LOCAL Executor* _executor_ = NULL;
 
+// Per thread index of the processing thread (and therefore its run
+// queue), or -1 if this is not a processing thread.
+static THREAD_LOCAL long __worker__ = -1;
+
 
 // NOTE: Clock::* implementations are in clock.cpp except for
 // Clock::settle which currently has a dependency on
@@ -514,12 +901,12 @@ static void transport(Message* message, ProcessBase* sender = NULL)
 }
 
 
-static bool libprocess(Request* request)
+static bool libprocess(const Request* request)
 {
   return
     (request->method == "POST" &&
      request->headers.contains("User-Agent") &&
-     request->headers["User-Agent"].find("libprocess/") == 0) ||
+     request->headers.at("User-Agent").find("libprocess/") == 0) ||
     (request->method == "POST" &&
      request->headers.contains("Libprocess-From"));
 }
@@ -688,7 +1075,7 @@ void timedout(const list<Timer>& timers)
 
 namespace internal {
 
-void on_accept(const Future<Socket>& socket)
+void on_accept(const Future<Socket>& socket, Socket server)
 {
   if (socket.isReady()) {
     // Inform the socket manager for proper bookkeeping.
@@ -698,7 +1085,10 @@ void on_accept(const Future<Socket>& socket)
     char* data = new char[size];
     memset(data, 0, size);
 
-    DataDecoder* decoder = new DataDecoder(socket.get());
+    DataDecoder* decoder = new DataDecoder(
+        socket.get(),
+        lambda::bind(&ProcessManager::streaming, process_manager, lambda::_1),
+        process_manager->maxRequestBodySize());
 
     socket.get().recv(data, size)
       .onAny(lambda::bind(
@@ -710,8 +1100,8 @@ void on_accept(const Future<Socket>& socket)
           decoder));
   }
 
-  __s__->accept()
-    .onAny(lambda::bind(&on_accept, lambda::_1));
+  server.accept()
+    .onAny(lambda::bind(&on_accept, lambda::_1, server));
 }
 
 } // namespace internal {
@@ -728,6 +1118,27 @@ void install(vector<Owned<FirewallRule>>&& rules)
 
 } // namespace firewall {
 
+
+#ifdef ENABLE_JEMALLOC
+// Returns the jemalloc statistic 'name' (e.g., "stats.allocated"),
+// after refreshing the statistics.
+static Future<double> jemalloc(const string& name)
+{
+  uint64_t epoch = 1;
+  size_t length = sizeof(epoch);
+  mallctl("epoch", &epoch, &length, &epoch, length);
+
+  size_t value = 0;
+  length = sizeof(value);
+  if (mallctl(name.c_str(), &value, &length, NULL, 0) != 0) {
+    return Failure("Failed to read jemalloc statistic '" + name + "'");
+  }
+
+  return value;
+}
+#endif // ENABLE_JEMALLOC
+
+
 void initialize(const string& delegate)
 {
   // TODO(benh): Return an error if attempting to initialize again
@@ -829,25 +1240,50 @@ void initialize(const string& delegate)
     }
   }
 
-  // Create a "server" socket for communicating.
-  Try<Socket> create = Socket::create();
-  if (create.isError()) {
-    PLOG(FATAL) << "Failed to construct server socket:" << create.error();
-  }
-  __s__ = new Socket(create.get());
+  // Create the "server" socket(s) for communicating.
+  const size_t servers = EventLoop::count();
 
-  // Allow address reuse.
-  int on = 1;
-  if (setsockopt(__s__->get(), SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0) {
-    PLOG(FATAL) << "Failed to initialize, setsockopt(SO_REUSEADDR)";
-  }
+  __s__ = new vector<Socket>();
 
-  Try<Address> bind = __s__->bind(__address__);
-  if (bind.isError()) {
-    PLOG(FATAL) << "Failed to initialize: " << bind.error();
-  }
+  for (size_t i = 0; i < servers; i++) {
+    Try<Socket> create = Socket::create();
+    if (create.isError()) {
+      PLOG(FATAL) << "Failed to construct server socket:" << create.error();
+    }
+
+    Socket socket = create.get();
+
+    // Allow address reuse.
+    int on = 1;
+    if (setsockopt(
+            socket.get(), SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0) {
+      PLOG(FATAL) << "Failed to initialize, setsockopt(SO_REUSEADDR)";
+    }
 
-  __address__ = bind.get();
+    // Allow the other server sockets to bind to the same address.
+    if (servers > 1) {
+#ifdef SO_REUSEPORT
+      if (setsockopt(
+              socket.get(), SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0) {
+        PLOG(FATAL) << "Failed to initialize, setsockopt(SO_REUSEPORT)";
+      }
+#else
+      LOG(FATAL) << "Failed to initialize, SO_REUSEPORT is not supported";
+#endif // SO_REUSEPORT
+    }
+
+    // NOTE: The other server sockets bind to the address that the
+    // first one got bound to, in particular to its port if the port
+    // was chosen by the kernel.
+    Try<Address> bind = socket.bind(__address__);
+    if (bind.isError()) {
+      PLOG(FATAL) << "Failed to initialize: " << bind.error();
+    }
+
+    __address__ = bind.get();
+
+    __s__->push_back(socket);
+  }
 
   // If advertised IP and port are present, use them instead.
   value = os::getenv("LIBPROCESS_ADVERTISE_IP");
@@ -895,17 +1331,25 @@ void initialize(const string& delegate)
     __address__.ip = ip.get();
   }
 
-  Try<Nothing> listen = __s__->listen(LISTEN_BACKLOG);
-  if (listen.isError()) {
-    PLOG(FATAL) << "Failed to initialize: " << listen.error();
+  foreach (Socket& socket, *__s__) {
+    Try<Nothing> listen = socket.listen(LISTEN_BACKLOG);
+    if (listen.isError()) {
+      PLOG(FATAL) << "Failed to initialize: " << listen.error();
+    }
   }
 
   // Need to set `initialize_complete` here so that we can actually
   // invoke `accept()` and `spawn()` below.
   initialize_complete.store(true);
 
-  __s__->accept()
-    .onAny(lambda::bind(&internal::on_accept, lambda::_1));
+  // Spawn the HTTP proxies before accepting any connections.
+  socket_manager->spawnProxies(cpus);
+
+  foreach (const Socket& socket, *__s__) {
+    Socket server = socket;
+    server.accept()
+      .onAny(lambda::bind(&internal::on_accept, lambda::_1, server));
+  }
 
   // TODO(benh): Make sure creating the garbage collector, logging
   // process, and profiler always succeeds and use supervisors to make
@@ -934,6 +1378,55 @@ void initialize(const string& delegate)
 
   CHECK_NOTNULL(metricsProcess);
 
+  metrics::add(socket_manager->metrics.coalesced_writes);
+  metrics::add(socket_manager->metrics.coalesced_encoders);
+
+#ifdef USE_SSL_SOCKET
+  {
+    network::LibeventSSLSocketImpl::Metrics& ssl =
+      network::LibeventSSLSocketImpl::metrics();
+
+    metrics::add(ssl.client_handshake);
+    metrics::add(ssl.server_handshake);
+    metrics::add(ssl.client_handshakes);
+    metrics::add(ssl.server_handshakes);
+    metrics::add(ssl.client_resumptions);
+    metrics::add(ssl.server_resumptions);
+    metrics::add(ssl.ktls_connections);
+  }
+#endif
+
+  // NOTE: See the comment about the dedicated thread gauges in
+  // 'ProcessManager::spawn' as to why the garbage collector evaluates
+  // the gauges of the allocator.
+  const vector<vector<metrics::Gauge>> pools = {
+    SlabPool<Message>::createGauges(
+        "libprocess/allocator/message/", gc),
+    SlabPool<MessageEvent>::createGauges(
+        "libprocess/allocator/message_event/", gc),
+    SlabPool<DispatchEvent>::createGauges(
+        "libprocess/allocator/dispatch_event/", gc),
+    SlabPool<Request>::createGauges(
+        "libprocess/allocator/http_request/", gc),
+    SlabPool<MessageEncoder>::createGauges(
+        "libprocess/allocator/message_encoder/", gc)
+  };
+
+  foreach (const vector<metrics::Gauge>& gauges, pools) {
+    foreach (const metrics::Gauge& gauge, gauges) {
+      metrics::add(gauge);
+    }
+  }
+
+#ifdef ENABLE_JEMALLOC
+  foreach (const string& name,
+           vector<string>({"allocated", "active", "resident", "mapped"})) {
+    metrics::add(metrics::Gauge(
+        "libprocess/allocator/jemalloc/" + name + "_bytes",
+        defer(gc, [name]() { return jemalloc("stats." + name); })));
+  }
+#endif // ENABLE_JEMALLOC
+
   // Initialize the mime types.
   mime::initialize();
 
@@ -983,12 +1476,20 @@ Address address()
 }
 
 
-HttpProxy::HttpProxy(const Socket& _socket)
+HttpProxy::HttpProxy()
   : ProcessBase(ID::generate("__http__")),
-    socket(_socket) {}
+    nextId(0) {}
 
 
 HttpProxy::~HttpProxy()
+{
+  foreachvalue (Connection* connection, connections) {
+    delete connection;
+  }
+}
+
+
+HttpProxy::Connection::~Connection()
 {
   // Need to make sure response producers know not to continue to
   // create a response (streaming or otherwise).
@@ -1023,54 +1524,167 @@ HttpProxy::~HttpProxy()
 }
 
 
-void HttpProxy::enqueue(const Response& response, const Request& request)
+void HttpProxy::enqueue(
+    const Socket& socket,
+    const Response& response,
+    const Request& request)
+{
+  handle(socket, Future<Response>(response), request);
+}
+
+
+void HttpProxy::handle(
+    const Socket& socket,
+    const Future<Response>& future,
+    const Request& request)
 {
-  handle(Future<Response>(response), request);
+  const int s = socket.get();
+
+  if (connections.count(s) == 0) {
+    // The socket might have been closed after this was dispatched,
+    // in which case it is not going to be closed again (see
+    // SocketManager::proxied).
+    if (!socket_manager->proxied(s)) {
+      return;
+    }
+
+    connections[s] = new Connection(socket, nextId++);
+  }
+
+  Connection* connection = connections[s];
+
+  connection->items.push(new Item(request, future));
+
+  if (connection->items.size() == 1) {
+    next(connection);
+  }
 }
 
 
-void HttpProxy::handle(const Future<Response>& future, const Request& request)
+void HttpProxy::close(int s)
 {
-  items.push(new Item(request, future));
+  if (connections.count(s) > 0) {
+    delete connections[s];
+    connections.erase(s);
+  }
+}
 
-  if (items.size() == 1) {
-    next();
+
+HttpProxy::Connection* HttpProxy::find(int s, uint64_t id)
+{
+  if (connections.count(s) > 0 && connections[s]->id == id) {
+    return connections[s];
   }
+
+  return NULL;
 }
 
 
-void HttpProxy::next()
+void HttpProxy::next(Connection* connection)
 {
-  if (items.size() > 0) {
+  if (connection->items.size() > 0) {
     // Wait for any transition of the future.
-    items.front()->future.onAny(
-        defer(self(), &HttpProxy::waited, lambda::_1));
+    connection->items.front()->future.onAny(
+        defer(self(),
+              &HttpProxy::waited,
+              connection->socket.get(),
+              connection->id,
+              lambda::_1));
   }
 }
 
 
-void HttpProxy::waited(const Future<Response>& future)
+void HttpProxy::waited(int s, uint64_t id, const Future<Response>& future)
 {
-  CHECK(items.size() > 0);
-  Item* item = items.front();
+  Connection* connection = find(s, id);
+  if (connection == NULL) {
+    return;
+  }
+
+  CHECK(connection->items.size() > 0);
+  Item* item = connection->items.front();
 
   CHECK(future == item->future);
 
   // Process the item and determine if we're done or not (so we know
   // whether to start waiting on the next responses).
-  bool processed = process(item->future, item->request);
+  bool processed = process(connection, item->future, item->request);
 
-  items.pop();
+  connection->items.pop();
   delete item;
 
   if (processed) {
-    next();
+    next(connection);
+  }
+}
+
+
+// Returns the first and last byte (inclusive) of a file of 'size'
+// bytes that is requested by the value of a 'Range' header, None if
+// the whole file should be sent, or an Error if the range can not be
+// satisfied. Only a single range of bytes is supported, any other
+// (including invalid) values are ignored as permitted by RFC 7233.
+static Result<pair<off_t, off_t>> range(const string& value, off_t size)
+{
+  if (!strings::startsWith(value, "bytes=")) {
+    return None();
+  }
+
+  const string spec = strings::trim(value.substr(strlen("bytes=")));
+
+  size_t dash = spec.find('-');
+  if (dash == string::npos || spec.find(',') != string::npos) {
+    return None();
+  }
+
+  const string first = strings::trim(spec.substr(0, dash));
+  const string last = strings::trim(spec.substr(dash + 1));
+
+  // A suffix range, i.e., the last 'last' bytes.
+  if (first.empty()) {
+    Try<off_t> suffix = numify<off_t>(last);
+    if (suffix.isError() || suffix.get() < 0) {
+      return None();
+    }
+
+    if (suffix.get() == 0 || size == 0) {
+      return Error("Empty range");
+    }
+
+    return std::make_pair(std::max<off_t>(0, size - suffix.get()), size - 1);
+  }
+
+  Try<off_t> start = numify<off_t>(first);
+  if (start.isError() || start.get() < 0) {
+    return None();
+  }
+
+  off_t end = size - 1;
+
+  if (!last.empty()) {
+    Try<off_t> result = numify<off_t>(last);
+    if (result.isError() || result.get() < start.get()) {
+      return None();
+    }
+
+    end = std::min(result.get(), end);
+  }
+
+  if (start.get() >= size) {
+    return Error("Range starts beyond the end of the file");
   }
+
+  return std::make_pair(start.get(), end);
 }
 
 
-bool HttpProxy::process(const Future<Response>& future, const Request& request)
+bool HttpProxy::process(
+    Connection* connection,
+    const Future<Response>& future,
+    const Request& request)
 {
+  const Socket& socket = connection->socket;
+
   if (!future.isReady()) {
     // TODO(benh): Consider handling other "states" of future
     // (discarded, failed, etc) with different HTTP statuses.
@@ -1102,23 +1716,66 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
       if (fstat(fd, &s) != 0) {
         const string error = os::strerror(errno);
         VLOG(1) << "Failed to send file at '" << path << "': " << error;
+        os::close(fd);
         socket_manager->send(InternalServerError(), request, socket);
       } else if (S_ISDIR(s.st_mode)) {
         VLOG(1) << "Returning '404 Not Found' for directory '" << path << "'";
+        os::close(fd);
         socket_manager->send(NotFound(), request, socket);
       } else {
+        // Serve the requested range of the file (if any), which lets
+        // clients like the sandbox pailer fetch only what they need.
+        Result<pair<off_t, off_t>> bytes = None();
+
+        Option<string> value = request.headers.get("Range");
+        if (value.isSome() && response.code == http::Status::OK) {
+          bytes = range(value.get(), s.st_size);
+        }
+
+        response.headers["Accept-Ranges"] = "bytes";
+
+        if (bytes.isError()) {
+          VLOG(1) << "Returning '416 Requested range not satisfiable' for "
+                  << "range '" << value.get() << "' of file at '" << path
+                  << "': " << bytes.error();
+
+          os::close(fd);
+
+          Response unsatisfiable(http::Status::REQUESTED_RANGE_NOT_SATISFIABLE);
+          unsatisfiable.headers["Content-Range"] =
+            "bytes */" + stringify(s.st_size);
+          unsatisfiable.headers["Content-Length"] = "0";
+
+          socket_manager->send(unsatisfiable, request, socket);
+          return true; // All done, can process next request.
+        }
+
+        off_t offset = 0;
+        size_t length = s.st_size;
+
+        if (bytes.isSome()) {
+          offset = bytes.get().first;
+          length = bytes.get().second - bytes.get().first + 1;
+
+          response.code = http::Status::PARTIAL_CONTENT;
+          response.status = http::Status::string(response.code);
+          response.headers["Content-Range"] =
+            "bytes " + stringify(bytes.get().first) + "-" +
+            stringify(bytes.get().second) + "/" + stringify(s.st_size);
+        }
+
         // While the user is expected to properly set a 'Content-Type'
         // header, we fill in (or overwrite) 'Content-Length' header.
-        stringstream out;
-        out << s.st_size;
-        response.headers["Content-Length"] = out.str();
+        response.headers["Content-Length"] = stringify(length);
 
-        if (s.st_size == 0) {
+        if (length == 0) {
+          os::close(fd);
           socket_manager->send(response, request, socket);
           return true; // All done, can process next request.
         }
 
-        VLOG(1) << "Sending file at '" << path << "' with length " << s.st_size;
+        VLOG(1) << "Sending file at '" << path << "' with length " << length
+                << " at offset " << offset;
 
         // TODO(benh): Consider a way to have the socket manager turn
         // on TCP_CORK for both sends and then turn it off.
@@ -1128,7 +1785,7 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
 
         // Note the file descriptor gets closed by FileEncoder.
         socket_manager->send(
-            new FileEncoder(socket, fd, s.st_size),
+            new FileEncoder(socket, fd, length, offset),
             request.keepAlive);
       }
     }
@@ -1141,6 +1798,11 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
     // header, we fill in (or overwrite) 'Transfer-Encoding' header.
     response.headers["Transfer-Encoding"] = "chunked";
 
+    if (socket_manager->compressible(response, request)) {
+      response.headers["Content-Encoding"] = "gzip";
+      connection->compressor.reset(socket_manager->compressor());
+    }
+
     VLOG(3) << "Starting \"chunked\" streaming";
 
     socket_manager->send(
@@ -1150,12 +1812,30 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
     CHECK_SOME(response.reader);
     http::Pipe::Reader reader = response.reader.get();
 
-    pipe = reader;
+    connection->pipe = reader;
 
     reader.read()
-      .onAny(defer(self(), &Self::stream, request, lambda::_1));
+      .onAny(defer(self(),
+                   &Self::stream,
+                   socket.get(),
+                   connection->id,
+                   request,
+                   lambda::_1));
 
     return false; // Streaming, don't process next response (yet)!
+  } else if (socket_manager->compressible(response, request)) {
+    // The body gets compressed by a compressor rather than by this
+    // proxy, which sends the responses of other connections too.
+    socket_manager->compress(response, request)
+      .onAny(defer(self(),
+                   &Self::compressed,
+                   socket.get(),
+                   connection->id,
+                   response,
+                   request,
+                   lambda::_1));
+
+    return false; // Compressing, don't process next response (yet)!
   } else {
     socket_manager->send(response, request, socket);
   }
@@ -1165,36 +1845,64 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
 
 
 void HttpProxy::stream(
+    int s,
+    uint64_t id,
     const Request& request,
     const Future<string>& chunk)
 {
-  CHECK_SOME(pipe);
+  Connection* connection = find(s, id);
+  if (connection == NULL) {
+    return;
+  }
+
+  const Socket& socket = connection->socket;
 
-  http::Pipe::Reader reader = pipe.get();
+  CHECK_SOME(connection->pipe);
+
+  http::Pipe::Reader reader = connection->pipe.get();
 
   bool finished = false; // Whether we're done streaming.
 
-  if (chunk.isReady()) {
+  // The data of the chunk as it gets sent, i.e., compressed if the
+  // body is compressed.
+  Try<string> data = chunk.isReady() ? chunk.get() : string();
+
+  if (chunk.isReady() && connection->compressor.get() != NULL) {
+    data = chunk.get().empty()
+      ? connection->compressor->finish()
+      : connection->compressor->compress(chunk.get());
+  }
+
+  if (chunk.isReady() && data.isSome()) {
     std::ostringstream out;
 
+    // NOTE: The data of the last chunk of a compressed body is not
+    // empty, it ends the compressed stream.
+    if (!data.get().empty()) {
+      out << std::hex << data.get().size() << "\r\n";
+      out << data.get();
+      out << "\r\n";
+    }
+
     if (chunk.get().empty()) {
       // Finished reading.
       out << "0\r\n" << "\r\n";
       finished = true;
     } else {
-      out << std::hex << chunk.get().size() << "\r\n";
-      out << chunk.get();
-      out << "\r\n";
-
       // Keep reading.
       reader.read()
-        .onAny(defer(self(), &Self::stream, request, lambda::_1));
+        .onAny(defer(self(), &Self::stream, s, id, request, lambda::_1));
     }
 
     // Always persist the connection when streaming is not finished.
     socket_manager->send(
         new DataEncoder(socket, out.str()),
         finished ? request.keepAlive : true);
+  } else if (chunk.isReady()) {
+    VLOG(1) << "Failed to compress stream: " << data.error();
+    // TODO(bmahler): Have to close connection if headers were sent!
+    socket_manager->send(InternalServerError(), request, socket);
+    finished = true;
   } else if (chunk.isFailed()) {
     VLOG(1) << "Failed to read from stream: " << chunk.failure();
     // TODO(bmahler): Have to close connection if headers were sent!
@@ -1209,42 +1917,163 @@ void HttpProxy::stream(
 
   if (finished) {
     reader.close();
-    pipe = None();
-    next();
+    connection->pipe = None();
+    connection->compressor.reset();
+    next(connection);
   }
 }
 
 
-SocketManager::SocketManager() {}
-
+void HttpProxy::compressed(
+    int s,
+    uint64_t id,
+    Response response,
+    const Request& request,
+    const Future<string>& body)
+{
+  Connection* connection = find(s, id);
+  if (connection == NULL) {
+    return;
+  }
 
-SocketManager::~SocketManager() {}
+  if (body.isReady()) {
+    response.body = body.get();
+    response.headers["Content-Length"] = stringify(response.body.size());
+    response.headers["Content-Encoding"] = "gzip";
+  } else {
+    LOG(WARNING) << "Failed to gzip response body: "
+                 << (body.isFailed() ? body.failure() : "discarded");
+  }
 
+  socket_manager->send(response, request, connection->socket);
 
-void SocketManager::accepted(const Socket& socket)
-{
-  synchronized (mutex) {
-    sockets[socket] = new Socket(socket);
-  }
+  next(connection);
 }
 
 
-namespace internal {
-
-void ignore_recv_data(
-    const Future<size_t>& length,
-    Socket* socket,
-    char* data,
-    size_t size)
+SocketManager::SocketManager()
+  : coalesce(Kilobytes(256)),
+    nextCompressor(0),
+    httpCompression(GZIP_MINIMUM_BODY_LENGTH),
+    httpCompressionLevel(Z_DEFAULT_COMPRESSION),
+    httpCompressStreams(false)
 {
-  if (length.isDiscarded() || length.isFailed()) {
-    socket_manager->close(*socket);
-    delete[] data;
-    delete socket;
-    return;
+  Option<string> value = os::getenv("LIBPROCESS_COALESCE_WRITE_BYTES");
+  if (value.isSome()) {
+    Try<Bytes> bytes = Bytes::parse(value.get());
+    if (bytes.isError()) {
+      LOG(FATAL) << "Parsing LIBPROCESS_COALESCE_WRITE_BYTES=" << value.get()
+                 << " failed: " << bytes.error();
+    }
+    coalesce = bytes.get();
   }
 
-  if (length.get() == 0) {
+  value = os::getenv("LIBPROCESS_COMPRESS_MESSAGE_BYTES");
+  if (value.isSome()) {
+    Try<Bytes> bytes = Bytes::parse(value.get());
+    if (bytes.isError()) {
+      LOG(FATAL) << "Parsing LIBPROCESS_COMPRESS_MESSAGE_BYTES="
+                 << value.get() << " failed: " << bytes.error();
+    }
+    compression = bytes.get();
+  }
+
+  value = os::getenv("LIBPROCESS_COMPRESS_RESPONSE_BYTES");
+  if (value.isSome()) {
+    Try<Bytes> bytes = Bytes::parse(value.get());
+    if (bytes.isError()) {
+      LOG(FATAL) << "Parsing LIBPROCESS_COMPRESS_RESPONSE_BYTES="
+                 << value.get() << " failed: " << bytes.error();
+    }
+    httpCompression = bytes.get();
+  }
+
+  value = os::getenv("LIBPROCESS_COMPRESS_RESPONSE_LEVEL");
+  if (value.isSome()) {
+    Try<int> level = numify<int>(value.get());
+    if (level.isError() ||
+        level.get() < Z_DEFAULT_COMPRESSION ||
+        level.get() > Z_BEST_COMPRESSION) {
+      LOG(FATAL) << "Parsing LIBPROCESS_COMPRESS_RESPONSE_LEVEL="
+                 << value.get() << " failed: expecting a level from "
+                 << Z_DEFAULT_COMPRESSION << " to " << Z_BEST_COMPRESSION;
+    }
+    httpCompressionLevel = level.get();
+  }
+
+  value = os::getenv("LIBPROCESS_COMPRESS_STREAMS");
+  if (value.isSome()) {
+    httpCompressStreams = value.get() == "true" || value.get() == "1";
+  }
+
+  value = os::getenv("LIBPROCESS_NUM_HTTP_COMPRESSORS");
+  if (value.isSome()) {
+    Try<size_t> count = numify<size_t>(value.get());
+    if (count.isError() || count.get() == 0) {
+      LOG(FATAL) << "Parsing LIBPROCESS_NUM_HTTP_COMPRESSORS="
+                 << value.get() << " failed: expecting a positive number";
+    }
+    httpCompressors = count.get();
+  }
+}
+
+
+SocketManager::~SocketManager() {}
+
+
+void SocketManager::accepted(const Socket& socket)
+{
+  SocketShard& shard = socketShard(socket);
+
+  synchronized (shard.mutex) {
+    shard.sockets[socket] = new Socket(socket);
+  }
+}
+
+
+Option<Address> SocketManager::remote(int s)
+{
+  SocketShard& shard = socketShard(s);
+
+  synchronized (shard.mutex) {
+    if (shard.addresses.count(s) > 0) {
+      return shard.addresses[s];
+    }
+  }
+
+  return None();
+}
+
+
+bool SocketManager::locked(int s, const Option<Address>& address)
+{
+  SocketShard& shard = socketShard(s);
+
+  if (shard.addresses.count(s) == 0) {
+    return true;
+  }
+
+  return address.isSome() &&
+    &peerShard(shard.addresses[s]) == &peerShard(address.get());
+}
+
+
+namespace internal {
+
+void ignore_recv_data(
+    const Future<size_t>& length,
+    Socket* socket,
+    char* data,
+    size_t size)
+{
+  if (length.isDiscarded() || length.isFailed()) {
+    socket_manager->close(*socket);
+    delete[] data;
+    delete socket;
+    return;
+  }
+
+  if (length.get() == 0) {
     socket_manager->close(*socket);
     delete[] data;
     delete socket;
@@ -1287,24 +2116,23 @@ void SocketManager::link_connect(
     // If we allow downgrading from SSL to non-SSL, then retry as a
     // POLL socket.
     if (attempt_downgrade) {
-      synchronized (mutex) {
-        Try<Socket> create = Socket::create(Socket::POLL);
-        if (create.isError()) {
-          VLOG(1) << "Failed to link, create socket: " << create.error();
-          socket_manager->close(*socket);
-          delete socket;
-          return;
-        }
+      Try<Socket> create = Socket::create(Socket::POLL);
+      if (create.isError()) {
+        VLOG(1) << "Failed to link, create socket: " << create.error();
+        socket_manager->close(*socket);
+        delete socket;
+        return;
+      }
 
-        poll_socket = create.get();
+      poll_socket = create.get();
 
-        // Update all the datastructures that are mapped to the socket
-        // that just failed to connect. They will now point to the new
-        // POLL socket we are about to try to connect. Even if the
-        // process has exited, persistent links will stay around, and
-        // temporary links will get cleaned up as they would otherwise.
-        swap_implementing_socket(*socket, new Socket(poll_socket.get()));
-      }
+      // Update all the datastructures that are mapped to the socket
+      // that just failed to connect. They will now point to the new
+      // POLL socket we are about to try to connect. Even if the
+      // process has exited, persistent links will stay around, and
+      // temporary links will get cleaned up as they would otherwise.
+      swap_implementing_socket(
+          to.address, *socket, new Socket(poll_socket.get()));
 
       CHECK_SOME(poll_socket);
       poll_socket.get().connect(to.address)
@@ -1376,9 +2204,11 @@ void SocketManager::link(
   Option<Socket> socket = None();
   bool connect = false;
 
-  synchronized (mutex) {
+  PeerShard& peer = peerShard(to.address);
+
+  synchronized (peer.mutex) {
     // Check if the socket address is remote and there isn't a persistant link.
-    if (to.address != __address__  && persists.count(to.address) == 0) {
+    if (to.address != __address__  && peer.persists.count(to.address) == 0) {
       // Okay, no link, let's create a socket.
       // The kind of socket we create is passed in as an argument.
       // This allows us to support downgrading the connection type
@@ -1391,25 +2221,29 @@ void SocketManager::link(
       socket = create.get();
       int s = socket.get().get();
 
-      sockets[s] = new Socket(socket.get());
-      addresses[s] = to.address;
+      SocketShard& shard = socketShard(s);
 
-      persists[to.address] = s;
+      synchronized (shard.mutex) {
+        shard.sockets[s] = new Socket(socket.get());
+        shard.addresses[s] = to.address;
 
-      // Initialize 'outgoing' to prevent a race with
-      // SocketManager::send() while the socket is not yet connected.
-      // Initializing the 'outgoing' queue prevents
-      // SocketManager::send() from trying to write before it's
-      // connected.
-      outgoing[s];
+        // Initialize 'outgoing' to prevent a race with
+        // SocketManager::send() while the socket is not yet connected.
+        // Initializing the 'outgoing' queue prevents
+        // SocketManager::send() from trying to write before it's
+        // connected.
+        shard.outgoing[s];
+      }
+
+      peer.persists[to.address] = s;
 
       connect = true;
     }
 
-    links.linkers[to].insert(process);
-    links.linkees[process].insert(to);
+    peer.links.linkers[to].insert(process);
+    peer.links.linkees[process].insert(to);
     if (to.address != __address__) {
-      links.remotes[to.address].insert(to);
+      peer.links.remotes[to.address].insert(to);
     }
   }
 
@@ -1426,38 +2260,103 @@ void SocketManager::link(
 }
 
 
+void SocketManager::spawnProxies(size_t count)
+{
+  CHECK(proxies.empty());
+
+  for (size_t i = 0; i < count; i++) {
+    proxies.push_back(spawn(new HttpProxy(), true));
+  }
+
+  CHECK(compressors.empty());
+
+  size_t size = httpCompressors.getOrElse(std::max<size_t>(1, count / 4));
+
+  for (size_t i = 0; i < size; i++) {
+    compressors.push_back(
+        spawn(new HttpCompressor(httpCompressionLevel), true));
+  }
+}
+
+
+bool SocketManager::compressible(
+    const Response& response,
+    const Request& request)
+{
+  if (response.headers.contains("Content-Encoding") ||
+      !request.acceptsEncoding("gzip")) {
+    return false;
+  }
+
+  if (response.type == Response::BODY) {
+    return response.body.size() >= httpCompression.bytes();
+  }
+
+  return response.type == Response::PIPE && httpCompressStreams;
+}
+
+
+Future<string> SocketManager::compress(
+    const Response& response,
+    const Request& request)
+{
+  CHECK(!compressors.empty());
+
+  // Responses with an 'ETag' are compressed by the same compressor,
+  // which keeps their compressed bodies, and the others are spread
+  // across the compressors.
+  Option<string> key = None();
+  size_t hash = nextCompressor++;
+
+  Option<string> etag = response.headers.get("ETag");
+  if (etag.isSome()) {
+    key = request.url.path + " " + etag.get();
+    hash = std::hash<string>()(key.get());
+  }
+
+  return dispatch(
+      compressors[hash % compressors.size()],
+      &HttpCompressor::compress,
+      response.body,
+      key);
+}
+
+
+gzip::Compressor* SocketManager::compressor()
+{
+  return new gzip::Compressor(httpCompressionLevel);
+}
+
+
 PID<HttpProxy> SocketManager::proxy(const Socket& socket)
 {
-  HttpProxy* proxy = NULL;
+  SocketShard& shard = socketShard(socket);
 
-  synchronized (mutex) {
+  synchronized (shard.mutex) {
     // This socket might have been asked to get closed (e.g., remote
     // side hang up) while a process is attempting to handle an HTTP
     // request. Thus, if there is no more socket, return an empty PID.
-    if (sockets.count(socket) > 0) {
-      if (proxies.count(socket) > 0) {
-        return proxies[socket]->self();
-      } else {
-        proxy = new HttpProxy(*sockets[socket]);
-        proxies[socket] = proxy;
-      }
-    }
-  }
+    if (shard.sockets.count(socket) > 0) {
+      shard.proxies.insert(socket);
 
-  // Now check if we need to spawn a newly created proxy. Note that we
-  // need to do this outside of the synchronized block above to avoid
-  // a possible deadlock (because spawn eventually synchronizes on
-  // ProcessManager and ProcessManager::cleanup synchronizes on
-  // ProcessManager and then SocketManager, so a deadlock results if
-  // we do spawn within the synchronized block above).
-  if (proxy != NULL) {
-    return spawn(proxy, true);
+      return proxies[static_cast<size_t>(socket.get()) % proxies.size()];
+    }
   }
 
   return PID<HttpProxy>();
 }
 
 
+bool SocketManager::proxied(int s)
+{
+  SocketShard& shard = socketShard(s);
+
+  synchronized (shard.mutex) {
+    return shard.proxies.count(s) > 0;
+  }
+}
+
+
 namespace internal {
 
 void _send(
@@ -1471,9 +2370,11 @@ void send(Encoder* encoder, Socket* socket)
 {
   switch (encoder->kind()) {
     case Encoder::DATA: {
+      int iovcnt;
       size_t size;
-      const char* data = reinterpret_cast<DataEncoder*>(encoder)->next(&size);
-      socket->send(data, size)
+      const struct iovec* iov =
+        reinterpret_cast<VectorEncoder*>(encoder)->next(&iovcnt, &size);
+      socket->send(iov, iovcnt)
         .onAny(lambda::bind(
             &internal::_send,
             lambda::_1,
@@ -1537,21 +2438,24 @@ void SocketManager::send(Encoder* encoder, bool persist)
 {
   CHECK(encoder != NULL);
 
-  synchronized (mutex) {
-    Socket socket = encoder->socket();
-    if (sockets.count(socket) > 0) {
+  Socket socket = encoder->socket();
+
+  SocketShard& shard = socketShard(socket);
+
+  synchronized (shard.mutex) {
+    if (shard.sockets.count(socket) > 0) {
       // Update whether or not this socket should get disposed after
       // there is no more data to send.
       if (!persist) {
-        dispose.insert(socket);
+        shard.dispose.insert(socket);
       }
 
-      if (outgoing.count(socket) > 0) {
-        outgoing[socket].push(encoder);
+      if (shard.outgoing.count(socket) > 0) {
+        shard.outgoing[socket].push(encoder);
         encoder = NULL;
       } else {
         // Initialize the outgoing queue.
-        outgoing[socket];
+        shard.outgoing[socket];
       }
     } else {
       VLOG(1) << "Attempting to send on a no longer valid socket!";
@@ -1588,7 +2492,8 @@ void SocketManager::send(
 void SocketManager::send_connect(
     const Future<Nothing>& future,
     Socket* socket,
-    Message* message)
+    Message* message,
+    bool compressed)
 {
   if (future.isDiscarded() || future.isFailed()) {
     if (future.isFailed()) {
@@ -1610,25 +2515,24 @@ void SocketManager::send_connect(
     // If we allow downgrading from SSL to non-SSL, then retry as a
     // POLL socket.
     if (attempt_downgrade) {
-      synchronized (mutex) {
-        Try<Socket> create = Socket::create(Socket::POLL);
-        if (create.isError()) {
-          VLOG(1) << "Failed to link, create socket: " << create.error();
-          socket_manager->close(*socket);
-          delete message;
-          delete socket;
-          return;
-        }
+      Try<Socket> create = Socket::create(Socket::POLL);
+      if (create.isError()) {
+        VLOG(1) << "Failed to link, create socket: " << create.error();
+        socket_manager->close(*socket);
+        delete message;
+        delete socket;
+        return;
+      }
 
-        poll_socket = create.get();
+      poll_socket = create.get();
 
-        // Update all the datastructures that are mapped to the socket
-        // that just failed to connect. They will now point to the new
-        // POLL socket we are about to try to connect. Even if the
-        // process has exited, persistent links will stay around, and
-        // temporary links will get cleaned up as they would otherwise.
-        swap_implementing_socket(*socket, new Socket(poll_socket.get()));
-      }
+      // Update all the datastructures that are mapped to the socket
+      // that just failed to connect. They will now point to the new
+      // POLL socket we are about to try to connect. Even if the
+      // process has exited, persistent links will stay around, and
+      // temporary links will get cleaned up as they would otherwise.
+      swap_implementing_socket(
+          message->to.address, *socket, new Socket(poll_socket.get()));
 
       CHECK_SOME(poll_socket);
       poll_socket.get().connect(message->to.address)
@@ -1637,7 +2541,8 @@ void SocketManager::send_connect(
             this,
             lambda::_1,
             new Socket(poll_socket.get()),
-            message));
+            message,
+            compressed));
 
       // We don't need to 'shutdown()' the socket as it was never
       // connected.
@@ -1653,7 +2558,7 @@ void SocketManager::send_connect(
     return;
   }
 
-  Encoder* encoder = new MessageEncoder(*socket, message);
+  Encoder* encoder = new MessageEncoder(*socket, message, compressed);
 
   // Receive and ignore data from this socket. Note that we don't
   // expect to receive anything other than HTTP '202 Accepted'
@@ -1677,34 +2582,44 @@ void SocketManager::send(Message* message, const Socket::Kind& kind)
 {
   CHECK(message != NULL);
 
+  // Compress the message before taking any locks.
+  const bool compressed = compress(message);
+
   const Address& address = message->to.address;
 
   Option<Socket> socket = None();
   bool connect = false;
 
-  synchronized (mutex) {
+  PeerShard& peer = peerShard(address);
+
+  synchronized (peer.mutex) {
     // Check if there is already a socket.
-    bool persist = persists.count(address) > 0;
-    bool temp = temps.count(address) > 0;
+    bool persist = peer.persists.count(address) > 0;
+    bool temp = peer.temps.count(address) > 0;
     if (persist || temp) {
-      int s = persist ? persists[address] : temps[address];
-      CHECK(sockets.count(s) > 0);
-      socket = *sockets[s];
+      int s = persist ? peer.persists[address] : peer.temps[address];
 
-      // Update whether or not this socket should get disposed after
-      // there is no more data to send.
-      if (!persist) {
-        dispose.insert(socket.get());
-      }
+      SocketShard& shard = socketShard(s);
 
-      if (outgoing.count(socket.get()) > 0) {
-        outgoing[socket.get()].push(new MessageEncoder(socket.get(), message));
-        return;
-      } else {
-        // Initialize the outgoing queue.
-        outgoing[socket.get()];
-      }
+      synchronized (shard.mutex) {
+        CHECK(shard.sockets.count(s) > 0);
+        socket = *shard.sockets[s];
 
+        // Update whether or not this socket should get disposed after
+        // there is no more data to send.
+        if (!persist) {
+          shard.dispose.insert(s);
+        }
+
+        if (shard.outgoing.count(s) > 0) {
+          shard.outgoing[s].push(
+              new MessageEncoder(socket.get(), message, compressed));
+          return;
+        } else {
+          // Initialize the outgoing queue.
+          shard.outgoing[s];
+        }
+      }
     } else {
       // No persistent or temporary socket to the socket address
       // currently exists, so we create a temporary one.
@@ -1720,14 +2635,19 @@ void SocketManager::send(Message* message, const Socket::Kind& kind)
       socket = create.get();
       int s = socket.get();
 
-      sockets[s] = new Socket(socket.get());
-      addresses[s] = address;
-      temps[address] = s;
+      SocketShard& shard = socketShard(s);
 
-      dispose.insert(s);
+      synchronized (shard.mutex) {
+        shard.sockets[s] = new Socket(socket.get());
+        shard.addresses[s] = address;
 
-      // Initialize the outgoing queue.
-      outgoing[s];
+        shard.dispose.insert(s);
+
+        // Initialize the outgoing queue.
+        shard.outgoing[s];
+      }
+
+      peer.temps[address] = s;
 
       connect = true;
     }
@@ -1741,22 +2661,115 @@ void SocketManager::send(Message* message, const Socket::Kind& kind)
           this,
           lambda::_1,
           new Socket(socket.get()),
-          message));
+          message,
+          compressed));
   } else {
     // If we're not connecting and we haven't added the encoder to
     // the 'outgoing' queue then schedule it to be sent.
     internal::send(
-        new MessageEncoder(socket.get(), message),
+        new MessageEncoder(socket.get(), message, compressed),
         new Socket(socket.get()));
   }
 }
 
 
+void SocketManager::negotiate(const Address& address, const Request& request)
+{
+  if (compression.isNone()) {
+    return;
+  }
+
+  const bool gzip =
+    request.headers.get("Libprocess-Accept-Encoding") == string("gzip");
+
+  PeerShard& peer = peerShard(address);
+
+  synchronized (peer.mutex) {
+    if (gzip) {
+      peer.gzip.insert(address);
+    } else {
+      peer.gzip.erase(address);
+    }
+  }
+}
+
+
+bool SocketManager::compress(Message* message)
+{
+  if (compression.isNone() ||
+      message->body.size() < compression->bytes()) {
+    return false;
+  }
+
+  const Address& address = message->to.address;
+
+  PeerShard& peer = peerShard(address);
+
+  synchronized (peer.mutex) {
+    if (peer.gzip.count(address) == 0) {
+      return false;
+    }
+  }
+
+  Try<string> compressed = gzip::compress(message->body);
+  if (compressed.isError()) {
+    LOG(WARNING) << "Failed to gzip the body of message '" << message->name
+                 << "' to " << message->to << ": " << compressed.error();
+    return false;
+  }
+
+  message->body = compressed.get();
+
+  return true;
+}
+
+
 Encoder* SocketManager::next(int s)
 {
-  HttpProxy* proxy = NULL; // Non-null if needs to be terminated.
+  bool proxied = false; // Whether the proxy needs to close 's'.
+  Encoder* encoder = NULL;
+
+  // A socket that we connected to a peer might get disposed, which
+  // requires locking the peer shard of its address first.
+  bool done = false;
+
+  while (!done) {
+    Option<Address> address = remote(s);
+
+    if (address.isSome()) {
+      synchronized (peerShard(address.get()).mutex) {
+        done = _next(s, address, &encoder, &proxied);
+      }
+    } else {
+      done = _next(s, address, &encoder, &proxied);
+    }
+  }
+
+  // We dispatch to the proxy outside the synchronized block to avoid
+  // possible deadlock between the ProcessManager and SocketManager.
+  if (proxied) {
+    dispatch(proxies[static_cast<size_t>(s) % proxies.size()],
+             &HttpProxy::close,
+             s);
+  }
+
+  return encoder;
+}
+
+
+bool SocketManager::_next(
+    int s,
+    const Option<Address>& _address,
+    Encoder** encoder,
+    bool* proxied)
+{
+  SocketShard& shard = socketShard(s);
+
+  synchronized (shard.mutex) {
+    if (!locked(s, _address)) {
+      return false;
+    }
 
-  synchronized (mutex) {
     // We cannot assume 'sockets.count(s) > 0' here because it's
     // possible that 's' has been removed with a a call to
     // SocketManager::close. For example, it could be the case that a
@@ -1770,37 +2783,73 @@ Encoder* SocketManager::next(int s)
     // invoked we find out there there is no more data and thus stop
     // sending.
     // TODO(benh): Should we actually finish sending the data!?
-    if (sockets.count(s) > 0) {
-      CHECK(outgoing.count(s) > 0);
+    if (shard.sockets.count(s) > 0) {
+      CHECK(shard.outgoing.count(s) > 0);
+
+      queue<Encoder*>& outgoing = shard.outgoing[s];
 
-      if (!outgoing[s].empty()) {
+      if (!outgoing.empty()) {
         // More messages!
-        Encoder* encoder = outgoing[s].front();
-        outgoing[s].pop();
-        return encoder;
+        Encoder* first = outgoing.front();
+        outgoing.pop();
+
+        // Coalesce the data of other queued encoders (that got
+        // queued while the previous write was in flight) into the
+        // same gather write, up to 'coalesce' bytes, so that many
+        // small messages to the same peer only cost a single
+        // system call and a single trip through the event loop.
+        if (first->kind() == Encoder::DATA) {
+          VectorEncoder* batch = reinterpret_cast<VectorEncoder*>(first);
+
+          size_t coalesced = 0;
+
+          while (!outgoing.empty() &&
+                 outgoing.front()->kind() == Encoder::DATA &&
+                 batch->count() < static_cast<size_t>(IOV_MAX) &&
+                 batch->remaining() + outgoing.front()->remaining() <=
+                   coalesce.bytes()) {
+            VectorEncoder* that =
+              reinterpret_cast<VectorEncoder*>(outgoing.front());
+            outgoing.pop();
+
+            batch->append(*that);
+            delete that;
+
+            coalesced++;
+          }
+
+          if (coalesced > 0) {
+            ++metrics.coalesced_writes;
+            metrics.coalesced_encoders += coalesced;
+          }
+        }
+
+        *encoder = first;
       } else {
         // No more messages ... erase the outgoing queue.
-        outgoing.erase(s);
+        shard.outgoing.erase(s);
 
-        if (dispose.count(s) > 0) {
+        if (shard.dispose.count(s) > 0) {
           // This is either a temporary socket we created or it's a
           // socket that we were receiving data from and possibly
           // sending HTTP responses back on. Clean up either way.
-          if (addresses.count(s) > 0) {
-            const Address& address = addresses[s];
-            CHECK(temps.count(address) > 0 && temps[address] == s);
-            temps.erase(address);
-            addresses.erase(s);
+          if (shard.addresses.count(s) > 0) {
+            // NOTE: The caller holds the lock of the peer shard.
+            const Address& address = shard.addresses[s];
+            PeerShard& peer = peerShard(address);
+            CHECK(peer.temps.count(address) > 0 && peer.temps[address] == s);
+            peer.temps.erase(address);
+            shard.addresses.erase(s);
           }
 
-          if (proxies.count(s) > 0) {
-            proxy = proxies[s];
-            proxies.erase(s);
+          if (shard.proxies.count(s) > 0) {
+            *proxied = true;
+            shard.proxies.erase(s);
           }
 
-          dispose.erase(s);
+          shard.dispose.erase(s);
 
-          auto iterator = sockets.find(s);
+          auto iterator = shard.sockets.find(s);
 
           // We don't actually close the socket (we wait for the Socket
           // abstraction to close it once there are no more references),
@@ -1811,7 +2860,7 @@ Encoder* SocketManager::next(int s)
           // map so that in the case where 'shutdown()' ends up
           // calling close the termination logic is not run twice.
           Socket* socket = iterator->second;
-          sockets.erase(iterator);
+          shard.sockets.erase(iterator);
 
           Try<Nothing> shutdown = socket->shutdown();
           if (shutdown.isError()) {
@@ -1825,62 +2874,112 @@ Encoder* SocketManager::next(int s)
     }
   }
 
-  // We terminate the proxy outside the synchronized block to avoid
-  // possible deadlock between the ProcessManager and SocketManager
-  // (see comment in SocketManager::proxy for more information).
-  if (proxy != NULL) {
-    terminate(proxy);
+  return true;
+}
+
+
+void SocketManager::close(int s)
+{
+  bool proxied = false; // Whether the proxy needs to close 's'.
+
+  // Closing a socket that we connected to a peer requires locking
+  // the peer shard of its address first.
+  bool done = false;
+
+  while (!done) {
+    Option<Address> address = remote(s);
+
+    if (address.isSome()) {
+      synchronized (peerShard(address.get()).mutex) {
+        done = _close(s, address, &proxied);
+      }
+    } else {
+      done = _close(s, address, &proxied);
+    }
   }
 
-  return NULL;
+  // We dispatch to the proxy outside the synchronized block to avoid
+  // possible deadlock between the ProcessManager and SocketManager.
+  if (proxied) {
+    dispatch(proxies[static_cast<size_t>(s) % proxies.size()],
+             &HttpProxy::close,
+             s);
+  }
+
+  // Note that we don't actually:
+  //
+  //   close(s);
+  //
+  // Because, for example, there could be a race between an HttpProxy
+  // trying to do send a response with SocketManager::send() or a
+  // process might be responding to another Request (e.g., trying
+  // to do a sendfile) since these things may be happening
+  // asynchronously we can't close the socket yet, because it might
+  // get reused before any of the above things have finished, and then
+  // we'll end up sending data on the wrong socket! Instead, we rely
+  // on the last reference of our Socket object to close the
+  // socket. Note, however, that since socket is no longer in
+  // 'sockets' any attempt to send with it will just get ignored.
+  // TODO(benh): Always do a 'shutdown(s, SHUT_RDWR)' since that
+  // should keep the file descriptor valid until the last Socket
+  // reference does a close but force all event loop watchers to stop?
 }
 
 
-void SocketManager::close(int s)
+bool SocketManager::_close(
+    int s,
+    const Option<Address>& _address,
+    bool* proxied)
 {
-  HttpProxy* proxy = NULL; // Non-null if needs to be terminated.
+  SocketShard& shard = socketShard(s);
+
+  synchronized (shard.mutex) {
+    if (!locked(s, _address)) {
+      return false;
+    }
 
-  synchronized (mutex) {
     // This socket might not be active if it was already asked to get
     // closed (e.g., a write on the socket failed so we try and close
     // it and then later the recv side of the socket gets closed so we
     // try and close it again). Thus, ignore the request if we don't
     // know about the socket.
-    if (sockets.count(s) > 0) {
+    if (shard.sockets.count(s) > 0) {
       // Clean up any remaining encoders for this socket.
-      if (outgoing.count(s) > 0) {
-        while (!outgoing[s].empty()) {
-          Encoder* encoder = outgoing[s].front();
+      if (shard.outgoing.count(s) > 0) {
+        while (!shard.outgoing[s].empty()) {
+          Encoder* encoder = shard.outgoing[s].front();
           delete encoder;
-          outgoing[s].pop();
+          shard.outgoing[s].pop();
         }
 
-        outgoing.erase(s);
+        shard.outgoing.erase(s);
       }
 
       // Clean up after sockets used for remote communication.
-      if (addresses.count(s) > 0) {
-        const Address& address = addresses[s];
+      if (shard.addresses.count(s) > 0) {
+        // NOTE: The caller holds the lock of the peer shard.
+        const Address& address = shard.addresses[s];
+        PeerShard& peer = peerShard(address);
 
         // Don't bother invoking exited unless socket was persistant.
-        if (persists.count(address) > 0 && persists[address] == s) {
-          persists.erase(address);
+        if (peer.persists.count(address) > 0 && peer.persists[address] == s) {
+          peer.persists.erase(address);
           exited(address); // Generate ExitedEvent(s)!
-        } else if (temps.count(address) > 0 && temps[address] == s) {
-          temps.erase(address);
+        } else if (peer.temps.count(address) > 0 && peer.temps[address] == s) {
+          peer.temps.erase(address);
         }
 
-        addresses.erase(s);
+        shard.addresses.erase(s);
       }
 
-      // Clean up any proxy associated with this socket.
-      if (proxies.count(s) > 0) {
-        proxy = proxies[s];
-        proxies.erase(s);
+      // Clean up any proxy connection associated with this socket.
+      if (shard.proxies.count(s) > 0) {
+        *proxied = true;
+        shard.proxies.erase(s);
       }
 
-      dispose.erase(s);
-      auto iterator = sockets.find(s);
+      shard.dispose.erase(s);
+      auto iterator = shard.sockets.find(s);
 
       // We need to stop any 'ignore_data' receivers as they may have
       // the last Socket reference so we shutdown recvs but don't do a
@@ -1896,7 +2995,7 @@ void SocketManager::close(int s)
       // that in the case where 'shutdown()' ends up calling close the
       // termination logic is not run twice.
       Socket* socket = iterator->second;
-      sockets.erase(iterator);
+      shard.sockets.erase(iterator);
 
       Try<Nothing> shutdown = socket->shutdown();
       if (shutdown.isError()) {
@@ -1908,29 +3007,7 @@ void SocketManager::close(int s)
     }
   }
 
-  // We terminate the proxy outside the synchronized block to avoid
-  // possible deadlock between the ProcessManager and SocketManager.
-  if (proxy != NULL) {
-    terminate(proxy);
-  }
-
-  // Note that we don't actually:
-  //
-  //   close(s);
-  //
-  // Because, for example, there could be a race between an HttpProxy
-  // trying to do send a response with SocketManager::send() or a
-  // process might be responding to another Request (e.g., trying
-  // to do a sendfile) since these things may be happening
-  // asynchronously we can't close the socket yet, because it might
-  // get reused before any of the above things have finished, and then
-  // we'll end up sending data on the wrong socket! Instead, we rely
-  // on the last reference of our Socket object to close the
-  // socket. Note, however, that since socket is no longer in
-  // 'sockets' any attempt to send with it will just get ignored.
-  // TODO(benh): Always do a 'shutdown(s, SHUT_RDWR)' since that
-  // should keep the file descriptor valid until the last Socket
-  // reference does a close but force all event loop watchers to stop?
+  return true;
 }
 
 
@@ -1940,31 +3017,33 @@ void SocketManager::exited(const Address& address)
   // into ProcessManager ... then we wouldn't have to convince
   // ourselves that the accesses to each Process object will always be
   // valid.
-  synchronized (mutex) {
-    if (!links.remotes.contains(address)) {
+  PeerShard& peer = peerShard(address);
+
+  synchronized (peer.mutex) {
+    if (!peer.links.remotes.contains(address)) {
       return; // No linkees for this socket address!
     }
 
-    foreach (const UPID& linkee, links.remotes[address]) {
+    foreach (const UPID& linkee, peer.links.remotes[address]) {
       // Find and notify the linkers.
-      CHECK(links.linkers.contains(linkee));
+      CHECK(peer.links.linkers.contains(linkee));
 
-      foreach (ProcessBase* linker, links.linkers[linkee]) {
+      foreach (ProcessBase* linker, peer.links.linkers[linkee]) {
         linker->enqueue(new ExitedEvent(linkee));
 
         // Remove the linkee pid from the linker.
-        CHECK(links.linkees.contains(linker));
+        CHECK(peer.links.linkees.contains(linker));
 
-        links.linkees[linker].erase(linkee);
-        if (links.linkees[linker].empty()) {
-          links.linkees.erase(linker);
+        peer.links.linkees[linker].erase(linkee);
+        if (peer.links.linkees[linker].empty()) {
+          peer.links.linkees.erase(linker);
         }
       }
 
-      links.linkers.erase(linkee);
+      peer.links.linkers.erase(linkee);
     }
 
-    links.remotes.erase(address);
+    peer.links.remotes.erase(address);
   }
 }
 
@@ -1981,104 +3060,143 @@ void SocketManager::exited(ProcessBase* process)
   // can update the clocks of linked processes as appropriate.
   const Time time = Clock::now(process);
 
-  synchronized (mutex) {
-    // If this process had linked to anything, we need to clean
-    // up any pointers to it. Also, if this process was the last
-    // linker to a remote linkee, we must remove linkee from the
-    // remotes!
-    if (links.linkees.contains(process)) {
-      foreach (const UPID& linkee, links.linkees[process]) {
-        CHECK(links.linkers.contains(linkee));
+  // If this process had linked to anything, we need to clean up any
+  // pointers to it. Also, if this process was the last linker to a
+  // remote linkee, we must remove linkee from the remotes! Since the
+  // links live in the shard of the linkee, this process might have
+  // linked to linkees in any shard.
+  for (size_t i = 0; i < SHARDS; i++) {
+    PeerShard& peer = peerShards[i];
+
+    synchronized (peer.mutex) {
+      if (!peer.links.linkees.contains(process)) {
+        continue;
+      }
+
+      foreach (const UPID& linkee, peer.links.linkees[process]) {
+        CHECK(peer.links.linkers.contains(linkee));
 
-        links.linkers[linkee].erase(process);
-        if (links.linkers[linkee].empty()) {
-          links.linkers.erase(linkee);
+        peer.links.linkers[linkee].erase(process);
+        if (peer.links.linkers[linkee].empty()) {
+          peer.links.linkers.erase(linkee);
 
           // The exited process was the last linker for this linkee,
           // so we need to remove the linkee from the remotes.
           if (linkee.address != __address__) {
-            CHECK(links.remotes.contains(linkee.address));
+            CHECK(peer.links.remotes.contains(linkee.address));
 
-            links.remotes[linkee.address].erase(linkee);
-            if (links.remotes[linkee.address].empty()) {
-              links.remotes.erase(linkee.address);
+            peer.links.remotes[linkee.address].erase(linkee);
+            if (peer.links.remotes[linkee.address].empty()) {
+              peer.links.remotes.erase(linkee.address);
             }
           }
         }
       }
-      links.linkees.erase(process);
+      peer.links.linkees.erase(process);
     }
+  }
+
+  PeerShard& peer = peerShard(pid.address);
 
+  synchronized (peer.mutex) {
     // Find the linkers to notify.
-    if (!links.linkers.contains(pid)) {
+    if (!peer.links.linkers.contains(pid)) {
       return; // No linkers for this process!
     }
 
-    foreach (ProcessBase* linker, links.linkers[pid]) {
+    foreach (ProcessBase* linker, peer.links.linkers[pid]) {
       CHECK(linker != process) << "Process linked with itself";
       Clock::update(linker, time);
       linker->enqueue(new ExitedEvent(pid));
 
       // Remove the linkee pid from the linker.
-      CHECK(links.linkees.contains(linker));
+      CHECK(peer.links.linkees.contains(linker));
 
-      links.linkees[linker].erase(pid);
-      if (links.linkees[linker].empty()) {
-        links.linkees.erase(linker);
+      peer.links.linkees[linker].erase(pid);
+      if (peer.links.linkees[linker].empty()) {
+        peer.links.linkees.erase(linker);
       }
     }
 
-    links.linkers.erase(pid);
+    peer.links.linkers.erase(pid);
   }
 }
 
 
-void SocketManager::swap_implementing_socket(const Socket& from, Socket* to)
+void SocketManager::swap_implementing_socket(
+    const Address& address,
+    const Socket& from,
+    Socket* to)
 {
   const int from_fd = from.get();
   const int to_fd = to->get();
 
-  // Make sure the 'from' and 'to' are valid to swap.
-  CHECK(sockets.count(from_fd) > 0);
-  CHECK(sockets.count(to_fd) == 0);
+  PeerShard& peer = peerShard(address);
+  SocketShard& source = socketShard(from_fd);
+  SocketShard& destination = socketShard(to_fd);
+
+  // Lock the socket shards in the order of their index (see
+  // 'SHARDS'), which might be the same shard.
+  SocketShard* first = std::min(&source, &destination);
+  SocketShard* second = std::max(&source, &destination);
+
+  bool proxied = false; // Whether the proxy needs to close 'from'.
+
+  synchronized (peer.mutex) {
+    synchronized (first->mutex) {
+      synchronized (second->mutex) {
+        // Make sure the 'from' and 'to' are valid to swap.
+        CHECK(source.sockets.count(from_fd) > 0);
+        CHECK(destination.sockets.count(to_fd) == 0);
+        CHECK(source.addresses.count(from_fd) > 0);
+        CHECK(source.addresses[from_fd] == address);
+
+        source.sockets.erase(from_fd);
+        destination.sockets[to_fd] = to;
+
+        // Update the dispose set if this is a temporary link.
+        if (source.dispose.count(from_fd) > 0) {
+          destination.dispose.insert(to_fd);
+          source.dispose.erase(from_fd);
+        }
 
-  synchronized (mutex) {
-    sockets.erase(from_fd);
-    sockets[to_fd] = to;
+        // Update the fd that this address is associated with. Once
+        // we've done this we can update the 'temps' and 'persists'
+        // datastructures using this updated address.
+        destination.addresses[to_fd] = address;
+        source.addresses.erase(from_fd);
 
-    // Update the dispose set if this is a temporary link.
-    if (dispose.count(from_fd) > 0) {
-      dispose.insert(to_fd);
-      dispose.erase(from_fd);
-    }
+        // If this address is a temporary link.
+        if (peer.temps.count(address) > 0) {
+          peer.temps[address] = to_fd;
+          // No need to erase as we're changing the value, not the key.
+        }
 
-    // Update the fd that this address is associated with. Once we've
-    // done this we can update the 'temps' and 'persists'
-    // datastructures using this updated address.
-    addresses[to_fd] = addresses[from_fd];
-    addresses.erase(from_fd);
+        // If this address is a persistent link.
+        if (peer.persists.count(address) > 0) {
+          peer.persists[address] = to_fd;
+          // No need to erase as we're changing the value, not the key.
+        }
 
-    // If this address is a temporary link.
-    if (temps.count(addresses[to_fd]) > 0) {
-      temps[addresses[to_fd]] = to_fd;
-      // No need to erase as we're changing the value, not the key.
-    }
+        // Move any encoders queued against this link to the new socket.
+        destination.outgoing[to_fd] = std::move(source.outgoing[from_fd]);
+        source.outgoing.erase(from_fd);
 
-    // If this address is a persistent link.
-    if (persists.count(addresses[to_fd]) > 0) {
-      persists[addresses[to_fd]] = to_fd;
-      // No need to erase as we're changing the value, not the key.
+        // The connection of the proxy holds on to the 'from' socket,
+        // so it gets closed, and any further requests are handled by
+        // a connection on the 'to' socket.
+        if (source.proxies.count(from_fd) > 0) {
+          proxied = true;
+          source.proxies.erase(from_fd);
+        }
+      }
     }
+  }
 
-    // Move any encoders queued against this link to the new socket.
-    outgoing[to_fd] = std::move(outgoing[from_fd]);
-    outgoing.erase(from_fd);
-
-    // Update the fd any proxies are associated with.
-    if (proxies.count(from_fd) > 0) {
-      proxies[to_fd] = proxies[from_fd];
-      proxies.erase(from_fd);
-    }
+  if (proxied) {
+    dispatch(proxies[static_cast<size_t>(from_fd) % proxies.size()],
+             &HttpProxy::close,
+             from_fd);
   }
 }
 
@@ -2086,7 +3204,18 @@ void SocketManager::swap_implementing_socket(const Socket& from, Socket* to)
 ProcessManager::ProcessManager(const string& _delegate)
   : delegate(_delegate)
 {
-  running.store(0);
+  next_runq.store(0);
+  runnable.store(0);
+
+  Option<string> value = os::getenv("LIBPROCESS_MAX_REQUEST_BODY_BYTES");
+  if (value.isSome()) {
+    Try<Bytes> bytes = Bytes::parse(value.get());
+    if (bytes.isError()) {
+      LOG(FATAL) << "Parsing LIBPROCESS_MAX_REQUEST_BODY_BYTES=" << value.get()
+                 << " failed: " << bytes.error();
+    }
+    max_request_body_size = bytes.get();
+  }
 }
 
 
@@ -2119,6 +3248,19 @@ ProcessManager::~ProcessManager()
     thread->join();
     delete thread;
   }
+
+  foreach (RunQueue* runq, runqs) {
+    delete runq;
+  }
+
+  // NOTE: Every dedicated process has been terminated above, so this
+  // only waits for their threads to exit.
+  synchronized (dedicated_threads_mutex) {
+    foreach (DedicatedThread* thread, dedicated_threads) {
+      delete thread;
+    }
+    dedicated_threads.clear();
+  }
 }
 
 
@@ -2138,18 +3280,27 @@ long ProcessManager::init_threads()
   long cpus = std::max(8L, sysconf(_SC_NPROCESSORS_ONLN));
   threads.reserve(cpus+1);
 
+  // Create the run queues before any of the processing threads so
+  // that 'runqs' never changes while the threads are running.
+  runqs.reserve(cpus);
+  for (long i = 0; i < cpus; i++) {
+    runqs.push_back(new RunQueue());
+  }
+
   // Create processing threads.
   for (long i = 0; i < cpus; i++) {
     // Retain the thread handles so that we can join when shutting down.
     threads.emplace_back(
         // We pass a constant reference to `joining` to make it clear that this
         // value is only being tested (read), and not manipulated.
-        new std::thread(std::bind([](const std::atomic_bool& joining) {
+        new std::thread(std::bind([](const std::atomic_bool& joining,
+                                     long worker) {
+          __worker__ = worker;
           do {
-            ProcessBase* process = process_manager->dequeue();
+            ProcessBase* process = process_manager->dequeue(worker);
             if (process == NULL) {
               Gate::state_t old = gate->approach();
-              process = process_manager->dequeue();
+              process = process_manager->dequeue(worker);
               if (process == NULL) {
                 if (joining.load()) {
                   break;
@@ -2163,7 +3314,8 @@ long ProcessManager::init_threads()
             process_manager->resume(process);
           } while (true);
         },
-        std::cref(joining_threads))));
+        std::cref(joining_threads),
+        i)));
   }
 
   // Create a thread for the event loop.
@@ -2201,6 +3353,8 @@ void ProcessManager::handle(
   if (libprocess(request)) {
     Message* message = parse(request);
     if (message != NULL) {
+      socket_manager->negotiate(message->from.address, *request);
+
       // TODO(benh): Use the sender PID when delivering in order to
       // capture happens-before timing relationships for testing.
       bool accepted = deliver(message->to, new MessageEvent(message));
@@ -2218,11 +3372,11 @@ void ProcessManager::handle(
       if (agent.getOrElse("").find("libprocess/") == string::npos) {
         if (accepted) {
           VLOG(2) << "Accepted libprocess message to " << request->url.path;
-          dispatch(proxy, &HttpProxy::enqueue, Accepted(), *request);
+          dispatch(proxy, &HttpProxy::enqueue, socket, Accepted(), *request);
         } else {
           VLOG(1) << "Failed to handle libprocess message to "
                   << request->url.path << ": not found";
-          dispatch(proxy, &HttpProxy::enqueue, NotFound(), *request);
+          dispatch(proxy, &HttpProxy::enqueue, socket, NotFound(), *request);
         }
       }
 
@@ -2248,7 +3402,7 @@ void ProcessManager::handle(
 
     // Enqueue the response with the HttpProxy so that it respects the
     // order of requests to account for HTTP/1.1 pipelining.
-    dispatch(proxy, &HttpProxy::enqueue, BadRequest(), *request);
+    dispatch(proxy, &HttpProxy::enqueue, socket, BadRequest(), *request);
 
     // Cleanup request.
     delete request;
@@ -2265,29 +3419,37 @@ void ProcessManager::handle(
 
     // Enqueue the response with the HttpProxy so that it respects the
     // order of requests to account for HTTP/1.1 pipelining.
-    dispatch(proxy, &HttpProxy::enqueue, NotFound(), *request);
+    dispatch(proxy, &HttpProxy::enqueue, socket, NotFound(), *request);
 
     // Cleanup request.
     delete request;
     return;
   }
 
-  // Split the path by '/'.
-  vector<string> tokens = strings::tokenize(request->url.path, "/");
+  // The receiver is the process named by the first component of the
+  // path, which we find without splitting the whole path.
+  const size_t start = request->url.path.find_first_not_of('/');
 
   // Try and determine a receiver, otherwise try and delegate.
   ProcessReference receiver;
 
-  if (tokens.size() == 0 && delegate != "") {
+  if (start == string::npos && delegate != "") {
     request->url.path = "/" + delegate;
     receiver = use(UPID(delegate, __address__));
-  } else if (tokens.size() > 0) {
+  } else if (start != string::npos) {
+    string id = request->url.path.substr(
+        start, request->url.path.find('/', start) - start);
+
     // Decode possible percent-encoded path.
-    Try<string> decode = http::decode(tokens[0]);
-    if (!decode.isError()) {
-      receiver = use(UPID(decode.get(), __address__));
+    if (id.find_first_of("%+") != string::npos) {
+      Try<string> decode = http::decode(id);
+      if (!decode.isError()) {
+        receiver = use(UPID(decode.get(), __address__));
+      } else {
+        VLOG(1) << "Failed to decode URL path: " << decode.error();
+      }
     } else {
-      VLOG(1) << "Failed to decode URL path: " << decode.error();
+      receiver = use(UPID(id, __address__));
     }
   }
 
@@ -2317,6 +3479,7 @@ void ProcessManager::handle(
         dispatch(
             proxy,
             &HttpProxy::enqueue,
+            socket,
             rejection.get(),
             *request);
 
@@ -2336,7 +3499,7 @@ void ProcessManager::handle(
 
     // Enqueue the response with the HttpProxy so that it respects the
     // order of requests to account for HTTP/1.1 pipelining.
-    dispatch(proxy, &HttpProxy::handle, promise->future(), *request);
+    dispatch(proxy, &HttpProxy::handle, socket, promise->future(), *request);
 
     // TODO(benh): Use the sender PID in order to capture
     // happens-before timing relationships for testing.
@@ -2352,7 +3515,7 @@ void ProcessManager::handle(
 
   // Enqueue the response with the HttpProxy so that it respects the
   // order of requests to account for HTTP/1.1 pipelining.
-  dispatch(proxy, &HttpProxy::enqueue, NotFound(), *request);
+  dispatch(proxy, &HttpProxy::enqueue, socket, NotFound(), *request);
 
   // Cleanup request.
   delete request;
@@ -2399,18 +3562,116 @@ bool ProcessManager::deliver(
 }
 
 
-UPID ProcessManager::spawn(ProcessBase* process, bool manage)
+// Pins the thread to the specified CPU.
+static Try<Nothing> pin(std::thread* thread, int cpu)
+{
+#ifdef __linux__
+  if (cpu < 0 || cpu >= CPU_SETSIZE) {
+    return Error("Invalid CPU");
+  }
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+
+  int error =
+    pthread_setaffinity_np(thread->native_handle(), sizeof(set), &set);
+  if (error != 0) {
+    return Error(os::strerror(error));
+  }
+
+  return Nothing();
+#else
+  return Error("Not supported on this platform");
+#endif // __linux__
+}
+
+
+UPID ProcessManager::spawn(
+    ProcessBase* process,
+    bool manage,
+    const SpawnOptions& options)
 {
   CHECK(process != NULL);
 
+  if (options.dedicated) {
+    // Reclaim the threads of dedicated processes that have
+    // terminated since a dedicated process was last spawned.
+    reap();
+
+    // A dedicated process never goes on a run queue, so its thread
+    // must be set before the process can get enqueued (i.e., before
+    // the process gets added to 'processes' below).
+    DedicatedThread* thread = new DedicatedThread(process);
+    thread->thread = new std::thread(&ProcessManager::run, this, thread);
+
+    if (options.cpu.isSome()) {
+      Try<Nothing> pinned = pin(thread->thread, options.cpu.get());
+      if (pinned.isError()) {
+        LOG(WARNING) << "Failed to pin the thread of dedicated process "
+                     << process->pid << " to CPU " << options.cpu.get()
+                     << ": " << pinned.error();
+      } else {
+        thread->cpu = options.cpu.get();
+      }
+    }
+
+    process->dedicated = thread;
+  }
+
+  // Like the thread of a dedicated process, the event queue must be
+  // instrumented before any events can get enqueued.
+  if (options.mailboxMetrics) {
+    process->mailbox.reset(new MailboxMetrics());
+    process->events->instrument(process->mailbox.get());
+  }
+
   synchronized (processes_mutex) {
     if (processes.count(process->pid.id) > 0) {
+      // Stops the thread that was created above, if any.
+      delete process->dedicated;
+      process->dedicated = NULL;
+
+      process->events->instrument(NULL);
+      process->mailbox.reset();
+
       return UPID();
     } else {
       processes[process->pid.id] = process;
     }
   }
 
+  if (process->dedicated != NULL) {
+    DedicatedThread* thread = process->dedicated;
+
+    synchronized (dedicated_threads_mutex) {
+      dedicated_threads.push_back(thread);
+    }
+
+    // NOTE: The gauge gets evaluated by the garbage collector rather
+    // than the dedicated process so that collecting the metrics does
+    // not interfere with the process.
+    const double cpu = thread->cpu.isSome() ? thread->cpu.get() : -1;
+
+    thread->gauge = metrics::Gauge(
+        "libprocess/dedicated_processes/" + process->pid.id + "/cpu",
+        defer(gc, [cpu]() -> Future<double> { return cpu; }));
+
+    metrics::add(thread->gauge.get());
+  }
+
+  if (process->mailbox) {
+    // NOTE: See the comment about the dedicated thread gauge above.
+    process->mailbox->gauges = MailboxMetrics::createGauges(
+        "libprocess/processes/" + process->pid.id + "/mailbox/",
+        process->mailbox,
+        gc);
+
+    foreach (const metrics::Gauge& gauge, process->mailbox->gauges) {
+      metrics::add(gauge);
+    }
+  }
+
   // Use the garbage collector if requested.
   if (manage) {
     dispatch(gc, &GarbageCollector::manage<ProcessBase>, process);
@@ -2431,10 +3692,65 @@ UPID ProcessManager::spawn(ProcessBase* process, bool manage)
 }
 
 
+void ProcessManager::run(DedicatedThread* thread)
+{
+  while (true) {
+    if (!thread->ready.exchange(false)) {
+      Gate::state_t old = thread->gate.approach();
+      if (!thread->ready.exchange(false)) {
+        if (thread->terminated.load()) {
+          thread->gate.leave();
+          break;
+        }
+        thread->gate.arrive(old); // Wait at gate if idle.
+        continue;
+      } else {
+        thread->gate.leave();
+      }
+    }
+
+    resume(thread->process);
+
+    if (thread->terminated.load()) {
+      break;
+    }
+  }
+}
+
+
+void ProcessManager::reap()
+{
+  list<DedicatedThread*> terminated;
+
+  synchronized (dedicated_threads_mutex) {
+    list<DedicatedThread*>::iterator it = dedicated_threads.begin();
+    while (it != dedicated_threads.end()) {
+      if ((*it)->terminated.load()) {
+        terminated.push_back(*it);
+        it = dedicated_threads.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  foreach (DedicatedThread* thread, terminated) {
+    delete thread;
+  }
+}
+
+
 void ProcessManager::resume(ProcessBase* process)
 {
   __process__ = process;
 
+  // Remember which processing thread ran this process so that it
+  // gets enqueued back onto the same thread's run queue (threads
+  // that are only donated to a process via 'wait' don't count).
+  if (__worker__ >= 0) {
+    process->worker.store(__worker__);
+  }
+
   VLOG(2) << "Resuming " << process->pid << " at " << Clock::now();
 
   bool terminate = false;
@@ -2450,91 +3766,113 @@ void ProcessManager::resume(ProcessBase* process)
   }
 
   while (!terminate && !blocked) {
-    Event* event = NULL;
-
-    synchronized (process->mutex) {
-      if (process->events.size() > 0) {
-        event = process->events.front();
-        process->events.pop_front();
-        process->state = ProcessBase::RUNNING;
-      } else {
-        process->state = ProcessBase::BLOCKED;
+    Event* event = process->events->dequeue();
+
+    if (event == NULL) {
+      // Producers first enqueue an event and then check if the
+      // process is BLOCKED (see ProcessBase::enqueue), so after
+      // blocking we need to check for any events that might have
+      // been enqueued in the meantime. If there are, we try to
+      // unblock the process ourselves, which fails if a producer
+      // has already made the process READY (and thus enqueued it).
+      process->state = ProcessBase::BLOCKED;
+
+      if (process->events->empty()) {
         blocked = true;
+      } else {
+        ProcessBase::ProcessState expected = ProcessBase::BLOCKED;
+        if (!process->state.compare_exchange_strong(
+                expected, ProcessBase::RUNNING)) {
+          blocked = true;
+        }
       }
+
+      continue;
     }
 
-    if (!blocked) {
-      CHECK(event != NULL);
+    process->state = ProcessBase::RUNNING;
 
-      // Determine if we should filter this event.
-      synchronized (filterer_mutex) {
-        if (filterer != NULL) {
-          bool filter = false;
-          struct FilterVisitor : EventVisitor
-          {
-            explicit FilterVisitor(bool* _filter) : filter(_filter) {}
+    // Determine if we should filter this event.
+    synchronized (filterer_mutex) {
+      if (filterer != NULL) {
+        bool filter = false;
+        struct FilterVisitor : EventVisitor
+        {
+          explicit FilterVisitor(bool* _filter) : filter(_filter) {}
 
-            virtual void visit(const MessageEvent& event)
-            {
-              *filter = filterer->filter(event);
-            }
+          virtual void visit(const MessageEvent& event)
+          {
+            *filter = filterer->filter(event);
+          }
 
-            virtual void visit(const DispatchEvent& event)
-            {
-              *filter = filterer->filter(event);
-            }
+          virtual void visit(const DispatchEvent& event)
+          {
+            *filter = filterer->filter(event);
+          }
 
-            virtual void visit(const HttpEvent& event)
-            {
-              *filter = filterer->filter(event);
-            }
+          virtual void visit(const HttpEvent& event)
+          {
+            *filter = filterer->filter(event);
+          }
 
-            virtual void visit(const ExitedEvent& event)
-            {
-              *filter = filterer->filter(event);
-            }
+          virtual void visit(const ExitedEvent& event)
+          {
+            *filter = filterer->filter(event);
+          }
 
-            bool* filter;
-          } visitor(&filter);
+          bool* filter;
+        } visitor(&filter);
 
-          event->visit(&visitor);
+        event->visit(&visitor);
 
-          if (filter) {
-            delete event;
-            continue; // Try and execute the next event.
-          }
+        if (filter) {
+          delete event;
+          continue; // Try and execute the next event.
         }
       }
+    }
 
-      // Determine if we should terminate.
-      terminate = event->is<TerminateEvent>();
-
-      // Now service the event.
-      try {
-        process->serve(*event);
-      } catch (const std::exception& e) {
-        std::cerr << "libprocess: " << process->pid
-                  << " terminating due to "
-                  << e.what() << std::endl;
-        terminate = true;
-      } catch (...) {
-        std::cerr << "libprocess: " << process->pid
-                  << " terminating due to unknown exception" << std::endl;
-        terminate = true;
-      }
+    // Determine if we should terminate.
+    terminate = event->is<TerminateEvent>();
+
+    const int64_t start = process->mailbox ? MailboxMetrics::now() : 0;
+
+    const bool profiling = ActorProfiler::running();
+    const int64_t cpu = profiling ? ActorProfiler::cpu() : 0;
+
+    // Now service the event.
+    try {
+      process->serve(*event);
+    } catch (const std::exception& e) {
+      std::cerr << "libprocess: " << process->pid
+                << " terminating due to "
+                << e.what() << std::endl;
+      terminate = true;
+    } catch (...) {
+      std::cerr << "libprocess: " << process->pid
+                << " terminating due to unknown exception" << std::endl;
+      terminate = true;
+    }
 
-      delete event;
+    if (process->mailbox) {
+      process->mailbox->served(*event, MailboxMetrics::now() - start);
+    }
 
-      if (terminate) {
-        cleanup(process);
-      }
+    if (profiling) {
+      ActorProfiler::record(process->pid, *event, ActorProfiler::cpu() - cpu);
+    }
+
+    delete event;
+
+    if (terminate) {
+      cleanup(process);
     }
   }
 
   __process__ = NULL;
 
-  CHECK_GE(running.load(), 1);
-  running.fetch_sub(1);
+  CHECK_GE(runnable.load(), 1);
+  runnable.fetch_sub(1);
 }
 
 
@@ -2542,6 +3880,10 @@ void ProcessManager::cleanup(ProcessBase* process)
 {
   VLOG(2) << "Cleaning up " << process->pid;
 
+  // The process might get deallocated below, see 'run'.
+  DedicatedThread* dedicated = process->dedicated;
+  std::shared_ptr<MailboxMetrics> mailbox = process->mailbox;
+
   // First, set the terminating state so no more events will get
   // enqueued and delete al the pending events. We want to delete the
   // events before we hold the processes lock because deleting an
@@ -2552,21 +3894,27 @@ void ProcessManager::cleanup(ProcessBase* process)
   // the process we are cleaning up will get dropped (since it's
   // terminating) and eliminates the potential of enqueueing them on
   // another process that gets spawned with the same PID.
-  deque<Event*> events;
-
-  synchronized (process->mutex) {
-    process->state = ProcessBase::TERMINATING;
-    events = process->events;
-    process->events.clear();
-  }
+  process->state = ProcessBase::TERMINATING;
 
   // Delete pending events.
-  while (!events.empty()) {
-    Event* event = events.front();
-    events.pop_front();
+  Event* event = NULL;
+  while ((event = process->events->dequeue()) != NULL) {
     delete event;
   }
 
+  // Stop streaming the request bodies for the routes of the process.
+  foreachpair (const string& name,
+               const ProcessBase::RouteOptions& options,
+               process->handlers.options) {
+    if (options.requestStreaming) {
+      stream("/" + process->pid.id + "/" + name, false);
+    }
+  }
+
+  // Events that got enqueued by producers that observed the process
+  // before it was TERMINATING (see below).
+  vector<Event*> events;
+
   // Possible gate non-libprocess threads are waiting at.
   Gate* gate = NULL;
 
@@ -2579,23 +3927,32 @@ void ProcessManager::cleanup(ProcessBase* process)
 #endif
     }
 
-    synchronized (process->mutex) {
-      CHECK(process->events.empty());
+    // Since enqueueing an event doesn't synchronize with setting
+    // the process to TERMINATING, a producer that observed the
+    // process before it was TERMINATING might have enqueued an event
+    // after we deleted the pending events above. Such a producer
+    // holds a reference, so now that all references are gone no
+    // more events can get enqueued. We delete these events once we
+    // are no longer holding the processes lock (see above).
+    while ((event = process->events->dequeue()) != NULL) {
+      events.push_back(event);
+    }
 
-      processes.erase(process->pid.id);
+    CHECK(process->events->empty());
 
-      // Lookup gate to wake up waiting threads.
-      map<ProcessBase*, Gate*>::iterator it = gates.find(process);
-      if (it != gates.end()) {
-        gate = it->second;
-        // N.B. The last thread that leaves the gate also free's it.
-        gates.erase(it);
-      }
+    processes.erase(process->pid.id);
 
-      CHECK(process->refs.load() == 0);
-      process->state = ProcessBase::TERMINATED;
+    // Lookup gate to wake up waiting threads.
+    map<ProcessBase*, Gate*>::iterator it = gates.find(process);
+    if (it != gates.end()) {
+      gate = it->second;
+      // N.B. The last thread that leaves the gate also free's it.
+      gates.erase(it);
     }
 
+    CHECK(process->refs.load() == 0);
+    process->state = ProcessBase::TERMINATED;
+
     // Note that we don't remove the process from the clock during
     // cleanup, but rather the clock is reset for a process when it is
     // created (see ProcessBase::ProcessBase). We do this so that
@@ -2633,6 +3990,24 @@ void ProcessManager::cleanup(ProcessBase* process)
       gate->open();
     }
   }
+
+  foreach (Event* event, events) {
+    delete event;
+  }
+
+  if (mailbox) {
+    foreach (const metrics::Gauge& gauge, mailbox->gauges) {
+      metrics::remove(gauge);
+    }
+  }
+
+  if (dedicated != NULL) {
+    if (dedicated->gauge.isSome()) {
+      metrics::remove(dedicated->gauge.get());
+    }
+
+    dedicated->terminated.store(true);
+  }
 }
 
 
@@ -2707,23 +4082,13 @@ bool ProcessManager::wait(const UPID& pid)
       // Check if it is runnable in order to donate this thread.
       if (process->state == ProcessBase::BOTTOM ||
           process->state == ProcessBase::READY) {
-        synchronized (runq_mutex) {
-          list<ProcessBase*>::iterator it =
-            find(runq.begin(), runq.end(), process);
-          if (it != runq.end()) {
-            // Found it! Remove it from the run queue since we'll be
-            // donating our thread and also increment 'running' before
-            // leaving this 'runq' protected critical section so that
-            // everyone that is waiting for the processes to settle
-            // continue to wait (otherwise they could see nothing in
-            // 'runq' and 'running' equal to 0 between when we exit
-            // this critical section and increment 'running').
-            runq.erase(it);
-            running.fetch_add(1);
-          } else {
-            // Another thread has resumed the process ...
-            process = NULL;
-          }
+        // Remove it from the run queue since we'll be donating our
+        // thread. Note that 'runnable' stays incremented while we
+        // resume the process so that everyone that is waiting for
+        // the processes to settle continues to wait.
+        if (!remove(process)) {
+          // Another thread has resumed the process ...
+          process = NULL;
         }
       } else {
         // Process is not runnable, so no need to donate ...
@@ -2797,6 +4162,47 @@ string ProcessManager::absolutePath(const string& path)
 }
 
 
+void ProcessManager::stream(const string& path, bool streaming)
+{
+  synchronized (streaming_mutex) {
+    if (streaming) {
+      streaming_routes.insert(path);
+    } else {
+      streaming_routes.erase(path);
+    }
+  }
+}
+
+
+bool ProcessManager::streaming(const Request& request)
+{
+  // The body of a libprocess message is always needed as a whole.
+  if (libprocess(&request)) {
+    return false;
+  }
+
+  // TODO(bmahler): Account for delegation and percent-encoded ids
+  // (such requests get their whole body buffered instead).
+  string path = request.url.path;
+
+  synchronized (streaming_mutex) {
+    if (streaming_routes.empty()) {
+      return false;
+    }
+
+    while (Path(path).dirname() != path) {
+      if (streaming_routes.count(path) > 0) {
+        return true;
+      }
+
+      path = Path(path).dirname();
+    }
+  }
+
+  return false;
+}
+
+
 void ProcessManager::enqueue(ProcessBase* process)
 {
   CHECK(process != NULL);
@@ -2810,14 +4216,38 @@ void ProcessManager::enqueue(ProcessBase* process)
     return;
   }
 
-  // TODO(benh): Check and see if this process has it's own thread. If
-  // it does, push it on that threads runq, and wake up that thread if
-  // it's not running. Otherwise, check and see which thread this
-  // process was last running on, and put it on that threads runq.
+  // A dedicated process only ever runs on its own thread, so we just
+  // wake up that thread.
+  if (process->dedicated != NULL) {
+    runnable.fetch_add(1);
+    process->dedicated->ready.store(true);
+    process->dedicated->gate.open();
+    return;
+  }
+
+  // Put the process on the run queue of the thread it was last
+  // running on. A process that has never run gets put on the run
+  // queue of the current processing thread (if any), otherwise we
+  // pick a run queue round-robin.
+  long worker = process->worker.load();
+  if (worker < 0) {
+    worker = __worker__ >= 0
+      ? __worker__
+      : next_runq.fetch_add(1) % runqs.size();
+  }
+
+  CHECK_LT(worker, static_cast<long>(runqs.size()));
+
+  RunQueue* runq = runqs[worker];
 
-  synchronized (runq_mutex) {
-    CHECK(find(runq.begin(), runq.end(), process) == runq.end());
-    runq.push_back(process);
+  // Increment 'runnable' before the process becomes visible on the
+  // run queue so that it can never be decremented (in 'resume')
+  // before having been incremented.
+  runnable.fetch_add(1);
+
+  synchronized (runq->mutex) {
+    runq->processes.push_back(process);
+    runq->size.fetch_add(1);
   }
 
   // Wake up the processing thread if necessary.
@@ -2825,26 +4255,51 @@ void ProcessManager::enqueue(ProcessBase* process)
 }
 
 
-ProcessBase* ProcessManager::dequeue()
+ProcessBase* ProcessManager::dequeue(long worker)
 {
-  // TODO(benh): Remove a process from this thread's runq. If there
-  // are no processes to run, and this is not a dedicated thread, then
-  // steal one from another threads runq.
+  // Remove a process from this thread's run queue. If there are no
+  // processes to run then steal one from another thread's run queue.
+  // We always take the process at the front of a run queue (i.e.,
+  // the one that has been waiting the longest) to preserve fairness.
+  //
+  // NOTE: Dedicated processes never go on a run queue so they never
+  // get stolen (see 'enqueue').
+  for (size_t i = 0; i < runqs.size(); i++) {
+    RunQueue* runq = runqs[(worker + i) % runqs.size()];
 
-  ProcessBase* process = NULL;
+    if (runq->size.load() == 0) {
+      continue;
+    }
+
+    synchronized (runq->mutex) {
+      if (!runq->processes.empty()) {
+        ProcessBase* process = runq->processes.front();
+        runq->processes.pop_front();
+        runq->size.fetch_sub(1);
+        return process;
+      }
+    }
+  }
 
-  synchronized (runq_mutex) {
-    if (!runq.empty()) {
-      process = runq.front();
-      runq.pop_front();
-      // Increment the running count of processes in order to support
-      // the Clock::settle() operation (this must be done atomically
-      // with removing the process from the runq).
-      running.fetch_add(1);
+  return NULL;
+}
+
+
+bool ProcessManager::remove(ProcessBase* process)
+{
+  foreach (RunQueue* runq, runqs) {
+    synchronized (runq->mutex) {
+      deque<ProcessBase*>::iterator it =
+        find(runq->processes.begin(), runq->processes.end(), process);
+      if (it != runq->processes.end()) {
+        runq->processes.erase(it);
+        runq->size.fetch_sub(1);
+        return true;
+      }
     }
   }
 
-  return process;
+  return false;
 }
 
 
@@ -2868,21 +4323,16 @@ void ProcessManager::settle()
 
     done = true; // Assume to start that we are settled.
 
-    synchronized (runq_mutex) {
-      if (!runq.empty()) {
-        done = false;
-        continue;
-      }
-
-      if (running.load() > 0) {
-        done = false;
-        continue;
-      }
+    // Note that 'runnable' accounts for both the processes on any of
+    // the run queues and the processes that are currently running.
+    if (runnable.load() > 0) {
+      done = false;
+      continue;
+    }
 
-      if (!Clock::settled()) {
-        done = false;
-        continue;
-      }
+    if (!Clock::settled()) {
+      done = false;
+      continue;
     }
   } while (!done);
 }
@@ -2897,6 +4347,18 @@ Future<Response> ProcessManager::__processes__(const Request&)
       JSON::Object object;
       object.values["id"] = process->pid.id;
 
+      if (process->dedicated != NULL) {
+        object.values["dedicated"] = JSON::Boolean(true);
+
+        if (process->dedicated->cpu.isSome()) {
+          object.values["cpu"] = process->dedicated->cpu.get();
+        }
+      }
+
+      if (process->mailbox) {
+        object.values["mailbox"] = process->mailbox->json();
+      }
+
       JSON::Array events;
 
       struct JSONVisitor : EventVisitor
@@ -2955,11 +4417,7 @@ Future<Response> ProcessManager::__processes__(const Request&)
         JSON::Array* events;
       } visitor(&events);
 
-      synchronized (process->mutex) {
-        foreach (Event* event, process->events) {
-          event->visit(&visitor);
-        }
-      }
+      process->events->visit(&visitor);
 
       object.values["events"] = events;
       array.values.push_back(object);
@@ -2976,8 +4434,14 @@ ProcessBase::ProcessBase(const string& id)
 
   state = ProcessBase::BOTTOM;
 
+  events = new EventQueue();
+
   refs = 0;
 
+  worker = -1;
+
+  dedicated = NULL;
+
   pid.id = id != "" ? id : ID::generate();
   pid.address = __address__;
 
@@ -2990,36 +4454,47 @@ ProcessBase::ProcessBase(const string& id)
 }
 
 
-ProcessBase::~ProcessBase() {}
+ProcessBase::~ProcessBase()
+{
+  delete events;
+}
 
 
 void ProcessBase::enqueue(Event* event, bool inject)
 {
   CHECK(event != NULL);
 
-  synchronized (mutex) {
-    if (state != TERMINATING && state != TERMINATED) {
-      if (!inject) {
-        events.push_back(event);
-      } else {
-        events.push_front(event);
-      }
+  ProcessState old = state.load();
 
-      if (state == BLOCKED) {
-        state = READY;
-        process_manager->enqueue(this);
-      }
+  if (old == TERMINATING || old == TERMINATED) {
+    delete event;
+    return;
+  }
 
-      CHECK(state == BOTTOM ||
-            state == READY ||
-            state == RUNNING);
-    } else {
-      delete event;
-    }
+  events->enqueue(event, inject);
+
+  // Only the producer that transitions the process from BLOCKED to
+  // READY enqueues it for running. Note that this must happen after
+  // enqueueing the event (see ProcessManager::resume).
+  ProcessState blocked = BLOCKED;
+  if (state.compare_exchange_strong(blocked, READY)) {
+    process_manager->enqueue(this);
   }
 }
 
 
+void ProcessBase::prioritize(const string& name)
+{
+  events->prioritize(name);
+}
+
+
+size_t ProcessBase::eventCount(bool (*predicate)(const Event*))
+{
+  return events->count(predicate);
+}
+
+
 void ProcessBase::inject(
     const UPID& from,
     const string& name,
@@ -3068,7 +4543,7 @@ void ProcessBase::visit(const MessageEvent& event)
 
 void ProcessBase::visit(const DispatchEvent& event)
 {
-  (*event.f)(this);
+  event.f(this);
 }
 
 
@@ -3077,40 +4552,79 @@ void ProcessBase::visit(const HttpEvent& event)
   VLOG(1) << "Handling HTTP event for process '" << pid.id << "'"
           << " with path: '" << event.request->url.path << "'";
 
-  CHECK(event.request->url.path.find('/') == 0); // See ProcessManager::handle.
-
-  // Split the path by '/'.
-  vector<string> tokens = strings::tokenize(event.request->url.path, "/");
-  CHECK(tokens.size() >= 1);
-  CHECK_EQ(pid.id, http::decode(tokens[0]).get());
+  const string& path = event.request->url.path;
 
-  // First look to see if there is an HTTP handler that can handle the
-  // longest prefix of this path.
+  CHECK(path.find('/') == 0); // See ProcessManager::handle.
 
-  // Remove the 'id' prefix from the path.
-  string name = strings::remove(
-      event.request->url.path, "/" + tokens[0], strings::PREFIX);
+  // Skip the 'id' component of the path.
+  const size_t start = path.find_first_not_of('/');
+  CHECK_NE(string::npos, start);
 
-  name = strings::trim(name, strings::PREFIX, "/");
+  const size_t end = std::min(path.find('/', start), path.size());
 
-  while (Path(name).dirname() != name) {
-    if (handlers.http.count(name) > 0) {
-      // Now call the handler and associate the response with the promise.
-      event.response->associate(handlers.http[name](*event.request));
+  // The component is decoded only if it is not the 'id' verbatim.
+  CHECK(path.compare(start, end - start, pid.id) == 0 ||
+        pid.id == http::decode(path.substr(start, end - start)).get());
 
-      return;
+  // First look to see if there is an HTTP handler that can handle the
+  // longest prefix of this path.
+  const string* name = match(path, end);
+
+  if (name != NULL) {
+    const HttpRequestHandler& handler = handlers.http[*name];
+    const bool streaming = handlers.options[*name].requestStreaming;
+
+    if (event.request->type == Request::PIPE && !streaming) {
+      // The body was streamed but the handler wants the whole body
+      // (e.g., a request for a path below a streaming route that is
+      // handled by a non-streaming route), so read it all first.
+      CHECK_SOME(event.request->reader);
+
+      Request request = *event.request;
+      request.type = Request::BODY;
+      request.reader = None();
+
+      event.response->associate(
+          event.request->reader->readAll()
+            .then(defer(self(), [=](const string& body) {
+              Request _request = request;
+              _request.body = body;
+              return handler(_request);
+            })));
+    } else if (event.request->type == Request::BODY && streaming) {
+      // Provide the already received body through a pipe (e.g.,
+      // for a request that was delegated to this process).
+      http::Pipe pipe;
+      http::Pipe::Writer writer = pipe.writer();
+      writer.write(event.request->body);
+      writer.close();
+
+      Request request = *event.request;
+      request.type = Request::PIPE;
+      request.body.clear();
+      request.reader = pipe.reader();
+
+      event.response->associate(handler(request));
+    } else {
+      // Now call the handler and associate the response with the
+      // promise.
+      event.response->associate(handler(*event.request));
     }
 
-    name = Path(name).dirname();
+    return;
   }
 
+  // Split the path by '/'.
+  vector<string> tokens = strings::tokenize(path, "/");
+  CHECK(tokens.size() >= 1);
+
   // If no HTTP handler is found look in assets.
-  name = tokens.size() > 1 ? tokens[1] : "";
+  const string asset = tokens.size() > 1 ? tokens[1] : "";
 
-  if (assets.count(name) > 0) {
+  if (assets.count(asset) > 0) {
     OK response;
     response.type = Response::PATH;
-    response.path = assets[name].path;
+    response.path = assets[asset].path;
 
     // Construct the final path by appending remaining tokens.
     for (int i = 2; i < tokens.size(); i++) {
@@ -3122,8 +4636,8 @@ void ProcessBase::visit(const HttpEvent& event)
     size_t index = basename.find_last_of('.');
     if (index != string::npos) {
       string extension = basename.substr(index);
-      if (assets[name].types.count(extension) > 0) {
-        response.headers["Content-Type"] = assets[name].types[extension];
+      if (assets[asset].types.count(extension) > 0) {
+        response.headers["Content-Type"] = assets[asset].types[extension];
       }
     }
 
@@ -3143,6 +4657,69 @@ void ProcessBase::visit(const HttpEvent& event)
 }
 
 
+const string* ProcessBase::match(const string& path, size_t position) const
+{
+  const Routes* node = &routes;
+
+  size_t index = path.find_first_not_of('/', position);
+
+  // Only the empty path is handled by the route of the process itself.
+  if (index == string::npos) {
+    return node->name.isSome() ? &node->name.get() : NULL;
+  }
+
+  // Walk down the trie for each component of the path, without
+  // copying the components. Like a lookup of the path, and of each
+  // 'Path::dirname' of it in turn, the whole path only matches if it
+  // has no trailing '/', and a prefix of it only matches if it does
+  // not contain a '//'.
+  const string* name = NULL;
+
+  while (true) {
+    const size_t next = std::min(path.find('/', index), path.size());
+    const size_t length = next - index;
+
+    const Routes* child = NULL;
+    foreach (const auto& candidate, node->children) {
+      if (candidate.first.size() == length &&
+          path.compare(index, length, candidate.first) == 0) {
+        child = candidate.second.get();
+        break;
+      }
+    }
+
+    if (child == NULL) {
+      break;
+    }
+
+    node = child;
+
+    if (next == path.size()) {
+      if (node->name.isSome()) {
+        name = &node->name.get();
+      }
+      break;
+    }
+
+    index = path.find_first_not_of('/', next);
+
+    if (index == string::npos) {
+      break;
+    }
+
+    if (node->name.isSome()) {
+      name = &node->name.get();
+    }
+
+    if (index > next + 1) {
+      break;
+    }
+  }
+
+  return name;
+}
+
+
 void ProcessBase::visit(const ExitedEvent& event)
 {
   exited(event.pid);
@@ -3170,17 +4747,50 @@ UPID ProcessBase::link(const UPID& to)
 void ProcessBase::route(
     const string& name,
     const Option<string>& help_,
-    const HttpRequestHandler& handler)
+    const HttpRequestHandler& handler,
+    const RouteOptions& options)
 {
   // Routes must start with '/'.
   CHECK(name.find('/') == 0);
   handlers.http[name.substr(1)] = handler;
+  handlers.options[name.substr(1)] = options;
+
+  Routes* node = &routes;
+
+  foreach (const string& component, strings::tokenize(name, "/")) {
+    bool found = false;
+
+    foreach (auto& child, node->children) {
+      if (child.first == component) {
+        node = child.second.get();
+        found = true;
+        break;
+      }
+    }
+
+    if (!found) {
+      node->children.push_back(
+          std::make_pair(component, std::make_shared<Routes>()));
+
+      node = node->children.back().second.get();
+    }
+  }
+
+  node->name = name.substr(1);
+
+  process_manager->stream("/" + pid.id + name, options.requestStreaming);
   dispatch(help, &Help::add, pid.id, name, help_);
 }
 
 
 
 UPID spawn(ProcessBase* process, bool manage)
+{
+  return spawn(process, SpawnOptions(), manage);
+}
+
+
+UPID spawn(ProcessBase* process, const SpawnOptions& options, bool manage)
 {
   process::initialize();
 
@@ -3192,7 +4802,7 @@ UPID spawn(ProcessBase* process, bool manage)
       Clock::update(process, Clock::now(__process__));
     }
 
-    return process_manager->spawn(process, manage);
+    return process_manager->spawn(process, manage, options);
   } else {
     return UPID();
   }
@@ -3325,17 +4935,51 @@ bool exited(const UPID& from, const UPID& to)
 } // namespace inject {
 
 
+void* Message::operator new(size_t size)
+{
+  return SlabPool<Message>::allocate(size);
+}
+
+
+void Message::operator delete(void* pointer, size_t size)
+{
+  SlabPool<Message>::deallocate(pointer, size);
+}
+
+
+void* MessageEvent::operator new(size_t size)
+{
+  return SlabPool<MessageEvent>::allocate(size);
+}
+
+
+void MessageEvent::operator delete(void* pointer, size_t size)
+{
+  SlabPool<MessageEvent>::deallocate(pointer, size);
+}
+
+
+void* DispatchEvent::operator new(size_t size)
+{
+  return SlabPool<DispatchEvent>::allocate(size);
+}
+
+
+void DispatchEvent::operator delete(void* pointer, size_t size)
+{
+  SlabPool<DispatchEvent>::deallocate(pointer, size);
+}
+
+
 namespace internal {
 
-void dispatch(
-    const UPID& pid,
-    const std::shared_ptr<lambda::function<void(ProcessBase*)>>& f,
-    const Option<const std::type_info*>& functionType)
+void dispatch(DispatchEvent* event)
 {
   process::initialize();
 
-  DispatchEvent* event = new DispatchEvent(pid, f, functionType);
-  process_manager->deliver(pid, event, __process__);
+  // NOTE: The event might get deleted as soon as it has been
+  // delivered so we can't pass a reference to its pid.
+  process_manager->deliver(UPID(event->pid), event, __process__);
 }
 
 } // namespace internal {
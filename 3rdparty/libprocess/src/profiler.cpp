@@ -10,7 +10,20 @@
 // See the License for the specific language governing permissions and
 // limitations under the License
 
+#include <stdlib.h>
+#include <time.h>
+
+#ifndef __WINDOWS__
+#include <cxxabi.h>
+#include <dlfcn.h>
+#endif // __WINDOWS__
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <vector>
 
 #include <glog/logging.h>
 
@@ -18,15 +31,29 @@
 #include <gperftools/profiler.h>
 #endif
 
+#include "process/delay.hpp"
+#include "process/event.hpp"
 #include "process/future.hpp"
 #include "process/help.hpp"
 #include "process/http.hpp"
+#include "process/owned.hpp"
 #include "process/profiler.hpp"
 
+#include "stout/duration.hpp"
+#include "stout/foreach.hpp"
 #include "stout/format.hpp"
+#include "stout/hashmap.hpp"
 #include "stout/option.hpp"
 #include "stout/os.hpp"
 #include "stout/os/strerror.hpp"
+#include "stout/stringify.hpp"
+#include "stout/strings.hpp"
+#include "stout/synchronized.hpp"
+#include "stout/thread_local.hpp"
+
+#include "actor_profiler.hpp"
+
+using std::string;
 
 namespace process {
 
@@ -34,8 +61,214 @@ namespace {
 
 const char PROFILE_FILE[] = "perftools.out";
 
+// Default and maximum duration of profiling actors.
+const Duration DEFAULT_ACTORS_DURATION = Seconds(10);
+const Duration MAX_ACTORS_DURATION = Minutes(10);
+
+
+// The samples of a single processing thread. Only ever accessed by
+// that thread, except when profiling gets started or stopped.
+struct Samples
+{
+  std::mutex mutex;
+
+  // CPU time (in nanoseconds) of each stack.
+  hashmap<string, uint64_t> stacks;
+
+  // Cache of the names of dispatched functions, see 'name' below.
+  // Only accessed by the thread itself.
+  hashmap<const void*, string> functions;
+};
+
+
+// All of the threads' samples, which are never deleted since a
+// thread can't remove its samples when it exits.
+std::mutex* threads_mutex = new std::mutex();
+std::vector<Samples*>* threads = new std::vector<Samples*>();
+
+THREAD_LOCAL Samples* samples = NULL;
+
+
+string demangle(const char* name)
+{
+#ifndef __WINDOWS__
+  int status = 0;
+  char* demangled = abi::__cxa_demangle(name, NULL, NULL, &status);
+  if (status == 0 && demangled != NULL) {
+    string result(demangled);
+    free(demangled);
+    return result;
+  }
+#endif // __WINDOWS__
+
+  return name;
+}
+
+
+// Returns the name of the dispatched function: its symbol if its
+// address is known and it can be found in the dynamic symbol table,
+// otherwise the type of the function (e.g., for virtual functions).
+string name(const DispatchEvent& event)
+{
+#ifndef __WINDOWS__
+  if (event.function != NULL) {
+    Dl_info info;
+    if (dladdr(const_cast<void*>(event.function), &info) != 0 &&
+        info.dli_sname != NULL &&
+        info.dli_saddr == event.function) {
+      return demangle(info.dli_sname);
+    }
+  }
+#endif // __WINDOWS__
+
+  if (event.functionType.isSome()) {
+    return demangle(event.functionType.get()->name());
+  }
+
+  return "unknown";
+}
+
+
+// Returns the frame with any ';' (the frame separator) and newlines
+// replaced so that the output stays parseable.
+string frame(const string& name)
+{
+  return strings::replace(strings::replace(name, ";", "_"), "\n", "_");
+}
+
 }  // namespace {
 
+
+std::atomic_bool ActorProfiler::profiling(false);
+
+
+bool ActorProfiler::start()
+{
+  synchronized (threads_mutex) {
+    if (profiling.load()) {
+      return false;
+    }
+
+    foreach (Samples* samples, *threads) {
+      synchronized (samples->mutex) {
+        samples->stacks.clear();
+      }
+    }
+
+    profiling.store(true);
+  }
+
+  return true;
+}
+
+
+hashmap<string, uint64_t> ActorProfiler::stop()
+{
+  hashmap<string, uint64_t> stacks;
+
+  synchronized (threads_mutex) {
+    profiling.store(false);
+
+    foreach (Samples* samples, *threads) {
+      synchronized (samples->mutex) {
+        foreachpair (const string& stack, uint64_t time, samples->stacks) {
+          stacks[stack] += time;
+        }
+        samples->stacks.clear();
+      }
+    }
+  }
+
+  return stacks;
+}
+
+
+int64_t ActorProfiler::cpu()
+{
+#ifndef __WINDOWS__
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+  }
+#endif // __WINDOWS__
+
+  // Fall back to wall clock time.
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+void ActorProfiler::record(
+    const UPID& pid,
+    const Event& event,
+    int64_t nanoseconds)
+{
+  if (samples == NULL) {
+    samples = new Samples();
+    synchronized (threads_mutex) {
+      threads->push_back(samples);
+    }
+  }
+
+  struct StackVisitor : EventVisitor
+  {
+    explicit StackVisitor(Samples* _samples) : samples(_samples) {}
+
+    virtual void visit(const MessageEvent& event)
+    {
+      stack = "message;" + frame(event.message->name);
+    }
+
+    virtual void visit(const DispatchEvent& event)
+    {
+      const void* key = event.function;
+      if (key == NULL && event.functionType.isSome()) {
+        key = event.functionType.get();
+      }
+
+      if (!samples->functions.contains(key)) {
+        samples->functions[key] = frame(name(event));
+      }
+
+      stack = "dispatch;" + samples->functions[key];
+    }
+
+    virtual void visit(const HttpEvent& event)
+    {
+      stack = "http;" + frame(event.request->url.path);
+    }
+
+    virtual void visit(const ExitedEvent& event)
+    {
+      stack = "exited";
+    }
+
+    virtual void visit(const TerminateEvent& event)
+    {
+      stack = "terminate";
+    }
+
+    Samples* samples;
+    string stack;
+  } visitor(samples);
+
+  event.visit(&visitor);
+
+  // Group processes with generated ids, e.g., '__http__(1)'.
+  string id = pid.id;
+  size_t index = id.find('(');
+  if (index != string::npos && index > 0 && id[id.size() - 1] == ')') {
+    id = id.substr(0, index);
+  }
+
+  const string stack = frame(id) + ";" + visitor.stack;
+
+  synchronized (samples->mutex) {
+    samples->stacks[stack] += nanoseconds > 0 ? nanoseconds : 0;
+  }
+}
+
+
 const std::string Profiler::START_HELP()
 {
   return HELP(
@@ -46,6 +279,32 @@ const std::string Profiler::START_HELP()
 }
 
 
+const std::string Profiler::ACTORS_HELP()
+{
+  return HELP(
+    TLDR(
+        "Profiles the CPU time spent by each process."),
+    DESCRIPTION(
+        "Attributes the CPU time that processes spend serving events to",
+        "the process and to the event for the requested 'duration' (10",
+        "seconds by default, at most 10 minutes), e.g., to the name of a",
+        "message, the function of a dispatch, or the path of an HTTP",
+        "request. Dispatched functions are only named if their symbols",
+        "are exported, otherwise they are named by their type.",
+        "",
+        "The response is in the \"folded stacks\" format, i.e., a line per",
+        "process and event consisting of the process id (without the",
+        "\"(N)\" suffix of generated ids), the event type, and the event",
+        "name separated by ';' followed by the CPU time in nanoseconds,",
+        "which can be rendered by flamegraph.pl",
+        "(https://github.com/brendangregg/FlameGraph).",
+        "",
+        "Query parameters:",
+        "",
+        ">        duration=VALUE     How long to profile (e.g., '30secs')."));
+}
+
+
 const std::string Profiler::STOP_HELP()
 {
   return HELP(
@@ -126,4 +385,60 @@ Future<http::Response> Profiler::stop(const http::Request& request)
 #endif
 }
 
+Future<http::Response> Profiler::actors(const http::Request& request)
+{
+  Duration duration = DEFAULT_ACTORS_DURATION;
+
+  Option<string> parameter = request.url.query.get("duration");
+  if (parameter.isSome()) {
+    Try<Duration> parse = Duration::parse(parameter.get());
+    if (parse.isError()) {
+      return http::BadRequest(
+          "Invalid duration '" + parameter.get() + "': " + parse.error() +
+          ".\n");
+    }
+
+    duration = parse.get();
+  }
+
+  if (duration <= Duration::zero() || duration > MAX_ACTORS_DURATION) {
+    return http::BadRequest(
+        "The duration must be positive and at most " +
+        stringify(MAX_ACTORS_DURATION) + ".\n");
+  }
+
+  if (!ActorProfiler::start()) {
+    return http::BadRequest("Already profiling actors.\n");
+  }
+
+  LOG(INFO) << "Profiling actors for " << duration;
+
+  Owned<Promise<http::Response>> promise(new Promise<http::Response>());
+
+  delay(duration, self(), &Profiler::_actors, promise);
+
+  return promise->future();
+}
+
+
+void Profiler::_actors(const Owned<Promise<http::Response>>& promise)
+{
+  hashmap<string, uint64_t> stacks = ActorProfiler::stop();
+
+  LOG(INFO) << "Stopped profiling actors";
+
+  // Sort the stacks so that the output is deterministic.
+  std::map<string, uint64_t> sorted(stacks.begin(), stacks.end());
+
+  std::ostringstream out;
+  foreachpair (const string& stack, uint64_t time, sorted) {
+    out << stack << " " << time << "\n";
+  }
+
+  http::OK response(out.str());
+  response.headers["Content-Type"] = "text/plain; charset=utf-8";
+
+  promise->set(response);
+}
+
 } // namespace process {
@@ -15,27 +15,46 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif // __linux__
+
+#include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/future.hpp>
 #include <process/id.hpp>
+#include <process/io.hpp>
 #include <process/once.hpp>
 #include <process/owned.hpp>
 #include <process/reap.hpp>
 
 #include <stout/check.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/multihashmap.hpp>
 #include <stout/none.hpp>
 #include <stout/os.hpp>
 #include <stout/result.hpp>
 #include <stout/try.hpp>
 
+#include <stout/os/close.hpp>
+
+#if defined(__linux__) && !defined(SYS_pidfd_open)
+// Older C libraries don't define the system call number, which is
+// the same on every architecture (since Linux 5.3).
+#define SYS_pidfd_open 434
+#endif
+
 namespace process {
 
 
-// TODO(bmahler): This can be optimized to use a thread per pid, where
-// each thread makes a blocking call to waitpid. This eliminates the
-// unfortunate poll delay.
+// Where possible (i.e., on Linux 5.3 and newer) the reaper opens a
+// "pidfd" for each pid and polls it in the event loop, which makes
+// the pidfd readable once the process terminates, so that the
+// termination is noticed right away whether or not the process is
+// our child. Otherwise (or if the pidfd can not be opened) the
+// reaper checks the pid periodically, at an interval given by the
+// model below.
 //
 // Simple bounded linear model for computing the poll interval.
 // Values were chosen such that at (50 pids, 100 ms) the CPU usage is
@@ -70,6 +89,11 @@ public:
     if (os::exists(pid)) {
       Owned<Promise<Option<int> > > promise(new Promise<Option<int> >());
       promises.put(pid, promise);
+
+      if (!pidfds.contains(pid)) {
+        watch(pid);
+      }
+
       return promise->future();
     } else {
       return None();
@@ -92,6 +116,10 @@ protected:
     // between waitpid and the (!exists) conditional it will still exist as a
     // zombie; it will be reaped by us on the next loop.
     foreach (pid_t pid, promises.keys()) {
+      if (pidfds.contains(pid)) {
+        continue; // Watched in the event loop (see 'watch').
+      }
+
       int status;
       if (waitpid(pid, &status, WNOHANG) > 0) {
         // We have reaped a child.
@@ -105,6 +133,49 @@ protected:
     delay(interval(), self(), &ReaperProcess::wait); // Reap forever!
   }
 
+  // Polls a pidfd of the pid, if one can be opened, in which case
+  // 'terminated' gets invoked once the process has terminated.
+  void watch(pid_t pid)
+  {
+#ifdef __linux__
+    int pidfd = ::syscall(SYS_pidfd_open, pid, 0);
+    if (pidfd < 0) {
+      // Fall back to polling (see 'wait'), e.g., on older kernels or
+      // if the process has terminated (and been reaped) already.
+      return;
+    }
+
+    pidfds[pid] = pidfd;
+
+    io::poll(pidfd, io::READ)
+      .onAny(defer(self(), &ReaperProcess::terminated, pid, pidfd, lambda::_1));
+#endif // __linux__
+  }
+
+  void terminated(pid_t pid, int pidfd, const Future<short>& poll)
+  {
+    CHECK(pidfds.contains(pid) && pidfds[pid] == pidfd);
+
+    pidfds.erase(pid);
+    os::close(pidfd);
+
+    if (!poll.isReady()) {
+      LOG(WARNING) << "Failed to poll the pidfd of process " << pid << ": "
+                   << (poll.isFailed() ? poll.failure() : "discarded")
+                   << "; falling back to polling the process";
+      return;
+    }
+
+    // The process has terminated, so we either reap it now if it is
+    // our child, or it has been (or will be) reaped by someone else.
+    int status;
+    if (waitpid(pid, &status, WNOHANG) > 0) {
+      notify(pid, status);
+    } else {
+      notify(pid, None());
+    }
+  }
+
   void notify(pid_t pid, Result<int> status)
   {
     foreach (const Owned<Promise<Option<int> > >& promise, promises.get(pid)) {
@@ -122,7 +193,13 @@ protected:
 private:
   const Duration interval()
   {
-    size_t count = promises.size();
+    // NOTE: Only the pids which are not watched get polled.
+    size_t count = 0;
+    foreach (pid_t pid, promises.keys()) {
+      if (!pidfds.contains(pid)) {
+        count++;
+      }
+    }
 
     if (count <= LOW_PID_COUNT) {
       return MIN_REAP_INTERVAL();
@@ -139,6 +216,9 @@ private:
   }
 
   multihashmap<pid_t, Owned<Promise<Option<int> > > > promises;
+
+  // The pidfds of the pids which are watched in the event loop.
+  hashmap<pid_t, int> pidfds;
 };
 
 
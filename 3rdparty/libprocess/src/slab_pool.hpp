@@ -0,0 +1,273 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESS_SLAB_POOL_HPP__
+#define __PROCESS_SLAB_POOL_HPP__
+
+#include <stddef.h>
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <process/defer.hpp>
+#include <process/future.hpp>
+#include <process/pid.hpp>
+
+#include <process/metrics/gauge.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/synchronized.hpp>
+#include <stout/thread_local.hpp>
+
+namespace process {
+
+// A pool of memory blocks for objects of type T, which are allocated
+// and deleted at a high rate and usually by different threads, e.g.,
+// messages get decoded by the event loop thread and deleted by the
+// worker that served them. Meant to back the class specific
+// 'operator new' and 'operator delete' of T.
+//
+// Blocks are carved out of "slabs" of BATCH blocks that are never
+// returned to the allocator, so the memory of a pool is bounded by
+// the peak number of objects alive at once and never gets interleaved
+// with other (longer lived) allocations. Each thread caches up to
+// 2 * BATCH free blocks and exchanges whole batches of free blocks
+// with a shared depot, so the lock of the depot is taken at most once
+// every BATCH allocations (or deletions) of a thread.
+//
+// NOTE: The blocks cached by a thread that exits are not reclaimed.
+template <typename T>
+class SlabPool
+{
+public:
+  // Number of blocks per slab, and per batch exchanged with the depot.
+  static const size_t BATCH = 64;
+
+  static void* allocate(size_t size)
+  {
+    // NOTE: A subclass of T might be larger.
+    if (size != sizeof(T)) {
+      return ::operator new(size);
+    }
+
+    Cache* cache = local();
+
+    if (cache->blocks == NULL) {
+      refill(cache);
+    }
+
+    Block* block = cache->blocks;
+    cache->blocks = block->next;
+    cache->size.store(
+        cache->size.load(std::memory_order_relaxed) - 1,
+        std::memory_order_relaxed);
+
+    return block;
+  }
+
+  static void deallocate(void* pointer, size_t size)
+  {
+    if (size != sizeof(T)) {
+      ::operator delete(pointer);
+      return;
+    }
+
+    Cache* cache = local();
+
+    Block* block = static_cast<Block*>(pointer);
+    block->next = cache->blocks;
+    cache->blocks = block;
+
+    const size_t cached = cache->size.load(std::memory_order_relaxed) + 1;
+    cache->size.store(cached, std::memory_order_relaxed);
+
+    if (cached >= 2 * BATCH) {
+      flush(cache);
+    }
+  }
+
+  struct Statistics
+  {
+    // Number of blocks carved out of slabs so far.
+    size_t capacity;
+
+    // Number of blocks that are cached by a thread or the depot.
+    size_t free;
+  };
+
+  // NOTE: The thread caches are read while their threads might be
+  // using them, so this is only approximate.
+  static Statistics statistics()
+  {
+    Depot* depot = SlabPool::depot();
+
+    Statistics statistics;
+
+    synchronized (depot->mutex) {
+      statistics.capacity = depot->slabs * BATCH;
+      statistics.free = depot->batches.size() * BATCH;
+
+      foreach (const Cache* cache, depot->caches) {
+        statistics.free += cache->size.load(std::memory_order_relaxed);
+      }
+    }
+
+    return statistics;
+  }
+
+  // Returns the gauges exporting the number of blocks in use, the
+  // number of free blocks, and the total size of the slabs (see
+  // 'statistics'), which get evaluated by the process 'pid'.
+  static std::vector<metrics::Gauge> createGauges(
+      const std::string& prefix,
+      const UPID& pid)
+  {
+    std::vector<metrics::Gauge> gauges;
+
+    gauges.push_back(metrics::Gauge(
+        prefix + "in_use",
+        defer(pid, []() -> Future<double> {
+          const Statistics statistics = SlabPool::statistics();
+          return statistics.capacity > statistics.free
+            ? statistics.capacity - statistics.free
+            : 0;
+        })));
+
+    gauges.push_back(metrics::Gauge(
+        prefix + "free",
+        defer(pid, []() -> Future<double> {
+          return SlabPool::statistics().free;
+        })));
+
+    gauges.push_back(metrics::Gauge(
+        prefix + "slab_bytes",
+        defer(pid, []() -> Future<double> {
+          return SlabPool::statistics().capacity * sizeof(T);
+        })));
+
+    return gauges;
+  }
+
+private:
+  // A free block, linked through the block itself.
+  struct Block
+  {
+    Block* next;
+  };
+
+  static_assert(sizeof(T) >= sizeof(Block), "T is smaller than a Block");
+
+  // The free blocks of a thread. Only the size is read by others.
+  struct Cache
+  {
+    Cache() : blocks(NULL), size(0) {}
+
+    Block* blocks;
+    std::atomic<size_t> size;
+  };
+
+  struct Depot
+  {
+    Depot() : slabs(0) {}
+
+    std::mutex mutex;
+
+    // Lists of exactly BATCH free blocks.
+    std::vector<Block*> batches;
+
+    // The caches of all threads, which are never deleted since a
+    // thread can't remove its cache when it exits.
+    std::vector<const Cache*> caches;
+
+    size_t slabs;
+  };
+
+  static Depot* depot()
+  {
+    static Depot* depot = new Depot();
+    return depot;
+  }
+
+  static Cache* local()
+  {
+    static THREAD_LOCAL Cache* cache = NULL;
+
+    if (cache == NULL) {
+      cache = new Cache();
+
+      Depot* depot = SlabPool::depot();
+      synchronized (depot->mutex) {
+        depot->caches.push_back(cache);
+      }
+    }
+
+    return cache;
+  }
+
+  // Fills the (empty) cache with a batch from the depot or, if the
+  // depot is empty, with the blocks of a new slab.
+  static void refill(Cache* cache)
+  {
+    Depot* depot = SlabPool::depot();
+
+    synchronized (depot->mutex) {
+      if (!depot->batches.empty()) {
+        cache->blocks = depot->batches.back();
+        cache->size.store(BATCH, std::memory_order_relaxed);
+        depot->batches.pop_back();
+        return;
+      }
+
+      depot->slabs++;
+    }
+
+    char* slab = static_cast<char*>(::operator new(sizeof(T) * BATCH));
+
+    for (size_t i = BATCH; i > 0; i--) {
+      Block* block = reinterpret_cast<Block*>(slab + (i - 1) * sizeof(T));
+      block->next = cache->blocks;
+      cache->blocks = block;
+    }
+
+    cache->size.store(BATCH, std::memory_order_relaxed);
+  }
+
+  // Moves a batch of free blocks from the cache to the depot.
+  static void flush(Cache* cache)
+  {
+    Block* batch = cache->blocks;
+
+    Block* last = batch;
+    for (size_t i = 1; i < BATCH; i++) {
+      last = last->next;
+    }
+
+    cache->blocks = last->next;
+    last->next = NULL;
+
+    cache->size.store(
+        cache->size.load(std::memory_order_relaxed) - BATCH,
+        std::memory_order_relaxed);
+
+    Depot* depot = SlabPool::depot();
+    synchronized (depot->mutex) {
+      depot->batches.push_back(batch);
+    }
+  }
+};
+
+} // namespace process {
+
+#endif // __PROCESS_SLAB_POOL_HPP__
@@ -31,7 +31,7 @@ using std::string;
 namespace process {
 namespace network {
 
-Try<Socket> Socket::create(Kind kind, Option<int> s)
+Try<Socket> Socket::create(Kind kind, Option<int> s, int family)
 {
   // If the caller passed in a file descriptor, we do
   // not own its life cycle and must not close it.
@@ -41,13 +41,13 @@ Try<Socket> Socket::create(Kind kind, Option<int> s)
     // Supported in Linux >= 2.6.27.
 #if defined(SOCK_NONBLOCK) && defined(SOCK_CLOEXEC)
     Try<int> fd =
-      network::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      network::socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
 
     if (fd.isError()) {
       return Error("Failed to create socket: " + fd.error());
     }
 #else
-    Try<int> fd = network::socket(AF_INET, SOCK_STREAM, 0);
+    Try<int> fd = network::socket(family, SOCK_STREAM, 0);
     if (fd.isError()) {
       return Error("Failed to create socket: " + fd.error());
     }
@@ -243,5 +243,17 @@ Future<Nothing> Socket::Impl::send(const std::string& _data)
 }
 
 
+Future<size_t> Socket::Impl::send(const struct iovec* iov, int iovcnt)
+{
+  for (int i = 0; i < iovcnt; i++) {
+    if (iov[i].iov_len > 0) {
+      return send(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+    }
+  }
+
+  return Failure("No data to send");
+}
+
+
 } // namespace network {
 } // namespace process {
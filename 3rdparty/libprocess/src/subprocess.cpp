@@ -15,6 +15,8 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <spawn.h>
+
 #include <string>
 
 #include <glog/logging.h>
@@ -23,12 +25,17 @@
 #include <process/reap.hpp>
 #include <process/subprocess.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
+
 #include <stout/error.hpp>
 #include <stout/lambda.hpp>
 #include <stout/foreach.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
 #include <stout/os/strerror.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
 #include <stout/unreachable.hpp>
@@ -96,6 +103,89 @@ static Try<Nothing> cloexec(int stdinFd[2], int stdoutFd[2], int stderrFd[2])
   return Nothing();
 }
 
+
+// Metrics of the subprocesses of all processes, which get added when
+// the first subprocess is created.
+struct Metrics
+{
+  Metrics()
+    : spawn("libprocess/subprocess/spawn", Hours(1)),
+      spawns("libprocess/subprocess/spawns"),
+      forks("libprocess/subprocess/forks")
+  {
+    metrics::add(spawn);
+    metrics::add(spawns);
+    metrics::add(forks);
+  }
+
+  // Time the calling thread takes to create a subprocess.
+  metrics::Timer<Microseconds> spawn;
+
+  // Number of subprocesses created with 'posix_spawn' (see
+  // 'internal::spawn' below) and by cloning the calling process.
+  metrics::Counter spawns;
+  metrics::Counter forks;
+};
+
+
+static Metrics& metrics()
+{
+  static Metrics* metrics = new Metrics();
+  return *metrics;
+}
+
+
+// Creates the child process with 'posix_spawn' which, unlike 'fork',
+// does not copy the page tables of the calling process (e.g., glibc
+// creates the child with CLONE_VM | CLONE_VFORK), and so does not
+// take longer as the calling process grows. The redirections of
+// stdin/stdout/stderr are done with file actions since there is no
+// function to run in the child. All of the other file descriptors
+// created by 'subprocess' are close-on-exec.
+static pid_t spawn(
+    const string& path,
+    char** argv,
+    char** envp,
+    int stdinFd[2],
+    int stdoutFd[2],
+    int stderrFd[2])
+{
+  posix_spawn_file_actions_t actions;
+
+  int error = ::posix_spawn_file_actions_init(&actions);
+  if (error != 0) {
+    errno = error;
+    return -1;
+  }
+
+  error = ::posix_spawn_file_actions_adddup2(
+      &actions, stdinFd[0], STDIN_FILENO);
+
+  if (error == 0) {
+    error = ::posix_spawn_file_actions_adddup2(
+        &actions, stdoutFd[1], STDOUT_FILENO);
+  }
+
+  if (error == 0) {
+    error = ::posix_spawn_file_actions_adddup2(
+        &actions, stderrFd[1], STDERR_FILENO);
+  }
+
+  pid_t pid = -1;
+  if (error == 0) {
+    error = ::posix_spawnp(&pid, path.c_str(), &actions, NULL, argv, envp);
+  }
+
+  ::posix_spawn_file_actions_destroy(&actions);
+
+  if (error != 0) {
+    errno = error;
+    return -1;
+  }
+
+  return pid;
+}
+
 }  // namespace internal {
 
 
@@ -355,24 +445,62 @@ Try<Subprocess> subprocess(
     envp[index] = NULL;
   }
 
-  // Determine the function to clone the child process. If the user
-  // does not specify the clone function, we will use the default.
-  lambda::function<pid_t(const lambda::function<int()>&)> clone =
-    (_clone.isSome() ? _clone.get() : defaultClone);
-
-  // Now, clone the child process.
-  pid_t pid = clone(lambda::bind(
-      &childMain,
-      path,
-      _argv,
-      in,
-      out,
-      err,
-      envp,
-      setup,
-      stdinFd,
-      stdoutFd,
-      stderrFd));
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  pid_t pid = -1;
+
+  // Spawn rather than clone the child process when nothing but the
+  // redirections has to be done in the child. This also requires
+  // that 'posix_spawnp' searches the same PATH as 'os::execvpe' (the
+  // one of the child), and that none of the file descriptors to
+  // redirect already is one of stdin/stdout/stderr, since 'dup2' then
+  // leaves it close-on-exec.
+  const bool spawnable =
+    setup.isNone() &&
+    _clone.isNone() &&
+    (environment.isNone() || strings::contains(path, "/")) &&
+    stdinFd[0] > STDERR_FILENO &&
+    stdoutFd[1] > STDERR_FILENO &&
+    stderrFd[1] > STDERR_FILENO;
+
+  if (spawnable) {
+    pid = internal::spawn(path, _argv, envp, stdinFd, stdoutFd, stderrFd);
+
+    if (pid != -1) {
+      ++internal::metrics().spawns;
+    }
+  }
+
+  // Fall back to cloning the child process, also if spawning failed.
+  // The child then reports the errors it hits, e.g., that there is
+  // no executable at 'path', through its exit status as usual.
+  if (pid == -1) {
+    // Determine the function to clone the child process. If the user
+    // does not specify the clone function, we will use the default.
+    lambda::function<pid_t(const lambda::function<int()>&)> clone =
+      (_clone.isSome() ? _clone.get() : defaultClone);
+
+    // Now, clone the child process.
+    pid = clone(lambda::bind(
+        &childMain,
+        path,
+        _argv,
+        in,
+        out,
+        err,
+        envp,
+        setup,
+        stdinFd,
+        stdoutFd,
+        stderrFd));
+
+    if (pid != -1) {
+      ++internal::metrics().forks;
+    }
+  }
+
+  internal::metrics().spawn.record(stopwatch.elapsed());
 
   delete[] _argv;
 
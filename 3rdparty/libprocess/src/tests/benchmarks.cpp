@@ -18,26 +18,36 @@
 
 #include <gmock/gmock.h>
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include <process/collect.hpp>
+#include <process/defer.hpp>
+#include <process/delay.hpp>
+#include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
+#include <process/http.hpp>
 #include <process/owned.hpp>
 #include <process/process.hpp>
+#include <process/socket.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 #include <stout/hashset.hpp>
+#include <stout/nothing.hpp>
 #include <stout/stopwatch.hpp>
 
 namespace http = process::http;
 
 using process::Future;
+using process::PID;
 using process::Owned;
 using process::Process;
 using process::ProcessBase;
@@ -374,3 +384,628 @@ TEST(ProcessTest, Process_BENCHMARK_LargeNumberOfLinks)
     delete process;
   }
 }
+
+
+class DispatchTargetProcess : public Process<DispatchTargetProcess>
+{
+public:
+  DispatchTargetProcess() : count(0) {}
+
+  void zero() { count++; }
+  void one(int i) { count++; }
+  void two(int i, double d) { count++; }
+  void three(int i, double d, const string& s) { count++; }
+
+  size_t total() { return count; }
+
+private:
+  size_t count;
+};
+
+
+// Dispatches to the target from within a process (i.e., from a
+// worker thread) since that is how the vast majority of dispatches
+// happen.
+class DispatcherProcess : public Process<DispatcherProcess>
+{
+public:
+  explicit DispatcherProcess(const PID<DispatchTargetProcess>& _target)
+    : target(_target) {}
+
+  Nothing run(size_t arity, size_t dispatches)
+  {
+    const string s = "short";
+
+    for (size_t i = 0; i < dispatches; i++) {
+      switch (arity) {
+        case 0: dispatch(target, &DispatchTargetProcess::zero); break;
+        case 1: dispatch(target, &DispatchTargetProcess::one, 1); break;
+        case 2: dispatch(target, &DispatchTargetProcess::two, 1, 2.0); break;
+        case 3:
+          dispatch(target, &DispatchTargetProcess::three, 1, 2.0, s);
+          break;
+      }
+    }
+
+    return Nothing();
+  }
+
+private:
+  const PID<DispatchTargetProcess> target;
+};
+
+
+// Measures the throughput of dispatching methods that take zero to
+// three arguments, which should not require any allocations besides
+// copying the arguments themselves.
+TEST(ProcessTest, Process_BENCHMARK_Dispatch)
+{
+  const size_t dispatches = 1000000;
+
+  DispatchTargetProcess target;
+  spawn(target);
+
+  DispatcherProcess dispatcher(target.self());
+  spawn(dispatcher);
+
+  for (size_t arity = 0; arity <= 3; arity++) {
+    Stopwatch watch;
+    watch.start();
+
+    AWAIT_READY(dispatch(
+        dispatcher, &DispatcherProcess::run, arity, dispatches));
+
+    // Wait until the target has served all of the dispatches.
+    Future<size_t> total = dispatch(target, &DispatchTargetProcess::total);
+    AWAIT_EXPECT_EQ((arity + 1) * dispatches, total);
+
+    Duration elapsed = watch.elapsed();
+
+    cout << "Dispatched " << dispatches << " methods with " << arity
+         << " argument(s) in " << elapsed << " ("
+         << dispatches / elapsed.secs() << " dispatches/sec)" << endl;
+  }
+
+  terminate(dispatcher);
+  wait(dispatcher);
+
+  terminate(target);
+  wait(target);
+}
+
+
+// Measures the throughput of completing 'then' chains of different
+// depths, where every continuation gets installed before the chain
+// completes (i.e., every continuation is stored as a callback).
+TEST(FutureTest, Future_BENCHMARK_Then)
+{
+  const size_t continuations = 1000000;
+
+  const vector<size_t> depths = {1, 10, 100};
+
+  foreach (size_t depth, depths) {
+    const size_t chains = continuations / depth;
+
+    Stopwatch watch;
+    watch.start();
+
+    for (size_t i = 0; i < chains; i++) {
+      Promise<size_t> promise;
+
+      Future<size_t> future = promise.future();
+      for (size_t j = 0; j < depth; j++) {
+        future = future.then([](size_t value) { return value + 1; });
+      }
+
+      promise.set(0);
+
+      ASSERT_TRUE(future.isReady());
+      ASSERT_EQ(depth, future.get());
+    }
+
+    Duration elapsed = watch.elapsed();
+
+    cout << "Completed " << chains << " 'then' chains of depth " << depth
+         << " in " << elapsed << " ("
+         << chains * depth / elapsed.secs() << " continuations/sec)" << endl;
+  }
+}
+
+
+// Prints the count, the percentiles and the maximum of the given
+// latencies.
+static void report(const string& name, vector<Duration> latencies)
+{
+  if (latencies.empty()) {
+    return;
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+
+  auto percentile = [&latencies](double p) {
+    return latencies[std::min(
+        latencies.size() - 1,
+        static_cast<size_t>(p * latencies.size()))];
+  };
+
+  cout << name << ": " << latencies.size() << " samples"
+       << ", p50 " << percentile(0.5)
+       << ", p99 " << percentile(0.99)
+       << ", p999 " << percentile(0.999)
+       << ", max " << latencies.back() << endl;
+}
+
+
+// A process that sends 'ping' messages to a server (see
+// ServerProcess) one at a time, and records the round trip latency
+// of each of them.
+class PingerProcess : public Process<PingerProcess>
+{
+public:
+  PingerProcess(const UPID& _server, const Bytes& size, size_t _messages)
+    : server(_server),
+      message(size.bytes(), '1'),
+      messages(_messages) {}
+
+  virtual ~PingerProcess() {}
+
+  Future<vector<Duration>> run()
+  {
+    latencies.reserve(messages);
+
+    watch.start();
+    send(server, "ping", message.c_str(), message.size());
+
+    return promise.future();
+  }
+
+protected:
+  virtual void initialize()
+  {
+    install("pong", &PingerProcess::pong);
+  }
+
+private:
+  void pong(const UPID& from, const string& body)
+  {
+    latencies.push_back(watch.elapsed());
+
+    if (latencies.size() == messages) {
+      promise.set(latencies);
+      return;
+    }
+
+    watch.start();
+    send(server, "ping", message.c_str(), message.size());
+  }
+
+  const UPID server;
+  const string message;
+  const size_t messages;
+
+  Stopwatch watch;
+  vector<Duration> latencies;
+  Promise<vector<Duration>> promise;
+};
+
+
+// Measures the round trip latency and the throughput of messages of
+// different sizes between two processes. Note that the messages do
+// not go through sockets since both processes are local (see the
+// TODO above), so this measures the message passing of libprocess
+// itself, i.e., the encoding, the mailboxes and the scheduling.
+TEST(ProcessTest, Process_BENCHMARK_MessageSize)
+{
+  const vector<Bytes> sizes =
+    {Bytes(16), Kilobytes(1), Kilobytes(64), Megabytes(1)};
+
+  ServerProcess server;
+  const UPID serverPid = spawn(&server);
+
+  foreach (const Bytes& size, sizes) {
+    // Send fewer of the larger messages.
+    const size_t messages =
+      std::min<size_t>(100000, Gigabytes(1).bytes() / size.bytes());
+
+    PingerProcess pinger(serverPid, size, messages);
+    spawn(pinger);
+
+    Stopwatch watch;
+    watch.start();
+
+    Future<vector<Duration>> latencies =
+      dispatch(pinger, &PingerProcess::run);
+
+    AWAIT_READY_FOR(latencies, Minutes(5));
+
+    Duration elapsed = watch.elapsed();
+
+    cout << "Sent " << messages << " messages of " << size << " in "
+         << elapsed << " (" << messages / elapsed.secs() << " messages/sec, "
+         << messages * size.bytes() / elapsed.secs() / Megabytes(1).bytes()
+         << " MB/sec)"
+         << endl;
+
+    report("Round trip latency of " + stringify(size), latencies.get());
+
+    terminate(pinger);
+    wait(pinger);
+  }
+
+  terminate(server);
+  wait(server);
+}
+
+
+// A process that counts the messages it receives.
+class SinkProcess : public Process<SinkProcess>
+{
+public:
+  explicit SinkProcess(size_t _messages) : messages(_messages), count(0) {}
+
+  virtual ~SinkProcess() {}
+
+  Future<Nothing> received()
+  {
+    return promise.future();
+  }
+
+protected:
+  virtual void initialize()
+  {
+    install("message", &SinkProcess::message);
+  }
+
+private:
+  void message(const UPID& from, const string& body)
+  {
+    if (++count == messages) {
+      promise.set(Nothing());
+    }
+  }
+
+  const size_t messages;
+  size_t count;
+  Promise<Nothing> promise;
+};
+
+
+// A process that sends messages to a sink as fast as it can.
+class SourceProcess : public Process<SourceProcess>
+{
+public:
+  explicit SourceProcess(const UPID& _sink) : sink(_sink) {}
+
+  virtual ~SourceProcess() {}
+
+  Nothing run(size_t messages)
+  {
+    const string body(16, '1');
+
+    for (size_t i = 0; i < messages; i++) {
+      send(sink, "message", body.c_str(), body.size());
+    }
+
+    return Nothing();
+  }
+
+private:
+  const UPID sink;
+};
+
+
+// Measures the throughput of a single process that receives the
+// messages of different numbers of concurrent senders, i.e., the
+// contention on its mailbox.
+TEST(ProcessTest, Process_BENCHMARK_FanIn)
+{
+  const size_t messages = 1000000;
+
+  const vector<size_t> senders = {1, 10, 100, 1000};
+
+  foreach (size_t count, senders) {
+    SinkProcess sink(messages);
+    spawn(sink);
+
+    vector<Owned<SourceProcess>> sources;
+    for (size_t i = 0; i < count; i++) {
+      sources.push_back(Owned<SourceProcess>(new SourceProcess(sink.self())));
+      spawn(sources.back().get());
+    }
+
+    Stopwatch watch;
+    watch.start();
+
+    foreach (const Owned<SourceProcess>& source, sources) {
+      dispatch(source->self(), &SourceProcess::run, messages / count);
+    }
+
+    AWAIT_READY_FOR(sink.received(), Minutes(5));
+
+    Duration elapsed = watch.elapsed();
+
+    cout << "Received " << messages << " messages from " << count
+         << " sender(s) in " << elapsed << " ("
+         << messages / elapsed.secs() << " messages/sec)" << endl;
+
+    foreach (const Owned<SourceProcess>& source, sources) {
+      terminate(source.get());
+      wait(source.get());
+    }
+
+    terminate(sink);
+    wait(sink);
+  }
+}
+
+
+// A process with a route that responds right away.
+class RouteProcess : public Process<RouteProcess>
+{
+public:
+  virtual ~RouteProcess() {}
+
+protected:
+  virtual void initialize()
+  {
+    route("/ping", None(), [](const http::Request&) {
+      return http::OK("pong");
+    });
+  }
+};
+
+
+// Sends 'requests' requests over the connection, one after another,
+// and returns the latency of each of them.
+static Future<vector<Duration>> ping(
+    http::Connection connection,
+    const http::Request& request,
+    size_t requests,
+    Owned<vector<Duration>> latencies = Owned<vector<Duration>>(
+        new vector<Duration>()))
+{
+  if (latencies->size() == requests) {
+    return *latencies;
+  }
+
+  Owned<Stopwatch> watch(new Stopwatch());
+  watch->start();
+
+  return connection.send(request)
+    .then([=](const http::Response& response) -> Future<vector<Duration>> {
+      if (response.code != http::Status::OK) {
+        return process::Failure("Unexpected response " + response.status);
+      }
+
+      latencies->push_back(watch->elapsed());
+
+      return ping(connection, request, requests, latencies);
+    });
+}
+
+
+// Measures the requests per second and the latency of an HTTP route
+// served over persistent connections, with different numbers of
+// concurrent connections. This goes through sockets, so comparing a
+// run with plaintext sockets to one with SSL sockets (i.e., with
+// LIBPROCESS_SSL_ENABLED=true, in a build that supports SSL) gives
+// the cost of SSL.
+TEST(ProcessTest, Process_BENCHMARK_HttpRequests)
+{
+  const size_t requests = 10000;
+
+  const vector<size_t> connections = {1, 10, 100};
+
+  RouteProcess process;
+  spawn(process);
+
+  string scheme = "http";
+
+#ifdef USE_SSL_SOCKET
+  if (process::network::Socket::DEFAULT_KIND() ==
+      process::network::Socket::SSL) {
+    scheme = "https";
+  }
+#endif // USE_SSL_SOCKET
+
+  const http::URL url(
+      scheme,
+      process.self().address.ip,
+      process.self().address.port,
+      process.self().id + "/ping");
+
+  http::Request request;
+  request.method = "GET";
+  request.url = url;
+  request.keepAlive = true;
+
+  foreach (size_t count, connections) {
+    list<Future<http::Connection>> connects;
+    for (size_t i = 0; i < count; i++) {
+      connects.push_back(http::connect(url));
+    }
+
+    Future<list<http::Connection>> connected = collect(connects);
+    AWAIT_READY(connected);
+
+    Stopwatch watch;
+    watch.start();
+
+    list<Future<vector<Duration>>> futures;
+    foreach (const http::Connection& connection, connected.get()) {
+      futures.push_back(ping(connection, request, requests / count));
+    }
+
+    Future<list<vector<Duration>>> latencies = collect(futures);
+    AWAIT_READY_FOR(latencies, Minutes(5));
+
+    Duration elapsed = watch.elapsed();
+
+    cout << "Served " << requests << " " << scheme << " requests over "
+         << count << " connection(s) in " << elapsed << " ("
+         << requests / elapsed.secs() << " requests/sec)" << endl;
+
+    vector<Duration> all;
+    foreach (const vector<Duration>& latencies_, latencies.get()) {
+      all.insert(all.end(), latencies_.begin(), latencies_.end());
+    }
+
+    report("Request latency", all);
+
+    foreach (http::Connection connection, connected.get()) {
+      AWAIT_READY(connection.disconnect());
+    }
+  }
+
+  terminate(process);
+  wait(process);
+}
+
+
+class EchoProcess : public Process<EchoProcess>
+{
+public:
+  virtual ~EchoProcess() {}
+
+  size_t echo(size_t i) { return i; }
+};
+
+
+// A process that dispatches to an EchoProcess and continues (in its
+// own context) once the result is ready, one at a time, recording
+// the latency of each such round trip.
+class RoundTripProcess : public Process<RoundTripProcess>
+{
+public:
+  explicit RoundTripProcess(const PID<EchoProcess>& _echo) : echo(_echo) {}
+
+  virtual ~RoundTripProcess() {}
+
+  Future<vector<Duration>> run(size_t _count)
+  {
+    count = _count;
+    latencies.reserve(count);
+
+    next();
+
+    return promise.future();
+  }
+
+private:
+  void next()
+  {
+    watch.start();
+
+    dispatch(echo, &EchoProcess::echo, latencies.size())
+      .then(defer(self(), [this](size_t) -> Nothing {
+        latencies.push_back(watch.elapsed());
+
+        if (latencies.size() == count) {
+          promise.set(latencies);
+        } else {
+          next();
+        }
+
+        return Nothing();
+      }));
+  }
+
+  const PID<EchoProcess> echo;
+
+  size_t count;
+  Stopwatch watch;
+  vector<Duration> latencies;
+  Promise<vector<Duration>> promise;
+};
+
+
+// Measures the latency of a 'dispatch' to another process and of a
+// deferred 'Future::then' back, i.e., of how processes usually talk
+// to each other (see Process_BENCHMARK_Dispatch for the throughput).
+TEST(ProcessTest, Process_BENCHMARK_DispatchLatency)
+{
+  const size_t dispatches = 100000;
+
+  EchoProcess echo;
+  spawn(echo);
+
+  RoundTripProcess roundTrip(echo.self());
+  spawn(roundTrip);
+
+  Future<vector<Duration>> latencies =
+    dispatch(roundTrip, &RoundTripProcess::run, dispatches);
+
+  AWAIT_READY_FOR(latencies, Minutes(5));
+
+  report("Dispatch and deferred 'then' latency", latencies.get());
+
+  terminate(roundTrip);
+  wait(roundTrip);
+
+  terminate(echo);
+  wait(echo);
+}
+
+
+// A process that records how late each of its timers fires.
+class TimersProcess : public Process<TimersProcess>
+{
+public:
+  explicit TimersProcess(size_t _timers) : timers(_timers) {}
+
+  virtual ~TimersProcess() {}
+
+  Future<vector<Duration>> run(const Duration& spread)
+  {
+    lateness.reserve(timers);
+
+    const process::Time now = process::Clock::now();
+
+    // Spread the timers evenly over 'spread', in a shuffled order so
+    // that they are not installed in the order they expire.
+    for (size_t i = 0; i < timers; i++) {
+      const Duration duration =
+        spread * (static_cast<double>((i * 7919) % timers) / timers);
+
+      process::delay(duration, self(), &TimersProcess::fire, now + duration);
+    }
+
+    return promise.future();
+  }
+
+private:
+  void fire(const process::Time& due)
+  {
+    lateness.push_back(process::Clock::now() - due);
+
+    if (lateness.size() == timers) {
+      promise.set(lateness);
+    }
+  }
+
+  const size_t timers;
+  vector<Duration> lateness;
+  Promise<vector<Duration>> promise;
+};
+
+
+// Measures how late timers fire when many of them are pending.
+TEST(ProcessTest, Process_BENCHMARK_Timers)
+{
+  const vector<size_t> counts = {1000, 10000, 100000};
+
+  foreach (size_t timers, counts) {
+    TimersProcess process(timers);
+    spawn(process);
+
+    Future<vector<Duration>> lateness =
+      dispatch(process, &TimersProcess::run, Seconds(1));
+
+    AWAIT_READY_FOR(lateness, Minutes(1));
+
+    report("Lateness of " + stringify(timers) + " timers", lateness.get());
+
+    terminate(process);
+    wait(process);
+  }
+}
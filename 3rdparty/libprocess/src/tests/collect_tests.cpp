@@ -10,6 +10,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License
 
+#include <memory>
+
 #include <process/collect.hpp>
 #include <process/gtest.hpp>
 
@@ -19,6 +21,9 @@ using process::Future;
 using process::Promise;
 
 using std::list;
+using std::shared_ptr;
+using std::vector;
+using std::weak_ptr;
 
 TEST(CollectTest, Ready)
 {
@@ -128,6 +133,120 @@ TEST(CollectTest, DiscardPropagation)
 }
 
 
+TEST(CollectTest, Vector)
+{
+  // First ensure an empty vector functions correctly.
+  vector<Future<int>> empty;
+  Future<vector<int>> collect = process::collect(empty);
+
+  AWAIT_READY(collect);
+  EXPECT_TRUE(collect.get().empty());
+
+  Promise<int> promise1;
+  Promise<int> promise2;
+  Promise<int> promise3;
+
+  vector<Future<int>> futures = {
+    promise1.future(),
+    promise2.future(),
+    promise3.future()
+  };
+
+  collect = process::collect(futures);
+
+  // Set them out-of-order, the collect completes in place once the
+  // last of them is set.
+  promise3.set(3);
+  promise1.set(1);
+
+  ASSERT_TRUE(collect.isPending());
+
+  promise2.set(2);
+
+  ASSERT_TRUE(collect.isReady());
+  EXPECT_EQ(vector<int>({1, 2, 3}), collect.get());
+
+  // Collect should fail when a future fails.
+  Promise<int> promise4;
+  Promise<int> promise5;
+
+  collect = process::collect(
+      vector<Future<int>>({promise4.future(), promise5.future()}));
+
+  promise4.fail("failure");
+
+  AWAIT_FAILED(collect);
+
+  promise5.set(5);
+
+  // Collect should fail when a future is discarded.
+  Promise<int> promise6;
+
+  collect = process::collect(
+      vector<Future<int>>({promise1.future(), promise6.future()}));
+
+  promise6.discard();
+
+  AWAIT_FAILED(collect);
+}
+
+
+// Tests that the state shared by the futures gets released once the
+// collect fails, even if some of the futures are still pending.
+TEST(CollectTest, VectorFailedReleasesFutures)
+{
+  Promise<shared_ptr<int>> promise1;
+  Promise<shared_ptr<int>> promise2;
+
+  weak_ptr<int> probe;
+  Future<vector<shared_ptr<int>>> collect;
+
+  {
+    shared_ptr<int> value(new int(1));
+    probe = value;
+
+    // Only the futures held by the collect refer to the value once
+    // we leave this scope.
+    collect = process::collect(
+        vector<Future<shared_ptr<int>>>({
+            value,
+            promise1.future(),
+            promise2.future()}));
+  }
+
+  EXPECT_FALSE(probe.expired());
+
+  promise1.fail("failure");
+
+  AWAIT_FAILED(collect);
+
+  // The pending 'promise2' must not keep the futures alive.
+  EXPECT_TRUE(promise2.future().isPending());
+  EXPECT_TRUE(probe.expired());
+}
+
+
+TEST(CollectTest, VectorDiscardPropagation)
+{
+  Future<int> future1;
+  Future<int> future2;
+
+  future1
+    .onDiscard([=](){ process::internal::discarded(future1); });
+  future2
+    .onDiscard([=](){ process::internal::discarded(future2); });
+
+  Future<vector<int>> collect =
+    process::collect(vector<Future<int>>({future1, future2}));
+
+  collect.discard();
+
+  AWAIT_DISCARDED(collect);
+  AWAIT_DISCARDED(future1);
+  AWAIT_DISCARDED(future2);
+}
+
+
 TEST(AwaitTest, Success)
 {
   // First ensure an empty list functions correctly.
@@ -242,3 +361,62 @@ TEST(AwaitTest, DiscardPropagation)
   AWAIT_DISCARDED(future1);
   AWAIT_DISCARDED(future2);
 }
+
+
+TEST(AwaitTest, Vector)
+{
+  // First ensure an empty vector functions correctly.
+  vector<Future<int>> empty;
+  Future<vector<Future<int>>> await = process::await(empty);
+
+  AWAIT_READY(await);
+  EXPECT_TRUE(await.get().empty());
+
+  Promise<int> promise1;
+  Promise<int> promise2;
+  Promise<int> promise3;
+
+  vector<Future<int>> futures = {
+    promise1.future(),
+    promise2.future(),
+    promise3.future()
+  };
+
+  await = process::await(futures);
+
+  promise3.discard();
+  promise1.set(1);
+
+  ASSERT_TRUE(await.isPending());
+
+  promise2.fail("failure");
+
+  ASSERT_TRUE(await.isReady());
+  ASSERT_EQ(3u, await.get().size());
+
+  ASSERT_TRUE(await.get()[0].isReady());
+  EXPECT_EQ(1, await.get()[0].get());
+  EXPECT_TRUE(await.get()[1].isFailed());
+  EXPECT_TRUE(await.get()[2].isDiscarded());
+}
+
+
+TEST(AwaitTest, VectorDiscardPropagation)
+{
+  Future<int> future1;
+  Future<int> future2;
+
+  future1
+    .onDiscard([=](){ process::internal::discarded(future1); });
+  future2
+    .onDiscard([=](){ process::internal::discarded(future2); });
+
+  Future<vector<Future<int>>> await =
+    process::await(vector<Future<int>>({future1, future2}));
+
+  await.discard();
+
+  AWAIT_DISCARDED(await);
+  AWAIT_DISCARDED(future1);
+  AWAIT_DISCARDED(future2);
+}
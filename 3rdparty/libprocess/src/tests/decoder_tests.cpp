@@ -13,11 +13,18 @@
 #include <gmock/gmock.h>
 
 #include <deque>
+#include <sstream>
 #include <string>
+#include <vector>
 
+#include <process/owned.hpp>
 #include <process/socket.hpp>
 
+#include <stout/bytes.hpp>
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
+#include <stout/gzip.hpp>
+#include <stout/stringify.hpp>
 
 #include "decoder.hpp"
 
@@ -25,6 +32,7 @@ namespace http = process::http;
 
 using process::DataDecoder;
 using process::Future;
+using process::Owned;
 using process::ResponseDecoder;
 using process::StreamingResponseDecoder;
 
@@ -32,12 +40,20 @@ using process::network::Socket;
 
 using std::deque;
 using std::string;
+using std::vector;
+
+
+static bool streaming(const http::Request& request)
+{
+  return request.url.path == "/stream";
+}
+
 
 TEST(DecoderTest, Request)
 {
   Try<Socket> socket = Socket::create();
   ASSERT_SOME(socket);
-  DataDecoder decoder = DataDecoder(socket.get());
+  DataDecoder decoder(socket.get());
 
   const string data =
     "GET /path/file.json?key1=value1&key2=value2#fragment HTTP/1.1\r\n"
@@ -75,7 +91,7 @@ TEST(DecoderTest, RequestHeaderContinuation)
 {
   Try<Socket> socket = Socket::create();
   ASSERT_SOME(socket);
-  DataDecoder decoder = DataDecoder(socket.get());
+  DataDecoder decoder(socket.get());
 
   const string data =
     "GET /path/file.json HTTP/1.1\r\n"
@@ -100,7 +116,7 @@ TEST(DecoderTest, RequestHeaderCaseInsensitive)
 {
   Try<Socket> socket = Socket::create();
   ASSERT_SOME(socket);
-  DataDecoder decoder = DataDecoder(socket.get());
+  DataDecoder decoder(socket.get());
 
   const string data =
     "GET /path/file.json HTTP/1.1\r\n"
@@ -122,6 +138,226 @@ TEST(DecoderTest, RequestHeaderCaseInsensitive)
 }
 
 
+TEST(DecoderTest, StreamingRequest)
+{
+  Try<Socket> socket = Socket::create();
+  ASSERT_SOME(socket);
+  DataDecoder decoder(socket.get(), &streaming);
+
+  const string headers =
+    "POST /stream?key=value HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "Content-Length: 5\r\n"
+    "\r\n";
+
+  // The request is returned as soon as the headers are decoded.
+  deque<http::Request*> requests =
+    decoder.decode(headers.data(), headers.length());
+
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_EQ(1, requests.size());
+
+  http::Request* request = requests[0];
+  EXPECT_EQ("POST", request->method);
+  EXPECT_EQ("/stream", request->url.path);
+  EXPECT_SOME_EQ("value", request->url.query.get("key"));
+  EXPECT_TRUE(request->body.empty());
+
+  ASSERT_EQ(http::Request::PIPE, request->type);
+  ASSERT_SOME(request->reader);
+
+  http::Pipe::Reader reader = request->reader.get();
+  delete request;
+
+  Future<string> read = reader.read();
+  EXPECT_TRUE(read.isPending());
+
+  requests = decoder.decode("he", 2);
+  ASSERT_FALSE(decoder.failed());
+  EXPECT_TRUE(requests.empty());
+
+  ASSERT_TRUE(read.isReady());
+  EXPECT_EQ("he", read.get());
+
+  // The rest of the body is followed by a request which is not
+  // streamed.
+  const string data =
+    "llo"
+    "POST /path HTTP/1.1\r\n"
+    "Content-Length: 3\r\n"
+    "\r\n"
+    "abc";
+
+  requests = decoder.decode(data.data(), data.length());
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_EQ(1, requests.size());
+
+  request = requests[0];
+  EXPECT_EQ(http::Request::BODY, request->type);
+  EXPECT_NONE(request->reader);
+  EXPECT_EQ("abc", request->body);
+  delete request;
+
+  read = reader.read();
+  ASSERT_TRUE(read.isReady());
+  EXPECT_EQ("llo", read.get());
+
+  // End-of-file.
+  read = reader.read();
+  ASSERT_TRUE(read.isReady());
+  EXPECT_EQ("", read.get());
+}
+
+
+TEST(DecoderTest, StreamingRequestFailure)
+{
+  Try<Socket> socket = Socket::create();
+  ASSERT_SOME(socket);
+
+  Owned<DataDecoder> decoder(new DataDecoder(socket.get(), &streaming));
+
+  const string data =
+    "POST /stream HTTP/1.1\r\n"
+    "Content-Length: 5\r\n"
+    "\r\n"
+    "he";
+
+  deque<http::Request*> requests = decoder->decode(data.data(), data.length());
+  ASSERT_FALSE(decoder->failed());
+  ASSERT_EQ(1, requests.size());
+
+  ASSERT_SOME(requests[0]->reader);
+  http::Pipe::Reader reader = requests[0]->reader.get();
+  delete requests[0];
+
+  Future<string> read = reader.read();
+  ASSERT_TRUE(read.isReady());
+  EXPECT_EQ("he", read.get());
+
+  read = reader.read();
+  EXPECT_TRUE(read.isPending());
+
+  // Destroying the decoder (e.g., because the socket got closed)
+  // before the body is complete fails the reader.
+  decoder.reset();
+
+  EXPECT_TRUE(read.isFailed());
+}
+
+
+TEST(DecoderTest, RequestGzip)
+{
+  const string body(64 * 1024, 'a');
+
+  Try<string> compressed = gzip::compress(body);
+  ASSERT_SOME(compressed);
+
+  const string headers =
+    "POST /path HTTP/1.1\r\n"
+    "Content-Encoding: gzip\r\n"
+    "Content-Length: " + stringify(compressed->size()) + "\r\n"
+    "\r\n";
+
+  Try<Socket> socket = Socket::create();
+  ASSERT_SOME(socket);
+
+  // Feed the compressed body in pieces to check that it gets
+  // decompressed incrementally.
+  DataDecoder decoder(socket.get());
+
+  deque<http::Request*> requests =
+    decoder.decode(headers.data(), headers.length());
+
+  for (size_t offset = 0; offset < compressed->size(); offset += 7) {
+    ASSERT_TRUE(requests.empty());
+    const string piece = compressed->substr(offset, 7);
+    requests = decoder.decode(piece.data(), piece.length());
+    ASSERT_FALSE(decoder.failed());
+  }
+
+  ASSERT_EQ(1, requests.size());
+  EXPECT_EQ(body, requests[0]->body);
+  EXPECT_SOME_EQ(stringify(body.size()),
+                 requests[0]->headers.get("Content-Length"));
+  delete requests[0];
+
+  // A streamed body gets decompressed as well.
+  DataDecoder streamingDecoder(socket.get(), &streaming);
+
+  const string data =
+    "POST /stream HTTP/1.1\r\n"
+    "Content-Encoding: gzip\r\n"
+    "Content-Length: " + stringify(compressed->size()) + "\r\n"
+    "\r\n" + compressed.get();
+
+  requests = streamingDecoder.decode(data.data(), data.length());
+  ASSERT_FALSE(streamingDecoder.failed());
+  ASSERT_EQ(1, requests.size());
+
+  ASSERT_SOME(requests[0]->reader);
+  EXPECT_NONE(requests[0]->headers.get("Content-Length"));
+
+  Future<string> all = requests[0]->reader->readAll();
+  delete requests[0];
+
+  ASSERT_TRUE(all.isReady());
+  EXPECT_EQ(body, all.get());
+}
+
+
+TEST(DecoderTest, RequestMaxBodySize)
+{
+  Try<Socket> socket = Socket::create();
+  ASSERT_SOME(socket);
+
+  DataDecoder decoder(socket.get(), &streaming, Bytes(4));
+
+  // A body within the limit.
+  string data =
+    "POST /path HTTP/1.1\r\n"
+    "Content-Length: 4\r\n"
+    "\r\n"
+    "abcd";
+
+  deque<http::Request*> requests = decoder.decode(data.data(), data.length());
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_EQ(1, requests.size());
+  EXPECT_EQ("abcd", requests[0]->body);
+  delete requests[0];
+
+  // A streamed body exceeding the limit fails both the decoder and
+  // the reader.
+  data =
+    "POST /stream HTTP/1.1\r\n"
+    "Content-Length: 5\r\n"
+    "\r\n"
+    "abcde";
+
+  requests = decoder.decode(data.data(), data.length());
+  EXPECT_TRUE(decoder.failed());
+  ASSERT_EQ(1, requests.size());
+
+  ASSERT_SOME(requests[0]->reader);
+  Future<string> all = requests[0]->reader->readAll();
+  delete requests[0];
+
+  EXPECT_TRUE(all.isFailed());
+
+  // A whole body exceeding the limit fails the decoder.
+  DataDecoder decoder2(socket.get(), &streaming, Bytes(4));
+
+  data =
+    "POST /path HTTP/1.1\r\n"
+    "Content-Length: 5\r\n"
+    "\r\n"
+    "abcde";
+
+  requests = decoder2.decode(data.data(), data.length());
+  EXPECT_TRUE(decoder2.failed());
+  EXPECT_TRUE(requests.empty());
+}
+
+
 TEST(DecoderTest, Response)
 {
   ResponseDecoder decoder;
@@ -201,6 +437,67 @@ TEST(DecoderTest, StreamingResponse)
 }
 
 
+TEST(DecoderTest, StreamingResponseGzip)
+{
+  StreamingResponseDecoder decoder;
+
+  const string headers =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Encoding: gzip\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "\r\n";
+
+  deque<http::Response*> responses =
+    decoder.decode(headers.data(), headers.length());
+
+  EXPECT_FALSE(decoder.failed());
+  ASSERT_EQ(1, responses.size());
+
+  Owned<http::Response> response(responses[0]);
+  ASSERT_SOME(response->reader);
+
+  http::Pipe::Reader reader = response->reader.get();
+
+  // Each chunk of the compressed stream is decompressed as soon as
+  // it arrives.
+  gzip::Compressor compressor;
+
+  const vector<string> data = {"hello", "world"};
+
+  foreach (const string& piece, data) {
+    Try<string> compressed = compressor.compress(piece);
+    ASSERT_SOME(compressed);
+
+    std::ostringstream chunk;
+    chunk << std::hex << compressed->size() << "\r\n"
+          << compressed.get() << "\r\n";
+
+    Future<string> read = reader.read();
+
+    decoder.decode(chunk.str().data(), chunk.str().length());
+    EXPECT_FALSE(decoder.failed());
+
+    ASSERT_TRUE(read.isReady());
+    EXPECT_EQ(piece, read.get());
+  }
+
+  Try<string> end = compressor.finish();
+  ASSERT_SOME(end);
+
+  std::ostringstream chunk;
+  chunk << std::hex << end->size() << "\r\n" << end.get() << "\r\n"
+        << "0\r\n\r\n";
+
+  decoder.decode(chunk.str().data(), chunk.str().length());
+  EXPECT_FALSE(decoder.failed());
+  EXPECT_FALSE(decoder.writingBody());
+
+  Future<string> read = reader.read();
+  ASSERT_TRUE(read.isReady());
+  EXPECT_EQ("", read.get()); // EOF.
+}
+
+
 TEST(DecoderTest, StreamingResponseFailure)
 {
   StreamingResponseDecoder decoder;
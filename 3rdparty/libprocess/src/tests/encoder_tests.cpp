@@ -12,22 +12,32 @@
 
 #include <gmock/gmock.h>
 
+#include <algorithm>
 #include <deque>
 #include <string>
 #include <vector>
 
 #include <process/http.hpp>
+#include <process/message.hpp>
 #include <process/socket.hpp>
 
 #include <stout/gtest.hpp>
+#include <stout/gzip.hpp>
 
 #include "encoder.hpp"
 #include "decoder.hpp"
 
 namespace http = process::http;
 
+using process::DataDecoder;
+using process::DataEncoder;
 using process::HttpResponseEncoder;
+using process::Message;
+using process::MessageEncoder;
 using process::ResponseDecoder;
+using process::UPID;
+
+using process::network::Socket;
 
 using std::deque;
 using std::string;
@@ -109,3 +119,127 @@ TEST(EncoderTest, AcceptableEncodings)
       << gzipRequest.headers.get("Accept-Encoding").get() << "'";
   }
 }
+
+
+// Returns the data of all iovecs returned by 'next', sending only
+// part of the data each time to exercise 'backup'.
+static string drain(MessageEncoder* encoder)
+{
+  string result;
+
+  while (encoder->remaining() > 0) {
+    int iovcnt;
+    size_t length;
+    const struct iovec* iov = encoder->next(&iovcnt, &length);
+
+    // "Send" at most half (but at least one byte) of the data.
+    size_t sent = std::max<size_t>(length / 2, 1);
+    encoder->backup(length - sent);
+
+    for (int i = 0; i < iovcnt && sent > 0; i++) {
+      const size_t size = std::min(sent, iov[i].iov_len);
+      result.append(static_cast<const char*>(iov[i].iov_base), size);
+      sent -= size;
+    }
+  }
+
+  return result;
+}
+
+
+TEST(EncoderTest, Message)
+{
+  Try<Socket> socket = Socket::create();
+  ASSERT_SOME(socket);
+
+  Message* message = new Message();
+  message->name = "name";
+  message->from = UPID("from@0.0.0.1:1");
+  message->to = UPID("to@0.0.0.1:1");
+  message->body = string(4096, 'x');
+
+  const string encoded = MessageEncoder::encode(message);
+
+  // The encoder keeps the header, the body and the trailer separate.
+  MessageEncoder encoder(socket.get(), message);
+  EXPECT_EQ(3u, encoder.count());
+  EXPECT_EQ(encoded.size(), encoder.remaining());
+
+  EXPECT_EQ(encoded, drain(&encoder));
+}
+
+
+TEST(EncoderTest, CompressedMessage)
+{
+  Try<Socket> socket = Socket::create();
+  ASSERT_SOME(socket);
+
+  const string body(64 * 1024, 'x');
+
+  Try<string> compressed = gzip::compress(body);
+  ASSERT_SOME(compressed);
+
+  Message* message = new Message();
+  message->name = "name";
+  message->from = UPID("from@0.0.0.1:1");
+  message->to = UPID("to@0.0.0.1:1");
+  message->body = compressed.get();
+
+  MessageEncoder encoder(socket.get(), message, true);
+  const string encoded = drain(&encoder);
+
+  // The receiver gets the original body back.
+  DataDecoder decoder(socket.get());
+
+  deque<http::Request*> requests =
+    decoder.decode(encoded.data(), encoded.length());
+
+  ASSERT_FALSE(decoder.failed());
+  ASSERT_EQ(1u, requests.size());
+
+  EXPECT_EQ("/to/name", requests[0]->url.path);
+  EXPECT_EQ(body, requests[0]->body);
+  EXPECT_SOME_EQ("gzip", requests[0]->headers.get("Content-Encoding"));
+  EXPECT_SOME_EQ(
+      "gzip", requests[0]->headers.get("Libprocess-Accept-Encoding"));
+
+  delete requests[0];
+}
+
+
+TEST(EncoderTest, Coalesce)
+{
+  Try<Socket> socket = Socket::create();
+  ASSERT_SOME(socket);
+
+  Message* message1 = new Message();
+  message1->name = "first";
+  message1->to = UPID("to@0.0.0.1:1");
+  message1->body = "body";
+
+  // A message without a body only has a header.
+  Message* message2 = new Message();
+  message2->name = "second";
+  message2->to = UPID("to@0.0.0.1:1");
+
+  const string encoded =
+    MessageEncoder::encode(message1) +
+    MessageEncoder::encode(message2) +
+    "data";
+
+  MessageEncoder encoder(socket.get(), message1);
+
+  {
+    MessageEncoder that(socket.get(), message2);
+    encoder.append(that);
+  }
+
+  {
+    DataEncoder that(socket.get(), "data");
+    encoder.append(that);
+  }
+
+  EXPECT_EQ(5u, encoder.count());
+
+  EXPECT_EQ(encoded, drain(&encoder));
+}
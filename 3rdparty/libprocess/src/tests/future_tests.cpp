@@ -17,6 +17,7 @@
 #include <process/future.hpp>
 
 using process::Future;
+using process::Promise;
 
 using std::string;
 
@@ -27,3 +28,36 @@ TEST(FutureTest, ArrowOperator)
   Future<string> s = string("hello");
   EXPECT_EQ(5u, s->size());
 }
+
+
+// Counts the copies made of a value, but not the moves.
+struct Copies
+{
+  Copies() : count(0) {}
+  Copies(const Copies& that) : count(that.count + 1) {}
+  Copies(Copies&& that) : count(that.count) {}
+
+  Copies& operator=(const Copies& that)
+  {
+    count = that.count + 1;
+    return *this;
+  }
+
+  int count;
+};
+
+
+TEST(FutureTest, Move)
+{
+  // Setting a future with a temporary value moves it into the future.
+  Promise<Copies> promise;
+  EXPECT_TRUE(promise.set(Copies()));
+
+  ASSERT_TRUE(promise.future().isReady());
+  EXPECT_EQ(0, promise.future().get().count);
+
+  Future<Copies> future = Copies();
+
+  ASSERT_TRUE(future.isReady());
+  EXPECT_EQ(0, future.get().count);
+}
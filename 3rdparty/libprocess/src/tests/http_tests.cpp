@@ -21,6 +21,7 @@
 #include <vector>
 
 #include <process/address.hpp>
+#include <process/clock.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
@@ -34,12 +35,17 @@
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
 #include <stout/os.hpp>
+#include <stout/path.hpp>
 #include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+
+#include <stout/tests/utils.hpp>
 
 #include "encoder.hpp"
 
 namespace http = process::http;
 
+using process::Clock;
 using process::Future;
 using process::Owned;
 using process::Process;
@@ -47,6 +53,7 @@ using process::Promise;
 
 using process::http::URL;
 
+using process::network::Address;
 using process::network::Socket;
 
 using std::string;
@@ -71,10 +78,15 @@ public:
   MOCK_METHOD1(requestDelete, Future<http::Response>(const http::Request&));
   MOCK_METHOD1(a, Future<http::Response>(const http::Request&));
   MOCK_METHOD1(abc, Future<http::Response>(const http::Request&));
+  MOCK_METHOD1(stream, Future<http::Response>(const http::Request&));
+  MOCK_METHOD1(whole, Future<http::Response>(const http::Request&));
 
 protected:
   virtual void initialize()
   {
+    RouteOptions options;
+    options.requestStreaming = true;
+
     route("/auth", None(), &HttpProcess::auth);
     route("/body", None(), &HttpProcess::body);
     route("/pipe", None(), &HttpProcess::pipe);
@@ -83,6 +95,8 @@ protected:
     route("/delete", None(), &HttpProcess::requestDelete);
     route("/a", None(), &HttpProcess::a);
     route("/a/b/c", None(), &HttpProcess::abc);
+    route("/stream", None(), &HttpProcess::stream, options);
+    route("/stream/whole", None(), &HttpProcess::whole);
   }
 
   Future<http::Response> auth(const http::Request& request)
@@ -333,6 +347,55 @@ TEST(HTTPTest, PipeReaderCloses)
 }
 
 
+TEST(HTTPTest, PipeHighWaterMark)
+{
+  http::Pipe pipe(Bytes(10));
+  http::Pipe::Reader reader = pipe.reader();
+  http::Pipe::Writer writer = pipe.writer();
+
+  AWAIT_READY(writer.writable());
+
+  // Writes beyond the high-water mark still succeed, but the pipe
+  // is only writable again once the reader has caught up.
+  EXPECT_TRUE(writer.write("hello"));
+  EXPECT_TRUE(writer.write("world"));
+  EXPECT_TRUE(writer.write("!"));
+
+  Future<Nothing> writable = writer.writable();
+  EXPECT_TRUE(writable.isPending());
+
+  AWAIT_EXPECT_EQ("hello", reader.read());
+  AWAIT_READY(writable);
+
+  AWAIT_EXPECT_EQ("world", reader.read());
+  AWAIT_EXPECT_EQ("!", reader.read());
+
+  // Writes that satisfy a pending read don't count.
+  Future<string> read = reader.read();
+  EXPECT_TRUE(writer.write("0123456789"));
+  AWAIT_EXPECT_EQ("0123456789", read);
+  AWAIT_READY(writer.writable());
+
+  // Waiting writers fail once either end gets closed.
+  EXPECT_TRUE(writer.write("0123456789"));
+
+  writable = writer.writable();
+  EXPECT_TRUE(writable.isPending());
+
+  EXPECT_TRUE(reader.close());
+  AWAIT_FAILED(writable);
+  AWAIT_FAILED(writer.writable());
+
+  // Pipes without a high-water mark are always writable.
+  http::Pipe unbounded;
+  EXPECT_TRUE(unbounded.writer().write(string(1024, 'a')));
+  AWAIT_READY(unbounded.writer().writable());
+
+  EXPECT_TRUE(unbounded.writer().close());
+  AWAIT_FAILED(unbounded.writer().writable());
+}
+
+
 TEST(HTTPTest, Encode)
 {
   string unencoded = "a$&+,/:;=?@ \"<>#%{}|\\^~[]`\x19\x80\xFF";
@@ -455,6 +518,49 @@ TEST(HTTPTest, Get)
 }
 
 
+TEST(HTTPTest, CompressedBody)
+{
+  Http http;
+
+  http::OK ok(string(64 * 1024, 'a'));
+  ok.headers["ETag"] = "\"1\"";
+
+  EXPECT_CALL(*http.process, body(_))
+    .WillRepeatedly(Return(ok));
+
+  http::Headers headers;
+  headers["Accept-Encoding"] = "gzip";
+
+  // The same version of the body (i.e., with the same 'ETag') is
+  // compressed once and then served compressed again.
+  for (int i = 0; i < 2; i++) {
+    Future<http::Response> response =
+      http::get(http.process->self(), "body", None(), headers);
+
+    AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+    EXPECT_SOME_EQ("gzip", response->headers.get("Content-Encoding"));
+    EXPECT_EQ(ok.body, response->body);
+  }
+
+  // Clients that do not accept gzip get the body as is.
+  Future<http::Response> response = http::get(http.process->self(), "body");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  EXPECT_NONE(response->headers.get("Content-Encoding"));
+  EXPECT_EQ(ok.body, response->body);
+
+  // Small bodies are not compressed.
+  EXPECT_CALL(*http.process, body(_))
+    .WillOnce(Return(http::OK("small")));
+
+  response = http::get(http.process->self(), "body", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  EXPECT_NONE(response->headers.get("Content-Encoding"));
+  EXPECT_EQ("small", response->body);
+}
+
+
 TEST(HTTPTest, NestedGet)
 {
   Http http;
@@ -638,6 +744,70 @@ TEST(HTTPTest, Post)
 }
 
 
+Future<http::Response> validateStream(const http::Request& request)
+{
+  EXPECT_EQ("POST", request.method);
+  EXPECT_EQ(http::Request::PIPE, request.type);
+  EXPECT_TRUE(request.body.empty());
+
+  if (request.reader.isNone()) {
+    return http::InternalServerError();
+  }
+
+  // Respond with the body that was read from the pipe. Reading needs
+  // a non-const reader, which shares the pipe with the request's.
+  http::Pipe::Reader reader = request.reader.get();
+
+  return reader.readAll()
+    .then([](const string& body) -> http::Response {
+      return http::OK(body);
+    });
+}
+
+
+TEST(HTTPTest, StreamingPost)
+{
+  Http http;
+
+  // Use a body that does not get received in a single read.
+  string body = "";
+  while (body.length() < (1024 * 1024)) {
+    body.append(1, ' ' + (rand() % ('~' - ' ')));
+  }
+
+  EXPECT_CALL(*http.process, stream(_))
+    .WillOnce(Invoke(validateStream));
+
+  Future<http::Response> future =
+    http::post(http.process->self(), "stream", None(), body, "text/plain");
+
+  AWAIT_READY(future);
+  ASSERT_EQ(http::Status::OK, future->code);
+  EXPECT_EQ(body, future->body);
+
+  // A route below a streaming route which does not stream requests
+  // still gets the whole body.
+  Future<http::Request> request;
+  EXPECT_CALL(*http.process, whole(_))
+    .WillOnce(DoAll(FutureArg<0>(&request), Return(http::OK())));
+
+  future = http::post(
+      http.process->self(),
+      "stream/whole",
+      None(),
+      "This is the payload.",
+      "text/plain");
+
+  AWAIT_READY(future);
+  ASSERT_EQ(http::Status::OK, future->code);
+
+  AWAIT_READY(request);
+  EXPECT_EQ(http::Request::BODY, request->type);
+  EXPECT_NONE(request->reader);
+  EXPECT_EQ("This is the payload.", request->body);
+}
+
+
 http::Response validateDelete(const http::Request& request)
 {
   EXPECT_EQ("DELETE", request.method);
@@ -1004,6 +1174,341 @@ TEST(HTTPConnectionTest, Equality)
 }
 
 
+class HTTPConnectionUnixTest : public TemporaryDirectoryTest {};
+
+
+// Tests that requests can be sent over a persistent connection to a
+// server listening on a unix domain socket.
+TEST_F(HTTPConnectionUnixTest, Serial)
+{
+  const string path = path::join(os::getcwd(), "server.sock");
+
+  Try<Address> address = Address::create(path);
+
+  ASSERT_SOME(address);
+
+  Try<Socket> create = Socket::create(Socket::POLL, None(), AF_UNIX);
+  ASSERT_SOME(create);
+
+  Socket server = create.get();
+
+  ASSERT_SOME(server.bind(address.get()));
+  ASSERT_SOME(server.listen(1));
+  EXPECT_SOME_EQ(address.get(), server.address());
+
+  Future<Socket> accept = server.accept();
+
+  Future<http::Connection> connect = http::connect(address.get());
+  AWAIT_READY(connect);
+
+  http::Connection connection = connect.get();
+
+  AWAIT_READY(accept);
+
+  Socket socket = accept.get();
+
+  http::Request request;
+  request.method = "GET";
+  request.url = URL("http", "localhost", 80, "/containers/json");
+  request.keepAlive = true;
+
+  for (int i = 0; i < 2; i++) {
+    Future<http::Response> response = connection.send(request);
+
+    Future<string> received = socket.recv();
+    AWAIT_READY(received);
+    EXPECT_TRUE(strings::startsWith(
+        received.get(), "GET /containers/json HTTP/1.1\r\n"));
+
+    AWAIT_READY(socket.send(
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Length: 2\r\n"
+        "\r\n"
+        "[]"));
+
+    AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+    AWAIT_EXPECT_RESPONSE_BODY_EQ("[]", response);
+  }
+
+  AWAIT_READY(connection.disconnect());
+
+  // The sandbox can only be removed once the socket file is.
+  ASSERT_SOME(os::rm(path));
+}
+
+
+// Tests that sequential requests get sent on the same connection.
+TEST(HTTPConnectionPoolTest, Reuse)
+{
+  Http http;
+
+  http::URL url = http::URL(
+      "http",
+      http.process->self().address.ip,
+      http.process->self().address.port,
+      http.process->self().id + "/get");
+
+  Future<http::Request> get1;
+  Future<http::Request> get2;
+
+  EXPECT_CALL(*http.process, get(_))
+    .WillOnce(DoAll(FutureArg<0>(&get1), Return(http::OK("1"))))
+    .WillOnce(DoAll(FutureArg<0>(&get2), Return(http::OK("2"))));
+
+  http::ConnectionPool pool;
+
+  http::Request request;
+  request.method = "GET";
+  request.url = url;
+
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("1", pool.send(request));
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("2", pool.send(request));
+
+  AWAIT_READY(get1);
+  AWAIT_READY(get2);
+
+  EXPECT_EQ(get1->client, get2->client);
+}
+
+
+// Tests that concurrent requests get sent on separate connections,
+// up to the maximum number of connections, after which they get
+// pipelined.
+TEST(HTTPConnectionPoolTest, MaxConnections)
+{
+  Http http;
+
+  http::URL url = http::URL(
+      "http",
+      http.process->self().address.ip,
+      http.process->self().address.port,
+      http.process->self().id + "/get");
+
+  Promise<http::Response> promise1;
+  Promise<http::Response> promise2;
+
+  Future<http::Request> get1;
+  Future<http::Request> get2;
+  Future<http::Request> get3;
+
+  EXPECT_CALL(*http.process, get(_))
+    .WillOnce(DoAll(FutureArg<0>(&get1), Return(promise1.future())))
+    .WillOnce(DoAll(FutureArg<0>(&get2), Return(promise2.future())))
+    .WillOnce(DoAll(FutureArg<0>(&get3), Return(http::OK("3"))));
+
+  http::ConnectionPool::Options options;
+  options.maxConnections = 2;
+
+  http::ConnectionPool pool(options);
+
+  http::Request request;
+  request.method = "GET";
+  request.url = url;
+
+  Future<http::Response> response1 = pool.send(request);
+  AWAIT_READY(get1);
+
+  Future<http::Response> response2 = pool.send(request);
+  AWAIT_READY(get2);
+
+  EXPECT_NE(get1->client, get2->client);
+
+  // The third request gets pipelined behind one of the others.
+  Future<http::Response> response3 = pool.send(request);
+
+  promise1.set(http::OK("1"));
+  promise2.set(http::OK("2"));
+
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("1", response1);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("2", response2);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("3", response3);
+
+  AWAIT_READY(get3);
+  EXPECT_TRUE(get3->client == get1->client || get3->client == get2->client);
+}
+
+
+// Tests that idle connections get closed after the idle timeout.
+TEST(HTTPConnectionPoolTest, IdleTimeout)
+{
+  Http http;
+
+  http::URL url = http::URL(
+      "http",
+      http.process->self().address.ip,
+      http.process->self().address.port,
+      http.process->self().id + "/get");
+
+  Future<http::Request> get1;
+  Future<http::Request> get2;
+
+  EXPECT_CALL(*http.process, get(_))
+    .WillOnce(DoAll(FutureArg<0>(&get1), Return(http::OK("1"))))
+    .WillOnce(DoAll(FutureArg<0>(&get2), Return(http::OK("2"))));
+
+  Clock::pause();
+
+  http::ConnectionPool::Options options;
+  options.idleTimeout = Seconds(10);
+
+  http::ConnectionPool pool(options);
+
+  http::Request request;
+  request.method = "GET";
+  request.url = url;
+
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("1", pool.send(request));
+
+  Clock::advance(Seconds(20));
+  Clock::settle();
+
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("2", pool.send(request));
+
+  AWAIT_READY(get1);
+  AWAIT_READY(get2);
+
+  EXPECT_NE(get1->client, get2->client);
+
+  Clock::resume();
+}
+
+
+// Tests that a streamed response keeps the connection busy until the
+// body has been read.
+TEST(HTTPConnectionPoolTest, StreamedResponse)
+{
+  Http http;
+
+  http::URL url = http::URL(
+      "http",
+      http.process->self().address.ip,
+      http.process->self().address.port,
+      http.process->self().id + "/get");
+
+  http::Pipe pipe;
+  http::OK ok;
+  ok.type = http::Response::PIPE;
+  ok.reader = pipe.reader();
+
+  Future<http::Request> get1;
+  Future<http::Request> get2;
+
+  EXPECT_CALL(*http.process, get(_))
+    .WillOnce(DoAll(FutureArg<0>(&get1), Return(ok)))
+    .WillOnce(DoAll(FutureArg<0>(&get2), Return(http::OK("2"))));
+
+  http::ConnectionPool pool;
+
+  http::Request request;
+  request.method = "GET";
+  request.url = url;
+
+  Future<http::Response> response1 = pool.send(request, true);
+
+  AWAIT_READY(response1);
+  ASSERT_SOME(response1->reader);
+
+  http::Pipe::Reader reader = response1->reader.get();
+
+  http::Pipe::Writer writer = pipe.writer();
+  writer.write("hello");
+
+  AWAIT_EQ("hello", reader.read());
+
+  // The connection is still streaming the body, so the next request
+  // goes out on another connection.
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("2", pool.send(request));
+
+  writer.close();
+
+  AWAIT_EQ("", reader.read());
+
+  AWAIT_READY(get1);
+  AWAIT_READY(get2);
+
+  EXPECT_NE(get1->client, get2->client);
+}
+
+
+class HTTPRangeTest : public TemporaryDirectoryTest {};
+
+
+// Tests that 'Range' requests for a PATH response are served the
+// requested bytes of the file.
+TEST_F(HTTPRangeTest, Path)
+{
+  Http http;
+
+  const string path = path::join(os::getcwd(), "file");
+  ASSERT_SOME(os::write(path, "0123456789"));
+
+  http::OK ok;
+  ok.type = http::Response::PATH;
+  ok.path = path;
+  ok.headers["Content-Type"] = "text/plain";
+
+  EXPECT_CALL(*http.process, get(_))
+    .WillRepeatedly(Return(ok));
+
+  auto get = [&http](const Option<string>& range) {
+    http::Headers headers;
+    if (range.isSome()) {
+      headers["Range"] = range.get();
+    }
+    return http::get(http.process->self(), "get", None(), headers);
+  };
+
+  // Without a range the whole file gets sent.
+  Future<http::Response> response = get(None());
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("0123456789", response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes", "Accept-Ranges", response);
+
+  response = get(string("bytes=2-5"));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      http::Status::string(http::Status::PARTIAL_CONTENT), response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("2345", response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes 2-5/10", "Content-Range", response);
+
+  // An open ended range.
+  response = get(string("bytes=7-"));
+
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("789", response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes 7-9/10", "Content-Range", response);
+
+  // A suffix range.
+  response = get(string("bytes=-3"));
+
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("789", response);
+
+  // The end of a range is capped at the end of the file.
+  response = get(string("bytes=8-100"));
+
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("89", response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes 8-9/10", "Content-Range", response);
+
+  // Ranges starting beyond the end of the file can't be satisfied.
+  response = get(string("bytes=10-"));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      http::Status::string(http::Status::REQUESTED_RANGE_NOT_SATISFIABLE),
+      response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes */10", "Content-Range", response);
+
+  // Multiple and invalid ranges are ignored.
+  response = get(string("bytes=0-1,4-5"));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("0123456789", response);
+
+  response = get(string("bytes=5-2"));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+}
+
+
 TEST(HTTPTest, QueryEncodeDecode)
 {
   // If we use Type<a, b> directly inside a macro without surrounding
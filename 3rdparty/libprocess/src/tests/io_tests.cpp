@@ -361,6 +361,78 @@ TEST(IOTest, Redirect)
 }
 
 
+// Tests redirecting between pipes, which have to wait for both the
+// data to read and the room to write it, and into a file opened with
+// O_APPEND, which the kernel cannot splice into.
+TEST(IOTest, RedirectPipeAndAppend)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  string data = "Lorem ipsum dolor sit amet, consectetur adipisicing elit. ";
+
+  while (Bytes(data.size()) < Megabytes(1)) {
+    data.append(data);
+  }
+
+  int in[2];
+  int out[2];
+
+  ASSERT_NE(-1, ::pipe(in));
+  ASSERT_NE(-1, ::pipe(out));
+
+  ASSERT_SOME(os::nonblock(in[0]));
+  ASSERT_SOME(os::nonblock(in[1]));
+  ASSERT_SOME(os::nonblock(out[0]));
+  ASSERT_SOME(os::nonblock(out[1]));
+
+  Future<Nothing> redirect = io::redirect(in[0], out[1]);
+
+  ASSERT_SOME(os::close(in[0]));
+  ASSERT_SOME(os::close(out[1]));
+
+  Future<string> read = io::read(out[0]);
+
+  AWAIT_READY(io::write(in[1], data));
+  ASSERT_SOME(os::close(in[1]));
+
+  AWAIT_READY(redirect);
+  AWAIT_EXPECT_EQ(data, read);
+
+  ASSERT_SOME(os::close(out[0]));
+
+  // Now redirect into a file opened for appending.
+  Try<string> path = os::mktemp();
+  ASSERT_SOME(path);
+
+  ASSERT_SOME(os::write(path.get(), "head "));
+
+  Try<int> fd = os::open(
+      path.get(),
+      O_WRONLY | O_APPEND | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  ASSERT_SOME(fd);
+  ASSERT_SOME(os::nonblock(fd.get()));
+
+  ASSERT_NE(-1, ::pipe(in));
+  ASSERT_SOME(os::nonblock(in[0]));
+  ASSERT_SOME(os::nonblock(in[1]));
+
+  redirect = io::redirect(in[0], fd.get());
+
+  ASSERT_SOME(os::close(in[0]));
+  ASSERT_SOME(os::close(fd.get()));
+
+  AWAIT_READY(io::write(in[1], data));
+  ASSERT_SOME(os::close(in[1]));
+
+  AWAIT_READY(redirect);
+
+  EXPECT_SOME_EQ("head " + data, os::read(path.get()));
+
+  ASSERT_SOME(os::rm(path.get()));
+}
+
 TEST(IOTest, Peek)
 {
   ASSERT_TRUE(GTEST_IS_THREADSAFE);
@@ -10,6 +10,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License
 
+#include <thread>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include <gmock/gmock.h>
@@ -20,12 +23,15 @@
 #include <process/limiter.hpp>
 
 #include <stout/duration.hpp>
+#include <stout/foreach.hpp>
 #include <stout/nothing.hpp>
 
 using process::Clock;
 using process::Future;
 using process::RateLimiter;
 
+using std::vector;
+
 TEST(LimiterTest, Acquire)
 {
   ASSERT_TRUE(GTEST_IS_THREADSAFE);
@@ -121,3 +127,82 @@ TEST(LimiterTest, DiscardLast)
   Clock::advance(interval);
   AWAIT_READY(acquire3);
 }
+
+
+// This test verifies that an available permit is handed out right
+// away, without waiting on the limiter, and that the permits after
+// it are still rate limited.
+TEST(LimiterTest, AcquireReady)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  Duration interval = Milliseconds(5);
+
+  RateLimiter limiter(1, interval);
+
+  Clock::pause();
+
+  Future<Nothing> acquire1 = limiter.acquire();
+  EXPECT_TRUE(acquire1.isReady());
+
+  Future<Nothing> acquire2 = limiter.acquire();
+
+  Clock::settle();
+  EXPECT_TRUE(acquire2.isPending());
+
+  Clock::advance(interval);
+  AWAIT_READY(acquire2);
+
+  // Nobody is waiting anymore, but the next permit is not due yet.
+  Future<Nothing> acquire3 = limiter.acquire();
+
+  Clock::settle();
+  EXPECT_TRUE(acquire3.isPending());
+
+  Clock::advance(interval);
+  AWAIT_READY(acquire3);
+}
+
+
+// This test verifies that permits acquired from many threads at once
+// are still handed out one interval at a time.
+TEST(LimiterTest, AcquireConcurrently)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  Duration interval = Milliseconds(5);
+
+  RateLimiter limiter(1, interval);
+
+  Clock::pause();
+
+  const size_t count = 8;
+
+  vector<Future<Nothing>> acquires(count);
+  vector<std::thread> threads;
+
+  for (size_t i = 0; i < count; i++) {
+    threads.emplace_back([&limiter, &acquires, i]() {
+      acquires[i] = limiter.acquire();
+    });
+  }
+
+  foreach (std::thread& thread, threads) {
+    thread.join();
+  }
+
+  for (size_t permits = 1; permits <= count; permits++) {
+    Clock::settle();
+
+    size_t ready = 0;
+    foreach (const Future<Nothing>& acquire, acquires) {
+      if (acquire.isReady()) {
+        ready++;
+      }
+    }
+
+    EXPECT_EQ(permits, ready);
+
+    Clock::advance(interval);
+  }
+}
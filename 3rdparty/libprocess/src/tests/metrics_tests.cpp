@@ -17,6 +17,7 @@
 
 #include <stout/duration.hpp>
 #include <stout/gtest.hpp>
+#include <stout/strings.hpp>
 
 #include <process/clock.hpp>
 #include <process/future.hpp>
@@ -29,6 +30,7 @@
 #include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
+#include <process/metrics/push_gauge.hpp>
 #include <process/metrics/timer.hpp>
 
 namespace http = process::http;
@@ -40,6 +42,7 @@ using http::Response;
 
 using metrics::Counter;
 using metrics::Gauge;
+using metrics::PushGauge;
 using metrics::Timer;
 
 using process::Clock;
@@ -130,6 +133,35 @@ TEST(MetricsTest, Gauge)
 }
 
 
+TEST(MetricsTest, PushGauge)
+{
+  PushGauge gauge("test/push_gauge");
+
+  AWAIT_READY(metrics::add(gauge));
+
+  AWAIT_EXPECT_EQ(0.0, gauge.value());
+
+  ++gauge;
+  AWAIT_EXPECT_EQ(1.0, gauge.value());
+
+  gauge += 41;
+  AWAIT_EXPECT_EQ(42.0, gauge.value());
+
+  --gauge;
+  AWAIT_EXPECT_EQ(41.0, gauge.value());
+
+  gauge -= 40.5;
+  AWAIT_EXPECT_EQ(0.5, gauge.value());
+
+  gauge = 42;
+  AWAIT_EXPECT_EQ(42.0, gauge.value());
+
+  EXPECT_NONE(gauge.statistics());
+
+  AWAIT_READY(metrics::remove(gauge));
+}
+
+
 TEST(MetricsTest, Statistics)
 {
   Counter counter("test/counter", process::TIME_SERIES_WINDOW);
@@ -404,6 +436,73 @@ TEST(MetricsTest, SnapshotStatistics)
 }
 
 
+TEST(MetricsTest, Prometheus)
+{
+  UPID upid("metrics", process::address());
+
+  Clock::pause();
+
+  Counter counter("test/counter");
+
+  Counter foo("test/principals/foo/messages");
+  foo.label("test/messages", {{"principal", "foo"}});
+
+  Counter bar("test/principals/bar/messages");
+  bar.label("test/messages", {{"principal", "b\"ar"}});
+
+  Counter history("test/history", process::TIME_SERIES_WINDOW);
+
+  AWAIT_READY(metrics::add(counter));
+  AWAIT_READY(metrics::add(foo));
+  AWAIT_READY(metrics::add(bar));
+  AWAIT_READY(metrics::add(history));
+
+  ++foo;
+
+  for (size_t i = 0; i < 10; ++i) {
+    Clock::advance(Seconds(1));
+    ++history;
+  }
+
+  // Advance the clock to avoid rate limit.
+  Clock::advance(Seconds(1));
+
+  Future<Response> response = http::get(upid, "prometheus");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(
+      "text/plain; version=0.0.4",
+      "Content-Type",
+      response);
+
+  const string& body = response.get().body;
+
+  EXPECT_TRUE(strings::contains(body, "# TYPE test_counter untyped\n"));
+  EXPECT_TRUE(strings::contains(body, "\ntest_counter 0.0\n"));
+
+  // The labeled counters are members of one family.
+  EXPECT_TRUE(strings::contains(
+      body,
+      "# TYPE test_messages untyped\n"
+      "test_messages{principal=\"b\\\"ar\"} 0.0\n"
+      "test_messages{principal=\"foo\"} 1.0\n"));
+
+  EXPECT_FALSE(strings::contains(body, "test_principals"));
+
+  EXPECT_TRUE(strings::contains(body, "\ntest_history 10.0\n"));
+  EXPECT_TRUE(strings::contains(body, "# TYPE test_history_window summary\n"));
+  EXPECT_TRUE(strings::contains(
+      body, "\ntest_history_window{quantile=\"0.5\"} 5.0\n"));
+  EXPECT_TRUE(strings::contains(
+      body, "\ntest_history_window{quantile=\"1\"} 10.0\n"));
+  EXPECT_TRUE(strings::contains(body, "\ntest_history_window_count 11\n"));
+
+  AWAIT_READY(metrics::remove(counter));
+  AWAIT_READY(metrics::remove(foo));
+  AWAIT_READY(metrics::remove(bar));
+  AWAIT_READY(metrics::remove(history));
+}
+
+
 TEST(MetricsTest, Timer)
 {
   metrics::Timer<Nanoseconds> timer("test/timer");
@@ -10,6 +10,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License
 
+#include <sched.h>
 #include <time.h>
 
 #include <arpa/inet.h>
@@ -20,13 +21,17 @@
 #include <netinet/tcp.h>
 
 #include <atomic>
+#include <list>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <vector>
 
 #include <process/async.hpp>
 #include <process/clock.hpp>
+#include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/dispatch.hpp>
@@ -36,6 +41,7 @@
 #include <process/gc.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
+#include <process/id.hpp>
 #include <process/network.hpp>
 #include <process/owned.hpp>
 #include <process/process.hpp>
@@ -43,18 +49,24 @@
 #include <process/socket.hpp>
 #include <process/time.hpp>
 
+#include <process/metrics/metrics.hpp>
+
 #include <stout/duration.hpp>
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
+#include <stout/json.hpp>
 #include <stout/lambda.hpp>
 #include <stout/nothing.hpp>
 #include <stout/os.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
+#include <stout/synchronized.hpp>
 #include <stout/try.hpp>
 
 #include "encoder.hpp"
+#include "slab_pool.hpp"
 
 namespace http = process::http;
 namespace inject = process::inject;
@@ -77,8 +89,11 @@ using process::Process;
 using process::ProcessBase;
 using process::Promise;
 using process::run;
+using process::SlabPool;
+using process::SpawnOptions;
 using process::TerminateEvent;
 using process::Time;
+using process::Timer;
 using process::UPID;
 
 using process::firewall::DisabledEndpointsFirewallRule;
@@ -1016,6 +1031,64 @@ TEST(ProcessTest, Delay)
 }
 
 
+// Tests that timers with timeouts spanning many orders of magnitude
+// expire in the order of their timeouts (and creation for equal
+// timeouts), exactly when the clock is advanced past them.
+TEST(ProcessTest, Timers)
+{
+  Clock::pause();
+
+  std::mutex mutex;
+  vector<int> expired;
+
+  auto expire = [&mutex, &expired](int i) {
+    synchronized (mutex) {
+      expired.push_back(i);
+    }
+  };
+
+  Clock::timer(Days(30), lambda::bind(expire, 6));
+  Clock::timer(Seconds(1), lambda::bind(expire, 3));
+  Clock::timer(Nanoseconds(1), lambda::bind(expire, 1));
+  Clock::timer(Seconds(1), lambda::bind(expire, 4));
+  Clock::timer(Minutes(10), lambda::bind(expire, 5));
+  Clock::timer(Microseconds(10), lambda::bind(expire, 2));
+
+  Timer canceled = Clock::timer(Milliseconds(500), lambda::bind(expire, 0));
+  EXPECT_TRUE(Clock::cancel(canceled));
+  EXPECT_FALSE(Clock::cancel(canceled));
+
+  Clock::settle();
+
+  synchronized (mutex) {
+    EXPECT_TRUE(expired.empty());
+  }
+
+  Clock::advance(Seconds(1) - Nanoseconds(1));
+  Clock::settle();
+
+  synchronized (mutex) {
+    EXPECT_EQ(vector<int>({1, 2}), expired);
+  }
+
+  Clock::advance(Nanoseconds(1));
+  Clock::settle();
+
+  synchronized (mutex) {
+    EXPECT_EQ(vector<int>({1, 2, 3, 4}), expired);
+  }
+
+  Clock::advance(Days(30));
+  Clock::settle();
+
+  synchronized (mutex) {
+    EXPECT_EQ(vector<int>({1, 2, 3, 4, 5, 6}), expired);
+  }
+
+  Clock::resume();
+}
+
+
 class OrderProcess : public Process<OrderProcess>
 {
 public:
@@ -1096,6 +1169,73 @@ TEST(ProcessTest, Donate)
 }
 
 
+class ProducersProcess : public Process<ProducersProcess>
+{
+public:
+  explicit ProducersProcess(size_t producers)
+    : sequences(producers, 0), ordered(true) {}
+
+  void produce(size_t producer, size_t sequence)
+  {
+    // Events from each producer must be served in the order
+    // they were enqueued.
+    if (sequences[producer] != sequence) {
+      ordered = false;
+    }
+    sequences[producer] = sequence + 1;
+  }
+
+  vector<size_t> get() { return sequences; }
+
+  bool isOrdered() { return ordered; }
+
+private:
+  vector<size_t> sequences;
+  bool ordered;
+};
+
+
+// Enqueues events on a single process from many threads at once
+// to exercise the (lock-free) event queue.
+TEST(ProcessTest, ConcurrentProducers)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  const size_t producers = 8;
+  const size_t events = 10000;
+
+  ProducersProcess process(producers);
+  spawn(process);
+
+  vector<std::thread*> threads;
+  for (size_t producer = 0; producer < producers; producer++) {
+    threads.push_back(new std::thread([&process, producer, events]() {
+      for (size_t sequence = 0; sequence < events; sequence++) {
+        dispatch(process, &ProducersProcess::produce, producer, sequence);
+      }
+    }));
+  }
+
+  foreach (std::thread* thread, threads) {
+    thread->join();
+    delete thread;
+  }
+
+  Future<vector<size_t>> sequences =
+    dispatch(process, &ProducersProcess::get);
+
+  AWAIT_READY(sequences);
+  EXPECT_EQ(vector<size_t>(producers, events), sequences.get());
+
+  Future<bool> ordered = dispatch(process, &ProducersProcess::isOrdered);
+
+  AWAIT_EXPECT_TRUE(ordered);
+
+  terminate(process);
+  wait(process);
+}
+
+
 class ExitedProcess : public Process<ExitedProcess>
 {
 public:
@@ -1232,6 +1372,315 @@ TEST(ProcessTest, Settle)
 }
 
 
+class ThreadProcess : public Process<ThreadProcess>
+{
+public:
+  explicit ThreadProcess(const string& id = process::ID::generate("thread"))
+    : ProcessBase(id) {}
+
+  std::thread::id thread() { return std::this_thread::get_id(); }
+};
+
+
+// Tests that a dedicated process always runs on its own thread and
+// shows up as dedicated in '/__processes__' and in the metrics.
+TEST(ProcessTest, Dedicated)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  ThreadProcess shared;
+  spawn(shared);
+
+  ThreadProcess dedicated;
+
+  SpawnOptions options;
+  options.dedicated = true;
+
+#ifdef __linux__
+  // Pin to a CPU which this thread is allowed to run on.
+  const int cpu = sched_getcpu();
+  ASSERT_LE(0, cpu);
+  options.cpu = cpu;
+#endif // __linux__
+
+  PID<ThreadProcess> pid = spawn(dedicated, options);
+  ASSERT_EQ(dedicated.self(), pid);
+
+  Future<std::thread::id> thread = dispatch(pid, &ThreadProcess::thread);
+  AWAIT_READY(thread);
+
+  for (int i = 0; i < 10; i++) {
+    Future<std::thread::id> thread_ = dispatch(pid, &ThreadProcess::thread);
+    AWAIT_READY(thread_);
+    EXPECT_EQ(thread.get(), thread_.get());
+
+    thread_ = dispatch(shared, &ThreadProcess::thread);
+    AWAIT_READY(thread_);
+    EXPECT_NE(thread.get(), thread_.get());
+  }
+
+  // Spawning a process with the same id fails.
+  ThreadProcess duplicate(pid.id);
+  EXPECT_FALSE(spawn(duplicate, options));
+
+  Future<http::Response> response =
+    http::get(UPID("__processes__", process::address()));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  Try<JSON::Array> processes = JSON::parse<JSON::Array>(response->body);
+  ASSERT_SOME(processes);
+
+  Option<JSON::Object> object;
+  foreach (const JSON::Value& value, processes->values) {
+    ASSERT_TRUE(value.is<JSON::Object>());
+    const JSON::Object& process = value.as<JSON::Object>();
+
+    Result<JSON::String> id = process.find<JSON::String>("id");
+    ASSERT_SOME(id);
+
+    if (id->value == shared.self().id) {
+      EXPECT_EQ(0u, process.values.count("dedicated"));
+    } else if (id->value == pid.id) {
+      object = process;
+    }
+  }
+
+  ASSERT_SOME(object);
+
+  Result<JSON::Boolean> dedicated_ = object->find<JSON::Boolean>("dedicated");
+  ASSERT_SOME(dedicated_);
+  EXPECT_TRUE(dedicated_->value);
+
+#ifdef __linux__
+  Result<JSON::Number> cpu_ = object->find<JSON::Number>("cpu");
+  ASSERT_SOME(cpu_);
+  EXPECT_EQ(cpu, cpu_->as<int>());
+#endif // __linux__
+
+  response = http::get(
+      process::metrics::internal::MetricsProcess::instance()->self(),
+      "snapshot");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  Try<JSON::Object> snapshot = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(snapshot);
+
+  EXPECT_EQ(1u, snapshot->values.count(
+      "libprocess/dedicated_processes/" + pid.id + "/cpu"));
+
+  terminate(dedicated);
+  wait(dedicated);
+
+  terminate(shared);
+  wait(shared);
+}
+
+
+class MailboxProcess : public Process<MailboxProcess>
+{
+public:
+  Nothing serve(const Duration& duration)
+  {
+    os::sleep(duration);
+    return Nothing();
+  }
+};
+
+
+// Tests that the mailbox metrics of a process get exported by the
+// metrics and by '/__processes__'.
+TEST(ProcessTest, MailboxMetrics)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  MailboxProcess process;
+
+  SpawnOptions options;
+  options.mailboxMetrics = true;
+
+  PID<MailboxProcess> pid = spawn(process, options);
+
+  // The first dispatch blocks the process so that the others queue
+  // up behind it.
+  std::list<Future<Nothing>> futures;
+  futures.push_back(
+      dispatch(pid, &MailboxProcess::serve, Milliseconds(50)));
+
+  for (int i = 0; i < 9; i++) {
+    futures.push_back(dispatch(pid, &MailboxProcess::serve, Duration::zero()));
+  }
+
+  AWAIT_READY(process::collect(futures));
+
+  Future<http::Response> response =
+    http::get(UPID("__processes__", process::address()));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  Try<JSON::Array> processes = JSON::parse<JSON::Array>(response->body);
+  ASSERT_SOME(processes);
+
+  Option<JSON::Object> mailbox;
+  foreach (const JSON::Value& value, processes->values) {
+    const JSON::Object& object = value.as<JSON::Object>();
+    Result<JSON::String> id = object.find<JSON::String>("id");
+    ASSERT_SOME(id);
+
+    if (id->value == pid.id) {
+      Result<JSON::Object> mailbox_ = object.find<JSON::Object>("mailbox");
+      ASSERT_SOME(mailbox_);
+      mailbox = mailbox_.get();
+    }
+  }
+
+  ASSERT_SOME(mailbox);
+
+  EXPECT_SOME_EQ(
+      JSON::Number(0),
+      mailbox->find<JSON::Number>("depth"));
+
+  EXPECT_SOME_EQ(
+      JSON::Number(10),
+      mailbox->find<JSON::Number>("service_time_ms.dispatch.count"));
+
+  EXPECT_SOME_EQ(
+      JSON::Number(0),
+      mailbox->find<JSON::Number>("service_time_ms.message.count"));
+
+  // All but the first event waited for (most of) the time it took to
+  // serve the first one.
+  Result<JSON::Number> latency =
+    mailbox->find<JSON::Number>("latency_ms.p90");
+  ASSERT_SOME(latency);
+  EXPECT_LE(25, latency->as<double>());
+
+  Result<JSON::Number> service =
+    mailbox->find<JSON::Number>("service_time_ms.dispatch.max");
+  ASSERT_SOME(service);
+  EXPECT_LE(50, service->as<double>());
+
+  response = http::get(
+      process::metrics::internal::MetricsProcess::instance()->self(),
+      "snapshot");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  Try<JSON::Object> snapshot = JSON::parse<JSON::Object>(response->body);
+  ASSERT_SOME(snapshot);
+
+  const string prefix = "libprocess/processes/" + pid.id + "/mailbox/";
+
+  EXPECT_EQ(1u, snapshot->values.count(prefix + "depth"));
+  EXPECT_EQ(1u, snapshot->values.count(prefix + "latency_ms/p99"));
+
+  EXPECT_EQ(
+      JSON::Value(JSON::Number(10)),
+      snapshot->values[prefix + "service_time_ms/dispatch/count"]);
+
+  // There were no HTTP events, so there are no percentiles.
+  EXPECT_EQ(0u, snapshot->values.count(prefix + "service_time_ms/http/p50"));
+
+  terminate(process);
+  wait(process);
+}
+
+
+class PrioritizedProcess : public Process<PrioritizedProcess>
+{
+public:
+  PrioritizedProcess() : blocked(false), released(false)
+  {
+    install("control", &PrioritizedProcess::control);
+    install("bulk", &PrioritizedProcess::bulk);
+
+    prioritize("control");
+  }
+
+  Nothing block()
+  {
+    blocked.store(true);
+    while (!released.load()) {
+      os::sleep(Milliseconds(1));
+    }
+    return Nothing();
+  }
+
+  vector<string> served()
+  {
+    return messages;
+  }
+
+  std::atomic_bool blocked;
+  std::atomic_bool released;
+
+private:
+  void control(const UPID& from, const string& body)
+  {
+    messages.push_back("control");
+  }
+
+  void bulk(const UPID& from, const string& body)
+  {
+    messages.push_back("bulk");
+  }
+
+  vector<string> messages;
+};
+
+
+// Tests that prioritized messages get served before bulk events, but
+// that bulk events still get served after a burst of prioritized
+// messages.
+TEST(ProcessTest, Prioritize)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  PrioritizedProcess process;
+  PID<PrioritizedProcess> pid = spawn(process);
+
+  // Block the process so that the messages queue up.
+  Future<Nothing> block = dispatch(pid, &PrioritizedProcess::block);
+
+  while (!process.blocked.load()) {
+    os::sleep(Milliseconds(1));
+  }
+
+  for (int i = 0; i < 20; i++) {
+    post(pid, "bulk");
+  }
+
+  for (int i = 0; i < 20; i++) {
+    post(pid, "control");
+  }
+
+  process.released.store(true);
+
+  AWAIT_READY(block);
+
+  // This dispatch is a bulk event, so it only gets served once all
+  // the messages have been served.
+  Future<vector<string>> served =
+    dispatch(pid, &PrioritizedProcess::served);
+
+  AWAIT_READY(served);
+
+  vector<string> expected;
+  expected.insert(expected.end(), 8, "control");
+  expected.push_back("bulk");
+  expected.insert(expected.end(), 8, "control");
+  expected.push_back("bulk");
+  expected.insert(expected.end(), 4, "control");
+  expected.insert(expected.end(), 18, "bulk");
+
+  EXPECT_EQ(expected, served.get());
+
+  terminate(process);
+  wait(process);
+}
+
+
 TEST(ProcessTest, Pid)
 {
   ASSERT_TRUE(GTEST_IS_THREADSAFE);
@@ -1792,6 +2241,57 @@ TEST(ProcessTest, PercentEncodedURLs)
 }
 
 
+class NestedRoutesProcess : public Process<NestedRoutesProcess>
+{
+public:
+  NestedRoutesProcess()
+    : ProcessBase("nested") {}
+
+  virtual void initialize()
+  {
+    route("/", None(), &Self::root);
+    route("/a", None(), &Self::a);
+    route("/a/b/c", None(), &Self::c);
+  }
+
+  MOCK_METHOD1(root, Future<http::Response>(const http::Request&));
+  MOCK_METHOD1(a, Future<http::Response>(const http::Request&));
+  MOCK_METHOD1(c, Future<http::Response>(const http::Request&));
+};
+
+
+// Tests that a request is handled by the route with the longest
+// matching prefix of its path.
+TEST(ProcessTest, NestedRoutes)
+{
+  NestedRoutesProcess process;
+  spawn(process);
+
+  EXPECT_CALL(process, root(_))
+    .WillRepeatedly(Return(http::OK("root")));
+
+  EXPECT_CALL(process, a(_))
+    .WillRepeatedly(Return(http::OK("a")));
+
+  EXPECT_CALL(process, c(_))
+    .WillRepeatedly(Return(http::OK("c")));
+
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("root", http::get(process.self()));
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("a", http::get(process.self(), "a"));
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("a", http::get(process.self(), "a/b"));
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("c", http::get(process.self(), "a/b/c"));
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("c", http::get(process.self(), "a/b/c/d"));
+
+  // The route of the process itself only handles its own path.
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      http::NotFound().status,
+      http::get(process.self(), "b"));
+
+  terminate(process);
+  wait(process);
+}
+
+
 class HTTPEndpointProcess : public Process<HTTPEndpointProcess>
 {
 public:
@@ -1962,3 +2462,67 @@ TEST(ProcessTest, FirewallUninstall)
   terminate(process);
   wait(process);
 }
+
+
+struct Pooled
+{
+  char data[48];
+};
+
+
+TEST(ProcessTest, SlabPool)
+{
+  typedef SlabPool<Pooled> Pool;
+
+  const size_t BATCH = Pool::BATCH;
+
+  // NOTE: The pool might be in use already if the tests are repeated.
+  auto used = []() {
+    const Pool::Statistics statistics = Pool::statistics();
+    return statistics.capacity - statistics.free;
+  };
+
+  const size_t initial = used();
+
+  vector<void*> blocks;
+  for (size_t i = 0; i < 3 * BATCH; i++) {
+    blocks.push_back(Pool::allocate(sizeof(Pooled)));
+  }
+
+  EXPECT_EQ(initial + 3 * BATCH, used());
+
+  // Blocks of other sizes (e.g., of subclasses) are not pooled.
+  void* block = Pool::allocate(2 * sizeof(Pooled));
+  EXPECT_EQ(initial + 3 * BATCH, used());
+  Pool::deallocate(block, 2 * sizeof(Pooled));
+
+  // Deallocating the blocks on another thread caches up to 2 * BATCH
+  // of them on that thread and returns the rest to the depot.
+  std::thread thread([&blocks]() {
+    foreach (void* block, blocks) {
+      Pool::deallocate(block, sizeof(Pooled));
+    }
+  });
+
+  thread.join();
+
+  EXPECT_EQ(initial, used());
+
+  // This thread reuses the blocks from the depot rather than
+  // allocating new slabs.
+  const size_t capacity = Pool::statistics().capacity;
+
+  blocks.clear();
+  for (size_t i = 0; i < 2 * BATCH; i++) {
+    blocks.push_back(Pool::allocate(sizeof(Pooled)));
+  }
+
+  EXPECT_EQ(capacity, Pool::statistics().capacity);
+  EXPECT_EQ(initial + 2 * BATCH, used());
+
+  foreach (void* block, blocks) {
+    Pool::deallocate(block, sizeof(Pooled));
+  }
+
+  EXPECT_EQ(initial, used());
+}
@@ -0,0 +1,146 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <gmock/gmock.h>
+
+#include <string>
+#include <vector>
+
+#include <process/clock.hpp>
+#include <process/dispatch.hpp>
+#include <process/future.hpp>
+#include <process/gtest.hpp>
+#include <process/http.hpp>
+#include <process/id.hpp>
+#include <process/process.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/gtest.hpp>
+#include <stout/nothing.hpp>
+#include <stout/numify.hpp>
+#include <stout/os.hpp>
+#include <stout/strings.hpp>
+
+#include "actor_profiler.hpp"
+
+namespace http = process::http;
+
+using process::ActorProfiler;
+using process::Clock;
+using process::Future;
+using process::PID;
+using process::Process;
+using process::UPID;
+
+using std::string;
+using std::vector;
+
+
+class ProfiledProcess : public Process<ProfiledProcess>
+{
+public:
+  ProfiledProcess() : ProcessBase(process::ID::generate("profiled")) {}
+
+  Nothing spin()
+  {
+    // Burn some CPU so that there is something to attribute.
+    volatile uint64_t sum = 0;
+    for (int i = 0; i < 1000000; i++) {
+      sum += i;
+    }
+    return Nothing();
+  }
+
+protected:
+  virtual void initialize()
+  {
+    install("ping", &ProfiledProcess::ping);
+  }
+
+private:
+  void ping(const UPID& from, const string& body) {}
+};
+
+
+TEST(ProfilerTest, Actors)
+{
+  ProfiledProcess process;
+  PID<ProfiledProcess> pid = spawn(process);
+
+  const UPID profiler("profiler", process::address());
+
+  // Invalid durations are rejected.
+  Future<http::Response> response =
+    http::get(profiler, "actors", "duration=bogus");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::BadRequest().status, response);
+
+  response = http::get(profiler, "actors", "duration=1hrs");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::BadRequest().status, response);
+
+  // Pause the clock so that the profile only gets returned once we
+  // advance the clock.
+  Clock::pause();
+
+  response = http::get(profiler, "actors", "duration=1secs");
+
+  // Wait for the profiler to start.
+  while (!ActorProfiler::running() && response.isPending()) {
+    os::sleep(Milliseconds(1));
+  }
+
+  ASSERT_TRUE(ActorProfiler::running());
+
+  // Only one profile can be taken at a time.
+  Future<http::Response> concurrent =
+    http::get(profiler, "actors", "duration=1secs");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::BadRequest().status, concurrent);
+
+  post(pid, "ping");
+
+  AWAIT_READY(dispatch(pid, &ProfiledProcess::spin));
+
+  Clock::advance(Seconds(1));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  Clock::resume();
+
+  EXPECT_FALSE(ActorProfiler::running());
+
+  // Every line is a stack followed by the CPU time, with the
+  // generated id of the process grouped as 'profiled'.
+  bool message = false;
+  bool dispatch = false;
+
+  foreach (const string& line, strings::tokenize(response->body, "\n")) {
+    size_t index = line.rfind(' ');
+    ASSERT_NE(string::npos, index) << line;
+
+    const string stack = line.substr(0, index);
+    EXPECT_SOME(numify<uint64_t>(line.substr(index + 1))) << line;
+
+    if (stack == "profiled;message;ping") {
+      message = true;
+    } else if (strings::startsWith(stack, "profiled;dispatch;")) {
+      dispatch = true;
+    }
+  }
+
+  EXPECT_TRUE(message) << response->body;
+  EXPECT_TRUE(dispatch) << response->body;
+
+  terminate(process);
+  wait(process);
+}
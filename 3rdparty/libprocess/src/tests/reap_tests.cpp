@@ -15,6 +15,10 @@
 
 #include <sys/wait.h>
 
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif // __linux__
+
 #include <gtest/gtest.h>
 
 #include <process/clock.hpp>
@@ -25,10 +29,15 @@
 
 #include <stout/exit.hpp>
 #include <stout/gtest.hpp>
+#include <stout/os.hpp>
 #include <stout/os/fork.hpp>
 #include <stout/os/pstree.hpp>
 #include <stout/try.hpp>
 
+#if defined(__linux__) && !defined(SYS_pidfd_open)
+#define SYS_pidfd_open 434 // See reap.cpp.
+#endif
+
 using process::Clock;
 using process::Future;
 using process::MAX_REAP_INTERVAL;
@@ -191,3 +200,44 @@ TEST(ReapTest, TerminatedChildProcess)
 
   Clock::resume();
 }
+
+
+#ifdef __linux__
+// Checks that, where pidfds are supported, the termination of a
+// child process is noticed without waiting for the poll interval.
+TEST(ReapTest, ChildProcessWithoutPolling)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  // Skip the test if the kernel does not support pidfds.
+  int pidfd = ::syscall(SYS_pidfd_open, ::getpid(), 0);
+  if (pidfd < 0) {
+    LOG(WARNING) << "Skipping test since pidfds are not supported: "
+                 << os::strerror(errno);
+    return;
+  }
+  os::close(pidfd);
+
+  Try<ProcessTree> tree = Fork(None(),
+                               Exec("sleep 10"))();
+
+  ASSERT_SOME(tree);
+  pid_t child = tree.get();
+
+  // Pause the clock so that the reaper never polls.
+  Clock::pause();
+
+  Future<Option<int> > status = process::reap(child);
+
+  EXPECT_EQ(0, kill(child, SIGKILL));
+
+  AWAIT_READY(status);
+
+  ASSERT_SOME(status.get());
+  int status_ = status.get().get();
+  ASSERT_TRUE(WIFSIGNALED(status_));
+  ASSERT_EQ(SIGKILL, WTERMSIG(status_));
+
+  Clock::resume();
+}
+#endif // __linux__
@@ -69,3 +69,40 @@ TEST(StatisticsTest, Statistics)
   EXPECT_FLOAT_EQ(4.99, statistics.get().p999);
   EXPECT_FLOAT_EQ(4.999, statistics.get().p9999);
 }
+
+
+// Ensures that the percentiles do not depend on the order in which
+// the values were set.
+TEST(StatisticsTest, Unordered)
+{
+  TimeSeries<double> timeseries;
+
+  Time now = Clock::now();
+
+  // Set the values from -5 to 5 in the order 5, -5, 4, -4, ..., 0.
+  for (int i = 5; i >= 0; --i) {
+    now += Seconds(1);
+    timeseries.set(i, now);
+
+    if (i != 0) {
+      now += Seconds(1);
+      timeseries.set(-i, now);
+    }
+  }
+
+  Option<Statistics<double> > statistics = Statistics<double>::from(timeseries);
+
+  EXPECT_SOME(statistics);
+
+  EXPECT_EQ(11u, statistics.get().count);
+
+  EXPECT_FLOAT_EQ(-5.0, statistics.get().min);
+  EXPECT_FLOAT_EQ(5.0, statistics.get().max);
+
+  EXPECT_FLOAT_EQ(0.0, statistics.get().p50);
+  EXPECT_FLOAT_EQ(4.0, statistics.get().p90);
+  EXPECT_FLOAT_EQ(4.5, statistics.get().p95);
+  EXPECT_FLOAT_EQ(4.9, statistics.get().p99);
+  EXPECT_FLOAT_EQ(4.99, statistics.get().p999);
+  EXPECT_FLOAT_EQ(4.999, statistics.get().p9999);
+}
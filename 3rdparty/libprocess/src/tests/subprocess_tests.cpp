@@ -138,6 +138,38 @@ TEST_F(SubprocessTest, Status)
 }
 
 
+// This test verifies that a subprocess which cannot be executed (which
+// 'subprocess' spawns, as there is no setup function) still reports
+// the failure through its exit status.
+TEST_F(SubprocessTest, MissingExecutable)
+{
+  const string path = path::join(sandbox.get(), "missing");
+
+  Try<Subprocess> s = subprocess(
+      path,
+      {"missing"},
+      Subprocess::FD(STDIN_FILENO),
+      Subprocess::PATH("/dev/null"),
+      Subprocess::PATH("/dev/null"));
+
+  ASSERT_SOME(s);
+
+  // Advance time until the internal reaper reaps the subprocess.
+  Clock::pause();
+  while (s.get().status().isPending()) {
+    Clock::advance(MAX_REAP_INTERVAL());
+    Clock::settle();
+  }
+  Clock::resume();
+
+  AWAIT_ASSERT_READY(s.get().status());
+  ASSERT_SOME(s.get().status().get());
+
+  int status = s.get().status().get().get();
+  EXPECT_FALSE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+
 TEST_F(SubprocessTest, PipeOutput)
 {
   // Standard out.
@@ -0,0 +1,371 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESS_TIMER_WHEEL_HPP__
+#define __PROCESS_TIMER_WHEEL_HPP__
+
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+#include <process/time.hpp>
+#include <process/timer.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/option.hpp>
+
+namespace process {
+
+// A hierarchical timing wheel (see Varghese and Lauck's "Hashed and
+// Hierarchical Timing Wheels") used by the Clock to store timers.
+// Adding and canceling a timer is O(1), while expiring timers costs
+// O(1) amortized per timer since a timer moves down through at most
+// 'LEVELS' levels before it expires.
+//
+// Time is divided into units of 2^UNIT_BITS nanoseconds (about a
+// millisecond). Level 0 has a slot per unit, and each slot of level
+// 'k' covers 64^k units. A timer is kept at the lowest level whose
+// slot does not also cover 'cursor' (i.e., the level of the most
+// significant base 64 digit in which the timer's unit differs from
+// the cursor) so that every timer at level 'k' expires after every
+// timer at the levels below 'k'. Timers whose unit is before the
+// cursor (e.g., timers created with a negative duration) are kept
+// in a separate 'overdue' slot.
+//
+// NOTE: Units only determine where a timer is stored, the exact time
+// of a timer is what determines whether or not it has expired, so a
+// timer never expires early (or late) because of the unit size.
+//
+// NOTE: This class is not thread safe, see clock.cpp for how it is
+// synchronized.
+class TimerWheel
+{
+public:
+  TimerWheel() : cursor(0)
+  {
+    for (int level = 0; level < LEVELS; level++) {
+      occupied[level] = 0;
+      for (int digit = 0; digit < SLOTS; digit++) {
+        slots[level][digit].level = level;
+        slots[level][digit].digit = digit;
+      }
+    }
+
+    overdue.level = -1;
+    overdue.digit = -1;
+  }
+
+  ~TimerWheel()
+  {
+    clear();
+  }
+
+  // Adds a timer, the 'id' must uniquely identify the timer.
+  void add(uint64_t id, const Timer& timer)
+  {
+    Node* node = new Node(id, timer);
+    nodes[id] = node;
+    place(node);
+  }
+
+  // Returns true if the timer was pending and has been removed.
+  bool cancel(uint64_t id)
+  {
+    Option<Node*> node = nodes.get(id);
+    if (node.isNone()) {
+      return false;
+    }
+
+    nodes.erase(id);
+    unlink(node.get());
+    delete node.get();
+    return true;
+  }
+
+  // Removes every timer whose time is at or before 'now' and appends
+  // them (and their ids) to 'expired' in no particular order.
+  void expire(
+      const Time& now,
+      std::vector<std::pair<uint64_t, Timer>>* expired)
+  {
+    const uint64_t unit = units(now);
+
+    for (Node* node = overdue.head; node != NULL;) {
+      Node* next = node->next;
+      if (node->time <= now) {
+        remove(node, expired);
+      }
+      node = next;
+    }
+
+    while (true) {
+      Option<Slot*> slot = first();
+      if (slot.isNone()) {
+        break;
+      }
+
+      const uint64_t start = this->start(*slot.get());
+      if (start > unit) {
+        break;
+      }
+
+      // Move the cursor to the start of the slot, which is before
+      // (or at) the unit of every remaining timer.
+      cursor = start;
+
+      if (slot.get()->level == 0) {
+        for (Node* node = slot.get()->head; node != NULL;) {
+          Node* next = node->next;
+          if (node->time <= now) {
+            remove(node, expired);
+          }
+          node = next;
+        }
+
+        // Any remaining timers are in the same unit as 'now' but
+        // expire after it.
+        if (slot.get()->head != NULL) {
+          break;
+        }
+      } else {
+        // "Cascade" the timers of this slot to the lower levels.
+        Node* node = slot.get()->head;
+        slot.get()->head = slot.get()->tail = NULL;
+        occupied[slot.get()->level] &= ~(UINT64_C(1) << slot.get()->digit);
+
+        while (node != NULL) {
+          Node* next = node->next;
+          place(node);
+          node = next;
+        }
+      }
+    }
+
+    // NOTE: Every remaining timer is after 'unit' (or in it), so
+    // advancing the cursor keeps each timer at a valid level.
+    if (cursor < unit) {
+      cursor = unit;
+    }
+  }
+
+  // Returns the time of the earliest timer, if any.
+  Option<Time> next()
+  {
+    Option<Time> earliest = None();
+
+    for (const Node* node = overdue.head; node != NULL; node = node->next) {
+      if (earliest.isNone() || node->time < earliest.get()) {
+        earliest = node->time;
+      }
+    }
+
+    Option<Slot*> slot = first();
+    if (slot.isSome()) {
+      for (const Node* node = slot.get()->head;
+           node != NULL;
+           node = node->next) {
+        if (earliest.isNone() || node->time < earliest.get()) {
+          earliest = node->time;
+        }
+      }
+    }
+
+    return earliest;
+  }
+
+  bool empty() const
+  {
+    return nodes.empty();
+  }
+
+  size_t size() const
+  {
+    return nodes.size();
+  }
+
+  void clear()
+  {
+    foreachvalue (Node* node, nodes) {
+      delete node;
+    }
+
+    nodes.clear();
+
+    for (int level = 0; level < LEVELS; level++) {
+      occupied[level] = 0;
+      for (int digit = 0; digit < SLOTS; digit++) {
+        slots[level][digit].head = slots[level][digit].tail = NULL;
+      }
+    }
+
+    overdue.head = overdue.tail = NULL;
+  }
+
+private:
+  static const int UNIT_BITS = 20;
+  static const int SLOT_BITS = 6;
+  static const int SLOTS = 1 << SLOT_BITS;
+  static const int LEVELS = (64 + SLOT_BITS - 1) / SLOT_BITS;
+
+  struct Slot;
+
+  struct Node
+  {
+    Node(uint64_t _id, const Timer& _timer)
+      : id(_id),
+        timer(_timer),
+        time(_timer.timeout().time()),
+        unit(units(time)),
+        slot(NULL),
+        previous(NULL),
+        next(NULL) {}
+
+    const uint64_t id;
+    const Timer timer;
+    const Time time;
+    const uint64_t unit;
+
+    Slot* slot;
+    Node* previous;
+    Node* next;
+  };
+
+  // A doubly linked list of timers.
+  struct Slot
+  {
+    Slot() : head(NULL), tail(NULL), level(0), digit(0) {}
+
+    Node* head;
+    Node* tail;
+
+    int level;
+    int digit;
+  };
+
+  static uint64_t units(const Time& time)
+  {
+    const int64_t nanoseconds = time.duration().ns();
+    if (nanoseconds <= 0) {
+      return 0;
+    }
+
+    return static_cast<uint64_t>(nanoseconds) >> UNIT_BITS;
+  }
+
+  // Returns the first unit covered by the slot, given the cursor.
+  uint64_t start(const Slot& slot) const
+  {
+    const int shift = slot.level * SLOT_BITS;
+    const int above = shift + SLOT_BITS;
+
+    const uint64_t high = above < 64 ? (cursor >> above) << above : 0;
+
+    return high | (static_cast<uint64_t>(slot.digit) << shift);
+  }
+
+  // Returns the slot containing the earliest timers of the wheel
+  // (excluding overdue timers), if any.
+  Option<Slot*> first()
+  {
+    for (int level = 0; level < LEVELS; level++) {
+      if (occupied[level] != 0) {
+        return &slots[level][__builtin_ctzll(occupied[level])];
+      }
+    }
+
+    return None();
+  }
+
+  void place(Node* node)
+  {
+    Slot* slot = &overdue;
+
+    if (node->unit >= cursor) {
+      const uint64_t difference = node->unit ^ cursor;
+
+      const int level = difference == 0
+        ? 0
+        : (63 - __builtin_clzll(difference)) / SLOT_BITS;
+
+      const int digit = (node->unit >> (level * SLOT_BITS)) & (SLOTS - 1);
+
+      slot = &slots[level][digit];
+      occupied[level] |= UINT64_C(1) << digit;
+    }
+
+    // Append so that timers keep their relative order.
+    node->slot = slot;
+    node->previous = slot->tail;
+    node->next = NULL;
+
+    if (slot->tail != NULL) {
+      slot->tail->next = node;
+    } else {
+      slot->head = node;
+    }
+
+    slot->tail = node;
+  }
+
+  void unlink(Node* node)
+  {
+    Slot* slot = node->slot;
+
+    if (node->previous != NULL) {
+      node->previous->next = node->next;
+    } else {
+      slot->head = node->next;
+    }
+
+    if (node->next != NULL) {
+      node->next->previous = node->previous;
+    } else {
+      slot->tail = node->previous;
+    }
+
+    if (slot->head == NULL && slot->level >= 0) {
+      occupied[slot->level] &= ~(UINT64_C(1) << slot->digit);
+    }
+
+    node->slot = NULL;
+    node->previous = node->next = NULL;
+  }
+
+  void remove(Node* node, std::vector<std::pair<uint64_t, Timer>>* expired)
+  {
+    unlink(node);
+    nodes.erase(node->id);
+    expired->push_back(std::make_pair(node->id, node->timer));
+    delete node;
+  }
+
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  // Every timer is at or after the cursor, except for overdue timers.
+  uint64_t cursor;
+
+  Slot slots[LEVELS][SLOTS];
+
+  // Bitmap of the non-empty slots of each level.
+  uint64_t occupied[LEVELS];
+
+  Slot overdue;
+
+  hashmap<uint64_t, Node*> nodes;
+};
+
+} // namespace process {
+
+#endif // __PROCESS_TIMER_WHEEL_HPP__
@@ -17,14 +17,17 @@
 #ifndef __MESOS_AUTHORIZER_AUTHORIZER_HPP__
 #define __MESOS_AUTHORIZER_AUTHORIZER_HPP__
 
+#include <list>
 #include <ostream>
 #include <string>
 
 // ONLY USEFUL AFTER RUNNING PROTOC.
 #include <mesos/authorizer/authorizer.pb.h>
 
+#include <process/collect.hpp>
 #include <process/future.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/nothing.hpp>
 #include <stout/option.hpp>
 #include <stout/try.hpp>
@@ -108,6 +111,31 @@ public:
   virtual process::Future<bool> authorize(
       const ACL::RunTask& request) = 0;
 
+  /**
+   * Used to verify a batch of ACL::RunTask requests at once, e.g., all
+   * of the tasks launched by an accept call, so that an authorizer
+   * which needs a round trip to some external service for each call
+   * can make a single one for all of them. The default implementation
+   * authorizes each of the requests on its own.
+   *
+   * @param requests The ACL::RunTask requests to verify.
+   *
+   * @return the decisions for the requests, in the same order, see the
+   *     single request version above. A failed future indicates a
+   *     problem processing some of the requests, in which case they
+   *     can all be retried.
+   */
+  virtual process::Future<std::list<bool>> authorize(
+      const std::list<ACL::RunTask>& requests)
+  {
+    std::list<process::Future<bool>> futures;
+    foreach (const ACL::RunTask& request, requests) {
+      futures.push_back(authorize(request));
+    }
+
+    return process::collect(futures);
+  }
+
   /**
    * Used to verify if a principal is allowed to shut down a framework launched
    * by the given framework_principal. The principal and framework_principal
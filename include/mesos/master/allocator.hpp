@@ -42,6 +42,19 @@ namespace mesos {
 namespace master {
 namespace allocator {
 
+/**
+ * Resources of a framework on an agent that the allocator recovers,
+ * see `Allocator::recoverResources`.
+ */
+struct Recovery
+{
+  FrameworkID frameworkId;
+  SlaveID slaveId;
+  Resources resources;
+  Option<Filters> filters;
+};
+
+
 /**
  * Basic model of an allocator: resources are allocated to a framework
  * in the form of offers. A framework can refuse some resources in
@@ -207,6 +220,23 @@ public:
   virtual void removeSlave(
       const SlaveID& slaveId) = 0;
 
+  /**
+   * Removes several agents at once.
+   *
+   * This is equivalent to calling `removeSlave` for each of the agents
+   * in order, which is what the default implementation does. The
+   * master uses this when it removes many agents at once, e.g., when
+   * they fail their health checks during a network partition, so
+   * allocators can override it to process the removals as a single
+   * event.
+   */
+  virtual void bulkRemoveSlaves(const std::vector<SlaveID>& slaveIds)
+  {
+    for (const SlaveID& slaveId : slaveIds) {
+      removeSlave(slaveId);
+    }
+  }
+
   /**
    * Updates an agent.
    *
@@ -345,6 +375,40 @@ public:
       const Resources& resources,
       const Option<Filters>& filters) = 0;
 
+  /**
+   * Recovers resources of several frameworks and agents at once.
+   *
+   * This is equivalent to calling `recoverResources` for each of the
+   * recoveries in order, which is what the default implementation
+   * does. The master uses this when it recovers the resources of many
+   * offers at once, e.g., when a framework fails over, so allocators
+   * can override it to process the recoveries as a single event.
+   */
+  virtual void bulkRecoverResources(const std::vector<Recovery>& recoveries)
+  {
+    for (const Recovery& recovery : recoveries) {
+      recoverResources(
+          recovery.frameworkId,
+          recovery.slaveId,
+          recovery.resources,
+          recovery.filters);
+    }
+  }
+
+  /**
+   * Informs the allocator that a framework accepted offered resources.
+   *
+   * Allocators that offer the same resources to several frameworks at
+   * once use this to account the resources to the framework that
+   * accepted them. The master invokes this before it recovers the
+   * resources of the other offers that it rescinds for overlapping
+   * with the accepted ones. The default implementation does nothing.
+   */
+  virtual void acceptResources(
+      const FrameworkID& frameworkId,
+      const SlaveID& slaveId,
+      const Resources& resources) {}
+
   /**
    * Suppresses offers.
    *
@@ -359,6 +359,14 @@ private:
   // ensure this is warranted.
   bool _contains(const Resource& that) const;
 
+  // Similar to 'operator+=(const Resource&)' and
+  // 'operator-=(const Resource&)' but skip the validity (and
+  // emptiness) check of 'that', which holds for the Resource objects
+  // of a Resources. Used for the arithmetic between Resources, which
+  // is the bulk of the arithmetic done by the allocator.
+  void add(const Resource& that);
+  void subtract(const Resource& that);
+
   // Similar to the public 'find', but only for a single Resource
   // object. The target resource may span multiple roles, so this
   // returns Resources.
@@ -130,6 +130,25 @@ public:
       SchedulerDriver* driver,
       const TaskStatus& status) = 0;
 
+  // Invoked instead of 'statusUpdate' with the status updates that
+  // the driver received at about the same time, in order, if the
+  // driver delivers its callbacks in batches, i.e., if the
+  // environment variable MESOS_BATCH_CALLBACKS is set to true. In
+  // that mode 'resourceOffers' is invoked with the offers of all the
+  // offer messages received at about the same time as well. If
+  // implicit acknowledgements are being used, then returning from
+  // this callback _acknowledges_ receipt of all of these status
+  // updates. The default implementation invokes 'statusUpdate' for
+  // each of the status updates.
+  virtual void statusUpdates(
+      SchedulerDriver* driver,
+      const std::vector<TaskStatus>& statuses)
+  {
+    for (size_t i = 0; i < statuses.size(); i++) {
+      statusUpdate(driver, statuses[i]);
+    }
+  }
+
   // Invoked when an executor sends a message. These messages are best
   // effort; do not expect a framework message to be retransmitted in
   // any reliable fashion.
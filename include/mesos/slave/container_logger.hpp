@@ -0,0 +1,86 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MESOS_SLAVE_CONTAINER_LOGGER_HPP__
+#define __MESOS_SLAVE_CONTAINER_LOGGER_HPP__
+
+#include <string>
+
+#include <mesos/mesos.hpp>
+
+#include <process/future.hpp>
+#include <process/subprocess.hpp>
+
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace slave {
+
+// A containerizer component used to manage the stdout and stderr of
+// containers. Before launching an executor, the containerizer asks
+// the logger where the output of the executor should go, e.g., to
+// the 'stdout' and 'stderr' files of the sandbox (the default), or
+// to pipes which the logger reads from and ships elsewhere.
+class ContainerLogger
+{
+public:
+  // Where to redirect the stdout and stderr of an executor. When
+  // these are file descriptors, the containerizer takes ownership of
+  // them and closes them once the executor has been launched.
+  struct SubprocessInfo
+  {
+    SubprocessInfo(
+        const process::Subprocess::IO& _out,
+        const process::Subprocess::IO& _err)
+      : out(_out), err(_err) {}
+
+    process::Subprocess::IO out;
+    process::Subprocess::IO err;
+  };
+
+  // Create a container logger instance of the given type specified
+  // by the user. If the type is not specified, a default container
+  // logger instance, which writes to the sandbox, will be created.
+  static Try<ContainerLogger*> create(const Option<std::string>& type);
+
+  virtual ~ContainerLogger() {}
+
+  // Initializes this container logger. This method needs to be
+  // called before any other member method is called.
+  virtual Try<Nothing> initialize() = 0;
+
+  // Called for each executor the containerizer recovers after an
+  // agent restart. The output of these executors was set up by a
+  // previous instance of the logger, so a logger whose state does
+  // not outlive the agent should re-establish it here.
+  virtual process::Future<Nothing> recover(
+      const ExecutorInfo& executorInfo,
+      const std::string& sandboxDirectory) = 0;
+
+  // Called before an executor is launched in the given sandbox.
+  // Returns the redirections of the stdout and stderr of the
+  // executor.
+  virtual process::Future<SubprocessInfo> prepare(
+      const ExecutorInfo& executorInfo,
+      const std::string& sandboxDirectory) = 0;
+};
+
+} // namespace slave {
+} // namespace mesos {
+
+#endif // __MESOS_SLAVE_CONTAINER_LOGGER_HPP__
@@ -49,6 +49,14 @@ public:
       const std::list<ContainerState>& states,
       const hashset<ContainerID>& orphans) = 0;
 
+  // Returns whether the isolator has to be prepared after the
+  // isolators before it, i.e., those before it in the --isolation
+  // flag with the filesystem isolators first. An isolator whose
+  // 'prepare' does not depend on any other isolator, e.g., one that
+  // only creates a cgroup for the container, can return false so
+  // that the containerizer prepares it concurrently with the others.
+  virtual bool ordered() const { return true; }
+
   // Prepare for isolation of the executor. Any steps that require
   // execution in the containerized context (e.g. inside a network
   // namespace) can be returned in the optional CommandInfo and they
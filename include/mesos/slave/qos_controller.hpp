@@ -59,6 +59,15 @@ public:
   virtual Try<Nothing> initialize(
       const lambda::function<process::Future<ResourceUsage>()>& usage) = 0;
 
+  // Registers a callback that allows the QoS Controller to fetch the
+  // recent history of the resource usage for each executor on slave,
+  // which is only kept if the slave samples the usage, see the
+  // '--usage_sampling_interval' flag. This is called right after
+  // 'initialize'. The default implementation ignores the callback.
+  virtual void setUsageHistory(
+      const lambda::function<process::Future<ResourceUsageHistory>()>&
+        history) {}
+
   // A QoS Controller informs the slave about corrections to carry
   // out, but returning futures to QoSCorrection objects. For more
   // information, please refer to mesos.proto.
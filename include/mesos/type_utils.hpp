@@ -69,6 +69,9 @@ bool operator==(const URL& left, const URL& right);
 bool operator==(const TaskStatus& left, const TaskStatus& right);
 bool operator!=(const TaskStatus& left, const TaskStatus& right);
 
+bool operator==(const Unavailability& left, const Unavailability& right);
+bool operator!=(const Unavailability& left, const Unavailability& right);
+
 inline bool operator==(const ContainerID& left, const ContainerID& right)
 {
   return left.value() == right.value();
@@ -20,7 +20,9 @@
 
 #include <sasl/sasl.h>
 
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
@@ -28,7 +30,11 @@
 #include <process/process.hpp>
 #include <process/protobuf.hpp>
 
+#include <stout/hashmap.hpp>
 #include <stout/strings.hpp>
+#include <stout/synchronized.hpp>
+
+#include "authentication/cram_md5/authenticator.hpp"
 
 #include "logging/logging.hpp"
 
@@ -49,6 +55,58 @@ namespace cram_md5 {
 using namespace process;
 using std::string;
 
+namespace sessions {
+
+// A session issued to a principal of this process, along with the
+// secret of the principal when the session was issued.
+struct Session
+{
+  string secret;
+  string ticket;
+  string key;
+};
+
+
+// The last session issued to each principal of this process. These
+// outlive the authenticatees, which only authenticate once.
+static std::mutex* mutex = new std::mutex();
+static hashmap<string, Session>* issued = new hashmap<string, Session>();
+
+
+Option<Session> get(const Credential& credential)
+{
+  synchronized (mutex) {
+    Option<Session> session = issued->get(credential.principal());
+
+    // A session issued for another secret would authenticate the
+    // principal with the secret it used to have.
+    if (session.isSome() && session.get().secret == credential.secret()) {
+      return session;
+    }
+  }
+
+  return None();
+}
+
+
+void put(const Credential& credential, const Session& session)
+{
+  synchronized (mutex) {
+    issued->put(credential.principal(), session);
+  }
+}
+
+
+void erase(const Credential& credential)
+{
+  synchronized (mutex) {
+    issued->erase(credential.principal());
+  }
+}
+
+} // namespace sessions {
+
+
 class CRAMMD5AuthenticateeProcess
   : public ProtobufProcess<CRAMMD5AuthenticateeProcess>
 {
@@ -181,14 +239,16 @@ protected:
     // Anticipate mechanisms and steps from the server.
     install<AuthenticationMechanismsMessage>(
         &CRAMMD5AuthenticateeProcess::mechanisms,
-        &AuthenticationMechanismsMessage::mechanisms);
+        &AuthenticationMechanismsMessage::mechanisms,
+        &AuthenticationMechanismsMessage::challenge);
 
     install<AuthenticationStepMessage>(
         &CRAMMD5AuthenticateeProcess::step,
         &AuthenticationStepMessage::data);
 
     install<AuthenticationCompletedMessage>(
-        &CRAMMD5AuthenticateeProcess::completed);
+        &CRAMMD5AuthenticateeProcess::completed,
+        &AuthenticationCompletedMessage::ticket);
 
     install<AuthenticationFailedMessage>(
         &CRAMMD5AuthenticateeProcess::failed);
@@ -198,8 +258,19 @@ protected:
         &AuthenticationErrorMessage::error);
   }
 
-  void mechanisms(const std::vector<string>& mechanisms)
+  void mechanisms(
+      const std::vector<string>& _mechanisms,
+      const string& challenge)
   {
+    if (status == RESUMING) {
+      // The authenticator refused to resume the session, e.g., since
+      // it expired, and offers the SASL mechanisms instead.
+      LOG(INFO) << "Session refused, falling back to SASL";
+
+      sessions::erase(credential);
+      status = STARTING;
+    }
+
     if (status != STARTING) {
       status = ERROR;
       promise.fail("Unexpected authentication 'mechanisms' received");
@@ -209,6 +280,40 @@ protected:
     // TODO(benh): Store 'from' in order to ensure we only communicate
     // with the same Authenticator.
 
+    // The session mechanism is not a SASL mechanism.
+    std::vector<string> mechanisms;
+    bool resumable = false;
+    foreach (const string& mechanism, _mechanisms) {
+      if (mechanism == SESSION_MECHANISM) {
+        resumable = !challenge.empty();
+      } else {
+        mechanisms.push_back(mechanism);
+      }
+    }
+
+    // Resume the session by answering the challenge with the key of
+    // the session, which never goes over the wire itself.
+    Option<sessions::Session> session = None();
+    if (resumable) {
+      session = sessions::get(credential);
+    }
+
+    if (session.isSome()) {
+      Option<string> response = hmac(session.get().key, challenge);
+      if (response.isSome()) {
+        LOG(INFO) << "Attempting to authenticate by resuming a session";
+
+        AuthenticationStartMessage message;
+        message.set_mechanism(SESSION_MECHANISM);
+        message.set_data(session.get().ticket + response.get());
+
+        reply(message);
+
+        status = RESUMING;
+        return;
+      }
+    }
+
     LOG(INFO) << "Received SASL authentication mechanisms: "
               << strings::join(",", mechanisms);
 
@@ -287,9 +392,9 @@ protected:
     }
   }
 
-  void completed()
+  void completed(const string& ticket)
   {
-    if (status != STEPPING) {
+    if (status != STEPPING && status != RESUMING) {
       status = ERROR;
       promise.fail("Unexpected authentication 'completed' received");
       return;
@@ -297,12 +402,30 @@ protected:
 
     LOG(INFO) << "Authentication success";
 
+    // Derive the key of the session from the ticket and our secret,
+    // the same way as the authenticator does.
+    if (!ticket.empty()) {
+      Option<string> key =
+        hmac(credential.secret(), "mesos-session-key:" + ticket);
+
+      if (key.isSome()) {
+        sessions::Session session;
+        session.secret = credential.secret();
+        session.ticket = ticket;
+        session.key = key.get();
+
+        sessions::put(credential, session);
+      }
+    }
+
     status = COMPLETED;
     promise.set(true);
   }
 
   void failed()
   {
+    sessions::erase(credential);
+
     status = FAILED;
     promise.set(false);
   }
@@ -345,6 +468,78 @@ private:
     return SASL_OK;
   }
 
+  // Returns the HMAC-MD5 of 'text' keyed with 'key' in hex. The SASL
+  // client library only computes an HMAC-MD5 as part of the CRAM-MD5
+  // mechanism, whose response to a challenge is the user name
+  // followed by the HMAC-MD5 of the challenge keyed with the password
+  // in hex (see RFC 2195), so we answer 'text' as a challenge.
+  static Option<string> hmac(const string& key, const string& text)
+  {
+    sasl_secret_t* secret =
+      (sasl_secret_t*) malloc(sizeof(sasl_secret_t) + key.length());
+
+    CHECK(secret != NULL) << "Failed to allocate memory for secret";
+
+    memcpy(secret->data, key.data(), key.length());
+    secret->len = key.length();
+
+    sasl_callback_t callbacks[4];
+
+    callbacks[0].id = SASL_CB_USER;
+    callbacks[0].proc = (int(*)()) &user;
+    callbacks[0].context = (void*) "mesos";
+
+    callbacks[1].id = SASL_CB_AUTHNAME;
+    callbacks[1].proc = (int(*)()) &user;
+    callbacks[1].context = (void*) "mesos";
+
+    callbacks[2].id = SASL_CB_PASS;
+    callbacks[2].proc = (int(*)()) &pass;
+    callbacks[2].context = (void*) secret;
+
+    callbacks[3].id = SASL_CB_LIST_END;
+    callbacks[3].proc = NULL;
+    callbacks[3].context = NULL;
+
+    sasl_conn_t* connection = NULL;
+    sasl_interact_t* interact = NULL;
+    const char* output = NULL;
+    unsigned length = 0;
+    const char* mechanism = NULL;
+
+    int result = sasl_client_new(
+        "mesos", NULL, NULL, NULL, callbacks, 0, &connection);
+
+    if (result == SASL_OK) {
+      result = sasl_client_start(
+          connection, "CRAM-MD5", &interact, &output, &length, &mechanism);
+    }
+
+    // The CRAM-MD5 client waits for the challenge before it responds.
+    Option<string> digest = None();
+    if (result == SASL_CONTINUE) {
+      result = sasl_client_step(
+          connection, text.data(), text.length(), &interact, &output, &length);
+
+      if ((result == SASL_OK || result == SASL_CONTINUE) && output != NULL) {
+        const string response(output, length);
+
+        size_t separator = response.rfind(' ');
+        if (separator != string::npos) {
+          digest = response.substr(separator + 1);
+        }
+      }
+    }
+
+    if (connection != NULL) {
+      sasl_dispose(&connection);
+    }
+
+    free(secret);
+
+    return digest;
+  }
+
   const Credential credential;
 
   // PID of the client that needs to be authenticated.
@@ -358,6 +553,7 @@ private:
   {
     READY,
     STARTING,
+    RESUMING,
     STEPPING,
     COMPLETED,
     FAILED,
@@ -19,11 +19,15 @@
 #include <sasl/sasl.h>
 #include <sasl/saslplug.h>
 
+#include <iomanip>
+#include <list>
 #include <map>
+#include <sstream>
 #include <vector>
 
 #include <mesos/mesos.hpp>
 
+#include <process/clock.hpp>
 #include <process/defer.hpp>
 #include <process/once.hpp>
 #include <process/owned.hpp>
@@ -32,6 +36,9 @@
 #include <stout/check.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
+#include <stout/numify.hpp>
+#include <stout/stringify.hpp>
+#include <stout/uuid.hpp>
 
 #include "authenticator.hpp"
 
@@ -54,14 +61,130 @@ namespace cram_md5 {
 using namespace process;
 using std::string;
 
+namespace sessions {
+
+// The size of an HMAC-MD5 in hex.
+static const size_t HMAC_SIZE = 32;
+
+
+// Returns the HMAC-MD5 of 'text' keyed with 'key' in hex, the same
+// way as the response of a CRAM-MD5 client (see the authenticatee).
+Option<string> hmac(const string& key, const string& text)
+{
+  Option<string> digest = InMemoryAuxiliaryPropertyPlugin::hmac(key, text);
+  if (digest.isNone()) {
+    return None();
+  }
+
+  std::ostringstream out;
+  out << std::hex << std::setfill('0');
+
+  foreach (char c, digest.get()) {
+    out << std::setw(2) << static_cast<int>(static_cast<unsigned char>(c));
+  }
+
+  return out.str();
+}
+
+
+// Returns the key of the session with the given ticket, keyed with
+// the secret of the principal. Any authenticator with the same
+// credentials can thus derive it, e.g., a newly elected master.
+Option<string> key(const string& principal, const string& ticket)
+{
+  Option<std::list<string>> secrets =
+    InMemoryAuxiliaryPropertyPlugin::lookup(principal, SASL_AUX_PASSWORD_PROP);
+
+  if (secrets.isNone() || secrets.get().empty()) {
+    return None();
+  }
+
+  return hmac(secrets.get().front(), "mesos-session-key:" + ticket);
+}
+
+
+// Returns a ticket for a session of the principal which expires after
+// the given duration, of the form '<principal>:<expiry>:<uuid>'. The
+// ticket itself does not authenticate anybody, only the key that both
+// ends derive from it and the secret of the principal does.
+string issue(const string& principal, const Duration& ttl)
+{
+  return principal + ":" +
+    stringify(static_cast<int64_t>((Clock::now() + ttl).secs())) + ":" +
+    UUID::random().toString();
+}
+
+
+// Returns the principal of the session if the authenticatee resumes
+// it with a valid ticket followed by the HMAC-MD5 of the challenge
+// keyed with the key of the session, i.e., the ticket has not expired
+// and the authenticatee knows the key.
+Option<string> verify(const string& data, const string& challenge)
+{
+  if (data.size() <= HMAC_SIZE) {
+    return None();
+  }
+
+  const string ticket = data.substr(0, data.size() - HMAC_SIZE);
+  const string response = data.substr(data.size() - HMAC_SIZE);
+
+  size_t separator = ticket.rfind(':');
+  if (separator == string::npos || separator == 0) {
+    return None();
+  }
+
+  size_t separator_ = ticket.rfind(':', separator - 1);
+  if (separator_ == string::npos) {
+    return None();
+  }
+
+  const string principal = ticket.substr(0, separator_);
+
+  Try<int64_t> expiry = numify<int64_t>(
+      ticket.substr(separator_ + 1, separator - separator_ - 1));
+
+  if (expiry.isError() || expiry.get() < Clock::now().secs()) {
+    return None();
+  }
+
+  Option<string> key_ = key(principal, ticket);
+  if (key_.isNone()) {
+    return None();
+  }
+
+  Option<string> expected = hmac(key_.get(), challenge);
+  if (expected.isNone() || expected.get().size() != response.size()) {
+    return None();
+  }
+
+  // Compare all of the response, so that the time this takes does
+  // not tell how much of a forged response is right.
+  unsigned char difference = 0;
+  for (size_t i = 0; i < response.size(); i++) {
+    difference |= expected.get()[i] ^ response[i];
+  }
+
+  if (difference != 0) {
+    return None();
+  }
+
+  return principal;
+}
+
+} // namespace sessions {
+
+
 class CRAMMD5AuthenticatorSessionProcess :
   public ProtobufProcess<CRAMMD5AuthenticatorSessionProcess>
 {
 public:
-  explicit CRAMMD5AuthenticatorSessionProcess(const UPID& _pid)
+  CRAMMD5AuthenticatorSessionProcess(
+      const UPID& _pid,
+      const Option<Duration>& _sessionTtl)
     : ProcessBase(ID::generate("crammd5_authenticator_session")),
       status(READY),
       pid(_pid),
+      sessionTtl(_sessionTtl),
       connection(NULL) {}
 
   virtual ~CRAMMD5AuthenticatorSessionProcess()
@@ -148,10 +271,20 @@ public:
       return promise.future();
     }
 
-    std::vector<string> mechanisms = strings::tokenize(output, ",");
+    mechanisms = strings::tokenize(output, ",");
 
-    // Send authentication mechanisms.
+    // Send authentication mechanisms. The session mechanism is not a
+    // SASL mechanism, which SASL clients ignore. Its challenge is
+    // fresh for each authentication, so that the responses to it
+    // cannot be replayed.
     AuthenticationMechanismsMessage message;
+    if (sessionTtl.isSome()) {
+      challenge = UUID::random().toString();
+
+      message.add_mechanisms(SESSION_MECHANISM);
+      message.set_challenge(challenge.get());
+    }
+
     foreach (const string& mechanism, mechanisms) {
       message.add_mechanisms(mechanism);
     }
@@ -200,6 +333,11 @@ public:
       return;
     }
 
+    if (mechanism == SESSION_MECHANISM) {
+      resume(data);
+      return;
+    }
+
     LOG(INFO) << "Received SASL authentication start";
 
     // Start the server.
@@ -307,6 +445,50 @@ private:
     return SASL_OK;
   }
 
+  // Helper for handling the resumption of a session by the
+  // authenticatee rather than a SASL mechanism.
+  void resume(const string& data)
+  {
+    Option<string> principal_ = None();
+    if (challenge.isSome()) {
+      principal_ = sessions::verify(data, challenge.get());
+    }
+
+    if (principal_.isNone()) {
+      LOG(INFO) << "Refused to resume session, falling back to SASL";
+
+      // Let the authenticatee start over with a SASL mechanism, e.g.,
+      // when its session has expired.
+      AuthenticationMechanismsMessage message;
+      foreach (const string& mechanism, mechanisms) {
+        message.add_mechanisms(mechanism);
+      }
+
+      send(pid, message);
+      return;
+    }
+
+    LOG(INFO) << "Authentication success by resuming a session";
+
+    principal = principal_;
+    completed();
+  }
+
+  // Helper for completing a successful authentication.
+  void completed()
+  {
+    CHECK_SOME(principal);
+
+    AuthenticationCompletedMessage message;
+    if (sessionTtl.isSome()) {
+      message.set_ticket(sessions::issue(principal.get(), sessionTtl.get()));
+    }
+
+    send(pid, message);
+    status = COMPLETED;
+    promise.set(principal);
+  }
+
   // Helper for handling result of server start and step.
   void handle(int result, const char* output, unsigned length)
   {
@@ -318,9 +500,7 @@ private:
       // Note that we're not using SASL_SUCCESS_DATA which means that
       // we should not have any data to send when we get a SASL_OK.
       CHECK(output == NULL);
-      send(pid, AuthenticationCompletedMessage());
-      status = COMPLETED;
-      promise.set(principal);
+      completed();
     } else if (result == SASL_CONTINUE) {
       LOG(INFO) << "Authentication requires more steps";
       AuthenticationStepMessage message;
@@ -360,6 +540,17 @@ private:
 
   const UPID pid;
 
+  // How long the sessions that the authenticator issues tickets for
+  // are valid for, if it issues any.
+  const Option<Duration> sessionTtl;
+
+  // The challenge to resume a session with, if the authenticator
+  // issues session tickets.
+  Option<string> challenge;
+
+  // The SASL mechanisms offered to the authenticatee.
+  std::vector<string> mechanisms;
+
   sasl_conn_t* connection;
 
   Promise<Option<string>> promise;
@@ -371,9 +562,11 @@ private:
 class CRAMMD5AuthenticatorSession
 {
 public:
-  explicit CRAMMD5AuthenticatorSession(const UPID& pid)
+  CRAMMD5AuthenticatorSession(
+      const UPID& pid,
+      const Option<Duration>& sessionTtl)
   {
-    process = new CRAMMD5AuthenticatorSessionProcess(pid);
+    process = new CRAMMD5AuthenticatorSessionProcess(pid, sessionTtl);
     spawn(process);
   }
 
@@ -403,8 +596,9 @@ class CRAMMD5AuthenticatorProcess :
   public Process<CRAMMD5AuthenticatorProcess>
 {
 public:
-  CRAMMD5AuthenticatorProcess() :
-    ProcessBase(ID::generate("crammd5_authenticator")) {}
+  explicit CRAMMD5AuthenticatorProcess(const Option<Duration>& _sessionTtl)
+    : ProcessBase(ID::generate("crammd5_authenticator")),
+      sessionTtl(_sessionTtl) {}
 
   virtual ~CRAMMD5AuthenticatorProcess() {}
 
@@ -417,7 +611,7 @@ public:
     }
 
     Owned<CRAMMD5AuthenticatorSession> session(
-        new CRAMMD5AuthenticatorSession(pid));
+        new CRAMMD5AuthenticatorSession(pid, sessionTtl));
 
     sessions.put(pid, session);
 
@@ -434,6 +628,8 @@ public:
 }
 
 private:
+  const Option<Duration> sessionTtl;
+
   hashmap <UPID, Owned<CRAMMD5AuthenticatorSession>> sessions;
 };
 
@@ -478,6 +674,12 @@ Try<Authenticator*> CRAMMD5Authenticator::create()
 CRAMMD5Authenticator::CRAMMD5Authenticator() : process(NULL) {}
 
 
+CRAMMD5Authenticator::CRAMMD5Authenticator(
+    const Option<Duration>& _sessionTtl)
+  : sessionTtl(_sessionTtl),
+    process(NULL) {}
+
+
 CRAMMD5Authenticator::~CRAMMD5Authenticator()
 {
   if (process != NULL) {
@@ -542,7 +744,7 @@ Try<Nothing> CRAMMD5Authenticator::initialize(
     return error->get();
   }
 
-  process = new CRAMMD5AuthenticatorProcess();
+  process = new CRAMMD5AuthenticatorProcess(sessionTtl);
   spawn(process);
 
   return Nothing();
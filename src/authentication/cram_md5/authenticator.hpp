@@ -24,6 +24,7 @@
 #include <process/future.hpp>
 #include <process/id.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/option.hpp>
 #include <stout/try.hpp>
 
@@ -31,6 +32,15 @@ namespace mesos {
 namespace internal {
 namespace cram_md5 {
 
+// The mechanism, announced along with the SASL mechanisms, with which
+// an authenticatee resumes the session it was issued a ticket for the
+// last time it authenticated (see AuthenticationCompletedMessage)
+// rather than going through a SASL exchange. The authenticatee sends
+// the ticket followed by the HMAC-MD5 of the challenge of the
+// authenticator (see AuthenticationMechanismsMessage), keyed with the
+// HMAC-MD5 of the ticket keyed with its secret, both in hex.
+const char SESSION_MECHANISM[] = "MESOS-SESSION";
+
 // Forward declaration.
 class CRAMMD5AuthenticatorProcess;
 
@@ -42,6 +52,10 @@ public:
 
   CRAMMD5Authenticator();
 
+  // Issues tickets for sessions which are valid for 'sessionTtl' to
+  // the authenticatees it authenticates, if set.
+  explicit CRAMMD5Authenticator(const Option<Duration>& sessionTtl);
+
   virtual ~CRAMMD5Authenticator();
 
   virtual Try<Nothing> initialize(const Option<Credentials>& credentials);
@@ -50,6 +64,8 @@ public:
       const process::UPID& pid);
 
 private:
+  const Option<Duration> sessionTtl;
+
   CRAMMD5AuthenticatorProcess* process;
 };
 
@@ -38,6 +38,7 @@ namespace cram_md5 {
 // Storage for the static members.
 Multimap<string, Property> InMemoryAuxiliaryPropertyPlugin::properties;
 sasl_auxprop_plug_t InMemoryAuxiliaryPropertyPlugin::plugin;
+const sasl_utils_t* InMemoryAuxiliaryPropertyPlugin::utils = NULL;
 std::mutex InMemoryAuxiliaryPropertyPlugin::mutex;
 
 int InMemoryAuxiliaryPropertyPlugin::initialize(
@@ -58,6 +59,8 @@ int InMemoryAuxiliaryPropertyPlugin::initialize(
 
   *version = SASL_AUXPROP_PLUG_VERSION;
 
+  InMemoryAuxiliaryPropertyPlugin::utils = utils;
+
   plugin.features = 0;
   plugin.spare_int1 = 0;
   plugin.glob_context = NULL;
@@ -74,6 +77,27 @@ int InMemoryAuxiliaryPropertyPlugin::initialize(
 }
 
 
+Option<string> InMemoryAuxiliaryPropertyPlugin::hmac(
+    const string& key,
+    const string& text)
+{
+  if (utils == NULL) {
+    return None();
+  }
+
+  unsigned char digest[16];
+
+  utils->hmac_md5(
+      reinterpret_cast<const unsigned char*>(text.data()),
+      text.size(),
+      reinterpret_cast<const unsigned char*>(key.data()),
+      key.size(),
+      digest);
+
+  return string(reinterpret_cast<const char*>(digest), sizeof(digest));
+}
+
+
 #if SASL_AUXPROP_PLUG_VERSION <= 4
   void InMemoryAuxiliaryPropertyPlugin::lookup(
 #else
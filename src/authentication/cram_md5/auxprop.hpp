@@ -69,6 +69,13 @@ public:
     return None();
   }
 
+  // Returns the HMAC-MD5 of 'text' keyed with 'key', computed by the
+  // utilities SASL provides to its plugins, or None if the plugin has
+  // not been initialized yet.
+  static Option<std::string> hmac(
+      const std::string& key,
+      const std::string& text);
+
   // SASL plugin initialize entry.
   static int initialize(
       const sasl_utils_t* utils,
@@ -95,6 +102,10 @@ private:
 
   static sasl_auxprop_plug_t plugin;
 
+  // The utilities SASL provided when initializing the plugin, which
+  // live as long as the SASL library.
+  static const sasl_utils_t* utils;
+
   // Access to 'properties' has to be protected as multiple
   // authenticator instances may be active concurrently.
   static std::mutex mutex;
@@ -16,110 +16,286 @@
 
 #include "authorizer/local/authorizer.hpp"
 
+#include <algorithm>
+#include <list>
 #include <string>
+#include <vector>
 
+#include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/id.hpp>
 #include <process/process.hpp>
 #include <process/protobuf.hpp>
 
+#include <process/metrics/gauge.hpp>
+#include <process/metrics/metrics.hpp>
+
+#include <stout/cache.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/try.hpp>
 
 using process::Failure;
 using process::Future;
+using process::defer;
 using process::dispatch;
 
+using process::metrics::Gauge;
+
+using std::list;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
 
+// Maximum number of authorization decisions remembered by the local
+// authorizer, see 'LocalAuthorizerProcess::cached'.
+static const size_t DECISIONS_CACHE_CAPACITY = 1024;
+
+
+// The ACLs of one kind, indexed by the values of their principals,
+// so that a request only has to be matched against the ACLs which
+// can apply to its principals rather than against all of them.
+template <typename T>
+class ACLIndex
+{
+public:
+  explicit ACLIndex(const google::protobuf::RepeatedPtrField<T>& _acls)
+    : acls(_acls)
+  {
+    for (int i = 0; i < acls.size(); i++) {
+      const ACL::Entity& principals = acls.Get(i).principals();
+
+      if (principals.type() != ACL::Entity::SOME) {
+        others.push_back(i);
+        continue;
+      }
+
+      foreach (const string& value, principals.values()) {
+        vector<int>& positions = some[value];
+
+        // The values of an ACL may contain duplicates.
+        if (positions.empty() || positions.back() != i) {
+          positions.push_back(i);
+        }
+      }
+    }
+  }
+
+  // Returns the ACLs which may match a request by the given
+  // principals (see 'matches' below), in the order they were
+  // specified since the first ACL that matches decides the request.
+  vector<const T*> candidates(const ACL::Entity& principals) const
+  {
+    vector<const T*> result;
+
+    // An ACL for SOME principals can match a request by SOME
+    // principals only, and then only if its values include all of
+    // the values of the request, and hence the first of them. A
+    // request for SOME principals but without values is matched by
+    // every ACL.
+    if (principals.type() == ACL::Entity::SOME) {
+      if (principals.values_size() == 0) {
+        foreach (const T& acl, acls) {
+          result.push_back(&acl);
+        }
+        return result;
+      }
+
+      auto indexed = some.find(principals.values(0));
+      if (indexed != some.end()) {
+        vector<int> positions;
+        positions.reserve(others.size() + indexed->second.size());
+
+        std::merge(
+            others.begin(),
+            others.end(),
+            indexed->second.begin(),
+            indexed->second.end(),
+            std::back_inserter(positions));
+
+        foreach (int position, positions) {
+          result.push_back(&acls.Get(position));
+        }
+        return result;
+      }
+    }
+
+    foreach (int position, others) {
+      result.push_back(&acls.Get(position));
+    }
+    return result;
+  }
+
+private:
+  const google::protobuf::RepeatedPtrField<T>& acls;
+
+  // The positions of the ACLs for SOME principals, by principal.
+  hashmap<string, vector<int>> some;
+
+  // The positions of the ACLs for ANY or NONE principals.
+  vector<int> others;
+};
+
+
 class LocalAuthorizerProcess : public ProtobufProcess<LocalAuthorizerProcess>
 {
 public:
   LocalAuthorizerProcess(const ACLs& _acls)
-    : ProcessBase(process::ID::generate("authorizer")), acls(_acls) {}
+    : ProcessBase(process::ID::generate("authorizer")),
+      acls(_acls),
+      registerFrameworks(acls.register_frameworks()),
+      runTasks(acls.run_tasks()),
+      shutdownFrameworks(acls.shutdown_frameworks()),
+      reserveResources(acls.reserve_resources()),
+      unreserveResources(acls.unreserve_resources()),
+      decisions(DECISIONS_CACHE_CAPACITY),
+      metrics(*this) {}
 
   Future<bool> authorize(const ACL::RegisterFramework& request)
   {
-    foreach (const ACL::RegisterFramework& acl, acls.register_frameworks()) {
+    return cached(request);
+  }
+
+  Future<bool> authorize(const ACL::RunTask& request)
+  {
+    return cached(request);
+  }
+
+  Future<list<bool>> authorize(const list<ACL::RunTask>& requests)
+  {
+    list<bool> result;
+    foreach (const ACL::RunTask& request, requests) {
+      result.push_back(cached(request));
+    }
+
+    return result;
+  }
+
+  Future<bool> authorize(const ACL::ShutdownFramework& request)
+  {
+    return cached(request);
+  }
+
+  Future<bool> authorize(const ACL::ReserveResources& request)
+  {
+    return cached(request);
+  }
+
+  Future<bool> authorize(const ACL::UnreserveResources& request)
+  {
+    return cached(request);
+  }
+
+private:
+  // The ACLs never change once the authorizer is initialized, so the
+  // decision for a request can be remembered. Frameworks and
+  // operators tend to send the same requests over and over (e.g.,
+  // every task of a framework is launched as the same user), which
+  // saves walking the ACLs for each of them.
+  template <typename Request>
+  bool cached(const Request& request)
+  {
+    // The serialization of requests of different types can be the
+    // same, hence we prefix the key with the type of the request.
+    const string key =
+      Request::descriptor()->full_name() + ":" + request.SerializeAsString();
+
+    Option<bool> decision = decisions.get(key);
+    if (decision.isNone()) {
+      decision = decide(request);
+      decisions.put(key, decision.get());
+    }
+
+    return decision.get();
+  }
+
+  bool decide(const ACL::RegisterFramework& request)
+  {
+    foreach (const ACL::RegisterFramework* acl,
+             registerFrameworks.candidates(request.principals())) {
       // ACL matches if both subjects and objects match.
-      if (matches(request.principals(), acl.principals()) &&
-          matches(request.roles(), acl.roles())) {
+      if (matches(request.principals(), acl->principals()) &&
+          matches(request.roles(), acl->roles())) {
         // ACL is allowed if both subjects and objects are allowed.
-        return allows(request.principals(), acl.principals()) &&
-               allows(request.roles(), acl.roles());
+        return allows(request.principals(), acl->principals()) &&
+               allows(request.roles(), acl->roles());
       }
     }
 
     return acls.permissive(); // None of the ACLs match.
   }
 
-  Future<bool> authorize(const ACL::RunTask& request)
+  bool decide(const ACL::RunTask& request)
   {
-    foreach (const ACL::RunTask& acl, acls.run_tasks()) {
+    foreach (const ACL::RunTask* acl,
+             runTasks.candidates(request.principals())) {
       // ACL matches if both subjects and objects match.
-      if (matches(request.principals(), acl.principals()) &&
-          matches(request.users(), acl.users())) {
+      if (matches(request.principals(), acl->principals()) &&
+          matches(request.users(), acl->users())) {
         // ACL is allowed if both subjects and objects are allowed.
-        return allows(request.principals(), acl.principals()) &&
-               allows(request.users(), acl.users());
+        return allows(request.principals(), acl->principals()) &&
+               allows(request.users(), acl->users());
       }
     }
 
     return acls.permissive(); // None of the ACLs match.
   }
 
-  Future<bool> authorize(const ACL::ShutdownFramework& request)
+  bool decide(const ACL::ShutdownFramework& request)
   {
-    foreach (const ACL::ShutdownFramework& acl, acls.shutdown_frameworks()) {
+    foreach (const ACL::ShutdownFramework* acl,
+             shutdownFrameworks.candidates(request.principals())) {
       // ACL matches if both subjects and objects match.
-      if (matches(request.principals(), acl.principals()) &&
+      if (matches(request.principals(), acl->principals()) &&
           matches(request.framework_principals(),
-                  acl.framework_principals())) {
+                  acl->framework_principals())) {
         // ACL is allowed if both subjects and objects are allowed.
-        return allows(request.principals(), acl.principals()) &&
+        return allows(request.principals(), acl->principals()) &&
                allows(request.framework_principals(),
-                      acl.framework_principals());
+                      acl->framework_principals());
       }
     }
 
     return acls.permissive(); // None of the ACLs match.
   }
 
-  Future<bool> authorize(const ACL::ReserveResources& request)
+  bool decide(const ACL::ReserveResources& request)
   {
-    foreach (const ACL::ReserveResources& acl, acls.reserve_resources()) {
+    foreach (const ACL::ReserveResources* acl,
+             reserveResources.candidates(request.principals())) {
       // ACL matches if both subjects and objects match.
-      if (matches(request.principals(), acl.principals()) &&
-          matches(request.resources(), acl.resources())) {
+      if (matches(request.principals(), acl->principals()) &&
+          matches(request.resources(), acl->resources())) {
         // ACL is allowed if both subjects and objects are allowed.
-        return allows(request.principals(), acl.principals()) &&
-               allows(request.resources(), acl.resources());
+        return allows(request.principals(), acl->principals()) &&
+               allows(request.resources(), acl->resources());
       }
     }
 
     return acls.permissive(); // None of the ACLs match.
   }
 
-  Future<bool> authorize(const ACL::UnreserveResources& request)
+  bool decide(const ACL::UnreserveResources& request)
   {
-    foreach (const ACL::UnreserveResources& acl, acls.unreserve_resources()) {
+    foreach (const ACL::UnreserveResources* acl,
+             unreserveResources.candidates(request.principals())) {
       // ACL matches if both subjects and objects match.
-      if (matches(request.principals(), acl.principals()) &&
-          matches(request.reserver_principals(), acl.reserver_principals())) {
+      if (matches(request.principals(), acl->principals()) &&
+          matches(request.reserver_principals(), acl->reserver_principals())) {
         // ACL is allowed if both subjects and objects are allowed.
-        return allows(request.principals(), acl.principals()) &&
-               allows(request.reserver_principals(), acl.reserver_principals());
+        return allows(request.principals(), acl->principals()) &&
+               allows(request.reserver_principals(),
+                      acl->reserver_principals());
       }
     }
 
     return acls.permissive(); // None of the ACLs match.
   }
 
-private:
   // Match matrix:
   //
   //                  -----------ACL----------
@@ -227,7 +403,63 @@ private:
     return false;
   }
 
-  ACLs acls;
+  double _cache_hits()
+  {
+    return static_cast<double>(decisions.statistics().hits);
+  }
+
+  double _cache_misses()
+  {
+    return static_cast<double>(decisions.statistics().misses);
+  }
+
+  double _cache_evictions()
+  {
+    return static_cast<double>(decisions.statistics().evictions);
+  }
+
+  struct Metrics
+  {
+    explicit Metrics(const LocalAuthorizerProcess& process)
+      : cache_hits(
+            "authorizer/cache_hits",
+            defer(process, &LocalAuthorizerProcess::_cache_hits)),
+        cache_misses(
+            "authorizer/cache_misses",
+            defer(process, &LocalAuthorizerProcess::_cache_misses)),
+        cache_evictions(
+            "authorizer/cache_evictions",
+            defer(process, &LocalAuthorizerProcess::_cache_evictions))
+    {
+      process::metrics::add(cache_hits);
+      process::metrics::add(cache_misses);
+      process::metrics::add(cache_evictions);
+    }
+
+    ~Metrics()
+    {
+      process::metrics::remove(cache_hits);
+      process::metrics::remove(cache_misses);
+      process::metrics::remove(cache_evictions);
+    }
+
+    Gauge cache_hits;
+    Gauge cache_misses;
+    Gauge cache_evictions;
+  };
+
+  const ACLs acls;
+
+  // Indices of the ACLs above, built once the ACLs are loaded.
+  const ACLIndex<ACL::RegisterFramework> registerFrameworks;
+  const ACLIndex<ACL::RunTask> runTasks;
+  const ACLIndex<ACL::ShutdownFramework> shutdownFrameworks;
+  const ACLIndex<ACL::ReserveResources> reserveResources;
+  const ACLIndex<ACL::UnreserveResources> unreserveResources;
+
+  Cache<string, bool> decisions;
+
+  Metrics metrics;
 };
 
 
@@ -306,6 +538,22 @@ Future<bool> LocalAuthorizer::authorize(const ACL::RunTask& request)
 }
 
 
+Future<list<bool>> LocalAuthorizer::authorize(
+    const list<ACL::RunTask>& requests)
+{
+  if (process == NULL) {
+    return Failure("Authorizer not initialized");
+  }
+
+  // Necessary to disambiguate.
+  typedef Future<list<bool>>(LocalAuthorizerProcess::*F)(
+      const list<ACL::RunTask>&);
+
+  return dispatch(
+      process, static_cast<F>(&LocalAuthorizerProcess::authorize), requests);
+}
+
+
 Future<bool> LocalAuthorizer::authorize(const ACL::ShutdownFramework& request)
 {
   if (process == NULL) {
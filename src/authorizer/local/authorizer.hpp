@@ -17,6 +17,8 @@
 #ifndef __AUTHORIZER_AUTHORIZER_HPP__
 #define __AUTHORIZER_AUTHORIZER_HPP__
 
+#include <list>
+
 #include <mesos/authorizer/authorizer.hpp>
 
 #include <process/future.hpp>
@@ -55,6 +57,8 @@ public:
       const ACL::RegisterFramework& request);
   virtual process::Future<bool> authorize(
       const ACL::RunTask& request);
+  virtual process::Future<std::list<bool>> authorize(
+      const std::list<ACL::RunTask>& requests);
   virtual process::Future<bool> authorize(
       const ACL::ShutdownFramework& request);
   virtual process::Future<bool> authorize(
@@ -26,6 +26,7 @@
 #include <stout/foreach.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/stringify.hpp>
+#include <stout/strings.hpp>
 #include <stout/unreachable.hpp>
 
 #include "common/http.hpp"
@@ -49,8 +50,9 @@ string serialize(
       return message.SerializeAsString();
     }
     case ContentType::JSON: {
-      JSON::Object object = JSON::protobuf(message);
-      return stringify(object);
+      string body;
+      JSON::serialize(message, &body);
+      return body;
     }
   }
 
@@ -58,6 +60,25 @@ string serialize(
 }
 
 
+bool acceptsProtobuf(const process::http::Request& request)
+{
+  Option<string> accept = request.headers.get("Accept");
+
+  return accept.isSome() &&
+         strings::contains(accept.get(), APPLICATION_PROTOBUF) &&
+         request.acceptsMediaType(APPLICATION_PROTOBUF);
+}
+
+
+process::http::Response protobufResponse(
+    const google::protobuf::Message& message)
+{
+  process::http::OK ok(serialize(ContentType::PROTOBUF, message));
+  ok.headers["Content-Type"] = APPLICATION_PROTOBUF;
+  return ok;
+}
+
+
 // TODO(bmahler): Kill these in favor of automatic Proto->JSON
 // Conversion (when it becomes available).
 
@@ -66,7 +87,7 @@ string serialize(
 static JSON::Value value(
     const string& name,
     const Value::Type& type,
-    Resources resources)
+    const Resources& resources)
 {
   switch (type) {
     case Value::SCALAR:
@@ -367,5 +388,214 @@ JSON::Object model(
 }
 
 
+void json(JSON::ObjectWriter* writer, const Task& task)
+{
+  writer->field("id", task.task_id().value());
+  writer->field("name", task.name());
+  writer->field("framework_id", task.framework_id().value());
+  writer->field("executor_id", task.executor_id().value());
+  writer->field("slave_id", task.slave_id().value());
+  writer->field("state", TaskState_Name(task.state()));
+  writer->field("resources", Resources(task.resources()));
+  writer->field("statuses", task.statuses());
+
+  if (task.has_labels()) {
+    writer->field("labels", task.labels());
+  }
+
+  if (task.has_discovery()) {
+    writer->field("discovery", JSON::protobuf(task.discovery()));
+  }
+}
+
+
+void json(
+    JSON::ObjectWriter* writer,
+    const TaskInfo& task,
+    const FrameworkID& frameworkId,
+    const TaskState& state,
+    const vector<TaskStatus>& statuses)
+{
+  writer->field("id", task.task_id().value());
+  writer->field("name", task.name());
+  writer->field("framework_id", frameworkId.value());
+  writer->field("executor_id", task.executor().executor_id().value());
+  writer->field("slave_id", task.slave_id().value());
+  writer->field("state", TaskState_Name(state));
+  writer->field("resources", Resources(task.resources()));
+  writer->field("statuses", statuses);
+
+  if (task.has_labels()) {
+    writer->field("labels", task.labels());
+  }
+
+  if (task.has_discovery()) {
+    writer->field("discovery", JSON::protobuf(task.discovery()));
+  }
+}
+
 }  // namespace internal {
+
+
+void json(JSON::ObjectWriter* writer, const Attributes& attributes)
+{
+  foreach (const Attribute& attribute, attributes) {
+    switch (attribute.type()) {
+      case Value::SCALAR:
+        writer->field(attribute.name(), attribute.scalar().value());
+        break;
+      case Value::RANGES:
+        writer->field(attribute.name(), stringify(attribute.ranges()));
+        break;
+      case Value::SET:
+        writer->field(attribute.name(), stringify(attribute.set()));
+        break;
+      case Value::TEXT:
+        writer->field(attribute.name(), attribute.text().value());
+        break;
+      default:
+        LOG(FATAL) << "Unexpected Value type: " << attribute.type();
+        break;
+    }
+  }
+}
+
+
+void json(JSON::ObjectWriter* writer, const CommandInfo& command)
+{
+  if (command.has_shell()) {
+    writer->field("shell", command.shell());
+  }
+
+  if (command.has_value()) {
+    writer->field("value", command.value());
+  }
+
+  writer->field("argv", command.arguments());
+
+  if (command.has_environment()) {
+    writer->field("environment", [&command](JSON::ObjectWriter* writer) {
+      writer->field("variables", [&command](JSON::ArrayWriter* writer) {
+        foreach (const Environment::Variable& variable,
+                 command.environment().variables()) {
+          writer->element([&variable](JSON::ObjectWriter* writer) {
+            writer->field("name", variable.name());
+            writer->field("value", variable.value());
+          });
+        }
+      });
+    });
+  }
+
+  writer->field("uris", [&command](JSON::ArrayWriter* writer) {
+    foreach (const CommandInfo::URI& uri, command.uris()) {
+      writer->element([&uri](JSON::ObjectWriter* writer) {
+        writer->field("value", uri.value());
+        writer->field("executable", uri.executable());
+      });
+    }
+  });
+}
+
+
+void json(JSON::ObjectWriter* writer, const ContainerStatus& status)
+{
+  if (status.network_infos().size() > 0) {
+    writer->field("network_infos", status.network_infos());
+  }
+}
+
+
+void json(JSON::ObjectWriter* writer, const ExecutorInfo& executorInfo)
+{
+  writer->field("executor_id", executorInfo.executor_id().value());
+  writer->field("name", executorInfo.name());
+  writer->field("framework_id", executorInfo.framework_id().value());
+  writer->field("command", executorInfo.command());
+  writer->field("resources", Resources(executorInfo.resources()));
+}
+
+
+void json(JSON::ArrayWriter* writer, const Labels& labels)
+{
+  foreach (const Label& label, labels.labels()) {
+    writer->element(JSON::protobuf(label));
+  }
+}
+
+
+void json(JSON::ObjectWriter* writer, const NetworkInfo& info)
+{
+  if (info.has_ip_address()) {
+    writer->field("ip_address", info.ip_address());
+  }
+
+  if (info.groups().size() > 0) {
+    writer->field("groups", info.groups());
+  }
+
+  if (info.has_labels()) {
+    writer->field("labels", info.labels());
+  }
+
+  if (info.ip_addresses().size() > 0) {
+    writer->field("ip_addresses", [&info](JSON::ArrayWriter* writer) {
+      foreach (const NetworkInfo::IPAddress& ipAddress, info.ip_addresses()) {
+        writer->element(JSON::protobuf(ipAddress));
+      }
+    });
+  }
+}
+
+
+void json(JSON::ObjectWriter* writer, const Offer& offer)
+{
+  writer->field("id", offer.id().value());
+  writer->field("framework_id", offer.framework_id().value());
+  writer->field("slave_id", offer.slave_id().value());
+  writer->field("resources", Resources(offer.resources()));
+}
+
+
+void json(JSON::ObjectWriter* writer, const Resources& resources)
+{
+  // Model non-revocable resources, where cpus, mem, and disk are
+  // always present.
+  const Resources nonRevocable = resources.nonRevocable();
+  const map<string, Value::Type> types = nonRevocable.types();
+
+  const vector<string> defaults = {"cpus", "mem", "disk"};
+  foreach (const string& name, defaults) {
+    if (types.count(name) == 0) {
+      writer->field(name, 0);
+    }
+  }
+
+  foreachpair (const string& name, const Value::Type& type, types) {
+    writer->field(name, internal::value(name, type, nonRevocable));
+  }
+
+  // Model revocable resources.
+  const Resources revocable = resources.revocable();
+
+  foreachpair (const string& name, const Value::Type& type, revocable.types()) {
+    writer->field(name + "_revocable", internal::value(name, type, revocable));
+  }
+}
+
+
+void json(JSON::ObjectWriter* writer, const TaskStatus& status)
+{
+  writer->field("state", TaskState_Name(status.state()));
+  writer->field("timestamp", status.timestamp());
+
+  if (status.has_labels()) {
+    writer->field("labels", status.labels());
+  }
+
+  if (status.has_container_status()) {
+    writer->field("container_status", status.container_status());
+  }
+}
+
 }  // namespace mesos {
@@ -22,8 +22,11 @@
 #include <mesos/http.hpp>
 #include <mesos/mesos.hpp>
 
+#include <process/http.hpp>
+
 #include <stout/hashmap.hpp>
 #include <stout/json.hpp>
+#include <stout/jsonify.hpp>
 #include <stout/protobuf.hpp>
 
 namespace mesos {
@@ -31,6 +34,19 @@ namespace mesos {
 class Resources;
 class Attributes;
 
+// These write the same JSON as the corresponding 'model' functions
+// below, but directly into the output (see stout/jsonify.hpp). They
+// need to be in the namespace of the type they write.
+void json(JSON::ObjectWriter* writer, const Attributes& attributes);
+void json(JSON::ObjectWriter* writer, const CommandInfo& command);
+void json(JSON::ObjectWriter* writer, const ContainerStatus& status);
+void json(JSON::ObjectWriter* writer, const ExecutorInfo& executorInfo);
+void json(JSON::ArrayWriter* writer, const Labels& labels);
+void json(JSON::ObjectWriter* writer, const NetworkInfo& info);
+void json(JSON::ObjectWriter* writer, const Offer& offer);
+void json(JSON::ObjectWriter* writer, const Resources& resources);
+void json(JSON::ObjectWriter* writer, const TaskStatus& status);
+
 namespace internal {
 
 class Task;
@@ -43,6 +59,20 @@ std::string serialize(
     const google::protobuf::Message& message);
 
 
+// Returns whether the request asks for a protobuf response, i.e.,
+// whether its 'Accept' header names 'application/x-protobuf' (e.g.,
+// "Accept: application/x-protobuf, application/json"). We default to
+// JSON otherwise, since a request without an 'Accept' header accepts
+// all media types.
+bool acceptsProtobuf(const process::http::Request& request);
+
+
+// Returns a 200 OK response with the message serialized as protobuf,
+// which is considerably cheaper to render, and to parse, than JSON.
+process::http::Response protobufResponse(
+    const google::protobuf::Message& message);
+
+
 // Deserializes a string message into a protobuf message based on the
 // HTTP content type.
 template <typename Message>
@@ -59,12 +89,12 @@ Try<Message> deserialize(
       return message;
     }
     case ContentType::JSON: {
-      Try<JSON::Value> value = JSON::parse(body);
-      if (value.isError()) {
-        return Error("Failed to parse body into JSON: " + value.error());
+      Try<Message> message = ::protobuf::parse<Message>(body);
+      if (message.isError()) {
+        return Error("Failed to parse body into JSON: " + message.error());
       }
 
-      return ::protobuf::parse<Message>(value.get());
+      return message;
     }
   }
 
@@ -89,6 +119,14 @@ JSON::Object model(
     const TaskState& state,
     const std::vector<TaskStatus>& statuses);
 
+void json(JSON::ObjectWriter* writer, const Task& task);
+void json(
+    JSON::ObjectWriter* writer,
+    const TaskInfo& task,
+    const FrameworkID& frameworkId,
+    const TaskState& state,
+    const std::vector<TaskStatus>& statuses);
+
 } // namespace internal {
 } // namespace mesos {
 
@@ -0,0 +1,141 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __COMMON_INTERNER_HPP__
+#define __COMMON_INTERNER_HPP__
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+
+namespace mesos {
+namespace internal {
+
+// Keeps a single copy of each distinct protobuf message of type 'T'
+// that is in use, so that identical messages (e.g., the ExecutorInfo
+// of the same executor on many slaves) share their memory. Messages
+// are hashed and compared by their serialization. The interner only
+// holds weak references: a message is freed once its last user drops
+// it, and the interner forgets it at the next purge.
+//
+// NOTE: Interned messages are shared and must not be modified, hence
+// they are handed out as pointers to const.
+template <typename T>
+class Interner
+{
+public:
+  Interner() : entries(0), threshold(MIN_PURGE_THRESHOLD) {}
+
+  // Returns the interned message with the same content as 't',
+  // interning a copy of 't' if there is none.
+  std::shared_ptr<const T> intern(const T& t)
+  {
+    const std::string data = t.SerializePartialAsString();
+
+    std::vector<std::weak_ptr<const T>>& bucket =
+      messages[std::hash<std::string>()(data)];
+
+    foreach (const std::weak_ptr<const T>& message, bucket) {
+      std::shared_ptr<const T> interned = message.lock();
+
+      if (interned && interned->SerializePartialAsString() == data) {
+        return interned;
+      }
+    }
+
+    std::shared_ptr<const T> interned(new T(t));
+    bucket.push_back(interned);
+
+    // We drop the references to freed messages once the entries have
+    // doubled since the last purge, which amortizes the purges over
+    // the calls.
+    if (++entries > threshold) {
+      purge();
+    }
+
+    return interned;
+  }
+
+  // Returns the number of distinct messages in use.
+  size_t size() const
+  {
+    size_t size = 0;
+
+    foreachvalue (const std::vector<std::weak_ptr<const T>>& bucket,
+                  messages) {
+      foreach (const std::weak_ptr<const T>& message, bucket) {
+        if (!message.expired()) {
+          ++size;
+        }
+      }
+    }
+
+    return size;
+  }
+
+private:
+  static const size_t MIN_PURGE_THRESHOLD = 1024;
+
+  void purge()
+  {
+    entries = 0;
+
+    auto iterator = messages.begin();
+    while (iterator != messages.end()) {
+      std::vector<std::weak_ptr<const T>>& bucket = iterator->second;
+
+      bucket.erase(
+          std::remove_if(
+              bucket.begin(),
+              bucket.end(),
+              [](const std::weak_ptr<const T>& message) {
+                return message.expired();
+              }),
+          bucket.end());
+
+      entries += bucket.size();
+
+      if (bucket.empty()) {
+        iterator = messages.erase(iterator);
+      } else {
+        ++iterator;
+      }
+    }
+
+    threshold = 2 * entries > MIN_PURGE_THRESHOLD
+      ? 2 * entries
+      : MIN_PURGE_THRESHOLD;
+  }
+
+  // The interned messages by the hash of their serialization.
+  hashmap<size_t, std::vector<std::weak_ptr<const T>>> messages;
+
+  // The number of entries in 'messages', including freed messages.
+  size_t entries;
+
+  // The number of entries at which we purge the freed messages.
+  size_t threshold;
+};
+
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __COMMON_INTERNER_HPP__
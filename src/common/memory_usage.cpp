@@ -0,0 +1,85 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef ENABLE_JEMALLOC
+#include <jemalloc/jemalloc.h>
+#elif defined(__linux__)
+// NOTE: Not guarded by '__GLIBC__', which is only defined once a libc
+// header has been included.
+#include <malloc.h>
+#endif
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <stout/foreach.hpp>
+
+#include "common/memory_usage.hpp"
+
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+
+JSON::Object model(const MemoryUsage& usage)
+{
+  JSON::Object object;
+  object.values["count"] = usage.count;
+  object.values["bytes"] = usage.bytes;
+  return object;
+}
+
+
+JSON::Object mallocStatistics()
+{
+  JSON::Object object;
+
+#ifdef ENABLE_JEMALLOC
+  object.values["allocator"] = "jemalloc";
+
+  // Refresh the statistics first.
+  uint64_t epoch = 1;
+  size_t length = sizeof(epoch);
+  mallctl("epoch", &epoch, &length, &epoch, length);
+
+  foreach (const string& name,
+           vector<string>({"allocated", "active", "resident", "mapped"})) {
+    size_t value = 0;
+    length = sizeof(value);
+    if (mallctl(("stats." + name).c_str(), &value, &length, NULL, 0) == 0) {
+      object.values[name + "_bytes"] = value;
+    }
+  }
+#elif defined(__GLIBC__) && \
+  (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  // NOTE: We use 'mallinfo2' since the fields of 'mallinfo' are
+  // 'int's which overflow beyond 2GB.
+  const struct mallinfo2 info = mallinfo2();
+
+  object.values["allocator"] = "glibc";
+  object.values["allocated_bytes"] = info.uordblks + info.hblkhd;
+  object.values["free_bytes"] = info.fordblks;
+  object.values["mapped_bytes"] = info.arena + info.hblkhd;
+#endif
+
+  return object;
+}
+
+} // namespace internal {
+} // namespace mesos {
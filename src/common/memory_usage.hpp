@@ -0,0 +1,66 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __COMMON_MEMORY_USAGE_HPP__
+#define __COMMON_MEMORY_USAGE_HPP__
+
+#include <stddef.h>
+
+#include <google/protobuf/message.h>
+
+#include <stout/json.hpp>
+
+namespace mesos {
+namespace internal {
+
+// The approximate memory used by a number of objects of the same
+// kind, as reported by the '/memory' endpoints of the master and the
+// slave. The bytes of protobuf messages are their 'SpaceUsed()',
+// i.e., they include the sub-messages and strings they own.
+struct MemoryUsage
+{
+  MemoryUsage() : count(0), bytes(0) {}
+
+  // Accounts for an object of 'size' bytes.
+  void add(size_t size)
+  {
+    ++count;
+    bytes += size;
+  }
+
+  // Accounts for an object of 'size' bytes which keeps 'message'.
+  void add(const google::protobuf::Message& message, size_t size = 0)
+  {
+    add(message.SpaceUsed() + size);
+  }
+
+  size_t count;
+  size_t bytes;
+};
+
+
+JSON::Object model(const MemoryUsage& usage);
+
+
+// Returns the statistics of the memory allocator of the process
+// (e.g., the bytes allocated by jemalloc when built with
+// '--enable-jemalloc'), or an empty object if they are not available.
+JSON::Object mallocStatistics();
+
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __COMMON_MEMORY_USAGE_HPP__
@@ -33,11 +33,6 @@
 #include <stout/protobuf.hpp>
 #include <stout/strings.hpp>
 
-// TODO(bernd-mesos): Remove this interim dependency in the course of
-// solving MESOS-3997.
-#include <master/constants.hpp>
-
-
 using std::map;
 using std::ostream;
 using std::set;
@@ -46,8 +41,6 @@ using std::vector;
 
 using google::protobuf::RepeatedPtrField;
 
-using mesos::internal::master::MIN_CPUS;
-
 
 namespace mesos {
 
@@ -71,6 +64,42 @@ bool operator!=(
 }
 
 
+bool operator==(
+    const Resource::DiskInfo::Source& left,
+    const Resource::DiskInfo::Source& right)
+{
+  if (left.type() != right.type()) {
+    return false;
+  }
+
+  if (left.has_path() != right.has_path()) {
+    return false;
+  }
+
+  if (left.has_path() && left.path().root() != right.path().root()) {
+    return false;
+  }
+
+  if (left.has_mount() != right.has_mount()) {
+    return false;
+  }
+
+  if (left.has_mount() && left.mount().root() != right.mount().root()) {
+    return false;
+  }
+
+  return true;
+}
+
+
+bool operator!=(
+    const Resource::DiskInfo::Source& left,
+    const Resource::DiskInfo::Source& right)
+{
+  return !(left == right);
+}
+
+
 bool operator==(const Resource::DiskInfo& left, const Resource::DiskInfo& right)
 {
   // NOTE: We ignore 'volume' inside DiskInfo when doing comparison
@@ -78,6 +107,14 @@ bool operator==(const Resource::DiskInfo& left, const Resource::DiskInfo& right)
   // nothing to do with the Resource object itself. A framework can
   // use this resource and specify different 'volume' every time it
   // uses it.
+  if (left.has_source() != right.has_source()) {
+    return false;
+  }
+
+  if (left.has_source() && left.source() != right.source()) {
+    return false;
+  }
+
   if (left.has_persistence() != right.has_persistence()) {
     return false;
   }
@@ -97,8 +134,8 @@ bool operator!=(const Resource::DiskInfo& left, const Resource::DiskInfo& right)
 
 bool operator==(const Resource& left, const Resource& right)
 {
-  if (left.name() != right.name() ||
-      left.type() != right.type() ||
+  if (left.type() != right.type() ||
+      left.name() != right.name() ||
       left.role() != right.role()) {
     return false;
   }
@@ -151,8 +188,8 @@ namespace internal {
 // different name, type or role are not addable.
 static bool addable(const Resource& left, const Resource& right)
 {
-  if (left.name() != right.name() ||
-      left.type() != right.type() ||
+  if (left.type() != right.type() ||
+      left.name() != right.name() ||
       left.role() != right.role()) {
     return false;
   }
@@ -183,6 +220,14 @@ static bool addable(const Resource& left, const Resource& right)
     return false;
   }
 
+  // A MOUNT disk is a whole filesystem of its own, two of them cannot
+  // be added together.
+  if (left.has_disk() &&
+      left.disk().has_source() &&
+      left.disk().source().type() == Resource::DiskInfo::Source::MOUNT) {
+    return false;
+  }
+
   // Check RevocableInfo.
   if (left.has_revocable() != right.has_revocable()) {
     return false;
@@ -202,8 +247,8 @@ static bool addable(const Resource& left, const Resource& right)
 // contain "right".
 static bool subtractable(const Resource& left, const Resource& right)
 {
-  if (left.name() != right.name() ||
-      left.type() != right.type() ||
+  if (left.type() != right.type() ||
+      left.name() != right.name() ||
       left.role() != right.role()) {
     return false;
   }
@@ -232,6 +277,14 @@ static bool subtractable(const Resource& left, const Resource& right)
     return false;
   }
 
+  // A MOUNT disk cannot be split, it is only used as a whole.
+  if (left.has_disk() &&
+      left.disk().has_source() &&
+      left.disk().source().type() == Resource::DiskInfo::Source::MOUNT &&
+      left != right) {
+    return false;
+  }
+
   // Check RevocableInfo.
   if (left.has_revocable() != right.has_revocable()) {
     return false;
@@ -594,6 +647,26 @@ Option<Error> Resources::validate(const Resource& resource)
         "DiskInfo should not be set for " + resource.name() + " resource");
   }
 
+  if (resource.has_disk() && resource.disk().has_source()) {
+    const Resource::DiskInfo::Source& source = resource.disk().source();
+
+    switch (source.type()) {
+      case Resource::DiskInfo::Source::PATH:
+        if (!source.has_path() || source.has_mount()) {
+          return Error("DiskInfo::Source of type PATH needs 'path' only");
+        }
+        break;
+      case Resource::DiskInfo::Source::MOUNT:
+        if (!source.has_mount() || source.has_path()) {
+          return Error("DiskInfo::Source of type MOUNT needs 'mount' only");
+        }
+        break;
+      default:
+        return Error(
+            "Unsupported DiskInfo::Source type " + stringify(source.type()));
+    }
+  }
+
   // Checks for the invalid state of (role, reservation) pair.
   if (resource.role() == "*" && resource.has_reservation()) {
     return Error(
@@ -703,14 +776,14 @@ bool Resources::contains(const Resources& that) const
   Resources remaining = *this;
 
   foreach (const Resource& resource, that.resources) {
-    // NOTE: We use _contains because Resources only contain valid
-    // Resource objects, and we don't want the performance hit of the
-    // validity check.
+    // NOTE: We use _contains and subtract because Resources only
+    // contain valid Resource objects, and we don't want the
+    // performance hit of the validity check.
     if (!remaining._contains(resource)) {
       return false;
     }
 
-    remaining -= resource;
+    remaining.subtract(resource);
   }
 
   return true;
@@ -732,7 +805,7 @@ Resources Resources::filter(
   Resources result;
   foreach (const Resource& resource, resources) {
     if (predicate(resource)) {
-      result += resource;
+      result.add(resource);
     }
   }
   return result;
@@ -745,7 +818,7 @@ hashmap<string, Resources> Resources::reserved() const
 
   foreach (const Resource& resource, resources) {
     if (isReserved(resource)) {
-      result[resource.role()] += resource;
+      result[resource.role()].add(resource);
     }
   }
 
@@ -897,14 +970,21 @@ Try<Resources> Resources::apply(const Offer::Operation& operation) const
           return Error("Invalid CREATE Operation: Missing 'persistence'");
         }
 
-        // Strip the disk info so that we can subtract it from the
-        // original resources.
+        // Strip the persistence and the volume from the disk info so
+        // that we can subtract it from the original resources. The
+        // source of the disk is kept.
         // TODO(jieyu): Non-persistent volumes are not supported for
         // now. Persistent volumes can only be be created from regular
         // disk resources. Revisit this once we start to support
         // non-persistent volumes.
         Resource stripped = volume;
-        stripped.clear_disk();
+
+        if (stripped.disk().has_source()) {
+          stripped.mutable_disk()->clear_persistence();
+          stripped.mutable_disk()->clear_volume();
+        } else {
+          stripped.clear_disk();
+        }
 
         if (!result.contains(stripped)) {
           return Error("Invalid CREATE Operation: Insufficient disk resources");
@@ -935,7 +1015,13 @@ Try<Resources> Resources::apply(const Offer::Operation& operation) const
         }
 
         Resource stripped = volume;
-        stripped.clear_disk();
+
+        if (stripped.disk().has_source()) {
+          stripped.mutable_disk()->clear_persistence();
+          stripped.mutable_disk()->clear_volume();
+        } else {
+          stripped.clear_disk();
+        }
 
         result -= volume;
         result += stripped;
@@ -947,25 +1033,18 @@ Try<Resources> Resources::apply(const Offer::Operation& operation) const
       return Error("Unknown offer operation " + stringify(operation.type()));
   }
 
-  // The following are sanity checks to ensure the amount of each type of
+  // This is a sanity check to ensure the amount of each type of
   // resource does not change.
   // TODO(jieyu): Currently, we only check known resource types like
   // cpus, mem, disk, ports, etc. We should generalize this.
-
-  CHECK(result.mem() == mem() &&
+  // NOTE: The scalars can be compared exactly since their arithmetic
+  // is done in fixed point (see src/common/values.cpp), which is what
+  // fixed MESOS-3552.
+  CHECK(result.cpus() == cpus() &&
+        result.mem() == mem() &&
         result.disk() == disk() &&
         result.ports() == ports());
 
-  // This comparison is an interim fix - see MESOS-3552. We are making it
-  // reasonably certain that almost equal values are correctly regarded as
-  // equal. Small, usually acceptable, differences occur due to numeric
-  // operations such as unparsing and then parsing a floating point number.
-  // TODO(bernd-mesos): Of course, they might also accumulate, so we need a
-  // better long-term fix. Apply one here when solving MESOS-3997.
-  CHECK_NEAR(result.cpus().isNone() ? 0.0 : result.cpus().get(),
-             cpus().isNone()? 0.0 : cpus().get(),
-             MIN_CPUS);
-
   return result;
 }
 
@@ -1145,6 +1224,41 @@ bool Resources::_contains(const Resource& that) const
 }
 
 
+void Resources::add(const Resource& that)
+{
+  foreach (Resource& resource, resources) {
+    if (internal::addable(resource, that)) {
+      resource += that;
+      return;
+    }
+  }
+
+  // Cannot be combined with any existing Resource object.
+  resources.Add()->CopyFrom(that);
+}
+
+
+void Resources::subtract(const Resource& that)
+{
+  for (int i = 0; i < resources.size(); i++) {
+    Resource* resource = resources.Mutable(i);
+
+    if (internal::subtractable(*resource, that)) {
+      *resource -= that;
+
+      // Remove the resource if it becomes invalid or zero. We need
+      // to do the validation because we want to strip negative
+      // scalar Resource object.
+      if (validate(*resource).isSome() || isEmpty(*resource)) {
+        resources.DeleteSubrange(i, 1);
+      }
+
+      break;
+    }
+  }
+}
+
+
 Option<Resources> Resources::find(const Resource& target) const
 {
   Resources found;
@@ -1225,19 +1339,7 @@ Resources Resources::operator+(const Resources& that) const
 Resources& Resources::operator+=(const Resource& that)
 {
   if (validate(that).isNone() && !isEmpty(that)) {
-    bool found = false;
-    foreach (Resource& resource, resources) {
-      if (internal::addable(resource, that)) {
-        resource += that;
-        found = true;
-        break;
-      }
-    }
-
-    // Cannot be combined with any existing Resource object.
-    if (!found) {
-      resources.Add()->CopyFrom(that);
-    }
+    add(that);
   }
 
   return *this;
@@ -1247,7 +1349,7 @@ Resources& Resources::operator+=(const Resource& that)
 Resources& Resources::operator+=(const Resources& that)
 {
   foreach (const Resource& resource, that.resources) {
-    *this += resource;
+    add(resource);
   }
 
   return *this;
@@ -1273,22 +1375,7 @@ Resources Resources::operator-(const Resources& that) const
 Resources& Resources::operator-=(const Resource& that)
 {
   if (validate(that).isNone() && !isEmpty(that)) {
-    for (int i = 0; i < resources.size(); i++) {
-      Resource* resource = resources.Mutable(i);
-
-      if (internal::subtractable(*resource, that)) {
-        *resource -= that;
-
-        // Remove the resource if it becomes invalid or zero. We need
-        // to do the validation because we want to strip negative
-        // scalar Resource object.
-        if (validate(*resource).isSome() || isEmpty(*resource)) {
-          resources.DeleteSubrange(i, 1);
-        }
-
-        break;
-      }
-    }
+    subtract(that);
   }
 
   return *this;
@@ -1298,7 +1385,7 @@ Resources& Resources::operator-=(const Resource& that)
 Resources& Resources::operator-=(const Resources& that)
 {
   foreach (const Resource& resource, that.resources) {
-    *this -= resource;
+    subtract(resource);
   }
 
   return *this;
@@ -1331,6 +1418,21 @@ ostream& operator<<(ostream& stream, const Volume& volume)
 
 ostream& operator<<(ostream& stream, const Resource::DiskInfo& disk)
 {
+  if (disk.has_source()) {
+    switch (disk.source().type()) {
+      case Resource::DiskInfo::Source::PATH:
+        stream << "PATH:" << disk.source().path().root();
+        break;
+      case Resource::DiskInfo::Source::MOUNT:
+        stream << "MOUNT:" << disk.source().mount().root();
+        break;
+    }
+
+    if (disk.has_persistence()) {
+      stream << ",";
+    }
+  }
+
   if (disk.has_persistence()) {
     stream << disk.persistence().id();
   }
@@ -58,7 +58,12 @@ Try<Resources> applyCheckpointedResources(
     }
 
     if (Resources::isPersistentVolume(resource)) {
-      stripped.clear_disk();
+      if (stripped.disk().has_source()) {
+        stripped.mutable_disk()->clear_persistence();
+        stripped.mutable_disk()->clear_volume();
+      } else {
+        stripped.clear_disk();
+      }
     }
 
     if (!totalResources.contains(stripped)) {
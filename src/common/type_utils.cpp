@@ -360,4 +360,18 @@ bool operator!=(const TaskStatus& left, const TaskStatus& right)
   return !(left == right);
 }
 
+
+bool operator==(const Unavailability& left, const Unavailability& right)
+{
+  return left.start() == right.start() &&
+    left.has_duration() == right.has_duration() &&
+    left.duration() == right.duration();
+}
+
+
+bool operator!=(const Unavailability& left, const Unavailability& right)
+{
+  return !(left == right);
+}
+
 } // namespace mesos {
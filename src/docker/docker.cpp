@@ -14,6 +14,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <map>
 #include <vector>
 
@@ -45,6 +46,8 @@ using namespace mesos;
 
 using namespace mesos::internal::slave;
 
+using mesos::internal::docker::Engine;
+
 using namespace process;
 
 using std::list;
@@ -93,6 +96,18 @@ static Future<Nothing> checkError(const string& cmd, const Subprocess& s)
     .then(lambda::bind(_checkError, cmd, s));
 }
 
+Option<Engine> Docker::createEngine(const string& socket)
+{
+  Try<Engine> engine = Engine::create(socket);
+  if (engine.isError()) {
+    LOG(WARNING) << "Using only the docker CLI: " << engine.error();
+    return None();
+  }
+
+  return engine.get();
+}
+
+
 Try<Docker*> Docker::create(
     const string& path,
     const string& socket,
@@ -365,8 +380,8 @@ Future<Nothing> Docker::run(
     const string& mappedDirectory,
     const Option<Resources>& resources,
     const Option<map<string, string>>& env,
-    const Option<string>& stdoutPath,
-    const Option<string>& stderrPath) const
+    const Subprocess::IO& _stdout,
+    const Subprocess::IO& _stderr) const
 {
   if (!containerInfo.has_docker()) {
     return Failure("No docker info found in container info");
@@ -577,22 +592,12 @@ Future<Nothing> Docker::run(
   // URI downloads.
   environment["HOME"] = sandboxDirectory;
 
-  Subprocess::IO stdoutIo = Subprocess::PIPE();
-  Subprocess::IO stderrIo = Subprocess::PIPE();
-  if (stdoutPath.isSome()) {
-    stdoutIo = Subprocess::PATH(stdoutPath.get());
-  }
-
-  if (stderrPath.isSome()) {
-    stderrIo = Subprocess::PATH(stderrPath.get());
-  }
-
   Try<Subprocess> s = subprocess(
       path,
       argv,
       Subprocess::PATH("/dev/null"),
-      stdoutIo,
-      stderrIo,
+      _stdout,
+      _stderr,
       None(),
       environment);
 
@@ -709,12 +714,143 @@ Future<Docker::Container> Docker::inspect(
   Owned<Promise<Docker::Container>> promise(new Promise<Docker::Container>());
 
   const string cmd =  path + " -H " + socket + " inspect " + containerName;
-  _inspect(cmd, promise, retryInterval);
+
+  if (engine.isSome()) {
+    inspectEngine(*this, containerName, cmd, promise, retryInterval);
+  } else {
+    _inspect(cmd, promise, retryInterval);
+  }
 
   return promise->future();
 }
 
 
+void Docker::inspectEngine(
+    const Docker& docker,
+    const string& containerName,
+    const string& cmd,
+    const Owned<Promise<Docker::Container>>& promise,
+    const Option<Duration>& retryInterval)
+{
+  CHECK_SOME(docker.engine);
+
+  if (retryInterval.isNone()) {
+    docker.engine->get("/containers/" + containerName + "/json")
+      .onAny([=](const Future<string>& output) {
+        if (!output.isReady()) {
+          VLOG(1) << "Falling back to '" << cmd << "' after failing to "
+                  << "inspect through the Engine API: "
+                  << (output.isFailed() ? output.failure() : "discarded");
+
+          _inspect(cmd, promise, retryInterval);
+          return;
+        }
+
+        // The Engine API returns the object that the CLI wraps in an
+        // array.
+        ___inspect(cmd, promise, retryInterval, "[" + output.get() + "]");
+      });
+
+    return;
+  }
+
+  // Subscribe to the events of the container before inspecting it, so
+  // that its start can not be missed in between.
+  JSON::Array containers;
+  containers.values.push_back(containerName);
+
+  JSON::Array types;
+  types.values.push_back("start");
+
+  JSON::Object filters;
+  filters.values["container"] = containers;
+  filters.values["event"] = types;
+
+  docker.engine->events(filters)
+    .onAny([=](const Future<Engine::Events>& events) {
+      if (!events.isReady()) {
+        VLOG(1) << "Falling back to polling '" << cmd << "' after failing "
+                << "to subscribe to the events of the Engine API: "
+                << (events.isFailed() ? events.failure() : "discarded");
+
+        _inspect(cmd, promise, retryInterval);
+        return;
+      }
+
+      // Ending the subscription fails a pending wait for an event.
+      Engine::Events events_ = events.get();
+      promise->future().onDiscard([events_]() mutable { events_.close(); });
+
+      _inspectEngine(docker, containerName, cmd, promise, retryInterval,
+                     events.get());
+    });
+}
+
+
+void Docker::_inspectEngine(
+    const Docker& docker,
+    const string& containerName,
+    const string& cmd,
+    const Owned<Promise<Docker::Container>>& promise,
+    const Option<Duration>& retryInterval,
+    Engine::Events events)
+{
+  if (promise->future().hasDiscard()) {
+    promise->discard();
+    return;
+  }
+
+  CHECK_SOME(docker.engine);
+
+  docker.engine->get("/containers/" + containerName + "/json")
+    .onAny([=](const Future<string>& output) mutable {
+      if (promise->future().hasDiscard()) {
+        promise->discard();
+        return;
+      }
+
+      if (output.isReady()) {
+        Try<Docker::Container> container =
+          Docker::Container::create("[" + output.get() + "]");
+
+        if (container.isError()) {
+          promise->fail("Unable to create container: " + container.error());
+          return;
+        }
+
+        if (container.get().started) {
+          promise->set(container.get());
+          return;
+        }
+      }
+
+      // The container does not exist or did not start yet, so inspect
+      // it again once the daemon reports its start.
+      VLOG(1) << "Waiting for an event of container '" << containerName
+              << "' to inspect it again";
+
+      events.next()
+        .onAny([=](const Future<Nothing>& next) {
+          if (promise->future().hasDiscard()) {
+            promise->discard();
+            return;
+          }
+
+          if (!next.isReady()) {
+            VLOG(1) << "Falling back to polling '" << cmd << "': "
+                    << (next.isFailed() ? next.failure() : "discarded");
+
+            _inspect(cmd, promise, retryInterval);
+            return;
+          }
+
+          _inspectEngine(
+              docker, containerName, cmd, promise, retryInterval, events);
+        });
+    });
+}
+
+
 void Docker::_inspect(
     const string& cmd,
     const Owned<Promise<Docker::Container>>& promise,
@@ -841,6 +977,96 @@ void Docker::___inspect(
 Future<list<Docker::Container>> Docker::ps(
     bool all,
     const Option<string>& prefix) const
+{
+  if (engine.isSome()) {
+    const Docker docker = *this;
+
+    return psEngine(*this, all, prefix)
+      .repair([=](const Future<list<Docker::Container>>& ps) {
+        VLOG(1) << "Falling back to 'docker ps' after failing to list the "
+                << "containers through the Engine API: " << ps.failure();
+
+        return docker.psCLI(all, prefix);
+      });
+  }
+
+  return psCLI(all, prefix);
+}
+
+
+Future<list<Docker::Container>> Docker::psEngine(
+    const Docker& docker,
+    bool all,
+    const Option<string>& prefix)
+{
+  CHECK_SOME(docker.engine);
+
+  hashmap<string, string> query;
+  if (all) {
+    query["all"] = "1";
+  }
+
+  return docker.engine->get("/containers/json", query)
+    .then([docker, prefix](const string& output)
+        -> Future<list<Docker::Container>> {
+      Try<JSON::Array> parse = JSON::parse<JSON::Array>(output);
+      if (parse.isError()) {
+        return Failure("Failed to parse JSON: " + parse.error());
+      }
+
+      // All of the inspects are pipelined over the persistent
+      // connection rather than forked as 'docker inspect' processes.
+      vector<Future<string>> inspects;
+
+      foreach (const JSON::Value& value, parse.get().values) {
+        if (!value.is<JSON::Object>()) {
+          return Failure("Unexpected JSON value: " + stringify(value));
+        }
+
+        Result<JSON::Array> names =
+          value.as<JSON::Object>().find<JSON::Array>("Names");
+
+        if (!names.isSome() || names.get().values.empty() ||
+            !names.get().values.front().is<JSON::String>()) {
+          return Failure("Unable to find Names in container");
+        }
+
+        // Unlike in the output of the CLI, the names start with a '/'.
+        string name = names.get().values.front().as<JSON::String>().value;
+        name = strings::remove(name, "/", strings::PREFIX);
+
+        if (prefix.isNone() || strings::startsWith(name, prefix.get())) {
+          inspects.push_back(
+              docker.engine->get("/containers/" + name + "/json"));
+        }
+      }
+
+      return collect(inspects)
+        .then([](const vector<string>& outputs)
+            -> Future<list<Docker::Container>> {
+          list<Docker::Container> containers;
+
+          foreach (const string& output, outputs) {
+            Try<Docker::Container> container =
+              Docker::Container::create("[" + output + "]");
+
+            if (container.isError()) {
+              return Failure(
+                  "Unable to create container: " + container.error());
+            }
+
+            containers.push_back(container.get());
+          }
+
+          return containers;
+        });
+    });
+}
+
+
+Future<list<Docker::Container>> Docker::psCLI(
+    bool all,
+    const Option<string>& prefix) const
 {
   string cmd = path + " -H " + socket + (all ? " ps -a" : " ps");
 
@@ -899,83 +1125,162 @@ Future<list<Docker::Container>> Docker::__ps(
     const Option<string>& prefix,
     const string& output)
 {
-  Owned<vector<string>> lines(new vector<string>());
-  *lines = strings::tokenize(output, "\n");
+  vector<string> lines = strings::tokenize(output, "\n");
 
   // Skip the header.
-  CHECK(!lines->empty());
-  lines->erase(lines->begin());
+  CHECK(!lines.empty());
+  lines.erase(lines.begin());
+
+  // Inspect the containers that we are interested in depending on
+  // whether or not a 'prefix' was specified.
+  Owned<vector<string>> names(new vector<string>());
+
+  foreach (const string& line, lines) {
+    vector<string> columns = strings::split(strings::trim(line), " ");
+
+    // We expect the name column to be the last column from ps.
+    string name = columns[columns.size() - 1];
+    if (prefix.isNone() || strings::startsWith(name, prefix.get())) {
+      names->push_back(name);
+    }
+  }
 
   Owned<list<Docker::Container>> containers(new list<Docker::Container>());
 
   Owned<Promise<list<Docker::Container>>> promise(
     new Promise<list<Docker::Container>>());
 
-  // Limit number of parallel calls to docker inspect at once to prevent
-  // reaching system's open file descriptor limit.
-  inspectBatches(containers, lines, promise, docker, prefix);
+  // Inspect the containers in batches rather than with a 'docker
+  // inspect' per container, so that a large number of containers
+  // doesn't fork as many processes.
+  inspectBatches(containers, names, promise, docker);
 
   return promise->future();
 }
 
-// TODO(chenlily): Generalize functionality into a concurrency limiter
-// within libprocess.
+
 void Docker::inspectBatches(
     Owned<list<Docker::Container>> containers,
-    Owned<vector<string>> lines,
+    Owned<vector<string>> names,
     Owned<Promise<list<Docker::Container>>> promise,
-    const Docker& docker,
-    const Option<string>& prefix)
+    const Docker& docker)
 {
-  list<Future<Docker::Container>> batch =
-    createInspectBatch(lines, docker, prefix);
+  if (names->empty()) {
+    promise->set(*containers);
+    return;
+  }
 
-  collect(batch).onAny([=](const Future<list<Docker::Container>>& c) {
-    if (c.isReady()) {
-      foreach (const Docker::Container& container, c.get()) {
-        containers->push_back(container);
-      }
-      if (lines->empty()) {
-        promise->set(*containers);
-      }
-      else {
-        inspectBatches(containers, lines, promise, docker, prefix);
-      }
-    } else {
-      if (c.isFailed()) {
+  const size_t size = std::min(names->size(), DOCKER_PS_MAX_INSPECT_CONTAINERS);
+
+  const vector<string> batch(names->end() - size, names->end());
+  names->erase(names->end() - size, names->end());
+
+  inspectBatch(docker, batch)
+    .onAny([=](const Future<list<Docker::Container>>& c) {
+      if (c.isReady()) {
+        foreach (const Docker::Container& container, c.get()) {
+          containers->push_back(container);
+        }
+        inspectBatches(containers, names, promise, docker);
+      } else if (c.isFailed()) {
         promise->fail("Docker ps batch failed " + c.failure());
-      }
-      else {
+      } else {
         promise->fail("Docker ps batch discarded");
       }
-    }
-  });
+    });
 }
 
 
-list<Future<Docker::Container>> Docker::createInspectBatch(
-    Owned<vector<string>> lines,
+Future<list<Docker::Container>> Docker::inspectBatch(
     const Docker& docker,
-    const Option<string>& prefix)
+    const vector<string>& names)
 {
-  list<Future<Docker::Container>> batch;
+  vector<string> argv;
+  argv.push_back(docker.path);
+  argv.push_back("-H");
+  argv.push_back(docker.socket);
+  argv.push_back("inspect");
+  argv.insert(argv.end(), names.begin(), names.end());
 
-  while (!lines->empty() && batch.size() < DOCKER_PS_MAX_INSPECT_CALLS) {
-    string line = lines->back();
-    lines->pop_back();
+  const string cmd = strings::join(" ", argv);
 
-    // Inspect the containers that we are interested in depending on
-    // whether or not a 'prefix' was specified.
-    vector<string> columns = strings::split(strings::trim(line), " ");
+  VLOG(1) << "Running " << cmd;
 
-    // We expect the name column to be the last column from ps.
-    string name = columns[columns.size() - 1];
-    if (prefix.isNone() || strings::startsWith(name, prefix.get())) {
-      batch.push_back(docker.inspect(name));
+  Try<Subprocess> s = subprocess(
+      docker.path,
+      argv,
+      Subprocess::PATH("/dev/null"),
+      Subprocess::PIPE(),
+      Subprocess::PIPE(),
+      None());
+
+  if (s.isError()) {
+    return Failure("Failed to execute '" + cmd + "': " + s.error());
+  }
+
+  // Start reading from stdout so writing to the pipe won't block
+  // to handle cases where the output is larger than the pipe
+  // capacity.
+  const Future<string> output = io::read(s.get().out().get());
+
+  return s.get().status()
+    .then(lambda::bind(&Docker::_inspectBatch, cmd, s.get(), output));
+}
+
+
+Future<list<Docker::Container>> Docker::_inspectBatch(
+    const string& cmd,
+    const Subprocess& s,
+    Future<string> output)
+{
+  Option<int> status = s.status().get();
+
+  if (!status.isSome()) {
+    output.discard();
+    return Failure("No status found from '" + cmd + "'");
+  } else if (status.get() != 0) {
+    output.discard();
+    CHECK_SOME(s.err());
+    return io::read(s.err().get())
+      .then(lambda::bind(
+                failure<list<Docker::Container>>,
+                cmd,
+                status.get(),
+                lambda::_1));
+  }
+
+  // Read to EOF.
+  return output.then(lambda::bind(&Docker::__inspectBatch, lambda::_1));
+}
+
+
+Future<list<Docker::Container>> Docker::__inspectBatch(const string& output)
+{
+  Try<JSON::Array> parse = JSON::parse<JSON::Array>(output);
+  if (parse.isError()) {
+    return Failure("Failed to parse JSON: " + parse.error());
+  }
+
+  list<Docker::Container> containers;
+
+  foreach (const JSON::Value& value, parse.get().values) {
+    if (!value.is<JSON::Object>()) {
+      return Failure("Unexpected JSON value: " + stringify(value));
     }
+
+    // Keep the output of each container in the format of inspecting
+    // that container alone.
+    Try<Docker::Container> container =
+      Docker::Container::create("[" + stringify(value) + "]");
+
+    if (container.isError()) {
+      return Failure("Unable to create container: " + container.error());
+    }
+
+    containers.push_back(container.get());
   }
 
-  return batch;
+  return containers;
 }
 
 
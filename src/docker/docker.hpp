@@ -34,6 +34,8 @@
 
 #include "mesos/resources.hpp"
 
+#include "docker/engine.hpp"
+
 
 // Abstraction for working with Docker (modeled on CLI).
 //
@@ -113,8 +115,9 @@ public:
       const std::string& mappedDirectory,
       const Option<mesos::Resources>& resources = None(),
       const Option<std::map<std::string, std::string>>& env = None(),
-      const Option<std::string>& stdoutPath = None(),
-      const Option<std::string>& stderrPath = None()) const;
+      const process::Subprocess::IO& _stdout = process::Subprocess::PIPE(),
+      const process::Subprocess::IO& _stderr = process::Subprocess::PIPE())
+    const;
 
   // Returns the current docker version.
   virtual process::Future<Version> version() const;
@@ -161,12 +164,19 @@ public:
   }
 
 protected:
-  // Uses the specified path to the Docker CLI tool.
+  // Uses the specified path to the Docker CLI tool. Inspecting and
+  // listing containers use the Engine API on the socket instead, and
+  // fall back to the CLI if the daemon can not be reached that way.
   Docker(const std::string& _path,
          const std::string& _socket)
-       : path(_path), socket("unix://" + _socket) {};
+       : path(_path),
+         socket("unix://" + _socket),
+         engine(createEngine(_socket)) {};
 
 private:
+  static Option<mesos::internal::docker::Engine> createEngine(
+      const std::string& socket);
+
   static process::Future<Nothing> _run(
       const Option<int>& status);
 
@@ -202,6 +212,34 @@ private:
       const Option<Duration>& retryInterval,
       const process::Future<std::string>& output);
 
+  // Inspects the container through the Engine API. With a
+  // 'retryInterval', the container is inspected again on each of its
+  // events until it started, rather than every 'retryInterval'.
+  static void inspectEngine(
+      const Docker& docker,
+      const std::string& containerName,
+      const std::string& cmd,
+      const process::Owned<process::Promise<Container>>& promise,
+      const Option<Duration>& retryInterval);
+
+  static void _inspectEngine(
+      const Docker& docker,
+      const std::string& containerName,
+      const std::string& cmd,
+      const process::Owned<process::Promise<Container>>& promise,
+      const Option<Duration>& retryInterval,
+      mesos::internal::docker::Engine::Events events);
+
+  // Performs 'docker ps (-a)' through the CLI.
+  process::Future<std::list<Container>> psCLI(
+      bool all,
+      const Option<std::string>& prefix) const;
+
+  static process::Future<std::list<Container>> psEngine(
+      const Docker& docker,
+      bool all,
+      const Option<std::string>& prefix);
+
   static process::Future<std::list<Container>> _ps(
       const Docker& docker,
       const std::string& cmd,
@@ -216,15 +254,22 @@ private:
 
   static void inspectBatches(
       process::Owned<std::list<Docker::Container>> containers,
-      process::Owned<std::vector<std::string>> lines,
+      process::Owned<std::vector<std::string>> names,
       process::Owned<process::Promise<std::list<Docker::Container>>> promise,
-      const Docker& docker,
-      const Option<std::string>& prefix);
+      const Docker& docker);
 
-  static std::list<process::Future<Docker::Container>> createInspectBatch(
-      process::Owned<std::vector<std::string>> lines,
+  // Performs a single 'docker inspect' of all the given containers.
+  static process::Future<std::list<Docker::Container>> inspectBatch(
       const Docker& docker,
-      const Option<std::string>& prefix);
+      const std::vector<std::string>& names);
+
+  static process::Future<std::list<Docker::Container>> _inspectBatch(
+      const std::string& cmd,
+      const process::Subprocess& s,
+      process::Future<std::string> output);
+
+  static process::Future<std::list<Docker::Container>> __inspectBatch(
+      const std::string& output);
 
   static process::Future<Image> _pull(
       const Docker& docker,
@@ -258,6 +303,10 @@ private:
 
   const std::string path;
   const std::string socket;
+
+  // The Engine API client, or None if the socket path is not a valid
+  // unix domain socket path.
+  const Option<mesos::internal::docker::Engine> engine;
 };
 
 #endif // __DOCKER_HPP__
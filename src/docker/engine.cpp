@@ -0,0 +1,192 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <mutex>
+#include <string>
+
+#include <process/http.hpp>
+
+#include <stout/check.hpp>
+#include <stout/option.hpp>
+#include <stout/stringify.hpp>
+#include <stout/synchronized.hpp>
+
+#include "docker/engine.hpp"
+
+using process::Failure;
+using process::Future;
+
+using process::network::Address;
+
+using std::string;
+
+namespace http = process::http;
+
+namespace mesos {
+namespace internal {
+namespace docker {
+
+struct Engine::Data
+{
+  explicit Data(const Address& _address) : address(_address) {}
+
+  // Returns the persistent connection, after (re-)establishing it if
+  // the daemon was not connected yet or closed the connection.
+  Future<http::Connection> connect()
+  {
+    synchronized (mutex) {
+      if (connection.isNone() || !disconnected->isPending()) {
+        connection = http::connect(address);
+        disconnected = connection->then([](http::Connection connection) {
+          return connection.disconnected();
+        });
+      }
+
+      return connection.get();
+    }
+  }
+
+  const Address address;
+
+  std::mutex mutex;
+  Option<Future<http::Connection>> connection;
+
+  // Satisfied once 'connection' fails or gets disconnected.
+  Option<Future<Nothing>> disconnected;
+};
+
+
+struct Engine::Events::Data
+{
+  Data(
+      const http::Connection& _connection,
+      const http::Pipe::Reader& _reader)
+    : connection(_connection),
+      reader(_reader) {}
+
+  ~Data()
+  {
+    reader.close();
+    connection.disconnect();
+  }
+
+  http::Connection connection;
+  http::Pipe::Reader reader;
+};
+
+
+Engine::Events::Events(
+    const http::Connection& connection,
+    const http::Pipe::Reader& reader)
+  : data(new Data(connection, reader)) {}
+
+
+Future<Nothing> Engine::Events::next()
+{
+  return data->reader.read()
+    .then([](const string& events) -> Future<Nothing> {
+      if (events.empty()) {
+        return Failure("The daemon closed the event stream");
+      }
+
+      return Nothing();
+    });
+}
+
+
+void Engine::Events::close()
+{
+  data->reader.close();
+}
+
+
+Try<Engine> Engine::create(const string& socket)
+{
+  Try<Address> address = Address::create(socket);
+  if (address.isError()) {
+    return Error("Invalid docker socket: " + address.error());
+  }
+
+  return Engine(address.get());
+}
+
+
+Engine::Engine(const Address& address)
+  : data(new Data(address)) {}
+
+
+Future<string> Engine::get(
+    const string& path,
+    const hashmap<string, string>& query) const
+{
+  http::Request request;
+  request.method = "GET";
+  request.url = http::URL("http", "localhost", 80, path, query);
+  request.keepAlive = true;
+
+  return data->connect()
+    .then([request](http::Connection connection) {
+      return connection.send(request);
+    })
+    .then([path](const http::Response& response) -> Future<string> {
+      if (response.code != http::Status::OK) {
+        return Failure(
+            "Failed to GET '" + path + "': " + response.status +
+            ": " + response.body);
+      }
+
+      return response.body;
+    });
+}
+
+
+Future<Engine::Events> Engine::events(const JSON::Object& filters) const
+{
+  http::Request request;
+  request.method = "GET";
+  request.url = http::URL(
+      "http",
+      "localhost",
+      80,
+      "/events",
+      {{"filters", stringify(filters)}});
+  request.keepAlive = true;
+
+  // The streamed response occupies its connection until the
+  // subscription ends, so each subscription gets its own connection.
+  return http::connect(data->address)
+    .then([request](http::Connection connection) {
+      return connection.send(request, true)
+        .then([connection](const http::Response& response)
+            -> Future<Events> {
+          CHECK_SOME(response.reader);
+
+          http::Pipe::Reader reader = response.reader.get();
+
+          if (response.code != http::Status::OK) {
+            reader.close();
+            return Failure(
+                "Failed to subscribe to the events: " + response.status);
+          }
+
+          return Events(connection, reader);
+        });
+    });
+}
+
+} // namespace docker {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,98 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __DOCKER_ENGINE_HPP__
+#define __DOCKER_ENGINE_HPP__
+
+#include <memory>
+#include <string>
+
+#include <process/address.hpp>
+#include <process/future.hpp>
+#include <process/http.hpp>
+
+#include <stout/hashmap.hpp>
+#include <stout/json.hpp>
+#include <stout/nothing.hpp>
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace internal {
+namespace docker {
+
+// A client of the Docker Engine API that the docker daemon serves on
+// its unix domain socket. Requests are pipelined over one persistent
+// connection, which gets re-established on the next request after
+// the daemon closed it.
+class Engine
+{
+public:
+  // A subscription to the '/events' of the daemon, which ends once
+  // the last copy of it is destroyed.
+  class Events
+  {
+  public:
+    // Returns once the daemon reports more events. The events are not
+    // parsed: the subscribers only need to know that the state of the
+    // containers in their filter changed.
+    process::Future<Nothing> next();
+
+    // Ends the subscription, which fails a pending 'next'.
+    void close();
+
+  private:
+    friend class Engine;
+
+    Events(
+        const process::http::Connection& connection,
+        const process::http::Pipe::Reader& reader);
+
+    struct Data;
+
+    std::shared_ptr<Data> data;
+  };
+
+  // Returns an error if 'socket' can not be the path of a unix
+  // domain socket. The daemon is not contacted until the first
+  // request.
+  static Try<Engine> create(const std::string& socket);
+
+  // Returns the body of the response to a GET of 'path', or a failure
+  // if the daemon could not be reached or did not respond with 200 OK.
+  process::Future<std::string> get(
+      const std::string& path,
+      const hashmap<std::string, std::string>& query =
+        hashmap<std::string, std::string>()) const;
+
+  // Subscribes to the events matching 'filters', e.g.,
+  // {"container": ["mesos-..."], "event": ["start"]}. The returned
+  // future is ready once the daemon accepted the subscription, so
+  // that no later event gets missed.
+  process::Future<Events> events(const JSON::Object& filters) const;
+
+private:
+  explicit Engine(const process::network::Address& address);
+
+  struct Data;
+
+  std::shared_ptr<Data> data;
+};
+
+} // namespace docker {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __DOCKER_ENGINE_HPP__
@@ -22,6 +22,7 @@
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <vector>
 
 #include <mesos/executor.hpp>
 #include <mesos/mesos.hpp>
@@ -64,6 +65,7 @@ using namespace mesos::internal::slave;
 using namespace process;
 
 using std::string;
+using std::vector;
 
 using process::Latch;
 using process::wait; // Necessary on some OS's to disambiguate.
@@ -112,6 +114,7 @@ public:
                   const string& _directory,
                   bool _checkpoint,
                   Duration _recoveryTimeout,
+                  const Option<Duration>& _statusUpdateWindow,
                   std::recursive_mutex* _mutex,
                   Latch* _latch)
     : ProcessBase(ID::generate("executor")),
@@ -129,7 +132,8 @@ public:
       latch(_latch),
       directory(_directory),
       checkpoint(_checkpoint),
-      recoveryTimeout(_recoveryTimeout)
+      recoveryTimeout(_recoveryTimeout),
+      statusUpdateWindow(_statusUpdateWindow)
   {
     LOG(INFO) << "Version: " << MESOS_VERSION;
 
@@ -269,6 +273,9 @@ protected:
       message.add_updates()->MergeFrom(update);
     }
 
+    // These include the updates that are still to be sent.
+    batchedUpdates.clear();
+
     // Send all unacknowledged tasks.
     // TODO(vinod): Use foreachvalue instead once LinkedHashmap
     // supports it.
@@ -404,6 +411,10 @@ protected:
 
   void stop()
   {
+    // Send the updates that are still to be sent, as the executor
+    // likely expects them to be sent once it stops the driver.
+    _sendStatusUpdates();
+
     terminate(self());
 
     synchronized (mutex) {
@@ -519,9 +530,48 @@ protected:
     // Capture the status update.
     updates[uuid] = *update;
 
+    if (statusUpdateWindow.isSome()) {
+      // We send the updates of a window in one message, see
+      // '_sendStatusUpdates()'.
+      if (batchedUpdates.empty()) {
+        delay(statusUpdateWindow.get(), self(), &Self::_sendStatusUpdates);
+      }
+
+      batchedUpdates.push_back(*update);
+      return;
+    }
+
     send(slave, message);
   }
 
+  void _sendStatusUpdates()
+  {
+    if (batchedUpdates.empty()) {
+      return;
+    }
+
+    if (batchedUpdates.size() == 1) {
+      StatusUpdateMessage message;
+      message.mutable_update()->MergeFrom(batchedUpdates.front());
+      message.set_pid(self());
+
+      send(slave, message);
+    } else {
+      VLOG(1) << "Executor sending " << batchedUpdates.size()
+              << " status updates";
+
+      StatusUpdatesMessage message;
+      foreach (const StatusUpdate& update, batchedUpdates) {
+        message.add_updates()->MergeFrom(update);
+      }
+      message.set_pid(self());
+
+      send(slave, message);
+    }
+
+    batchedUpdates.clear();
+  }
+
   void sendFrameworkMessage(const string& data)
   {
     ExecutorToFrameworkMessage message;
@@ -551,8 +601,15 @@ private:
   bool checkpoint;
   Duration recoveryTimeout;
 
+  // If set, the status updates are sent in batches of the updates of
+  // this long, which the slave sets only if it handles such batches.
+  Option<Duration> statusUpdateWindow;
+
   LinkedHashMap<UUID, StatusUpdate> updates; // Unacknowledged updates.
 
+  // The updates still to be sent in the current window.
+  vector<StatusUpdate> batchedUpdates;
+
   // We store tasks that have not been acknowledged
   // (via status updates) by the slave. This ensures that, during
   // recovery, the slave relaunches only those tasks that have
@@ -701,6 +758,21 @@ Status MesosExecutorDriver::start()
       }
     }
 
+    // Get the window in which to batch the status updates, if any.
+    Option<Duration> statusUpdateWindow = None();
+
+    value = os::getenv("MESOS_STATUS_UPDATE_WINDOW");
+
+    if (value.isSome()) {
+      Try<Duration> _statusUpdateWindow = Duration::parse(value.get());
+
+      CHECK_SOME(_statusUpdateWindow)
+          << "Cannot parse MESOS_STATUS_UPDATE_WINDOW '" << value.get()
+          << "': " << _statusUpdateWindow.error();
+
+      statusUpdateWindow = _statusUpdateWindow.get();
+    }
+
     CHECK(process == NULL);
 
     process = new ExecutorProcess(
@@ -714,6 +786,7 @@ Status MesosExecutorDriver::start()
         workDirectory,
         checkpoint,
         recoveryTimeout,
+        statusUpdateWindow,
         &mutex,
         latch);
 
@@ -14,10 +14,17 @@
 // See the License for the specific language governing permissions and
 // limitations under the License
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <unistd.h>
 
 #include <sys/stat.h>
 
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif // __linux__
+
 #include <algorithm>
 #include <map>
 #include <string>
@@ -25,15 +32,20 @@
 
 #include <boost/shared_array.hpp>
 
+#include <process/collect.hpp>
+#include <process/defer.hpp>
 #include <process/deferred.hpp> // TODO(benh): This is required by Clang.
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/help.hpp>
 #include <process/http.hpp>
+#include <process/id.hpp>
 #include <process/io.hpp>
 #include <process/mime.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/error.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/json.hpp>
@@ -64,6 +76,7 @@ using process::http::BadRequest;
 using process::http::InternalServerError;
 using process::http::NotFound;
 using process::http::OK;
+using process::http::Pipe;
 using process::http::Response;
 using process::http::Request;
 
@@ -100,10 +113,38 @@ private:
   // Returns a file listing for a directory.
   // Requests have the following parameters:
   //   path: The directory to browse. Required.
+  //   offset: The index of the first entry to list. Optional.
+  //   limit: The maximum number of entries to list. Optional.
   // The response will contain a list of JSON files and directories contained
   // in the path (see files::jsonFileInfo for the format).
   Future<Response> browse(const Request& request);
 
+  // A directory listing which is being streamed.
+  struct Listing
+  {
+    Listing() : directory(NULL), index(0), empty(true) {}
+
+    ~Listing()
+    {
+      if (directory != NULL) {
+        closedir(directory);
+      }
+    }
+
+    DIR* directory;
+    string path; // The virtual path of the directory.
+    vector<string> names; // The sorted names of the entries to list.
+    size_t index; // The index of the next entry to list.
+    bool empty; // Whether no entry was listed yet.
+    Option<Pipe::Writer> writer;
+    Option<string> jsonp;
+  };
+
+  // Writes the next batch of entries of the listing, and dispatches
+  // itself for the following batch so that a huge directory does not
+  // keep the process from serving other requests.
+  void _browse(const Owned<Listing>& listing);
+
   // Reads data from a file at a given offset and for a given length.
   // See the jquery pailer for the expected behavior.
   Future<Response> read(const Request& request);
@@ -111,8 +152,16 @@ private:
   // Returns the raw file contents for a given path.
   // Requests have the following parameters:
   //   path: The directory to browse. Required.
+  //   follow: Whether to keep streaming what gets appended to the
+  //     file. Optional.
+  //   offset: The offset to start following from. Optional.
+  // Unless following, this honors 'Range' headers (see http::Response).
   Future<Response> download(const Request& request);
 
+  // Streams the file at the resolved path from the given offset and
+  // keeps streaming what gets appended to it (see FollowProcess).
+  Future<Response> follow(const string& path, off_t offset);
+
   // Returns the internal virtual path mapping.
   Future<Response> debug(const Request& request);
 
@@ -130,6 +179,193 @@ FilesProcess::FilesProcess()
 {}
 
 
+#ifdef __linux__
+// Writes the content of a file starting at the current offset of its
+// file descriptor into a pipe and keeps writing what gets appended to
+// the file (like 'tail -f') until either the reader closes the pipe
+// or the file gets removed or renamed. Uses inotify to wait for the
+// file to be modified rather than re-reading it periodically.
+class FollowProcess : public Process<FollowProcess>
+{
+public:
+  // How much of the file we buffer in the pipe for a slow reader
+  // before we wait for it to catch up, see '_read'.
+  static const size_t HIGH_WATER_MARK = 1024 * 1024;
+
+  FollowProcess(int _fd, int _inotify, const Pipe::Writer& _writer)
+    : ProcessBase(process::ID::generate("__files_follow__")),
+      fd(_fd),
+      inotify(_inotify),
+      writer(_writer),
+      data(new char[BUFFER_SIZE]),
+      reading(0),
+      polling(0) {}
+
+protected:
+  virtual void initialize()
+  {
+    // Stop following once nobody is listening any longer.
+    writer.readerClosed()
+      .onAny(defer(self(), &Self::closed));
+
+    read();
+  }
+
+  virtual void finalize()
+  {
+    writer.close();
+
+    reading.discard();
+    polling.discard();
+
+    // Only close the file descriptors once they are no longer read
+    // or polled, since discarding happens asynchronously.
+    const int fd = this->fd;
+    const int inotify = this->inotify;
+
+    await(reading, polling)
+      .onAny([fd, inotify]() {
+        os::close(fd);
+        os::close(inotify);
+      });
+  }
+
+private:
+  static const size_t BUFFER_SIZE = 64 * 1024;
+
+  void closed()
+  {
+    terminate(self());
+  }
+
+  void read()
+  {
+    reading = io::read(fd, data.get(), BUFFER_SIZE);
+
+    reading.onAny(defer(self(), &Self::_read, lambda::_1));
+  }
+
+  void _read(const Future<size_t>& length)
+  {
+    if (!length.isReady()) {
+      writer.fail(
+          "Failed to read file: " +
+          (length.isFailed() ? length.failure() : "discarded"));
+      terminate(self());
+      return;
+    }
+
+    if (length.get() > 0) {
+      if (!writer.write(string(data.get(), length.get()))) {
+        terminate(self()); // The reader has closed the pipe.
+        return;
+      }
+
+      // Wait for the reader to catch up before reading on, so that a
+      // slow reader does not make us buffer the whole file.
+      writer.writable()
+        .onAny(defer(self(), &Self::writable, lambda::_1));
+      return;
+    }
+
+    // At the end of the file, check whether it has been removed or
+    // truncated (e.g., by log rotation) before waiting for it to be
+    // modified.
+    struct stat s;
+    if (fstat(fd, &s) < 0) {
+      writer.fail("Failed to stat file: " + os::strerror(errno));
+      terminate(self());
+      return;
+    }
+
+    if (s.st_nlink == 0) {
+      terminate(self());
+      return;
+    }
+
+    off_t offset = lseek(fd, 0, SEEK_CUR);
+    if (offset > s.st_size) {
+      if (lseek(fd, 0, SEEK_SET) < 0) {
+        writer.fail("Failed to seek file: " + os::strerror(errno));
+        terminate(self());
+        return;
+      }
+
+      read();
+      return;
+    }
+
+    polling = io::poll(inotify, io::READ);
+
+    polling.onAny(defer(self(), &Self::modified, lambda::_1));
+  }
+
+  void writable(const Future<Nothing>& future)
+  {
+    // Either end of the pipe got closed while we waited.
+    if (!future.isReady()) {
+      terminate(self());
+      return;
+    }
+
+    read();
+  }
+
+  void modified(const Future<short>& future)
+  {
+    if (!future.isReady()) {
+      writer.fail(
+          "Failed to wait for the file to be modified: " +
+          (future.isFailed() ? future.failure() : "discarded"));
+      terminate(self());
+      return;
+    }
+
+    // Consume all of the pending events, we only care whether the
+    // file has been moved since it is read until the end anyway.
+    alignas(struct inotify_event)
+      char buffer[sizeof(struct inotify_event) + NAME_MAX + 1];
+
+    bool moved = false;
+
+    ssize_t length;
+    while ((length = ::read(inotify, buffer, sizeof(buffer))) > 0) {
+      for (char* event = buffer; event < buffer + length;) {
+        const struct inotify_event* e =
+          reinterpret_cast<const struct inotify_event*>(event);
+
+        moved = moved || (e->mask & (IN_MOVE_SELF | IN_DELETE_SELF));
+
+        event += sizeof(struct inotify_event) + e->len;
+      }
+    }
+
+    if (length < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+      writer.fail("Failed to read inotify events: " + os::strerror(errno));
+      terminate(self());
+      return;
+    }
+
+    if (moved) {
+      terminate(self());
+      return;
+    }
+
+    read();
+  }
+
+  const int fd;
+  const int inotify;
+  Pipe::Writer writer;
+  boost::shared_array<char> data;
+
+  // The outstanding operation (only one at a time).
+  Future<size_t> reading;
+  Future<short> polling;
+};
+#endif // __linux__
+
+
 void FilesProcess::initialize()
 {
   // TODO(ijimenez): Remove these endpoints at the end of the
@@ -207,7 +443,14 @@ const string FilesProcess::BROWSE_HELP = HELP(
         "",
         "Query parameters:",
         "",
-        ">        path=VALUE          The path of directory to browse."));
+        ">        path=VALUE          The path of directory to browse.",
+        ">        offset=VALUE        The index of the first entry to list,",
+        ">                            in the order of their names.",
+        ">        limit=VALUE         The maximum number of entries to list."));
+
+
+// The number of entries of a listing that get stat'ed per dispatch.
+static const size_t BROWSE_BATCH_SIZE = 1000;
 
 
 Future<Response> FilesProcess::browse(const Request& request)
@@ -218,6 +461,30 @@ Future<Response> FilesProcess::browse(const Request& request)
     return BadRequest("Expecting 'path=value' in query.\n");
   }
 
+  size_t offset = 0;
+
+  if (request.url.query.get("offset").isSome()) {
+    Try<size_t> result = numify<size_t>(request.url.query.get("offset").get());
+
+    if (result.isError()) {
+      return BadRequest("Failed to parse offset: " + result.error() + ".\n");
+    }
+
+    offset = result.get();
+  }
+
+  Option<size_t> limit = None();
+
+  if (request.url.query.get("limit").isSome()) {
+    Try<size_t> result = numify<size_t>(request.url.query.get("limit").get());
+
+    if (result.isError()) {
+      return BadRequest("Failed to parse limit: " + result.error() + ".\n");
+    }
+
+    limit = result.get();
+  }
+
   Result<string> resolvedPath = resolve(path.get());
 
   if (resolvedPath.isError()) {
@@ -226,45 +493,100 @@ Future<Response> FilesProcess::browse(const Request& request)
     return NotFound();
   }
 
+  Owned<Listing> listing(new Listing());
+  listing->path = path.get();
+  listing->jsonp = request.url.query.get("jsonp");
+
   // The result will be a sorted (on path) array of files and dirs:
   // [{"name": "README", "path": "dir/README" "dir":False, "size":42}, ...]
-  map<string, JSON::Object> files;
-  Try<list<string> > entries = os::ls(resolvedPath.get());
-  if (entries.isSome()) {
-    foreach (const string& entry, entries.get()) {
-      struct stat s;
-      string fullPath = path::join(resolvedPath.get(), entry);
-
-      if (stat(fullPath.c_str(), &s) < 0) {
-        PLOG(WARNING) << "Found " << fullPath << " in ls but stat failed";
-        continue;
-      }
+  // We only read the names of the entries up front, the entries are
+  // stat'ed (relative to the directory) as they get listed, so that
+  // only the requested page of a huge directory gets stat'ed.
+  listing->directory = opendir(resolvedPath.get().c_str());
 
-      files[fullPath] = jsonFileInfo(path::join(path.get(), entry), s);
-    }
+  if (listing->directory == NULL) {
+    return OK(JSON::Array(), listing->jsonp);
   }
 
-  JSON::Array listing;
-  foreachvalue (const JSON::Object& file, files) {
-    listing.values.push_back(file);
+  struct dirent* entry;
+  while ((entry = readdir(listing->directory)) != NULL) {
+    if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+      listing->names.push_back(entry->d_name);
+    }
   }
 
-  return OK(listing, request.url.query.get("jsonp"));
+  std::sort(listing->names.begin(), listing->names.end());
+
+  // Drop the entries outside of the requested page.
+  const size_t size = listing->names.size();
+  const size_t begin = std::min(offset, size);
+  const size_t end = limit.isSome()
+    ? begin + std::min(limit.get(), size - begin)
+    : size;
+
+  listing->names.erase(listing->names.begin() + end, listing->names.end());
+  listing->names.erase(
+      listing->names.begin(),
+      listing->names.begin() + begin);
+
+  Pipe pipe;
+
+  OK response;
+  response.type = Response::PIPE;
+  response.reader = pipe.reader();
+  response.headers["Content-Type"] =
+    listing->jsonp.isSome() ? "text/javascript" : "application/json";
+
+  listing->writer = pipe.writer();
+  listing->writer->write(
+      (listing->jsonp.isSome() ? listing->jsonp.get() + "(" : "") + "[");
+
+  _browse(listing);
+
+  return response;
 }
 
 
-// TODO(benh): Remove 'const &' from size after fixing libprocess.
-Future<Response> _read(int fd,
-                       const size_t& size,
-                       off_t offset,
-                       const boost::shared_array<char>& data,
-                       const Option<string>& jsonp) {
-  JSON::Object object;
+void FilesProcess::_browse(const Owned<Listing>& listing)
+{
+  string batch;
 
-  object.values["offset"] = offset;
-  object.values["data"] = string(data.get(), size);
+  const size_t end =
+    std::min(listing->index + BROWSE_BATCH_SIZE, listing->names.size());
+
+  for (; listing->index < end; listing->index++) {
+    const string& name = listing->names[listing->index];
+
+    struct stat s;
+    if (fstatat(dirfd(listing->directory), name.c_str(), &s, 0) < 0) {
+      PLOG(WARNING) << "Found " << name << " in '" << listing->path
+                    << "' but stat failed";
+      continue;
+    }
+
+    if (!listing->empty) {
+      batch += ",";
+    }
+
+    listing->empty = false;
+
+    batch += stringify(jsonFileInfo(path::join(listing->path, name), s));
+  }
 
-  return OK(object, jsonp);
+  if (listing->index == listing->names.size()) {
+    batch += listing->jsonp.isSome() ? "]);" : "]";
+
+    listing->writer->write(batch);
+    listing->writer->close();
+    return;
+  }
+
+  // Stop if the client went away.
+  if (!listing->writer->write(batch)) {
+    return;
+  }
+
+  dispatch(self(), &Self::_browse, listing);
 }
 
 
@@ -373,39 +695,44 @@ Future<Response> FilesProcess::read(const Request& request)
     return OK(object, request.url.query.get("jsonp"));
   }
 
-  // Seek to the offset we want to read from.
-  if (lseek(fd.get(), offset, SEEK_SET) == -1) {
-    string error = strings::format(
-        "Failed to seek file at '%s': %s",
-        resolvedPath.get(),
-        os::strerror(errno)).get();
+  // Read 'length' bytes (or to EOF) at the offset straight into the
+  // data of the response. The length is capped above, so we read
+  // synchronously rather than polling a regular file, which is
+  // always readable anyway.
+  string data(length, '\0');
 
-    LOG(WARNING) << error;
-    os::close(fd.get());
-    return InternalServerError(error);
-  }
+  ssize_t bytes = 0;
+  while (bytes < length) {
+    ssize_t result =
+      ::pread(fd.get(), &data[bytes], length - bytes, offset + bytes);
 
-  Try<Nothing> nonblock = os::nonblock(fd.get());
-  if (nonblock.isError()) {
-    string error =
-        "Failed to set file descriptor nonblocking: " + nonblock.error();
-    LOG(WARNING) << error;
-    os::close(fd.get());
-    return InternalServerError(error);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    } else if (result < 0) {
+      string error = strings::format(
+          "Failed to read file at '%s': %s",
+          resolvedPath.get(),
+          os::strerror(errno)).get();
+
+      LOG(WARNING) << error;
+      os::close(fd.get());
+      return InternalServerError(error);
+    } else if (result == 0) {
+      break;
+    }
+
+    bytes += result;
   }
 
-  // Read 'length' bytes (or to EOF).
-  boost::shared_array<char> data(new char[length]);
+  os::close(fd.get());
+
+  data.resize(bytes);
 
-  return io::read(fd.get(), data.get(), static_cast<size_t>(length))
-    .then(lambda::bind(
-        _read,
-        fd.get(),
-        lambda::_1,
-        offset,
-        data,
-        request.url.query.get("jsonp")))
-    .onAny(lambda::bind(&os::close, fd.get()));
+  JSON::Object object;
+  object.values["offset"] = offset;
+  object.values["data"] = data;
+
+  return OK(object, request.url.query.get("jsonp"));
 }
 
 
@@ -418,7 +745,15 @@ const string FilesProcess::DOWNLOAD_HELP = HELP(
         "",
         "Query parameters:",
         "",
-        ">        path=VALUE          The path of directory to browse."));
+        ">        path=VALUE          The path of directory to browse.",
+        ">        follow=(true|false) Whether to keep streaming what gets",
+        ">                            appended to the file.",
+        ">        offset=VALUE        The offset to start following from,",
+        ">                            the end of the file by default.",
+        "",
+        "Unless following, a single range of bytes can be requested",
+        "via a 'Range' header, e.g., 'Range: bytes=-4096' for the",
+        "last 4096 bytes of the file."));
 
 
 Future<Response> FilesProcess::download(const Request& request)
@@ -429,6 +764,32 @@ Future<Response> FilesProcess::download(const Request& request)
     return BadRequest("Expecting 'path=value' in query.\n");
   }
 
+  bool following = false;
+
+  Option<string> parameter = request.url.query.get("follow");
+  if (parameter.isSome()) {
+    if (parameter.get() == "true") {
+      following = true;
+    } else if (parameter.get() != "false") {
+      return BadRequest(
+          "Failed to parse follow: Expecting 'true' or 'false'.\n");
+    }
+  }
+
+  off_t offset = -1;
+
+  if (request.url.query.get("offset").isSome()) {
+    Try<off_t> result = numify<off_t>(request.url.query.get("offset").get());
+
+    if (result.isError() || result.get() < 0) {
+      return BadRequest(
+          "Failed to parse offset: " +
+          (result.isError() ? result.error() : "Negative offset") + ".\n");
+    }
+
+    offset = result.get();
+  }
+
   Result<string> resolvedPath = resolve(path.get());
 
   if (resolvedPath.isError()) {
@@ -442,8 +803,15 @@ Future<Response> FilesProcess::download(const Request& request)
     return BadRequest("Cannot download a directory.\n");
   }
 
+  if (following) {
+    return follow(resolvedPath.get(), offset);
+  }
+
   string basename = Path(resolvedPath.get()).basename();
 
+  // NOTE: Sending the file (or the requested range of it) is done via
+  // 'sendfile' by libprocess, so the data is never copied through
+  // userspace.
   OK response;
   response.type = response.PATH;
   response.path = resolvedPath.get();
@@ -464,6 +832,67 @@ Future<Response> FilesProcess::download(const Request& request)
 }
 
 
+Future<Response> FilesProcess::follow(const string& path, off_t offset)
+{
+#ifdef __linux__
+  Try<int> fd = os::open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+
+  if (fd.isError()) {
+    string error = strings::format("Failed to open file at '%s': %s",
+        path, fd.error()).get();
+    LOG(WARNING) << error;
+    return InternalServerError(error + ".\n");
+  }
+
+  // Start at the end of the file by default, like 'tail -f'.
+  if (lseek(fd.get(), offset == -1 ? 0 : offset,
+            offset == -1 ? SEEK_END : SEEK_SET) == -1) {
+    string error = strings::format(
+        "Failed to seek file at '%s': %s",
+        path,
+        os::strerror(errno)).get();
+
+    LOG(WARNING) << error;
+    os::close(fd.get());
+    return InternalServerError(error + ".\n");
+  }
+
+  int inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+  if (inotify < 0 ||
+      inotify_add_watch(
+          inotify,
+          path.c_str(),
+          IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF) < 0) {
+    string error = strings::format(
+        "Failed to watch file at '%s': %s",
+        path,
+        os::strerror(errno)).get();
+
+    LOG(WARNING) << error;
+    os::close(fd.get());
+    if (inotify >= 0) {
+      os::close(inotify);
+    }
+    return InternalServerError(error + ".\n");
+  }
+
+  Pipe pipe(Bytes(FollowProcess::HIGH_WATER_MARK));
+
+  OK response;
+  response.type = Response::PIPE;
+  response.reader = pipe.reader();
+  response.headers["Content-Type"] = "application/octet-stream";
+
+  spawn(new FollowProcess(fd.get(), inotify, pipe.writer()), true);
+
+  return response;
+#else
+  return BadRequest("Following files is only supported on Linux.\n");
+#endif // __linux__
+}
+
+
 const string FilesProcess::DEBUG_HELP = HELP(
     TLDR(
         "Returns the internal virtual path mapping."),
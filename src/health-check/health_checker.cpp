@@ -0,0 +1,340 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <process/clock.hpp>
+#include <process/defer.hpp>
+#include <process/delay.hpp>
+#include <process/dispatch.hpp>
+#include <process/http.hpp>
+#include <process/id.hpp>
+#include <process/process.hpp>
+#include <process/subprocess.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/foreach.hpp>
+#include <stout/lambda.hpp>
+#include <stout/os.hpp>
+#include <stout/strings.hpp>
+
+#include "common/status_utils.hpp"
+
+#include "health-check/health_checker.hpp"
+
+#include "messages/messages.hpp"
+
+using process::Clock;
+using process::Failure;
+using process::Future;
+using process::Owned;
+using process::Subprocess;
+using process::UPID;
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace http = process::http;
+
+namespace mesos {
+namespace internal {
+namespace health {
+
+Try<Owned<HealthChecker>> HealthChecker::create(
+    const HealthCheck& check,
+    const UPID& executor,
+    const TaskID& taskID)
+{
+  if (check.has_http() && check.has_command()) {
+    return Error("Both 'http' and 'command' health check requested");
+  }
+
+  if (!check.has_http() && !check.has_command()) {
+    return Error("Expecting one of 'http' or 'command' health check");
+  }
+
+  if (check.has_command() && !check.command().has_value()) {
+    return Error(check.command().shell()
+                 ? "Shell command is not specified"
+                 : "Executable path is not specified");
+  }
+
+  Owned<HealthCheckerProcess> process(
+      new HealthCheckerProcess(check, executor, taskID));
+
+  return Owned<HealthChecker>(new HealthChecker(process));
+}
+
+
+HealthChecker::HealthChecker(Owned<HealthCheckerProcess> _process)
+  : process(_process)
+{
+  spawn(CHECK_NOTNULL(process.get()));
+}
+
+
+HealthChecker::~HealthChecker()
+{
+  terminate(process.get());
+  wait(process.get());
+}
+
+
+Future<Nothing> HealthChecker::healthCheck()
+{
+  return dispatch(process.get(), &HealthCheckerProcess::healthCheck);
+}
+
+
+HealthCheckerProcess::HealthCheckerProcess(
+    const HealthCheck& _check,
+    const UPID& _executor,
+    const TaskID& _taskID)
+  : ProcessBase(process::ID::generate("health-checker")),
+    check(_check),
+    initializing(true),
+    executor(_executor),
+    taskID(_taskID),
+    consecutiveFailures(0) {}
+
+
+Future<Nothing> HealthCheckerProcess::healthCheck()
+{
+  VLOG(2) << "Health checks starting in "
+          << Seconds(check.delay_seconds()) << ", grace period "
+          << Seconds(check.grace_period_seconds());
+
+  startTime = Clock::now();
+
+  delay(Seconds(check.delay_seconds()), self(), &Self::_healthCheck);
+  return promise.future();
+}
+
+
+void HealthCheckerProcess::failure(const string& message)
+{
+  if (check.grace_period_seconds() > 0 &&
+      (Clock::now() - startTime).secs() <= check.grace_period_seconds()) {
+    LOG(INFO) << "Ignoring failure as health check still in grace period";
+    reschedule();
+    return;
+  }
+
+  consecutiveFailures++;
+  VLOG(1) << "#" << consecutiveFailures << " check failed: " << message;
+
+  bool killTask = consecutiveFailures >= check.consecutive_failures();
+
+  TaskHealthStatus taskHealthStatus;
+  taskHealthStatus.set_healthy(false);
+  taskHealthStatus.set_consecutive_failures(consecutiveFailures);
+  taskHealthStatus.set_kill_task(killTask);
+  taskHealthStatus.mutable_task_id()->CopyFrom(taskID);
+  send(executor, taskHealthStatus);
+
+  if (killTask) {
+    promise.fail(message);
+  } else {
+    reschedule();
+  }
+}
+
+
+void HealthCheckerProcess::success()
+{
+  VLOG(1) << "Check passed";
+
+  // Send a healthy status update on the first success,
+  // and on the first success following failure(s).
+  if (initializing || consecutiveFailures > 0) {
+    TaskHealthStatus taskHealthStatus;
+    taskHealthStatus.set_healthy(true);
+    taskHealthStatus.mutable_task_id()->CopyFrom(taskID);
+    send(executor, taskHealthStatus);
+    initializing = false;
+  }
+  consecutiveFailures = 0;
+  reschedule();
+}
+
+
+void HealthCheckerProcess::_healthCheck()
+{
+  Future<Nothing> checking;
+
+  if (check.has_command()) {
+    checking = _commandHealthCheck();
+  } else {
+    CHECK(check.has_http());
+    checking = _httpHealthCheck();
+  }
+
+  checking.onAny(defer(self(), &Self::__healthCheck, lambda::_1));
+}
+
+
+Future<Nothing> HealthCheckerProcess::_commandHealthCheck()
+{
+  const CommandInfo& command = check.command();
+
+  map<string, string> environment = os::environment();
+
+  foreach (const Environment::Variable& variable,
+           command.environment().variables()) {
+    environment[variable.name()] = variable.value();
+  }
+
+  // Launch the subprocess.
+  Try<Subprocess> external = Error("Not launched");
+
+  if (command.shell()) {
+    // Use the shell variant.
+    VLOG(2) << "Launching health command '" << command.value() << "'";
+
+    external = process::subprocess(
+        command.value(),
+        Subprocess::PATH("/dev/null"),
+        Subprocess::FD(STDERR_FILENO),
+        Subprocess::FD(STDERR_FILENO),
+        environment);
+  } else {
+    // Use the exec variant.
+    vector<string> argv;
+    foreach (const string& arg, command.arguments()) {
+      argv.push_back(arg);
+    }
+
+    VLOG(2) << "Launching health command [" << command.value() << ", "
+            << strings::join(", ", argv) << "]";
+
+    external = process::subprocess(
+        command.value(),
+        argv,
+        Subprocess::PATH("/dev/null"),
+        Subprocess::FD(STDERR_FILENO),
+        Subprocess::FD(STDERR_FILENO),
+        None(),
+        environment);
+  }
+
+  if (external.isError()) {
+    return Failure(
+        "Error creating subprocess for healthcheck: " + external.error());
+  }
+
+  const pid_t commandPid = external.get().pid();
+  const Duration timeout = Seconds(check.timeout_seconds());
+
+  // Unlike the 'mesos-health-check' program did, we do not block the
+  // process while the command runs, as it is the executor's process.
+  return external.get().status()
+    .after(timeout, [=](Future<Option<int>> status) -> Future<Option<int>> {
+      status.discard();
+
+      // Cleanup the external command process.
+      os::killtree(commandPid, SIGKILL);
+      VLOG(1) << "Kill health check command " << commandPid;
+
+      return Failure(
+          "Command check failed with reason: status still pending after "
+          "timeout " + stringify(timeout));
+    })
+    .then([](const Option<int>& status) -> Future<Nothing> {
+      if (status.isNone()) {
+        return Failure("Command check failed with reason: no status found");
+      }
+
+      if (status.get() != 0) {
+        return Failure("Health command check " + WSTRINGIFY(status.get()));
+      }
+
+      return Nothing();
+    });
+}
+
+
+Future<Nothing> HealthCheckerProcess::_httpHealthCheck()
+{
+  const HealthCheck::HTTP& _http = check.http();
+
+  string path = _http.path();
+  if (!strings::startsWith(path, "/")) {
+    path = "/" + path;
+  }
+
+  // The tasks are expected to listen on the port on the local host,
+  // e.g., with host networking.
+  const http::URL url("http", "127.0.0.1", _http.port(), path);
+  const Duration timeout = Seconds(check.timeout_seconds());
+
+  const vector<uint32_t> statuses(
+      _http.statuses().begin(),
+      _http.statuses().end());
+
+  VLOG(2) << "Sending health check request to " << url;
+
+  return http::get(url)
+    .after(timeout, [=](Future<http::Response> response)
+        -> Future<http::Response> {
+      response.discard();
+
+      return Failure(
+          "HTTP check failed with reason: response still pending after "
+          "timeout " + stringify(timeout));
+    })
+    .then([statuses](const http::Response& response) -> Future<Nothing> {
+      // Any status is acceptable if no statuses are expected.
+      if (!statuses.empty() &&
+          std::find(statuses.begin(), statuses.end(), response.code) ==
+            statuses.end()) {
+        return Failure(
+            "HTTP check failed with unexpected status '" +
+            response.status + "'");
+      }
+
+      return Nothing();
+    });
+}
+
+
+void HealthCheckerProcess::__healthCheck(const Future<Nothing>& checking)
+{
+  if (checking.isReady()) {
+    success();
+  } else {
+    failure(checking.isFailed() ? checking.failure() : "discarded");
+  }
+}
+
+
+void HealthCheckerProcess::reschedule()
+{
+  VLOG(1) << "Rescheduling health check in "
+          << Seconds(check.interval_seconds());
+
+  delay(Seconds(check.interval_seconds()), self(), &Self::_healthCheck);
+}
+
+} // namespace health {
+} // namespace internal {
+} // namespace mesos {
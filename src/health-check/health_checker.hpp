@@ -0,0 +1,112 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __HEALTH_CHECKER_HPP__
+#define __HEALTH_CHECKER_HPP__
+
+#include <string>
+
+#include <mesos/mesos.hpp>
+
+#include <process/future.hpp>
+#include <process/owned.hpp>
+#include <process/pid.hpp>
+#include <process/protobuf.hpp>
+#include <process/time.hpp>
+
+#include <stout/nothing.hpp>
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace internal {
+namespace health {
+
+// Forward declarations.
+class HealthCheckerProcess;
+
+
+// Runs the health checks of a task and sends a 'TaskHealthStatus'
+// message to the executor on every change of the health of the task.
+// The health checker runs in the process of the executor, so that an
+// executor does not need a 'mesos-health-check' process, i.e., another
+// libprocess runtime, per task. Command checks still run the command
+// in a subprocess, while HTTP checks are sent with libprocess.
+class HealthChecker
+{
+public:
+  static Try<process::Owned<HealthChecker>> create(
+      const HealthCheck& check,
+      const process::UPID& executor,
+      const TaskID& taskID);
+
+  ~HealthChecker();
+
+  // Starts the health checks. The future fails once the task fails
+  // enough consecutive checks to be killed.
+  process::Future<Nothing> healthCheck();
+
+private:
+  explicit HealthChecker(process::Owned<HealthCheckerProcess> process);
+
+  process::Owned<HealthCheckerProcess> process;
+};
+
+
+class HealthCheckerProcess : public ProtobufProcess<HealthCheckerProcess>
+{
+public:
+  HealthCheckerProcess(
+      const HealthCheck& _check,
+      const process::UPID& _executor,
+      const TaskID& _taskID);
+
+  virtual ~HealthCheckerProcess() {}
+
+  process::Future<Nothing> healthCheck();
+
+private:
+  void failure(const std::string& message);
+  void success();
+
+  void _healthCheck();
+
+  // Runs the command of the check. The future fails if the command
+  // can not be launched, or fails or times out.
+  process::Future<Nothing> _commandHealthCheck();
+
+  // Sends the request of the check to the port of the task on the
+  // local host. The future fails if the request fails or times out,
+  // or if the response does not have one of the expected statuses.
+  process::Future<Nothing> _httpHealthCheck();
+
+  void __healthCheck(const process::Future<Nothing>& checking);
+
+  void reschedule();
+
+  process::Promise<Nothing> promise;
+  HealthCheck check;
+  bool initializing;
+  process::UPID executor;
+  TaskID taskID;
+  uint32_t consecutiveFailures;
+  process::Time startTime;
+};
+
+} // namespace health {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __HEALTH_CHECKER_HPP__
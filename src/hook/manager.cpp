@@ -14,34 +14,200 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <list>
 #include <mutex>
 #include <string>
 #include <vector>
 
 #include <mesos/hook.hpp>
+#include <mesos/type_utils.hpp>
 
 #include <mesos/module/hook.hpp>
 
+#include <process/collect.hpp>
+#include <process/dispatch.hpp>
+#include <process/id.hpp>
+#include <process/owned.hpp>
+#include <process/process.hpp>
+
 #include <stout/check.hpp>
 #include <stout/foreach.hpp>
 #include <stout/nothing.hpp>
+#include <stout/result.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
 
 #include "hook/manager.hpp"
 #include "module/manager.hpp"
 
+using std::list;
 using std::map;
 using std::string;
 using std::vector;
 
 using mesos::modules::ModuleManager;
 
+using process::Future;
+using process::Owned;
+
 namespace mesos {
 namespace internal {
 
+// Invokes the hooks of a single module for the asynchronous variants
+// of the hooks, so that a slow module only delays itself.
+class HookModuleProcess : public process::Process<HookModuleProcess>
+{
+public:
+  explicit HookModuleProcess(Hook* _hook)
+    : ProcessBase(process::ID::generate("hook-module")),
+      hook(_hook) {}
+
+  Result<Labels> masterLaunchTaskLabelDecorator(
+      const TaskInfo& taskInfo,
+      const FrameworkInfo& frameworkInfo,
+      const SlaveInfo& slaveInfo)
+  {
+    return hook->masterLaunchTaskLabelDecorator(
+        taskInfo, frameworkInfo, slaveInfo);
+  }
+
+  Result<Labels> slaveRunTaskLabelDecorator(
+      const TaskInfo& taskInfo,
+      const ExecutorInfo& executorInfo,
+      const FrameworkInfo& frameworkInfo,
+      const SlaveInfo& slaveInfo)
+  {
+    return hook->slaveRunTaskLabelDecorator(
+        taskInfo, executorInfo, frameworkInfo, slaveInfo);
+  }
+
+  Try<Nothing> slavePreLaunchDockerHook(
+      const ContainerInfo& containerInfo,
+      const CommandInfo& commandInfo,
+      const Option<TaskInfo>& taskInfo,
+      const ExecutorInfo& executorInfo,
+      const string& name,
+      const string& sandboxDirectory,
+      const string& mappedDirectory,
+      const Option<Resources>& resources,
+      const Option<map<string, string>>& env)
+  {
+    return hook->slavePreLaunchDockerHook(
+        containerInfo,
+        commandInfo,
+        taskInfo,
+        executorInfo,
+        name,
+        sandboxDirectory,
+        mappedDirectory,
+        resources,
+        env);
+  }
+
+private:
+  Hook* hook;
+};
+
+
 static std::mutex mutex;
 static hashmap<string, Hook*> availableHooks;
+static hashmap<string, Owned<HookModuleProcess>> hookProcesses;
+
+
+// Gives up on the invocation of a hook once 'timeout' has elapsed.
+// The result type 'T' is either a 'Result' or a 'Try'.
+template <typename T>
+static Future<T> timeout(const Future<T>& future, const Duration& timeout)
+{
+  return future.after(timeout, [timeout](Future<T> future) -> Future<T> {
+    future.discard();
+    return T(Error("Timed out after " + stringify(timeout)));
+  });
+}
+
+
+// Returns the error of the invocation of a hook, if any.
+template <typename T>
+static Option<string> error(const Future<T>& result)
+{
+  if (!result.isReady()) {
+    return result.isFailed() ? result.failure() : "discarded";
+  } else if (result.get().isError()) {
+    return result.get().error();
+  }
+
+  return None();
+}
+
+
+static bool contains(const Labels& labels, const Label& label)
+{
+  foreach (const Label& label_, labels.labels()) {
+    if (label_ == label) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+// Merges the labels returned by the label decorators of the modules
+// which were all given the task with the labels 'labels'.
+static Labels decorate(
+    const string& hook,
+    const Labels& labels,
+    const list<string>& names,
+    const list<Future<Result<Labels>>>& results)
+{
+  CHECK_EQ(names.size(), results.size());
+
+  Option<Labels> decorated;
+
+  list<string>::const_iterator name = names.begin();
+  foreach (const Future<Result<Labels>>& result, results) {
+    const string& module = *name++;
+
+    const Option<string> error_ = error(result);
+    if (error_.isSome()) {
+      LOG(WARNING) << hook << " hook failed for module '"
+                   << module << "': " << error_.get();
+      continue;
+    }
+
+    // NOTE: If the hook returns None(), the task labels won't be
+    // changed.
+    if (result.get().isNone()) {
+      continue;
+    }
+
+    const Labels& labels_ = result.get().get();
+
+    if (decorated.isNone()) {
+      decorated = labels_;
+      continue;
+    }
+
+    // Apply the changes of this module on top of the others.
+    Labels merged;
+    foreach (const Label& label, decorated.get().labels()) {
+      if (!contains(labels, label) || contains(labels_, label)) {
+        merged.add_labels()->CopyFrom(label);
+      }
+    }
+
+    foreach (const Label& label, labels_.labels()) {
+      if (!contains(labels, label)) {
+        merged.add_labels()->CopyFrom(label);
+      }
+    }
+
+    decorated = merged;
+  }
+
+  return decorated.getOrElse(labels);
+}
 
 
 Try<Nothing> HookManager::initialize(const string& hookList)
@@ -67,6 +233,11 @@ Try<Nothing> HookManager::initialize(const string& hookList)
 
       // Add the hook module to the list of available hooks.
       availableHooks[hook] = module.get();
+
+      hookProcesses[hook] =
+        Owned<HookModuleProcess>(new HookModuleProcess(module.get()));
+
+      process::spawn(hookProcesses[hook].get());
     }
   }
 
@@ -84,6 +255,11 @@ Try<Nothing> HookManager::unload(const std::string& hookName)
 
     // Now remove the hook from the list of available hooks.
     availableHooks.erase(hookName);
+
+    process::terminate(hookProcesses[hookName].get());
+    process::wait(hookProcesses[hookName].get());
+
+    hookProcesses.erase(hookName);
   }
 
   return Nothing();
@@ -325,5 +501,130 @@ Attributes HookManager::slaveAttributesDecorator(
   }
 }
 
+
+Future<Labels> HookManager::masterLaunchTaskLabelDecorator(
+    const TaskInfo& taskInfo,
+    const FrameworkInfo& frameworkInfo,
+    const SlaveInfo& slaveInfo,
+    const Duration& timeout)
+{
+  list<string> names;
+  list<Future<Result<Labels>>> futures;
+
+  synchronized (mutex) {
+    foreachpair (const string& name,
+                 const Owned<HookModuleProcess>& process,
+                 hookProcesses) {
+      names.push_back(name);
+      futures.push_back(internal::timeout(
+          process::dispatch(
+              process.get(),
+              &HookModuleProcess::masterLaunchTaskLabelDecorator,
+              taskInfo,
+              frameworkInfo,
+              slaveInfo),
+          timeout));
+    }
+  }
+
+  const Labels labels = taskInfo.labels();
+
+  return process::await(futures)
+    .then([=](const list<Future<Result<Labels>>>& results) {
+      return decorate("Master label decorator", labels, names, results);
+    });
+}
+
+
+Future<Labels> HookManager::slaveRunTaskLabelDecorator(
+    const TaskInfo& taskInfo,
+    const ExecutorInfo& executorInfo,
+    const FrameworkInfo& frameworkInfo,
+    const SlaveInfo& slaveInfo,
+    const Duration& timeout)
+{
+  list<string> names;
+  list<Future<Result<Labels>>> futures;
+
+  synchronized (mutex) {
+    foreachpair (const string& name,
+                 const Owned<HookModuleProcess>& process,
+                 hookProcesses) {
+      names.push_back(name);
+      futures.push_back(internal::timeout(
+          process::dispatch(
+              process.get(),
+              &HookModuleProcess::slaveRunTaskLabelDecorator,
+              taskInfo,
+              executorInfo,
+              frameworkInfo,
+              slaveInfo),
+          timeout));
+    }
+  }
+
+  const Labels labels = taskInfo.labels();
+
+  return process::await(futures)
+    .then([=](const list<Future<Result<Labels>>>& results) {
+      return decorate("Slave label decorator", labels, names, results);
+    });
+}
+
+
+Future<Nothing> HookManager::slavePreLaunchDockerHook(
+    const ContainerInfo& containerInfo,
+    const CommandInfo& commandInfo,
+    const Option<TaskInfo>& taskInfo,
+    const ExecutorInfo& executorInfo,
+    const string& name,
+    const string& sandboxDirectory,
+    const string& mappedDirectory,
+    const Option<Resources>& resources,
+    const Option<map<string, string>>& env,
+    const Duration& timeout)
+{
+  list<string> names;
+  list<Future<Try<Nothing>>> futures;
+
+  synchronized (mutex) {
+    foreachpair (const string& module,
+                 const Owned<HookModuleProcess>& process,
+                 hookProcesses) {
+      names.push_back(module);
+      futures.push_back(internal::timeout(
+          process::dispatch(
+              process.get(),
+              &HookModuleProcess::slavePreLaunchDockerHook,
+              containerInfo,
+              commandInfo,
+              taskInfo,
+              executorInfo,
+              name,
+              sandboxDirectory,
+              mappedDirectory,
+              resources,
+              env),
+          timeout));
+    }
+  }
+
+  return process::await(futures)
+    .then([=](const list<Future<Try<Nothing>>>& results) {
+      list<string>::const_iterator module = names.begin();
+      foreach (const Future<Try<Nothing>>& result, results) {
+        const Option<string> error_ = error(result);
+        if (error_.isSome()) {
+          LOG(WARNING) << "Slave pre launch docker hook failed for module '"
+                       << *module << "': " << error_.get();
+        }
+
+        ++module;
+      }
+
+      return Nothing();
+    });
+}
+
 } // namespace internal {
 } // namespace mesos {
@@ -17,11 +17,16 @@
 #ifndef __HOOK_MANAGER_HPP__
 #define __HOOK_MANAGER_HPP__
 
+#include <map>
 #include <string>
 
 #include <mesos/mesos.hpp>
 #include <mesos/hook.hpp>
 
+#include <process/future.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/nothing.hpp>
 #include <stout/try.hpp>
 
 namespace mesos {
@@ -78,6 +83,44 @@ public:
 
   static Attributes slaveAttributesDecorator(
       const SlaveInfo& slaveInfo);
+
+  // The asynchronous variants of the hooks above, for the callers
+  // that must not block on slow hook modules (e.g., the master and
+  // the slave actors). The hooks of the modules are invoked in
+  // parallel, each module on its own actor so that a module never
+  // sees concurrent invocations, and the returned future is ready
+  // once every module returned or timed out after 'timeout'. The
+  // result of a module that times out is ignored, just like that of
+  // a module that returns an error.
+  //
+  // NOTE: As the modules are invoked in parallel, they do not see
+  // the labels set by each other. Instead, the labels added and
+  // removed by each module are applied to the labels returned by the
+  // first module (in the unspecified order of the modules).
+  static process::Future<Labels> masterLaunchTaskLabelDecorator(
+      const TaskInfo& taskInfo,
+      const FrameworkInfo& frameworkInfo,
+      const SlaveInfo& slaveInfo,
+      const Duration& timeout);
+
+  static process::Future<Labels> slaveRunTaskLabelDecorator(
+      const TaskInfo& taskInfo,
+      const ExecutorInfo& executorInfo,
+      const FrameworkInfo& frameworkInfo,
+      const SlaveInfo& slaveInfo,
+      const Duration& timeout);
+
+  static process::Future<Nothing> slavePreLaunchDockerHook(
+      const ContainerInfo& containerInfo,
+      const CommandInfo& commandInfo,
+      const Option<TaskInfo>& taskInfo,
+      const ExecutorInfo& executorInfo,
+      const std::string& name,
+      const std::string& sandboxDirectory,
+      const std::string& mappedDirectory,
+      const Option<Resources>& resources,
+      const Option<std::map<std::string, std::string>>& env,
+      const Duration& timeout);
 };
 
 } // namespace internal {
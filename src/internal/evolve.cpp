@@ -17,6 +17,7 @@
 #include <process/pid.hpp>
 
 #include <stout/check.hpp>
+#include <stout/foreach.hpp>
 
 #include "internal/evolve.hpp"
 
@@ -235,6 +236,27 @@ v1::scheduler::Event evolve(const StatusUpdateMessage& message)
 }
 
 
+v1::scheduler::Event evolve(const ReconcileResultMessage& message)
+{
+  v1::scheduler::Event event;
+  event.set_type(v1::scheduler::Event::RECONCILE_RESULT);
+
+  v1::scheduler::Event::ReconcileResult* result =
+    event.mutable_reconcile_result();
+
+  // Each status is evolved like the status of a separately sent
+  // update (without a 'pid', so the 'uuid' is cleared).
+  foreach (const StatusUpdate& update, message.updates()) {
+    StatusUpdateMessage _message;
+    _message.mutable_update()->CopyFrom(update);
+
+    result->add_statuses()->CopyFrom(evolve(_message).update().status());
+  }
+
+  return event;
+}
+
+
 v1::scheduler::Event evolve(const LostSlaveMessage& message)
 {
   v1::scheduler::Event event;
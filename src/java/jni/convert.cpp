@@ -16,11 +16,16 @@
 
 #include <jni.h>
 
+#include <map>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <assert.h>
 
 #include <mesos/mesos.hpp>
 
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/result.hpp>
 #include <stout/strings.hpp>
 
@@ -52,14 +57,23 @@ namespace {
 
 jweak mesosClassLoader = NULL; // Initialized in JNI_OnLoad later in this file.
 
-jclass FindMesosClass(JNIEnv* env, const char* className)
-{
-  if (env->ExceptionCheck()) {
-      fprintf(stderr, "ERROR: exception pending on entry to "
-                      "FindMesosClass()\n");
-      return NULL;
-  }
+// 'ClassLoader.loadClass', initialized in JNI_OnLoad too.
+jmethodID loadClass = NULL;
+
+// The classes found by FindMesosClass(), as global references, and
+// the static methods of these classes looked up through
+// GetMesosStaticMethodID(). Each conversion below needs a class and
+// its 'parseFrom' or 'valueOf', and going through the ClassLoader
+// (a call into Java) for every message dominated converting, e.g.,
+// a batch of offers. The conversions run on the threads of all the
+// drivers, hence the mutex. The caches are released in JNI_OnUnLoad.
+std::mutex cacheMutex;
+hashmap<string, jclass> classes;
+std::map<std::pair<jclass, string>, jmethodID> staticMethods;
 
+
+jclass LoadMesosClass(JNIEnv* env, const char* className)
+{
   if (mesosClassLoader == NULL) {
     return env->FindClass(className);
   }
@@ -73,14 +87,6 @@ jclass FindMesosClass(JNIEnv* env, const char* className)
       convName[i] = '.';
   }
 
-  jclass javaLangClassLoader = env->FindClass("java/lang/ClassLoader");
-  assert(javaLangClassLoader != NULL);
-  jmethodID loadClass =
-    env->GetMethodID(javaLangClassLoader,
-                     "loadClass",
-                     "(Ljava/lang/String;)Ljava/lang/Class;");
-  assert(loadClass != NULL);
-
   // Create an object for the class name string; alloc could fail.
   jstring strClassName = env->NewStringUTF(convName.c_str());
   if (env->ExceptionCheck()) {
@@ -101,12 +107,95 @@ jclass FindMesosClass(JNIEnv* env, const char* className)
     return NULL;
   }
 
+  env->DeleteLocalRef(strClassName);
+
   return cls;
 }
 
 } // namespace {
 
 
+// Returns a global reference, which the caller must not delete.
+jclass FindMesosClass(JNIEnv* env, const char* className)
+{
+  if (env->ExceptionCheck()) {
+      fprintf(stderr, "ERROR: exception pending on entry to "
+                      "FindMesosClass()\n");
+      return NULL;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (classes.contains(className)) {
+      return classes[className];
+    }
+  }
+
+  jclass cls = LoadMesosClass(env, className);
+  if (cls == NULL) {
+    return NULL;
+  }
+
+  jclass global = (jclass) env->NewGlobalRef(cls);
+  env->DeleteLocalRef(cls);
+
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  if (classes.contains(className)) {
+    // Another thread got here first.
+    env->DeleteGlobalRef(global);
+    return classes[className];
+  }
+
+  classes[className] = global;
+  return global;
+}
+
+
+namespace {
+
+// Like 'GetStaticMethodID' but cached, for classes returned by
+// FindMesosClass().
+jmethodID GetMesosStaticMethodID(
+    JNIEnv* env,
+    jclass clazz,
+    const char* name,
+    const char* signature)
+{
+  const std::pair<jclass, string> key(clazz, string(name) + signature);
+
+  {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (staticMethods.count(key) > 0) {
+      return staticMethods[key];
+    }
+  }
+
+  jmethodID method = env->GetStaticMethodID(clazz, name, signature);
+  if (method == NULL) {
+    return NULL;
+  }
+
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  staticMethods[key] = method;
+  return method;
+}
+
+
+void ReleaseMesosClasses(JNIEnv* env)
+{
+  std::lock_guard<std::mutex> lock(cacheMutex);
+
+  foreachvalue (jclass cls, classes) {
+    env->DeleteGlobalRef(cls);
+  }
+
+  classes.clear();
+  staticMethods.clear();
+}
+
+} // namespace {
+
+
 // Called by JVM when it loads our library.
 JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* jvm, void* reserved)
 {
@@ -131,6 +220,12 @@ JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* jvm, void* reserved)
       javaLangThread, "getContextClassLoader", "()Ljava/lang/ClassLoader;");
   assert(getContextClassLoader != NULL);
 
+  loadClass = env->GetMethodID(
+      javaLangClassLoader,
+      "loadClass",
+      "(Ljava/lang/String;)Ljava/lang/Class;");
+  assert(loadClass != NULL);
+
   jobject thread = env->CallStaticObjectMethod(javaLangThread, currentThread);
   assert(thread != NULL);
 
@@ -151,6 +246,7 @@ JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* jvm, void* reserved)
   const string nativeMajorVersion = strings::split(MESOS_VERSION, ".")[0];
 
   if (jarMajorVersion != nativeMajorVersion) {
+    ReleaseMesosClasses(env);
     env->DeleteWeakGlobalRef(mesosClassLoader);
     mesosClassLoader = NULL;
     const string& error =
@@ -185,6 +281,8 @@ JNIEXPORT void JNICALL JNI_OnUnLoad(JavaVM* jvm, void* reserved)
 
   // TODO(benh): Must we set 'MesosNativeLibrary.loaded' to false?
 
+  ReleaseMesosClasses(env);
+
   if (mesosClassLoader != NULL) {
     env->DeleteWeakGlobalRef(mesosClassLoader);
     mesosClassLoader = NULL;
@@ -212,11 +310,11 @@ jobject convert(JNIEnv* env, const FrameworkID& frameworkId)
   // FrameworkID frameworkId = FrameworkID.parseFrom(data);
   jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$FrameworkID");
 
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$FrameworkID;");
+  jmethodID parseFrom = GetMesosStaticMethodID(
+      env, clazz, "parseFrom", "([B)Lorg/apache/mesos/Protos$FrameworkID;");
 
   jobject jframeworkId = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
+  env->DeleteLocalRef(jdata);
 
   return jframeworkId;
 }
@@ -235,11 +333,11 @@ jobject convert(JNIEnv* env, const FrameworkInfo& frameworkInfo)
   // FrameworkInfo frameworkInfo = FrameworkInfo.parseFrom(data);
   jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$FrameworkInfo");
 
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$FrameworkInfo;");
+  jmethodID parseFrom = GetMesosStaticMethodID(
+      env, clazz, "parseFrom", "([B)Lorg/apache/mesos/Protos$FrameworkInfo;");
 
   jobject jframeworkInfo = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
+  env->DeleteLocalRef(jdata);
 
   return jframeworkInfo;
 }
@@ -258,11 +356,11 @@ jobject convert(JNIEnv* env, const MasterInfo& masterInfo)
   // MasterInfo masterInfo = MasterInfo.parseFrom(data);
   jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$MasterInfo");
 
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$MasterInfo;");
+  jmethodID parseFrom = GetMesosStaticMethodID(
+      env, clazz, "parseFrom", "([B)Lorg/apache/mesos/Protos$MasterInfo;");
 
   jobject jmasterInfo = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
+  env->DeleteLocalRef(jdata);
 
   return jmasterInfo;
 }
@@ -281,11 +379,11 @@ jobject convert(JNIEnv* env, const ExecutorID& executorId)
   // ExecutorID executorId = ExecutorID.parseFrom(data);
   jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$ExecutorID");
 
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$ExecutorID;");
+  jmethodID parseFrom = GetMesosStaticMethodID(
+      env, clazz, "parseFrom", "([B)Lorg/apache/mesos/Protos$ExecutorID;");
 
   jobject jexecutorId = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
+  env->DeleteLocalRef(jdata);
 
   return jexecutorId;
 }
@@ -304,11 +402,11 @@ jobject convert(JNIEnv* env, const TaskID& taskId)
   // TaskID taskId = TaskID.parseFrom(data);
   jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$TaskID");
 
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$TaskID;");
+  jmethodID parseFrom = GetMesosStaticMethodID(
+      env, clazz, "parseFrom", "([B)Lorg/apache/mesos/Protos$TaskID;");
 
   jobject jtaskId = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
+  env->DeleteLocalRef(jdata);
 
   return jtaskId;
 }
@@ -327,11 +425,11 @@ jobject convert(JNIEnv* env, const SlaveID& slaveId)
   // SlaveID slaveId = SlaveID.parseFrom(data);
   jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$SlaveID");
 
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$SlaveID;");
+  jmethodID parseFrom = GetMesosStaticMethodID(
+      env, clazz, "parseFrom", "([B)Lorg/apache/mesos/Protos$SlaveID;");
 
   jobject jslaveId = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
+  env->DeleteLocalRef(jdata);
 
   return jslaveId;
 }
@@ -350,11 +448,11 @@ jobject convert(JNIEnv* env, const SlaveInfo& slaveInfo)
   // SlaveInfo slaveInfo = SlaveInfo.parseFrom(data);
   jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$SlaveInfo");
 
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$SlaveInfo;");
+  jmethodID parseFrom = GetMesosStaticMethodID(
+      env, clazz, "parseFrom", "([B)Lorg/apache/mesos/Protos$SlaveInfo;");
 
   jobject jslaveInfo = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
+  env->DeleteLocalRef(jdata);
 
   return jslaveInfo;
 }
@@ -373,11 +471,11 @@ jobject convert(JNIEnv* env, const OfferID& offerId)
   // OfferID offerId = OfferID.parseFrom(data);
   jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$OfferID");
 
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$OfferID;");
+  jmethodID parseFrom = GetMesosStaticMethodID(
+      env, clazz, "parseFrom", "([B)Lorg/apache/mesos/Protos$OfferID;");
 
   jobject jofferId = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
+  env->DeleteLocalRef(jdata);
 
   return jofferId;
 }
@@ -391,9 +489,8 @@ jobject convert(JNIEnv* env, const TaskState& state)
   // TaskState state = TaskState.valueOf(value);
   jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$TaskState");
 
-  jmethodID valueOf =
-    env->GetStaticMethodID(clazz, "valueOf",
-                           "(I)Lorg/apache/mesos/Protos$TaskState;");
+  jmethodID valueOf = GetMesosStaticMethodID(
+      env, clazz, "valueOf", "(I)Lorg/apache/mesos/Protos$TaskState;");
 
   jobject jstate = env->CallStaticObjectMethod(clazz, valueOf, jvalue);
 
@@ -414,11 +511,11 @@ jobject convert(JNIEnv* env, const TaskInfo& task)
   // TaskInfo task = TaskInfo.parseFrom(data);
   jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$TaskInfo");
 
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$TaskInfo;");
+  jmethodID parseFrom = GetMesosStaticMethodID(
+      env, clazz, "parseFrom", "([B)Lorg/apache/mesos/Protos$TaskInfo;");
 
   jobject jtask = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
+  env->DeleteLocalRef(jdata);
 
   return jtask;
 }
@@ -437,11 +534,11 @@ jobject convert(JNIEnv* env, const TaskStatus& status)
   // TaskStatus status = TaskStatus.parseFrom(data);
   jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$TaskStatus");
 
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$TaskStatus;");
+  jmethodID parseFrom = GetMesosStaticMethodID(
+      env, clazz, "parseFrom", "([B)Lorg/apache/mesos/Protos$TaskStatus;");
 
   jobject jstatus = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
+  env->DeleteLocalRef(jdata);
 
   return jstatus;
 }
@@ -460,11 +557,11 @@ jobject convert(JNIEnv* env, const Offer& offer)
   // Offer offer = Offer.parseFrom(data);
   jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$Offer");
 
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$Offer;");
+  jmethodID parseFrom = GetMesosStaticMethodID(
+      env, clazz, "parseFrom", "([B)Lorg/apache/mesos/Protos$Offer;");
 
   jobject joffer = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
+  env->DeleteLocalRef(jdata);
 
   return joffer;
 }
@@ -483,11 +580,11 @@ jobject convert(JNIEnv* env, const ExecutorInfo& executor)
   // ExecutorInfo executor = ExecutorInfo.parseFrom(data);
   jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$ExecutorInfo");
 
-  jmethodID parseFrom =
-    env->GetStaticMethodID(clazz, "parseFrom",
-                           "([B)Lorg/apache/mesos/Protos$ExecutorInfo;");
+  jmethodID parseFrom = GetMesosStaticMethodID(
+      env, clazz, "parseFrom", "([B)Lorg/apache/mesos/Protos$ExecutorInfo;");
 
   jobject jexecutor = env->CallStaticObjectMethod(clazz, parseFrom, jdata);
+  env->DeleteLocalRef(jdata);
 
   return jexecutor;
 }
@@ -500,9 +597,8 @@ jobject convert(JNIEnv* env, const Status& status)
 
   jclass clazz = FindMesosClass(env, "org/apache/mesos/Protos$Status");
 
-  jmethodID valueOf =
-    env->GetStaticMethodID(clazz, "valueOf",
-                           "(I)Lorg/apache/mesos/Protos$Status;");
+  jmethodID valueOf = GetMesosStaticMethodID(
+      env, clazz, "valueOf", "(I)Lorg/apache/mesos/Protos$Status;");
 
   jobject jstate = env->CallStaticObjectMethod(clazz, valueOf, jvalue);
 
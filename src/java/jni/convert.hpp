@@ -30,4 +30,10 @@ Result<jfieldID> getFieldID(
     const char* name,
     const char* signature);
 
+// Finds a Mesos class, also from threads that were attached to the
+// JVM from native code (and where 'FindClass' only searches the
+// system class loader). Returns a global reference, which the caller
+// must not delete.
+jclass FindMesosClass(JNIEnv* env, const char* className);
+
 #endif // __CONVERT_HPP__
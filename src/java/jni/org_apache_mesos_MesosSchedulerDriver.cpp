@@ -200,18 +200,21 @@ void JNIScheduler::resourceOffers(SchedulerDriver* driver,
 		     "(Lorg/apache/mesos/SchedulerDriver;"
 		     "Ljava/util/List;)V");
 
-  // List offers = new ArrayList();
+  // List offers = new ArrayList(offers.size());
   clazz = env->FindClass("java/util/ArrayList");
 
-  jmethodID _init_ = env->GetMethodID(clazz, "<init>", "()V");
-  jobject joffers = env->NewObject(clazz, _init_);
+  jmethodID _init_ = env->GetMethodID(clazz, "<init>", "(I)V");
+  jobject joffers = env->NewObject(clazz, _init_, (jint) offers.size());
 
   jmethodID add = env->GetMethodID(clazz, "add", "(Ljava/lang/Object;)Z");
 
-  // Loop through C++ vector and add each offer to the Java list.
+  // Loop through C++ vector and add each offer to the Java list,
+  // dropping the local references as we go so that a large batch
+  // of offers doesn't overflow the local reference table.
   foreach (const Offer& offer, offers) {
     jobject joffer = convert<Offer>(env, offer);
     env->CallBooleanMethod(joffers, add, joffer);
+    env->DeleteLocalRef(joffer);
   }
 
   env->ExceptionClear();
@@ -18,12 +18,17 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include <process/check.hpp>
+#include <process/collect.hpp>
 #include <process/future.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/foreach.hpp>
+#include <stout/option.hpp>
+
+#include "jvm/jvm.hpp"
 
 #include "state/state.hpp"
 
@@ -36,6 +41,94 @@ using process::Future;
 
 using std::set;
 using std::string;
+using std::vector;
+
+namespace {
+
+// Completes the Java 'AbstractState.Completion' of a callback based
+// operation with the outcome of 'future' and releases the global
+// reference to the completion. This runs on the thread that completed
+// the future, which is attached to the JVM only for the duration of
+// the call, unless the future was already complete, in which case we
+// are still on the Java thread that started the operation.
+void complete(
+    JavaVM* jvm,
+    jobject jcompletion,
+    const Future<Option<vector<Variable>>>& future)
+{
+  JNIEnv* env = NULL;
+
+  bool attached = false;
+  if (jvm->GetEnv(JNIENV_CAST(&env), JNI_VERSION_1_6) == JNI_EDETACHED) {
+    jvm->AttachCurrentThread(JNIENV_CAST(&env), NULL);
+    attached = true;
+  }
+
+  jclass clazz = env->GetObjectClass(jcompletion);
+
+  env->ExceptionClear();
+
+  if (future.isReady()) {
+    jobjectArray jvariables = NULL;
+
+    if (future.get().isSome()) {
+      const vector<Variable>& variables = future.get().get();
+
+      // We can't use 'FindClass' on a thread attached from native
+      // code as it would only search the system class loader.
+      jclass variableClazz =
+        FindMesosClass(env, "org/apache/mesos/state/Variable");
+
+      jmethodID _init_ = env->GetMethodID(variableClazz, "<init>", "()V");
+      jfieldID __variable = env->GetFieldID(variableClazz, "__variable", "J");
+
+      jvariables = env->NewObjectArray(variables.size(), variableClazz, NULL);
+
+      for (size_t i = 0; i < variables.size(); i++) {
+        jobject jvariable = env->NewObject(variableClazz, _init_);
+        env->SetLongField(
+            jvariable, __variable, (jlong) new Variable(variables[i]));
+
+        env->SetObjectArrayElement(jvariables, i, jvariable);
+        env->DeleteLocalRef(jvariable);
+      }
+    }
+
+    // completion.succeeded(variables);
+    jmethodID succeeded = env->GetMethodID(
+        clazz, "succeeded", "([Lorg/apache/mesos/state/Variable;)V");
+
+    env->CallVoidMethod(jcompletion, succeeded, jvariables);
+  } else if (future.isFailed()) {
+    // completion.failed(message);
+    jmethodID failed =
+      env->GetMethodID(clazz, "failed", "(Ljava/lang/String;)V");
+
+    jstring jmessage = env->NewStringUTF(future.failure().c_str());
+
+    env->CallVoidMethod(jcompletion, failed, jmessage);
+  } else {
+    // completion.discarded();
+    jmethodID discarded = env->GetMethodID(clazz, "discarded", "()V");
+
+    env->CallVoidMethod(jcompletion, discarded);
+  }
+
+  // The executor might have rejected the callback, there is nobody
+  // left to tell about it though.
+  if (env->ExceptionCheck()) {
+    env->ExceptionDescribe();
+    env->ExceptionClear();
+  }
+
+  env->DeleteGlobalRef(jcompletion);
+
+  if (attached) {
+    jvm->DetachCurrentThread();
+  }
+}
+
+} // namespace {
 
 extern "C" {
 
@@ -1322,4 +1415,89 @@ JNIEXPORT void JNICALL Java_org_apache_mesos_state_AbstractState_00024NamesFutur
       jfuture);
 }
 
+/*
+ * Class:     org_apache_mesos_state_AbstractState
+ * Method:    __fetch_async
+ * Signature: ([Ljava/lang/String;Lorg/apache/mesos/state/AbstractState$Completion;)V
+ */
+JNIEXPORT void JNICALL Java_org_apache_mesos_state_AbstractState__1_1fetch_1async
+  (JNIEnv* env, jobject thiz, jobjectArray jnames, jobject jcompletion)
+{
+  jclass clazz = env->GetObjectClass(thiz);
+
+  jfieldID __state = env->GetFieldID(clazz, "__state", "J");
+
+  State* state = (State*) env->GetLongField(thiz, __state);
+
+  // Start fetching all of the variables before waiting for any of
+  // them so that the whole batch is fetched concurrently.
+  vector<Future<Variable>> futures;
+
+  jsize length = env->GetArrayLength(jnames);
+  futures.reserve(length);
+
+  for (jsize i = 0; i < length; i++) {
+    jstring jname = (jstring) env->GetObjectArrayElement(jnames, i);
+    futures.push_back(state->fetch(construct<string>(env, jname)));
+    env->DeleteLocalRef(jname);
+  }
+
+  JavaVM* jvm = NULL;
+  env->GetJavaVM(&jvm);
+
+  jcompletion = env->NewGlobalRef(jcompletion);
+
+  process::collect(futures)
+    .then([](const vector<Variable>& variables) {
+      return Option<vector<Variable>>::some(variables);
+    })
+    .onAny([=](const Future<Option<vector<Variable>>>& future) {
+      complete(jvm, jcompletion, future);
+    });
+}
+
+
+/*
+ * Class:     org_apache_mesos_state_AbstractState
+ * Method:    __store_async
+ * Signature: ([Lorg/apache/mesos/state/Variable;Lorg/apache/mesos/state/AbstractState$Completion;)V
+ */
+JNIEXPORT void JNICALL Java_org_apache_mesos_state_AbstractState__1_1store_1async
+  (JNIEnv* env, jobject thiz, jobjectArray jvariables, jobject jcompletion)
+{
+  jclass clazz = env->GetObjectClass(thiz);
+
+  jfieldID __state = env->GetFieldID(clazz, "__state", "J");
+
+  State* state = (State*) env->GetLongField(thiz, __state);
+
+  vector<Variable> variables;
+
+  jsize length = env->GetArrayLength(jvariables);
+  variables.reserve(length);
+
+  for (jsize i = 0; i < length; i++) {
+    jobject jvariable = env->GetObjectArrayElement(jvariables, i);
+
+    clazz = env->GetObjectClass(jvariable);
+
+    jfieldID __variable = env->GetFieldID(clazz, "__variable", "J");
+
+    variables.push_back(
+        *((Variable*) env->GetLongField(jvariable, __variable)));
+
+    env->DeleteLocalRef(jvariable);
+  }
+
+  JavaVM* jvm = NULL;
+  env->GetJavaVM(&jvm);
+
+  jcompletion = env->NewGlobalRef(jcompletion);
+
+  state->store(variables)
+    .onAny([=](const Future<Option<vector<Variable>>>& future) {
+      complete(jvm, jcompletion, future);
+    });
+}
+
 } // extern "C" {
@@ -18,9 +18,13 @@
 
 package org.apache.mesos.state;
 
+import java.util.Arrays;
 import java.util.Iterator;
+import java.util.List;
 
+import java.util.concurrent.CancellationException;
 import java.util.concurrent.ExecutionException;
+import java.util.concurrent.Executor;
 import java.util.concurrent.Future;
 import java.util.concurrent.TimeoutException;
 import java.util.concurrent.TimeUnit;
@@ -216,8 +220,157 @@ public abstract class AbstractState implements State {
     };
   }
 
+  /**
+   * Fetches the variable with the specified name without blocking a
+   * thread: the callback is invoked through the executor once the
+   * variable has been fetched.
+   *
+   * @param name      The name of the variable.
+   * @param executor  The executor that invokes the callback.
+   * @param callback  The callback to invoke with the variable.
+   *
+   * @see State#fetch(String)
+   */
+  public void fetch(
+      String name,
+      Executor executor,
+      Callback<Variable> callback) {
+    __fetch_async(new String[] { name }, new Completion<Variable>(
+        executor, callback) {
+      @Override
+      protected Variable convert(Variable[] variables) {
+        return variables[0];
+      }
+    });
+  }
+
+  /**
+   * Fetches the variables with the specified names, crossing into the
+   * native library once for the whole batch. The callback is invoked
+   * through the executor with the variables in the order of the names
+   * once all of them have been fetched, or with the first failure.
+   *
+   * @param names     The names of the variables.
+   * @param executor  The executor that invokes the callback.
+   * @param callback  The callback to invoke with the variables.
+   */
+  public void fetch(
+      List<String> names,
+      Executor executor,
+      Callback<List<Variable>> callback) {
+    __fetch_async(
+        names.toArray(new String[names.size()]),
+        new Completion<List<Variable>>(executor, callback) {
+          @Override
+          protected List<Variable> convert(Variable[] variables) {
+            return Arrays.asList(variables);
+          }
+        });
+  }
+
+  /**
+   * Stores the specified variable without blocking a thread: the
+   * callback is invoked through the executor with the variable with
+   * the new value on success, or null if the variable was no longer
+   * valid.
+   *
+   * @param variable  The variable to be stored.
+   * @param executor  The executor that invokes the callback.
+   * @param callback  The callback to invoke with the stored variable.
+   *
+   * @see State#store(Variable)
+   */
+  public void store(
+      Variable variable,
+      Executor executor,
+      Callback<Variable> callback) {
+    __store_async(new Variable[] { variable }, new Completion<Variable>(
+        executor, callback) {
+      @Override
+      protected Variable convert(Variable[] variables) {
+        return variables == null ? null : variables[0];
+      }
+    });
+  }
+
+  /**
+   * Stores the specified variables at once, crossing into the native
+   * library once for the whole batch. Either all of the variables are
+   * stored or, if any of them was no longer valid, none of them is
+   * and the callback is invoked with null. The callback is invoked
+   * through the executor.
+   *
+   * @param variables  The variables to be stored.
+   * @param executor   The executor that invokes the callback.
+   * @param callback   The callback to invoke with the stored variables.
+   */
+  public void store(
+      List<Variable> variables,
+      Executor executor,
+      Callback<List<Variable>> callback) {
+    __store_async(
+        variables.toArray(new Variable[variables.size()]),
+        new Completion<List<Variable>>(executor, callback) {
+          @Override
+          protected List<Variable> convert(Variable[] stored) {
+            return stored == null ? null : Arrays.asList(stored);
+          }
+        });
+  }
+
   protected native void finalize();
 
+  // Completes a callback based operation. The native library invokes
+  // 'succeeded', 'failed', or 'discarded' exactly once, on the thread
+  // which completed the operation, and these only hand the result
+  // over to the executor so that the native thread is not held up by
+  // the callback. Being an inner class a completion also keeps this
+  // state (and so the native state) alive until the operation is done.
+  private abstract class Completion<T> {
+    public Completion(Executor executor, Callback<T> callback) {
+      this.executor = executor;
+      this.callback = callback;
+    }
+
+    protected abstract T convert(Variable[] variables);
+
+    final void succeeded(final Variable[] variables) {
+      executor.execute(new Runnable() {
+        @Override
+        public void run() {
+          callback.succeeded(convert(variables));
+        }
+      });
+    }
+
+    final void failed(final String message) {
+      executor.execute(new Runnable() {
+        @Override
+        public void run() {
+          callback.failed(new ExecutionException(message, null));
+        }
+      });
+    }
+
+    final void discarded() {
+      executor.execute(new Runnable() {
+        @Override
+        public void run() {
+          callback.failed(new CancellationException("Future was discarded"));
+        }
+      });
+    }
+
+    private final Executor executor;
+    private final Callback<T> callback;
+  }
+
+  private native void __fetch_async(String[] names, Completion<?> completion);
+
+  private native void __store_async(
+      Variable[] variables,
+      Completion<?> completion);
+
   // Native implementations of 'fetch', 'store', 'expunge', and 'names'. We wrap
   // them in classes to carry the java references correctly through the JNI
   // bindings (MESOS-2161). The native functions in AbstractState will be
@@ -0,0 +1,44 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.apache.mesos.state;
+
+/**
+ * Receives the result of an asynchronous operation on the state, see
+ * the callback based operations of {@link AbstractState}. Callbacks
+ * are invoked through the executor passed to the operation, never on
+ * the native threads which complete the operation.
+ */
+public interface Callback<T> {
+  /**
+   * Invoked with the result of a successful operation.
+   *
+   * @param result  The result of the operation, which is null for a
+   *                store which failed because a variable was no
+   *                longer valid.
+   */
+  void succeeded(T result);
+
+  /**
+   * Invoked when the operation failed or was discarded.
+   *
+   * @param t  An ExecutionException describing the failure, or a
+   *           CancellationException if the operation was discarded.
+   */
+  void failed(Throwable t);
+}
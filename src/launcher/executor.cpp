@@ -31,6 +31,7 @@
 #include <process/delay.hpp>
 #include <process/future.hpp>
 #include <process/io.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/protobuf.hpp>
 #include <process/subprocess.hpp>
@@ -49,6 +50,8 @@
 #include "common/http.hpp"
 #include "common/status_utils.hpp"
 
+#include "health-check/health_checker.hpp"
+
 #ifdef __linux__
 #include "linux/fs.hpp"
 #endif
@@ -79,17 +82,14 @@ class CommandExecutorProcess : public ProtobufProcess<CommandExecutorProcess>
 public:
   CommandExecutorProcess(
       const Option<char**>& override,
-      const string& _healthCheckDir,
       const Option<string>& _sandboxDirectory,
       const Option<string>& _user)
     : launched(false),
       killed(false),
       killedByHealthCheck(false),
       pid(-1),
-      healthPid(-1),
       escalationTimeout(slave::EXECUTOR_SIGNAL_ESCALATION_TIMEOUT),
       driver(None()),
-      healthCheckDir(_healthCheckDir),
       override(override),
       sandboxDirectory(_sandboxDirectory),
       user(_user) {}
@@ -396,10 +396,9 @@ public:
   void killTask(ExecutorDriver* driver, const TaskID& taskId)
   {
     shutdown(driver);
-    if (healthPid != -1) {
-      // Cleanup health check process.
-      os::killtree(healthPid, SIGKILL);
-    }
+
+    // Stop the health checks.
+    checker.reset();
   }
 
   void frameworkMessage(ExecutorDriver* driver, const string& data) {}
@@ -560,38 +559,20 @@ private:
   void launchHealthCheck(const TaskInfo& task)
   {
     if (task.has_health_check()) {
-      JSON::Object json = JSON::protobuf(task.health_check());
-
-      // Launch the subprocess using 'exec' style so that quotes can
-      // be properly handled.
-      vector<string> argv(4);
-      argv[0] = "mesos-health-check";
-      argv[1] = "--executor=" + stringify(self());
-      argv[2] = "--health_check_json=" + stringify(json);
-      argv[3] = "--task_id=" + task.task_id().value();
-
-      cout << "Launching health check process: "
-           << path::join(healthCheckDir, "mesos-health-check")
-           << " " << argv[1] << " " << argv[2] << " " << argv[3] << endl;
-
-      Try<Subprocess> healthProcess =
-        process::subprocess(
-          path::join(healthCheckDir, "mesos-health-check"),
-          argv,
-          // Intentionally not sending STDIN to avoid health check
-          // commands that expect STDIN input to block.
-          Subprocess::PATH("/dev/null"),
-          Subprocess::FD(STDOUT_FILENO),
-          Subprocess::FD(STDERR_FILENO));
-
-      if (healthProcess.isError()) {
-        cerr << "Unable to launch health process: " << healthProcess.error();
-      } else {
-        healthPid = healthProcess.get().pid();
+      Try<Owned<health::HealthChecker>> _checker =
+        health::HealthChecker::create(
+            task.health_check(), self(), task.task_id());
 
-        cout << "Health check process launched at pid: "
-             << stringify(healthPid) << endl;
+      if (_checker.isError()) {
+        cerr << "Unable to launch health check: " << _checker.error() << endl;
+        return;
       }
+
+      checker = _checker.get();
+      checker->healthCheck();
+
+      cout << "Launched health check for task '" << task.task_id() << "'"
+           << endl;
     }
   }
 
@@ -599,11 +580,10 @@ private:
   bool killed;
   bool killedByHealthCheck;
   pid_t pid;
-  pid_t healthPid;
+  Owned<health::HealthChecker> checker;
   Duration escalationTimeout;
   Timer escalationTimer;
   Option<ExecutorDriver*> driver;
-  string healthCheckDir;
   Option<char**> override;
   Option<string> sandboxDirectory;
   Option<string> user;
@@ -615,12 +595,10 @@ class CommandExecutor: public Executor
 public:
   CommandExecutor(
       const Option<char**>& override,
-      const string& healthCheckDir,
       const Option<string>& sandboxDirectory,
       const Option<string>& user)
   {
-    process = new CommandExecutorProcess(
-        override, healthCheckDir, sandboxDirectory, user);
+    process = new CommandExecutorProcess(override, sandboxDirectory, user);
     spawn(process);
   }
 
@@ -756,12 +734,8 @@ int main(int argc, char** argv)
     }
   }
 
-  const Option<string> envPath = os::getenv("MESOS_LAUNCHER_DIR");
-  string path =
-    envPath.isSome() ? envPath.get()
-                     : os::realpath(Path(argv[0]).dirname()).get();
   mesos::internal::CommandExecutor executor(
-      override, path, flags.sandbox_directory, flags.user);
+      override, flags.sandbox_directory, flags.user);
   mesos::MesosExecutorDriver driver(&executor);
   return driver.run() == mesos::DRIVER_STOPPED ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -14,7 +14,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <atomic>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <process/owned.hpp>
 
@@ -25,6 +29,7 @@
 #include <stout/path.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/strings.hpp>
+#include <stout/unreachable.hpp>
 
 #include <mesos/mesos.hpp>
 
@@ -45,10 +50,30 @@ using namespace mesos;
 using namespace mesos::internal;
 
 using std::string;
+using std::vector;
 
 using mesos::fetcher::FetcherInfo;
 
 using mesos::internal::slave::Fetcher;
+using mesos::internal::slave::FETCHER_CACHE_EXTRACTED_SUFFIX;
+
+// The number of times that an interrupted download is resumed.
+static const int DOWNLOAD_RESUME_ATTEMPTS = 3;
+
+
+// Whether 'extract' recognizes the file as an archive.
+static bool isArchive(const string& sourcePath)
+{
+  return strings::endsWith(sourcePath, ".tar") ||
+         strings::endsWith(sourcePath, ".tgz") ||
+         strings::endsWith(sourcePath, ".tar.gz") ||
+         strings::endsWith(sourcePath, ".tbz2") ||
+         strings::endsWith(sourcePath, ".tar.bz2") ||
+         strings::endsWith(sourcePath, ".txz") ||
+         strings::endsWith(sourcePath, ".tar.xz") ||
+         strings::endsWith(sourcePath, ".gz") ||
+         strings::endsWith(sourcePath, ".zip");
+}
 
 
 // Try to extract sourcePath into directory. If sourcePath is
@@ -132,11 +157,32 @@ static Try<string> downloadWithNet(
             << "' to '" << destinationPath << "'";
 
   Try<int> code = net::download(sourceUri, destinationPath);
+
+  // If the transfer broke off, we resume it where it stopped rather
+  // than downloading the resource again, as long as it progresses.
+  Bytes downloaded = 0;
+  for (int attempt = 0;
+       code.isError() && attempt < DOWNLOAD_RESUME_ATTEMPTS;
+       attempt++) {
+    Try<Bytes> size = os::stat::size(destinationPath);
+    if (size.isError() || size.get() <= downloaded) {
+      break;
+    }
+
+    downloaded = size.get();
+
+    LOG(WARNING) << "Resuming the download of '" << sourceUri << "' after "
+                 << downloaded << ", which failed with: " << code.error();
+
+    code = net::download(sourceUri, destinationPath, true);
+  }
+
   if (code.isError()) {
     return Error("Error downloading resource: " + code.error());
   } else {
-    // The status code for successful HTTP requests is 200, the status code
-    // for successful FTP file transfers is 226.
+    // The status code for successful HTTP requests is 200 (206 if the
+    // download was resumed), the status code for successful FTP file
+    // transfers is 226.
     if (strings::startsWith(sourceUri, "ftp://") ||
         strings::startsWith(sourceUri, "ftps://")) {
       if (code.get() != 226) {
@@ -144,7 +190,7 @@ static Try<string> downloadWithNet(
                      stringify(code.get()));
       }
     } else {
-      if (code.get() != 200) {
+      if (code.get() != 200 && (downloaded == 0 || code.get() != 206)) {
         return Error("Error downloading resource, received HTTP return code " +
                      stringify(code.get()));
       }
@@ -155,11 +201,21 @@ static Try<string> downloadWithNet(
 }
 
 
+// On Linux we let 'cp' clone the file if the file system supports
+// it (e.g., btrfs, XFS), so that copies from the cache share their
+// blocks with the cache file until either of them is modified.
+#ifdef __linux__
+static const string CP = "cp --reflink=auto";
+#else
+static const string CP = "cp";
+#endif // __linux__
+
+
 static Try<string> copyFile(
     const string& sourcePath,
     const string& destinationPath)
 {
-  const string command = "cp '" + sourcePath + "' '" + destinationPath + "'";
+  const string command = CP + " '" + sourcePath + "' '" + destinationPath + "'";
 
   LOG(INFO) << "Copying resource with command:" << command;
 
@@ -221,6 +277,49 @@ static Try<string> download(
 }
 
 
+// Copies the contents of a directory into another directory.
+static Try<string> copyDirectory(
+    const string& sourceDirectory,
+    const string& destinationDirectory)
+{
+  const string command =
+    CP + " -R -p '" + sourceDirectory + "/.' '" + destinationDirectory + "'";
+
+  LOG(INFO) << "Copying directory with command:" << command;
+
+  int status = os::system(command);
+  if (status != 0) {
+    return Error("Failed to copy with command '" + command +
+                 "', exit status: " + stringify(status));
+  }
+
+  return destinationDirectory;
+}
+
+
+static Try<Nothing> verifyChecksum(
+    const string& path,
+    const string& checksum)
+{
+  // NOTE: 'sha256sum' prints the digest followed by the file name.
+  Try<string> output = os::shell("sha256sum '" + path + "'");
+  if (output.isError()) {
+    return Error("Failed to compute the checksum: " + output.error());
+  }
+
+  const string digest = strings::tokenize(output.get(), " ").front();
+
+  if (strings::lower(digest) != strings::lower(checksum)) {
+    return Error("Checksum mismatch: expected " + checksum +
+                 " but got " + digest);
+  }
+
+  LOG(INFO) << "Verified checksum " << checksum << " of '" << path << "'";
+
+  return Nothing();
+}
+
+
 // TODO(bernd-mesos): Refactor this into stout so that we can more easily
 // chmod an exectuable. For example, we could define some static flags
 // so that someone can do: os::chmod(path, EXECUTABLE_CHMOD_FLAGS).
@@ -237,26 +336,142 @@ static Try<string> chmodExecutable(const string& filePath)
 }
 
 
+// Returns the cache directory of an item that uses the cache.
+static Try<string> itemCacheDirectory(
+    const FetcherInfo::Item& item,
+    const Option<string>& cacheDirectory)
+{
+  const Option<string> directory = item.has_cache_directory()
+    ? Option<string>(item.cache_directory())
+    : cacheDirectory;
+
+  if (directory.isNone() || directory.get().empty()) {
+    return Error("Cache directory not specified");
+  }
+
+  if (!item.has_cache_filename() || item.cache_filename().empty()) {
+    // This should never happen if this program is used by the Mesos
+    // slave and could then be a CHECK. But other uses are possible.
+    return Error("No cache file name for: " + item.uri().value());
+  }
+
+  return directory.get();
+}
+
+
+// Returns the path that the item is downloaded to, or none if it is
+// retrieved from the cache without downloading.
+static Try<Option<string>> downloadPath(
+    const FetcherInfo::Item& item,
+    const Option<string>& cacheDirectory,
+    const string& sandboxDirectory)
+{
+  switch (item.action()) {
+    case FetcherInfo::Item::BYPASS_CACHE: {
+      Try<string> basename = Fetcher::basename(item.uri().value());
+      if (basename.isError()) {
+        return Error("Failed to determine the basename of the URI '" +
+                     item.uri().value() + "' with error: " +
+                     basename.error());
+      }
+
+      return Some(path::join(sandboxDirectory, basename.get()));
+    }
+    case FetcherInfo::Item::DOWNLOAD_AND_CACHE: {
+      Try<string> directory = itemCacheDirectory(item, cacheDirectory);
+      if (directory.isError()) {
+        return Error(directory.error());
+      }
+
+      Try<Nothing> mkdir = os::mkdir(directory.get());
+      if (mkdir.isError()) {
+        return Error("Failed to create fetcher cache directory '" +
+                     directory.get() + "': " + mkdir.error());
+      }
+
+      return Some(path::join(directory.get(), item.cache_filename()));
+    }
+    case FetcherInfo::Item::RETRIEVE_FROM_CACHE:
+      return None();
+  }
+
+  UNREACHABLE();
+}
+
+
+// Downloads the items that need to be downloaded, up to 'concurrency'
+// of them at the same time, and returns the results by item index.
+// Only the downloads run concurrently, everything that touches the
+// sandbox is done in the order of the items afterwards.
+static vector<Option<Try<string>>> downloadAll(
+    const FetcherInfo& info,
+    const Option<string>& cacheDirectory,
+    const Option<string>& frameworksHome,
+    size_t concurrency)
+{
+  const int size = info.items_size();
+
+  vector<Option<Try<string>>> results(size);
+  vector<string> paths(size);
+
+  for (int i = 0; i < size; i++) {
+    Try<Option<string>> path = downloadPath(
+        info.items(i), cacheDirectory, info.sandbox_directory());
+
+    if (path.isError()) {
+      results[i] = Try<string>(Error(path.error()));
+    } else if (path.get().isSome()) {
+      paths[i] = path.get().get();
+    }
+  }
+
+  std::atomic<int> next(0);
+
+  auto downloader = [&]() {
+    for (int i = next++; i < size; i = next++) {
+      if (!paths[i].empty()) {
+        results[i] = download(info.items(i).uri().value(),
+                              paths[i],
+                              frameworksHome);
+      }
+    }
+  };
+
+  vector<std::thread> threads;
+  for (size_t i = 1; i < concurrency && i < (size_t) size; i++) {
+    threads.push_back(std::thread(downloader));
+  }
+
+  downloader();
+
+  foreach (std::thread& thread, threads) {
+    thread.join();
+  }
+
+  return results;
+}
+
+
 // Returns the resulting file or in case of extraction the destination
 // directory (for logging).
 static Try<string> fetchBypassingCache(
     const CommandInfo::URI& uri,
     const string& sandboxDirectory,
-    const Option<string>& frameworksHome)
+    const Try<string>& downloaded)
 {
   LOG(INFO) << "Fetching directly into the sandbox directory";
 
-  Try<string> basename = Fetcher::basename(uri.value());
-  if (basename.isError()) {
-    return Error("Failed to determine the basename of the URI '" +
-                 uri.value() + "' with error: " + basename.error());
+  if (downloaded.isError()) {
+    return Error(downloaded.error());
   }
 
-  string path = path::join(sandboxDirectory, basename.get());
+  const string& path = downloaded.get();
 
-  Try<string> downloaded = download(uri.value(), path, frameworksHome);
-  if (downloaded.isError()) {
-    return Error(downloaded.error());
+  if (uri.has_checksum()) {
+    Try<Nothing> verified = verifyChecksum(path, uri.checksum());
+    if (verified.isError()) {
+      return Error(verified.error());
+    }
   }
 
   if (uri.executable()) {
@@ -297,6 +512,10 @@ static Try<string> fetchFromCache(
 
   string sourcePath = path::join(cacheDirectory, item.cache_filename());
 
+  // An archive that has been extracted in the cache is copied from
+  // there instead of being extracted again, see 'extractIntoCache'.
+  string extractedPath = sourcePath + FETCHER_CACHE_EXTRACTED_SUFFIX;
+
   if (item.uri().executable()) {
     Try<string> copied = copyFile(sourcePath, destinationPath);
     if (copied.isError()) {
@@ -304,6 +523,8 @@ static Try<string> fetchFromCache(
     }
 
     return chmodExecutable(copied.get());
+  } else if (item.uri().extract() && os::exists(extractedPath)) {
+    return copyDirectory(extractedPath, sandboxDirectory);
   } else if (item.uri().extract()) {
     Try<bool> extracted = extract(sourcePath, sandboxDirectory);
     if (extracted.isError()) {
@@ -321,47 +542,102 @@ static Try<string> fetchFromCache(
 }
 
 
+// Extracts an archive that has just been downloaded into the cache
+// next to it, so that fetching it from the cache does not need to
+// extract it again. The agent accounts for the extracted files in the
+// cache size when the download completes. We do not do this for cache
+// files that are already in the cache, whose space is accounted for.
+static Try<Nothing> extractIntoCache(
+    const FetcherInfo::Item& item,
+    const string& cacheDirectory)
+{
+  const string sourcePath =
+    path::join(cacheDirectory, item.cache_filename());
+
+  if (item.uri().executable() ||
+      !item.uri().extract() ||
+      !isArchive(sourcePath)) {
+    return Nothing();
+  }
+
+  // The extraction only becomes visible to the other fetches of the
+  // cache file once it has been completed.
+  const string extractedPath = sourcePath + FETCHER_CACHE_EXTRACTED_SUFFIX;
+  const string temporaryPath = extractedPath + ".tmp";
+
+  if (os::exists(temporaryPath)) {
+    Try<Nothing> rmdir = os::rmdir(temporaryPath);
+    if (rmdir.isError()) {
+      return Error("Failed to remove '" + temporaryPath + "': " +
+                   rmdir.error());
+    }
+  }
+
+  Try<Nothing> mkdir = os::mkdir(temporaryPath);
+  if (mkdir.isError()) {
+    return Error("Failed to create '" + temporaryPath + "': " +
+                 mkdir.error());
+  }
+
+  Try<bool> extracted = extract(sourcePath, temporaryPath);
+  if (extracted.isError()) {
+    os::rmdir(temporaryPath);
+    return Error(extracted.error());
+  }
+
+  Try<Nothing> rename = os::rename(temporaryPath, extractedPath);
+  if (rename.isError()) {
+    os::rmdir(temporaryPath);
+    return Error("Failed to rename '" + temporaryPath + "' to '" +
+                 extractedPath + "': " + rename.error());
+  }
+
+  return Nothing();
+}
+
+
 // Returns the resulting file or in case of extraction the destination
 // directory (for logging).
 static Try<string> fetchThroughCache(
     const FetcherInfo::Item& item,
     const Option<string>& cacheDirectory,
     const string& sandboxDirectory,
-    const Option<string>& frameworksHome)
+    const Option<Try<string>>& downloaded)
 {
-  if (cacheDirectory.isNone() || cacheDirectory.get().empty()) {
-    return Error("Cache directory not specified");
-  }
-
-  if (!item.has_cache_filename() || item.cache_filename().empty()) {
-    // This should never happen if this program is used by the Mesos
-    // slave and could then be a CHECK. But other uses are possible.
-    return Error("No cache file name for: " + item.uri().value());
+  Try<string> directory = itemCacheDirectory(item, cacheDirectory);
+  if (directory.isError()) {
+    return Error(directory.error());
   }
 
   CHECK_NE(FetcherInfo::Item::BYPASS_CACHE, item.action())
     << "Unexpected fetcher action selector";
 
   if (item.action() == FetcherInfo::Item::DOWNLOAD_AND_CACHE) {
-    LOG(INFO) << "Downloading into cache";
+    CHECK_SOME(downloaded);
 
-    Try<Nothing> mkdir = os::mkdir(cacheDirectory.get());
-    if (mkdir.isError()) {
-      return Error("Failed to create fetcher cache directory '" +
-                   cacheDirectory.get() + "': " + mkdir.error());
+    if (downloaded.get().isError()) {
+      return Error(downloaded.get().error());
     }
 
-    Try<string> downloaded = download(
-        item.uri().value(),
-        path::join(cacheDirectory.get(), item.cache_filename()),
-        frameworksHome);
+    if (item.uri().has_checksum()) {
+      Try<Nothing> verified =
+        verifyChecksum(downloaded.get().get(), item.uri().checksum());
+
+      if (verified.isError()) {
+        return Error(verified.error());
+      }
+    }
 
-    if (downloaded.isError()) {
-      return Error(downloaded.error());
+    // If the extraction fails we still extract from the cache file
+    // into the sandbox below, which reports any problem with it.
+    Try<Nothing> extracted = extractIntoCache(item, directory.get());
+    if (extracted.isError()) {
+      LOG(WARNING) << "Failed to extract '" << downloaded.get().get()
+                   << "' in the cache: " << extracted.error();
     }
   }
 
-  return fetchFromCache(item, cacheDirectory.get(), sandboxDirectory);
+  return fetchFromCache(item, directory.get(), sandboxDirectory);
 }
 
 
@@ -371,22 +647,24 @@ static Try<string> fetch(
     const FetcherInfo::Item& item,
     const Option<string>& cacheDirectory,
     const string& sandboxDirectory,
-    const Option<string>& frameworksHome)
+    const Option<Try<string>>& downloaded)
 {
   LOG(INFO) << "Fetching URI '" << item.uri().value() << "'";
 
   if (item.action() == FetcherInfo::Item::BYPASS_CACHE) {
+    CHECK_SOME(downloaded);
+
     return fetchBypassingCache(
         item.uri(),
         sandboxDirectory,
-        frameworksHome);
+        downloaded.get());
   }
 
   return fetchThroughCache(
       item,
       cacheDirectory,
       sandboxDirectory,
-      frameworksHome);
+      downloaded);
 }
 
 
@@ -442,10 +720,20 @@ int main(int argc, char* argv[])
       Option<string>::some(fetcherInfo.get().frameworks_home()) :
         Option<string>::none();
 
+  // The slave limits the number of concurrent downloads of all the
+  // fetcher programs that are running.
+  const size_t concurrency =
+    std::max(1u, fetcherInfo.get().max_concurrent_downloads());
+
+  const vector<Option<Try<string>>> downloaded = downloadAll(
+      fetcherInfo.get(), cacheDirectory, frameworksHome, concurrency);
+
   // Fetch each URI to a local file, chmod, then chown if a user is provided.
-  foreach (const FetcherInfo::Item& item, fetcherInfo.get().items()) {
+  for (int i = 0; i < fetcherInfo.get().items_size(); i++) {
+    const FetcherInfo::Item& item = fetcherInfo.get().items(i);
+
     Try<string> fetched =
-      fetch(item, cacheDirectory, sandboxDirectory, frameworksHome);
+      fetch(item, cacheDirectory, sandboxDirectory, downloaded[i]);
     if (fetched.isError()) {
       EXIT(1) << "Failed to fetch '" << item.uri().value()
               << "': " + fetched.error();
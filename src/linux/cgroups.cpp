@@ -15,18 +15,23 @@
 // limitations under the License.
 
 #include <errno.h>
+#include <fcntl.h>
 #include <fts.h>
 #include <signal.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
+#include <sys/inotify.h>
 #include <sys/syscall.h>
+#include <sys/sysmacros.h>
 #include <sys/types.h>
 
 #include <glog/logging.h>
 
 #include <fstream>
+#include <deque>
 #include <list>
 #include <map>
 #include <set>
@@ -37,7 +42,9 @@
 #include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/delay.hpp>
+#include <process/id.hpp>
 #include <process/io.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/reap.hpp>
 
@@ -47,6 +54,7 @@
 #include <stout/hashset.hpp>
 #include <stout/lambda.hpp>
 #include <stout/none.hpp>
+#include <stout/numify.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
@@ -1376,6 +1384,14 @@ Try<Nothing> state(
 
 } // namespace freezer {
 
+// A freezer cgroup usually reaches the requested state within a few
+// milliseconds, so the state is checked again after an interval that
+// starts small and backs off exponentially. The freezer subsystem of
+// cgroups v1 has no notification of state changes.
+static const Duration MIN_FREEZER_INTERVAL = Milliseconds(1);
+static const Duration MAX_FREEZER_INTERVAL = Milliseconds(100);
+
+
 class Freezer : public Process<Freezer>
 {
 public:
@@ -1384,7 +1400,8 @@ public:
       const string& _cgroup)
     : hierarchy(_hierarchy),
       cgroup(_cgroup),
-      start(Clock::now()) {}
+      start(Clock::now()),
+      interval(MIN_FREEZER_INTERVAL) {}
 
   virtual ~Freezer() {}
 
@@ -1415,7 +1432,7 @@ public:
     }
 
     // Attempt to freeze the freezer cgroup again.
-    delay(Milliseconds(100), self(), &Self::freeze);
+    delay(backoff(), self(), &Self::freeze);
   }
 
   void thaw()
@@ -1444,7 +1461,7 @@ public:
     }
 
     // Attempt to thaw the freezer cgroup again.
-    delay(Milliseconds(100), self(), &Self::thaw);
+    delay(backoff(), self(), &Self::thaw);
   }
 
   Future<Nothing> future() { return promise.future(); }
@@ -1470,9 +1487,18 @@ protected:
   }
 
 private:
+  // Returns the interval after which to check the state again.
+  Duration backoff()
+  {
+    const Duration current = interval;
+    interval = std::min(interval * 2, MAX_FREEZER_INTERVAL);
+    return current;
+  }
+
   const string hierarchy;
   const string cgroup;
   const Time start;
+  Duration interval;
   Promise<Nothing> promise;
 };
 
@@ -1616,6 +1642,91 @@ private:
 };
 
 
+// The maximum number of cgroups whose tasks are killed at the same
+// time, by all the destroys. Freezing a large number of cgroups at
+// once slows all of them down.
+static const size_t MAX_CONCURRENT_TASKS_KILLERS = 32;
+
+
+// The process that runs the TasksKillers of all the destroys, at most
+// MAX_CONCURRENT_TASKS_KILLERS of them at a time, in the order they
+// are requested.
+class TasksKillers : public Process<TasksKillers>
+{
+public:
+  TasksKillers()
+    : ProcessBase(ID::generate("cgroups-tasks-killers")),
+      active(0) {}
+
+  virtual ~TasksKillers() {}
+
+  // Kills all tasks in the cgroup once a killer is available.
+  // Discarding the returned future stops the killer, or removes the
+  // cgroup from the queue if its killer has not started yet.
+  Future<Nothing> kill(const string& hierarchy, const string& cgroup)
+  {
+    Owned<Promise<Nothing>> promise(new Promise<Nothing>());
+    queue.push_back(Request{hierarchy, cgroup, promise});
+
+    next();
+
+    return promise->future();
+  }
+
+private:
+  struct Request
+  {
+    string hierarchy;
+    string cgroup;
+    Owned<Promise<Nothing>> promise;
+  };
+
+  void next()
+  {
+    while (active < MAX_CONCURRENT_TASKS_KILLERS && !queue.empty()) {
+      Request request = queue.front();
+      queue.pop_front();
+
+      if (request.promise->future().hasDiscard()) {
+        request.promise->discard();
+        continue;
+      }
+
+      TasksKiller* killer = new TasksKiller(request.hierarchy, request.cgroup);
+      Future<Nothing> future = killer->future();
+      spawn(killer, true);
+
+      active++;
+
+      // A discarded request discards the killer, which terminates.
+      request.promise->associate(future);
+
+      future.onAny(defer(self(), &Self::finished));
+    }
+  }
+
+  void finished()
+  {
+    CHECK_GT(active, 0u);
+    active--;
+
+    next();
+  }
+
+  size_t active;
+  std::deque<Request> queue;
+};
+
+
+static PID<TasksKillers> killers()
+{
+  static TasksKillers* killers = new TasksKillers();
+  static const PID<TasksKillers> pid = spawn(killers);
+
+  return pid;
+}
+
+
 // The process used to destroy a cgroup.
 class Destroyer : public Process<Destroyer>
 {
@@ -1639,10 +1750,11 @@ protected:
     // Kill tasks in the given cgroups in parallel. Use collect mechanism to
     // wait until all kill processes finish.
     foreach (const string& cgroup, cgroups) {
-      internal::TasksKiller* killer =
-        new internal::TasksKiller(hierarchy, cgroup);
-      killers.push_back(killer->future());
-      spawn(killer, true);
+      killers.push_back(dispatch(
+          internal::killers(),
+          &internal::TasksKillers::kill,
+          hierarchy,
+          cgroup));
     }
 
     collect(killers)
@@ -1862,6 +1974,186 @@ Try<hashmap<string, uint64_t>> stat(
 }
 
 
+Try<Nothing> stat(
+    const string& contents,
+    const std::initializer_list<StatField>& fields)
+{
+  const char* line = contents.c_str();
+  const char* end = line + contents.size();
+
+  while (line < end) {
+    const char* eol = static_cast<const char*>(
+        ::memchr(line, '\n', end - line));
+
+    if (eol == NULL) {
+      eol = end;
+    }
+
+    // Skip empty lines.
+    if (eol == line) {
+      line = eol + 1;
+      continue;
+    }
+
+    // Expected line format: "%s %llu".
+    const char* separator = static_cast<const char*>(
+        ::memchr(line, ' ', eol - line));
+
+    char* last = NULL;
+    uint64_t value = 0;
+
+    if (separator != NULL && separator != line) {
+      errno = 0;
+      value = ::strtoull(separator + 1, &last, 10);
+    }
+
+    if (last == NULL || last == separator + 1 || last != eol || errno != 0) {
+      return Error(
+          "Unexpected line format: " + string(line, eol - line));
+    }
+
+    const size_t length = separator - line;
+
+    foreach (const StatField& field, fields) {
+      if (::strncmp(field.name, line, length) == 0 &&
+          field.name[length] == '\0') {
+        *field.value = value;
+        break;
+      }
+    }
+
+    line = eol + 1;
+  }
+
+  return Nothing();
+}
+
+
+Try<Owned<Control>> Control::open(
+    const string& hierarchy,
+    const string& cgroup,
+    const string& control,
+    bool unified)
+{
+  const string path = path::join(hierarchy, cgroup, control);
+
+  if (!unified) {
+    Option<Error> error = verify(hierarchy, cgroup, control);
+    if (error.isSome()) {
+      return error.get();
+    }
+  } else {
+    Try<bool> mounted = unified::mounted(hierarchy);
+    if (mounted.isError()) {
+      return Error(
+          "Failed to determine if the unified hierarchy at '" + hierarchy +
+          "' is mounted: " + mounted.error());
+    } else if (!mounted.get()) {
+      return Error("'" + hierarchy + "' is not a valid unified hierarchy");
+    } else if (!os::exists(path)) {
+      return Error("'" + control + "' is not a valid control");
+    }
+  }
+
+  Try<int> fd = os::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd.isError()) {
+    return Error("Failed to open '" + path + "': " + fd.error());
+  }
+
+  return Owned<Control>(new Control(path, fd.get()));
+}
+
+
+Control::Control(const string& _path, int _fd)
+  : path(_path),
+    fd(_fd)
+{
+  // Most control files fit in a page; the buffer grows as needed and
+  // keeps its capacity across reads.
+  buffer.reserve(os::pagesize());
+}
+
+
+Control::~Control()
+{
+  os::close(fd);
+}
+
+
+Try<Nothing> Control::read()
+{
+  // The kernel generates the contents of a control file on each read
+  // from offset 0, so we use pread(2) rather than reopening the file.
+  // Resizing within the capacity of the buffer does not allocate.
+  size_t length = 0;
+
+  while (true) {
+    if (buffer.capacity() - length < static_cast<size_t>(os::pagesize())) {
+      buffer.reserve(2 * buffer.capacity());
+    }
+
+    buffer.resize(buffer.capacity());
+
+    ssize_t n = ::pread(fd, &buffer[length], buffer.size() - length, length);
+
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      ErrnoError error("Failed to read '" + path + "'");
+      buffer.clear();
+      return error;
+    } else if (n == 0) {
+      break;
+    }
+
+    length += n;
+  }
+
+  buffer.resize(length);
+
+  return Nothing();
+}
+
+
+Try<uint64_t> Control::value()
+{
+  Try<Nothing> read = Control::read();
+  if (read.isError()) {
+    return Error(read.error());
+  }
+
+  char* last = NULL;
+
+  errno = 0;
+  const uint64_t value = ::strtoull(buffer.c_str(), &last, 10);
+
+  if (last == buffer.c_str() || errno != 0 ||
+      (*last != '\0' && *last != '\n')) {
+    return Error("Failed to parse '" + path + "': '" + buffer + "'");
+  }
+
+  return value;
+}
+
+
+Try<Nothing> Control::stat(const std::initializer_list<StatField>& fields)
+{
+  Try<Nothing> read = Control::read();
+  if (read.isError()) {
+    return Error(read.error());
+  }
+
+  Try<Nothing> stat = cgroups::stat(buffer, fields);
+  if (stat.isError()) {
+    return Error("Failed to parse '" + path + "': " + stat.error());
+  }
+
+  return Nothing();
+}
+
+
 namespace internal {
 
 // Helper for finding the cgroup of the specified pid for the
@@ -2037,6 +2329,207 @@ Try<Stats> stat(
 
 } // namespace cpuacct {
 
+
+namespace cpuset {
+
+Try<set<unsigned int>> parse(const string& list)
+{
+  set<unsigned int> ids;
+
+  foreach (const string& token, strings::tokenize(strings::trim(list), ",")) {
+    const vector<string> range = strings::split(token, "-");
+    if (range.size() > 2) {
+      return Error("Invalid range '" + token + "'");
+    }
+
+    Try<unsigned int> first = numify<unsigned int>(range[0]);
+    if (first.isError()) {
+      return Error("Invalid id '" + range[0] + "': " + first.error());
+    }
+
+    Try<unsigned int> last = first;
+    if (range.size() == 2) {
+      last = numify<unsigned int>(range[1]);
+      if (last.isError()) {
+        return Error("Invalid id '" + range[1] + "': " + last.error());
+      } else if (last.get() < first.get()) {
+        return Error("Invalid range '" + token + "'");
+      }
+    }
+
+    for (unsigned int id = first.get(); id <= last.get(); id++) {
+      ids.insert(id);
+    }
+  }
+
+  return ids;
+}
+
+
+string format(const set<unsigned int>& ids)
+{
+  vector<string> ranges;
+
+  set<unsigned int>::const_iterator iterator = ids.begin();
+  while (iterator != ids.end()) {
+    const unsigned int first = *iterator;
+    unsigned int last = first;
+
+    while (++iterator != ids.end() && *iterator == last + 1) {
+      last = *iterator;
+    }
+
+    if (first == last) {
+      ranges.push_back(stringify(first));
+    } else {
+      ranges.push_back(stringify(first) + "-" + stringify(last));
+    }
+  }
+
+  return strings::join(",", ranges);
+}
+
+
+Try<set<unsigned int>> cpus(
+    const string& hierarchy,
+    const string& cgroup)
+{
+  Try<string> read = cgroups::read(hierarchy, cgroup, "cpuset.cpus");
+
+  if (read.isError()) {
+    return Error(read.error());
+  }
+
+  return parse(read.get());
+}
+
+
+Try<Nothing> cpus(
+    const string& hierarchy,
+    const string& cgroup,
+    const set<unsigned int>& cpus)
+{
+  return cgroups::write(hierarchy, cgroup, "cpuset.cpus", format(cpus));
+}
+
+
+Try<set<unsigned int>> mems(
+    const string& hierarchy,
+    const string& cgroup)
+{
+  Try<string> read = cgroups::read(hierarchy, cgroup, "cpuset.mems");
+
+  if (read.isError()) {
+    return Error(read.error());
+  }
+
+  return parse(read.get());
+}
+
+
+Try<Nothing> mems(
+    const string& hierarchy,
+    const string& cgroup,
+    const set<unsigned int>& mems)
+{
+  return cgroups::write(hierarchy, cgroup, "cpuset.mems", format(mems));
+}
+
+} // namespace cpuset {
+
+
+namespace blkio {
+
+Try<Nothing> weight(
+    const string& hierarchy,
+    const string& cgroup,
+    uint16_t weight)
+{
+  return cgroups::write(hierarchy, cgroup, "blkio.weight", stringify(weight));
+}
+
+
+Try<Nothing> throttle(
+    const string& hierarchy,
+    const string& cgroup,
+    const string& control,
+    dev_t device,
+    uint64_t limit)
+{
+  return cgroups::write(
+      hierarchy,
+      cgroup,
+      control,
+      stringify(major(device)) + ":" + stringify(minor(device)) + " " +
+      stringify(limit));
+}
+
+
+Try<vector<Value>> parse(const string& stats)
+{
+  vector<Value> values;
+
+  foreach (const string& line, strings::tokenize(stats, "\n")) {
+    const vector<string> fields = strings::tokenize(line, " ");
+    if (fields.empty() || fields.size() > 3) {
+      return Error("Invalid entry '" + line + "'");
+    }
+
+    Value value;
+
+    // The totals are the only entries without a device.
+    size_t index = 0;
+    if (fields[0] != "Total") {
+      const vector<string> numbers = strings::split(fields[0], ":");
+      if (numbers.size() != 2) {
+        return Error("Invalid device '" + fields[0] + "'");
+      }
+
+      Try<unsigned int> _major = numify<unsigned int>(numbers[0]);
+      Try<unsigned int> _minor = numify<unsigned int>(numbers[1]);
+      if (_major.isError() || _minor.isError()) {
+        return Error("Invalid device '" + fields[0] + "'");
+      }
+
+      value.device = makedev(_major.get(), _minor.get());
+      index++;
+    }
+
+    if (fields.size() - index == 2) {
+      value.operation = fields[index++];
+    } else if (fields.size() - index != 1) {
+      return Error("Invalid entry '" + line + "'");
+    }
+
+    Try<uint64_t> number = numify<uint64_t>(fields[index]);
+    if (number.isError()) {
+      return Error("Invalid value '" + fields[index] + "': " + number.error());
+    }
+
+    value.value = number.get();
+    values.push_back(value);
+  }
+
+  return values;
+}
+
+
+Try<vector<Value>> stat(
+    const string& hierarchy,
+    const string& cgroup,
+    const string& control)
+{
+  Try<string> read = cgroups::read(hierarchy, cgroup, control);
+
+  if (read.isError()) {
+    return Error(read.error());
+  }
+
+  return parse(read.get());
+}
+
+} // namespace blkio {
+
 namespace memory {
 
 Result<string> cgroup(pid_t pid)
@@ -2457,4 +2950,1050 @@ Future<Nothing> thaw(
 
 } // namespace freezer {
 
+namespace unified {
+
+// Returns some error string if either (a) the unified hierarchy is not
+// mounted at the given path, (b) cgroup does not exist, or (c) control
+// file does not exist.
+static Option<Error> verify(
+    const string& hierarchy,
+    const string& cgroup = "",
+    const string& control = "")
+{
+  Try<bool> mounted = unified::mounted(hierarchy);
+  if (mounted.isError()) {
+    return Error(
+        "Failed to determine if the unified hierarchy at '" + hierarchy +
+        "' is mounted: " + mounted.error());
+  } else if (!mounted.get()) {
+    return Error("'" + hierarchy + "' is not a unified hierarchy");
+  }
+
+  if (cgroup != "") {
+    if (!os::exists(path::join(hierarchy, cgroup))) {
+      return Error("'" + cgroup + "' is not a valid cgroup");
+    }
+  }
+
+  if (control != "") {
+    if (!os::exists(path::join(hierarchy, cgroup, control))) {
+      return Error(
+          "'" + control + "' is not a valid control "
+          "(is the controller enabled?)");
+    }
+  }
+
+  return None();
+}
+
+
+bool enabled()
+{
+  // The file systems supported by the kernel are listed one per line
+  // as "[nodev]\t<type>".
+  ifstream file("/proc/filesystems");
+
+  string line;
+  while (getline(file, line)) {
+    vector<string> tokens = strings::tokenize(line, " \t");
+    if (!tokens.empty() && tokens.back() == "cgroup2") {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+Result<string> hierarchy()
+{
+  Try<fs::MountTable> table = fs::MountTable::read("/proc/mounts");
+  if (table.isError()) {
+    return Error(table.error());
+  }
+
+  foreach (const fs::MountTable::Entry& entry, table.get().entries) {
+    if (entry.type == "cgroup2") {
+      return entry.dir;
+    }
+  }
+
+  return None();
+}
+
+
+Try<Nothing> mount(const string& hierarchy)
+{
+  if (!enabled()) {
+    return Error("The unified hierarchy is not supported by the kernel");
+  }
+
+  if (!os::exists(hierarchy)) {
+    Try<Nothing> mkdir = os::mkdir(hierarchy);
+    if (mkdir.isError()) {
+      return Error(
+          "Failed to create directory '" + hierarchy + "': " + mkdir.error());
+    }
+  }
+
+  return fs::mount("cgroup2", hierarchy, "cgroup2", 0, None());
+}
+
+
+Try<Nothing> unmount(const string& hierarchy)
+{
+  Option<Error> error = verify(hierarchy);
+  if (error.isSome()) {
+    return error.get();
+  }
+
+  return fs::unmount(hierarchy);
+}
+
+
+Try<bool> mounted(const string& hierarchy)
+{
+  if (!os::exists(hierarchy)) {
+    return false;
+  }
+
+  // We compare canonicalized absolute paths.
+  Result<string> realpath = os::realpath(hierarchy);
+  if (!realpath.isSome()) {
+    return Error(
+        "Failed to determine canonical path of '" + hierarchy + "': " +
+        (realpath.isError()
+         ? realpath.error()
+         : "No such file or directory"));
+  }
+
+  Try<fs::MountTable> table = fs::MountTable::read("/proc/mounts");
+  if (table.isError()) {
+    return Error(table.error());
+  }
+
+  foreach (const fs::MountTable::Entry& entry, table.get().entries) {
+    if (entry.type == "cgroup2") {
+      Result<string> dir = os::realpath(entry.dir);
+      if (dir.isSome() && dir.get() == realpath.get()) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+
+Try<string> prepare(
+    const string& hierarchy,
+    const string& root,
+    const set<string>& controllers)
+{
+  // Use the unified hierarchy where it is mounted already, e.g., by
+  // systemd, since there can be only one.
+  Result<string> mounted = unified::hierarchy();
+  if (mounted.isError()) {
+    return Error(
+        "Failed to determine the unified hierarchy: " + mounted.error());
+  }
+
+  if (mounted.isNone()) {
+    Try<Nothing> mount = unified::mount(hierarchy);
+    if (mount.isError()) {
+      return Error(
+          "Failed to mount the unified hierarchy at '" + hierarchy + "': " +
+          mount.error());
+    }
+
+    mounted = hierarchy;
+  }
+
+  // A controller attached to a cgroups v1 hierarchy is not available
+  // in the unified hierarchy.
+  Try<set<string>> available = unified::controllers(mounted.get());
+  if (available.isError()) {
+    return Error(available.error());
+  }
+
+  foreach (const string& controller, controllers) {
+    if (available.get().count(controller) == 0) {
+      return Error(
+          "The '" + controller + "' controller is not available in the "
+          "unified hierarchy at '" + mounted.get() + "' (is it attached "
+          "to a cgroups v1 hierarchy?)");
+    }
+  }
+
+  Try<Nothing> create = unified::create(mounted.get(), root, controllers);
+  if (create.isError()) {
+    return Error(
+        "Failed to create root cgroup '" + root + "': " + create.error());
+  }
+
+  Try<Nothing> enable = unified::enable(mounted.get(), root, controllers);
+  if (enable.isError()) {
+    return Error(enable.error());
+  }
+
+  return mounted.get();
+}
+
+
+// Writes a control file of a cgroup.
+static Try<Nothing> write(
+    const string& hierarchy,
+    const string& cgroup,
+    const string& control,
+    const string& value)
+{
+  Option<Error> error = verify(hierarchy, cgroup, control);
+  if (error.isSome()) {
+    return error.get();
+  }
+
+  Try<Nothing> write =
+    cgroups::internal::write(hierarchy, cgroup, control, value);
+
+  if (write.isError()) {
+    return Error(
+        "Failed to write control '" + control + "': " + write.error());
+  }
+
+  return Nothing();
+}
+
+
+// Reads a control file of a cgroup.
+static Try<string> read(
+    const string& hierarchy,
+    const string& cgroup,
+    const string& control)
+{
+  Option<Error> error = verify(hierarchy, cgroup, control);
+  if (error.isSome()) {
+    return error.get();
+  }
+
+  Try<string> read = cgroups::internal::read(hierarchy, cgroup, control);
+  if (read.isError()) {
+    return Error(
+        "Failed to read control '" + control + "': " + read.error());
+  }
+
+  return read.get();
+}
+
+
+// Reads a control file that lists controllers separated by spaces.
+static Try<set<string>> _controllers(
+    const string& hierarchy,
+    const string& cgroup,
+    const string& control)
+{
+  Option<Error> error = verify(hierarchy, cgroup, control);
+  if (error.isSome()) {
+    return error.get();
+  }
+
+  Try<string> read = cgroups::internal::read(hierarchy, cgroup, control);
+  if (read.isError()) {
+    return Error(
+        "Failed to read control '" + control + "': " + read.error());
+  }
+
+  set<string> controllers;
+  foreach (const string& controller, strings::tokenize(read.get(), " \n")) {
+    controllers.insert(controller);
+  }
+
+  return controllers;
+}
+
+
+Try<set<string>> controllers(const string& hierarchy, const string& cgroup)
+{
+  return _controllers(hierarchy, cgroup, "cgroup.controllers");
+}
+
+
+Try<set<string>> enabled(const string& hierarchy, const string& cgroup)
+{
+  return _controllers(hierarchy, cgroup, "cgroup.subtree_control");
+}
+
+
+Try<Nothing> enable(
+    const string& hierarchy,
+    const string& cgroup,
+    const set<string>& controllers)
+{
+  if (controllers.empty()) {
+    return Nothing();
+  }
+
+  Option<Error> error = verify(hierarchy, cgroup, "cgroup.subtree_control");
+  if (error.isSome()) {
+    return error.get();
+  }
+
+  vector<string> changes;
+  foreach (const string& controller, controllers) {
+    changes.push_back("+" + controller);
+  }
+
+  Try<Nothing> write = cgroups::internal::write(
+      hierarchy,
+      cgroup,
+      "cgroup.subtree_control",
+      strings::join(" ", changes));
+
+  if (write.isError()) {
+    return Error(
+        "Failed to enable controllers '" + stringify(controllers) +
+        "' in cgroup '" + cgroup + "': " + write.error());
+  }
+
+  return Nothing();
+}
+
+
+Try<Nothing> create(
+    const string& hierarchy,
+    const string& cgroup,
+    const set<string>& controllers)
+{
+  Option<Error> error = verify(hierarchy);
+  if (error.isSome()) {
+    return error.get();
+  }
+
+  const vector<string> components = strings::tokenize(cgroup, "/");
+  if (components.empty()) {
+    return Error("The root cgroup cannot be created");
+  }
+
+  // Each ancestor has to enable the controllers for its children,
+  // starting with the root cgroup, before the next level is created.
+  string current = "/";
+  foreach (const string& component, components) {
+    Try<set<string>> enabled = unified::enabled(hierarchy, current);
+    if (enabled.isError()) {
+      return Error(enabled.error());
+    }
+
+    set<string> missing;
+    foreach (const string& controller, controllers) {
+      if (enabled.get().count(controller) == 0) {
+        missing.insert(controller);
+      }
+    }
+
+    Try<Nothing> enable = unified::enable(hierarchy, current, missing);
+    if (enable.isError()) {
+      return Error(enable.error());
+    }
+
+    current = path::join(current, component);
+
+    const string path = path::join(hierarchy, current);
+    if (!os::exists(path)) {
+      Try<Nothing> mkdir = os::mkdir(path, false);
+      if (mkdir.isError()) {
+        return Error(
+            "Failed to create directory '" + path + "': " + mkdir.error());
+      }
+    }
+  }
+
+  return Nothing();
+}
+
+
+Try<bool> exists(const string& hierarchy, const string& cgroup)
+{
+  Option<Error> error = verify(hierarchy);
+  if (error.isSome()) {
+    return error.get();
+  }
+
+  return os::exists(path::join(hierarchy, cgroup));
+}
+
+
+Try<Nothing> assign(const string& hierarchy, const string& cgroup, pid_t pid)
+{
+  Option<Error> error = verify(hierarchy, cgroup, "cgroup.procs");
+  if (error.isSome()) {
+    return error.get();
+  }
+
+  Try<Nothing> write = cgroups::internal::write(
+      hierarchy, cgroup, "cgroup.procs", stringify(pid));
+
+  if (write.isError()) {
+    return Error(
+        "Failed to assign process " + stringify(pid) +
+        " to cgroup '" + cgroup + "': " + write.error());
+  }
+
+  return Nothing();
+}
+
+
+// Reads a control file that lists process or thread ids, one per line.
+static Try<set<pid_t>> pids(
+    const string& hierarchy,
+    const string& cgroup,
+    const string& control)
+{
+  Try<string> read = unified::read(hierarchy, cgroup, control);
+  if (read.isError()) {
+    return Error(read.error());
+  }
+
+  set<pid_t> pids;
+  foreach (const string& token, strings::tokenize(read.get(), "\n")) {
+    Try<pid_t> pid = numify<pid_t>(token);
+    if (pid.isError()) {
+      return Error("Failed to parse '" + token + "': " + pid.error());
+    }
+
+    pids.insert(pid.get());
+  }
+
+  return pids;
+}
+
+
+Try<set<pid_t>> processes(const string& hierarchy, const string& cgroup)
+{
+  return pids(hierarchy, cgroup, "cgroup.procs");
+}
+
+
+Try<set<pid_t>> threads(const string& hierarchy, const string& cgroup)
+{
+  return pids(hierarchy, cgroup, "cgroup.threads");
+}
+
+
+Try<bool> populated(const string& hierarchy, const string& cgroup)
+{
+  Option<Error> error = verify(hierarchy, cgroup, "cgroup.events");
+  if (error.isSome()) {
+    return error.get();
+  }
+
+  Try<string> read =
+    cgroups::internal::read(hierarchy, cgroup, "cgroup.events");
+
+  if (read.isError()) {
+    return Error("Failed to read control 'cgroup.events': " + read.error());
+  }
+
+  // The control has "<key> <value>" lines, e.g., "populated 1".
+  Option<uint64_t> populated;
+
+  Try<Nothing> stat = cgroups::stat(read.get(), {{"populated", &populated}});
+  if (stat.isError()) {
+    return Error("Failed to parse 'cgroup.events': " + stat.error());
+  } else if (populated.isNone()) {
+    return Error("Failed to find 'populated' in 'cgroup.events'");
+  }
+
+  return populated.get() != 0;
+}
+
+
+namespace internal {
+
+// Returns the descendants of the given cgroup, children before their
+// parents, so that they can be removed in that order.
+static Try<vector<string>> descendants(
+    const string& hierarchy,
+    const string& cgroup)
+{
+  Try<list<string>> entries = os::ls(path::join(hierarchy, cgroup));
+  if (entries.isError()) {
+    return Error(
+        "Failed to list cgroup '" + cgroup + "': " + entries.error());
+  }
+
+  vector<string> cgroups;
+  foreach (const string& entry, entries.get()) {
+    const string child = path::join(cgroup, entry);
+
+    // The control files are regular files, the children directories.
+    if (!os::stat::isdir(path::join(hierarchy, child))) {
+      continue;
+    }
+
+    Try<vector<string>> nested = descendants(hierarchy, child);
+    if (nested.isError()) {
+      return Error(nested.error());
+    }
+
+    cgroups.insert(cgroups.end(), nested.get().begin(), nested.get().end());
+    cgroups.push_back(child);
+  }
+
+  return cgroups;
+}
+
+
+// Processes in a cgroup that is being killed exit within a few
+// milliseconds, so whether the cgroups are empty is checked again
+// after an interval that starts small and backs off exponentially.
+static const Duration MIN_DESTROY_INTERVAL = Milliseconds(1);
+static const Duration MAX_DESTROY_INTERVAL = Milliseconds(100);
+
+
+// The process used to destroy cgroups in the unified hierarchy.
+class Destroyer : public Process<Destroyer>
+{
+public:
+  Destroyer(const string& _hierarchy, const vector<string>& _cgroups)
+    : ProcessBase(ID::generate("cgroups-unified-destroyer")),
+      hierarchy(_hierarchy),
+      cgroups(_cgroups),
+      start(Clock::now()),
+      interval(MIN_DESTROY_INTERVAL) {}
+
+  virtual ~Destroyer() {}
+
+  // Return a future indicating the state of the destroyer.
+  // Failure occurs if any cgroup fails to be destroyed.
+  Future<Nothing> future() { return promise.future(); }
+
+protected:
+  virtual void initialize()
+  {
+    // Stop when no one cares.
+    promise.future().onDiscard(lambda::bind(
+        static_cast<void (*)(const UPID&, bool)>(terminate), self(), true));
+
+    // Without 'cgroup.kill', freeze the cgroups so that their
+    // processes cannot fork while they are being killed. Frozen
+    // processes still die on SIGKILL.
+    foreach (const string& cgroup, cgroups) {
+      if (!os::exists(path::join(hierarchy, cgroup, "cgroup.kill")) &&
+          os::exists(path::join(hierarchy, cgroup, "cgroup.freeze"))) {
+        Try<Nothing> freeze = cgroups::internal::write(
+            hierarchy, cgroup, "cgroup.freeze", "1");
+
+        if (freeze.isError()) {
+          fail("Failed to freeze cgroup '" + cgroup + "': " + freeze.error());
+          return;
+        }
+      }
+    }
+
+    kill();
+  }
+
+  virtual void finalize()
+  {
+    promise.discard();
+  }
+
+private:
+  void kill()
+  {
+    foreach (const string& cgroup, cgroups) {
+      // A cgroup shared by several owners, e.g., the container cgroup
+      // of the launcher and the isolators, may have been removed by
+      // another destroyer in the meantime.
+      if (!os::exists(path::join(hierarchy, cgroup))) {
+        continue;
+      }
+
+      if (os::exists(path::join(hierarchy, cgroup, "cgroup.kill"))) {
+        Try<Nothing> write = cgroups::internal::write(
+            hierarchy, cgroup, "cgroup.kill", "1");
+
+        if (write.isError()) {
+          fail("Failed to kill cgroup '" + cgroup + "': " + write.error());
+          return;
+        }
+
+        continue;
+      }
+
+      Try<set<pid_t>> pids = unified::processes(hierarchy, cgroup);
+      if (pids.isError()) {
+        fail("Failed to get processes of cgroup '" + cgroup + "': " +
+             pids.error());
+        return;
+      }
+
+      foreach (pid_t pid, pids.get()) {
+        // The process may have exited since it was listed.
+        if (::kill(pid, SIGKILL) == -1 && errno != ESRCH) {
+          fail(ErrnoError(
+              "Failed to kill process " + stringify(pid) +
+              " of cgroup '" + cgroup + "'").message);
+          return;
+        }
+      }
+    }
+
+    foreach (const string& cgroup, cgroups) {
+      if (!os::exists(path::join(hierarchy, cgroup))) {
+        continue;
+      }
+
+      Try<bool> populated = unified::populated(hierarchy, cgroup);
+      if (populated.isError()) {
+        fail(populated.error());
+        return;
+      }
+
+      if (populated.get()) {
+        // Kill again in case a process was forked before the cgroup
+        // was frozen or killed.
+        delay(backoff(), self(), &Self::kill);
+        return;
+      }
+    }
+
+    remove();
+  }
+
+  void remove()
+  {
+    foreach (const string& cgroup, cgroups) {
+      if (!os::exists(path::join(hierarchy, cgroup))) {
+        continue;
+      }
+
+      Try<Nothing> remove = cgroups::internal::remove(hierarchy, cgroup);
+      if (remove.isError()) {
+        fail("Failed to remove cgroup '" + cgroup + "': " + remove.error());
+        return;
+      }
+    }
+
+    LOG(INFO) << "Successfully destroyed cgroups in "
+              << path::join(hierarchy, cgroups.back())
+              << " after " << (Clock::now() - start);
+
+    promise.set(Nothing());
+    terminate(self());
+  }
+
+  void fail(const string& message)
+  {
+    promise.fail(message);
+    terminate(self());
+  }
+
+  // Returns the interval after which to check the cgroups again.
+  Duration backoff()
+  {
+    const Duration current = interval;
+    interval = std::min(interval * 2, MAX_DESTROY_INTERVAL);
+    return current;
+  }
+
+  const string hierarchy;
+  const vector<string> cgroups;
+  const Time start;
+  Duration interval;
+  Promise<Nothing> promise;
+};
+
+} // namespace internal {
+
+
+Try<vector<string>> get(const string& hierarchy, const string& cgroup)
+{
+  Option<Error> error = verify(hierarchy, cgroup);
+  if (error.isSome()) {
+    return error.get();
+  }
+
+  Try<vector<string>> descendants = internal::descendants(hierarchy, cgroup);
+  if (descendants.isError()) {
+    return Error(descendants.error());
+  }
+
+  // The cgroups are relative to the hierarchy root, like with 'get'
+  // in cgroups v1.
+  vector<string> cgroups;
+  foreach (const string& descendant, descendants.get()) {
+    cgroups.push_back(strings::trim(descendant, "/"));
+  }
+
+  return cgroups;
+}
+
+
+Future<Nothing> destroy(const string& hierarchy, const string& cgroup)
+{
+  Option<Error> error = verify(hierarchy, cgroup);
+  if (error.isSome()) {
+    return Failure(error.get().message);
+  }
+
+  Try<vector<string>> descendants = internal::descendants(hierarchy, cgroup);
+  if (descendants.isError()) {
+    return Failure(
+        "Failed to get nested cgroups: " + descendants.error());
+  }
+
+  // The root cgroup itself cannot be destroyed.
+  vector<string> candidates = descendants.get();
+  if (strings::trim(cgroup, "/") != "") {
+    candidates.push_back(cgroup);
+  }
+
+  if (candidates.empty()) {
+    return Nothing();
+  }
+
+  internal::Destroyer* destroyer =
+    new internal::Destroyer(hierarchy, candidates);
+  Future<Nothing> future = destroyer->future();
+  spawn(destroyer, true);
+  return future;
+}
+
+
+Future<Nothing> destroy(
+    const string& hierarchy,
+    const string& cgroup,
+    const Duration& timeout)
+{
+  return destroy(hierarchy, cgroup)
+    .after(timeout, lambda::bind(&cgroups::_destroy, lambda::_1, timeout));
+}
+
+
+Try<Pressure> Pressure::parse(const string& contents)
+{
+  Option<Stall> some;
+  Option<Stall> full;
+
+  foreach (const string& line, strings::tokenize(contents, "\n")) {
+    vector<string> tokens = strings::tokenize(line, " ");
+    if (tokens.size() != 5) {
+      return Error("Unexpected line format: " + line);
+    }
+
+    Stall stall;
+    hashmap<string, string> values;
+
+    for (size_t i = 1; i < tokens.size(); i++) {
+      vector<string> pair = strings::split(tokens[i], "=", 2);
+      if (pair.size() != 2) {
+        return Error("Unexpected line format: " + line);
+      }
+
+      values[pair[0]] = pair[1];
+    }
+
+    if (!values.contains("avg10") ||
+        !values.contains("avg60") ||
+        !values.contains("avg300") ||
+        !values.contains("total")) {
+      return Error("Unexpected line format: " + line);
+    }
+
+    Try<double> avg10 = numify<double>(values["avg10"]);
+    Try<double> avg60 = numify<double>(values["avg60"]);
+    Try<double> avg300 = numify<double>(values["avg300"]);
+    Try<uint64_t> total = numify<uint64_t>(values["total"]);
+
+    if (avg10.isError() || avg60.isError() || avg300.isError() ||
+        total.isError()) {
+      return Error("Failed to parse line: " + line);
+    }
+
+    stall.avg10 = avg10.get();
+    stall.avg60 = avg60.get();
+    stall.avg300 = avg300.get();
+    stall.total = Microseconds(total.get());
+
+    if (tokens[0] == "some") {
+      some = stall;
+    } else if (tokens[0] == "full") {
+      full = stall;
+    } else {
+      return Error("Unexpected line format: " + line);
+    }
+  }
+
+  if (some.isNone()) {
+    return Error("Failed to find the 'some' line");
+  }
+
+  Pressure pressure;
+  pressure.some = some.get();
+  pressure.full = full;
+
+  return pressure;
+}
+
+
+Try<Pressure> pressure(
+    const string& hierarchy,
+    const string& cgroup,
+    const string& resource)
+{
+  const string control = resource + ".pressure";
+
+  Option<Error> error = verify(hierarchy, cgroup, control);
+  if (error.isSome()) {
+    return error.get();
+  }
+
+  Try<string> read = cgroups::internal::read(hierarchy, cgroup, control);
+  if (read.isError()) {
+    return Error(
+        "Failed to read control '" + control + "': " + read.error());
+  }
+
+  Try<Pressure> pressure = Pressure::parse(read.get());
+  if (pressure.isError()) {
+    return Error(
+        "Failed to parse control '" + control + "': " + pressure.error());
+  }
+
+  return pressure;
+}
+
+namespace cpu {
+
+Try<Nothing> weight(
+    const string& hierarchy,
+    const string& cgroup,
+    uint64_t weight)
+{
+  return unified::write(hierarchy, cgroup, "cpu.weight", stringify(weight));
+}
+
+
+Try<Nothing> max(
+    const string& hierarchy,
+    const string& cgroup,
+    const Duration& quota,
+    const Duration& period)
+{
+  return unified::write(
+      hierarchy,
+      cgroup,
+      "cpu.max",
+      stringify(static_cast<int64_t>(quota.us())) + " " +
+      stringify(static_cast<int64_t>(period.us())));
+}
+
+} // namespace cpu {
+
+namespace memory {
+
+Result<Bytes> max(const string& hierarchy, const string& cgroup)
+{
+  Try<string> read = unified::read(hierarchy, cgroup, "memory.max");
+  if (read.isError()) {
+    return Error(read.error());
+  }
+
+  const string value = strings::trim(read.get());
+  if (value == "max") {
+    return None();
+  }
+
+  Try<Bytes> bytes = Bytes::parse(value + "B");
+  if (bytes.isError()) {
+    return Error(bytes.error());
+  }
+
+  return bytes.get();
+}
+
+
+Try<Nothing> max(
+    const string& hierarchy,
+    const string& cgroup,
+    const Bytes& bytes)
+{
+  return unified::write(
+      hierarchy, cgroup, "memory.max", stringify(bytes.bytes()));
+}
+
+
+Try<Nothing> low(
+    const string& hierarchy,
+    const string& cgroup,
+    const Bytes& bytes)
+{
+  return unified::write(
+      hierarchy, cgroup, "memory.low", stringify(bytes.bytes()));
+}
+
+
+Try<Nothing> swap_max(
+    const string& hierarchy,
+    const string& cgroup,
+    const Bytes& bytes)
+{
+  return unified::write(
+      hierarchy, cgroup, "memory.swap.max", stringify(bytes.bytes()));
+}
+
+
+namespace internal {
+
+// The process which listens for the OOM kills of a cgroup. The kernel
+// generates an inotify "modified" event on 'memory.events' whenever
+// one of its counters changes, so the listener polls an inotify file
+// descriptor rather than the control file itself.
+class OomListener : public Process<OomListener>
+{
+public:
+  OomListener(const string& _hierarchy, const string& _cgroup)
+    : ProcessBase(ID::generate("cgroups-unified-oom-listener")),
+      hierarchy(_hierarchy),
+      cgroup(_cgroup),
+      fd(-1) {}
+
+  virtual ~OomListener()
+  {
+    if (fd != -1) {
+      os::close(fd);
+    }
+  }
+
+  Future<Nothing> future() { return promise.future(); }
+
+protected:
+  virtual void initialize()
+  {
+    // Stop when no one cares.
+    promise.future().onDiscard(lambda::bind(
+        static_cast<void (*)(const UPID&, bool)>(terminate), self(), true));
+
+    fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd == -1) {
+      fail(ErrnoError("Failed to create an inotify instance").message);
+      return;
+    }
+
+    const string path = path::join(hierarchy, cgroup, "memory.events");
+
+    if (::inotify_add_watch(fd, path.c_str(), IN_MODIFY) == -1) {
+      fail(ErrnoError("Failed to watch '" + path + "'").message);
+      return;
+    }
+
+    // The watch is set up before the counter is read, so that no kill
+    // after the call is missed.
+    Try<uint64_t> kills = count();
+    if (kills.isError()) {
+      fail(kills.error());
+      return;
+    }
+
+    baseline = kills.get();
+
+    wait();
+  }
+
+  virtual void finalize()
+  {
+    polling.discard();
+    promise.discard();
+  }
+
+private:
+  void wait()
+  {
+    polling = io::poll(fd, io::READ);
+    polling.onAny(defer(self(), &Self::_wait, lambda::_1));
+  }
+
+  void _wait(const Future<short>& future)
+  {
+    if (!future.isReady()) {
+      fail("Failed to poll the inotify instance: " +
+           (future.isFailed() ? future.failure() : "discarded"));
+      return;
+    }
+
+    // The events only tell that the file was modified, so they are
+    // drained without being looked at.
+    char buffer[4096];
+    while (::read(fd, buffer, sizeof(buffer)) > 0);
+
+    Try<uint64_t> kills = count();
+    if (kills.isError()) {
+      fail(kills.error());
+      return;
+    }
+
+    if (kills.get() > baseline) {
+      promise.set(Nothing());
+      terminate(self());
+      return;
+    }
+
+    wait();
+  }
+
+  // Returns the number of OOM kills in the cgroup.
+  Try<uint64_t> count()
+  {
+    Try<string> read = unified::read(hierarchy, cgroup, "memory.events");
+    if (read.isError()) {
+      return Error(read.error());
+    }
+
+    Option<uint64_t> kills;
+
+    Try<Nothing> stat = cgroups::stat(read.get(), {{"oom_kill", &kills}});
+    if (stat.isError()) {
+      return Error("Failed to parse 'memory.events': " + stat.error());
+    } else if (kills.isNone()) {
+      return Error("Failed to find 'oom_kill' in 'memory.events'");
+    }
+
+    return kills.get();
+  }
+
+  void fail(const string& message)
+  {
+    promise.fail(message);
+    terminate(self());
+  }
+
+  const string hierarchy;
+  const string cgroup;
+  int fd;
+  uint64_t baseline;
+  Future<short> polling;
+  Promise<Nothing> promise;
+};
+
+} // namespace internal {
+
+
+Future<Nothing> oom(const string& hierarchy, const string& cgroup)
+{
+  Option<Error> error = verify(hierarchy, cgroup, "memory.events");
+  if (error.isSome()) {
+    return Failure(error.get().message);
+  }
+
+  internal::OomListener* listener =
+    new internal::OomListener(hierarchy, cgroup);
+  Future<Nothing> future = listener->future();
+  spawn(listener, true);
+  return future;
+}
+
+} // namespace memory {
+
+} // namespace unified {
+
 } // namespace cgroups {
@@ -20,6 +20,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include <initializer_list>
 #include <set>
 #include <string>
 #include <vector>
@@ -27,6 +28,7 @@
 #include <sys/types.h>
 
 #include <process/future.hpp>
+#include <process/owned.hpp>
 #include <process/timeout.hpp>
 
 #include <stout/bytes.hpp>
@@ -386,6 +388,73 @@ Try<hashmap<std::string, uint64_t>> stat(
     const std::string& file);
 
 
+// A value to parse from the contents of a stat file, e.g., 'total_rss'
+// of 'memory.stat'. The value is left untouched if the contents do not
+// have a line for the name.
+struct StatField
+{
+  const char* name;
+  Option<uint64_t>* value;
+};
+
+
+// Parses the "<name> <value>" lines of the contents of a stat file
+// (e.g., 'memory.stat' or 'cpu.stat') into the given fields. Unlike
+// 'stat' above, this does not allocate anything, so it is suitable for
+// the paths that read stat files frequently, e.g., collecting the
+// usage of containers.
+// @return  Nothing if the contents are well formed.
+//          Error if a line does not have the expected format.
+Try<Nothing> stat(
+    const std::string& contents,
+    const std::initializer_list<StatField>& fields);
+
+
+// A control file of a cgroup that is kept open so that it can be read
+// repeatedly, e.g., each time the usage of a container is collected,
+// without joining the path, verifying the hierarchy, and opening the
+// file on every read. The file is read with pread(2) into a buffer
+// that is reused across reads. Use the public 'open' function to open
+// a control file of an existing cgroup, which is in the unified
+// hierarchy (cgroups v2) if 'unified' is set.
+class Control
+{
+public:
+  static Try<process::Owned<Control>> open(
+      const std::string& hierarchy,
+      const std::string& cgroup,
+      const std::string& control,
+      bool unified = false);
+
+  ~Control();
+
+  // Reads the current contents of the control file, which are then
+  // available through 'contents' until the next read.
+  Try<Nothing> read();
+
+  const std::string& contents() const { return buffer; }
+
+  // Reads a control file holding a single number, e.g.,
+  // 'memory.usage_in_bytes'.
+  Try<uint64_t> value();
+
+  // Reads a stat control file, e.g., 'memory.stat', into the given
+  // fields; see 'stat' above.
+  Try<Nothing> stat(const std::initializer_list<StatField>& fields);
+
+private:
+  Control(const std::string& path, int fd);
+
+  Control(const Control&) = delete;
+  Control& operator=(const Control&) = delete;
+
+  const std::string path;
+  const int fd;
+
+  std::string buffer;
+};
+
+
 // Cpu controls.
 namespace cpu {
 
@@ -465,6 +534,95 @@ Try<Stats> stat(
 } // namespace cpuacct {
 
 
+// Cpuset controls.
+namespace cpuset {
+
+// Parses a list of cpus or memory nodes in the format of the kernel,
+// e.g., "0-3,8,10-11", as used by cpuset.cpus and cpuset.mems.
+Try<std::set<unsigned int>> parse(const std::string& list);
+
+
+// Formats the cpus or memory nodes in the format of the kernel,
+// collapsing consecutive ids into ranges.
+std::string format(const std::set<unsigned int>& ids);
+
+
+// Returns the cpus of the cgroup from cpuset.cpus.
+Try<std::set<unsigned int>> cpus(
+    const std::string& hierarchy,
+    const std::string& cgroup);
+
+
+// Sets the cpus of the cgroup using cpuset.cpus.
+Try<Nothing> cpus(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    const std::set<unsigned int>& cpus);
+
+
+// Returns the memory nodes of the cgroup from cpuset.mems.
+Try<std::set<unsigned int>> mems(
+    const std::string& hierarchy,
+    const std::string& cgroup);
+
+
+// Sets the memory nodes of the cgroup using cpuset.mems.
+Try<Nothing> mems(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    const std::set<unsigned int>& mems);
+
+} // namespace cpuset {
+
+
+// Blkio controls.
+namespace blkio {
+
+// Sets the proportional weight of the cgroup using blkio.weight. The
+// weight is only enforced by the proportional schedulers (e.g., CFQ).
+Try<Nothing> weight(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    uint16_t weight);
+
+
+// Limits the bytes, or the operations, per second of the cgroup on
+// the block device with the given throttle control, e.g.,
+// blkio.throttle.read_bps_device. A limit of 0 removes the limit.
+Try<Nothing> throttle(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    const std::string& control,
+    dev_t device,
+    uint64_t limit);
+
+
+// An entry of a blkio statistics control, e.g., "8:0 Read 4096". The
+// entries of totals have no device, and the entries of the controls
+// which are not broken down by operation, like blkio.time, have an
+// empty operation.
+struct Value
+{
+  Option<dev_t> device;
+  std::string operation;
+  uint64_t value;
+};
+
+
+// Parses the entries of a blkio statistics control.
+Try<std::vector<Value>> parse(const std::string& stats);
+
+
+// Returns the entries of the statistics control of the cgroup, e.g.,
+// blkio.throttle.io_service_bytes.
+Try<std::vector<Value>> stat(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    const std::string& control);
+
+} // namespace blkio {
+
+
 // Memory controls.
 namespace memory {
 
@@ -647,6 +805,260 @@ process::Future<Nothing> thaw(
 
 } // namespace freezer {
 
+// The unified hierarchy of cgroups v2. Unlike cgroups v1, there is a
+// single hierarchy with all the controllers, so a container needs a
+// single cgroup rather than one per subsystem. A controller is
+// available in a cgroup only if it is enabled in the
+// 'cgroup.subtree_control' of the parent cgroup, and a cgroup that
+// enables controllers for its children cannot have processes of its
+// own (the "no internal processes" rule). The kernel reports whether a
+// cgroup has processes in 'cgroup.events' and, if it supports pressure
+// stall information (PSI), the pressure on each resource in the
+// '<resource>.pressure' files.
+namespace unified {
+
+// Returns true if the kernel supports the unified hierarchy.
+bool enabled();
+
+
+// Returns the mount point of the unified hierarchy, or None if it is
+// not mounted.
+Result<std::string> hierarchy();
+
+
+// Mounts the unified hierarchy at the given path, creating the
+// directory if needed.
+// @param   hierarchy   Path to the hierarchy root.
+// @return  Some if the operation succeeds.
+//          Error if the operation fails.
+Try<Nothing> mount(const std::string& hierarchy);
+
+
+// Unmounts the unified hierarchy. All cgroups other than the root
+// cgroup must have been removed.
+Try<Nothing> unmount(const std::string& hierarchy);
+
+
+// Returns true if the unified hierarchy is mounted at the given path.
+Try<bool> mounted(const std::string& hierarchy);
+
+
+// Prepares the unified hierarchy for use by the slave, like 'prepare'
+// above does for a v1 subsystem: the hierarchy is mounted at the
+// given path unless it is mounted already, and the root cgroup is
+// created with the given controllers enabled for its children.
+// @param   hierarchy     Path to mount the hierarchy at, if needed.
+// @param   root          The root cgroup of the slave.
+// @param   controllers   The controllers to enable for the containers.
+// @return  The path of the hierarchy if the operation succeeds.
+//          Error if the operation fails.
+Try<std::string> prepare(
+    const std::string& hierarchy,
+    const std::string& root,
+    const std::set<std::string>& controllers);
+
+
+// Returns the controllers that are available in the given cgroup,
+// i.e., the ones listed in its 'cgroup.controllers'.
+Try<std::set<std::string>> controllers(
+    const std::string& hierarchy,
+    const std::string& cgroup = "/");
+
+
+// Returns the controllers that the given cgroup enables for its
+// children, i.e., the ones listed in its 'cgroup.subtree_control'.
+Try<std::set<std::string>> enabled(
+    const std::string& hierarchy,
+    const std::string& cgroup);
+
+
+// Enables the given controllers for the children of the given cgroup.
+// The controllers must be available in the cgroup.
+Try<Nothing> enable(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    const std::set<std::string>& controllers);
+
+
+// Creates a cgroup, along with any missing ancestors, and enables the
+// given controllers in the 'cgroup.subtree_control' of each ancestor
+// that does not already enable them, so that they are available in
+// the new cgroup. The ancestors must not have processes of their own.
+// @param   hierarchy     Path to the hierarchy root.
+// @param   cgroup        Path to the cgroup relative to the hierarchy root.
+// @param   controllers   The controllers to make available in the cgroup.
+// @return  Some if the operation succeeds.
+//          Error if the operation fails.
+Try<Nothing> create(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    const std::set<std::string>& controllers = std::set<std::string>());
+
+
+// Returns true if the given cgroup exists.
+Try<bool> exists(const std::string& hierarchy, const std::string& cgroup);
+
+
+// Moves the given process (with all its threads) into the cgroup.
+Try<Nothing> assign(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    pid_t pid);
+
+
+// Returns the processes in the cgroup (not in its descendants).
+Try<std::set<pid_t>> processes(
+    const std::string& hierarchy,
+    const std::string& cgroup);
+
+
+// Returns the threads in the cgroup (not in its descendants).
+Try<std::set<pid_t>> threads(
+    const std::string& hierarchy,
+    const std::string& cgroup);
+
+
+// Returns true if the cgroup or any of its descendants has processes,
+// as reported by the 'populated' key of its 'cgroup.events'.
+Try<bool> populated(const std::string& hierarchy, const std::string& cgroup);
+
+
+// Returns the cgroups under the given cgroup, children before their
+// parents, like 'get' above.
+Try<std::vector<std::string>> get(
+    const std::string& hierarchy,
+    const std::string& cgroup = "/");
+
+
+// Kills all the processes in the cgroup and its descendants, and
+// removes them all once they are empty. The processes are killed with
+// 'cgroup.kill' if the kernel supports it (5.14 and later); otherwise
+// the cgroup is frozen with 'cgroup.freeze' (5.2 and later), if
+// available, so that its processes cannot fork while they are being
+// killed.
+process::Future<Nothing> destroy(
+    const std::string& hierarchy,
+    const std::string& cgroup = "/");
+
+
+// Same as above but fails if the cgroup has not been destroyed after
+// the given timeout.
+process::Future<Nothing> destroy(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    const Duration& timeout);
+
+
+// The pressure stall information (PSI) of a resource, i.e., the share
+// of wall time in which tasks were delayed waiting for the resource,
+// as a percentage averaged over the last 10, 60 and 300 seconds, and
+// the total time they were delayed.
+struct Stall
+{
+  double avg10;
+  double avg60;
+  double avg300;
+  Duration total;
+};
+
+
+struct Pressure
+{
+  // Parses the contents of a '<resource>.pressure' file, e.g.:
+  //   some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+  //   full avg10=0.00 avg60=0.00 avg300=0.00 total=0
+  // where the totals are in microseconds.
+  static Try<Pressure> parse(const std::string& contents);
+
+  // The time in which some of the tasks were stalled.
+  Stall some;
+
+  // The time in which all the (non-idle) tasks were stalled at once,
+  // i.e., the time wasted entirely. Older kernels do not report it
+  // for the 'cpu' resource.
+  Option<Stall> full;
+};
+
+
+// Returns the pressure of the given resource ("cpu", "memory" or
+// "io") on the cgroup. Unlike the v1 memory pressure events, which
+// are counted by listening to notifications, this is a snapshot that
+// can be read at any time.
+Try<Pressure> pressure(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    const std::string& resource);
+
+
+// Cpu controls.
+namespace cpu {
+
+// Sets the weight of the cgroup using cpu.weight, between 1 and
+// 10000. A cgroup gets a share of the cpus proportional to its
+// weight, like with cpu.shares in cgroups v1.
+Try<Nothing> weight(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    uint64_t weight);
+
+
+// Sets the bandwidth limit of the cgroup using cpu.max: the cgroup
+// can run for 'quota' in each 'period', like with cpu.cfs_quota_us
+// and cpu.cfs_period_us in cgroups v1.
+Try<Nothing> max(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    const Duration& quota,
+    const Duration& period);
+
+} // namespace cpu {
+
+
+// Memory controls.
+namespace memory {
+
+// Returns the hard memory limit from memory.max, or None if the
+// memory of the cgroup is not limited.
+Result<Bytes> max(const std::string& hierarchy, const std::string& cgroup);
+
+
+// Sets the hard memory limit using memory.max. The OOM killer is
+// invoked if the memory usage of the cgroup cannot be kept under it.
+Try<Nothing> max(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    const Bytes& bytes);
+
+
+// Sets the memory protection using memory.low: the memory of the
+// cgroup is reclaimed below it only if no unprotected memory can be
+// reclaimed elsewhere, like the soft limit of cgroups v1.
+Try<Nothing> low(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    const Bytes& bytes);
+
+
+// Sets the swap limit using memory.swap.max.
+Try<Nothing> swap_max(
+    const std::string& hierarchy,
+    const std::string& cgroup,
+    const Bytes& bytes);
+
+
+// Listens for the OOM killer killing a process of the cgroup, as
+// counted by the 'oom_kill' key of its 'memory.events'. The returned
+// future is satisfied at the next kill after the call, and can be
+// discarded to stop listening. Unlike in cgroups v1, the OOM killer
+// cannot be disabled.
+process::Future<Nothing> oom(
+    const std::string& hierarchy,
+    const std::string& cgroup);
+
+} // namespace memory {
+
+} // namespace unified {
+
 } // namespace cgroups {
 
 namespace std {
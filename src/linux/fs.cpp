@@ -288,6 +288,26 @@ Try<FileSystemTable> FileSystemTable::read()
 }
 
 
+Try<bool> supported(const string& fsname)
+{
+  Try<string> filesystems = os::read("/proc/filesystems");
+  if (filesystems.isError()) {
+    return Error("Failed to read '/proc/filesystems': " + filesystems.error());
+  }
+
+  // Each line has the type of a file system, after an optional
+  // 'nodev' for the ones that are not on a block device.
+  foreach (const string& line, strings::tokenize(filesystems.get(), "\n")) {
+    vector<string> tokens = strings::tokenize(line, " \t");
+    if (!tokens.empty() && tokens.back() == fsname) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
 Try<Nothing> mount(const Option<string>& source,
                    const string& target,
                    const Option<string>& type,
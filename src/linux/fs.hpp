@@ -295,6 +295,12 @@ struct FileSystemTable {
 };
 
 
+// Returns whether the kernel supports the file system, i.e., whether
+// it is listed in /proc/filesystems.
+// @param   fsname    File system type, e.g., 'overlay'.
+Try<bool> supported(const std::string& fsname);
+
+
 // Mount a file system.
 // @param   source    Specify the file system (often a device name but
 //                    it can also be a directory for a bind mount).
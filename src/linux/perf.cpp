@@ -14,11 +14,17 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <errno.h>
+#include <fcntl.h>
 #include <signal.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
+#include <linux/perf_event.h>
+
 #include <sys/prctl.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 
@@ -34,7 +40,9 @@
 #include <process/process.hpp>
 #include <process/subprocess.hpp>
 
+#include <stout/numify.hpp>
 #include <stout/os.hpp>
+#include <stout/path.hpp>
 #include <stout/strings.hpp>
 #include <stout/unreachable.hpp>
 
@@ -47,6 +55,7 @@
 using namespace process;
 
 using process::await;
+using process::Owned;
 
 using std::list;
 using std::ostringstream;
@@ -506,4 +515,308 @@ Try<hashmap<string, mesos::PerfStatistics>> parse(
   return statistics;
 }
 
+
+namespace internal {
+
+// The type and the configuration of an event for perf_event_open(2).
+struct Event
+{
+  uint32_t type;
+  uint64_t config;
+};
+
+
+// Returns the events that a Sampler can count, keyed by their
+// normalized names, i.e., the fields of the PerfStatistics protobuf.
+static const hashmap<string, Event>& events()
+{
+  static hashmap<string, Event>* events = []() {
+    hashmap<string, Event>* events = new hashmap<string, Event>({
+      {"cycles", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES}},
+      {"stalled_cycles_frontend",
+       {PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_FRONTEND}},
+      {"stalled_cycles_backend",
+       {PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND}},
+      {"instructions", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS}},
+      {"cache_references",
+       {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES}},
+      {"cache_misses", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES}},
+      {"branches", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS}},
+      {"branch_misses", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}},
+      {"bus_cycles", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BUS_CYCLES}},
+      {"ref_cycles", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_REF_CPU_CYCLES}},
+      {"cpu_clock", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_CLOCK}},
+      {"task_clock", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK}},
+      {"page_faults", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS}},
+      {"minor_faults", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MIN}},
+      {"major_faults", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MAJ}},
+      {"context_switches",
+       {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES}},
+      {"cpu_migrations", {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS}},
+      {"alignment_faults",
+       {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_ALIGNMENT_FAULTS}},
+      {"emulation_faults",
+       {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_EMULATION_FAULTS}}
+    });
+
+    // The hardware cache events are named '<cache>_<operation>s' and
+    // '<cache>_<operation>_misses', e.g., 'llc_loads' and
+    // 'llc_load_misses', see 'perf list'.
+    const vector<tuple<string, uint64_t>> caches = {
+      std::make_tuple("l1_dcache", PERF_COUNT_HW_CACHE_L1D),
+      std::make_tuple("l1_icache", PERF_COUNT_HW_CACHE_L1I),
+      std::make_tuple("llc", PERF_COUNT_HW_CACHE_LL),
+      std::make_tuple("dtlb", PERF_COUNT_HW_CACHE_DTLB),
+      std::make_tuple("itlb", PERF_COUNT_HW_CACHE_ITLB),
+      std::make_tuple("branch", PERF_COUNT_HW_CACHE_BPU),
+      std::make_tuple("node", PERF_COUNT_HW_CACHE_NODE)
+    };
+
+    const vector<tuple<string, string, uint64_t>> operations = {
+      std::make_tuple("loads", "load", PERF_COUNT_HW_CACHE_OP_READ),
+      std::make_tuple("stores", "store", PERF_COUNT_HW_CACHE_OP_WRITE),
+      std::make_tuple(
+          "prefetches", "prefetch", PERF_COUNT_HW_CACHE_OP_PREFETCH)
+    };
+
+    foreach (const auto& cache, caches) {
+      foreach (const auto& operation, operations) {
+        const uint64_t config =
+          std::get<1>(cache) | (std::get<2>(operation) << 8);
+
+        events->put(
+            std::get<0>(cache) + "_" + std::get<0>(operation),
+            {PERF_TYPE_HW_CACHE,
+             config | (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16)});
+
+        events->put(
+            std::get<0>(cache) + "_" + std::get<1>(operation) + "_misses",
+            {PERF_TYPE_HW_CACHE,
+             config | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)});
+      }
+    }
+
+    // Only keep the events that can be reported.
+    foreach (const string& name, events->keys()) {
+      if (mesos::PerfStatistics::descriptor()->FindFieldByName(name) ==
+            NULL) {
+        events->erase(name);
+      }
+    }
+
+    return events;
+  }();
+
+  return *events;
+}
+
+
+// Returns the online CPUs, from a list of ranges of CPUs such as
+// '0-3,6,8-11'.
+static Try<vector<int>> online()
+{
+  Try<string> read = os::read("/sys/devices/system/cpu/online");
+  if (read.isError()) {
+    return Error("Failed to read online CPUs: " + read.error());
+  }
+
+  vector<int> cpus;
+
+  foreach (const string& range, strings::tokenize(read.get(), ",\n")) {
+    vector<string> bounds = strings::split(range, "-");
+
+    Try<int> first = numify<int>(bounds[0]);
+    Try<int> last = bounds.size() == 2 ? numify<int>(bounds[1]) : first;
+
+    if (bounds.size() > 2 || first.isError() || last.isError()) {
+      return Error("Failed to parse online CPUs '" + read.get() + "'");
+    }
+
+    for (int cpu = first.get(); cpu <= last.get(); cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+
+  return cpus;
+}
+
+} // namespace internal {
+
+
+bool Sampler::valid(const set<string>& events)
+{
+  foreach (const string& event, events) {
+    if (!internal::events().contains(internal::normalize(event))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+Try<Owned<Sampler>> Sampler::create(
+    const set<string>& events,
+    const string& hierarchy,
+    const string& cgroup)
+{
+  Try<vector<int>> cpus = internal::online();
+  if (cpus.isError()) {
+    return Error(cpus.error());
+  }
+
+  const string path = path::join(hierarchy, cgroup);
+
+  // The cgroup is only needed to open the counters.
+  Try<int> directory = os::open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (directory.isError()) {
+    return Error(
+        "Failed to open cgroup '" + path + "': " + directory.error());
+  }
+
+  // The sampler closes the counters opened so far if one fails.
+  Owned<Sampler> sampler(new Sampler());
+
+  foreach (const string& event, events) {
+    const string name = internal::normalize(event);
+
+    Option<internal::Event> found = internal::events().get(name);
+    if (found.isNone()) {
+      os::close(directory.get());
+      return Error("Unsupported perf event '" + event + "'");
+    }
+
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+
+    attr.size = sizeof(attr);
+    attr.type = found->type;
+    attr.config = found->config;
+
+    // Needed to scale the counts if the counters get multiplexed.
+    attr.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // Events of a cgroup can only be counted per CPU.
+    foreach (int cpu, cpus.get()) {
+      int fd = ::syscall(
+          __NR_perf_event_open,
+          &attr,
+          directory.get(),
+          cpu,
+          -1,
+          PERF_FLAG_PID_CGROUP);
+
+      if (fd < 0) {
+        ErrnoError error(
+            "Failed to open perf event '" + event + "' for "
+            "cgroup '" + path + "' on CPU " + stringify(cpu));
+
+        os::close(directory.get());
+        return error;
+      }
+
+      // NOTE: PERF_FLAG_FD_CLOEXEC requires Linux 3.14.
+      Try<Nothing> cloexec = os::cloexec(fd);
+      if (cloexec.isError()) {
+        os::close(fd);
+        os::close(directory.get());
+        return Error(
+            "Failed to set FD_CLOEXEC on perf event '" + event + "': " +
+            cloexec.error());
+      }
+
+      sampler->counters.push_back({
+          mesos::PerfStatistics::descriptor()->FindFieldByName(name),
+          fd,
+          0,
+          0,
+          0});
+    }
+  }
+
+  os::close(directory.get());
+
+  return sampler;
+}
+
+
+Sampler::Sampler()
+  : time(Clock::now()) {}
+
+
+Sampler::~Sampler()
+{
+  foreach (const Counter& counter, counters) {
+    os::close(counter.fd);
+  }
+}
+
+
+Try<mesos::PerfStatistics> Sampler::sample()
+{
+  const Time now = Clock::now();
+
+  mesos::PerfStatistics statistics;
+  statistics.set_timestamp(time.secs());
+  statistics.set_duration((now - time).secs());
+
+  const google::protobuf::Reflection* reflection =
+    statistics.GetReflection();
+
+  foreach (Counter& counter, counters) {
+    // With the read format of the counters, the value is followed by
+    // the times the counter was enabled and running.
+    uint64_t values[3];
+
+    ssize_t length = ::read(counter.fd, values, sizeof(values));
+    if (length != sizeof(values)) {
+      return ErrnoError(
+          "Failed to read perf event '" + counter.field->name() + "'");
+    }
+
+    const uint64_t value = values[0] - counter.value;
+    const uint64_t enabled = values[1] - counter.enabled;
+    const uint64_t running = values[2] - counter.running;
+
+    counter.value = values[0];
+    counter.enabled = values[1];
+    counter.running = values[2];
+
+    // Scale the count to the time the counter was enabled, as 'perf
+    // stat' does, if it was only running part of that time.
+    double count = value;
+    if (running > 0 && running < enabled) {
+      count = count * enabled / running;
+    }
+
+    switch (counter.field->type()) {
+      case google::protobuf::FieldDescriptor::TYPE_DOUBLE:
+        // The clock events are counted in nanoseconds, while 'perf
+        // stat' reports them in milliseconds.
+        reflection->SetDouble(
+            &statistics,
+            counter.field,
+            reflection->GetDouble(statistics, counter.field) +
+              count / 1000000);
+        break;
+      case google::protobuf::FieldDescriptor::TYPE_UINT64:
+        reflection->SetUInt64(
+            &statistics,
+            counter.field,
+            reflection->GetUInt64(statistics, counter.field) +
+              static_cast<uint64_t>(count));
+        break;
+      default:
+        return Error(
+            "Unsupported perf field type for '" +
+            counter.field->name() + "'");
+    }
+  }
+
+  time = now;
+
+  return statistics;
+}
+
 } // namespace perf {
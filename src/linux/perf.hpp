@@ -21,11 +21,17 @@
 
 #include <set>
 #include <string>
+#include <vector>
+
+#include <google/protobuf/descriptor.h>
 
 #include <process/future.hpp>
+#include <process/owned.hpp>
+#include <process/time.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/try.hpp>
 
 // For PerfStatistics protobuf.
 #include "mesos/mesos.hpp"
@@ -57,6 +63,65 @@ Try<hashmap<std::string, mesos::PerfStatistics>> parse(
     const std::string& output,
     const Version& version);
 
+
+// Counts perf events for the processes of a perf_event cgroup using
+// perf_event_open(2) directly rather than running 'perf stat'. The
+// counters are opened in cgroup mode on every online CPU when the
+// sampler is created and are kept open for as long as it exists, so
+// taking a sample only reads them. Use the public 'create' function
+// to create a sampler for an existing cgroup.
+// NOTE: Only the events that have a field in the PerfStatistics
+// protobuf are supported, by their 'perf list' names, e.g., cycles or
+// L1-dcache-load-misses, and CPUs brought online after the sampler is
+// created are not counted.
+class Sampler
+{
+public:
+  // Returns whether all the events can be counted by a sampler.
+  static bool valid(const std::set<std::string>& events);
+
+  // NOTE: The cgroup should be relative to the hierarchy of the
+  // perf_event subsystem, as for 'sample' above.
+  static Try<process::Owned<Sampler>> create(
+      const std::set<std::string>& events,
+      const std::string& hierarchy,
+      const std::string& cgroup);
+
+  ~Sampler();
+
+  // Returns the counts of the events since the previous sample, or
+  // since the sampler was created for the first sample. Like 'perf
+  // stat', the counts are scaled if the kernel had to multiplex the
+  // counters because there were more events than hardware counters.
+  Try<mesos::PerfStatistics> sample();
+
+private:
+  Sampler();
+
+  Sampler(const Sampler&) = delete;
+  Sampler& operator=(const Sampler&) = delete;
+
+  struct Counter
+  {
+    // The field of the event in the PerfStatistics protobuf.
+    const google::protobuf::FieldDescriptor* field;
+
+    // The counter of the event on a CPU.
+    int fd;
+
+    // The count of the event and the times the counter was enabled
+    // and running, as of the last sample.
+    uint64_t value;
+    uint64_t enabled;
+    uint64_t running;
+  };
+
+  std::vector<Counter> counters;
+
+  // The time of the last sample.
+  process::Time time;
+};
+
 } // namespace perf {
 
 #endif // __PERF_HPP__
@@ -0,0 +1,232 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+
+#include <sys/socket.h>
+
+#include <vector>
+
+#include <stout/error.hpp>
+#include <stout/none.hpp>
+#include <stout/option.hpp>
+
+#include <stout/os/close.hpp>
+#include <stout/os/strerror.hpp>
+
+#include "linux/proc_connector.hpp"
+
+using std::vector;
+
+namespace proc_connector {
+
+// Reads one datagram from the socket, if any is queued, appending its
+// events to 'events' and saving the error of the acknowledgement of
+// a subscription in 'ack'. Returns false if nothing was queued.
+static Try<bool> read(int fd, vector<Event>* events, Option<int>* ack)
+{
+  alignas(struct nlmsghdr) char buffer[8192];
+
+  ssize_t length;
+  do {
+    length = ::recv(fd, buffer, sizeof(buffer), 0);
+  } while (length < 0 && errno == EINTR);
+
+  if (length < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return false;
+    } else if (errno == ENOBUFS) {
+      events->push_back(Event{Event::OVERRUN, 0, 0});
+      return true;
+    }
+
+    return ErrnoError("Failed to receive from the netlink socket");
+  }
+
+  int remaining = static_cast<int>(length);
+  for (struct nlmsghdr* header = (struct nlmsghdr*) buffer;
+       NLMSG_OK(header, remaining);
+       header = NLMSG_NEXT(header, remaining)) {
+    if (header->nlmsg_type == NLMSG_OVERRUN) {
+      events->push_back(Event{Event::OVERRUN, 0, 0});
+      continue;
+    } else if (header->nlmsg_type == NLMSG_NOOP ||
+               header->nlmsg_type == NLMSG_ERROR) {
+      continue;
+    }
+
+    const struct cn_msg* message = (struct cn_msg*) NLMSG_DATA(header);
+    if (message->id.idx != CN_IDX_PROC || message->id.val != CN_VAL_PROC) {
+      continue;
+    }
+
+    const struct proc_event* event = (struct proc_event*) message->data;
+
+    // NOTE: Threads are forked and exit like processes, but only
+    // the thread group leaders (i.e., the processes) are reported.
+    switch (event->what) {
+      case proc_event::PROC_EVENT_NONE:
+        *ack = static_cast<int>(event->event_data.ack.err);
+        break;
+      case proc_event::PROC_EVENT_FORK:
+        if (event->event_data.fork.child_pid ==
+            event->event_data.fork.child_tgid) {
+          events->push_back(Event{
+              Event::FORK,
+              event->event_data.fork.child_tgid,
+              event->event_data.fork.parent_tgid});
+        }
+        break;
+      case proc_event::PROC_EVENT_EXIT:
+        if (event->event_data.exit.process_pid ==
+            event->event_data.exit.process_tgid) {
+          events->push_back(Event{
+              Event::EXIT,
+              event->event_data.exit.process_tgid,
+              0});
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  return true;
+}
+
+
+Try<int> subscribe()
+{
+  int fd = ::socket(
+      PF_NETLINK,
+      SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+      NETLINK_CONNECTOR);
+
+  if (fd < 0) {
+    return ErrnoError("Failed to create a netlink socket");
+  }
+
+  struct sockaddr_nl address;
+  memset(&address, 0, sizeof(address));
+  address.nl_family = AF_NETLINK;
+  address.nl_groups = CN_IDX_PROC;
+
+  if (::bind(fd, (struct sockaddr*) &address, sizeof(address)) < 0) {
+    ErrnoError error("Failed to bind the netlink socket");
+    os::close(fd);
+    return error;
+  }
+
+  alignas(struct nlmsghdr) char buffer[NLMSG_SPACE(
+      sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op))];
+
+  memset(buffer, 0, sizeof(buffer));
+
+  struct nlmsghdr* header = (struct nlmsghdr*) buffer;
+  header->nlmsg_len =
+    NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op));
+  header->nlmsg_type = NLMSG_DONE;
+  header->nlmsg_pid = ::getpid();
+
+  struct cn_msg* message = (struct cn_msg*) NLMSG_DATA(header);
+  message->id.idx = CN_IDX_PROC;
+  message->id.val = CN_VAL_PROC;
+  message->len = sizeof(enum proc_cn_mcast_op);
+
+  const enum proc_cn_mcast_op op = PROC_CN_MCAST_LISTEN;
+  memcpy(message->data, &op, sizeof(op));
+
+  if (::send(fd, buffer, header->nlmsg_len, 0) < 0) {
+    ErrnoError error("Failed to subscribe to the proc connector");
+    os::close(fd);
+    return error;
+  }
+
+  // The kernel acknowledges the subscription with an event to all of
+  // the listeners. The events are only sent to the sockets in the
+  // initial network namespace, so without the acknowledgement there
+  // would be no way to tell a subscription which never gets any
+  // events apart from a quiet host.
+  Option<int> ack = None();
+  vector<Event> events;
+
+  while (ack.isNone()) {
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    int result = ::poll(&pfd, 1, 1000);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    } else if (result < 0) {
+      ErrnoError error("Failed to poll the netlink socket");
+      os::close(fd);
+      return error;
+    } else if (result == 0) {
+      os::close(fd);
+      return Error("Timed out waiting for the proc connector");
+    }
+
+    // The events of other processes which arrive before the
+    // acknowledgement are dropped.
+    events.clear();
+
+    Try<bool> read = proc_connector::read(fd, &events, &ack);
+    if (read.isError()) {
+      os::close(fd);
+      return Error(read.error());
+    }
+  }
+
+  if (ack.get() != 0) {
+    os::close(fd);
+    return Error(
+        "Failed to subscribe to the proc connector: " +
+        os::strerror(ack.get()));
+  }
+
+  return fd;
+}
+
+
+Try<vector<Event>> receive(int fd)
+{
+  vector<Event> events;
+  Option<int> ack = None();
+
+  // Bound the number of datagrams read at once so that a busy host
+  // does not keep the caller here forever.
+  for (int i = 0; i < 256; i++) {
+    Try<bool> read = proc_connector::read(fd, &events, &ack);
+    if (read.isError()) {
+      return Error(read.error());
+    } else if (!read.get()) {
+      break;
+    }
+  }
+
+  return events;
+}
+
+} // namespace proc_connector {
@@ -0,0 +1,63 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __LINUX_PROC_CONNECTOR_HPP__
+#define __LINUX_PROC_CONNECTOR_HPP__
+
+#include <sys/types.h>
+
+#include <vector>
+
+#include <stout/try.hpp>
+
+// The proc connector of the kernel sends an event over netlink for
+// each fork, exec and exit of a process on the host, which lets a
+// process tree be followed without walking '/proc'.
+// NOTE: Subscribing to the events requires CAP_NET_ADMIN.
+namespace proc_connector {
+
+struct Event
+{
+  enum Type
+  {
+    // A process 'pid' was forked by the process 'parent'.
+    FORK,
+
+    // The process 'pid' exited.
+    EXIT,
+
+    // The socket ran out of buffer space and events were dropped, so
+    // any state that was built from them must be rebuilt.
+    OVERRUN
+  };
+
+  Type type;
+  pid_t pid;
+  pid_t parent;
+};
+
+
+// Returns a non-blocking netlink socket which receives the events.
+Try<int> subscribe();
+
+
+// Returns the events queued on the socket, which is empty if there
+// are none. Events of threads are skipped, as are exec events.
+Try<std::vector<Event>> receive(int fd);
+
+} // namespace proc_connector {
+
+#endif // __LINUX_PROC_CONNECTOR_HPP__
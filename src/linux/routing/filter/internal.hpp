@@ -271,21 +271,12 @@ inline Try<Nothing> attach(
 }
 
 
-// Generates the handle for the given filter on the link. Returns none
-// if we decide to let the kernel choose the handle.
-template <typename Classifier>
-Result<U32Handle> generateU32Handle(
+// Returns all the libnl filters (rtnl_cls) attached to the given
+// parent on the link.
+inline Try<std::vector<Netlink<struct rtnl_cls>>> getClses(
     const Netlink<struct rtnl_link>& link,
-    const Filter<Classifier>& filter)
+    const Handle& parent)
 {
-  // If the user does not specify a priority, we have no choice but
-  // let the kernel choose the handle because we do not know the
-  // 'htid' that is associated with that priority.
-  if (filter.priority.isNone()) {
-    return None();
-  }
-
-  // Scan all the filters attached to the given parent on the link.
   Try<Netlink<struct nl_sock>> socket = routing::socket();
   if (socket.isError()) {
     return Error(socket.error());
@@ -297,7 +288,7 @@ Result<U32Handle> generateU32Handle(
   int error = rtnl_cls_alloc_cache(
       socket.get().get(),
       rtnl_link_get_ifindex(link.get()),
-      filter.parent.get(),
+      parent.get(),
       &c);
 
   if (error != 0) {
@@ -308,55 +299,111 @@ Result<U32Handle> generateU32Handle(
 
   Netlink<struct nl_cache> cache(c);
 
-  // A map from priority to the corresponding 'htid'.
-  hashmap<uint16_t, uint32_t> htids;
-
-  // A map from 'htid' to a set of already used nodes.
-  hashmap<uint32_t, hashset<uint32_t>> nodes;
+  std::vector<Netlink<struct rtnl_cls>> results;
 
   for (struct nl_object* o = nl_cache_get_first(cache.get());
        o != NULL; o = nl_cache_get_next(o)) {
-    struct rtnl_cls* cls = (struct rtnl_cls*) o;
+    // NOTE: We increment the reference counter here because 'cache'
+    // will be freed when this function finishes and we want this
+    // object's life to be longer than this function.
+    nl_object_get(o);
 
-    // Only look at u32 filters. For other type of filters, their
-    // handles are generated by the kernel correctly.
-    if (rtnl_tc_get_kind(TC_CAST(cls)) == std::string("u32")) {
-      U32Handle handle(rtnl_tc_get_handle(TC_CAST(cls)));
+    results.push_back(Netlink<struct rtnl_cls>((struct rtnl_cls*) o));
+  }
 
-      htids[rtnl_cls_get_prio(cls)] = handle.htid();
-      nodes[handle.htid()].insert(handle.node());
+  return results;
+}
+
+
+// The u32 handles used by the filters attached to a parent on a
+// link, from which we pick unused handles for new u32 filters.
+class U32Handles
+{
+public:
+  explicit U32Handles(const std::vector<Netlink<struct rtnl_cls>>& clses)
+  {
+    foreach (const Netlink<struct rtnl_cls>& cls, clses) {
+      // Only look at u32 filters. For other type of filters, their
+      // handles are generated by the kernel correctly.
+      if (rtnl_tc_get_kind(TC_CAST(cls.get())) == std::string("u32")) {
+        U32Handle handle(rtnl_tc_get_handle(TC_CAST(cls.get())));
+
+        htids[rtnl_cls_get_prio(cls.get())] = handle.htid();
+        nodes[handle.htid()].insert(handle.node());
+      }
     }
   }
 
-  // If this filter has a new priority, we need to let the kernel
-  // decide the handle because we don't know which 'htid' this
-  // priority will be associated with.
-  if (!htids.contains(filter.priority.get().get())) {
+  // Returns an unused handle for a filter with the given priority and
+  // marks it as used. Returns none if we decide to let the kernel
+  // choose the handle.
+  Result<U32Handle> allocate(const Option<Priority>& priority)
+  {
+    // If the user does not specify a priority, we have no choice but
+    // let the kernel choose the handle because we do not know the
+    // 'htid' that is associated with that priority. The same goes for
+    // a new priority.
+    if (priority.isNone() || !htids.contains(priority.get().get())) {
+      return None();
+    }
+
+    // NOTE: By default, kernel will choose to use divisor 1, which
+    // means all filters will be in hash bucket 0. Also, kernel assigns
+    // node id starting from 0x800 by default. Here, we keep the same
+    // semantics as kernel.
+    uint32_t htid = htids[priority.get().get()];
+    for (uint32_t node = 0x800; node <= 0xfff; node++) {
+      if (!nodes[htid].contains(node)) {
+        nodes[htid].insert(node);
+        return U32Handle(htid, 0x0, node);
+      }
+    }
+
+    return Error("No available handle exists");
+  }
+
+private:
+  // A map from priority to the corresponding 'htid'.
+  hashmap<uint16_t, uint32_t> htids;
+
+  // A map from 'htid' to a set of already used nodes.
+  hashmap<uint32_t, hashset<uint32_t>> nodes;
+};
+
+
+// Generates the handle for the given filter on the link. Returns none
+// if we decide to let the kernel choose the handle.
+template <typename Classifier>
+Result<U32Handle> generateU32Handle(
+    const Netlink<struct rtnl_link>& link,
+    const Filter<Classifier>& filter)
+{
+  if (filter.priority.isNone()) {
     return None();
   }
 
-  // NOTE: By default, kernel will choose to use divisor 1, which
-  // means all filters will be in hash bucket 0. Also, kernel assigns
-  // node id starting from 0x800 by default. Here, we keep the same
-  // semantics as kernel.
-  uint32_t htid = htids[filter.priority.get().get()];
-  for (uint32_t node = 0x800; node <= 0xfff; node++) {
-    if (!nodes[htid].contains(node)) {
-      return U32Handle(htid, 0x0, node);
-    }
+  // Scan all the filters attached to the given parent on the link.
+  Try<std::vector<Netlink<struct rtnl_cls>>> clses =
+    getClses(link, filter.parent);
+
+  if (clses.isError()) {
+    return Error(clses.error());
   }
 
-  return Error("No available handle exists");
+  return U32Handles(clses.get()).allocate(filter.priority);
 }
 
 
 // Encodes a filter (in our representation) to a libnl filter
-// (rtnl_cls). We use template here so that it works for any type of
+// (rtnl_cls). If 'handles' is given, the handle of a u32 filter that
+// has none is picked from it rather than from a dump of the filters
+// on the link. We use template here so that it works for any type of
 // classifier.
 template <typename Classifier>
 Try<Netlink<struct rtnl_cls>> encodeFilter(
     const Netlink<struct rtnl_link>& link,
-    const Filter<Classifier>& filter)
+    const Filter<Classifier>& filter,
+    U32Handles* handles = NULL)
 {
   struct rtnl_cls* c = rtnl_cls_alloc();
   if (c == NULL) {
@@ -400,7 +447,9 @@ Try<Netlink<struct rtnl_cls>> encodeFilter(
     // handle of the filter by picking an unused handle.
     // TODO(jieyu): Revisit this once the kernel bug is fixed.
     if (rtnl_tc_get_kind(TC_CAST(cls.get())) == std::string("u32")) {
-      Result<U32Handle> handle = generateU32Handle(link, filter);
+      Result<U32Handle> handle = handles != NULL
+        ? handles->allocate(filter.priority)
+        : generateU32Handle(link, filter);
       if (handle.isError()) {
         return Error("Failed to find an unused u32 handle: " + handle.error());
       }
@@ -483,50 +532,6 @@ Result<Filter<Classifier>> decodeFilter(const Netlink<struct rtnl_cls>& cls)
 // Helpers for internal APIs.
 /////////////////////////////////////////////////
 
-// Returns all the libnl filters (rtnl_cls) attached to the given
-// parent on the link.
-inline Try<std::vector<Netlink<struct rtnl_cls>>> getClses(
-    const Netlink<struct rtnl_link>& link,
-    const Handle& parent)
-{
-  Try<Netlink<struct nl_sock>> socket = routing::socket();
-  if (socket.isError()) {
-    return Error(socket.error());
-  }
-
-  // Dump all the libnl filters (i.e., rtnl_cls) attached to the given
-  // parent on the link.
-  struct nl_cache* c = NULL;
-  int error = rtnl_cls_alloc_cache(
-      socket.get().get(),
-      rtnl_link_get_ifindex(link.get()),
-      parent.get(),
-      &c);
-
-  if (error != 0) {
-    return Error(
-        "Failed to get filter info from kernel: " +
-        std::string(nl_geterror(error)));
-  }
-
-  Netlink<struct nl_cache> cache(c);
-
-  std::vector<Netlink<struct rtnl_cls>> results;
-
-  for (struct nl_object* o = nl_cache_get_first(cache.get());
-       o != NULL; o = nl_cache_get_next(o)) {
-    // NOTE: We increment the reference counter here because 'cache'
-    // will be freed when this function finishes and we want this
-    // object's life to be longer than this function.
-    nl_object_get(o);
-
-    results.push_back(Netlink<struct rtnl_cls>((struct rtnl_cls*) o));
-  }
-
-  return results;
-}
-
-
 // Returns the libnl filter (rtnl_cls) attached to the given parent
 // that matches the specified classifier on the link. Returns None if
 // no match has been found. We use template here so that it works for
@@ -640,6 +645,110 @@ Try<bool> create(const std::string& _link, const Filter<Classifier>& filter)
 }
 
 
+// Creates the filters on the link in a batch. The link and the
+// filters attached to each parent are dumped once for the batch, and
+// the filters are added on a single socket, which makes this much
+// cheaper than creating them one by one on a link with many filters.
+// Returns false, creating none of them, if a filter attached to the
+// same parent with the same classifier as one of them already exists.
+// We use template here so that it works for any type of classifier.
+template <typename Classifier>
+Try<bool> create(
+    const std::string& _link,
+    const std::vector<Filter<Classifier>>& filters)
+{
+  if (filters.empty()) {
+    return true;
+  }
+
+  Result<Netlink<struct rtnl_link>> link = link::internal::get(_link);
+  if (link.isError()) {
+    return Error(link.error());
+  } else if (link.isNone()) {
+    return Error("Link '" + _link + "' is not found");
+  }
+
+  // The classifiers and the u32 handles of the filters attached to
+  // each of the parents of the batch, by parent.
+  hashmap<uint32_t, std::vector<Classifier>> classifiers;
+  hashmap<uint32_t, U32Handles> handles;
+
+  foreach (const Filter<Classifier>& filter, filters) {
+    const uint32_t parent = filter.parent.get();
+
+    if (!handles.contains(parent)) {
+      Try<std::vector<Netlink<struct rtnl_cls>>> clses =
+        getClses(link.get(), filter.parent);
+
+      if (clses.isError()) {
+        return Error(clses.error());
+      }
+
+      std::vector<Classifier> existing;
+      foreach (const Netlink<struct rtnl_cls>& cls, clses.get()) {
+        Result<Filter<Classifier>> decoded = decodeFilter<Classifier>(cls);
+        if (decoded.isError()) {
+          return Error("Failed to decode: " + decoded.error());
+        } else if (decoded.isSome()) {
+          existing.push_back(decoded.get().classifier);
+        }
+      }
+
+      classifiers.put(parent, existing);
+      handles.put(parent, U32Handles(clses.get()));
+    }
+
+    foreach (const Classifier& classifier, classifiers.at(parent)) {
+      if (classifier == filter.classifier) {
+        // The filter already exists.
+        return false;
+      }
+    }
+  }
+
+  Try<Netlink<struct nl_sock>> socket = routing::socket();
+  if (socket.isError()) {
+    return Error(socket.error());
+  }
+
+  foreach (const Filter<Classifier>& filter, filters) {
+    const uint32_t parent = filter.parent.get();
+
+    Try<Netlink<struct rtnl_cls>> cls =
+      encodeFilter(link.get(), filter, &handles.at(parent));
+
+    if (cls.isError()) {
+      return Error("Failed to encode the filter: " + cls.error());
+    }
+
+    int error = rtnl_cls_add(
+        socket.get().get(),
+        cls.get().get(),
+        NLM_F_CREATE | NLM_F_EXCL);
+
+    if (error != 0) {
+      return Error(std::string(nl_geterror(error)));
+    }
+
+    // If we let the kernel choose the handle, e.g., for the first
+    // filter with a new priority, we need to learn the handles in use
+    // again so that the next filters do not reuse it (MESOS-1617).
+    if (rtnl_tc_get_handle(TC_CAST(cls.get().get())) == 0) {
+      Try<std::vector<Netlink<struct rtnl_cls>>> clses =
+        getClses(link.get(), filter.parent);
+
+      if (clses.isError()) {
+        return Error(clses.error());
+      }
+
+      handles.put(parent, U32Handles(clses.get()));
+    }
+  }
+
+  return true;
+}
+
+
 // Removes the filter attached to the given parent that matches the
 // specified classifier from the link. Returns false if such a filter
 // is not found. We use template here so that it works for any type of
@@ -682,6 +791,70 @@ Try<bool> remove(
 }
 
 
+// Removes the filters attached to the given parent that match the
+// specified classifiers from the link in a batch, dumping the filters
+// on the link once. Returns the number of filters removed, i.e., the
+// classifiers that match no filter are skipped. We use template here
+// so that it works for any type of classifier.
+template <typename Classifier>
+Try<size_t> remove(
+    const std::string& _link,
+    const Handle& parent,
+    const std::vector<Classifier>& classifiers)
+{
+  if (classifiers.empty()) {
+    return 0;
+  }
+
+  Result<Netlink<struct rtnl_link>> link = link::internal::get(_link);
+  if (link.isError()) {
+    return Error(link.error());
+  } else if (link.isNone()) {
+    return 0;
+  }
+
+  Try<std::vector<Netlink<struct rtnl_cls>>> clses =
+    getClses(link.get(), parent);
+
+  if (clses.isError()) {
+    return Error(clses.error());
+  }
+
+  // The filters that are to be removed.
+  std::vector<Netlink<struct rtnl_cls>> removals;
+
+  foreach (const Netlink<struct rtnl_cls>& cls, clses.get()) {
+    Result<Filter<Classifier>> filter = decodeFilter<Classifier>(cls);
+    if (filter.isError()) {
+      return Error("Failed to decode: " + filter.error());
+    } else if (filter.isNone()) {
+      continue;
+    }
+
+    foreach (const Classifier& classifier, classifiers) {
+      if (filter.get().classifier == classifier) {
+        removals.push_back(cls);
+        break;
+      }
+    }
+  }
+
+  Try<Netlink<struct nl_sock>> socket = routing::socket();
+  if (socket.isError()) {
+    return Error(socket.error());
+  }
+
+  foreach (const Netlink<struct rtnl_cls>& cls, removals) {
+    int error = rtnl_cls_delete(socket.get().get(), cls.get(), 0);
+    if (error != 0) {
+      return Error(std::string(nl_geterror(error)));
+    }
+  }
+
+  return removals.size();
+}
+
+
 // Updates the action of the filter attached to the given parent that
 // matches the specified classifier on the link. Returns false if such
 // a filter is not found. We use template here so that it works for
@@ -536,6 +536,14 @@ Try<bool> create(
           action::Terminal()));
 }
 
+Try<bool> create(
+    const string& link,
+    const vector<Filter<Classifier>>& filters)
+{
+  return internal::create(link, filters);
+}
+
+
 Try<bool> remove(
     const string& link,
     const Handle& parent,
@@ -545,6 +553,15 @@ Try<bool> remove(
 }
 
 
+Try<size_t> remove(
+    const string& link,
+    const Handle& parent,
+    const vector<Classifier>& classifiers)
+{
+  return internal::remove(link, parent, classifiers);
+}
+
+
 Result<vector<Filter<Classifier>>> filters(
     const string& link,
     const Handle& parent)
@@ -179,6 +179,16 @@ Try<bool> create(
     const Option<Handle>& classid);
 
 
+// Creates the IP packet filters on the link in a batch, which is
+// much cheaper than creating them one by one when the link has many
+// filters. Returns false, creating none of them, if an IP packet
+// filter attached to the same parent with the same classifier as one
+// of them already exists.
+Try<bool> create(
+    const std::string& link,
+    const std::vector<Filter<Classifier>>& filters);
+
+
 // Removes the IP packet filter attached to the given parent that
 // matches the specified classifier from the link. Returns false if
 // such a filter is not found.
@@ -188,6 +198,15 @@ Try<bool> remove(
     const Classifier& classifier);
 
 
+// Removes the IP packet filters attached to the given parent that
+// match the specified classifiers from the link in a batch. Returns
+// the number of filters removed.
+Try<size_t> remove(
+    const std::string& link,
+    const Handle& parent,
+    const std::vector<Classifier>& classifiers);
+
+
 // Returns all the IP packet filters attached to the given parent on
 // the link. Returns none if the link or the parent is not found.
 Result<std::vector<Filter<Classifier>>> filters(
@@ -24,6 +24,7 @@
 
 #include <netlink/idiag/msg.h>
 
+#include <netlink/route/class.h>
 #include <netlink/route/classifier.h>
 #include <netlink/route/link.h>
 #include <netlink/route/qdisc.h>
@@ -41,6 +42,7 @@ namespace routing {
 // Customized deallocation functions for netlink objects.
 inline void cleanup(struct nl_cache* cache) { nl_cache_free(cache); }
 inline void cleanup(struct nl_sock* sock) { nl_socket_free(sock); }
+inline void cleanup(struct rtnl_class* cls) { rtnl_class_put(cls); }
 inline void cleanup(struct rtnl_cls* cls) { rtnl_cls_put(cls); }
 inline void cleanup(struct rtnl_link* link) { rtnl_link_put(link); }
 inline void cleanup(struct rtnl_qdisc* qdisc) { rtnl_qdisc_put(qdisc); }
@@ -111,6 +111,12 @@ Try<bool> setMTU(const std::string& link, unsigned int mtu);
 // Returns the statistics of the link.
 Result<hashmap<std::string, uint64_t>> statistics(const std::string& link);
 
+
+// Returns the statistics of all the links, by link name, from a
+// single dump of the links. This is much cheaper than getting the
+// statistics of many links one by one.
+Try<hashmap<std::string, hashmap<std::string, uint64_t>>> statistics();
+
 } // namespace link {
 } // namespace routing {
 
@@ -16,15 +16,24 @@
 
 #include <netlink/errno.h>
 
+#include <netlink/route/class.h>
 #include <netlink/route/qdisc.h>
 #include <netlink/route/tc.h>
 
+#include <netlink/route/qdisc/htb.h>
+
+#include <limits>
+
 #include <stout/error.hpp>
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
 #include <stout/result.hpp>
+#include <stout/stringify.hpp>
 
 #include "linux/routing/handle.hpp"
+#include "linux/routing/internal.hpp"
+
+#include "linux/routing/link/internal.hpp"
 
 #include "linux/routing/queueing/htb.hpp"
 #include "linux/routing/queueing/internal.hpp"
@@ -36,10 +45,18 @@ namespace queueing {
 
 namespace htb {
 
-// TODO(cwang): The htb queueing discipline configuration is not
-// exposed to the user because we use all the default parameters
+// TODO(cwang): Only the default class of the htb queueing discipline
+// is exposed to the user, we use the default for the other parameters
 // currently.
-struct Config {};
+struct Config
+{
+  Config() {}
+
+  explicit Config(const Handle& _defaultClass)
+    : defaultClass(_defaultClass) {}
+
+  Option<Handle> defaultClass;
+};
 
 } // namespace htb {
 
@@ -57,6 +74,19 @@ Try<Nothing> encode<htb::Config>(
     const Netlink<struct rtnl_qdisc>& qdisc,
     const htb::Config& config)
 {
+  if (config.defaultClass.isSome()) {
+    // The kernel takes the secondary number of the default class, the
+    // primary number being the one of the queueing discipline.
+    int error = rtnl_htb_set_defcls(
+        qdisc.get(),
+        config.defaultClass.get().secondary());
+
+    if (error != 0) {
+      return Error(
+          "Failed to set the default class: " + string(nl_geterror(error)));
+    }
+  }
+
   return Nothing();
 }
 
@@ -105,6 +135,87 @@ Try<bool> create(
 }
 
 
+Try<bool> create(
+    const string& link,
+    const Handle& parent,
+    const Handle& handle,
+    const Handle& defaultClass)
+{
+  return internal::create(
+      link,
+      Discipline<Config>(
+          KIND,
+          parent,
+          handle,
+          Config(defaultClass)));
+}
+
+
+Try<bool> createClass(
+    const string& _link,
+    const Handle& parent,
+    const Handle& handle,
+    const Bytes& rate)
+{
+  Result<Netlink<struct rtnl_link>> link = link::internal::get(_link);
+  if (link.isError()) {
+    return Error(link.error());
+  } else if (link.isNone()) {
+    return Error("Link '" + _link + "' is not found");
+  }
+
+  struct rtnl_class* c = rtnl_class_alloc();
+  if (c == NULL) {
+    return Error("Failed to allocate a libnl class");
+  }
+
+  Netlink<struct rtnl_class> cls(c);
+
+  rtnl_tc_set_link(TC_CAST(cls.get()), link.get().get());
+  rtnl_tc_set_parent(TC_CAST(cls.get()), parent.get());
+  rtnl_tc_set_handle(TC_CAST(cls.get()), handle.get());
+
+  int error = rtnl_tc_set_kind(TC_CAST(cls.get()), KIND);
+  if (error != 0) {
+    return Error(
+        "Failed to set the kind of the class: " + string(nl_geterror(error)));
+  }
+
+  if (rate.bytes() > std::numeric_limits<uint32_t>::max()) {
+    return Error("The rate of the class is too large: " + stringify(rate));
+  }
+
+  // The ceiling defaults to the rate, so the class does not borrow.
+  error = rtnl_htb_set_rate(cls.get(), rate.bytes());
+  if (error != 0) {
+    return Error(
+        "Failed to set the rate of the class: " + string(nl_geterror(error)));
+  }
+
+  Try<Netlink<struct nl_sock>> socket = routing::socket();
+  if (socket.isError()) {
+    return Error(socket.error());
+  }
+
+  // The flag NLM_F_EXCL tells libnl that if the class already exists,
+  // this function should return error.
+  error = rtnl_class_add(
+      socket.get().get(),
+      cls.get(),
+      NLM_F_CREATE | NLM_F_EXCL);
+
+  if (error != 0) {
+    if (error == -NLE_EXIST) {
+      return false;
+    }
+    return Error(
+        "Failed to add a class to the link: " + string(nl_geterror(error)));
+  }
+
+  return true;
+}
+
+
 Try<bool> remove(const string& link, const Handle& parent)
 {
   return internal::remove(link, parent, KIND);
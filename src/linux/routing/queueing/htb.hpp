@@ -21,7 +21,9 @@
 
 #include <string>
 
+#include <stout/bytes.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/option.hpp>
 #include <stout/try.hpp>
 
 #include "linux/routing/handle.hpp"
@@ -48,6 +50,27 @@ Try<bool> create(
     const Option<Handle>& handle);
 
 
+// Creates a new htb queueing discipline like 'create' above, which
+// sends the traffic that no filter classifies to the class with the
+// given handle.
+Try<bool> create(
+    const std::string& link,
+    const Handle& parent,
+    const Handle& handle,
+    const Handle& defaultClass);
+
+
+// Creates a new htb class on the egress side of the link, under the
+// htb queueing discipline or class 'parent', which limits the traffic
+// through it to 'rate' per second. Returns false if a class with the
+// same handle already exists.
+Try<bool> createClass(
+    const std::string& link,
+    const Handle& parent,
+    const Handle& handle,
+    const Bytes& rate);
+
+
 // Removes the htb queueing discipline from the link. Returns
 // false if the htb queueing discipline is not found.
 Try<bool> remove(
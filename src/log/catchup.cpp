@@ -17,13 +17,16 @@
 #include <stdint.h>
 
 #include <list>
+#include <set>
 
 #include <process/collect.hpp>
 #include <process/id.hpp>
 #include <process/process.hpp>
 #include <process/timer.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
+#include <stout/option.hpp>
 #include <stout/stringify.hpp>
 
 #include "log/catchup.hpp"
@@ -34,6 +37,7 @@
 using namespace process;
 
 using std::list;
+using std::set;
 
 namespace mesos {
 namespace internal {
@@ -165,6 +169,11 @@ static Future<uint64_t> catchup(
 }
 
 
+// Catches-up an interval of positions in two phases. First, we copy
+// the actions that the other replicas have learned already, in large
+// chunks. Then, we catch-up each position that is still missing (e.g.,
+// the unlearned tail of the log) through consensus.
+//
 // TODO(jieyu): Our current implementation catches-up each position in
 // the set sequentially. In the future, we may want to parallelize it
 // to improve the performance. Also, we may want to implement rate
@@ -198,14 +207,14 @@ protected:
     promise.future().onDiscard(lambda::bind(
         static_cast<void(*)(const UPID&, bool)>(terminate), self(), true));
 
-    // Catch-up sequentially.
     current = positions.lower();
 
-    catchup();
+    transfer();
   }
 
   virtual void finalize()
   {
+    transferring.discard();
     catching.discard();
 
     // TODO(benh): Discard our promise only after 'catching' has
@@ -219,6 +228,105 @@ private:
     catching.discard();
   }
 
+  static void expired(Future<Option<uint64_t> > transferring)
+  {
+    transferring.discard();
+  }
+
+  // Asks the other replicas for the learned actions from the current
+  // position on, and persists the ones the first replica responds
+  // with. Copying the actions is only an optimization, so if it does
+  // not work out we catch-up the positions through consensus.
+  void transfer()
+  {
+    if (current >= positions.upper()) {
+      transferred(None());
+      return;
+    }
+
+    CatchUpRequest request;
+    request.set_from(current);
+    request.set_to(positions.upper() - 1);
+
+    // The local replica is the one catching up.
+    set<UPID> filter;
+    filter.insert(replica->pid());
+
+    transferring = network->broadcast(protocol::catchup, request, filter)
+      .then(defer(self(), &Self::receive, lambda::_1))
+      .then(defer(self(), &Self::received, lambda::_1))
+      .onAny(defer(self(), &Self::transferred, lambda::_1));
+
+    Clock::timer(timeout, lambda::bind(&Self::expired, transferring));
+  }
+
+  Future<Future<CatchUpResponse> > receive(
+      const set<Future<CatchUpResponse> >& _responses)
+  {
+    if (_responses.empty()) {
+      return Failure("No other replicas in the network");
+    }
+
+    responses = _responses;
+
+    return select(responses);
+  }
+
+  // Returns the position after the persisted actions, or none if
+  // there are no actions to copy.
+  Future<Option<uint64_t> > received(const Future<CatchUpResponse>& response)
+  {
+    // We only need the first response.
+    process::discard(responses);
+    responses.clear();
+
+    if (!response.isReady() || response.get().actions_size() == 0) {
+      return None();
+    }
+
+    list<Action> actions;
+    foreach (const Action& action, response.get().actions()) {
+      actions.push_back(action);
+    }
+
+    const uint64_t next = actions.back().position() + 1;
+
+    return replica->learn(actions)
+      .then([next](bool learned) -> Future<Option<uint64_t> > {
+        if (!learned) {
+          return Failure("Failed to persist the learned actions");
+        }
+
+        return Option<uint64_t>(next);
+      });
+  }
+
+  void transferred(const Future<Option<uint64_t> >& future)
+  {
+    if (future.isReady() && future.get().isSome()) {
+      CHECK_GT(future.get().get(), current);
+
+      current = future.get().get();
+
+      transfer();
+      return;
+    }
+
+    if (future.isDiscarded()) {
+      LOG(INFO) << "Unable to copy the learned actions from position "
+                << current << " in " << timeout;
+    } else if (future.isFailed()) {
+      LOG(INFO) << "Unable to copy the learned actions from position "
+                << current << ": " << future.failure();
+    }
+
+    // Catch-up the positions that are still missing sequentially. The
+    // positions copied above are skipped as they are learned already.
+    current = positions.lower();
+
+    catchup();
+  }
+
   void catchup()
   {
     if (current >= positions.upper()) {
@@ -281,6 +389,8 @@ private:
   uint64_t current;
 
   process::Promise<Nothing> promise;
+  set<Future<CatchUpResponse> > responses;
+  Future<Option<uint64_t> > transferring;
   Future<uint64_t> catching;
 };
 
@@ -17,6 +17,7 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <deque>
 
 #include <mesos/type_utils.hpp>
 
@@ -25,6 +26,7 @@
 #include <process/id.hpp>
 #include <process/process.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/none.hpp>
 
 #include "log/catchup.hpp"
@@ -35,6 +37,7 @@
 
 using namespace process;
 
+using std::deque;
 using std::string;
 
 namespace mesos {
@@ -47,11 +50,13 @@ public:
   CoordinatorProcess(
       size_t _quorum,
       const Shared<Replica>& _replica,
-      const Shared<Network>& _network)
+      const Shared<Network>& _network,
+      size_t _window)
     : ProcessBase(ID::generate("log-coordinator")),
       quorum(_quorum),
       replica(_replica),
       network(_network),
+      window(_window),
       state(INITIAL),
       proposal(0),
       index(0) {}
@@ -61,14 +66,19 @@ public:
   // See comments in 'coordinator.hpp'.
   Future<Option<uint64_t> > elect();
   Future<uint64_t> demote();
-  Future<Option<uint64_t> > append(const string& bytes);
+  Future<Option<uint64_t> > append(
+      const string& bytes,
+      Action::Append::Compression compression);
   Future<Option<uint64_t> > truncate(uint64_t to);
 
 protected:
   virtual void finalize()
   {
     electing.discard();
-    writing.discard();
+
+    foreach (Future<Option<uint64_t> > write, writes) {
+      write.discard();
+    }
   }
 
 private:
@@ -94,20 +104,30 @@ private:
 
   Future<Option<uint64_t> > write(const Action& action);
   Future<WriteResponse> runWritePhase(const Action& action);
+  Future<Option<uint64_t> > checkPreviousWrite(
+      const Action& action,
+      Future<WriteResponse> response,
+      const Option<uint64_t>& previous);
   Future<Option<uint64_t> > checkWritePhase(
       const Action& action,
       const WriteResponse& response);
   Future<Nothing> runLearnPhase(const Action& action);
   Future<bool> checkLearnPhase(const Action& action);
-  Future<Option<uint64_t> > updateIndexAfterWritten(bool missing);
-  void writingFinished();
+  Future<Option<uint64_t> > checkPositionAfterWritten(
+      const Action& action,
+      bool missing);
+  void writingFinished(const Option<uint64_t>& position);
   void writingFailed();
   void writingAborted();
+  void writingDone();
 
   const size_t quorum;
   const Shared<Replica> replica;
   const Shared<Network> network;
 
+  // The maximum number of writes in flight.
+  const size_t window;
+
   // The current state of the coordinator. A coordinator needs to be
   // elected first to perform append and truncate operations. If one
   // tries to do an append or a truncate while the coordinator is not
@@ -115,7 +135,8 @@ private:
   // coordinator does not declare itself as elected until it wins the
   // election and has filled all existing positions. A coordinator is
   // put in electing state after it decides to go for an election and
-  // before it is elected.
+  // before it is elected. An elected coordinator is writing while any
+  // of its writes are in flight.
   enum
   {
     INITIAL,
@@ -131,7 +152,9 @@ private:
   uint64_t index;
 
   Future<Option<uint64_t> > electing;
-  Future<Option<uint64_t> > writing;
+
+  // The writes in flight, in the order of their positions.
+  deque<Future<Option<uint64_t> > > writes;
 };
 
 
@@ -148,6 +171,8 @@ Future<Option<uint64_t> > CoordinatorProcess::elect()
     return index - 1; // The last learned position!
   } else if (state == WRITING) {
     return Failure("Coordinator already elected, and is currently writing");
+  } else if (!writes.empty()) {
+    return Failure("Coordinator was demoted, and is still writing");
   }
 
   CHECK_EQ(state, INITIAL);
@@ -303,22 +328,26 @@ Future<uint64_t> CoordinatorProcess::demote()
 /////////////////////////////////////////////////
 
 
-Future<Option<uint64_t> > CoordinatorProcess::append(const string& bytes)
+Future<Option<uint64_t> > CoordinatorProcess::append(
+    const string& bytes,
+    Action::Append::Compression compression)
 {
   if (state == INITIAL || state == ELECTING) {
     return None();
-  } else if (state == WRITING) {
-    return Failure("Coordinator is currently writing");
   }
 
   Action action;
-  action.set_position(index);
+  action.set_position(index++);
   action.set_promised(proposal);
   action.set_performed(proposal);
   action.set_type(Action::APPEND);
   Action::Append* append = action.mutable_append();
   append->set_bytes(bytes);
 
+  if (compression != Action::Append::NONE) {
+    append->set_compression(compression);
+  }
+
   return write(action);
 }
 
@@ -327,12 +356,10 @@ Future<Option<uint64_t> > CoordinatorProcess::truncate(uint64_t to)
 {
   if (state == INITIAL || state == ELECTING) {
     return None();
-  } else if (state == WRITING) {
-    return Failure("Coordinator is currently writing");
   }
 
   Action action;
-  action.set_position(index);
+  action.set_position(index++);
   action.set_promised(proposal);
   action.set_performed(proposal);
   action.set_type(Action::TRUNCATE);
@@ -348,17 +375,42 @@ Future<Option<uint64_t> > CoordinatorProcess::write(const Action& action)
   LOG(INFO) << "Coordinator attempting to write " << action.type()
             << " action at position " << action.position();
 
-  CHECK_EQ(state, ELECTED);
+  CHECK(state == ELECTED || state == WRITING);
   CHECK(action.has_performed() && action.has_type());
 
   state = WRITING;
 
-  writing = runWritePhase(action)
-    .then(defer(self(), &Self::checkWritePhase, action, lambda::_1))
-    .onReady(defer(self(), &Self::writingFinished))
+  // Only 'window' writes run their write phase at a time, so the
+  // write phase of this write waits for the write 'window' positions
+  // before it to finish, unless that one finished already.
+  Future<Nothing> started = Nothing();
+  if (writes.size() >= window) {
+    started = writes[writes.size() - window]
+      .then([]() { return Nothing(); });
+  }
+
+  Future<WriteResponse> response =
+    started.then(defer(self(), &Self::runWritePhase, action));
+
+  // The writes commit and learn in order, so this one only checks
+  // its write phase after the previous write finished.
+  Future<Option<uint64_t> > previous = Option<uint64_t>(action.position() - 1);
+  if (!writes.empty()) {
+    previous = writes.back();
+  }
+
+  Future<Option<uint64_t> > writing = previous
+    .then(defer(self(),
+                &Self::checkPreviousWrite,
+                action,
+                response,
+                lambda::_1))
+    .onReady(defer(self(), &Self::writingFinished, lambda::_1))
     .onFailed(defer(self(), &Self::writingFailed))
     .onDiscarded(defer(self(), &Self::writingAborted));
 
+  writes.push_back(writing);
+
   return writing;
 }
 
@@ -369,6 +421,23 @@ Future<WriteResponse> CoordinatorProcess::runWritePhase(const Action& action)
 }
 
 
+Future<Option<uint64_t> > CoordinatorProcess::checkPreviousWrite(
+    const Action& action,
+    Future<WriteResponse> response,
+    const Option<uint64_t>& previous)
+{
+  if (previous.isNone()) {
+    // The coordinator was demoted by a previous write, so this write
+    // can not be committed either.
+    response.discard();
+    return None();
+  }
+
+  return response
+    .then(defer(self(), &Self::checkWritePhase, action, lambda::_1));
+}
+
+
 Future<Option<uint64_t> > CoordinatorProcess::checkWritePhase(
     const Action& action,
     const WriteResponse& response)
@@ -383,7 +452,10 @@ Future<Option<uint64_t> > CoordinatorProcess::checkWritePhase(
 
   return runLearnPhase(action)
     .then(defer(self(), &Self::checkLearnPhase, action))
-    .then(defer(self(), &Self::updateIndexAfterWritten, lambda::_1));
+    .then(defer(self(),
+                &Self::checkPositionAfterWritten,
+                action,
+                lambda::_1));
 }
 
 
@@ -402,39 +474,58 @@ Future<bool> CoordinatorProcess::checkLearnPhase(const Action& action)
 }
 
 
-Future<Option<uint64_t> > CoordinatorProcess::updateIndexAfterWritten(
+Future<Option<uint64_t> > CoordinatorProcess::checkPositionAfterWritten(
+    const Action& action,
     bool missing)
 {
   CHECK(!missing) << "Not expecting local replica to be missing position "
-                  << index << " after the writing is done";
+                  << action.position() << " after the writing is done";
 
-  return index++;
+  return action.position();
 }
 
 
-void CoordinatorProcess::writingFinished()
+void CoordinatorProcess::writingFinished(const Option<uint64_t>& position)
 {
-  CHECK_EQ(state, WRITING);
-  state = ELECTED;
+  // The positions after a NACK'ed write have been handed out already,
+  // so the coordinator needs to get elected again before writing.
+  if (position.isNone()) {
+    state = INITIAL;
+  }
+
+  writingDone();
 }
 
 
 void CoordinatorProcess::writingFailed()
 {
-  CHECK_EQ(state, WRITING);
   state = INITIAL;
+  writingDone();
 }
 
 
 void CoordinatorProcess::writingAborted()
 {
-  CHECK_EQ(state, WRITING);
-
   // Demote the coordinator if a write operation is discarded since we
   // don't actually know the write was successful or not and we really
   // need to "catch-up" that position before we try and do another
   // write (see MESOS-1038 for more details).
   state = INITIAL;
+  writingDone();
+}
+
+
+void CoordinatorProcess::writingDone()
+{
+  // The writes finish in order, but a failed write fails the writes
+  // after it right away, so we remove all the finished ones.
+  while (!writes.empty() && !writes.front().isPending()) {
+    writes.pop_front();
+  }
+
+  if (state == WRITING && writes.empty()) {
+    state = ELECTED;
+  }
 }
 
 
@@ -446,9 +537,10 @@ void CoordinatorProcess::writingAborted()
 Coordinator::Coordinator(
     size_t quorum,
     const Shared<Replica>& replica,
-    const Shared<Network>& network)
+    const Shared<Network>& network,
+    size_t window)
 {
-  process = new CoordinatorProcess(quorum, replica, network);
+  process = new CoordinatorProcess(quorum, replica, network, window);
   spawn(process);
 }
 
@@ -473,9 +565,11 @@ Future<uint64_t> Coordinator::demote()
 }
 
 
-Future<Option<uint64_t> > Coordinator::append(const string& bytes)
+Future<Option<uint64_t> > Coordinator::append(
+    const string& bytes,
+    Action::Append::Compression compression)
 {
-  return dispatch(process, &CoordinatorProcess::append, bytes);
+  return dispatch(process, &CoordinatorProcess::append, bytes, compression);
 }
 
 
@@ -40,10 +40,14 @@ class CoordinatorProcess;
 class Coordinator
 {
 public:
+  // The coordinator writes up to 'window' log positions at a time,
+  // i.e., it starts writing a position before the previous ones are
+  // committed, while still committing and learning them in order.
   Coordinator(
       size_t _quorum,
       const process::Shared<Replica>& _replica,
-      const process::Shared<Network>& _network);
+      const process::Shared<Network>& _network,
+      size_t _window = 1);
 
   ~Coordinator();
 
@@ -60,8 +64,14 @@ public:
 
   // Appends the specified bytes to the end of the log. Returns the
   // position of the appended entry if the operation succeeds or none
-  // if the coordinator was demoted.
-  process::Future<Option<uint64_t> > append(const std::string& bytes);
+  // if the coordinator was demoted, in which case the writes after
+  // it return none as well. Writes may be issued before the previous
+  // ones finish, and they finish in the order they were issued. The
+  // bytes are expected to be compressed already, 'compression' only
+  // records how, so that readers can decompress them.
+  process::Future<Option<uint64_t> > append(
+      const std::string& bytes,
+      Action::Append::Compression compression = Action::Append::NONE);
 
   // Removes all log entries preceding the log entry at the given
   // position (to). Returns the position at which the truncate
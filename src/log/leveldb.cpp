@@ -25,7 +25,10 @@
 
 #include <stout/check.hpp>
 #include <stout/error.hpp>
+#include <stout/foreach.hpp>
 #include <stout/numify.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/strings.hpp>
 #include <stout/unreachable.hpp>
@@ -33,6 +36,7 @@
 #include "log/leveldb.hpp"
 
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -126,8 +130,15 @@ static string encode(uint64_t position, bool adjust = true)
 // }
 
 
-LevelDBStorage::LevelDBStorage()
-  : db(NULL), first(None())
+LevelDBStorage::LevelDBStorage(
+    const Bytes& _cacheSize,
+    int _bloomFilterBitsPerKey)
+  : cacheSize(_cacheSize),
+    bloomFilterBitsPerKey(_bloomFilterBitsPerKey),
+    db(NULL),
+    cache(NULL),
+    filter(NULL),
+    first(None())
 {
   // Nothing to see here.
 }
@@ -136,14 +147,30 @@ LevelDBStorage::LevelDBStorage()
 LevelDBStorage::~LevelDBStorage()
 {
   delete db; // Might be null if open failed in LevelDBStorage::restore.
+
+  // The db has to be deleted before its cache and filter policy.
+  delete cache;
+  delete filter;
 }
 
 
-Try<Storage::State> LevelDBStorage::restore(const string& path)
+Try<Storage::State> LevelDBStorage::restore(const string& _path)
 {
+  path = _path;
+
   leveldb::Options options;
   options.create_if_missing = true;
 
+  cache = leveldb::NewLRUCache(cacheSize.bytes());
+  options.block_cache = cache;
+
+  // The tables written without a filter policy are still read, they
+  // just don't have a filter.
+  if (bloomFilterBitsPerKey > 0) {
+    filter = leveldb::NewBloomFilterPolicy(bloomFilterBitsPerKey);
+    options.filter_policy = filter;
+  }
+
   // TODO(benh): Can't use varint comparator until bug discussed at
   // groups.google.com/group/leveldb/browse_thread/thread/17eac39168909ba7
   // gets fixed. For now, we are using the default byte-wise
@@ -309,24 +336,41 @@ Try<Nothing> LevelDBStorage::persist(const Metadata& metadata)
 
 
 Try<Nothing> LevelDBStorage::persist(const Action& action)
+{
+  return persist(vector<Action>(1, action));
+}
+
+
+Try<Nothing> LevelDBStorage::persist(const vector<Action>& actions)
 {
   Stopwatch stopwatch;
   stopwatch.start();
 
-  Record record;
-  record.set_type(Record::ACTION);
-  record.mutable_action()->MergeFrom(action);
+  // Write all the actions with a single sync, which is what most of
+  // the time of a persist is spent on.
+  leveldb::WriteBatch batch;
 
-  string value;
+  size_t size = 0;
 
-  if (!record.SerializeToString(&value)) {
-    return Error("Failed to serialize record");
+  foreach (const Action& action, actions) {
+    Record record;
+    record.set_type(Record::ACTION);
+    record.mutable_action()->MergeFrom(action);
+
+    string value;
+
+    if (!record.SerializeToString(&value)) {
+      return Error("Failed to serialize record");
+    }
+
+    batch.Put(encode(action.position()), value);
+    size += value.size();
   }
 
   leveldb::WriteOptions options;
   options.sync = true;
 
-  leveldb::Status status = db->Put(options, encode(action.position()), value);
+  leveldb::Status status = db->Write(options, &batch);
 
   if (!status.ok()) {
     return Error(status.ToString());
@@ -336,76 +380,135 @@ Try<Nothing> LevelDBStorage::persist(const Action& action)
   // of checking 'isNone()' because it's likely that log entries are
   // written out of order during catch-up (e.g. if a random bulk
   // catch-up policy is used).
-  first = min(first, action.position());
+  foreach (const Action& action, actions) {
+    first = min(first, action.position());
+  }
 
-  LOG(INFO) << "Persisting action (" << value.size()
-            << " bytes) to leveldb took " << stopwatch.elapsed();
+  if (actions.size() == 1) {
+    LOG(INFO) << "Persisting action (" << size
+              << " bytes) to leveldb took " << stopwatch.elapsed();
+  } else {
+    LOG(INFO) << "Persisting " << actions.size() << " actions (" << size
+              << " bytes) to leveldb took " << stopwatch.elapsed();
+  }
 
   // Delete positions if a truncate action has been *learned*. Note
   // that we do this in a best-effort fashion (i.e., we ignore any
   // failures to the database since we can always try again).
-  if (action.has_type() && action.type() == Action::TRUNCATE &&
-      action.has_learned() && action.learned()) {
-    CHECK(action.has_truncate());
-
-    stopwatch.start(); // Restart the stopwatch.
-
-    // To actually perform the truncation in leveldb we need to remove
-    // all the keys that represent positions no longer in the log. We
-    // do this by attempting to delete all keys that represent the
-    // first position we know is still in leveldb up to (but
-    // excluding) the truncate position. Note that this works because
-    // the semantics of WriteBatch are such that even if the position
-    // doesn't exist (which is possible because this replica has some
-    // holes), we can attempt to delete the key that represents it and
-    // it will just ignore that key. This is *much* cheaper than
-    // actually iterating through the entire database instead (which
-    // was, for posterity, the original implementation). In addition,
-    // caching the "first" position we know is in the database is
-    // cheaper than using an iterator to determine the first position
-    // (which was, for posterity, the second implementation).
-
-    leveldb::WriteBatch batch;
-
-    CHECK_SOME(first);
-
-    // Add positions up to (but excluding) the truncate position to
-    // the batch starting at the first position still in leveldb. It's
-    // likely that the first position is greater than the truncate
-    // position (e.g., during catch-up). In that case, we do nothing
-    // because there is nothing we can truncate.
-    // TODO(jieyu): We might miss a truncation if we do random (i.e.,
-    // out of order) bulk catch-up and the truncate operation is
-    // caught up first.
-    uint64_t index = 0;
-    while ((first.get() + index) < action.truncate().to()) {
-      batch.Delete(encode(first.get() + index));
-      index++;
+  foreach (const Action& action, actions) {
+    if (action.has_type() && action.type() == Action::TRUNCATE &&
+        action.has_learned() && action.learned()) {
+      truncate(action);
     }
+  }
 
-    // If we added any positions, attempt to delete them!
-    if (index > 0) {
-      // We do this write asynchronously (e.g., using default options).
-      leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
-
-      if (!status.ok()) {
-        LOG(WARNING) << "Ignoring leveldb batch delete failure: "
-                     << status.ToString();
-      } else {
-        // Save the new first position!
-        CHECK_LT(first.get(), action.truncate().to());
-        first = action.truncate().to();
-
-        LOG(INFO) << "Deleting ~" << index
-                  << " keys from leveldb took " << stopwatch.elapsed();
-      }
+  return Nothing();
+}
+
+
+void LevelDBStorage::truncate(const Action& action)
+{
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  CHECK(action.has_truncate());
+
+  // To actually perform the truncation in leveldb we need to remove
+  // all the keys that represent positions no longer in the log. We
+  // do this by attempting to delete all keys that represent the
+  // first position we know is still in leveldb up to (but
+  // excluding) the truncate position. Note that this works because
+  // the semantics of WriteBatch are such that even if the position
+  // doesn't exist (which is possible because this replica has some
+  // holes), we can attempt to delete the key that represents it and
+  // it will just ignore that key. This is *much* cheaper than
+  // actually iterating through the entire database instead (which
+  // was, for posterity, the original implementation). In addition,
+  // caching the "first" position we know is in the database is
+  // cheaper than using an iterator to determine the first position
+  // (which was, for posterity, the second implementation).
+
+  leveldb::WriteBatch batch;
+
+  CHECK_SOME(first);
+
+  // Add positions up to (but excluding) the truncate position to
+  // the batch starting at the first position still in leveldb. It's
+  // likely that the first position is greater than the truncate
+  // position (e.g., during catch-up). In that case, we do nothing
+  // because there is nothing we can truncate.
+  // TODO(jieyu): We might miss a truncation if we do random (i.e.,
+  // out of order) bulk catch-up and the truncate operation is
+  // caught up first.
+  uint64_t index = 0;
+  while ((first.get() + index) < action.truncate().to()) {
+    batch.Delete(encode(first.get() + index));
+    index++;
+  }
+
+  // If we added any positions, attempt to delete them!
+  if (index > 0) {
+    // We do this write asynchronously (e.g., using default options).
+    leveldb::Status status = db->Write(leveldb::WriteOptions(), &batch);
+
+    if (!status.ok()) {
+      LOG(WARNING) << "Ignoring leveldb batch delete failure: "
+                   << status.ToString();
+    } else {
+      // Save the new first position!
+      CHECK_LT(first.get(), action.truncate().to());
+      first = action.truncate().to();
+
+      LOG(INFO) << "Deleting ~" << index
+                << " keys from leveldb took " << stopwatch.elapsed();
     }
   }
+}
+
+
+Try<Nothing> LevelDBStorage::compact(uint64_t to)
+{
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  // The deleted positions only free their disk space once leveldb
+  // compacts the tables they are in. Note that this includes the
+  // metadata record, which is tiny.
+  const string limit = encode(to);
+  const leveldb::Slice slice(limit);
+
+  db->CompactRange(NULL, &slice);
+
+  LOG(INFO) << "Compacting the positions before " << to
+            << " in leveldb took " << stopwatch.elapsed();
 
   return Nothing();
 }
 
 
+Try<Bytes> LevelDBStorage::size()
+{
+  Try<std::list<string> > files = os::ls(path);
+
+  if (files.isError()) {
+    return Error("Failed to list '" + path + "': " + files.error());
+  }
+
+  Bytes size;
+
+  foreach (const string& file, files.get()) {
+    Try<Bytes> bytes = os::stat::size(path::join(path, file));
+
+    // Files can be removed by a compaction while we list them.
+    if (bytes.isSome()) {
+      size += bytes.get();
+    }
+  }
+
+  return size;
+}
+
+
 Try<Action> LevelDBStorage::read(uint64_t position)
 {
   Stopwatch stopwatch;
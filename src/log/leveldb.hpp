@@ -17,10 +17,16 @@
 #ifndef __LOG_LEVELDB_HPP__
 #define __LOG_LEVELDB_HPP__
 
+#include <leveldb/cache.h>
 #include <leveldb/db.h>
+#include <leveldb/filter_policy.h>
 
 #include <stdint.h>
 
+#include <string>
+#include <vector>
+
+#include <stout/bytes.hpp>
 #include <stout/option.hpp>
 
 #include "log/storage.hpp"
@@ -33,16 +39,36 @@ namespace log {
 class LevelDBStorage : public Storage
 {
 public:
-  LevelDBStorage();
+  // The block cache keeps the recently read blocks of the log in
+  // memory, and a bloom filter with 'bloomFilterBitsPerKey' bits per
+  // key (0 disables them) saves the disk reads of the positions that
+  // are not in the log, e.g., holes.
+  explicit LevelDBStorage(
+      const Bytes& cacheSize = Megabytes(8),
+      int bloomFilterBitsPerKey = 10);
+
   virtual ~LevelDBStorage();
 
   virtual Try<State> restore(const std::string& path);
   virtual Try<Nothing> persist(const Metadata& metadata);
   virtual Try<Nothing> persist(const Action& action);
+  virtual Try<Nothing> persist(const std::vector<Action>& actions);
   virtual Try<Action> read(uint64_t position);
+  virtual Try<Nothing> compact(uint64_t to);
+  virtual Try<Bytes> size();
 
 private:
+  // Deletes the positions truncated by a learned truncate action.
+  void truncate(const Action& action);
+
+  const Bytes cacheSize;
+  const int bloomFilterBitsPerKey;
+
+  std::string path;
+
   leveldb::DB* db;
+  leveldb::Cache* cache;
+  const leveldb::FilterPolicy* filter;
 
   // First position still in leveldb, used during truncation.
   Option<uint64_t> first;
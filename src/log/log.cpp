@@ -27,9 +27,11 @@
 #include <stout/check.hpp>
 #include <stout/error.hpp>
 #include <stout/foreach.hpp>
+#include <stout/gzip.hpp>
 #include <stout/lambda.hpp>
 #include <stout/nothing.hpp>
 #include <stout/set.hpp>
+#include <stout/stringify.hpp>
 
 #include "log/coordinator.hpp"
 #include "log/log.hpp"
@@ -117,6 +119,12 @@ public:
       const Log::Position& from,
       const Log::Position& to);
 
+  Future<Nothing> stream(
+      const Log::Position& from,
+      const Log::Position& to,
+      const lambda::function<Future<Nothing>(const list<Log::Entry>&)>& f,
+      size_t count);
+
 protected:
   virtual void initialize();
   virtual void finalize();
@@ -139,6 +147,12 @@ private:
       const Log::Position& from,
       const Log::Position& to);
 
+  Future<Nothing> _stream(
+      const Log::Position& last,
+      const Log::Position& to,
+      const lambda::function<Future<Nothing>(const list<Log::Entry>&)>& f,
+      size_t count);
+
   Future<list<Log::Entry> > __read(
       const Log::Position& from,
       const Log::Position& to,
@@ -152,7 +166,7 @@ private:
 class LogWriterProcess : public Process<LogWriterProcess>
 {
 public:
-  explicit LogWriterProcess(Log* log);
+  LogWriterProcess(Log* log, size_t window, bool compress);
 
   Future<Option<Log::Position> > start();
   Future<Option<Log::Position> > append(const string& bytes);
@@ -181,6 +195,8 @@ private:
 
   const size_t quorum;
   const Shared<Network> network;
+  const size_t window;
+  const bool compress;
 
   Future<Shared<Replica> > recovering;
   list<process::Promise<Nothing>*> promises;
@@ -546,7 +562,24 @@ Future<list<Log::Entry> > LogReaderProcess::__read(
     // And only return appends.
     CHECK(action.has_type());
     if (action.type() == Action::APPEND) {
-      entries.push_back(Log::Entry(action.position(), action.append().bytes()));
+      const Action::Append& append = action.append();
+
+      switch (append.compression()) {
+        case Action::Append::NONE:
+          entries.push_back(Log::Entry(action.position(), append.bytes()));
+          break;
+        case Action::Append::GZIP: {
+          Try<string> decompressed = gzip::decompress(append.bytes());
+          if (decompressed.isError()) {
+            return Failure(
+                "Failed to decompress entry at position " +
+                stringify(action.position()) + ": " + decompressed.error());
+          }
+
+          entries.push_back(Log::Entry(action.position(), decompressed.get()));
+          break;
+        }
+      }
     }
   }
 
@@ -554,6 +587,43 @@ Future<list<Log::Entry> > LogReaderProcess::__read(
 }
 
 
+Future<Nothing> LogReaderProcess::stream(
+    const Log::Position& from,
+    const Log::Position& to,
+    const lambda::function<Future<Nothing>(const list<Log::Entry>&)>& f,
+    size_t count)
+{
+  if (count == 0) {
+    return Failure("Bad read batch size (0)");
+  } else if (to < from) {
+    return Failure("Bad read range (to < from)");
+  }
+
+  // The last position of this batch.
+  const Log::Position last = to.value - from.value < count
+    ? to
+    : Log::Position(from.value + count - 1);
+
+  return read(from, last)
+    .then(f)
+    .then(defer(self(), &Self::_stream, last, to, f, count));
+}
+
+
+Future<Nothing> LogReaderProcess::_stream(
+    const Log::Position& last,
+    const Log::Position& to,
+    const lambda::function<Future<Nothing>(const list<Log::Entry>&)>& f,
+    size_t count)
+{
+  if (last == to) {
+    return Nothing();
+  }
+
+  return stream(last.value + 1, to, f, count);
+}
+
+
 Log::Position LogReaderProcess::position(uint64_t value)
 {
   return Log::Position(value);
@@ -565,10 +635,12 @@ Log::Position LogReaderProcess::position(uint64_t value)
 /////////////////////////////////////////////////
 
 
-LogWriterProcess::LogWriterProcess(Log* log)
+LogWriterProcess::LogWriterProcess(Log* log, size_t _window, bool _compress)
   : ProcessBase(ID::generate("log-writer")),
     quorum(log->process->quorum),
     network(log->process->network),
+    window(_window),
+    compress(_compress),
     recovering(dispatch(log->process, &LogProcess::recover)),
     coordinator(NULL),
     error(None()) {}
@@ -654,7 +726,7 @@ Future<Option<Log::Position> > LogWriterProcess::_start()
 
   CHECK_READY(recovering);
 
-  coordinator = new Coordinator(quorum, recovering.get(), network);
+  coordinator = new Coordinator(quorum, recovering.get(), network, window);
 
   LOG(INFO) << "Attempting to start the writer";
 
@@ -690,7 +762,24 @@ Future<Option<Log::Position> > LogWriterProcess::append(const string& bytes)
     return Failure(error.get());
   }
 
-  return coordinator->append(bytes)
+  string data = bytes;
+  Action::Append::Compression compression = Action::Append::NONE;
+
+  if (compress) {
+    // We keep the bytes uncompressed if compressing does not make them
+    // smaller, e.g., for small entries or already compressed data.
+    Try<string> compressed = gzip::compress(bytes);
+    if (compressed.isError()) {
+      return Failure("Failed to compress: " + compressed.error());
+    }
+
+    if (compressed.get().size() < bytes.size()) {
+      data = compressed.get();
+      compression = Action::Append::GZIP;
+    }
+  }
+
+  return coordinator->append(data, compression)
     .then(lambda::bind(&Self::position, lambda::_1))
     .onFailed(defer(self(), &Self::failed, "Failed to append", lambda::_1));
 }
@@ -816,6 +905,16 @@ Future<list<Log::Entry> > Log::Reader::read(
 }
 
 
+Future<Nothing> Log::Reader::read(
+    const Log::Position& from,
+    const Log::Position& to,
+    const lambda::function<Future<Nothing>(const list<Log::Entry>&)>& f,
+    size_t count)
+{
+  return dispatch(process, &LogReaderProcess::stream, from, to, f, count);
+}
+
+
 Future<Log::Position> Log::Reader::beginning()
 {
   return dispatch(process, &LogReaderProcess::beginning);
@@ -833,9 +932,9 @@ Future<Log::Position> Log::Reader::ending()
 /////////////////////////////////////////////////
 
 
-Log::Writer::Writer(Log* log)
+Log::Writer::Writer(Log* log, size_t window, bool compress)
 {
-  process = new LogWriterProcess(log);
+  process = new LogWriterProcess(log, window, compress);
   spawn(process);
 }
 
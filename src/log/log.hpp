@@ -30,6 +30,7 @@
 #include <process/timeout.hpp>
 
 #include <stout/duration.hpp>
+#include <stout/lambda.hpp>
 #include <stout/none.hpp>
 #include <stout/option.hpp>
 
@@ -133,6 +134,19 @@ public:
         const Position& from,
         const Position& to);
 
+    // Reads the entries between the specified positions in batches of
+    // up to 'count' positions, and calls 'f' with the entries of each
+    // batch in order. The next batch is only read once the future
+    // returned by 'f' for the previous one is ready, so only a batch
+    // at a time is kept in memory. Returns a failure if the positions
+    // are invalid or if 'f' fails.
+    process::Future<Nothing> read(
+        const Position& from,
+        const Position& to,
+        const lambda::function<
+            process::Future<Nothing>(const std::list<Entry>&)>& f,
+        size_t count = 1024);
+
     // Returns the beginning position of the log from the perspective
     // of the local replica (which may be out of date if the log has
     // been opened and truncated while this replica was partitioned).
@@ -155,8 +169,14 @@ public:
     // one writer (local or remote) can be valid at any point in
     // time. A writer becomes invalid if either Writer::append or
     // Writer::truncate return None, in which case, the writer (or
-    // another writer) must be restarted.
-    explicit Writer(Log* log);
+    // another writer) must be restarted. The writer writes up to
+    // 'window' entries at a time, so that appends and truncates that
+    // are issued before the previous ones finish do not each wait for
+    // a round trip to a quorum of the replicas. If 'compress' is set,
+    // the writer compresses the data it appends (unless that does not
+    // make it smaller), and readers decompress it transparently. Only
+    // enable this once all the readers of the log support it.
+    explicit Writer(Log* log, size_t window = 1, bool compress = false);
     ~Writer();
 
     // Attempts to get a promise (from the log's replicas) for
@@ -17,15 +17,25 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <utility>
+#include <vector>
 
 #include <mesos/type_utils.hpp>
 
+#include <process/async.hpp>
+#include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/id.hpp>
 
+#include <process/metrics/gauge.hpp>
+#include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
+
+#include <stout/bytes.hpp>
 #include <stout/check.hpp>
 #include <stout/error.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
 #include <stout/result.hpp>
@@ -39,7 +49,9 @@
 using namespace process;
 
 using std::list;
+using std::pair;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -51,10 +63,16 @@ namespace protocol {
 Protocol<PromiseRequest, PromiseResponse> promise;
 Protocol<WriteRequest, WriteResponse> write;
 Protocol<RecoverRequest, RecoverResponse> recover;
+Protocol<CatchUpRequest, CatchUpResponse> catchup;
 
 } // namespace protocol {
 
 
+// The (approximate) maximum size of the actions in a response to a
+// catch-up request.
+static const Bytes MAX_CATCH_UP_RESPONSE_SIZE = Megabytes(4);
+
+
 class ReplicaProcess : public ProtobufProcess<ReplicaProcess>
 {
 public:
@@ -100,6 +118,11 @@ public:
   // to storage. Returns true on success and false otherwise.
   bool update(const Metadata::Status& status);
 
+  // Persists the learned actions at once, skipping the positions that
+  // are truncated or learned already. Returns true on success and
+  // false otherwise.
+  bool learn(const list<Action>& actions);
+
 private:
   // Handles a request from a proposer to promise not to accept writes
   // from any other proposer with lower proposal number.
@@ -114,10 +137,28 @@ private:
   // Handles a message notifying of a learned action.
   void learned(const UPID& from, const Action& action);
 
+  // Handles a request for the learned actions in a range of positions.
+  void catchup(const UPID& from, const CatchUpRequest& request);
+
   // Persists the specified action to storage. Returns true on success
   // and false otherwise.
   bool persist(const Action& action);
 
+  // Stages the action of a write request, to be persisted along with
+  // the actions of the other write requests that arrive before it is
+  // committed, and replies with the response once it is persisted.
+  void stage(
+      const UPID& from,
+      const Action& action,
+      const WriteResponse& response);
+
+  // Persists the staged actions with a single write to storage and
+  // replies to their write requests.
+  void commit();
+
+  // Updates the positions of the log after an action was persisted.
+  void persisted(const Action& action);
+
   // Updates the highest promise this replica has given. The update
   // will be persisted to storage. Returns true on success and false
   // otherwise.
@@ -126,6 +167,15 @@ private:
   // Helper routine to restore log (e.g., on restart).
   void restore(const string& path);
 
+  // Reclaims the disk space of the truncated positions before 'to' in
+  // the background. Only one compaction runs at a time, the last one
+  // requested meanwhile runs after it.
+  void compact(uint64_t to);
+  void compacted(const Future<Try<Nothing>>& future);
+
+  // Gauge handler.
+  Future<double> _size_bytes();
+
   // Underlying storage for the log.
   Storage* storage;
 
@@ -144,13 +194,48 @@ private:
 
   // Unlearned positions in the log.
   IntervalSet<uint64_t> unlearned;
+
+  // The staged actions, their positions and the responses to their
+  // write requests. Other requests commit the staged actions before
+  // they read or persist anything.
+  vector<Action> staged;
+  hashset<uint64_t> positions;
+  vector<pair<UPID, WriteResponse>> responses;
+
+  // The compaction in progress, and the next one to run after it.
+  Future<Try<Nothing>> compacting;
+  Option<uint64_t> compaction;
+
+  struct Metrics
+  {
+    explicit Metrics(const ReplicaProcess& process)
+      : size_bytes(
+            "log/replica/size_bytes",
+            defer(process, &ReplicaProcess::_size_bytes)),
+        compaction("log/replica/compaction")
+    {
+      process::metrics::add(size_bytes);
+      process::metrics::add(compaction);
+    }
+
+    ~Metrics()
+    {
+      process::metrics::remove(size_bytes);
+      process::metrics::remove(compaction);
+    }
+
+    process::metrics::Gauge size_bytes;
+    process::metrics::Timer<Milliseconds> compaction;
+  } metrics;
 };
 
 
 ReplicaProcess::ReplicaProcess(const string& path)
   : ProcessBase(ID::generate("log-replica")),
     begin(0),
-    end(0)
+    end(0),
+    compacting(Try<Nothing>(Nothing())),
+    metrics(*this)
 {
   // TODO(benh): Factor out and expose storage.
   storage = new LevelDBStorage();
@@ -170,11 +255,17 @@ ReplicaProcess::ReplicaProcess(const string& path)
   install<LearnedMessage>(
       &ReplicaProcess::learned,
       &LearnedMessage::action);
+
+  install<CatchUpRequest>(
+      &ReplicaProcess::catchup);
 }
 
 
 ReplicaProcess::~ReplicaProcess()
 {
+  // The compaction uses the storage in another thread.
+  compacting.await();
+
   delete storage;
 }
 
@@ -307,6 +398,8 @@ uint64_t ReplicaProcess::promised()
 
 bool ReplicaProcess::update(const Metadata::Status& status)
 {
+  commit();
+
   Metadata metadata_;
   metadata_.set_status(status);
   metadata_.set_promised(promised());
@@ -327,6 +420,41 @@ bool ReplicaProcess::update(const Metadata::Status& status)
 }
 
 
+bool ReplicaProcess::learn(const list<Action>& actions)
+{
+  commit();
+
+  vector<Action> learning;
+
+  foreach (const Action& action, actions) {
+    CHECK(action.has_learned() && action.learned());
+
+    if (missing(action.position())) {
+      learning.push_back(action);
+    }
+  }
+
+  if (learning.empty()) {
+    return true;
+  }
+
+  Try<Nothing> result = storage->persist(learning);
+
+  if (result.isError()) {
+    LOG(ERROR) << "Error writing to log: " << result.error();
+    return false;
+  }
+
+  LOG(INFO) << "Persisted " << learning.size() << " learned action(s)";
+
+  foreach (const Action& action, learning) {
+    persisted(action);
+  }
+
+  return true;
+}
+
+
 bool ReplicaProcess::updatePromised(uint64_t promised)
 {
   Metadata metadata_;
@@ -371,6 +499,8 @@ bool ReplicaProcess::updatePromised(uint64_t promised)
 
 void ReplicaProcess::promise(const UPID& from, const PromiseRequest& request)
 {
+  commit();
+
   // Ignore promise requests if this replica is not in VOTING status;
   // we also inform the requester, so that they can retry promptly.
   if (status() != Metadata::VOTING) {
@@ -538,6 +668,12 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
   LOG(INFO) << "Replica received write request for position "
             << request.position() << " from " << from;
 
+  // A write to a position that is staged already needs to see the
+  // staged action, so we persist the staged actions first.
+  if (positions.contains(request.position())) {
+    commit();
+  }
+
   Result<Action> result = read(request.position());
 
   if (result.isError()) {
@@ -576,14 +712,12 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
           LOG(FATAL) << "Unknown Action::Type!";
       }
 
-      if (persist(action)) {
-        WriteResponse response;
-        response.set_type(WriteResponse::ACCEPT);
-        response.set_okay(true);
-        response.set_proposal(request.proposal());
-        response.set_position(request.position());
-        reply(response);
-      }
+      WriteResponse response;
+      response.set_type(WriteResponse::ACCEPT);
+      response.set_okay(true);
+      response.set_proposal(request.proposal());
+      response.set_position(request.position());
+      stage(from, action, response);
     }
   } else if (result.isSome()) {
     Action action = result.get();
@@ -655,14 +789,12 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
             LOG(FATAL) << "Unknown Action::Type!";
         }
 
-        if (persist(action)) {
-          WriteResponse response;
-          response.set_type(WriteResponse::ACCEPT);
-          response.set_okay(true);
-          response.set_proposal(request.proposal());
-          response.set_position(request.position());
-          reply(response);
-        }
+        WriteResponse response;
+        response.set_type(WriteResponse::ACCEPT);
+        response.set_okay(true);
+        response.set_proposal(request.proposal());
+        response.set_position(request.position());
+        stage(from, action, response);
       }
     }
   }
@@ -671,6 +803,8 @@ void ReplicaProcess::write(const UPID& from, const WriteRequest& request)
 
 void ReplicaProcess::recover(const UPID& from, const RecoverRequest& request)
 {
+  commit();
+
   LOG(INFO) << "Replica in " << status()
             << " status received a broadcasted recover request from "
             << from;
@@ -689,6 +823,8 @@ void ReplicaProcess::recover(const UPID& from, const RecoverRequest& request)
 
 void ReplicaProcess::learned(const UPID& from, const Action& action)
 {
+  commit();
+
   LOG(INFO) << "Replica received learned notice for position "
             << action.position() << " from " << from;
 
@@ -701,17 +837,116 @@ void ReplicaProcess::learned(const UPID& from, const Action& action)
 }
 
 
+void ReplicaProcess::catchup(const UPID& from, const CatchUpRequest& request)
+{
+  commit();
+
+  // Only a replica in VOTING status can tell which actions have been
+  // learned. We do not reply otherwise, so that the requester uses
+  // the response of another replica.
+  if (status() != Metadata::VOTING) {
+    LOG(INFO) << "Replica ignoring catch-up request from " << from
+              << " as it is in " << status() << " status";
+    return;
+  }
+
+  LOG(INFO) << "Replica received catch-up request for positions "
+            << request.from() << " -> " << request.to() << " from " << from;
+
+  CatchUpResponse response;
+  Bytes size = 0;
+
+  const uint64_t to = std::min(request.to(), end);
+
+  for (uint64_t position = std::max(request.from(), begin);
+       position <= to && size < MAX_CATCH_UP_RESPONSE_SIZE;
+       position++) {
+    if (holes.contains(position) || unlearned.contains(position)) {
+      continue;
+    }
+
+    Try<Action> action = storage->read(position);
+
+    if (action.isError()) {
+      LOG(ERROR) << "Error getting log record at " << position
+                 << ": " << action.error();
+      break;
+    }
+
+    response.add_actions()->CopyFrom(action.get());
+    size += Bytes(action.get().ByteSize());
+  }
+
+  reply(response);
+}
+
+
 bool ReplicaProcess::persist(const Action& action)
 {
-  Try<Nothing> persisted = storage->persist(action);
+  Try<Nothing> result = storage->persist(action);
 
-  if (persisted.isError()) {
-    LOG(ERROR) << "Error writing to log: " << persisted.error();
+  if (result.isError()) {
+    LOG(ERROR) << "Error writing to log: " << result.error();
     return false;
   }
 
   LOG(INFO) << "Persisted action at " << action.position();
 
+  persisted(action);
+
+  return true;
+}
+
+
+void ReplicaProcess::stage(
+    const UPID& from,
+    const Action& action,
+    const WriteResponse& response)
+{
+  // The write requests already queued up for this replica get staged
+  // before the dispatched commit, so they are persisted together.
+  if (staged.empty()) {
+    dispatch(self(), &ReplicaProcess::commit);
+  }
+
+  staged.push_back(action);
+  positions.insert(action.position());
+  responses.push_back(std::make_pair(from, response));
+}
+
+
+void ReplicaProcess::commit()
+{
+  if (staged.empty()) {
+    return;
+  }
+
+  Try<Nothing> result = storage->persist(staged);
+
+  if (result.isError()) {
+    LOG(ERROR) << "Error writing to log: " << result.error();
+  } else {
+    LOG(INFO) << "Persisted " << staged.size() << " staged action(s)";
+
+    foreach (const Action& action, staged) {
+      persisted(action);
+    }
+
+    // Like with the other requests, a write request is only replied
+    // to if its action was persisted.
+    foreach (const auto& response, responses) {
+      send(response.first, response.second);
+    }
+  }
+
+  staged.clear();
+  positions.clear();
+  responses.clear();
+}
+
+
+void ReplicaProcess::persisted(const Action& action)
+{
   // No longer a hole here (if there even was one).
   holes -= action.position();
 
@@ -730,8 +965,12 @@ bool ReplicaProcess::persist(const Action& action)
       unlearned -= (Bound<uint64_t>::open(0),
                     Bound<uint64_t>::open(action.truncate().to()));
 
-      // And update the beginning position.
-      begin = std::max(begin, action.truncate().to());
+      // And update the beginning position, and reclaim the disk
+      // space of the truncated positions.
+      if (action.truncate().to() > begin) {
+        begin = action.truncate().to();
+        compact(begin);
+      }
     }
   } else {
     // We just introduced an unlearned position.
@@ -746,8 +985,54 @@ bool ReplicaProcess::persist(const Action& action)
 
   // And update the end position.
   end = std::max(end, action.position());
+}
 
-  return true;
+
+void ReplicaProcess::compact(uint64_t to)
+{
+  if (compacting.isPending()) {
+    compaction = to;
+    return;
+  }
+
+  Storage* storage = this->storage;
+
+  metrics.compaction.start();
+
+  compacting = async([storage, to]() { return storage->compact(to); });
+  compacting.onAny(defer(self(), &Self::compacted, lambda::_1));
+}
+
+
+void ReplicaProcess::compacted(const Future<Try<Nothing>>& future)
+{
+  metrics.compaction.stop();
+
+  if (!future.isReady()) {
+    LOG(WARNING) << "Failed to compact the log: "
+                 << (future.isFailed() ? future.failure() : "discarded");
+  } else if (future.get().isError()) {
+    LOG(WARNING) << "Failed to compact the log: " << future.get().error();
+  }
+
+  if (compaction.isSome()) {
+    const uint64_t to = compaction.get();
+    compaction = None();
+
+    compact(to);
+  }
+}
+
+
+Future<double> ReplicaProcess::_size_bytes()
+{
+  Try<Bytes> size = storage->size();
+
+  if (size.isError()) {
+    return Failure(size.error());
+  }
+
+  return static_cast<double>(size.get().bytes());
 }
 
 
@@ -846,6 +1131,12 @@ Future<bool> Replica::update(const Metadata::Status& status)
 }
 
 
+Future<bool> Replica::learn(const list<Action>& actions) const
+{
+  return dispatch(process, &ReplicaProcess::learn, actions);
+}
+
+
 PID<ReplicaProcess> Replica::pid() const
 {
   return process->self();
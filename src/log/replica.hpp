@@ -40,6 +40,7 @@ namespace protocol {
 extern Protocol<PromiseRequest, PromiseResponse> promise;
 extern Protocol<WriteRequest, WriteResponse> write;
 extern Protocol<RecoverRequest, RecoverResponse> recover;
+extern Protocol<CatchUpRequest, CatchUpResponse> catchup;
 
 } // namespace protocol {
 
@@ -94,6 +95,12 @@ public:
   // mocking in tests.
   virtual process::Future<bool> update(const Metadata::Status& status);
 
+  // Persists learned actions, e.g., the ones copied from another
+  // replica during catch-up, all at once. The positions that are
+  // truncated or learned already are skipped. Returns true if the
+  // actions were persisted successfully, false otherwise.
+  process::Future<bool> learn(const std::list<Action>& actions) const;
+
   // Returns the PID associated with this replica.
   process::PID<ReplicaProcess> pid() const;
 
@@ -20,7 +20,9 @@
 #include <stdint.h>
 
 #include <string>
+#include <vector>
 
+#include <stout/bytes.hpp>
 #include <stout/interval.hpp>
 #include <stout/nothing.hpp>
 #include <stout/try.hpp>
@@ -53,7 +55,20 @@ public:
   virtual Try<State> restore(const std::string& path) = 0;
   virtual Try<Nothing> persist(const Metadata& metadata) = 0;
   virtual Try<Nothing> persist(const Action& action) = 0;
+
+  // Persists all the actions at once, e.g., with a single sync to
+  // disk, so that either all or none of them are persisted.
+  virtual Try<Nothing> persist(const std::vector<Action>& actions) = 0;
+
   virtual Try<Action> read(uint64_t position) = 0;
+
+  // Reclaims the disk space of the positions before 'to', which have
+  // been truncated. Unlike the other operations, this one may be run
+  // in a different thread, as it can take a while.
+  virtual Try<Nothing> compact(uint64_t to) = 0;
+
+  // Returns the size of the log on disk.
+  virtual Try<Bytes> size() = 0;
 };
 
 } // namespace log {
@@ -88,6 +88,11 @@ Benchmark::Flags::Flags()
       "  random: all bits are randomly chosen\n",
       "random");
 
+  add(&Flags::window,
+      "window",
+      "Maximum number of appends in flight at a time",
+      1);
+
   add(&Flags::initialize,
       "initialize",
       "Whether to initialize the log",
@@ -104,7 +109,8 @@ Try<Nothing> Benchmark::execute(int argc, char** argv)
       "replicated log. It takes a trace file of write sizes\n"
       "and replay that trace to measure the latency of each\n"
       "write. The data to be written for each write can be\n"
-      "specified using the --type flag.\n"
+      "specified using the --type flag, and the number of\n"
+      "writes in flight using the --window flag.\n"
       "\n");
 
   // Configure the tool by parsing command line arguments.
@@ -146,6 +152,10 @@ Try<Nothing> Benchmark::execute(int argc, char** argv)
     return Error(flags.usage("Missing required option --output"));
   }
 
+  if (flags.window == 0) {
+    return Error(flags.usage("Expected --window to be at least 1"));
+  }
+
   // Initialize the log.
   if (flags.initialize) {
     Initialize initialize;
@@ -166,7 +176,7 @@ Try<Nothing> Benchmark::execute(int argc, char** argv)
       flags.znode.get());
 
   // Create the log writer.
-  Log::Writer writer(&log);
+  Log::Writer writer(&log, flags.window);
 
   Future<Option<Log::Position> > position = writer.start();
 
@@ -214,32 +224,52 @@ Try<Nothing> Benchmark::execute(int argc, char** argv)
     }
   }
 
+  // The appends in flight, and when they were issued.
+  vector<Future<Option<Log::Position> > > appends(sizes.size());
+  vector<Time> starts(sizes.size());
+
   Stopwatch stopwatch;
   stopwatch.start();
 
-  for (size_t i = 0; i < sizes.size(); i++) {
-    Stopwatch stopwatch;
-    stopwatch.start();
-
-    position = writer.append(data[i]);
-
-    if (!position.await(Seconds(10))) {
-      return Error("Failed to append: timed out");
-    } else if (!position.isReady()) {
-      return Error("Failed to append: " +
-                   (position.isFailed()
-                    ? position.failure()
-                    : "Discarded future"));
-    } else if (position.get().isNone()) {
-      return Error("Failed to append: exclusive write promise lost");
+  // Issue the appends, keeping up to --window of them in flight.
+  // They finish in order, so we wait for them in order as well.
+  for (size_t i = 0; i < sizes.size() + flags.window; i++) {
+    if (i >= flags.window) {
+      const size_t j = i - flags.window;
+
+      if (j >= sizes.size()) {
+        continue;
+      }
+
+      position = appends[j];
+
+      if (!position.await(Seconds(10))) {
+        return Error("Failed to append: timed out");
+      } else if (!position.isReady()) {
+        return Error("Failed to append: " +
+                     (position.isFailed()
+                      ? position.failure()
+                      : "Discarded future"));
+      } else if (position.get().isNone()) {
+        return Error("Failed to append: exclusive write promise lost");
+      }
+
+      timestamps.push_back(Clock::now());
+      durations.push_back(timestamps.back() - starts[j]);
     }
 
-    durations.push_back(stopwatch.elapsed());
-    timestamps.push_back(Clock::now());
+    if (i < sizes.size()) {
+      starts[i] = Clock::now();
+      appends[i] = writer.append(data[i]);
+    }
   }
 
+  const Duration elapsed = stopwatch.elapsed();
+
   cout << "Total number of appends: " << sizes.size() << endl;
-  cout << "Total time used: " << stopwatch.elapsed() << endl;
+  cout << "Total time used: " << elapsed << endl;
+  cout << "Throughput with a window of " << flags.window << ": "
+       << sizes.size() / elapsed.secs() << " appends/s" << endl;
 
   // Ouput statistics.
   ofstream output(flags.output.get().c_str());
@@ -44,6 +44,7 @@ public:
     Option<std::string> input;
     Option<std::string> output;
     std::string type;
+    size_t window;
     bool initialize;
     bool help;
   };
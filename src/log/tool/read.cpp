@@ -144,24 +144,44 @@ Try<Nothing> Read::execute(int argc, char** argv)
   LOG(INFO) << "Attempting to read the log from "
             << from.get() << " to " << to.get() << endl;
 
-  Future<list<Action> > actions = replica.read(from.get(), to.get());
-  if (timeout.isSome()) {
-    actions.await(timeout.get().remaining());
-  } else {
-    actions.await();
+  if (to.get() < from.get()) {
+    return Error("Bad read range (to < from)");
   }
 
-  if (actions.isPending()) {
-    return Error("Timed out while reading the replica");
-  } else if (actions.isDiscarded()) {
-    return Error("Failed to read the replica (discarded future)");
-  } else if (actions.isFailed()) {
-    return Error(actions.failure());
-  }
+  // Read the log in batches of positions so that we don't need to
+  // keep the whole range in memory.
+  const uint64_t count = 1024;
+
+  for (uint64_t position = from.get(); position <= to.get();) {
+    const uint64_t last = to.get() - position < count
+      ? to.get()
+      : position + count - 1;
+
+    Future<list<Action> > actions = replica.read(position, last);
+    if (timeout.isSome()) {
+      actions.await(timeout.get().remaining());
+    } else {
+      actions.await();
+    }
+
+    if (actions.isPending()) {
+      return Error("Timed out while reading the replica");
+    } else if (actions.isDiscarded()) {
+      return Error("Failed to read the replica (discarded future)");
+    } else if (actions.isFailed()) {
+      return Error(actions.failure());
+    }
+
+    foreach (const Action& action, actions.get()) {
+      cout << "----------------------------------------------" << endl;
+      action.PrintDebugString();
+    }
+
+    if (last == to.get()) {
+      break;
+    }
 
-  foreach (const Action& action, actions.get()) {
-    cout << "----------------------------------------------" << endl;
-    action.PrintDebugString();
+    position = last + 1;
   }
 
   return Nothing();
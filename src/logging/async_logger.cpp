@@ -0,0 +1,223 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h> // For memcpy().
+
+#include <glog/logging.h>
+#include <glog/raw_logging.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+#include "logging/async_logger.hpp"
+
+using process::metrics::Counter;
+
+using std::string;
+
+namespace mesos {
+namespace internal {
+namespace logging {
+
+AsyncLogger::AsyncLogger(
+    google::base::Logger* _logger,
+    size_t _capacity,
+    bool _drop,
+    const Counter& _dropped)
+  : logger(_logger),
+    capacity(_capacity),
+    drop(_drop),
+    dropped(_dropped),
+    buffer(new char[_capacity]),
+    head(0),
+    tail(0),
+    writing(false),
+    stopping(false)
+{
+  thread = std::thread(&AsyncLogger::run, this);
+}
+
+
+AsyncLogger::~AsyncLogger()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+
+  ready.notify_one();
+  thread.join();
+
+  delete[] buffer;
+}
+
+
+void AsyncLogger::Write(
+    bool forceFlush,
+    time_t timestamp,
+    const char* message,
+    int length)
+{
+  // The buffer can not be written to by more than one thread at a
+  // time. We use RAW_CHECK as LOG would try to grab the log mutex
+  // glog already holds.
+  RAW_CHECK(!writing.exchange(true, std::memory_order_acquire),
+            "Concurrent writes to the asynchronous logger");
+
+  write(forceFlush, timestamp, message, length);
+
+  writing.store(false, std::memory_order_release);
+}
+
+
+void AsyncLogger::Flush()
+{
+  drain();
+  logger->Flush();
+}
+
+
+google::uint32 AsyncLogger::LogSize()
+{
+  return logger->LogSize();
+}
+
+
+void AsyncLogger::write(
+    bool forceFlush,
+    time_t timestamp,
+    const char* message,
+    int length)
+{
+  const size_t size = sizeof(Header) + length;
+
+  // The messages which glog wants flushed (e.g., the ones at or
+  // above 'WARNING', including the FATAL ones which are followed by
+  // an abort) are written synchronously, as are the ones that would
+  // not even fit into an empty buffer.
+  if (forceFlush || size > capacity) {
+    drain();
+    logger->Write(forceFlush, timestamp, message, length);
+    return;
+  }
+
+  const uint64_t position = head.load(std::memory_order_relaxed);
+
+  if (capacity - (position - tail.load(std::memory_order_acquire)) < size) {
+    if (drop) {
+      ++dropped;
+      return;
+    }
+
+    drain();
+  }
+
+  const Header header = {timestamp, static_cast<size_t>(length)};
+
+  copy(position, reinterpret_cast<const char*>(&header), sizeof(header));
+  copy(position + sizeof(header), message, length);
+
+  head.store(position + size, std::memory_order_release);
+
+  // NOTE: We do not hold the mutex, so the background thread might
+  // miss this if it is about to wait, in which case it writes the
+  // message once the wait times out.
+  ready.notify_one();
+}
+
+
+void AsyncLogger::copy(uint64_t position, const char* data, size_t size)
+{
+  const size_t index = position % capacity;
+  const size_t first = std::min(size, capacity - index);
+
+  memcpy(buffer + index, data, first);
+  memcpy(buffer, data + first, size - first);
+}
+
+
+void AsyncLogger::copy(char* data, uint64_t position, size_t size) const
+{
+  const size_t index = position % capacity;
+  const size_t first = std::min(size, capacity - index);
+
+  memcpy(data, buffer + index, first);
+  memcpy(data + first, buffer, size - first);
+}
+
+
+void AsyncLogger::drain()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+
+  ready.notify_one();
+
+  drained.wait(lock, [this]() {
+    return tail.load(std::memory_order_acquire) ==
+      head.load(std::memory_order_relaxed);
+  });
+}
+
+
+void AsyncLogger::run()
+{
+  string message;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+
+      ready.wait_for(lock, std::chrono::milliseconds(100), [this]() {
+        return stopping ||
+          head.load(std::memory_order_acquire) !=
+            tail.load(std::memory_order_relaxed);
+      });
+
+      if (stopping &&
+          head.load(std::memory_order_acquire) ==
+            tail.load(std::memory_order_relaxed)) {
+        return;
+      }
+    }
+
+    uint64_t position = tail.load(std::memory_order_relaxed);
+    const uint64_t end = head.load(std::memory_order_acquire);
+
+    while (position != end) {
+      Header header;
+      copy(reinterpret_cast<char*>(&header), position, sizeof(header));
+
+      message.resize(header.length);
+      copy(&message[0], position + sizeof(header), header.length);
+
+      logger->Write(false, header.timestamp, message.data(), header.length);
+
+      position += sizeof(header) + header.length;
+      tail.store(position, std::memory_order_release);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+    }
+
+    drained.notify_all();
+  }
+}
+
+} // namespace logging {
+} // namespace internal {
+} // namespace mesos {
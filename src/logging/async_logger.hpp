@@ -0,0 +1,120 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __LOGGING_ASYNC_LOGGER_HPP__
+#define __LOGGING_ASYNC_LOGGER_HPP__
+
+#include <stdint.h>
+#include <time.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <glog/logging.h>
+
+#include <process/metrics/counter.hpp>
+
+namespace mesos {
+namespace internal {
+namespace logging {
+
+// A logger which writes the messages to the log file of a severity
+// (i.e., the logger glog installed for it) from a background thread.
+// The messages are copied into a ring buffer of the given capacity.
+// Once it is full, a message is either dropped, which increments
+// the given counter, or the writer blocks until the background
+// thread wrote out all buffered messages.
+//
+// NOTE: glog only ever calls 'Write' while holding its log mutex, so
+// that there is a single producer and a single consumer (the
+// background thread) and neither of them needs a lock to access the
+// buffer. 'Write' aborts if it is ever called concurrently.
+class AsyncLogger : public google::base::Logger
+{
+public:
+  AsyncLogger(
+      google::base::Logger* logger,
+      size_t capacity,
+      bool drop,
+      const process::metrics::Counter& dropped);
+
+  virtual ~AsyncLogger();
+
+  virtual void Write(
+      bool forceFlush,
+      time_t timestamp,
+      const char* message,
+      int length);
+
+  virtual void Flush();
+
+  virtual google::uint32 LogSize();
+
+private:
+  struct Header
+  {
+    time_t timestamp;
+    size_t length;
+  };
+
+  void write(
+      bool forceFlush,
+      time_t timestamp,
+      const char* message,
+      int length);
+
+  // Copies the data into the buffer, at the given position.
+  void copy(uint64_t position, const char* data, size_t size);
+
+  // Copies the data at the given position out of the buffer.
+  void copy(char* data, uint64_t position, size_t size) const;
+
+  // Waits until the background thread wrote all buffered messages.
+  void drain();
+
+  void run();
+
+  google::base::Logger* logger;
+
+  const size_t capacity;
+  const bool drop;
+  process::metrics::Counter dropped;
+
+  char* buffer;
+
+  // The total number of bytes written into the buffer (by 'Write'),
+  // and read out of it (by the background thread).
+  std::atomic<uint64_t> head;
+  std::atomic<uint64_t> tail;
+
+  // Set while a 'Write' is in progress, see above.
+  std::atomic<bool> writing;
+
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::condition_variable drained;
+  bool stopping;
+
+  std::thread thread;
+};
+
+} // namespace logging {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __LOGGING_ASYNC_LOGGER_HPP__
@@ -44,6 +44,22 @@ mesos::internal::logging::Flags::Flags()
       "How many seconds to buffer log messages for",
       0);
 
+  add(&Flags::async_logging_buffer_size,
+      "async_logging_buffer_size",
+      "Size of the buffer for the log messages which are written to the\n"
+      "log files by a background thread, rather than by the threads that\n"
+      "log them (no default, the log files are written synchronously\n"
+      "unless specified). Messages at or above 'WARNING' are still\n"
+      "written synchronously, after the buffered ones.");
+
+  add(&Flags::async_logging_overflow,
+      "async_logging_overflow",
+      "What to do with a log message when the buffer of the asynchronous\n"
+      "logging (see 'async_logging_buffer_size') is full; possible values:\n"
+      "'block' until the buffered messages are written, or 'drop' the\n"
+      "message, which is counted by the 'logging/dropped_lines' metric",
+      "block");
+
   add(&Flags::initialize_driver_logging,
       "initialize_driver_logging",
       "Whether to automatically initialize Google logging of scheduler\n"
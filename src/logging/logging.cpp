@@ -15,6 +15,7 @@
 // limitations under the License.
 
 #include <signal.h> // For sigaction(), sigemptyset().
+#include <stdlib.h> // For atexit().
 #include <string.h> // For strsignal().
 
 #include <glog/logging.h>
@@ -24,6 +25,9 @@
 
 #include <process/once.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/metrics.hpp>
+
 #include <stout/error.hpp>
 #include <stout/exit.hpp>
 #include <stout/os.hpp>
@@ -33,10 +37,13 @@
 
 #include <stout/os/signals.hpp>
 
+#include "logging/async_logger.hpp"
 #include "logging/logging.hpp"
 
 using process::Once;
 
+using process::metrics::Counter;
+
 using std::string;
 
 // Captures the stack trace and exits when a pure virtual method is
@@ -91,6 +98,13 @@ inline void handler(int signal, siginfo_t *siginfo, void *context)
 }
 
 
+// Writes out the buffered log messages when exiting.
+static void flush()
+{
+  google::FlushLogFiles(google::INFO);
+}
+
+
 google::LogSeverity getLogSeverity(const string& logging_level)
 {
   if (logging_level == "INFO") {
@@ -127,6 +141,13 @@ void initialize(
                " 'INFO', 'WARNING', 'ERROR'.";
   }
 
+  if (flags.async_logging_overflow != "block" &&
+      flags.async_logging_overflow != "drop") {
+    EXIT(1) << "'" << flags.async_logging_overflow << "' is not a valid"
+               " value for the 'async_logging_overflow' flag. Possible"
+               " values are: 'block', 'drop'.";
+  }
+
   FLAGS_minloglevel = getLogSeverity(flags.logging_level);
 
   if (flags.log_dir.isSome()) {
@@ -169,6 +190,26 @@ void initialize(
       << " level logging started!";
   }
 
+  // Only the log files are written asynchronously, the messages
+  // logged to stderr are still written by the threads that log them.
+  if (flags.log_dir.isSome() && flags.async_logging_buffer_size.isSome()) {
+    Counter dropped("logging/dropped_lines");
+    process::metrics::add(dropped);
+
+    for (int severity = 0; severity < google::NUM_SEVERITIES; severity++) {
+      // NOTE: glog owns the loggers.
+      google::base::SetLogger(
+          severity,
+          new AsyncLogger(
+              google::base::GetLogger(severity),
+              flags.async_logging_buffer_size->bytes(),
+              flags.async_logging_overflow == "drop",
+              dropped));
+    }
+
+    atexit(&flush);
+  }
+
   VLOG(1) << "Logging to " <<
     (flags.log_dir.isSome() ? flags.log_dir.get() : "STDERR");
 
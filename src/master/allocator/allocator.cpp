@@ -27,6 +27,9 @@
 using std::string;
 
 using mesos::internal::master::allocator::HierarchicalDRFAllocator;
+using mesos::internal::master::allocator::HierarchicalDRFMostAvailableAllocator;
+using mesos::internal::master::allocator::HierarchicalDRFOptimisticAllocator;
+using mesos::internal::master::allocator::HierarchicalDRFPackAllocator;
 
 namespace mesos {
 namespace master {
@@ -40,6 +43,12 @@ Try<Allocator*> Allocator::create(const string& name)
   // ModuleManager and built-in allocator factory do that already.
   if (name == mesos::internal::master::DEFAULT_ALLOCATOR) {
     return HierarchicalDRFAllocator::create();
+  } else if (name == "HierarchicalDRFPack") {
+    return HierarchicalDRFPackAllocator::create();
+  } else if (name == "HierarchicalDRFMostAvailable") {
+    return HierarchicalDRFMostAvailableAllocator::create();
+  } else if (name == mesos::internal::master::OPTIMISTIC_ALLOCATOR) {
+    return HierarchicalDRFOptimisticAllocator::create();
   }
 
   return modules::ModuleManager::create<Allocator>(name);
@@ -17,12 +17,15 @@
 #ifndef __MASTER_ALLOCATOR_MESOS_ALLOCATOR_HPP__
 #define __MASTER_ALLOCATOR_MESOS_ALLOCATOR_HPP__
 
+#include <vector>
+
 #include <mesos/master/allocator.hpp>
 
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/process.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/try.hpp>
 
@@ -89,6 +92,9 @@ public:
   void removeSlave(
       const SlaveID& slaveId);
 
+  void bulkRemoveSlaves(
+      const std::vector<SlaveID>& slaveIds);
+
   void updateSlave(
       const SlaveID& slave,
       const Resources& oversubscribed);
@@ -136,6 +142,14 @@ public:
       const Resources& resources,
       const Option<Filters>& filters);
 
+  void bulkRecoverResources(
+      const std::vector<mesos::master::allocator::Recovery>& recoveries);
+
+  void acceptResources(
+      const FrameworkID& frameworkId,
+      const SlaveID& slaveId,
+      const Resources& resources);
+
   void suppressOffers(
       const FrameworkID& frameworkId);
 
@@ -213,6 +227,13 @@ public:
   virtual void removeSlave(
       const SlaveID& slaveId) = 0;
 
+  virtual void bulkRemoveSlaves(const std::vector<SlaveID>& slaveIds)
+  {
+    foreach (const SlaveID& slaveId, slaveIds) {
+      removeSlave(slaveId);
+    }
+  }
+
   virtual void updateSlave(
       const SlaveID& slave,
       const Resources& oversubscribed) = 0;
@@ -260,6 +281,27 @@ public:
       const Resources& resources,
       const Option<Filters>& filters) = 0;
 
+  // Recovers the resources in order within a single event, rather
+  // than dispatching an event for each of them.
+  virtual void bulkRecoverResources(
+      const std::vector<mesos::master::allocator::Recovery>& recoveries)
+  {
+    foreach (const mesos::master::allocator::Recovery& recovery, recoveries) {
+      recoverResources(
+          recovery.frameworkId,
+          recovery.slaveId,
+          recovery.resources,
+          recovery.filters);
+    }
+  }
+
+  // Only the allocators that offer the same resources to several
+  // frameworks at once need to know which framework accepted them.
+  virtual void acceptResources(
+      const FrameworkID& frameworkId,
+      const SlaveID& slaveId,
+      const Resources& resources) {}
+
   virtual void suppressOffers(
       const FrameworkID& frameworkId) = 0;
 
@@ -427,6 +469,17 @@ inline void MesosAllocator<AllocatorProcess>::removeSlave(
 }
 
 
+template <typename AllocatorProcess>
+inline void MesosAllocator<AllocatorProcess>::bulkRemoveSlaves(
+    const std::vector<SlaveID>& slaveIds)
+{
+  process::dispatch(
+      process,
+      &MesosAllocatorProcess::bulkRemoveSlaves,
+      slaveIds);
+}
+
+
 template <typename AllocatorProcess>
 inline void MesosAllocator<AllocatorProcess>::updateSlave(
     const SlaveID& slaveId,
@@ -575,6 +628,32 @@ inline void MesosAllocator<AllocatorProcess>::recoverResources(
 }
 
 
+template <typename AllocatorProcess>
+inline void MesosAllocator<AllocatorProcess>::bulkRecoverResources(
+    const std::vector<mesos::master::allocator::Recovery>& recoveries)
+{
+  process::dispatch(
+      process,
+      &MesosAllocatorProcess::bulkRecoverResources,
+      recoveries);
+}
+
+
+template <typename AllocatorProcess>
+inline void MesosAllocator<AllocatorProcess>::acceptResources(
+    const FrameworkID& frameworkId,
+    const SlaveID& slaveId,
+    const Resources& resources)
+{
+  process::dispatch(
+      process,
+      &MesosAllocatorProcess::acceptResources,
+      frameworkId,
+      slaveId,
+      resources);
+}
+
+
 template <typename AllocatorProcess>
 inline void MesosAllocator<AllocatorProcess>::suppressOffers(
     const FrameworkID& frameworkId)
@@ -17,21 +17,30 @@
 #include "master/allocator/mesos/hierarchical.hpp"
 
 #include <algorithm>
+#include <memory>
 #include <vector>
 
 #include <mesos/resources.hpp>
 #include <mesos/type_utils.hpp>
 
+#include <process/clock.hpp>
 #include <process/event.hpp>
 #include <process/delay.hpp>
+#include <process/dispatch.hpp>
+#include <process/help.hpp>
 #include <process/id.hpp>
 #include <process/timeout.hpp>
 
 #include <stout/check.hpp>
 #include <stout/hashset.hpp>
+#include <stout/json.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
 
+#include "common/http.hpp"
+
+using std::pair;
+using std::shared_ptr;
 using std::string;
 using std::vector;
 
@@ -40,10 +49,18 @@ using mesos::master::RoleInfo;
 
 using mesos::quota::QuotaInfo;
 
+using process::Clock;
+using process::DESCRIPTION;
 using process::Failure;
 using process::Future;
+using process::HELP;
+using process::TLDR;
+using process::Time;
 using process::Timeout;
 
+using process::http::OK;
+using process::http::Response;
+
 namespace mesos {
 namespace internal {
 namespace master {
@@ -57,6 +74,13 @@ public:
   virtual ~OfferFilter() {}
 
   virtual bool filter(const Resources& resources) = 0;
+
+  // Returns true if a filter refusing 'resources' until 'timeout'
+  // filters everything this filter does, i.e., this filter is
+  // redundant once such a filter is installed.
+  virtual bool subsumedBy(
+      const Resources& resources,
+      const Timeout& timeout) = 0;
 };
 
 
@@ -79,6 +103,13 @@ public:
            timeout.remaining() > Seconds(0);
   }
 
+  virtual bool subsumedBy(
+      const Resources& _resources,
+      const Timeout& _timeout)
+  {
+    return timeout <= _timeout && _resources.contains(resources);
+  }
+
   const Resources resources;
   const Timeout timeout;
 };
@@ -119,6 +150,41 @@ public:
 };
 
 
+void StateProcess::initialize()
+{
+  route("/state", STATE_HELP(), &StateProcess::state);
+}
+
+
+const string StateProcess::STATE_HELP()
+{
+  return HELP(
+      TLDR(
+          "Provides a snapshot of the allocator's state."),
+      DESCRIPTION(
+          "The snapshot is taken at the end of the latest allocation run.",
+          "It includes the shares of the roles and frameworks, the quota",
+          "of the roles, the number of offer filters of the frameworks,",
+          "and the total and allocated resources of the slaves."));
+}
+
+
+void StateProcess::update(const shared_ptr<const JSON::Object>& _snapshot)
+{
+  snapshot = _snapshot;
+}
+
+
+Future<Response> StateProcess::state(const process::http::Request& request)
+{
+  if (snapshot == NULL) {
+    return OK(JSON::Object(), request.url.query.get("jsonp"));
+  }
+
+  return OK(*snapshot, request.url.query.get("jsonp"));
+}
+
+
 void HierarchicalAllocatorProcess::initialize(
     const Duration& _allocationInterval,
     const lambda::function<
@@ -160,6 +226,18 @@ void HierarchicalAllocatorProcess::initialize(
     LOG(ERROR) << "No roles specified, cannot allocate resources!";
   }
 
+  // NOTE: Only one allocator per libprocess instance can serve
+  // '/allocator/state', e.g., tests can run several allocators.
+  stateProcess = new StateProcess();
+
+  if (!process::spawn(stateProcess)) {
+    LOG(WARNING) << "Not serving the allocator state, since another "
+                 << "allocator is already serving it";
+
+    delete stateProcess;
+    stateProcess = NULL;
+  }
+
   VLOG(1) << "Initialized hierarchical allocator process";
 
   delay(allocationInterval, self(), &Self::batch);
@@ -264,6 +342,10 @@ void HierarchicalAllocatorProcess::addFramework(
 
   frameworks[frameworkId].suppressed = false;
 
+  updateOfferConstraints(frameworkId, frameworkInfo);
+
+  metrics.addFramework(frameworkId);
+
   LOG(INFO) << "Added framework " << frameworkId;
 
   allocate();
@@ -305,6 +387,10 @@ void HierarchicalAllocatorProcess::removeFramework(
   // HierarchicalAllocatorProcess::expire.
   frameworks.erase(frameworkId);
 
+  metrics.removeFramework(frameworkId);
+
+  dirty = true;
+
   LOG(INFO) << "Removed framework " << frameworkId;
 }
 
@@ -348,6 +434,8 @@ void HierarchicalAllocatorProcess::deactivateFramework(
   frameworks[frameworkId].offerFilters.clear();
   frameworks[frameworkId].inverseOfferFilters.clear();
 
+  dirty = true;
+
   LOG(INFO) << "Deactivated framework " << frameworkId;
 }
 
@@ -374,6 +462,27 @@ void HierarchicalAllocatorProcess::updateFramework(
       frameworks[frameworkId].revocable = true;
     }
   }
+
+  updateOfferConstraints(frameworkId, frameworkInfo);
+
+  dirty = true;
+}
+
+
+void HierarchicalAllocatorProcess::updateOfferConstraints(
+    const FrameworkID& frameworkId,
+    const FrameworkInfo& frameworkInfo)
+{
+  Framework& framework = frameworks.at(frameworkId);
+
+  framework.offerConstraints = None();
+  framework.minResources = Resources();
+
+  if (frameworkInfo.has_offer_constraints()) {
+    framework.offerConstraints = frameworkInfo.offer_constraints();
+    framework.minResources =
+      Resources(frameworkInfo.offer_constraints().min_resources()).flatten();
+  }
 }
 
 
@@ -419,6 +528,8 @@ void HierarchicalAllocatorProcess::addSlave(
   slaves[slaveId].activated = true;
   slaves[slaveId].checkpoint = slaveInfo.checkpoint();
   slaves[slaveId].hostname = slaveInfo.hostname();
+  slaves[slaveId].attributes = slaveInfo.attributes();
+  slaves[slaveId].idle = Clock::now();
 
   // NOTE: We currently implement maintenance in the allocator to be able to
   // leverage state and features such as the FrameworkSorter and OfferFilter.
@@ -518,6 +629,8 @@ void HierarchicalAllocatorProcess::activateSlave(
 
   slaves[slaveId].activated = true;
 
+  dirty = true;
+
   LOG(INFO)<< "Slave " << slaveId << " reactivated";
 }
 
@@ -541,6 +654,8 @@ void HierarchicalAllocatorProcess::updateWhitelist(
 
   whitelist = _whitelist;
 
+  dirty = true;
+
   if (whitelist.isSome()) {
     LOG(INFO) << "Updated slave whitelist: " << stringify(whitelist.get());
 
@@ -622,6 +737,8 @@ void HierarchicalAllocatorProcess::updateAllocation(
 
   slaves[slaveId].total = updatedTotal.get();
 
+  dirty = true;
+
   LOG(INFO) << "Updated allocation of framework " << frameworkId
             << " on slave " << slaveId
             << " from " << frameworkAllocation
@@ -666,6 +783,8 @@ Future<Nothing> HierarchicalAllocatorProcess::updateAvailable(
   quotaRoleSorter->update(
       slaveId, slaves[slaveId].total.unreserved().nonRevocable());
 
+  dirty = true;
+
   return Nothing();
 }
 
@@ -728,6 +847,8 @@ void HierarchicalAllocatorProcess::updateInverseOffer(
     // out the next time we schedule inverse offers.
     maintenance.offersOutstanding.erase(frameworkId);
 
+    dirty = true;
+
     // If the response is `Some`, this means the framework responded. Otherwise
     // if it is `None` the inverse offer timed out or was rescinded.
     if (status.isSome()) {
@@ -854,11 +975,57 @@ void HierarchicalAllocatorProcess::recoverResources(
   // which it might not in the event that we dispatched Master::offer
   // before we received Allocator::removeSlave).
   if (slaves.contains(slaveId)) {
+    Slave& slave = slaves[slaveId];
+
+    // The resources of the optimistic copies of the framework, if
+    // any, are not in the allocated resources.
+    Resources recovered = resources;
+
+    if (slave.optimistic.contains(frameworkId)) {
+      Resources& copy = slave.optimistic[frameworkId];
+      const Resources copied = copy - (copy - recovered);
+
+      copy -= copied;
+      recovered -= copied;
+
+      if (copy.empty()) {
+        slave.optimistic.erase(frameworkId);
+      }
+    }
+
     // NOTE: We cannot add the following CHECK due to the double
     // precision errors. See MESOS-1187 for details.
     // CHECK(slaves[slaveId].allocated.contains(resources));
 
-    slaves[slaveId].allocated -= resources;
+    slave.allocated -= recovered;
+
+    // The frameworks holding an optimistic copy of the recovered
+    // resources may still accept them, so the resources now count as
+    // allocated to one of them. Whichever framework accepts them
+    // first claims them (see 'acceptResources()'), and the master
+    // rescinds the offers of the others.
+    foreach (const FrameworkID& frameworkId_, slave.optimistic.keys()) {
+      if (recovered.empty()) {
+        break;
+      }
+
+      Resources& copy = slave.optimistic[frameworkId_];
+      const Resources copied = copy - (copy - recovered);
+
+      copy -= copied;
+      recovered -= copied;
+      slave.allocated += copied;
+
+      if (copy.empty()) {
+        slave.optimistic.erase(frameworkId_);
+      }
+    }
+
+    if (slave.idle.isNone()) {
+      slave.idle = Clock::now();
+    }
+
+    dirty = true;
 
     LOG(INFO) << "Recovered " << resources
               << " (total: " << slaves[slaveId].total
@@ -901,12 +1068,29 @@ void HierarchicalAllocatorProcess::recoverResources(
             << " filtered slave " << slaveId
             << " for " << seconds.get();
 
+    const Timeout timeout = Timeout::in(seconds.get());
+
+    hashset<OfferFilter*>& offerFilters =
+      frameworks[frameworkId].offerFilters[slaveId];
+
+    // Remove the filters that the new filter subsumes, e.g., the
+    // filters of the previous offers a framework declined with the
+    // same 'refuse_seconds'. Otherwise such frameworks would build up
+    // filters that 'isFiltered' has to check for each allocation.
+    // The removed filters are deleted when they expire, see
+    // HierarchicalAllocatorProcess::expire.
+    for (auto it = offerFilters.begin(); it != offerFilters.end();) {
+      if ((*it)->subsumedBy(resources, timeout)) {
+        it = offerFilters.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
     // Create a new filter and delay its expiration.
-    OfferFilter* offerFilter = new RefusedOfferFilter(
-        resources,
-        Timeout::in(seconds.get()));
+    OfferFilter* offerFilter = new RefusedOfferFilter(resources, timeout);
 
-    frameworks[frameworkId].offerFilters[slaveId].insert(offerFilter);
+    offerFilters.insert(offerFilter);
 
     // We need to disambiguate the function call to pick the correct
     // expire() overload.
@@ -926,6 +1110,43 @@ void HierarchicalAllocatorProcess::recoverResources(
 }
 
 
+void HierarchicalAllocatorProcess::acceptResources(
+    const FrameworkID& frameworkId,
+    const SlaveID& slaveId,
+    const Resources& resources)
+{
+  CHECK(initialized);
+
+  if (!slaves.contains(slaveId)) {
+    return;
+  }
+
+  Slave& slave = slaves[slaveId];
+
+  if (!slave.optimistic.contains(frameworkId)) {
+    return;
+  }
+
+  // The accepted resources of the optimistic copy of the framework
+  // are now allocated to it. The master recovers the offers of the
+  // other frameworks that hold these resources, which only takes
+  // them out of 'allocated' if they were allocated to one of them.
+  // NOTE: The framework sorters already account for the copy.
+  Resources& copy = slave.optimistic[frameworkId];
+  const Resources accepted = copy - (copy - resources);
+
+  copy -= accepted;
+  slave.allocated += accepted;
+
+  if (copy.empty()) {
+    slave.optimistic.erase(frameworkId);
+  }
+
+  VLOG(1) << "Framework " << frameworkId << " accepted its optimistic copy "
+          << "of " << accepted << " on slave " << slaveId;
+}
+
+
 void HierarchicalAllocatorProcess::suppressOffers(
     const FrameworkID& frameworkId)
 {
@@ -1037,12 +1258,24 @@ void HierarchicalAllocatorProcess::resume()
   VLOG(1) << "Allocation resumed";
 
   paused = false;
+
+  // Allocations requested while paused were skipped.
+  dirty = true;
 }
 
 
 void HierarchicalAllocatorProcess::batch()
 {
-  allocate();
+  // Skip the allocation if nothing changed since the last allocation
+  // of all slaves, since it would not offer anything new.
+  if (dirty) {
+    allocate();
+  } else {
+    VLOG(2) << "Skipped allocation because nothing changed";
+
+    ++metrics.allocation_runs_skipped;
+  }
+
   delay(allocationInterval, self(), &Self::batch);
 }
 
@@ -1052,16 +1285,17 @@ void HierarchicalAllocatorProcess::allocate()
   if (paused) {
     VLOG(1) << "Skipped allocation because the allocator is paused";
 
+    dirty = true;
     return;
   }
 
-  Stopwatch stopwatch;
-  stopwatch.start();
-
-  allocate(slaves.keys());
+  foreachkey (const SlaveID& slaveId, slaves) {
+    allocationCandidates.insert(slaveId);
+  }
 
-  VLOG(1) << "Performed allocation for " << slaves.size() << " slaves in "
-            << stopwatch.elapsed();
+  if (allocation.isNone() || !allocation->isPending()) {
+    allocation = dispatch(self(), &Self::_allocate);
+  }
 }
 
 
@@ -1071,19 +1305,58 @@ void HierarchicalAllocatorProcess::allocate(
   if (paused) {
     VLOG(1) << "Skipped allocation because the allocator is paused";
 
+    dirty = true;
     return;
   }
 
-  Stopwatch stopwatch;
-  stopwatch.start();
+  allocationCandidates.insert(slaveId);
+
+  if (allocation.isNone() || !allocation->isPending()) {
+    allocation = dispatch(self(), &Self::_allocate);
+  }
+}
+
+
+Nothing HierarchicalAllocatorProcess::_allocate()
+{
+  if (paused) {
+    VLOG(1) << "Skipped allocation because the allocator is paused";
+
+    return Nothing();
+  }
+
+  metrics.allocation_run.start();
+
+  // Slaves might have been removed since they were added as
+  // candidates.
+  hashset<SlaveID> slaveIds;
+  foreach (const SlaveID& slaveId, allocationCandidates) {
+    if (slaves.contains(slaveId)) {
+      slaveIds.insert(slaveId);
+    }
+  }
+
+  allocationCandidates.clear();
+
+  // Once all the slaves are allocated, the periodic allocation has
+  // nothing to do until something changes.
+  if (slaveIds.size() == slaves.size()) {
+    dirty = false;
+  }
+
+  allocate(slaveIds);
+
+  ++metrics.allocation_runs;
+  metrics.allocation_run_slaves = slaveIds.size();
+
+  const Duration elapsed = metrics.allocation_run.stop();
+
+  VLOG(1) << "Performed allocation for " << slaveIds.size() << " slaves in "
+          << elapsed;
 
-  // TODO(bmahler): Add initializer list constructor for hashset.
-  hashset<SlaveID> slaves;
-  slaves.insert(slaveId);
-  allocate(slaves);
+  publish();
 
-  VLOG(1) << "Performed allocation for slave " << slaveId << " in "
-          << stopwatch.elapsed();
+  return Nothing();
 }
 
 
@@ -1103,6 +1376,12 @@ void HierarchicalAllocatorProcess::allocate(
   //       to a framework of any role.
   hashmap<FrameworkID, hashmap<SlaveID, Resources>> offerable;
 
+  // The frameworks in the order in which they first got resources,
+  // which follows the DRF order. We make the offers in this order, so
+  // that among optimistic offers the master can tell which frameworks
+  // come first (see 'Master::rescindConflictingOffers()').
+  vector<FrameworkID> offerOrder;
+
   // NOTE: This function can operate on a small subset of slaves, we have to
   // make sure that we don't assume cluster knowledge when summing resources
   // from that set.
@@ -1118,24 +1397,58 @@ void HierarchicalAllocatorProcess::allocate(
     }
   }
 
-  // Randomize the order in which slaves' resources are allocated.
-  // TODO(vinod): Implement a smarter sorting algorithm.
+  // Randomize the order in which slaves' resources are allocated. The
+  // slaves with the same available resources stay in random order
+  // when ordering them by their available resources below.
   std::random_shuffle(slaveIds.begin(), slaveIds.end());
 
+  if (slaveOrder != SlaveOrder::RANDOM) {
+    // Compute the available resources of each slave once rather than
+    // for each comparison. We order by cpus first and memory second.
+    hashmap<SlaveID, pair<double, Bytes>> available;
+    foreach (const SlaveID& slaveId, slaveIds) {
+      const Slave& slave = slaves.at(slaveId);
+      const Resources resources =
+        (slave.total - slave.allocated).nonRevocable();
+
+      available[slaveId] = std::make_pair(
+          resources.cpus().getOrElse(0.0),
+          resources.mem().getOrElse(Bytes(0)));
+    }
+
+    const bool ascending = slaveOrder == SlaveOrder::LEAST_AVAILABLE_FIRST;
+
+    std::stable_sort(
+        slaveIds.begin(),
+        slaveIds.end(),
+        [&available, ascending](const SlaveID& left, const SlaveID& right) {
+          return ascending
+            ? available.at(left) < available.at(right)
+            : available.at(right) < available.at(left);
+        });
+  }
+
+  // NOTE: Below we look up each slave, role and framework once per
+  // iteration rather than for each use, since hashing their ids and
+  // names makes up a large part of an allocation in a large cluster.
+  // The references stay valid since allocating doesn't add any.
+
   // Quota comes first and fair share second. Here we process only those
   // roles, for which quota is set (quota'ed roles). Such roles form a
   // special allocation group with a dedicated sorter.
   foreach (const SlaveID& slaveId, slaveIds) {
+    Slave& slave = slaves.at(slaveId);
+
     foreach (const string& role, quotaRoleSorter->sort()) {
       CHECK_SOME(roles[role].quota);
 
-      // Summing up resources is fine because quota is only for scalar
-      // resources.
+      // Only looking at the scalar resources is fine because quota is
+      // only for scalar resources.
       // NOTE: Reserved and revocable resources are excluded in
       // `quotaRoleSorter`.
       // TODO(alexr): Consider including dynamically reserved resources.
-      Resources roleConsumedResources =
-        Resources::sum(quotaRoleSorter->allocation(role));
+      const Resources& roleConsumedResources =
+        quotaRoleSorter->allocationScalars(role);
 
       // If quota for the role is satisfied, we do not need to do any further
       // allocations, at least at this stage.
@@ -1148,21 +1461,23 @@ void HierarchicalAllocatorProcess::allocate(
         break;
       }
 
+      Sorter* frameworkSorter = frameworkSorters[role];
+
       // Fetch frameworks according to their fair share.
-      foreach (const string& frameworkId_, frameworkSorters[role]->sort()) {
+      foreach (const string& frameworkId_, frameworkSorter->sort()) {
         FrameworkID frameworkId;
         frameworkId.set_value(frameworkId_);
 
         // If the framework has suppressed offers, ignore. The Unallocated
         // part of the quota will not be allocated to other roles.
-        if (frameworks[frameworkId].suppressed) {
+        if (frameworks.at(frameworkId).suppressed) {
           continue;
         }
 
         // Quota is satisfied from the available unreserved non-revocable
         // resources on the agent.
         // TODO(alexr): Consider adding dynamically reserved resources.
-        Resources available = slaves[slaveId].total - slaves[slaveId].allocated;
+        Resources available = slave.total - slave.allocated;
         Resources resources = available.unreserved().nonRevocable();
 
         // NOTE: The resources may not be allocatable here, but they can be
@@ -1184,14 +1499,18 @@ void HierarchicalAllocatorProcess::allocate(
         // NOTE: We perform "coarse-grained" allocation for quota'ed
         // resources, which may lead to overcommitment of resources beyond
         // quota. This is fine since quota currently represents a guarantee.
+        if (!offerable.contains(frameworkId)) {
+          offerOrder.push_back(frameworkId);
+        }
+
         offerable[frameworkId][slaveId] += resources;
-        slaves[slaveId].allocated += resources;
+        slave.allocated += resources;
 
         // Resources allocated as part of the quota count towards the
         // role's and the framework's fair share.
         // NOTE: Reserved and revocable resources have already been excluded.
-        frameworkSorters[role]->add(slaveId, resources);
-        frameworkSorters[role]->allocated(frameworkId_, slaveId, resources);
+        frameworkSorter->add(slaveId, resources);
+        frameworkSorter->allocated(frameworkId_, slaveId, resources);
         roleSorter->allocated(role, slaveId, resources);
         quotaRoleSorter->allocated(role, slaveId, resources);
       }
@@ -1203,8 +1522,8 @@ void HierarchicalAllocatorProcess::allocate(
   // ensure we do not over-allocate resources during the WDRF phase.
   Resources remainingClusterResources;
   foreach (const SlaveID& slaveId, slaveIds) {
-    remainingClusterResources +=
-      slaves[slaveId].total - slaves[slaveId].allocated;
+    const Slave& slave = slaves.at(slaveId);
+    remainingClusterResources += slave.total - slave.allocated;
   }
 
   // Frameworks in a quota'ed role may temporarily reject resources by
@@ -1217,7 +1536,7 @@ void HierarchicalAllocatorProcess::allocate(
 
     // Compute the amount of quota that the role does not have allocated.
     // NOTE: Reserved and revocable resources are excluded in `quotaRoleSorter`.
-    Resources allocated = Resources::sum(quotaRoleSorter->allocation(name));
+    const Resources& allocated = quotaRoleSorter->allocationScalars(name);
     const Resources required = role.quota.get().guarantee();
     unallocatedQuotaResources += (required - allocated);
   }
@@ -1245,19 +1564,30 @@ void HierarchicalAllocatorProcess::allocate(
       break;
     }
 
+    Slave& slave = slaves.at(slaveId);
+
+    // The resources allocated on the slave in this stage, and the
+    // number of frameworks that got an optimistic copy of them.
+    Resources allocated;
+    size_t copies = 0;
+
     foreach (const string& role, roleSorter->sort()) {
-      foreach (const string& frameworkId_,
-               frameworkSorters[role]->sort()) {
+      Sorter* frameworkSorter = frameworkSorters[role];
+      const bool quota = roles[role].quota.isSome();
+
+      foreach (const string& frameworkId_, frameworkSorter->sort()) {
         FrameworkID frameworkId;
         frameworkId.set_value(frameworkId_);
 
+        const Framework& framework = frameworks.at(frameworkId);
+
         // If the framework has suppressed offers, ignore.
-        if (frameworks[frameworkId].suppressed) {
+        if (framework.suppressed) {
           continue;
         }
 
         // Calculate the currently available resources on the slave.
-        Resources available = slaves[slaveId].total - slaves[slaveId].allocated;
+        Resources available = slave.total - slave.allocated;
 
         // NOTE: Currently, frameworks are allowed to have '*' role.
         // Calling reserved('*') returns an empty Resources object.
@@ -1265,49 +1595,81 @@ void HierarchicalAllocatorProcess::allocate(
 
         // Remove revocable resources if the framework has not opted
         // for them.
-        if (!frameworks[frameworkId].revocable) {
+        if (!framework.revocable) {
           resources = resources.nonRevocable();
         }
 
+        // If the offer generated by `resources` would force this WDRF stage
+        // to use more than `remainingClusterResources`, move along. We do
+        // not terminate early, as offers generated further in the loop may
+        // be small enough to fit within `remainingClusterResources`.
+        if (!remainingClusterResources.contains(allocatedForWDRF + resources)) {
+          resources = Resources();
+        }
+
+        // In the optimistic mode, the framework also gets a copy of the
+        // resources allocated on the slave to the frameworks before it.
+        // The copies do not count towards the WDRF stage since they are
+        // allocated already.
+        Resources copy;
+        if (copies < optimisticOffers) {
+          copy = allocated.unreserved() + allocated.reserved(role);
+
+          if (!framework.revocable) {
+            copy = copy.nonRevocable();
+          }
+        }
+
+        const Resources offered = resources + copy;
+
         // If the resources are not allocatable, ignore.
-        if (!allocatable(resources)) {
+        if (!allocatable(offered)) {
           continue;
         }
 
         // If the framework filters these resources, ignore.
-        if (isFiltered(frameworkId, slaveId, resources)) {
+        if (isFiltered(frameworkId, slaveId, offered)) {
           continue;
         }
 
-        // If the offer generated by `resources` would force this WDRF stage
-        // to use more than `remainingClusterResources`, move along. We do
-        // not terminate early, as offers generated further in the loop may
-        // be small enough to fit within `remainingClusterResources`.
-        if (!remainingClusterResources.contains(allocatedForWDRF + resources)) {
-          continue;
+        if (!resources.empty()) {
+          VLOG(2) << "Allocating " << resources << " on slave " << slaveId
+                  << " to framework " << frameworkId;
         }
 
-        VLOG(2) << "Allocating " << resources << " on slave " << slaveId
-                << " to framework " << frameworkId;
+        if (!copy.empty()) {
+          VLOG(2) << "Offering an optimistic copy of " << copy
+                  << " on slave " << slaveId << " to framework "
+                  << frameworkId;
+
+          slave.optimistic[frameworkId] += copy;
+          ++copies;
+        }
+
+        if (!offerable.contains(frameworkId)) {
+          offerOrder.push_back(frameworkId);
+        }
 
         // NOTE: We perform "coarse-grained" allocation, meaning that we always
         // allocate the entire remaining slave resources to a single framework.
         // NOTE: We may have already allocated some resources on the current
         // agent as part of quota.
-        offerable[frameworkId][slaveId] += resources;
+        offerable[frameworkId][slaveId] += offered;
         allocatedForWDRF += resources;
-        slaves[slaveId].allocated += resources;
+        allocated += resources;
+        slave.allocated += resources;
 
         // Reserved resources are only accounted for in the framework
         // sorter, since the reserved resources are not shared across
-        // roles.
-        frameworkSorters[role]->add(slaveId, resources);
-        frameworkSorters[role]->allocated(frameworkId_, slaveId, resources);
-        roleSorter->allocated(role, slaveId, resources.unreserved());
+        // roles. The optimistic copies count towards the shares of the
+        // frameworks holding them, just like any offered resources.
+        frameworkSorter->add(slaveId, offered);
+        frameworkSorter->allocated(frameworkId_, slaveId, offered);
+        roleSorter->allocated(role, slaveId, offered.unreserved());
 
-        if (roles[role].quota.isSome()) {
+        if (quota) {
           quotaRoleSorter->allocated(
-              role, slaveId, resources.unreserved().nonRevocable());
+              role, slaveId, offered.unreserved().nonRevocable());
         }
       }
     }
@@ -1316,10 +1678,35 @@ void HierarchicalAllocatorProcess::allocate(
   if (offerable.empty()) {
     VLOG(1) << "No resources available to allocate!";
   } else {
+    const Time now = Clock::now();
+
     // Now offer the resources to each framework.
-    foreachkey (const FrameworkID& frameworkId, offerable) {
+    foreach (const FrameworkID& frameworkId, offerOrder) {
+      if (metrics.time_to_offer.contains(frameworkId)) {
+        foreachkey (const SlaveID& slaveId, offerable[frameworkId]) {
+          if (slaves.contains(slaveId) && slaves[slaveId].idle.isSome()) {
+            metrics.time_to_offer.at(frameworkId).record(
+                now - slaves[slaveId].idle.get());
+          }
+        }
+      }
+
       offerCallback(frameworkId, offerable[frameworkId]);
     }
+
+    // The slaves whose available resources were all offered are no
+    // longer idle.
+    foreach (const FrameworkID& frameworkId, offerOrder) {
+      foreachkey (const SlaveID& slaveId, offerable[frameworkId]) {
+        if (slaves.contains(slaveId)) {
+          Slave& slave = slaves[slaveId];
+
+          if ((slave.total - slave.allocated).empty()) {
+            slave.idle = None();
+          }
+        }
+      }
+    }
   }
 
   // NOTE: For now, we implement maintenance inverse offers within the
@@ -1434,6 +1821,9 @@ void HierarchicalAllocatorProcess::expire(
     if (frameworks[frameworkId].offerFilters[slaveId].empty()) {
       frameworks[frameworkId].offerFilters.erase(slaveId);
     }
+
+    // The filtered resources can be offered again.
+    allocate(slaveId);
   }
 
   delete offerFilter;
@@ -1460,12 +1850,120 @@ void HierarchicalAllocatorProcess::expire(
     if(frameworks[frameworkId].inverseOfferFilters[slaveId].empty()) {
       frameworks[frameworkId].inverseOfferFilters.erase(slaveId);
     }
+
+    // The inverse offer can be sent again.
+    allocate(slaveId);
   }
 
   delete inverseOfferFilter;
 }
 
 
+void HierarchicalAllocatorProcess::publish()
+{
+  if (stateProcess == NULL) {
+    return;
+  }
+
+  JSON::Object object;
+  object.values["timestamp"] = Clock::now().secs();
+
+  {
+    JSON::Array array;
+    array.values.reserve(roles.size());
+
+    foreachpair (const string& name, const Role& role, roles) {
+      JSON::Object entry;
+      entry.values["name"] = name;
+      entry.values["weight"] = role.info.weight();
+
+      if (roleSorter->contains(name)) {
+        entry.values["share"] = roleSorter->share(name);
+      }
+
+      if (role.quota.isSome() && quotaRoleSorter->contains(name)) {
+        // The headroom is the part of the guarantee that is not
+        // allocated yet, which the allocator keeps from other roles.
+        const Resources guarantee = role.quota.get().guarantee();
+        const Resources& allocated = quotaRoleSorter->allocationScalars(name);
+
+        JSON::Object quota;
+        quota.values["guarantee"] = model(guarantee);
+        quota.values["allocated"] = model(allocated);
+        quota.values["headroom"] = model(guarantee - allocated);
+
+        entry.values["quota"] = quota;
+      }
+
+      array.values.push_back(entry);
+    }
+
+    object.values["roles"] = array;
+  }
+
+  {
+    JSON::Array array;
+    array.values.reserve(frameworks.size());
+
+    foreachpair (const FrameworkID& frameworkId,
+                 const Framework& framework,
+                 frameworks) {
+      JSON::Object entry;
+      entry.values["id"] = frameworkId.value();
+      entry.values["role"] = framework.role;
+      entry.values["suppressed"] = framework.suppressed;
+
+      Sorter* frameworkSorter = frameworkSorters.at(framework.role);
+      if (frameworkSorter->contains(frameworkId.value())) {
+        entry.values["share"] = frameworkSorter->share(frameworkId.value());
+      }
+
+      size_t offerFilters = 0;
+      foreachvalue (const hashset<OfferFilter*>& filters,
+                    framework.offerFilters) {
+        offerFilters += filters.size();
+      }
+
+      size_t inverseOfferFilters = 0;
+      foreachvalue (const hashset<InverseOfferFilter*>& filters,
+                    framework.inverseOfferFilters) {
+        inverseOfferFilters += filters.size();
+      }
+
+      entry.values["offer_filters"] = offerFilters;
+      entry.values["inverse_offer_filters"] = inverseOfferFilters;
+
+      array.values.push_back(entry);
+    }
+
+    object.values["frameworks"] = array;
+  }
+
+  {
+    JSON::Array array;
+    array.values.reserve(slaves.size());
+
+    foreachpair (const SlaveID& slaveId, const Slave& slave, slaves) {
+      JSON::Object entry;
+      entry.values["id"] = slaveId.value();
+      entry.values["hostname"] = slave.hostname;
+      entry.values["activated"] = slave.activated;
+      entry.values["total"] = model(slave.total);
+      entry.values["allocated"] = model(slave.allocated);
+
+      array.values.push_back(entry);
+    }
+
+    object.values["slaves"] = array;
+  }
+
+  process::dispatch(
+      stateProcess,
+      &StateProcess::update,
+      std::make_shared<const JSON::Object>(std::move(object)));
+}
+
+
 bool HierarchicalAllocatorProcess::isWhitelisted(
     const SlaveID& slaveId)
 {
@@ -1484,10 +1982,12 @@ bool HierarchicalAllocatorProcess::isFiltered(
   CHECK(frameworks.contains(frameworkId));
   CHECK(slaves.contains(slaveId));
 
+  const Framework& framework = frameworks.at(frameworkId);
+
   // Do not offer a non-checkpointing slave's resources to a checkpointing
   // framework. This is a short term fix until the following is resolved:
   // https://issues.apache.org/jira/browse/MESOS-444.
-  if (frameworks[frameworkId].checkpoint && !slaves[slaveId].checkpoint) {
+  if (framework.checkpoint && !slaves.at(slaveId).checkpoint) {
     VLOG(1) << "Filtered offer with " << resources
             << " on non-checkpointing slave " << slaveId
             << " for checkpointing framework " << frameworkId;
@@ -1495,9 +1995,18 @@ bool HierarchicalAllocatorProcess::isFiltered(
     return true;
   }
 
-  if (frameworks[frameworkId].offerFilters.contains(slaveId)) {
-    foreach (
-      OfferFilter* offerFilter, frameworks[frameworkId].offerFilters[slaveId]) {
+  if (!satisfies(frameworkId, slaveId, resources)) {
+    VLOG(1) << "Filtered offer with " << resources
+            << " on slave " << slaveId
+            << " not satisfying the offer constraints"
+            << " of framework " << frameworkId;
+
+    return true;
+  }
+
+  auto offerFilters = framework.offerFilters.find(slaveId);
+  if (offerFilters != framework.offerFilters.end()) {
+    foreach (OfferFilter* offerFilter, offerFilters->second) {
       if (offerFilter->filter(resources)) {
         VLOG(1) << "Filtered offer with " << resources
                 << " on slave " << slaveId
@@ -1512,6 +2021,42 @@ bool HierarchicalAllocatorProcess::isFiltered(
 }
 
 
+bool HierarchicalAllocatorProcess::satisfies(
+    const FrameworkID& frameworkId,
+    const SlaveID& slaveId,
+    const Resources& resources)
+{
+  const Framework& framework = frameworks.at(frameworkId);
+  const Slave& slave = slaves.at(slaveId);
+
+  if (framework.offerConstraints.isNone()) {
+    return true;
+  }
+
+  foreach (const FrameworkInfo::OfferConstraints::Attribute& constraint,
+           framework.offerConstraints->attributes()) {
+    bool found = false;
+
+    foreach (const Attribute& attribute, slave.attributes) {
+      if (attribute.name() == constraint.name() &&
+          (!constraint.has_value() ||
+           (attribute.type() == Value::TEXT &&
+            attribute.text().value() == constraint.value()))) {
+        found = true;
+        break;
+      }
+    }
+
+    if (!found) {
+      return false;
+    }
+  }
+
+  return framework.minResources.empty() ||
+         resources.flatten().contains(framework.minResources);
+}
+
+
 bool HierarchicalAllocatorProcess::isFiltered(
     const FrameworkID& frameworkId,
     const SlaveID& slaveId)
@@ -17,21 +17,35 @@
 #ifndef __MASTER_ALLOCATOR_MESOS_HIERARCHICAL_HPP__
 #define __MASTER_ALLOCATOR_MESOS_HIERARCHICAL_HPP__
 
+#include <memory>
 #include <string>
 
+#include <mesos/attributes.hpp>
 #include <mesos/mesos.hpp>
 
 #include <process/future.hpp>
+#include <process/http.hpp>
 #include <process/id.hpp>
+#include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
+#include <process/metrics/push_gauge.hpp>
+#include <process/metrics/timer.hpp>
+#include <process/process.hpp>
+#include <process/time.hpp>
 
 #include <stout/duration.hpp>
+#include <stout/flat_hashmap.hpp>
+#include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
+#include <stout/json.hpp>
+#include <stout/nothing.hpp>
 #include <stout/option.hpp>
+#include <stout/stringify.hpp>
 
 #include "master/allocator/mesos/allocator.hpp"
+#include "master/allocator/sorter/drf/hierarchical.hpp"
 #include "master/allocator/sorter/drf/sorter.hpp"
 
 #include "master/constants.hpp"
@@ -41,17 +55,72 @@ namespace internal {
 namespace master {
 namespace allocator {
 
+// The order in which an allocation run goes through the slaves. Each
+// slave is offered to the frameworks first in the DRF order, so this
+// determines which frameworks get the resources of which slaves.
+enum class SlaveOrder
+{
+  // Random order, which spreads the tasks across the cluster.
+  RANDOM,
+
+  // Slaves with the fewest available resources first, which packs
+  // the tasks onto fewer slaves and keeps large slaves free for
+  // frameworks with large tasks.
+  LEAST_AVAILABLE_FIRST,
+
+  // Slaves with the most available resources first, so that the
+  // frameworks first in the DRF order get the largest offers.
+  MOST_AVAILABLE_FIRST
+};
+
+
 // We forward declare the hierarchical allocator process so that we
-// can typedef an instantiation of it with DRF sorters.
-template <typename RoleSorter, typename FrameworkSorter>
+// can typedef an instantiation of it with DRF sorters. The roles are
+// sorted by a HierarchicalDRFSorter, so that roles like 'eng/ads' and
+// 'eng/search' share the resources of 'eng' with the other roles.
+//
+// 'OptimisticOffers' is the number of frameworks, after the one that
+// the resources of a slave are allocated to, that get an optimistic
+// copy of these resources in the same allocation run. The master
+// resolves the conflicts when one of the frameworks accepts, see
+// 'Master::rescindConflictingOffers()'.
+template <
+    typename RoleSorter,
+    typename FrameworkSorter,
+    SlaveOrder Order = SlaveOrder::RANDOM,
+    size_t OptimisticOffers = 0>
 class HierarchicalAllocatorProcess;
 
-typedef HierarchicalAllocatorProcess<DRFSorter, DRFSorter>
+typedef HierarchicalAllocatorProcess<HierarchicalDRFSorter, DRFSorter>
 HierarchicalDRFAllocatorProcess;
 
 typedef MesosAllocator<HierarchicalDRFAllocatorProcess>
 HierarchicalDRFAllocator;
 
+typedef HierarchicalAllocatorProcess<
+    HierarchicalDRFSorter, DRFSorter, SlaveOrder::LEAST_AVAILABLE_FIRST>
+HierarchicalDRFPackAllocatorProcess;
+
+typedef MesosAllocator<HierarchicalDRFPackAllocatorProcess>
+HierarchicalDRFPackAllocator;
+
+typedef HierarchicalAllocatorProcess<
+    HierarchicalDRFSorter, DRFSorter, SlaveOrder::MOST_AVAILABLE_FIRST>
+HierarchicalDRFMostAvailableAllocatorProcess;
+
+typedef MesosAllocator<HierarchicalDRFMostAvailableAllocatorProcess>
+HierarchicalDRFMostAvailableAllocator;
+
+// Offers the resources of each slave to up to 3 frameworks at once, in
+// the DRF order, so that frameworks holding on to their offers do not
+// keep the others waiting.
+typedef HierarchicalAllocatorProcess<
+    HierarchicalDRFSorter, DRFSorter, SlaveOrder::RANDOM, 2>
+HierarchicalDRFOptimisticAllocatorProcess;
+
+typedef MesosAllocator<HierarchicalDRFOptimisticAllocatorProcess>
+HierarchicalDRFOptimisticAllocator;
+
 
 namespace internal {
 
@@ -60,6 +129,34 @@ class OfferFilter;
 class InverseOfferFilter;
 
 
+// Serves the state of the allocator at '/allocator/state'. The
+// allocator publishes a snapshot of its state here at the end of each
+// allocation run, so that reading the state neither waits for nor
+// delays the events queued for the allocator.
+class StateProcess : public process::Process<StateProcess>
+{
+public:
+  StateProcess() : ProcessBase("allocator") {}
+
+  virtual ~StateProcess() {}
+
+  void update(const std::shared_ptr<const JSON::Object>& snapshot);
+
+protected:
+  virtual void initialize();
+
+private:
+  static const std::string STATE_HELP();
+
+  process::Future<process::http::Response> state(
+      const process::http::Request& request);
+
+  // The snapshot is never modified once published, so the allocator
+  // and this process can share it without copying.
+  std::shared_ptr<const JSON::Object> snapshot;
+};
+
+
 // Implements the basic allocator algorithm - first pick a role by
 // some criteria, then pick one of their frameworks to allocate to.
 class HierarchicalAllocatorProcess : public MesosAllocatorProcess
@@ -67,17 +164,30 @@ class HierarchicalAllocatorProcess : public MesosAllocatorProcess
 public:
   HierarchicalAllocatorProcess(
       const std::function<Sorter*()>& _roleSorterFactory,
-      const std::function<Sorter*()>& _frameworkSorterFactory)
+      const std::function<Sorter*()>& _frameworkSorterFactory,
+      SlaveOrder _slaveOrder,
+      size_t _optimisticOffers)
     : ProcessBase(process::ID::generate("hierarchical-allocator")),
       initialized(false),
       paused(true),
+      dirty(true),
       metrics(*this),
       roleSorterFactory(_roleSorterFactory),
       frameworkSorterFactory(_frameworkSorterFactory),
+      slaveOrder(_slaveOrder),
+      optimisticOffers(_optimisticOffers),
       quotaRoleSorter(NULL),
-      roleSorter(NULL) {}
+      roleSorter(NULL),
+      stateProcess(NULL) {}
 
-  virtual ~HierarchicalAllocatorProcess() {}
+  virtual ~HierarchicalAllocatorProcess()
+  {
+    if (stateProcess != NULL) {
+      process::terminate(stateProcess);
+      process::wait(stateProcess);
+      delete stateProcess;
+    }
+  }
 
   process::PID<HierarchicalAllocatorProcess> self() const
   {
@@ -174,6 +284,11 @@ public:
       const Resources& resources,
       const Option<Filters>& filters);
 
+  void acceptResources(
+      const FrameworkID& frameworkId,
+      const SlaveID& slaveId,
+      const Resources& resources);
+
   void suppressOffers(
       const FrameworkID& frameworkId);
 
@@ -199,15 +314,25 @@ protected:
   // Callback for doing batch allocations.
   void batch();
 
-  // Allocate any allocatable resources.
+  // Allocate any allocatable resources. This only schedules an
+  // allocation run, see '_allocate'.
   void allocate();
 
-  // Allocate resources just from the specified slave.
+  // Allocate resources just from the specified slave. This only
+  // schedules an allocation run, see '_allocate'.
   void allocate(const SlaveID& slaveId);
 
+  // Performs an allocation run for the slaves accumulated in
+  // 'allocationCandidates' by the calls to 'allocate' since the
+  // last run.
+  Nothing _allocate();
+
   // Allocate resources from the specified slaves.
   void allocate(const hashset<SlaveID>& slaveIds);
 
+  // Publishes a snapshot of the allocator's state to 'stateProcess'.
+  void publish();
+
   // Send inverse offers from the specified slaves.
   void deallocate(const hashset<SlaveID>& slaveIds);
 
@@ -226,8 +351,20 @@ protected:
   // Checks whether the slave is whitelisted.
   bool isWhitelisted(const SlaveID& slaveId);
 
+  void updateOfferConstraints(
+      const FrameworkID& frameworkId,
+      const FrameworkInfo& frameworkInfo);
+
+  // Returns true if the slave, and the resources available on it,
+  // satisfy the offer constraints of the framework.
+  bool satisfies(
+      const FrameworkID& frameworkId,
+      const SlaveID& slaveId,
+      const Resources& resources);
+
   // Returns true if there is a resource offer filter for this framework
-  // on this slave.
+  // on this slave, or if the slave or the resources do not satisfy the
+  // offer constraints of the framework.
   bool isFiltered(
       const FrameworkID& frameworkId,
       const SlaveID& slaveId,
@@ -244,6 +381,22 @@ protected:
   bool initialized;
   bool paused;
 
+  // Slaves to include in the next allocation run.
+  hashset<SlaveID> allocationCandidates;
+
+  // If true, the periodic allocation performs an allocation of all
+  // slaves, otherwise it is skipped. Set by the events that can lead
+  // to new offers without requesting an allocation themselves, e.g.,
+  // recovered resources or expired filters, and cleared by an
+  // allocation of all slaves.
+  bool dirty;
+
+  // The pending allocation run, if any. Events like adding a framework
+  // or a slave request an allocation, and all the requests made while
+  // a run is pending are coalesced into that run. Otherwise a burst of
+  // such events would perform a full allocation for each of them.
+  Option<process::Future<Nothing>> allocation;
+
   // Recovery data.
   Option<int> expectedAgentCount;
 
@@ -262,17 +415,71 @@ protected:
     explicit Metrics(const Self& process)
       : event_queue_dispatches(
             "allocator/event_queue_dispatches",
-            process::defer(process.self(), &Self::_event_queue_dispatches))
+            process::defer(process.self(), &Self::_event_queue_dispatches)),
+        allocation_runs("allocator/allocation_runs"),
+        allocation_runs_skipped("allocator/allocation_runs_skipped"),
+        allocation_run("allocator/allocation_run", Hours(1)),
+        allocation_run_slaves("allocator/allocation_run_slaves")
     {
       process::metrics::add(event_queue_dispatches);
+      process::metrics::add(allocation_runs);
+      process::metrics::add(allocation_runs_skipped);
+      process::metrics::add(allocation_run);
+      process::metrics::add(allocation_run_slaves);
     }
 
     ~Metrics()
     {
       process::metrics::remove(event_queue_dispatches);
+      process::metrics::remove(allocation_runs);
+      process::metrics::remove(allocation_runs_skipped);
+      process::metrics::remove(allocation_run);
+      process::metrics::remove(allocation_run_slaves);
+
+      foreachvalue (const process::metrics::Timer<Milliseconds>& timer,
+                    time_to_offer) {
+        process::metrics::remove(timer);
+      }
+    }
+
+    void addFramework(const FrameworkID& frameworkId)
+    {
+      process::metrics::Timer<Milliseconds> timer(
+          "allocator/frameworks/" + stringify(frameworkId) + "/time_to_offer",
+          Hours(1));
+
+      timer.label(
+          "allocator/frameworks/time_to_offer_ms",
+          {{"framework_id", stringify(frameworkId)}});
+
+      process::metrics::add(timer);
+
+      time_to_offer.put(frameworkId, timer);
+    }
+
+    void removeFramework(const FrameworkID& frameworkId)
+    {
+      if (time_to_offer.contains(frameworkId)) {
+        process::metrics::remove(time_to_offer.at(frameworkId));
+        time_to_offer.erase(frameworkId);
+      }
     }
 
     process::metrics::Gauge event_queue_dispatches;
+
+    process::metrics::Counter allocation_runs;
+    process::metrics::Counter allocation_runs_skipped;
+
+    // Latency of the allocation runs, and the number of slaves they
+    // covered, which is smaller than the number of slaves for the
+    // runs requested by events about individual slaves.
+    process::metrics::Timer<Milliseconds> allocation_run;
+    process::metrics::PushGauge allocation_run_slaves;
+
+    // Per-framework time from resources becoming available on a
+    // slave (the slave was added or resources were recovered on it)
+    // until they are offered to the framework.
+    hashmap<FrameworkID, process::metrics::Timer<Milliseconds>> time_to_offer;
   } metrics;
 
   struct Framework
@@ -286,6 +493,13 @@ protected:
     // Whether the framework desires revocable resources.
     bool revocable;
 
+    // The constraints that the offers to the framework have to satisfy
+    // (see 'FrameworkInfo.offer_constraints'), with the minimum
+    // resources flattened so that they can be compared regardless of
+    // roles and reservations.
+    Option<FrameworkInfo::OfferConstraints> offerConstraints;
+    Resources minResources;
+
     // Active offer and inverse offer filters for the framework.
     hashmap<SlaveID, hashset<OfferFilter*>> offerFilters;
     hashmap<SlaveID, hashset<InverseOfferFilter*>> inverseOfferFilters;
@@ -296,7 +510,10 @@ protected:
     return static_cast<double>(eventCount<process::DispatchEvent>());
   }
 
-  hashmap<FrameworkID, Framework> frameworks;
+  // NOTE: The maps of frameworks and slaves are 'flat_hashmap's since
+  // they are looked up for every allocation, which means that adding
+  // a framework (slave) may invalidate the references to the others.
+  flat_hashmap<FrameworkID, Framework> frameworks;
 
   struct Slave
   {
@@ -319,11 +536,29 @@ protected:
     // Note that it's possible for the slave to be over-allocated!
     // In this case, allocated > total.
 
+    // The optimistic copies of allocated resources that are offered
+    // to further frameworks, which are not in 'allocated'. When a
+    // framework accepts its copy, the accepted resources count as
+    // allocated to it (see 'acceptResources()'). When the allocated
+    // resources are recovered, the resources of a copy count as
+    // allocated instead, as the framework holding the copy may still
+    // accept them (see 'recoverResources()').
+    hashmap<FrameworkID, Resources> optimistic;
+
     bool activated;  // Whether to offer resources.
     bool checkpoint; // Whether slave supports checkpointing.
 
+    // The time since which the slave has had available resources that
+    // were not offered, for the 'time_to_offer' metrics. This is the
+    // time of the oldest such resources, hence it is not reset when
+    // only part of the available resources is offered.
+    Option<process::Time> idle;
+
     std::string hostname;
 
+    // The attributes of the slave, for the offer constraints.
+    Attributes attributes;
+
     // Represents a scheduled unavailability due to maintenance for a specific
     // slave, and the responses from frameworks as to whether they will be able
     // to gracefully handle this unavailability.
@@ -359,7 +594,7 @@ protected:
     Option<Maintenance> maintenance;
   };
 
-  hashmap<SlaveID, Slave> slaves;
+  flat_hashmap<SlaveID, Slave> slaves;
 
   // Represents a role and data associated with it.
   // NOTE: We currently associate quota with roles, but this may change in
@@ -396,6 +631,10 @@ protected:
   const std::function<Sorter*()> roleSorterFactory;
   const std::function<Sorter*()> frameworkSorterFactory;
 
+  const SlaveOrder slaveOrder;
+
+  const size_t optimisticOffers;
+
   // A dedicated sorter for roles for which quota is set. Quota'ed roles
   // belong to an extra allocation group and have resources allocated up
   // to their alloted quota prior to non-quota'ed roles.
@@ -405,6 +644,11 @@ protected:
 
   Sorter* roleSorter;
   hashmap<std::string, Sorter*> frameworkSorters;
+
+  // Serves the snapshots of the allocator's state. This is NULL
+  // before 'initialize' or if there is another allocator serving
+  // '/allocator/state' in this process.
+  StateProcess* stateProcess;
 };
 
 
@@ -414,7 +658,11 @@ protected:
 // We map the templatized version of the `HierarchicalAllocatorProcess` to one
 // that relies on sorter factories in the internal namespace. This allows us
 // to keep the implemention of the allocator in the implementation file.
-template <typename RoleSorter, typename FrameworkSorter>
+template <
+    typename RoleSorter,
+    typename FrameworkSorter,
+    SlaveOrder Order,
+    size_t OptimisticOffers>
 class HierarchicalAllocatorProcess
   : public internal::HierarchicalAllocatorProcess
 {
@@ -422,7 +670,9 @@ public:
   HierarchicalAllocatorProcess()
     : internal::HierarchicalAllocatorProcess(
           []() -> Sorter* { return new RoleSorter(); },
-          []() -> Sorter* { return new FrameworkSorter(); }) {}
+          []() -> Sorter* { return new FrameworkSorter(); },
+          Order,
+          OptimisticOffers) {}
 };
 
 } // namespace allocator {
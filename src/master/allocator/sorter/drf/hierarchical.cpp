@@ -0,0 +1,449 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
+
+#include "logging/logging.hpp"
+
+#include "master/allocator/sorter/drf/hierarchical.hpp"
+
+using std::list;
+using std::string;
+
+namespace mesos {
+namespace internal {
+namespace master {
+namespace allocator {
+
+// The name of a client in the sorter of its own node. The paths are
+// split at '/', so no child of a node can have this name.
+static const char SELF[] = "/";
+
+
+HierarchicalDRFSorter::HierarchicalDRFSorter()
+  : root(new Node("", "", NULL)),
+    clients(0) {}
+
+
+HierarchicalDRFSorter::~HierarchicalDRFSorter()
+{
+  foreachvalue (Node* node, nodes) {
+    delete node;
+  }
+
+  delete root;
+}
+
+
+void HierarchicalDRFSorter::add(const string& name, double weight)
+{
+  CHECK(!name.empty());
+
+  Node* node = create(name);
+  CHECK(!node->client) << "Client '" << name << "' already exists";
+
+  node->sorter.add(SELF, weight);
+  node->client = true;
+  node->clientActive = true;
+
+  updateWeight(node, weight);
+  updateActive(node, 1);
+
+  clients++;
+}
+
+
+void HierarchicalDRFSorter::remove(const string& name)
+{
+  Node* node = find(name);
+
+  // Remove the client's allocation from the subtrees of the ancestors,
+  // the client's own sorter entry is removed with it below.
+  foreachpair (const SlaveID& slaveId,
+               const Resources& resources,
+               node->sorter.allocation(SELF)) {
+    for (Node* n = node; n != root; n = n->parent) {
+      n->parent->sorter.unallocated(n->name, slaveId, resources);
+    }
+  }
+
+  if (node->clientActive) {
+    updateActive(node, -1);
+  }
+
+  node->sorter.remove(SELF);
+  node->client = false;
+  node->clientActive = false;
+
+  clients--;
+
+  if (!node->children.empty()) {
+    updateWeight(node, 1);
+    return;
+  }
+
+  // Remove the nodes that have neither a client nor children left.
+  while (node != root && !node->client && node->children.empty()) {
+    Node* parent = node->parent;
+
+    parent->sorter.remove(node->name);
+    parent->children.erase(node->name);
+    nodes.erase(node->path);
+
+    delete node;
+
+    node = parent;
+  }
+}
+
+
+void HierarchicalDRFSorter::activate(const string& name)
+{
+  Node* node = find(name);
+
+  if (!node->clientActive) {
+    node->sorter.activate(SELF);
+    node->clientActive = true;
+
+    updateActive(node, 1);
+  }
+}
+
+
+void HierarchicalDRFSorter::deactivate(const string& name)
+{
+  Node* node = find(name);
+
+  if (node->clientActive) {
+    node->sorter.deactivate(SELF);
+    node->clientActive = false;
+
+    updateActive(node, -1);
+  }
+}
+
+
+void HierarchicalDRFSorter::allocated(
+    const string& name,
+    const SlaveID& slaveId,
+    const Resources& resources)
+{
+  Node* node = find(name);
+
+  node->sorter.allocated(SELF, slaveId, resources);
+
+  for (Node* n = node; n != root; n = n->parent) {
+    n->parent->sorter.allocated(n->name, slaveId, resources);
+  }
+}
+
+
+void HierarchicalDRFSorter::update(
+    const string& name,
+    const SlaveID& slaveId,
+    const Resources& oldAllocation,
+    const Resources& newAllocation)
+{
+  Node* node = find(name);
+
+  // Updating an allocation also updates the total pool of resources
+  // of the sorters that have the client, i.e., those of the node and
+  // its ancestors. The sorters of the other nodes get the new total.
+  hashset<Node*> updated;
+
+  node->sorter.update(SELF, slaveId, oldAllocation, newAllocation);
+  updated.insert(node);
+
+  for (Node* n = node; n != root; n = n->parent) {
+    n->parent->sorter.update(n->name, slaveId, oldAllocation, newAllocation);
+    updated.insert(n->parent);
+  }
+
+  total[slaveId] -= oldAllocation;
+  total[slaveId] += newAllocation;
+
+  foreachvalue (Node* n, nodes) {
+    if (!updated.contains(n)) {
+      n->sorter.update(slaveId, total[slaveId]);
+    }
+  }
+
+  if (total[slaveId].empty()) {
+    total.erase(slaveId);
+  }
+}
+
+
+void HierarchicalDRFSorter::unallocated(
+    const string& name,
+    const SlaveID& slaveId,
+    const Resources& resources)
+{
+  Node* node = find(name);
+
+  node->sorter.unallocated(SELF, slaveId, resources);
+
+  for (Node* n = node; n != root; n = n->parent) {
+    n->parent->sorter.unallocated(n->name, slaveId, resources);
+  }
+}
+
+
+hashmap<SlaveID, Resources> HierarchicalDRFSorter::allocation(
+    const string& name)
+{
+  return find(name)->sorter.allocation(SELF);
+}
+
+
+hashmap<string, Resources> HierarchicalDRFSorter::allocation(
+    const SlaveID& slaveId)
+{
+  hashmap<string, Resources> result;
+
+  foreachvalue (Node* node, nodes) {
+    if (node->client) {
+      Resources resources = node->sorter.allocation(SELF, slaveId);
+
+      if (!resources.empty()) {
+        result.emplace(node->path, resources);
+      }
+    }
+  }
+
+  return result;
+}
+
+
+Resources HierarchicalDRFSorter::allocation(
+    const string& name,
+    const SlaveID& slaveId)
+{
+  return find(name)->sorter.allocation(SELF, slaveId);
+}
+
+
+const Resources& HierarchicalDRFSorter::allocationScalars(const string& name)
+{
+  return find(name)->sorter.allocationScalars(SELF);
+}
+
+
+double HierarchicalDRFSorter::share(const string& name)
+{
+  return find(name)->sorter.share(SELF);
+}
+
+
+void HierarchicalDRFSorter::add(
+    const SlaveID& slaveId,
+    const Resources& resources)
+{
+  if (resources.empty()) {
+    return;
+  }
+
+  total[slaveId] += resources;
+
+  root->sorter.add(slaveId, resources);
+
+  foreachvalue (Node* node, nodes) {
+    node->sorter.add(slaveId, resources);
+  }
+}
+
+
+void HierarchicalDRFSorter::remove(
+    const SlaveID& slaveId,
+    const Resources& resources)
+{
+  if (resources.empty()) {
+    return;
+  }
+
+  CHECK(total.contains(slaveId));
+
+  total[slaveId] -= resources;
+
+  if (total[slaveId].empty()) {
+    total.erase(slaveId);
+  }
+
+  root->sorter.remove(slaveId, resources);
+
+  foreachvalue (Node* node, nodes) {
+    node->sorter.remove(slaveId, resources);
+  }
+}
+
+
+void HierarchicalDRFSorter::update(
+    const SlaveID& slaveId,
+    const Resources& resources)
+{
+  if (resources.empty()) {
+    total.erase(slaveId);
+  } else {
+    total[slaveId] = resources;
+  }
+
+  root->sorter.update(slaveId, resources);
+
+  foreachvalue (Node* node, nodes) {
+    node->sorter.update(slaveId, resources);
+  }
+}
+
+
+list<string> HierarchicalDRFSorter::sort()
+{
+  list<string> result;
+
+  if (!root->children.empty()) {
+    sort(root, &result);
+  }
+
+  return result;
+}
+
+
+bool HierarchicalDRFSorter::contains(const string& name)
+{
+  return nodes.contains(name) && nodes.at(name)->client;
+}
+
+
+int HierarchicalDRFSorter::count()
+{
+  return clients;
+}
+
+
+HierarchicalDRFSorter::Node* HierarchicalDRFSorter::create(const string& path)
+{
+  if (path.empty()) {
+    return root;
+  }
+
+  if (nodes.contains(path)) {
+    return nodes.at(path);
+  }
+
+  const size_t separator = path.find_last_of('/');
+
+  Node* parent;
+  string name;
+
+  if (separator == string::npos) {
+    parent = root;
+    name = path;
+  } else {
+    parent = create(path.substr(0, separator));
+    name = path.substr(separator + 1);
+  }
+
+  Node* node = new Node(path, name, parent);
+
+  foreachpair (const SlaveID& slaveId, const Resources& resources, total) {
+    node->sorter.add(slaveId, resources);
+  }
+
+  // The node has no active clients yet.
+  parent->sorter.add(name, node->weight);
+  parent->sorter.deactivate(name);
+  parent->children[name] = node;
+
+  nodes[path] = node;
+
+  return node;
+}
+
+
+HierarchicalDRFSorter::Node* HierarchicalDRFSorter::find(const string& name)
+{
+  CHECK(contains(name)) << "Unknown client '" << name << "'";
+
+  return nodes.at(name);
+}
+
+
+void HierarchicalDRFSorter::updateActive(Node* node, int delta)
+{
+  for (Node* n = node; n != root; n = n->parent) {
+    const size_t active = n->active;
+    n->active += delta;
+
+    if (active == 0 && n->active > 0) {
+      n->parent->sorter.activate(n->name);
+    } else if (active > 0 && n->active == 0) {
+      n->parent->sorter.deactivate(n->name);
+    }
+  }
+}
+
+
+void HierarchicalDRFSorter::updateWeight(Node* node, double weight)
+{
+  if (node->weight == weight) {
+    return;
+  }
+
+  // A DRFSorter cannot change the weight of a client, so we add the
+  // node again with its allocation.
+  DRFSorter* sorter = &node->parent->sorter;
+
+  const hashmap<SlaveID, Resources> allocation = sorter->allocation(node->name);
+
+  sorter->remove(node->name);
+  sorter->add(node->name, weight);
+
+  foreachpair (const SlaveID& slaveId,
+               const Resources& resources,
+               allocation) {
+    sorter->allocated(node->name, slaveId, resources);
+  }
+
+  if (node->active == 0) {
+    sorter->deactivate(node->name);
+  }
+
+  node->weight = weight;
+}
+
+
+void HierarchicalDRFSorter::sort(Node* node, list<string>* result)
+{
+  // Only the nodes with active clients get sorted, so the client of a
+  // node without children is active.
+  if (node->children.empty()) {
+    result->push_back(node->path);
+    return;
+  }
+
+  foreach (const string& name, node->sorter.sort()) {
+    if (name == SELF) {
+      result->push_back(node->path);
+    } else {
+      sort(node->children.at(name), result);
+    }
+  }
+}
+
+} // namespace allocator {
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,175 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MASTER_ALLOCATOR_SORTER_DRF_HIERARCHICAL_HPP__
+#define __MASTER_ALLOCATOR_SORTER_DRF_HIERARCHICAL_HPP__
+
+#include <list>
+#include <string>
+
+#include <mesos/resources.hpp>
+
+#include <stout/hashmap.hpp>
+
+#include "master/allocator/sorter/sorter.hpp"
+
+#include "master/allocator/sorter/drf/sorter.hpp"
+
+
+namespace mesos {
+namespace internal {
+namespace master {
+namespace allocator {
+
+// A sorter for clients whose names are paths, e.g., 'eng/ads/batch'.
+// The clients form a tree in which each node sorts only its children,
+// by the dominant share of the resources allocated to the clients in
+// their subtrees, using a DRFSorter. The prefixes of the paths need
+// not be clients themselves, e.g., 'eng' and 'eng/ads' above. If they
+// are, a client is sorted next to the subtrees of its children.
+//
+// The order of the clients is the depth first traversal of the tree,
+// so the cost of sorting a node depends only on the number of its
+// children. A flat set of client names is a tree with a single level,
+// which this sorter sorts the same way as a DRFSorter.
+class HierarchicalDRFSorter : public Sorter
+{
+public:
+  HierarchicalDRFSorter();
+
+  virtual ~HierarchicalDRFSorter();
+
+  virtual void add(const std::string& name, double weight = 1);
+
+  virtual void remove(const std::string& name);
+
+  virtual void activate(const std::string& name);
+
+  virtual void deactivate(const std::string& name);
+
+  virtual void allocated(
+      const std::string& name,
+      const SlaveID& slaveId,
+      const Resources& resources);
+
+  virtual void update(
+      const std::string& name,
+      const SlaveID& slaveId,
+      const Resources& oldAllocation,
+      const Resources& newAllocation);
+
+  virtual void unallocated(
+      const std::string& name,
+      const SlaveID& slaveId,
+      const Resources& resources);
+
+  virtual hashmap<SlaveID, Resources> allocation(const std::string& name);
+
+  virtual hashmap<std::string, Resources> allocation(const SlaveID& slaveId);
+
+  virtual Resources allocation(const std::string& name, const SlaveID& slaveId);
+
+  virtual const Resources& allocationScalars(const std::string& name);
+
+  virtual double share(const std::string& name);
+
+  virtual void add(const SlaveID& slaveId, const Resources& resources);
+
+  virtual void remove(const SlaveID& slaveId, const Resources& resources);
+
+  virtual void update(const SlaveID& slaveId, const Resources& resources);
+
+  virtual std::list<std::string> sort();
+
+  virtual bool contains(const std::string& name);
+
+  virtual int count();
+
+private:
+  struct Node
+  {
+    Node(const std::string& _path, const std::string& _name, Node* _parent)
+      : path(_path),
+        name(_name),
+        parent(_parent),
+        client(false),
+        clientActive(false),
+        active(0),
+        weight(1) {}
+
+    // The full path of the node, e.g., 'eng/ads', and the last
+    // component of it, e.g., 'ads', which is the name of the node in
+    // the sorter of its parent.
+    const std::string path;
+    const std::string name;
+
+    Node* parent;
+
+    hashmap<std::string, Node*> children;
+
+    // Sorts the children of this node and, if the path of this node
+    // is a client, the client itself. The allocations of a child are
+    // those of all the clients in its subtree.
+    DRFSorter sorter;
+
+    // Whether the path of this node is a client, and if so, whether
+    // the client is active.
+    bool client;
+    bool clientActive;
+
+    // The number of active clients in the subtree of this node. The
+    // node is active in the sorter of its parent if this is positive.
+    size_t active;
+
+    // The weight of the node in the sorter of its parent, which is
+    // the weight of the client if the path of this node is a client.
+    double weight;
+  };
+
+  // Returns the node for the path, creating it and its ancestors if
+  // they do not exist yet.
+  Node* create(const std::string& path);
+
+  // Returns the node of a client.
+  Node* find(const std::string& name);
+
+  // Updates the number of active clients in the subtree of the node
+  // and of its ancestors, and (de)activates them accordingly.
+  void updateActive(Node* node, int delta);
+
+  // Sets the weight of the node in the sorter of its parent.
+  void updateWeight(Node* node, double weight);
+
+  void sort(Node* node, std::list<std::string>* result);
+
+  Node* root;
+
+  // All the nodes of the tree, by path, except the root.
+  hashmap<std::string, Node*> nodes;
+
+  int clients;
+
+  // The total pool of resources, which every node's sorter uses to
+  // calculate the shares. We keep it to initialize new nodes.
+  hashmap<SlaveID, Resources> total;
+};
+
+} // namespace allocator {
+} // namespace master {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MASTER_ALLOCATOR_SORTER_DRF_HIERARCHICAL_HPP__
@@ -42,7 +42,7 @@ bool DRFComparator::operator()(const Client& client1, const Client& client2)
 void DRFSorter::add(const string& name, double weight)
 {
   Client client(name, 0, 0);
-  clients.insert(client);
+  insert(client);
 
   allocations[name] = Allocation();
   weights[name] = weight;
@@ -54,7 +54,7 @@ void DRFSorter::remove(const string& name)
   set<Client, DRFComparator>::iterator it = find(name);
 
   if (it != clients.end()) {
-    clients.erase(it);
+    erase(it);
   }
 
   allocations.erase(name);
@@ -67,7 +67,7 @@ void DRFSorter::activate(const string& name)
   CHECK(allocations.contains(name));
 
   Client client(name, calculateShare(name), 0);
-  clients.insert(client);
+  insert(client);
 }
 
 
@@ -80,7 +80,7 @@ void DRFSorter::deactivate(const string& name)
     // because we lose information such as the number of allocations
     // for this client which means the fairness can be gamed by a
     // framework disconnecting and reconnecting.
-    clients.erase(it);
+    erase(it);
   }
 }
 
@@ -100,8 +100,8 @@ void DRFSorter::allocated(
     client.allocations++;
 
     // Remove and reinsert it to update the ordering appropriately.
-    clients.erase(it);
-    clients.insert(client);
+    erase(it);
+    insert(client);
   }
 
   allocations[name].resources[slaveId] += resources;
@@ -138,6 +138,8 @@ void DRFSorter::update(
   total.scalars -= oldAllocation.scalars();
   total.scalars += newAllocation.scalars();
 
+  updateQuantities();
+
   CHECK(allocations[name].resources[slaveId].contains(oldAllocation));
   CHECK(allocations[name].scalars.contains(oldAllocation.scalars()));
 
@@ -192,6 +194,22 @@ Resources DRFSorter::allocation(const string& name, const SlaveID& slaveId)
 }
 
 
+const Resources& DRFSorter::allocationScalars(const string& name)
+{
+  CHECK(contains(name));
+
+  return allocations.at(name).scalars;
+}
+
+
+double DRFSorter::share(const string& name)
+{
+  CHECK(contains(name));
+
+  return calculateShare(name);
+}
+
+
 void DRFSorter::unallocated(
     const string& name,
     const SlaveID& slaveId,
@@ -216,6 +234,8 @@ void DRFSorter::add(const SlaveID& slaveId, const Resources& resources)
     total.resources[slaveId] += resources;
     total.scalars += resources.scalars();
 
+    updateQuantities();
+
     // We have to recalculate all shares when the total resources
     // change, but we put it off until sort is called so that if
     // something else changes before the next allocation we don't
@@ -233,6 +253,8 @@ void DRFSorter::remove(const SlaveID& slaveId, const Resources& resources)
     total.resources[slaveId] -= resources;
     total.scalars -= resources.scalars();
 
+    updateQuantities();
+
     if (total.resources[slaveId].empty()) {
       total.resources.erase(slaveId);
     }
@@ -251,6 +273,8 @@ void DRFSorter::update(const SlaveID& slaveId, const Resources& resources)
 
   total.resources[slaveId] = resources;
 
+  updateQuantities();
+
   if (total.resources[slaveId].empty()) {
     total.resources.erase(slaveId);
   }
@@ -274,7 +298,16 @@ list<string> DRFSorter::sort()
       temp.insert(client);
     }
 
-    clients = temp;
+    clients.swap(temp);
+
+    index.clear();
+    for (it = clients.begin(); it != clients.end(); it++) {
+      index[it->name] = it;
+    }
+
+    // Shares only need to be recalculated again after another
+    // dirtying operation occurs.
+    dirty = false;
   }
 
   list<string> result;
@@ -311,8 +344,8 @@ void DRFSorter::update(const string& name)
     client.share = calculateShare(client.name);
 
     // Remove and reinsert it to update the ordering appropriately.
-    clients.erase(it);
-    clients.insert(client);
+    erase(it);
+    insert(client);
   }
 }
 
@@ -325,25 +358,18 @@ double DRFSorter::calculateShare(const string& name)
   // currently does not take into account resources that are not
   // scalars.
 
-  foreach (const string& scalar, total.scalars.names()) {
-    double _total = 0.0;
-
-    // NOTE: Scalar resources may be spread across multiple
-    // 'Resource' objects. E.g. persistent volumes.
-    foreach (const Resource& resource, total.scalars.get(scalar)) {
-      CHECK_EQ(resource.type(), Value::SCALAR);
-      _total += resource.scalar().value();
-    }
+  const Resources& scalars = allocations[name].scalars;
 
+  foreachpair (const string& scalar, double _total, total.quantities) {
     if (_total > 0.0) {
       double allocation = 0.0;
 
       // NOTE: Scalar resources may be spread across multiple
       // 'Resource' objects. E.g. persistent volumes.
-      foreach (const Resource& resource,
-               allocations[name].scalars.get(scalar)) {
-        CHECK_EQ(resource.type(), Value::SCALAR);
-        allocation += resource.scalar().value();
+      foreach (const Resource& resource, scalars) {
+        if (resource.name() == scalar) {
+          allocation += resource.scalar().value();
+        }
       }
 
       share = std::max(share, allocation / _total);
@@ -354,16 +380,40 @@ double DRFSorter::calculateShare(const string& name)
 }
 
 
+void DRFSorter::updateQuantities()
+{
+  total.quantities.clear();
+
+  foreach (const Resource& resource, total.scalars) {
+    CHECK_EQ(resource.type(), Value::SCALAR);
+    total.quantities[resource.name()] += resource.scalar().value();
+  }
+}
+
+
 set<Client, DRFComparator>::iterator DRFSorter::find(const string& name)
 {
-  set<Client, DRFComparator>::iterator it;
-  for (it = clients.begin(); it != clients.end(); it++) {
-    if (name == (*it).name) {
-      break;
-    }
+  hashmap<string, set<Client, DRFComparator>::iterator>::iterator it =
+    index.find(name);
+
+  if (it == index.end()) {
+    return clients.end();
   }
 
-  return it;
+  return it->second;
+}
+
+
+void DRFSorter::insert(const Client& client)
+{
+  index[client.name] = clients.insert(client).first;
+}
+
+
+void DRFSorter::erase(set<Client, DRFComparator>::iterator it)
+{
+  index.erase(it->name);
+  clients.erase(it);
 }
 
 } // namespace allocator {
@@ -22,6 +22,7 @@
 
 #include <mesos/resources.hpp>
 
+#include <stout/flat_hashmap.hpp>
 #include <stout/hashmap.hpp>
 
 #include "master/allocator/sorter/sorter.hpp"
@@ -93,6 +94,10 @@ public:
 
   virtual Resources allocation(const std::string& name, const SlaveID& slaveId);
 
+  virtual const Resources& allocationScalars(const std::string& name);
+
+  virtual double share(const std::string& name);
+
   virtual void add(const SlaveID& slaveId, const Resources& resources);
 
   virtual void remove(const SlaveID& slaveId, const Resources& resources);
@@ -113,16 +118,29 @@ private:
   // Returns the dominant resource share for the client.
   double calculateShare(const std::string& name);
 
+  // Recalculates the total quantity of each kind of scalar resource.
+  void updateQuantities();
+
   // Returns an iterator to the specified client, if
   // it exists in this Sorter.
   std::set<Client, DRFComparator>::iterator find(const std::string& name);
 
+  // Inserts the client into 'clients' and 'index'.
+  void insert(const Client& client);
+
+  // Erases the client from 'clients' and 'index'.
+  void erase(std::set<Client, DRFComparator>::iterator it);
+
   // If true, sort() will recalculate all shares.
-  bool dirty;
+  bool dirty = false;
 
   // A set of Clients (names and shares) sorted by share.
   std::set<Client, DRFComparator> clients;
 
+  // Maps the names of the active clients to their position in
+  // 'clients', which lets us find a client without scanning the set.
+  hashmap<std::string, std::set<Client, DRFComparator>::iterator> index;
+
   // Maps client names to the weights that should be applied to their shares.
   hashmap<std::string, double> weights;
 
@@ -134,6 +152,10 @@ private:
     // that to speed up the calculation of shares. See MESOS-2891 for
     // the reasons why we want to do that.
     Resources scalars;
+
+    // The total quantity of each kind of scalar, e.g., "cpus", so
+    // that calculating a share doesn't sum them up each time.
+    hashmap<std::string, double> quantities;
   } total;
 
   // Allocation for a client.
@@ -145,7 +167,7 @@ private:
   };
 
   // Maps client names to the resources they have been allocated.
-  hashmap<std::string, Allocation> allocations;
+  flat_hashmap<std::string, Allocation> allocations;
 };
 
 } // namespace allocator {
@@ -88,6 +88,15 @@ public:
       const std::string& client,
       const SlaveID& slaveId) = 0;
 
+  // Returns the scalar resources allocated to this client, summed up
+  // across all slaves. This is maintained as allocations change, so
+  // it is cheaper than summing up 'allocation(client)'.
+  virtual const Resources& allocationScalars(const std::string& client) = 0;
+
+  // Returns the share of this client that the Sorter's policy
+  // orders the clients by, either active or deactivated.
+  virtual double share(const std::string& client) = 0;
+
   // Add resources to the total pool of resources this
   // Sorter should consider.
   virtual void add(const SlaveID& slaveId, const Resources& resources) = 0;
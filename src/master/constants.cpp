@@ -32,11 +32,18 @@ const Bytes MIN_MEM = Megabytes(32);
 const Duration DEFAULT_HEARTBEAT_INTERVAL = Seconds(15);
 const Duration DEFAULT_SLAVE_PING_TIMEOUT = Seconds(15);
 const size_t DEFAULT_MAX_SLAVE_PING_TIMEOUTS = 5;
+const size_t SLAVE_PING_SLOTS = 10;
+const Duration SLAVE_PING_LATENCY_WINDOW = Minutes(15);
+const Bytes DEFAULT_MAX_HTTP_FRAMEWORK_BUFFER_SIZE = Megabytes(64);
 const Duration MIN_SLAVE_REREGISTER_TIMEOUT = Minutes(10);
 const double RECOVERY_SLAVE_REMOVAL_PERCENT_LIMIT = 1.0; // 100%.
 const size_t MAX_REMOVED_SLAVES = 100000;
 const uint32_t MAX_COMPLETED_FRAMEWORKS = 50;
 const uint32_t MAX_COMPLETED_TASKS_PER_FRAMEWORK = 1000;
+const uint32_t MAX_OFFER_TRACES = 1000;
+const size_t MAX_STATE_CACHE_RESPONSES = 16;
+const size_t TASK_VALIDATION_BATCH_SIZE = 128;
+const size_t RECONCILIATION_BATCH_SIZE = 1000;
 const Duration WHITELIST_WATCH_INTERVAL = Seconds(5);
 const uint32_t TASK_LIMIT = 100;
 const std::string MASTER_INFO_LABEL = "info";
@@ -45,6 +52,7 @@ const std::string MASTER_INFO_JSON_LABEL = "json.info";
 const Duration ZOOKEEPER_SESSION_TIMEOUT = Seconds(10);
 const std::string DEFAULT_AUTHENTICATOR = "crammd5";
 const std::string DEFAULT_ALLOCATOR = "HierarchicalDRF";
+const std::string OPTIMISTIC_ALLOCATOR = "HierarchicalDRFOptimistic";
 const std::string DEFAULT_AUTHORIZER = "local";
 
 } // namespace master {
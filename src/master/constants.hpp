@@ -68,6 +68,18 @@ extern const Duration DEFAULT_SLAVE_PING_TIMEOUT;
 // Maximum number of ping timeouts until slave is considered failed.
 extern const size_t DEFAULT_MAX_SLAVE_PING_TIMEOUTS;
 
+// Number of time slots the slaves are spread over for pinging, i.e.,
+// the slave observer wakes up this many times per slave ping timeout
+// and pings the slaves of one slot at a time.
+extern const size_t SLAVE_PING_SLOTS;
+
+// Window of the ping latencies recorded for each slave.
+extern const Duration SLAVE_PING_LATENCY_WINDOW;
+
+// Default maximum amount of events that are buffered for an HTTP
+// framework that does not keep up with reading them.
+extern const Bytes DEFAULT_MAX_HTTP_FRAMEWORK_BUFFER_SIZE;
+
 // The minimum timeout that can be used by a newly elected leader to
 // allow re-registration of slaves. Any slaves that do not re-register
 // within this timeout will be shutdown.
@@ -95,6 +107,23 @@ extern const uint32_t MAX_COMPLETED_FRAMEWORKS;
 // cache.  TODO(thomasm): Make configurable.
 extern const uint32_t MAX_COMPLETED_TASKS_PER_FRAMEWORK;
 
+// Maximum number of traces of answered or removed offers to keep,
+// see the '/offer-traces' endpoint.
+extern const uint32_t MAX_OFFER_TRACES;
+
+// Maximum number of rendered '/state' and '/state-summary' responses
+// that the master keeps, i.e., of distinct queries of these endpoints,
+// when '--state_cache_ttl' is set.
+extern const size_t MAX_STATE_CACHE_RESPONSES;
+
+// Maximum number of tasks of an ACCEPT call that are validated in a
+// single batch off the master actor.
+extern const size_t TASK_VALIDATION_BATCH_SIZE;
+
+// Maximum number of task statuses that the master sends to a
+// framework in a single reconciliation result.
+extern const size_t RECONCILIATION_BATCH_SIZE;
+
 // Time interval to check for updated watchers list.
 extern const Duration WHITELIST_WATCH_INTERVAL;
 
@@ -125,6 +154,11 @@ extern const std::string DEFAULT_AUTHENTICATOR;
 // Name of the default, HierarchicalDRF authenticator.
 extern const std::string DEFAULT_ALLOCATOR;
 
+// Name of the HierarchicalDRF allocator that offers the same resources
+// to several frameworks at once. The master resolves the conflicts
+// between the resulting offers when one of them is accepted.
+extern const std::string OPTIMISTIC_ALLOCATOR;
+
 // Name of the default, local authorizer.
 extern const std::string DEFAULT_AUTHORIZER;
 
@@ -310,13 +310,12 @@ Future<Option<MasterInfo> > StandaloneMasterDetector::detect(
 
 
 // TODO(benh): Get ZooKeeper timeout from configuration.
+// The detectors of a process, e.g., of the frameworks of a scheduler,
+// share a ZooKeeper session and the memberships cached by its group.
 ZooKeeperMasterDetectorProcess::ZooKeeperMasterDetectorProcess(
     const zookeeper::URL& url)
   : ZooKeeperMasterDetectorProcess(Owned<Group>(
-    new Group(url.servers,
-              MASTER_DETECTOR_ZK_SESSION_TIMEOUT,
-              url.path,
-              url.authentication))) {}
+    Group::shared(url, MASTER_DETECTOR_ZK_SESSION_TIMEOUT))) {}
 
 
 ZooKeeperMasterDetectorProcess::ZooKeeperMasterDetectorProcess(
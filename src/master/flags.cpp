@@ -101,6 +101,33 @@ mesos::internal::master::Flags::Flags()
       "after which the operation is considered a failure.",
       Seconds(5));
 
+  add(&Flags::registry_max_deltas,
+      "registry_max_deltas",
+      "Maximum number of changes of the registry to store as deltas,\n"
+      "rather than storing the whole registry on every change. After\n"
+      "this many deltas the whole registry is stored again and the\n"
+      "deltas are removed. Masters recover the registry from the last\n"
+      "whole registry and the deltas after it, so all masters need to\n"
+      "support deltas before this is enabled. 0 disables deltas.",
+      0);
+
+  add(&Flags::registry_standby_interval,
+      "registry_standby_interval",
+      "If set, the interval at which masters that are not leading read\n"
+      "the registry that the leading master stores, without interfering\n"
+      "with it. This keeps the log read and the registry parsed, so that\n"
+      "a master that gets elected only reads the changes since then.\n"
+      "Only the 'replicated_log' registry reads the registry like this.");
+
+  add(&Flags::registry_compress,
+      "registry_compress",
+      "Whether to compress the registry in the replicated log, which\n"
+      "makes for smaller writes to the replicas and their disks. Only the\n"
+      "'replicated_log' registry compresses the registry. Masters need\n"
+      "to support compression to recover such a registry, so all masters\n"
+      "need to support it before this is enabled.",
+      false);
+
   add(&Flags::log_auto_initialize,
       "log_auto_initialize",
       "Whether to automatically initialize the replicated log used for the\n"
@@ -376,11 +403,35 @@ mesos::internal::master::Flags::Flags()
       "load an alternate authenticator module using --modules.",
       DEFAULT_AUTHENTICATOR);
 
+  add(&Flags::authentication_session_ttl,
+      "authentication_session_ttl",
+      "If set, the default '" + DEFAULT_AUTHENTICATOR + "' authenticator\n"
+      "issues a session ticket to each framework or slave it authenticates,\n"
+      "which is valid for the given duration (e.g., '1hrs'). The next\n"
+      "authentication of the framework or slave, with any master with the\n"
+      "same credentials, resumes the session by answering a fresh challenge\n"
+      "with a key derived from the ticket and its secret, instead of going\n"
+      "through a full CRAM-MD5 exchange, e.g., when they all reconnect\n"
+      "after a master failover.");
+
+  add(&Flags::max_concurrent_authentications,
+      "max_concurrent_authentications",
+      "The maximum number of frameworks and slaves the master authenticates\n"
+      "at once. Further authentication requests wait, in order, for one of\n"
+      "the ongoing authentications to finish. Unbounded if not set.");
+
   add(&Flags::allocator,
       "allocator",
       "Allocator to use for resource allocation to frameworks.\n"
-      "Use the default '" + DEFAULT_ALLOCATOR + "' allocator, or\n"
-      "load an alternate allocator module using --modules.",
+      "Use the default '" + DEFAULT_ALLOCATOR + "' allocator, which offers\n"
+      "the slaves in random order, 'HierarchicalDRFPack', which offers\n"
+      "the slaves with the fewest available resources first,\n"
+      "'HierarchicalDRFMostAvailable', which offers the slaves with the\n"
+      "most available resources first, '" + OPTIMISTIC_ALLOCATOR + "',\n"
+      "which offers the resources of each slave to up to 3 frameworks at\n"
+      "once (the first framework to accept them wins, and the overlapping\n"
+      "offers of the others are rescinded), or load an alternate\n"
+      "allocator module using --modules.",
       DEFAULT_ALLOCATOR);
 
   add(&Flags::hooks,
@@ -388,6 +439,14 @@ mesos::internal::master::Flags::Flags()
       "A comma-separated list of hook modules to be\n"
       "installed inside master.");
 
+  add(&Flags::hook_timeout,
+      "hook_timeout",
+      "The maximum amount of time to wait for each hook module on the\n"
+      "hooks that the master invokes asynchronously (e.g., the label\n"
+      "decorator of the launched tasks). The result of a hook module that\n"
+      "does not return in time is ignored.",
+      Seconds(5));
+
   add(&Flags::slave_ping_timeout,
       "slave_ping_timeout",
       "The timeout within which each slave is expected to respond to a\n"
@@ -419,6 +478,39 @@ mesos::internal::master::Flags::Flags()
         return None();
       });
 
+  add(&Flags::max_http_framework_buffer_size,
+      "max_http_framework_buffer_size",
+      "The maximum amount of events (e.g., 16MB) that the master buffers\n"
+      "for an HTTP framework that does not keep up with reading them.\n"
+      "Once exceeded, the master stops sending events to the framework\n"
+      "and disconnects it, i.e., the scheduler has to subscribe again.\n",
+      DEFAULT_MAX_HTTP_FRAMEWORK_BUFFER_SIZE);
+
+  add(&Flags::max_reregistering_slaves,
+      "max_reregistering_slaves",
+      "The maximum number of slaves that the master re-admits at the same\n"
+      "time after a failover, i.e., that wait for the registrar. The\n"
+      "master ignores the re-registration of other slaves meanwhile,\n"
+      "which retry it with a backoff (see '--registration_backoff_factor'\n"
+      "of the slaves). This paces the re-registration of many slaves\n"
+      "after a failover, so that the master does not hold the tasks and\n"
+      "executors of all of them at once. By default, there is no limit.",
+      [](const Option<size_t>& value) -> Option<Error> {
+        if (value.isSome() && value.get() < 1) {
+          return Error("Expected --max_reregistering_slaves to be at least 1");
+        }
+        return None();
+      });
+
+  add(&Flags::state_cache_ttl,
+      "state_cache_ttl",
+      "Duration (e.g., 2secs) for which the master serves a rendered\n"
+      "response of '/state' or '/state-summary' again, for the same\n"
+      "query, rather than rendering it for each request. This keeps\n"
+      "frequent polling of these endpoints from delaying the master, in\n"
+      "exchange for responses that are this much out of date.\n"
+      "By default, each request renders a new response.");
+
 
   add(&Flags::authorizers,
       "authorizers",
@@ -19,6 +19,7 @@
 
 #include <string>
 
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 #include <stout/option.hpp>
 #include <stout/path.hpp>
@@ -52,6 +53,9 @@ public:
   bool registry_strict;
   Duration registry_fetch_timeout;
   Duration registry_store_timeout;
+  size_t registry_max_deltas;
+  Option<Duration> registry_standby_interval;
+  bool registry_compress;
   bool log_auto_initialize;
   Duration slave_reregister_timeout;
   std::string recovery_slave_removal_limit;
@@ -73,10 +77,16 @@ public:
   Option<Duration> offer_timeout;
   Option<Modules> modules;
   std::string authenticators;
+  Option<Duration> authentication_session_ttl;
+  Option<size_t> max_concurrent_authentications;
   std::string allocator;
   Option<std::string> hooks;
+  Duration hook_timeout;
   Duration slave_ping_timeout;
   size_t max_slave_ping_timeouts;
+  Bytes max_http_framework_buffer_size;
+  Option<size_t> max_reregistering_slaves;
+  Option<Duration> state_cache_ttl;
   std::string authorizers;
 
 #ifdef WITH_NETWORK_ISOLATOR
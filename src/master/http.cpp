@@ -14,6 +14,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <functional>
 #include <iomanip>
 #include <map>
 #include <memory>
@@ -31,12 +33,14 @@
 
 #include <mesos/maintenance/maintenance.hpp>
 
+#include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/help.hpp>
 
 #include <process/metrics/metrics.hpp>
 
 #include <stout/base64.hpp>
+#include <stout/flat_hashmap.hpp>
 #include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
@@ -47,6 +51,7 @@
 #include <stout/numify.hpp>
 #include <stout/os.hpp>
 #include <stout/protobuf.hpp>
+#include <stout/recordio.hpp>
 #include <stout/result.hpp>
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
@@ -54,6 +59,7 @@
 
 #include "common/build.hpp"
 #include "common/http.hpp"
+#include "common/memory_usage.hpp"
 #include "common/protobuf_utils.hpp"
 
 #include "internal/devolve.hpp"
@@ -70,7 +76,9 @@
 
 using google::protobuf::RepeatedPtrField;
 
+using process::await;
 using process::Clock;
+using process::collect;
 using process::DESCRIPTION;
 using process::Future;
 using process::HELP;
@@ -84,6 +92,7 @@ using process::http::InternalServerError;
 using process::http::MethodNotAllowed;
 using process::http::NotFound;
 using process::http::NotImplemented;
+using process::http::NotModified;
 using process::http::NotAcceptable;
 using process::http::OK;
 using process::http::Pipe;
@@ -218,8 +227,9 @@ JSON::Object model(const Framework& framework)
     JSON::Array array;
     array.values.reserve(framework.completedTasks.size()); // MESOS-2353.
 
-    foreach (const std::shared_ptr<Task>& task, framework.completedTasks) {
-      array.values.push_back(model(*task));
+    foreach (const std::shared_ptr<const CompletedTask>& task,
+             framework.completedTasks) {
+      array.values.push_back(model(task->task()));
     }
 
     object.values["completed_tasks"] = std::move(array);
@@ -249,8 +259,9 @@ JSON::Object model(const Framework& framework)
     foreachpair (const SlaveID& slaveId,
                  const auto& executorsMap,
                  framework.executors) {
-      foreachvalue (const ExecutorInfo& executor, executorsMap) {
-        JSON::Object executorJson = model(executor);
+      foreachvalue (const std::shared_ptr<const ExecutorInfo>& executor,
+                    executorsMap) {
+        JSON::Object executorJson = model(*executor);
         executorJson.values["slave_id"] = slaveId.value();
         executors.values.push_back(executorJson);
       }
@@ -306,6 +317,31 @@ JSON::Object model(const Slave& slave)
 }
 
 
+// Writes the same JSON as 'model' for a Slave.
+void json(JSON::ObjectWriter* writer, const Slave& slave)
+{
+  writer->field("id", slave.id.value());
+  writer->field("pid", string(slave.pid));
+  writer->field("hostname", slave.info.hostname());
+  writer->field("registered_time", slave.registeredTime.secs());
+
+  if (slave.reregisteredTime.isSome()) {
+    writer->field("reregistered_time", slave.reregisteredTime.get().secs());
+  }
+
+  const Resources& totalResources = slave.totalResources;
+  writer->field("resources", totalResources);
+  writer->field("used_resources", Resources::sum(slave.usedResources));
+  writer->field("offered_resources", slave.offeredResources);
+  writer->field("reserved_resources", totalResources.reserved());
+  writer->field("unreserved_resources", totalResources.unreserved());
+
+  writer->field("attributes", Attributes(slave.info.attributes()));
+  writer->field("active", slave.active);
+  writer->field("version", slave.version);
+}
+
+
 // Returns a JSON object modeled after a Role.
 JSON::Object model(const Role& role)
 {
@@ -328,6 +364,171 @@ JSON::Object model(const Role& role)
 }
 
 
+// Writes the same JSON as 'model' for a Framework.
+void json(JSON::ObjectWriter* writer, const Framework& framework)
+{
+  writer->field("id", framework.id().value());
+  writer->field("name", framework.info.name());
+
+  // Omit pid for http frameworks.
+  if (framework.pid.isSome()) {
+    writer->field("pid", string(framework.pid.get()));
+  }
+
+  writer->field("used_resources", framework.totalUsedResources);
+  writer->field("offered_resources", framework.totalOfferedResources);
+
+  writer->field("capabilities", [&framework](JSON::ArrayWriter* writer) {
+    foreach (const FrameworkInfo::Capability& capability,
+             framework.info.capabilities()) {
+      writer->element(FrameworkInfo::Capability::Type_Name(capability.type()));
+    }
+  });
+
+  writer->field("hostname", framework.info.hostname());
+  writer->field("webui_url", framework.info.webui_url());
+  writer->field("active", framework.active);
+  writer->field("user", framework.info.user());
+  writer->field("failover_timeout", framework.info.failover_timeout());
+  writer->field("checkpoint", framework.info.checkpoint());
+  writer->field("role", framework.info.role());
+  writer->field("registered_time", framework.registeredTime.secs());
+  writer->field("unregistered_time", framework.unregisteredTime.secs());
+
+  if (framework.info.has_principal()) {
+    writer->field("principal", framework.info.principal());
+  }
+
+  writer->field(
+      "resources",
+      framework.totalUsedResources + framework.totalOfferedResources);
+
+  if (framework.registeredTime != framework.reregisteredTime) {
+    writer->field("reregistered_time", framework.reregisteredTime.secs());
+  }
+
+  writer->field("tasks", [&framework](JSON::ArrayWriter* writer) {
+    foreachvalue (const TaskInfo& task, framework.pendingTasks) {
+      writer->element([&](JSON::ObjectWriter* writer) {
+        mesos::internal::json(
+            writer, task, framework.id(), TASK_STAGING, vector<TaskStatus>());
+      });
+    }
+
+    foreachvalue (Task* task, framework.tasks) {
+      writer->element(*task);
+    }
+  });
+
+  writer->field("completed_tasks", [&framework](JSON::ArrayWriter* writer) {
+    foreach (const std::shared_ptr<const CompletedTask>& task,
+             framework.completedTasks) {
+      writer->element(task->task());
+    }
+  });
+
+  writer->field("offers", [&framework](JSON::ArrayWriter* writer) {
+    foreach (Offer* offer, framework.offers) {
+      writer->element(*offer);
+    }
+  });
+
+  writer->field("executors", [&framework](JSON::ArrayWriter* writer) {
+    foreachpair (const SlaveID& slaveId,
+                 const auto& executorsMap,
+                 framework.executors) {
+      foreachvalue (const std::shared_ptr<const ExecutorInfo>& executor,
+                    executorsMap) {
+        writer->element([&](JSON::ObjectWriter* writer) {
+          json(writer, *executor);
+          writer->field("slave_id", slaveId.value());
+        });
+      }
+    }
+  });
+
+  if (framework.info.has_labels()) {
+    writer->field("labels", framework.info.labels());
+  }
+}
+
+
+// Sets the protobuf counterparts of the fields that 'json' writes
+// for a Slave, for the protobuf responses of the endpoints.
+void operatorState(const Slave& slave, MasterOperatorState::Slave* state)
+{
+  state->mutable_info()->CopyFrom(slave.info);
+  state->set_pid(string(slave.pid));
+  state->set_registered_time(slave.registeredTime.secs());
+
+  if (slave.reregisteredTime.isSome()) {
+    state->set_reregistered_time(slave.reregisteredTime.get().secs());
+  }
+
+  state->mutable_resources()->CopyFrom(slave.totalResources);
+  state->mutable_used_resources()->CopyFrom(
+      Resources::sum(slave.usedResources));
+  state->mutable_offered_resources()->CopyFrom(slave.offeredResources);
+  state->set_active(slave.active);
+  state->set_version(slave.version);
+}
+
+
+// Sets the protobuf counterparts of the fields that 'json' writes
+// for a Framework.
+void operatorState(
+    const Framework& framework,
+    MasterOperatorState::Framework* state)
+{
+  state->mutable_info()->CopyFrom(framework.info);
+
+  if (framework.pid.isSome()) {
+    state->set_pid(string(framework.pid.get()));
+  }
+
+  state->set_active(framework.active);
+  state->set_registered_time(framework.registeredTime.secs());
+
+  if (framework.registeredTime != framework.reregisteredTime) {
+    state->set_reregistered_time(framework.reregisteredTime.secs());
+  }
+
+  state->set_unregistered_time(framework.unregisteredTime.secs());
+  state->mutable_used_resources()->CopyFrom(framework.totalUsedResources);
+  state->mutable_offered_resources()->CopyFrom(
+      framework.totalOfferedResources);
+
+  foreachvalue (const TaskInfo& task, framework.pendingTasks) {
+    state->add_tasks()->CopyFrom(
+        protobuf::createTask(task, TASK_STAGING, framework.id()));
+  }
+
+  foreachvalue (Task* task, framework.tasks) {
+    state->add_tasks()->CopyFrom(*task);
+  }
+
+  foreach (const std::shared_ptr<const CompletedTask>& task,
+           framework.completedTasks) {
+    state->add_completed_tasks()->CopyFrom(task->task());
+  }
+
+  foreach (Offer* offer, framework.offers) {
+    state->add_offers()->CopyFrom(*offer);
+  }
+
+  foreachpair (const SlaveID& slaveId,
+               const auto& executorsMap,
+               framework.executors) {
+    foreachvalue (const std::shared_ptr<const ExecutorInfo>& executor,
+                  executorsMap) {
+      MasterOperatorState::Executor* executor_ = state->add_executors();
+      executor_->mutable_slave_id()->CopyFrom(slaveId);
+      executor_->mutable_info()->CopyFrom(*executor);
+    }
+  }
+}
+
+
 void Master::Http::log(const Request& request)
 {
   Option<string> userAgent = request.headers.get("User-Agent");
@@ -399,14 +600,8 @@ Future<Response> Master::Http::scheduler(const Request& request) const
       return BadRequest("Failed to parse body into Call protobuf");
     }
   } else if (contentType.get() == APPLICATION_JSON) {
-    Try<JSON::Value> value = JSON::parse(request.body);
-
-    if (value.isError()) {
-      return BadRequest("Failed to parse body into JSON: " + value.error());
-    }
-
     Try<v1::scheduler::Call> parse =
-      ::protobuf::parse<v1::scheduler::Call>(value.get());
+      ::protobuf::parse<v1::scheduler::Call>(request.body);
 
     if (parse.isError()) {
       return BadRequest("Failed to convert JSON into Call protobuf: " +
@@ -430,11 +625,16 @@ Future<Response> Master::Http::scheduler(const Request& request) const
   }
 
   if (call.type() == scheduler::Call::SUBSCRIBE) {
-    // We default to JSON since an empty 'Accept' header
+    // We send protobuf, which is considerably cheaper for us to
+    // encode than JSON, to the schedulers that explicitly accept it
+    // (e.g., "Accept: application/x-protobuf, application/json").
+    // Otherwise we default to JSON since an empty 'Accept' header
     // results in all media types considered acceptable.
     ContentType responseContentType;
 
-    if (request.acceptsMediaType(APPLICATION_JSON)) {
+    if (acceptsProtobuf(request)) {
+      responseContentType = ContentType::PROTOBUF;
+    } else if (request.acceptsMediaType(APPLICATION_JSON)) {
       responseContentType = ContentType::JSON;
     } else if (request.acceptsMediaType(APPLICATION_PROTOBUF)) {
       responseContentType = ContentType::PROTOBUF;
@@ -444,7 +644,9 @@ Future<Response> Master::Http::scheduler(const Request& request) const
           "'" + APPLICATION_PROTOBUF + "' or '" + APPLICATION_JSON + "'");
     }
 
-    Pipe pipe;
+    // Bound the events buffered for a scheduler that doesn't keep up,
+    // see 'Framework::send'.
+    Pipe pipe(master->flags.max_http_framework_buffer_size);
     OK ok;
     ok.headers["Content-Type"] = stringify(responseContentType);
 
@@ -502,6 +704,10 @@ Future<Response> Master::Http::scheduler(const Request& request) const
       master->acknowledge(framework, call.acknowledge());
       return Accepted();
 
+    case scheduler::Call::ACKNOWLEDGEMENTS:
+      master->acknowledge(framework, call.acknowledgements());
+      return Accepted();
+
     case scheduler::Call::RECONCILE:
       master->reconcile(framework, call.reconcile());
       return Accepted();
@@ -540,8 +746,14 @@ static Resources removeDiskInfos(const Resources& resources)
 {
   Resources result = resources;
 
+  // The source of a disk is kept, the volumes are created on it.
   foreach (Resource& resource, result) {
-    resource.clear_disk();
+    if (resource.has_disk() && resource.disk().has_source()) {
+      resource.mutable_disk()->clear_persistence();
+      resource.mutable_disk()->clear_volume();
+    } else {
+      resource.clear_disk();
+    }
   }
 
   return result;
@@ -618,9 +830,9 @@ Future<Response> Master::Http::createVolumes(const Request& request) const
   // TODO(neilc): Add a create-volumes ACL for authorization.
 
   // The resources required for this operation are equivalent to the
-  // volumes specified by the user minus any DiskInfo (DiskInfo will
-  // be created when this operation is applied).
-  return _operation(slaveId, removeDiskInfos(volumes), operation);
+  // volumes specified by the user minus any DiskInfo but the source
+  // (DiskInfo will be created when this operation is applied).
+  return _operation(slaveId, removeDiskInfos(volumes), {operation});
 }
 
 
@@ -705,18 +917,45 @@ Future<Response> Master::Http::destroyVolumes(const Request& request) const
 
   // TODO(neilc): Add a destroy-volumes ACL for authorization.
 
-  return _operation(slaveId, volumes, operation);
+  return _operation(slaveId, volumes, {operation});
 }
 
 
 string Master::Http::FRAMEWORKS()
 {
-  return HELP(TLDR("Exposes the frameworks info."));
+  return HELP(
+    TLDR("Exposes the frameworks info."),
+    DESCRIPTION(
+        "Requests that accept 'application/x-protobuf' get a",
+        "serialized MasterOperatorState message instead of JSON."));
 }
 
 
 Future<Response> Master::Http::frameworks(const Request& request) const
 {
+  if (acceptsProtobuf(request)) {
+    MasterOperatorState state;
+
+    foreachvalue (Framework* framework, master->frameworks.registered) {
+      operatorState(*framework, state.add_frameworks());
+    }
+
+    foreach (const std::shared_ptr<Framework>& framework,
+             master->frameworks.completed) {
+      operatorState(*framework, state.add_completed_frameworks());
+    }
+
+    foreachvalue (const Slave* slave, master->slaves.registered) {
+      foreachkey (const FrameworkID& frameworkId, slave->tasks) {
+        if (!master->frameworks.registered.contains(frameworkId)) {
+          state.add_unregistered_frameworks()->CopyFrom(frameworkId);
+        }
+      }
+    }
+
+    return protobufResponse(state);
+  }
+
   JSON::Object object;
 
   // Model all of the frameworks.
@@ -807,10 +1046,292 @@ Future<Response> Master::Http::health(const Request& request) const
   return OK();
 }
 
+
+string Master::Http::IMAGES_HELP()
+{
+  return HELP(
+    TLDR(
+        "Pulls images on the slaves ahead of the tasks that use them."),
+    DESCRIPTION(
+        "GET returns 200 OK and a JSON object with the \"slaves\" that",
+        "pulled images, each with its \"slaveId\" and the \"pulls\" it",
+        "last reported, as returned by the '/images' endpoint of the",
+        "slave.",
+        "",
+        "POST asks the slaves to pull the images of an \"images\" value",
+        "with a JSON array of Image objects, and returns 200 OK and a JSON",
+        "object with the \"slaveIds\" of the slaves it asked. An",
+        "optional \"slaveIds\" value with a JSON array of slave IDs",
+        "restricts the request to these slaves, otherwise all connected",
+        "slaves are asked. Each slave pulls at most",
+        "--image_prefetch_max_concurrent_pulls images at the same time.",
+        "",
+        "Query parameters:",
+        "",
+        ">        jsonp=VALUE          The name of a JSONP callback."));
+}
+
+
+Future<Response> Master::Http::images(const Request& request) const
+{
+  if (request.method == "GET") {
+    JSON::Array slaves;
+
+    foreachvalue (const Slave* slave, master->slaves.registered) {
+      if (slave->imagePulls.empty()) {
+        continue;
+      }
+
+      JSON::Array pulls;
+      foreach (const ImagePull& pull, slave->imagePulls) {
+        pulls.values.push_back(JSON::protobuf(pull));
+      }
+
+      JSON::Object object;
+      object.values["slaveId"] = slave->id.value();
+      object.values["pulls"] = std::move(pulls);
+
+      slaves.values.push_back(std::move(object));
+    }
+
+    JSON::Object object;
+    object.values["slaves"] = std::move(slaves);
+
+    return OK(object, request.url.query.get("jsonp"));
+  }
+
+  if (request.method != "POST") {
+    return BadRequest("Expecting GET or POST");
+  }
+
+  Result<Credential> credential = authenticate(request);
+  if (credential.isError()) {
+    return Unauthorized("Mesos master", credential.error());
+  }
+
+  // Parse the query string in the request body.
+  Try<hashmap<string, string>> decode =
+    process::http::query::decode(request.body);
+
+  if (decode.isError()) {
+    return BadRequest("Unable to decode query string: " + decode.error());
+  }
+
+  const hashmap<string, string>& values = decode.get();
+
+  if (values.get("images").isNone()) {
+    return BadRequest("Missing 'images' query parameter");
+  }
+
+  Try<JSON::Array> parse =
+    JSON::parse<JSON::Array>(values.get("images").get());
+
+  if (parse.isError()) {
+    return BadRequest(
+        "Error in parsing 'images' query parameter: " + parse.error());
+  }
+
+  PullImagesMessage message;
+
+  foreach (const JSON::Value& value, parse.get().values) {
+    if (!value.is<JSON::Object>()) {
+      return BadRequest("Expecting objects in 'images' query parameter");
+    }
+
+    Try<Image> image = ::protobuf::parse<Image>(value);
+    if (image.isError()) {
+      return BadRequest(
+          "Error in parsing 'images' query parameter: " + image.error());
+    }
+
+    message.add_images()->CopyFrom(image.get());
+  }
+
+  vector<Slave*> slaves;
+
+  if (values.get("slaveIds").isSome()) {
+    Try<JSON::Array> ids =
+      JSON::parse<JSON::Array>(values.get("slaveIds").get());
+
+    if (ids.isError()) {
+      return BadRequest(
+          "Error in parsing 'slaveIds' query parameter: " + ids.error());
+    }
+
+    foreach (const JSON::Value& id, ids.get().values) {
+      if (!id.is<JSON::String>()) {
+        return BadRequest("Expecting strings in 'slaveIds' query parameter");
+      }
+
+      SlaveID slaveId;
+      slaveId.set_value(id.as<JSON::String>().value);
+
+      Slave* slave = master->slaves.registered.get(slaveId);
+      if (slave == NULL) {
+        return BadRequest("No slave found with ID " + slaveId.value());
+      }
+
+      slaves.push_back(slave);
+    }
+  } else {
+    foreachvalue (Slave* slave, master->slaves.registered) {
+      slaves.push_back(slave);
+    }
+  }
+
+  JSON::Array slaveIds;
+
+  foreach (Slave* slave, slaves) {
+    // The slaves that are not connected pull the images once they
+    // are asked again.
+    if (!slave->connected) {
+      continue;
+    }
+
+    master->send(slave->pid, message);
+
+    slaveIds.values.push_back(slave->id.value());
+  }
+
+  LOG(INFO) << "Asked " << slaveIds.values.size() << " slaves to pull "
+            << message.images_size() << " images";
+
+  JSON::Object object;
+  object.values["slaveIds"] = std::move(slaveIds);
+
+  return OK(object, request.url.query.get("jsonp"));
+}
+
 const static string HOSTS_KEY = "hosts";
 const static string LEVEL_KEY = "level";
 const static string MONITOR_KEY = "monitor";
 
+string Master::Http::MEMORY_HELP()
+{
+  return HELP(
+    TLDR(
+        "Reports the approximate memory used by the master."),
+    DESCRIPTION(
+        "Returns 200 OK and a JSON object with the \"count\" and",
+        "approximate \"bytes\" of the frameworks, tasks, executors,",
+        "offers and slaves that the master keeps in memory. The bytes",
+        "of an object include the protobuf messages that it keeps",
+        "(measured with 'SpaceUsed()'), but not the overhead of the",
+        "maps which index it.",
+        "",
+        "The \"executors\" count every executor on every slave, while",
+        "their bytes count each distinct ExecutorInfo once, since the",
+        "master shares identical ones. The \"http_connections\" bytes",
+        "are the events buffered for the HTTP frameworks. The object also",
+        "has the numbers of events in the \"event_queue\" of the master,",
+        "and the \"malloc\" statistics of the memory allocator, if",
+        "available.",
+        "",
+        "NOTE: The master visits all of its tasks to answer, which takes",
+        "a while when there are many of them.",
+        "",
+        "Query parameters:",
+        "",
+        ">        jsonp=VALUE          The name of a JSONP callback."));
+}
+
+
+Future<Response> Master::Http::memory(const Request& request) const
+{
+  MemoryUsage frameworks;
+  MemoryUsage completedFrameworks;
+  MemoryUsage tasks;
+  MemoryUsage pendingTasks;
+  MemoryUsage completedTasks;
+  MemoryUsage httpConnections;
+
+  foreachvalue (const Framework* framework, master->frameworks.registered) {
+    frameworks.add(framework->info, sizeof(Framework));
+
+    foreachvalue (const TaskInfo& task, framework->pendingTasks) {
+      pendingTasks.add(task);
+    }
+
+    foreachvalue (const Task* task, framework->tasks) {
+      tasks.add(*task);
+    }
+
+    foreach (const std::shared_ptr<const CompletedTask>& task,
+             framework->completedTasks) {
+      completedTasks.add(task->bytes());
+    }
+
+    if (framework->http.isSome()) {
+      httpConnections.add(framework->http.get().writer.buffered());
+    }
+  }
+
+  foreach (const std::shared_ptr<Framework>& framework,
+           master->frameworks.completed) {
+    completedFrameworks.add(framework->info, sizeof(Framework));
+
+    foreach (const std::shared_ptr<const CompletedTask>& task,
+             framework->completedTasks) {
+      completedTasks.add(task->bytes());
+    }
+  }
+
+  MemoryUsage slaves;
+  MemoryUsage executors;
+
+  // The ExecutorInfos are shared, so we count the bytes of each
+  // distinct one once.
+  hashset<const ExecutorInfo*> executorInfos;
+
+  foreachvalue (const Slave* slave, master->slaves.registered) {
+    slaves.add(slave->info, sizeof(Slave));
+
+    foreachvalue (const auto& executorsMap, slave->executors) {
+      foreachvalue (const std::shared_ptr<const ExecutorInfo>& executor,
+                    executorsMap) {
+        if (executorInfos.contains(executor.get())) {
+          ++executors.count;
+        } else {
+          executorInfos.insert(executor.get());
+          executors.add(*executor);
+        }
+      }
+    }
+  }
+
+  MemoryUsage offers;
+  foreachvalue (const Offer* offer, master->offers) {
+    offers.add(*offer);
+  }
+
+  MemoryUsage inverseOffers;
+  foreachvalue (const InverseOffer* inverseOffer, master->inverseOffers) {
+    inverseOffers.add(*inverseOffer);
+  }
+
+  JSON::Object eventQueue;
+  eventQueue.values["messages"] = master->_event_queue_messages();
+  eventQueue.values["dispatches"] = master->_event_queue_dispatches();
+  eventQueue.values["http_requests"] = master->_event_queue_http_requests();
+
+  JSON::Object object;
+  object.values["frameworks"] = model(frameworks);
+  object.values["completed_frameworks"] = model(completedFrameworks);
+  object.values["tasks"] = model(tasks);
+  object.values["pending_tasks"] = model(pendingTasks);
+  object.values["completed_tasks"] = model(completedTasks);
+  object.values["executors"] = model(executors);
+  object.values["offers"] = model(offers);
+  object.values["inverse_offers"] = model(inverseOffers);
+  object.values["slaves"] = model(slaves);
+  object.values["http_connections"] = model(httpConnections);
+  object.values["event_queue"] = std::move(eventQueue);
+  object.values["malloc"] = mallocStatistics();
+
+  return OK(object, request.url.query.get("jsonp"));
+}
+
+
 string Master::Http::OBSERVE_HELP()
 {
   return HELP(
@@ -856,50 +1377,363 @@ Future<Response> Master::Http::observe(const Request& request) const
   Try<hashmap<string, string>> decode =
     process::http::query::decode(request.body);
 
-  if (decode.isError()) {
-    return BadRequest("Unable to decode query string: " + decode.error());
-  }
+  if (decode.isError()) {
+    return BadRequest("Unable to decode query string: " + decode.error());
+  }
+
+  hashmap<string, string> values = decode.get();
+
+  // Build up a JSON object of the values we received and send them back
+  // down the wire as JSON for validation / confirmation.
+  JSON::Object response;
+
+  // TODO(ccarson):  As soon as RepairCoordinator is introduced it will
+  // consume these values. We should revisit if we still want to send the
+  // JSON down the wire at that point.
+
+  // Add 'monitor'.
+  Try<string> monitor = getFormValue(MONITOR_KEY, values);
+  if (monitor.isError()) {
+    return BadRequest(monitor.error());
+  }
+  response.values[MONITOR_KEY] = monitor.get();
+
+  // Add 'hosts'.
+  Try<string> hostsString = getFormValue(HOSTS_KEY, values);
+  if (hostsString.isError()) {
+    return BadRequest(hostsString.error());
+  }
+
+  vector<string> hosts = strings::split(hostsString.get(), ",");
+  JSON::Array hostArray;
+  hostArray.values.assign(hosts.begin(), hosts.end());
+
+  response.values[HOSTS_KEY] = hostArray;
+
+  // Add 'isHealthy'.
+  Try<string> level = getFormValue(LEVEL_KEY, values);
+  if (level.isError()) {
+    return BadRequest(level.error());
+  }
+
+  bool isHealthy = strings::upper(level.get()) == "OK";
+
+  response.values["isHealthy"] = isHealthy;
+
+  return OK(response);
+}
+
+
+string Master::Http::OFFER_TRACES_HELP()
+{
+  return HELP(
+    TLDR(
+        "Traces the lifecycle of the recent offers."),
+    DESCRIPTION(
+        "Returns 200 OK and a JSON object with the traces of the",
+        "\"outstanding\" offers and of the last " +
+          stringify(MAX_OFFER_TRACES) + " \"completed\" ones, i.e.,",
+        "the offers that were answered, rescinded or removed.",
+        "",
+        "A trace has the IDs of the offer, its framework and its slave,",
+        "the time at which the offer was made (\"offered\") and, once",
+        "answered, the time of the answer (\"answered\") and how long",
+        "the framework held the offer (\"hold_time_secs\"). The",
+        "\"outcome\" of a completed offer is \"ACCEPTED\",",
+        "\"DECLINED\", \"RESCINDED\" or \"REMOVED\".",
+        "",
+        "The per-framework 'offer_hold_time' and 'accept_to_running'",
+        "metrics of the master and 'time_to_offer' metrics of the",
+        "allocator summarize the lifecycle of all offers.",
+        "",
+        "Query parameters:",
+        "",
+        ">        jsonp=VALUE          The name of a JSONP callback."));
+}
+
+
+Future<Response> Master::Http::offerTraces(const Request& request) const
+{
+  auto model = [](const Master::OfferTrace& trace) {
+    JSON::Object object;
+    object.values["offer_id"] = trace.offerId.value();
+    object.values["framework_id"] = trace.frameworkId.value();
+    object.values["slave_id"] = trace.slaveId.value();
+    object.values["offered"] = trace.offered.secs();
+
+    if (trace.answered.isSome()) {
+      object.values["answered"] = trace.answered.get().secs();
+      object.values["hold_time_secs"] =
+        (trace.answered.get() - trace.offered).secs();
+    }
+
+    if (trace.outcome.isSome()) {
+      object.values["outcome"] = trace.outcome.get();
+    }
+
+    return object;
+  };
+
+  JSON::Array outstanding;
+  foreachvalue (const std::shared_ptr<Master::OfferTrace>& trace,
+                master->offerTraces.outstanding) {
+    outstanding.values.push_back(model(*trace));
+  }
+
+  JSON::Array completed;
+  foreach (const std::shared_ptr<const Master::OfferTrace>& trace,
+           master->offerTraces.completed) {
+    completed.values.push_back(model(*trace));
+  }
+
+  JSON::Object object;
+  object.values["outstanding"] = std::move(outstanding);
+  object.values["completed"] = std::move(completed);
+
+  return OK(object, request.url.query.get("jsonp"));
+}
+
+
+string Master::Http::OPERATIONS_HELP()
+{
+  return HELP(
+    TLDR(
+        "Applies reservation and persistent volume operations in bulk."),
+    DESCRIPTION(
+        "Returns 200 OK and the outcome of the operations on each slave.",
+        "Please provide an \"operations\" value with a JSON array of",
+        "objects, each with a \"slaveId\" and an \"operation\", an",
+        "Offer::Operation of type RESERVE, UNRESERVE, CREATE or DESTROY.",
+        "",
+        "The operations are validated against the state of the slaves",
+        "and the operations before them in the array, and authorized,",
+        "first; the request fails as a whole if any of them is invalid",
+        "or not authorized. The operations on a slave are then applied",
+        "in order, all together or not at all, after rescinding the",
+        "offers needed to cover them, and the outcome on each slave is",
+        "reported as an object with its \"slaveId\", the \"code\" of",
+        "the response /reserve et al. would have returned and a",
+        "\"message\" if the operations were not applied."));
+}
+
+
+Future<Response> Master::Http::operations(const Request& request) const
+{
+  if (request.method != "POST") {
+    return BadRequest("Expecting POST");
+  }
+
+  Result<Credential> credential = authenticate(request);
+  if (credential.isError()) {
+    return Unauthorized("Mesos master", credential.error());
+  }
+
+  // Parse the query string in the request body.
+  Try<hashmap<string, string>> decode =
+    process::http::query::decode(request.body);
+
+  if (decode.isError()) {
+    return BadRequest("Unable to decode query string: " + decode.error());
+  }
+
+  const hashmap<string, string>& values = decode.get();
+
+  if (values.get("operations").isNone()) {
+    return BadRequest("Missing 'operations' query parameter");
+  }
+
+  Try<JSON::Array> parse =
+    JSON::parse<JSON::Array>(values.get("operations").get());
+
+  if (parse.isError()) {
+    return BadRequest(
+        "Error in parsing 'operations' query parameter: " + parse.error());
+  }
+
+  Option<string> principal =
+    credential.isSome() ? credential.get().principal() : Option<string>::none();
+
+  // The operations, and the resources they require, of each slave,
+  // in the order in which the slaves first appear in the request.
+  struct Batch
+  {
+    SlaveID slaveId;
+    Resources required;
+    vector<Offer::Operation> operations;
+
+    // The checkpointed resources of the slave once the operations
+    // before the next one have been applied, for validation.
+    Resources checkpointed;
+  };
+
+  vector<Batch> batches;
+  hashmap<SlaveID, size_t> indices;
+
+  list<Future<bool>> authorizations;
+
+  foreach (const JSON::Value& value, parse.get().values) {
+    if (!value.is<JSON::Object>()) {
+      return BadRequest("Expecting objects in 'operations' query parameter");
+    }
+
+    const JSON::Object& object = value.as<JSON::Object>();
+
+    Result<JSON::String> id = object.find<JSON::String>("slaveId");
+    if (!id.isSome()) {
+      return BadRequest("Missing 'slaveId' in 'operations' query parameter");
+    }
+
+    Result<JSON::Object> json = object.find<JSON::Object>("operation");
+    if (!json.isSome()) {
+      return BadRequest(
+          "Missing 'operation' in 'operations' query parameter");
+    }
+
+    Try<Offer::Operation> operation =
+      ::protobuf::parse<Offer::Operation>(json.get());
+
+    if (operation.isError()) {
+      return BadRequest(
+          "Error in parsing 'operations' query parameter: " +
+          operation.error());
+    }
+
+    SlaveID slaveId;
+    slaveId.set_value(id.get().value);
+
+    Slave* slave = master->slaves.registered.get(slaveId);
+    if (slave == NULL) {
+      return BadRequest("No slave found with ID " + slaveId.value());
+    }
+
+    if (!indices.contains(slaveId)) {
+      indices[slaveId] = batches.size();
+      batches.push_back(
+          Batch{slaveId, Resources(), {}, slave->checkpointedResources});
+    }
+
+    Batch& batch = batches[indices[slaveId]];
+
+    Option<Error> error = None();
+
+    switch (operation.get().type()) {
+      case Offer::Operation::RESERVE: {
+        const Resources resources = operation.get().reserve().resources();
+
+        error = validation::operation::validate(
+            operation.get().reserve(), None(), principal);
+
+        if (error.isNone()) {
+          authorizations.push_back(master->authorizeReserveResources(
+              operation.get().reserve(), principal));
+
+          // NOTE: See '/reserve' for why `flatten()` is important.
+          batch.required += resources.flatten();
+          batch.checkpointed += resources;
+        }
+        break;
+      }
+
+      case Offer::Operation::UNRESERVE: {
+        const Resources resources = operation.get().unreserve().resources();
+
+        error = validation::operation::validate(
+            operation.get().unreserve(), principal.isSome());
+
+        if (error.isNone()) {
+          authorizations.push_back(master->authorizeUnreserveResources(
+              operation.get().unreserve(), principal));
+
+          batch.required += resources;
+          batch.checkpointed -= resources;
+        }
+        break;
+      }
+
+      case Offer::Operation::CREATE: {
+        const Resources volumes = operation.get().create().volumes();
+
+        error = validation::operation::validate(
+            operation.get().create(), batch.checkpointed);
+
+        if (error.isNone()) {
+          // See '/create-volumes' for why the DiskInfos are removed.
+          batch.required += removeDiskInfos(volumes);
+          batch.checkpointed += volumes;
+        }
+        break;
+      }
+
+      case Offer::Operation::DESTROY: {
+        const Resources volumes = operation.get().destroy().volumes();
+
+        error = validation::operation::validate(
+            operation.get().destroy(), batch.checkpointed);
 
-  hashmap<string, string> values = decode.get();
+        if (error.isNone()) {
+          batch.required += volumes;
+          batch.checkpointed -= volumes;
+        }
+        break;
+      }
 
-  // Build up a JSON object of the values we received and send them back
-  // down the wire as JSON for validation / confirmation.
-  JSON::Object response;
+      default:
+        return BadRequest(
+            "Unsupported " + Offer::Operation::Type_Name(
+                operation.get().type()) + " operation");
+    }
 
-  // TODO(ccarson):  As soon as RepairCoordinator is introduced it will
-  // consume these values. We should revisit if we still want to send the
-  // JSON down the wire at that point.
+    if (error.isSome()) {
+      return BadRequest(
+          "Invalid " + Offer::Operation::Type_Name(operation.get().type()) +
+          " operation: " + error.get().message);
+    }
 
-  // Add 'monitor'.
-  Try<string> monitor = getFormValue(MONITOR_KEY, values);
-  if (monitor.isError()) {
-    return BadRequest(monitor.error());
+    batch.operations.push_back(operation.get());
   }
-  response.values[MONITOR_KEY] = monitor.get();
 
-  // Add 'hosts'.
-  Try<string> hostsString = getFormValue(HOSTS_KEY, values);
-  if (hostsString.isError()) {
-    return BadRequest(hostsString.error());
-  }
+  return collect(authorizations)
+    .then(defer(master->self(), [=](const list<bool>& authorized)
+        -> Future<Response> {
+      foreach (bool authorized_, authorized) {
+        if (!authorized_) {
+          return Unauthorized("Mesos master");
+        }
+      }
 
-  vector<string> hosts = strings::split(hostsString.get(), ",");
-  JSON::Array hostArray;
-  hostArray.values.assign(hosts.begin(), hosts.end());
+      // Offers are rescinded, and the allocator updated, once per
+      // slave rather than once per operation.
+      list<Future<Response>> responses;
+      foreach (const Batch& batch, batches) {
+        responses.push_back(
+            _operation(batch.slaveId, batch.required, batch.operations));
+      }
 
-  response.values[HOSTS_KEY] = hostArray;
+      return await(responses)
+        .then([batches](const list<Future<Response>>& responses)
+            -> Response {
+          JSON::Array array;
 
-  // Add 'isHealthy'.
-  Try<string> level = getFormValue(LEVEL_KEY, values);
-  if (level.isError()) {
-    return BadRequest(level.error());
-  }
+          auto batch = batches.begin();
+          foreach (const Future<Response>& response, responses) {
+            // NOTE: '_operation' repairs its failures into responses.
+            CHECK_READY(response);
 
-  bool isHealthy = strings::upper(level.get()) == "OK";
+            JSON::Object object;
+            object.values["slaveId"] = batch->slaveId.value();
+            object.values["code"] = response.get().code;
 
-  response.values["isHealthy"] = isHealthy;
+            if (response.get().code != process::http::Status::OK) {
+              object.values["message"] = response.get().body;
+            }
 
-  return OK(response);
+            array.values.push_back(object);
+            ++batch;
+          }
+
+          return OK(array);
+        });
+    }));
 }
 
 
@@ -1042,7 +1876,7 @@ Future<Response> Master::Http::reserve(const Request& request) const
       // we want to ensure that the required resources are available
       // and unreserved; `flatten()` removes the role and
       // ReservationInfo from the resources.
-      return _operation(slaveId, resources.flatten(), operation);
+      return _operation(slaveId, resources.flatten(), {operation});
     }));
 }
 
@@ -1054,12 +1888,25 @@ string Master::Http::SLAVES_HELP()
         "Information about registered slaves."),
     DESCRIPTION(
         "This endpoint shows information about the slaves registered in",
-        "this master formatted as a JSON object."));
+        "this master formatted as a JSON object.",
+        "",
+        "Requests that accept 'application/x-protobuf' get a",
+        "serialized MasterOperatorState message instead."));
 }
 
 
 Future<Response> Master::Http::slaves(const Request& request) const
 {
+  if (acceptsProtobuf(request)) {
+    MasterOperatorState state;
+
+    foreachvalue (const Slave* slave, master->slaves.registered) {
+      operatorState(*slave, state.add_slaves());
+    }
+
+    return protobufResponse(state);
+  }
+
   JSON::Object object;
 
   {
@@ -1118,145 +1965,191 @@ string Master::Http::STATE_HELP()
         "Information about state of master."),
     DESCRIPTION(
         "This endpoint shows information about the frameworks, tasks,",
-        "executors and slaves running in the cluster as a JSON object."));
+        "executors and slaves running in the cluster as a JSON object.",
+        "",
+        "Requests that accept 'application/x-protobuf' get a",
+        "serialized MasterOperatorState message instead."));
 }
 
 
 Future<Response> Master::Http::state(const Request& request) const
 {
-  JSON::Object object;
-  object.values["version"] = MESOS_VERSION;
-
-  if (build::GIT_SHA.isSome()) {
-    object.values["git_sha"] = build::GIT_SHA.get();
-  }
+  return cached(request, &Http::_state);
+}
 
-  if (build::GIT_BRANCH.isSome()) {
-    object.values["git_branch"] = build::GIT_BRANCH.get();
-  }
 
-  if (build::GIT_TAG.isSome()) {
-    object.values["git_tag"] = build::GIT_TAG.get();
-  }
+Response Master::Http::_state(const Request& request) const
+{
+  if (acceptsProtobuf(request)) {
+    MasterOperatorState state;
+    state.set_version(MESOS_VERSION);
+    state.set_id(master->info().id());
+    state.set_pid(string(master->self()));
+    state.set_hostname(master->info().hostname());
+    state.set_start_time(master->startTime.secs());
+
+    if (master->electedTime.isSome()) {
+      state.set_elected_time(master->electedTime.get().secs());
+    }
 
-  object.values["build_date"] = build::DATE;
-  object.values["build_time"] = build::TIME;
-  object.values["build_user"] = build::USER;
-  object.values["start_time"] = master->startTime.secs();
+    if (master->leader.isSome()) {
+      state.set_leader(master->leader.get().pid());
+    }
 
-  if (master->electedTime.isSome()) {
-    object.values["elected_time"] = master->electedTime.get().secs();
-  }
+    foreachpair (const string& name, const flags::Flag& flag, master->flags) {
+      Option<string> value = flag.stringify(master->flags);
+      if (value.isSome()) {
+        Parameter* parameter = state.add_flags();
+        parameter->set_key(name);
+        parameter->set_value(value.get());
+      }
+    }
 
-  object.values["id"] = master->info().id();
-  object.values["pid"] = string(master->self());
-  object.values["hostname"] = master->info().hostname();
-  object.values["activated_slaves"] = master->_slaves_active();
-  object.values["deactivated_slaves"] = master->_slaves_inactive();
+    foreachvalue (const Slave* slave, master->slaves.registered) {
+      operatorState(*slave, state.add_slaves());
+    }
 
-  if (master->flags.cluster.isSome()) {
-    object.values["cluster"] = master->flags.cluster.get();
-  }
+    foreachvalue (Framework* framework, master->frameworks.registered) {
+      operatorState(*framework, state.add_frameworks());
+    }
 
-  if (master->leader.isSome()) {
-    object.values["leader"] = master->leader.get().pid();
-  }
+    foreach (const std::shared_ptr<Framework>& framework,
+             master->frameworks.completed) {
+      operatorState(*framework, state.add_completed_frameworks());
+    }
 
-  if (master->flags.log_dir.isSome()) {
-    object.values["log_dir"] = master->flags.log_dir.get();
-  }
+    foreachvalue (const Slave* slave, master->slaves.registered) {
+      typedef hashmap<TaskID, Task*> TaskMap;
+      foreachpair (const FrameworkID& frameworkId,
+                   const TaskMap& tasks,
+                   slave->tasks) {
+        if (master->frameworks.registered.contains(frameworkId)) {
+          continue;
+        }
 
-  if (master->flags.external_log_file.isSome()) {
-    object.values["external_log_file"] = master->flags.external_log_file.get();
-  }
+        state.add_unregistered_frameworks()->CopyFrom(frameworkId);
 
-  {
-    JSON::Object flags;
-    foreachpair (const string& name, const flags::Flag& flag, master->flags) {
-      Option<string> value = flag.stringify(master->flags);
-      if (value.isSome()) {
-        flags.values[name] = value.get();
+        foreachvalue (const Task* task, tasks) {
+          state.add_orphan_tasks()->CopyFrom(*task);
+        }
       }
     }
-    object.values["flags"] = std::move(flags);
+
+    return protobufResponse(state);
   }
 
-  // Model all of the slaves.
-  {
-    JSON::Array array;
-    array.values.reserve(master->slaves.registered.size()); // MESOS-2353.
+  // The state is written out directly rather than modeled as a
+  // JSON::Object first, since the latter gets very large (and takes
+  // a while to build and to destroy) for big clusters.
+  auto state = [this](JSON::ObjectWriter* writer) {
+    writer->field("version", MESOS_VERSION);
 
-    foreachvalue (Slave* slave, master->slaves.registered) {
-      array.values.push_back(model(*slave));
+    if (build::GIT_SHA.isSome()) {
+      writer->field("git_sha", build::GIT_SHA.get());
     }
 
-    object.values["slaves"] = std::move(array);
-  }
+    if (build::GIT_BRANCH.isSome()) {
+      writer->field("git_branch", build::GIT_BRANCH.get());
+    }
 
-  // Model all of the frameworks.
-  {
-    JSON::Array array;
-    array.values.reserve(master->frameworks.registered.size()); // MESOS-2353.
+    if (build::GIT_TAG.isSome()) {
+      writer->field("git_tag", build::GIT_TAG.get());
+    }
 
-    foreachvalue (Framework* framework, master->frameworks.registered) {
-      array.values.push_back(model(*framework));
+    writer->field("build_date", build::DATE);
+    writer->field("build_time", build::TIME);
+    writer->field("build_user", build::USER);
+    writer->field("start_time", master->startTime.secs());
+
+    if (master->electedTime.isSome()) {
+      writer->field("elected_time", master->electedTime.get().secs());
     }
 
-    object.values["frameworks"] = std::move(array);
-  }
+    writer->field("id", master->info().id());
+    writer->field("pid", string(master->self()));
+    writer->field("hostname", master->info().hostname());
+    writer->field("activated_slaves", master->_slaves_active());
+    writer->field("deactivated_slaves", master->_slaves_inactive());
 
-  // Model all of the completed frameworks.
-  {
-    JSON::Array array;
-    array.values.reserve(master->frameworks.completed.size()); // MESOS-2353.
+    if (master->flags.cluster.isSome()) {
+      writer->field("cluster", master->flags.cluster.get());
+    }
 
-    foreach (const std::shared_ptr<Framework>& framework,
-             master->frameworks.completed) {
-      array.values.push_back(model(*framework));
+    if (master->leader.isSome()) {
+      writer->field("leader", master->leader.get().pid());
     }
 
-    object.values["completed_frameworks"] = std::move(array);
-  }
+    if (master->flags.log_dir.isSome()) {
+      writer->field("log_dir", master->flags.log_dir.get());
+    }
 
-  // Model all of the orphan tasks.
-  {
-    JSON::Array array;
+    if (master->flags.external_log_file.isSome()) {
+      writer->field("external_log_file", master->flags.external_log_file.get());
+    }
 
-    // Find those orphan tasks.
-    foreachvalue (const Slave* slave, master->slaves.registered) {
-      typedef hashmap<TaskID, Task*> TaskMap;
-      foreachvalue (const TaskMap& tasks, slave->tasks) {
-        foreachvalue (const Task* task, tasks) {
-          CHECK_NOTNULL(task);
-          if (!master->frameworks.registered.contains(task->framework_id())) {
-            array.values.push_back(model(*task));
-          }
+    writer->field("flags", [this](JSON::ObjectWriter* writer) {
+      foreachpair (const string& name, const flags::Flag& flag, master->flags) {
+        Option<string> value = flag.stringify(master->flags);
+        if (value.isSome()) {
+          writer->field(name, value.get());
         }
       }
-    }
+    });
 
-    object.values["orphan_tasks"] = std::move(array);
-  }
+    // Model all of the slaves.
+    writer->field("slaves", [this](JSON::ArrayWriter* writer) {
+      foreachvalue (Slave* slave, master->slaves.registered) {
+        writer->element(*slave);
+      }
+    });
 
-  // Model all currently unregistered frameworks.
-  // This could happen when the framework has yet to re-register
-  // after master failover.
-  {
-    JSON::Array array;
+    // Model all of the frameworks.
+    writer->field("frameworks", [this](JSON::ArrayWriter* writer) {
+      foreachvalue (Framework* framework, master->frameworks.registered) {
+        writer->element(*framework);
+      }
+    });
 
-    // Find unregistered frameworks.
-    foreachvalue (const Slave* slave, master->slaves.registered) {
-      foreachkey (const FrameworkID& frameworkId, slave->tasks) {
-        if (!master->frameworks.registered.contains(frameworkId)) {
-          array.values.push_back(frameworkId.value());
+    // Model all of the completed frameworks.
+    writer->field("completed_frameworks", [this](JSON::ArrayWriter* writer) {
+      foreach (const std::shared_ptr<Framework>& framework,
+               master->frameworks.completed) {
+        writer->element(*framework);
+      }
+    });
+
+    // Model all of the orphan tasks.
+    writer->field("orphan_tasks", [this](JSON::ArrayWriter* writer) {
+      // Find those orphan tasks.
+      foreachvalue (const Slave* slave, master->slaves.registered) {
+        typedef hashmap<TaskID, Task*> TaskMap;
+        foreachvalue (const TaskMap& tasks, slave->tasks) {
+          foreachvalue (const Task* task, tasks) {
+            CHECK_NOTNULL(task);
+            if (!master->frameworks.registered.contains(task->framework_id())) {
+              writer->element(*task);
+            }
+          }
         }
       }
-    }
+    });
 
-    object.values["unregistered_frameworks"] = std::move(array);
-  }
+    // Model all currently unregistered frameworks.
+    // This could happen when the framework has yet to re-register
+    // after master failover.
+    writer->field("unregistered_frameworks", [this](JSON::ArrayWriter* writer) {
+      // Find unregistered frameworks.
+      foreachvalue (const Slave* slave, master->slaves.registered) {
+        foreachkey (const FrameworkID& frameworkId, slave->tasks) {
+          if (!master->frameworks.registered.contains(frameworkId)) {
+            writer->element(frameworkId.value());
+          }
+        }
+      }
+    });
+  };
 
-  return OK(object, request.url.query.get("jsonp"));
+  return OK(jsonify(state), request.url.query.get("jsonp"));
 }
 
 
@@ -1267,7 +2160,8 @@ Future<Response> Master::Http::state(const Request& request) const
 class SlaveFrameworkMapping
 {
 public:
-  SlaveFrameworkMapping(const hashmap<FrameworkID, Framework*>& frameworks)
+  SlaveFrameworkMapping(
+      const flat_hashmap<FrameworkID, Framework*>& frameworks)
   {
     foreachpair (const FrameworkID& frameworkId,
                  const Framework* framework,
@@ -1282,9 +2176,10 @@ public:
         slavesToFrameworks[task->slave_id()].insert(frameworkId);
       }
 
-      foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
-        frameworksToSlaves[frameworkId].insert(task->slave_id());
-        slavesToFrameworks[task->slave_id()].insert(frameworkId);
+      foreach (const std::shared_ptr<const CompletedTask>& task,
+               framework->completedTasks) {
+        frameworksToSlaves[frameworkId].insert(task->slaveId);
+        slavesToFrameworks[task->slaveId].insert(frameworkId);
       }
     }
   }
@@ -1328,9 +2223,9 @@ struct TaskStateSummary
       error(0) {}
 
   // Account for the state of the given task.
-  void count(const Task& task)
+  void count(const TaskState& state)
   {
-    switch (task.state()) {
+    switch (state) {
       case TASK_STAGING: { ++staging; break; }
       case TASK_STARTING: { ++starting; break; }
       case TASK_RUNNING: { ++running; break; }
@@ -1365,7 +2260,8 @@ const TaskStateSummary TaskStateSummary::EMPTY;
 class TaskStateSummaries
 {
 public:
-  TaskStateSummaries(const hashmap<FrameworkID, Framework*>& frameworks)
+  TaskStateSummaries(
+      const flat_hashmap<FrameworkID, Framework*>& frameworks)
   {
     foreachpair (const FrameworkID& frameworkId,
                  const Framework* framework,
@@ -1376,13 +2272,14 @@ public:
       }
 
       foreachvalue (const Task* task, framework->tasks) {
-        frameworkTaskSummaries[frameworkId].count(*task);
-        slaveTaskSummaries[task->slave_id()].count(*task);
+        frameworkTaskSummaries[frameworkId].count(task->state());
+        slaveTaskSummaries[task->slave_id()].count(task->state());
       }
 
-      foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
-        frameworkTaskSummaries[frameworkId].count(*task);
-        slaveTaskSummaries[task->slave_id()].count(*task);
+      foreach (const std::shared_ptr<const CompletedTask>& task,
+               framework->completedTasks) {
+        frameworkTaskSummaries[frameworkId].count(task->state);
+        slaveTaskSummaries[task->slaveId].count(task->state);
       }
     }
   }
@@ -1418,6 +2315,12 @@ string Master::Http::STATESUMMARY_HELP()
 
 
 Future<Response> Master::Http::stateSummary(const Request& request) const
+{
+  return cached(request, &Http::_stateSummary);
+}
+
+
+Response Master::Http::_stateSummary(const Request& request) const
 {
   JSON::Object object;
 
@@ -1525,6 +2428,60 @@ Future<Response> Master::Http::stateSummary(const Request& request) const
 }
 
 
+string Master::Http::STATE_STREAM_HELP()
+{
+  return HELP(
+    TLDR(
+        "Stream of the state of the cluster and of its changes."),
+    DESCRIPTION(
+        "This endpoint streams \"Record-IO\" encoded JSON objects. The",
+        "first one is {\"type\": \"SNAPSHOT\", \"state\": ...}, where",
+        "\"state\" is the state as served by /state. Each of the",
+        "following ones has the \"type\" of a change, i.e.,",
+        "\"TASK_ADDED\", \"TASK_UPDATED\" or \"TASK_REMOVED\" with",
+        "the \"task\", \"SLAVE_ADDED\" or \"SLAVE_REMOVED\" with the",
+        "\"slave\", and \"FRAMEWORK_ADDED\" or \"FRAMEWORK_REMOVED\"",
+        "with the \"framework\".",
+        "",
+        "A subscriber that does not keep up with reading the changes",
+        "gets disconnected and has to subscribe again."));
+}
+
+
+Future<Response> Master::Http::stateStream(const Request& request) const
+{
+  // The snapshot is not wrapped for 'jsonp'.
+  Request snapshotRequest = request;
+  snapshotRequest.url.query.clear();
+
+  const Response snapshot = _state(snapshotRequest);
+
+  if (snapshot.code != process::http::Status::OK) {
+    return snapshot;
+  }
+
+  Pipe pipe(master->flags.max_http_framework_buffer_size);
+
+  OK ok;
+  ok.headers["Content-Type"] = APPLICATION_JSON;
+  ok.type = Response::PIPE;
+  ok.reader = pipe.reader();
+
+  // The state is already rendered, so we write the record around it
+  // rather than parsing it into a 'JSON::Object' first.
+  const string record =
+    "{\"type\":\"SNAPSHOT\",\"state\":" + snapshot.body + "}";
+
+  Pipe::Writer writer = pipe.writer();
+  writer.write(::recordio::Encoder<string>(
+      [](const string& s) { return s; }).encode(record));
+
+  master->stateStreams.push_back(writer);
+
+  return ok;
+}
+
+
 string Master::Http::ROLES_HELP()
 {
   return HELP(
@@ -1655,13 +2612,23 @@ string Master::Http::TASKS_HELP()
     DESCRIPTION(
       "Lists known tasks.",
       "",
+      "Requests that accept 'application/x-protobuf' get a serialized",
+      "MasterOperatorState message instead of JSON, which has all the",
+      "fields of the tasks.",
+      "",
       "Query parameters:",
       "",
       ">        limit=VALUE          Maximum number of tasks returned "
       "(default is " + stringify(TASK_LIMIT) + ").",
       ">        offset=VALUE         Starts task list at offset.",
       ">        order=(asc|desc)     Ascending or descending sort order "
-      "(default is descending)."
+      "(default is descending).",
+      ">        framework_id=VALUE   Only the tasks of this framework.",
+      ">        slave_id=VALUE       Only the tasks on this slave.",
+      ">        role=VALUE           Only the tasks of the frameworks of a "
+      "role.",
+      ">        fields=VALUE,...     Only these fields of each task, "
+      "e.g., 'id,state,slave_id'."
       ""));
 }
 
@@ -1722,45 +2689,119 @@ Future<Response> Master::Http::tasks(const Request& request) const
   // TODO(nnielsen): Currently, formatting errors in offset and/or limit
   // will silently be ignored. This could be reported to the user instead.
 
+  // Get the filters and the fields to return, if any.
+  Option<string> frameworkId = request.url.query.get("framework_id");
+  Option<string> slaveId = request.url.query.get("slave_id");
+  Option<string> role = request.url.query.get("role");
+
+  Option<vector<string>> fields = None();
+  if (request.url.query.contains("fields")) {
+    fields = strings::tokenize(request.url.query.get("fields").get(), ",");
+  }
+
+  auto selected = [&](const Framework* framework) {
+    return (frameworkId.isNone() ||
+            framework->id().value() == frameworkId.get()) &&
+           (role.isNone() || framework->info.role() == role.get());
+  };
+
   // Construct framework list with both active and completed frameworks.
   vector<const Framework*> frameworks;
   foreachvalue (Framework* framework, master->frameworks.registered) {
-    frameworks.push_back(framework);
+    if (selected(framework)) {
+      frameworks.push_back(framework);
+    }
   }
   foreach (const std::shared_ptr<Framework>& framework,
            master->frameworks.completed) {
-    frameworks.push_back(framework.get());
+    if (selected(framework.get())) {
+      frameworks.push_back(framework.get());
+    }
+  }
+
+  // The completed tasks are kept encoded, so we decode those that
+  // pass the filters.
+  size_t completed = 0;
+  foreach (const Framework* framework, frameworks) {
+    completed += framework->completedTasks.size();
   }
 
+  vector<Task> completedTasks;
+  completedTasks.reserve(completed); // Keeps the pointers below valid.
+
   // Construct task list with both running and finished tasks.
   vector<const Task*> tasks;
   foreach (const Framework* framework, frameworks) {
     foreachvalue (Task* task, framework->tasks) {
       CHECK_NOTNULL(task);
-      tasks.push_back(task);
+      if (slaveId.isNone() || task->slave_id().value() == slaveId.get()) {
+        tasks.push_back(task);
+      }
     }
-    foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
-      tasks.push_back(task.get());
+    foreach (const std::shared_ptr<const CompletedTask>& task,
+             framework->completedTasks) {
+      if (slaveId.isNone() || task->slaveId.value() == slaveId.get()) {
+        completedTasks.push_back(task->task());
+        tasks.push_back(&completedTasks.back());
+      }
     }
   }
 
+  // Only the tasks up to the end of the requested slice need to be
+  // sorted, which is cheaper than sorting all of them for a small one.
+  const size_t begin = std::min(offset, tasks.size());
+  const size_t end = begin + std::min(limit, tasks.size() - begin);
+
   // Sort tasks by task status timestamp. Default order is descending.
   // The earliest timestamp is chosen for comparison when multiple are present.
   Option<string> order = request.url.query.get("order");
   if (order.isSome() && (order.get() == "asc")) {
-    sort(tasks.begin(), tasks.end(), TaskComparator::ascending);
+    std::partial_sort(
+        tasks.begin(),
+        tasks.begin() + end,
+        tasks.end(),
+        TaskComparator::ascending);
   } else {
-    sort(tasks.begin(), tasks.end(), TaskComparator::descending);
+    std::partial_sort(
+        tasks.begin(),
+        tasks.begin() + end,
+        tasks.end(),
+        TaskComparator::descending);
+  }
+
+  // The 'fields' only project the JSON response.
+  if (acceptsProtobuf(request)) {
+    MasterOperatorState state;
+
+    for (size_t i = begin; i < end; i++) {
+      state.add_tasks()->CopyFrom(*tasks[i]);
+    }
+
+    return protobufResponse(state);
   }
 
   JSON::Object object;
 
   {
     JSON::Array array;
-    size_t end = std::min(offset + limit, tasks.size());
-    for (size_t i = offset; i < end; i++) {
-      const Task* task = tasks[i];
-      array.values.push_back(model(*task));
+    array.values.reserve(end - begin); // MESOS-2353.
+
+    for (size_t i = begin; i < end; i++) {
+      JSON::Object task = model(*tasks[i]);
+
+      if (fields.isSome()) {
+        JSON::Object projection;
+        foreach (const string& field, fields.get()) {
+          auto iterator = task.values.find(field);
+          if (iterator != task.values.end()) {
+            projection.values[field] = std::move(iterator->second);
+          }
+        }
+
+        task = std::move(projection);
+      }
+
+      array.values.push_back(std::move(task));
     }
 
     object.values["tasks"] = std::move(array);
@@ -1841,8 +2882,20 @@ Future<Response> Master::Http::maintenanceSchedule(const Request& request) const
 
       // TODO(josephw): allow more than one schedule.
 
-      // Put the machines in the updated schedule into a set.
-      // Save the unavailability, to help with updating some machines.
+      // Index the machines in the current and the updated schedule by
+      // their unavailability, so that only the machines that are
+      // added, removed or rescheduled are updated below, rather than
+      // every machine in every window.
+      hashmap<MachineID, Unavailability> current;
+      foreach (const mesos::maintenance::Schedule& agenda,
+               master->maintenance.schedules) {
+        foreach (const mesos::maintenance::Window& window, agenda.windows()) {
+          foreach (const MachineID& id, window.machine_ids()) {
+            current[id] = window.unavailability();
+          }
+        }
+      }
+
       hashmap<MachineID, Unavailability> updated;
       foreach (const mesos::maintenance::Window& window, schedule.windows()) {
         foreach (const MachineID& id, window.machine_ids()) {
@@ -1850,33 +2903,28 @@ Future<Response> Master::Http::maintenanceSchedule(const Request& request) const
         }
       }
 
-      // NOTE: Copies are needed because `updateUnavailability()` in this loop
-      // modifies the container.
-      foreachkey (const MachineID& id, utils::copy(master->machines)) {
-        // Update the entry for each updated machine.
-        if (updated.contains(id)) {
-          master->updateUnavailability(id, updated[id]);
-          continue;
+      // Transition each removed machine back to the `UP` mode and remove the
+      // unavailability.
+      foreachkey (const MachineID& id, current) {
+        if (!updated.contains(id)) {
+          master->machines[id].info.set_mode(MachineInfo::UP);
+          master->updateUnavailability(id, None());
         }
-
-        // Transition each removed machine back to the `UP` mode and remove the
-        // unavailability.
-        master->machines[id].info.set_mode(MachineInfo::UP);
-        master->updateUnavailability(id, None());
       }
 
-      // Save each new machine, with the unavailability
-      // and starting in `DRAINING` mode.
-      foreach (const mesos::maintenance::Window& window, schedule.windows()) {
-        foreach (const MachineID& id, window.machine_ids()) {
-          MachineInfo info;
+      // Save each new machine starting in `DRAINING` mode, and update
+      // the unavailability of the machines in the schedule, which is a
+      // no-op for those whose unavailability did not change.
+      foreachpair (const MachineID& id,
+                   const Unavailability& unavailability,
+                   updated) {
+        if (!current.contains(id)) {
+          MachineInfo& info = master->machines[id].info;
           info.mutable_id()->CopyFrom(id);
           info.set_mode(MachineInfo::DRAINING);
-
-          master->machines[id].info.CopyFrom(info);
-
-          master->updateUnavailability(id, window.unavailability());
         }
+
+        master->updateUnavailability(id, unavailability);
       }
 
       // Replace the old schedule(s) with the new schedule.
@@ -1955,15 +3003,14 @@ Future<Response> Master::Http::machineDown(const Request& request) const
       // for all the tasks that were running on the slave and `LostSlaveMessage`
       // messages to the framework. This guards against the slave having dropped
       // the `ShutdownMessage`.
+      vector<Slave*> slaves;
       foreach (const MachineID& machineId, ids.get()) {
         // The machine may not be in machines. This means no slaves are
         // currently registered on that machine so this is a no-op.
         if (master->machines.contains(machineId)) {
-          // NOTE: Copies are needed because removeSlave modifies
-          // master->machines.
           foreach (
               const SlaveID& slaveId,
-              utils::copy(master->machines[machineId].slaves)) {
+              master->machines[machineId].slaves) {
             Slave* slave = master->slaves.registered.get(slaveId);
             CHECK_NOTNULL(slave);
 
@@ -1972,14 +3019,17 @@ Future<Response> Master::Http::machineDown(const Request& request) const
             shutdownMessage.set_message("Operator initiated 'Machine DOWN'");
             master->send(slave->pid, shutdownMessage);
 
-            // Immediately remove the slave to force sending `TASK_LOST` status
-            // updates as well as `LostSlaveMessage` messages to the frameworks.
-            // See comment above.
-            master->removeSlave(slave, "Operator initiated 'Machine DOWN'");
+            slaves.push_back(slave);
           }
         }
       }
 
+      // Immediately remove the slaves to force sending `TASK_LOST` status
+      // updates as well as `LostSlaveMessage` messages to the frameworks.
+      // See comment above. The slaves of all the machines are removed at
+      // once.
+      master->removeSlaves(slaves, "Operator initiated 'Machine DOWN'");
+
       // Update the master's local state with the downed machines.
       foreach (const MachineID& id, ids.get()) {
         master->machines[id].info.set_mode(MachineInfo::DOWN);
@@ -2256,7 +3306,7 @@ Future<Response> Master::Http::unreserve(const Request& request) const
         return Unauthorized("Mesos master");
       }
 
-      return _operation(slaveId, resources, operation);
+      return _operation(slaveId, resources, {operation});
     }));
 }
 
@@ -2303,10 +3353,80 @@ Result<Credential> Master::Http::authenticate(const Request& request) const
 }
 
 
+Response Master::Http::cached(
+    const Request& request,
+    Response (Http::*render)(const Request&) const) const
+{
+  Option<string> key = None();
+  Option<RenderedResponse> rendered = None();
+
+  if (master->flags.state_cache_ttl.isSome()) {
+    // The order of the query parameters does not change the
+    // response, so we sort them for the key.
+    vector<string> query;
+    foreachpair (const string& name, const string& value, request.url.query) {
+      query.push_back(name + "=" + value);
+    }
+
+    std::sort(query.begin(), query.end());
+
+    key = request.url.path + "?" + strings::join("&", query);
+
+    // The protobuf responses are cached apart from the JSON ones.
+    if (acceptsProtobuf(request)) {
+      key = key.get() + " " + APPLICATION_PROTOBUF;
+    }
+    rendered = master->renderedResponses.get(key.get());
+  }
+
+  Response response;
+
+  if (rendered.isSome()) {
+    ++master->metrics->state_cache_hits;
+    master->stateCacheStaleness = Clock::now() - rendered.get().time;
+    response = rendered.get().response;
+  } else {
+    response = (this->*render)(request);
+
+    // Only successful responses get an 'ETag' or are served again.
+    if (response.code == process::http::Status::OK) {
+      response.headers["ETag"] =
+        "\"" + stringify(std::hash<string>()(response.body)) + "\"";
+
+      if (key.isSome()) {
+        ++master->metrics->state_cache_misses;
+        master->stateCacheStaleness = Duration::zero();
+
+        master->renderedResponses.put(
+            key.get(), RenderedResponse{response, Clock::now()});
+      }
+    }
+  }
+
+  Option<string> etag = response.headers.get("ETag");
+  Option<string> ifNoneMatch = request.headers.get("If-None-Match");
+
+  if (etag.isSome() && ifNoneMatch.isSome()) {
+    foreach (const string& token, strings::tokenize(ifNoneMatch.get(), ",")) {
+      const string tag = strings::remove(
+          strings::trim(token), "W/", strings::PREFIX);
+
+      if (tag == etag.get() || tag == "*") {
+        NotModified notModified;
+        notModified.headers["ETag"] = etag.get();
+        return notModified;
+      }
+    }
+  }
+
+  return response;
+}
+
+
 Future<Response> Master::Http::_operation(
     const SlaveID& slaveId,
     Resources required,
-    const Offer::Operation& operation) const
+    const vector<Offer::Operation>& operations) const
 {
   Slave* slave = master->slaves.registered.get(slaveId);
   if (slave == NULL) {
@@ -2321,7 +3441,7 @@ Future<Response> Master::Http::_operation(
   // the race between the allocator scheduling an 'allocate' call to
   // itself vs master's request to schedule 'updateAvailable'.
   // We greedily rescind one offer at time until we've rescinded
-  // enough offers to cover 'operation'.
+  // enough offers to cover 'operations'.
   foreach (Offer* offer, utils::copy(slave->offers)) {
     // If rescinding the offer would not contribute to satisfying
     // the required resources, skip it.
@@ -2343,8 +3463,9 @@ Future<Response> Master::Http::_operation(
 
     master->removeOffer(offer, true); // Rescind!
 
-    // If we've rescinded enough offers to cover 'operation', we're done.
-    Try<Resources> updatedRecovered = recovered.apply(operation);
+    // If we've rescinded enough offers to cover 'operations', we're
+    // done.
+    Try<Resources> updatedRecovered = recovered.apply(operations);
     if (updatedRecovered.isSome()) {
       break;
     }
@@ -2352,7 +3473,7 @@ Future<Response> Master::Http::_operation(
 
   // Propagate the 'Future<Nothing>' as 'Future<Response>' where
   // 'Nothing' -> 'OK' and Failed -> 'Conflict'.
-  return master->apply(slave, operation)
+  return master->apply(slave, operations)
     .then([]() -> Response { return OK(); })
     .repair([](const Future<Response>& result) {
        return Conflict(result.failure());
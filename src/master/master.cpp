@@ -34,6 +34,7 @@
 
 #include <mesos/module/authenticator.hpp>
 
+#include <process/async.hpp>
 #include <process/check.hpp>
 #include <process/collect.hpp>
 #include <process/defer.hpp>
@@ -46,6 +47,7 @@
 #include <process/shared.hpp>
 
 #include <process/metrics/metrics.hpp>
+#include <process/metrics/timer.hpp>
 
 #include <stout/check.hpp>
 #include <stout/duration.hpp>
@@ -58,9 +60,12 @@
 #include <stout/numify.hpp>
 #include <stout/option.hpp>
 #include <stout/path.hpp>
+#include <stout/protobuf.hpp>
+#include <stout/recordio.hpp>
 #include <stout/stringify.hpp>
 #include <stout/utils.hpp>
 #include <stout/uuid.hpp>
+#include <stout/version.hpp>
 
 #include "authentication/cram_md5/authenticator.hpp"
 
@@ -88,6 +93,7 @@ using std::shared_ptr;
 using std::string;
 using std::vector;
 
+using process::async;
 using process::await;
 using process::wait; // Necessary on some OS's to disambiguate.
 using process::Clock;
@@ -115,97 +121,178 @@ namespace master {
 
 using mesos::master::RoleInfo;
 using mesos::master::allocator::Allocator;
+using mesos::master::allocator::Recovery;
 
 
+// Health checks all the slaves of the master. The slaves are spread
+// over 'SLAVE_PING_SLOTS' time slots of a slave ping timeout, and the
+// observer pings the slaves of one slot at a time, so that it needs a
+// single timer regardless of the number of slaves. The pongs of the
+// slaves are sent to the observer rather than to the master.
 class SlaveObserver : public ProtobufProcess<SlaveObserver>
 {
 public:
-  SlaveObserver(const UPID& _slave,
-                const SlaveInfo& _slaveInfo,
-                const SlaveID& _slaveId,
-                const PID<Master>& _master,
+  SlaveObserver(const PID<Master>& _master,
                 const Option<shared_ptr<RateLimiter>>& _limiter,
                 const shared_ptr<Metrics> _metrics,
                 const Duration& _slavePingTimeout,
                 const size_t _maxSlavePingTimeouts)
     : ProcessBase(process::ID::generate("slave-observer")),
-      slave(_slave),
-      slaveInfo(_slaveInfo),
-      slaveId(_slaveId),
       master(_master),
       limiter(_limiter),
       metrics(_metrics),
       slavePingTimeout(_slavePingTimeout),
       maxSlavePingTimeouts(_maxSlavePingTimeouts),
-      timeouts(0),
-      pinged(false),
-      connected(true)
+      slots(SLAVE_PING_SLOTS),
+      slot(0)
   {
     install<PongSlaveMessage>(&SlaveObserver::pong);
   }
 
-  void reconnect()
+  void add(const SlaveID& slaveId, const UPID& pid)
   {
-    connected = true;
+    CHECK(!slaves.contains(slaveId))
+      << "Slave " << slaveId << " is already observed";
+
+    // The slave is pinged right away and then with the slot that is
+    // due the latest within a slave ping timeout from now.
+    const size_t _slot = (slot + slots.size() - 1) % slots.size();
+
+    slaves[slaveId] = Owned<ObservedSlave>(
+        new ObservedSlave(slaveId, pid, _slot));
+
+    slots[_slot].insert(slaveId);
+    pids[pid] = slaveId;
+
+    ping(slaveId);
+  }
+
+  void remove(const SlaveID& slaveId)
+  {
+    CHECK(slaves.contains(slaveId))
+      << "Slave " << slaveId << " is not observed";
+
+    const Owned<ObservedSlave>& slave = slaves.at(slaveId);
+
+    slots[slave->slot].erase(slaveId);
+
+    if (pids.get(slave->pid) == slaveId) {
+      pids.erase(slave->pid);
+    }
+
+    slaves.erase(slaveId);
+  }
+
+  void reconnect(const SlaveID& slaveId, const UPID& pid)
+  {
+    CHECK(slaves.contains(slaveId))
+      << "Slave " << slaveId << " is not observed";
+
+    const Owned<ObservedSlave>& slave = slaves.at(slaveId);
+
+    if (pids.get(slave->pid) == slaveId) {
+      pids.erase(slave->pid);
+    }
+
+    slave->pid = pid;
+    slave->connected = true;
+
+    pids[pid] = slaveId;
   }
 
-  void disconnect()
+  void disconnect(const SlaveID& slaveId)
   {
-    connected = false;
+    CHECK(slaves.contains(slaveId))
+      << "Slave " << slaveId << " is not observed";
+
+    slaves.at(slaveId)->connected = false;
   }
 
 protected:
   virtual void initialize()
   {
-    ping();
+    delay(interval(), self(), &SlaveObserver::tick);
+  }
+
+  // Checks the pings of the slaves of the current slot and pings them
+  // again.
+  void tick()
+  {
+    foreach (const SlaveID& slaveId, utils::copy(slots[slot])) {
+      timeout(slaveId);
+    }
+
+    slot = (slot + 1) % slots.size();
+
+    delay(interval(), self(), &SlaveObserver::tick);
   }
 
-  void ping()
+  void ping(const SlaveID& slaveId)
   {
+    const Owned<ObservedSlave>& slave = slaves.at(slaveId);
+
     PingSlaveMessage message;
-    message.set_connected(connected);
-    send(slave, message);
+    message.set_connected(slave->connected);
+    send(slave->pid, message);
 
-    pinged = true;
-    delay(slavePingTimeout, self(), &SlaveObserver::timeout);
+    slave->pinged = true;
+    slave->pingLatency.start();
   }
 
-  void pong()
+  void pong(const UPID& from)
   {
-    timeouts = 0;
-    pinged = false;
+    // Ignore pongs of slaves that are no longer observed.
+    Option<SlaveID> slaveId = pids.get(from);
+    if (slaveId.isNone()) {
+      return;
+    }
+
+    const Owned<ObservedSlave>& slave = slaves.at(slaveId.get());
+
+    // Only the first pong for a ping tells the latency.
+    if (slave->pinged) {
+      slave->pingLatency.stop();
+    }
+
+    slave->timeouts = 0;
+    slave->pinged = false;
 
     // Cancel any pending shutdown.
-    if (shuttingDown.isSome()) {
+    if (slave->shuttingDown.isSome()) {
       // Need a copy for non-const access.
-      Future<Nothing> future = shuttingDown.get();
+      Future<Nothing> future = slave->shuttingDown.get();
       future.discard();
     }
   }
 
-  void timeout()
+  void timeout(const SlaveID& slaveId)
   {
-    if (pinged) {
-      timeouts++; // No pong has been received before the timeout.
-      if (timeouts >= maxSlavePingTimeouts) {
+    const Owned<ObservedSlave>& slave = slaves.at(slaveId);
+
+    if (slave->pinged) {
+      slave->timeouts++; // No pong has been received before the timeout.
+      if (slave->timeouts >= maxSlavePingTimeouts) {
         // No pong has been received for the last
         // 'maxSlavePingTimeouts' pings.
-        shutdown();
+        shutdown(slaveId);
       }
     }
 
     // NOTE: We keep pinging even if we schedule a shutdown. This is
     // because if the slave eventually responds to a ping, we can
     // cancel the shutdown.
-    ping();
+    ping(slaveId);
   }
 
   // NOTE: The shutdown of the slave is rate limited and can be
   // canceled if a pong was received before the actual shutdown is
-  // called.
-  void shutdown()
+  // called. Since the observer watches all the slaves, the rate
+  // limiter is only acquired by it.
+  void shutdown(const SlaveID& slaveId)
   {
-    if (shuttingDown.isSome()) {
+    const Owned<ObservedSlave>& slave = slaves.at(slaveId);
+
+    if (slave->shuttingDown.isSome()) {
       return;  // Shutdown is already in progress.
     }
 
@@ -218,15 +305,20 @@ protected:
       acquire = limiter.get()->acquire();
     }
 
-    shuttingDown = acquire.onAny(defer(self(), &Self::_shutdown));
+    slave->shuttingDown =
+      acquire.onAny(defer(self(), &Self::_shutdown, slaveId, lambda::_1));
+
     ++metrics->slave_shutdowns_scheduled;
   }
 
-  void _shutdown()
+  void _shutdown(const SlaveID& slaveId, const Future<Nothing>& future)
   {
-    CHECK_SOME(shuttingDown);
-
-    const Future<Nothing>& future = shuttingDown.get();
+    // The slave might have been removed, or even added again, in the
+    // meantime.
+    if (!slaves.contains(slaveId) ||
+        slaves.at(slaveId)->shuttingDown != future) {
+      return;
+    }
 
     CHECK(!future.isFailed());
 
@@ -236,10 +328,15 @@ protected:
 
       ++metrics->slave_shutdowns_completed;
 
-      dispatch(master,
-               &Master::shutdownSlave,
-               slaveId,
-               "health check timed out");
+      // The slaves whose permits arrive together (e.g., all the
+      // slaves of a slot timing out without a rate limit) are shut
+      // down together, once the messages already queued for the
+      // observer have been handled.
+      if (shutdowns.empty()) {
+        dispatch(self(), &Self::__shutdown);
+      }
+
+      shutdowns.push_back(slaveId);
     } else if (future.isDiscarded()) {
       LOG(INFO) << "Canceling shutdown of slave " << slaveId
                 << " since a pong is received!";
@@ -247,22 +344,73 @@ protected:
       ++metrics->slave_shutdowns_canceled;
     }
 
-    shuttingDown = None();
+    slaves.at(slaveId)->shuttingDown = None();
+  }
+
+  void __shutdown()
+  {
+    dispatch(master,
+             &Master::shutdownSlaves,
+             shutdowns,
+             "health check timed out");
+
+    shutdowns.clear();
   }
 
 private:
-  const UPID slave;
-  const SlaveInfo slaveInfo;
-  const SlaveID slaveId;
+  struct ObservedSlave
+  {
+    ObservedSlave(const SlaveID& slaveId, const UPID& _pid, size_t _slot)
+      : pid(_pid),
+        slot(_slot),
+        connected(true),
+        pinged(false),
+        timeouts(0),
+        pingLatency(
+            "master/slaves/" + stringify(slaveId) + "/ping_latency",
+            SLAVE_PING_LATENCY_WINDOW)
+    {
+      process::metrics::add(pingLatency);
+    }
+
+    ~ObservedSlave()
+    {
+      process::metrics::remove(pingLatency);
+    }
+
+    UPID pid;
+    const size_t slot;
+    bool connected;
+    bool pinged;
+    uint32_t timeouts;
+    Option<Future<Nothing>> shuttingDown;
+
+    // The time between the pings of the slave and its pongs.
+    process::metrics::Timer<Milliseconds> pingLatency;
+  };
+
+  Duration interval() const
+  {
+    return slavePingTimeout / slots.size();
+  }
+
   const PID<Master> master;
   const Option<shared_ptr<RateLimiter>> limiter;
   shared_ptr<Metrics> metrics;
-  Option<Future<Nothing>> shuttingDown;
   const Duration slavePingTimeout;
   const size_t maxSlavePingTimeouts;
-  uint32_t timeouts;
-  bool pinged;
-  bool connected;
+
+  hashmap<SlaveID, Owned<ObservedSlave>> slaves;
+
+  // The slave whose pongs come from a pid.
+  hashmap<UPID, SlaveID> pids;
+
+  // The slaves pinged in each time slot, and the slot due next.
+  vector<hashset<SlaveID>> slots;
+  size_t slot;
+
+  // The slaves to shut down with the next call to '__shutdown'.
+  vector<SlaveID> shutdowns;
 };
 
 
@@ -287,7 +435,8 @@ Master::Master(
     authorizer(_authorizer),
     authenticator(None()),
     metrics(new Metrics(*this)),
-    electedTime(None())
+    electedTime(None()),
+    renderedResponses(MAX_STATE_CACHE_RESPONSES, _flags.state_cache_ttl)
 {
   slaves.limiter = _slaveRemovalLimiter;
 
@@ -455,7 +604,8 @@ void Master::initialize()
   if (authenticatorNames[0] == DEFAULT_AUTHENTICATOR) {
     LOG(INFO) << "Using default '" << DEFAULT_AUTHENTICATOR
               << "' authenticator";
-    authenticator = new cram_md5::CRAMMD5Authenticator();
+    authenticator =
+      new cram_md5::CRAMMD5Authenticator(flags.authentication_session_ttl);
   } else {
     Try<Authenticator*> module =
       modules::ModuleManager::create<Authenticator>(authenticatorNames[0]);
@@ -622,12 +772,24 @@ void Master::initialize()
       });
   spawn(whitelistWatcher);
 
+  // Set up the observer of the health of the slaves.
+  observer = new SlaveObserver(
+      self(),
+      slaves.limiter,
+      metrics,
+      flags.slave_ping_timeout,
+      flags.max_slave_ping_timeouts);
+  spawn(observer);
+
   nextFrameworkId = 0;
   nextSlaveId = 0;
   nextOfferId = 0;
 
   startTime = Clock::now();
 
+  // Keep metrics of the protobuf messages the master handles.
+  instrument("master/handlers");
+
   install<scheduler::Call>(&Master::receive);
 
   // Install handler functions for certain messages.
@@ -644,6 +806,10 @@ void Master::initialize()
       &ReregisterFrameworkMessage::framework,
       &ReregisterFrameworkMessage::failover);
 
+  // Don't let re-registering frameworks wait behind floods of status
+  // updates (e.g., after a master failover).
+  prioritize<ReregisterFrameworkMessage>();
+
   install<UnregisterFrameworkMessage>(
       &Master::unregisterFramework,
       &UnregisterFrameworkMessage::framework_id);
@@ -711,6 +877,11 @@ void Master::initialize()
       &StatusUpdateMessage::update,
       &StatusUpdateMessage::pid);
 
+  install<StatusUpdatesMessage>(
+      &Master::statusUpdates,
+      &StatusUpdatesMessage::updates,
+      &StatusUpdatesMessage::pid);
+
   // Added in 0.24.0 to support HTTP schedulers. Since
   // these do not have a pid, the slave must forward
   // messages through the master.
@@ -738,6 +909,11 @@ void Master::initialize()
       &UpdateSlaveMessage::slave_id,
       &UpdateSlaveMessage::oversubscribed_resources);
 
+  install<ImagePullsMessage>(
+      &Master::updateImagePulls,
+      &ImagePullsMessage::slave_id,
+      &ImagePullsMessage::pulls);
+
   install<AuthenticateMessage>(
       &Master::authenticate,
       &AuthenticateMessage::pid);
@@ -780,12 +956,36 @@ void Master::initialize()
         [http](const process::http::Request& request) {
           return http.health(request);
         });
+  route("/images",
+        Http::IMAGES_HELP(),
+        [http](const process::http::Request& request) {
+          Http::log(request);
+          return http.images(request);
+        });
+  route("/memory",
+        Http::MEMORY_HELP(),
+        [http](const process::http::Request& request) {
+          Http::log(request);
+          return http.memory(request);
+        });
   route("/observe",
         Http::OBSERVE_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.observe(request);
         });
+  route("/offer-traces",
+        Http::OFFER_TRACES_HELP(),
+        [http](const process::http::Request& request) {
+          Http::log(request);
+          return http.offerTraces(request);
+        });
+  route("/operations",
+        Http::OPERATIONS_HELP(),
+        [http](const process::http::Request& request) {
+          Http::log(request);
+          return http.operations(request);
+        });
   route("/redirect",
         Http::REDIRECT_HELP(),
         [http](const process::http::Request& request) {
@@ -843,6 +1043,12 @@ void Master::initialize()
           Http::log(request);
           return http.stateSummary(request);
         });
+  route("/state/stream",
+        Http::STATE_STREAM_HELP(),
+        [http](const process::http::Request& request) {
+          Http::log(request);
+          return http.stateStream(request);
+        });
   // TODO(ijimenez): Remove this endpoint at the end of the
   // deprecation cycle.
   route("/tasks.json",
@@ -937,6 +1143,14 @@ void Master::finalize()
 {
   LOG(INFO) << "Master terminating";
 
+  // Close the state streams first, rather than sending them the
+  // removals of the slaves and frameworks below.
+  foreach (Pipe::Writer writer, stateStreams) {
+    writer.close();
+  }
+
+  stateStreams.clear();
+
   // NOTE: Even though we remove the slave and framework from the
   // allocator, it is possible that offers are already dispatched to
   // this master. In tests, if a new master (with the same PID) is
@@ -977,11 +1191,6 @@ void Master::finalize()
       removeInverseOffer(inverseOffer);
     }
 
-    // Terminate the slave observer.
-    terminate(slave->observer);
-    wait(slave->observer);
-
-    delete slave->observer;
     delete slave;
   }
   slaves.registered.clear();
@@ -1038,10 +1247,18 @@ void Master::finalize()
     Clock::cancel(slaves.recoveredTimer.get());
   }
 
+  if (offerTimer.isSome()) {
+    Clock::cancel(offerTimer.get());
+  }
+
   terminate(whitelistWatcher);
   wait(whitelistWatcher);
   delete whitelistWatcher;
 
+  terminate(observer);
+  wait(observer);
+  delete observer;
+
   if (authenticator.isSome()) {
     delete authenticator.get();
   }
@@ -1054,6 +1271,15 @@ void Master::exited(const FrameworkID& frameworkId, const HttpConnection& http)
     if (framework->http.isSome() &&
         framework->http.get().writer == http.writer) {
       CHECK_EQ(frameworkId, framework->id());
+
+      // The framework might already have been disconnected, e.g., for
+      // not keeping up with the events (see 'Framework::send').
+      if (!framework->connected) {
+        LOG(INFO) << "Ignoring disconnection for framework "
+                  << *framework << " as it is already disconnected";
+        return;
+      }
+
       _exited(framework);
       return;
     }
@@ -1548,8 +1774,8 @@ Nothing Master::removeSlave(const Registry::Slave& slave)
 
     registrar->apply(Owned<Operation>(new RemoveSlave(slave.info())))
       .onAny(defer(self(),
-                   &Self::_removeSlave,
-                   slave.info(),
+                   &Self::_removeSlaves,
+                   vector<SlaveInfo>{slave.info()},
                    vector<StatusUpdate>(), // No TASK_LOST updates to send.
                    lambda::_1,
                    "did not re-register after master failover",
@@ -1634,6 +1860,8 @@ void Master::detected(const Future<Option<MasterInfo>>& _leader)
   bool wasElected = elected();
   leader = _leader.get();
 
+  metrics->elected = elected() ? 1 : 0;
+
   LOG(INFO) << "The newly elected leader is "
             << (leader.isSome()
                 ? (leader.get().pid() + " with id " + leader.get().id())
@@ -1809,6 +2037,10 @@ void Master::receive(
       acknowledge(framework, call.acknowledge());
       break;
 
+    case scheduler::Call::ACKNOWLEDGEMENTS:
+      acknowledge(framework, call.acknowledgements());
+      break;
+
     case scheduler::Call::RECONCILE:
       reconcile(framework, call.reconcile());
       break;
@@ -2061,7 +2293,12 @@ void Master::_subscribe(
       LOG(INFO) << "Allowing framework " << *framework
                 << " to subscribe with an already used id";
 
-      framework->connected = true;
+      if (!framework->connected) {
+        framework->connected = true;
+        ++metrics->frameworks_connected;
+        --metrics->frameworks_disconnected;
+      }
+
       framework->updateConnection(http);
 
       http.closed()
@@ -2070,6 +2307,8 @@ void Master::_subscribe(
       // Reactivate the framework.
       if (!framework->active) {
         framework->active = true;
+        ++metrics->frameworks_active;
+        --metrics->frameworks_inactive;
         allocator->activateFramework(framework->id());
       }
 
@@ -2093,7 +2332,7 @@ void Master::_subscribe(
       foreachvalue (Task* task, slave->tasks[framework->id()]) {
         framework->addTask(task);
       }
-      foreachvalue (const ExecutorInfo& executor,
+      foreachvalue (const shared_ptr<const ExecutorInfo>& executor,
                     slave->executors[framework->id()]) {
         framework->addExecutor(slave->id, executor);
       }
@@ -2386,13 +2625,19 @@ void Master::_subscribe(
       }
 
       // TODO(bmahler): Shouldn't this re-link with the scheduler?
-      framework->connected = true;
+      if (!framework->connected) {
+        framework->connected = true;
+        ++metrics->frameworks_connected;
+        --metrics->frameworks_disconnected;
+      }
 
       // Reactivate the framework.
       // NOTE: We do this after recovering resources (above) so that
       // the allocator has the correct view of the framework's share.
       if (!framework->active) {
         framework->active = true;
+        ++metrics->frameworks_active;
+        --metrics->frameworks_inactive;
         allocator->activateFramework(framework->id());
       }
 
@@ -2414,7 +2659,7 @@ void Master::_subscribe(
       foreachvalue (Task* task, slave->tasks[framework->id()]) {
         framework->addTask(task);
       }
-      foreachvalue (const ExecutorInfo& executor,
+      foreachvalue (const shared_ptr<const ExecutorInfo>& executor,
                     slave->executors[framework->id()]) {
         framework->addExecutor(slave->id, executor);
       }
@@ -2502,7 +2747,11 @@ void Master::disconnect(Framework* framework)
 
   LOG(INFO) << "Disconnecting framework " << *framework;
 
-  framework->connected = false;
+  if (framework->connected) {
+    framework->connected = false;
+    --metrics->frameworks_connected;
+    ++metrics->frameworks_disconnected;
+  }
 
   if (framework->pid.isSome()) {
     // Remove the framework from authenticated. This is safe because
@@ -2527,19 +2776,28 @@ void Master::deactivate(Framework* framework)
   LOG(INFO) << "Deactivating framework " << *framework;
 
   // Stop sending offers here for now.
-  framework->active = false;
+  if (framework->active) {
+    framework->active = false;
+    --metrics->frameworks_active;
+    ++metrics->frameworks_inactive;
+  }
 
   // Tell the allocator to stop allocating resources to this framework.
   allocator->deactivateFramework(framework->id());
 
   // Remove the framework's offers.
+  vector<Recovery> recoveries;
   foreach (Offer* offer, utils::copy(framework->offers)) {
-    allocator->recoverResources(
-        offer->framework_id(), offer->slave_id(), offer->resources(), None());
+    recoveries.push_back(Recovery{
+        offer->framework_id(), offer->slave_id(), offer->resources(), None()});
 
     removeOffer(offer, true); // Rescind.
   }
 
+  if (!recoveries.empty()) {
+    allocator->bulkRecoverResources(recoveries);
+  }
+
   // Remove the framework's inverse offers.
   foreach (InverseOffer* inverseOffer, utils::copy(framework->inverseOffers)) {
     allocator->updateInverseOffer(
@@ -2561,10 +2819,14 @@ void Master::disconnect(Slave* slave)
 
   LOG(INFO) << "Disconnecting slave " << *slave;
 
-  slave->connected = false;
+  if (slave->connected) {
+    slave->connected = false;
+    --metrics->slaves_connected;
+    ++metrics->slaves_disconnected;
+  }
 
   // Inform the slave observer.
-  dispatch(slave->observer, &SlaveObserver::disconnect);
+  dispatch(observer, &SlaveObserver::disconnect, slave->id);
 
   // Remove the slave from authenticated. This is safe because
   // a slave will always reauthenticate before (re-)registering.
@@ -2580,18 +2842,31 @@ void Master::deactivate(Slave* slave)
 
   LOG(INFO) << "Deactivating slave " << *slave;
 
+  if (slave->active) {
+    nonStaticClusterResources -=
+      Resources(slave->info.resources()).unreserved().scalars();
+
+    --metrics->slaves_active;
+    ++metrics->slaves_inactive;
+  }
+
   slave->active = false;
 
   allocator->deactivateSlave(slave->id);
 
   // Remove and rescind offers.
+  vector<Recovery> recoveries;
   foreach (Offer* offer, utils::copy(slave->offers)) {
-    allocator->recoverResources(
-        offer->framework_id(), slave->id, offer->resources(), None());
+    recoveries.push_back(Recovery{
+        offer->framework_id(), slave->id, offer->resources(), None()});
 
     removeOffer(offer, true); // Rescind!
   }
 
+  if (!recoveries.empty()) {
+    allocator->bulkRecoverResources(recoveries);
+  }
+
   // Remove and rescind inverse offers.
   foreach (InverseOffer* inverseOffer, utils::copy(slave->inverseOffers)) {
     allocator->updateInverseOffer(
@@ -2723,36 +2998,60 @@ void Master::launchTasks(
 }
 
 
-Future<bool> Master::authorizeTask(
-    const TaskInfo& task,
+list<Future<bool>> Master::authorizeTasks(
+    const google::protobuf::RepeatedPtrField<TaskInfo>& tasks,
     Framework* framework)
 {
   if (authorizer.isNone()) {
-    return true; // Authorization is disabled.
+    // Authorization is disabled.
+    return list<Future<bool>>(tasks.size(), true);
   }
 
-  // Authorize the task.
-  string user = framework->info.user(); // Default user.
-  if (task.has_command() && task.command().has_user()) {
-    user = task.command().user();
-  } else if (task.has_executor() && task.executor().command().has_user()) {
-    user = task.executor().command().user();
+  list<mesos::ACL::RunTask> requests;
+  foreach (const TaskInfo& task, tasks) {
+    string user = framework->info.user(); // Default user.
+    if (task.has_command() && task.command().has_user()) {
+      user = task.command().user();
+    } else if (task.has_executor() && task.executor().command().has_user()) {
+      user = task.executor().command().user();
+    }
+
+    LOG(INFO)
+      << "Authorizing framework principal '" << framework->info.principal()
+      << "' to launch task " << task.task_id() << " as user '" << user << "'";
+
+    mesos::ACL::RunTask request;
+    if (framework->info.has_principal()) {
+      request.mutable_principals()->add_values(framework->info.principal());
+    } else {
+      // Framework doesn't have a principal set.
+      request.mutable_principals()->set_type(mesos::ACL::Entity::ANY);
+    }
+    request.mutable_users()->add_values(user);
+
+    requests.push_back(request);
   }
 
-  LOG(INFO)
-    << "Authorizing framework principal '" << framework->info.principal()
-    << "' to launch task " << task.task_id() << " as user '" << user << "'";
+  // Authorize all the tasks at once, which saves an authorizer that
+  // calls out to some external service a round trip per task.
+  Future<vector<bool>> decisions = authorizer.get()->authorize(requests)
+    .then([](const list<bool>& decisions) {
+      return vector<bool>(decisions.begin(), decisions.end());
+    });
 
-  mesos::ACL::RunTask request;
-  if (framework->info.has_principal()) {
-    request.mutable_principals()->add_values(framework->info.principal());
-  } else {
-    // Framework doesn't have a principal set.
-    request.mutable_principals()->set_type(mesos::ACL::Entity::ANY);
+  list<Future<bool>> futures;
+  for (size_t i = 0; i < requests.size(); i++) {
+    futures.push_back(decisions
+      .then([i](const vector<bool>& decisions) -> Future<bool> {
+        if (i >= decisions.size()) {
+          return Failure("Authorizer returned fewer decisions than requests");
+        }
+
+        return decisions[i];
+      }));
   }
-  request.mutable_users()->add_values(user);
 
-  return authorizer.get()->authorize(request);
+  return futures;
 }
 
 
@@ -2845,8 +3144,11 @@ Resources Master::addTask(
         << "' known to the framework " << *framework
         << " but unknown to the slave " << *slave;
 
-      slave->addExecutor(framework->id(), task.executor());
-      framework->addExecutor(slave->id, task.executor());
+      const shared_ptr<const ExecutorInfo> executor =
+        internedExecutorInfos.intern(task.executor());
+
+      slave->addExecutor(framework->id(), executor);
+      framework->addExecutor(slave->id, executor);
 
       resources += task.executor().resources();
     }
@@ -2877,6 +3179,8 @@ Resources Master::addTask(
   slave->addTask(t);
   framework->addTask(t);
 
+  stream("TASK_ADDED", "task", model(*t));
+
   return resources;
 }
 
@@ -2931,6 +3235,7 @@ void Master::accept(
               offer->resources(),
               None());
         }
+        answerOffer(offer, "ACCEPTED");
         removeOffer(offer);
         continue;
       }
@@ -3010,15 +3315,33 @@ void Master::accept(
   LOG(INFO) << "Processing ACCEPT call for offers: " << accept.offer_ids()
             << " on slave " << *slave << " for framework " << *framework;
 
+  // An ACCEPT call without any operations, or only with launches of
+  // no tasks, declines the offers, so it does not conflict with the
+  // offers of the other frameworks.
+  bool declined = true;
+  foreach (const Offer::Operation& operation, accept.operations()) {
+    if (operation.type() != Offer::Operation::LAUNCH ||
+        operation.launch().task_infos().size() > 0) {
+      declined = false;
+      break;
+    }
+  }
+
+  if (flags.allocator == OPTIMISTIC_ALLOCATOR && !declined) {
+    rescindConflictingOffers(framework, slave, offeredResources);
+  }
+
   list<Future<bool>> futures;
   foreach (const Offer::Operation& operation, accept.operations()) {
     switch (operation.type()) {
       case Offer::Operation::LAUNCH: {
         // Authorize the tasks. A task is in 'framework->pendingTasks'
         // before it is authorized.
-        foreach (const TaskInfo& task, operation.launch().task_infos()) {
-          futures.push_back(authorizeTask(task, framework));
+        futures.splice(
+            futures.end(),
+            authorizeTasks(operation.launch().task_infos(), framework));
 
+        foreach (const TaskInfo& task, operation.launch().task_infos()) {
           // Add to pending tasks.
           //
           // NOTE: The task ID here hasn't been validated yet, but it
@@ -3028,6 +3351,7 @@ void Master::accept(
           // will not be launched.
           if (!framework->pendingTasks.contains(task.task_id())) {
             framework->pendingTasks[task.task_id()] = task;
+            ++metrics->tasks_staging;
           }
         }
         break;
@@ -3071,15 +3395,166 @@ void Master::accept(
     }
   }
 
-  // Wait for all the tasks to be authorized.
-  await(futures)
+  Future<list<Future<bool>>> authorizations = await(futures);
+  Future<vector<Option<Error>>> validations = validateTasks(accept);
+  Future<vector<Labels>> decorations =
+    decorateTasks(accept, framework, slave);
+
+  // Wait for all the tasks to be authorized, validated and decorated.
+  await(authorizations, validations, decorations)
     .onAny(defer(self(),
                  &Master::_accept,
                  framework->id(),
                  slaveId.get(),
                  offeredResources,
                  accept,
-                 lambda::_1));
+                 authorizations,
+                 validations,
+                 decorations));
+}
+
+
+void Master::rescindConflictingOffers(
+    Framework* framework,
+    Slave* slave,
+    const Resources& accepted)
+{
+  CHECK_NOTNULL(framework);
+  CHECK_NOTNULL(slave);
+
+  // The allocator accounts the accepted resources to the framework
+  // before it recovers the rescinded offers below, in which it might
+  // have offered the same resources to the other frameworks.
+  allocator->acceptResources(framework->id(), slave->id, accepted);
+
+  // NOTE: The offers of a slave that are made in different allocation
+  // runs do not share any resources, but as we cannot tell apart the
+  // scalar resources of the offers, we rescind every offer of the
+  // other frameworks that has some of the same kind of resources as
+  // the accepted ones. Each rescinded offer gets made again in the
+  // next allocation runs. The other offers of the framework itself
+  // never share resources with the accepted ones.
+  vector<Recovery> recoveries;
+
+  foreach (Offer* offer, utils::copy(slave->offers)) {
+    if (offer->framework_id() == framework->id()) {
+      continue;
+    }
+
+    const Resources offered = offer->resources();
+
+    if ((offered - (offered - accepted)).empty()) {
+      continue;
+    }
+
+    LOG(INFO) << "Rescinding offer " << offer->id() << " of framework "
+              << offer->framework_id() << " on slave " << *slave
+              << " which overlaps with the accepted resources " << accepted;
+
+    recoveries.push_back(
+        Recovery{offer->framework_id(), slave->id, offered, None()});
+
+    removeOffer(offer, true); // Rescind.
+  }
+
+  if (!recoveries.empty()) {
+    allocator->bulkRecoverResources(recoveries);
+  }
+}
+
+
+Future<vector<Option<Error>>> Master::validateTasks(
+    const scheduler::Call::Accept& accept)
+{
+  // The batches share a copy of the call, so that they only see the
+  // tasks as they were at the time of the call.
+  shared_ptr<const scheduler::Call::Accept> call(
+      new scheduler::Call::Accept(accept));
+
+  shared_ptr<vector<const TaskInfo*>> tasks(new vector<const TaskInfo*>());
+
+  foreach (const Offer::Operation& operation, call->operations()) {
+    if (operation.type() == Offer::Operation::LAUNCH) {
+      foreach (const TaskInfo& task, operation.launch().task_infos()) {
+        tasks->push_back(&task);
+      }
+    }
+  }
+
+  if (tasks->empty()) {
+    return vector<Option<Error>>();
+  }
+
+  list<Future<vector<Option<Error>>>> batches;
+
+  for (size_t begin = 0;
+       begin < tasks->size();
+       begin += TASK_VALIDATION_BATCH_SIZE) {
+    const size_t end =
+      std::min(begin + TASK_VALIDATION_BATCH_SIZE, tasks->size());
+
+    batches.push_back(async([call, tasks, begin, end]() {
+      vector<Option<Error>> errors;
+      errors.reserve(end - begin);
+
+      for (size_t i = begin; i < end; i++) {
+        errors.push_back(validation::task::validate(*tasks->at(i)));
+      }
+
+      return errors;
+    }));
+  }
+
+  return collect(batches)
+    .then([](const list<vector<Option<Error>>>& batches) {
+      vector<Option<Error>> errors;
+
+      foreach (const vector<Option<Error>>& batch, batches) {
+        errors.insert(errors.end(), batch.begin(), batch.end());
+      }
+
+      return errors;
+    });
+}
+
+
+Future<vector<Labels>> Master::decorateTasks(
+    const scheduler::Call::Accept& accept,
+    const Framework* framework,
+    const Slave* slave)
+{
+  if (!HookManager::hooksAvailable()) {
+    return vector<Labels>();
+  }
+
+  list<Future<Labels>> futures;
+
+  foreach (const Offer::Operation& operation, accept.operations()) {
+    if (operation.type() != Offer::Operation::LAUNCH) {
+      continue;
+    }
+
+    foreach (const TaskInfo& task, operation.launch().task_infos()) {
+      // The hooks see the task as it will be launched, see the
+      // 'framework_id' of the ExecutorInfo in '_accept()'.
+      TaskInfo task_(task);
+      if (task.has_executor() && !task.executor().has_framework_id()) {
+        task_.mutable_executor()
+            ->mutable_framework_id()->CopyFrom(framework->id());
+      }
+
+      futures.push_back(HookManager::masterLaunchTaskLabelDecorator(
+          task_,
+          framework->info,
+          slave->info,
+          flags.hook_timeout));
+    }
+  }
+
+  return collect(futures)
+    .then([](const list<Labels>& labels) {
+      return vector<Labels>(labels.begin(), labels.end());
+    });
 }
 
 
@@ -3088,7 +3563,9 @@ void Master::_accept(
     const SlaveID& slaveId,
     const Resources& offeredResources,
     const scheduler::Call::Accept& accept,
-    const Future<list<Future<bool>>>& _authorizations)
+    const Future<list<Future<bool>>>& _authorizations,
+    const Future<vector<Option<Error>>>& validations,
+    const Future<vector<Labels>>& decorations)
 {
   Framework* framework = getFramework(frameworkId);
 
@@ -3162,6 +3639,17 @@ void Master::_accept(
   CHECK_READY(_authorizations);
   list<Future<bool>> authorizations = _authorizations.get();
 
+  // The results of the validation of the tasks that does not depend on
+  // the state of the master, in the order of the tasks.
+  CHECK_READY(validations);
+  vector<Option<Error>>::const_iterator validation =
+    validations.get().begin();
+
+  // The labels of the tasks set by the label decorator hooks, if any,
+  // in the order of the tasks.
+  CHECK_READY(decorations);
+  vector<Labels>::const_iterator decoration = decorations.get().begin();
+
   foreach (const Offer::Operation& operation, accept.operations()) {
     switch (operation.type()) {
       // The RESERVE operation allows a principal to reserve resources.
@@ -3303,10 +3791,27 @@ void Master::_accept(
       }
 
       case Offer::Operation::LAUNCH: {
+        // The tasks launched onto the same executor are sent to the
+        // slave in one RunTasksMessage, which slaves since 0.27.0
+        // understand.
+        Try<Version> version = Version::parse(slave->version);
+        const bool batch =
+          version.isSome() && version.get() >= Version(0, 27, 0);
+
+        hashmap<ExecutorID, RunTasksMessage> batches;
+
         foreach (const TaskInfo& task, operation.launch().task_infos()) {
           Future<bool> authorization = authorizations.front();
           authorizations.pop_front();
 
+          CHECK(validation != validations.get().end());
+          Option<Error> validationError = *validation++;
+
+          Option<Labels> labels;
+          if (decoration != decorations.get().end()) {
+            labels = *decoration++;
+          }
+
           // NOTE: The task will not be in 'pendingTasks' if
           // 'killTask()' for the task was called before we are here.
           // No need to launch the task if it's no longer pending.
@@ -3316,7 +3821,10 @@ void Master::_accept(
           bool pending = framework->pendingTasks.contains(task.task_id());
 
           // Remove from pending tasks.
-          framework->pendingTasks.erase(task.task_id());
+          if (pending) {
+            framework->pendingTasks.erase(task.task_id());
+            --metrics->tasks_staging;
+          }
 
           CHECK(!authorization.isDiscarded());
 
@@ -3365,11 +3873,13 @@ void Master::_accept(
                 ->mutable_framework_id()->CopyFrom(framework->id());
           }
 
-          const Option<Error>& validationError = validation::task::validate(
-              task_,
-              framework,
-              slave,
-              _offeredResources);
+          if (validationError.isNone()) {
+            validationError = validation::task::validate(
+                task_,
+                framework,
+                slave,
+                _offeredResources);
+          }
 
           if (validationError.isSome()) {
             const StatusUpdate& update = protobuf::createStatusUpdate(
@@ -3398,6 +3908,8 @@ void Master::_accept(
           if (pending) {
             _offeredResources -= addTask(task_, framework, slave);
 
+            framework->launchTimes[task_.task_id()] = Clock::now();
+
             // TODO(bmahler): Consider updating this log message to
             // indicate when the executor is also being launched.
             LOG(INFO) << "Launching task " << task_.task_id()
@@ -3414,17 +3926,41 @@ void Master::_accept(
             message.set_pid(framework->pid.getOrElse(UPID()));
             message.mutable_task()->MergeFrom(task_);
 
-            if (HookManager::hooksAvailable()) {
+            if (labels.isSome()) {
               // Set labels retrieved from label-decorator hooks.
               message.mutable_task()->mutable_labels()->CopyFrom(
-                  HookManager::masterLaunchTaskLabelDecorator(
-                      task_,
-                      framework->info,
-                      slave->info));
+                  labels.get());
+            }
+
+            if (!batch || !task_.has_executor()) {
+              send(slave->pid, message);
+              continue;
+            }
+
+            const ExecutorID& executorId = task_.executor().executor_id();
+
+            if (!batches.contains(executorId)) {
+              batches[executorId].mutable_framework()->CopyFrom(
+                  message.framework());
+              batches[executorId].set_pid(message.pid());
             }
 
+            batches[executorId].add_tasks()->CopyFrom(message.task());
+          }
+        }
+
+        foreachvalue (const RunTasksMessage& message, batches) {
+          if (message.tasks_size() > 1) {
             send(slave->pid, message);
+            continue;
           }
+
+          RunTaskMessage _message;
+          _message.mutable_framework()->CopyFrom(message.framework());
+          _message.set_pid(message.pid());
+          _message.mutable_task()->CopyFrom(message.tasks(0));
+
+          send(slave->pid, _message);
         }
         break;
       }
@@ -3457,7 +3993,10 @@ void Master::decline(
 
   ++metrics->messages_decline_offers;
 
-  //  Return resources to the allocator.
+  // Return resources to the allocator, which we do with a single call
+  // since frameworks may decline many offers at once.
+  vector<Recovery> recoveries;
+
   foreach (const OfferID& offerId, decline.offer_ids()) {
     // Since we re-use `OfferID`s, it is possible to arrive here with either a
     // resource offer, or an inverse offer. We first try as a resource offer and
@@ -3465,12 +4004,13 @@ void Master::decline(
     // those are currently the only 2 ways to get an `OfferID`.
     Offer* offer = getOffer(offerId);
     if (offer != NULL) {
-      allocator->recoverResources(
+      recoveries.push_back(Recovery{
           offer->framework_id(),
           offer->slave_id(),
           offer->resources(),
-          decline.filters());
+          decline.filters()});
 
+      answerOffer(offer, "DECLINED");
       removeOffer(offer);
       continue;
     }
@@ -3502,6 +4042,10 @@ void Master::decline(
     LOG(WARNING) << "Ignoring decline of offer " << offerId
                  << " since it is no longer valid";
   }
+
+  if (!recoveries.empty()) {
+    allocator->bulkRecoverResources(recoveries);
+  }
 }
 
 
@@ -3583,6 +4127,7 @@ void Master::kill(Framework* framework, const scheduler::Call::Kill& kill)
   if (framework->pendingTasks.contains(taskId)) {
     // Remove from pending tasks.
     framework->pendingTasks.erase(taskId);
+    --metrics->tasks_staging;
 
     const StatusUpdate& update = protobuf::createStatusUpdate(
         framework->id(),
@@ -3767,15 +4312,81 @@ void Master::acknowledge(
   message.mutable_task_id()->CopyFrom(taskId);
   message.set_uuid(uuid.toBytes());
 
-  send(slave->pid, message);
-
   metrics->valid_status_update_acknowledgements++;
+
+  if (slave->batchStatusUpdates) {
+    // We send the acknowledgements made while the master processes
+    // the events that are already queued in one message, by sending
+    // them after those events, see '_acknowledge()'.
+    if (acknowledgements.empty()) {
+      dispatch(self(), &Self::_acknowledge);
+    }
+
+    acknowledgements[slaveId].push_back(message);
+    return;
+  }
+
+  send(slave->pid, message);
 }
 
 
-void Master::schedulerMessage(
-    const UPID& from,
-    const SlaveID& slaveId,
+void Master::acknowledge(
+    Framework* framework,
+    const scheduler::Call::Acknowledgements& acknowledgements)
+{
+  CHECK_NOTNULL(framework);
+
+  LOG(INFO) << "Processing ACKNOWLEDGEMENTS call with "
+            << acknowledgements.acknowledgements_size()
+            << " acknowledgements for framework " << *framework;
+
+  // The acknowledgements for the slaves that forward their status
+  // updates in batches are sent to each of them in one message, see
+  // 'acknowledge()' above.
+  foreach (const scheduler::Call::Acknowledge& acknowledge,
+           acknowledgements.acknowledgements()) {
+    this->acknowledge(framework, acknowledge);
+  }
+}
+
+
+void Master::_acknowledge()
+{
+  foreachpair (const SlaveID& slaveId,
+               const vector<StatusUpdateAcknowledgementMessage>& messages,
+               acknowledgements) {
+    // The slave retries the updates whose acknowledgements are
+    // dropped here, e.g., if it got disconnected meanwhile.
+    Slave* slave = slaves.registered.get(slaveId);
+
+    if (slave == NULL || !slave->connected) {
+      LOG(WARNING) << "Dropping " << messages.size()
+                   << " status update acknowledgements for slave "
+                   << slaveId << " because the slave is "
+                   << (slave == NULL ? "not registered" : "disconnected");
+      continue;
+    }
+
+    if (messages.size() == 1) {
+      send(slave->pid, messages.front());
+    } else {
+      StatusUpdateAcknowledgementsMessage message;
+      foreach (const StatusUpdateAcknowledgementMessage& acknowledgement,
+               messages) {
+        message.add_acknowledgements()->CopyFrom(acknowledgement);
+      }
+
+      send(slave->pid, message);
+    }
+  }
+
+  acknowledgements.clear();
+}
+
+
+void Master::schedulerMessage(
+    const UPID& from,
+    const SlaveID& slaveId,
     const FrameworkID& frameworkId,
     const ExecutorID& executorId,
     const string& data)
@@ -4217,9 +4828,22 @@ void Master::reregisterSlave(
     // slave.
     if (!slave->connected) {
       slave->connected = true;
-      dispatch(slave->observer, &SlaveObserver::reconnect);
+      ++metrics->slaves_connected;
+      --metrics->slaves_disconnected;
+
+      dispatch(observer, &SlaveObserver::reconnect, slave->id, slave->pid);
+
+      if (!slave->active) {
+        ++metrics->slaves_active;
+        --metrics->slaves_inactive;
+      }
+
       slave->active = true;
+
       allocator->activateSlave(slave->id);
+
+      nonStaticClusterResources +=
+        Resources(slave->info.resources()).unreserved().scalars();
     }
 
     CHECK(slave->active)
@@ -4231,10 +4855,6 @@ void Master::reregisterSlave(
     return;
   }
 
-  // Ensure we don't remove the slave for not re-registering after
-  // we've recovered it from the registry.
-  slaves.recovered.erase(slaveInfo.id());
-
   // If we're already re-registering this slave, then no need to ask
   // the registrar again.
   if (slaves.reregistering.contains(slaveInfo.id())) {
@@ -4245,6 +4865,26 @@ void Master::reregisterSlave(
     return;
   }
 
+  // Pace the readmission of the slaves after a failover, the slave
+  // retries re-registering with a backoff. We do so before removing
+  // the slave from the recovered slaves below, so that it is still
+  // removed if it does not get readmitted in time.
+  if (flags.max_reregistering_slaves.isSome() &&
+      slaves.reregistering.size() >= flags.max_reregistering_slaves.get()) {
+    LOG(INFO)
+      << "Ignoring re-register slave message from slave "
+      << slaveInfo.id() << " at " << from << " ("
+      << slaveInfo.hostname() << ") as "
+      << slaves.reregistering.size() << " slaves are being readmitted";
+
+    ++metrics->recovery_slave_reregistrations_deferred;
+    return;
+  }
+
+  // Ensure we don't remove the slave for not re-registering after
+  // we've recovered it from the registry.
+  slaves.recovered.erase(slaveInfo.id());
+
   LOG(INFO) << "Re-registering slave " << slaveInfo.id() << " at " << from
             << " (" << slaveInfo.hostname() << ")";
 
@@ -4301,6 +4941,11 @@ void Master::_reregisterSlave(
     machineId.set_hostname(slaveInfo.hostname());
     machineId.set_ip(stringify(pid.address.ip));
 
+    vector<shared_ptr<const ExecutorInfo>> executors;
+    foreach (const ExecutorInfo& executorInfo, executorInfos) {
+      executors.push_back(internedExecutorInfos.intern(executorInfo));
+    }
+
     Slave* slave = new Slave(
         slaveInfo,
         pid,
@@ -4308,7 +4953,7 @@ void Master::_reregisterSlave(
         version,
         Clock::now(),
         checkpointedResources,
-        executorInfos,
+        executors,
         tasks);
 
     slave->reregisteredTime = Clock::now();
@@ -4454,19 +5099,49 @@ void Master::updateSlave(
 }
 
 
+void Master::updateImagePulls(
+    const UPID& from,
+    const SlaveID& slaveId,
+    const vector<ImagePull>& pulls)
+{
+  Slave* slave = slaves.registered.get(slaveId);
+  if (slave == NULL) {
+    LOG(WARNING) << "Ignoring image pulls of unknown slave " << slaveId;
+    return;
+  }
+
+  if (slave->pid != from) {
+    LOG(WARNING) << "Ignoring image pulls of slave " << *slave
+                 << " from unexpected " << from;
+    return;
+  }
+
+  slave->imagePulls = pulls;
+}
+
+
 void Master::updateUnavailability(
     const MachineID& machineId,
     const Option<Unavailability>& unavailability)
 {
+  MachineInfo& info = machines[machineId].info;
+
+  // Only update the allocator and rescind offers if the
+  // unavailability has actually changed.
+  const Option<Unavailability> current = info.has_unavailability()
+    ? Option<Unavailability>(info.unavailability())
+    : None();
+
+  if (current == unavailability) {
+    return;
+  }
+
   if (unavailability.isSome()) {
-    machines[machineId].info.mutable_unavailability()->CopyFrom(
-        unavailability.get());
+    info.mutable_unavailability()->CopyFrom(unavailability.get());
   } else {
-    machines[machineId].info.clear_unavailability();
+    info.clear_unavailability();
   }
 
-  // TODO(jmlvanre): Only update allocator and rescind offers if the
-  // unavailability has actually changed.
   if (machines.contains(machineId)) {
     // For every slave on this machine, update the allocator.
     foreach (const SlaveID& slaveId, machines[machineId].slaves) {
@@ -4528,6 +5203,25 @@ void Master::updateUnavailability(
 // because the status updates will be sent by the slave.
 //
 // TODO(vinod): Add a benchmark test for status update handling.
+void Master::statusUpdates(
+    const vector<StatusUpdate>& updates,
+    const UPID& pid)
+{
+  // Only slaves that handle batched acknowledgements send batched
+  // updates, so we batch the acknowledgements for such a slave too.
+  if (!updates.empty()) {
+    Slave* slave = slaves.registered.get(updates.front().slave_id());
+    if (slave != NULL && slave->pid == pid) {
+      slave->batchStatusUpdates = true;
+    }
+  }
+
+  foreach (const StatusUpdate& update, updates) {
+    statusUpdate(update, pid);
+  }
+}
+
+
 void Master::statusUpdate(StatusUpdate update, const UPID& pid)
 {
   ++metrics->messages_status_update;
@@ -4726,24 +5420,38 @@ void Master::shutdown(
 
 void Master::shutdownSlave(const SlaveID& slaveId, const string& message)
 {
-  if (!slaves.registered.contains(slaveId)) {
-    // Possible when the SlaveObserver dispatched to shutdown a slave,
-    // but exited() was already called for this slave.
-    LOG(WARNING) << "Unable to shutdown unknown slave " << slaveId;
-    return;
-  }
-
-  Slave* slave = slaves.registered.get(slaveId);
-  CHECK_NOTNULL(slave);
+  shutdownSlaves({slaveId}, message);
+}
 
-  LOG(WARNING) << "Shutting down slave " << *slave << " with message '"
-               << message << "'";
 
+void Master::shutdownSlaves(
+    const vector<SlaveID>& slaveIds,
+    const string& message)
+{
   ShutdownMessage message_;
   message_.set_message(message);
-  send(slave->pid, message_);
 
-  removeSlave(slave, message, metrics->slave_removals_reason_unhealthy);
+  vector<Slave*> _slaves;
+  foreach (const SlaveID& slaveId, slaveIds) {
+    if (!slaves.registered.contains(slaveId)) {
+      // Possible when the SlaveObserver dispatched to shutdown a
+      // slave, but exited() was already called for this slave.
+      LOG(WARNING) << "Unable to shutdown unknown slave " << slaveId;
+      continue;
+    }
+
+    Slave* slave = slaves.registered.get(slaveId);
+    CHECK_NOTNULL(slave);
+
+    LOG(WARNING) << "Shutting down slave " << *slave << " with message '"
+                 << message << "'";
+
+    send(slave->pid, message_);
+
+    _slaves.push_back(slave);
+  }
+
+  removeSlaves(_slaves, message, metrics->slave_removals_reason_unhealthy);
 }
 
 
@@ -4801,77 +5509,89 @@ void Master::_reconcileTasks(
 
   ++metrics->messages_reconcile_tasks;
 
-  if (statuses.empty()) {
-    // Implicit reconciliation.
+  const bool implicit = statuses.empty();
+
+  // Implicit reconciliation answers for each task currently known.
+  vector<TaskStatus> tasks;
+
+  if (implicit) {
     LOG(INFO) << "Performing implicit task state reconciliation"
                  " for framework " << *framework;
 
     foreachvalue (const TaskInfo& task, framework->pendingTasks) {
-      const StatusUpdate& update = protobuf::createStatusUpdate(
-          framework->id(),
-          task.slave_id(),
-          task.task_id(),
-          TASK_STAGING,
-          TaskStatus::SOURCE_MASTER,
-          None(),
-          "Reconciliation: Latest task state",
-          TaskStatus::REASON_RECONCILIATION);
-
-      VLOG(1) << "Sending implicit reconciliation state "
-              << update.status().state()
-              << " for task " << update.status().task_id()
-              << " of framework " << *framework;
+      TaskStatus status;
+      status.mutable_task_id()->CopyFrom(task.task_id());
+      status.mutable_slave_id()->CopyFrom(task.slave_id());
+      status.set_state(TASK_STAGING); // Dummy status.
 
-      // TODO(bmahler): Consider using forward(); might lead to too
-      // much logging.
-      StatusUpdateMessage message;
-      message.mutable_update()->CopyFrom(update);
-      framework->send(message);
+      tasks.push_back(status);
     }
 
     foreachvalue (Task* task, framework->tasks) {
-      const TaskState& state = task->has_status_update_state()
-          ? task->status_update_state()
-          : task->state();
+      TaskStatus status;
+      status.mutable_task_id()->CopyFrom(task->task_id());
+      status.mutable_slave_id()->CopyFrom(task->slave_id());
+      status.set_state(TASK_RUNNING); // Dummy status.
+
+      tasks.push_back(status);
+    }
+  } else {
+    LOG(INFO) << "Performing explicit task state reconciliation for "
+              << statuses.size() << " tasks of framework " << *framework;
+  }
 
-      const Option<ExecutorID>& executorId = task->has_executor_id()
-          ? Option<ExecutorID>(task->executor_id())
-          : None();
+  const vector<TaskStatus>& reconciliations = implicit ? tasks : statuses;
 
-      const StatusUpdate& update = protobuf::createStatusUpdate(
-          framework->id(),
-          task->slave_id(),
-          task->task_id(),
-          state,
-          TaskStatus::SOURCE_MASTER,
-          None(),
-          "Reconciliation: Latest task state",
-          TaskStatus::REASON_RECONCILIATION,
-          executorId,
-          protobuf::getTaskHealth(*task),
-          None(),
-          protobuf::getTaskContainerStatus(*task));
-
-      VLOG(1) << "Sending implicit reconciliation state "
-              << update.status().state()
-              << " for task " << update.status().task_id()
+  bool batched = false;
+  foreach (const FrameworkInfo::Capability& capability,
+           framework->info.capabilities()) {
+    if (capability.type() == FrameworkInfo::Capability::RECONCILE_RESULT) {
+      batched = true;
+    }
+  }
+
+  if (batched) {
+    // We answer the reconciliation in batches, computing the answers
+    // only when sending them so that they reflect the latest state
+    // of the tasks.
+    foreach (const TaskStatus& status, reconciliations) {
+      framework->reconciliations.push_back({status, implicit});
+    }
+
+    if (!framework->sendingReconcileResults) {
+      sendReconcileResults(framework->id());
+    }
+
+    return;
+  }
+
+  foreach (const TaskStatus& status, reconciliations) {
+    const Option<StatusUpdate> update = reconcileTask(framework, status);
+
+    if (update.isSome()) {
+      VLOG(1) << "Sending " << (implicit ? "implicit" : "explicit")
+              << " reconciliation state "
+              << update.get().status().state()
+              << " for task " << update.get().status().task_id()
               << " of framework " << *framework;
 
       // TODO(bmahler): Consider using forward(); might lead to too
       // much logging.
       StatusUpdateMessage message;
-      message.mutable_update()->CopyFrom(update);
+      message.mutable_update()->CopyFrom(update.get());
       framework->send(message);
     }
-
-    return;
   }
+}
+
 
-  // Explicit reconciliation.
-  LOG(INFO) << "Performing explicit task state reconciliation for "
-            << statuses.size() << " tasks of framework " << *framework;
+Option<StatusUpdate> Master::reconcileTask(
+    Framework* framework,
+    const TaskStatus& status)
+{
+  CHECK_NOTNULL(framework);
 
-  // Explicit reconciliation occurs for the following cases:
+  // Reconciliation occurs for the following cases:
   //   (1) Task is known, but pending: TASK_STAGING.
   //   (2) Task is known: send the latest state.
   //   (3) Task is unknown, slave is registered: TASK_LOST.
@@ -4884,92 +5604,167 @@ void Master::_reconcileTasks(
   // action for TASK_LOST. Later, if the task is running, the
   // framework can discover it with implicit reconciliation and will
   // be able to kill it.
-  foreach (const TaskStatus& status, statuses) {
-    Option<SlaveID> slaveId = None();
-    if (status.has_slave_id()) {
-      slaveId = status.slave_id();
-    }
-
-    Option<StatusUpdate> update = None();
-    Task* task = framework->getTask(status.task_id());
-
-    if (framework->pendingTasks.contains(status.task_id())) {
-      // (1) Task is known, but pending: TASK_STAGING.
-      const TaskInfo& task_ = framework->pendingTasks[status.task_id()];
-      update = protobuf::createStatusUpdate(
-          framework->id(),
-          task_.slave_id(),
-          task_.task_id(),
-          TASK_STAGING,
-          TaskStatus::SOURCE_MASTER,
-          None(),
-          "Reconciliation: Latest task state",
-          TaskStatus::REASON_RECONCILIATION);
-    } else if (task != NULL) {
-      // (2) Task is known: send the latest status update state.
-      const TaskState& state = task->has_status_update_state()
-          ? task->status_update_state()
-          : task->state();
-
-      const Option<ExecutorID> executorId = task->has_executor_id()
-          ? Option<ExecutorID>(task->executor_id())
-          : None();
-
-      update = protobuf::createStatusUpdate(
-          framework->id(),
-          task->slave_id(),
-          task->task_id(),
-          state,
-          TaskStatus::SOURCE_MASTER,
-          None(),
-          "Reconciliation: Latest task state",
-          TaskStatus::REASON_RECONCILIATION,
-          executorId,
-          protobuf::getTaskHealth(*task),
-          None(),
-          protobuf::getTaskContainerStatus(*task));
-    } else if (slaveId.isSome() && slaves.registered.contains(slaveId.get())) {
-      // (3) Task is unknown, slave is registered: TASK_LOST.
-      update = protobuf::createStatusUpdate(
-          framework->id(),
-          slaveId.get(),
-          status.task_id(),
-          TASK_LOST,
-          TaskStatus::SOURCE_MASTER,
-          None(),
-          "Reconciliation: Task is unknown to the slave",
-          TaskStatus::REASON_RECONCILIATION);
-    } else if (slaves.transitioning(slaveId)) {
-      // (4) Task is unknown, slave is transitionary: no-op.
-      LOG(INFO) << "Dropping reconciliation of task " << status.task_id()
-                << " for framework " << *framework
-                << " because there are transitional slaves";
-    } else {
-      // (5) Task is unknown, slave is unknown: TASK_LOST.
-      update = protobuf::createStatusUpdate(
-          framework->id(),
-          slaveId,
-          status.task_id(),
-          TASK_LOST,
-          TaskStatus::SOURCE_MASTER,
-          None(),
-          "Reconciliation: Task is unknown",
-          TaskStatus::REASON_RECONCILIATION);
+  Option<SlaveID> slaveId = None();
+  if (status.has_slave_id()) {
+    slaveId = status.slave_id();
+  }
+
+  Task* task = framework->getTask(status.task_id());
+
+  if (framework->pendingTasks.contains(status.task_id())) {
+    // (1) Task is known, but pending: TASK_STAGING.
+    const TaskInfo& task_ = framework->pendingTasks[status.task_id()];
+    return protobuf::createStatusUpdate(
+        framework->id(),
+        task_.slave_id(),
+        task_.task_id(),
+        TASK_STAGING,
+        TaskStatus::SOURCE_MASTER,
+        None(),
+        "Reconciliation: Latest task state",
+        TaskStatus::REASON_RECONCILIATION);
+  } else if (task != NULL) {
+    // (2) Task is known: send the latest status update state.
+    const TaskState& state = task->has_status_update_state()
+        ? task->status_update_state()
+        : task->state();
+
+    const Option<ExecutorID> executorId = task->has_executor_id()
+        ? Option<ExecutorID>(task->executor_id())
+        : None();
+
+    return protobuf::createStatusUpdate(
+        framework->id(),
+        task->slave_id(),
+        task->task_id(),
+        state,
+        TaskStatus::SOURCE_MASTER,
+        None(),
+        "Reconciliation: Latest task state",
+        TaskStatus::REASON_RECONCILIATION,
+        executorId,
+        protobuf::getTaskHealth(*task),
+        None(),
+        protobuf::getTaskContainerStatus(*task));
+  } else if (slaveId.isSome() && slaves.registered.contains(slaveId.get())) {
+    // (3) Task is unknown, slave is registered: TASK_LOST.
+    return protobuf::createStatusUpdate(
+        framework->id(),
+        slaveId.get(),
+        status.task_id(),
+        TASK_LOST,
+        TaskStatus::SOURCE_MASTER,
+        None(),
+        "Reconciliation: Task is unknown to the slave",
+        TaskStatus::REASON_RECONCILIATION);
+  } else if (slaves.transitioning(slaveId)) {
+    // (4) Task is unknown, slave is transitionary: no-op.
+    LOG(INFO) << "Dropping reconciliation of task " << status.task_id()
+              << " for framework " << *framework
+              << " because there are transitional slaves";
+
+    return None();
+  }
+
+  // (5) Task is unknown, slave is unknown: TASK_LOST.
+  return protobuf::createStatusUpdate(
+      framework->id(),
+      slaveId,
+      status.task_id(),
+      TASK_LOST,
+      TaskStatus::SOURCE_MASTER,
+      None(),
+      "Reconciliation: Task is unknown",
+      TaskStatus::REASON_RECONCILIATION);
+}
+
+
+void Master::sendReconcileResults(const FrameworkID& frameworkId)
+{
+  Framework* framework = getFramework(frameworkId);
+  if (framework == NULL) {
+    return;
+  }
+
+  framework->sendingReconcileResults = false;
+
+  if (framework->reconciliations.empty()) {
+    return;
+  }
+
+  if (!framework->connected) {
+    // The framework has to reconcile again once it reconnects.
+    LOG(INFO) << "Dropping " << framework->reconciliations.size()
+              << " pending reconciliations of disconnected framework "
+              << *framework;
+
+    framework->reconciliations.clear();
+    return;
+  }
+
+  if (framework->http.isSome()) {
+    // Rather than having 'Framework::send' drop the results (and
+    // disconnect the framework) when the scheduler does not keep up,
+    // we send the next batch once it has read the buffered events.
+    const Future<Nothing> writable = framework->http.get().writer.writable();
+
+    if (!writable.isReady()) {
+      if (!writable.isPending()) {
+        // The connection is closed, the framework has to reconcile
+        // again once it resubscribes.
+        framework->reconciliations.clear();
+        return;
+      }
+
+      framework->sendingReconcileResults = true;
+      writable.onAny(defer(self(), &Self::sendReconcileResults, frameworkId));
+      return;
+    }
+  }
+
+  ReconcileResultMessage message;
+
+  while (!framework->reconciliations.empty() &&
+         (size_t) message.updates_size() < RECONCILIATION_BATCH_SIZE) {
+    const Framework::Reconciliation reconciliation =
+      framework->reconciliations.front();
+
+    framework->reconciliations.pop_front();
+
+    const TaskID& taskId = reconciliation.status.task_id();
+
+    // A task that was known at the time of an implicit
+    // reconciliation but has been removed since then is not
+    // answered, the framework has received its terminal update.
+    if (reconciliation.implicit &&
+        !framework->pendingTasks.contains(taskId) &&
+        framework->getTask(taskId) == NULL) {
+      continue;
     }
 
+    const Option<StatusUpdate> update =
+      reconcileTask(framework, reconciliation.status);
+
     if (update.isSome()) {
-      VLOG(1) << "Sending explicit reconciliation state "
+      VLOG(1) << "Sending reconciliation state "
               << update.get().status().state()
-              << " for task " << update.get().status().task_id()
+              << " for task " << taskId
               << " of framework " << *framework;
 
-      // TODO(bmahler): Consider using forward(); might lead to too
-      // much logging.
-      StatusUpdateMessage message;
-      message.mutable_update()->CopyFrom(update.get());
-      framework->send(message);
+      message.add_updates()->CopyFrom(update.get());
     }
   }
+
+  if (message.updates_size() > 0) {
+    framework->send(message);
+  }
+
+  if (!framework->reconciliations.empty()) {
+    // We send the next batch once the master has handled the
+    // messages it received in the meantime.
+    framework->sendingReconcileResults = true;
+    dispatch(self(), &Self::sendReconcileResults, frameworkId);
+  }
 }
 
 
@@ -5084,7 +5879,7 @@ void Master::offer(const FrameworkID& frameworkId,
 
     // Add all framework's executors running on this slave.
     if (slave->executors.contains(framework->id())) {
-      const hashmap<ExecutorID, ExecutorInfo>& executors =
+      const hashmap<ExecutorID, shared_ptr<const ExecutorInfo>>& executors =
         slave->executors[framework->id()];
       foreachkey (const ExecutorID& executorId, executors) {
         offer->add_executor_ids()->MergeFrom(executorId);
@@ -5100,17 +5895,22 @@ void Master::offer(const FrameworkID& frameworkId,
     }
 
     offers[offer->id()] = offer;
+    metrics->outstanding_offers = offers.size();
+
+    shared_ptr<OfferTrace> trace(new OfferTrace());
+    trace->offerId = offer->id();
+    trace->frameworkId = framework->id();
+    trace->slaveId = slave->id;
+    trace->offered = Clock::now();
+
+    offerTraces.outstanding[offer->id()] = trace;
 
     framework->addOffer(offer);
     slave->addOffer(offer);
 
     if (flags.offer_timeout.isSome()) {
       // Rescind the offer after the timeout elapses.
-      offerTimers[offer->id()] =
-        delay(flags.offer_timeout.get(),
-              self(),
-              &Self::offerTimeout,
-              offer->id());
+      addOfferTimeout(offer->id());
     }
 
     // TODO(jieyu): For now, we strip 'ephemeral_ports' resource from
@@ -5208,11 +6008,7 @@ void Master::inverseOffer(
     // timeout?
     if (flags.offer_timeout.isSome()) {
       // Rescind the inverse offer after the timeout elapses.
-      inverseOfferTimers[inverseOffer->id()] =
-        delay(flags.offer_timeout.get(),
-              self(),
-              &Self::inverseOfferTimeout,
-              inverseOffer->id());
+      addOfferTimeout(inverseOffer->id());
     }
 
     // Add the inverse offer *AND* the corresponding slave's PID.
@@ -5305,6 +6101,23 @@ void Master::authenticate(const UPID& from, const UPID& pid)
     return;
   }
 
+  // Bound the number of ongoing authentications, see
+  // '--max_concurrent_authentications'. A queued up client which asks
+  // again keeps its place in the queue.
+  if (flags.max_concurrent_authentications.isSome() &&
+      authenticating.size() >= flags.max_concurrent_authentications.get()) {
+    if (!queuedAuthentications.contains(pid)) {
+      LOG(INFO) << "Queuing up authentication request from " << pid
+                << " because " << authenticating.size()
+                << " authentications are in progress";
+
+      authenticationQueue.push_back(pid);
+    }
+
+    queuedAuthentications[pid] = from;
+    return;
+  }
+
   LOG(INFO) << "Authenticating " << pid;
 
   // Start authentication.
@@ -5342,6 +6155,20 @@ void Master::_authenticate(
   }
 
   authenticating.erase(pid);
+
+  // Start the authentication which has been waiting the longest.
+  while (!authenticationQueue.empty()) {
+    const UPID next = authenticationQueue.front();
+    authenticationQueue.pop_front();
+
+    Option<UPID> from = queuedAuthentications.get(next);
+    queuedAuthentications.erase(next);
+
+    if (from.isSome()) {
+      authenticate(from.get(), next);
+      break;
+    }
+  }
 }
 
 
@@ -5518,6 +6345,22 @@ void Master::addFramework(Framework* framework)
 
   frameworks.registered[framework->id()] = framework;
 
+  if (framework->connected) {
+    ++metrics->frameworks_connected;
+  } else {
+    ++metrics->frameworks_disconnected;
+  }
+
+  if (framework->active) {
+    ++metrics->frameworks_active;
+  } else {
+    ++metrics->frameworks_inactive;
+  }
+
+  metrics->tasks_staging += framework->pendingTasks.size();
+
+  stream("FRAMEWORK_ADDED", "framework", JSON::protobuf(framework->info));
+
   if (framework->pid.isSome()) {
     link(framework->pid.get());
   } else {
@@ -5546,6 +6389,12 @@ void Master::addFramework(Framework* framework)
 
   // Export framework metrics.
 
+  CHECK(!metrics->framework_offers.contains(framework->id()));
+  metrics->framework_offers.put(
+      framework->id(),
+      Owned<Metrics::FrameworkOffers>(
+          new Metrics::FrameworkOffers(framework->id())));
+
   // If the framework is authenticated, its principal should be in
   // 'authenticated'. Otherwise look if it's supplied in
   // FrameworkInfo.
@@ -5658,13 +6507,18 @@ void Master::_failoverFramework(Framework* framework)
   // We do this after we have updated the pid and sent the framework
   // registered message so that the allocator can immediately re-offer
   // these resources to this framework if it wants.
+  vector<Recovery> recoveries;
   foreach (Offer* offer, utils::copy(framework->offers)) {
-    allocator->recoverResources(
-        offer->framework_id(), offer->slave_id(), offer->resources(), None());
+    recoveries.push_back(Recovery{
+        offer->framework_id(), offer->slave_id(), offer->resources(), None()});
 
     removeOffer(offer);
   }
 
+  if (!recoveries.empty()) {
+    allocator->bulkRecoverResources(recoveries);
+  }
+
   // Also remove the inverse offers.
   foreach (InverseOffer* inverseOffer, utils::copy(framework->inverseOffers)) {
     allocator->updateInverseOffer(
@@ -5679,13 +6533,19 @@ void Master::_failoverFramework(Framework* framework)
   }
 
   // Reconnect and reactivate the framework.
-  framework->connected = true;
+  if (!framework->connected) {
+    framework->connected = true;
+    ++metrics->frameworks_connected;
+    --metrics->frameworks_disconnected;
+  }
 
   // Reactivate the framework.
   // NOTE: We do this after recovering resources (above) so that
   // the allocator has the correct view of the framework's share.
   if (!framework->active) {
     framework->active = true;
+    ++metrics->frameworks_active;
+    --metrics->frameworks_inactive;
     allocator->activateFramework(framework->id());
   }
 
@@ -5731,6 +6591,7 @@ void Master::removeFramework(Framework* framework)
   }
 
   // Remove the pending tasks from the framework.
+  metrics->tasks_staging -= framework->pendingTasks.size();
   framework->pendingTasks.clear();
 
   // Remove pointers to the framework's tasks in slaves.
@@ -5770,16 +6631,18 @@ void Master::removeFramework(Framework* framework)
   }
 
   // Remove the framework's offers (if they weren't removed before).
+  vector<Recovery> recoveries;
   foreach (Offer* offer, utils::copy(framework->offers)) {
-    allocator->recoverResources(
-        offer->framework_id(),
-        offer->slave_id(),
-        offer->resources(),
-        None());
+    recoveries.push_back(Recovery{
+        offer->framework_id(), offer->slave_id(), offer->resources(), None()});
 
     removeOffer(offer);
   }
 
+  if (!recoveries.empty()) {
+    allocator->bulkRecoverResources(recoveries);
+  }
+
   // Also remove the inverse offers.
   foreach (InverseOffer* inverseOffer, utils::copy(framework->inverseOffers)) {
     allocator->updateInverseOffer(
@@ -5842,8 +6705,25 @@ void Master::removeFramework(Framework* framework)
     }
   }
 
+  metrics->framework_offers.erase(framework->id());
+
   // Remove the framework.
   frameworks.registered.erase(framework->id());
+
+  if (framework->connected) {
+    --metrics->frameworks_connected;
+  } else {
+    --metrics->frameworks_disconnected;
+  }
+
+  if (framework->active) {
+    --metrics->frameworks_active;
+  } else {
+    --metrics->frameworks_inactive;
+  }
+
+  stream("FRAMEWORK_REMOVED", "framework", JSON::protobuf(framework->info));
+
   allocator->removeFramework(framework->id());
 }
 
@@ -5903,28 +6783,35 @@ void Master::addSlave(
   slaves.removed.erase(slave->id);
   slaves.registered.put(slave);
 
+  CHECK(slave->connected);
+  CHECK(slave->active);
+  nonStaticClusterResources +=
+    Resources(slave->info.resources()).unreserved().scalars();
+
+  ++metrics->slaves_connected;
+  ++metrics->slaves_active;
+
+  // The task counts of the slave are kept up to date in the task
+  // state gauges while it is registered.
+  slave->metrics = metrics.get();
+  foreachpair (const TaskState& state, size_t count, slave->taskStates) {
+    metrics->addTasks(state, count);
+  }
+
+  stream("SLAVE_ADDED", "slave", JSON::protobuf(slave->info));
+
   link(slave->pid);
 
   // Map the slave to the machine it is running on.
   CHECK(!machines[slave->machineId].slaves.contains(slave->id));
   machines[slave->machineId].slaves.insert(slave->id);
 
-  // Set up an observer for the slave.
-  slave->observer = new SlaveObserver(
-      slave->pid,
-      slave->info,
-      slave->id,
-      self(),
-      slaves.limiter,
-      metrics,
-      flags.slave_ping_timeout,
-      flags.max_slave_ping_timeouts);
-
-  spawn(slave->observer);
+  // Start health checking the slave.
+  dispatch(observer, &SlaveObserver::add, slave->id, slave->pid);
 
   // Add the slave's executors to the frameworks.
   foreachkey (const FrameworkID& frameworkId, slave->executors) {
-    foreachvalue (const ExecutorInfo& executorInfo,
+    foreachvalue (const shared_ptr<const ExecutorInfo>& executorInfo,
                   slave->executors[frameworkId]) {
       Framework* framework = getFramework(frameworkId);
       if (framework != NULL) { // The framework might not be re-registered yet.
@@ -6001,159 +6888,275 @@ void Master::removeSlave(
 {
   CHECK_NOTNULL(slave);
 
-  LOG(INFO) << "Removing slave " << *slave << ": " << message;
+  removeSlaves({slave}, message, reason);
+}
+
+
+void Master::removeSlaves(
+    const vector<Slave*>& _slaves,
+    const string& message,
+    Option<Counter> reason)
+{
+  if (_slaves.empty()) {
+    return;
+  }
+
+  vector<SlaveID> slaveIds;
+  foreach (Slave* slave, _slaves) {
+    CHECK_NOTNULL(slave);
+
+    LOG(INFO) << "Removing slave " << *slave << ": " << message;
+
+    slaveIds.push_back(slave->id);
+  }
 
-  // We want to remove the slave first, to avoid the allocator
+  // We want to remove the slaves first, to avoid the allocator
   // re-allocating the recovered resources.
   //
-  // NOTE: Removing the slave is not sufficient for recovering the
+  // NOTE: Removing the slaves is not sufficient for recovering the
   // resources in the allocator, because the "Sorters" are updated
-  // only within recoverResources() (see MESOS-621). The calls to
-  // recoverResources() below are therefore required, even though
-  // the slave is already removed.
-  allocator->removeSlave(slave->id);
+  // only within recoverResources() (see MESOS-621). The recovery of
+  // the resources below is therefore required, even though the
+  // slaves are already removed.
+  allocator->bulkRemoveSlaves(slaveIds);
 
   // Transition the tasks to lost and remove them, BUT do not send
   // updates. Rather, build up the updates so that we can send them
-  // after the slave is removed from the registry.
+  // after the slaves are removed from the registry.
   vector<StatusUpdate> updates;
-  foreachkey (const FrameworkID& frameworkId, utils::copy(slave->tasks)) {
-    foreachvalue (Task* task, utils::copy(slave->tasks[frameworkId])) {
-      const StatusUpdate& update = protobuf::createStatusUpdate(
-          task->framework_id(),
-          task->slave_id(),
-          task->task_id(),
-          TASK_LOST,
-          TaskStatus::SOURCE_MASTER,
-          None(),
-          "Slave " + slave->info.hostname() + " removed: " + message,
-          TaskStatus::REASON_SLAVE_REMOVED,
-          (task->has_executor_id() ?
-              Option<ExecutorID>(task->executor_id()) : None()));
+  vector<Recovery> recoveries;
+  vector<SlaveInfo> slaveInfos;
 
-      updateTask(task, update);
-      removeTask(task);
+  foreach (Slave* slave, _slaves) {
+    foreachkey (const FrameworkID& frameworkId, utils::copy(slave->tasks)) {
+      foreachvalue (Task* task, utils::copy(slave->tasks[frameworkId])) {
+        const StatusUpdate& update = protobuf::createStatusUpdate(
+            task->framework_id(),
+            task->slave_id(),
+            task->task_id(),
+            TASK_LOST,
+            TaskStatus::SOURCE_MASTER,
+            None(),
+            "Slave " + slave->info.hostname() + " removed: " + message,
+            TaskStatus::REASON_SLAVE_REMOVED,
+            (task->has_executor_id() ?
+                Option<ExecutorID>(task->executor_id()) : None()));
 
-      updates.push_back(update);
+        updateTask(task, update);
+        removeTask(task);
+
+        updates.push_back(update);
+      }
     }
-  }
 
-  // Remove executors from the slave for proper resource accounting.
-  foreachkey (const FrameworkID& frameworkId, utils::copy(slave->executors)) {
-    foreachkey (const ExecutorID& executorId,
-                utils::copy(slave->executors[frameworkId])) {
-      removeExecutor(slave, frameworkId, executorId);
+    // Remove executors from the slave for proper resource accounting.
+    foreachkey (const FrameworkID& frameworkId,
+                utils::copy(slave->executors)) {
+      foreachkey (const ExecutorID& executorId,
+                  utils::copy(slave->executors[frameworkId])) {
+        removeExecutor(slave, frameworkId, executorId);
+      }
     }
-  }
 
-  foreach (Offer* offer, utils::copy(slave->offers)) {
-    // TODO(vinod): We don't need to call 'Allocator::recoverResources'
-    // once MESOS-621 is fixed.
-    allocator->recoverResources(
-        offer->framework_id(), slave->id, offer->resources(), None());
+    foreach (Offer* offer, utils::copy(slave->offers)) {
+      // TODO(vinod): We don't need to recover the resources of the
+      // offers once MESOS-621 is fixed.
+      recoveries.push_back(Recovery{
+          offer->framework_id(), slave->id, offer->resources(), None()});
 
-    // Remove and rescind offers.
-    removeOffer(offer, true); // Rescind!
-  }
+      // Remove and rescind offers.
+      removeOffer(offer, true); // Rescind!
+    }
 
-  // Remove inverse offers because sending them for a slave that is
-  // gone doesn't make sense.
-  foreach (InverseOffer* inverseOffer, utils::copy(slave->inverseOffers)) {
-    // We don't need to update the allocator because we've already called
-    // `RemoveSlave()`.
-    // Remove and rescind inverse offers.
-    removeInverseOffer(inverseOffer, true); // Rescind!
-  }
+    // Remove inverse offers because sending them for a slave that is
+    // gone doesn't make sense.
+    foreach (InverseOffer* inverseOffer,
+             utils::copy(slave->inverseOffers)) {
+      // We don't need to update the allocator because we've already
+      // called `bulkRemoveSlaves()`.
+      // Remove and rescind inverse offers.
+      removeInverseOffer(inverseOffer, true); // Rescind!
+    }
 
-  // Mark the slave as being removed.
-  slaves.removing.insert(slave->id);
-  slaves.registered.remove(slave);
-  slaves.removed.put(slave->id, Nothing());
-  authenticated.erase(slave->pid);
+    // Mark the slave as being removed.
+    slaves.removing.insert(slave->id);
+    slaves.registered.remove(slave);
 
-  // Remove the slave from the `machines` mapping.
-  CHECK(machines.contains(slave->machineId));
-  CHECK(machines[slave->machineId].slaves.contains(slave->id));
-  machines[slave->machineId].slaves.erase(slave->id);
+    if (slave->active) {
+      nonStaticClusterResources -=
+        Resources(slave->info.resources()).unreserved().scalars();
+    }
+
+    if (slave->connected) {
+      --metrics->slaves_connected;
+    } else {
+      --metrics->slaves_disconnected;
+    }
+
+    if (slave->active) {
+      --metrics->slaves_active;
+    } else {
+      --metrics->slaves_inactive;
+    }
+
+    foreachpair (const TaskState& state, size_t count, slave->taskStates) {
+      metrics->addTasks(state, -static_cast<double>(count));
+    }
+    slave->metrics = NULL;
+
+    stream("SLAVE_REMOVED", "slave", JSON::protobuf(slave->info));
+
+    slaves.removed.put(slave->id, Nothing());
+    authenticated.erase(slave->pid);
+
+    // Remove the slave from the `machines` mapping.
+    CHECK(machines.contains(slave->machineId));
+    CHECK(machines[slave->machineId].slaves.contains(slave->id));
+    machines[slave->machineId].slaves.erase(slave->id);
+
+    // Stop health checking the slave.
+    dispatch(observer, &SlaveObserver::remove, slave->id);
+
+    // TODO(benh): unlink(slave->pid);
 
-  // Kill the slave observer.
-  terminate(slave->observer);
-  wait(slave->observer);
-  delete slave->observer;
+    slaveInfos.push_back(slave->info);
 
-  // TODO(benh): unlink(slave->pid);
+    delete slave;
+  }
+
+  if (!recoveries.empty()) {
+    allocator->bulkRecoverResources(recoveries);
+  }
+
+  // Remove the slaves from the registrar in a single operation. Once
+  // this is completed, we can forward the LOST task updates to the
+  // frameworks and notify all frameworks that the slaves were lost.
+  Owned<Operation> operation;
+  if (slaveInfos.size() == 1) {
+    operation.reset(new RemoveSlave(slaveInfos.front()));
+  } else {
+    operation.reset(new RemoveSlaves(slaveInfos));
+  }
 
-  // Remove this slave from the registrar. Once this is completed, we
-  // can forward the LOST task updates to the frameworks and notify
-  // all frameworks that this slave was lost.
-  registrar->apply(Owned<Operation>(new RemoveSlave(slave->info)))
+  registrar->apply(operation)
     .onAny(defer(self(),
-                 &Self::_removeSlave,
-                 slave->info,
+                 &Self::_removeSlaves,
+                 slaveInfos,
                  updates,
                  lambda::_1,
                  message,
                  reason));
-
-  delete slave;
 }
 
 
-void Master::_removeSlave(
-    const SlaveInfo& slaveInfo,
+void Master::_removeSlaves(
+    const vector<SlaveInfo>& slaveInfos,
     const vector<StatusUpdate>& updates,
     const Future<bool>& removed,
     const string& message,
     Option<Counter> reason)
 {
-  slaves.removing.erase(slaveInfo.id());
+  foreach (const SlaveInfo& slaveInfo, slaveInfos) {
+    slaves.removing.erase(slaveInfo.id());
+  }
 
   CHECK(!removed.isDiscarded());
 
   if (removed.isFailed()) {
-    LOG(FATAL) << "Failed to remove slave " << slaveInfo.id()
-               << " (" << slaveInfo.hostname() << ")"
+    LOG(FATAL) << "Failed to remove " << slaveInfos.size() << " slave(s)"
+               << " starting with " << slaveInfos.front().id()
+               << " (" << slaveInfos.front().hostname() << ")"
                << " from the registrar: " << removed.failure();
   }
 
   CHECK(removed.get())
-    << "Slave " << slaveInfo.id() << " (" << slaveInfo.hostname() << ") "
-    << "already removed from the registrar";
+    << slaveInfos.size() << " slave(s) starting with "
+    << slaveInfos.front().id() << " (" << slaveInfos.front().hostname()
+    << ") already removed from the registrar";
 
-  LOG(INFO) << "Removed slave " << slaveInfo.id() << " ("
-            << slaveInfo.hostname() << "): " << message;
+  foreach (const SlaveInfo& slaveInfo, slaveInfos) {
+    LOG(INFO) << "Removed slave " << slaveInfo.id() << " ("
+              << slaveInfo.hostname() << "): " << message;
 
-  ++metrics->slave_removals;
+    ++metrics->slave_removals;
 
-  if (reason.isSome()) {
-    ++utils::copy(reason.get()); // Remove const.
+    if (reason.isSome()) {
+      ++utils::copy(reason.get()); // Remove const.
+    }
   }
 
-  // Forward the LOST updates on to the framework.
+  // Forward the LOST updates on to the frameworks, in order for each
+  // framework.
+  hashmap<FrameworkID, vector<const StatusUpdate*>> lost;
   foreach (const StatusUpdate& update, updates) {
-    Framework* framework = getFramework(update.framework_id());
+    lost[update.framework_id()].push_back(&update);
+  }
+
+  foreachpair (const FrameworkID& frameworkId,
+               const vector<const StatusUpdate*>& _updates,
+               lost) {
+    Framework* framework = getFramework(frameworkId);
 
     if (framework == NULL) {
-      LOG(WARNING) << "Dropping update " << update << " from unknown framework "
-                   << update.framework_id();
-    } else {
-      forward(update, UPID(), framework);
+      LOG(WARNING) << "Dropping " << _updates.size() << " LOST update(s)"
+                   << " for unknown framework " << frameworkId;
+      continue;
     }
-  }
 
-  // Notify all frameworks of the lost slave.
-  foreachvalue (Framework* framework, frameworks.registered) {
-    LOG(INFO) << "Notifying framework " << *framework << " of lost slave "
-              << slaveInfo.id() << " (" << slaveInfo.hostname() << ") "
-              << "after recovering";
-    LostSlaveMessage message;
-    message.mutable_slave_id()->MergeFrom(slaveInfo.id());
-    framework->send(message);
+    bool batched = false;
+    foreach (const FrameworkInfo::Capability& capability,
+             framework->info.capabilities()) {
+      if (capability.type() == FrameworkInfo::Capability::RECONCILE_RESULT) {
+        batched = true;
+      }
+    }
+
+    if (!batched) {
+      foreach (const StatusUpdate* update, _updates) {
+        forward(*update, UPID(), framework);
+      }
+
+      continue;
+    }
+
+    // The LOST updates generated by the master are not acknowledged,
+    // like the answers to reconciliation, so a framework that can
+    // receive those in batches gets the LOST updates in batches too.
+    LOG(INFO) << "Sending " << _updates.size() << " LOST update(s)"
+              << " to framework " << *framework;
+
+    for (size_t i = 0; i < _updates.size(); i += RECONCILIATION_BATCH_SIZE) {
+      ReconcileResultMessage message;
+
+      const size_t end =
+        std::min(i + RECONCILIATION_BATCH_SIZE, _updates.size());
+
+      for (size_t j = i; j < end; j++) {
+        message.add_updates()->CopyFrom(*_updates[j]);
+      }
+
+      framework->send(message);
+    }
   }
 
-  // Finally, notify the `SlaveLost` hooks.
-  if (HookManager::hooksAvailable()) {
-    HookManager::masterSlaveLostHook(slaveInfo);
+  foreach (const SlaveInfo& slaveInfo, slaveInfos) {
+    // Notify all frameworks of the lost slave.
+    LostSlaveMessage lostSlave;
+    lostSlave.mutable_slave_id()->MergeFrom(slaveInfo.id());
+
+    Broadcast<LostSlaveMessage> broadcast(lostSlave);
+
+    foreachvalue (Framework* framework, frameworks.registered) {
+      LOG(INFO) << "Notifying framework " << *framework << " of lost slave "
+                << slaveInfo.id() << " (" << slaveInfo.hostname() << ") "
+                << "after recovering";
+      framework->send(broadcast);
+    }
+
+    // Finally, notify the `SlaveLost` hooks.
+    if (HookManager::hooksAvailable()) {
+      HookManager::masterSlaveLostHook(slaveInfo);
+    }
   }
 }
 
@@ -6176,6 +7179,10 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
 
   // Set 'terminated' to true if this is the first time the task
   // transitioned to terminal state. Also set the latest state.
+  // The slave owns the Task object and cannot be NULL.
+  Slave* slave = slaves.registered.get(task->slave_id());
+  CHECK_NOTNULL(slave);
+
   bool terminated;
   if (latestState.isSome()) {
     terminated = !protobuf::isTerminalState(task->state()) &&
@@ -6184,7 +7191,7 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
     // If the task has already transitioned to a terminal state,
     // do not update its state.
     if (!protobuf::isTerminalState(task->state())) {
-      task->set_state(latestState.get());
+      slave->updateTaskState(task, latestState.get());
     }
   } else {
     terminated = !protobuf::isTerminalState(task->state()) &&
@@ -6194,7 +7201,7 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
     // its state. Note that we are being defensive here because this should not
     // happen unless there is a bug in the master code.
     if (!protobuf::isTerminalState(task->state())) {
-      task->set_state(status.state());
+      slave->updateTaskState(task, status.state());
     }
   }
 
@@ -6213,6 +7220,21 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
   }
   task->add_statuses()->CopyFrom(status);
 
+  // Once the task is running, it is no longer waiting to run since
+  // the master launched it.
+  if (status.state() == TASK_RUNNING) {
+    Framework* framework = getFramework(task->framework_id());
+    if (framework != NULL &&
+        framework->launchTimes.contains(task->task_id())) {
+      if (metrics->framework_offers.contains(framework->id())) {
+        metrics->framework_offers[framework->id()]->accept_to_running.record(
+            Clock::now() - framework->launchTimes[task->task_id()]);
+      }
+
+      framework->launchTimes.erase(task->task_id());
+    }
+  }
+
   // Delete data (maybe very large since it's stored by on-top framework) we
   // are not interested in to avoid OOM.
   // For example: mesos-master is running on a machine with 4GB free memory,
@@ -6226,6 +7248,8 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
             << " (latest state: " << task->state()
             << ", status update state: " << status.state() << ")";
 
+  stream("TASK_UPDATED", "task", model(*task));
+
   // Once the task becomes terminal, we recover the resources.
   if (terminated) {
     allocator->recoverResources(
@@ -6234,10 +7258,6 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
         task->resources(),
         None());
 
-    // The slave owns the Task object and cannot be NULL.
-    Slave* slave = slaves.registered.get(task->slave_id());
-    CHECK_NOTNULL(slave);
-
     slave->taskTerminated(task);
 
     Framework* framework = getFramework(task->framework_id());
@@ -6297,15 +7317,58 @@ void Master::removeTask(Task* task)
   Framework* framework = getFramework(task->framework_id());
   if (framework != NULL) { // A framework might not be re-connected yet.
     framework->removeTask(task);
+    framework->launchTimes.erase(task->task_id());
   }
 
   // Remove from slave.
   slave->removeTask(task);
 
+  stream("TASK_REMOVED", "task", model(*task));
+
   delete task;
 }
 
 
+void Master::stream(
+    const string& type,
+    const string& key,
+    const JSON::Value& value)
+{
+  if (stateStreams.empty()) {
+    return;
+  }
+
+  JSON::Object event;
+  event.values["type"] = type;
+  event.values[key] = value;
+
+  const string record = ::recordio::Encoder<JSON::Object>(
+      [](const JSON::Object& object) { return stringify(object); })
+    .encode(event);
+
+  auto iterator = stateStreams.begin();
+  while (iterator != stateStreams.end()) {
+    Pipe::Writer writer = *iterator;
+
+    // Like for the schedulers, we disconnect a subscriber that
+    // doesn't keep up rather than buffering its events without bound.
+    if (!writer.writable().isReady()) {
+      LOG(WARNING) << "Disconnecting a subscriber of '/state/stream' that"
+                   << " has more than "
+                   << flags.max_http_framework_buffer_size
+                   << " of events buffered";
+
+      writer.fail("Too many events buffered");
+      iterator = stateStreams.erase(iterator);
+    } else if (!writer.write(record)) {
+      iterator = stateStreams.erase(iterator);
+    } else {
+      ++iterator;
+    }
+  }
+}
+
+
 void Master::removeExecutor(
     Slave* slave,
     const FrameworkID& frameworkId,
@@ -6314,14 +7377,15 @@ void Master::removeExecutor(
   CHECK_NOTNULL(slave);
   CHECK(slave->hasExecutor(frameworkId, executorId));
 
-  ExecutorInfo executor = slave->executors[frameworkId][executorId];
+  const shared_ptr<const ExecutorInfo> executor =
+    slave->executors[frameworkId][executorId];
 
   LOG(INFO) << "Removing executor '" << executorId
-            << "' with resources " << executor.resources()
+            << "' with resources " << executor->resources()
             << " of framework " << frameworkId << " on slave " << *slave;
 
   allocator->recoverResources(
-    frameworkId, slave->id, executor.resources(), None());
+    frameworkId, slave->id, executor->resources(), None());
 
   Framework* framework = getFramework(frameworkId);
   if (framework != NULL) { // The framework might not be re-registered yet.
@@ -6342,23 +7406,28 @@ void Master::apply(
 
   allocator->updateAllocation(framework->id(), slave->id, {operation});
 
-  _apply(slave, operation);
+  _apply(slave, {operation});
 }
 
 
-Future<Nothing> Master::apply(Slave* slave, const Offer::Operation& operation)
+Future<Nothing> Master::apply(
+    Slave* slave,
+    const vector<Offer::Operation>& operations)
 {
   CHECK_NOTNULL(slave);
 
-  return allocator->updateAvailable(slave->id, {operation})
-    .onReady(defer(self(), &Master::_apply, slave, operation));
+  return allocator->updateAvailable(slave->id, operations)
+    .onReady(defer(self(), &Master::_apply, slave, operations));
 }
 
 
-void Master::_apply(Slave* slave, const Offer::Operation& operation) {
+void Master::_apply(Slave* slave, const vector<Offer::Operation>& operations)
+{
   CHECK_NOTNULL(slave);
 
-  slave->apply(operation);
+  foreach (const Offer::Operation& operation, operations) {
+    slave->apply(operation);
+  }
 
   LOG(INFO) << "Sending checkpointed resources "
             << slave->checkpointedResources
@@ -6371,6 +7440,46 @@ void Master::_apply(Slave* slave, const Offer::Operation& operation) {
 }
 
 
+void Master::addOfferTimeout(const OfferID& offerId)
+{
+  CHECK_SOME(flags.offer_timeout);
+
+  offerTimeouts.push_back(
+      std::make_pair(Clock::now() + flags.offer_timeout.get(), offerId));
+
+  if (offerTimer.isNone()) {
+    offerTimer =
+      delay(flags.offer_timeout.get(), self(), &Self::expireOffers);
+  }
+}
+
+
+void Master::expireOffers()
+{
+  offerTimer = None();
+
+  const Time now = Clock::now();
+
+  while (!offerTimeouts.empty() && offerTimeouts.front().first <= now) {
+    const OfferID offerId = offerTimeouts.front().second;
+    offerTimeouts.pop_front();
+
+    if (offers.contains(offerId)) {
+      offerTimeout(offerId);
+    } else if (inverseOffers.contains(offerId)) {
+      inverseOfferTimeout(offerId);
+    }
+  }
+
+  if (!offerTimeouts.empty()) {
+    offerTimer = delay(
+        offerTimeouts.front().first - now,
+        self(),
+        &Self::expireOffers);
+  }
+}
+
+
 void Master::offerTimeout(const OfferID& offerId)
 {
   Offer* offer = getOffer(offerId);
@@ -6382,6 +7491,23 @@ void Master::offerTimeout(const OfferID& offerId)
 }
 
 
+void Master::answerOffer(Offer* offer, const string& outcome)
+{
+  if (!offerTraces.outstanding.contains(offer->id())) {
+    return;
+  }
+
+  shared_ptr<OfferTrace> trace = offerTraces.outstanding[offer->id()];
+  trace->answered = Clock::now();
+  trace->outcome = outcome;
+
+  if (metrics->framework_offers.contains(offer->framework_id())) {
+    metrics->framework_offers[offer->framework_id()]->offer_hold_time.record(
+        trace->answered.get() - trace->offered);
+  }
+}
+
+
 // TODO(vinod): Instead of 'removeOffer()', consider implementing
 // 'useOffer()', 'discardOffer()' and 'rescindOffer()' for clarity.
 void Master::removeOffer(Offer* offer, bool rescind)
@@ -6409,15 +7535,20 @@ void Master::removeOffer(Offer* offer, bool rescind)
     framework->send(message);
   }
 
-  // Remove and cancel offer removal timers. Canceling the Timers is
-  // only done to avoid having too many active Timers in libprocess.
-  if (offerTimers.contains(offer->id())) {
-    Clock::cancel(offerTimers[offer->id()]);
-    offerTimers.erase(offer->id());
+  if (offerTraces.outstanding.contains(offer->id())) {
+    shared_ptr<OfferTrace> trace = offerTraces.outstanding[offer->id()];
+
+    if (trace->outcome.isNone()) {
+      trace->outcome = rescind ? "RESCINDED" : "REMOVED";
+    }
+
+    offerTraces.completed.push_back(trace);
+    offerTraces.outstanding.erase(offer->id());
   }
 
   // Delete it.
   offers.erase(offer->id());
+  metrics->outstanding_offers = offers.size();
   delete offer;
 }
 
@@ -6464,13 +7595,6 @@ void Master::removeInverseOffer(InverseOffer* inverseOffer, bool rescind)
     framework->send(message);
   }
 
-  // Remove and cancel inverse offer removal timers. Canceling the Timers is
-  // only done to avoid having too many active Timers in libprocess.
-  if (inverseOfferTimers.contains(inverseOffer->id())) {
-    Clock::cancel(inverseOfferTimers[inverseOffer->id()]);
-    inverseOfferTimers.erase(inverseOffer->id());
-  }
-
   // Delete it.
   inverseOffers.erase(inverseOffer->id());
   delete inverseOffer;
@@ -6558,140 +7682,6 @@ double Master::_slaves_inactive()
 }
 
 
-double Master::_slaves_connected()
-{
-  double count = 0.0;
-  foreachvalue (Slave* slave, slaves.registered) {
-    if (slave->connected) {
-      count++;
-    }
-  }
-  return count;
-}
-
-
-double Master::_slaves_disconnected()
-{
-  double count = 0.0;
-  foreachvalue (Slave* slave, slaves.registered) {
-    if (!slave->connected) {
-      count++;
-    }
-  }
-  return count;
-}
-
-
-double Master::_frameworks_connected()
-{
-  double count = 0.0;
-  foreachvalue (Framework* framework, frameworks.registered) {
-    if (framework->connected) {
-      count++;
-    }
-  }
-  return count;
-}
-
-
-double Master::_frameworks_disconnected()
-{
-  double count = 0.0;
-  foreachvalue (Framework* framework, frameworks.registered) {
-    if (!framework->connected) {
-      count++;
-    }
-  }
-  return count;
-}
-
-
-double Master::_frameworks_active()
-{
-  double count = 0.0;
-  foreachvalue (Framework* framework, frameworks.registered) {
-    if (framework->active) {
-      count++;
-    }
-  }
-  return count;
-}
-
-
-double Master::_frameworks_inactive()
-{
-  double count = 0.0;
-  foreachvalue (Framework* framework, frameworks.registered) {
-    if (!framework->active) {
-      count++;
-    }
-  }
-  return count;
-}
-
-
-double Master::_tasks_staging()
-{
-  double count = 0.0;
-
-  // Add the tasks pending validation / authorization.
-  foreachvalue (Framework* framework, frameworks.registered) {
-    count += framework->pendingTasks.size();
-  }
-
-  foreachvalue (Slave* slave, slaves.registered) {
-    typedef hashmap<TaskID, Task*> TaskMap;
-    foreachvalue (const TaskMap& tasks, slave->tasks) {
-      foreachvalue (const Task* task, tasks) {
-        if (task->state() == TASK_STAGING) {
-          count++;
-        }
-      }
-    }
-  }
-
-  return count;
-}
-
-
-double Master::_tasks_starting()
-{
-  double count = 0.0;
-
-  foreachvalue (Slave* slave, slaves.registered) {
-    typedef hashmap<TaskID, Task*> TaskMap;
-    foreachvalue (const TaskMap& tasks, slave->tasks) {
-      foreachvalue (const Task* task, tasks) {
-        if (task->state() == TASK_STARTING) {
-          count++;
-        }
-      }
-    }
-  }
-
-  return count;
-}
-
-
-double Master::_tasks_running()
-{
-  double count = 0.0;
-
-  foreachvalue (Slave* slave, slaves.registered) {
-    typedef hashmap<TaskID, Task*> TaskMap;
-    foreachvalue (const TaskMap& tasks, slave->tasks) {
-      foreachvalue (const Task* task, tasks) {
-        if (task->state() == TASK_RUNNING) {
-          count++;
-        }
-      }
-    }
-  }
-
-  return count;
-}
-
-
 double Master::_resources_total(const string& name)
 {
   double total = 0.0;
@@ -19,8 +19,10 @@
 
 #include <stdint.h>
 
+#include <deque>
 #include <list>
 #include <memory>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -40,6 +42,7 @@
 
 #include <mesos/scheduler/scheduler.hpp>
 
+#include <process/dispatch.hpp>
 #include <process/limiter.hpp>
 #include <process/http.hpp>
 #include <process/owned.hpp>
@@ -50,6 +53,7 @@
 #include <process/metrics/counter.hpp>
 
 #include <stout/cache.hpp>
+#include <stout/flat_hashmap.hpp>
 #include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
@@ -58,6 +62,7 @@
 #include <stout/recordio.hpp>
 
 #include "common/http.hpp"
+#include "common/interner.hpp"
 #include "common/protobuf_utils.hpp"
 #include "common/resources_utils.hpp"
 
@@ -114,8 +119,8 @@ struct Slave
         const std::string& _version,
         const process::Time& _registeredTime,
         const Resources& _checkpointedResources,
-        const std::vector<ExecutorInfo> executorInfos =
-          std::vector<ExecutorInfo>(),
+        const std::vector<std::shared_ptr<const ExecutorInfo>> executorInfos =
+          std::vector<std::shared_ptr<const ExecutorInfo>>(),
         const std::vector<Task> tasks =
           std::vector<Task>())
     : id(_info.id()),
@@ -126,8 +131,9 @@ struct Slave
       registeredTime(_registeredTime),
       connected(true),
       active(true),
-      checkpointedResources(_checkpointedResources),
-      observer(NULL)
+      batchStatusUpdates(false),
+      metrics(NULL),
+      checkpointedResources(_checkpointedResources)
   {
     CHECK(_info.has_id());
 
@@ -139,9 +145,10 @@ struct Slave
     CHECK_SOME(resources);
     totalResources = resources.get();
 
-    foreach (const ExecutorInfo& executorInfo, executorInfos) {
-      CHECK(executorInfo.has_framework_id());
-      addExecutor(executorInfo.framework_id(), executorInfo);
+    foreach (const std::shared_ptr<const ExecutorInfo>& executorInfo,
+             executorInfos) {
+      CHECK(executorInfo->has_framework_id());
+      addExecutor(executorInfo->framework_id(), executorInfo);
     }
 
     foreach (const Task& task, tasks) {
@@ -168,6 +175,7 @@ struct Slave
       << "Duplicate task " << taskId << " of framework " << frameworkId;
 
     tasks[frameworkId][taskId] = task;
+    addTaskState(task->state());
 
     if (!protobuf::isTerminalState(task->state())) {
       usedResources[frameworkId] += task->resources();
@@ -178,6 +186,19 @@ struct Slave
               << " on slave " << id << " (" << info.hostname() << ")";
   }
 
+  // Transitions the task, which has to be a task on this slave, so
+  // that the task counts by state are updated.
+  void updateTaskState(Task* task, const TaskState& state)
+  {
+    CHECK(tasks[task->framework_id()].contains(task->task_id()))
+      << "Unknown task " << task->task_id()
+      << " of framework " << task->framework_id();
+
+    removeTaskState(task->state());
+    task->set_state(state);
+    addTaskState(state);
+  }
+
   // Notification of task termination, for resource accounting.
   // TODO(bmahler): This is a hack for performance. We need to
   // maintain resource counters because computing task resources
@@ -217,9 +238,17 @@ struct Slave
       tasks.erase(frameworkId);
     }
 
+    removeTaskState(task->state());
+
     killedTasks.remove(frameworkId, taskId);
   }
 
+  // Returns the number of tasks on this slave in the state.
+  size_t taskCount(const TaskState& state) const
+  {
+    return taskStates.get(state).getOrElse(0);
+  }
+
   void addOffer(Offer* offer)
   {
     CHECK(!offers.contains(offer)) << "Duplicate offer " << offer->id();
@@ -260,14 +289,14 @@ struct Slave
   }
 
   void addExecutor(const FrameworkID& frameworkId,
-                   const ExecutorInfo& executorInfo)
+                   const std::shared_ptr<const ExecutorInfo>& executorInfo)
   {
-    CHECK(!hasExecutor(frameworkId, executorInfo.executor_id()))
-      << "Duplicate executor '" << executorInfo.executor_id()
+    CHECK(!hasExecutor(frameworkId, executorInfo->executor_id()))
+      << "Duplicate executor '" << executorInfo->executor_id()
       << "' of framework " << frameworkId;
 
-    executors[frameworkId][executorInfo.executor_id()] = executorInfo;
-    usedResources[frameworkId] += executorInfo.resources();
+    executors[frameworkId][executorInfo->executor_id()] = executorInfo;
+    usedResources[frameworkId] += executorInfo->resources();
   }
 
   void removeExecutor(const FrameworkID& frameworkId,
@@ -277,7 +306,7 @@ struct Slave
       << "Unknown executor '" << executorId << "' of framework " << frameworkId;
 
     usedResources[frameworkId] -=
-      executors[frameworkId][executorId].resources();
+      executors[frameworkId][executorId]->resources();
 
     // XXX Remove.
 
@@ -317,8 +346,15 @@ struct Slave
   // No offers will be made for a deactivated slave.
   bool active;
 
-  // Executors running on this slave.
-  hashmap<FrameworkID, hashmap<ExecutorID, ExecutorInfo>> executors;
+  // Whether the slave forwards the status updates in batches, see
+  // 'Master::statusUpdates()'. Such a slave also handles batched
+  // acknowledgements of the updates.
+  bool batchStatusUpdates;
+
+  // Executors running on this slave. The ExecutorInfos are interned
+  // (see 'Master::internedExecutorInfos') and shared with the frameworks.
+  hashmap<FrameworkID,
+          hashmap<ExecutorID, std::shared_ptr<const ExecutorInfo>>> executors;
 
   // Tasks present on this slave.
   // TODO(bmahler): The task pointer ownership complexity arises from the fact
@@ -326,6 +362,15 @@ struct Slave
   // We should find a way to eliminate this.
   hashmap<FrameworkID, hashmap<TaskID, Task*>> tasks;
 
+  // The number of tasks in each state, which is kept up to date by
+  // 'addTask()', 'updateTaskState()' and 'removeTask()' so that the
+  // tasks need not be iterated over to count them, e.g., for metrics.
+  hashmap<TaskState, size_t> taskStates;
+
+  // The metrics of the master, which the task counts are added to
+  // while the slave is registered, see 'Master::addSlave()'.
+  Metrics* metrics;
+
   // Tasks that were asked to kill by frameworks.
   // This is used for reconciliation when the slave re-registers.
   multihashmap<FrameworkID, TaskID> killedTasks;
@@ -351,9 +396,33 @@ struct Slave
   // includes revocable resources as well.
   Resources totalResources;
 
-  SlaveObserver* observer;
+  // The pulls of the images prefetched by the slave, as last reported
+  // by the slave, see '/master/images'.
+  std::vector<ImagePull> imagePulls;
 
 private:
+  void addTaskState(const TaskState& state)
+  {
+    taskStates[state]++;
+
+    if (metrics != NULL) {
+      metrics->addTasks(state, 1);
+    }
+  }
+
+  void removeTaskState(const TaskState& state)
+  {
+    CHECK(taskStates.contains(state));
+
+    if (--taskStates[state] == 0) {
+      taskStates.erase(state);
+    }
+
+    if (metrics != NULL) {
+      metrics->addTasks(state, -1);
+    }
+  }
+
   Slave(const Slave&);              // No copying.
   Slave& operator=(const Slave&); // No assigning.
 };
@@ -469,6 +538,10 @@ public:
       StatusUpdate update,
       const process::UPID& pid);
 
+  void statusUpdates(
+      const std::vector<StatusUpdate>& updates,
+      const process::UPID& pid);
+
   void reconcileTasks(
       const process::UPID& from,
       const FrameworkID& frameworkId,
@@ -485,6 +558,11 @@ public:
       const SlaveID& slaveId,
       const Resources& oversubscribedResources);
 
+  void updateImagePulls(
+      const process::UPID& from,
+      const SlaveID& slaveId,
+      const std::vector<ImagePull>& pulls);
+
   void updateUnavailability(
       const MachineID& machineId,
       const Option<Unavailability>& unavailability);
@@ -493,6 +571,11 @@ public:
       const SlaveID& slaveId,
       const std::string& message);
 
+  // Shuts down several slaves at once, see 'removeSlaves'.
+  void shutdownSlaves(
+      const std::vector<SlaveID>& slaveIds,
+      const std::string& message);
+
   void authenticate(
       const process::UPID& from,
       const process::UPID& pid);
@@ -608,6 +691,16 @@ protected:
       Framework* framework,
       const std::vector<TaskStatus>& statuses);
 
+  // Returns the answer to the reconciliation of the task of 'status',
+  // or None if it can't be answered yet.
+  Option<StatusUpdate> reconcileTask(
+      Framework* framework,
+      const TaskStatus& status);
+
+  // Sends the next batch of answers to the pending reconciliations
+  // of a framework with the 'RECONCILE_RESULT' capability.
+  void sendReconcileResults(const FrameworkID& frameworkId);
+
   // Handles a known re-registering slave by reconciling the master's
   // view of the slave's tasks and executors.
   void reconcile(
@@ -660,8 +753,18 @@ protected:
       const std::string& message,
       Option<process::metrics::Counter> reason = None());
 
-  void _removeSlave(
-      const SlaveInfo& slaveInfo,
+  // Removes several slaves at once, e.g., the slaves that fail their
+  // health checks during a network partition. The slaves are removed
+  // from the allocator and from the registrar in a single operation,
+  // and the LOST updates of their tasks are forwarded in batches to
+  // each framework.
+  void removeSlaves(
+      const std::vector<Slave*>& _slaves,
+      const std::string& message,
+      Option<process::metrics::Counter> reason = None());
+
+  void _removeSlaves(
+      const std::vector<SlaveInfo>& slaveInfos,
       const std::vector<StatusUpdate>& updates,
       const process::Future<bool>& removed,
       const std::string& message,
@@ -677,12 +780,41 @@ protected:
   process::Future<bool> authorizeFramework(
       const FrameworkInfo& frameworkInfo);
 
-  // Returns whether the task is authorized.
-  // Returns failure for transient authorization failures.
-  process::Future<bool> authorizeTask(
-      const TaskInfo& task,
+  // Returns whether each of the tasks is authorized, in order, with
+  // a single request to the authorizer for all of them.
+  // Returns failures for transient authorization failures.
+  std::list<process::Future<bool>> authorizeTasks(
+      const google::protobuf::RepeatedPtrField<TaskInfo>& tasks,
       Framework* framework);
 
+  // Validates the parts of the tasks launched by the operations that
+  // do not depend on the state of the master (see
+  // 'validation::task::validate'). The tasks get validated in batches
+  // off the master actor, the errors are in the order of the tasks.
+  process::Future<std::vector<Option<Error>>> validateTasks(
+      const scheduler::Call::Accept& accept);
+
+  // Rescinds the offers of the other frameworks on the slave that
+  // overlap with the 'accepted' resources, when the allocator offers
+  // the same resources to several frameworks at once (see
+  // OPTIMISTIC_ALLOCATOR). The first framework to accept wins, and the
+  // allocator accounts the accepted resources to it.
+  void rescindConflictingOffers(
+      Framework* framework,
+      Slave* slave,
+      const Resources& accepted);
+
+  // Invokes the label decorator hooks on the tasks launched by the
+  // operations off the master actor, the labels are in the order of
+  // the tasks. There are no labels if no hooks are available.
+  //
+  // NOTE: The hooks are invoked before the tasks are validated, hence
+  // also on tasks that will not be launched.
+  process::Future<std::vector<Labels>> decorateTasks(
+      const scheduler::Call::Accept& accept,
+      const Framework* framework,
+      const Slave* slave);
+
   /**
    * Authorizes a `RESERVE` offer operation.
    *
@@ -738,6 +870,13 @@ protected:
   // Removes the task.
   void removeTask(Task* task);
 
+  // Sends an event of the given type, e.g., 'TASK_UPDATED', with the
+  // changed object under 'key' to the subscribers of '/state/stream'.
+  void stream(
+      const std::string& type,
+      const std::string& key,
+      const JSON::Value& value);
+
   // Remove an executor and recover its resources.
   void removeExecutor(
       Slave* slave,
@@ -753,14 +892,15 @@ protected:
       Slave* slave,
       const Offer::Operation& operation);
 
-  // Attempts to update the allocator by applying the given operation.
-  // If successful, updates the slave's resources, sends a
+  // Attempts to update the allocator by applying the given
+  // operations, in order, with a single update. If successful,
+  // updates the slave's resources, sends a single
   // 'CheckpointResourcesMessage' to the slave with the updated
   // checkpointed resources, and returns a 'Future' with 'Nothing'.
   // Otherwise, no action is taken and returns a failed 'Future'.
   process::Future<Nothing> apply(
       Slave* slave,
-      const Offer::Operation& operation);
+      const std::vector<Offer::Operation>& operations);
 
   // Forwards the update to the framework.
   void forward(
@@ -768,9 +908,21 @@ protected:
       const process::UPID& acknowledgee,
       Framework* framework);
 
+  // Remembers that the offer, or inverse offer, times out after
+  // '--offer_timeout'.
+  void addOfferTimeout(const OfferID& offerId);
+
+  // Times out the offers and inverse offers that are due, and waits
+  // for the next one.
+  void expireOffers();
+
   // Remove an offer after specified timeout
   void offerTimeout(const OfferID& offerId);
 
+  // Records that the framework answered the offer with the outcome
+  // (e.g., "ACCEPTED"), which the offer is removed with afterwards.
+  void answerOffer(Offer* offer, const std::string& outcome);
+
   // Remove an offer and optionally rescind the offer as well.
   void removeOffer(Offer* offer, bool rescind = false);
 
@@ -791,7 +943,7 @@ protected:
   Option<Credentials> credentials;
 
 private:
-  void _apply(Slave* slave, const Offer::Operation& operation);
+  void _apply(Slave* slave, const std::vector<Offer::Operation>& operations);
 
   void drop(
       const process::UPID& from,
@@ -837,7 +989,9 @@ private:
     const SlaveID& slaveId,
     const Resources& offeredResources,
     const scheduler::Call::Accept& accept,
-    const process::Future<std::list<process::Future<bool>>>& authorizations);
+    const process::Future<std::list<process::Future<bool>>>& authorizations,
+    const process::Future<std::vector<Option<Error>>>& validations,
+    const process::Future<std::vector<Labels>>& decorations);
 
   void decline(
       Framework* framework,
@@ -857,6 +1011,14 @@ private:
       Framework* framework,
       const scheduler::Call::Acknowledge& acknowledge);
 
+  void acknowledge(
+      Framework* framework,
+      const scheduler::Call::Acknowledgements& acknowledgements);
+
+  // Sends the acknowledgements batched by 'acknowledge()' to the
+  // slaves that forward their status updates in batches.
+  void _acknowledge();
+
   void reconcile(
       Framework* framework,
       const scheduler::Call::Reconcile& reconcile);
@@ -991,10 +1153,25 @@ private:
     process::Future<process::http::Response> health(
         const process::http::Request& request) const;
 
+    // /master/images
+    process::Future<process::http::Response> images(
+        const process::http::Request& request) const;
+
+    // /master/memory
+    process::Future<process::http::Response> memory(
+        const process::http::Request& request) const;
+
     // /master/observe
     process::Future<process::http::Response> observe(
         const process::http::Request& request) const;
 
+    // /master/operations
+    process::Future<process::http::Response> offerTraces(
+        const process::http::Request& request) const;
+
+    process::Future<process::http::Response> operations(
+        const process::http::Request& request) const;
+
     // /master/redirect
     process::Future<process::http::Response> redirect(
         const process::http::Request& request) const;
@@ -1023,6 +1200,10 @@ private:
     process::Future<process::http::Response> stateSummary(
         const process::http::Request& request) const;
 
+    // /master/state/stream
+    process::Future<process::http::Response> stateStream(
+        const process::http::Request& request) const;
+
     // /master/tasks
     process::Future<process::http::Response> tasks(
         const process::http::Request& request) const;
@@ -1055,13 +1236,18 @@ private:
     static std::string FLAGS_HELP();
     static std::string FRAMEWORKS();
     static std::string HEALTH_HELP();
+    static std::string IMAGES_HELP();
+    static std::string MEMORY_HELP();
     static std::string OBSERVE_HELP();
+    static std::string OFFER_TRACES_HELP();
+    static std::string OPERATIONS_HELP();
     static std::string REDIRECT_HELP();
     static std::string ROLES_HELP();
     static std::string TEARDOWN_HELP();
     static std::string SLAVES_HELP();
     static std::string STATE_HELP();
     static std::string STATESUMMARY_HELP();
+    static std::string STATE_STREAM_HELP();
     static std::string TASKS_HELP();
     static std::string MAINTENANCE_SCHEDULE_HELP();
     static std::string MAINTENANCE_STATUS_HELP();
@@ -1080,33 +1266,53 @@ private:
     Result<Credential> authenticate(
         const process::http::Request& request) const;
 
+    // Renders the response of the request with 'render', or, if
+    // '--state_cache_ttl' is set, serves the response rendered for
+    // an earlier request with the same path and query, if any, as
+    // long as it has not expired. The response has an 'ETag' of its
+    // body, so that a client can poll with 'If-None-Match' and get
+    // '304 Not Modified' rather than the same body again.
+    process::http::Response cached(
+        const process::http::Request& request,
+        process::http::Response (Http::*render)(
+            const process::http::Request&) const) const;
+
+    // Renderers of the responses of /master/state and
+    // /master/state-summary, see 'cached()'.
+    process::http::Response _state(
+        const process::http::Request& request) const;
+
+    process::http::Response _stateSummary(
+        const process::http::Request& request) const;
+
     // Continuations.
     process::Future<process::http::Response> _teardown(
         const FrameworkID& id) const;
 
     /**
      * Continuation for operations: /reserve, /unreserve,
-     * /create-volumes and /destroy-volumes. First tries to recover
-     * 'required' amount of resources by rescinding outstanding
-     * offers, then tries to apply the operation by calling
-     * 'master->apply' and propagates the 'Future<Nothing>' as
-     * 'Future<Response>' where 'Nothing' -> 'OK' and Failed ->
+     * /create-volumes, /destroy-volumes and /operations. First tries
+     * to recover 'required' amount of resources by rescinding
+     * outstanding offers, then tries to apply the operations by
+     * calling 'master->apply' and propagates the 'Future<Nothing>'
+     * as 'Future<Response>' where 'Nothing' -> 'OK' and Failed ->
      * 'Conflict'.
      *
-     * @param slaveId The ID of the slave that the operation is
+     * @param slaveId The ID of the slave that the operations are
      *     updating.
-     * @param required The resources needed to satisfy the operation.
+     * @param required The resources needed to satisfy the operations.
      *     This is used for an optimization where we try to only
      *     rescind offers that would contribute to satisfying the
-     *     operation.
-     * @param operation The operation to be performed.
+     *     operations.
+     * @param operations The operations to be performed, in order.
+     *     They are applied all together, or not at all.
      *
      * @return Returns 'OK' if successful, 'Conflict' otherwise.
      */
     process::Future<process::http::Response> _operation(
         const SlaveID& slaveId,
         Resources required,
-        const Offer::Operation& operation) const;
+        const std::vector<Offer::Operation>& operations) const;
 
     Master* master;
 
@@ -1135,6 +1341,7 @@ private:
 
   mesos::master::allocator::Allocator* allocator;
   WhitelistWatcher* whitelistWatcher;
+  SlaveObserver* observer;
   Registrar* registrar;
   Repairer* repairer;
   Files* files;
@@ -1286,7 +1493,7 @@ private:
   {
     Frameworks() : completed(MAX_COMPLETED_FRAMEWORKS) {}
 
-    hashmap<FrameworkID, Framework*> registered;
+    flat_hashmap<FrameworkID, Framework*> registered;
     boost::circular_buffer<std::shared_ptr<Framework>> completed;
 
     // Principals of frameworks keyed by PID.
@@ -1310,17 +1517,64 @@ private:
     Option<process::Owned<BoundedRateLimiter>> defaultLimiter;
   } frameworks;
 
-  hashmap<OfferID, Offer*> offers;
-  hashmap<OfferID, process::Timer> offerTimers;
+  // A single copy of each distinct ExecutorInfo of the executors on
+  // the slaves, shared by all slaves and frameworks that have the
+  // executor, e.g., a framework that runs the same executor on many
+  // slaves.
+  Interner<ExecutorInfo> internedExecutorInfos;
 
+  hashmap<OfferID, Offer*> offers;
   hashmap<OfferID, InverseOffer*> inverseOffers;
-  hashmap<OfferID, process::Timer> inverseOfferTimers;
+
+  // The trace of an offer from when it is made until the framework
+  // answers it, or it is rescinded or removed otherwise.
+  struct OfferTrace
+  {
+    OfferID offerId;
+    FrameworkID frameworkId;
+    SlaveID slaveId;
+
+    process::Time offered;
+    Option<process::Time> answered;
+
+    // "ACCEPTED" or "DECLINED" once answered, or "RESCINDED" or
+    // "REMOVED" if the offer is removed without an answer.
+    Option<std::string> outcome;
+  };
+
+  // The traces of the outstanding offers, and of the most recently
+  // completed ones, for the '/offer-traces' endpoint.
+  struct OfferTraces
+  {
+    OfferTraces() : completed(MAX_OFFER_TRACES) {}
+
+    hashmap<OfferID, std::shared_ptr<OfferTrace>> outstanding;
+    boost::circular_buffer<std::shared_ptr<const OfferTrace>> completed;
+  } offerTraces;
+
+  // The offers and inverse offers in the order they time out. Since
+  // all of them time out after '--offer_timeout', a single timer for
+  // the first of them is enough, rather than one per offer. Offers
+  // that are removed in the meantime are skipped once they are due.
+  std::deque<std::pair<process::Time, OfferID>> offerTimeouts;
+  Option<process::Timer> offerTimer;
+
+  // The acknowledgements sent to each slave in the next batch, see
+  // 'acknowledge()'.
+  hashmap<SlaveID, std::vector<StatusUpdateAcknowledgementMessage>>
+    acknowledgements;
 
   hashmap<std::string, Role*> roles;
 
   // We store quotas by role because we set them at the role level.
   hashmap<std::string, Quota> quotas;
 
+  // The unreserved scalar resources of the active slaves, i.e., those
+  // which participate in resource allocation, kept up to date as
+  // slaves are added, removed, deactivated and reactivated so that
+  // the quota capacity heuristic need not visit every slave.
+  Resources nonStaticClusterResources;
+
   // Authenticator names as supplied via flags.
   std::vector<std::string> authenticatorNames;
 
@@ -1332,6 +1586,13 @@ private:
   // The future is removed from the map when master completes authentication.
   hashmap<process::UPID, process::Future<Option<std::string>>> authenticating;
 
+  // Frameworks/slaves waiting for an authentication to finish before
+  // theirs starts, see '--max_concurrent_authentications'. The queue
+  // holds their PIDs in order, the map the PIDs of their
+  // authenticatees.
+  std::deque<process::UPID> authenticationQueue;
+  hashmap<process::UPID, process::UPID> queuedAuthentications;
+
   // Principals of authenticated frameworks/slaves keyed by PID.
   hashmap<process::UPID, std::string> authenticated;
 
@@ -1351,26 +1612,9 @@ private:
     return (process::Clock::now() - startTime).secs();
   }
 
-  double _elected()
-  {
-    return elected() ? 1 : 0;
-  }
-
-  double _slaves_connected();
-  double _slaves_disconnected();
   double _slaves_active();
   double _slaves_inactive();
 
-  double _frameworks_connected();
-  double _frameworks_disconnected();
-  double _frameworks_active();
-  double _frameworks_inactive();
-
-  double _outstanding_offers()
-  {
-    return offers.size();
-  }
-
   double _event_queue_messages()
   {
     return static_cast<double>(eventCount<process::MessageEvent>());
@@ -1386,9 +1630,10 @@ private:
     return static_cast<double>(eventCount<process::HttpEvent>());
   }
 
-  double _tasks_staging();
-  double _tasks_starting();
-  double _tasks_running();
+  double _state_cache_staleness_secs()
+  {
+    return stateCacheStaleness.secs();
+  }
 
   double _resources_total(const std::string& name);
   double _resources_used(const std::string& name);
@@ -1402,6 +1647,25 @@ private:
 
   Option<process::Time> electedTime; // Time when this master is elected.
 
+  // The rendered responses of '/state' and '/state-summary' by query,
+  // which are served again until '--state_cache_ttl' has passed since
+  // they were rendered. See 'Http::cached()'.
+  struct RenderedResponse
+  {
+    process::http::Response response;
+    process::Time time;
+  };
+
+  Cache<std::string, RenderedResponse> renderedResponses;
+
+  // How old the last response of '/state' or '/state-summary' was
+  // when it was served, zero if it was rendered for the request.
+  Duration stateCacheStaleness;
+
+  // The connections of the subscribers of '/state/stream', which get
+  // the changes of the tasks, slaves and frameworks, see 'stream()'.
+  std::list<process::http::Pipe::Writer> stateStreams;
+
   // Validates the framework including authorization.
   // Returns None if the framework is valid.
   // Returns Error if the framework is invalid.
@@ -1517,12 +1781,100 @@ private:
 };
 
 
+// Implementation of the removal of several slaves at once, e.g., when
+// many slaves fail their health checks during a network partition.
+// Unlike applying a 'RemoveSlave' per slave, this goes through the
+// registry only once.
+class RemoveSlaves : public Operation
+{
+public:
+  explicit RemoveSlaves(const std::vector<SlaveInfo>& _infos) : infos(_infos)
+  {
+    foreach (const SlaveInfo& info, infos) {
+      CHECK(info.has_id()) << "SlaveInfo is missing the 'id' field";
+    }
+  }
+
+protected:
+  virtual Try<bool> perform(
+      Registry* registry,
+      hashset<SlaveID>* slaveIDs,
+      bool strict)
+  {
+    hashset<SlaveID> ids;
+    foreach (const SlaveInfo& info, infos) {
+      if (strict && !slaveIDs->contains(info.id())) {
+        return Error("Slave " + stringify(info.id()) + " not yet admitted");
+      }
+
+      ids.insert(info.id());
+    }
+
+    // Remove the slaves in a single pass, keeping the order of the
+    // remaining slaves.
+    google::protobuf::RepeatedPtrField<Registry::Slave>* slaves =
+      registry->mutable_slaves()->mutable_slaves();
+
+    int kept = 0;
+    for (int i = 0; i < slaves->size(); i++) {
+      if (ids.contains(slaves->Get(i).info().id())) {
+        slaveIDs->erase(slaves->Get(i).info().id());
+      } else {
+        slaves->SwapElements(i, kept++);
+      }
+    }
+
+    if (kept == slaves->size()) {
+      return false; // No mutation.
+    }
+
+    slaves->DeleteSubrange(kept, slaves->size() - kept);
+    return true; // Mutation.
+  }
+
+private:
+  const std::vector<SlaveInfo> infos;
+};
+
+
 inline std::ostream& operator<<(
     std::ostream& stream,
     const Framework& framework);
 
 
 // Represents the streaming HTTP connection to a framework.
+// An event to send to several frameworks, e.g., the FAILURE event
+// for a lost slave. The event is evolved and encoded into a RecordIO
+// record at most once per content type, however many HTTP frameworks
+// it is sent to. The message must outlive the broadcast.
+template <typename Message>
+class Broadcast
+{
+public:
+  explicit Broadcast(const Message& _message) : message(_message) {}
+
+  // Returns the RecordIO record of the event for 'contentType'.
+  const std::string& record(ContentType contentType)
+  {
+    Option<std::string>& record = records[static_cast<int>(contentType)];
+
+    if (record.isNone()) {
+      ::recordio::Encoder<v1::scheduler::Event> encoder(
+          lambda::bind(serialize, contentType, lambda::_1));
+
+      record = encoder.encode(evolve(message));
+    }
+
+    return record.get();
+  }
+
+  const Message& message;
+
+private:
+  std::map<int, Option<std::string>> records;
+};
+
+
 struct HttpConnection
 {
   HttpConnection(const process::http::Pipe::Writer& _writer,
@@ -1540,6 +1892,12 @@ struct HttpConnection
     return writer.write(encoder.encode(evolve(message)));
   }
 
+  // Sends an already encoded event, see 'Broadcast'.
+  bool write(const std::string& record)
+  {
+    return writer.write(record);
+  }
+
   bool close()
   {
     return writer.close();
@@ -1550,6 +1908,14 @@ struct HttpConnection
     return writer.readerClosed();
   }
 
+  // Returns false if the scheduler is not keeping up with reading the
+  // events, i.e., the high-water mark of the pipe has been reached,
+  // or if the connection is closed.
+  bool writable() const
+  {
+    return writer.writable().isReady();
+  }
+
   process::http::Pipe::Writer writer;
   ContentType contentType;
   ::recordio::Encoder<v1::scheduler::Event> encoder;
@@ -1582,21 +1948,72 @@ private:
     if (http.closed().isPending()) {
       VLOG(1) << "Sending heartbeat to " << frameworkId;
 
-      scheduler::Event event;
-      event.set_type(scheduler::Event::HEARTBEAT);
-
-      http.send(event);
+      http.write(record(http.contentType));
     }
 
     process::delay(interval, self(), &Self::heartbeat);
   }
 
+  // The HEARTBEAT event is the same for all frameworks, hence it is
+  // encoded only once per content type, for all the heartbeaters.
+  static const std::string& record(ContentType contentType)
+  {
+    static const std::string json = encode(ContentType::JSON);
+    static const std::string protobuf = encode(ContentType::PROTOBUF);
+
+    return contentType == ContentType::JSON ? json : protobuf;
+  }
+
+  static std::string encode(ContentType contentType)
+  {
+    scheduler::Event event;
+    event.set_type(scheduler::Event::HEARTBEAT);
+
+    return Broadcast<scheduler::Event>(event).record(contentType);
+  }
+
   const FrameworkID frameworkId;
   HttpConnection http;
   const Duration interval;
 };
 
 
+// A completed task of a framework. Since the master keeps up to
+// 'MAX_COMPLETED_TASKS_PER_FRAMEWORK' of them for each framework, the
+// task is kept serialized, which takes a fraction of the memory of
+// the 'Task' with all its statuses. Only what is needed to summarize
+// the task (see '/state-summary') is kept decoded.
+struct CompletedTask
+{
+  explicit CompletedTask(const Task& task)
+    : slaveId(task.slave_id()),
+      state(task.state())
+  {
+    CHECK(task.SerializeToString(&data));
+  }
+
+  // Decodes the task.
+  Task task() const
+  {
+    Task task;
+    CHECK(task.ParseFromString(data));
+    return task;
+  }
+
+  // Returns the approximate memory used by the completed task.
+  size_t bytes() const
+  {
+    return sizeof(*this) + data.capacity();
+  }
+
+  const SlaveID slaveId;
+  const TaskState state;
+
+private:
+  std::string data;
+};
+
+
 // Information about a connected or completed framework.
 // TODO(bmahler): Keeping the task and executor information in sync
 // across the Slave and Framework structs is error prone!
@@ -1613,7 +2030,8 @@ struct Framework
       active(true),
       registeredTime(time),
       reregisteredTime(time),
-      completedTasks(MAX_COMPLETED_TASKS_PER_FRAMEWORK) {}
+      completedTasks(MAX_COMPLETED_TASKS_PER_FRAMEWORK),
+      sendingReconcileResults(false) {}
 
   Framework(Master* const _master,
             const FrameworkInfo& _info,
@@ -1626,7 +2044,8 @@ struct Framework
       active(true),
       registeredTime(time),
       reregisteredTime(time),
-      completedTasks(MAX_COMPLETED_TASKS_PER_FRAMEWORK) {}
+      completedTasks(MAX_COMPLETED_TASKS_PER_FRAMEWORK),
+      sendingReconcileResults(false) {}
 
   ~Framework()
   {
@@ -1679,6 +2098,16 @@ struct Framework
   // Sends a message to the connected framework.
   template <typename Message>
   void send(const Message& message)
+  {
+    Broadcast<Message> broadcast(message);
+    send(broadcast);
+  }
+
+  // Sends a message that is sent to other frameworks too, encoding
+  // it only if no other HTTP framework with the same content type
+  // had it encoded already.
+  template <typename Message>
+  void send(Broadcast<Message>& broadcast)
   {
     if (!connected) {
       LOG(WARNING) << "Master attempted to send message to disconnected"
@@ -1686,20 +2115,34 @@ struct Framework
     }
 
     if (http.isSome()) {
-      if (!http.get().send(message)) {
+      if (connected && !http.get().writable()) {
+        // Rather than buffering events without bound for a scheduler
+        // that doesn't keep up, we drop them and disconnect it (the
+        // scheduler has to subscribe again and reconcile). We do so
+        // asynchronously since the master might be iterating over its
+        // frameworks, see 'Master::exited'.
+        LOG(WARNING) << "Dropping event for framework " << *this << ":"
+                     << " more than "
+                     << master->flags.max_http_framework_buffer_size
+                     << " of events are buffered, disconnecting it";
+
+        process::dispatch(
+            master->self(), &Master::exited, id(), http.get());
+      } else if (!http.get().write(broadcast.record(http->contentType))) {
         LOG(WARNING) << "Unable to send event to framework " << *this << ":"
                      << " connection closed";
       }
     } else {
       CHECK_SOME(pid);
-      master->send(pid.get(), message);
+      master->send(pid.get(), broadcast.message);
     }
   }
 
   void addCompletedTask(const Task& task)
   {
     // TODO(adam-mesos): Check if completed task already exists.
-    completedTasks.push_back(std::shared_ptr<Task>(new Task(task)));
+    completedTasks.push_back(
+        std::shared_ptr<const CompletedTask>(new CompletedTask(task)));
   }
 
   void removeTask(Task* task)
@@ -1766,15 +2209,15 @@ struct Framework
   }
 
   void addExecutor(const SlaveID& slaveId,
-                   const ExecutorInfo& executorInfo)
+                   const std::shared_ptr<const ExecutorInfo>& executorInfo)
   {
-    CHECK(!hasExecutor(slaveId, executorInfo.executor_id()))
-      << "Duplicate executor '" << executorInfo.executor_id()
+    CHECK(!hasExecutor(slaveId, executorInfo->executor_id()))
+      << "Duplicate executor '" << executorInfo->executor_id()
       << "' on slave " << slaveId;
 
-    executors[slaveId][executorInfo.executor_id()] = executorInfo;
-    totalUsedResources += executorInfo.resources();
-    usedResources[slaveId] += executorInfo.resources();
+    executors[slaveId][executorInfo->executor_id()] = executorInfo;
+    totalUsedResources += executorInfo->resources();
+    usedResources[slaveId] += executorInfo->resources();
   }
 
   void removeExecutor(const SlaveID& slaveId,
@@ -1785,8 +2228,8 @@ struct Framework
       << "' of framework " << id()
       << " of slave " << slaveId;
 
-    totalUsedResources -= executors[slaveId][executorId].resources();
-    usedResources[slaveId] -= executors[slaveId][executorId].resources();
+    totalUsedResources -= executors[slaveId][executorId]->resources();
+    usedResources[slaveId] -= executors[slaveId][executorId]->resources();
     if (usedResources[slaveId].empty()) {
       usedResources.erase(slaveId);
     }
@@ -1959,18 +2402,28 @@ struct Framework
   // being authorized.
   hashmap<TaskID, TaskInfo> pendingTasks;
 
-  hashmap<TaskID, Task*> tasks;
+  // The times at which the master launched the tasks that are not
+  // running yet, for the 'accept_to_running' metric.
+  hashmap<TaskID, process::Time> launchTimes;
+
+  // NOTE: This and the other maps of ids that the master looks up
+  // for most of the messages it receives are 'flat_hashmap's, see
+  // the NOTE in 'stout/flat_hashmap.hpp' for when they invalidate
+  // references.
+  flat_hashmap<TaskID, Task*> tasks;
 
-  // NOTE: We use a shared pointer for Task because clang doesn't like
-  // Boost's implementation of circular_buffer with Task (Boost
-  // attempts to do some memset's which are unsafe).
-  boost::circular_buffer<std::shared_ptr<Task>> completedTasks;
+  // NOTE: We use a shared pointer for CompletedTask because clang
+  // doesn't like Boost's implementation of circular_buffer with
+  // protobufs (Boost attempts to do some memset's which are unsafe).
+  boost::circular_buffer<std::shared_ptr<const CompletedTask>> completedTasks;
 
   hashset<Offer*> offers; // Active offers for framework.
 
   hashset<InverseOffer*> inverseOffers; // Active inverse offers for framework.
 
-  hashmap<SlaveID, hashmap<ExecutorID, ExecutorInfo>> executors;
+  // The ExecutorInfos are shared with the slaves, see 'Slave::executors'.
+  hashmap<SlaveID,
+          hashmap<ExecutorID, std::shared_ptr<const ExecutorInfo>>> executors;
 
   // NOTE: For the used and offered resources below, we keep the
   // total as well as partitioned by SlaveID.
@@ -2002,6 +2455,23 @@ struct Framework
   Resources totalOfferedResources;
   hashmap<SlaveID, Resources> offeredResources;
 
+  // The reconciliations of a framework with the 'RECONCILE_RESULT'
+  // capability that are yet to be answered, see
+  // 'Master::sendReconcileResults'.
+  struct Reconciliation
+  {
+    TaskStatus status;
+
+    // Whether the task was known at the time of an implicit
+    // reconciliation, rather than named by the framework.
+    bool implicit;
+  };
+
+  std::deque<Reconciliation> reconciliations;
+
+  // Whether the next batch of answers is scheduled to be sent.
+  bool sendingReconcileResults;
+
   // This is only set for HTTP frameworks.
   Option<process::Owned<Heartbeater>> heartbeater;
 
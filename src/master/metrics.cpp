@@ -42,44 +42,31 @@ Metrics::Metrics(const Master& master)
         "master/uptime_secs",
         defer(master, &Master::_uptime_secs)),
     elected(
-        "master/elected",
-        defer(master, &Master::_elected)),
+        "master/elected"),
     slaves_connected(
-        "master/slaves_connected",
-        defer(master, &Master::_slaves_connected)),
+        "master/slaves_connected"),
     slaves_disconnected(
-        "master/slaves_disconnected",
-        defer(master, &Master::_slaves_disconnected)),
+        "master/slaves_disconnected"),
     slaves_active(
-        "master/slaves_active",
-        defer(master, &Master::_slaves_active)),
+        "master/slaves_active"),
     slaves_inactive(
-        "master/slaves_inactive",
-        defer(master, &Master::_slaves_inactive)),
+        "master/slaves_inactive"),
     frameworks_connected(
-        "master/frameworks_connected",
-        defer(master, &Master::_frameworks_connected)),
+        "master/frameworks_connected"),
     frameworks_disconnected(
-        "master/frameworks_disconnected",
-        defer(master, &Master::_frameworks_disconnected)),
+        "master/frameworks_disconnected"),
     frameworks_active(
-        "master/frameworks_active",
-        defer(master, &Master::_frameworks_active)),
+        "master/frameworks_active"),
     frameworks_inactive(
-        "master/frameworks_inactive",
-        defer(master, &Master::_frameworks_inactive)),
+        "master/frameworks_inactive"),
     outstanding_offers(
-        "master/outstanding_offers",
-        defer(master, &Master::_outstanding_offers)),
+        "master/outstanding_offers"),
     tasks_staging(
-        "master/tasks_staging",
-        defer(master, &Master::_tasks_staging)),
+        "master/tasks_staging"),
     tasks_starting(
-        "master/tasks_starting",
-        defer(master, &Master::_tasks_starting)),
+        "master/tasks_starting"),
     tasks_running(
-        "master/tasks_running",
-        defer(master, &Master::_tasks_running)),
+        "master/tasks_running"),
     tasks_finished(
         "master/tasks_finished"),
     tasks_failed(
@@ -152,6 +139,8 @@ Metrics::Metrics(const Master& master)
         "master/invalid_status_update_acknowledgements"),
     recovery_slave_removals(
         "master/recovery_slave_removals"),
+    recovery_slave_reregistrations_deferred(
+        "master/recovery_slave_reregistrations_deferred"),
     event_queue_messages(
         "master/event_queue_messages",
         defer(master, &Master::_event_queue_messages)),
@@ -161,6 +150,13 @@ Metrics::Metrics(const Master& master)
     event_queue_http_requests(
         "master/event_queue_http_requests",
         defer(master, &Master::_event_queue_http_requests)),
+    state_cache_hits(
+        "master/state_cache_hits"),
+    state_cache_misses(
+        "master/state_cache_misses"),
+    state_cache_staleness_secs(
+        "master/state_cache_staleness_secs",
+        defer(master, &Master::_state_cache_staleness_secs)),
     slave_registrations(
         "master/slave_registrations"),
     slave_reregistrations(
@@ -247,11 +243,16 @@ Metrics::Metrics(const Master& master)
   process::metrics::add(invalid_status_update_acknowledgements);
 
   process::metrics::add(recovery_slave_removals);
+  process::metrics::add(recovery_slave_reregistrations_deferred);
 
   process::metrics::add(event_queue_messages);
   process::metrics::add(event_queue_dispatches);
   process::metrics::add(event_queue_http_requests);
 
+  process::metrics::add(state_cache_hits);
+  process::metrics::add(state_cache_misses);
+  process::metrics::add(state_cache_staleness_secs);
+
   process::metrics::add(slave_registrations);
   process::metrics::add(slave_reregistrations);
   process::metrics::add(slave_removals);
@@ -383,11 +384,16 @@ Metrics::~Metrics()
   process::metrics::remove(invalid_status_update_acknowledgements);
 
   process::metrics::remove(recovery_slave_removals);
+  process::metrics::remove(recovery_slave_reregistrations_deferred);
 
   process::metrics::remove(event_queue_messages);
   process::metrics::remove(event_queue_dispatches);
   process::metrics::remove(event_queue_http_requests);
 
+  process::metrics::remove(state_cache_hits);
+  process::metrics::remove(state_cache_misses);
+  process::metrics::remove(state_cache_staleness_secs);
+
   process::metrics::remove(slave_registrations);
   process::metrics::remove(slave_reregistrations);
   process::metrics::remove(slave_removals);
@@ -460,6 +466,12 @@ void Metrics::incrementTasksStates(
         strings::lower(TaskStatus::Source_Name(source)) + "/" +
         strings::lower(TaskStatus::Reason_Name(reason)));
 
+    counter.label(
+        "master/task_states",
+        {{"state", strings::lower(TaskState_Name(state))},
+         {"source", strings::lower(TaskStatus::Source_Name(source))},
+         {"reason", strings::lower(TaskStatus::Reason_Name(reason))}});
+
     tasks_states[state][source].put(reason, counter);
     process::metrics::add(counter);
   }
@@ -469,6 +481,24 @@ void Metrics::incrementTasksStates(
 }
 
 
+void Metrics::addTasks(const TaskState& state, double count)
+{
+  switch (state) {
+    case TASK_STAGING:
+      tasks_staging += count;
+      break;
+    case TASK_STARTING:
+      tasks_starting += count;
+      break;
+    case TASK_RUNNING:
+      tasks_running += count;
+      break;
+    default:
+      break;
+  }
+}
+
+
 } // namespace master {
 } // namespace internal {
 } // namespace mesos {
@@ -23,8 +23,12 @@
 #include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
+#include <process/metrics/push_gauge.hpp>
+#include <process/metrics/timer.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/stringify.hpp>
 
 #include "mesos/mesos.hpp"
 #include "mesos/type_utils.hpp"
@@ -42,24 +46,24 @@ struct Metrics
   ~Metrics();
 
   process::metrics::Gauge uptime_secs;
-  process::metrics::Gauge elected;
+  process::metrics::PushGauge elected;
 
-  process::metrics::Gauge slaves_connected;
-  process::metrics::Gauge slaves_disconnected;
-  process::metrics::Gauge slaves_active;
-  process::metrics::Gauge slaves_inactive;
+  process::metrics::PushGauge slaves_connected;
+  process::metrics::PushGauge slaves_disconnected;
+  process::metrics::PushGauge slaves_active;
+  process::metrics::PushGauge slaves_inactive;
 
-  process::metrics::Gauge frameworks_connected;
-  process::metrics::Gauge frameworks_disconnected;
-  process::metrics::Gauge frameworks_active;
-  process::metrics::Gauge frameworks_inactive;
+  process::metrics::PushGauge frameworks_connected;
+  process::metrics::PushGauge frameworks_disconnected;
+  process::metrics::PushGauge frameworks_active;
+  process::metrics::PushGauge frameworks_inactive;
 
-  process::metrics::Gauge outstanding_offers;
+  process::metrics::PushGauge outstanding_offers;
 
   // Task state metrics.
-  process::metrics::Gauge tasks_staging;
-  process::metrics::Gauge tasks_starting;
-  process::metrics::Gauge tasks_running;
+  process::metrics::PushGauge tasks_staging;
+  process::metrics::PushGauge tasks_starting;
+  process::metrics::PushGauge tasks_running;
   process::metrics::Counter tasks_finished;
   process::metrics::Counter tasks_failed;
   process::metrics::Counter tasks_killed;
@@ -102,6 +106,11 @@ struct Metrics
       : messages_received("frameworks/" + principal + "/messages_received"),
         messages_processed("frameworks/" + principal + "/messages_processed")
     {
+      messages_received.label(
+          "frameworks/messages_received", {{"principal", principal}});
+      messages_processed.label(
+          "frameworks/messages_processed", {{"principal", principal}});
+
       process::metrics::add(messages_received);
       process::metrics::add(messages_processed);
     }
@@ -117,6 +126,50 @@ struct Metrics
   // principal.
   hashmap<std::string, process::Owned<Frameworks>> frameworks;
 
+  // Metrics of the offers to and the tasks of a single framework,
+  // with percentiles over the last hour. These metrics have names
+  // prefixed by "master/frameworks/<framework_id>/".
+  struct FrameworkOffers
+  {
+    // Time from the master making an offer until the framework
+    // accepts or declines it.
+    process::metrics::Timer<Milliseconds> offer_hold_time;
+
+    // Time from the master launching a task on the slave, after the
+    // framework accepted an offer, until the task is running.
+    process::metrics::Timer<Milliseconds> accept_to_running;
+
+    explicit FrameworkOffers(const FrameworkID& frameworkId)
+      : offer_hold_time(
+            "master/frameworks/" + stringify(frameworkId) +
+            "/offer_hold_time",
+            Hours(1)),
+        accept_to_running(
+            "master/frameworks/" + stringify(frameworkId) +
+            "/accept_to_running",
+            Hours(1))
+    {
+      offer_hold_time.label(
+          "master/frameworks/offer_hold_time_ms",
+          {{"framework_id", stringify(frameworkId)}});
+      accept_to_running.label(
+          "master/frameworks/accept_to_running_ms",
+          {{"framework_id", stringify(frameworkId)}});
+
+      process::metrics::add(offer_hold_time);
+      process::metrics::add(accept_to_running);
+    }
+
+    ~FrameworkOffers()
+    {
+      process::metrics::remove(offer_hold_time);
+      process::metrics::remove(accept_to_running);
+    }
+  };
+
+  // Per-framework offer metrics keyed by the framework ID.
+  hashmap<FrameworkID, process::Owned<FrameworkOffers>> framework_offers;
+
   // Messages from schedulers.
   process::metrics::Counter messages_register_framework;
   process::metrics::Counter messages_reregister_framework;
@@ -159,12 +212,18 @@ struct Metrics
 
   // Recovery counters.
   process::metrics::Counter recovery_slave_removals;
+  process::metrics::Counter recovery_slave_reregistrations_deferred;
 
   // Process metrics.
   process::metrics::Gauge event_queue_messages;
   process::metrics::Gauge event_queue_dispatches;
   process::metrics::Gauge event_queue_http_requests;
 
+  // Responses of '/state' and '/state-summary' served from the cache.
+  process::metrics::Counter state_cache_hits;
+  process::metrics::Counter state_cache_misses;
+  process::metrics::Gauge state_cache_staleness_secs;
+
   // Successful registry operations.
   process::metrics::Counter slave_registrations;
   process::metrics::Counter slave_reregistrations;
@@ -192,6 +251,9 @@ struct Metrics
       const TaskState& state,
       const TaskStatus::Source& source,
       const TaskStatus::Reason& reason);
+
+  // Adds to the gauge of the tasks in the state, if there is one.
+  void addTasks(const TaskState& state, double count);
 };
 
 } // namespace master {
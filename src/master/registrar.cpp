@@ -14,30 +14,38 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <deque>
+#include <list>
+#include <set>
 #include <string>
+#include <vector>
 
 #include <mesos/type_utils.hpp>
 
 #include <process/defer.hpp>
+#include <process/delay.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/help.hpp>
 #include <process/http.hpp>
+#include <process/collect.hpp>
 #include <process/id.hpp>
 #include <process/owned.hpp>
 #include <process/process.hpp>
 
-#include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
+#include <process/metrics/push_gauge.hpp>
 #include <process/metrics/timer.hpp>
 
 #include <stout/lambda.hpp>
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
+#include <stout/numify.hpp>
 #include <stout/option.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/stopwatch.hpp>
+#include <stout/strings.hpp>
 
 #include "master/registrar.hpp"
 #include "master/registry.hpp"
@@ -47,6 +55,7 @@
 using mesos::internal::state::protobuf::State;
 using mesos::internal::state::protobuf::Variable;
 
+using process::collect;
 using process::dispatch;
 using process::spawn;
 using process::terminate;
@@ -64,11 +73,14 @@ using process::USAGE;
 
 using process::http::OK;
 
-using process::metrics::Gauge;
+using process::metrics::PushGauge;
 using process::metrics::Timer;
 
 using std::deque;
+using std::list;
+using std::set;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -77,12 +89,18 @@ namespace master {
 using process::http::Response;
 using process::http::Request;
 
+// The names of the variables of the deltas of the registry, which are
+// followed by their consecutive numbers starting at 1, see
+// RegistrarProcess::update().
+static const char REGISTRY_DELTA_PREFIX[] = "registry_delta_";
+
 class RegistrarProcess : public Process<RegistrarProcess>
 {
 public:
   RegistrarProcess(const Flags& _flags, State* _state)
     : ProcessBase(process::ID::generate("registrar")),
-      metrics(*this),
+      metrics(),
+      firstDelta(1),
       updating(false),
       flags(_flags),
       state(_state) {}
@@ -97,6 +115,10 @@ protected:
   virtual void initialize()
   {
     route("/registry", registryHelp(), &RegistrarProcess::registry);
+
+    if (flags.registry_standby_interval.isSome()) {
+      follow();
+    }
   }
 
 private:
@@ -128,13 +150,9 @@ private:
   // Metrics.
   struct Metrics
   {
-    explicit Metrics(const RegistrarProcess& process)
-      : queued_operations(
-            "registrar/queued_operations",
-            defer(process, &RegistrarProcess::_queued_operations)),
-        registry_size_bytes(
-            "registrar/registry_size_bytes",
-            defer(process, &RegistrarProcess::_registry_size_bytes)),
+    Metrics()
+      : queued_operations("registrar/queued_operations"),
+        registry_size_bytes("registrar/registry_size_bytes"),
         state_fetch("registrar/state_fetch"),
         state_store("registrar/state_store", Days(1))
     {
@@ -154,29 +172,24 @@ private:
       process::metrics::remove(state_store);
     }
 
-    Gauge queued_operations;
-    Gauge registry_size_bytes;
+    PushGauge queued_operations;
+
+    // NOTE: This is 0 until the registry is recovered.
+    PushGauge registry_size_bytes;
 
     Timer<Milliseconds> state_fetch;
     Timer<Milliseconds> state_store;
   } metrics;
 
-  // Gauge handlers.
-  double _queued_operations()
-  {
-    return operations.size();
-  }
-
-  Future<double> _registry_size_bytes()
-  {
-    if (variable.isSome()) {
-      return variable.get().get().ByteSize();
-    }
-
-    return Failure("Not recovered yet");
-  }
+  // Reads the registry periodically until we recover, so that a
+  // standby master keeps it warm for when it gets elected.
+  void follow();
+  void _follow(const Future<Variable<Registry> >& registry);
 
   // Continuations.
+  Future<Variable<Registry> > fetchDeltas(const Variable<Registry>& registry);
+  Future<list<Variable<RegistryDelta> > > _fetchDeltas(
+      const set<string>& names);
   void _recover(
       const MasterInfo& info,
       const Future<Variable<Registry> >& recovery);
@@ -186,16 +199,40 @@ private:
   // Helper for updating state (performing store).
   void update();
   void _update(
-      const Future<Option<Variable<Registry> > >& store,
+      const Future<bool>& store,
       deque<Owned<Operation> > operations);
 
+  // Helpers for storing the registry, or a delta of it. They return
+  // false on a version mismatch.
+  Future<bool> store();
+  Future<bool> store(const RegistryDelta& delta);
+  Future<bool> expunge();
+
   // Fails all pending operations and transitions the Registrar
   // into an error state in which all subsequent operations will fail.
   // This ensures we don't attempt to re-acquire log leadership by
   // performing more State storage operations.
   void abort(const string& message);
 
+  // The latest whole registry that was stored, i.e., the snapshot
+  // that the deltas apply to.
   Option<Variable<Registry> > variable;
+
+  // The whole registry as last read while following, which recovery
+  // reuses rather than parsing it again if it did not change since.
+  Option<Variable<Registry> > standby;
+
+  // The deltas stored since 'variable', the first of them numbered
+  // 'firstDelta'.
+  deque<Variable<RegistryDelta> > deltas;
+  size_t firstDelta;
+
+  // The registry with all the operations applied, and the accumulator
+  // of the ids of its slaves, which we keep to avoid copying or
+  // scanning every slave on each update.
+  Option<Registry> current;
+  hashset<SlaveID> slaveIDs;
+
   deque<Owned<Operation> > operations;
   bool updating; // Used to signify fetching (recovering) or storing.
 
@@ -235,15 +272,92 @@ void fail(deque<Owned<Operation>>* operations, const string& message)
 }
 
 
+// Returns all of the registry but its slaves, without copying them.
+static Registry others(Registry* registry)
+{
+  Registry::Slaves slaves;
+  slaves.Swap(registry->mutable_slaves());
+
+  Registry others = *registry;
+  others.clear_slaves();
+
+  registry->mutable_slaves()->Swap(&slaves);
+
+  return others;
+}
+
+
+// Applies a delta to the registry. Applying a delta again is a no-op,
+// so is applying the deltas to a registry that already contains any
+// of them, as long as the deltas after them are applied as well.
+static void patch(const RegistryDelta& delta, Registry* registry)
+{
+  hashset<SlaveID> ids;
+  foreach (const SlaveID& slaveId, delta.removed_slaves()) {
+    ids.insert(slaveId);
+  }
+
+  // Added slaves replace those with the same id.
+  foreach (const Registry::Slave& slave, delta.added_slaves()) {
+    ids.insert(slave.info().id());
+  }
+
+  if (!ids.empty()) {
+    google::protobuf::RepeatedPtrField<Registry::Slave>* slaves =
+      registry->mutable_slaves()->mutable_slaves();
+
+    // Remove the slaves in a single pass, keeping the order of the
+    // others.
+    int size = 0;
+    for (int i = 0; i < slaves->size(); i++) {
+      if (!ids.contains(slaves->Get(i).info().id())) {
+        slaves->SwapElements(i, size++);
+      }
+    }
+
+    while (slaves->size() > size) {
+      slaves->RemoveLast();
+    }
+
+    foreach (const Registry::Slave& slave, delta.added_slaves()) {
+      slaves->Add()->CopyFrom(slave);
+    }
+  }
+
+  if (delta.has_others()) {
+    Registry::Slaves slaves;
+    slaves.Swap(registry->mutable_slaves());
+
+    registry->CopyFrom(delta.others());
+
+    registry->mutable_slaves()->Swap(&slaves);
+  }
+}
+
+
 Future<Response> RegistrarProcess::registry(const Request& request)
 {
-  JSON::Object result;
+  Option<string> jsonp = request.url.query.get("jsonp");
 
-  if (variable.isSome()) {
-    result = JSON::protobuf(variable.get().get());
+  if (current.isNone()) {
+    return OK(JSON::Object(), jsonp);
   }
 
-  return OK(result, request.url.query.get("jsonp"));
+  // Serialize the registry directly rather than first converting it
+  // into a JSON::Object, since the registry includes every agent.
+  string body = jsonp.isSome() ? jsonp.get() + "(" : "";
+
+  JSON::serialize(current.get(), &body);
+
+  if (jsonp.isSome()) {
+    body += ");";
+  }
+
+  OK response(body);
+  response.headers["Content-Type"] =
+    jsonp.isSome() ? "text/javascript" : "application/json";
+
+  return response;
 }
 
 
@@ -307,7 +421,8 @@ Future<Registry> RegistrarProcess::recover(const MasterInfo& info)
     LOG(INFO) << "Recovering registrar";
 
     metrics.state_fetch.start();
-    state->fetch<Registry>("registry")
+    state->fetch<Registry>("registry", standby)
+      .then(defer(self(), &Self::fetchDeltas, lambda::_1))
       .after(flags.registry_fetch_timeout,
              lambda::bind(
                  &timeout<Variable<Registry> >,
@@ -323,6 +438,86 @@ Future<Registry> RegistrarProcess::recover(const MasterInfo& info)
 }
 
 
+void RegistrarProcess::follow()
+{
+  // Once recovering, the registry is read for real.
+  if (recovered.isSome()) {
+    return;
+  }
+
+  state->follow<Registry>("registry", standby)
+    .onAny(defer(self(), &Self::_follow, lambda::_1));
+}
+
+
+void RegistrarProcess::_follow(const Future<Variable<Registry> >& registry)
+{
+  if (recovered.isSome()) {
+    return;
+  }
+
+  if (registry.isReady()) {
+    standby = registry.get();
+  } else {
+    LOG(WARNING) << "Failed to follow the registry: "
+                 << (registry.isFailed() ? registry.failure() : "discarded");
+  }
+
+  CHECK_SOME(flags.registry_standby_interval);
+  delay(flags.registry_standby_interval.get(), self(), &Self::follow);
+}
+
+
+Future<Variable<Registry> > RegistrarProcess::fetchDeltas(
+    const Variable<Registry>& registry)
+{
+  return state->names()
+    .then(defer(self(), &Self::_fetchDeltas, lambda::_1))
+    .then(defer(self(), [=](const list<Variable<RegistryDelta> >& fetched) {
+      deltas = deque<Variable<RegistryDelta> >(fetched.begin(), fetched.end());
+      return registry;
+    }));
+}
+
+
+Future<list<Variable<RegistryDelta> > > RegistrarProcess::_fetchDeltas(
+    const set<string>& names)
+{
+  vector<size_t> numbers;
+  foreach (const string& name, names) {
+    if (strings::startsWith(name, REGISTRY_DELTA_PREFIX)) {
+      Try<size_t> number = numify<size_t>(
+          strings::remove(name, REGISTRY_DELTA_PREFIX, strings::PREFIX));
+
+      if (number.isError()) {
+        return Failure("Invalid registry delta '" + name + "'");
+      }
+
+      numbers.push_back(number.get());
+    }
+  }
+
+  std::sort(numbers.begin(), numbers.end());
+
+  // Compaction expunges the deltas in order, so the deltas left over
+  // from an interrupted compaction are the last ones.
+  firstDelta = numbers.empty() ? 1 : numbers.front();
+
+  list<Future<Variable<RegistryDelta> > > futures;
+  for (size_t i = 0; i < numbers.size(); i++) {
+    if (numbers[i] != firstDelta + i) {
+      return Failure(
+          "Missing registry delta " + stringify(firstDelta + i));
+    }
+
+    futures.push_back(state->fetch<RegistryDelta>(
+        REGISTRY_DELTA_PREFIX + stringify(numbers[i])));
+  }
+
+  return collect(futures);
+}
+
+
 void RegistrarProcess::_recover(
     const MasterInfo& info,
     const Future<Variable<Registry> >& recovery)
@@ -337,16 +532,31 @@ void RegistrarProcess::_recover(
   } else {
     Duration elapsed = metrics.state_fetch.stop();
 
+    standby = None();
+
+    // Save the registry, and apply the deltas stored after it.
+    variable = recovery.get();
+    current = variable.get().get();
+
+    foreach (const Variable<RegistryDelta>& delta, deltas) {
+      patch(delta.get(), &current.get());
+    }
+
+    foreach (const Registry::Slave& slave, current.get().slaves().slaves()) {
+      slaveIDs.insert(slave.info().id());
+    }
+
     LOG(INFO) << "Successfully fetched the registry"
-              << " (" << Bytes(recovery.get().get().ByteSize()) << ")"
+              << " (" << Bytes(current.get().ByteSize()) << ")"
+              << " and " << deltas.size() << " deltas of it"
               << " in " << elapsed;
 
-    // Save the registry.
-    variable = recovery.get();
+    metrics.registry_size_bytes = current.get().ByteSize();
 
     // Perform the Recover operation to add the new MasterInfo.
     Owned<Operation> operation(new Recover(info));
     operations.push_back(operation);
+    metrics.queued_operations = operations.size();
     operation->future()
       .onAny(defer(self(), &Self::__recover, lambda::_1));
 
@@ -369,11 +579,11 @@ void RegistrarProcess::__recover(const Future<bool>& recover)
   } else {
     LOG(INFO) << "Successfully recovered registrar";
 
-    // At this point _update() has updated 'variable' to contain
+    // At this point update() has updated 'current' to contain
     // the Registry with the latest MasterInfo.
     // Set the promise and un-gate any pending operations.
-    CHECK_SOME(variable);
-    recovered.get()->set(variable.get().get());
+    CHECK_SOME(current);
+    recovered.get()->set(current.get());
   }
 }
 
@@ -395,9 +605,11 @@ Future<bool> RegistrarProcess::_apply(Owned<Operation> operation)
     return Failure(error.get());
   }
 
-  CHECK_SOME(variable);
+  CHECK_SOME(current);
 
   operations.push_back(operation);
+  metrics.queued_operations = operations.size();
+
   Future<bool> future = operation->future();
   if (!updating) {
     update();
@@ -414,7 +626,7 @@ void RegistrarProcess::update()
 
   CHECK(!updating);
   CHECK_NONE(error);
-  CHECK_SOME(variable);
+  CHECK_SOME(current);
 
   // Time how long it takes to apply the operations.
   Stopwatch stopwatch;
@@ -422,29 +634,113 @@ void RegistrarProcess::update()
 
   updating = true;
 
-  // Create a snapshot of the current registry.
-  Registry registry = variable.get().get();
+  // The operations are applied to the current registry in place, as
+  // the registrar aborts if storing them fails.
+  Registry* registry = &current.get();
+
+  // Whether to store the changes as a delta, rather than the whole
+  // registry, which also expunges the deltas.
+  const bool delta = deltas.size() < flags.registry_max_deltas;
+
+  // To compute the delta we follow the ids of the slaves through the
+  // operations, which only ever append slaves or remove them, and
+  // remember which of them were appended.
+  vector<SlaveID> ids;
+  vector<bool> appended;
+  string before;
+
+  if (delta) {
+    ids.reserve(registry->slaves().slaves().size());
+    foreach (const Registry::Slave& slave, registry->slaves().slaves()) {
+      ids.push_back(slave.info().id());
+    }
 
-  // Create the 'slaveIDs' accumulator.
-  hashset<SlaveID> slaveIDs;
-  foreach (const Registry::Slave& slave, registry.slaves().slaves()) {
-    slaveIDs.insert(slave.info().id());
+    appended.resize(ids.size(), false);
+    before = others(registry).SerializeAsString();
   }
 
+  RegistryDelta changes;
+
   foreach (Owned<Operation> operation, operations) {
+    const int size = registry->slaves().slaves().size();
+
     // No need to process the result of the operation.
-    (*operation)(&registry, &slaveIDs, flags.registry_strict);
+    (*operation)(registry, &slaveIDs, flags.registry_strict);
+
+    if (!delta || registry->slaves().slaves().size() == size) {
+      continue;
+    }
+
+    const google::protobuf::RepeatedPtrField<Registry::Slave>& slaves =
+      registry->slaves().slaves();
+
+    if (slaves.size() > size) {
+      CHECK_EQ(size + 1, slaves.size());
+
+      ids.push_back(slaves.Get(size).info().id());
+      appended.push_back(true);
+    } else {
+      // Removing slaves keeps the order of the remaining ones, so the
+      // removed slaves are those whose ids are not found in order.
+      vector<SlaveID> _ids;
+      vector<bool> _appended;
+
+      _ids.reserve(slaves.size());
+      _appended.reserve(slaves.size());
+
+      int j = 0;
+      for (size_t i = 0; i < ids.size(); i++) {
+        if (j < slaves.size() && slaves.Get(j).info().id() == ids[i]) {
+          _ids.push_back(ids[i]);
+          _appended.push_back(appended[i]);
+          j++;
+        } else if (!appended[i]) {
+          changes.add_removed_slaves()->CopyFrom(ids[i]);
+        }
+      }
+
+      CHECK_EQ(slaves.size(), j);
+
+      ids.swap(_ids);
+      appended.swap(_appended);
+    }
   }
 
-  LOG(INFO) << "Applied " << operations.size() << " operations in "
-            << stopwatch.elapsed() << "; attempting to update the 'registry'";
+  metrics.registry_size_bytes = registry->ByteSize();
+
+  Future<bool> store;
+
+  if (delta) {
+    for (size_t i = 0; i < appended.size(); i++) {
+      if (appended[i]) {
+        changes.add_added_slaves()->CopyFrom(registry->slaves().slaves(i));
+      }
+    }
+
+    Registry after = others(registry);
+    if (after.SerializeAsString() != before) {
+      changes.mutable_others()->CopyFrom(after);
+    }
+
+    LOG(INFO) << "Applied " << operations.size() << " operations in "
+              << stopwatch.elapsed() << "; attempting to store delta "
+              << firstDelta + deltas.size() << " of the 'registry'";
+
+    metrics.state_store.start();
+    store = this->store(changes);
+  } else {
+    LOG(INFO) << "Applied " << operations.size() << " operations in "
+              << stopwatch.elapsed() << "; attempting to update the 'registry'";
+
+    metrics.state_store.start();
+    store = this->store();
+  }
 
   // Perform the store, and time the operation.
-  metrics.state_store.start();
-  state->store(variable.get().mutate(registry))
+  store
     .after(flags.registry_store_timeout,
            lambda::bind(
-               &timeout<Option<Variable<Registry> > >,
+               &timeout<bool>,
                "store",
                flags.registry_store_timeout,
                lambda::_1))
@@ -452,17 +748,81 @@ void RegistrarProcess::update()
 
   // Clear the operations, _update will transition the Promises!
   operations.clear();
+  metrics.queued_operations = 0;
+}
+
+
+Future<bool> RegistrarProcess::store()
+{
+  CHECK_SOME(variable);
+
+  return state->store(variable.get().mutate(current.get()))
+    .then(defer(self(), [=](const Option<Variable<Registry> >& stored)
+        -> Future<bool> {
+      if (stored.isNone()) {
+        return false;
+      }
+
+      variable = stored.get();
+
+      // The deltas are part of the stored registry now.
+      return expunge();
+    }));
+}
+
+
+Future<bool> RegistrarProcess::store(const RegistryDelta& delta)
+{
+  const string name =
+    REGISTRY_DELTA_PREFIX + stringify(firstDelta + deltas.size());
+
+  return state->fetch<RegistryDelta>(name)
+    .then(defer(self(), [=](const Variable<RegistryDelta>& variable) {
+      return state->store(variable.mutate(delta));
+    }))
+    .then(defer(self(), [=](const Option<Variable<RegistryDelta> >& stored) {
+      if (stored.isNone()) {
+        return false;
+      }
+
+      deltas.push_back(stored.get());
+      return true;
+    }));
+}
+
+
+Future<bool> RegistrarProcess::expunge()
+{
+  if (deltas.empty()) {
+    firstDelta = 1;
+    return true;
+  }
+
+  // We expunge the deltas in order, so that a master that fails over
+  // during this only recovers the last ones, which the stored
+  // registry already contains (see 'patch()').
+  return state->expunge(deltas.front())
+    .then(defer(self(), [=](bool expunged) -> Future<bool> {
+      if (!expunged) {
+        return false;
+      }
+
+      deltas.pop_front();
+      firstDelta++;
+
+      return expunge();
+    }));
 }
 
 
 void RegistrarProcess::_update(
-    const Future<Option<Variable<Registry> > >& store,
+    const Future<bool>& store,
     deque<Owned<Operation> > applied)
 {
   updating = false;
 
   // Abort if the storage operation did not succeed.
-  if (!store.isReady() || store.get().isNone()) {
+  if (!store.isReady() || !store.get()) {
     string message = "Failed to update 'registry': ";
 
     if (store.isFailed()) {
@@ -483,8 +843,6 @@ void RegistrarProcess::_update(
 
   LOG(INFO) << "Successfully updated the 'registry' in " << elapsed;
 
-  variable = store.get().get();
-
   // Remove the operations.
   while (!applied.empty()) {
     Owned<Operation> operation = applied.front();
@@ -506,6 +864,7 @@ void RegistrarProcess::abort(const string& message)
   LOG(ERROR) << "Registrar aborting: " << message;
 
   fail(&operations, message);
+  metrics.queued_operations = 0;
 }
 
 
@@ -116,6 +116,12 @@ Option<Error> validate(const mesos::scheduler::Call& call)
       }
       return None();
 
+    case mesos::scheduler::Call::ACKNOWLEDGEMENTS:
+      if (!call.has_acknowledgements()) {
+        return Error("Expecting 'acknowledgements' to be present");
+      }
+      return None();
+
     case mesos::scheduler::Call::RECONCILE:
       if (!call.has_reconcile()) {
         return Error("Expecting 'reconcile' to be present");
@@ -323,10 +329,8 @@ Option<Error> validateSlaveID(const TaskInfo& task, Slave* slave)
 }
 
 
-// Validates that tasks that use the "same" executor (i.e., same
-// ExecutorID) have an identical ExecutorInfo.
-Option<Error> validateExecutorInfo(
-    const TaskInfo& task, Framework* framework, Slave* slave)
+// Validates that a task has either a command or an executor.
+Option<Error> validateCommandOrExecutor(const TaskInfo& task)
 {
   if (task.has_executor() == task.has_command()) {
     return Error(
@@ -334,6 +338,15 @@ Option<Error> validateExecutorInfo(
         "ExecutorInfo present");
   }
 
+  return None();
+}
+
+
+// Validates that tasks that use the "same" executor (i.e., same
+// ExecutorID) have an identical ExecutorInfo.
+Option<Error> validateExecutorInfo(
+    const TaskInfo& task, Framework* framework, Slave* slave)
+{
   if (task.has_executor()) {
     // The master currently expects ExecutorInfo.framework_id to be
     // set even though it is an optional field. Currently, the
@@ -353,7 +366,7 @@ Option<Error> validateExecutorInfo(
 
     if (slave->hasExecutor(framework->id(), executorId)) {
       executorInfo =
-        slave->executors.get(framework->id()).get().get(executorId);
+        *slave->executors.get(framework->id()).get().get(executorId).get();
     }
 
     if (executorInfo.isSome() && !(task.executor() == executorInfo.get())) {
@@ -498,6 +511,25 @@ Option<Error> validateResources(const TaskInfo& task)
 } // namespace internal {
 
 
+Option<Error> validate(const TaskInfo& task)
+{
+  vector<lambda::function<Option<Error>(void)>> validators = {
+    lambda::bind(internal::validateTaskID, task),
+    lambda::bind(internal::validateCommandOrExecutor, task),
+    lambda::bind(internal::validateResources, task)
+  };
+
+  foreach (const lambda::function<Option<Error>(void)>& validator, validators) {
+    Option<Error> error = validator();
+    if (error.isSome()) {
+      return error;
+    }
+  }
+
+  return None();
+}
+
+
 Option<Error> validate(
     const TaskInfo& task,
     Framework* framework,
@@ -512,12 +544,10 @@ Option<Error> validate(
   // assumes that ExecutorInfo is valid which is verified by
   // 'validateExecutorInfo'.
   vector<lambda::function<Option<Error>(void)>> validators = {
-    lambda::bind(internal::validateTaskID, task),
     lambda::bind(internal::validateUniqueTaskID, task, framework),
     lambda::bind(internal::validateSlaveID, task, slave),
     lambda::bind(internal::validateExecutorInfo, task, framework, slave),
     lambda::bind(internal::validateCheckpoint, framework, slave),
-    lambda::bind(internal::validateResources, task),
     lambda::bind(
         internal::validateResourceUsage, task, framework, slave, offered)
   };
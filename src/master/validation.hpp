@@ -60,11 +60,18 @@ Option<Error> validate(
 
 namespace task {
 
+// Validates the parts of a task that do not depend on the state of the
+// master, e.g., its ID and its resources. Since it only looks at the
+// task, it can be called for many tasks concurrently.
+Option<Error> validate(const TaskInfo& task);
+
+
 // Validates a task that a framework attempts to launch within the
 // offered resources. Returns an optional error which will cause the
 // master to send a failed status update back to the framework.
 // NOTE: This function must be called sequentially for each task, and
 // each task needs to be launched before the next can be validated.
+// It assumes that the task passed the validation above.
 Option<Error> validate(
     const TaskInfo& task,
     Framework* framework,
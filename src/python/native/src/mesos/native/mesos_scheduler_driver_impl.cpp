@@ -179,6 +179,7 @@ PyObject* MesosSchedulerDriverImpl_new(PyTypeObject* type,
     self->driver = NULL;
     self->proxyScheduler = NULL;
     self->pythonScheduler = NULL;
+    self->raw = false;
   }
   return (PyObject*) self;
 }
@@ -191,25 +192,42 @@ int MesosSchedulerDriverImpl_init(MesosSchedulerDriverImpl* self,
                                   PyObject* args,
                                   PyObject* kwds)
 {
-  // Note: We use an integer for 'implicitAcknoweldgements' because
-  // it is the recommended way to pass booleans through CPython.
+  // Note: We use integers for 'implicitAcknoweldgements' and 'raw'
+  // because it is the recommended way to pass booleans through
+  // CPython.
   PyObject* schedulerObj = NULL;
   PyObject* frameworkObj = NULL;
   const char* master;
   int implicitAcknowledgements = 1; // Enabled by default.
   PyObject* credentialObj = NULL;
-
-  if (!PyArg_ParseTuple(
+  int raw = 0; // Disabled by default.
+
+  static const char* kwlist[] = {
+    "scheduler",
+    "framework",
+    "master",
+    "implicitAcknowledgements",
+    "credential",
+    "raw",
+    NULL
+  };
+
+  if (!PyArg_ParseTupleAndKeywords(
       args,
-      "OOs|iO",
+      kwds,
+      "OOs|iOi",
+      (char**) kwlist,
       &schedulerObj,
       &frameworkObj,
       &master,
       &implicitAcknowledgements,
-      &credentialObj)) {
+      &credentialObj,
+      &raw)) {
     return -1;
   }
 
+  self->raw = raw != 0;
+
   if (schedulerObj != NULL) {
     PyObject* tmp = self->pythonScheduler;
     Py_INCREF(schedulerObj);
@@ -325,7 +343,10 @@ PyObject* MesosSchedulerDriverImpl_start(MesosSchedulerDriverImpl* self)
     return NULL;
   }
 
-  Status status = self->driver->start();
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->start();
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
 
@@ -344,7 +365,10 @@ PyObject* MesosSchedulerDriverImpl_stop(MesosSchedulerDriverImpl* self,
     return NULL;
   }
 
-  Status status = self->driver->stop(failover);
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->stop(failover);
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
 
@@ -356,7 +380,10 @@ PyObject* MesosSchedulerDriverImpl_abort(MesosSchedulerDriverImpl* self)
     return NULL;
   }
 
-  Status status = self->driver->abort();
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->abort();
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
 
@@ -426,7 +453,10 @@ PyObject* MesosSchedulerDriverImpl_requestResources(
     requests.push_back(request);
   }
 
-  Status status = self->driver->requestResources(requests);
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->requestResources(requests);
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
 
@@ -503,7 +533,10 @@ PyObject* MesosSchedulerDriverImpl_launchTasks(MesosSchedulerDriverImpl* self,
     }
   }
 
-  Status status = self->driver->launchTasks(offerIds, tasks, filters);
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->launchTasks(offerIds, tasks, filters);
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
 
@@ -526,7 +559,10 @@ PyObject* MesosSchedulerDriverImpl_killTask(MesosSchedulerDriverImpl* self,
     return NULL;
   }
 
-  Status status = self->driver->killTask(tid);
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->killTask(tid);
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
 
@@ -605,7 +641,10 @@ PyObject* MesosSchedulerDriverImpl_acceptOffers(MesosSchedulerDriverImpl* self,
     }
   }
 
-  Status status = self->driver->acceptOffers(offerIds, operations, filters);
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->acceptOffers(offerIds, operations, filters);
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
 
@@ -640,7 +679,10 @@ PyObject* MesosSchedulerDriverImpl_declineOffer(MesosSchedulerDriverImpl* self,
     }
   }
 
-  Status status = self->driver->declineOffer(offerId, filters);
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->declineOffer(offerId, filters);
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
 
@@ -652,7 +694,10 @@ PyObject* MesosSchedulerDriverImpl_reviveOffers(MesosSchedulerDriverImpl* self)
     return NULL;
   }
 
-  Status status = self->driver->reviveOffers();
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->reviveOffers();
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
 
@@ -665,7 +710,10 @@ PyObject* MesosSchedulerDriverImpl_suppressOffers(
     return NULL;
   }
 
-  Status status = self->driver->suppressOffers();
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->suppressOffers();
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
 
@@ -691,7 +739,10 @@ PyObject* MesosSchedulerDriverImpl_acknowledgeStatusUpdate(
     return NULL;
   }
 
-  Status status = self->driver->acknowledgeStatusUpdate(taskStatus);
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->acknowledgeStatusUpdate(taskStatus);
+  Py_END_ALLOW_THREADS
 
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
@@ -728,8 +779,11 @@ PyObject* MesosSchedulerDriverImpl_sendFrameworkMessage(
     return NULL;
   }
 
-  Status status = self->driver->sendFrameworkMessage(
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->sendFrameworkMessage(
       executorId, slaveId, string(data, length));
+  Py_END_ALLOW_THREADS
 
   return PyInt_FromLong(status); // Sets exception if creating long fails.
 }
@@ -774,7 +828,10 @@ PyObject* MesosSchedulerDriverImpl_reconcileTasks(
     statuses.push_back(status);
   }
 
-  Status status = self->driver->reconcileTasks(statuses);
+  Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = self->driver->reconcileTasks(statuses);
+  Py_END_ALLOW_THREADS
   return PyInt_FromLong(status);
 }
 
@@ -33,6 +33,7 @@ struct MesosSchedulerDriverImpl {
     MesosSchedulerDriver* driver;
     ProxyScheduler* proxyScheduler;
     PyObject* pythonScheduler;
+    bool raw; /* Whether protobufs are passed as serialized strings. */
 };
 
 /**
@@ -54,8 +54,10 @@ public:
 
 /**
  * Convert a Python protocol buffer object into a C++ one by serializing
- * it to a string and deserializing the result back in C++. Returns true
- * on success, or prints an error and returns false on failure.
+ * it to a string and deserializing the result back in C++. The object
+ * can also be an already serialized protobuf (a string), in which case
+ * it is deserialized directly. Returns true on success, or prints an
+ * error and returns false on failure.
  */
 template <typename T>
 bool readPythonProtobuf(PyObject* obj, T* t)
@@ -64,6 +66,15 @@ bool readPythonProtobuf(PyObject* obj, T* t)
     std::cerr << "None object given where protobuf expected" << std::endl;
     return false;
   }
+  if (PyString_Check(obj)) {
+    bool success =
+      t->ParseFromArray(PyString_AS_STRING(obj), PyString_GET_SIZE(obj));
+    if (!success) {
+      std::cerr << "Could not deserialize protobuf as expected type"
+                << std::endl;
+    }
+    return success;
+  }
   PyObject* res = PyObject_CallMethod(obj,
                                       (char*) "SerializeToString",
                                       (char*) NULL);
@@ -93,13 +104,29 @@ bool readPythonProtobuf(PyObject* obj, T* t)
 
 /**
  * Convert a C++ protocol buffer object into a Python one by serializing
- * it to a string and deserializing the result back in Python. Returns the
- * resulting PyObject* on success or raises a Python exception and returns
- * NULL on failure.
+ * it to a string and deserializing the result back in Python. If 'raw'
+ * is set the serialized string itself is returned, leaving the choice
+ * of the protobuf implementation to the caller. Returns the resulting
+ * PyObject* on success or raises a Python exception and returns NULL on
+ * failure.
  */
 template <typename T>
-PyObject* createPythonProtobuf(const T& t, const char* typeName)
+PyObject* createPythonProtobuf(
+    const T& t,
+    const char* typeName,
+    bool raw = false)
 {
+  if (raw) {
+    std::string str;
+    if (!t.SerializeToString(&str)) {
+      PyErr_Format(PyExc_Exception,
+                   "C++ %s SerializeToString failed",
+                   typeName);
+      return NULL;
+    }
+    return PyString_FromStringAndSize(str.data(), str.size());
+  }
+
   PyObject* dict = PyModule_GetDict(mesos_pb2);
   if (dict == NULL) {
     PyErr_Format(PyExc_Exception, "PyModule_GetDict failed");
@@ -45,12 +45,12 @@ void ProxyScheduler::registered(SchedulerDriver* driver,
   PyObject* minfo = NULL;
   PyObject* res = NULL;
 
-  fid = createPythonProtobuf(frameworkId, "FrameworkID");
+  fid = createPythonProtobuf(frameworkId, "FrameworkID", impl->raw);
   if (fid == NULL) {
     goto cleanup; // createPythonProtobuf will have set an exception.
   }
 
-  minfo = createPythonProtobuf(masterInfo, "MasterInfo");
+  minfo = createPythonProtobuf(masterInfo, "MasterInfo", impl->raw);
   if (minfo == NULL) {
     goto cleanup; // createPythonProtobuf will have set an exception.
   }
@@ -85,7 +85,7 @@ void ProxyScheduler::reregistered(SchedulerDriver* driver,
   PyObject* minfo = NULL;
   PyObject* res = NULL;
 
-  minfo = createPythonProtobuf(masterInfo, "MasterInfo");
+  minfo = createPythonProtobuf(masterInfo, "MasterInfo", impl->raw);
   if (minfo == NULL) {
     goto cleanup; // createPythonProtobuf will have set an exception.
   }
@@ -147,7 +147,7 @@ void ProxyScheduler::resourceOffers(SchedulerDriver* driver,
     goto cleanup;
   }
   for (size_t i = 0; i < offers.size(); i++) {
-    PyObject* offer = createPythonProtobuf(offers[i], "Offer");
+    PyObject* offer = createPythonProtobuf(offers[i], "Offer", impl->raw);
     if (offer == NULL) {
       goto cleanup;
     }
@@ -183,7 +183,7 @@ void ProxyScheduler::offerRescinded(SchedulerDriver* driver,
   PyObject* oid = NULL;
   PyObject* res = NULL;
 
-  oid = createPythonProtobuf(offerId, "OfferID");
+  oid = createPythonProtobuf(offerId, "OfferID", impl->raw);
   if (oid == NULL) {
     goto cleanup; // createPythonProtobuf will have set an exception.
   }
@@ -216,7 +216,7 @@ void ProxyScheduler::statusUpdate(SchedulerDriver* driver,
   PyObject* stat = NULL;
   PyObject* res = NULL;
 
-  stat = createPythonProtobuf(status, "TaskStatus");
+  stat = createPythonProtobuf(status, "TaskStatus", impl->raw);
   if (stat == NULL) {
     goto cleanup; // createPythonProtobuf will have set an exception.
   }
@@ -252,12 +252,12 @@ void ProxyScheduler::frameworkMessage(SchedulerDriver* driver,
   PyObject* sid = NULL;
   PyObject* res = NULL;
 
-  eid = createPythonProtobuf(executorId, "ExecutorID");
+  eid = createPythonProtobuf(executorId, "ExecutorID", impl->raw);
   if (eid == NULL) {
     goto cleanup; // createPythonProtobuf will have set an exception.
   }
 
-  sid = createPythonProtobuf(slaveId, "SlaveID");
+  sid = createPythonProtobuf(slaveId, "SlaveID", impl->raw);
   if (sid == NULL) {
     goto cleanup; // createPythonProtobuf will have set an exception.
   }
@@ -293,7 +293,7 @@ void ProxyScheduler::slaveLost(SchedulerDriver* driver, const SlaveID& slaveId)
   PyObject* sid = NULL;
   PyObject* res = NULL;
 
-  sid = createPythonProtobuf(slaveId, "SlaveID");
+  sid = createPythonProtobuf(slaveId, "SlaveID", impl->raw);
   if (sid == NULL) {
     goto cleanup; // createPythonProtobuf will have set an exception.
   }
@@ -329,8 +329,8 @@ void ProxyScheduler::executorLost(SchedulerDriver* driver,
   PyObject* slaveIdObj = NULL;
   PyObject* res = NULL;
 
-  executorIdObj = createPythonProtobuf(executorId, "ExecutorID");
-  slaveIdObj = createPythonProtobuf(slaveId, "SlaveID");
+  executorIdObj = createPythonProtobuf(executorId, "ExecutorID", impl->raw);
+  slaveIdObj = createPythonProtobuf(slaveId, "SlaveID", impl->raw);
 
   if (executorIdObj == NULL || slaveIdObj == NULL) {
     goto cleanup; // createPythonProtobuf will have set an exception.
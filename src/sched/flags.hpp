@@ -99,11 +99,20 @@ public:
         "master. Use the default '" + DEFAULT_AUTHENTICATEE + "', or\n"
         "load an alternate authenticatee module using MESOS_MODULES.",
         DEFAULT_AUTHENTICATEE);
+
+    add(&Flags::batch_callbacks,
+        "batch_callbacks",
+        "Whether to deliver the offers, and the status updates, that the\n"
+        "driver receives at about the same time in a single callback,\n"
+        "i.e., 'Scheduler::resourceOffers' with the offers of several\n"
+        "messages and 'Scheduler::statusUpdates' with several updates.",
+        false);
   }
 
   Duration registration_backoff_factor;
   Option<Modules> modules;
   std::string authenticatee;
+  bool batch_callbacks;
 };
 
 } // namespace scheduler {
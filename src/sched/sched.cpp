@@ -154,6 +154,7 @@ public:
       running(true),
       detector(_detector),
       flags(_flags),
+      batching(false),
       implicitAcknowledgements(_implicitAcknowledgements),
       credential(_credential),
       authenticatee(NULL),
@@ -200,6 +201,10 @@ protected:
         &StatusUpdateMessage::update,
         &StatusUpdateMessage::pid);
 
+    install<ReconcileResultMessage>(
+        &SchedulerProcess::reconcileResult,
+        &ReconcileResultMessage::updates);
+
     install<LostSlaveMessage>(
         &SchedulerProcess::lostSlave,
         &LostSlaveMessage::slave_id);
@@ -233,6 +238,10 @@ protected:
       EXIT(1) << "Failed to detect a master: " << _master.failure();
     }
 
+    // Deliver any batched callbacks (and acknowledge the updates to
+    // the old master) first, see 'batch'.
+    flush();
+
     if (_master.get().isSome()) {
       master = _master.get().get();
     } else {
@@ -557,6 +566,36 @@ protected:
         break;
       }
 
+      case Event::RECONCILE_RESULT: {
+        if (!event.has_reconcile_result()) {
+          drop(event, "Expecting 'reconcile_result' to be present");
+          break;
+        }
+
+        vector<StatusUpdate> updates;
+
+        foreach (const TaskStatus& status,
+                 event.reconcile_result().statuses()) {
+          StatusUpdate update;
+          update.mutable_framework_id()->CopyFrom(framework.id());
+          update.mutable_status()->CopyFrom(status);
+          update.set_timestamp(status.timestamp());
+
+          if (status.has_executor_id()) {
+            update.mutable_executor_id()->CopyFrom(status.executor_id());
+          }
+
+          if (status.has_slave_id()) {
+            update.mutable_slave_id()->CopyFrom(status.slave_id());
+          }
+
+          updates.push_back(update);
+        }
+
+        reconcileResult(from, updates);
+        break;
+      }
+
       case Event::MESSAGE: {
         if (!event.has_message()) {
           drop(event, "Expecting 'message' to be present");
@@ -645,6 +684,9 @@ protected:
     connected = true;
     failover = false;
 
+    // Deliver any batched callbacks first, see 'batch'.
+    flush();
+
     Stopwatch stopwatch;
     if (FLAGS_v >= 1) {
       stopwatch.start();
@@ -687,6 +729,9 @@ protected:
     connected = true;
     failover = false;
 
+    // Deliver any batched callbacks first, see 'batch'.
+    flush();
+
     Stopwatch stopwatch;
     if (FLAGS_v >= 1) {
       stopwatch.start();
@@ -801,6 +846,17 @@ protected:
       }
     }
 
+    if (flags.batch_callbacks) {
+      // Keep the callbacks in order.
+      if (!pendingUpdates.empty()) {
+        flush();
+      }
+
+      pendingOffers.insert(pendingOffers.end(), offers.begin(), offers.end());
+      batch();
+      return;
+    }
+
     Stopwatch stopwatch;
     if (FLAGS_v >= 1) {
       stopwatch.start();
@@ -838,6 +894,9 @@ protected:
 
     savedOffers.erase(offerId);
 
+    // Deliver any batched callbacks first, see 'batch'.
+    flush();
+
     Stopwatch stopwatch;
     if (FLAGS_v >= 1) {
       stopwatch.start();
@@ -909,6 +968,27 @@ protected:
       status.set_uuid(update.uuid());
     }
 
+    // See above for when we don't need to acknowledge.
+    const bool acknowledge =
+      (update.has_uuid() && update.uuid() != "") ||
+      (from != UPID() && pid != UPID());
+
+    if (flags.batch_callbacks) {
+      // Keep the callbacks in order.
+      if (!pendingOffers.empty()) {
+        flush();
+      }
+
+      pendingUpdates.push_back(status);
+
+      if (acknowledge) {
+        pendingAcknowledgements.push_back(update);
+      }
+
+      batch();
+      return;
+    }
+
     Stopwatch stopwatch;
     if (FLAGS_v >= 1) {
       stopwatch.start();
@@ -918,7 +998,7 @@ protected:
 
     VLOG(1) << "Scheduler::statusUpdate took " << stopwatch.elapsed();
 
-    if (implicitAcknowledgements) {
+    if (implicitAcknowledgements && acknowledge) {
       // Note that we need to look at the atomic 'running' here
       // so that we don't acknowledge the update if the driver was
       // aborted during the processing of the update.
@@ -928,29 +1008,130 @@ protected:
         return;
       }
 
-      // See above for when we don't need to acknowledge.
-      if ((update.has_uuid() && update.uuid() != "") ||
-          (from != UPID() && pid != UPID())) {
-        // We drop updates while we're disconnected.
-        CHECK(connected);
-        CHECK_SOME(master);
+      // We drop updates while we're disconnected.
+      CHECK(connected);
 
-        VLOG(2) << "Sending ACK for status update " << update
-                << " to " << master.get().pid();
+      sendAcknowledgement(update);
+    }
+  }
 
-        Call call;
+  void reconcileResult(
+      const UPID& from,
+      const vector<StatusUpdate>& updates)
+  {
+    // The answers to reconciliation never need acknowledging, so we
+    // deliver each like an update without a 'uuid' or 'pid'.
+    foreach (const StatusUpdate& update, updates) {
+      StatusUpdate _update = update;
+      _update.clear_uuid();
+
+      statusUpdate(from, _update, UPID());
+    }
+  }
 
-        CHECK(framework.has_id());
-        call.mutable_framework_id()->CopyFrom(framework.id());
-        call.set_type(Call::ACKNOWLEDGE);
+  void sendAcknowledgement(const StatusUpdate& update)
+  {
+    CHECK_SOME(master);
 
-        Call::Acknowledge* acknowledge = call.mutable_acknowledge();
-        acknowledge->mutable_slave_id()->CopyFrom(update.slave_id());
-        acknowledge->mutable_task_id()->CopyFrom(update.status().task_id());
-        acknowledge->set_uuid(update.uuid());
+    VLOG(2) << "Sending ACK for status update " << update
+            << " to " << master.get().pid();
+
+    Call call;
+
+    CHECK(framework.has_id());
+    call.mutable_framework_id()->CopyFrom(framework.id());
+    call.set_type(Call::ACKNOWLEDGE);
 
-        CHECK_SOME(master);
-        send(master.get().pid(), call);
+    Call::Acknowledge* acknowledge = call.mutable_acknowledge();
+    acknowledge->mutable_slave_id()->CopyFrom(update.slave_id());
+    acknowledge->mutable_task_id()->CopyFrom(update.status().task_id());
+    acknowledge->set_uuid(update.uuid());
+
+    send(master.get().pid(), call);
+  }
+
+  // With '--batch_callbacks', the offers and status updates are not
+  // delivered right away but once the messages already queued for
+  // this process have been handled, so that the offers (updates) of
+  // the messages that arrived at about the same time are delivered
+  // in one callback without adding any latency. The batch is
+  // delivered earlier if the next callback is a different one, in
+  // order to keep the callbacks in order.
+  void batch()
+  {
+    if (!batching) {
+      batching = true;
+      dispatch(self(), &Self::_batch);
+    }
+  }
+
+  void _batch()
+  {
+    batching = false;
+    flush();
+  }
+
+  void flush()
+  {
+    if (!pendingOffers.empty()) {
+      vector<Offer> offers;
+      std::swap(offers, pendingOffers);
+
+      if (!running.load()) {
+        VLOG(1) << "Dropping " << offers.size() << " batched offers "
+                << "because the driver is not running!";
+        return;
+      }
+
+      Stopwatch stopwatch;
+      if (FLAGS_v >= 1) {
+        stopwatch.start();
+      }
+
+      scheduler->resourceOffers(driver, offers);
+
+      VLOG(1) << "Scheduler::resourceOffers took " << stopwatch.elapsed();
+    }
+
+    if (!pendingUpdates.empty()) {
+      vector<TaskStatus> statuses;
+      std::swap(statuses, pendingUpdates);
+
+      vector<StatusUpdate> updates;
+      std::swap(updates, pendingAcknowledgements);
+
+      if (!running.load()) {
+        VLOG(1) << "Dropping " << statuses.size() << " batched status "
+                << "updates because the driver is not running!";
+        return;
+      }
+
+      Stopwatch stopwatch;
+      if (FLAGS_v >= 1) {
+        stopwatch.start();
+      }
+
+      scheduler->statusUpdates(driver, statuses);
+
+      VLOG(1) << "Scheduler::statusUpdates took " << stopwatch.elapsed();
+
+      if (implicitAcknowledgements) {
+        // Note that we need to look at the atomic 'running' here
+        // so that we don't acknowledge the updates if the driver was
+        // aborted during the processing of the updates.
+        if (!running.load()) {
+          VLOG(1) << "Not sending status update acknowledgment messages "
+                  << "because the driver is not running!";
+          return;
+        }
+
+        // We drop updates while we're disconnected, and deliver the
+        // batch before we get disconnected.
+        CHECK(updates.empty() || connected);
+
+        foreach (const StatusUpdate& update, updates) {
+          sendAcknowledgement(update);
+        }
       }
     }
   }
@@ -982,6 +1163,9 @@ protected:
 
     savedSlavePids.erase(slaveId);
 
+    // Deliver any batched callbacks first, see 'batch'.
+    flush();
+
     Stopwatch stopwatch;
     if (FLAGS_v >= 1) {
       stopwatch.start();
@@ -1005,6 +1189,9 @@ protected:
 
     VLOG(2) << "Received framework message";
 
+    // Deliver any batched callbacks first, see 'batch'.
+    flush();
+
     Stopwatch stopwatch;
     if (FLAGS_v >= 1) {
       stopwatch.start();
@@ -1024,6 +1211,9 @@ protected:
 
     LOG(INFO) << "Got error '" << message << "'";
 
+    // Deliver any batched callbacks first, see 'batch'.
+    flush();
+
     driver->abort();
 
     Stopwatch stopwatch;
@@ -1491,6 +1681,14 @@ private:
   hashmap<OfferID, hashmap<SlaveID, UPID> > savedOffers;
   hashmap<SlaveID, UPID> savedSlavePids;
 
+  // The offers and status updates to deliver, and the updates to
+  // acknowledge, with '--batch_callbacks'. At most one of the offers
+  // and the status updates is not empty, see 'batch'.
+  vector<Offer> pendingOffers;
+  vector<TaskStatus> pendingUpdates;
+  vector<StatusUpdate> pendingAcknowledgements;
+  bool batching;
+
   // The driver optionally provides implicit acknowledgements
   // for frameworks. If disabled, the framework must send its
   // own acknowledgements through the driver, when the 'uuid'
@@ -53,7 +53,9 @@
 #include <stout/option.hpp>
 #include <stout/os.hpp>
 #include <stout/recordio.hpp>
+#include <stout/strings.hpp>
 #include <stout/uuid.hpp>
+#include <stout/version.hpp>
 
 #include "common/http.hpp"
 #include "common/recordio.hpp"
@@ -96,6 +98,11 @@ namespace mesos {
 namespace v1 {
 namespace scheduler {
 
+// The acknowledgements sent within this window are coalesced into
+// one ACKNOWLEDGEMENTS call, see 'MesosProcess::send'.
+static const Duration ACKNOWLEDGEMENTS_WINDOW = Milliseconds(5);
+
+
 // The process (below) is responsible for receiving messages
 // (eventually events) from the master and sending messages (via
 // calls) to the master.
@@ -114,7 +121,9 @@ public:
       disconnected(_disconnected),
       received(_received),
       local(false),
-      detector(NULL)
+      detector(NULL),
+      coalesce(false),
+      direct(false)
   {
     GOOGLE_PROTOBUF_VERIFY_VERSION;
 
@@ -169,6 +178,18 @@ public:
 
     // Save the detector so we can delete it later.
     detector = create.get();
+
+    // The framework messages are sent to the agents directly if asked
+    // to, which the agents must allow, see the slave flag
+    // '--direct_framework_messages'.
+    direct = os::getenv("MESOS_DIRECT_FRAMEWORK_MESSAGES").isSome();
+
+    // All calls but SUBSCRIBE are pipelined on a single persistent
+    // connection to the master, see '_send'.
+    http::ConnectionPool::Options options;
+    options.maxConnections = 1;
+
+    pool = http::ConnectionPool(options);
   }
 
   virtual ~MesosProcess()
@@ -187,10 +208,42 @@ public:
   using ProtobufProcess<MesosProcess>::send;
 
   void send(const Call& call)
+  {
+    // Masters which understand ACKNOWLEDGEMENTS calls get the
+    // acknowledgements in batches, which spares them an HTTP request
+    // per status update.
+    if (call.type() == Call::ACKNOWLEDGE && coalesce) {
+      if (acknowledgements.isNone()) {
+        Call batch;
+        batch.set_type(Call::ACKNOWLEDGEMENTS);
+        batch.mutable_acknowledgements();
+
+        if (call.has_framework_id()) {
+          batch.mutable_framework_id()->CopyFrom(call.framework_id());
+        }
+
+        acknowledgements = batch;
+
+        delay(ACKNOWLEDGEMENTS_WINDOW, self(), &Self::flush);
+      }
+
+      acknowledgements.get().mutable_acknowledgements()
+        ->add_acknowledgements()->CopyFrom(call.acknowledge());
+      return;
+    }
+
+    // Keep the acknowledgements in order with the other calls.
+    flush();
+
+    enqueue(call);
+  }
+
+protected:
+  void enqueue(const Call& call)
   {
     // NOTE: We enqueue the calls to guarantee that a call is sent only after
-    // a response has been received for the previous call.
-    // TODO(vinod): Use HTTP pipelining instead.
+    // the previous call has been sent, which for a SUBSCRIBE call means
+    // that its response has been received (see '_send').
     calls.push(call);
 
     if (calls.size() > 1) {
@@ -202,9 +255,41 @@ public:
       .onAny(defer(self(), &Self::___send));
   }
 
-protected:
+  // Sends the coalesced acknowledgements, if any.
+  void flush()
+  {
+    if (acknowledgements.isNone()) {
+      return;
+    }
+
+    const Call batch = acknowledgements.get();
+    acknowledgements = None();
+
+    // The master may have changed meanwhile to one which does not
+    // understand ACKNOWLEDGEMENTS calls.
+    if (coalesce) {
+      enqueue(batch);
+      return;
+    }
+
+    foreach (const Call::Acknowledge& acknowledge,
+             batch.acknowledgements().acknowledgements()) {
+      Call call;
+      call.set_type(Call::ACKNOWLEDGE);
+      call.mutable_acknowledge()->CopyFrom(acknowledge);
+
+      if (batch.has_framework_id()) {
+        call.mutable_framework_id()->CopyFrom(batch.framework_id());
+      }
+
+      enqueue(call);
+    }
+  }
+
   virtual void initialize()
   {
+    install<ExecutorToFrameworkMessage>(&MesosProcess::executorMessage);
+
     // Start detecting masters.
     detector->detect()
       .onAny(defer(self(), &MesosProcess::detected, lambda::_1));
@@ -235,6 +320,10 @@ protected:
 
       VLOG(1) << "New master detected at " << master.get();
 
+      Try<Version> version = Version::parse(future.get().get().version());
+
+      coalesce = version.isSome() && version.get() >= Version(0, 27, 0);
+
       mutex.lock()
         .then(defer(self(), &Self::__detected))
         .onAny(lambda::bind(&Mutex::unlock, mutex));
@@ -297,9 +386,27 @@ protected:
 
     VLOG(1) << "Sending " << call.type() << " call to " << master.get();
 
-    // TODO(vinod): Add support for sending MESSAGE calls directly
-    // to the slave, instead of relaying it through the master, as
-    // the scheduler driver does.
+    // Send MESSAGE calls directly to the agent if we know its pid from
+    // its offers, instead of relaying them through the master, as the
+    // scheduler driver does.
+    if (call.type() == Call::MESSAGE &&
+        direct &&
+        agents.contains(call.message().agent_id().value())) {
+      const UPID& agent = agents.at(call.message().agent_id().value());
+
+      VLOG(1) << "Sending " << call.type() << " call directly to " << agent;
+
+      FrameworkToExecutorMessage message;
+      message.mutable_slave_id()->CopyFrom(
+          devolve(call.message().agent_id()));
+      message.mutable_framework_id()->CopyFrom(devolve(call.framework_id()));
+      message.mutable_executor_id()->CopyFrom(
+          devolve(call.message().executor_id()));
+      message.set_data(call.message().data());
+
+      send(agent, message);
+      return Nothing();
+    }
 
     const string body = serialize(contentType, call);
     const http::Headers headers{{"Accept", stringify(contentType)}};
@@ -317,18 +424,33 @@ protected:
           headers,
           body,
           stringify(contentType));
-    } else {
-      response = post(
-          master.get(),
-          "api/v1/scheduler",
-          headers,
-          body,
-          stringify(contentType));
+
+      return response
+        .onAny(defer(self(), &Self::__send, call, lambda::_1))
+        .then([]() { return Nothing(); });
     }
 
-    return response
-      .onAny(defer(self(), &Self::__send, call, lambda::_1))
-      .then([]() { return Nothing(); });
+    // The other calls are pipelined on the persistent connection in
+    // the order they are sent, so the next call can be sent without
+    // waiting for the response to this one.
+    http::Request request;
+    request.method = "POST";
+    request.url = http::URL(
+        "http",
+        master.get().address.ip,
+        master.get().address.port,
+        master.get().id + "/api/v1/scheduler");
+    request.headers = headers;
+    request.headers["Content-Type"] = stringify(contentType);
+    request.body = body;
+    request.keepAlive = true;
+
+    response = pool.send(request);
+
+    response
+      .onAny(defer(self(), &Self::__send, call, lambda::_1));
+
+    return Nothing();
   }
 
   void __send(const Call& call, const Future<Response>& response)
@@ -451,6 +573,23 @@ protected:
       return;
     }
 
+    // Remember the pids of the agents for sending them the framework
+    // messages directly.
+    if (direct && event.type() == Event::OFFERS) {
+      foreach (const v1::Offer& offer, event.offers().offers()) {
+        if (offer.has_url()) {
+          agents[offer.agent_id().value()] = UPID(
+              strings::remove(offer.url().path(), "/", strings::PREFIX) +
+              "@" + offer.url().address().ip() +
+              ":" + stringify(offer.url().address().port()));
+        }
+      }
+    } else if (event.type() == Event::FAILURE &&
+               event.failure().has_agent_id() &&
+               !event.failure().has_executor_id()) {
+      agents.erase(event.failure().agent_id().value());
+    }
+
     if (isLocallyInjected) {
       VLOG(1) << "Enqueuing locally injected event " << stringify(event.type());
     } else {
@@ -470,6 +609,23 @@ protected:
     }
   }
 
+  // Handles the framework messages which the agents send directly,
+  // see 'agents'.
+  void executorMessage(
+      const UPID& from,
+      const ExecutorToFrameworkMessage& message)
+  {
+    const string& agentId = message.slave_id().value();
+
+    if (!agents.contains(agentId) || agents.at(agentId) != from) {
+      LOG(WARNING) << "Ignoring framework message from " << from
+                   << " which is not the agent " << agentId;
+      return;
+    }
+
+    receive(evolve(message), false);
+  }
+
   void disconnect()
   {
     if (connection.isSome()) {
@@ -490,6 +646,9 @@ private:
 
   Option<Connection> connection;
 
+  // The persistent connection for the calls other than SUBSCRIBE.
+  http::ConnectionPool pool;
+
   ContentType contentType;
 
   Mutex mutex; // Used to serialize the callback invocations.
@@ -506,6 +665,16 @@ private:
 
   queue<Call> calls;
 
+  // Whether the master understands ACKNOWLEDGEMENTS calls, and the
+  // one being coalesced.
+  bool coalesce;
+  Option<Call> acknowledgements;
+
+  // Whether to send the framework messages directly to the agents,
+  // and the pids of the agents by their ids.
+  bool direct;
+  hashmap<string, UPID> agents;
+
   Option<UPID> master;
 };
 
@@ -72,8 +72,8 @@ set(AGENT_LIBS
   ${GLOG_LFLAG}
   )
 
-if (NOT ENABLE_LIBEVENT)
+if (NOT ENABLE_LIBEVENT AND NOT ENABLE_EPOLL)
   set(AGENT_LIBS ${AGENT_LIBS} ${LIBEV_LFLAG})
 elseif (ENABLE_LIBEVENT)
   set(AGENT_LIBS ${AGENT_LIBS} ${LIBEVENT_LFLAG})
-endif (NOT ENABLE_LIBEVENT)
+endif (NOT ENABLE_LIBEVENT AND NOT ENABLE_EPOLL)
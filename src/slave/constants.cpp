@@ -30,10 +30,15 @@ const Duration EXECUTOR_REREGISTER_TIMEOUT = Seconds(2);
 const Duration EXECUTOR_SIGNAL_ESCALATION_TIMEOUT = Seconds(3);
 const Duration STATUS_UPDATE_RETRY_INTERVAL_MIN = Seconds(10);
 const Duration STATUS_UPDATE_RETRY_INTERVAL_MAX = Minutes(10);
+const Duration STATUS_UPDATE_JOURNAL_COMPACTION_INTERVAL = Minutes(10);
 const Duration DEFAULT_REGISTRATION_BACKOFF_FACTOR = Seconds(1);
 const Duration REGISTER_RETRY_INTERVAL_MAX = Minutes(1);
 const Duration GC_DELAY = Weeks(1);
 const double GC_DISK_HEADROOM = 0.1;
+const size_t GC_MAX_CONCURRENT_REMOVALS = 2;
+const size_t DISK_USAGE_MAX_CONCURRENT_CHECKS = 4;
+const Duration USAGE_HISTORY_WINDOW = Minutes(10);
+const size_t USAGE_HISTORY_CAPACITY = 120;
 const Duration DISK_WATCH_INTERVAL = Minutes(1);
 const Duration RECOVERY_TIMEOUT = Minutes(15);
 const uint32_t MAX_COMPLETED_FRAMEWORKS = 50;
@@ -51,6 +56,8 @@ const Duration DOCKER_INSPECT_DELAY = Seconds(1);
 // TODO(tnachen): Make this a flag.
 const Duration DOCKER_VERSION_WAIT_TIMEOUT = Seconds(5);
 const std::string DEFAULT_AUTHENTICATEE = "crammd5";
+const std::string FETCHER_CACHE_EXTRACTED_SUFFIX = ".extracted";
+const std::string ROTATING_CONTAINER_LOGGER = "rotate";
 const std::string COMMAND_EXECUTOR_ROOTFS_CONTAINER_PATH = ".rootfs";
 
 Duration DEFAULT_MASTER_PING_TIMEOUT()
@@ -42,6 +42,11 @@ extern const Duration EXECUTOR_SIGNAL_ESCALATION_TIMEOUT;
 extern const Duration RECOVERY_TIMEOUT;
 extern const Duration STATUS_UPDATE_RETRY_INTERVAL_MIN;
 extern const Duration STATUS_UPDATE_RETRY_INTERVAL_MAX;
+
+// The interval at which the status update manager compacts the
+// journal of the checkpointed status updates.
+extern const Duration STATUS_UPDATE_JOURNAL_COMPACTION_INTERVAL;
+
 extern const Duration GC_DELAY;
 extern const Duration DISK_WATCH_INTERVAL;
 
@@ -58,6 +63,20 @@ extern const Duration REGISTER_RETRY_INTERVAL_MAX;
 // Minimum free disk capacity enforced by the garbage collector.
 extern const double GC_DISK_HEADROOM;
 
+// Maximum number of paths that the garbage collector removes at the
+// same time.
+extern const size_t GC_MAX_CONCURRENT_REMOVALS;
+
+// Maximum number of disk usage checks of container paths that the
+// 'posix/disk' isolator runs at the same time.
+extern const size_t DISK_USAGE_MAX_CONCURRENT_CHECKS;
+
+// The window of the history of the resource usage of each container
+// that the resource monitor keeps, and the maximum number of samples
+// in it, beyond which the older samples get downsampled.
+extern const Duration USAGE_HISTORY_WINDOW;
+extern const size_t USAGE_HISTORY_CAPACITY;
+
 // Maximum number of completed frameworks to store in memory.
 extern const uint32_t MAX_COMPLETED_FRAMEWORKS;
 
@@ -102,15 +121,47 @@ extern const Duration DOCKER_INSPECT_DELAY;
 // docker version.
 extern const Duration DOCKER_VERSION_WAIT_TIMEOUT;
 
+// Default maximum number of image layers that the Docker registry
+// puller downloads at the same time.
+const size_t DEFAULT_DOCKER_PULLER_MAX_CONCURRENT_DOWNLOADS = 4;
+
 // Name of the default, CRAM-MD5 authenticatee.
 extern const std::string DEFAULT_AUTHENTICATEE;
 
 // Default maximum storage space to be used by the fetcher cache.
 const Bytes DEFAULT_FETCHER_CACHE_SIZE = Gigabytes(2);
 
-// Default maximum number of docker inspect calls docker ps will invoke
-// in parallel to prevent hitting system's open file descriptor limit.
-const int DOCKER_PS_MAX_INSPECT_CALLS = 100;
+// Default maximum number of URIs that the fetcher downloads at the
+// same time.
+const size_t DEFAULT_FETCHER_MAX_CONCURRENT_DOWNLOADS = 8;
+
+// Default maximum number of images that the slave prefetches at the
+// same time.
+const size_t DEFAULT_IMAGE_PREFETCH_MAX_CONCURRENT_PULLS = 2;
+
+// Name of the built-in container logger which rotates the output of
+// the executors.
+extern const std::string ROTATING_CONTAINER_LOGGER;
+
+// Default size at which the rotating container logger rotates the
+// 'stdout' and 'stderr' files of a sandbox.
+const Bytes DEFAULT_CONTAINER_LOGGER_MAX_SIZE = Megabytes(10);
+
+// Default number of rotated files the rotating container logger keeps
+// for each of the 'stdout' and 'stderr' files of a sandbox.
+const size_t DEFAULT_CONTAINER_LOGGER_MAX_FILES = 5;
+
+// Default maximum amount of events that are buffered for an HTTP
+// executor that does not keep up with reading them.
+const Bytes DEFAULT_MAX_HTTP_EXECUTOR_BUFFER_SIZE = Megabytes(64);
+
+// Suffix of the directory next to a fetcher cache file into which the
+// archive in the cache file is extracted.
+extern const std::string FETCHER_CACHE_EXTRACTED_SUFFIX;
+
+// Maximum number of containers docker ps will pass to a single
+// 'docker inspect' call, to bound the length of its command line.
+const size_t DOCKER_PS_MAX_INSPECT_CONTAINERS = 100;
 
 // If no pings received within this timeout, then the slave will
 // trigger a re-detection of the master to cause a re-registration.
@@ -0,0 +1,154 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <errno.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include <process/subprocess.hpp>
+
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/lambda.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+
+#include "slave/container_loggers/rotate.hpp"
+
+#include "slave/containerizer/mesos/containerizer.hpp"
+#include "slave/containerizer/mesos/rotate.hpp"
+
+using std::string;
+using std::vector;
+
+using process::Failure;
+using process::Future;
+using process::Subprocess;
+
+using mesos::slave::ContainerLogger;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+Try<Nothing> RotatingContainerLogger::initialize()
+{
+  const string path = path::join(flags.launcher_dir, MESOS_CONTAINERIZER);
+
+  if (!os::exists(path)) {
+    return Error("Failed to find '" + path + "'");
+  }
+
+  return Nothing();
+}
+
+
+Future<Nothing> RotatingContainerLogger::recover(
+    const ExecutorInfo& executorInfo,
+    const string& sandboxDirectory)
+{
+  // The rotating processes of the executor outlive the slave.
+  return Nothing();
+}
+
+
+Future<ContainerLogger::SubprocessInfo> RotatingContainerLogger::prepare(
+    const ExecutorInfo& executorInfo,
+    const string& sandboxDirectory)
+{
+  Try<int> out = rotate(path::join(sandboxDirectory, "stdout"));
+  if (out.isError()) {
+    return Failure("Failed to start rotating 'stdout': " + out.error());
+  }
+
+  Try<int> err = rotate(path::join(sandboxDirectory, "stderr"));
+  if (err.isError()) {
+    os::close(out.get());
+    return Failure("Failed to start rotating 'stderr': " + err.error());
+  }
+
+  return ContainerLogger::SubprocessInfo(
+      Subprocess::FD(out.get()),
+      Subprocess::FD(err.get()));
+}
+
+
+// Post fork, pre exec function.
+static int setup()
+{
+  // Move to a different session so the slave can be restarted, or
+  // killed, without killing the rotating process.
+  if (::setsid() == -1) {
+    return errno;
+  }
+
+  return 0;
+}
+
+
+Try<int> RotatingContainerLogger::rotate(const string& path)
+{
+  int pipes[2];
+  if (::pipe(pipes) == -1) {
+    return ErrnoError("Failed to create pipe");
+  }
+
+  // NOTE: The pipe must not leak into the processes forked by the
+  // slave, or the rotating process would not see the executor exit.
+  foreach (int fd, pipes) {
+    Try<Nothing> cloexec = os::cloexec(fd);
+    if (cloexec.isError()) {
+      os::close(pipes[0]);
+      os::close(pipes[1]);
+      return Error("Failed to cloexec pipe: " + cloexec.error());
+    }
+  }
+
+  MesosContainerizerRotate::Flags rotateFlags;
+  rotateFlags.path = path;
+  rotateFlags.max_size = flags.container_logger_max_size;
+  rotateFlags.max_files = flags.container_logger_max_files;
+  rotateFlags.compress = flags.container_logger_compress;
+
+  vector<string> argv(2);
+  argv[0] = MESOS_CONTAINERIZER;
+  argv[1] = MesosContainerizerRotate::NAME;
+
+  Try<Subprocess> s = subprocess(
+      path::join(flags.launcher_dir, MESOS_CONTAINERIZER),
+      argv,
+      Subprocess::FD(pipes[0]),
+      Subprocess::PATH("/dev/null"),
+      Subprocess::FD(STDERR_FILENO),
+      rotateFlags,
+      None(),
+      lambda::bind(&setup));
+
+  os::close(pipes[0]);
+
+  if (s.isError()) {
+    os::close(pipes[1]);
+    return Error("Failed to fork: " + s.error());
+  }
+
+  return pipes[1];
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,67 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __SLAVE_CONTAINER_LOGGERS_ROTATE_HPP__
+#define __SLAVE_CONTAINER_LOGGERS_ROTATE_HPP__
+
+#include <string>
+
+#include <mesos/slave/container_logger.hpp>
+
+#include "slave/flags.hpp"
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// The built-in container logger which bounds the disk space used by
+// the output of executors. The output goes through pipes to a
+// "mesos-containerizer rotate" process for each of 'stdout' and
+// 'stderr', which writes it to the sandbox and rotates the files by
+// size (see MesosContainerizerRotate). These processes run in their
+// own session, so the output keeps flowing while the slave restarts
+// and nothing needs to be recovered.
+class RotatingContainerLogger : public mesos::slave::ContainerLogger
+{
+public:
+  explicit RotatingContainerLogger(const Flags& _flags) : flags(_flags) {}
+
+  virtual ~RotatingContainerLogger() {}
+
+  virtual Try<Nothing> initialize();
+
+  virtual process::Future<Nothing> recover(
+      const ExecutorInfo& executorInfo,
+      const std::string& sandboxDirectory);
+
+  virtual process::Future<mesos::slave::ContainerLogger::SubprocessInfo>
+  prepare(
+      const ExecutorInfo& executorInfo,
+      const std::string& sandboxDirectory);
+
+private:
+  // Starts a process which rotates the file at 'path' and returns
+  // the write end of the pipe to it.
+  Try<int> rotate(const std::string& path);
+
+  const Flags flags;
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __SLAVE_CONTAINER_LOGGERS_ROTATE_HPP__
@@ -0,0 +1,61 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include <process/subprocess.hpp>
+
+#include <stout/path.hpp>
+
+#include "slave/container_loggers/sandbox.hpp"
+
+using std::string;
+
+using process::Future;
+using process::Subprocess;
+
+using mesos::slave::ContainerLogger;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+Try<Nothing> SandboxContainerLogger::initialize()
+{
+  return Nothing();
+}
+
+
+Future<Nothing> SandboxContainerLogger::recover(
+    const ExecutorInfo& executorInfo,
+    const string& sandboxDirectory)
+{
+  return Nothing();
+}
+
+
+Future<ContainerLogger::SubprocessInfo> SandboxContainerLogger::prepare(
+    const ExecutorInfo& executorInfo,
+    const string& sandboxDirectory)
+{
+  return ContainerLogger::SubprocessInfo(
+      Subprocess::PATH(path::join(sandboxDirectory, "stdout")),
+      Subprocess::PATH(path::join(sandboxDirectory, "stderr")));
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,51 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __SLAVE_CONTAINER_LOGGERS_SANDBOX_HPP__
+#define __SLAVE_CONTAINER_LOGGERS_SANDBOX_HPP__
+
+#include <string>
+
+#include <mesos/slave/container_logger.hpp>
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// The default container logger, which redirects the output of
+// executors to the 'stdout' and 'stderr' files of their sandbox.
+class SandboxContainerLogger : public mesos::slave::ContainerLogger
+{
+public:
+  virtual ~SandboxContainerLogger() {}
+
+  virtual Try<Nothing> initialize();
+
+  virtual process::Future<Nothing> recover(
+      const ExecutorInfo& executorInfo,
+      const std::string& sandboxDirectory);
+
+  virtual process::Future<mesos::slave::ContainerLogger::SubprocessInfo>
+  prepare(
+      const ExecutorInfo& executorInfo,
+      const std::string& sandboxDirectory);
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __SLAVE_CONTAINER_LOGGERS_SANDBOX_HPP__
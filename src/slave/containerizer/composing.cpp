@@ -88,6 +88,8 @@ public:
 
   Future<hashset<ContainerID>> containers();
 
+  Future<bool> pull(const Image& image);
+
 private:
   // Continuations.
   Future<Nothing> _recover();
@@ -240,6 +242,12 @@ Future<hashset<ContainerID>> ComposingContainerizer::containers()
 }
 
 
+Future<bool> ComposingContainerizer::pull(const Image& image)
+{
+  return dispatch(process, &ComposingContainerizerProcess::pull, image);
+}
+
+
 ComposingContainerizerProcess::~ComposingContainerizerProcess()
 {
   foreach (Containerizer* containerizer, containerizers_) {
@@ -549,6 +557,28 @@ Future<hashset<ContainerID>> ComposingContainerizerProcess::containers()
   return containers_.keys();
 }
 
+
+Future<bool> ComposingContainerizerProcess::pull(const Image& image)
+{
+  // Pull the image into every containerizer that supports it, since
+  // we do not know yet which one will launch the tasks that use it.
+  list<Future<bool>> futures;
+  foreach (Containerizer* containerizer, containerizers_) {
+    futures.push_back(containerizer->pull(image));
+  }
+
+  return collect(futures)
+    .then([](const list<bool>& pulled) {
+      foreach (bool pulled_, pulled) {
+        if (pulled_) {
+          return true;
+        }
+      }
+
+      return false;
+    });
+}
+
 } // namespace slave {
 } // namespace internal {
 } // namespace mesos {
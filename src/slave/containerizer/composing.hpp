@@ -87,6 +87,8 @@ public:
 
   virtual process::Future<hashset<ContainerID>> containers();
 
+  virtual process::Future<bool> pull(const Image& image);
+
 private:
   ComposingContainerizerProcess* process;
 };
@@ -27,11 +27,18 @@
 #include <stout/strings.hpp>
 #include <stout/uuid.hpp>
 
+#ifdef __linux__
+#include "linux/fs.hpp"
+#endif // __linux__
+
 #include "hook/manager.hpp"
 
+#include "slave/constants.hpp"
 #include "slave/flags.hpp"
 #include "slave/slave.hpp"
 
+#include "slave/container_loggers/rotate.hpp"
+
 #include "slave/containerizer/composing.hpp"
 #include "slave/containerizer/containerizer.hpp"
 #include "slave/containerizer/docker.hpp"
@@ -49,6 +56,8 @@ using std::vector;
 
 using namespace process;
 
+using mesos::slave::ContainerLogger;
+
 namespace mesos {
 namespace internal {
 namespace slave {
@@ -67,6 +76,56 @@ Try<Resources> Containerizer::resources(const Flags& flags)
 
   Resources resources = parsed.get();
 
+  // The disks with a source are on the directories, or on the mount
+  // points, set up by the operator.
+  foreach (const Resource& resource, resources) {
+    if (!resource.has_disk() || !resource.disk().has_source()) {
+      continue;
+    }
+
+    const Resource::DiskInfo::Source& source = resource.disk().source();
+
+    const string root = source.type() == Resource::DiskInfo::Source::PATH
+      ? source.path().root()
+      : source.mount().root();
+
+    if (!os::stat::isdir(root)) {
+      return Error(
+          "The root '" + root + "' of disk " + stringify(resource) +
+          " is not a directory");
+    }
+
+#ifdef __linux__
+    if (source.type() == Resource::DiskInfo::Source::MOUNT) {
+      Result<string> realpath = os::realpath(root);
+      if (!realpath.isSome()) {
+        return Error(
+            "Failed to get the realpath of '" + root + "': " +
+            (realpath.isError() ? realpath.error() : "No such directory"));
+      }
+
+      Try<fs::MountInfoTable> table = fs::MountInfoTable::read();
+      if (table.isError()) {
+        return Error("Failed to read the mount table: " + table.error());
+      }
+
+      bool mounted = false;
+      foreach (const fs::MountInfoTable::Entry& entry, table.get().entries) {
+        if (entry.target == realpath.get()) {
+          mounted = true;
+          break;
+        }
+      }
+
+      if (!mounted) {
+        return Error(
+            "The root '" + root + "' of disk " + stringify(resource) +
+            " is not a mount point");
+      }
+    }
+#endif // __linux__
+  }
+
   // NOTE: We need to check for the "cpus" string within the flag
   // because once Resources are parsed, we cannot distinguish between
   //  (1) "cpus:0", and
@@ -124,7 +183,7 @@ Try<Resources> Containerizer::resources(const Flags& flags)
 
     // NOTE: We calculate disk size of the file system on
     // which the slave work directory is mounted.
-    Try<Bytes> disk_ = fs::size(flags.work_dir);
+    Try<Bytes> disk_ = ::fs::size(flags.work_dir);
     if (!disk_.isSome()) {
       LOG(WARNING) << "Failed to auto-detect the disk space: '"
                    << disk_.error()
@@ -314,6 +373,11 @@ map<string, string> executorEnvironment(
     environment["MESOS_RECOVERY_TIMEOUT"] = stringify(flags.recovery_timeout);
   }
 
+  if (flags.executor_status_update_window > Duration::zero()) {
+    environment["MESOS_STATUS_UPDATE_WINDOW"] =
+      stringify(flags.executor_status_update_window);
+  }
+
   if (HookManager::hooksAvailable()) {
     // Include any environment variables from Hooks.
     // TODO(karya): Call environment decorator hook _after_ putting all
@@ -337,6 +401,43 @@ map<string, string> executorEnvironment(
 }
 
 
+Try<ContainerLogger*> createContainerLogger(const Flags& flags)
+{
+  Try<ContainerLogger*> logger = (ContainerLogger*) NULL;
+
+  if (flags.container_logger.isSome() &&
+      flags.container_logger.get() == ROTATING_CONTAINER_LOGGER) {
+    logger = new RotatingContainerLogger(flags);
+  } else {
+    logger = ContainerLogger::create(flags.container_logger);
+  }
+
+  if (logger.isError()) {
+    return Error(logger.error());
+  }
+
+  Try<Nothing> initialize = logger.get()->initialize();
+  if (initialize.isError()) {
+    delete logger.get();
+    return Error(
+        "Failed to initialize container logger: " + initialize.error());
+  }
+
+  return logger.get();
+}
+
+
+void closeOutput(const ContainerLogger::SubprocessInfo& subprocessInfo)
+{
+  if (subprocessInfo.out.isFd()) {
+    os::close(subprocessInfo.out.getFd().get());
+  }
+
+  if (subprocessInfo.err.isFd()) {
+    os::close(subprocessInfo.err.getFd().get());
+  }
+}
+
 } // namespace slave {
 } // namespace internal {
 } // namespace mesos {
@@ -24,6 +24,8 @@
 
 #include <mesos/containerizer/containerizer.hpp>
 
+#include <mesos/slave/container_logger.hpp>
+
 #include <process/future.hpp>
 #include <process/owned.hpp>
 #include <process/process.hpp>
@@ -124,6 +126,15 @@ public:
   virtual void destroy(const ContainerID& containerId) = 0;
 
   virtual process::Future<hashset<ContainerID>> containers() = 0;
+
+  // Pull an image into the stores of the containerizer ahead of the
+  // containers that use it. Returns true if pulling this image is
+  // supported and it has been pulled, otherwise false or a failure if
+  // something went wrong.
+  virtual process::Future<bool> pull(const Image& image)
+  {
+    return false;
+  }
 };
 
 
@@ -149,6 +160,19 @@ std::map<std::string, std::string> executorEnvironment(
     const Flags& flags,
     bool includeOsEnvironment = true);
 
+
+// Creates and initializes the container logger selected by the
+// 'container_logger' flag: the built-in rotating logger, a module,
+// or by default the logger which writes to the sandbox.
+Try<mesos::slave::ContainerLogger*> createContainerLogger(const Flags& flags);
+
+
+// Closes the file descriptors, if any, which the container logger
+// handed over for the output of an executor. This is called once the
+// executor has its copies, or if it will not be launched.
+void closeOutput(
+    const mesos::slave::ContainerLogger::SubprocessInfo& subprocessInfo);
+
 } // namespace slave {
 } // namespace internal {
 } // namespace mesos {
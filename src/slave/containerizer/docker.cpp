@@ -20,12 +20,15 @@
 #include <vector>
 
 #include <process/check.hpp>
+#include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/io.hpp>
 #include <process/reap.hpp>
 #include <process/subprocess.hpp>
 
+#include <process/metrics/metrics.hpp>
+
 #include <stout/fs.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
@@ -58,6 +61,8 @@ using std::vector;
 
 using namespace process;
 
+using mesos::slave::ContainerLogger;
+
 namespace mesos {
 namespace internal {
 namespace slave {
@@ -137,7 +142,16 @@ Try<DockerContainerizer*> DockerContainerizer::create(
     }
   }
 
-  return new DockerContainerizer(flags, fetcher, docker);
+  Try<ContainerLogger*> logger = createContainerLogger(flags);
+  if (logger.isError()) {
+    return Error("Failed to create container logger: " + logger.error());
+  }
+
+  return new DockerContainerizer(
+      flags,
+      fetcher,
+      docker,
+      Owned<ContainerLogger>(logger.get()));
 }
 
 
@@ -152,8 +166,9 @@ DockerContainerizer::DockerContainerizer(
 DockerContainerizer::DockerContainerizer(
     const Flags& flags,
     Fetcher* fetcher,
-    Shared<Docker> docker)
-  : process(new DockerContainerizerProcess(flags, fetcher, docker))
+    Shared<Docker> docker,
+    const Owned<ContainerLogger>& logger)
+  : process(new DockerContainerizerProcess(flags, fetcher, docker, logger))
 {
   spawn(process.get());
 }
@@ -321,7 +336,12 @@ Future<Nothing> DockerContainerizerProcess::fetch(
     const ContainerID& containerId,
     const SlaveID& slaveId)
 {
-  CHECK(containers_.contains(containerId));
+  // NOTE: The container might have been destroyed while the pre
+  // launch hooks were running, see 'launch()'.
+  if (!containers_.contains(containerId)) {
+    return Failure("Container is already destroyed");
+  }
+
   Container* container = containers_[containerId];
 
   return fetcher->fetch(
@@ -353,6 +373,8 @@ Future<Nothing> DockerContainerizerProcess::pull(
 
   containers_[containerId]->pull = future;
 
+  metrics.image_pull.time(future);
+
   return future.then(defer(self(), [=]() {
     VLOG(1) << "Docker pull " << image << " completed";
     return Nothing();
@@ -360,6 +382,47 @@ Future<Nothing> DockerContainerizerProcess::pull(
 }
 
 
+Future<bool> DockerContainerizerProcess::pullImage(const Image& image)
+{
+  if (image.type() != Image::DOCKER) {
+    return false;
+  }
+
+  // There is no sandbox yet, so 'docker pull' runs with the home
+  // directory, and hence the credentials, of the slave.
+  const Option<string> home = os::getenv("HOME");
+
+  Future<Docker::Image> future = docker->pull(
+      home.isSome() ? home.get() : flags.work_dir,
+      image.docker().name());
+
+  metrics.image_pull.time(future);
+
+  const string name = image.docker().name();
+
+  return future.then(defer(self(), [=]() {
+    VLOG(1) << "Docker pull " << name << " completed";
+    return true;
+  }));
+}
+
+
+DockerContainerizerProcess::Metrics::Metrics()
+  : image_pull("containerizer/docker/image_pull", Hours(1)),
+    container_run("containerizer/docker/container_run", Hours(1))
+{
+  process::metrics::add(image_pull);
+  process::metrics::add(container_run);
+}
+
+
+DockerContainerizerProcess::Metrics::~Metrics()
+{
+  process::metrics::remove(image_pull);
+  process::metrics::remove(container_run);
+}
+
+
 Try<Nothing> DockerContainerizerProcess::checkpoint(
     const ContainerID& containerId,
     pid_t pid)
@@ -492,6 +555,15 @@ Future<hashset<ContainerID>> DockerContainerizer::containers()
 }
 
 
+Future<bool> DockerContainerizer::pull(const Image& image)
+{
+  return dispatch(
+      process.get(),
+      &DockerContainerizerProcess::pullImage,
+      image);
+}
+
+
 // A Subprocess async-safe "setup" helper used by
 // DockerContainerizerProcess when launching the mesos-docker-executor
 // that does a 'setsid' and then synchronizes with the parent.
@@ -561,12 +633,17 @@ Future<Nothing> DockerContainerizerProcess::_recover(
   // Tracks all the task containers that launched an executor in
   // a docker container.
   hashset<ContainerID> executorContainers;
+  // The pids of the running task containers, which usage() needs to
+  // find the cgroups of the containers.
+  hashmap<ContainerID, pid_t> containerPids;
   foreach (const Docker::Container& container, _containers) {
     Option<ContainerID> id = parse(container);
     if (id.isSome()) {
       existingContainers.insert(id.get());
       if (strings::contains(container.name, ".executor")) {
         executorContainers.insert(id.get());
+      } else if (container.pid.isSome()) {
+        containerPids[id.get()] = container.pid.get();
       }
     }
   }
@@ -575,6 +652,9 @@ Future<Nothing> DockerContainerizerProcess::_recover(
   // detect very unlikely duplicate scenario (see below).
   hashmap<ContainerID, pid_t> pids;
 
+  // The recovery of the output of the executors by the logger.
+  list<Future<Nothing>> recovers;
+
   foreachvalue (const FrameworkState& framework, state.frameworks) {
     foreachvalue (const ExecutorState& executor, framework.executors) {
       if (executor.info.isNone()) {
@@ -644,6 +724,7 @@ Future<Nothing> DockerContainerizerProcess::_recover(
       container->state = Container::RUNNING;
       container->launchesExecutorContainer =
         executorContainers.contains(containerId);
+      container->pid = containerPids.get(containerId);
 
       pid_t pid = run.get().forkedPid.get();
 
@@ -665,14 +746,26 @@ Future<Nothing> DockerContainerizerProcess::_recover(
       }
 
       pids.put(containerId, pid);
+
+      const string directory = paths::getExecutorRunPath(
+          flags.work_dir,
+          state.id,
+          framework.id,
+          executor.id,
+          containerId);
+
+      recovers.push_back(logger->recover(executorInfo, directory));
     }
   }
 
-  if (flags.docker_kill_orphans) {
-    return __recover(_containers);
-  }
+  return collect(recovers)
+    .then(defer(self(), [=]() -> Future<Nothing> {
+      if (flags.docker_kill_orphans) {
+        return __recover(_containers);
+      }
 
-  return Nothing();
+      return Nothing();
+    }));
 }
 
 
@@ -765,8 +858,11 @@ Future<bool> DockerContainerizerProcess::launch(
               << "' and framework '" << executorInfo.framework_id() << "'";
   }
 
+  // The pre launch hooks are done before we start fetching.
+  Future<Nothing> preLaunch = Nothing();
+
   if (HookManager::hooksAvailable()) {
-    HookManager::slavePreLaunchDockerHook(
+    preLaunch = HookManager::slavePreLaunchDockerHook(
         container.get()->container,
         container.get()->command,
         taskInfo,
@@ -775,14 +871,21 @@ Future<bool> DockerContainerizerProcess::launch(
         container.get()->directory,
         flags.sandbox_directory,
         container.get()->resources,
-        container.get()->environment);
+        container.get()->environment,
+        flags.hook_timeout);
   }
 
   if (taskInfo.isSome() && flags.docker_mesos_image.isNone()) {
     // Launching task by forking a subprocess to run docker executor.
-    return container.get()->launch = fetch(containerId, slaveId)
+    return container.get()->launch = preLaunch
+      .then(defer(self(), [=]() { return fetch(containerId, slaveId); }))
       .then(defer(self(), [=]() { return pull(containerId); }))
-      .then(defer(self(), [=]() { return launchExecutorProcess(containerId); }))
+      .then(defer(self(), [=]() {
+        return logger->prepare(executorInfo, directory);
+      }))
+      .then(defer(self(), [=](const ContainerLogger::SubprocessInfo& info) {
+        return launchExecutorProcess(containerId, info);
+      }))
       .then(defer(self(), [=](pid_t pid) {
         return reapExecutor(containerId, pid);
       }));
@@ -802,10 +905,14 @@ Future<bool> DockerContainerizerProcess::launch(
   // is running in a container (via docker_mesos_image flag)
   // we want the executor to keep running when the slave container
   // dies.
-  return container.get()->launch = fetch(containerId, slaveId)
+  return container.get()->launch = preLaunch
+    .then(defer(self(), [=]() { return fetch(containerId, slaveId); }))
     .then(defer(self(), [=]() { return pull(containerId); }))
     .then(defer(self(), [=]() {
-      return launchExecutorContainer(containerId, containerName);
+      return logger->prepare(executorInfo, directory);
+    }))
+    .then(defer(self(), [=](const ContainerLogger::SubprocessInfo& info) {
+      return launchExecutorContainer(containerId, containerName, info);
     }))
     .then(defer(self(), [=](const Docker::Container& dockerContainer) {
       return checkpointExecutor(containerId, dockerContainer);
@@ -818,9 +925,11 @@ Future<bool> DockerContainerizerProcess::launch(
 
 Future<Docker::Container> DockerContainerizerProcess::launchExecutorContainer(
     const ContainerID& containerId,
-    const string& containerName)
+    const string& containerName,
+    const ContainerLogger::SubprocessInfo& subprocessInfo)
 {
   if (!containers_.contains(containerId)) {
+    closeOutput(subprocessInfo);
     return Failure("Container is already destroyed");
   }
 
@@ -838,8 +947,10 @@ Future<Docker::Container> DockerContainerizerProcess::launchExecutorContainer(
       flags.sandbox_directory,
       container->resources,
       container->environment,
-      path::join(container->directory, "stdout"),
-      path::join(container->directory, "stderr"));
+      subprocessInfo.out,
+      subprocessInfo.err);
+
+  closeOutput(subprocessInfo);
 
   Owned<Promise<Docker::Container>> promise(new Promise<Docker::Container>());
   // We like to propogate the run failure when run fails so slave can
@@ -860,14 +971,18 @@ Future<Docker::Container> DockerContainerizerProcess::launchExecutorContainer(
     promise->fail(failure);
   });
 
+  metrics.container_run.time(promise->future());
+
   return promise->future();
 }
 
 
 Future<pid_t> DockerContainerizerProcess::launchExecutorProcess(
-    const ContainerID& containerId)
+    const ContainerID& containerId,
+    const ContainerLogger::SubprocessInfo& subprocessInfo)
 {
   if (!containers_.contains(containerId)) {
+    closeOutput(subprocessInfo);
     return Failure("Container is already destroyed");
   }
 
@@ -906,12 +1021,14 @@ Future<pid_t> DockerContainerizerProcess::launchExecutorProcess(
       path::join(flags.launcher_dir, "mesos-docker-executor"),
       argv,
       Subprocess::PIPE(),
-      Subprocess::PATH(path::join(container->directory, "stdout")),
-      Subprocess::PATH(path::join(container->directory, "stderr")),
+      subprocessInfo.out,
+      subprocessInfo.err,
       dockerFlags(flags, container->name(), container->directory),
       environment,
       lambda::bind(&setup, container->directory));
 
+  closeOutput(subprocessInfo);
+
   if (s.isError()) {
     return Failure("Failed to fork executor: " + s.error());
   }
@@ -955,6 +1072,14 @@ Future<pid_t> DockerContainerizerProcess::checkpointExecutor(
     return Failure("Unable to get executor pid after launch");
   }
 
+  Container* container = containers_[containerId];
+
+  // Unless the executor launches the task in another container, this
+  // is the container of the task, whose pid usage() needs.
+  if (container->executorName().isNone()) {
+    container->pid = pid.get();
+  }
+
   Try<Nothing> checkpointed = checkpoint(containerId, pid.get());
 
   if (checkpointed.isError()) {
@@ -1202,8 +1327,7 @@ Future<ResourceStatistics> DockerContainerizerProcess::usage(
     return Failure("Container is being removed: " + stringify(containerId));
   }
 
-  auto collectUsage = [this, containerId](
-      pid_t pid) -> Future<ResourceStatistics> {
+  auto collectUsage = [this, containerId]() -> Future<ResourceStatistics> {
     // First make sure container is still there.
     if (!containers_.contains(containerId)) {
       return Failure("Container has been destroyed: " + stringify(containerId));
@@ -1215,7 +1339,8 @@ Future<ResourceStatistics> DockerContainerizerProcess::usage(
       return Failure("Container is being removed: " + stringify(containerId));
     }
 
-    const Try<ResourceStatistics> cgroupStats = cgroupsStatistics(pid);
+    const Try<ResourceStatistics> cgroupStats =
+      cgroupsStatistics(containerId);
     if (cgroupStats.isError()) {
       return Failure("Failed to collect cgroup stats: " + cgroupStats.error());
     }
@@ -1237,9 +1362,10 @@ Future<ResourceStatistics> DockerContainerizerProcess::usage(
     return result;
   };
 
-  // Skip inspecting the docker container if we already have the pid.
+  // Skip inspecting the docker container if we already have the pid,
+  // which we do unless the docker executor launched the container.
   if (container->pid.isSome()) {
-    return collectUsage(container->pid.get());
+    return collectUsage();
   }
 
   return docker->inspect(container->name())
@@ -1263,71 +1389,127 @@ Future<ResourceStatistics> DockerContainerizerProcess::usage(
         // a pid for the container.
         container->pid = pid;
 
-        return collectUsage(pid.get());
+        return collectUsage();
       }));
 #endif // __linux__
 }
 
 
+#ifdef __linux__
+// Opens a control file of a cgroup in the hierarchy of the given
+// subsystem, where 'cgroup' is the lookup of the cgroup of a process.
+static Try<Owned<cgroups::Control>> openControl(
+    const string& subsystem,
+    const Result<string>& cgroup,
+    const string& name)
+{
+  const Result<string> hierarchy = cgroups::hierarchy(subsystem);
+  if (hierarchy.isError()) {
+    return Error(
+        "Failed to determine the cgroup '" + subsystem +
+        "' subsystem hierarchy: " + hierarchy.error());
+  } else if (hierarchy.isNone()) {
+    return Error(
+        "Failed to find the cgroup '" + subsystem +
+        "' subsystem hierarchy");
+  }
+
+  if (cgroup.isError()) {
+    return Error(
+        "Failed to determine cgroup for the '" + subsystem +
+        "' subsystem: " + cgroup.error());
+  } else if (cgroup.isNone()) {
+    return Error(
+        "Failed to find cgroup for the '" + subsystem + "' subsystem");
+  }
+
+  return cgroups::Control::open(hierarchy.get(), cgroup.get(), name);
+}
+#endif // __linux__
+
+
 Try<ResourceStatistics> DockerContainerizerProcess::cgroupsStatistics(
-    pid_t pid) const
+    const ContainerID& containerId)
 {
 #ifndef __linux__
   return Error("Does not support cgroups on non-linux platform");
 #else
-  const Result<string> cpuHierarchy = cgroups::hierarchy("cpuacct");
-  const Result<string> memHierarchy = cgroups::hierarchy("memory");
+  CHECK(containers_.contains(containerId));
 
-  if (cpuHierarchy.isError()) {
-    return Error(
-        "Failed to determine the cgroup 'cpu' subsystem hierarchy: " +
-        cpuHierarchy.error());
-  }
+  Container* container = containers_[containerId];
 
-  if (memHierarchy.isError()) {
-    return Error(
-        "Failed to determine the cgroup 'memory' subsystem hierarchy: " +
-        memHierarchy.error());
-  }
+  CHECK_SOME(container->pid);
 
-  const Result<string> cpuCgroup = cgroups::cpuacct::cgroup(pid);
-  if (cpuCgroup.isError()) {
-    return Error(
-        "Failed to determine cgroup for the 'cpu' subsystem: " +
-        cpuCgroup.error());
+  // The control files are opened on first use and kept open, see
+  // 'Container::cpuacctStat'.
+  if (container->cpuacctStat.get() == NULL) {
+    Try<Owned<cgroups::Control>> control =
+      openControl(
+          "cpuacct",
+          cgroups::cpuacct::cgroup(container->pid.get()),
+          "cpuacct.stat");
+
+    if (control.isError()) {
+      return Error("Failed to open cpuacct.stat: " + control.error());
+    }
+
+    container->cpuacctStat = control.get();
   }
 
-  const Result<string> memCgroup = cgroups::memory::cgroup(pid);
-  if (memCgroup.isError()) {
-    return Error(
-        "Failed to determine cgroup for the 'memory' subsystem: " +
-        memCgroup.error());
+  if (container->memoryStat.get() == NULL) {
+    Try<Owned<cgroups::Control>> control =
+      openControl(
+          "memory",
+          cgroups::memory::cgroup(container->pid.get()),
+          "memory.stat");
+
+    if (control.isError()) {
+      return Error("Failed to open memory.stat: " + control.error());
+    }
+
+    container->memoryStat = control.get();
   }
 
-  const Try<cgroups::cpuacct::Stats> cpuAcctStat =
-    cgroups::cpuacct::stat(cpuHierarchy.get(), cpuCgroup.get());
+  Option<uint64_t> user;
+  Option<uint64_t> system;
 
-  if (cpuAcctStat.isError()) {
-    return Error("Failed to get cpu.stat: " + cpuAcctStat.error());
+  Try<Nothing> stat = container->cpuacctStat->stat({
+      {"user", &user},
+      {"system", &system}});
+
+  if (stat.isError()) {
+    return Error("Failed to get cpuacct.stat: " + stat.error());
+  }
+
+  if (user.isNone() || system.isNone()) {
+    return Error("cgroups cpuacct stats does not contain 'user' or 'system'");
   }
 
-  const Try<hashmap<string, uint64_t>> memStats =
-    cgroups::stat(memHierarchy.get(), memCgroup.get(), "memory.stat");
+  Option<uint64_t> rss;
 
-  if (memStats.isError()) {
+  stat = container->memoryStat->stat({{"rss", &rss}});
+
+  if (stat.isError()) {
     return Error(
         "Error getting memory statistics from cgroups memory subsystem: " +
-        memStats.error());
+        stat.error());
   }
 
-  if (!memStats.get().contains("rss")) {
+  if (rss.isNone()) {
     return Error("cgroups memory stats does not contain 'rss' data");
   }
 
+  // Convert the clock ticks of cpuacct.stat as cgroups::cpuacct::stat
+  // does.
+  const long ticks = sysconf(_SC_CLK_TCK);
+  if (ticks <= 0) {
+    return ErrnoError("Failed to get sysconf(_SC_CLK_TCK)");
+  }
+
   ResourceStatistics result;
-  result.set_cpus_system_time_secs(cpuAcctStat.get().system.secs());
-  result.set_cpus_user_time_secs(cpuAcctStat.get().user.secs());
-  result.set_mem_rss_bytes(memStats.get().at("rss"));
+  result.set_cpus_system_time_secs((double) system.get() / (double) ticks);
+  result.set_cpus_user_time_secs((double) user.get() / (double) ticks);
+  result.set_mem_rss_bytes(rss.get());
 
   return result;
 #endif // __linux__
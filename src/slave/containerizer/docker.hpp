@@ -17,14 +17,25 @@
 #ifndef __DOCKER_CONTAINERIZER_HPP__
 #define __DOCKER_CONTAINERIZER_HPP__
 
+#include <mesos/slave/container_logger.hpp>
+
+#include <process/owned.hpp>
 #include <process/shared.hpp>
 
+#include <process/metrics/timer.hpp>
+
 #include <stout/flags.hpp>
 #include <stout/hashset.hpp>
 
 #include "docker/docker.hpp"
 #include "docker/executor.hpp"
 
+#ifdef __linux__
+#include "linux/cgroups.hpp"
+#endif // __linux__
+
+#include "slave/container_loggers/sandbox.hpp"
+
 #include "slave/containerizer/containerizer.hpp"
 
 namespace mesos {
@@ -61,7 +72,10 @@ public:
   DockerContainerizer(
       const Flags& flags,
       Fetcher* fetcher,
-      process::Shared<Docker> docker);
+      process::Shared<Docker> docker,
+      const process::Owned<mesos::slave::ContainerLogger>& logger =
+        process::Owned<mesos::slave::ContainerLogger>(
+            new SandboxContainerLogger()));
 
   // This is only public for tests.
   DockerContainerizer(
@@ -105,6 +119,8 @@ public:
 
   virtual process::Future<hashset<ContainerID>> containers();
 
+  virtual process::Future<bool> pull(const Image& image);
+
 private:
   process::Owned<DockerContainerizerProcess> process;
 };
@@ -118,10 +134,14 @@ public:
   DockerContainerizerProcess(
       const Flags& _flags,
       Fetcher* _fetcher,
-      process::Shared<Docker> _docker)
+      process::Shared<Docker> _docker,
+      const process::Owned<mesos::slave::ContainerLogger>& _logger =
+        process::Owned<mesos::slave::ContainerLogger>(
+            new SandboxContainerLogger()))
     : flags(_flags),
       fetcher(_fetcher),
-      docker(_docker) {}
+      docker(_docker),
+      logger(_logger) {}
 
   virtual process::Future<Nothing> recover(
       const Option<state::SlaveState>& state);
@@ -156,6 +176,9 @@ public:
 
   virtual process::Future<Nothing> pull(const ContainerID& containerId);
 
+  // Pulls an image ahead of the containers that use it.
+  virtual process::Future<bool> pullImage(const Image& image);
+
   virtual process::Future<hashset<ContainerID>> containers();
 
 private:
@@ -178,11 +201,13 @@ private:
   // Starts the executor in a Docker container.
   process::Future<Docker::Container> launchExecutorContainer(
       const ContainerID& containerId,
-      const std::string& containerName);
+      const std::string& containerName,
+      const mesos::slave::ContainerLogger::SubprocessInfo& subprocessInfo);
 
   // Starts the docker executor with a subprocess.
   process::Future<pid_t> launchExecutorProcess(
-      const ContainerID& containerId);
+      const ContainerID& containerId,
+      const mesos::slave::ContainerLogger::SubprocessInfo& subprocessInfo);
 
   process::Future<pid_t> checkpointExecutor(
       const ContainerID& containerId,
@@ -217,7 +242,9 @@ private:
       const Resources& resources,
       pid_t pid);
 
-  Try<ResourceStatistics> cgroupsStatistics(pid_t pid) const;
+  // Reads the statistics of the cgroups of the running container,
+  // whose pid must be known.
+  Try<ResourceStatistics> cgroupsStatistics(const ContainerID& containerId);
 
   // Call back for when the executor exits. This will trigger
   // container destroy.
@@ -234,6 +261,21 @@ private:
 
   process::Shared<Docker> docker;
 
+  const process::Owned<mesos::slave::ContainerLogger> logger;
+
+  struct Metrics
+  {
+    Metrics();
+    ~Metrics();
+
+    // The time to pull the image of a container.
+    process::metrics::Timer<Milliseconds> image_pull;
+
+    // The time to run the executor container, up to the point where
+    // it is inspected successfully.
+    process::metrics::Timer<Milliseconds> container_run;
+  } metrics;
+
   struct Container
   {
     static Try<Container*> create(
@@ -444,6 +486,15 @@ private:
     // running container.
     Option<pid_t> pid;
 
+#ifdef __linux__
+    // The cgroup control files read by usage(). They are opened on
+    // the first usage() of the running container and kept open, so
+    // that collecting the usage neither inspects the container nor
+    // looks up its cgroups again.
+    process::Owned<cgroups::Control> cpuacctStat;
+    process::Owned<cgroups::Control> memoryStat;
+#endif // __linux__
+
     // The executor pid that was forked to wait on the running
     // container. This is stored so we can clean up the executor
     // on destroy.
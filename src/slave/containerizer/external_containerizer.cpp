@@ -24,6 +24,8 @@
 #include <signal.h>
 #include <stdio.h>
 
+#include <sys/socket.h>
+
 #include <mesos/type_utils.hpp>
 
 #include <process/async.hpp>
@@ -249,11 +251,61 @@ ExternalContainerizerProcess::ExternalContainerizerProcess(
     const Flags& _flags) : flags(_flags) {}
 
 
+ExternalContainerizerProcess::Daemon::Daemon(pid_t _pid, int _socket)
+  : pid(_pid),
+    socket(_socket),
+    encoder([](const containerizer::Call& call) {
+      return call.SerializeAsString();
+    }),
+    decoder([](const string& data) -> Try<containerizer::Response> {
+      containerizer::Response response;
+      if (!response.ParseFromString(data)) {
+        return Error("Failed to parse the response");
+      }
+      return response;
+    }),
+    writing(Nothing()),
+    nextId(0) {}
+
+
+void ExternalContainerizerProcess::finalize()
+{
+  if (daemon.isSome()) {
+    daemon.get()->reading.discard();
+
+    // The daemon is expected to exit once its stdin is closed.
+    os::close(daemon.get()->socket);
+  }
+}
+
+
 Future<Nothing> ExternalContainerizerProcess::recover(
     const Option<state::SlaveState>& state)
 {
   LOG(INFO) << "Recovering containerizer";
 
+  if (flags.external_containerizer_daemon) {
+    Try<Nothing> started = start();
+    if (started.isError()) {
+      return Failure("Recover failed: " + started.error());
+    }
+
+    containerizer::Call call;
+    call.set_type(containerizer::Call::RECOVER);
+
+    // Gather the active containers from the external containerizer
+    // once it has recovered its internal state.
+    return this->call(call)
+      .then(defer(PID<ExternalContainerizerProcess>(this), [this]() {
+        return containers();
+      }))
+      .then(defer(
+          PID<ExternalContainerizerProcess>(this),
+          &ExternalContainerizerProcess::__recover,
+          state,
+          lambda::_1));
+  }
+
   // Ask the external containerizer to recover its internal state.
   Try<Subprocess> invoked = invoke("recover");
 
@@ -481,6 +533,43 @@ Future<bool> ExternalContainerizerProcess::launch(
 
   Sandbox sandbox(directory, user);
 
+  if (daemon.isSome()) {
+    if (user.isSome()) {
+      Try<Nothing> chown = os::chown(user.get(), directory);
+      if (chown.isError()) {
+        return Failure("Launch of container '" + containerId.value() +
+                       "' failed: Failed to chown work directory: " +
+                       chown.error());
+      }
+    }
+
+    containerizer::Call call;
+    call.set_type(containerizer::Call::LAUNCH);
+    call.mutable_launch()->CopyFrom(launch);
+
+    foreachpair (const string& name, const string& value, environment) {
+      Environment::Variable* variable =
+        call.mutable_environment()->add_variables();
+      variable->set_name(name);
+      variable->set_value(value);
+    }
+
+    // Record the container launch intend.
+    actives.put(containerId, Owned<Container>(new Container(sandbox)));
+
+    return this->call(call)
+      .then(defer(
+          PID<ExternalContainerizerProcess>(this),
+          &ExternalContainerizerProcess::launched,
+          launch,
+          lambda::_1))
+      .onAny(defer(
+          PID<ExternalContainerizerProcess>(this),
+          &ExternalContainerizerProcess::__launch,
+          containerId,
+          lambda::_1));
+  }
+
   Try<Subprocess> invoked = invoke(
       "launch",
       launch,
@@ -500,23 +589,13 @@ Future<bool> ExternalContainerizerProcess::launch(
   // checkpoint one. See MESOS-1328 and MESOS-923.
   // TODO(tillt): Remove this entirely as soon as MESOS-923 is fixed.
   if (checkpoint) {
-    const string& path = slave::paths::getForkedPidPath(
-        slave::paths::getMetaRootDir(flags.work_dir),
+    Try<Nothing> checkpointed = checkpointPid(
         slaveId,
-        executor.framework_id(),
-        executor.executor_id(),
-        containerId);
-
-    LOG(INFO) << "Checkpointing executor's forked pid " << invoked.get().pid()
-              << " to '" << path <<  "'";
-
-    Try<Nothing> checkpointed =
-      slave::state::checkpoint(path, stringify(invoked.get().pid()));
+        executor,
+        containerId,
+        invoked.get().pid());
 
     if (checkpointed.isError()) {
-      LOG(ERROR) << "Failed to checkpoint executor's forked pid to '"
-                 << path << "': " << checkpointed.error();
-
       return Failure("Could not checkpoint executor's pid");
     }
   }
@@ -576,6 +655,72 @@ void ExternalContainerizerProcess::__launch(
 }
 
 
+Future<bool> ExternalContainerizerProcess::launched(
+    const containerizer::Launch& launch,
+    const containerizer::Response& response)
+{
+  const ContainerID& containerId = launch.container_id();
+
+  VLOG(1) << "Launch callback triggered on container '" << containerId << "'";
+
+  if (!actives.contains(containerId)) {
+    return Failure("Container '" + containerId.value() + "' not running");
+  }
+
+  // The forked pid is checkpointed once the daemon has launched the
+  // executor, see 'launch'.
+  if (launch.checkpoint()) {
+    if (!response.has_pid()) {
+      return Failure("Could not checkpoint executor's pid: "
+                     "The external containerizer did not return it");
+    }
+
+    Try<Nothing> checkpointed = checkpointPid(
+        launch.slave_id(),
+        launch.executor_info(),
+        containerId,
+        response.pid());
+
+    if (checkpointed.isError()) {
+      return Failure("Could not checkpoint executor's pid");
+    }
+  }
+
+  VLOG(1) << "Launch finishing up for container '" << containerId << "'";
+
+  actives[containerId]->launched.set(Nothing());
+
+  return true;
+}
+
+
+Try<Nothing> ExternalContainerizerProcess::checkpointPid(
+    const SlaveID& slaveId,
+    const ExecutorInfo& executorInfo,
+    const ContainerID& containerId,
+    pid_t pid)
+{
+  const string& path = slave::paths::getForkedPidPath(
+      slave::paths::getMetaRootDir(flags.work_dir),
+      slaveId,
+      executorInfo.framework_id(),
+      executorInfo.executor_id(),
+      containerId);
+
+  LOG(INFO) << "Checkpointing executor's forked pid " << pid
+            << " to '" << path <<  "'";
+
+  Try<Nothing> checkpointed = slave::state::checkpoint(path, stringify(pid));
+
+  if (checkpointed.isError()) {
+    LOG(ERROR) << "Failed to checkpoint executor's forked pid to '"
+               << path << "': " << checkpointed.error();
+  }
+
+  return checkpointed;
+}
+
+
 Future<containerizer::Termination> ExternalContainerizerProcess::wait(
     const ContainerID& containerId)
 {
@@ -604,6 +749,28 @@ Future<containerizer::Termination> ExternalContainerizerProcess::_wait(
     return Failure("Container '" + containerId.value() + "' not running");
   }
 
+  if (daemon.isSome()) {
+    if (actives[containerId]->waiting) {
+      VLOG(2) << "Already waiting for " << containerId;
+      return actives[containerId]->termination.future();
+    }
+
+    actives[containerId]->waiting = true;
+
+    containerizer::Call call;
+    call.set_type(containerizer::Call::WAIT);
+    call.mutable_wait()->mutable_container_id()->CopyFrom(containerId);
+
+    this->call(call)
+      .onAny(defer(
+          PID<ExternalContainerizerProcess>(this),
+          &ExternalContainerizerProcess::waited,
+          containerId,
+          lambda::_1));
+
+    return actives[containerId]->termination.future();
+  }
+
   // We must not run multiple 'wait' invocations concurrently on the
   // same container.
   if (actives[containerId]->pid.isSome()) {
@@ -701,6 +868,33 @@ void ExternalContainerizerProcess::__wait(
 }
 
 
+void ExternalContainerizerProcess::waited(
+    const ContainerID& containerId,
+    const Future<containerizer::Response>& future)
+{
+  VLOG(1) << "Wait callback triggered on container '" << containerId << "'";
+
+  if (!actives.contains(containerId)) {
+    LOG(ERROR) << "Container '" << containerId << "' not running";
+    return;
+  }
+
+  if (!future.isReady()) {
+    VLOG(2) << "Wait termination failed on '" << containerId << "'";
+    actives[containerId]->termination.fail(
+        future.isFailed() ? future.failure() : "discarded");
+  } else {
+    const containerizer::Termination& termination =
+      future.get().termination();
+
+    VLOG(2) << "Wait Termination: " << termination.DebugString();
+    actives[containerId]->termination.set(termination);
+  }
+
+  cleanup(containerId);
+}
+
+
 Future<Nothing> ExternalContainerizerProcess::update(
     const ContainerID& containerId,
     const Resources& resources)
@@ -738,6 +932,15 @@ Future<Nothing> ExternalContainerizerProcess::_update(
   update.mutable_container_id()->CopyFrom(containerId);
   update.mutable_resources()->CopyFrom(resources);
 
+  if (daemon.isSome()) {
+    containerizer::Call call;
+    call.set_type(containerizer::Call::UPDATE);
+    call.mutable_update()->CopyFrom(update);
+
+    return this->call(call)
+      .then([]() { return Nothing(); });
+  }
+
   Try<Subprocess> invoked = invoke(
       "update",
       update,
@@ -803,6 +1006,24 @@ Future<ResourceStatistics> ExternalContainerizerProcess::_usage(
     return Failure("Container '" + containerId.value() + "'' not running");
   }
 
+  if (daemon.isSome()) {
+    // The usages which are requested together, e.g., by the resource
+    // monitor for all containers, are gathered by a single call to
+    // the daemon once they are all queued up.
+    if (usages.empty()) {
+      dispatch(self(), &ExternalContainerizerProcess::collectUsage);
+    }
+
+    if (!usages.contains(containerId)) {
+      Owned<Promise<ResourceStatistics>> promise(
+          new Promise<ResourceStatistics>());
+
+      usages.put(containerId, promise);
+    }
+
+    return usages[containerId]->future();
+  }
+
   containerizer::Usage usage;
   usage.mutable_container_id()->CopyFrom(containerId);
 
@@ -864,6 +1085,62 @@ Future<ResourceStatistics> ExternalContainerizerProcess::__usage(
 }
 
 
+void ExternalContainerizerProcess::collectUsage()
+{
+  VLOG(1) << "Usage triggered on " << usages.size() << " containers";
+
+  containerizer::Call call;
+  call.set_type(containerizer::Call::USAGE);
+
+  foreachkey (const ContainerID& containerId, usages) {
+    call.add_usage()->CopyFrom(containerId);
+  }
+
+  this->call(call)
+    .onAny(defer(
+        PID<ExternalContainerizerProcess>(this),
+        &ExternalContainerizerProcess::_collectUsage,
+        usages,
+        lambda::_1));
+
+  usages.clear();
+}
+
+
+void ExternalContainerizerProcess::_collectUsage(
+    const hashmap<ContainerID, Owned<Promise<ResourceStatistics>>>& promises,
+    const Future<containerizer::Response>& future)
+{
+  VLOG(1) << "Usage callback triggered on " << promises.size()
+          << " containers";
+
+  if (!future.isReady()) {
+    foreachvalue (const Owned<Promise<ResourceStatistics>>& promise,
+                  promises) {
+      promise->fail(future.isFailed() ? future.failure() : "discarded");
+    }
+    return;
+  }
+
+  foreach (const containerizer::Response::Statistics& statistics,
+           future.get().usage()) {
+    if (promises.contains(statistics.container_id())) {
+      promises.get(statistics.container_id()).get()->set(
+          statistics.statistics());
+    }
+  }
+
+  foreachpair (const ContainerID& containerId,
+               const Owned<Promise<ResourceStatistics>>& promise,
+               promises) {
+    if (promise->future().isPending()) {
+      promise->fail("Could not receive any result for container '" +
+                    containerId.value() + "'");
+    }
+  }
+}
+
+
 void ExternalContainerizerProcess::destroy(const ContainerID& containerId)
 {
   VLOG(1) << "Destroy triggered on container '" << containerId << "'";
@@ -901,6 +1178,20 @@ void ExternalContainerizerProcess::_destroy(const ContainerID& containerId)
   containerizer::Destroy destroy;
   destroy.mutable_container_id()->CopyFrom(containerId);
 
+  if (daemon.isSome()) {
+    containerizer::Call call;
+    call.set_type(containerizer::Call::DESTROY);
+    call.mutable_destroy()->CopyFrom(destroy);
+
+    this->call(call)
+      .onAny(defer(
+          PID<ExternalContainerizerProcess>(this),
+          &ExternalContainerizerProcess::destroyed,
+          containerId,
+          lambda::_1));
+    return;
+  }
+
   Try<Subprocess> invoked = invoke(
       "destroy",
       destroy,
@@ -945,10 +1236,60 @@ void ExternalContainerizerProcess::__destroy(
 }
 
 
+void ExternalContainerizerProcess::destroyed(
+    const ContainerID& containerId,
+    const Future<containerizer::Response>& future)
+{
+  VLOG(1) << "Destroy callback triggered on container '" << containerId << "'";
+
+  if (!actives.contains(containerId)) {
+    LOG(ERROR) << "Container '" << containerId << "' not running ";
+    return;
+  }
+
+  // Unlike the "wait" process of a forked external containerizer, the
+  // pending 'wait' call of the daemon can not be terminated, hence we
+  // give up on the container.
+  if (!future.isReady()) {
+    const string message =
+      future.isFailed() ? future.failure() : "discarded";
+
+    LOG(ERROR) << "Destroy of container '" << containerId
+               << "' failed: " << message;
+
+    actives[containerId]->termination.fail(message);
+    cleanup(containerId);
+    return;
+  }
+
+  // Otherwise the daemon answers the pending 'wait' call once the
+  // container is gone.
+  if (!actives[containerId]->waiting) {
+    LOG(WARNING) << "Container '" << containerId << "' not being waited on";
+    cleanup(containerId);
+  }
+}
+
+
 Future<hashset<ContainerID>> ExternalContainerizerProcess::containers()
 {
   VLOG(1) << "Containers triggered";
 
+  if (daemon.isSome()) {
+    containerizer::Call call;
+    call.set_type(containerizer::Call::CONTAINERS);
+
+    return this->call(call)
+      .then([](const containerizer::Response& response) {
+        hashset<ContainerID> result;
+        foreach (const ContainerID& containerId,
+                 response.containers().containers()) {
+          result.insert(containerId);
+        }
+        return result;
+      });
+  }
+
   Try<Subprocess> invoked = invoke("containers");
 
   if (invoked.isError()) {
@@ -1212,6 +1553,203 @@ Try<Subprocess> ExternalContainerizerProcess::invoke(
   return external;
 }
 
+
+Try<Nothing> ExternalContainerizerProcess::start()
+{
+  CHECK_SOME(flags.containerizer_path) << "containerizer_path not set";
+
+  int sockets[2];
+  if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) == -1) {
+    return ErrnoError("Failed to create the external containerizer socket");
+  }
+
+  map<string, string> environment = os::environment();
+
+  environment["MESOS_LIBEXEC_DIRECTORY"] = flags.launcher_dir;
+  environment["MESOS_WORK_DIRECTORY"] = flags.work_dir;
+
+  const string execute = flags.containerizer_path.get() + " daemon";
+
+  VLOG(2) << "calling: [" << execute << "]";
+
+  // The daemon reads the calls from its stdin and writes the
+  // responses to its stdout, which are both the other end of the
+  // socket. Its stderr is the one of the slave. Run a setsid within
+  // the child-context.
+  Try<Subprocess> external = process::subprocess(
+      execute,
+      Subprocess::FD(sockets[1]),
+      Subprocess::FD(sockets[1]),
+      Subprocess::FD(STDERR_FILENO),
+      environment,
+      lambda::bind(&setup, string()));
+
+  os::close(sockets[1]);
+
+  if (external.isError()) {
+    os::close(sockets[0]);
+    return Error("Failed to execute external containerizer: " +
+                 external.error());
+  }
+
+  // Sync parent and child process to make sure we have done the
+  // setsid within the child context before continuing.
+  int sync;
+  while (::read(sockets[0], &sync, sizeof(sync)) == -1 && errno == EINTR);
+
+  Try<Nothing> nonblock = os::nonblock(sockets[0]);
+  if (nonblock.isError()) {
+    ::kill(external.get().pid(), SIGKILL);
+    os::close(sockets[0]);
+    return Error("Failed to accept nonblock: " + nonblock.error());
+  }
+
+  LOG(INFO) << "Started external containerizer daemon with pid "
+            << external.get().pid();
+
+  daemon = Owned<Daemon>(new Daemon(external.get().pid(), sockets[0]));
+
+  receive();
+
+  return Nothing();
+}
+
+
+Future<containerizer::Response> ExternalContainerizerProcess::call(
+    containerizer::Call call)
+{
+  CHECK_SOME(daemon);
+
+  if (daemon.get()->error.isSome()) {
+    return Failure(
+        "External containerizer daemon is gone: " + daemon.get()->error.get());
+  }
+
+  call.set_id(daemon.get()->nextId++);
+
+  VLOG(1) << "Calling external containerizer daemon for method '"
+          << containerizer::Call::Type_Name(call.type()) << "'";
+
+  Owned<Promise<containerizer::Response>> promise(
+      new Promise<containerizer::Response>());
+
+  daemon.get()->calls.put(call.id(), promise);
+
+  const int socket = daemon.get()->socket;
+  const string data = daemon.get()->encoder.encode(call);
+
+  daemon.get()->writing = daemon.get()->writing
+    .then([socket, data]() { return io::write(socket, data); });
+
+  daemon.get()->writing
+    .onFailed(defer(
+        PID<ExternalContainerizerProcess>(this),
+        &ExternalContainerizerProcess::stop,
+        lambda::_1));
+
+  return promise->future()
+    .then([](const containerizer::Response& response)
+        -> Future<containerizer::Response> {
+      if (response.has_error()) {
+        return Failure(response.error());
+      }
+      return response;
+    });
+}
+
+
+void ExternalContainerizerProcess::receive()
+{
+  CHECK_SOME(daemon);
+
+  daemon.get()->reading = io::read(
+      daemon.get()->socket,
+      daemon.get()->data,
+      sizeof(daemon.get()->data));
+
+  daemon.get()->reading
+    .onAny(defer(
+        PID<ExternalContainerizerProcess>(this),
+        &ExternalContainerizerProcess::_receive,
+        lambda::_1));
+}
+
+
+void ExternalContainerizerProcess::_receive(const Future<size_t>& future)
+{
+  CHECK_SOME(daemon);
+
+  if (!future.isReady()) {
+    stop("Failed to read from the socket: " +
+         (future.isFailed() ? future.failure() : "discarded"));
+    return;
+  }
+
+  if (future.get() == 0) {
+    stop("The socket was closed");
+    return;
+  }
+
+  Try<std::deque<Try<containerizer::Response>>> responses =
+    daemon.get()->decoder.decode(string(daemon.get()->data, future.get()));
+
+  // A daemon whose responses can not be decoded is of no use anymore.
+  if (responses.isError()) {
+    ::kill(daemon.get()->pid, SIGKILL);
+    stop("Failed to decode the responses: " + responses.error());
+    return;
+  }
+
+  foreach (const Try<containerizer::Response>& response, responses.get()) {
+    if (response.isError()) {
+      ::kill(daemon.get()->pid, SIGKILL);
+      stop("Failed to decode a response: " + response.error());
+      return;
+    }
+
+    const uint64_t id = response.get().id();
+
+    Option<Owned<Promise<containerizer::Response>>> promise =
+      daemon.get()->calls.get(id);
+
+    if (promise.isNone()) {
+      LOG(WARNING) << "Ignoring the response to the unknown call " << id
+                   << " of the external containerizer daemon";
+      continue;
+    }
+
+    daemon.get()->calls.erase(id);
+    promise.get()->set(response.get());
+  }
+
+  receive();
+}
+
+
+void ExternalContainerizerProcess::stop(const string& message)
+{
+  CHECK_SOME(daemon);
+
+  if (daemon.get()->error.isSome()) {
+    return;
+  }
+
+  LOG(ERROR) << "Lost the external containerizer daemon with pid "
+             << daemon.get()->pid << ": " << message;
+
+  daemon.get()->error = message;
+
+  hashmap<uint64_t, Owned<Promise<containerizer::Response>>> calls =
+    daemon.get()->calls;
+
+  daemon.get()->calls.clear();
+
+  foreachvalue (const Owned<Promise<containerizer::Response>>& promise,
+                calls) {
+    promise->fail(message);
+  }
+}
+
 } // namespace slave {
 } // namespace internal {
 } // namespace mesos {
@@ -27,6 +27,7 @@
 
 #include <stout/hashmap.hpp>
 #include <stout/protobuf.hpp>
+#include <stout/recordio.hpp>
 #include <stout/try.hpp>
 
 #include "slave/state.hpp"
@@ -54,6 +55,14 @@ namespace slave {
 // 'wait' on the external containerizer side is expected to block
 // until the task command/executor has terminated.
 //
+// With '--external_containerizer_daemon', the external containerizer
+// program is instead invoked once as 'daemon' and gets the commands
+// as "Record-IO" encoded containerizer::Call messages on its stdin,
+// which is a unix socket. It answers each of them with a
+// containerizer::Response of the same id on its stdout, which is the
+// same socket, and is expected to exit once its stdin is closed. The
+// 'usage' of all containers is gathered by a single call.
+//
 // Additionally, we have the following environment variable setup
 // for external containerizer programs:
 // MESOS_LIBEXEC_DIRECTORY = path to mesos-executor, mesos-usage, ...
@@ -160,6 +169,9 @@ public:
   // Get all active container-id's.
   process::Future<hashset<ContainerID>> containers();
 
+protected:
+  virtual void finalize();
+
 private:
   // Startup flags.
   const Flags flags;
@@ -179,7 +191,7 @@ private:
   struct Container
   {
     Container(const Option<Sandbox>& sandbox)
-      : sandbox(sandbox), pid(None()), destroying(false) {}
+      : sandbox(sandbox), pid(None()), destroying(false), waiting(false) {}
 
     // Keep sandbox information available for subsequent containerizer
     // invocations.
@@ -195,6 +207,10 @@ private:
     // Is set when container is being destroyed.
     bool destroying;
 
+    // Is set when the container is waited on by a call to the
+    // external containerizer daemon.
+    bool waiting;
+
     // As described in MESOS-1251, we need to make sure that events
     // that are triggered before launch has completed, are in fact
     // queued until then to reduce complexity within external
@@ -211,6 +227,45 @@ private:
   // Stores all active containers.
   hashmap<ContainerID, process::Owned<Container>> actives;
 
+  // The long-lived external containerizer program, see
+  // '--external_containerizer_daemon'.
+  struct Daemon
+  {
+    Daemon(pid_t _pid, int _socket);
+
+    const pid_t pid;
+
+    // The slave end of the unix socket to the daemon.
+    const int socket;
+
+    ::recordio::Encoder<containerizer::Call> encoder;
+    ::recordio::Decoder<containerizer::Response> decoder;
+
+    // The calls are written one after the other so that they can not
+    // interleave on the socket.
+    process::Future<Nothing> writing;
+
+    // The buffer the responses are read into.
+    char data[4096];
+    process::Future<size_t> reading;
+
+    uint64_t nextId;
+
+    // The calls which have not been answered yet.
+    hashmap<uint64_t, process::Owned<process::Promise<containerizer::Response>>>
+      calls;
+
+    // Set once the daemon is gone, after which all calls fail.
+    Option<std::string> error;
+  };
+
+  Option<process::Owned<Daemon>> daemon;
+
+  // The containers whose usage is gathered by the next 'usage' call
+  // to the daemon.
+  hashmap<ContainerID, process::Owned<process::Promise<ResourceStatistics>>>
+    usages;
+
   process::Future<Nothing> _recover(
       const Option<state::SlaveState>& state,
       const process::Future<Option<int>>& future);
@@ -229,6 +284,10 @@ private:
       const ContainerID& containerId,
       const process::Future<bool>& future);
 
+  process::Future<bool> launched(
+      const containerizer::Launch& launch,
+      const containerizer::Response& response);
+
   process::Future<containerizer::Termination> _wait(
       const ContainerID& containerId);
 
@@ -257,6 +316,10 @@ private:
 
   void _destroy(const ContainerID& containerId);
 
+  void destroyed(
+      const ContainerID& containerId,
+      const process::Future<containerizer::Response>& future);
+
   void __destroy(
       const ContainerID& containerId,
       const process::Future<Option<int>>& future);
@@ -274,6 +337,43 @@ private:
   // in the container.
   void cleanup(const ContainerID& containerId);
 
+  // Gathers the usage of all containers in 'usages' by a single call
+  // to the daemon.
+  void collectUsage();
+
+  void _collectUsage(
+      const hashmap<ContainerID,
+                    process::Owned<process::Promise<ResourceStatistics>>>&
+        promises,
+      const process::Future<containerizer::Response>& future);
+
+  void waited(
+      const ContainerID& containerId,
+      const process::Future<containerizer::Response>& future);
+
+  // Starts the external containerizer daemon.
+  Try<Nothing> start();
+
+  // Sends the given call to the daemon, which is assigned an id, and
+  // returns its response. The returned future fails if the call
+  // failed on the side of the daemon.
+  process::Future<containerizer::Response> call(containerizer::Call call);
+
+  // Receives the responses of the daemon.
+  void receive();
+  void _receive(const process::Future<size_t>& future);
+
+  // Fails all unanswered calls to the daemon, as well as all calls
+  // which follow, once it is gone.
+  void stop(const std::string& message);
+
+  // Checkpoints the pid of an executor as its forked pid.
+  Try<Nothing> checkpointPid(
+      const SlaveID& slaveId,
+      const ExecutorInfo& executorInfo,
+      const ContainerID& containerId,
+      pid_t pid);
+
   // Invoke the external containerizer with the given command.
   Try<process::Subprocess> invoke(
       const std::string& command,
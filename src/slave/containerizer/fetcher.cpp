@@ -14,22 +14,29 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <unordered_map>
 
 #include <process/async.hpp>
 #include <process/check.hpp>
+#include <process/clock.hpp>
 #include <process/collect.hpp>
 #include <process/dispatch.hpp>
 #include <process/owned.hpp>
 
+#include <stout/hashset.hpp>
 #include <stout/net.hpp>
 #include <stout/path.hpp>
+#include <stout/protobuf.hpp>
 
 #include <stout/os/read.hpp>
 
 #include "hdfs/hdfs.hpp"
 
+#include "messages/messages.hpp"
+
 #include "slave/slave.hpp"
+#include "slave/state.hpp"
 
 #include "slave/containerizer/fetcher.hpp"
 
@@ -37,13 +44,15 @@ using std::list;
 using std::map;
 using std::shared_ptr;
 using std::string;
-using std::transform;
 using std::vector;
 
 using mesos::fetcher::FetcherInfo;
 
+using process::Clock;
 using process::Future;
 using process::Owned;
+using process::Promise;
+using process::Time;
 
 namespace mesos {
 namespace internal {
@@ -54,6 +63,8 @@ static const string FILE_URI_LOCALHOST = "file://localhost";
 
 static const string CACHE_FILE_NAME_PREFIX = "c";
 
+static const string CACHE_INDEX_FILE_NAME = "index";
+
 
 Fetcher::Fetcher() : process(new FetcherProcess())
 {
@@ -75,11 +86,199 @@ Fetcher::~Fetcher()
 }
 
 
-Try<Nothing> Fetcher::recover(const SlaveID& slaveId, const Flags& flags)
+// Returns the total size of the files in a directory.
+static Try<Bytes> directorySize(const string& directory)
+{
+  Try<list<string>> files = os::find(directory, "");
+  if (files.isError()) {
+    return Error(files.error());
+  }
+
+  Bytes total = 0;
+
+  foreach (const string& file, files.get()) {
+    Try<Bytes> size = os::stat::size(file, os::stat::DO_NOT_FOLLOW_SYMLINK);
+    if (size.isError()) {
+      return Error(size.error());
+    }
+
+    total += size.get();
+  }
+
+  return total;
+}
+
+
+// Returns whether the name is the one of a cache file, or of the
+// directory of its extracted archive, as made by nextFilename().
+static bool isCacheFilename(const string& name)
+{
+  if (!strings::startsWith(name, CACHE_FILE_NAME_PREFIX)) {
+    return false;
+  }
+
+  const size_t index = CACHE_FILE_NAME_PREFIX.size();
+  const size_t dash = name.find_first_not_of("0123456789", index);
+
+  return dash != string::npos && dash > index && name[dash] == '-';
+}
+
+
+// Checks that the files of a checkpointed cache entry are complete,
+// i.e., that they have the size the entry had when it completed.
+static Try<Nothing> validateCacheEntry(
+    const string& cacheDirectory,
+    const FetcherCacheIndex::Entry& entry)
+{
+  // The entries are in the cache directory, or in the one of a user.
+  if (entry.directory() != cacheDirectory &&
+      Path(entry.directory()).dirname() != cacheDirectory) {
+    return Error("Unexpected directory '" + entry.directory() + "'");
+  }
+
+  if (!isCacheFilename(entry.filename()) ||
+      strings::contains(entry.filename(), "/")) {
+    return Error("Unexpected file name '" + entry.filename() + "'");
+  }
+
+  const string path = path::join(entry.directory(), entry.filename());
+
+  Try<Bytes> size = os::stat::size(path, os::stat::DO_NOT_FOLLOW_SYMLINK);
+  if (size.isError()) {
+    return Error("Missing cache file '" + path + "': " + size.error());
+  }
+
+  Bytes total = size.get();
+
+  const string extracted = path + FETCHER_CACHE_EXTRACTED_SUFFIX;
+  if (os::exists(extracted)) {
+    Try<Bytes> extractedSize = directorySize(extracted);
+    if (extractedSize.isError()) {
+      return Error(
+          "Could not determine the size of '" + extracted + "': " +
+          extractedSize.error());
+    }
+
+    total += extractedSize.get();
+  }
+
+  if (total != Bytes(entry.size())) {
+    return Error(
+        "Size of the cache file '" + path + "' is " + stringify(total) +
+        " instead of " + stringify(Bytes(entry.size())));
+  }
+
+  return Nothing();
+}
+
+
+// Validates the index of the cache in the given directory, and the
+// cache files, see Fetcher::recover().
+static Try<Nothing> recoverCache(const string& cacheDirectory)
 {
-  // Good enough for now, simple, least-effort recovery.
-  VLOG(1) << "Clearing fetcher cache";
+  const string indexPath = path::join(cacheDirectory, CACHE_INDEX_FILE_NAME);
+
+  FetcherCacheIndex index;
+  index.set_serial(0);
+
+  if (os::exists(indexPath)) {
+    Result<FetcherCacheIndex> read =
+      ::protobuf::read<FetcherCacheIndex>(indexPath);
+
+    if (read.isError()) {
+      return Error("Failed to read the cache index: " + read.error());
+    }
+
+    if (read.isSome()) {
+      index = read.get();
+    }
+  }
+
+  FetcherCacheIndex valid;
+  valid.set_serial(index.serial());
+
+  hashset<string> paths = {indexPath};
+
+  foreach (const FetcherCacheIndex::Entry& entry, index.entries()) {
+    Try<Nothing> validation = validateCacheEntry(cacheDirectory, entry);
+    if (validation.isError()) {
+      LOG(WARNING) << "Dropping fetcher cache entry '" << entry.key()
+                   << "': " << validation.error();
+      continue;
+    }
+
+    const string path = path::join(entry.directory(), entry.filename());
+    paths.insert(path);
+    paths.insert(path + FETCHER_CACHE_EXTRACTED_SUFFIX);
+
+    valid.add_entries()->CopyFrom(entry);
+  }
+
+  // Remove the files that are not in the index, e.g., the ones of
+  // interrupted downloads and of the dropped entries, from the cache
+  // directory and from the ones of the users.
+  list<string> directories = {cacheDirectory};
+
+  Try<list<string>> names = os::ls(cacheDirectory);
+  if (names.isError()) {
+    return Error("Failed to list the cache directory: " + names.error());
+  }
+
+  foreach (const string& name, names.get()) {
+    const string path = path::join(cacheDirectory, name);
+    if (os::stat::isdir(path) && !isCacheFilename(name)) {
+      directories.push_back(path);
+    }
+  }
+
+  foreach (const string& directory, directories) {
+    names = os::ls(directory);
+    if (names.isError()) {
+      return Error(
+          "Failed to list '" + directory + "': " + names.error());
+    }
+
+    foreach (const string& name, names.get()) {
+      const string path = path::join(directory, name);
+
+      if (paths.contains(path)) {
+        continue;
+      }
+
+      // Besides the cache files, only the directories of the users,
+      // and the temporary files of interrupted checkpoints of the
+      // index, are in the cache directory.
+      if (!isCacheFilename(name) &&
+          (directory != cacheDirectory || os::stat::isdir(path))) {
+        continue;
+      }
+
+      LOG(INFO) << "Removing unknown fetcher cache file '" << path << "'";
+
+      Try<Nothing> rm = os::stat::isdir(path)
+        ? os::rmdir(path)
+        : os::rm(path);
+
+      if (rm.isError()) {
+        return Error("Failed to remove '" + path + "': " + rm.error());
+      }
+    }
+  }
+
+  Try<Nothing> checkpoint = state::checkpoint(indexPath, valid);
+  if (checkpoint.isError()) {
+    return Error("Failed to checkpoint the cache index: " + checkpoint.error());
+  }
+
+  LOG(INFO) << "Recovered " << valid.entries_size() << " of "
+            << index.entries_size() << " fetcher cache entries";
+
+  return Nothing();
+}
 
+
+Try<Nothing> Fetcher::recover(const SlaveID& slaveId, const Flags& flags)
+{
   string cacheDirectory = paths::getSlavePath(flags.fetcher_cache_dir, slaveId);
   Result<string> path = os::realpath(cacheDirectory);
   if (path.isError()) {
@@ -89,14 +288,24 @@ Try<Nothing> Fetcher::recover(const SlaveID& slaveId, const Flags& flags)
     return Error(path.error());
   }
 
-  if (path.isSome() && os::exists(path.get())) {
-    Try<Nothing> rmdir = os::rmdir(path.get(), true);
-    if (rmdir.isError()) {
-      LOG(ERROR) << "Could not delete fetcher cache directory '"
-                 << cacheDirectory << "', error: " + rmdir.error();
+  if (path.isNone() || !os::exists(path.get())) {
+    return Nothing();
+  }
 
-      return rmdir;
-    }
+  Try<Nothing> recover = recoverCache(cacheDirectory);
+  if (recover.isSome()) {
+    return Nothing();
+  }
+
+  LOG(WARNING) << "Clearing fetcher cache, since it could not be "
+               << "recovered: " << recover.error();
+
+  Try<Nothing> rmdir = os::rmdir(path.get(), true);
+  if (rmdir.isError()) {
+    LOG(ERROR) << "Could not delete fetcher cache directory '"
+               << cacheDirectory << "', error: " + rmdir.error();
+
+    return rmdir;
   }
 
   return Nothing();
@@ -219,14 +428,20 @@ Future<Nothing> Fetcher::fetch(
     return Nothing();
   }
 
-  return dispatch(process.get(),
-                  &FetcherProcess::fetch,
-                  containerId,
-                  commandInfo,
-                  sandboxDirectory,
-                  user,
-                  slaveId,
-                  flags);
+  Future<Nothing> fetch = dispatch(
+      process.get(),
+      &FetcherProcess::fetch,
+      containerId,
+      commandInfo,
+      sandboxDirectory,
+      user,
+      slaveId,
+      flags);
+
+  // NOTE: Timers can be used from any thread.
+  process->metrics.fetch.time(fetch);
+
+  return fetch;
 }
 
 
@@ -244,6 +459,24 @@ FetcherProcess::~FetcherProcess()
 }
 
 
+FetcherProcess::Metrics::Metrics(const FetcherProcess& process)
+  : fetch("containerizer/fetcher/fetch", Hours(1)),
+    cache_entries(
+        "containerizer/fetcher/cache_entries",
+        defer(process, &FetcherProcess::_cache_entries))
+{
+  process::metrics::add(fetch);
+  process::metrics::add(cache_entries);
+}
+
+
+FetcherProcess::Metrics::~Metrics()
+{
+  process::metrics::remove(fetch);
+  process::metrics::remove(cache_entries);
+}
+
+
 // Find out how large a potential download from the given URI is.
 static Try<Bytes> fetchSize(
     const string& uri,
@@ -306,6 +539,15 @@ Future<Nothing> FetcherProcess::fetch(
   // always the exact same value.
   cache.setSpace(flags.fetcher_cache_size);
 
+  // The cache files of URIs with a checksum are shared by all users
+  // and live outside of the per-user cache directories.
+  const string sharedCacheDirectory =
+    paths::getSlavePath(flags.fetcher_cache_dir, slaveId);
+
+  // The entries recovered by Fetcher::recover() are loaded on first
+  // use, the slave ID is not known before.
+  cache.load(sharedCacheDirectory);
+
   Try<Nothing> validated = validateUris(commandInfo);
   if (validated.isError()) {
     return Failure("Could not fetch: " + validated.error());
@@ -316,7 +558,7 @@ Future<Nothing> FetcherProcess::fetch(
     commandUser = commandInfo.user();
   }
 
-  string cacheDirectory = paths::getSlavePath(flags.fetcher_cache_dir, slaveId);
+  string cacheDirectory = sharedCacheDirectory;
   if (commandUser.isSome()) {
     // Segregating per-user cache directories.
     cacheDirectory = path::join(cacheDirectory, commandUser.get());
@@ -362,7 +604,7 @@ Future<Nothing> FetcherProcess::fetch(
     // Check if this is already in the cache (but not necessarily
     // downloaded).
     const Option<shared_ptr<Cache::Entry>> entry =
-      cache.get(commandUser, uri.value());
+      cache.get(commandUser, uri);
 
     if (entry.isSome()) {
       entry.get()->reference();
@@ -373,8 +615,10 @@ Future<Nothing> FetcherProcess::fetch(
           return Future<shared_ptr<Cache::Entry>>(entry.get());
         }));
     } else {
-      shared_ptr<Cache::Entry> newEntry =
-        cache.create(cacheDirectory, commandUser, uri);
+      shared_ptr<Cache::Entry> newEntry = cache.create(
+          uri.has_checksum() ? sharedCacheDirectory : cacheDirectory,
+          commandUser,
+          uri);
 
       newEntry->reference();
 
@@ -482,6 +726,10 @@ Future<Nothing> FetcherProcess::__fetch(
 
     item->mutable_uri()->CopyFrom(uri);
 
+    if (entry.isSome() && entry.get()->directory != cacheDirectory) {
+      item->set_cache_directory(entry.get()->directory);
+    }
+
     if (entry.isSome()) {
       if (entry.get()->completion().isPending()) {
         // Since the entry is not yet "complete", i.e.,
@@ -512,7 +760,30 @@ Future<Nothing> FetcherProcess::__fetch(
     info.set_frameworks_home(flags.frameworks_home);
   }
 
-  return run(containerId, sandboxDirectory, user, info, flags)
+  // The downloads of all the runs of the fetcher program are limited,
+  // those that only retrieve files from the cache do not need any.
+  size_t count = 0;
+  foreach (const FetcherInfo::Item& item, info.items()) {
+    if (item.action() != FetcherInfo::Item::RETRIEVE_FROM_CACHE) {
+      count++;
+    }
+  }
+
+  Future<size_t> granted =
+    count == 0 ? Future<size_t>(0u) : acquireDownloads(count, flags);
+
+  return granted
+    .then(defer(self(), [=](size_t granted) -> Future<Nothing> {
+      FetcherInfo _info = info;
+      if (granted > 1) {
+        _info.set_max_concurrent_downloads(granted);
+      }
+
+      return run(containerId, sandboxDirectory, user, _info, flags)
+        .onAny(defer(self(), [=](const Future<Nothing>&) {
+          releaseDownloads(granted, flags);
+        }));
+    }))
     .repair(defer(self(), [=](const Future<Nothing>& future) {
       LOG(ERROR) << "Failed to run mesos-fetcher: " << future.failure();
 
@@ -528,17 +799,22 @@ Future<Nothing> FetcherProcess::__fetch(
         }
       }
 
+      cache.checkpoint();
+
       return future; // Always propagate the failure!
     }))
     .then(defer(self(), [=]() {
       foreachvalue (const Option<shared_ptr<Cache::Entry>>& entry, entries) {
         if (entry.isSome()) {
-          entry.get()->unreference();
-
           if (entry.get()->completion().isPending()) {
             // Successfully downloaded and cached!
 
+            // NOTE: We only unreference the entry after adjusting it,
+            // which may evict other entries to make room for the
+            // extracted archive, so that it is not evicted itself.
             Try<Nothing> adjust = cache.adjust(entry.get());
+            entry.get()->unreference();
+
             if (adjust.isSome()) {
               entry.get()->complete();
             } else {
@@ -551,10 +827,14 @@ Future<Nothing> FetcherProcess::__fetch(
               entry.get()->fail();
               cache.remove(entry.get());
             }
+          } else {
+            entry.get()->unreference();
           }
         }
       }
 
+      cache.checkpoint();
+
       return Nothing();
     }));
 }
@@ -610,10 +890,12 @@ Try<list<Path>> FetcherProcess::cacheFiles(
                  cacheDirectory + "' with error: " + find.error());
   }
 
-  transform(find.get().begin(),
-            find.get().end(),
-            std::back_inserter(result),
-            [](const string& path) { return Path(path); });
+  // The files of extracted archives are part of their cache files.
+  foreach (const string& path, find.get()) {
+    if (!strings::contains(path, FETCHER_CACHE_EXTRACTED_SUFFIX + "/")) {
+      result.push_back(Path(path));
+    }
+  }
 
   return result;
 }
@@ -815,6 +1097,50 @@ Future<Nothing> FetcherProcess::run(
 }
 
 
+Future<size_t> FetcherProcess::acquireDownloads(
+    size_t count,
+    const Flags& flags)
+{
+  CHECK_GT(count, 0u);
+
+  const size_t limit =
+    std::max<size_t>(1u, flags.fetcher_max_concurrent_downloads);
+
+  if (waiters.empty() && downloads < limit) {
+    const size_t granted = std::min(count, limit - downloads);
+    downloads += granted;
+    return granted;
+  }
+
+  VLOG(1) << "Waiting for " << count << " downloads, "
+          << downloads << " are in use";
+
+  Owned<Promise<size_t>> promise(new Promise<size_t>());
+  waiters.push_back(std::make_pair(count, promise));
+
+  return promise->future();
+}
+
+
+void FetcherProcess::releaseDownloads(size_t count, const Flags& flags)
+{
+  CHECK_GE(downloads, count);
+
+  downloads -= count;
+
+  const size_t limit =
+    std::max<size_t>(1u, flags.fetcher_max_concurrent_downloads);
+
+  while (!waiters.empty() && downloads < limit) {
+    const size_t granted = std::min(waiters.front().first, limit - downloads);
+    downloads += granted;
+
+    waiters.front().second->set(granted);
+    waiters.pop_front();
+  }
+}
+
+
 void FetcherProcess::kill(const ContainerID& containerId)
 {
   if (subprocessPids.contains(containerId)) {
@@ -873,16 +1199,31 @@ static string cacheKey(const Option<string>& user, const string& uri)
 }
 
 
+// URIs with a checksum are cached by their content for all users.
+static string cacheKey(
+    const Option<string>& user,
+    const CommandInfo::URI& uri)
+{
+  if (uri.has_checksum()) {
+    return "sha256:" + strings::lower(uri.checksum());
+  }
+
+  return cacheKey(user, uri.value());
+}
+
+
 shared_ptr<FetcherProcess::Cache::Entry> FetcherProcess::Cache::create(
     const string& cacheDirectory,
     const Option<string>& user,
     const CommandInfo::URI& uri)
 {
-  const string key = cacheKey(user, uri.value());
+  const string key = cacheKey(user, uri);
   const string filename = nextFilename(uri);
 
   auto entry = shared_ptr<Cache::Entry>(
-      new Cache::Entry(key, cacheDirectory, filename));
+      new Cache::Entry(key, cacheDirectory, filename, uri));
+
+  entry->used = Clock::now();
 
   table.put(key, entry);
   lruSortedEntries.push_back(entry);
@@ -905,6 +1246,31 @@ FetcherProcess::Cache::get(
     // Refresh the cache entry by moving it to the back of lruSortedEntries.
     lruSortedEntries.remove(entry.get());
     lruSortedEntries.push_back(entry.get());
+
+    entry.get()->used = Clock::now();
+  }
+
+  return entry;
+}
+
+
+Option<shared_ptr<FetcherProcess::Cache::Entry>>
+FetcherProcess::Cache::get(
+    const Option<string>& user,
+    const CommandInfo::URI& uri)
+{
+  if (!uri.has_checksum()) {
+    return get(user, uri.value());
+  }
+
+  const string key = cacheKey(user, uri);
+
+  Option<shared_ptr<Entry>> entry = table.get(key);
+  if (entry.isSome()) {
+    lruSortedEntries.remove(entry.get());
+    lruSortedEntries.push_back(entry.get());
+
+    entry.get()->used = Clock::now();
   }
 
   return entry;
@@ -986,6 +1352,16 @@ Try<Nothing> FetcherProcess::Cache::remove(
     }
   }
 
+  if (os::exists(entry->extractedPath().value)) {
+    Try<Nothing> rmdir = os::rmdir(entry->extractedPath().value);
+    if (rmdir.isError()) {
+      return Error("Could not delete the extracted archive '" +
+                   entry->extractedPath().value + "' with error: " +
+                   rmdir.error() + " for entry '" + entry->key +
+                   "', leaking cache space: " + stringify(entry->size));
+    }
+  }
+
   // NOTE: There is an assumption that if and only if 'entry->size > 0'
   // then we've claimed cache space for this entry! This currently only
   // gets set in reserveCacheSpace().
@@ -1073,6 +1449,26 @@ Try<Nothing> FetcherProcess::Cache::adjust(
                  "' disappeared from: " + entry->path().value);
   }
 
+  // The space of an archive that the fetcher program extracted in the
+  // cache was not known before downloading, so we reserve it now.
+  if (os::exists(entry->extractedPath().value)) {
+    Try<Bytes> extractedSize = directorySize(entry->extractedPath().value);
+    if (extractedSize.isError()) {
+      return Error("Could not determine the size of the extracted archive "
+                   "for '" + entry->key + "': " + extractedSize.error());
+    }
+
+    Try<Nothing> reservation = reserve(extractedSize.get());
+    if (reservation.isError()) {
+      return Error("Not enough cache space for the extracted archive for '" +
+                   entry->key + "': " + reservation.error());
+    }
+
+    claimSpace(extractedSize.get());
+
+    entry->size += extractedSize.get();
+  }
+
   return Nothing();
 }
 
@@ -1083,6 +1479,86 @@ size_t FetcherProcess::Cache::size()
 }
 
 
+void FetcherProcess::Cache::load(const string& directory)
+{
+  if (root.isSome()) {
+    return;
+  }
+
+  root = directory;
+
+  const string path = path::join(directory, CACHE_INDEX_FILE_NAME);
+  if (!os::exists(path)) {
+    return;
+  }
+
+  Result<FetcherCacheIndex> index = ::protobuf::read<FetcherCacheIndex>(path);
+  if (!index.isSome()) {
+    LOG(WARNING) << "Failed to read the fetcher cache index '" << path << "': "
+                 << (index.isError() ? index.error() : "empty");
+    return;
+  }
+
+  filenameSerial = std::max<unsigned long>(
+      filenameSerial, index.get().serial());
+
+  foreach (const FetcherCacheIndex::Entry& checkpointed,
+           index.get().entries()) {
+    auto entry = shared_ptr<Cache::Entry>(new Cache::Entry(
+        checkpointed.key(),
+        checkpointed.directory(),
+        checkpointed.filename(),
+        checkpointed.uri()));
+
+    Try<Time> used = Time::create(checkpointed.last_used());
+    entry->used = used.isSome() ? used.get() : Clock::now();
+    entry->size = Bytes(checkpointed.size());
+    entry->complete();
+
+    table.put(entry->key, entry);
+    lruSortedEntries.push_back(entry);
+
+    claimSpace(entry->size);
+  }
+
+  LOG(INFO) << "Loaded " << table.size() << " fetcher cache entries";
+}
+
+
+void FetcherProcess::Cache::checkpoint()
+{
+  if (root.isNone()) {
+    return;
+  }
+
+  FetcherCacheIndex index;
+  index.set_serial(filenameSerial);
+
+  foreach (const shared_ptr<Cache::Entry>& entry, lruSortedEntries) {
+    // Only the entries that are completely downloaded are reusable.
+    if (!entry->completion().isReady()) {
+      continue;
+    }
+
+    FetcherCacheIndex::Entry* checkpointed = index.add_entries();
+    checkpointed->set_key(entry->key);
+    checkpointed->set_directory(entry->directory);
+    checkpointed->set_filename(entry->filename);
+    checkpointed->mutable_uri()->CopyFrom(entry->uri);
+    checkpointed->set_size(entry->size.bytes());
+    checkpointed->set_last_used(entry->used.secs());
+  }
+
+  const string path = path::join(root.get(), CACHE_INDEX_FILE_NAME);
+
+  Try<Nothing> checkpoint = state::checkpoint(path, index);
+  if (checkpoint.isError()) {
+    LOG(WARNING) << "Failed to checkpoint the fetcher cache index '" << path
+                 << "': " << checkpoint.error();
+  }
+}
+
+
 void FetcherProcess::Cache::setSpace(const Bytes& bytes)
 {
   if (space > 0) {
@@ -17,8 +17,10 @@
 #ifndef __SLAVE_CONTAINERIZER_FETCHER_HPP__
 #define __SLAVE_CONTAINERIZER_FETCHER_HPP__
 
+#include <deque>
 #include <list>
 #include <string>
+#include <utility>
 
 #include <mesos/mesos.hpp>
 #include <mesos/type_utils.hpp>
@@ -27,11 +29,17 @@
 
 #include <process/id.hpp>
 #include <process/future.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/subprocess.hpp>
+#include <process/time.hpp>
+
+#include <process/metrics/gauge.hpp>
+#include <process/metrics/timer.hpp>
 
 #include <stout/hashmap.hpp>
 
+#include "slave/constants.hpp"
 #include "slave/flags.hpp"
 
 namespace mesos {
@@ -83,6 +91,11 @@ public:
 
   virtual ~Fetcher();
 
+  // Validates the checkpointed index of the cache of the slave,
+  // removing the entries whose cache files were partially written or
+  // have disappeared, and the cache files that are not in the index.
+  // The fetcher loads the remaining entries on first use. The cache
+  // is cleared if its index cannot be read.
   // TODO(bernd-mesos): Inject these parameters at Fetcher creation time.
   // Then also inject the fetcher into the slave at creation time. Then
   // it will be possible to make this an instance method instead of a
@@ -114,7 +127,10 @@ private:
 class FetcherProcess : public process::Process<FetcherProcess>
 {
 public:
-  FetcherProcess() : ProcessBase(process::ID::generate("fetcher")) {}
+  FetcherProcess()
+    : ProcessBase(process::ID::generate("fetcher")),
+      metrics(*this),
+      downloads(0) {}
 
   virtual ~FetcherProcess();
 
@@ -139,6 +155,18 @@ public:
   // running on behalf of the given container ID, if any.
   void kill(const ContainerID& containerId);
 
+  struct Metrics
+  {
+    explicit Metrics(const FetcherProcess& process);
+    ~Metrics();
+
+    // The time to fetch the URIs of a container, timed by 'Fetcher'.
+    process::metrics::Timer<Milliseconds> fetch;
+
+    // The number of entries in the cache (and its index).
+    process::metrics::Gauge cache_entries;
+  } metrics;
+
   // Representation of the fetcher cache and its contents. There is
   // exactly one instance per instance of FetcherProcess. All methods
   // of Cache are to be executed on the latter to ensure atomicity of
@@ -152,10 +180,12 @@ public:
       Entry(
           const std::string& key,
           const std::string& directory,
-          const std::string& filename)
+          const std::string& filename,
+          const CommandInfo::URI& uri)
         : key(key),
           directory(directory),
           filename(filename),
+          uri(uri),
           size(0),
           referenceCount(0) {}
 
@@ -184,7 +214,16 @@ public:
       // that the slave flags get injected into the fetcher.
       Path path() { return Path(path::join(directory, filename)); }
 
-      // Uniquely identifies a user/URI combination.
+      // Returns the path of the directory into which the fetcher
+      // program extracts the file if it is an archive, which is then
+      // part of the entry, including its size.
+      Path extractedPath()
+      {
+        return Path(path().value + FETCHER_CACHE_EXTRACTED_SUFFIX);
+      }
+
+      // Uniquely identifies a user/URI combination, or the content of
+      // a URI with a checksum, which all users share.
       const std::string key;
 
       // Cache directory where this entry is stored.
@@ -196,11 +235,18 @@ public:
       // URI.
       const std::string filename;
 
+      // The URI the file was downloaded from, checkpointed in the
+      // index of the cache with the entry.
+      const CommandInfo::URI uri;
+
       // The expected size of the cache file. This field is set before
       // downloading. If the actual size of the downloaded file is
       // different a warning is logged and the field's value adjusted.
       Bytes size;
 
+      // The time of the last use of the entry.
+      process::Time used;
+
     private:
       // Concurrent fetch attempts can reference the same entry multiple
       // times.
@@ -239,6 +285,12 @@ public:
         const Option<std::string>& user,
         const std::string& uri);
 
+    // Retrieves the cache entry for the URI, which is the one for its
+    // checksum if it has one.
+    Option<std::shared_ptr<Entry>> get(
+        const Option<std::string>& user,
+        const CommandInfo::URI& uri);
+
     // Returns whether an entry for this user and URI is in the cache.
     bool contains(const Option<std::string>& user, const std::string& uri);
 
@@ -267,6 +319,13 @@ public:
     // Number of entries.
     size_t size();
 
+    // Loads the entries checkpointed in the index of the cache in
+    // 'directory', once, and checkpoints the index there from then on.
+    void load(const std::string& directory);
+
+    // Checkpoints the completed entries to the index of the cache.
+    void checkpoint();
+
   private:
     // Maximum storable number of bytes in the cache directory.
     Bytes space;
@@ -283,6 +342,9 @@ public:
 
     // Stores cache file entries sorted from LRU to MRU.
     std::list<std::shared_ptr<Entry>> lruSortedEntries;
+
+    // The directory of the index, once loaded.
+    Option<std::string> root;
   };
 
   // Public and virtual for mock testing.
@@ -312,6 +374,11 @@ public:
   Bytes availableCacheSpace();
 
 private:
+  double _cache_entries()
+  {
+    return static_cast<double>(cache.size());
+  }
+
   process::Future<Nothing> __fetch(
       const hashmap<CommandInfo::URI,
       Option<std::shared_ptr<Cache::Entry>>>& entries,
@@ -328,9 +395,26 @@ private:
       const Try<Bytes>& requestedSpace,
       const std::shared_ptr<Cache::Entry>& entry);
 
+  // Grants up to 'count' downloads to a run of the fetcher program,
+  // once at least one of 'flags.fetcher_max_concurrent_downloads' is
+  // not in use by the other runs.
+  process::Future<size_t> acquireDownloads(size_t count, const Flags& flags);
+
+  // Returns the downloads of a run that has terminated to the runs
+  // that wait for downloads.
+  void releaseDownloads(size_t count, const Flags& flags);
+
   Cache cache;
 
   hashmap<ContainerID, pid_t> subprocessPids;
+
+  // The number of downloads granted to the running fetcher programs.
+  size_t downloads;
+
+  // The runs that wait for downloads, in the order in which they
+  // asked for them, with the number of downloads they need.
+  std::deque<std::pair<size_t, process::Owned<process::Promise<size_t>>>>
+    waiters;
 };
 
 } // namespace slave {
@@ -51,7 +51,9 @@
 #include "slave/containerizer/mesos/isolators/posix/disk.hpp"
 
 #ifdef __linux__
+#include "slave/containerizer/mesos/isolators/cgroups/blkio.hpp"
 #include "slave/containerizer/mesos/isolators/cgroups/cpushare.hpp"
+#include "slave/containerizer/mesos/isolators/cgroups/cpuset.hpp"
 #include "slave/containerizer/mesos/isolators/cgroups/mem.hpp"
 #include "slave/containerizer/mesos/isolators/cgroups/perf_event.hpp"
 #endif
@@ -90,6 +92,7 @@ namespace slave {
 using mesos::modules::ModuleManager;
 
 using mesos::slave::ContainerLimitation;
+using mesos::slave::ContainerLogger;
 using mesos::slave::ContainerPrepareInfo;
 using mesos::slave::ContainerState;
 using mesos::slave::Isolator;
@@ -168,7 +171,9 @@ Try<MesosContainerizer*> MesosContainerizer::create(
     {"posix/disk", &PosixDiskIsolatorProcess::create},
 #ifdef __linux__
     {"cgroups/cpu", &CgroupsCpushareIsolatorProcess::create},
+    {"cgroups/cpuset", &CgroupsCpusetIsolatorProcess::create},
     {"cgroups/mem", &CgroupsMemIsolatorProcess::create},
+    {"cgroups/blkio", &CgroupsBlkioIsolatorProcess::create},
     {"cgroups/perf_event", &CgroupsPerfEventIsolatorProcess::create},
     {"namespaces/pid", &NamespacesPidIsolatorProcess::create},
 #endif
@@ -178,6 +183,7 @@ Try<MesosContainerizer*> MesosContainerizer::create(
   };
 
   vector<Owned<Isolator>> isolators;
+  vector<string> names;
 
   foreach (const string& type, strings::tokenize(isolation, ",")) {
     Owned<Isolator> isolator;
@@ -207,8 +213,10 @@ Try<MesosContainerizer*> MesosContainerizer::create(
     // prepared filesystem (e.g., any volume mounts are performed).
     if (strings::contains(type, "filesystem/")) {
       isolators.insert(isolators.begin(), isolator);
+      names.insert(names.begin(), type);
     } else {
       isolators.push_back(isolator);
+      names.push_back(type);
     }
   }
 
@@ -225,7 +233,7 @@ Try<MesosContainerizer*> MesosContainerizer::create(
     }
   } else {
     // Use Linux launcher if it is available, POSIX otherwise.
-    launcher = LinuxLauncher::available()
+    launcher = LinuxLauncher::available(flags_)
       ? LinuxLauncher::create(flags_)
       : PosixLauncher::create(flags_);
   }
@@ -241,12 +249,24 @@ Try<MesosContainerizer*> MesosContainerizer::create(
     return Error("Failed to create launcher: " + launcher.error());
   }
 
+  Try<ContainerLogger*> logger = createContainerLogger(flags_);
+  if (logger.isError()) {
+    return Error("Failed to create container logger: " + logger.error());
+  }
+
   return new MesosContainerizer(
       flags_,
       local,
       fetcher,
       Owned<Launcher>(launcher.get()),
-      isolators);
+      isolators,
+      names,
+      Owned<ContainerLogger>(logger.get()),
+#ifdef __linux__
+      provisioner.get());
+#else
+      None());
+#endif // __linux__
 }
 
 
@@ -255,13 +275,19 @@ MesosContainerizer::MesosContainerizer(
     bool local,
     Fetcher* fetcher,
     const Owned<Launcher>& launcher,
-    const vector<Owned<Isolator>>& isolators)
+    const vector<Owned<Isolator>>& isolators,
+    const vector<string>& isolatorNames,
+    const Owned<ContainerLogger>& logger,
+    const Option<Owned<Provisioner>>& provisioner)
   : process(new MesosContainerizerProcess(
       flags,
       local,
       fetcher,
       launcher,
-      isolators))
+      isolators,
+      isolatorNames,
+      logger,
+      provisioner))
 {
   spawn(process.get());
 }
@@ -377,6 +403,12 @@ Future<hashset<ContainerID>> MesosContainerizer::containers()
 }
 
 
+Future<bool> MesosContainerizer::pull(const Image& image)
+{
+  return dispatch(process.get(), &MesosContainerizerProcess::pull, image);
+}
+
+
 Future<Nothing> MesosContainerizerProcess::recover(
     const Option<state::SlaveState>& state)
 {
@@ -473,14 +505,19 @@ Future<Nothing> MesosContainerizerProcess::_recover(
     const list<ContainerState>& recoverable,
     const hashset<ContainerID>& orphans)
 {
-  list<Future<Nothing>> futures;
+  vector<Future<Nothing>> futures;
 
   // Then recover the isolators.
   foreach (const Owned<Isolator>& isolator, isolators) {
     futures.push_back(isolator->recover(recoverable, orphans));
   }
 
-  // If all isolators recover then continue.
+  // And the output of the executors.
+  foreach (const ContainerState& run, recoverable) {
+    futures.push_back(logger->recover(run.executor_info(), run.directory()));
+  }
+
+  // If all isolators and the logger recover then continue.
   return collect(futures)
     .then(defer(self(), &Self::__recover, recoverable, orphans));
 }
@@ -625,40 +662,52 @@ Future<bool> MesosContainerizerProcess::launch(
 
   containers_.put(containerId, Owned<Container>(container));
 
-  return prepare(containerId, executorInfo, directory, user)
-    .then(defer(self(),
-                &Self::_launch,
-                containerId,
-                executorInfo,
-                directory,
-                user,
-                slaveId,
-                slavePid,
-                checkpoint,
-                lambda::_1));
+  // NOTE: The output of local executors goes to the output of the
+  // slave, so the logger is not involved.
+  Future<bool> launch = prepare(containerId, executorInfo, directory, user)
+    .then(defer(self(), [=](
+        const list<Option<ContainerPrepareInfo>>& prepareInfos) {
+      Future<ContainerLogger::SubprocessInfo> subprocessInfo = local
+        ? ContainerLogger::SubprocessInfo(
+              Subprocess::FD(STDOUT_FILENO),
+              Subprocess::FD(STDERR_FILENO))
+        : logger->prepare(executorInfo, directory);
+
+      return subprocessInfo
+        .then(defer(self(),
+                    &Self::_launch,
+                    containerId,
+                    executorInfo,
+                    directory,
+                    user,
+                    slaveId,
+                    slavePid,
+                    checkpoint,
+                    prepareInfos,
+                    lambda::_1));
+    }));
+
+  metrics.container_launch.time(launch);
+
+  return launch;
 }
 
 
-static list<Option<ContainerPrepareInfo>> accumulate(
-    list<Option<ContainerPrepareInfo>> l,
-    const Option<ContainerPrepareInfo>& e)
+static Future<list<Option<ContainerPrepareInfo>>> _prepare(
+    const list<Future<Option<ContainerPrepareInfo>>>& futures)
 {
-  l.push_back(e);
-  return l;
-}
+  list<Option<ContainerPrepareInfo>> prepareInfos;
 
+  // Propagate the failure of the first isolator that failed.
+  foreach (const Future<Option<ContainerPrepareInfo>>& future, futures) {
+    if (!future.isReady()) {
+      return Failure(future.isFailed() ? future.failure() : "discarded");
+    }
 
-static Future<list<Option<ContainerPrepareInfo>>> _prepare(
-    const Owned<Isolator>& isolator,
-    const ContainerID& containerId,
-    const ExecutorInfo& executorInfo,
-    const string& directory,
-    const Option<string>& user,
-    const list<Option<ContainerPrepareInfo>> prepareInfos)
-{
-  // Propagate any failure.
-  return isolator->prepare(containerId, executorInfo, directory, user)
-    .then(lambda::bind(&accumulate, prepareInfos, lambda::_1));
+    prepareInfos.push_back(future.get());
+  }
+
+  return prepareInfos;
 }
 
 
@@ -670,23 +719,49 @@ Future<list<Option<ContainerPrepareInfo>>> MesosContainerizerProcess::prepare(
 {
   CHECK(containers_.contains(containerId));
 
-  // We prepare the isolators sequentially according to their ordering
-  // to permit basic dependency specification, e.g., preparing a
-  // filesystem isolator before other isolators.
-  Future<list<Option<ContainerPrepareInfo>>> f =
-    list<Option<ContainerPrepareInfo>>();
+  // We prepare the isolators according to their ordering to permit
+  // basic dependency specification, e.g., preparing a filesystem
+  // isolator before other isolators: an ordered isolator is prepared
+  // once all the isolators before it are. The isolators that are not
+  // ordered (see Isolator::ordered) are prepared right away, i.e.,
+  // concurrently with the others.
+  list<Future<Option<ContainerPrepareInfo>>> futures;
 
-  foreach (const Owned<Isolator>& isolator, isolators) {
-    // Chain together preparing each isolator.
-    f = f.then(lambda::bind(&_prepare,
-                            isolator,
-                            containerId,
-                            executorInfo,
-                            directory,
-                            user,
-                            lambda::_1));
+  for (size_t i = 0; i < isolators.size(); i++) {
+    const Owned<Isolator> isolator = isolators[i];
+
+    Option<process::metrics::Timer<Milliseconds>> timer;
+    if (i < metrics.isolator_prepare.size()) {
+      timer = metrics.isolator_prepare[i];
+    }
+
+    lambda::function<Future<Option<ContainerPrepareInfo>>()> start =
+      [=]() mutable {
+        Future<Option<ContainerPrepareInfo>> future =
+          isolator->prepare(containerId, executorInfo, directory, user);
+
+        if (timer.isSome()) {
+          timer->time(future);
+        }
+
+        return future;
+      };
+
+    if (!isolator->ordered() || futures.empty()) {
+      futures.push_back(start());
+    } else {
+      // Propagate any failure of the isolators before it.
+      futures.push_back(collect(futures).then(start));
+    }
   }
 
+  // NOTE: We wait for all the isolators even if one fails, so that
+  // destroy only cleans up the isolators once none is preparing.
+  Future<list<Option<ContainerPrepareInfo>>> f = await(futures)
+    .then(lambda::bind(&_prepare, lambda::_1));
+
+  metrics.container_prepare.time(f);
+
   containers_[containerId]->prepareInfos = f;
 
   return f;
@@ -722,13 +797,20 @@ Future<bool> MesosContainerizerProcess::_launch(
     const SlaveID& slaveId,
     const PID<Slave>& slavePid,
     bool checkpoint,
-    const list<Option<ContainerPrepareInfo>>& prepareInfos)
+    const list<Option<ContainerPrepareInfo>>& prepareInfos,
+    const ContainerLogger::SubprocessInfo& subprocessInfo)
 {
   if (!containers_.contains(containerId)) {
+    if (!local) {
+      closeOutput(subprocessInfo);
+    }
     return Failure("Container has been destroyed");
   }
 
   if (containers_[containerId]->state == DESTROYING) {
+    if (!local) {
+      closeOutput(subprocessInfo);
+    }
     return Failure("Container is currently being destroyed");
   }
 
@@ -738,6 +820,9 @@ Future<bool> MesosContainerizerProcess::_launch(
   foreach (const Option<ContainerPrepareInfo>& prepareInfo, prepareInfos) {
     if (prepareInfo.isSome() && prepareInfo.get().has_rootfs()) {
       if (rootfs.isSome()) {
+        if (!local) {
+          closeOutput(subprocessInfo);
+        }
         return Failure("Only one isolator should return the container rootfs");
       } else {
         rootfs = prepareInfo.get().rootfs();
@@ -819,20 +904,28 @@ Future<bool> MesosContainerizerProcess::_launch(
   argv[0] = MESOS_CONTAINERIZER;
   argv[1] = MesosContainerizerLaunch::NAME;
 
+  // NOTE: Forking is synchronous, so the timer cannot be running for
+  // another container.
+  metrics.container_fork.start();
+
   Try<pid_t> forked = launcher->fork(
       containerId,
       path::join(flags.launcher_dir, MESOS_CONTAINERIZER),
       argv,
       Subprocess::FD(STDIN_FILENO),
-      (local ? Subprocess::FD(STDOUT_FILENO)
-             : Subprocess::PATH(path::join(directory, "stdout"))),
-      (local ? Subprocess::FD(STDERR_FILENO)
-             : Subprocess::PATH(path::join(directory, "stderr"))),
+      subprocessInfo.out,
+      subprocessInfo.err,
       launchFlags,
       environment,
       None(),
       namespaces); // 'namespaces' will be ignored by PosixLauncher.
 
+  metrics.container_fork.stop();
+
+  if (!local) {
+    closeOutput(subprocessInfo);
+  }
+
   if (forked.isError()) {
     return Failure("Failed to fork executor: " + forked.error());
   }
@@ -900,13 +993,21 @@ Future<bool> MesosContainerizerProcess::isolate(
   // or destroy because we assume there are no dependencies in
   // isolation.
   list<Future<Nothing>> futures;
-  foreach (const Owned<Isolator>& isolator, isolators) {
-    futures.push_back(isolator->isolate(containerId, _pid));
+  for (size_t i = 0; i < isolators.size(); i++) {
+    Future<Nothing> future = isolators[i]->isolate(containerId, _pid);
+
+    if (i < metrics.isolator_isolate.size()) {
+      metrics.isolator_isolate[i].time(future);
+    }
+
+    futures.push_back(future);
   }
 
   // Wait for all isolators to complete.
   Future<list<Nothing>> future = collect(futures);
 
+  metrics.container_isolate.time(future);
+
   containers_[containerId]->isolation = future;
 
   return future.then([]() { return true; });
@@ -978,6 +1079,48 @@ Future<Nothing> MesosContainerizerProcess::update(
   // so that subsequent containerizer->update can be handled properly.
   container->resources = resources;
 
+  // Coalesce with the update that follows the one in progress, which
+  // will update the isolators with the latest resources.
+  if (container->coalesced.isSome()) {
+    return container->coalesced.get();
+  }
+
+  if (container->updating.isSome()) {
+    container->coalesced = container->updating.get()
+      .repair([](const Future<Nothing>&) { return Nothing(); })
+      .then(defer(self(), &Self::_update, containerId));
+
+    return container->coalesced.get();
+  }
+
+  return _update(containerId);
+}
+
+
+Future<Nothing> MesosContainerizerProcess::_update(
+    const ContainerID& containerId)
+{
+  if (!containers_.contains(containerId)) {
+    return Nothing();
+  }
+
+  const Owned<Container>& container = containers_[containerId];
+
+  container->coalesced = None();
+
+  if (container->state == DESTROYING) {
+    return Nothing();
+  }
+
+  // Skip the isolators, and thus the writes to the control files of
+  // the cgroups, if they already have these resources.
+  if (container->updated.isSome() &&
+      container->updated.get() == container->resources) {
+    return Nothing();
+  }
+
+  const Resources resources = container->resources;
+
   // Update each isolator.
   list<Future<Nothing>> futures;
   foreach (const Owned<Isolator>& isolator, isolators) {
@@ -985,8 +1128,42 @@ Future<Nothing> MesosContainerizerProcess::update(
   }
 
   // Wait for all isolators to complete.
-  return collect(futures)
+  Future<Nothing> future = collect(futures)
     .then([]() { return Nothing(); });
+
+  container->updating = future;
+
+  future.onAny(defer(
+      self(),
+      &Self::__update,
+      containerId,
+      resources,
+      lambda::_1));
+
+  return future;
+}
+
+
+void MesosContainerizerProcess::__update(
+    const ContainerID& containerId,
+    const Resources& resources,
+    const Future<Nothing>& future)
+{
+  if (!containers_.contains(containerId)) {
+    return;
+  }
+
+  const Owned<Container>& container = containers_[containerId];
+
+  container->updating = None();
+
+  // If any isolator failed, the next update goes to all isolators
+  // even if the resources do not change.
+  if (future.isReady()) {
+    container->updated = resources;
+  } else {
+    container->updated = None();
+  }
 }
 
 
@@ -996,7 +1173,7 @@ Future<Nothing> MesosContainerizerProcess::update(
 Future<ResourceStatistics> _usage(
     const ContainerID& containerId,
     const Option<Resources>& resources,
-    const list<Future<ResourceStatistics>>& statistics)
+    const vector<Future<ResourceStatistics>>& statistics)
 {
   ResourceStatistics result;
 
@@ -1038,7 +1215,7 @@ Future<ResourceStatistics> MesosContainerizerProcess::usage(
     return Failure("Unknown container: " + stringify(containerId));
   }
 
-  list<Future<ResourceStatistics>> futures;
+  vector<Future<ResourceStatistics>> futures;
   foreach (const Owned<Isolator>& isolator, isolators) {
     futures.push_back(isolator->usage(containerId));
   }
@@ -1120,8 +1297,11 @@ void MesosContainerizerProcess::_destroy(
     const ContainerID& containerId)
 {
   // Kill all processes then continue destruction.
-  launcher->destroy(containerId)
-    .onAny(defer(self(), &Self::__destroy, containerId, lambda::_1));
+  Future<Nothing> kill = launcher->destroy(containerId);
+
+  metrics.container_kill.time(kill);
+
+  kill.onAny(defer(self(), &Self::__destroy, containerId, lambda::_1));
 }
 
 
@@ -1294,17 +1474,68 @@ Future<hashset<ContainerID>> MesosContainerizerProcess::containers()
 }
 
 
-MesosContainerizerProcess::Metrics::Metrics()
+Future<bool> MesosContainerizerProcess::pull(const Image& image)
+{
+  if (provisioner.isNone()) {
+    return false;
+  }
+
+  return provisioner.get()->pull(image);
+}
+
+
+MesosContainerizerProcess::Metrics::Metrics(const vector<string>& isolators)
   : container_destroy_errors(
-        "containerizer/mesos/container_destroy_errors")
+        "containerizer/mesos/container_destroy_errors"),
+    container_launch(
+        "containerizer/mesos/container_launch", Hours(1)),
+    container_prepare(
+        "containerizer/mesos/container_prepare", Hours(1)),
+    container_fork(
+        "containerizer/mesos/container_fork", Hours(1)),
+    container_isolate(
+        "containerizer/mesos/container_isolate", Hours(1)),
+    container_kill(
+        "containerizer/mesos/container_kill", Hours(1))
 {
   process::metrics::add(container_destroy_errors);
+  process::metrics::add(container_launch);
+  process::metrics::add(container_prepare);
+  process::metrics::add(container_fork);
+  process::metrics::add(container_isolate);
+  process::metrics::add(container_kill);
+
+  foreach (const string& isolator, isolators) {
+    isolator_prepare.push_back(process::metrics::Timer<Milliseconds>(
+        "containerizer/mesos/isolators/" + isolator + "/prepare", Hours(1)));
+
+    isolator_isolate.push_back(process::metrics::Timer<Milliseconds>(
+        "containerizer/mesos/isolators/" + isolator + "/isolate", Hours(1)));
+
+    process::metrics::add(isolator_prepare.back());
+    process::metrics::add(isolator_isolate.back());
+  }
 }
 
 
 MesosContainerizerProcess::Metrics::~Metrics()
 {
   process::metrics::remove(container_destroy_errors);
+  process::metrics::remove(container_launch);
+  process::metrics::remove(container_prepare);
+  process::metrics::remove(container_fork);
+  process::metrics::remove(container_isolate);
+  process::metrics::remove(container_kill);
+
+  foreach (const process::metrics::Timer<Milliseconds>& timer,
+           isolator_prepare) {
+    process::metrics::remove(timer);
+  }
+
+  foreach (const process::metrics::Timer<Milliseconds>& timer,
+           isolator_isolate) {
+    process::metrics::remove(timer);
+  }
 }
 
 
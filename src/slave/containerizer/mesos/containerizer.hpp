@@ -18,21 +18,28 @@
 #define __MESOS_CONTAINERIZER_HPP__
 
 #include <list>
+#include <string>
 #include <vector>
 
+#include <mesos/slave/container_logger.hpp>
 #include <mesos/slave/isolator.hpp>
 
 #include <process/metrics/counter.hpp>
+#include <process/metrics/timer.hpp>
 
 #include <stout/hashmap.hpp>
 #include <stout/multihashmap.hpp>
 
 #include "slave/state.hpp"
 
+#include "slave/container_loggers/sandbox.hpp"
+
 #include "slave/containerizer/containerizer.hpp"
 
 #include "slave/containerizer/mesos/launcher.hpp"
 
+#include "slave/containerizer/mesos/provisioner/provisioner.hpp"
+
 namespace mesos {
 namespace internal {
 namespace slave {
@@ -50,12 +57,21 @@ public:
       bool local,
       Fetcher* fetcher);
 
+  // The names of the isolators, e.g., 'cgroups/cpu', are used for
+  // their metrics, which are only added if the names are given. The
+  // provisioner, if any, is used to pull images ahead of time.
   MesosContainerizer(
       const Flags& flags,
       bool local,
       Fetcher* fetcher,
       const process::Owned<Launcher>& launcher,
-      const std::vector<process::Owned<mesos::slave::Isolator>>& isolators);
+      const std::vector<process::Owned<mesos::slave::Isolator>>& isolators,
+      const std::vector<std::string>& isolatorNames =
+        std::vector<std::string>(),
+      const process::Owned<mesos::slave::ContainerLogger>& logger =
+        process::Owned<mesos::slave::ContainerLogger>(
+            new SandboxContainerLogger()),
+      const Option<process::Owned<Provisioner>>& provisioner = None());
 
   // Used for testing.
   MesosContainerizer(const process::Owned<MesosContainerizerProcess>& _process);
@@ -98,6 +114,8 @@ public:
 
   virtual process::Future<hashset<ContainerID>> containers();
 
+  virtual process::Future<bool> pull(const Image& image);
+
 private:
   process::Owned<MesosContainerizerProcess> process;
 };
@@ -112,12 +130,21 @@ public:
       bool _local,
       Fetcher* _fetcher,
       const process::Owned<Launcher>& _launcher,
-      const std::vector<process::Owned<mesos::slave::Isolator>>& _isolators)
+      const std::vector<process::Owned<mesos::slave::Isolator>>& _isolators,
+      const std::vector<std::string>& _isolatorNames =
+        std::vector<std::string>(),
+      const process::Owned<mesos::slave::ContainerLogger>& _logger =
+        process::Owned<mesos::slave::ContainerLogger>(
+            new SandboxContainerLogger()),
+      const Option<process::Owned<Provisioner>>& _provisioner = None())
     : flags(_flags),
       local(_local),
       fetcher(_fetcher),
       launcher(_launcher),
-      isolators(_isolators) {}
+      isolators(_isolators),
+      logger(_logger),
+      provisioner(_provisioner),
+      metrics(_isolatorNames) {}
 
   virtual ~MesosContainerizerProcess() {}
 
@@ -152,6 +179,8 @@ public:
 
   virtual process::Future<hashset<ContainerID>> containers();
 
+  virtual process::Future<bool> pull(const Image& image);
+
   // Made public for testing.
   void ___recover(
       const ContainerID& containerId,
@@ -187,12 +216,23 @@ private:
       const SlaveID& slaveId,
       const process::PID<Slave>& slavePid,
       bool checkpoint,
-      const std::list<Option<mesos::slave::ContainerPrepareInfo>>& scripts);
+      const std::list<Option<mesos::slave::ContainerPrepareInfo>>& scripts,
+      const mesos::slave::ContainerLogger::SubprocessInfo& subprocessInfo);
 
   process::Future<bool> isolate(
       const ContainerID& containerId,
       pid_t _pid);
 
+  // Updates the isolators with the latest resources of the container,
+  // unless they already have them.
+  process::Future<Nothing> _update(const ContainerID& containerId);
+
+  // Continues '_update()' once all isolators have been updated.
+  void __update(
+      const ContainerID& containerId,
+      const Resources& resources,
+      const process::Future<Nothing>& future);
+
   // Continues 'destroy()' once isolators has completed.
   void _destroy(const ContainerID& containerId);
 
@@ -235,6 +275,10 @@ private:
   Fetcher* fetcher;
   const process::Owned<Launcher> launcher;
   const std::vector<process::Owned<mesos::slave::Isolator>> isolators;
+  const process::Owned<mesos::slave::ContainerLogger> logger;
+
+  // The provisioner shared with the 'filesystem/linux' isolator.
+  const Option<process::Owned<Provisioner>> provisioner;
 
   enum State
   {
@@ -274,6 +318,18 @@ private:
     // ResourceStatistics limits in usage().
     Resources resources;
 
+    // The resources the isolators were last updated with, if any.
+    Option<Resources> updated;
+
+    // The update of the isolators in progress, if any, and the update
+    // that follows it. All the updates of the container that arrive
+    // while the isolators are being updated wait for the following
+    // update, which is coalesced to the latest resources. This avoids
+    // a round of cgroup writes per task when an executor launches
+    // many tasks at once.
+    Option<process::Future<Nothing>> updating;
+    Option<process::Future<Nothing>> coalesced;
+
     // The executor's working directory on the host.
     std::string directory;
 
@@ -284,10 +340,28 @@ private:
 
   struct Metrics
   {
-    Metrics();
+    explicit Metrics(const std::vector<std::string>& isolators);
     ~Metrics();
 
     process::metrics::Counter container_destroy_errors;
+
+    // The time of the phases of the launch of a container: the whole
+    // launch, preparing all the isolators, forking the executor with
+    // the launcher, and isolating it with all the isolators.
+    process::metrics::Timer<Milliseconds> container_launch;
+    process::metrics::Timer<Milliseconds> container_prepare;
+    process::metrics::Timer<Milliseconds> container_fork;
+    process::metrics::Timer<Milliseconds> container_isolate;
+
+    // The time the launcher takes to kill all the processes of a
+    // container when it is destroyed.
+    process::metrics::Timer<Milliseconds> container_kill;
+
+    // The time each isolator takes to prepare and to isolate a
+    // container, in the order of 'isolators'. These are empty if the
+    // names of the isolators are not known.
+    std::vector<process::metrics::Timer<Milliseconds>> isolator_prepare;
+    std::vector<process::metrics::Timer<Milliseconds>> isolator_isolate;
   } metrics;
 };
 
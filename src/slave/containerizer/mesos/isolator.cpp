@@ -45,6 +45,12 @@ MesosIsolator::~MesosIsolator()
 }
 
 
+bool MesosIsolator::ordered() const
+{
+  return process->ordered();
+}
+
+
 Future<Nothing> MesosIsolator::recover(
     const list<ContainerState>& state,
     const hashset<ContainerID>& orphans)
@@ -41,6 +41,8 @@ public:
   explicit MesosIsolator(process::Owned<MesosIsolatorProcess> process);
   virtual ~MesosIsolator();
 
+  virtual bool ordered() const;
+
   virtual process::Future<Nothing> recover(
       const std::list<mesos::slave::ContainerState>& states,
       const hashset<ContainerID>& orphans);
@@ -78,6 +80,10 @@ class MesosIsolatorProcess : public process::Process<MesosIsolatorProcess>
 public:
   virtual ~MesosIsolatorProcess() {}
 
+  // NOTE: This is called on the isolator directly rather than through
+  // a dispatch, so it must not depend on the state of the process.
+  virtual bool ordered() const { return true; }
+
   virtual process::Future<Nothing> recover(
       const std::list<mesos::slave::ContainerState>& states,
       const hashset<ContainerID>& orphans) = 0;
@@ -0,0 +1,614 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <stdint.h>
+
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+#include <algorithm>
+
+#include <process/defer.hpp>
+#include <process/pid.hpp>
+
+#include <stout/check.hpp>
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
+#include <stout/nothing.hpp>
+#include <stout/numify.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+#include <stout/try.hpp>
+
+#include "linux/cgroups.hpp"
+
+#include "slave/containerizer/mesos/isolators/cgroups/blkio.hpp"
+
+using namespace process;
+
+using std::list;
+using std::set;
+using std::string;
+using std::vector;
+
+using mesos::slave::ContainerLimitation;
+using mesos::slave::ContainerPrepareInfo;
+using mesos::slave::ContainerState;
+using mesos::slave::Isolator;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+typedef CgroupsBlkioIsolatorProcess::Limits Limits;
+
+
+// Returns the disk of the block device the path is on, or None if
+// the path is not on a block device (e.g., tmpfs). The limits can
+// only be set on whole disks, not on their partitions.
+static Result<dev_t> disk(const string& path)
+{
+  struct stat s;
+  if (::stat(path.c_str(), &s) < 0) {
+    return ErrnoError("Failed to stat '" + path + "'");
+  }
+
+  const string sysfs = path::join(
+      "/sys/dev/block",
+      stringify(major(s.st_dev)) + ":" + stringify(minor(s.st_dev)));
+
+  if (!os::exists(sysfs)) {
+    return None();
+  }
+
+  if (!os::exists(path::join(sysfs, "partition"))) {
+    return s.st_dev;
+  }
+
+  // The directory of a partition is in the one of its disk.
+  Try<string> read = os::read(path::join(sysfs, "..", "dev"));
+  if (read.isError()) {
+    return Error("Failed to read the disk of '" + sysfs + "': " + read.error());
+  }
+
+  const vector<string> numbers =
+    strings::split(strings::trim(read.get()), ":");
+
+  if (numbers.size() == 2) {
+    Try<unsigned int> _major = numify<unsigned int>(numbers[0]);
+    Try<unsigned int> _minor = numify<unsigned int>(numbers[1]);
+    if (_major.isSome() && _minor.isSome()) {
+      return makedev(_major.get(), _minor.get());
+    }
+  }
+
+  return Error("Invalid device '" + read.get() + "' of '" + sysfs + "'");
+}
+
+
+// Returns the weight and the limits set by the executor labels.
+static Try<Limits> limits(const ExecutorInfo& executorInfo)
+{
+  Limits limits;
+
+  if (!executorInfo.has_labels()) {
+    return limits;
+  }
+
+  foreach (const Label& label, executorInfo.labels().labels()) {
+    if (!label.has_value()) {
+      continue;
+    }
+
+    const string& key = label.key();
+    const string& value = label.value();
+
+    if (key == BLKIO_LABEL_WEIGHT) {
+      Try<uint16_t> weight = numify<uint16_t>(value);
+      if (weight.isError() ||
+          weight.get() < MIN_BLKIO_WEIGHT ||
+          weight.get() > MAX_BLKIO_WEIGHT) {
+        return Error(
+            "Invalid '" + key + "' label '" + value + "': the weight " +
+            "ranges from " + stringify(MIN_BLKIO_WEIGHT) + " to " +
+            stringify(MAX_BLKIO_WEIGHT));
+      }
+
+      limits.weight = weight.get();
+    } else if (key == BLKIO_LABEL_READ_BPS || key == BLKIO_LABEL_WRITE_BPS) {
+      Try<Bytes> bytes = Bytes::parse(value);
+      if (bytes.isError()) {
+        return Error(
+            "Invalid '" + key + "' label '" + value + "': " + bytes.error());
+      }
+
+      if (key == BLKIO_LABEL_READ_BPS) {
+        limits.readBps = bytes.get();
+      } else {
+        limits.writeBps = bytes.get();
+      }
+    } else if (key == BLKIO_LABEL_READ_IOPS ||
+               key == BLKIO_LABEL_WRITE_IOPS) {
+      Try<uint64_t> iops = numify<uint64_t>(value);
+      if (iops.isError()) {
+        return Error(
+            "Invalid '" + key + "' label '" + value + "': " + iops.error());
+      }
+
+      if (key == BLKIO_LABEL_READ_IOPS) {
+        limits.readIops = iops.get();
+      } else {
+        limits.writeIops = iops.get();
+      }
+    }
+  }
+
+  return limits;
+}
+
+
+// Sums the reads and the writes of the entries of the devices. The
+// totals are skipped, they are the sums of the entries already.
+static void sum(
+    const vector<cgroups::blkio::Value>& values,
+    uint64_t* read,
+    uint64_t* write)
+{
+  *read = 0;
+  *write = 0;
+
+  foreach (const cgroups::blkio::Value& value, values) {
+    if (value.device.isNone()) {
+      continue;
+    }
+
+    if (value.operation == "Read") {
+      *read += value.value;
+    } else if (value.operation == "Write") {
+      *write += value.value;
+    }
+  }
+}
+
+
+CgroupsBlkioIsolatorProcess::CgroupsBlkioIsolatorProcess(
+    const Flags& _flags,
+    const string& _hierarchy,
+    const Option<dev_t>& _device,
+    bool _weights)
+  : flags(_flags),
+    hierarchy(_hierarchy),
+    device(_device),
+    weights(_weights) {}
+
+
+Try<Isolator*> CgroupsBlkioIsolatorProcess::create(const Flags& flags)
+{
+  Try<string> hierarchy = cgroups::prepare(
+      flags.cgroups_hierarchy,
+      "blkio",
+      flags.cgroups_root);
+
+  if (hierarchy.isError()) {
+    return Error(
+        "Failed to prepare hierarchy for blkio subsystem: " +
+        hierarchy.error());
+  }
+
+  // Ensure that no other subsystem is attached to the hierarchy.
+  Try<set<string>> subsystems = cgroups::subsystems(hierarchy.get());
+  if (subsystems.isError()) {
+    return Error(
+        "Failed to get the list of attached subsystems for hierarchy " +
+        hierarchy.get());
+  } else if (subsystems.get().size() != 1) {
+    return Error(
+        "Unexpected subsystems found attached to the hierarchy " +
+        hierarchy.get());
+  }
+
+  Try<bool> weights = cgroups::exists(
+      hierarchy.get(),
+      flags.cgroups_root,
+      "blkio.weight");
+
+  if (weights.isError()) {
+    return Error("Failed to find 'blkio.weight': " + weights.error());
+  }
+
+  if (!weights.get()) {
+    LOG(WARNING) << "The I/O scheduler does not support weights, the "
+                 << "'blkio.weight' of the containers will not be set";
+  }
+
+  Result<dev_t> device = disk(flags.work_dir);
+  if (device.isError()) {
+    return Error(
+        "Failed to find the disk of '" + flags.work_dir + "': " +
+        device.error());
+  }
+
+  Option<dev_t> _device;
+  if (device.isSome()) {
+    _device = device.get();
+  } else {
+    LOG(WARNING) << "The work directory '" << flags.work_dir << "' is not "
+                 << "on a block device, the blkio limits of the "
+                 << "containers will not be set";
+  }
+
+  process::Owned<MesosIsolatorProcess> process(
+      new CgroupsBlkioIsolatorProcess(
+          flags, hierarchy.get(), _device, weights.get()));
+
+  return new MesosIsolator(process);
+}
+
+
+Future<Nothing> CgroupsBlkioIsolatorProcess::recover(
+    const list<ContainerState>& states,
+    const hashset<ContainerID>& orphans)
+{
+  foreach (const ContainerState& state, states) {
+    const ContainerID& containerId = state.container_id();
+    const string cgroup = path::join(flags.cgroups_root, containerId.value());
+
+    Try<bool> exists = cgroups::exists(hierarchy, cgroup);
+    if (exists.isError()) {
+      foreachvalue (Info* info, infos) {
+        delete info;
+      }
+      infos.clear();
+      return Failure(
+          "Failed to check cgroup for container " + stringify(containerId));
+    }
+
+    if (!exists.get()) {
+      // This may occur if the executor has exited and the isolator
+      // has destroyed the cgroup but the slave dies before noticing
+      // this. This will be detected when the containerizer tries to
+      // monitor the executor's pid.
+      LOG(WARNING) << "Couldn't find cgroup for container " << containerId;
+      continue;
+    }
+
+    // The limits are in the cgroup already, only the weight label is
+    // needed for the updates.
+    Try<Limits> _limits = limits(state.executor_info());
+    if (_limits.isError()) {
+      LOG(WARNING) << "Ignoring the blkio labels of container "
+                   << containerId << ": " << _limits.error();
+
+      _limits = Limits();
+    }
+
+    infos[containerId] = new Info(containerId, cgroup, _limits.get());
+  }
+
+  // Remove orphan cgroups.
+  Try<vector<string>> cgroups = cgroups::get(hierarchy, flags.cgroups_root);
+  if (cgroups.isError()) {
+    foreachvalue (Info* info, infos) {
+      delete info;
+    }
+    infos.clear();
+    return Failure(cgroups.error());
+  }
+
+  foreach (const string& cgroup, cgroups.get()) {
+    // Ignore the slave cgroup (see the --slave_subsystems flag).
+    // TODO(idownes): Remove this when the cgroups layout is
+    // updated, see MESOS-1185.
+    if (cgroup == path::join(flags.cgroups_root, "slave")) {
+      continue;
+    }
+
+    ContainerID containerId;
+    containerId.set_value(Path(cgroup).basename());
+
+    if (infos.contains(containerId)) {
+      continue;
+    }
+
+    // Known orphan cgroups will be destroyed by the containerizer
+    // using the normal cleanup path. See MESOS-2367 for details.
+    if (orphans.contains(containerId)) {
+      infos[containerId] = new Info(containerId, cgroup, Limits());
+      continue;
+    }
+
+    LOG(INFO) << "Removing unknown orphaned cgroup '"
+              << path::join("blkio", cgroup) << "'";
+
+    // We don't wait on the destroy as we don't want to block recovery.
+    cgroups::destroy(hierarchy, cgroup, cgroups::DESTROY_TIMEOUT);
+  }
+
+  return Nothing();
+}
+
+
+Future<Option<ContainerPrepareInfo>> CgroupsBlkioIsolatorProcess::prepare(
+    const ContainerID& containerId,
+    const ExecutorInfo& executorInfo,
+    const string& directory,
+    const Option<string>& user)
+{
+  if (infos.contains(containerId)) {
+    return Failure("Container has already been prepared");
+  }
+
+  Try<Limits> _limits = limits(executorInfo);
+  if (_limits.isError()) {
+    return Failure("Failed to prepare isolator: " + _limits.error());
+  }
+
+  Info* info = new Info(
+      containerId,
+      path::join(flags.cgroups_root, containerId.value()),
+      _limits.get());
+
+  infos[containerId] = info;
+
+  Try<bool> exists = cgroups::exists(hierarchy, info->cgroup);
+  if (exists.isError()) {
+    return Failure("Failed to prepare isolator: " + exists.error());
+  } else if (exists.get()) {
+    return Failure("Failed to prepare isolator: cgroup already exists");
+  }
+
+  Try<Nothing> create = cgroups::create(hierarchy, info->cgroup);
+  if (create.isError()) {
+    return Failure("Failed to prepare isolator: " + create.error());
+  }
+
+  // Chown the cgroup so the executor can create nested cgroups. Do
+  // not recurse so the control files are still owned by the slave
+  // user and thus cannot be changed by the executor.
+  if (user.isSome()) {
+    Try<Nothing> chown = os::chown(
+        user.get(),
+        path::join(hierarchy, info->cgroup),
+        false);
+    if (chown.isError()) {
+      return Failure("Failed to prepare isolator: " + chown.error());
+    }
+  }
+
+  const Limits& limits = info->limits;
+
+  if (device.isSome()) {
+    vector<std::pair<string, Option<uint64_t>>> throttles = {
+      {"blkio.throttle.read_bps_device",
+       limits.readBps.isSome()
+         ? Option<uint64_t>(limits.readBps.get().bytes())
+         : None()},
+      {"blkio.throttle.write_bps_device",
+       limits.writeBps.isSome()
+         ? Option<uint64_t>(limits.writeBps.get().bytes())
+         : None()},
+      {"blkio.throttle.read_iops_device", limits.readIops},
+      {"blkio.throttle.write_iops_device", limits.writeIops}};
+
+    foreach (const auto& throttle, throttles) {
+      if (throttle.second.isNone()) {
+        continue;
+      }
+
+      Try<Nothing> write = cgroups::blkio::throttle(
+          hierarchy,
+          info->cgroup,
+          throttle.first,
+          device.get(),
+          throttle.second.get());
+
+      if (write.isError()) {
+        return Failure(
+            "Failed to update '" + throttle.first + "': " + write.error());
+      }
+
+      LOG(INFO) << "Updated '" << throttle.first << "' to "
+                << throttle.second.get() << " for container " << containerId;
+    }
+  } else if (limits.readBps.isSome() ||
+             limits.writeBps.isSome() ||
+             limits.readIops.isSome() ||
+             limits.writeIops.isSome()) {
+    LOG(WARNING) << "Ignoring the blkio limits of container " << containerId
+                 << " as the work directory is not on a block device";
+  }
+
+  return update(containerId, executorInfo.resources())
+    .then([]() -> Future<Option<ContainerPrepareInfo>> {
+      return None();
+    });
+}
+
+
+Future<Nothing> CgroupsBlkioIsolatorProcess::isolate(
+    const ContainerID& containerId,
+    pid_t pid)
+{
+  if (!infos.contains(containerId)) {
+    return Failure("Unknown container");
+  }
+
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  CHECK_NONE(info->pid);
+  info->pid = pid;
+
+  Try<Nothing> assign = cgroups::assign(hierarchy, info->cgroup, pid);
+  if (assign.isError()) {
+    LOG(ERROR) << "Failed to assign container '" << info->containerId
+               << " to its own cgroup '"
+               << path::join(hierarchy, info->cgroup)
+               << "' : " << assign.error();
+
+    return Failure("Failed to isolate container: " + assign.error());
+  }
+
+  return Nothing();
+}
+
+
+Future<ContainerLimitation> CgroupsBlkioIsolatorProcess::watch(
+    const ContainerID& containerId)
+{
+  if (!infos.contains(containerId)) {
+    return Failure("Unknown container");
+  }
+
+  CHECK_NOTNULL(infos[containerId]);
+
+  return infos[containerId]->limitation.future();
+}
+
+
+Future<Nothing> CgroupsBlkioIsolatorProcess::update(
+    const ContainerID& containerId,
+    const Resources& resources)
+{
+  if (!infos.contains(containerId)) {
+    return Failure("Unknown container");
+  }
+
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  if (!weights) {
+    return Nothing();
+  }
+
+  uint16_t weight;
+
+  if (info->limits.weight.isSome()) {
+    weight = info->limits.weight.get();
+  } else if (resources.cpus().isSome()) {
+    weight = std::min(
+        std::max(
+            (uint64_t) (BLKIO_WEIGHT_PER_CPU * resources.cpus().get()),
+            (uint64_t) MIN_BLKIO_WEIGHT),
+        (uint64_t) MAX_BLKIO_WEIGHT);
+  } else {
+    return Nothing();
+  }
+
+  Try<Nothing> write = cgroups::blkio::weight(hierarchy, info->cgroup, weight);
+  if (write.isError()) {
+    return Failure("Failed to update 'blkio.weight': " + write.error());
+  }
+
+  LOG(INFO) << "Updated 'blkio.weight' to " << weight
+            << " for container " << containerId;
+
+  return Nothing();
+}
+
+
+Future<ResourceStatistics> CgroupsBlkioIsolatorProcess::usage(
+    const ContainerID& containerId)
+{
+  if (!infos.contains(containerId)) {
+    return Failure("Unknown container");
+  }
+
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  // The throttle statistics are kept whatever the I/O scheduler, and
+  // whether the container is throttled or not.
+  Try<vector<cgroups::blkio::Value>> bytes = cgroups::blkio::stat(
+      hierarchy, info->cgroup, "blkio.throttle.io_service_bytes");
+
+  if (bytes.isError()) {
+    return Failure(
+        "Failed to read 'blkio.throttle.io_service_bytes': " + bytes.error());
+  }
+
+  Try<vector<cgroups::blkio::Value>> ops = cgroups::blkio::stat(
+      hierarchy, info->cgroup, "blkio.throttle.io_serviced");
+
+  if (ops.isError()) {
+    return Failure(
+        "Failed to read 'blkio.throttle.io_serviced': " + ops.error());
+  }
+
+  uint64_t read;
+  uint64_t write;
+
+  ResourceStatistics result;
+
+  sum(bytes.get(), &read, &write);
+  result.set_blkio_read_bytes(read);
+  result.set_blkio_write_bytes(write);
+
+  sum(ops.get(), &read, &write);
+  result.set_blkio_read_ops(read);
+  result.set_blkio_write_ops(write);
+
+  return result;
+}
+
+
+Future<Nothing> CgroupsBlkioIsolatorProcess::cleanup(
+    const ContainerID& containerId)
+{
+  // Multiple calls may occur during test clean up.
+  if (!infos.contains(containerId)) {
+    VLOG(1) << "Ignoring cleanup request for unknown container: "
+            << containerId;
+
+    return Nothing();
+  }
+
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  return cgroups::destroy(hierarchy, info->cgroup, cgroups::DESTROY_TIMEOUT)
+    .onAny(defer(PID<CgroupsBlkioIsolatorProcess>(this),
+                &CgroupsBlkioIsolatorProcess::_cleanup,
+                containerId,
+                lambda::_1));
+}
+
+
+Future<Nothing> CgroupsBlkioIsolatorProcess::_cleanup(
+    const ContainerID& containerId,
+    const Future<Nothing>& future)
+{
+  if (!infos.contains(containerId)) {
+    return Failure("Unknown container");
+  }
+
+  CHECK_NOTNULL(infos[containerId]);
+
+  if (!future.isReady()) {
+    return Failure(
+        "Failed to clean up container " + stringify(containerId) +
+        " : " + (future.isFailed() ? future.failure() : "discarded"));
+  }
+
+  delete infos[containerId];
+  infos.erase(containerId);
+
+  return future;
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
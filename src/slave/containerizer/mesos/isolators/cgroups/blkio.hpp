@@ -0,0 +1,137 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef __BLKIO_ISOLATOR_HPP__
+#define __BLKIO_ISOLATOR_HPP__
+
+#include <sys/types.h>
+
+#include <string>
+
+#include <process/future.hpp>
+
+#include <stout/bytes.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/option.hpp>
+
+#include "slave/flags.hpp"
+
+#include "slave/containerizer/mesos/isolator.hpp"
+
+#include "slave/containerizer/mesos/isolators/cgroups/constants.hpp"
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// Use the Linux blkio cgroup controller to share the disk I/O between
+// the containers. The proportional weight of a container follows its
+// cpus, or the "blkio_weight" label of its executor. The executor
+// labels can also limit the bytes and the operations per second of
+// the container on the block device of the work directory.
+class CgroupsBlkioIsolatorProcess : public MesosIsolatorProcess
+{
+public:
+  static Try<mesos::slave::Isolator*> create(const Flags& flags);
+
+  virtual ~CgroupsBlkioIsolatorProcess() {}
+
+  virtual process::Future<Nothing> recover(
+      const std::list<mesos::slave::ContainerState>& states,
+      const hashset<ContainerID>& orphans);
+
+  virtual process::Future<Option<mesos::slave::ContainerPrepareInfo>> prepare(
+      const ContainerID& containerId,
+      const ExecutorInfo& executorInfo,
+      const std::string& directory,
+      const Option<std::string>& user);
+
+  virtual process::Future<Nothing> isolate(
+      const ContainerID& containerId,
+      pid_t pid);
+
+  virtual process::Future<mesos::slave::ContainerLimitation> watch(
+      const ContainerID& containerId);
+
+  virtual process::Future<Nothing> update(
+      const ContainerID& containerId,
+      const Resources& resources);
+
+  virtual process::Future<ResourceStatistics> usage(
+      const ContainerID& containerId);
+
+  virtual process::Future<Nothing> cleanup(
+      const ContainerID& containerId);
+
+  // The weight and the limits set by the labels of an executor.
+  struct Limits
+  {
+    Option<uint16_t> weight;
+    Option<Bytes> readBps;
+    Option<Bytes> writeBps;
+    Option<uint64_t> readIops;
+    Option<uint64_t> writeIops;
+  };
+
+private:
+  CgroupsBlkioIsolatorProcess(
+      const Flags& flags,
+      const std::string& hierarchy,
+      const Option<dev_t>& device,
+      bool weights);
+
+  process::Future<Nothing> _cleanup(
+      const ContainerID& containerId,
+      const process::Future<Nothing>& future);
+
+  struct Info
+  {
+    Info(const ContainerID& _containerId,
+         const std::string& _cgroup,
+         const Limits& _limits)
+      : containerId(_containerId),
+        cgroup(_cgroup),
+        limits(_limits) {}
+
+    const ContainerID containerId;
+    const std::string cgroup;
+    const Limits limits;
+    Option<pid_t> pid;
+
+    process::Promise<mesos::slave::ContainerLimitation> limitation;
+  };
+
+  const Flags flags;
+
+  const std::string hierarchy;
+
+  // The block device of the work directory, which the limits apply
+  // to, if it is a block device.
+  const Option<dev_t> device;
+
+  // Whether the I/O scheduler of the kernel supports weights.
+  const bool weights;
+
+  // TODO(bmahler): Use Owned<Info>.
+  hashmap<ContainerID, Info*> infos;
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __BLKIO_ISOLATOR_HPP__
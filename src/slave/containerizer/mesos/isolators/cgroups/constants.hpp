@@ -17,6 +17,8 @@
 #ifndef __CGROUPS_ISOLATOR_CONSTANTS_HPP__
 #define __CGROUPS_ISOLATOR_CONSTANTS_HPP__
 
+#include <string>
+
 #include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 
@@ -28,6 +30,7 @@ namespace slave {
 const uint64_t CPU_SHARES_PER_CPU = 1024;
 const uint64_t CPU_SHARES_PER_CPU_REVOCABLE = 10;
 const uint64_t MIN_CPU_SHARES = 2; // Linux constant.
+const uint64_t MAX_CPU_SHARES = 262144; // Linux constant.
 const Duration CPU_CFS_PERIOD = Milliseconds(100); // Linux default.
 const Duration MIN_CPU_CFS_QUOTA = Milliseconds(1);
 
@@ -35,6 +38,24 @@ const Duration MIN_CPU_CFS_QUOTA = Milliseconds(1);
 // Memory subsystem constants.
 const Bytes MIN_MEMORY = Megabytes(32);
 
+
+// Cpuset subsystem constants. The executors with this label get whole
+// cores of their own.
+const std::string CPUSET_LABEL_KEY = "cpuset";
+const std::string CPUSET_LABEL_EXCLUSIVE = "exclusive";
+
+// Blkio subsystem constants. The weight of a container follows its
+// cpus unless the label sets it. The limits are set by labels only,
+// e.g., "blkio_read_bps" = "50MB" or "blkio_write_iops" = "200".
+const uint16_t BLKIO_WEIGHT_PER_CPU = 100;
+const uint16_t MIN_BLKIO_WEIGHT = 10;
+const uint16_t MAX_BLKIO_WEIGHT = 1000;
+const std::string BLKIO_LABEL_WEIGHT = "blkio_weight";
+const std::string BLKIO_LABEL_READ_BPS = "blkio_read_bps";
+const std::string BLKIO_LABEL_WRITE_BPS = "blkio_write_bps";
+const std::string BLKIO_LABEL_READ_IOPS = "blkio_read_iops";
+const std::string BLKIO_LABEL_WRITE_IOPS = "blkio_write_iops";
+
 } // namespace slave {
 } // namespace internal {
 } // namespace mesos {
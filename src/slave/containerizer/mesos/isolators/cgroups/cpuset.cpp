@@ -0,0 +1,687 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#include <process/defer.hpp>
+#include <process/pid.hpp>
+
+#include <stout/check.hpp>
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
+#include <stout/nothing.hpp>
+#include <stout/numify.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+#include <stout/try.hpp>
+
+#include "linux/cgroups.hpp"
+
+#include "slave/containerizer/mesos/isolators/cgroups/cpuset.hpp"
+
+using namespace process;
+
+using std::list;
+using std::map;
+using std::pair;
+using std::set;
+using std::string;
+using std::vector;
+
+using mesos::slave::ContainerLimitation;
+using mesos::slave::ContainerPrepareInfo;
+using mesos::slave::ContainerState;
+using mesos::slave::Isolator;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+typedef CgroupsCpusetIsolatorProcess::Core Core;
+
+
+// Groups the given cpus into their physical cores using the topology
+// in sysfs. The NUMA node of a cpu is linked from its directory as
+// 'node<N>', which is missing on machines without NUMA.
+static Try<vector<Core>> topology(const set<unsigned int>& cpus)
+{
+  // The cores keyed by their package and their id in the package.
+  map<pair<unsigned int, unsigned int>, Core> cores;
+
+  foreach (unsigned int cpu, cpus) {
+    const string path =
+      path::join("/sys/devices/system/cpu", "cpu" + stringify(cpu));
+
+    Try<string> package =
+      os::read(path::join(path, "topology", "physical_package_id"));
+
+    if (package.isError()) {
+      return Error(
+          "Failed to read the package of cpu " + stringify(cpu) +
+          ": " + package.error());
+    }
+
+    Try<string> core = os::read(path::join(path, "topology", "core_id"));
+    if (core.isError()) {
+      return Error(
+          "Failed to read the core of cpu " + stringify(cpu) +
+          ": " + core.error());
+    }
+
+    Try<unsigned int> _package =
+      numify<unsigned int>(strings::trim(package.get()));
+
+    Try<unsigned int> _core = numify<unsigned int>(strings::trim(core.get()));
+
+    if (_package.isError() || _core.isError()) {
+      return Error("Failed to parse the topology of cpu " + stringify(cpu));
+    }
+
+    unsigned int node = 0;
+
+    Try<list<string>> entries = os::ls(path);
+    if (entries.isError()) {
+      return Error("Failed to list '" + path + "': " + entries.error());
+    }
+
+    foreach (const string& entry, entries.get()) {
+      if (strings::startsWith(entry, "node")) {
+        Try<unsigned int> _node = numify<unsigned int>(entry.substr(4));
+        if (_node.isSome()) {
+          node = _node.get();
+          break;
+        }
+      }
+    }
+
+    Core& _cores = cores[std::make_pair(_package.get(), _core.get())];
+    _cores.node = node;
+    _cores.cpus.insert(cpu);
+  }
+
+  vector<Core> result;
+  foreachvalue (const Core& core, cores) {
+    result.push_back(core);
+  }
+
+  return result;
+}
+
+
+// Returns whether the executor asked for cores of its own.
+static bool exclusive(const ExecutorInfo& executorInfo)
+{
+  if (executorInfo.has_labels()) {
+    foreach (const Label& label, executorInfo.labels().labels()) {
+      if (label.key() == CPUSET_LABEL_KEY &&
+          label.has_value() &&
+          label.value() == CPUSET_LABEL_EXCLUSIVE) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+
+CgroupsCpusetIsolatorProcess::CgroupsCpusetIsolatorProcess(
+    const Flags& _flags,
+    const string& _hierarchy,
+    const vector<Core>& _cores,
+    const set<unsigned int>& _mems)
+  : flags(_flags),
+    hierarchy(_hierarchy),
+    cores(_cores),
+    mems(_mems),
+    owners(_cores.size()) {}
+
+
+Try<Isolator*> CgroupsCpusetIsolatorProcess::create(const Flags& flags)
+{
+  Try<string> hierarchy = cgroups::prepare(
+      flags.cgroups_hierarchy,
+      "cpuset",
+      flags.cgroups_root);
+
+  if (hierarchy.isError()) {
+    return Error(
+        "Failed to prepare hierarchy for cpuset subsystem: " +
+        hierarchy.error());
+  }
+
+  // Ensure that no other subsystem is attached to the hierarchy.
+  Try<set<string>> subsystems = cgroups::subsystems(hierarchy.get());
+  if (subsystems.isError()) {
+    return Error(
+        "Failed to get the list of attached subsystems for hierarchy " +
+        hierarchy.get());
+  } else if (subsystems.get().size() != 1) {
+    return Error(
+        "Unexpected subsystems found attached to the hierarchy " +
+        hierarchy.get());
+  }
+
+  // The containers are limited to the cpus and memory nodes of the
+  // root cgroup, which the cgroups of the containers inherit.
+  Try<set<unsigned int>> cpus =
+    cgroups::cpuset::cpus(hierarchy.get(), flags.cgroups_root);
+
+  if (cpus.isError()) {
+    return Error("Failed to get the cpus of the root cgroup: " + cpus.error());
+  }
+
+  Try<set<unsigned int>> mems =
+    cgroups::cpuset::mems(hierarchy.get(), flags.cgroups_root);
+
+  if (mems.isError()) {
+    return Error(
+        "Failed to get the memory nodes of the root cgroup: " + mems.error());
+  }
+
+  Try<vector<Core>> cores = topology(cpus.get());
+  if (cores.isError()) {
+    return Error("Failed to get the cpu topology: " + cores.error());
+  }
+
+  process::Owned<MesosIsolatorProcess> process(
+      new CgroupsCpusetIsolatorProcess(
+          flags, hierarchy.get(), cores.get(), mems.get()));
+
+  return new MesosIsolator(process);
+}
+
+
+Future<Nothing> CgroupsCpusetIsolatorProcess::recover(
+    const list<ContainerState>& states,
+    const hashset<ContainerID>& orphans)
+{
+  foreach (const ContainerState& state, states) {
+    const ContainerID& containerId = state.container_id();
+    const string cgroup = path::join(flags.cgroups_root, containerId.value());
+
+    Try<bool> exists = cgroups::exists(hierarchy, cgroup);
+    if (exists.isError()) {
+      foreachvalue (Info* info, infos) {
+        delete info;
+      }
+      infos.clear();
+      return Failure(
+          "Failed to check cgroup for container " + stringify(containerId));
+    }
+
+    if (!exists.get()) {
+      // This may occur if the executor has exited and the isolator
+      // has destroyed the cgroup but the slave dies before noticing
+      // this. This will be detected when the containerizer tries to
+      // monitor the executor's pid.
+      LOG(WARNING) << "Couldn't find cgroup for container " << containerId;
+      continue;
+    }
+
+    Info* info =
+      new Info(containerId, cgroup, exclusive(state.executor_info()));
+
+    infos[containerId] = info;
+
+    if (!info->exclusive) {
+      continue;
+    }
+
+    // The cores of an exclusive container are the ones of the cpus
+    // in its cgroup.
+    Try<set<unsigned int>> cpus = cgroups::cpuset::cpus(hierarchy, cgroup);
+    if (cpus.isError()) {
+      foreachvalue (Info* info, infos) {
+        delete info;
+      }
+      infos.clear();
+      return Failure(
+          "Failed to get the cpus of container " + stringify(containerId) +
+          ": " + cpus.error());
+    }
+
+    for (size_t i = 0; i < cores.size(); i++) {
+      if (std::includes(
+              cpus.get().begin(),
+              cpus.get().end(),
+              cores[i].cpus.begin(),
+              cores[i].cpus.end())) {
+        if (owners[i].isSome()) {
+          LOG(WARNING) << "Core " << i << " of container " << containerId
+                       << " is already given to container "
+                       << owners[i].get();
+          continue;
+        }
+
+        owners[i] = containerId;
+        info->cores.push_back(i);
+      }
+    }
+  }
+
+  // Remove orphan cgroups.
+  Try<vector<string>> cgroups = cgroups::get(hierarchy, flags.cgroups_root);
+  if (cgroups.isError()) {
+    foreachvalue (Info* info, infos) {
+      delete info;
+    }
+    infos.clear();
+    return Failure(cgroups.error());
+  }
+
+  foreach (const string& cgroup, cgroups.get()) {
+    // Ignore the slave cgroup (see the --slave_subsystems flag).
+    // TODO(idownes): Remove this when the cgroups layout is
+    // updated, see MESOS-1185.
+    if (cgroup == path::join(flags.cgroups_root, "slave")) {
+      continue;
+    }
+
+    ContainerID containerId;
+    containerId.set_value(Path(cgroup).basename());
+
+    if (infos.contains(containerId)) {
+      continue;
+    }
+
+    // Known orphan cgroups will be destroyed by the containerizer
+    // using the normal cleanup path. See MESOS-2367 for details. They
+    // keep sharing cores until then.
+    if (orphans.contains(containerId)) {
+      infos[containerId] = new Info(containerId, cgroup, false);
+      continue;
+    }
+
+    LOG(INFO) << "Removing unknown orphaned cgroup '"
+              << path::join("cpuset", cgroup) << "'";
+
+    // We don't wait on the destroy as we don't want to block recovery.
+    cgroups::destroy(hierarchy, cgroup, cgroups::DESTROY_TIMEOUT);
+  }
+
+  // Write the cores left by the recovered exclusive containers to
+  // all the other containers.
+  Try<Nothing> apply = this->apply(NULL);
+  if (apply.isError()) {
+    return Failure("Failed to recover the cpusets: " + apply.error());
+  }
+
+  return Nothing();
+}
+
+
+Future<Option<ContainerPrepareInfo>> CgroupsCpusetIsolatorProcess::prepare(
+    const ContainerID& containerId,
+    const ExecutorInfo& executorInfo,
+    const string& directory,
+    const Option<string>& user)
+{
+  if (infos.contains(containerId)) {
+    return Failure("Container has already been prepared");
+  }
+
+  Info* info = new Info(
+      containerId,
+      path::join(flags.cgroups_root, containerId.value()),
+      exclusive(executorInfo));
+
+  infos[containerId] = info;
+
+  Try<bool> exists = cgroups::exists(hierarchy, info->cgroup);
+  if (exists.isError()) {
+    return Failure("Failed to prepare isolator: " + exists.error());
+  } else if (exists.get()) {
+    return Failure("Failed to prepare isolator: cgroup already exists");
+  }
+
+  // The new cgroup gets all the cpus and memory nodes of the root
+  // cgroup, the update below narrows them down.
+  Try<Nothing> create = cgroups::create(hierarchy, info->cgroup);
+  if (create.isError()) {
+    return Failure("Failed to prepare isolator: " + create.error());
+  }
+
+  // Chown the cgroup so the executor can create nested cgroups. Do
+  // not recurse so the control files are still owned by the slave
+  // user and thus cannot be changed by the executor.
+  if (user.isSome()) {
+    Try<Nothing> chown = os::chown(
+        user.get(),
+        path::join(hierarchy, info->cgroup),
+        false);
+    if (chown.isError()) {
+      return Failure("Failed to prepare isolator: " + chown.error());
+    }
+  }
+
+  return update(containerId, executorInfo.resources())
+    .then([]() -> Future<Option<ContainerPrepareInfo>> {
+      return None();
+    });
+}
+
+
+Future<Nothing> CgroupsCpusetIsolatorProcess::isolate(
+    const ContainerID& containerId,
+    pid_t pid)
+{
+  if (!infos.contains(containerId)) {
+    return Failure("Unknown container");
+  }
+
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  CHECK_NONE(info->pid);
+  info->pid = pid;
+
+  Try<Nothing> assign = cgroups::assign(hierarchy, info->cgroup, pid);
+  if (assign.isError()) {
+    LOG(ERROR) << "Failed to assign container '" << info->containerId
+               << " to its own cgroup '"
+               << path::join(hierarchy, info->cgroup)
+               << "' : " << assign.error();
+
+    return Failure("Failed to isolate container: " + assign.error());
+  }
+
+  return Nothing();
+}
+
+
+Future<ContainerLimitation> CgroupsCpusetIsolatorProcess::watch(
+    const ContainerID& containerId)
+{
+  if (!infos.contains(containerId)) {
+    return Failure("Unknown container");
+  }
+
+  CHECK_NOTNULL(infos[containerId]);
+
+  return infos[containerId]->limitation.future();
+}
+
+
+Future<Nothing> CgroupsCpusetIsolatorProcess::update(
+    const ContainerID& containerId,
+    const Resources& resources)
+{
+  if (resources.cpus().isNone()) {
+    return Failure("No cpus resource given");
+  }
+
+  if (!infos.contains(containerId)) {
+    return Failure("Unknown container");
+  }
+
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  if (info->exclusive) {
+    // Whole cores cover the integral part of the cpus.
+    size_t cpus = std::max<size_t>(1, (size_t) resources.cpus().get());
+
+    Try<Nothing> assign = this->assign(info, cpus);
+    if (assign.isError()) {
+      return Failure(
+          "Failed to assign cores to container " + stringify(containerId) +
+          ": " + assign.error());
+    }
+  }
+
+  Try<Nothing> apply = this->apply(info);
+  if (apply.isError()) {
+    return Failure("Failed to update the cpusets: " + apply.error());
+  }
+
+  return Nothing();
+}
+
+
+Future<ResourceStatistics> CgroupsCpusetIsolatorProcess::usage(
+    const ContainerID& containerId)
+{
+  if (!infos.contains(containerId)) {
+    return Failure("Unknown container");
+  }
+
+  // The cpu usage is reported by the cgroups/cpu isolator.
+  return ResourceStatistics();
+}
+
+
+Future<Nothing> CgroupsCpusetIsolatorProcess::cleanup(
+    const ContainerID& containerId)
+{
+  // Multiple calls may occur during test clean up.
+  if (!infos.contains(containerId)) {
+    VLOG(1) << "Ignoring cleanup request for unknown container: "
+            << containerId;
+
+    return Nothing();
+  }
+
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  return cgroups::destroy(hierarchy, info->cgroup, cgroups::DESTROY_TIMEOUT)
+    .onAny(defer(PID<CgroupsCpusetIsolatorProcess>(this),
+                &CgroupsCpusetIsolatorProcess::_cleanup,
+                containerId,
+                lambda::_1));
+}
+
+
+Future<Nothing> CgroupsCpusetIsolatorProcess::_cleanup(
+    const ContainerID& containerId,
+    const Future<Nothing>& future)
+{
+  if (!infos.contains(containerId)) {
+    return Failure("Unknown container");
+  }
+
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  if (!future.isReady()) {
+    return Failure(
+        "Failed to clean up container " + stringify(containerId) +
+        " : " + (future.isFailed() ? future.failure() : "discarded"));
+  }
+
+  foreach (size_t core, info->cores) {
+    owners[core] = None();
+  }
+
+  delete info;
+  infos.erase(containerId);
+
+  // Give the cores back to the containers which share cores.
+  Try<Nothing> apply = this->apply(NULL);
+  if (apply.isError()) {
+    LOG(WARNING) << "Failed to release the cores of container "
+                 << containerId << ": " << apply.error();
+  }
+
+  return future;
+}
+
+
+Try<Nothing> CgroupsCpusetIsolatorProcess::assign(Info* info, size_t cpus)
+{
+  // The count of the cpus of the given cores.
+  auto count = [this](const vector<size_t>& indices) {
+    size_t result = 0;
+    foreach (size_t index, indices) {
+      result += cores[index].cpus.size();
+    }
+    return result;
+  };
+
+  // Work on copies, so nothing changes if there are not enough cores.
+  vector<Option<ContainerID>> owners = this->owners;
+  vector<size_t> assigned = info->cores;
+
+  // Release the cores which are not needed anymore, the last ones
+  // first.
+  while (!assigned.empty() &&
+         count(assigned) - cores[assigned.back()].cpus.size() >= cpus) {
+    owners[assigned.back()] = None();
+    assigned.pop_back();
+  }
+
+  while (count(assigned) < cpus) {
+    map<unsigned int, vector<size_t>> free;
+    size_t total = 0;
+
+    for (size_t i = 0; i < cores.size(); i++) {
+      if (owners[i].isNone()) {
+        free[cores[i].node].push_back(i);
+        total++;
+      }
+    }
+
+    // At least one core is always left to the containers which share
+    // cores.
+    if (total <= 1) {
+      return Error(
+          "Not enough free cores for " + stringify(cpus) + " cpus");
+    }
+
+    // Stay on the node of the cores of the container if possible.
+    // Otherwise prefer the node with the fewest free cpus which still
+    // cover the rest, and else the node with the most free cpus.
+    Option<unsigned int> node;
+
+    if (!assigned.empty() && free.count(cores[assigned.front()].node) > 0) {
+      node = cores[assigned.front()].node;
+    } else {
+      const size_t needed = cpus - count(assigned);
+
+      Option<unsigned int> fit;
+      Option<unsigned int> largest;
+
+      foreachpair (unsigned int _node, const vector<size_t>& indices, free) {
+        const size_t available = count(indices);
+
+        if (available >= needed &&
+            (fit.isNone() || available < count(free[fit.get()]))) {
+          fit = _node;
+        }
+
+        if (largest.isNone() || available > count(free[largest.get()])) {
+          largest = _node;
+        }
+      }
+
+      node = fit.isSome() ? fit : largest;
+    }
+
+    CHECK_SOME(node);
+
+    const size_t core = free[node.get()].front();
+    owners[core] = info->containerId;
+    assigned.push_back(core);
+  }
+
+  this->owners = owners;
+  info->cores = assigned;
+
+  return Nothing();
+}
+
+
+Try<Nothing> CgroupsCpusetIsolatorProcess::apply(Info* info)
+{
+  if (info != NULL && info->exclusive) {
+    set<unsigned int> cpus;
+    set<unsigned int> nodes;
+
+    foreach (size_t core, info->cores) {
+      cpus.insert(cores[core].cpus.begin(), cores[core].cpus.end());
+
+      if (mems.count(cores[core].node) > 0) {
+        nodes.insert(cores[core].node);
+      }
+    }
+
+    if (nodes.empty()) {
+      nodes = mems;
+    }
+
+    Try<Nothing> write = cgroups::cpuset::cpus(hierarchy, info->cgroup, cpus);
+    if (write.isError()) {
+      return Error("Failed to update 'cpuset.cpus': " + write.error());
+    }
+
+    // Move the memory of the container along to its nodes.
+    write = cgroups::write(
+        hierarchy, info->cgroup, "cpuset.memory_migrate", "1");
+
+    if (write.isError()) {
+      return Error("Failed to update 'cpuset.memory_migrate': " +
+                   write.error());
+    }
+
+    write = cgroups::cpuset::mems(hierarchy, info->cgroup, nodes);
+    if (write.isError()) {
+      return Error("Failed to update 'cpuset.mems': " + write.error());
+    }
+
+    LOG(INFO) << "Updated 'cpuset.cpus' to '" << cgroups::cpuset::format(cpus)
+              << "' and 'cpuset.mems' to '" << cgroups::cpuset::format(nodes)
+              << "' for container " << info->containerId;
+  }
+
+  set<unsigned int> shared;
+  for (size_t i = 0; i < cores.size(); i++) {
+    if (owners[i].isNone()) {
+      shared.insert(cores[i].cpus.begin(), cores[i].cpus.end());
+    }
+  }
+
+  // The containers which share cores only need a write when the
+  // shared cores change, or when they are new.
+  foreachvalue (Info* other, infos) {
+    if (other->exclusive || (shared == this->shared && other != info)) {
+      continue;
+    }
+
+    Try<Nothing> write =
+      cgroups::cpuset::cpus(hierarchy, other->cgroup, shared);
+
+    if (write.isError()) {
+      return Error("Failed to update 'cpuset.cpus': " + write.error());
+    }
+  }
+
+  if (shared != this->shared) {
+    LOG(INFO) << "Updated 'cpuset.cpus' to '"
+              << cgroups::cpuset::format(shared)
+              << "' for the containers which share cores";
+  }
+
+  this->shared = shared;
+
+  return Nothing();
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
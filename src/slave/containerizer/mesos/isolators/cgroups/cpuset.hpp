@@ -0,0 +1,155 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __CPUSET_ISOLATOR_HPP__
+#define __CPUSET_ISOLATOR_HPP__
+
+#include <sys/types.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <process/future.hpp>
+
+#include <stout/hashmap.hpp>
+#include <stout/option.hpp>
+
+#include "slave/flags.hpp"
+
+#include "slave/containerizer/mesos/isolator.hpp"
+
+#include "slave/containerizer/mesos/isolators/cgroups/constants.hpp"
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// Use the Linux cpuset cgroup controller to give whole cores to the
+// containers of the executors labeled with "cpuset" = "exclusive".
+// Such a container gets as many cores as it takes to cover the
+// integral part of its cpus (at least one). The cores are taken from
+// a single NUMA node where possible, and the memory of the container
+// is bound to the nodes of its cores. All the other containers share
+// the remaining cores, of which at least one is always kept.
+//
+// The cores of a container are kept in its cgroup, and whether it is
+// exclusive in its checkpointed executor info, so the assignment is
+// recovered when the agent restarts.
+class CgroupsCpusetIsolatorProcess : public MesosIsolatorProcess
+{
+public:
+  static Try<mesos::slave::Isolator*> create(const Flags& flags);
+
+  virtual ~CgroupsCpusetIsolatorProcess() {}
+
+  virtual process::Future<Nothing> recover(
+      const std::list<mesos::slave::ContainerState>& states,
+      const hashset<ContainerID>& orphans);
+
+  virtual process::Future<Option<mesos::slave::ContainerPrepareInfo>> prepare(
+      const ContainerID& containerId,
+      const ExecutorInfo& executorInfo,
+      const std::string& directory,
+      const Option<std::string>& user);
+
+  virtual process::Future<Nothing> isolate(
+      const ContainerID& containerId,
+      pid_t pid);
+
+  virtual process::Future<mesos::slave::ContainerLimitation> watch(
+      const ContainerID& containerId);
+
+  virtual process::Future<Nothing> update(
+      const ContainerID& containerId,
+      const Resources& resources);
+
+  virtual process::Future<ResourceStatistics> usage(
+      const ContainerID& containerId);
+
+  virtual process::Future<Nothing> cleanup(
+      const ContainerID& containerId);
+
+  // The hardware threads of a physical core, and its NUMA node.
+  struct Core
+  {
+    unsigned int node;
+    std::set<unsigned int> cpus;
+  };
+
+private:
+  CgroupsCpusetIsolatorProcess(
+      const Flags& flags,
+      const std::string& hierarchy,
+      const std::vector<Core>& cores,
+      const std::set<unsigned int>& mems);
+
+  process::Future<Nothing> _cleanup(
+      const ContainerID& containerId,
+      const process::Future<Nothing>& future);
+
+  struct Info
+  {
+    Info(const ContainerID& _containerId,
+         const std::string& _cgroup,
+         bool _exclusive)
+      : containerId(_containerId),
+        cgroup(_cgroup),
+        exclusive(_exclusive) {}
+
+    const ContainerID containerId;
+    const std::string cgroup;
+    const bool exclusive;
+    Option<pid_t> pid;
+
+    // The indices in 'cores' of the cores of an exclusive container.
+    std::vector<size_t> cores;
+
+    process::Promise<mesos::slave::ContainerLimitation> limitation;
+  };
+
+  // Assigns the cores covering 'cpus' cpus to the container, keeping
+  // the cores it already has where possible.
+  Try<Nothing> assign(Info* info, size_t cpus);
+
+  // Writes the cpus and memory nodes of an exclusive container, and
+  // the cpus left to the other containers to each of them.
+  Try<Nothing> apply(Info* info);
+
+  const Flags flags;
+
+  const std::string hierarchy;
+
+  const std::vector<Core> cores;
+
+  // The memory nodes of the root cgroup.
+  const std::set<unsigned int> mems;
+
+  // The container of each core, if given to an exclusive container.
+  std::vector<Option<ContainerID>> owners;
+
+  // The cpus last written to the containers which share cores.
+  std::set<unsigned int> shared;
+
+  // TODO(bmahler): Use Owned<Info>.
+  hashmap<ContainerID, Info*> infos;
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __CPUSET_ISOLATOR_HPP__
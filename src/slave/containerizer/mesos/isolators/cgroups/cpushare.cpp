@@ -57,17 +57,53 @@ namespace slave {
 CgroupsCpushareIsolatorProcess::CgroupsCpushareIsolatorProcess(
     const Flags& _flags,
     const hashmap<string, string>& _hierarchies,
-    const vector<string>& _subsystems)
+    const vector<string>& _subsystems,
+    const Option<string>& _unified)
   : flags(_flags),
     hierarchies(_hierarchies),
-    subsystems(_subsystems) {}
+    subsystems(_subsystems),
+    unified(_unified) {}
 
 
 CgroupsCpushareIsolatorProcess::~CgroupsCpushareIsolatorProcess() {}
 
 
+// Returns the 'cpu.weight' of the unified hierarchy which corresponds
+// to the given 'cpu.shares' of cgroups v1, mapping the range of the
+// shares, [2, 262144], onto the range of the weights, [1, 10000].
+static uint64_t weight(uint64_t shares)
+{
+  shares = std::min(std::max(shares, MIN_CPU_SHARES), MAX_CPU_SHARES);
+
+  return 1 +
+    ((shares - MIN_CPU_SHARES) * 9999) / (MAX_CPU_SHARES - MIN_CPU_SHARES);
+}
+
+
 Try<Isolator*> CgroupsCpushareIsolatorProcess::create(const Flags& flags)
 {
+  if (flags.cgroups_unified) {
+    Try<string> hierarchy = cgroups::unified::prepare(
+        path::join(flags.cgroups_hierarchy, "unified"),
+        flags.cgroups_root,
+        {"cpu"});
+
+    if (hierarchy.isError()) {
+      return Error(
+          "Failed to prepare unified hierarchy for cpu controller: " +
+          hierarchy.error());
+    }
+
+    process::Owned<MesosIsolatorProcess> process(
+        new CgroupsCpushareIsolatorProcess(
+            flags,
+            hashmap<string, string>(),
+            vector<string>(),
+            hierarchy.get()));
+
+    return new MesosIsolator(process);
+  }
+
   Try<string> hierarchyCpu = cgroups::prepare(
         flags.cgroups_hierarchy,
         "cpu",
@@ -170,7 +206,10 @@ Future<Nothing> CgroupsCpushareIsolatorProcess::recover(
     const ContainerID& containerId = state.container_id();
     const string cgroup = path::join(flags.cgroups_root, containerId.value());
 
-    Try<bool> exists = cgroups::exists(hierarchies["cpu"], cgroup);
+    Try<bool> exists = unified.isSome()
+      ? cgroups::unified::exists(unified.get(), cgroup)
+      : cgroups::exists(hierarchies["cpu"], cgroup);
+
     if (exists.isError()) {
       foreachvalue (Info* info, infos) {
         delete info;
@@ -192,6 +231,33 @@ Future<Nothing> CgroupsCpushareIsolatorProcess::recover(
     infos[containerId] = new Info(containerId, cgroup);
   }
 
+  // In the unified hierarchy, the cgroups of the containers are shared
+  // with the Linux launcher, which reports all the unknown ones as
+  // orphans, so only the known orphans are looked for.
+  if (unified.isSome()) {
+    Try<vector<string>> cgroups =
+      cgroups::unified::get(unified.get(), flags.cgroups_root);
+
+    if (cgroups.isError()) {
+      foreachvalue (Info* info, infos) {
+        delete info;
+      }
+      infos.clear();
+      return Failure(cgroups.error());
+    }
+
+    foreach (const string& cgroup, cgroups.get()) {
+      ContainerID containerId;
+      containerId.set_value(Path(cgroup).basename());
+
+      if (!infos.contains(containerId) && orphans.contains(containerId)) {
+        infos[containerId] = new Info(containerId, cgroup);
+      }
+    }
+
+    return Nothing();
+  }
+
   // Remove orphan cgroups.
   foreach (const string& subsystem, subsystems) {
     Try<vector<string>> cgroups = cgroups::get(
@@ -262,6 +328,29 @@ Future<Option<ContainerPrepareInfo>> CgroupsCpushareIsolatorProcess::prepare(
 
   infos[containerId] = info;
 
+  if (unified.isSome()) {
+    // The cgroup may have been created by the memory isolator already.
+    Try<Nothing> create =
+      cgroups::unified::create(unified.get(), info->cgroup, {"cpu"});
+
+    if (create.isError()) {
+      return Failure("Failed to prepare isolator: " + create.error());
+    }
+
+    // Chown the cgroup so the executor can create nested cgroups. Do
+    // not recurse so the control files are still owned by the slave
+    // user and thus cannot be changed by the executor.
+    if (user.isSome()) {
+      Try<Nothing> chown = os::chown(
+          user.get(),
+          path::join(unified.get(), info->cgroup),
+          false);
+      if (chown.isError()) {
+        return Failure("Failed to prepare isolator: " + chown.error());
+      }
+    }
+  }
+
   foreach (const string& subsystem, subsystems) {
     Try<bool> exists = cgroups::exists(hierarchies[subsystem], info->cgroup);
     if (exists.isError()) {
@@ -309,6 +398,18 @@ Future<Nothing> CgroupsCpushareIsolatorProcess::isolate(
   CHECK_NONE(info->pid);
   info->pid = pid;
 
+  // The Linux launcher has moved the process into the cgroup already,
+  // unless another launcher is used, in which case it is moved here.
+  // Moving a process into its own cgroup is a no-op.
+  if (unified.isSome()) {
+    Try<Nothing> assign =
+      cgroups::unified::assign(unified.get(), info->cgroup, pid);
+
+    if (assign.isError()) {
+      return Failure("Failed to isolate container: " + assign.error());
+    }
+  }
+
   foreach (const string& subsystem, subsystems) {
     Try<Nothing> assign = cgroups::assign(
         hierarchies[subsystem],
@@ -354,7 +455,9 @@ Future<Nothing> CgroupsCpushareIsolatorProcess::update(
     return Failure("Unknown container");
   }
 
-  const Option<string>& hierarchy = hierarchies.get("cpu");
+  const Option<string>& hierarchy =
+    unified.isSome() ? unified : hierarchies.get("cpu");
+
   if (hierarchy.isNone()) {
     return Failure("No 'cpu' hierarchy");
   }
@@ -364,7 +467,7 @@ Future<Nothing> CgroupsCpushareIsolatorProcess::update(
 
   double cpus = resources.cpus().get();
 
-  // Always set cpu.shares.
+  // Set cpu.shares, unless it already has the value.
   uint64_t shares;
 
   if (flags.revocable_cpu_low_priority &&
@@ -378,37 +481,82 @@ Future<Nothing> CgroupsCpushareIsolatorProcess::update(
         MIN_CPU_SHARES);
   }
 
-  Try<Nothing> write = cgroups::cpu::shares(
-      hierarchy.get(),
-      info->cgroup,
-      shares);
+  if (info->shares != shares && unified.isSome()) {
+    Try<Nothing> write = cgroups::unified::cpu::weight(
+        hierarchy.get(),
+        info->cgroup,
+        weight(shares));
 
-  if (write.isError()) {
-    return Failure("Failed to update 'cpu.shares': " + write.error());
-  }
+    if (write.isError()) {
+      return Failure("Failed to update 'cpu.weight': " + write.error());
+    }
 
-  LOG(INFO) << "Updated 'cpu.shares' to " << shares
-            << " (cpus " << cpus << ")"
-            << " for container " << containerId;
+    info->shares = shares;
+
+    LOG(INFO) << "Updated 'cpu.weight' to " << weight(shares)
+              << " (cpus " << cpus << ")"
+              << " for container " << containerId;
+  } else if (info->shares != shares) {
+    Try<Nothing> write = cgroups::cpu::shares(
+        hierarchy.get(),
+        info->cgroup,
+        shares);
+
+    if (write.isError()) {
+      return Failure("Failed to update 'cpu.shares': " + write.error());
+    }
+
+    info->shares = shares;
+
+    LOG(INFO) << "Updated 'cpu.shares' to " << shares
+              << " (cpus " << cpus << ")"
+              << " for container " << containerId;
+  }
 
   // Set cfs quota if enabled.
-  if (flags.cgroups_enable_cfs) {
-    write = cgroups::cpu::cfs_period_us(
+  Duration quota = std::max(CPU_CFS_PERIOD * cpus, MIN_CPU_CFS_QUOTA);
+
+  // The unified hierarchy sets the quota along with the period.
+  if (flags.cgroups_enable_cfs && info->quota != quota && unified.isSome()) {
+    Try<Nothing> write = cgroups::unified::cpu::max(
         hierarchy.get(),
         info->cgroup,
+        quota,
         CPU_CFS_PERIOD);
 
     if (write.isError()) {
-      return Failure("Failed to update 'cpu.cfs_period_us': " + write.error());
+      return Failure("Failed to update 'cpu.max': " + write.error());
+    }
+
+    info->quota = quota;
+
+    LOG(INFO) << "Updated 'cpu.max' to " << quota << " per "
+              << CPU_CFS_PERIOD << " (cpus " << cpus << ")"
+              << " for container " << containerId;
+  } else if (flags.cgroups_enable_cfs && info->quota != quota) {
+    // The period never changes, so it is only set along with the
+    // first quota.
+    if (info->quota.isNone()) {
+      Try<Nothing> write = cgroups::cpu::cfs_period_us(
+          hierarchy.get(),
+          info->cgroup,
+          CPU_CFS_PERIOD);
+
+      if (write.isError()) {
+        return Failure(
+            "Failed to update 'cpu.cfs_period_us': " + write.error());
+      }
     }
 
-    Duration quota = std::max(CPU_CFS_PERIOD * cpus, MIN_CPU_CFS_QUOTA);
+    Try<Nothing> write =
+      cgroups::cpu::cfs_quota_us(hierarchy.get(), info->cgroup, quota);
 
-    write = cgroups::cpu::cfs_quota_us(hierarchy.get(), info->cgroup, quota);
     if (write.isError()) {
       return Failure("Failed to update 'cpu.cfs_quota_us': " + write.error());
     }
 
+    info->quota = quota;
+
     LOG(INFO) << "Updated 'cpu.cfs_period_us' to " << CPU_CFS_PERIOD
               << " and 'cpu.cfs_quota_us' to " << quota
               << " (cpus " << cpus << ")"
@@ -419,6 +567,31 @@ Future<Nothing> CgroupsCpushareIsolatorProcess::update(
 }
 
 
+// Returns the control file of the cgroup of a container. The control
+// file is opened on first use and kept open in 'control', so that the
+// following reads of the usage do not have to reopen it.
+static Try<cgroups::Control*> openControl(
+    Owned<cgroups::Control>* control,
+    const string& hierarchy,
+    const string& cgroup,
+    const string& name,
+    bool unified = false)
+{
+  if (control->get() == NULL) {
+    Try<Owned<cgroups::Control>> open =
+      cgroups::Control::open(hierarchy, cgroup, name, unified);
+
+    if (open.isError()) {
+      return Error(open.error());
+    }
+
+    *control = open.get();
+  }
+
+  return control->get();
+}
+
+
 Future<ResourceStatistics> CgroupsCpushareIsolatorProcess::usage(
     const ContainerID& containerId)
 {
@@ -430,6 +603,10 @@ Future<ResourceStatistics> CgroupsCpushareIsolatorProcess::usage(
 
   ResourceStatistics result;
 
+  if (unified.isSome()) {
+    return _usage(containerId, result);
+  }
+
   // TODO(chzhcn): Getting the number of processes and threads is
   // available as long as any cgroup subsystem is used so this best
   // not be tied to a specific cgroup isolator. A better place is
@@ -465,20 +642,30 @@ Future<ResourceStatistics> CgroupsCpushareIsolatorProcess::usage(
 
   PCHECK(ticks > 0) << "Failed to get sysconf(_SC_CLK_TCK)";
 
-  // Add the cpuacct.stat information.
-  Try<hashmap<string, uint64_t>> stat = cgroups::stat(
+  // Add the cpuacct.stat information. The control files are kept
+  // open across the calls, see 'openControl' above.
+  Try<cgroups::Control*> control = openControl(
+      &info->cpuacctStat,
       hierarchies["cpuacct"],
       info->cgroup,
       "cpuacct.stat");
 
-  if (stat.isError()) {
-    return Failure("Failed to read cpuacct.stat: " + stat.error());
+  if (control.isError()) {
+    return Failure("Failed to open cpuacct.stat: " + control.error());
   }
 
   // TODO(bmahler): Add namespacing to cgroups to enforce the expected
   // structure, e.g., cgroups::cpuacct::stat.
-  Option<uint64_t> user = stat.get().get("user");
-  Option<uint64_t> system = stat.get().get("system");
+  Option<uint64_t> user;
+  Option<uint64_t> system;
+
+  Try<Nothing> stat = control.get()->stat({
+      {"user", &user},
+      {"system", &system}});
+
+  if (stat.isError()) {
+    return Failure("Failed to read cpuacct.stat: " + stat.error());
+  }
 
   if (user.isSome() && system.isSome()) {
     result.set_cpus_user_time_secs((double) user.get() / (double) ticks);
@@ -487,22 +674,34 @@ Future<ResourceStatistics> CgroupsCpushareIsolatorProcess::usage(
 
   // Add the cpu.stat information only if CFS is enabled.
   if (flags.cgroups_enable_cfs) {
-    stat = cgroups::stat(hierarchies["cpu"], info->cgroup, "cpu.stat");
+    control = openControl(
+        &info->cpuStat, hierarchies["cpu"], info->cgroup, "cpu.stat");
+
+    if (control.isError()) {
+      return Failure("Failed to open cpu.stat: " + control.error());
+    }
+
+    Option<uint64_t> nr_periods;
+    Option<uint64_t> nr_throttled;
+    Option<uint64_t> throttled_time;
+
+    stat = control.get()->stat({
+        {"nr_periods", &nr_periods},
+        {"nr_throttled", &nr_throttled},
+        {"throttled_time", &throttled_time}});
+
     if (stat.isError()) {
       return Failure("Failed to read cpu.stat: " + stat.error());
     }
 
-    Option<uint64_t> nr_periods = stat.get().get("nr_periods");
     if (nr_periods.isSome()) {
       result.set_cpus_nr_periods(nr_periods.get());
     }
 
-    Option<uint64_t> nr_throttled = stat.get().get("nr_throttled");
     if (nr_throttled.isSome()) {
       result.set_cpus_nr_throttled(nr_throttled.get());
     }
 
-    Option<uint64_t> throttled_time = stat.get().get("throttled_time");
     if (throttled_time.isSome()) {
       result.set_cpus_throttled_time_secs(
           Nanoseconds(throttled_time.get()).secs());
@@ -513,6 +712,104 @@ Future<ResourceStatistics> CgroupsCpushareIsolatorProcess::usage(
 }
 
 
+// Returns the usage of a container in the unified hierarchy, where
+// 'cpu.stat' has the cpu times in microseconds, and 'cpu.pressure'
+// the pressure stall information.
+Future<ResourceStatistics> CgroupsCpushareIsolatorProcess::_usage(
+    const ContainerID& containerId,
+    ResourceStatistics result)
+{
+  CHECK_SOME(unified);
+
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  if (flags.cgroups_cpu_enable_pids_and_tids_count) {
+    Try<std::set<pid_t>> pids =
+      cgroups::unified::processes(unified.get(), info->cgroup);
+    if (pids.isError()) {
+      return Failure("Failed to get number of processes: " + pids.error());
+    }
+
+    result.set_processes(pids.get().size());
+
+    Try<std::set<pid_t>> tids =
+      cgroups::unified::threads(unified.get(), info->cgroup);
+    if (tids.isError()) {
+      return Failure("Failed to get number of threads: " + tids.error());
+    }
+
+    result.set_threads(tids.get().size());
+  }
+
+  Try<cgroups::Control*> control = openControl(
+      &info->cpuStat, unified.get(), info->cgroup, "cpu.stat", true);
+
+  if (control.isError()) {
+    return Failure("Failed to open cpu.stat: " + control.error());
+  }
+
+  Option<uint64_t> user_usec;
+  Option<uint64_t> system_usec;
+  Option<uint64_t> nr_periods;
+  Option<uint64_t> nr_throttled;
+  Option<uint64_t> throttled_usec;
+
+  Try<Nothing> stat = control.get()->stat({
+      {"user_usec", &user_usec},
+      {"system_usec", &system_usec},
+      {"nr_periods", &nr_periods},
+      {"nr_throttled", &nr_throttled},
+      {"throttled_usec", &throttled_usec}});
+
+  if (stat.isError()) {
+    return Failure("Failed to read cpu.stat: " + stat.error());
+  }
+
+  if (user_usec.isSome() && system_usec.isSome()) {
+    result.set_cpus_user_time_secs(Microseconds(user_usec.get()).secs());
+    result.set_cpus_system_time_secs(Microseconds(system_usec.get()).secs());
+  }
+
+  // The throttling statistics are only meaningful if CFS is enabled.
+  if (flags.cgroups_enable_cfs) {
+    if (nr_periods.isSome()) {
+      result.set_cpus_nr_periods(nr_periods.get());
+    }
+
+    if (nr_throttled.isSome()) {
+      result.set_cpus_nr_throttled(nr_throttled.get());
+    }
+
+    if (throttled_usec.isSome()) {
+      result.set_cpus_throttled_time_secs(
+          Microseconds(throttled_usec.get()).secs());
+    }
+  }
+
+  // The kernel may not support PSI, or have it disabled.
+  control = openControl(
+      &info->cpuPressure, unified.get(), info->cgroup, "cpu.pressure", true);
+
+  if (control.isSome()) {
+    Try<Nothing> read = control.get()->read();
+    if (read.isError()) {
+      return Failure("Failed to read cpu.pressure: " + read.error());
+    }
+
+    Try<cgroups::unified::Pressure> pressure =
+      cgroups::unified::Pressure::parse(control.get()->contents());
+
+    if (pressure.isError()) {
+      return Failure("Failed to parse cpu.pressure: " + pressure.error());
+    }
+
+    result.set_cpus_pressure_some_total_secs(pressure.get().some.total.secs());
+  }
+
+  return result;
+}
+
+
 Future<Nothing> CgroupsCpushareIsolatorProcess::cleanup(
     const ContainerID& containerId)
 {
@@ -527,6 +824,25 @@ Future<Nothing> CgroupsCpushareIsolatorProcess::cleanup(
   Info* info = CHECK_NOTNULL(infos[containerId]);
 
   list<Future<Nothing>> futures;
+
+  // In the unified hierarchy, the Linux launcher has destroyed the
+  // cgroup already, unless another launcher is used.
+  if (unified.isSome()) {
+    Try<bool> exists = cgroups::unified::exists(unified.get(), info->cgroup);
+    if (exists.isError()) {
+      return Failure(
+          "Failed to check cgroup for container " + stringify(containerId) +
+          ": " + exists.error());
+    }
+
+    if (exists.get()) {
+      futures.push_back(cgroups::unified::destroy(
+          unified.get(),
+          info->cgroup,
+          cgroups::DESTROY_TIMEOUT));
+    }
+  }
+
   foreach (const string& subsystem, subsystems) {
     futures.push_back(cgroups::destroy(
         hierarchies[subsystem],
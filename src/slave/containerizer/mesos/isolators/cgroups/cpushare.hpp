@@ -23,10 +23,14 @@
 #include <vector>
 
 #include <process/future.hpp>
+#include <process/owned.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/option.hpp>
 
+#include "linux/cgroups.hpp"
+
 #include "slave/flags.hpp"
 
 #include "slave/containerizer/mesos/isolator.hpp"
@@ -41,6 +45,10 @@ namespace slave {
 // Completely Fair Scheduler (CFS).
 // - cpushare implements proportionally weighted scheduling.
 // - cfs implements hard quota based scheduling.
+// If the '--cgroups_unified' flag is set, the isolator uses the cpu
+// controller of the unified hierarchy (cgroups v2), in the cgroup of
+// the container that it shares with the Linux launcher and the memory
+// isolator.
 class CgroupsCpushareIsolatorProcess : public MesosIsolatorProcess
 {
 public:
@@ -48,6 +56,8 @@ public:
 
   virtual ~CgroupsCpushareIsolatorProcess();
 
+  virtual bool ordered() const { return false; }
+
   virtual process::Future<Nothing> recover(
       const std::list<mesos::slave::ContainerState>& states,
       const hashset<ContainerID>& orphans);
@@ -79,7 +89,12 @@ private:
   CgroupsCpushareIsolatorProcess(
       const Flags& flags,
       const hashmap<std::string, std::string>& hierarchies,
-      const std::vector<std::string>& subsystems);
+      const std::vector<std::string>& subsystems,
+      const Option<std::string>& unified = None());
+
+  process::Future<ResourceStatistics> _usage(
+      const ContainerID& containerId,
+      ResourceStatistics result);
 
   virtual process::Future<std::list<Nothing>> _cleanup(
       const ContainerID& containerId,
@@ -95,7 +110,17 @@ private:
     Option<pid_t> pid;
     Option<Resources> resources;
 
+    // The values last written to 'cpu.shares' and 'cpu.cfs_quota_us',
+    // so that updates which do not change them skip the writes.
+    Option<uint64_t> shares;
+    Option<Duration> quota;
+
     process::Promise<mesos::slave::ContainerLimitation> limitation;
+
+    // The control files read by 'usage', which are kept open.
+    process::Owned<cgroups::Control> cpuacctStat;
+    process::Owned<cgroups::Control> cpuStat;
+    process::Owned<cgroups::Control> cpuPressure;
   };
 
   const Flags flags;
@@ -109,6 +134,10 @@ private:
   // will be only one element in the vector which is 'cpu,cpuacct'.
   std::vector<std::string> subsystems;
 
+  // The unified hierarchy, if the '--cgroups_unified' flag is set. The
+  // 'hierarchies' and 'subsystems' are empty then.
+  const Option<std::string> unified;
+
   // TODO(bmahler): Use Owned<Info>.
   hashmap<ContainerID, Info*> infos;
 };
@@ -71,10 +71,12 @@ static const vector<Level> levels()
 CgroupsMemIsolatorProcess::CgroupsMemIsolatorProcess(
     const Flags& _flags,
     const string& _hierarchy,
-    const bool _limitSwap)
+    const bool _limitSwap,
+    const bool _unified)
   : flags(_flags),
     hierarchy(_hierarchy),
-    limitSwap(_limitSwap) {}
+    limitSwap(_limitSwap),
+    unified(_unified) {}
 
 
 CgroupsMemIsolatorProcess::~CgroupsMemIsolatorProcess() {}
@@ -82,6 +84,44 @@ CgroupsMemIsolatorProcess::~CgroupsMemIsolatorProcess() {}
 
 Try<Isolator*> CgroupsMemIsolatorProcess::create(const Flags& flags)
 {
+  if (flags.cgroups_unified) {
+    // The unified hierarchy has no memory pressure notifications to
+    // reclaim the revocable memory on.
+    if (flags.cgroups_reclaim_revocable_memory) {
+      return Error(
+          "The '--cgroups_reclaim_revocable_memory' flag is not supported "
+          "with '--cgroups_unified'");
+    }
+
+    Try<string> hierarchy = cgroups::unified::prepare(
+        path::join(flags.cgroups_hierarchy, "unified"),
+        flags.cgroups_root,
+        {"memory"});
+
+    if (hierarchy.isError()) {
+      return Error(
+          "Failed to prepare unified hierarchy for memory controller: " +
+          hierarchy.error());
+    }
+
+    // There is no 'memory.swap.max' for the root cgroup, so swap
+    // accounting is checked on the cgroups root.
+    if (flags.cgroups_limit_swap &&
+        !os::exists(path::join(
+            hierarchy.get(), flags.cgroups_root, "memory.swap.max"))) {
+      return Error("'memory.swap.max' is not available");
+    }
+
+    process::Owned<MesosIsolatorProcess> process(
+        new CgroupsMemIsolatorProcess(
+            flags,
+            hierarchy.get(),
+            flags.cgroups_limit_swap,
+            true));
+
+    return new MesosIsolator(process);
+  }
+
   Try<string> hierarchy = cgroups::prepare(
       flags.cgroups_hierarchy,
       "memory",
@@ -163,7 +203,10 @@ Future<Nothing> CgroupsMemIsolatorProcess::recover(
     const ContainerID& containerId = state.container_id();
     const string cgroup = path::join(flags.cgroups_root, containerId.value());
 
-    Try<bool> exists = cgroups::exists(hierarchy, cgroup);
+    Try<bool> exists = unified
+      ? cgroups::unified::exists(hierarchy, cgroup)
+      : cgroups::exists(hierarchy, cgroup);
+
     if (exists.isError()) {
       foreachvalue (Info* info, infos) {
         delete info;
@@ -189,7 +232,10 @@ Future<Nothing> CgroupsMemIsolatorProcess::recover(
   }
 
   // Remove orphan cgroups.
-  Try<vector<string>> cgroups = cgroups::get(hierarchy, flags.cgroups_root);
+  Try<vector<string>> cgroups = unified
+    ? cgroups::unified::get(hierarchy, flags.cgroups_root)
+    : cgroups::get(hierarchy, flags.cgroups_root);
+
   if (cgroups.isError()) {
     foreachvalue (Info* info, infos) {
       delete info;
@@ -220,6 +266,13 @@ Future<Nothing> CgroupsMemIsolatorProcess::recover(
       continue;
     }
 
+    // In the unified hierarchy, the cgroups of the containers are
+    // shared with the Linux launcher, which reports all the unknown
+    // ones as orphans to the containerizer.
+    if (unified) {
+      continue;
+    }
+
     LOG(INFO) << "Removing unknown orphaned cgroup '" << cgroup << "'";
 
     // We don't wait on the destroy as we don't want to block recovery.
@@ -249,16 +302,22 @@ Future<Option<ContainerPrepareInfo>> CgroupsMemIsolatorProcess::prepare(
 
   infos[containerId] = info;
 
-  // Create a cgroup for this container.
-  Try<bool> exists = cgroups::exists(hierarchy, info->cgroup);
+  // Create a cgroup for this container. The cgroup in the unified
+  // hierarchy may have been created by the cpu isolator already.
+  Try<bool> exists = unified
+    ? cgroups::unified::exists(hierarchy, info->cgroup)
+    : cgroups::exists(hierarchy, info->cgroup);
 
   if (exists.isError()) {
     return Failure("Failed to prepare isolator: " + exists.error());
-  } else if (exists.get()) {
+  } else if (exists.get() && !unified) {
     return Failure("Failed to prepare isolator: cgroup already exists");
   }
 
-  Try<Nothing> create = cgroups::create(hierarchy, info->cgroup);
+  Try<Nothing> create = unified
+    ? cgroups::unified::create(hierarchy, info->cgroup, {"memory"})
+    : cgroups::create(hierarchy, info->cgroup);
+
   if (create.isError()) {
     return Failure("Failed to prepare isolator: " + create.error());
   }
@@ -277,7 +336,10 @@ Future<Option<ContainerPrepareInfo>> CgroupsMemIsolatorProcess::prepare(
   }
 
   oomListen(containerId);
-  pressureListen(containerId);
+
+  if (!unified) {
+    pressureListen(containerId);
+  }
 
   return update(containerId, executorInfo.resources())
     .then([]() -> Future<Option<ContainerPrepareInfo>> {
@@ -299,7 +361,12 @@ Future<Nothing> CgroupsMemIsolatorProcess::isolate(
   CHECK_NONE(info->pid);
   info->pid = pid;
 
-  Try<Nothing> assign = cgroups::assign(hierarchy, info->cgroup, pid);
+  // In the unified hierarchy, the Linux launcher has moved the process
+  // into the cgroup already, in which case this is a no-op.
+  Try<Nothing> assign = unified
+    ? cgroups::unified::assign(hierarchy, info->cgroup, pid)
+    : cgroups::assign(hierarchy, info->cgroup, pid);
+
   if (assign.isError()) {
     return Failure("Failed to assign container '" +
                    stringify(info->containerId) + "' to its own cgroup '" +
@@ -342,17 +409,97 @@ Future<Nothing> CgroupsMemIsolatorProcess::update(
   Bytes mem = resources.mem().get();
   Bytes limit = std::max(mem, MIN_MEMORY);
 
-  // Always set the soft limit.
-  Try<Nothing> write =
-    cgroups::memory::soft_limit_in_bytes(hierarchy, info->cgroup, limit);
+  // Set the soft limit, unless it already has the value. If the
+  // revocable memory is reclaimed, the soft limit covers only the
+  // non-revocable memory, so that the kernel reclaims from the
+  // containers with revocable memory first when the host is short of
+  // memory.
+  Bytes softLimit = limit;
 
-  if (write.isError()) {
-    return Failure(
-        "Failed to set 'memory.soft_limit_in_bytes': " + write.error());
+  if (flags.cgroups_reclaim_revocable_memory) {
+    Option<Bytes> revocable = resources.revocable().mem();
+    info->revocable = revocable.isSome() && revocable.get() > 0;
+
+    if (info->revocable) {
+      softLimit = resources.nonRevocable().mem().getOrElse(Bytes(0));
+    }
+  }
+
+  if (info->softLimit != softLimit && unified) {
+    Try<Nothing> write =
+      cgroups::unified::memory::low(hierarchy, info->cgroup, softLimit);
+
+    if (write.isError()) {
+      return Failure("Failed to set 'memory.low': " + write.error());
+    }
+
+    info->softLimit = softLimit;
+
+    LOG(INFO) << "Updated 'memory.low' to " << softLimit
+              << " for container " << containerId;
+  } else if (info->softLimit != softLimit) {
+    Try<Nothing> write = cgroups::memory::soft_limit_in_bytes(
+        hierarchy, info->cgroup, softLimit);
+
+    if (write.isError()) {
+      return Failure(
+          "Failed to set 'memory.soft_limit_in_bytes': " + write.error());
+    }
+
+    info->softLimit = softLimit;
+
+    LOG(INFO) << "Updated 'memory.soft_limit_in_bytes' to " << softLimit
+              << " for container " << containerId;
+  }
+
+  if (info->revocable && !info->reclaimNotifier.isPending()) {
+    reclaimListen(containerId);
+  } else if (!info->revocable && info->reclaimNotifier.isPending()) {
+    info->reclaimNotifier.discard();
   }
 
-  LOG(INFO) << "Updated 'memory.soft_limit_in_bytes' to " << limit
-            << " for container " << containerId;
+  if (unified) {
+    // Read the existing limit, which is None for a new cgroup.
+    Result<Bytes> currentLimit =
+      cgroups::unified::memory::max(hierarchy, info->cgroup);
+
+    if (currentLimit.isError()) {
+      return Failure("Failed to read 'memory.max': " + currentLimit.error());
+    }
+
+    // Only raise the hard limit of a running container, see below.
+    if (info->pid.isSome() &&
+        currentLimit.isSome() &&
+        limit <= currentLimit.get()) {
+      return Nothing();
+    }
+
+    Try<Nothing> write =
+      cgroups::unified::memory::max(hierarchy, info->cgroup, limit);
+
+    if (write.isError()) {
+      return Failure("Failed to set 'memory.max': " + write.error());
+    }
+
+    LOG(INFO) << "Updated 'memory.max' to " << limit
+              << " for container " << containerId;
+
+    // Unlike 'memory.memsw.limit_in_bytes', which limits the memory
+    // and swap together, 'memory.swap.max' limits the swap alone.
+    if (limitSwap && info->pid.isNone()) {
+      Try<Nothing> write =
+        cgroups::unified::memory::swap_max(hierarchy, info->cgroup, Bytes(0));
+
+      if (write.isError()) {
+        return Failure("Failed to set 'memory.swap.max': " + write.error());
+      }
+
+      LOG(INFO) << "Updated 'memory.swap.max' to 0B"
+                << " for container " << containerId;
+    }
+
+    return Nothing();
+  }
 
   // Read the existing limit.
   Try<Bytes> currentLimit =
@@ -407,6 +554,31 @@ Future<Nothing> CgroupsMemIsolatorProcess::update(
 }
 
 
+// Returns the control file of the cgroup of a container. The control
+// file is opened on first use and kept open in 'control', so that the
+// following reads of the usage do not have to reopen it.
+static Try<cgroups::Control*> openControl(
+    Owned<cgroups::Control>* control,
+    const string& hierarchy,
+    const string& cgroup,
+    const string& name,
+    bool unified = false)
+{
+  if (control->get() == NULL) {
+    Try<Owned<cgroups::Control>> open =
+      cgroups::Control::open(hierarchy, cgroup, name, unified);
+
+    if (open.isError()) {
+      return Error(open.error());
+    }
+
+    *control = open.get();
+  }
+
+  return control->get();
+}
+
+
 Future<ResourceStatistics> CgroupsMemIsolatorProcess::usage(
     const ContainerID& containerId)
 {
@@ -418,36 +590,74 @@ Future<ResourceStatistics> CgroupsMemIsolatorProcess::usage(
 
   ResourceStatistics result;
 
+  if (unified) {
+    return __usage(containerId, result);
+  }
+
   // The rss from memory.stat is wrong in two dimensions:
   //   1. It does not include child cgroups.
   //   2. It does not include any file backed pages.
-  Try<Bytes> usage = cgroups::memory::usage_in_bytes(hierarchy, info->cgroup);
+  //
+  // The control files are kept open across the calls, see
+  // 'openControl' above.
+  Try<cgroups::Control*> control = openControl(
+      &info->usageInBytes, hierarchy, info->cgroup, "memory.usage_in_bytes");
+  if (control.isError()) {
+    return Failure(
+        "Failed to open memory.usage_in_bytes: " + control.error());
+  }
+
+  Try<uint64_t> usage = control.get()->value();
   if (usage.isError()) {
     return Failure("Failed to parse memory.usage_in_bytes: " + usage.error());
   }
 
-  result.set_mem_total_bytes(usage.get().bytes());
+  result.set_mem_total_bytes(usage.get());
 
   if (limitSwap) {
-    Try<Bytes> usage =
-      cgroups::memory::memsw_usage_in_bytes(hierarchy, info->cgroup);
+    control = openControl(
+        &info->memswUsageInBytes,
+        hierarchy,
+        info->cgroup,
+        "memory.memsw.usage_in_bytes");
+    if (control.isError()) {
+      return Failure(
+          "Failed to open memory.memsw.usage_in_bytes: " + control.error());
+    }
+
+    Try<uint64_t> usage = control.get()->value();
     if (usage.isError()) {
       return Failure(
         "Failed to parse memory.memsw.usage_in_bytes: " + usage.error());
     }
 
-    result.set_mem_total_memsw_bytes(usage.get().bytes());
+    result.set_mem_total_memsw_bytes(usage.get());
+  }
+
+  control = openControl(&info->stat, hierarchy, info->cgroup, "memory.stat");
+  if (control.isError()) {
+    return Failure("Failed to open memory.stat: " + control.error());
   }
 
   // TODO(bmahler): Add namespacing to cgroups to enforce the expected
   // structure, e.g, cgroups::memory::stat.
-  Try<hashmap<string, uint64_t>> stat =
-    cgroups::stat(hierarchy, info->cgroup, "memory.stat");
+  Option<uint64_t> total_cache;
+  Option<uint64_t> total_rss;
+  Option<uint64_t> total_mapped_file;
+  Option<uint64_t> total_swap;
+  Option<uint64_t> total_unevictable;
+
+  Try<Nothing> stat = control.get()->stat({
+      {"total_cache", &total_cache},
+      {"total_rss", &total_rss},
+      {"total_mapped_file", &total_mapped_file},
+      {"total_swap", &total_swap},
+      {"total_unevictable", &total_unevictable}});
+
   if (stat.isError()) {
     return Failure("Failed to read memory.stat: " + stat.error());
   }
 
-  Option<uint64_t> total_cache = stat.get().get("total_cache");
   if (total_cache.isSome()) {
     // TODO(chzhcn): mem_file_bytes is deprecated in 0.23.0 and will
     // be removed in 0.24.0.
@@ -456,7 +666,6 @@ Future<ResourceStatistics> CgroupsMemIsolatorProcess::usage(
     result.set_mem_cache_bytes(total_cache.get());
   }
 
-  Option<uint64_t> total_rss = stat.get().get("total_rss");
   if (total_rss.isSome()) {
     // TODO(chzhcn): mem_anon_bytes is deprecated in 0.23.0 and will
     // be removed in 0.24.0.
@@ -465,17 +674,14 @@ Future<ResourceStatistics> CgroupsMemIsolatorProcess::usage(
     result.set_mem_rss_bytes(total_rss.get());
   }
 
-  Option<uint64_t> total_mapped_file = stat.get().get("total_mapped_file");
   if (total_mapped_file.isSome()) {
     result.set_mem_mapped_file_bytes(total_mapped_file.get());
   }
 
-  Option<uint64_t> total_swap = stat.get().get("total_swap");
   if (total_swap.isSome()) {
     result.set_mem_swap_bytes(total_swap.get());
   }
 
-  Option<uint64_t> total_unevictable = stat.get().get("total_unevictable");
   if (total_unevictable.isSome()) {
     result.set_mem_unevictable_bytes(total_unevictable.get());
   }
@@ -537,6 +743,120 @@ Future<ResourceStatistics> CgroupsMemIsolatorProcess::_usage(
 }
 
 
+Future<ResourceStatistics> CgroupsMemIsolatorProcess::__usage(
+    const ContainerID& containerId,
+    ResourceStatistics result)
+{
+  CHECK(unified);
+
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  // Unlike in cgroups v1, the usage of the unified hierarchy includes
+  // the child cgroups, and 'memory.stat' has no 'total_' keys.
+  Try<cgroups::Control*> control = openControl(
+      &info->usageInBytes, hierarchy, info->cgroup, "memory.current", true);
+
+  if (control.isError()) {
+    return Failure("Failed to open memory.current: " + control.error());
+  }
+
+  Try<uint64_t> usage = control.get()->value();
+  if (usage.isError()) {
+    return Failure("Failed to parse memory.current: " + usage.error());
+  }
+
+  result.set_mem_total_bytes(usage.get());
+
+  control = openControl(
+      &info->stat, hierarchy, info->cgroup, "memory.stat", true);
+  if (control.isError()) {
+    return Failure("Failed to open memory.stat: " + control.error());
+  }
+
+  Option<uint64_t> anon;
+  Option<uint64_t> file;
+  Option<uint64_t> file_mapped;
+  Option<uint64_t> unevictable;
+
+  Try<Nothing> stat = control.get()->stat({
+      {"anon", &anon},
+      {"file", &file},
+      {"file_mapped", &file_mapped},
+      {"unevictable", &unevictable}});
+
+  if (stat.isError()) {
+    return Failure("Failed to read memory.stat: " + stat.error());
+  }
+
+  if (file.isSome()) {
+    result.set_mem_file_bytes(file.get());
+    result.set_mem_cache_bytes(file.get());
+  }
+
+  if (anon.isSome()) {
+    result.set_mem_anon_bytes(anon.get());
+    result.set_mem_rss_bytes(anon.get());
+  }
+
+  if (file_mapped.isSome()) {
+    result.set_mem_mapped_file_bytes(file_mapped.get());
+  }
+
+  if (unevictable.isSome()) {
+    result.set_mem_unevictable_bytes(unevictable.get());
+  }
+
+  // The kernel may be built without swap accounting.
+  control = openControl(
+      &info->swapCurrent,
+      hierarchy,
+      info->cgroup,
+      "memory.swap.current",
+      true);
+
+  if (control.isSome()) {
+    Try<uint64_t> swap = control.get()->value();
+    if (swap.isError()) {
+      return Failure("Failed to parse memory.swap.current: " + swap.error());
+    }
+
+    result.set_mem_swap_bytes(swap.get());
+
+    if (limitSwap) {
+      result.set_mem_total_memsw_bytes(usage.get() + swap.get());
+    }
+  }
+
+  // The kernel may not support PSI, or have it disabled.
+  control = openControl(
+      &info->pressure, hierarchy, info->cgroup, "memory.pressure", true);
+
+  if (control.isSome()) {
+    Try<Nothing> read = control.get()->read();
+    if (read.isError()) {
+      return Failure("Failed to read memory.pressure: " + read.error());
+    }
+
+    Try<cgroups::unified::Pressure> pressure =
+      cgroups::unified::Pressure::parse(control.get()->contents());
+
+    if (pressure.isError()) {
+      return Failure("Failed to parse memory.pressure: " + pressure.error());
+    }
+
+    result.set_mem_pressure_some_total_secs(
+        pressure.get().some.total.secs());
+
+    if (pressure.get().full.isSome()) {
+      result.set_mem_pressure_full_total_secs(
+          pressure.get().full.get().total.secs());
+    }
+  }
+
+  return result;
+}
+
+
 Future<Nothing> CgroupsMemIsolatorProcess::cleanup(
     const ContainerID& containerId)
 {
@@ -549,10 +869,36 @@ Future<Nothing> CgroupsMemIsolatorProcess::cleanup(
 
   Info* info = CHECK_NOTNULL(infos[containerId]);
 
+  if (info->reclaimNotifier.isPending()) {
+    info->reclaimNotifier.discard();
+  }
+
   if (info->oomNotifier.isPending()) {
     info->oomNotifier.discard();
   }
 
+  if (unified) {
+    // The Linux launcher has destroyed the cgroup already, unless
+    // another launcher is used.
+    Try<bool> exists = cgroups::unified::exists(hierarchy, info->cgroup);
+    if (exists.isError()) {
+      return Failure(
+          "Failed to check cgroup for container " + stringify(containerId) +
+          ": " + exists.error());
+    }
+
+    Future<Nothing> destroy = exists.get()
+      ? cgroups::unified::destroy(
+            hierarchy, info->cgroup, cgroups::DESTROY_TIMEOUT)
+      : Nothing();
+
+    return destroy
+      .onAny(defer(PID<CgroupsMemIsolatorProcess>(this),
+                   &CgroupsMemIsolatorProcess::_cleanup,
+                   containerId,
+                   lambda::_1));
+  }
+
   return cgroups::destroy(hierarchy, info->cgroup, cgroups::DESTROY_TIMEOUT)
     .onAny(defer(PID<CgroupsMemIsolatorProcess>(this),
                  &CgroupsMemIsolatorProcess::_cleanup,
@@ -590,7 +936,9 @@ void CgroupsMemIsolatorProcess::oomListen(
   CHECK(infos.contains(containerId));
   Info* info = CHECK_NOTNULL(infos[containerId]);
 
-  info->oomNotifier = cgroups::memory::oom::listen(hierarchy, info->cgroup);
+  info->oomNotifier = unified
+    ? cgroups::unified::memory::oom(hierarchy, info->cgroup)
+    : cgroups::memory::oom::listen(hierarchy, info->cgroup);
 
   // If the listening fails immediately, something very wrong
   // happened.  Therefore, we report a fatal error here.
@@ -650,6 +998,65 @@ void CgroupsMemIsolatorProcess::oom(const ContainerID& containerId)
   ostringstream message;
   message << "Memory limit exceeded: ";
 
+  if (unified) {
+    Result<Bytes> limit =
+      cgroups::unified::memory::max(hierarchy, info->cgroup);
+
+    if (limit.isError()) {
+      LOG(ERROR) << "Failed to read 'memory.max': " << limit.error();
+    } else if (limit.isSome()) {
+      message << "Requested: " << limit.get() << " ";
+    }
+
+    // The peak usage is only reported by newer kernels.
+    Option<Bytes> usage;
+    if (os::exists(path::join(hierarchy, info->cgroup, "memory.peak"))) {
+      Try<Owned<cgroups::Control>> control = cgroups::Control::open(
+          hierarchy, info->cgroup, "memory.peak", true);
+
+      Try<uint64_t> peak = control.isSome()
+        ? control.get()->value()
+        : Try<uint64_t>(Error(control.error()));
+
+      if (peak.isError()) {
+        LOG(ERROR) << "Failed to read 'memory.peak': " << peak.error();
+      } else {
+        usage = Bytes(peak.get());
+        message << "Maximum Used: " << usage.get() << "\n";
+      }
+    }
+
+    // Output 'memory.stat' of the cgroup to help with debugging.
+    Try<cgroups::Control*> control = openControl(
+        &info->stat, hierarchy, info->cgroup, "memory.stat", true);
+
+    Try<Nothing> read = control.isSome()
+      ? control.get()->read()
+      : Try<Nothing>(Error(control.error()));
+
+    if (read.isError()) {
+      LOG(ERROR) << "Failed to read 'memory.stat': " << read.error();
+    } else {
+      message << "\nMEMORY STATISTICS: \n" << control.get()->contents()
+              << "\n";
+    }
+
+    LOG(INFO) << strings::trim(message.str());
+
+    Resources mem = Resources::parse(
+        "mem",
+        stringify(usage.isSome() ? usage.get().megabytes() : 0),
+        "*").get();
+
+    info->limitation.set(
+        protobuf::slave::createContainerLimitation(
+            mem,
+            message.str(),
+            TaskStatus::REASON_CONTAINER_LIMITATION_MEMORY));
+
+    return;
+  }
+
   // Output the requested memory limit.
   // NOTE: If limitSwap is (has been) used then both limit_in_bytes
   // and memsw.limit_in_bytes will always be set to the same value.
@@ -726,6 +1133,121 @@ void CgroupsMemIsolatorProcess::pressureListen(
   }
 }
 
+
+void CgroupsMemIsolatorProcess::reclaimListen(
+    const ContainerID& containerId)
+{
+  CHECK(infos.contains(containerId));
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  info->reclaimNotifier = cgroups::event::listen(
+      hierarchy,
+      info->cgroup,
+      "memory.pressure_level",
+      stringify(Level::CRITICAL));
+
+  info->reclaimNotifier.onAny(defer(
+      PID<CgroupsMemIsolatorProcess>(this),
+      &CgroupsMemIsolatorProcess::reclaimWaited,
+      containerId,
+      lambda::_1));
+}
+
+
+void CgroupsMemIsolatorProcess::reclaimWaited(
+    const ContainerID& containerId,
+    const Future<uint64_t>& future)
+{
+  if (future.isDiscarded()) {
+    return;
+  }
+
+  if (future.isFailed()) {
+    LOG(ERROR) << "Listening on critical memory pressure events failed "
+               << "for container " << containerId << ": "
+               << future.failure();
+    return;
+  }
+
+  if (!infos.contains(containerId) ||
+      !CHECK_NOTNULL(infos[containerId])->revocable) {
+    return;
+  }
+
+  reclaim(containerId);
+  reclaimListen(containerId);
+}
+
+
+void CgroupsMemIsolatorProcess::reclaim(const ContainerID& containerId)
+{
+  CHECK(infos.contains(containerId));
+  Info* info = CHECK_NOTNULL(infos[containerId]);
+
+  // A cgroup with tasks cannot be emptied with 'memory.force_empty',
+  // so we drop the page cache of the container by shrinking the hard
+  // limit to the memory that is not page cache, and then restore the
+  // limit. The kernel fails the write with EBUSY, rather than
+  // invoking the OOM killer, if it cannot reclaim enough memory.
+  Try<Bytes> limit = cgroups::memory::limit_in_bytes(hierarchy, info->cgroup);
+  if (limit.isError()) {
+    LOG(ERROR) << "Failed to read 'memory.limit_in_bytes': " << limit.error();
+    return;
+  }
+
+  Try<Bytes> usage = cgroups::memory::usage_in_bytes(hierarchy, info->cgroup);
+  if (usage.isError()) {
+    LOG(ERROR) << "Failed to read 'memory.usage_in_bytes': " << usage.error();
+    return;
+  }
+
+  Try<cgroups::Control*> control =
+    openControl(&info->stat, hierarchy, info->cgroup, "memory.stat");
+
+  if (control.isError()) {
+    LOG(ERROR) << "Failed to open memory.stat: " << control.error();
+    return;
+  }
+
+  Option<uint64_t> total_cache;
+
+  Try<Nothing> stat = control.get()->stat({{"total_cache", &total_cache}});
+  if (stat.isError() || total_cache.isNone()) {
+    LOG(ERROR) << "Failed to read the page cache from memory.stat"
+               << (stat.isError() ? ": " + stat.error() : "");
+    return;
+  }
+
+  Bytes cache(total_cache.get());
+  Bytes target = std::max(
+      usage.get() > cache ? usage.get() - cache : Bytes(0),
+      MIN_MEMORY);
+
+  if (target >= limit.get()) {
+    return;
+  }
+
+  LOG(INFO) << "Reclaiming " << cache << " of page cache of container "
+            << containerId << " on critical memory pressure";
+
+  Try<Nothing> shrink =
+    cgroups::memory::limit_in_bytes(hierarchy, info->cgroup, target);
+
+  if (shrink.isError()) {
+    LOG(WARNING) << "Failed to reclaim the page cache of container "
+                 << containerId << ": " << shrink.error();
+  }
+
+  Try<Nothing> restore =
+    cgroups::memory::limit_in_bytes(hierarchy, info->cgroup, limit.get());
+
+  if (restore.isError()) {
+    LOG(ERROR) << "Failed to restore 'memory.limit_in_bytes' to "
+               << limit.get() << " for container " << containerId << ": "
+               << restore.error();
+  }
+}
+
 } // namespace slave {
 } // namespace internal {
 } // namespace mesos {
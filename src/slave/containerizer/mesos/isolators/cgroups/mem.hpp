@@ -22,6 +22,7 @@
 #include <process/future.hpp>
 #include <process/owned.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/nothing.hpp>
 #include <stout/option.hpp>
@@ -43,6 +44,8 @@ public:
 
   virtual ~CgroupsMemIsolatorProcess();
 
+  virtual bool ordered() const { return false; }
+
   virtual process::Future<Nothing> recover(
       const std::list<mesos::slave::ContainerState>& states,
       const hashset<ContainerID>& orphans);
@@ -74,7 +77,13 @@ private:
   CgroupsMemIsolatorProcess(
       const Flags& flags,
       const std::string& hierarchy,
-      bool limitSwap);
+      bool limitSwap,
+      bool unified = false);
+
+  // Returns the usage of a container in the unified hierarchy.
+  process::Future<ResourceStatistics> __usage(
+      const ContainerID& containerId,
+      ResourceStatistics result);
 
   process::Future<ResourceStatistics> _usage(
       const ContainerID& containerId,
@@ -89,12 +98,16 @@ private:
   struct Info
   {
     Info(const ContainerID& _containerId, const std::string& _cgroup)
-      : containerId(_containerId), cgroup(_cgroup) {}
+      : containerId(_containerId), cgroup(_cgroup), revocable(false) {}
 
     const ContainerID containerId;
     const std::string cgroup;
     Option<pid_t> pid;
 
+    // The value last written to 'memory.soft_limit_in_bytes', so
+    // that updates which do not change it skip the write.
+    Option<Bytes> softLimit;
+
     process::Promise<mesos::slave::ContainerLimitation> limitation;
 
     // Used to cancel the OOM listening.
@@ -103,6 +116,19 @@ private:
     hashmap<cgroups::memory::pressure::Level,
             process::Owned<cgroups::memory::pressure::Counter>>
       pressureCounters;
+
+    // Whether the container has revocable memory and, if so, the
+    // listening on its critical memory pressure events, see
+    // '--cgroups_reclaim_revocable_memory'.
+    bool revocable;
+    process::Future<uint64_t> reclaimNotifier;
+
+    // The control files read by 'usage', which are kept open.
+    process::Owned<cgroups::Control> usageInBytes;
+    process::Owned<cgroups::Control> memswUsageInBytes;
+    process::Owned<cgroups::Control> stat;
+    process::Owned<cgroups::Control> swapCurrent;
+    process::Owned<cgroups::Control> pressure;
   };
 
   // Start listening on OOM events. This function will create an
@@ -121,13 +147,32 @@ private:
   // Start listening on memory pressure events.
   void pressureListen(const ContainerID& containerId);
 
+  // Start listening on the critical memory pressure events of a
+  // container with revocable memory, each of which is answered by
+  // reclaiming the page cache of the container.
+  void reclaimListen(const ContainerID& containerId);
+
+  void reclaimWaited(
+      const ContainerID& containerId,
+      const process::Future<uint64_t>& future);
+
+  void reclaim(const ContainerID& containerId);
+
   const Flags flags;
 
-  // The path to the cgroups subsystem hierarchy root.
+  // The path to the cgroups subsystem hierarchy root, or to the
+  // unified hierarchy if 'unified' is set.
   const std::string hierarchy;
 
   const bool limitSwap;
 
+  // Whether the memory controller of the unified hierarchy (cgroups
+  // v2) is used, see the '--cgroups_unified' flag. The cgroup of a
+  // container is then shared with the Linux launcher and the cpu
+  // isolator, the OOM events are read from 'memory.events' and the
+  // memory pressure from 'memory.pressure'.
+  const bool unified;
+
   // TODO(bmahler): Use Owned<Info>.
   hashmap<ContainerID, Info*> infos;
 };
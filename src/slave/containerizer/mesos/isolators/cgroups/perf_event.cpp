@@ -58,6 +58,7 @@ using std::vector;
 using process::Clock;
 using process::Failure;
 using process::Future;
+using process::Owned;
 using process::PID;
 using process::Time;
 
@@ -69,11 +70,17 @@ Try<Isolator*> CgroupsPerfEventIsolatorProcess::create(const Flags& flags)
 {
   LOG(INFO) << "Creating PerfEvent isolator";
 
-  if (!perf::supported()) {
+  if (flags.perf_sampler != "perf" && flags.perf_sampler != "native") {
+    return Error("Unknown perf sampler '" + flags.perf_sampler + "'");
+  }
+
+  const bool native = flags.perf_sampler == "native";
+
+  if (!native && !perf::supported()) {
     return Error("Perf is not supported");
   }
 
-  if (flags.perf_duration > flags.perf_interval) {
+  if (!native && flags.perf_duration > flags.perf_interval) {
     return Error("Sampling perf for duration (" +
                  stringify(flags.perf_duration) +
                  ") > interval (" +
@@ -91,7 +98,7 @@ Try<Isolator*> CgroupsPerfEventIsolatorProcess::create(const Flags& flags)
     events.insert(event);
   }
 
-  if (!perf::valid(events)) {
+  if (native ? !perf::Sampler::valid(events) : !perf::valid(events)) {
     return Error("Failed to create PerfEvent isolator, invalid events: " +
                  stringify(events));
   }
@@ -105,9 +112,16 @@ Try<Isolator*> CgroupsPerfEventIsolatorProcess::create(const Flags& flags)
     return Error("Failed to create perf_event cgroup: " + hierarchy.error());
   }
 
-  LOG(INFO) << "PerfEvent isolator will profile for " << flags.perf_duration
-            << " every " << flags.perf_interval
-            << " for events: " << stringify(events);
+  if (native) {
+    LOG(INFO) << "PerfEvent isolator will count events natively and "
+              << "sample them every " << flags.perf_interval
+              << " for events: " << stringify(events);
+  } else {
+    LOG(INFO) << "PerfEvent isolator will profile for "
+              << flags.perf_duration
+              << " every " << flags.perf_interval
+              << " for events: " << stringify(events);
+  }
 
   process::Owned<MesosIsolatorProcess> process(
       new CgroupsPerfEventIsolatorProcess(flags, hierarchy.get(), events));
@@ -160,7 +174,23 @@ Future<Nothing> CgroupsPerfEventIsolatorProcess::recover(
       continue;
     }
 
-    infos[containerId] = new Info(containerId, cgroup);
+    Info* info = new Info(containerId, cgroup);
+    infos[containerId] = info;
+
+    if (native()) {
+      // The counts of the events since the agent stopped are lost,
+      // the first sample covers the time since the recovery.
+      Try<Owned<perf::Sampler>> sampler =
+        perf::Sampler::create(events, hierarchy, cgroup);
+
+      if (sampler.isError()) {
+        LOG(WARNING) << "Failed to count perf events for container "
+                     << containerId << ", perf statistics will not be "
+                     << "available: " << sampler.error();
+      } else {
+        info->sampler = sampler.get();
+      }
+    }
   }
 
   // Remove orphan cgroups.
@@ -254,6 +284,17 @@ Future<Option<ContainerPrepareInfo>> CgroupsPerfEventIsolatorProcess::prepare(
     }
   }
 
+  if (native()) {
+    Try<Owned<perf::Sampler>> sampler =
+      perf::Sampler::create(events, hierarchy, info->cgroup);
+
+    if (sampler.isError()) {
+      return Failure("Failed to prepare isolator: " + sampler.error());
+    }
+
+    info->sampler = sampler.get();
+  }
+
   return None();
 }
 
@@ -330,6 +371,9 @@ Future<Nothing> CgroupsPerfEventIsolatorProcess::cleanup(
 
   info->destroying = true;
 
+  // Close the counters of the container before destroying its cgroup.
+  info->sampler.reset();
+
   return cgroups::destroy(hierarchy, info->cgroup)
     .then(defer(PID<CgroupsPerfEventIsolatorProcess>(this),
                 &CgroupsPerfEventIsolatorProcess::_cleanup,
@@ -368,6 +412,32 @@ Future<hashmap<string, PerfStatistics>> discardSample(
 
 void CgroupsPerfEventIsolatorProcess::sample()
 {
+  if (native()) {
+    // The counters are kept open, so a sample only reads them.
+    foreachvalue (Info* info, infos) {
+      CHECK_NOTNULL(info);
+
+      if (info->destroying || info->sampler.get() == NULL) {
+        continue;
+      }
+
+      Try<PerfStatistics> statistics = info->sampler->sample();
+      if (statistics.isError()) {
+        LOG(ERROR) << "Failed to get perf sample for container "
+                   << info->containerId << ": " << statistics.error();
+        continue;
+      }
+
+      info->statistics = statistics.get();
+    }
+
+    delay(flags.perf_interval,
+          PID<CgroupsPerfEventIsolatorProcess>(this),
+          &CgroupsPerfEventIsolatorProcess::sample);
+
+    return;
+  }
+
   // Collect a perf sample for all cgroups that are not being
   // destroyed. Since destroyal is asynchronous, 'perf stat' may
   // fail if the cgroup is destroyed before running perf.
@@ -19,11 +19,14 @@
 
 #include <set>
 
+#include <process/owned.hpp>
 #include <process/time.hpp>
 
 #include <stout/hashmap.hpp>
 #include <stout/nothing.hpp>
 
+#include "linux/perf.hpp"
+
 #include "slave/flags.hpp"
 
 #include "slave/containerizer/mesos/isolator.hpp"
@@ -39,6 +42,8 @@ public:
 
   virtual ~CgroupsPerfEventIsolatorProcess();
 
+  virtual bool ordered() const { return false; }
+
   virtual process::Future<Nothing> recover(
       const std::list<mesos::slave::ContainerState>& states,
       const hashset<ContainerID>& orphans);
@@ -104,8 +109,15 @@ private:
     PerfStatistics statistics;
     // Mark a container when we start destruction so we stop sampling it.
     bool destroying;
+
+    // The counters of the container's events, with the native sampler.
+    process::Owned<perf::Sampler> sampler;
   };
 
+  // Returns whether the events are counted with perf::Sampler rather
+  // than by running 'perf stat', see the --perf_sampler flag.
+  bool native() const { return flags.perf_sampler == "native"; }
+
   const Flags flags;
 
   // The path to the cgroups subsystem hierarchy root.
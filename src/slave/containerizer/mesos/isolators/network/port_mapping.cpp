@@ -25,6 +25,7 @@
 
 #include <mesos/mesos.hpp>
 
+#include <process/clock.hpp>
 #include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/io.hpp>
@@ -121,6 +122,11 @@ namespace slave {
 // The minimum number of ephemeral ports a container should have.
 static const uint16_t MIN_EPHEMERAL_PORTS_SIZE = 16;
 
+// How long a dump of the statistics of the links on the host is used
+// for the 'usage' calls. The resource monitor asks for the usage of
+// all the containers at once, so they share a single dump.
+static const Duration LINK_STATISTICS_TTL = Seconds(1);
+
 // Linux traffic control is a combination of queueing disciplines,
 // filters and classes organized as a tree for the ingress (tx) and
 // egress (rx) flows for each interface. Each container provides two
@@ -190,6 +196,22 @@ constexpr Handle CONTAINER_TX_HTB_CLASS_ID =
     Handle(CONTAINER_TX_HTB_HANDLE, 1);
 
 
+// Similarly, we limit the inbound traffic bandwidth with an HTB qdisc
+// and class as the egress qdisc of the host end of the veth [2]. All
+// the traffic to the container goes out of the host end of the veth,
+// since the filters above redirect it there, so this shapes the
+// ingress of the container without needing an intermediate device.
+// The ingress traffic control chain is thus:
+//
+// root device: handle::EGRESS_ROOT ->
+//    htb egress qdisc: CONTAINER_RX_HTB_HANDLE ->
+//        htb rate limiting class: CONTAINER_RX_HTB_CLASS_ID ->
+//            buffer-bloat reduction: FQ_CODEL
+constexpr Handle CONTAINER_RX_HTB_HANDLE = Handle(1, 0);
+constexpr Handle CONTAINER_RX_HTB_CLASS_ID =
+    Handle(CONTAINER_RX_HTB_HANDLE, 1);
+
+
 // Finally we create a second fq_codel qdisc on the public interface
 // of the host [6] to reduce performance interference between
 // containers. We create independent flows for each container, and
@@ -921,6 +943,53 @@ int PortMappingStatistics::execute()
 // Implementation for the isolator.
 /////////////////////////////////////////////////
 
+// Returns the given per container rate limit of the traffic in the
+// given direction, or none if the limit is zero, if it is not greater
+// than the host physical link speed.
+static Try<Option<Bytes>> checkRateLimit(
+    const string& direction,
+    const Bytes& limit,
+    const string& eth0)
+{
+  // Read host physical link speed from /sys/class/net/eth0/speed.
+  // This value is in MBits/s.
+  Try<string> value = os::read(path::join("/sys/class/net", eth0, "speed"));
+
+  if (value.isError()) {
+    return Error(
+        "Failed to read " +
+        path::join("/sys/class/net", eth0, "speed") +
+        ": " + value.error());
+  }
+
+  Try<uint64_t> hostLinkSpeed = numify<uint64_t>(strings::trim(value.get()));
+  CHECK_SOME(hostLinkSpeed);
+
+  // It could be possible that the nic driver doesn't support
+  // reporting physical link speed. In that case, report error.
+  if (hostLinkSpeed.get() == 0xFFFFFFFF) {
+    return Error(
+        "Network Isolator failed to determine link speed for " + eth0);
+  }
+
+  // Convert host link speed to Bytes/s for comparason.
+  if (hostLinkSpeed.get() * 1000000 / 8 < limit.bytes()) {
+    return Error(
+        "The given " + direction + " traffic limit for containers " +
+        stringify(limit.bytes()) +
+        " Bytes/s is greater than the host link speed " +
+        stringify(hostLinkSpeed.get() * 1000000 / 8) + " Bytes/s");
+  }
+
+  if (limit == Bytes(0)) {
+    LOG(WARNING) << "Ignoring the given zero " << direction << " rate limit";
+    return Option<Bytes>::none();
+  }
+
+  return Option<Bytes>(limit);
+}
+
+
 PortMappingIsolatorProcess::Metrics::Metrics()
   : adding_eth0_ip_filters_errors(
         "port_mapping/adding_eth0_ip_filters_errors"),
@@ -1271,47 +1340,33 @@ Try<Isolator*> PortMappingIsolatorProcess::create(const Flags& flags)
 
   LOG(INFO) << "Using " << lo.get() << " as the loopback interface";
 
-  // If egress rate limit is provided, do a sanity check that it is
-  // not greater than the host physical link speed.
+  // If egress or ingress rate limits are provided, check them.
   Option<Bytes> egressRateLimitPerContainer;
   if (flags.egress_rate_limit_per_container.isSome()) {
-    // Read host physical link speed from /sys/class/net/eth0/speed.
-    // This value is in MBits/s.
-    Try<string> value =
-      os::read(path::join("/sys/class/net", eth0.get(), "speed"));
+    Try<Option<Bytes>> limit = checkRateLimit(
+        "egress",
+        flags.egress_rate_limit_per_container.get(),
+        eth0.get());
 
-    if (value.isError()) {
-      return Error(
-          "Failed to read " +
-          path::join("/sys/class/net", eth0.get(), "speed") +
-          ": " + value.error());
+    if (limit.isError()) {
+      return Error(limit.error());
     }
 
-    Try<uint64_t> hostLinkSpeed = numify<uint64_t>(strings::trim(value.get()));
-    CHECK_SOME(hostLinkSpeed);
+    egressRateLimitPerContainer = limit.get();
+  }
 
-    // It could be possible that the nic driver doesn't support
-    // reporting physical link speed. In that case, report error.
-    if (hostLinkSpeed.get() == 0xFFFFFFFF) {
-      return Error(
-          "Network Isolator failed to determine link speed for " + eth0.get());
-    }
+  Option<Bytes> ingressRateLimitPerContainer;
+  if (flags.ingress_rate_limit_per_container.isSome()) {
+    Try<Option<Bytes>> limit = checkRateLimit(
+        "ingress",
+        flags.ingress_rate_limit_per_container.get(),
+        eth0.get());
 
-    // Convert host link speed to Bytes/s for comparason.
-    if (hostLinkSpeed.get() * 1000000 / 8 <
-        flags.egress_rate_limit_per_container.get().bytes()) {
-      return Error(
-          "The given egress traffic limit for containers " +
-          stringify(flags.egress_rate_limit_per_container.get().bytes()) +
-          " Bytes/s is greater than the host link speed " +
-          stringify(hostLinkSpeed.get() * 1000000 / 8) + " Bytes/s");
+    if (limit.isError()) {
+      return Error(limit.error());
     }
 
-    if (flags.egress_rate_limit_per_container.get() != Bytes(0)) {
-      egressRateLimitPerContainer = flags.egress_rate_limit_per_container.get();
-    } else {
-      LOG(WARNING) << "Ignoring the given zero egress rate limit";
-    }
+    ingressRateLimitPerContainer = limit.get();
   }
 
   // Get the host IP network, MAC and default gateway.
@@ -1648,6 +1703,7 @@ Try<Isolator*> PortMappingIsolatorProcess::create(const Flags& flags)
           hostTxFqCodelHandle,
           hostNetworkConfigurations,
           egressRateLimitPerContainer,
+          ingressRateLimitPerContainer,
           nonEphemeralPorts,
           ephemeralPortsAllocator,
           freeFlowIds)));
@@ -2275,10 +2331,57 @@ Future<Nothing> PortMappingIsolatorProcess::isolate(
   // Veth device should exist since we just created it.
   CHECK(createQdisc.get());
 
+  // Limit the ingress traffic of the container on the egress side of
+  // the host end of veth, see the comments for CONTAINER_RX_HTB_HANDLE.
+  if (ingressRateLimitPerContainer.isSome()) {
+    Try<bool> createHtb = htb::create(
+        veth(pid),
+        EGRESS_ROOT,
+        CONTAINER_RX_HTB_HANDLE,
+        CONTAINER_RX_HTB_CLASS_ID);
+
+    if (createHtb.isError()) {
+      return Failure(
+          "Failed to create the htb qdisc on " + veth(pid) +
+          ": " + createHtb.error());
+    } else if (!createHtb.get()) {
+      return Failure("The htb qdisc already exists on " + veth(pid));
+    }
+
+    Try<bool> createClass = htb::createClass(
+        veth(pid),
+        CONTAINER_RX_HTB_HANDLE,
+        CONTAINER_RX_HTB_CLASS_ID,
+        ingressRateLimitPerContainer.get());
+
+    if (createClass.isError()) {
+      return Failure(
+          "Failed to create the htb class on " + veth(pid) +
+          ": " + createClass.error());
+    } else if (!createClass.get()) {
+      return Failure("The htb class already exists on " + veth(pid));
+    }
+
+    // Like for the egress, the packets buffered at the leaf because
+    // of the rate limit are queued by fq_codel rather than pfifo_fast.
+    Try<bool> createFqCodel =
+      fq_codel::create(veth(pid), CONTAINER_RX_HTB_CLASS_ID, None());
+
+    if (createFqCodel.isError()) {
+      return Failure(
+          "Failed to create the fq_codel qdisc on " + veth(pid) +
+          ": " + createFqCodel.error());
+    } else if (!createFqCodel.get()) {
+      return Failure("The fq_codel qdisc already exists on " + veth(pid));
+    }
+  }
+
   // For each port range, add a set of IP packet filters to properly
   // redirect IP traffic to/from containers.
-  foreach (const PortRange& range,
-           getPortRanges(info->nonEphemeralPorts + info->ephemeralPorts)) {
+  const vector<PortRange> ranges =
+    getPortRanges(info->nonEphemeralPorts + info->ephemeralPorts);
+
+  foreach (const PortRange& range, ranges) {
     if (info->flowId.isSome()) {
       LOG(INFO) << "Adding IP packet filters with ports " << range
                 << " with flow ID " << info->flowId.get()
@@ -2287,14 +2390,14 @@ Future<Nothing> PortMappingIsolatorProcess::isolate(
       LOG(INFO) << "Adding IP packet filters with ports " << range
                 << " for container " << containerId;
     }
+  }
 
-    Try<Nothing> add = addHostIPFilters(range, info->flowId, veth(pid));
-    if (add.isError()) {
-      return Failure(
-          "Failed to add IP packet filter with ports " +
-          stringify(range) + " for container with pid " +
-          stringify(pid) + ": " + add.error());
-    }
+  Try<Nothing> add = addHostIPFilters(ranges, info->flowId, veth(pid));
+  if (add.isError()) {
+    return Failure(
+        "Failed to add IP packet filters with ports " +
+        stringify(ranges) + " for container with pid " +
+        stringify(pid) + ": " + add.error());
   }
 
   // Relay ICMP packets from veth of the container to host eth0.
@@ -2670,29 +2773,33 @@ Future<Nothing> PortMappingIsolatorProcess::update(
       LOG(INFO) << "Adding IP packet filters with ports " << range
                 << " for container " << containerId;
     }
+  }
 
-    // All IP packets from a container will be assigned a single flow
-    // on host eth0.
-    Try<Nothing> add = addHostIPFilters(range, info->flowId, veth(pid));
-    if (add.isError()) {
-      return Failure(
-          "Failed to add IP packet filter with ports " +
-          stringify(range) + " for container with pid " +
-          stringify(pid) + ": " + add.error());
-    }
+  // All IP packets from a container will be assigned a single flow
+  // on host eth0.
+  Try<Nothing> add = addHostIPFilters(portsToAdd, info->flowId, veth(pid));
+  if (add.isError()) {
+    return Failure(
+        "Failed to add IP packet filters with ports " +
+        stringify(portsToAdd) + " for container with pid " +
+        stringify(pid) + ": " + add.error());
   }
 
   foreach (const PortRange& range, portsToRemove) {
     LOG(INFO) << "Removing IP packet filters with ports " << range
               << " for container with pid " << pid;
+  }
 
-    Try<Nothing> removing = removeHostIPFilters(range, veth(pid));
-    if (removing.isError()) {
-      return Failure(
-          "Failed to remove IP packet filter with ports " +
-          stringify(range) + " for container with pid " +
-          stringify(pid) + ": " + removing.error());
-    }
+  const vector<PortRange> rangesToRemove(
+      portsToRemove.begin(),
+      portsToRemove.end());
+
+  Try<Nothing> removing = removeHostIPFilters(rangesToRemove, veth(pid));
+  if (removing.isError()) {
+    return Failure(
+        "Failed to remove IP packet filters with ports " +
+        stringify(rangesToRemove) + " for container with pid " +
+        stringify(pid) + ": " + removing.error());
   }
 
   // Update the non-ephemeral ports of this container.
@@ -2754,7 +2861,7 @@ Future<ResourceStatistics> PortMappingIsolatorProcess::usage(
   }
 
   Result<hashmap<string, uint64_t>> stat =
-    link::statistics(veth(info->pid.get()));
+    linkStatistics(veth(info->pid.get()));
 
   if (stat.isError()) {
     return Failure(
@@ -2819,6 +2926,36 @@ Future<ResourceStatistics> PortMappingIsolatorProcess::usage(
     result.set_net_tx_dropped(tx_dropped.get());
   }
 
+  // The ingress traffic control statistics are on the host end of
+  // veth. Like for the egress, they are only available if the
+  // container was created with an ingress rate limit, so we do not
+  // report a lack of them as an error.
+  Result<hashmap<string, uint64_t>> ingress =
+    htb::statistics(veth(info->pid.get()), EGRESS_ROOT);
+
+  if (ingress.isSome()) {
+    addTrafficControlStatistics(
+        NET_ISOLATOR_INGRESS_BW_LIMIT,
+        ingress.get(),
+        &result);
+  } else if (ingress.isError()) {
+    LOG(WARNING) << "Failed to get htb qdisc statistics on "
+                 << veth(info->pid.get()) << ": " << ingress.error();
+  }
+
+  ingress =
+    fq_codel::statistics(veth(info->pid.get()), CONTAINER_RX_HTB_CLASS_ID);
+
+  if (ingress.isSome()) {
+    addTrafficControlStatistics(
+        NET_ISOLATOR_INGRESS_BLOAT_REDUCTION,
+        ingress.get(),
+        &result);
+  } else if (ingress.isError()) {
+    LOG(WARNING) << "Failed to get fq_codel qdisc statistics on "
+                 << veth(info->pid.get()) << ": " << ingress.error();
+  }
+
   // Retrieve the socket information from inside the container.
   PortMappingStatistics statistics;
   statistics.flags.pid = info->pid.get();
@@ -2859,6 +2996,34 @@ Future<ResourceStatistics> PortMappingIsolatorProcess::usage(
 }
 
 
+Result<hashmap<string, uint64_t>> PortMappingIsolatorProcess::linkStatistics(
+    const string& link)
+{
+  // A link that is not in the dump may belong to a container that
+  // was launched after it, so we dump the links again.
+  if (links.isNone() ||
+      Clock::now() - links->timestamp > LINK_STATISTICS_TTL ||
+      !links->statistics.contains(link)) {
+    Try<hashmap<string, hashmap<string, uint64_t>>> statistics =
+      link::statistics();
+
+    if (statistics.isError()) {
+      return Error(statistics.error());
+    }
+
+    links = Links();
+    links->timestamp = Clock::now();
+    links->statistics = statistics.get();
+  }
+
+  if (!links->statistics.contains(link)) {
+    return None();
+  }
+
+  return links->statistics.at(link);
+}
+
+
 Future<ResourceStatistics> PortMappingIsolatorProcess::_usage(
     const ResourceStatistics& result,
     const Subprocess& s)
@@ -2982,20 +3147,22 @@ Try<Nothing> PortMappingIsolatorProcess::_cleanup(
 
   // Remove the IP filters on eth0 and lo for non-ephemeral port
   // ranges and the ephemeral port range.
-  foreach (const PortRange& range,
-           getPortRanges(info->nonEphemeralPorts + info->ephemeralPorts)) {
+  const vector<PortRange> ranges =
+    getPortRanges(info->nonEphemeralPorts + info->ephemeralPorts);
+
+  foreach (const PortRange& range, ranges) {
     LOG(INFO) << "Removing IP packet filters with ports " << range
               << " for container with pid " << pid;
+  }
 
-    // No need to remove filters on veth as they will be automatically
-    // removed by the kernel when we remove the link below.
-    Try<Nothing> removing = removeHostIPFilters(range, veth(pid), false);
-    if (removing.isError()) {
-      errors.push_back(
-          "Failed to remove IP packet filter with ports " +
-          stringify(range) + " for container with pid " +
-          stringify(pid) + ": " + removing.error());
-    }
+  // No need to remove filters on veth as they will be automatically
+  // removed by the kernel when we remove the link below.
+  Try<Nothing> removing = removeHostIPFilters(ranges, veth(pid), false);
+  if (removing.isError()) {
+    errors.push_back(
+        "Failed to remove IP packet filters with ports " +
+        stringify(ranges) + " for container with pid " +
+        stringify(pid) + ": " + removing.error());
   }
 
   // Free the ephemeral ports used by this container.
@@ -3221,247 +3388,275 @@ Try<Nothing> PortMappingIsolatorProcess::_cleanup(
 }
 
 
-// Helper function to set up IP filters on the host side for a given
-// port range.
+// Helper function to set up IP filters on the host side for the given
+// port ranges. The filters on each link are created in a batch.
 Try<Nothing> PortMappingIsolatorProcess::addHostIPFilters(
-    const PortRange& range,
+    const vector<PortRange>& ranges,
     const Option<uint16_t>& flowId,
     const string& veth)
 {
-  // NOTE: The order in which these filters are added is important!
-  // For each port range, we need to make sure that we don't try to
-  // add filters on host eth0 and host lo until we have successfully
-  // added filters on veth. This is because the slave could crash
-  // while we are adding filters, we want to make sure we don't leak
-  // any filters on host eth0 and host lo.
-
-  // Add an IP packet filter from veth of the container to host eth0
-  // to properly redirect IP packets sent from one container to
-  // external hosts. This filter has a lower priority compared to the
-  // 'vethToHostLo' filter because it does not check the destination
-  // IP. Notice that here we also check the source port of a packet.
-  // If the source port is not within the port ranges allocated for
-  // the container, the packet will get dropped.
-  Try<bool> vethToHostEth0 = filter::ip::create(
-      veth,
-      ingress::HANDLE,
-      ip::Classifier(None(), None(), range, None()),
-      Priority(IP_FILTER_PRIORITY, LOW),
-      action::Redirect(eth0));
-
-  if (vethToHostEth0.isError()) {
-    ++metrics.adding_veth_ip_filters_errors;
-
-    return Error(
-        "Failed to create an IP packet filter from " + veth +
-        " to host " + eth0 + ": " + vethToHostEth0.error());
-  } else if (!vethToHostEth0.get()) {
-    ++metrics.adding_veth_ip_filters_already_exist;
-
-    return Error(
-        "The IP packet filter from " + veth +
-        " to host " + eth0 + " already exists");
+  if (ranges.empty()) {
+    return Nothing();
   }
 
-  // Add two IP packet filters (one for public IP and one for loopback
-  // IP) from veth of the container to host lo to properly redirect IP
-  // packets sent from one container to either the host or another
-  // container. Notice that here we also check the source port of a
-  // packet. If the source port is not within the port ranges
-  // allocated for the container, the packet will get dropped.
-  Try<bool> vethToHostLoPublic = filter::ip::create(
-      veth,
-      ingress::HANDLE,
-      ip::Classifier(None(), hostIPNetwork.address(), range, None()),
-      Priority(IP_FILTER_PRIORITY, NORMAL),
-      action::Redirect(lo));
-
-  if (vethToHostLoPublic.isError()) {
-    ++metrics.adding_veth_ip_filters_errors;
+  // NOTE: The order in which these filters are added is important!
+  // We need to make sure that we don't try to add filters on host
+  // eth0 and host lo until we have successfully added filters on
+  // veth. This is because the slave could crash while we are adding
+  // filters, we want to make sure we don't leak any filters on host
+  // eth0 and host lo.
+  vector<filter::Filter<ip::Classifier>> vethFilters;
+  vector<filter::Filter<ip::Classifier>> hostEth0Filters;
+  vector<filter::Filter<ip::Classifier>> hostLoFilters;
+  vector<filter::Filter<ip::Classifier>> hostEth0EgressFilters;
 
-    return Error(
-        "Failed to create an IP packet filter (for public IP) from " +
-        veth + " to host " + lo + ": " + vethToHostLoPublic.error());
-  } else if (!vethToHostLoPublic.get()) {
-    ++metrics.adding_veth_ip_filters_already_exist;
+  foreach (const PortRange& range, ranges) {
+    // An IP packet filter from veth of the container to host eth0 to
+    // properly redirect IP packets sent from one container to
+    // external hosts. This filter has a lower priority compared to
+    // the filters to host lo because it does not check the
+    // destination IP. Notice that here we also check the source port
+    // of a packet. If the source port is not within the port ranges
+    // allocated for the container, the packet will get dropped.
+    vethFilters.push_back(filter::Filter<ip::Classifier>(
+        ingress::HANDLE,
+        ip::Classifier(None(), None(), range, None()),
+        Priority(IP_FILTER_PRIORITY, LOW),
+        None(),
+        None(),
+        action::Redirect(eth0)));
+
+    // Two IP packet filters (one for public IP and one for loopback
+    // IP) from veth of the container to host lo to properly redirect
+    // IP packets sent from one container to either the host or
+    // another container.
+    vethFilters.push_back(filter::Filter<ip::Classifier>(
+        ingress::HANDLE,
+        ip::Classifier(None(), hostIPNetwork.address(), range, None()),
+        Priority(IP_FILTER_PRIORITY, NORMAL),
+        None(),
+        None(),
+        action::Redirect(lo)));
 
-    return Error(
-        "The IP packet filter (for public IP) from " +
-        veth + " to host " + lo + " already exists");
+    vethFilters.push_back(filter::Filter<ip::Classifier>(
+        ingress::HANDLE,
+        ip::Classifier(
+            None(),
+            net::IPNetwork::LOOPBACK_V4().address(),
+            range,
+            None()),
+        Priority(IP_FILTER_PRIORITY, NORMAL),
+        None(),
+        None(),
+        action::Redirect(lo)));
+
+    // An IP packet filter from host eth0 to veth of the container
+    // such that any incoming IP packet will be properly redirected to
+    // the corresponding container based on its destination port.
+    hostEth0Filters.push_back(filter::Filter<ip::Classifier>(
+        ingress::HANDLE,
+        ip::Classifier(hostMAC, hostIPNetwork.address(), None(), range),
+        Priority(IP_FILTER_PRIORITY, NORMAL),
+        None(),
+        None(),
+        action::Redirect(veth)));
+
+    // An IP packet filter from host lo to veth of the container such
+    // that any internally generated IP packet will be properly
+    // redirected to the corresponding container based on its
+    // destination port.
+    hostLoFilters.push_back(filter::Filter<ip::Classifier>(
+        ingress::HANDLE,
+        ip::Classifier(None(), None(), None(), range),
+        Priority(IP_FILTER_PRIORITY, NORMAL),
+        None(),
+        None(),
+        action::Redirect(veth)));
+
+    // IP packet filters to classify traffic sending to eth0 in the
+    // same way so that traffic of each container will be classified
+    // to different flows defined by fq_codel.
+    if (flowId.isSome()) {
+      hostEth0EgressFilters.push_back(filter::Filter<ip::Classifier>(
+          hostTxFqCodelHandle,
+          ip::Classifier(None(), None(), range, None()),
+          Priority(IP_FILTER_PRIORITY, LOW),
+          None(),
+          Handle(hostTxFqCodelHandle, flowId.get()),
+          action::Terminal()));
+    }
   }
 
-  Try<bool> vethToHostLoLoopback = filter::ip::create(
-      veth,
-      ingress::HANDLE,
-      ip::Classifier(
-          None(),
-          net::IPNetwork::LOOPBACK_V4().address(),
-          range,
-          None()),
-      Priority(IP_FILTER_PRIORITY, NORMAL),
-      action::Redirect(lo));
+  Try<bool> vethToHost = filter::ip::create(veth, vethFilters);
 
-  if (vethToHostLoLoopback.isError()) {
+  if (vethToHost.isError()) {
     ++metrics.adding_veth_ip_filters_errors;
 
     return Error(
-        "Failed to create an IP packet filter (for loopback IP) from " +
-        veth + " to host " + lo + ": " + vethToHostLoLoopback.error());
-  } else if (!vethToHostLoLoopback.get()) {
+        "Failed to create the IP packet filters from " + veth +
+        " to host " + eth0 + " and " + lo + ": " + vethToHost.error());
+  } else if (!vethToHost.get()) {
     ++metrics.adding_veth_ip_filters_already_exist;
 
     return Error(
-        "The IP packet filter (for loopback IP) from " +
-        veth + " to host " + lo + " already exists");
+        "An IP packet filter from " + veth + " to host " + eth0 +
+        " or " + lo + " already exists");
   }
 
-  // Add an IP packet filter from host eth0 to veth of the container
-  // such that any incoming IP packet will be properly redirected to
-  // the corresponding container based on its destination port.
-  Try<bool> hostEth0ToVeth = filter::ip::create(
-      eth0,
-      ingress::HANDLE,
-      ip::Classifier(hostMAC, hostIPNetwork.address(), None(), range),
-      Priority(IP_FILTER_PRIORITY, NORMAL),
-      action::Redirect(veth));
+  Try<bool> hostEth0ToVeth = filter::ip::create(eth0, hostEth0Filters);
 
   if (hostEth0ToVeth.isError()) {
     ++metrics.adding_eth0_ip_filters_errors;
 
     return Error(
-        "Failed to create an IP packet filter from host " +
+        "Failed to create the IP packet filters from host " +
         eth0 + " to " + veth + ": " + hostEth0ToVeth.error());
   } else if (!hostEth0ToVeth.get()) {
     ++metrics.adding_eth0_ip_filters_already_exist;
 
     return Error(
-        "The IP packet filter from host " + eth0 + " to " +
+        "An IP packet filter from host " + eth0 + " to " +
         veth + " already exists");
   }
 
-  // Add an IP packet filter from host lo to veth of the container
-  // such that any internally generated IP packet will be properly
-  // redirected to the corresponding container based on its
-  // destination port.
-  Try<bool> hostLoToVeth = filter::ip::create(
-      lo,
-      ingress::HANDLE,
-      ip::Classifier(None(), None(), None(), range),
-      Priority(IP_FILTER_PRIORITY, NORMAL),
-      action::Redirect(veth));
+  Try<bool> hostLoToVeth = filter::ip::create(lo, hostLoFilters);
 
   if (hostLoToVeth.isError()) {
     ++metrics.adding_lo_ip_filters_errors;
 
     return Error(
-        "Failed to create an IP packet filter from host " +
+        "Failed to create the IP packet filters from host " +
         lo + " to " + veth + ": " + hostLoToVeth.error());
   } else if (!hostLoToVeth.get()) {
     ++metrics.adding_lo_ip_filters_already_exist;
 
     return Error(
-        "The IP packet filter from host " + lo + " to " +
+        "An IP packet filter from host " + lo + " to " +
         veth + " already exists");
   }
 
-  if (flowId.isSome()) {
-    // Add IP packet filters to classify traffic sending to eth0
-    // in the same way so that traffic of each container will be
-    // classified to different flows defined by fq_codel.
-    Try<bool> hostEth0Egress = filter::ip::create(
-        eth0,
-        hostTxFqCodelHandle,
-        ip::Classifier(None(), None(), range, None()),
-        Priority(IP_FILTER_PRIORITY, LOW),
-        Handle(hostTxFqCodelHandle, flowId.get()));
+  Try<bool> hostEth0Egress = filter::ip::create(eth0, hostEth0EgressFilters);
 
-    if (hostEth0Egress.isError()) {
-      ++metrics.adding_eth0_egress_filters_errors;
+  if (hostEth0Egress.isError()) {
+    ++metrics.adding_eth0_egress_filters_errors;
 
-      return Error(
-          "Failed to create a flow classifier for " + veth +
-          " on host " + eth0 + ": " + hostEth0Egress.error());
-    } else if (!hostEth0Egress.get()) {
-      ++metrics.adding_eth0_egress_filters_already_exist;
+    return Error(
+        "Failed to create the flow classifiers for " + veth +
+        " on host " + eth0 + ": " + hostEth0Egress.error());
+  } else if (!hostEth0Egress.get()) {
+    ++metrics.adding_eth0_egress_filters_already_exist;
 
-      return Error(
-          "The flow classifier for veth " + veth +
-          " on host " + eth0 + " already exists");
-    }
+    return Error(
+        "A flow classifier for veth " + veth +
+        " on host " + eth0 + " already exists");
   }
 
   return Nothing();
 }
 
 
-// Helper function to remove IP filters from the host side for a given
-// port range. The boolean flag 'removeFiltersOnVeth' indicates if we
-// need to remove filters on veth.
+// Helper function to remove IP filters from the host side for the
+// given port ranges. The filters on each link are removed in a batch.
+// The boolean flag 'removeFiltersOnVeth' indicates if we need to
+// remove filters on veth.
 Try<Nothing> PortMappingIsolatorProcess::removeHostIPFilters(
-    const PortRange& range,
+    const vector<PortRange>& ranges,
     const string& veth,
     bool removeFiltersOnVeth)
 {
+  if (ranges.empty()) {
+    return Nothing();
+  }
+
   // NOTE: Similar to above. The order in which these filters are
   // removed is important. We need to remove filters on host eth0 and
   // host lo first before we remove filters on veth.
+  vector<ip::Classifier> hostEth0Classifiers;
+  vector<ip::Classifier> hostLoClassifiers;
+  vector<ip::Classifier> hostEth0EgressClassifiers;
+  vector<ip::Classifier> vethClassifiers;
 
-  // Remove the IP packet filter from host eth0 to veth of the container.
-  Try<bool> hostEth0ToVeth = filter::ip::remove(
-      eth0,
-      ingress::HANDLE,
-      ip::Classifier(hostMAC, hostIPNetwork.address(), None(), range));
+  foreach (const PortRange& range, ranges) {
+    // The IP packet filter from host eth0 to veth of the container.
+    hostEth0Classifiers.push_back(
+        ip::Classifier(hostMAC, hostIPNetwork.address(), None(), range));
+
+    // The IP packet filter from host lo to veth of the container.
+    hostLoClassifiers.push_back(
+        ip::Classifier(None(), None(), None(), range));
+
+    // The egress flow classifier on host eth0.
+    hostEth0EgressClassifiers.push_back(
+        ip::Classifier(None(), None(), range, None()));
+
+    // The IP packet filters from veth of the container to host lo
+    // for the public IP and the loopback IP, and to host eth0.
+    vethClassifiers.push_back(
+        ip::Classifier(None(), hostIPNetwork.address(), range, None()));
+
+    vethClassifiers.push_back(
+        ip::Classifier(
+            None(),
+            net::IPNetwork::LOOPBACK_V4().address(),
+            range,
+            None()));
+
+    vethClassifiers.push_back(
+        ip::Classifier(None(), None(), range, None()));
+  }
+
+  Try<size_t> hostEth0ToVeth =
+    filter::ip::remove(eth0, ingress::HANDLE, hostEth0Classifiers);
 
   if (hostEth0ToVeth.isError()) {
     ++metrics.removing_eth0_ip_filters_errors;
 
     return Error(
-        "Failed to remove the IP packet filter from host " +
+        "Failed to remove the IP packet filters from host " +
         eth0 + " to " + veth + ": " + hostEth0ToVeth.error());
-  } else if (!hostEth0ToVeth.get()) {
-    ++metrics.removing_eth0_ip_filters_do_not_exist;
+  } else if (hostEth0ToVeth.get() < hostEth0Classifiers.size()) {
+    metrics.removing_eth0_ip_filters_do_not_exist +=
+      hostEth0Classifiers.size() - hostEth0ToVeth.get();
 
-    LOG(ERROR) << "The IP packet filter from host " << eth0
-               << " to " << veth << " does not exist";
+    LOG(ERROR) << "Some of the IP packet filters from host " << eth0
+               << " to " << veth << " do not exist";
   }
 
-  // Remove the IP packet filter from host lo to veth of the container.
-  Try<bool> hostLoToVeth = filter::ip::remove(
-      lo,
-      ingress::HANDLE,
-      ip::Classifier(None(), None(), None(), range));
+  Try<size_t> hostLoToVeth =
+    filter::ip::remove(lo, ingress::HANDLE, hostLoClassifiers);
 
   if (hostLoToVeth.isError()) {
     ++metrics.removing_lo_ip_filters_errors;
 
     return Error(
-        "Failed to remove the IP packet filter from host " +
+        "Failed to remove the IP packet filters from host " +
         lo + " to " + veth + ": " + hostLoToVeth.error());
-  } else if (!hostLoToVeth.get()) {
-    ++metrics.removing_lo_ip_filters_do_not_exist;
+  } else if (hostLoToVeth.get() < hostLoClassifiers.size()) {
+    metrics.removing_lo_ip_filters_do_not_exist +=
+      hostLoClassifiers.size() - hostLoToVeth.get();
 
-    LOG(ERROR) << "The IP packet filter from host " << lo
-               << " to " << veth << " does not exist";
+    LOG(ERROR) << "Some of the IP packet filters from host " << lo
+               << " to " << veth << " do not exist";
   }
 
   if (flags.egress_unique_flow_per_container) {
-    // Remove the egress flow classifier on host eth0.
-    Try<bool> hostEth0Egress = filter::ip::remove(
+    Try<size_t> hostEth0Egress = filter::ip::remove(
         eth0,
         hostTxFqCodelHandle,
-        ip::Classifier(None(), None(), range, None()));
+        hostEth0EgressClassifiers);
 
     if (hostEth0Egress.isError()) {
       ++metrics.removing_eth0_egress_filters_errors;
 
       return Error(
-          "Failed to remove the flow classifier from host " +
+          "Failed to remove the flow classifiers from host " +
           eth0 + " for " + veth + ": " + hostEth0Egress.error());
-    } else if (!hostEth0Egress.get()) {
-      ++metrics.removing_eth0_egress_filters_do_not_exist;
+    } else if (hostEth0Egress.get() < hostEth0EgressClassifiers.size()) {
+      metrics.removing_eth0_egress_filters_do_not_exist +=
+        hostEth0EgressClassifiers.size() - hostEth0Egress.get();
 
-      LOG(ERROR) << "The flow classifier from host " << eth0
-                 << " for " << range << " does not exist";
+      LOG(ERROR) << "Some of the flow classifiers from host " << eth0
+                 << " for " << veth << " do not exist";
     }
   }
 
@@ -3471,68 +3666,21 @@ Try<Nothing> PortMappingIsolatorProcess::removeHostIPFilters(
     return Nothing();
   }
 
-  // Remove the IP packet filter from veth of the container to
-  // host lo for the public IP.
-  Try<bool> vethToHostLoPublic = filter::ip::remove(
-      veth,
-      ingress::HANDLE,
-      ip::Classifier(None(), hostIPNetwork.address(), range, None()));
-
-  if (vethToHostLoPublic.isError()) {
-    ++metrics.removing_lo_ip_filters_errors;
-
-    return Error(
-        "Failed to remove the IP packet filter (for public IP) from " +
-        veth + " to host " + lo + ": " + vethToHostLoPublic.error());
-  } else if (!vethToHostLoPublic.get()) {
-    ++metrics.removing_lo_ip_filters_do_not_exist;
-
-    LOG(ERROR) << "The IP packet filter (for public IP) from "
-               << veth << " to host " << lo << " does not exist";
-  }
-
-  // Remove the IP packet filter from veth of the container to
-  // host lo for the loopback IP.
-  Try<bool> vethToHostLoLoopback = filter::ip::remove(
-      veth,
-      ingress::HANDLE,
-      ip::Classifier(
-          None(),
-          net::IPNetwork::LOOPBACK_V4().address(),
-          range,
-          None()));
-
-  if (vethToHostLoLoopback.isError()) {
-    ++metrics.removing_veth_ip_filters_errors;
-
-    return Error(
-        "Failed to remove the IP packet filter (for loopback IP) from " +
-        veth + " to host " + lo + ": " + vethToHostLoLoopback.error());
-  } else if (!vethToHostLoLoopback.get()) {
-    ++metrics.removing_veth_ip_filters_do_not_exist;
-
-    LOG(ERROR) << "The IP packet filter (for loopback IP) from "
-               << veth << " to host " << lo << " does not exist";
-  }
-
-  // Remove the IP packet filter from veth of the container to
-  // host eth0.
-  Try<bool> vethToHostEth0 = filter::ip::remove(
-      veth,
-      ingress::HANDLE,
-      ip::Classifier(None(), None(), range, None()));
+  Try<size_t> vethToHost =
+    filter::ip::remove(veth, ingress::HANDLE, vethClassifiers);
 
-  if (vethToHostEth0.isError()) {
+  if (vethToHost.isError()) {
     ++metrics.removing_veth_ip_filters_errors;
 
     return Error(
-        "Failed to remove the IP packet filter from " + veth +
-        " to host " + eth0 + ": " + vethToHostEth0.error());
-  } else if (!vethToHostEth0.get()) {
-    ++metrics.removing_veth_ip_filters_do_not_exist;
-
-    LOG(ERROR) << "The IP packet filter from " << veth
-               << " to host " << eth0 << " does not exist";
+        "Failed to remove the IP packet filters from " + veth +
+        " to host " + eth0 + " and " + lo + ": " + vethToHost.error());
+  } else if (vethToHost.get() < vethClassifiers.size()) {
+    metrics.removing_veth_ip_filters_do_not_exist +=
+      vethClassifiers.size() - vethToHost.get();
+
+    LOG(ERROR) << "Some of the IP packet filters from " << veth
+               << " to host " << eth0 << " and " << lo << " do not exist";
   }
 
   return Nothing();
@@ -27,6 +27,7 @@
 
 #include <process/owned.hpp>
 #include <process/subprocess.hpp>
+#include <process/time.hpp>
 
 #include <process/metrics/metrics.hpp>
 #include <process/metrics/counter.hpp>
@@ -39,6 +40,7 @@
 #include <stout/mac.hpp>
 #include <stout/none.hpp>
 #include <stout/option.hpp>
+#include <stout/result.hpp>
 #include <stout/subcommand.hpp>
 
 #include "linux/routing/filter/ip.hpp"
@@ -76,6 +78,9 @@ inline std::string PORT_MAPPING_BIND_MOUNT_SYMLINK_ROOT()
 // output for each of the Linux Traffic Control Qdiscs we report.
 constexpr char NET_ISOLATOR_BW_LIMIT[] = "bw_limit";
 constexpr char NET_ISOLATOR_BLOAT_REDUCTION[] = "bloat_reduction";
+constexpr char NET_ISOLATOR_INGRESS_BW_LIMIT[] = "ingress_bw_limit";
+constexpr char NET_ISOLATOR_INGRESS_BLOAT_REDUCTION[] =
+  "ingress_bloat_reduction";
 
 
 // Responsible for allocating ephemeral ports for the port mapping
@@ -258,6 +263,7 @@ private:
       const routing::Handle& _hostTxFqCodelHandle,
       const hashmap<std::string, std::string>& _hostNetworkConfigurations,
       const Option<Bytes>& _egressRateLimitPerContainer,
+      const Option<Bytes>& _ingressRateLimitPerContainer,
       const IntervalSet<uint16_t>& _managedNonEphemeralPorts,
       const process::Owned<EphemeralPortsAllocator>& _ephemeralPortsAllocator,
       const std::set<uint16_t>& _flowIDs)
@@ -271,6 +277,7 @@ private:
       hostTxFqCodelHandle(_hostTxFqCodelHandle),
       hostNetworkConfigurations(_hostNetworkConfigurations),
       egressRateLimitPerContainer(_egressRateLimitPerContainer),
+      ingressRateLimitPerContainer(_ingressRateLimitPerContainer),
       managedNonEphemeralPorts(_managedNonEphemeralPorts),
       ephemeralPortsAllocator(_ephemeralPortsAllocator),
       freeFlowIds(_flowIDs) {}
@@ -291,14 +298,20 @@ private:
       ResourceStatistics result,
       const process::Future<std::string>& out);
 
+  // Returns the statistics of a link on the host, e.g., the host end
+  // of the veth of a container, from a dump of all the links that is
+  // shared by the 'usage' calls made shortly after each other.
+  Result<hashmap<std::string, uint64_t>> linkStatistics(
+      const std::string& link);
+
   // Helper functions.
   Try<Nothing> addHostIPFilters(
-      const routing::filter::ip::PortRange& range,
+      const std::vector<routing::filter::ip::PortRange>& ranges,
       const Option<uint16_t>& flowId,
       const std::string& veth);
 
   Try<Nothing> removeHostIPFilters(
-      const routing::filter::ip::PortRange& range,
+      const std::vector<routing::filter::ip::PortRange>& ranges,
       const std::string& veth,
       bool removeFiltersOnVeth = true);
 
@@ -325,6 +338,9 @@ private:
   // The optional throughput limit to containers' egress traffic.
   const Option<Bytes> egressRateLimitPerContainer;
 
+  // The optional throughput limit to containers' ingress traffic.
+  const Option<Bytes> ingressRateLimitPerContainer;
+
   // All the non-ephemeral ports managed by the slave, as passed in
   // via flags.resources.
   const IntervalSet<uint16_t> managedNonEphemeralPorts;
@@ -339,6 +355,15 @@ private:
   // Recovered containers from a previous run that weren't managed by
   // the network isolator.
   hashset<ContainerID> unmanaged;
+
+  // The last dump of the statistics of the links on the host.
+  struct Links
+  {
+    process::Time timestamp;
+    hashmap<std::string, hashmap<std::string, uint64_t>> statistics;
+  };
+
+  Option<Links> links;
 };
 
 
@@ -17,6 +17,8 @@
 #ifndef __POSIX_ISOLATOR_HPP__
 #define __POSIX_ISOLATOR_HPP__
 
+#include <set>
+
 #include <process/future.hpp>
 
 #include <stout/hashmap.hpp>
@@ -28,6 +30,10 @@
 
 #include "slave/containerizer/mesos/isolator.hpp"
 
+#ifdef __linux__
+#include "slave/containerizer/mesos/process_tracker.hpp"
+#endif // __linux__
+
 #include "usage/usage.hpp"
 
 namespace mesos {
@@ -40,6 +46,8 @@ namespace slave {
 class PosixIsolatorProcess : public MesosIsolatorProcess
 {
 public:
+  virtual bool ordered() const { return false; }
+
   virtual process::Future<Nothing> recover(
       const std::list<mesos::slave::ContainerState>& state,
       const hashset<ContainerID>& orphans)
@@ -130,6 +138,42 @@ public:
   }
 
 protected:
+  // Collects the usage of the processes of a container. They are
+  // taken from the process tracker if it tracks the container (i.e.,
+  // the container was launched by the posix launcher), and otherwise
+  // found by walking '/proc'.
+  process::Future<ResourceStatistics> _usage(
+      const ContainerID& containerId,
+      bool mem,
+      bool cpus)
+  {
+    const pid_t pid = pids.get(containerId).get();
+
+#ifdef __linux__
+    Try<ProcessTracker*> tracker = ProcessTracker::instance();
+    if (tracker.isSome()) {
+      return tracker.get()->pids(containerId)
+        .then([=](const Option<std::set<pid_t>>& tracked)
+            -> process::Future<ResourceStatistics> {
+          Try<ResourceStatistics> usage = tracked.isSome()
+            ? mesos::internal::usage(tracked.get(), mem, cpus)
+            : mesos::internal::usage(pid, mem, cpus);
+
+          if (usage.isError()) {
+            return process::Failure(usage.error());
+          }
+          return usage.get();
+        });
+    }
+#endif // __linux__
+
+    Try<ResourceStatistics> usage = mesos::internal::usage(pid, mem, cpus);
+    if (usage.isError()) {
+      return process::Failure(usage.error());
+    }
+    return usage.get();
+  }
+
   hashmap<ContainerID, pid_t> pids;
   hashmap<ContainerID,
           process::Owned<process::Promise<mesos::slave::ContainerLimitation>>>
@@ -158,12 +202,7 @@ public:
     }
 
     // Use 'mesos-usage' but only request 'cpus_' values.
-    Try<ResourceStatistics> usage =
-      mesos::internal::usage(pids.get(containerId).get(), false, true);
-    if (usage.isError()) {
-      return process::Failure(usage.error());
-    }
-    return usage.get();
+    return _usage(containerId, false, true);
   }
 
 private:
@@ -192,12 +231,7 @@ public:
     }
 
     // Use 'mesos-usage' but only request 'mem_' values.
-    Try<ResourceStatistics> usage =
-      mesos::internal::usage(pids.get(containerId).get(), true, false);
-    if (usage.isError()) {
-      return process::Failure(usage.error());
-    }
-    return usage.get();
+    return _usage(containerId, true, false);
   }
 
 private:
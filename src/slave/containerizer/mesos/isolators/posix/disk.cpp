@@ -14,36 +14,34 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <signal.h>
+#include <fts.h>
 
-#ifdef __linux__
-#include <sys/prctl.h>
-#endif
+#include <sys/stat.h>
 #include <sys/types.h>
 
 #include <deque>
-#include <tuple>
+#include <set>
+#include <utility>
 
 #include <glog/logging.h>
 
+#include <process/async.hpp>
 #include <process/check.hpp>
-#include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/delay.hpp>
-#include <process/io.hpp>
-#include <process/subprocess.hpp>
 
 #include <stout/check.hpp>
 #include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
-#include <stout/numify.hpp>
-#include <stout/strings.hpp>
 
 #include <stout/os/exists.hpp>
-#include <stout/os/killtree.hpp>
+#include <stout/os/strerror.hpp>
 
 #include "common/protobuf_utils.hpp"
 
+#include "slave/constants.hpp"
+#include "slave/paths.hpp"
+
 #include "slave/containerizer/mesos/isolators/posix/disk.hpp"
 
 using namespace process;
@@ -64,8 +62,6 @@ namespace slave {
 
 Try<Isolator*> PosixDiskIsolatorProcess::create(const Flags& flags)
 {
-  // TODO(jieyu): Check the availability of command 'du'.
-
   return new MesosIsolator(process::Owned<MesosIsolatorProcess>(
         new PosixDiskIsolatorProcess(flags)));
 }
@@ -170,6 +166,17 @@ Future<Nothing> PosixDiskIsolatorProcess::update(
     if (!resource.has_disk()) {
       // Regular disk used for executor working directory.
       path = info->directory;
+    } else if (resource.disk().has_source() &&
+               resource.disk().source().type() ==
+                 Resource::DiskInfo::Source::MOUNT) {
+      // A MOUNT disk is used as a whole, its filesystem enforces the
+      // quota already.
+      continue;
+    } else if (resource.disk().has_source() &&
+               resource.disk().has_persistence()) {
+      // A persistent volume on a PATH disk shares the disk with the
+      // other volumes on it.
+      path = paths::getPersistentVolumePath(flags.work_dir, resource);
     } else {
       // TODO(jieyu): Support persistent volmes as well.
       LOG(ERROR) << "Enforcing disk quota unsupported for " << resource;
@@ -308,10 +315,77 @@ Future<Nothing> PosixDiskIsolatorProcess::cleanup(
 }
 
 
+// Returns the disk usage of the files rooted at 'path', i.e., the
+// blocks they occupy, the same as 'du -s' reports. Files with multiple
+// hard links are only counted once. Files that are removed while we
+// walk the tree are skipped.
+static Try<Bytes> diskUsage(const string& path)
+{
+  Bytes bytes;
+  Option<Error> error;
+
+  // The inodes of the files with multiple hard links seen so far.
+  std::set<std::pair<dev_t, ino_t>> links;
+
+  char* paths[] = {const_cast<char*>(path.c_str()), NULL};
+
+  FTS* tree = fts_open(paths, FTS_NOCHDIR | FTS_PHYSICAL, NULL);
+  if (tree == NULL) {
+    return ErrnoError("Failed to open '" + path + "'");
+  }
+
+  FTSENT* node;
+  while (error.isNone() && (node = fts_read(tree)) != NULL) {
+    switch (node->fts_info) {
+      case FTS_D:
+      case FTS_DNR:
+      case FTS_F:
+      case FTS_SL:
+      case FTS_SLNONE:
+      case FTS_DEFAULT: {
+        const struct stat* s = node->fts_statp;
+
+        if (!S_ISDIR(s->st_mode) && s->st_nlink > 1 &&
+            !links.insert(std::make_pair(s->st_dev, s->st_ino)).second) {
+          break;
+        }
+
+        bytes += Bytes(s->st_blocks * 512);
+        break;
+      }
+      case FTS_NS:
+      case FTS_ERR:
+        if (node->fts_errno != ENOENT ||
+            node->fts_level == FTS_ROOTLEVEL) {
+          error = Error("Failed to stat '" + string(node->fts_path) + "': " +
+                        os::strerror(node->fts_errno));
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  if (error.isNone() && errno != 0) {
+    error = ErrnoError("Failed to walk '" + path + "'");
+  }
+
+  fts_close(tree);
+
+  if (error.isSome()) {
+    return error.get();
+  }
+
+  return bytes;
+}
+
+
 class DiskUsageCollectorProcess : public Process<DiskUsageCollectorProcess>
 {
 public:
-  DiskUsageCollectorProcess(const Duration& _interval) : interval(_interval) {}
+  DiskUsageCollectorProcess(const Duration& _interval)
+    : interval(_interval), running(0), scheduled(false) {}
+
   virtual ~DiskUsageCollectorProcess() {}
 
   Future<Bytes> usage(const string& path)
@@ -339,11 +413,9 @@ protected:
 
   void finalize()
   {
+    // NOTE: The checks that are still running are left to finish on
+    // their own, their results are dropped.
     foreach (const Owned<Entry>& entry, entries) {
-      if (entry->du.isSome() && entry->du.get().status().isPending()) {
-        os::killtree(entry->du.get().pid(), SIGKILL);
-      }
-
       entry->promise.fail("DiskUsageCollector is destroyed");
     }
   }
@@ -352,32 +424,18 @@ private:
   // Describe a single pending check.
   struct Entry
   {
-    explicit Entry(const string& _path) : path(_path) {}
+    explicit Entry(const string& _path) : path(_path), started(false) {}
 
     string path;
-    Option<Subprocess> du;
+    bool started;
     Promise<Bytes> promise;
   };
 
-  // This function is invoked right before each 'du' is exec'ed. Note
-  // that this function needs to be async signal safe.
-  static int setupChild()
-  {
-#ifdef __linux__
-    // Kill the child process if the parent exits.
-    // NOTE: This function should never returns non-zero because we
-    // are passing in a valid signal.
-    return ::prctl(PR_SET_PDEATHSIG, SIGKILL);
-#else
-    return 0;
-#endif
-  }
-
   void discard(const string& path)
   {
     for (auto it = entries.begin(); it != entries.end(); ++it) {
-      // We only cancel those checks whose 'du' haven't been launched.
-      if ((*it)->path == path && (*it)->du.isNone()) {
+      // We only cancel those checks that haven't been started.
+      if ((*it)->path == path && !(*it)->started) {
         (*it)->promise.discard();
         entries.erase(it);
         break;
@@ -385,116 +443,84 @@ private:
     }
   }
 
-  // Schedule a 'du' to be invoked. The current implementation does
-  // not allow multiple 'du's running concurrently. The minimal
-  // interval between two subsequent 'du's is controlled by 'interval'
-  // for throttling purpose.
+  // Starts the checks that are pending, up to
+  // DISK_USAGE_MAX_CONCURRENT_CHECKS at the same time. The checks walk
+  // the directory trees in the slave, on the threads of 'async', and
+  // each of them is followed by 'interval' before the next one for
+  // throttling purpose.
+  //
+  // NOTE: The checks run in the slave's cgroup and it will be that
+  // cgroup that is charged for (a) memory to cache the fs data
+  // structures, (b) disk I/O to read those structures, and (c) the
+  // cpu time to traverse.
   void schedule()
   {
-    if (entries.empty()) {
-      delay(interval, self(), &Self::schedule);
-      return;
-    }
+    scheduled = false;
 
-    const Owned<Entry>& entry = entries.front();
-
-    // Invoke 'du' and report number of 1K-byte blocks. We fix the
-    // block size here so that we can get consistent results on all
-    // platforms (e.g., OS X uses 512 byte blocks).
-    //
-    // NOTE: The 'du' processes are run in the slave's cgroup and it
-    // will be that cgroup that is charged for (a) memory to cache the
-    // fs data structures, (b) disk I/O to read those structures, and
-    // (c) the cpu time to traverse.
-    Try<Subprocess> s = subprocess(
-        "du",
-        vector<string>({"du", "-k", "-s", entry->path}),
-        Subprocess::PATH("/dev/null"),
-        Subprocess::PIPE(),
-        Subprocess::PIPE(),
-        None(),
-        None(),
-        setupChild);
-
-    if (s.isError()) {
-      entry->promise.fail("Failed to exec 'du': " + s.error());
-
-      entries.pop_front();
-      delay(interval, self(), &Self::schedule);
-      return;
-    }
+    foreach (const Owned<Entry>& entry, entries) {
+      if (running >= DISK_USAGE_MAX_CONCURRENT_CHECKS) {
+        break;
+      }
+
+      if (!entry->started) {
+        entry->started = true;
+        running++;
 
-    entry->du = s.get();
+        async(&diskUsage, entry->path)
+          .onAny(defer(self(), &Self::_schedule, entry.get(), lambda::_1));
+      }
+    }
 
-    await(s.get().status(),
-          io::read(s.get().out().get()),
-          io::read(s.get().err().get()))
-      .onAny(defer(self(), &Self::_schedule, lambda::_1));
+    if (running == 0) {
+      reschedule();
+    }
   }
 
-  void _schedule(const Future<std::tuple<
-      Future<Option<int>>,
-      Future<string>,
-      Future<string>>>& future)
+  void _schedule(Entry* entry, const Future<Try<Bytes>>& future)
   {
-    CHECK_READY(future);
-    CHECK(!entries.empty());
-
-    const Owned<Entry>& entry = entries.front();
-    CHECK_SOME(entry->du);
-
-    Future<Option<int>> status = std::get<0>(future.get());
+    CHECK_GT(running, 0u);
+    running--;
 
-    if (!status.isReady()) {
+    if (!future.isReady()) {
       entry->promise.fail(
-          "Failed to perform 'du': " +
-          (status.isFailed() ? status.failure() : "discarded"));
-    } else if (status.get().isNone()) {
-      entry->promise.fail("Failed to reap the status of 'du'");
-    } else if (status.get().get() != 0) {
-      Future<string> error = std::get<2>(future.get());
-      if (!error.isReady()) {
-        entry->promise.fail(
-            "Failed to perform 'du'. Reading stderr failed: " +
-            (error.isFailed() ? error.failure() : "discarded"));
-      } else {
-        entry->promise.fail("Failed to perform 'du': " + error.get());
-      }
+          "Failed to check the disk usage: " +
+          (future.isFailed() ? future.failure() : "discarded"));
+    } else if (future.get().isError()) {
+      entry->promise.fail(
+          "Failed to check the disk usage: " + future.get().error());
     } else {
-      Future<string> output = std::get<1>(future.get());
-      if (!output.isReady()) {
-        entry->promise.fail(
-            "Failed to read stdout from 'du': " +
-            (output.isFailed() ? output.failure() : "discarded"));
-      } else {
-        // Parsing the output from 'du'. The following is a sample
-        // output. Tab is used as the delimiter between the number of
-        // blocks and the checked path.
-        // $ du /var/lib/mesos/.../runs/container_id
-        // 1024   /var/lib/mesos/.../runs/container_id
-        vector<string> tokens = strings::tokenize(output.get(), " \t");
-        if (tokens.empty()) {
-          entry->promise.fail("Unexpected output from 'du': " + output.get());
-        } else {
-          Try<size_t> value = numify<size_t>(tokens[0]);
-          if (value.isError()) {
-            entry->promise.fail("Unexpected output from 'du': " + output.get());
-          } else {
-            // Notify the callers.
-            entry->promise.set(Kilobytes(value.get()));
-          }
-        }
+      // Notify the callers.
+      entry->promise.set(future.get().get());
+    }
+
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+      if (it->get() == entry) {
+        entries.erase(it);
+        break;
       }
     }
 
-    entries.pop_front();
-    delay(interval, self(), &Self::schedule);
+    reschedule();
+  }
+
+  void reschedule()
+  {
+    if (!scheduled) {
+      scheduled = true;
+      delay(interval, self(), &Self::schedule);
+    }
   }
 
   const Duration interval;
 
-  // A queue of pending checks.
+  // A queue of pending checks, including those that are running.
   deque<Owned<Entry>> entries;
+
+  // The number of checks that are running.
+  size_t running;
+
+  // Whether 'schedule' is going to be invoked.
+  bool scheduled;
 };
 
 
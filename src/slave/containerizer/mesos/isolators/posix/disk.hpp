@@ -58,13 +58,13 @@ private:
 // This isolator monitors the disk usage for containers, and reports
 // ContainerLimitation when a container exceeds its disk quota. This
 // leverages the DiskUsageCollector to ensure that we don't induce too
-// much CPU usage and disk caching effects from running 'du' too
-// often.
+// much CPU usage and disk caching effects from walking the sandboxes
+// too often.
 //
 // NOTE: Currently all containers are processed in the same queue,
 // which means that when a container starts, it could take many disk
-// collection intervals until any data is available in the resource
-// usage statistics!
+// collection intervals (divided by the number of concurrent checks)
+// until any data is available in the resource usage statistics!
 //
 // TODO(jieyu): Consider handling each container independently, or
 // triggering an initial collection when the container starts, to
@@ -76,6 +76,8 @@ public:
 
   virtual ~PosixDiskIsolatorProcess();
 
+  virtual bool ordered() const { return false; }
+
   virtual process::Future<Nothing> recover(
       const std::list<mesos::slave::ContainerState>& states,
       const hashset<ContainerID>& orphans);
@@ -29,6 +29,10 @@
 
 #include "slave/containerizer/mesos/launcher.hpp"
 
+#ifdef __linux__
+#include "slave/containerizer/mesos/process_tracker.hpp"
+#endif // __linux__
+
 using namespace process;
 
 using std::list;
@@ -45,7 +49,19 @@ namespace slave {
 
 Try<Launcher*> PosixLauncher::create(const Flags& flags)
 {
-  return new PosixLauncher();
+  Option<ProcessTracker*> tracker = None();
+
+#ifdef __linux__
+  Try<ProcessTracker*> instance = ProcessTracker::instance();
+  if (instance.isError()) {
+    LOG(INFO) << "Not tracking the processes of the containers through "
+              << "the proc connector: " << instance.error();
+  } else {
+    tracker = instance.get();
+  }
+#endif // __linux__
+
+  return new PosixLauncher(tracker);
 }
 
 
@@ -69,6 +85,12 @@ Future<hashset<ContainerID>> PosixLauncher::recover(
     }
 
     pids.put(containerId, pid);
+
+#ifdef __linux__
+    if (tracker.isSome()) {
+      tracker.get()->track(containerId, pid);
+    }
+#endif // __linux__
   }
 
   return hashset<ContainerID>();
@@ -135,6 +157,12 @@ Try<pid_t> PosixLauncher::fork(
   // Store the pid (session id and process group id).
   pids.put(containerId, child.get().pid());
 
+#ifdef __linux__
+  if (tracker.isSome()) {
+    tracker.get()->track(containerId, child.get().pid());
+  }
+#endif // __linux__
+
   return child.get().pid();
 }
 
@@ -151,11 +179,32 @@ Future<Nothing> PosixLauncher::destroy(const ContainerID& containerId)
 
   pid_t pid = pids.get(containerId).get();
 
-  // Kill all processes in the session and process group.
-  Try<list<os::ProcessTree>> trees = os::killtree(pid, SIGKILL, true, true);
-
   pids.erase(containerId);
 
+#ifdef __linux__
+  if (tracker.isSome()) {
+    ProcessTracker* tracker = this->tracker.get();
+
+    // The tracker keeps killing the processes forked into the
+    // container until it is untracked, after the child is reaped.
+    return tracker->kill(containerId, SIGKILL)
+      .then([=](bool killed) {
+        if (!killed) {
+          // The tracker stopped receiving events, so fall back to
+          // killing all processes in the session and process group.
+          os::killtree(pid, SIGKILL, true, true);
+        }
+
+        return process::reap(pid);
+      })
+      .then(lambda::bind(&_destroy, lambda::_1))
+      .onAny([=]() { tracker->untrack(containerId); });
+  }
+#endif // __linux__
+
+  // Kill all processes in the session and process group.
+  os::killtree(pid, SIGKILL, true, true);
+
   // The child process may not have been waited on yet so we'll delay
   // completing destroy until we're sure it has been reaped.
   return process::reap(pid)
@@ -78,6 +78,10 @@ public:
 };
 
 
+// Forward declaration.
+class ProcessTracker;
+
+
 // Launcher suitable for any POSIX compliant system. Uses process
 // groups and sessions to track processes in a container. POSIX states
 // that process groups cannot migrate between sessions so all
@@ -107,11 +111,16 @@ public:
   virtual process::Future<Nothing> destroy(const ContainerID& containerId);
 
 private:
-  PosixLauncher() {}
+  explicit PosixLauncher(const Option<ProcessTracker*>& _tracker)
+    : tracker(_tracker) {}
 
   // The 'pid' is the process id of the first process and also the
   // process group id and session id.
   hashmap<ContainerID, pid_t> pids;
+
+  // Tracks the processes of the containers, if the proc connector is
+  // available, so that destroying a container does not walk '/proc'.
+  const Option<ProcessTracker*> tracker;
 };
 
 } // namespace slave {
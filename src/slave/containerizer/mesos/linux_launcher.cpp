@@ -37,6 +37,7 @@
 #include "mesos/resources.hpp"
 
 #include "slave/containerizer/mesos/linux_launcher.hpp"
+#include "slave/containerizer/mesos/zygote.hpp"
 
 #include "slave/containerizer/mesos/isolators/namespaces/pid.hpp"
 
@@ -64,42 +65,110 @@ static ContainerID container(const string& cgroup)
 }
 
 
+// The cgroups operations of the launcher, on either the freezer
+// hierarchy or the unified hierarchy.
+
+static Try<bool> exists(
+    bool unified,
+    const string& hierarchy,
+    const string& cgroup)
+{
+  return unified
+    ? cgroups::unified::exists(hierarchy, cgroup)
+    : cgroups::exists(hierarchy, cgroup);
+}
+
+
+static Try<Nothing> create(
+    bool unified,
+    const string& hierarchy,
+    const string& cgroup)
+{
+  return unified
+    ? cgroups::unified::create(hierarchy, cgroup)
+    : cgroups::create(hierarchy, cgroup);
+}
+
+
+static Try<Nothing> assign(
+    bool unified,
+    const string& hierarchy,
+    const string& cgroup,
+    pid_t pid)
+{
+  return unified
+    ? cgroups::unified::assign(hierarchy, cgroup, pid)
+    : cgroups::assign(hierarchy, cgroup, pid);
+}
+
+
+static Future<Nothing> destroy(
+    bool unified,
+    const string& hierarchy,
+    const string& cgroup)
+{
+  return unified
+    ? cgroups::unified::destroy(hierarchy, cgroup, cgroups::DESTROY_TIMEOUT)
+    : cgroups::destroy(hierarchy, cgroup, cgroups::DESTROY_TIMEOUT);
+}
+
+
 // `_systemdHierarchy` is only set if running on a systemd environment.
 LinuxLauncher::LinuxLauncher(
     const Flags& _flags,
-    const string& _freezerHierarchy,
-    const Option<string>& _systemdHierarchy)
+    const string& _hierarchy,
+    const Option<string>& _systemdHierarchy,
+    const Option<Owned<Zygote>>& _zygote)
   : flags(_flags),
-    freezerHierarchy(_freezerHierarchy),
-    systemdHierarchy(_systemdHierarchy) {}
+    hierarchy(_hierarchy),
+    systemdHierarchy(_systemdHierarchy),
+    zygote(_zygote) {}
 
 
 Try<Launcher*> LinuxLauncher::create(const Flags& flags)
 {
-  Try<string> freezerHierarchy = cgroups::prepare(
-      flags.cgroups_hierarchy,
-      "freezer",
-      flags.cgroups_root);
+  Try<string> hierarchy = Error("Unknown hierarchy");
+
+  if (flags.cgroups_unified) {
+    // The launcher only needs the cgroups to track the processes, so
+    // it does not enable any controller.
+    hierarchy = cgroups::unified::prepare(
+        path::join(flags.cgroups_hierarchy, "unified"),
+        flags.cgroups_root,
+        set<string>());
+
+    if (hierarchy.isError()) {
+      return Error("Failed to create Linux launcher: " + hierarchy.error());
+    }
 
-  if (freezerHierarchy.isError()) {
-    return Error(
-        "Failed to create Linux launcher: " + freezerHierarchy.error());
-  }
+    LOG(INFO) << "Using " << hierarchy.get()
+              << " as the unified hierarchy for the Linux launcher";
+  } else {
+    hierarchy = cgroups::prepare(
+        flags.cgroups_hierarchy,
+        "freezer",
+        flags.cgroups_root);
 
-  // Ensure that no other subsystem is attached to the freezer hierarchy.
-  Try<set<string>> subsystems = cgroups::subsystems(freezerHierarchy.get());
-  if (subsystems.isError()) {
-    return Error(
-        "Failed to get the list of attached subsystems for hierarchy " +
-        freezerHierarchy.get());
-  } else if (subsystems.get().size() != 1) {
-    return Error(
-        "Unexpected subsystems found attached to the hierarchy " +
-        freezerHierarchy.get());
-  }
+    if (hierarchy.isError()) {
+      return Error("Failed to create Linux launcher: " + hierarchy.error());
+    }
 
-  LOG(INFO) << "Using " << freezerHierarchy.get()
-            << " as the freezer hierarchy for the Linux launcher";
+    // Ensure that no other subsystem is attached to the freezer
+    // hierarchy.
+    Try<set<string>> subsystems = cgroups::subsystems(hierarchy.get());
+    if (subsystems.isError()) {
+      return Error(
+          "Failed to get the list of attached subsystems for hierarchy " +
+          hierarchy.get());
+    } else if (subsystems.get().size() != 1) {
+      return Error(
+          "Unexpected subsystems found attached to the hierarchy " +
+          hierarchy.get());
+    }
+
+    LOG(INFO) << "Using " << hierarchy.get()
+              << " as the freezer hierarchy for the Linux launcher";
+  }
 
   // On systemd environments we currently migrate executor pids into a separate
   // executor slice. This allows the life-time of the executor to be extended
@@ -167,20 +236,41 @@ Try<Launcher*> LinuxLauncher::create(const Flags& flags)
     }
   }
 
+  // Start the zygote now, while the agent is still small, see
+  // 'MesosContainerizerZygote'.
+  Option<Owned<Zygote>> zygote;
+
+  if (flags.launcher_zygote) {
+    Try<Owned<Zygote>> create =
+      Zygote::create(path::join(flags.launcher_dir, "mesos-containerizer"));
+
+    if (create.isError()) {
+      return Error("Failed to create the zygote: " + create.error());
+    }
+
+    zygote = create.get();
+  }
+
   return new LinuxLauncher(
       flags,
-      freezerHierarchy.get(),
+      hierarchy.get(),
       systemd::exists() ?
         Some(systemd::hierarchy()) :
-        Option<std::string>::none());
+        Option<std::string>::none(),
+      zygote);
 }
 
 
-bool LinuxLauncher::available()
+bool LinuxLauncher::available(const Flags& flags)
 {
   // Make sure:
   //   - we run as root
-  //   - "freezer" subsytem is enabled.
+  //   - "freezer" subsytem is enabled, or the unified hierarchy is
+  //     supported if it is to be used.
+
+  if (flags.cgroups_unified) {
+    return ::geteuid() == 0 && cgroups::unified::enabled();
+  }
 
   Try<bool> freezer = cgroups::enabled("freezer");
   return ::geteuid() == 0 &&
@@ -232,7 +322,14 @@ Future<hashset<ContainerID>> LinuxLauncher::recover(
     // destroy() when we clean up.
     pids.put(containerId, pid);
 
-    Try<bool> exists = cgroups::exists(freezerHierarchy, cgroup(containerId));
+    Try<bool> exists =
+      slave::exists(flags.cgroups_unified, hierarchy, cgroup(containerId));
+
+    if (exists.isError()) {
+      return Failure(
+          "Failed to check existence of cgroup for container " +
+          stringify(containerId) + ": " + exists.error());
+    }
 
     if (!exists.get()) {
       // This may occur if the freezer cgroup was destroyed but the
@@ -264,8 +361,9 @@ Future<hashset<ContainerID>> LinuxLauncher::recover(
   }
 
   // Return the set of orphan containers.
-  Try<vector<string>> cgroups =
-    cgroups::get(freezerHierarchy, flags.cgroups_root);
+  Try<vector<string>> cgroups = flags.cgroups_unified
+    ? cgroups::unified::get(hierarchy, flags.cgroups_root)
+    : cgroups::get(hierarchy, flags.cgroups_root);
 
   if (cgroups.isError()) {
     return Failure(cgroups.error());
@@ -321,6 +419,112 @@ static int childSetup(
 }
 
 
+// Returns a file descriptor, owned by the caller, which redirects a
+// standard stream of a child process like 'subprocess' does for the
+// given FD or PATH redirector.
+static Try<int> redirect(const Subprocess::IO& io, bool input)
+{
+  if (io.isFd()) {
+    int fd = ::dup(io.getFd().get());
+    if (fd == -1) {
+      return ErrnoError("Failed to dup");
+    }
+
+    return fd;
+  }
+
+  CHECK(io.isPath());
+
+  Try<int> open = input
+    ? os::open(io.getPath().get(), O_RDONLY | O_CLOEXEC)
+    : os::open(
+          io.getPath().get(),
+          O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+          S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  if (open.isError()) {
+    return Error(
+        "Failed to open '" + io.getPath().get() + "': " + open.error());
+  }
+
+  return open.get();
+}
+
+
+Try<pid_t> LinuxLauncher::zygoteFork(
+    const ContainerID& containerId,
+    const string& path,
+    vector<string> argv,
+    const process::Subprocess::IO& in,
+    const process::Subprocess::IO& out,
+    const process::Subprocess::IO& err,
+    const Option<flags::FlagsBase>& flags,
+    const Option<map<string, string>>& environment,
+    int cloneFlags)
+{
+  CHECK_SOME(zygote);
+
+  // Stringify the flags like 'subprocess' does.
+  if (flags.isSome()) {
+    foreachpair (const string& name, const flags::Flag& flag, flags.get()) {
+      Option<string> value = flag.stringify(flags.get());
+      if (value.isSome()) {
+        argv.push_back("--" + name + "=" + value.get());
+      }
+    }
+  }
+
+  map<string, string> cgroups;
+  map<string, string> unified;
+
+  if (this->flags.cgroups_unified) {
+    unified[hierarchy] = cgroup(containerId);
+  } else {
+    cgroups[hierarchy] = cgroup(containerId);
+  }
+
+  if (systemdHierarchy.isSome()) {
+    cgroups[systemdHierarchy.get()] = SYSTEMD_MESOS_EXECUTORS_SLICE;
+  }
+
+  vector<int> fds;
+
+  Try<int> redirected = redirect(in, true);
+  if (redirected.isSome()) {
+    fds.push_back(redirected.get());
+
+    redirected = redirect(out, false);
+    if (redirected.isSome()) {
+      fds.push_back(redirected.get());
+
+      redirected = redirect(err, false);
+      if (redirected.isSome()) {
+        fds.push_back(redirected.get());
+      }
+    }
+  }
+
+  Try<pid_t> pid = redirected.isError()
+    ? Error(redirected.error())
+    : zygote.get()->clone(
+          path,
+          argv,
+          fds[0],
+          fds[1],
+          fds[2],
+          environment,
+          cloneFlags,
+          cgroups,
+          unified);
+
+  foreach (int fd, fds) {
+    os::close(fd);
+  }
+
+  return pid;
+}
+
+
 Try<pid_t> LinuxLauncher::fork(
     const ContainerID& containerId,
     const string& path,
@@ -333,19 +537,23 @@ Try<pid_t> LinuxLauncher::fork(
     const Option<lambda::function<int()>>& setup,
     const Option<int>& namespaces)
 {
-  // Create a freezer cgroup for this container if necessary.
-  Try<bool> exists = cgroups::exists(freezerHierarchy, cgroup(containerId));
+  // NOTE: The 'flags' argument holds the flags of the child process.
+  const bool unified = this->flags.cgroups_unified;
+
+  // Create a cgroup for this container if necessary. In the unified
+  // hierarchy, the cgroups isolators have created it already.
+  Try<bool> exists = slave::exists(unified, hierarchy, cgroup(containerId));
+
   if (exists.isError()) {
-    return Error("Failed to check existence of freezer cgroup: " +
-                 exists.error());
+    return Error("Failed to check existence of cgroup: " + exists.error());
   }
 
   if (!exists.get()) {
     Try<Nothing> created =
-      cgroups::create(freezerHierarchy, cgroup(containerId));
+      slave::create(unified, hierarchy, cgroup(containerId));
 
     if (created.isError()) {
-      return Error("Failed to create freezer cgroup: " + created.error());
+      return Error("Failed to create cgroup: " + created.error());
     }
   }
 
@@ -360,6 +568,42 @@ Try<pid_t> LinuxLauncher::fork(
   int cloneFlags = namespaces.isSome() ? namespaces.get() : 0;
   cloneFlags |= SIGCHLD; // Specify SIGCHLD as child termination signal.
 
+  // The zygote cannot run a setup function, nor hand us the parent
+  // ends of pipes, so those children are still cloned by us.
+  if (zygote.isSome() &&
+      setup.isNone() &&
+      !in.isPipe() &&
+      !out.isPipe() &&
+      !err.isPipe()) {
+    LOG(INFO) << "Cloning child process with the zygote with flags = "
+              << ns::stringify(cloneFlags);
+
+    Try<pid_t> pid = zygoteFork(
+        containerId,
+        path,
+        argv,
+        in,
+        out,
+        err,
+        flags,
+        environment,
+        cloneFlags);
+
+    if (pid.isSome()) {
+      os::close(pipes[0]);
+      os::close(pipes[1]);
+
+      if (!pids.contains(containerId)) {
+        pids.put(containerId, pid.get());
+      }
+
+      return pid.get();
+    }
+
+    LOG(WARNING) << "Failed to clone child process with the zygote, "
+                 << "cloning it without: " << pid.error();
+  }
+
   LOG(INFO) << "Cloning child process with flags = "
             << ns::stringify(cloneFlags);
 
@@ -381,19 +625,20 @@ Try<pid_t> LinuxLauncher::fork(
   // Parent.
   os::close(pipes[0]);
 
-  // Move the child into the freezer cgroup. Any grandchildren will
-  // also be contained in the cgroup.
+  // Move the child into the cgroup. Any grandchildren will also be
+  // contained in the cgroup.
   // TODO(jieyu): Move this logic to the subprocess (i.e.,
   // mesos-containerizer launch).
-  Try<Nothing> assign = cgroups::assign(
-      freezerHierarchy,
+  Try<Nothing> assign = slave::assign(
+      unified,
+      hierarchy,
       cgroup(containerId),
       child.get().pid());
 
   if (assign.isError()) {
     LOG(ERROR) << "Failed to assign process " << child.get().pid()
                 << " of container '" << containerId << "'"
-                << " to its freezer cgroup: " << assign.error();
+                << " to its cgroup: " << assign.error();
 
     ::kill(child.get().pid(), SIGKILL);
     return Error("Failed to contain process");
@@ -455,16 +700,35 @@ Future<Nothing> LinuxLauncher::destroy(const ContainerID& containerId)
 
   // Just return if the cgroup was destroyed and the slave didn't receive the
   // notification. See comment in recover().
-  Try<bool> exists = cgroups::exists(freezerHierarchy, cgroup(containerId));
+  Try<bool> exists =
+    slave::exists(flags.cgroups_unified, hierarchy, cgroup(containerId));
+
   if (exists.isError()) {
-    return Failure("Failed to check existence of freezer cgroup: " +
-                   exists.error());
+    return Failure("Failed to check existence of cgroup: " + exists.error());
   }
 
   if (!exists.get()) {
     return Nothing();
   }
 
+  // The unified hierarchy tells whether any process is left in the
+  // cgroup, e.g., after the executor exited, in which case there is
+  // nothing to kill and the cgroup is only removed.
+  if (flags.cgroups_unified) {
+    Try<bool> populated =
+      cgroups::unified::populated(hierarchy, cgroup(containerId));
+
+    if (populated.isError()) {
+      return Failure(
+          "Failed to check whether the cgroup has processes: " +
+          populated.error());
+    }
+
+    if (!populated.get()) {
+      return slave::destroy(true, hierarchy, cgroup(containerId));
+    }
+  }
+
   Result<ino_t> containerPidNs =
     NamespacesPidIsolatorProcess::getNamespace(containerId);
 
@@ -473,19 +737,14 @@ Future<Nothing> LinuxLauncher::destroy(const ContainerID& containerId)
 
     return ns::pid::destroy(containerPidNs.get())
       .then(lambda::bind(
-            (Future<Nothing>(*)(const string&,
-                                const string&,
-                                const Duration&))(&cgroups::destroy),
-            freezerHierarchy,
-            cgroup(containerId),
-            cgroups::DESTROY_TIMEOUT));
+            &slave::destroy,
+            flags.cgroups_unified,
+            hierarchy,
+            cgroup(containerId)));
   }
 
-  // Try to clean up using just the freezer cgroup.
-  return cgroups::destroy(
-      freezerHierarchy,
-      cgroup(containerId),
-      cgroups::DESTROY_TIMEOUT);
+  // Try to clean up using just the cgroup.
+  return slave::destroy(flags.cgroups_unified, hierarchy, cgroup(containerId));
 }
 
 
@@ -17,7 +17,10 @@
 #ifndef __LINUX_LAUNCHER_HPP__
 #define __LINUX_LAUNCHER_HPP__
 
+#include <process/owned.hpp>
+
 #include "slave/containerizer/mesos/launcher.hpp"
+#include "slave/containerizer/mesos/zygote.hpp"
 
 namespace mesos {
 namespace internal {
@@ -27,14 +30,15 @@ namespace slave {
 static const char SYSTEMD_MESOS_EXECUTORS_SLICE[] = "mesos_executors.slice";
 
 // Launcher for Linux systems with cgroups. Uses a freezer cgroup to
-// track pids.
+// track pids, or a cgroup in the unified hierarchy (cgroups v2) if the
+// '--cgroups_unified' flag is set.
 class LinuxLauncher : public Launcher
 {
 public:
   static Try<Launcher*> create(const Flags& flags);
 
   // Returns 'true' if prerequisites for using LinuxLauncher are available.
-  static bool available();
+  static bool available(const Flags& flags);
 
   virtual ~LinuxLauncher() {}
 
@@ -58,14 +62,35 @@ public:
 private:
   LinuxLauncher(
       const Flags& flags,
-      const std::string& freezerHierarchy,
-      const Option<std::string>& systemdHierarchy);
+      const std::string& hierarchy,
+      const Option<std::string>& systemdHierarchy,
+      const Option<process::Owned<Zygote>>& zygote);
+
+  // Clones a child process with the zygote.
+  Try<pid_t> zygoteFork(
+      const ContainerID& containerId,
+      const std::string& path,
+      std::vector<std::string> argv,
+      const process::Subprocess::IO& in,
+      const process::Subprocess::IO& out,
+      const process::Subprocess::IO& err,
+      const Option<flags::FlagsBase>& flags,
+      const Option<std::map<std::string, std::string>>& environment,
+      int cloneFlags);
 
   static const std::string subsystem;
   const Flags flags;
-  const std::string freezerHierarchy;
+
+  // The freezer hierarchy, or the unified hierarchy if the
+  // '--cgroups_unified' flag is set.
+  const std::string hierarchy;
+
   const Option<std::string> systemdHierarchy;
 
+  // The zygote which clones the child processes if the
+  // '--launcher_zygote' flag is set.
+  const Option<process::Owned<Zygote>> zygote;
+
   std::string cgroup(const ContainerID& containerId);
 
   // The 'pid' is the process id of the child process and also the
@@ -19,6 +19,11 @@
 
 #include "slave/containerizer/mesos/launch.hpp"
 #include "slave/containerizer/mesos/mount.hpp"
+#include "slave/containerizer/mesos/rotate.hpp"
+
+#ifdef __linux__
+#include "slave/containerizer/mesos/zygote.hpp"
+#endif // __linux__
 
 using namespace mesos::internal::slave;
 
@@ -30,5 +35,9 @@ int main(int argc, char** argv)
       argc,
       argv,
       new MesosContainerizerLaunch(),
-      new MesosContainerizerMount());
+#ifdef __linux__
+      new MesosContainerizerZygote(),
+#endif // __linux__
+      new MesosContainerizerMount(),
+      new MesosContainerizerRotate());
 }
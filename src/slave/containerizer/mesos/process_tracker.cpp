@@ -0,0 +1,358 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <signal.h>
+
+#include <list>
+#include <set>
+#include <vector>
+
+#include <mesos/type_utils.hpp>
+
+#include <process/defer.hpp>
+#include <process/dispatch.hpp>
+#include <process/id.hpp>
+#include <process/io.hpp>
+#include <process/once.hpp>
+#include <process/process.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
+#include <stout/lambda.hpp>
+#include <stout/os.hpp>
+
+#include <stout/os/close.hpp>
+
+#include "linux/proc_connector.hpp"
+
+#include "slave/containerizer/mesos/process_tracker.hpp"
+
+using namespace process;
+
+using std::list;
+using std::set;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+class ProcessTrackerProcess : public Process<ProcessTrackerProcess>
+{
+public:
+  explicit ProcessTrackerProcess(int _fd)
+    : ProcessBase(process::ID::generate("process-tracker")),
+      fd(_fd),
+      failed(false) {}
+
+  virtual ~ProcessTrackerProcess()
+  {
+    os::close(fd);
+  }
+
+  void track(const ContainerID& containerId, pid_t pid)
+  {
+    if (containers.contains(containerId)) {
+      return;
+    }
+
+    containers[containerId].root = pid;
+
+    scan();
+  }
+
+  void untrack(const ContainerID& containerId)
+  {
+    if (!containers.contains(containerId)) {
+      return;
+    }
+
+    foreach (pid_t pid, containers[containerId].pids) {
+      owners.erase(pid);
+    }
+
+    containers.erase(containerId);
+  }
+
+  Option<set<pid_t>> pids(const ContainerID& containerId)
+  {
+    if (failed || !containers.contains(containerId)) {
+      return None();
+    }
+
+    return containers[containerId].pids;
+  }
+
+  bool kill(const ContainerID& containerId, int signal)
+  {
+    if (failed || !containers.contains(containerId)) {
+      return false;
+    }
+
+    Container& container = containers[containerId];
+    container.signal = signal;
+
+    foreach (pid_t pid, container.pids) {
+      ::kill(pid, signal);
+    }
+
+    return true;
+  }
+
+protected:
+  virtual void initialize()
+  {
+    poll();
+  }
+
+private:
+  struct Container
+  {
+    // The first process of the container.
+    pid_t root;
+
+    std::set<pid_t> pids;
+
+    // The signal sent to any process forked into the container, once
+    // the container has been killed.
+    Option<int> signal;
+  };
+
+  void poll()
+  {
+    io::poll(fd, io::READ)
+      .onAny(defer(self(), &Self::_poll, lambda::_1));
+  }
+
+  void _poll(const Future<short>& future)
+  {
+    if (!future.isReady()) {
+      LOG(ERROR) << "Failed to poll the proc connector: "
+                 << (future.isFailed() ? future.failure() : "discarded");
+      failed = true;
+      return;
+    }
+
+    Try<vector<proc_connector::Event>> events =
+      proc_connector::receive(fd);
+
+    if (events.isError()) {
+      LOG(ERROR) << "Failed to receive the events of the proc connector: "
+                 << events.error();
+      failed = true;
+      return;
+    }
+
+    bool overrun = false;
+
+    foreach (const proc_connector::Event& event, events.get()) {
+      switch (event.type) {
+        case proc_connector::Event::FORK:
+          if (owners.contains(event.parent)) {
+            const ContainerID& containerId = owners[event.parent];
+            Container& container = containers[containerId];
+
+            container.pids.insert(event.pid);
+            owners[event.pid] = containerId;
+
+            if (container.signal.isSome()) {
+              ::kill(event.pid, container.signal.get());
+            }
+          }
+          break;
+        case proc_connector::Event::EXIT:
+          if (owners.contains(event.pid)) {
+            containers[owners[event.pid]].pids.erase(event.pid);
+            owners.erase(event.pid);
+          }
+          break;
+        case proc_connector::Event::OVERRUN:
+          overrun = true;
+          break;
+      }
+    }
+
+    if (overrun) {
+      LOG(WARNING) << "Dropped events of the proc connector, rescanning "
+                   << "the processes of " << containers.size()
+                   << " container(s)";
+      scan();
+    }
+
+    poll();
+  }
+
+  // Finds the processes of all of the containers with a single walk
+  // of '/proc'. This seeds a newly tracked container and recovers
+  // from dropped events, which is the only time '/proc' is walked.
+  void scan()
+  {
+    if (containers.empty()) {
+      return;
+    }
+
+    Try<list<os::Process>> processes = os::processes();
+    if (processes.isError()) {
+      LOG(ERROR) << "Failed to list the processes: " << processes.error();
+      failed = true;
+      return;
+    }
+
+    hashmap<pid_t, ContainerID> roots;
+    foreachpair (const ContainerID& containerId,
+                 const Container& container,
+                 containers) {
+      roots[container.root] = containerId;
+    }
+
+    // Start out with the roots, the processes in their sessions and
+    // process groups, and the processes tracked so far which are
+    // still alive, and then add all of their descendants.
+    hashmap<pid_t, ContainerID> found;
+    hashmap<pid_t, list<pid_t>> children;
+    list<pid_t> pending;
+
+    foreach (const os::Process& process, processes.get()) {
+      children[process.parent].push_back(process.pid);
+
+      Option<ContainerID> containerId = None();
+      if (roots.contains(process.pid)) {
+        containerId = roots[process.pid];
+      } else if (process.session.isSome() &&
+                 roots.contains(process.session.get())) {
+        containerId = roots[process.session.get()];
+      } else if (roots.contains(process.group)) {
+        containerId = roots[process.group];
+      } else if (owners.contains(process.pid)) {
+        containerId = owners[process.pid];
+      }
+
+      if (containerId.isSome()) {
+        found[process.pid] = containerId.get();
+        pending.push_back(process.pid);
+      }
+    }
+
+    while (!pending.empty()) {
+      const pid_t pid = pending.front();
+      pending.pop_front();
+
+      if (!children.contains(pid)) {
+        continue;
+      }
+
+      foreach (pid_t child, children[pid]) {
+        if (!found.contains(child)) {
+          found[child] = found[pid];
+          pending.push_back(child);
+        }
+      }
+    }
+
+    owners.clear();
+    foreachvalue (Container& container, containers) {
+      container.pids.clear();
+    }
+
+    foreachpair (pid_t pid, const ContainerID& containerId, found) {
+      Container& container = containers[containerId];
+
+      container.pids.insert(pid);
+      owners[pid] = containerId;
+
+      if (container.signal.isSome()) {
+        ::kill(pid, container.signal.get());
+      }
+    }
+  }
+
+  const int fd;
+
+  // Set once events can no longer be received, after which the
+  // callers fall back to walking '/proc' themselves.
+  bool failed;
+
+  hashmap<ContainerID, Container> containers;
+
+  // The container of each tracked process.
+  hashmap<pid_t, ContainerID> owners;
+};
+
+
+Try<ProcessTracker*> ProcessTracker::instance()
+{
+  static Once* initialized = new Once();
+  static Try<ProcessTracker*>* tracker = NULL;
+
+  if (!initialized->once()) {
+    Try<int> fd = proc_connector::subscribe();
+    if (fd.isError()) {
+      tracker = new Try<ProcessTracker*>(Error(fd.error()));
+    } else {
+      tracker = new Try<ProcessTracker*>(new ProcessTracker(fd.get()));
+    }
+
+    initialized->done();
+  }
+
+  return *tracker;
+}
+
+
+ProcessTracker::ProcessTracker(int fd)
+{
+  process = new ProcessTrackerProcess(fd);
+  spawn(process);
+}
+
+
+ProcessTracker::~ProcessTracker()
+{
+  terminate(process);
+  wait(process);
+  delete process;
+}
+
+
+void ProcessTracker::track(const ContainerID& containerId, pid_t pid)
+{
+  dispatch(process, &ProcessTrackerProcess::track, containerId, pid);
+}
+
+
+void ProcessTracker::untrack(const ContainerID& containerId)
+{
+  dispatch(process, &ProcessTrackerProcess::untrack, containerId);
+}
+
+
+Future<Option<set<pid_t>>> ProcessTracker::pids(
+    const ContainerID& containerId)
+{
+  return dispatch(process, &ProcessTrackerProcess::pids, containerId);
+}
+
+
+Future<bool> ProcessTracker::kill(const ContainerID& containerId, int signal)
+{
+  return dispatch(
+      process, &ProcessTrackerProcess::kill, containerId, signal);
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,87 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MESOS_CONTAINERIZER_PROCESS_TRACKER_HPP__
+#define __MESOS_CONTAINERIZER_PROCESS_TRACKER_HPP__
+
+#include <sys/types.h>
+
+#include <set>
+
+#include <mesos/mesos.hpp>
+
+#include <process/future.hpp>
+
+#include <stout/option.hpp>
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// Forward declaration.
+class ProcessTrackerProcess;
+
+
+// Follows the processes of the containers through the fork and exit
+// events of the proc connector, so they can be listed without walking
+// '/proc'. It is shared by the posix launcher, which tracks the
+// containers it launches, and the posix isolators, which compute the
+// usage of those containers from their tracked processes.
+class ProcessTracker
+{
+public:
+  // Returns the tracker of the agent, which is created on the first
+  // call, or an error if the proc connector is not available (e.g.,
+  // without CAP_NET_ADMIN, or outside of the initial network
+  // namespace).
+  static Try<ProcessTracker*> instance();
+
+  ~ProcessTracker();
+
+  // Starts tracking the processes of a container: the process 'pid',
+  // the processes in its session or process group, and all of their
+  // descendants. The processes which already exist are found with a
+  // single walk of '/proc'.
+  void track(const ContainerID& containerId, pid_t pid);
+
+  void untrack(const ContainerID& containerId);
+
+  // Returns the processes of a container, or None if the container is
+  // not tracked or the tracker stopped receiving events.
+  process::Future<Option<std::set<pid_t>>> pids(
+      const ContainerID& containerId);
+
+  // Sends 'signal' to the processes of a container, and to any which
+  // are forked afterwards until the container is untracked. Returns
+  // false if the container is not tracked or the tracker stopped
+  // receiving events, in which case nothing is signaled.
+  process::Future<bool> kill(const ContainerID& containerId, int signal);
+
+private:
+  explicit ProcessTracker(int fd);
+
+  ProcessTracker(const ProcessTracker&) = delete;
+  ProcessTracker& operator=(const ProcessTracker&) = delete;
+
+  ProcessTrackerProcess* process;
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MESOS_CONTAINERIZER_PROCESS_TRACKER_HPP__
@@ -22,6 +22,9 @@
 
 #include "slave/containerizer/mesos/provisioner/backends/bind.hpp"
 #include "slave/containerizer/mesos/provisioner/backends/copy.hpp"
+#ifdef __linux__
+#include "slave/containerizer/mesos/provisioner/backends/overlay.hpp"
+#endif // __linux__
 
 using namespace process;
 
@@ -37,6 +40,7 @@ hashmap<string, Owned<Backend>> Backend::create(const Flags& flags)
 
 #ifdef __linux__
   creators.put("bind", &BindBackend::create);
+  creators.put("overlay", &OverlayBackend::create);
 #endif // __linux__
   creators.put("copy", &CopyBackend::create);
 
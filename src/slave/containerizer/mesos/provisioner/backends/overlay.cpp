@@ -0,0 +1,295 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <errno.h>
+#include <unistd.h>
+
+#include <process/dispatch.hpp>
+#include <process/process.hpp>
+
+#include <process/metrics/counter.hpp>
+#include <process/metrics/metrics.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+
+#include "linux/fs.hpp"
+
+#include "slave/containerizer/mesos/provisioner/backends/overlay.hpp"
+
+using namespace process;
+
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+class OverlayBackendProcess : public Process<OverlayBackendProcess>
+{
+public:
+  Future<Nothing> provision(const vector<string>& layers, const string& rootfs);
+
+  Future<bool> destroy(const string& rootfs);
+
+  struct Metrics
+  {
+    Metrics();
+    ~Metrics();
+
+    process::metrics::Counter remove_rootfs_errors;
+  } metrics;
+};
+
+
+// The upper and work directories of a rootfs are kept next to the
+// rootfses of the backend:
+// <backend>
+// |-- rootfses
+// |   |-- <rootfs_id> (the rootfs)
+// |-- scratch
+//     |-- <rootfs_id>
+//         |-- upperdir
+//         |-- workdir
+// so they are removed with the directory of the container.
+static string getScratchDir(const string& rootfs)
+{
+  const Path path(rootfs);
+
+  return path::join(
+      Path(Path(path.dirname()).dirname()).value,
+      "scratch",
+      path.basename());
+}
+
+
+Try<Owned<Backend>> OverlayBackend::create(const Flags&)
+{
+  Result<string> user = os::user();
+  if (!user.isSome()) {
+    return Error("Failed to determine user: " +
+                 (user.isError() ? user.error() : "username not found"));
+  }
+
+  if (user.get() != "root") {
+    return Error("OverlayBackend requires root privileges");
+  }
+
+  Try<bool> supported = fs::supported("overlay");
+  if (supported.isError()) {
+    return Error(
+        "Failed to check for overlay filesystem support: " +
+        supported.error());
+  }
+
+  if (!supported.get()) {
+    return Error("Overlay filesystem is not supported by the kernel");
+  }
+
+  return Owned<Backend>(new OverlayBackend(
+      Owned<OverlayBackendProcess>(new OverlayBackendProcess())));
+}
+
+
+OverlayBackend::~OverlayBackend()
+{
+  terminate(process.get());
+  wait(process.get());
+}
+
+
+OverlayBackend::OverlayBackend(Owned<OverlayBackendProcess> _process)
+  : process(_process)
+{
+  spawn(CHECK_NOTNULL(process.get()));
+}
+
+
+Future<Nothing> OverlayBackend::provision(
+    const vector<string>& layers,
+    const string& rootfs)
+{
+  return dispatch(
+      process.get(), &OverlayBackendProcess::provision, layers, rootfs);
+}
+
+
+Future<bool> OverlayBackend::destroy(const string& rootfs)
+{
+  return dispatch(process.get(), &OverlayBackendProcess::destroy, rootfs);
+}
+
+
+Future<Nothing> OverlayBackendProcess::provision(
+    const vector<string>& layers,
+    const string& rootfs)
+{
+  if (layers.size() == 0) {
+    return Failure("No filesystem layer provided");
+  }
+
+  Try<Nothing> mkdir = os::mkdir(rootfs);
+  if (mkdir.isError()) {
+    return Failure("Failed to create container rootfs at " + rootfs);
+  }
+
+  const string scratchDir = getScratchDir(rootfs);
+  const string upperdir = path::join(scratchDir, "upperdir");
+  const string workdir = path::join(scratchDir, "workdir");
+
+  mkdir = os::mkdir(upperdir);
+  if (mkdir.isError()) {
+    return Failure(
+        "Failed to create upper directory '" + upperdir + "': " +
+        mkdir.error());
+  }
+
+  mkdir = os::mkdir(workdir);
+  if (mkdir.isError()) {
+    return Failure(
+        "Failed to create work directory '" + workdir + "': " +
+        mkdir.error());
+  }
+
+  // The first of the lower directories is the top one, while the
+  // files in a layer shadow those of the layers before it.
+  const vector<string> lowerdirs(layers.rbegin(), layers.rend());
+
+  const string options =
+    "lowerdir=" + strings::join(":", lowerdirs) +
+    ",upperdir=" + upperdir +
+    ",workdir=" + workdir;
+
+  if (options.size() >= static_cast<size_t>(os::pagesize())) {
+    return Failure(
+        "Too many layers (" + stringify(layers.size()) + ") for the "
+        "overlay mount options to fit in a page");
+  }
+
+  Try<Nothing> mount = fs::mount(
+      "overlay",
+      rootfs,
+      "overlay",
+      0,
+      options);
+
+  if (mount.isError()) {
+    return Failure(
+        "Failed to mount rootfs '" + rootfs + "' with options '" +
+        options + "': " + mount.error());
+  }
+
+  // Mark the mount as shared+slave.
+  mount = fs::mount(
+      None(),
+      rootfs,
+      None(),
+      MS_SLAVE,
+      NULL);
+
+  if (mount.isError()) {
+    return Failure(
+        "Failed to mark mount '" + rootfs +
+        "' as a slave mount: " + mount.error());
+  }
+
+  mount = fs::mount(
+      None(),
+      rootfs,
+      None(),
+      MS_SHARED,
+      NULL);
+
+  if (mount.isError()) {
+    return Failure(
+        "Failed to mark mount '" + rootfs +
+        "' as a shared mount: " + mount.error());
+  }
+
+  return Nothing();
+}
+
+
+Future<bool> OverlayBackendProcess::destroy(const string& rootfs)
+{
+  Try<fs::MountInfoTable> mountTable = fs::MountInfoTable::read();
+
+  if (mountTable.isError()) {
+    return Failure("Failed to read mount table: " + mountTable.error());
+  }
+
+  foreach (const fs::MountInfoTable::Entry& entry, mountTable.get().entries) {
+    if (entry.target == rootfs) {
+      // NOTE: This would fail if the rootfs is still in use.
+      Try<Nothing> unmount = fs::unmount(entry.target);
+      if (unmount.isError()) {
+        return Failure(
+            "Failed to destroy overlay-mounted rootfs '" + rootfs + "': " +
+            unmount.error());
+      }
+
+      // See the comment in BindBackendProcess::destroy on why we
+      // ignore EBUSY here.
+      if (::rmdir(rootfs.c_str()) != 0) {
+        string message =
+          "Failed to remove rootfs mount point '" + rootfs + "':" +
+          os::strerror(errno);
+
+        if (errno == EBUSY) {
+          LOG(ERROR) << message;
+          ++metrics.remove_rootfs_errors;
+        } else {
+          return Failure(message);
+        }
+      }
+
+      const string scratchDir = getScratchDir(rootfs);
+
+      Try<Nothing> rmdir = os::rmdir(scratchDir);
+      if (rmdir.isError()) {
+        return Failure(
+            "Failed to remove scratch directory '" + scratchDir + "': " +
+            rmdir.error());
+      }
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+OverlayBackendProcess::Metrics::Metrics()
+  : remove_rootfs_errors(
+      "containerizer/mesos/provisioner/overlay/remove_rootfs_errors")
+{
+  process::metrics::add(remove_rootfs_errors);
+}
+
+
+OverlayBackendProcess::Metrics::~Metrics()
+{
+  process::metrics::remove(remove_rootfs_errors);
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
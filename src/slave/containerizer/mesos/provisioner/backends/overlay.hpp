@@ -0,0 +1,72 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __PROVISIONER_BACKENDS_OVERLAY_HPP__
+#define __PROVISIONER_BACKENDS_OVERLAY_HPP__
+
+#include "slave/containerizer/mesos/provisioner/backend.hpp"
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// Forward declaration.
+class OverlayBackendProcess;
+
+
+// This backend mounts the layers as the read-only lower directories
+// of an overlay filesystem, with a per-rootfs writable upper
+// directory. The layers are shared by all the containers that use
+// them, so provisioning takes no IO no matter the size of the image,
+// and the page cache of the files in the layers is shared as well.
+// NOTE:
+// 1) It requires a kernel with overlayfs (named 'overlay', 3.18+),
+//    and one with multiple lower directories (4.0+) for images with
+//    more than one layer.
+// 2) The layers must not be on an overlay filesystem themselves.
+// 3) The mount options hold the paths of all the layers, which limits
+//    the number of layers of an image to what fits in a page.
+// 4) The writes of the container go to the upper directory, which is
+//    not accounted for (in terms of disk usage), like with the copy
+//    backend.
+class OverlayBackend : public Backend
+{
+public:
+  virtual ~OverlayBackend();
+
+  // OverlayBackend doesn't use any flag.
+  static Try<process::Owned<Backend>> create(const Flags&);
+
+  virtual process::Future<Nothing> provision(
+      const std::vector<std::string>& layers,
+      const std::string& rootfs);
+
+  virtual process::Future<bool> destroy(const std::string& rootfs);
+
+private:
+  explicit OverlayBackend(process::Owned<OverlayBackendProcess> process);
+
+  OverlayBackend(const OverlayBackend&); // Not copyable.
+  OverlayBackend& operator=(const OverlayBackend&); // Not assignable.
+
+  process::Owned<OverlayBackendProcess> process;
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __PROVISIONER_BACKENDS_OVERLAY_HPP__
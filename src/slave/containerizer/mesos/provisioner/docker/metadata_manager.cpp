@@ -22,6 +22,7 @@
 
 #include <stout/foreach.hpp>
 #include <stout/hashset.hpp>
+#include <stout/linkedhashmap.hpp>
 #include <stout/os.hpp>
 #include <stout/protobuf.hpp>
 
@@ -62,18 +63,36 @@ public:
 
   Future<Option<Image>> get(const Image::Name& name);
 
-  // TODO(chenlily): Implement removal of unreferenced images.
+  Future<hashset<string>> prune(
+      const Bytes& maxSize,
+      const hashmap<string, Bytes>& layerSizes,
+      const hashset<string>& activeLayerIds);
 
 private:
-  // Write out metadata manager state to persistent store.
-  Try<Nothing> persist();
+  // Adds the image to the lookup table as the most recently used one,
+  // replacing the image of the same name, if any.
+  void add(const Image& image);
+
+  // Removes the image from the lookup table, and returns the ids of
+  // the layers that no other image references.
+  hashset<string> remove(const string& imageName);
+
+  // Write out the image to persistent store.
+  Try<Nothing> persist(const Image& image);
+
+  // Reads the images persisted in the file of each image or, before
+  // those were introduced, in the single 'storedImages' file.
+  Try<vector<Image>> read();
 
   const Flags flags;
 
   // This is a lookup table for images that are stored in memory. It is keyed
-  // by the name of the Image.
+  // by the name of the Image, the least recently used image first.
   // For example, "ubuntu:14.04" -> ubuntu14:04 Image.
-  hashmap<std::string, Image> storedImages;
+  LinkedHashMap<std::string, Image> storedImages;
+
+  // The number of stored images that reference each layer, by id.
+  hashmap<std::string, size_t> layerReferences;
 };
 
 
@@ -123,25 +142,37 @@ Future<Option<Image>> MetadataManager::get(const Image::Name& name)
 }
 
 
+Future<hashset<string>> MetadataManager::prune(
+    const Bytes& maxSize,
+    const hashmap<string, Bytes>& layerSizes,
+    const hashset<string>& activeLayerIds)
+{
+  return dispatch(
+      process.get(),
+      &MetadataManagerProcess::prune,
+      maxSize,
+      layerSizes,
+      activeLayerIds);
+}
+
+
 Future<Image> MetadataManagerProcess::put(
     const Image::Name& name,
     const vector<string>& layerIds)
 {
-  const string imageName = stringify(name);
-
   Image dockerImage;
   dockerImage.mutable_name()->CopyFrom(name);
   foreach (const string& layerId, layerIds) {
     dockerImage.add_layer_ids(layerId);
   }
 
-  storedImages[imageName] = dockerImage;
-
-  Try<Nothing> status = persist();
+  Try<Nothing> status = persist(dockerImage);
   if (status.isError()) {
     return Failure("Failed to save state of Docker images: " + status.error());
   }
 
+  add(dockerImage);
+
   return dockerImage;
 }
 
@@ -151,24 +182,115 @@ Future<Option<Image>> MetadataManagerProcess::get(
 {
   const string imageName = stringify(name);
 
-  if (!storedImages.contains(imageName)) {
+  Option<Image> image = storedImages.get(imageName);
+  if (image.isNone()) {
     return None();
   }
 
-  return storedImages[imageName];
+  // Move the image to the back, as the most recently used one.
+  storedImages.erase(imageName);
+  storedImages[imageName] = image.get();
+
+  return image;
+}
+
+
+Future<hashset<string>> MetadataManagerProcess::prune(
+    const Bytes& maxSize,
+    const hashmap<string, Bytes>& layerSizes,
+    const hashset<string>& activeLayerIds)
+{
+  Bytes size;
+  foreachkey (const string& layerId, layerReferences) {
+    size += layerSizes.get(layerId).getOrElse(Bytes(0));
+  }
+
+  hashset<string> removedLayerIds;
+
+  foreach (const string& imageName, storedImages.keys()) {
+    if (size <= maxSize) {
+      break;
+    }
+
+    const Image image = storedImages[imageName];
+
+    bool active = false;
+    foreach (const string& layerId, image.layer_ids()) {
+      if (activeLayerIds.contains(layerId)) {
+        active = true;
+        break;
+      }
+    }
+
+    if (active) {
+      continue;
+    }
+
+    const string imagePath =
+      paths::getImagePath(flags.docker_store_dir, imageName);
+
+    Try<Nothing> rm = os::rm(imagePath);
+    if (rm.isError()) {
+      return Failure(
+          "Failed to remove image '" + imageName + "' from '" +
+          imagePath + "': " + rm.error());
+    }
+
+    foreach (const string& layerId, remove(imageName)) {
+      size -= layerSizes.get(layerId).getOrElse(Bytes(0));
+      removedLayerIds.insert(layerId);
+    }
+
+    LOG(INFO) << "Removed Docker image '" << imageName << "' from the store";
+  }
+
+  return removedLayerIds;
 }
 
 
-Try<Nothing> MetadataManagerProcess::persist()
+void MetadataManagerProcess::add(const Image& image)
 {
-  Images images;
+  const string imageName = stringify(image.name());
 
-  foreachvalue (const Image& image, storedImages) {
-    images.add_images()->CopyFrom(image);
+  if (storedImages.contains(imageName)) {
+    remove(imageName);
   }
 
+  storedImages[imageName] = image;
+
+  foreach (const string& layerId, image.layer_ids()) {
+    layerReferences[layerId]++;
+  }
+}
+
+
+hashset<string> MetadataManagerProcess::remove(const string& imageName)
+{
+  CHECK(storedImages.contains(imageName));
+
+  const Image image = storedImages[imageName];
+  storedImages.erase(imageName);
+
+  hashset<string> unreferencedLayerIds;
+
+  foreach (const string& layerId, image.layer_ids()) {
+    CHECK(layerReferences.contains(layerId));
+
+    if (--layerReferences[layerId] == 0) {
+      layerReferences.erase(layerId);
+      unreferencedLayerIds.insert(layerId);
+    }
+  }
+
+  return unreferencedLayerIds;
+}
+
+
+Try<Nothing> MetadataManagerProcess::persist(const Image& image)
+{
   Try<Nothing> status = state::checkpoint(
-      paths::getStoredImagesPath(flags.docker_store_dir), images);
+      paths::getImagePath(flags.docker_store_dir, stringify(image.name())),
+      image);
   if (status.isError()) {
     return Error("Failed to perform checkpoint: " + status.error());
   }
@@ -177,25 +299,88 @@ Try<Nothing> MetadataManagerProcess::persist()
 }
 
 
-Future<Nothing> MetadataManagerProcess::recover()
+Try<vector<Image>> MetadataManagerProcess::read()
 {
-  string storedImagesPath = paths::getStoredImagesPath(flags.docker_store_dir);
+  vector<Image> images;
+
+  const string imagesDir = paths::getImagesDir(flags.docker_store_dir);
+
+  if (os::exists(imagesDir)) {
+    Try<list<string>> entries = os::ls(imagesDir);
+    if (entries.isError()) {
+      return Error(
+          "Failed to list '" + imagesDir + "': " + entries.error());
+    }
+
+    foreach (const string& entry, entries.get()) {
+      const string imagePath = path::join(imagesDir, entry);
 
-  if (!os::exists(storedImagesPath)) {
-    LOG(INFO) << "No images to load from disk. Docker provisioner image "
-              << "storage path '" << storedImagesPath << "' does not exist";
-    return Nothing();
+      Result<Image> image = ::protobuf::read<Image>(imagePath);
+      if (image.isError()) {
+        return Error(
+            "Failed to read protobuf for Docker provisioner image from '" +
+            imagePath + "': " + image.error());
+      }
+
+      // The file is empty if the agent failed while checkpointing it,
+      // before its image was stored.
+      if (image.isNone()) {
+        LOG(WARNING) << "Skipped loading empty Docker image file '"
+                     << imagePath << "'";
+        continue;
+      }
+
+      images.push_back(image.get());
+    }
   }
 
-  Result<Images> images = ::protobuf::read<Images>(storedImagesPath);
+  // The images from before the images were persisted one by one are
+  // persisted the new way, so that the old file can be removed.
+  const string storedImagesPath =
+    paths::getStoredImagesPath(flags.docker_store_dir);
+
+  if (os::exists(storedImagesPath)) {
+    Result<Images> storedImages = ::protobuf::read<Images>(storedImagesPath);
+    if (storedImages.isError()) {
+      return Error(
+          "Failed to read protobuf for Docker provisioner image: " +
+          storedImages.error());
+    }
+
+    if (storedImages.isSome()) {
+      foreach (const Image& image, storedImages.get().images()) {
+        Try<Nothing> status = persist(image);
+        if (status.isError()) {
+          return Error(
+              "Failed to save state of Docker image '" +
+              stringify(image.name()) + "': " + status.error());
+        }
+
+        images.push_back(image);
+      }
+    }
+
+    Try<Nothing> rm = os::rm(storedImagesPath);
+    if (rm.isError()) {
+      return Error(
+          "Failed to remove '" + storedImagesPath + "': " + rm.error());
+    }
+  }
+
+  return images;
+}
+
+
+Future<Nothing> MetadataManagerProcess::recover()
+{
+  Try<vector<Image>> images = read();
   if (images.isError()) {
-    return Failure("Failed to read protobuf for Docker provisioner image: " +
-                   images.error());
+    return Failure(images.error());
   }
 
-  foreach (const Image image, images.get().images()) {
+  foreach (const Image& image, images.get()) {
     vector<string> missingLayerIds;
-    foreach (const string layerId, image.layer_ids()) {
+    foreach (const string& layerId, image.layer_ids()) {
       const string rootfsPath =
         paths::getImageLayerRootfsPath(flags.docker_store_dir, layerId);
 
@@ -215,7 +400,7 @@ Future<Nothing> MetadataManagerProcess::recover()
       LOG(WARNING) << "Found duplicate image in recovery for image name '"
                    << imageName << "'";
     } else {
-      storedImages[imageName] = image;
+      add(image);
     }
   }
 
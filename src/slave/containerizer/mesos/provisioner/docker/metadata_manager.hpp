@@ -20,7 +20,9 @@
 #include <list>
 #include <string>
 
+#include <stout/bytes.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
 #include <stout/json.hpp>
 #include <stout/option.hpp>
 #include <stout/protobuf.hpp>
@@ -49,8 +51,11 @@ class MetadataManagerProcess;
  * provisioner that are stored on disk. It keeps track of the layers
  * that Docker images are composed of and recovers Image objects
  * upon initialization by checking for dependent layers stored on disk.
- * Currently, image layers are stored indefinitely, with no garbage
- * collection of unreferenced image layers.
+ * Each image is persisted in a file of its own, and the images are
+ * kept in memory in the order in which they were last used, so that
+ * the least recently used ones can be pruned. A layer is referenced
+ * by all the images that have it, and is unreferenced once the last
+ * of them is pruned.
  */
 class MetadataManager
 {
@@ -86,6 +91,23 @@ public:
    */
   process::Future<Option<Image>> get(const Image::Name& name);
 
+  /**
+   * Remove the least recently used images, except for the ones with
+   * any of the active layers, until the layers referenced by the
+   * remaining images take at most 'maxSize', and return the ids of
+   * the layers that are no longer referenced. The caller removes
+   * these from disk.
+   *
+   * @param maxSize       the maximum size of the referenced layers.
+   * @param layerSizes    the size of each layer, by id. Layers of
+   *                      unknown size count as empty.
+   * @param activeLayerIds the ids of the layers in use by containers.
+   */
+  process::Future<hashset<std::string>> prune(
+      const Bytes& maxSize,
+      const hashmap<std::string, Bytes>& layerSizes,
+      const hashset<std::string>& activeLayerIds);
+
 private:
   explicit MetadataManager(process::Owned<MetadataManagerProcess> process);
 
@@ -16,6 +16,8 @@
 
 #include "slave/containerizer/mesos/provisioner/docker/paths.hpp"
 
+#include <process/http.hpp>
+
 #include <stout/path.hpp>
 
 using std::string;
@@ -85,11 +87,17 @@ string getImageArchiveLayerRootfsPath(
 }
 
 
+string getLayersDir(const string& storeDir)
+{
+  return path::join(storeDir, "layers");
+}
+
+
 string getImageLayerPath(
     const string& storeDir,
     const string& layerId)
 {
-  return path::join(storeDir, "layers", layerId);
+  return path::join(getLayersDir(storeDir), layerId);
 }
 
 
@@ -101,6 +109,19 @@ string getImageLayerRootfsPath(
 }
 
 
+string getImagesDir(const string& storeDir)
+{
+  return path::join(storeDir, "images");
+}
+
+
+string getImagePath(const string& storeDir, const string& imageName)
+{
+  // Image names have '/' and ':' in them, which the encoding escapes.
+  return path::join(getImagesDir(storeDir), process::http::encode(imageName));
+}
+
+
 string getStoredImagesPath(const string& storeDir)
 {
   return path::join(storeDir, "storedImages");
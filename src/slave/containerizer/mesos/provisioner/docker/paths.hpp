@@ -38,7 +38,9 @@ namespace paths {
  *    |--layers
  *       |--<layer_id>
  *           |--rootfs
- *    |--storedImages (file holding on cached images)
+ *    |--images
+ *       |--<image_name> (percent-encoded, file holding a cached image)
+ *    |--storedImages (file holding on cached images, replaced by 'images')
  */
 
 std::string getStagingDir(const std::string& storeDir);
@@ -75,6 +77,9 @@ std::string getImageArchiveLayerRootfsPath(
   const std::string& layerId);
 
 
+std::string getLayersDir(const std::string& storeDir);
+
+
 std::string getImageLayerPath(
     const std::string& storeDir,
     const std::string& layerId);
@@ -85,6 +90,14 @@ std::string getImageLayerRootfsPath(
     const std::string& layerId);
 
 
+std::string getImagesDir(const std::string& storeDir);
+
+
+std::string getImagePath(
+    const std::string& storeDir,
+    const std::string& imageName);
+
+
 std::string getStoredImagesPath(const std::string& storeDir);
 
 } // namespace paths {
@@ -120,6 +120,10 @@ private:
   Owned<TokenManager> tokenManager_;
   const Option<Credentials> credentials_;
 
+  // Keeps the connections to the registry (and to the servers it
+  // redirects to) alive across requests.
+  http::ConnectionPool pool_;
+
   RegistryClientProcess(const RegistryClientProcess&) = delete;
   RegistryClientProcess& operator = (const RegistryClientProcess&) = delete;
 };
@@ -497,15 +501,15 @@ Future<http::Response> RegistryClientProcess::doHttpGet(
     bool resend,
     const Option<string>& lastResponseStatus) const
 {
-  Future<http::Response> response;
+  http::Request request;
+  request.method = "GET";
+  request.url = url;
 
-  if (isStreaming) {
-    response = process::http::streaming::get(url, headers);
-  } else {
-    response = process::http::get(url, headers);
+  if (headers.isSome()) {
+    request.headers = headers.get();
   }
 
-  return response
+  return pool_.send(request, isStreaming)
     .then(defer(self(), [=](const http::Response& httpResponse)
         -> Future<http::Response> {
       VLOG(1) << "Response status for url '" << url << "': "
@@ -16,6 +16,7 @@
 
 #include "slave/containerizer/mesos/provisioner/docker/registry_puller.hpp"
 
+#include <deque>
 #include <list>
 
 #include <process/collect.hpp>
@@ -23,6 +24,8 @@
 #include <process/dispatch.hpp>
 #include <process/subprocess.hpp>
 
+#include <stout/os.hpp>
+
 #include "common/status_utils.hpp"
 
 #include "slave/containerizer/mesos/provisioner/docker/paths.hpp"
@@ -62,7 +65,9 @@ public:
 private:
   explicit RegistryPullerProcess(
       const Owned<RegistryClient>& registry,
-      const Duration& timeout);
+      const Duration& timeout,
+      const string& storeDir,
+      size_t maxDownloads);
 
   Future<pair<string, string>> downloadLayer(
       const Image::Name& imageName,
@@ -70,22 +75,37 @@ private:
       const string& blobSum,
       const string& id);
 
-  Future<list<pair<string, string>>> downloadLayers(
-      const DockerImageManifest& manifest,
+  // Downloads and extracts a layer into the directory, unless the
+  // layer is being pulled for another image already, in which case
+  // this returns the rootfs that pull extracts.
+  Future<pair<string, string>> pullLayer(
       const Image::Name& imageName,
-      const Path& downloadDir);
+      const Path& directory,
+      const string& blobSum,
+      const string& id);
 
-  process::Future<list<pair<string, string>>> _pull(
+  Future<list<pair<string, string>>> pullLayers(
+      const DockerImageManifest& manifest,
       const Image::Name& imageName,
       const Path& downloadDir);
 
-  Future<list<pair<string, string>>> untarLayers(
-    const Future<list<pair<string, string>>>& layerFutures,
-    const Path& downloadDir);
+  // Waits until fewer than 'maxDownloads_' layers are downloading.
+  Future<Nothing> acquireDownload();
+  void releaseDownload();
 
   Owned<RegistryClient> registryClient_;
   const Duration pullTimeout_;
-  hashmap<string, Owned<Promise<pair<string, string>>>> downloadTracker_;
+
+  // The layers in here are not pulled again.
+  const string storeDir_;
+
+  const size_t maxDownloads_;
+  size_t downloads_;
+  std::deque<Owned<Promise<Nothing>>> downloadWaiters_;
+
+  // The layers being pulled, by id, which concurrent pulls of other
+  // images with the same layers share.
+  hashmap<string, Owned<Promise<pair<string, string>>>> layerTracker_;
 
   RegistryPullerProcess(const RegistryPullerProcess&) = delete;
   RegistryPullerProcess& operator=(const RegistryPullerProcess&) = delete;
@@ -173,17 +193,30 @@ Try<Owned<RegistryPullerProcess>> RegistryPullerProcess::create(
     return Error("Failed to create registry client: " + registry.error());
   }
 
+  if (flags.docker_puller_max_concurrent_downloads == 0) {
+    return Error(
+        "Failed to create registry puller - the maximum number of "
+        "concurrent downloads must be positive");
+  }
+
   return Owned<RegistryPullerProcess>(new RegistryPullerProcess(
       registry.get(),
-      Seconds(timeoutSecs.get())));
+      Seconds(timeoutSecs.get()),
+      flags.docker_store_dir,
+      flags.docker_puller_max_concurrent_downloads));
 }
 
 
 RegistryPullerProcess::RegistryPullerProcess(
     const Owned<RegistryClient>& registry,
-    const Duration& timeout)
+    const Duration& timeout,
+    const string& storeDir,
+    size_t maxDownloads)
   : registryClient_(registry),
-    pullTimeout_(timeout) {}
+    pullTimeout_(timeout),
+    storeDir_(storeDir),
+    maxDownloads_(maxDownloads),
+    downloads_(0) {}
 
 
 Future<pair<string, string>> RegistryPullerProcess::downloadLayer(
@@ -195,45 +228,74 @@ Future<pair<string, string>> RegistryPullerProcess::downloadLayer(
   VLOG(1) << "Downloading layer '"  << layerId
           << "' for image '" << stringify(imageName) << "'";
 
-  if (downloadTracker_.contains(layerId)) {
-    VLOG(1) << "Download already in progress for image '"
-            << stringify(imageName) << "', layer '" << layerId << "'";
+  const Path downloadFile(path::join(directory, layerId + ".tar"));
+
+  return registryClient_->getBlob(
+      imageName,
+      blobSum,
+      downloadFile)
+    .then([layerId, downloadFile](
+        size_t size) -> Future<pair<string, string>> {
+      // We don't expect Docker registry to return empty response
+      // even with empty layers.
+      if (size == 0) {
+        return Failure(
+            "Failed to download layer '" + layerId + "': no content");
+      }
+
+      return pair<string, string>(layerId, downloadFile);
+    });
+}
+
 
-    return downloadTracker_.at(layerId)->future();
+Future<pair<string, string>> RegistryPullerProcess::pullLayer(
+    const Image::Name& imageName,
+    const Path& directory,
+    const string& blobSum,
+    const string& layerId)
+{
+  if (layerTracker_.contains(layerId)) {
+    VLOG(1) << "Pull already in progress for layer '" << layerId
+            << "' of image '" << stringify(imageName) << "'";
+
+    return layerTracker_.at(layerId)->future();
   }
 
-  Owned<Promise<pair<string, string>>> downloadPromise(
+  // We use a promise for the pulls that share the layer, so that one
+  // of them timing out does not discard the pull of the others.
+  Owned<Promise<pair<string, string>>> promise(
       new Promise<pair<string, string>>());
 
-  downloadTracker_.insert({layerId, downloadPromise});
+  layerTracker_.insert({layerId, promise});
 
-  const Path downloadFile(path::join(directory, layerId + ".tar"));
-
-  registryClient_->getBlob(
-      imageName,
-      blobSum,
-      downloadFile)
-    .onAny(process::defer(
-        self(),
-        [this, layerId, downloadPromise, downloadFile](
-            const Future<size_t>& future) {
-          downloadTracker_.erase(layerId);
-
-          if (!future.isReady()) {
-              downloadPromise->fail(
-                  "Failed to download layer '" + layerId + "': " +
-                  (future.isFailed() ? future.failure() : "future discarded"));
-          } else if (future.get() == 0) {
-            // We don't expect Docker registry to return empty response
-            // even with empty layers.
-            downloadPromise->fail(
-                "Failed to download layer '" + layerId + "': no content");
-          } else {
-            downloadPromise->set({layerId, downloadFile});
-          }
-        }));
-
-  return downloadPromise->future();
+  // Each layer is extracted as soon as it is downloaded, while the
+  // other layers of the image are still downloading.
+  acquireDownload()
+    .then(defer(self(), [=]() {
+      return downloadLayer(imageName, directory, blobSum, layerId)
+        .onAny(defer(self(), &Self::releaseDownload));
+    }))
+    .then([directory](const pair<string, string>& layer) {
+      VLOG(1) << "Untarring layer '" << layer.first
+              << "' downloaded from registry to directory '"
+              << directory << "'";
+
+      return untarLayer(layer.second, directory, layer.first);
+    })
+    .onAny(defer(self(), [this, layerId, promise](
+        const Future<pair<string, string>>& future) {
+      layerTracker_.erase(layerId);
+
+      if (!future.isReady()) {
+        promise->fail(
+            "Failed to pull layer '" + layerId + "': " +
+            (future.isFailed() ? future.failure() : "future discarded"));
+      } else {
+        promise->set(future.get());
+      }
+    }));
+
+  return promise->future();
 }
 
 
@@ -245,12 +307,7 @@ Future<list<pair<string, string>>> RegistryPullerProcess::pull(
   return registryClient_->getManifest(imageName)
     .then(process::defer(self(), [this, directory, imageName](
         const DockerImageManifest& manifest) {
-      return downloadLayers(manifest, imageName, directory);
-    }))
-    .then(process::defer(self(), [this, directory](
-        const Future<list<pair<string, string>>>& layerFutures)
-        -> Future<list<pair<string, string>>> {
-      return untarLayers(layerFutures, directory);
+      return pullLayers(manifest, imageName, directory);
     }))
     .after(pullTimeout_, [imageName](
         Future<list<pair<string, string>>> future) {
@@ -261,43 +318,68 @@ Future<list<pair<string, string>>> RegistryPullerProcess::pull(
 }
 
 
-Future<list<pair<string, string>>> RegistryPullerProcess::downloadLayers(
+Future<list<pair<string, string>>> RegistryPullerProcess::pullLayers(
     const DockerImageManifest& manifest,
     const Image::Name& imageName,
     const Path& directory)
 {
-  list<Future<pair<string, string>>> downloadFutures;
+  list<Future<pair<string, string>>> layerFutures;
 
   for (int i = 0; i < manifest.fslayers_size(); i++) {
-    downloadFutures.push_back(
-        downloadLayer(imageName,
-                      directory,
-                      manifest.fslayers(i).blobsum(),
-                      manifest.history(i).v1compatibility().id()));
+    const string& layerId = manifest.history(i).v1compatibility().id();
+
+    // Images often share their base layers, which is why we do not
+    // pull the layers that the store has already.
+    const string rootfs = paths::getImageLayerRootfsPath(storeDir_, layerId);
+    if (os::exists(rootfs)) {
+      VLOG(1) << "Layer '" << layerId << "' of image '"
+              << stringify(imageName) << "' is in the store already";
+
+      layerFutures.push_back(pair<string, string>(layerId, rootfs));
+      continue;
+    }
+
+    layerFutures.push_back(
+        pullLayer(imageName,
+                  directory,
+                  manifest.fslayers(i).blobsum(),
+                  layerId));
   }
 
   // TODO(jojy): Delete downloaded files in the directory on discard and
   // failure?
   // TODO(jojy): Iterate through the futures and log the failed future.
-  return collect(downloadFutures);
+  return collect(layerFutures);
 }
 
 
-Future<list<pair<string, string>>> RegistryPullerProcess::untarLayers(
-    const Future<list<pair<string, string>>>& layerFutures,
-    const Path& directory)
+Future<Nothing> RegistryPullerProcess::acquireDownload()
 {
-  list<Future<pair<string, string>>> untarFutures;
-
-  pair<string, string> layerInfo;
-  foreach (layerInfo, layerFutures.get()) {
-    VLOG(1) << "Untarring layer '" << layerInfo.first
-            << "' downloaded from registry to directory '" << directory << "'";
-    untarFutures.emplace_back(
-        untarLayer(layerInfo.second, directory, layerInfo.first));
+  if (downloads_ < maxDownloads_) {
+    downloads_++;
+    return Nothing();
+  }
+
+  Owned<Promise<Nothing>> promise(new Promise<Nothing>());
+  downloadWaiters_.push_back(promise);
+
+  return promise->future();
+}
+
+
+void RegistryPullerProcess::releaseDownload()
+{
+  // The download is handed over to the next layer waiting for one.
+  if (!downloadWaiters_.empty()) {
+    Owned<Promise<Nothing>> promise = downloadWaiters_.front();
+    downloadWaiters_.pop_front();
+
+    promise->set(Nothing());
+    return;
   }
 
-  return collect(untarFutures);
+  CHECK_GT(downloads_, 0u);
+  downloads_--;
 }
 
 } // namespace docker {
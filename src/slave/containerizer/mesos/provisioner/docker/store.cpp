@@ -33,6 +33,8 @@
 
 #include "common/status_utils.hpp"
 
+#include "slave/containerizer/mesos/isolators/posix/disk.hpp"
+
 #include "slave/containerizer/mesos/provisioner/docker/metadata_manager.hpp"
 #include "slave/containerizer/mesos/provisioner/docker/paths.hpp"
 #include "slave/containerizer/mesos/provisioner/docker/puller.hpp"
@@ -58,7 +60,11 @@ public:
       const Flags& _flags,
       const Owned<MetadataManager>& _metadataManager,
       const Owned<Puller>& _puller)
-    : flags(_flags), metadataManager(_metadataManager), puller(_puller) {}
+    : flags(_flags),
+      metadataManager(_metadataManager),
+      puller(_puller),
+      collector(Seconds(0)),
+      pruning(Nothing()) {}
 
   ~StoreProcess() {}
 
@@ -66,6 +72,8 @@ public:
 
   Future<vector<string>> get(const mesos::Image& image);
 
+  Future<Nothing> prune(const hashset<string>& activeLayers);
+
 private:
   Future<Image> _get(
       const Image::Name& name,
@@ -82,10 +90,27 @@ private:
 
   Future<Nothing> moveLayer(const pair<string, string>& layerPath);
 
+  Future<Nothing> _recover();
+
+  // Measures the disk usage of a layer in the store. A failure to do
+  // so is only logged, the layer then does not count towards the size.
+  Future<Nothing> measureLayer(const string& layerId);
+
+  Future<Nothing> removeLayers(const hashset<string>& layerIds);
+
   const Flags flags;
   Owned<MetadataManager> metadataManager;
   Owned<Puller> puller;
   hashmap<std::string, Owned<Promise<Image>>> pulling;
+
+  DiskUsageCollector collector;
+
+  // The disk usage of the layers in the store, by id, once measured.
+  hashmap<string, Bytes> layerSizes;
+
+  // The prune in progress, if any. Pulls wait for it, so that the
+  // puller does not use a layer in the store that is being removed.
+  Future<Nothing> pruning;
 };
 
 
@@ -158,6 +183,12 @@ Future<vector<string>> Store::get(const mesos::Image& image)
 }
 
 
+Future<Nothing> Store::prune(const hashset<string>& activeLayers)
+{
+  return dispatch(process.get(), &StoreProcess::prune, activeLayers);
+}
+
+
 Future<vector<string>> StoreProcess::get(const mesos::Image& image)
 {
   if (image.type() != mesos::Image::DOCKER) {
@@ -192,7 +223,10 @@ Future<Image> StoreProcess::_get(
   if (!pulling.contains(imageName)) {
     Owned<Promise<Image>> promise(new Promise<Image>());
 
-    Future<Image> future = puller->pull(name, Path(staging.get()))
+    Future<Image> future = pruning
+      .then(defer(self(), [=]() {
+        return puller->pull(name, Path(staging.get()));
+      }))
       .then(defer(self(), &Self::moveLayers, lambda::_1))
       .then(defer(self(), &Self::storeImage, name, lambda::_1))
       .onAny(defer(self(), [this, imageName](const Future<Image>&) {
@@ -231,7 +265,114 @@ Future<vector<string>> StoreProcess::__get(const Image& image)
 
 Future<Nothing> StoreProcess::recover()
 {
-  return metadataManager->recover();
+  return metadataManager->recover()
+    .then(defer(self(), &Self::_recover));
+}
+
+
+Future<Nothing> StoreProcess::_recover()
+{
+  // The sizes of the layers are only needed to prune the store.
+  if (flags.docker_store_max_size.isNone()) {
+    return Nothing();
+  }
+
+  const string layersDir = paths::getLayersDir(flags.docker_store_dir);
+  if (!os::exists(layersDir)) {
+    return Nothing();
+  }
+
+  Try<list<string>> layerIds = os::ls(layersDir);
+  if (layerIds.isError()) {
+    return Failure(
+        "Failed to list the layers in '" + layersDir + "': " +
+        layerIds.error());
+  }
+
+  foreach (const string& layerId, layerIds.get()) {
+    measureLayer(layerId);
+  }
+
+  return Nothing();
+}
+
+
+Future<Nothing> StoreProcess::measureLayer(const string& layerId)
+{
+  return collector.usage(
+      paths::getImageLayerPath(flags.docker_store_dir, layerId))
+    .then(defer(self(), [this, layerId](const Bytes& size) -> Nothing {
+      layerSizes[layerId] = size;
+      return Nothing();
+    }))
+    .repair([layerId](const Future<Nothing>& future) {
+      LOG(WARNING) << "Failed to get the disk usage of layer '" << layerId
+                   << "': "
+                   << (future.isFailed() ? future.failure() : "discarded");
+
+      return Nothing();
+    });
+}
+
+
+Future<Nothing> StoreProcess::prune(const hashset<string>& activeLayers)
+{
+  if (flags.docker_store_max_size.isNone()) {
+    return Nothing();
+  }
+
+  // The puller skips the layers that are in the store already, so we
+  // do not remove any while images are pulled. The next prune will.
+  if (!pulling.empty() || pruning.isPending()) {
+    return Nothing();
+  }
+
+  // The layers of the store are '<store>/layers/<layer_id>/rootfs'.
+  hashset<string> activeLayerIds;
+  foreach (const string& layer, activeLayers) {
+    const string layerId = Path(Path(layer).dirname()).basename();
+
+    if (layer ==
+        paths::getImageLayerRootfsPath(flags.docker_store_dir, layerId)) {
+      activeLayerIds.insert(layerId);
+    }
+  }
+
+  pruning = metadataManager->prune(
+      flags.docker_store_max_size.get(),
+      layerSizes,
+      activeLayerIds)
+    .then(defer(self(), &Self::removeLayers, lambda::_1))
+    .repair([](const Future<Nothing>& future) {
+      LOG(ERROR) << "Failed to prune the Docker store: "
+                 << (future.isFailed() ? future.failure() : "discarded");
+
+      return Nothing();
+    });
+
+  return pruning;
+}
+
+
+Future<Nothing> StoreProcess::removeLayers(const hashset<string>& layerIds)
+{
+  foreach (const string& layerId, layerIds) {
+    const string layerPath =
+      paths::getImageLayerPath(flags.docker_store_dir, layerId);
+
+    Try<Nothing> rmdir = os::rmdir(layerPath);
+    if (rmdir.isError()) {
+      return Failure(
+          "Failed to remove layer '" + layerId + "' from '" + layerPath +
+          "': " + rmdir.error());
+    }
+
+    layerSizes.erase(layerId);
+
+    VLOG(1) << "Removed layer '" << layerId << "' from the Docker store";
+  }
+
+  return Nothing();
 }
 
 
@@ -265,6 +406,16 @@ Future<Image> StoreProcess::storeImage(
 
 Future<Nothing> StoreProcess::moveLayer(const pair<string, string>& layerPath)
 {
+  const string rootfsPath =
+    paths::getImageLayerRootfsPath(flags.docker_store_dir, layerPath.first);
+
+  // The layer is shared with an image that is in the store already,
+  // or with another image pulled at the same time that moved it.
+  if (os::exists(rootfsPath)) {
+    VLOG(1) << "Layer '" << layerPath.first << "' is in the store already";
+    return Nothing();
+  }
+
   if (!os::exists(layerPath.second)) {
     return Failure("Unable to find layer '" + layerPath.first + "' in '" +
                    layerPath.second + "'");
@@ -279,16 +430,17 @@ Future<Nothing> StoreProcess::moveLayer(const pair<string, string>& layerPath)
                    layerPath.first + "': " + mkdir.error());
   }
 
-  Try<Nothing> status = os::rename(
-      layerPath.second,
-      paths::getImageLayerRootfsPath(
-          flags.docker_store_dir, layerPath.first));
+  Try<Nothing> status = os::rename(layerPath.second, rootfsPath);
 
   if (status.isError()) {
     return Failure("Failed to move layer '" + layerPath.first +
                    "' to store directory: " + status.error());
   }
 
+  if (flags.docker_store_max_size.isSome()) {
+    return measureLayer(layerPath.first);
+  }
+
   return Nothing();
 }
 
@@ -54,6 +54,8 @@ public:
 
   process::Future<std::vector<std::string>> get(const mesos::Image& image);
 
+  process::Future<Nothing> prune(const hashset<std::string>& activeLayers);
+
 private:
   explicit Store(const process::Owned<StoreProcess>& _process);
 
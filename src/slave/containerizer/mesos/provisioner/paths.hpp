@@ -39,7 +39,11 @@ namespace paths {
 //             |-- backends
 //                 |-- <backend> (copy, bind, etc.)
 //                     |-- rootfses
-//                         |-- <rootfs_id> (the rootfs)
+//                     |   |-- <rootfs_id> (the rootfs)
+//                     |-- layers
+//                     |   |-- <rootfs_id> (the image layers of the rootfs)
+//                     |-- scratch (overlay only)
+//                         |-- <rootfs_id> (upper and work directories)
 //
 // There can be multiple backends due to the change of backend flags.
 // Under each backend a rootfs is identified by the 'rootfs_id' which
@@ -57,6 +61,15 @@ std::string getContainerRootfsDir(
     const std::string& rootfsId);
 
 
+// The file listing the image layers a rootfs is provisioned from,
+// one per line, so that the store keeps them while they are used.
+std::string getContainerRootfsLayersPath(
+    const std::string& provisionerDir,
+    const ContainerID& containerId,
+    const std::string& backend,
+    const std::string& rootfsId);
+
+
 // Recursively "ls" the container directory and return a map of
 // backend -> {rootfsId, ...}
 Try<hashmap<std::string, hashset<std::string>>>
@@ -26,9 +26,11 @@
 #include <stout/hashset.hpp>
 #include <stout/os.hpp>
 #include <stout/stringify.hpp>
+#include <stout/strings.hpp>
 #include <stout/uuid.hpp>
 
 #include "slave/paths.hpp"
+#include "slave/state.hpp"
 
 #include "slave/containerizer/mesos/provisioner/backend.hpp"
 #include "slave/containerizer/mesos/provisioner/paths.hpp"
@@ -143,6 +145,15 @@ Future<bool> Provisioner::destroy(const ContainerID& containerId)
 }
 
 
+Future<bool> Provisioner::pull(const Image& image)
+{
+  return dispatch(
+      CHECK_NOTNULL(process.get()),
+      &ProvisionerProcess::pull,
+      image);
+}
+
+
 ProvisionerProcess::ProvisionerProcess(
     const Flags& _flags,
     const string& _rootDir,
@@ -201,6 +212,31 @@ Future<Nothing> ProvisionerProcess::recover(
       }
 
       info->rootfses.put(backend, rootfses.get()[backend]);
+
+      foreach (const string& rootfsId, rootfses.get()[backend]) {
+        const string path = provisioner::paths::getContainerRootfsLayersPath(
+            rootDir,
+            containerId,
+            backend,
+            rootfsId);
+
+        // The layers are not checkpointed by older agents.
+        if (!os::exists(path)) {
+          continue;
+        }
+
+        Try<string> layers = os::read(path);
+        if (layers.isError()) {
+          return Failure(
+              "Failed to read the image layers of container " +
+              stringify(containerId) + " from '" + path + "': " +
+              layers.error());
+        }
+
+        foreach (const string& layer, strings::tokenize(layers.get(), "\n")) {
+          info->layers.insert(layer);
+        }
+      }
     }
 
     infos.put(containerId, info);
@@ -295,8 +331,33 @@ Future<string> ProvisionerProcess::_provision(
 
   infos[containerId]->rootfses[backend].insert(rootfsId);
 
+  // Checkpoint the layers before using them, so that the stores still
+  // keep them after the agent restarts.
+  const string layersPath = provisioner::paths::getContainerRootfsLayersPath(
+      rootDir,
+      containerId,
+      backend,
+      rootfsId);
+
+  Try<Nothing> checkpoint =
+    slave::state::checkpoint(layersPath, strings::join("\n", layers));
+
+  if (checkpoint.isError()) {
+    return Failure(
+        "Failed to checkpoint the image layers of container " +
+        stringify(containerId) + " to '" + layersPath + "': " +
+        checkpoint.error());
+  }
+
+  foreach (const string& layer, layers) {
+    infos[containerId]->layers.insert(layer);
+  }
+
   return backends.get(backend).get()->provision(layers, rootfs)
-    .then([rootfs]() -> Future<string> { return rootfs; });
+    .then(defer(self(), [this, rootfs]() -> Future<string> {
+      prune();
+      return rootfs;
+    }));
 }
 
 
@@ -361,10 +422,36 @@ Future<bool> ProvisionerProcess::_destroy(const ContainerID& containerId)
     ++metrics.remove_container_errors;
   }
 
+  prune();
+
   return true;
 }
 
 
+Future<bool> ProvisionerProcess::pull(const Image& image)
+{
+  if (!stores.contains(image.type())) {
+    return false;
+  }
+
+  return stores.get(image.type()).get()->get(image)
+    .then([]() { return true; });
+}
+
+
+void ProvisionerProcess::prune()
+{
+  hashset<string> activeLayers;
+  foreachvalue (const Owned<Info>& info, infos) {
+    activeLayers.insert(info->layers.begin(), info->layers.end());
+  }
+
+  foreachvalue (const Owned<Store>& store, stores) {
+    store->prune(activeLayers);
+  }
+}
+
+
 ProvisionerProcess::Metrics::Metrics()
   : remove_container_errors(
       "containerizer/mesos/provisioner/remove_container_errors")
@@ -81,6 +81,11 @@ public:
   // provisioned root filesystem for the given container.
   virtual process::Future<bool> destroy(const ContainerID& containerId);
 
+  // Pull the specified image into its store, without provisioning a
+  // root filesystem. Return false if there is no store for the type
+  // of the image.
+  virtual process::Future<bool> pull(const Image& image);
+
 protected:
   Provisioner() {} // For creating mock object.
 
@@ -112,6 +117,8 @@ public:
 
   process::Future<bool> destroy(const ContainerID& containerId);
 
+  process::Future<bool> pull(const Image& image);
+
 private:
   process::Future<std::string> _provision(
       const ContainerID& containerId,
@@ -119,6 +126,9 @@ private:
 
   process::Future<bool> _destroy(const ContainerID& containerId);
 
+  // Lets the stores remove the images no container uses anymore.
+  void prune();
+
   const Flags flags;
 
   // Absolute path to the provisioner root directory. It can be
@@ -135,6 +145,9 @@ private:
   {
     // Mappings: backend -> {rootfsId, ...}
     hashmap<std::string, hashset<std::string>> rootfses;
+
+    // The image layers of all the rootfses of the container.
+    hashset<std::string> layers;
   };
 
   hashmap<ContainerID, process::Owned<Info>> infos;
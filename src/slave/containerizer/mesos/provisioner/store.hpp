@@ -25,6 +25,7 @@
 #include <process/future.hpp>
 #include <process/owned.hpp>
 
+#include <stout/hashset.hpp>
 #include <stout/try.hpp>
 
 #include "slave/flags.hpp"
@@ -64,6 +65,16 @@ public:
   // The returned future fails if the requested image or any of its
   // dependencies cannot be found or failed to be fetched.
   virtual process::Future<std::vector<std::string>> get(const Image& image) = 0;
+
+  // Remove cached images to keep the store within its size limit, if
+  // it has one. The images with any of the 'activeLayers', i.e., the
+  // rootfs layers returned by 'get' to the containers that still use
+  // them, are kept.
+  virtual process::Future<Nothing> prune(
+      const hashset<std::string>& activeLayers)
+  {
+    return Nothing();
+  }
 };
 
 } // namespace slave {
@@ -0,0 +1,221 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+#include <stout/error.hpp>
+#include <stout/gzip.hpp>
+#include <stout/nothing.hpp>
+#include <stout/os.hpp>
+#include <stout/stringify.hpp>
+#include <stout/try.hpp>
+
+#include "slave/constants.hpp"
+
+#include "slave/containerizer/mesos/rotate.hpp"
+
+using std::cerr;
+using std::endl;
+using std::string;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+const string MesosContainerizerRotate::NAME = "rotate";
+
+
+MesosContainerizerRotate::Flags::Flags()
+{
+  add(&path,
+      "path",
+      "The path of the file to write stdin to.");
+
+  add(&max_size,
+      "max_size",
+      "The size at which the file is rotated.",
+      DEFAULT_CONTAINER_LOGGER_MAX_SIZE);
+
+  add(&max_files,
+      "max_files",
+      "The number of rotated files to keep.",
+      DEFAULT_CONTAINER_LOGGER_MAX_FILES);
+
+  add(&compress,
+      "compress",
+      "Whether to compress the rotated files with gzip.",
+      true);
+}
+
+
+// Returns the path of the i-th rotated file.
+static string rotated(
+    const MesosContainerizerRotate::Flags& flags,
+    size_t i)
+{
+  return flags.path.get() + "." + stringify(i) + (flags.compress ? ".gz" : "");
+}
+
+
+// Shifts the rotated files, dropping the oldest one, and moves the
+// file into the first of them.
+static Try<Nothing> rotate(const MesosContainerizerRotate::Flags& flags)
+{
+  const string& path = flags.path.get();
+
+  if (flags.max_files == 0) {
+    return os::rm(path);
+  }
+
+  // NOTE: The rename of the last file overwrites the oldest one.
+  for (size_t i = flags.max_files; i > 1; i--) {
+    if (os::exists(rotated(flags, i - 1))) {
+      Try<Nothing> rename =
+        os::rename(rotated(flags, i - 1), rotated(flags, i));
+      if (rename.isError()) {
+        return Error(rename.error());
+      }
+    }
+  }
+
+  if (!flags.compress) {
+    return os::rename(path, rotated(flags, 1));
+  }
+
+  // NOTE: Compressing blocks the copy, so the executor blocks once it
+  // has filled the pipe. The files are small enough for this to only
+  // take a fraction of a second.
+  Try<string> read = os::read(path);
+  if (read.isError()) {
+    return Error(read.error());
+  }
+
+  Try<string> compressed = gzip::compress(read.get());
+  if (compressed.isError()) {
+    return Error("Failed to compress: " + compressed.error());
+  }
+
+  Try<Nothing> write = os::write(rotated(flags, 1), compressed.get());
+  if (write.isError()) {
+    return Error(write.error());
+  }
+
+  return os::rm(path);
+}
+
+
+int MesosContainerizerRotate::execute()
+{
+  if (flags.path.isNone()) {
+    cerr << "Flag --path is not specified" << endl;
+    return 1;
+  }
+
+  const string& path = flags.path.get();
+
+  Try<int> fd = os::open(
+      path,
+      O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  if (fd.isError()) {
+    cerr << "Failed to open '" << path << "': " << fd.error() << endl;
+    return 1;
+  }
+
+  Try<Bytes> size = os::stat::size(path);
+  if (size.isError()) {
+    cerr << "Failed to stat '" << path << "': " << size.error() << endl;
+    return 1;
+  }
+
+  Bytes written = size.get();
+
+  char buffer[16384];
+
+  while (true) {
+    // Rotate the file once it is full and there is more output. We
+    // only read as much as still fits in the file, so the files never
+    // grow over the maximum size.
+    if (written > 0 && written >= flags.max_size) {
+      os::close(fd.get());
+
+      // NOTE: We keep appending to the file if it cannot be rotated,
+      // rather than exit and have the executor fail to write, and
+      // try again once another 'max_size' has been written.
+      Try<Nothing> rotation = rotate(flags);
+      if (rotation.isError()) {
+        cerr << "Failed to rotate '" << path << "': "
+             << rotation.error() << endl;
+      }
+
+      fd = os::open(
+          path,
+          O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+          S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+      if (fd.isError()) {
+        cerr << "Failed to open '" << path << "': " << fd.error() << endl;
+        return 1;
+      }
+
+      written = 0;
+    }
+
+    size_t room = std::max<uint64_t>(
+        (flags.max_size - written).bytes(), 1);
+
+    ssize_t length = ::read(
+        STDIN_FILENO, buffer, std::min(sizeof(buffer), room));
+
+    if (length < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      cerr << "Failed to read: " << os::strerror(errno) << endl;
+      return 1;
+    }
+
+    if (length == 0) {
+      break;
+    }
+
+    Try<Nothing> write = os::write(fd.get(), string(buffer, length));
+    if (write.isError()) {
+      cerr << "Failed to write to '" << path << "': " << write.error() << endl;
+      return 1;
+    }
+
+    written += Bytes(length);
+  }
+
+  os::close(fd.get());
+
+  return 0;
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,67 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MESOS_CONTAINERIZER_ROTATE_HPP__
+#define __MESOS_CONTAINERIZER_ROTATE_HPP__
+
+#include <string>
+
+#include <stout/bytes.hpp>
+#include <stout/flags.hpp>
+#include <stout/option.hpp>
+#include <stout/subcommand.hpp>
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// The "rotate" subcommand copies its stdin, the output of an
+// executor, to the file at '--path', and rotates the file whenever
+// it would grow over '--max_size': 'stdout' is renamed to 'stdout.1'
+// (compressed to 'stdout.1.gz' with '--compress'), 'stdout.1' to
+// 'stdout.2', and so on, keeping '--max_files' rotated files. It
+// exits once the executor, and any process it forked, has closed its
+// end of the pipe. The slave starts it in its own session so it
+// outlives slave restarts, like the executor.
+class MesosContainerizerRotate : public Subcommand
+{
+public:
+  static const std::string NAME;
+
+  struct Flags : public flags::FlagsBase
+  {
+    Flags();
+
+    Option<std::string> path;
+    Bytes max_size;
+    size_t max_files;
+    bool compress;
+  };
+
+  MesosContainerizerRotate() : Subcommand(NAME) {}
+
+  Flags flags;
+
+protected:
+  virtual int execute();
+  virtual flags::FlagsBase* getFlags() { return &flags; }
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MESOS_CONTAINERIZER_ROTATE_HPP__
@@ -0,0 +1,520 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <sched.h>
+#include <signal.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <iostream>
+
+#include <process/subprocess.hpp>
+
+#include <stout/abort.hpp>
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/json.hpp>
+#include <stout/lambda.hpp>
+#include <stout/nothing.hpp>
+#include <stout/os.hpp>
+#include <stout/result.hpp>
+#include <stout/stringify.hpp>
+
+#include "linux/cgroups.hpp"
+
+#include "slave/containerizer/mesos/zygote.hpp"
+
+using namespace process;
+
+using std::cerr;
+using std::endl;
+using std::map;
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+const string MesosContainerizerZygote::NAME = "zygote";
+
+// The file descriptors sent with a launch request, i.e., the stdin,
+// stdout and stderr of the process.
+static const size_t ZYGOTE_FDS = 3;
+
+
+// Sends a message over a unix socket as its length followed by its
+// data. The file descriptors, if any, are attached to the length.
+static Try<Nothing> send(
+    int socket,
+    const string& data,
+    const vector<int>& fds = vector<int>())
+{
+  CHECK_LE(fds.size(), ZYGOTE_FDS);
+
+  uint32_t length = data.size();
+
+  struct iovec iov;
+  iov.iov_base = &length;
+  iov.iov_len = sizeof(length);
+
+  struct msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+
+  char control[CMSG_SPACE(sizeof(int) * ZYGOTE_FDS)];
+
+  if (!fds.empty()) {
+    memset(control, 0, sizeof(control));
+    message.msg_control = control;
+    message.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+
+    struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+    memcpy(CMSG_DATA(header), fds.data(), sizeof(int) * fds.size());
+  }
+
+  ssize_t sent;
+  while ((sent = ::sendmsg(socket, &message, MSG_NOSIGNAL)) == -1 &&
+         errno == EINTR);
+
+  if (sent == -1) {
+    return ErrnoError("Failed to send the message length");
+  } else if (sent != sizeof(length)) {
+    return Error("Failed to send the message length");
+  }
+
+  return os::write(socket, data);
+}
+
+
+// Receives a message sent by 'send' above, and stores the attached
+// file descriptors in 'fds'. Returns None if the other end of the
+// socket is closed.
+static Result<string> receive(int socket, vector<int>* fds)
+{
+  uint32_t length;
+
+  struct iovec iov;
+  iov.iov_base = &length;
+  iov.iov_len = sizeof(length);
+
+  char control[CMSG_SPACE(sizeof(int) * ZYGOTE_FDS)];
+
+  struct msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+
+  ssize_t received;
+  while ((received = ::recvmsg(socket, &message, MSG_CMSG_CLOEXEC)) == -1 &&
+         errno == EINTR);
+
+  if (received == -1) {
+    return ErrnoError("Failed to receive the message length");
+  } else if (received == 0) {
+    return None();
+  } else if (received != sizeof(length)) {
+    return Error("Failed to receive the message length");
+  }
+
+  for (struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+       header != NULL;
+       header = CMSG_NXTHDR(&message, header)) {
+    if (header->cmsg_level == SOL_SOCKET &&
+        header->cmsg_type == SCM_RIGHTS) {
+      const int* data = reinterpret_cast<const int*>(CMSG_DATA(header));
+      const size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+
+      fds->insert(fds->end(), data, data + count);
+    }
+  }
+
+  Result<string> data = os::read(socket, length);
+  if (data.isError()) {
+    return Error("Failed to receive the message data: " + data.error());
+  } else if (data.isNone() || data.get().size() != length) {
+    return Error("Failed to receive the message data");
+  }
+
+  return data.get();
+}
+
+
+// The main function of a process cloned by the zygote. The zygote is
+// single threaded, so there is no need for async signal safety here.
+static int childMain(
+    int pipes[2],
+    const vector<int>& fds,
+    const string& path,
+    char** argv,
+    char** envp)
+{
+  ::close(pipes[1]);
+
+  // Block until the zygote has moved the process into its cgroups.
+  char dummy;
+  ssize_t length;
+  while ((length = ::read(pipes[0], &dummy, sizeof(dummy))) == -1 &&
+         errno == EINTR);
+
+  if (length != sizeof(dummy)) {
+    ABORT("Failed to synchronize with the zygote");
+  }
+
+  ::close(pipes[0]);
+
+  // Redirect stdin, stdout and stderr. The received file descriptors
+  // are close-on-exec, unlike the duplicated ones.
+  for (size_t i = 0; i < fds.size(); i++) {
+    while (::dup2(fds[i], i) == -1 && errno == EINTR);
+  }
+
+  // Move to a different session (and new process group) so we're
+  // independent from the slave's session, like the Linux launcher.
+  if (::setsid() == -1) {
+    perror("Failed to put child in a new session");
+    return 1;
+  }
+
+  os::execvpe(path.c_str(), argv, envp);
+
+  ABORT("Failed to os::execvpe on path '" + path + "': " + os::strerror(errno));
+}
+
+
+// Moves a process into the cgroups of a launch request, given as a
+// map from the hierarchies to the cgroups.
+static Try<Nothing> assign(
+    const JSON::Object& assignments,
+    bool unified,
+    pid_t pid)
+{
+  foreachpair (const string& hierarchy,
+               const JSON::Value& cgroup,
+               assignments.values) {
+    if (!cgroup.is<JSON::String>()) {
+      return Error("Malformed request");
+    }
+
+    Try<Nothing> assign = unified
+      ? cgroups::unified::assign(
+            hierarchy, cgroup.as<JSON::String>().value, pid)
+      : cgroups::assign(hierarchy, cgroup.as<JSON::String>().value, pid);
+
+    if (assign.isError()) {
+      return Error(
+          "Failed to assign process " + stringify(pid) + " to its cgroup"
+          " in '" + hierarchy + "': " + assign.error());
+    }
+  }
+
+  return Nothing();
+}
+
+
+// Clones the process of a launch request, see 'Zygote::clone'. If
+// the launch fails after the clone, the process is killed and its pid
+// is stored in 'killed', so that the agent, its parent, can reap it.
+static Try<pid_t> launch(
+    const string& request,
+    const vector<int>& fds,
+    Option<pid_t>* killed)
+{
+  if (fds.size() != ZYGOTE_FDS) {
+    return Error("Expecting " + stringify(ZYGOTE_FDS) + " file descriptors");
+  }
+
+  Try<JSON::Object> object = JSON::parse<JSON::Object>(request);
+  if (object.isError()) {
+    return Error("Failed to parse the request: " + object.error());
+  }
+
+  Result<JSON::String> path = object.get().find<JSON::String>("path");
+  Result<JSON::Array> arguments = object.get().find<JSON::Array>("argv");
+  Result<JSON::Number> flags = object.get().find<JSON::Number>("flags");
+  Result<JSON::Object> assignments =
+    object.get().find<JSON::Object>("cgroups");
+  Result<JSON::Object> unified = object.get().find<JSON::Object>("unified");
+  Result<JSON::Object> environment =
+    object.get().find<JSON::Object>("environment");
+
+  if (!path.isSome() || !arguments.isSome() || !flags.isSome() ||
+      !assignments.isSome() || !unified.isSome() || environment.isError()) {
+    return Error("Malformed request");
+  }
+
+  vector<string> argv;
+  foreach (const JSON::Value& value, arguments.get().values) {
+    if (!value.is<JSON::String>()) {
+      return Error("Malformed request");
+    }
+
+    argv.push_back(value.as<JSON::String>().value);
+  }
+
+  vector<string> entries;
+  if (environment.isSome()) {
+    foreachpair (const string& key,
+                 const JSON::Value& value,
+                 environment.get().values) {
+      if (!value.is<JSON::String>()) {
+        return Error("Malformed request");
+      }
+
+      entries.push_back(key + "=" + value.as<JSON::String>().value);
+    }
+  }
+
+  vector<char*> _argv;
+  foreach (const string& argument, argv) {
+    _argv.push_back(const_cast<char*>(argument.c_str()));
+  }
+  _argv.push_back(NULL);
+
+  vector<char*> envp;
+  foreach (const string& entry, entries) {
+    envp.push_back(const_cast<char*>(entry.c_str()));
+  }
+  envp.push_back(NULL);
+
+  // Use a pipe to block the child until it's been moved into its
+  // cgroups.
+  int pipes[2];
+  if (::pipe(pipes) == -1) {
+    return ErrnoError("Failed to create pipe");
+  }
+
+  pid_t pid = os::clone(
+      lambda::bind(
+          &childMain,
+          pipes,
+          fds,
+          path.get().value,
+          _argv.data(),
+          environment.isSome() ? envp.data() : os::raw::environment()),
+      flags.get().as<int>() | CLONE_PARENT);
+
+  ::close(pipes[0]);
+
+  if (pid == -1) {
+    ErrnoError error("Failed to clone");
+    ::close(pipes[1]);
+    return error;
+  }
+
+  Try<Nothing> assign = slave::assign(assignments.get(), false, pid);
+  if (assign.isSome()) {
+    assign = slave::assign(unified.get(), true, pid);
+  }
+
+  if (assign.isError()) {
+    ::kill(pid, SIGKILL);
+    *killed = pid;
+    ::close(pipes[1]);
+    return Error(assign.error());
+  }
+
+  char dummy;
+  ssize_t length;
+  while ((length = ::write(pipes[1], &dummy, sizeof(dummy))) == -1 &&
+         errno == EINTR);
+
+  ::close(pipes[1]);
+
+  if (length != sizeof(dummy)) {
+    ::kill(pid, SIGKILL);
+    *killed = pid;
+    return Error("Failed to synchronize child process");
+  }
+
+  return pid;
+}
+
+
+int MesosContainerizerZygote::execute()
+{
+  // Exit along with the agent.
+  if (::prctl(PR_SET_PDEATHSIG, SIGKILL) == -1) {
+    cerr << "Failed to set the parent death signal: "
+         << os::strerror(errno) << endl;
+    return 1;
+  }
+
+  while (true) {
+    vector<int> fds;
+    Result<string> request = receive(STDIN_FILENO, &fds);
+
+    if (request.isNone()) {
+      return 0;
+    } else if (request.isError()) {
+      cerr << "Failed to receive a launch request: "
+           << request.error() << endl;
+      return 1;
+    }
+
+    Option<pid_t> killed;
+    Try<pid_t> pid = launch(request.get(), fds, &killed);
+
+    foreach (int fd, fds) {
+      ::close(fd);
+    }
+
+    JSON::Object response;
+    if (pid.isError()) {
+      response.values["error"] = pid.error();
+
+      if (killed.isSome()) {
+        response.values["pid"] = killed.get();
+      }
+    } else {
+      response.values["pid"] = pid.get();
+    }
+
+    Try<Nothing> send = slave::send(STDIN_FILENO, stringify(response));
+    if (send.isError()) {
+      cerr << "Failed to send a launch response: " << send.error() << endl;
+      return 1;
+    }
+  }
+}
+
+
+Try<Owned<Zygote>> Zygote::create(const string& path)
+{
+  int sockets[2];
+  if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) == -1) {
+    return ErrnoError("Failed to create the zygote socket");
+  }
+
+  // The zygote reads the requests from its stdin, which is the other
+  // end of the socket.
+  Try<Subprocess> zygote = subprocess(
+      path,
+      {"mesos-containerizer", MesosContainerizerZygote::NAME},
+      Subprocess::FD(sockets[1]),
+      Subprocess::FD(STDOUT_FILENO),
+      Subprocess::FD(STDERR_FILENO));
+
+  os::close(sockets[1]);
+
+  if (zygote.isError()) {
+    os::close(sockets[0]);
+    return Error("Failed to launch the zygote: " + zygote.error());
+  }
+
+  return Owned<Zygote>(new Zygote(zygote.get().pid(), sockets[0]));
+}
+
+
+Zygote::~Zygote()
+{
+  os::close(socket);
+  ::kill(pid, SIGKILL);
+}
+
+
+Try<pid_t> Zygote::clone(
+    const string& path,
+    const vector<string>& argv,
+    int in,
+    int out,
+    int err,
+    const Option<map<string, string>>& environment,
+    int flags,
+    const map<string, string>& cgroups,
+    const map<string, string>& unified)
+{
+  JSON::Object request;
+  request.values["path"] = path;
+  request.values["flags"] = flags;
+
+  JSON::Array arguments;
+  foreach (const string& argument, argv) {
+    arguments.values.push_back(argument);
+  }
+  request.values["argv"] = arguments;
+
+  if (environment.isSome()) {
+    JSON::Object object;
+    foreachpair (const string& key, const string& value, environment.get()) {
+      object.values[key] = value;
+    }
+    request.values["environment"] = object;
+  }
+
+  JSON::Object object;
+  foreachpair (const string& hierarchy, const string& cgroup, cgroups) {
+    object.values[hierarchy] = cgroup;
+  }
+  request.values["cgroups"] = object;
+
+  object.values.clear();
+  foreachpair (const string& hierarchy, const string& cgroup, unified) {
+    object.values[hierarchy] = cgroup;
+  }
+  request.values["unified"] = object;
+
+  Try<Nothing> send = slave::send(socket, stringify(request), {in, out, err});
+  if (send.isError()) {
+    return Error("Failed to send the request to the zygote: " + send.error());
+  }
+
+  vector<int> fds;
+  Result<string> response = receive(socket, &fds);
+  if (!response.isSome()) {
+    return Error(
+        "Failed to receive the response of the zygote: " +
+        (response.isError() ? response.error() : "the zygote exited"));
+  }
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get());
+  if (parse.isError()) {
+    return Error("Failed to parse the response of the zygote: " +
+                 parse.error());
+  }
+
+  Result<JSON::String> error = parse.get().find<JSON::String>("error");
+  Result<JSON::Number> pid = parse.get().find<JSON::Number>("pid");
+
+  if (error.isSome()) {
+    // The zygote killed the process it cloned, which is our child.
+    if (pid.isSome()) {
+      ::waitpid(pid.get().as<pid_t>(), NULL, 0);
+    }
+
+    return Error(error.get().value);
+  } else if (!pid.isSome()) {
+    return Error("Malformed response of the zygote");
+  }
+
+  return pid.get().as<pid_t>();
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
@@ -0,0 +1,100 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __MESOS_CONTAINERIZER_ZYGOTE_HPP__
+#define __MESOS_CONTAINERIZER_ZYGOTE_HPP__
+
+#include <sys/types.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <process/owned.hpp>
+
+#include <stout/flags.hpp>
+#include <stout/option.hpp>
+#include <stout/subcommand.hpp>
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// The "zygote" subcommand clones the processes of the containers on
+// behalf of the Linux launcher. The launcher starts it while the
+// agent is still small, and sends it the launch requests over the
+// unix socket which is its stdin. Cloning from the zygote rather than
+// from the agent keeps the cost of copying the page tables of the
+// agent, which grows with its memory footprint, out of the launches.
+class MesosContainerizerZygote : public Subcommand
+{
+public:
+  static const std::string NAME;
+
+  struct Flags : public flags::FlagsBase {};
+
+  MesosContainerizerZygote() : Subcommand(NAME) {}
+
+  Flags flags;
+
+protected:
+  virtual int execute();
+  virtual flags::FlagsBase* getFlags() { return &flags; }
+};
+
+
+// The agent side of a zygote.
+class Zygote
+{
+public:
+  // Starts a zygote with the 'mesos-containerizer' binary at 'path'.
+  static Try<process::Owned<Zygote>> create(const std::string& path);
+
+  ~Zygote();
+
+  // Clones a process, with the given clone flags, which redirects its
+  // stdin, stdout and stderr to the given file descriptors and execs
+  // 'path'. The zygote moves the process into the given cgroups, as
+  // maps from cgroups v1 hierarchies and from unified hierarchies to
+  // cgroups, before it execs. The process is cloned with CLONE_PARENT,
+  // so it is a child of the caller rather than of the zygote, and the
+  // caller can reap it.
+  Try<pid_t> clone(
+      const std::string& path,
+      const std::vector<std::string>& argv,
+      int in,
+      int out,
+      int err,
+      const Option<std::map<std::string, std::string>>& environment,
+      int flags,
+      const std::map<std::string, std::string>& cgroups,
+      const std::map<std::string, std::string>& unified);
+
+private:
+  Zygote(pid_t _pid, int _socket) : pid(_pid), socket(_socket) {}
+
+  const pid_t pid;
+
+  // The agent end of the unix socket to the zygote.
+  const int socket;
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __MESOS_CONTAINERIZER_ZYGOTE_HPP__
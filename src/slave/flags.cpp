@@ -102,6 +102,42 @@ mesos::internal::slave::Flags::Flags()
       "network, pid, etc. If unspecified, the slave will choose the Linux\n"
       "launcher if it's running as root on Linux.");
 
+  add(&Flags::launcher_zygote,
+      "launcher_zygote",
+      "Whether the Linux launcher clones the processes of the containers\n"
+      "from a small helper process, started with the slave, rather than\n"
+      "from the slave itself. This keeps the cost of copying the page\n"
+      "tables of the slave, which grows with its memory footprint, out of\n"
+      "the container launches.",
+      false);
+
+  add(&Flags::container_logger,
+      "container_logger",
+      "The name of the container logger to use for the output of the\n"
+      "executors: 'rotate' for the built-in logger, which rotates the\n"
+      "'stdout' and 'stderr' files of the sandboxes by size, or the name\n"
+      "of a container logger module. By default the output is written to\n"
+      "the 'stdout' and 'stderr' files of the sandboxes.");
+
+  add(&Flags::container_logger_max_size,
+      "container_logger_max_size",
+      "The size at which the 'rotate' container logger rotates the\n"
+      "'stdout' and 'stderr' files of a sandbox.",
+      DEFAULT_CONTAINER_LOGGER_MAX_SIZE);
+
+  add(&Flags::container_logger_max_files,
+      "container_logger_max_files",
+      "The number of rotated files the 'rotate' container logger keeps\n"
+      "for each of the 'stdout' and 'stderr' files of a sandbox, e.g.,\n"
+      "'stdout.1' to 'stdout.5'. Older files are removed.",
+      DEFAULT_CONTAINER_LOGGER_MAX_FILES);
+
+  add(&Flags::container_logger_compress,
+      "container_logger_compress",
+      "Whether the 'rotate' container logger compresses the files it\n"
+      "rotates with gzip.",
+      true);
+
   add(&Flags::image_providers,
       "image_providers",
       "Comma-separated list of supported image providers,\n"
@@ -110,7 +146,7 @@ mesos::internal::slave::Flags::Flags()
   add(&Flags::image_provisioner_backend,
       "image_provisioner_backend",
       "Strategy for provisioning container rootfs from images,\n"
-      "e.g., 'bind', 'copy'.",
+      "e.g., 'bind', 'copy', 'overlay'.",
       "copy");
 
   add(&Flags::appc_store_dir,
@@ -143,6 +179,13 @@ mesos::internal::slave::Flags::Flags()
       "Timeout in seconds for pulling images from the Docker registry",
       "60");
 
+  add(&Flags::docker_puller_max_concurrent_downloads,
+      "docker_puller_max_concurrent_downloads",
+      "Maximum number of image layers that the registry puller downloads\n"
+      "at the same time, for all images combined. Layers shared by images\n"
+      "pulled at the same time are downloaded once.",
+      DEFAULT_DOCKER_PULLER_MAX_CONCURRENT_DOWNLOADS);
+
   add(&Flags::docker_registry,
       "docker_registry",
       "Default Docker image registry server host",
@@ -158,6 +201,13 @@ mesos::internal::slave::Flags::Flags()
       "Directory the Docker provisioner will store images in",
       "/tmp/mesos/store/docker");
 
+  add(&Flags::docker_store_max_size,
+      "docker_store_max_size",
+      "Maximum size of the layers of the images in the Docker store. Once\n"
+      "it is exceeded, the least recently used images are removed, with\n"
+      "the layers that no other image has, except for the images used by\n"
+      "containers. By default images are never removed.");
+
   add(&Flags::default_role,
       "default_role",
       "Any resources in the --resources flag that\n"
@@ -191,6 +241,20 @@ mesos::internal::slave::Flags::Flags()
       "(one subdirectory per slave).",
       "/tmp/mesos/fetch");
 
+  add(&Flags::fetcher_max_concurrent_downloads,
+      "fetcher_max_concurrent_downloads",
+      "Maximum number of URIs that the fetcher downloads at the same\n"
+      "time, for all containers combined. The URIs of a container are\n"
+      "downloaded concurrently as long as this allows it.",
+      DEFAULT_FETCHER_MAX_CONCURRENT_DOWNLOADS);
+
+  add(&Flags::image_prefetch_max_concurrent_pulls,
+      "image_prefetch_max_concurrent_pulls",
+      "Maximum number of images, requested through the '/images'\n"
+      "endpoints of the slave or the master, that the slave pulls at the\n"
+      "same time ahead of the tasks that use them.",
+      DEFAULT_IMAGE_PREFETCH_MAX_CONCURRENT_PULLS);
+
   add(&Flags::work_dir,
       "work_dir",
       "Directory path to place framework work directories\n", "/tmp/mesos");
@@ -273,6 +337,45 @@ mesos::internal::slave::Flags::Flags()
       "to shut down (e.g., 60secs, 3mins, etc)",
       EXECUTOR_SHUTDOWN_GRACE_PERIOD);
 
+  add(&Flags::executor_status_update_window,
+      "executor_status_update_window",
+      "Amount of time for which the executor driver collects the status\n"
+      "updates that an executor sends, to send them to the slave in one\n"
+      "message (e.g., 10ms). The slave checkpoints the updates of such a\n"
+      "message at once. Executors that run many short tasks can use this\n"
+      "to reduce the number of messages and disk writes, at the cost of\n"
+      "delaying the updates by up to this long. 0 disables batching.",
+      Duration::zero());
+
+  add(&Flags::batch_status_updates,
+      "batch_status_updates",
+      "Whether to forward the status updates of tasks that the slave\n"
+      "gets at about the same time, e.g., when many tasks terminate,\n"
+      "to the master in one message rather than one message each.\n"
+      "The master must be of a version that handles these messages,\n"
+      "it then also sends the acknowledgements of the updates in\n"
+      "batches.",
+      false);
+
+  add(&Flags::max_http_executor_buffer_size,
+      "max_http_executor_buffer_size",
+      "The maximum amount of events (e.g., 16MB) that the slave buffers\n"
+      "for an HTTP executor that does not keep up with reading them.\n"
+      "Once exceeded, the slave stops sending events to the executor and\n"
+      "closes its connection, i.e., the executor has to subscribe again.",
+      DEFAULT_MAX_HTTP_EXECUTOR_BUFFER_SIZE);
+
+  add(&Flags::direct_framework_messages,
+      "direct_framework_messages",
+      "Whether to accept the framework messages that schedulers using\n"
+      "the HTTP API send to the slave directly, rather than through the\n"
+      "master. The messages of the executors of such a framework are\n"
+      "then sent directly to its scheduler as well. The master cannot\n"
+      "vouch for the pid of such a scheduler: the slave accepts the\n"
+      "first pid that sends a message for the framework, and only that\n"
+      "pid until the framework fails over.",
+      false);
+
   add(&Flags::gc_delay,
       "gc_delay",
       "Maximum amount of time to wait before cleaning up\n"
@@ -347,12 +450,32 @@ mesos::internal::slave::Flags::Flags()
       "swap instead of just memory.\n",
       false);
 
+  add(&Flags::cgroups_reclaim_revocable_memory,
+      "cgroups_reclaim_revocable_memory",
+      "Cgroups feature flag to reclaim the memory of the containers with\n"
+      "revocable memory first: their soft limit covers only their\n"
+      "non-revocable memory, and their page cache is dropped on critical\n"
+      "memory pressure events.\n",
+      false);
+
   add(&Flags::cgroups_cpu_enable_pids_and_tids_count,
       "cgroups_cpu_enable_pids_and_tids_count",
       "Cgroups feature flag to enable counting of processes and threads\n"
       "inside a container.\n",
       false);
 
+  add(&Flags::cgroups_unified,
+      "cgroups_unified",
+      "Cgroups feature flag to use the cgroups v2 unified hierarchy in\n"
+      "the Linux launcher and the 'cgroups/cpu' and 'cgroups/mem'\n"
+      "isolators. Each container then gets a single cgroup, in place of\n"
+      "a cgroup in each of the freezer, cpu, cpuacct and memory\n"
+      "hierarchies. The unified hierarchy is mounted at\n"
+      "'<cgroups_hierarchy>/unified' unless it is mounted already, and\n"
+      "the 'cpu' and 'memory' controllers must not be attached to a\n"
+      "cgroups v1 hierarchy.\n",
+      false);
+
   add(&Flags::slave_subsystems,
       "slave_subsystems",
       "List of comma-separated cgroup subsystems to run the slave binary\n"
@@ -385,6 +508,18 @@ mesos::internal::slave::Flags::Flags()
       "than the perf_interval.",
       Seconds(10));
 
+  add(&Flags::perf_sampler,
+      "perf_sampler",
+      "How the perf_event isolator samples the perf events. With 'perf',\n"
+      "'perf stat' is run for perf_duration every perf_interval. With\n"
+      "'native', the events of each container are counted with\n"
+      "perf_event_open(2) for as long as the container exists and the\n"
+      "counters are read every perf_interval, so a sample covers the\n"
+      "whole interval and perf_duration is ignored. The native sampler\n"
+      "does not need the perf tool but only supports the events that\n"
+      "have a field in the PerfStatistics protobuf.",
+      "perf");
+
   add(&Flags::revocable_cpu_low_priority,
       "revocable_cpu_low_priority",
       "Run containers with revocable CPU at a lower priority than\n"
@@ -437,6 +572,16 @@ mesos::internal::slave::Flags::Flags()
       "The path to the external containerizer executable used when\n"
       "external isolation is activated (--isolation=external).");
 
+  add(&Flags::external_containerizer_daemon,
+      "external_containerizer_daemon",
+      "Whether to run the external containerizer executable once, with\n"
+      "the 'daemon' command, and to send it all the calls over a unix\n"
+      "socket instead of invoking it for every call. The daemon\n"
+      "answers the calls, which are \"Record-IO\" encoded\n"
+      "'containerizer::Call' messages, with 'containerizer::Response'\n"
+      "messages, and gathers the usage of all containers per call.",
+      false);
+
   add(&Flags::containerizers,
       "containerizers",
       "Comma-separated list of containerizer implementations\n"
@@ -552,6 +697,17 @@ mesos::internal::slave::Flags::Flags()
       "This flag uses the Bytes type (defined in stout) and is used for\n"
       "the 'network/port_mapping' isolator.");
 
+  add(&Flags::ingress_rate_limit_per_container,
+      "ingress_rate_limit_per_container",
+      "The limit of the ingress traffic for each container, in Bytes/s.\n"
+      "If not specified or specified as zero, the network isolator will\n"
+      "impose no limits to containers' ingress traffic throughput.\n"
+      "The traffic over the limit is queued and then dropped, which is\n"
+      "reported in the 'ingress_bw_limit' and 'ingress_bloat_reduction'\n"
+      "traffic control statistics of the containers. This flag uses the\n"
+      "Bytes type (defined in stout) and is used for the\n"
+      "'network/port_mapping' isolator.");
+
   add(&Flags::egress_unique_flow_per_container,
       "egress_unique_flow_per_container",
       "Whether to assign an individual flow for each container for the\n"
@@ -657,6 +813,14 @@ mesos::internal::slave::Flags::Flags()
       "A comma-separated list of hook modules to be\n"
       "installed inside the slave.");
 
+  add(&Flags::hook_timeout,
+      "hook_timeout",
+      "The maximum amount of time to wait for each hook module on the\n"
+      "hooks that the slave invokes asynchronously (e.g., the label\n"
+      "decorator of the launched tasks). The result of a hook module that\n"
+      "does not return in time is ignored.",
+      Seconds(5));
+
   add(&Flags::resource_estimator,
       "resource_estimator",
       "The name of the resource estimator to use for oversubscription.");
@@ -679,4 +843,13 @@ mesos::internal::slave::Flags::Flags()
       "about the total amount of oversubscribed resources that are allocated\n"
       "and available. The interval between updates is controlled by this flag.",
       Seconds(15));
+
+  add(&Flags::usage_sampling_interval,
+      "usage_sampling_interval",
+      "If set, the slave samples the resource usage of all its containers\n"
+      "in the background at this interval, and serves the latest sample to\n"
+      "the '/monitor/statistics' endpoint, the resource estimator and the\n"
+      "QoS controller, instead of collecting the usage for each of them.\n"
+      "The endpoint then also reports the rates of the usage since the\n"
+      "previous sample. If not set, the usage is collected on demand.");
 }
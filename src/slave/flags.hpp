@@ -46,6 +46,11 @@ public:
   Option<std::string> resources;
   std::string isolation;
   Option<std::string> launcher;
+  bool launcher_zygote;
+  Option<std::string> container_logger;
+  Bytes container_logger_max_size;
+  size_t container_logger_max_files;
+  bool container_logger_compress;
 
   Option<std::string> image_providers;
   std::string image_provisioner_backend;
@@ -56,14 +61,18 @@ public:
   std::string docker_local_archives_dir;
   std::string docker_puller;
   std::string docker_puller_timeout_secs;
+  size_t docker_puller_max_concurrent_downloads;
   std::string docker_registry;
   std::string docker_registry_port;
   std::string docker_store_dir;
+  Option<Bytes> docker_store_max_size;
 
   std::string default_role;
   Option<std::string> attributes;
   Bytes fetcher_cache_size;
   std::string fetcher_cache_dir;
+  size_t fetcher_max_concurrent_downloads;
+  size_t image_prefetch_max_concurrent_pulls;
   std::string work_dir;
   std::string launcher_dir;
   std::string hadoop_home; // TODO(benh): Make an Option.
@@ -73,6 +82,10 @@ public:
   Option<JSON::Object> executor_environment_variables;
   Duration executor_registration_timeout;
   Duration executor_shutdown_grace_period;
+  Duration executor_status_update_window;
+  Bytes max_http_executor_buffer_size;
+  bool batch_status_updates;
+  bool direct_framework_messages;
   Duration gc_delay;
   double gc_disk_headroom;
   Duration disk_watch_interval;
@@ -86,17 +99,21 @@ public:
   std::string cgroups_root;
   bool cgroups_enable_cfs;
   bool cgroups_limit_swap;
+  bool cgroups_reclaim_revocable_memory;
   bool cgroups_cpu_enable_pids_and_tids_count;
+  bool cgroups_unified;
   Option<std::string> slave_subsystems;
   Option<std::string> perf_events;
   Duration perf_interval;
   Duration perf_duration;
+  std::string perf_sampler;
   bool revocable_cpu_low_priority;
   std::string systemd_runtime_directory;
 #endif
   Option<Firewall> firewall_rules;
   Option<Path> credential;
   Option<std::string> containerizer_path;
+  bool external_containerizer_daemon;
   std::string containerizers;
   Option<std::string> default_container_image;
   std::string docker;
@@ -112,6 +129,7 @@ public:
   Option<std::string> eth0_name;
   Option<std::string> lo_name;
   Option<Bytes> egress_rate_limit_per_container;
+  Option<Bytes> ingress_rate_limit_per_container;
   bool egress_unique_flow_per_container;
   std::string egress_flow_classifier_parent;
   bool network_enable_socket_statistics_summary;
@@ -122,10 +140,12 @@ public:
   Option<Modules> modules;
   std::string authenticatee;
   Option<std::string> hooks;
+  Duration hook_timeout;
   Option<std::string> resource_estimator;
   Option<std::string> qos_controller;
   Duration qos_correction_interval_min;
   Duration oversubscribed_resources_interval;
+  Option<Duration> usage_sampling_interval;
 };
 
 } // namespace slave {
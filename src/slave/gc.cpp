@@ -14,16 +14,28 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <fts.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif // __linux__
+
 #include <list>
 
+#include <process/async.hpp>
+#include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/dispatch.hpp>
+#include <process/id.hpp>
 
 #include <stout/foreach.hpp>
-#include <stout/os/rmdir.hpp>
+#include <stout/lambda.hpp>
+#include <stout/os/strerror.hpp>
 
 #include "logging/logging.hpp"
 
+#include "slave/constants.hpp"
 #include "slave/gc.hpp"
 
 using namespace process;
@@ -38,12 +50,120 @@ namespace mesos {
 namespace internal {
 namespace slave {
 
+#ifdef __linux__
+// See 'linux/ioprio.h', which not all systems have.
+static const int IOPRIO_WHO_PROCESS = 1;
+static const int IOPRIO_CLASS_BE = 2;
+static const int IOPRIO_CLASS_SHIFT = 13;
+#endif // __linux__
+
+
+// Removes the directory like 'os::rmdir', and returns the number of
+// bytes of disk that its files took up. The removal runs with the
+// lowest I/O priority of the default class on Linux, so that it does
+// not starve the tasks that read and write the same disk. We do not
+// use the idle class, which would never remove anything under a
+// steady load.
+static Try<Bytes> removeDirectory(const string& directory)
+{
+#ifdef __linux__
+  // The I/O priority is that of the calling thread, one of the worker
+  // threads of libprocess, so we restore it once we are done.
+  const int priority = syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, 0);
+
+  if (priority < 0 ||
+      syscall(SYS_ioprio_set,
+              IOPRIO_WHO_PROCESS,
+              0,
+              (IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT) | 7) < 0) {
+    PLOG(WARNING) << "Failed to lower the I/O priority to delete '"
+                  << directory << "'";
+  }
+#endif // __linux__
+
+  Bytes bytes;
+  Option<Error> error;
+
+  char* paths[] = {const_cast<char*>(directory.c_str()), NULL};
+
+  FTS* tree = fts_open(paths, FTS_NOCHDIR, NULL);
+  if (tree == NULL) {
+    error = ErrnoError();
+  } else {
+    FTSENT* node;
+    while (error.isNone() && (node = fts_read(tree)) != NULL) {
+      switch (node->fts_info) {
+        case FTS_DP:
+          if (::rmdir(node->fts_path) < 0 && errno != ENOENT) {
+            error = ErrnoError();
+          } else {
+            bytes += Bytes(node->fts_statp->st_blocks * 512);
+          }
+          break;
+        case FTS_F:
+        case FTS_SL:
+        case FTS_DEFAULT:
+          if (::unlink(node->fts_path) < 0 && errno != ENOENT) {
+            error = ErrnoError();
+          } else {
+            bytes += Bytes(node->fts_statp->st_blocks * 512);
+          }
+          break;
+        case FTS_NS:
+        case FTS_ERR:
+          // The directory itself must exist, its contents might have
+          // been removed meanwhile.
+          if (node->fts_errno != ENOENT ||
+              node->fts_level == FTS_ROOTLEVEL) {
+            error = Error(os::strerror(node->fts_errno));
+          }
+          break;
+        default:
+          break;
+      }
+    }
+
+    if (error.isNone() && errno != 0) {
+      error = ErrnoError();
+    }
+
+    if (fts_close(tree) < 0 && error.isNone()) {
+      error = ErrnoError();
+    }
+  }
+
+#ifdef __linux__
+  if (priority >= 0) {
+    syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, priority);
+  }
+#endif // __linux__
+
+  if (error.isSome()) {
+    return error.get();
+  }
+
+  return bytes;
+}
+
+
+GarbageCollectorProcess::GarbageCollectorProcess()
+  : ProcessBase(process::ID::generate("gc")),
+    metrics(*this) {}
+
 
 GarbageCollectorProcess::~GarbageCollectorProcess()
 {
   foreachvalue (const PathInfo& info, paths) {
     info.promise->discard();
   }
+
+  foreach (const PathInfo& info, queued) {
+    info.promise->discard();
+  }
+
+  foreach (const PathInfo& info, removing) {
+    info.promise->discard();
+  }
 }
 
 
@@ -124,28 +244,15 @@ void GarbageCollectorProcess::reset()
 
 void GarbageCollectorProcess::remove(const Timeout& removalTime)
 {
-  // TODO(bmahler): Other dispatches can block waiting for a removal
-  // operation. To fix this, the removal operation can be done
-  // asynchronously in another thread.
   if (paths.count(removalTime) > 0) {
     foreach (const PathInfo& info, paths.get(removalTime)) {
-      LOG(INFO) << "Deleting " << info.path;
-
-      Try<Nothing> rmdir = os::rmdir(info.path);
-
-      if (rmdir.isError()) {
-        LOG(WARNING) << "Failed to delete '" << info.path << "': "
-                     << rmdir.error();
-        info.promise->fail(rmdir.error());
-      } else {
-        LOG(INFO) << "Deleted '" << info.path << "'";
-        info.promise->set(rmdir.get());
-      }
-
+      queued.push_back(info);
       timeouts.erase(info.path);
     }
 
     paths.remove(removalTime);
+
+    removeQueued();
   } else {
     // This occurs when either:
     //   1. The path(s) has already been removed (e.g. by prune()).
@@ -158,6 +265,52 @@ void GarbageCollectorProcess::remove(const Timeout& removalTime)
 }
 
 
+void GarbageCollectorProcess::removeQueued()
+{
+  while (!queued.empty() && removing.size() < GC_MAX_CONCURRENT_REMOVALS) {
+    const PathInfo info = queued.front();
+    queued.pop_front();
+
+    LOG(INFO) << "Deleting " << info.path;
+
+    removing.push_back(info);
+
+    async(&removeDirectory, info.path)
+      .onAny(defer(self(), &Self::_remove, lambda::_1, info));
+  }
+}
+
+
+void GarbageCollectorProcess::_remove(
+    const Future<Try<Bytes>>& removal,
+    const PathInfo& info)
+{
+  removing.remove(info);
+
+  if (!removal.isReady() || removal.get().isError()) {
+    const string error = removal.isFailed()
+      ? removal.failure()
+      : removal.isDiscarded()
+      ? "discarded"
+      : removal.get().error();
+
+    LOG(WARNING) << "Failed to delete '" << info.path << "': " << error;
+
+    ++metrics.path_removals_failed;
+    info.promise->fail(error);
+  } else {
+    LOG(INFO) << "Deleted '" << info.path << "', reclaiming "
+              << removal.get().get();
+
+    ++metrics.path_removals_succeeded;
+    metrics.bytes_reclaimed += removal.get().get().bytes();
+    info.promise->set(Nothing());
+  }
+
+  removeQueued();
+}
+
+
 void GarbageCollectorProcess::prune(const Duration& d)
 {
   foreach (const Timeout& removalTime, paths.keys()) {
@@ -17,6 +17,7 @@
 #ifndef __SLAVE_GC_HPP__
 #define __SLAVE_GC_HPP__
 
+#include <list>
 #include <string>
 #include <vector>
 
@@ -26,6 +27,11 @@
 #include <process/timeout.hpp>
 #include <process/timer.hpp>
 
+#include <process/metrics/counter.hpp>
+#include <process/metrics/gauge.hpp>
+#include <process/metrics/metrics.hpp>
+
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/multimap.hpp>
@@ -74,7 +80,9 @@ public:
   virtual process::Future<bool> unschedule(const std::string& path);
 
   // Deletes all the directories, whose scheduled garbage collection time
-  // is within the next 'd' duration of time.
+  // is within the next 'd' duration of time. The directories are
+  // deleted in the order they were scheduled to be, i.e., the oldest
+  // ones first.
   virtual void prune(const Duration& d);
 
 private:
@@ -86,6 +94,8 @@ class GarbageCollectorProcess :
     public process::Process<GarbageCollectorProcess>
 {
 public:
+  GarbageCollectorProcess();
+
   virtual ~GarbageCollectorProcess();
 
   process::Future<Nothing> schedule(
@@ -99,8 +109,15 @@ public:
 private:
   void reset();
 
+  // Queues the paths due at the removal time for removal.
   void remove(const process::Timeout& removalTime);
 
+  // Starts removing the queued paths, up to
+  // 'GC_MAX_CONCURRENT_REMOVALS' of them at a time. The paths are
+  // removed outside of this process, so that removing a big directory
+  // does not delay the other operations.
+  void removeQueued();
+
   struct PathInfo
   {
     PathInfo(const std::string& _path,
@@ -116,6 +133,20 @@ private:
     const process::Owned<process::Promise<Nothing> > promise;
   };
 
+  void _remove(
+      const process::Future<Try<Bytes>>& removal,
+      const PathInfo& info);
+
+  double _path_removals_pending()
+  {
+    return static_cast<double>(queued.size());
+  }
+
+  double _path_removals_active()
+  {
+    return static_cast<double>(removing.size());
+  }
+
   // Store all the timeouts and corresponding paths to delete.
   // NOTE: We are using Multimap here instead of Multihashmap, because
   // we need the keys of the map (deletion time) to be sorted.
@@ -126,6 +157,47 @@ private:
   hashmap<std::string, process::Timeout> timeouts;
 
   process::Timer timer;
+
+  // The paths that are due, in the order they were due, and the
+  // paths that are being removed. These can no longer be unscheduled.
+  std::list<PathInfo> queued;
+  std::list<PathInfo> removing;
+
+  struct Metrics
+  {
+    explicit Metrics(const GarbageCollectorProcess& process)
+      : path_removals_pending(
+            "gc/path_removals_pending",
+            defer(process, &GarbageCollectorProcess::_path_removals_pending)),
+        path_removals_active(
+            "gc/path_removals_active",
+            defer(process, &GarbageCollectorProcess::_path_removals_active)),
+        path_removals_succeeded("gc/path_removals_succeeded"),
+        path_removals_failed("gc/path_removals_failed"),
+        bytes_reclaimed("gc/bytes_reclaimed")
+    {
+      process::metrics::add(path_removals_pending);
+      process::metrics::add(path_removals_active);
+      process::metrics::add(path_removals_succeeded);
+      process::metrics::add(path_removals_failed);
+      process::metrics::add(bytes_reclaimed);
+    }
+
+    ~Metrics()
+    {
+      process::metrics::remove(path_removals_pending);
+      process::metrics::remove(path_removals_active);
+      process::metrics::remove(path_removals_succeeded);
+      process::metrics::remove(path_removals_failed);
+      process::metrics::remove(bytes_reclaimed);
+    }
+
+    process::metrics::Gauge path_removals_pending;
+    process::metrics::Gauge path_removals_active;
+    process::metrics::Counter path_removals_succeeded;
+    process::metrics::Counter path_removals_failed;
+    process::metrics::Counter bytes_reclaimed;
+  } metrics;
 };
 
 } // namespace slave {
@@ -27,6 +27,7 @@
 #include <mesos/attributes.hpp>
 #include <mesos/type_utils.hpp>
 
+#include <process/async.hpp>
 #include <process/help.hpp>
 #include <process/owned.hpp>
 
@@ -37,11 +38,13 @@
 #include <stout/lambda.hpp>
 #include <stout/net.hpp>
 #include <stout/numify.hpp>
+#include <stout/protobuf.hpp>
 #include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 
 #include "common/build.hpp"
 #include "common/http.hpp"
+#include "common/memory_usage.hpp"
 
 #include "internal/devolve.hpp"
 
@@ -52,6 +55,7 @@
 #include "slave/validation.hpp"
 
 
+using process::async;
 using process::Clock;
 using process::DESCRIPTION;
 using process::Future;
@@ -179,6 +183,392 @@ JSON::Object model(const Framework& framework)
 }
 
 
+// Writes the same JSON as 'model' for a TaskInfo.
+//
+// NOTE: This is not a 'json' overload since it would not be found
+// by argument-dependent lookup for a TaskInfo (which lives in the
+// 'mesos' namespace), use it through a lambda instead.
+static void writeTaskInfo(JSON::ObjectWriter* writer, const TaskInfo& task)
+{
+  writer->field("id", task.task_id().value());
+  writer->field("name", task.name());
+  writer->field("slave_id", task.slave_id().value());
+  writer->field("resources", Resources(task.resources()));
+
+  if (task.has_command()) {
+    writer->field("command", task.command());
+  }
+  if (task.has_executor()) {
+    writer->field("executor_id", task.executor().executor_id().value());
+  }
+}
+
+
+// The state of an executor as of a '/state' request, copied so that
+// it can be rendered outside of the slave, see 'Slave::Http::state()'.
+struct ExecutorSnapshot
+{
+  ExecutorSnapshot(const Executor& executor, bool completed)
+    : id(executor.id),
+      info(executor.info),
+      containerId(executor.containerId),
+      directory(executor.directory),
+      resources(executor.resources)
+  {
+    foreach (Task* task, executor.launchedTasks.values()) {
+      tasks.push_back(*task);
+    }
+
+    foreach (const TaskInfo& task, executor.queuedTasks.values()) {
+      queuedTasks.push_back(task);
+    }
+
+    if (completed) {
+      foreach (const std::shared_ptr<Task>& task, executor.completedTasks) {
+        completedTasks.push_back(*task);
+      }
+
+      // NOTE: We add 'terminatedTasks' to 'completed_tasks' for
+      // simplicity.
+      foreach (Task* task, executor.terminatedTasks.values()) {
+        completedTasks.push_back(*task);
+      }
+    }
+  }
+
+  ExecutorID id;
+  ExecutorInfo info;
+  ContainerID containerId;
+  string directory;
+  Resources resources;
+  vector<Task> tasks;
+  vector<TaskInfo> queuedTasks;
+  vector<Task> completedTasks;
+};
+
+
+// The state of a framework as of a '/state' request, with the
+// executors that pass the filter of the request.
+struct FrameworkSnapshot
+{
+  FrameworkSnapshot(
+      const Framework& framework,
+      const Option<string>& executorId,
+      bool completed)
+    : id(framework.id()),
+      info(framework.info)
+  {
+    foreachvalue (Executor* executor, framework.executors) {
+      if (executorId.isNone() || executor->id.value() == executorId.get()) {
+        executors.push_back(ExecutorSnapshot(*executor, completed));
+      }
+    }
+
+    if (completed) {
+      foreach (const Owned<Executor>& executor,
+               framework.completedExecutors) {
+        if (executorId.isNone() ||
+            executor->id.value() == executorId.get()) {
+          completedExecutors.push_back(ExecutorSnapshot(*executor, true));
+        }
+      }
+    }
+  }
+
+  FrameworkID id;
+  FrameworkInfo info;
+  vector<ExecutorSnapshot> executors;
+  vector<ExecutorSnapshot> completedExecutors;
+};
+
+
+// The state of the slave as of a '/state' request.
+struct SlaveSnapshot
+{
+  double startTime;
+  SlaveInfo info;
+  string pid;
+  Option<net::IP> master;
+  Option<string> logDir;
+  Option<string> externalLogFile;
+  vector<FrameworkSnapshot> frameworks;
+  vector<FrameworkSnapshot> completedFrameworks;
+  vector<std::pair<string, string>> flags;
+};
+
+
+// Writes the same JSON as 'model' for an Executor.
+void json(JSON::ObjectWriter* writer, const ExecutorSnapshot& executor)
+{
+  writer->field("id", executor.id.value());
+  writer->field("name", executor.info.name());
+  writer->field("source", executor.info.source());
+  writer->field("container", executor.containerId.value());
+  writer->field("directory", executor.directory);
+  writer->field("resources", executor.resources);
+
+  writer->field("tasks", [&executor](JSON::ArrayWriter* writer) {
+    foreach (const Task& task, executor.tasks) {
+      writer->element(task);
+    }
+  });
+
+  writer->field("queued_tasks", [&executor](JSON::ArrayWriter* writer) {
+    foreach (const TaskInfo& task, executor.queuedTasks) {
+      writer->element([&task](JSON::ObjectWriter* writer) {
+        writeTaskInfo(writer, task);
+      });
+    }
+  });
+
+  writer->field("completed_tasks", [&executor](JSON::ArrayWriter* writer) {
+    foreach (const Task& task, executor.completedTasks) {
+      writer->element(task);
+    }
+  });
+}
+
+
+// Writes the same JSON as 'model' for a Framework.
+void json(JSON::ObjectWriter* writer, const FrameworkSnapshot& framework)
+{
+  writer->field("id", framework.id.value());
+  writer->field("name", framework.info.name());
+  writer->field("user", framework.info.user());
+  writer->field("failover_timeout", framework.info.failover_timeout());
+  writer->field("checkpoint", framework.info.checkpoint());
+  writer->field("role", framework.info.role());
+  writer->field("hostname", framework.info.hostname());
+
+  writer->field("executors", [&framework](JSON::ArrayWriter* writer) {
+    foreach (const ExecutorSnapshot& executor, framework.executors) {
+      writer->element(executor);
+    }
+  });
+
+  writer->field(
+      "completed_executors", [&framework](JSON::ArrayWriter* writer) {
+        foreach (const ExecutorSnapshot& executor,
+                 framework.completedExecutors) {
+          writer->element(executor);
+        }
+      });
+}
+
+
+void json(JSON::ObjectWriter* writer, const SlaveSnapshot& slave)
+{
+  writer->field("version", MESOS_VERSION);
+
+  if (build::GIT_SHA.isSome()) {
+    writer->field("git_sha", build::GIT_SHA.get());
+  }
+
+  if (build::GIT_BRANCH.isSome()) {
+    writer->field("git_branch", build::GIT_BRANCH.get());
+  }
+
+  if (build::GIT_TAG.isSome()) {
+    writer->field("git_tag", build::GIT_TAG.get());
+  }
+
+  writer->field("build_date", build::DATE);
+  writer->field("build_time", build::TIME);
+  writer->field("build_user", build::USER);
+  writer->field("start_time", slave.startTime);
+  writer->field("id", slave.info.id().value());
+  writer->field("pid", slave.pid);
+  writer->field("hostname", slave.info.hostname());
+  writer->field("resources", Resources(slave.info.resources()));
+  writer->field("attributes", Attributes(slave.info.attributes()));
+
+  if (slave.master.isSome()) {
+    Try<string> hostname = net::getHostname(slave.master.get());
+    if (hostname.isSome()) {
+      writer->field("master_hostname", hostname.get());
+    }
+  }
+
+  if (slave.logDir.isSome()) {
+    writer->field("log_dir", slave.logDir.get());
+  }
+
+  if (slave.externalLogFile.isSome()) {
+    writer->field("external_log_file", slave.externalLogFile.get());
+  }
+
+  writer->field("frameworks", [&slave](JSON::ArrayWriter* writer) {
+    foreach (const FrameworkSnapshot& framework, slave.frameworks) {
+      writer->element(framework);
+    }
+  });
+
+  writer->field("completed_frameworks", [&slave](JSON::ArrayWriter* writer) {
+    foreach (const FrameworkSnapshot& framework, slave.completedFrameworks) {
+      writer->element(framework);
+    }
+  });
+
+  writer->field("flags", [&slave](JSON::ObjectWriter* writer) {
+    foreach (const auto& flag, slave.flags) {
+      writer->field(flag.first, flag.second);
+    }
+  });
+}
+
+
+// Sets the protobuf counterparts of the fields that 'json' writes
+// for an Executor, for the protobuf responses of '/state'.
+void operatorState(
+    const ExecutorSnapshot& executor,
+    SlaveOperatorState::Executor* state)
+{
+  state->mutable_info()->CopyFrom(executor.info);
+  state->mutable_container_id()->CopyFrom(executor.containerId);
+  state->set_directory(executor.directory);
+  state->mutable_resources()->CopyFrom(executor.resources);
+
+  foreach (const Task& task, executor.tasks) {
+    state->add_tasks()->CopyFrom(task);
+  }
+
+  foreach (const TaskInfo& task, executor.queuedTasks) {
+    state->add_queued_tasks()->CopyFrom(task);
+  }
+
+  foreach (const Task& task, executor.completedTasks) {
+    state->add_completed_tasks()->CopyFrom(task);
+  }
+}
+
+
+void operatorState(
+    const FrameworkSnapshot& framework,
+    SlaveOperatorState::Framework* state)
+{
+  state->mutable_info()->CopyFrom(framework.info);
+
+  foreach (const ExecutorSnapshot& executor, framework.executors) {
+    operatorState(executor, state->add_executors());
+  }
+
+  foreach (const ExecutorSnapshot& executor, framework.completedExecutors) {
+    operatorState(executor, state->add_completed_executors());
+  }
+}
+
+
+SlaveOperatorState operatorState(const SlaveSnapshot& slave)
+{
+  SlaveOperatorState state;
+  state.set_version(MESOS_VERSION);
+  state.set_start_time(slave.startTime);
+  state.mutable_info()->CopyFrom(slave.info);
+  state.set_pid(slave.pid);
+
+  if (slave.master.isSome()) {
+    Try<string> hostname = net::getHostname(slave.master.get());
+    if (hostname.isSome()) {
+      state.set_master_hostname(hostname.get());
+    }
+  }
+
+  if (slave.logDir.isSome()) {
+    state.set_log_dir(slave.logDir.get());
+  }
+
+  if (slave.externalLogFile.isSome()) {
+    state.set_external_log_file(slave.externalLogFile.get());
+  }
+
+  foreach (const auto& flag, slave.flags) {
+    Parameter* parameter = state.add_flags();
+    parameter->set_key(flag.first);
+    parameter->set_value(flag.second);
+  }
+
+  foreach (const FrameworkSnapshot& framework, slave.frameworks) {
+    operatorState(framework, state.add_frameworks());
+  }
+
+  foreach (const FrameworkSnapshot& framework, slave.completedFrameworks) {
+    operatorState(framework, state.add_completed_frameworks());
+  }
+
+  return state;
+}
+
+
+// A stream buffer that writes what is written to it to a pipe, in
+// chunks of up to 'CHUNK_SIZE'. Once the reader has closed the pipe,
+// the writes fail, which stops the stream from writing any more.
+class PipeStreamBuffer : public std::streambuf
+{
+public:
+  explicit PipeStreamBuffer(const Pipe::Writer& _writer)
+    : writer(_writer), closed(false) {}
+
+  virtual ~PipeStreamBuffer()
+  {
+    flush();
+  }
+
+protected:
+  virtual int_type overflow(int_type c)
+  {
+    if (closed) {
+      return traits_type::eof();
+    }
+
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      buffer.push_back(traits_type::to_char_type(c));
+
+      if (buffer.size() >= CHUNK_SIZE) {
+        flush();
+      }
+    }
+
+    return closed ? traits_type::eof() : traits_type::not_eof(c);
+  }
+
+  virtual std::streamsize xsputn(const char* s, std::streamsize n)
+  {
+    if (closed) {
+      return 0;
+    }
+
+    buffer.append(s, n);
+
+    if (buffer.size() >= CHUNK_SIZE) {
+      flush();
+    }
+
+    return closed ? 0 : n;
+  }
+
+  virtual int sync()
+  {
+    flush();
+    return closed ? -1 : 0;
+  }
+
+private:
+  static const size_t CHUNK_SIZE = 64 * 1024;
+
+  void flush()
+  {
+    if (!buffer.empty() && !closed) {
+      closed = !writer.write(buffer);
+      buffer.clear();
+    }
+  }
+
+  Pipe::Writer writer;
+  bool closed;
+  string buffer;
+};
+
+
 void Slave::Http::log(const Request& request)
 {
   Option<string> userAgent = request.headers.get("User-Agent");
@@ -236,13 +626,8 @@ Future<Response> Slave::Http::executor(const Request& request) const
       return BadRequest("Failed to parse body into Call protobuf");
     }
   } else if (contentType.get() == APPLICATION_JSON) {
-    Try<JSON::Value> value = JSON::parse(request.body);
-    if (value.isError()) {
-      return BadRequest("Failed to parse body into JSON: " + value.error());
-    }
-
     Try<v1::executor::Call> parse =
-      ::protobuf::parse<v1::executor::Call>(value.get());
+      ::protobuf::parse<v1::executor::Call>(request.body);
 
     if (parse.isError()) {
       return BadRequest("Failed to convert JSON into Call protobuf: " +
@@ -301,7 +686,7 @@ Future<Response> Slave::Http::executor(const Request& request) const
 
   switch (call.type()) {
     case executor::Call::SUBSCRIBE: {
-      Pipe pipe;
+      Pipe pipe(slave->flags.max_http_executor_buffer_size);
       OK ok;
       ok.headers["Content-Type"] = stringify(responseContentType);
 
@@ -343,6 +728,63 @@ Future<Response> Slave::Http::executor(const Request& request) const
 }
 
 
+string Slave::Http::CONTAINERS_HELP()
+{
+  return HELP(
+    TLDR(
+        "Traces the launch of the containers of the executors."),
+    DESCRIPTION(
+        "Returns a JSON array with an object for each executor running",
+        "on the agent, with the times at which the containerizer was",
+        "asked to launch its container, the container was launched, the",
+        "executor registered and its first task was running, in seconds",
+        "since the epoch. The times of the phases not reached yet are",
+        "not included.",
+        "",
+        "Query parameters:",
+        "",
+        ">        jsonp=VALUE          The name of a JSONP callback."));
+}
+
+
+Future<Response> Slave::Http::containers(const Request& request) const
+{
+  JSON::Array array;
+
+  foreachvalue (Framework* framework, slave->frameworks) {
+    foreachvalue (Executor* executor, framework->executors) {
+      JSON::Object trace;
+
+      const Executor::Trace& trace_ = executor->trace;
+      if (trace_.launching.isSome()) {
+        trace.values["launching"] = trace_.launching->secs();
+      }
+      if (trace_.launched.isSome()) {
+        trace.values["launched"] = trace_.launched->secs();
+      }
+      if (trace_.registered.isSome()) {
+        trace.values["registered"] = trace_.registered->secs();
+      }
+      if (trace_.running.isSome()) {
+        trace.values["running"] = trace_.running->secs();
+      }
+
+      JSON::Object object;
+      object.values["framework_id"] = framework->id().value();
+      object.values["executor_id"] = executor->id.value();
+      object.values["executor_name"] = executor->info.name();
+      object.values["source"] = executor->info.source();
+      object.values["container_id"] = executor->containerId.value();
+      object.values["trace"] = std::move(trace);
+
+      array.values.push_back(std::move(object));
+    }
+  }
+
+  return OK(array, request.url.query.get("jsonp"));
+}
+
+
 string Slave::Http::FLAGS_HELP()
 {
   return HELP(TLDR("Exposes the agent's flag configuration."));
@@ -385,80 +827,330 @@ Future<Response> Slave::Http::health(const Request& request) const
 }
 
 
-string Slave::Http::STATE_HELP() {
+string Slave::Http::IMAGES_HELP()
+{
   return HELP(
     TLDR(
-        "Information about state of the Slave."),
+        "Pulls images ahead of the tasks that use them."),
     DESCRIPTION(
-        "This endpoint shows information about the frameworks, executors",
-        "and the slave's master as a JSON object."));
+        "GET returns 200 OK and a JSON object with the \"pulls\" of the",
+        "images requested so far, each with its \"image\", its \"state\",",
+        "one of PENDING, PULLING, READY or FAILED, the \"timestamp\" of",
+        "the last change of the state, in seconds since the epoch, and a",
+        "\"message\" if the pull failed.",
+        "",
+        "POST queues the pulls of the images of an \"images\" value with",
+        "a JSON array of Image objects, and returns the same as GET. The",
+        "images are pulled into the stores of the containerizer, at most",
+        "--image_prefetch_max_concurrent_pulls of them at the same time.",
+        "The images that are ready or failed are pulled again.",
+        "",
+        "Query parameters:",
+        "",
+        ">        jsonp=VALUE          The name of a JSONP callback."));
 }
 
 
-Future<Response> Slave::Http::state(const Request& request) const
+Future<Response> Slave::Http::images(const Request& request) const
 {
-  JSON::Object object;
-  object.values["version"] = MESOS_VERSION;
+  if (request.method == "POST") {
+    Try<hashmap<string, string>> decode =
+      process::http::query::decode(request.body);
 
-  if (build::GIT_SHA.isSome()) {
-    object.values["git_sha"] = build::GIT_SHA.get();
+    if (decode.isError()) {
+      return BadRequest("Unable to decode query string: " + decode.error());
+    }
+
+    const Option<string> json = decode.get().get("images");
+    if (json.isNone()) {
+      return BadRequest("Missing 'images' query parameter");
+    }
+
+    Try<JSON::Array> parse = JSON::parse<JSON::Array>(json.get());
+    if (parse.isError()) {
+      return BadRequest(
+          "Error in parsing 'images' query parameter: " + parse.error());
+    }
+
+    vector<Image> images;
+    foreach (const JSON::Value& value, parse.get().values) {
+      if (!value.is<JSON::Object>()) {
+        return BadRequest("Expecting objects in 'images' query parameter");
+      }
+
+      Try<Image> image = ::protobuf::parse<Image>(value);
+      if (image.isError()) {
+        return BadRequest(
+            "Error in parsing 'images' query parameter: " + image.error());
+      }
+
+      images.push_back(image.get());
+    }
+
+    slave->prefetch(images);
+  } else if (request.method != "GET") {
+    return MethodNotAllowed(
+        "Expecting a 'GET' or 'POST' request, received '" +
+        request.method + "'");
   }
 
-  if (build::GIT_BRANCH.isSome()) {
-    object.values["git_branch"] = build::GIT_BRANCH.get();
+  JSON::Array pulls;
+  foreach (const ImagePull& pull, slave->imagePulls.values()) {
+    pulls.values.push_back(JSON::protobuf(pull));
   }
 
-  if (build::GIT_TAG.isSome()) {
-    object.values["git_tag"] = build::GIT_TAG.get();
+  JSON::Object object;
+  object.values["pulls"] = std::move(pulls);
+
+  return OK(object, request.url.query.get("jsonp"));
+}
+
+
+string Slave::Http::MEMORY_HELP()
+{
+  return HELP(
+    TLDR(
+        "Reports the approximate memory used by the slave."),
+    DESCRIPTION(
+        "Returns 200 OK and a JSON object with the \"count\" and",
+        "approximate \"bytes\" of the frameworks, executors, tasks and",
+        "image pulls that the slave keeps in memory. The bytes of an",
+        "object include the protobuf messages that it keeps (measured",
+        "with 'SpaceUsed()'), but not the overhead of the maps which",
+        "index it.",
+        "",
+        "The \"http_connections\" bytes are the events buffered for the",
+        "HTTP executors. The object also has the numbers of events in the",
+        "\"event_queue\" of the slave, and the \"malloc\" statistics of",
+        "the memory allocator, if available. The entries of the fetcher",
+        "cache are reported by the 'containerizer/fetcher/cache_entries'",
+        "metric.",
+        "",
+        "Query parameters:",
+        "",
+        ">        jsonp=VALUE          The name of a JSONP callback."));
+}
+
+
+Future<Response> Slave::Http::memory(const Request& request) const
+{
+  MemoryUsage executors;
+  MemoryUsage completedExecutors;
+  MemoryUsage queuedTasks;
+  MemoryUsage tasks;
+  MemoryUsage completedTasks;
+  MemoryUsage httpConnections;
+
+  auto addExecutor = [&](const Executor& executor, MemoryUsage* usage) {
+    usage->add(executor.info, sizeof(Executor));
+
+    foreach (const TaskInfo& task, executor.queuedTasks.values()) {
+      queuedTasks.add(task);
+    }
+
+    foreach (const Task* task, executor.launchedTasks.values()) {
+      tasks.add(*task);
+    }
+
+    foreach (const Task* task, executor.terminatedTasks.values()) {
+      tasks.add(*task);
+    }
+
+    foreach (const std::shared_ptr<Task>& task, executor.completedTasks) {
+      completedTasks.add(*task);
+    }
+
+    if (executor.http.isSome()) {
+      httpConnections.add(executor.http.get().writer.buffered());
+    }
+  };
+
+  MemoryUsage frameworks;
+  MemoryUsage pendingTasks;
+
+  foreachvalue (const Framework* framework, slave->frameworks) {
+    frameworks.add(framework->info, sizeof(Framework));
+
+    foreachvalue (const auto& pending, framework->pending) {
+      foreachvalue (const TaskInfo& task, pending) {
+        pendingTasks.add(task);
+      }
+    }
+
+    foreachvalue (const Executor* executor, framework->executors) {
+      addExecutor(*executor, &executors);
+    }
+
+    foreach (const Owned<Executor>& executor, framework->completedExecutors) {
+      addExecutor(*executor, &completedExecutors);
+    }
   }
 
-  object.values["build_date"] = build::DATE;
-  object.values["build_time"] = build::TIME;
-  object.values["build_user"] = build::USER;
-  object.values["start_time"] = slave->startTime.secs();
-  object.values["id"] = slave->info.id().value();
-  object.values["pid"] = string(slave->self());
-  object.values["hostname"] = slave->info.hostname();
-  object.values["resources"] = model(slave->info.resources());
-  object.values["attributes"] = model(slave->info.attributes());
+  MemoryUsage completedFrameworks;
 
-  if (slave->master.isSome()) {
-    Try<string> hostname = net::getHostname(slave->master.get().address.ip);
-    if (hostname.isSome()) {
-      object.values["master_hostname"] = hostname.get();
+  foreach (const Owned<Framework>& framework, slave->completedFrameworks) {
+    completedFrameworks.add(framework->info, sizeof(Framework));
+
+    foreach (const Owned<Executor>& executor, framework->completedExecutors) {
+      addExecutor(*executor, &completedExecutors);
     }
   }
 
-  if (slave->flags.log_dir.isSome()) {
-    object.values["log_dir"] = slave->flags.log_dir.get();
+  MemoryUsage imagePulls;
+  foreach (const ImagePull& pull, slave->imagePulls.values()) {
+    imagePulls.add(pull);
   }
 
-  if (slave->flags.external_log_file.isSome()) {
-    object.values["external_log_file"] = slave->flags.external_log_file.get();
+  JSON::Object eventQueue;
+  eventQueue.values["messages"] =
+    slave->eventCount<process::MessageEvent>();
+  eventQueue.values["dispatches"] =
+    slave->eventCount<process::DispatchEvent>();
+  eventQueue.values["http_requests"] =
+    slave->eventCount<process::HttpEvent>();
+
+  JSON::Object object;
+  object.values["frameworks"] = model(frameworks);
+  object.values["completed_frameworks"] = model(completedFrameworks);
+  object.values["executors"] = model(executors);
+  object.values["completed_executors"] = model(completedExecutors);
+  object.values["pending_tasks"] = model(pendingTasks);
+  object.values["queued_tasks"] = model(queuedTasks);
+  object.values["tasks"] = model(tasks);
+  object.values["completed_tasks"] = model(completedTasks);
+  object.values["image_pulls"] = model(imagePulls);
+  object.values["http_connections"] = model(httpConnections);
+  object.values["event_queue"] = std::move(eventQueue);
+  object.values["malloc"] = mallocStatistics();
+
+  return OK(object, request.url.query.get("jsonp"));
+}
+
+
+string Slave::Http::STATE_HELP() {
+  return HELP(
+    TLDR(
+        "Information about state of the Slave."),
+    DESCRIPTION(
+        "This endpoint shows information about the frameworks, executors",
+        "and the slave's master as a JSON object.",
+        "",
+        "Requests that accept 'application/x-protobuf' get a serialized",
+        "SlaveOperatorState message instead.",
+        "",
+        "Query parameters:",
+        "",
+        ">        framework_id=VALUE   Only shows the framework with this id.",
+        ">        executor_id=VALUE    Only shows the executors with this id.",
+        ">        completed=(true|false)",
+        ">                             Whether to show completed frameworks,",
+        ">                             executors and tasks, defaults to true.",
+        ">        jsonp=VALUE          The name of a JSONP callback."));
+}
+
+
+Future<Response> Slave::Http::state(const Request& request) const
+{
+  const Option<string> frameworkId = request.url.query.get("framework_id");
+  const Option<string> executorId = request.url.query.get("executor_id");
+
+  bool completed = true;
+
+  Option<string> completed_ = request.url.query.get("completed");
+  if (completed_.isSome()) {
+    if (completed_.get() != "true" && completed_.get() != "false") {
+      return BadRequest(
+          "Invalid value '" + completed_.get() + "' for 'completed', "
+          "expecting 'true' or 'false'");
+    }
+
+    completed = completed_.get() == "true";
   }
 
-  JSON::Array frameworks;
+  // We only copy the state here, and render it outside of the slave
+  // since that takes the most time for a slave with many executors.
+  // See the comment in the master's 'state' on why this is not
+  // modeled as a JSON::Object.
+  std::shared_ptr<SlaveSnapshot> snapshot(new SlaveSnapshot());
+
+  snapshot->startTime = slave->startTime.secs();
+  snapshot->info = slave->info;
+  snapshot->pid = string(slave->self());
+
+  if (slave->master.isSome()) {
+    snapshot->master = slave->master.get().address.ip;
+  }
+
+  snapshot->logDir = slave->flags.log_dir;
+  snapshot->externalLogFile = slave->flags.external_log_file;
+
   foreachvalue (Framework* framework, slave->frameworks) {
-    frameworks.values.push_back(model(*framework));
+    if (frameworkId.isNone() || framework->id().value() == frameworkId.get()) {
+      snapshot->frameworks.push_back(
+          FrameworkSnapshot(*framework, executorId, completed));
+    }
   }
-  object.values["frameworks"] = frameworks;
 
-  JSON::Array completedFrameworks;
-  foreach (const Owned<Framework>& framework, slave->completedFrameworks) {
-    completedFrameworks.values.push_back(model(*framework));
+  if (completed) {
+    foreach (const Owned<Framework>& framework, slave->completedFrameworks) {
+      if (frameworkId.isNone() ||
+          framework->id().value() == frameworkId.get()) {
+        snapshot->completedFrameworks.push_back(
+            FrameworkSnapshot(*framework, executorId, true));
+      }
+    }
   }
-  object.values["completed_frameworks"] = completedFrameworks;
 
-  JSON::Object flags;
   foreachpair (const string& name, const flags::Flag& flag, slave->flags) {
     Option<string> value = flag.stringify(slave->flags);
     if (value.isSome()) {
-      flags.values[name] = value.get();
+      snapshot->flags.push_back(std::make_pair(name, value.get()));
     }
   }
-  object.values["flags"] = flags;
 
-  return OK(object, request.url.query.get("jsonp"));
+  const Option<string> jsonp = request.url.query.get("jsonp");
+
+  const bool serializeProtobuf = acceptsProtobuf(request);
+
+  Pipe pipe;
+
+  OK ok;
+  ok.type = Response::PIPE;
+  ok.reader = pipe.reader();
+
+  if (serializeProtobuf) {
+    ok.headers["Content-Type"] = APPLICATION_PROTOBUF;
+  } else {
+    ok.headers["Content-Type"] =
+      jsonp.isSome() ? "text/javascript" : "application/json";
+  }
+
+  Pipe::Writer writer = pipe.writer();
+
+  // The state is streamed to the client as it is rendered.
+  async([snapshot, writer, jsonp, serializeProtobuf]() {
+    if (serializeProtobuf) {
+      Pipe::Writer(writer).write(operatorState(*snapshot).SerializeAsString());
+    } else {
+      PipeStreamBuffer buffer(writer);
+      std::ostream stream(&buffer);
+
+      if (jsonp.isSome()) {
+        stream << jsonp.get() << "(";
+      }
+
+      stream << jsonify(*snapshot);
+
+      if (jsonp.isSome()) {
+        stream << ");";
+      }
+    }
+
+    // 'async' only calls const functions, so we close a copy.
+    Pipe::Writer(writer).close();
+  });
+
+  return ok;
 }
 
 } // namespace slave {
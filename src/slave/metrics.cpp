@@ -86,7 +86,16 @@ Metrics::Metrics(const Slave& slave)
         "slave/executor_directory_max_allowed_age_secs",
         defer(slave, &Slave::_executor_directory_max_allowed_age_secs)),
     container_launch_errors(
-        "slave/container_launch_errors")
+        "slave/container_launch_errors"),
+    container_launch(
+        "slave/container_launch",
+        Hours(1)),
+    executor_registration(
+        "slave/executor_registration",
+        Hours(1)),
+    task_running(
+        "slave/task_running",
+        Hours(1))
 {
   // TODO(dhamon): Check return values for metric registration.
   process::metrics::add(uptime_secs);
@@ -120,6 +129,10 @@ Metrics::Metrics(const Slave& slave)
 
   process::metrics::add(container_launch_errors);
 
+  process::metrics::add(container_launch);
+  process::metrics::add(executor_registration);
+  process::metrics::add(task_running);
+
   // Create resource gauges.
   // TODO(dhamon): Set these up dynamically when creating a slave
   // based on the resources it exposes.
@@ -205,6 +218,10 @@ Metrics::~Metrics()
 
   process::metrics::remove(container_launch_errors);
 
+  process::metrics::remove(container_launch);
+  process::metrics::remove(executor_registration);
+  process::metrics::remove(task_running);
+
   foreach (const Gauge& gauge, resources_total) {
     process::metrics::remove(gauge);
   }
@@ -21,6 +21,9 @@
 
 #include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
+#include <process/metrics/timer.hpp>
+
+#include <stout/duration.hpp>
 
 
 namespace mesos {
@@ -66,6 +69,14 @@ struct Metrics
 
   process::metrics::Counter container_launch_errors;
 
+  // The time the containerizer takes to launch the container of an
+  // executor, the time the launched executor takes to register, and
+  // the time from the launch to the first task of the executor
+  // running.
+  process::metrics::Timer<Milliseconds> container_launch;
+  process::metrics::Timer<Milliseconds> executor_registration;
+  process::metrics::Timer<Milliseconds> task_running;
+
   // Non-revocable resources.
   std::vector<process::metrics::Gauge> resources_total;
   std::vector<process::metrics::Gauge> resources_used;
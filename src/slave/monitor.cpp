@@ -18,18 +18,29 @@
 
 #include <glog/logging.h>
 
+#include <mesos/type_utils.hpp>
+
 #include <process/collect.hpp>
 #include <process/defer.hpp>
+#include <process/delay.hpp>
+#include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/help.hpp>
 #include <process/http.hpp>
 #include <process/limiter.hpp>
 #include <process/process.hpp>
+#include <process/timeseries.hpp>
 
+#include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
 #include <stout/json.hpp>
 #include <stout/lambda.hpp>
 #include <stout/protobuf.hpp>
+#include <stout/stringify.hpp>
+
+#include "common/http.hpp"
 
+#include "slave/constants.hpp"
 #include "slave/monitor.hpp"
 
 using namespace process;
@@ -73,21 +84,150 @@ static const string STATISTICS_HELP()
           "        \"timestamp\":1388534400.0",
           "    }",
           "}]",
+          "```",
+          "",
+          "If the slave samples the usage, see '--usage_sampling_interval',",
+          "the entries are those of the latest sample and also have the",
+          "\"rates\" of the usage since the previous sample, e.g.,",
+          "",
+          "```",
+          "    \"rates\":",
+          "    {",
+          "        \"cpus_usage\":1.5,",
+          "        \"net_rx_bytes_per_second\":1024.0,",
+          "        \"net_tx_bytes_per_second\":512.0",
+          "    }",
+          "```",
+          "",
+          "Requests that accept 'application/x-protobuf' get a serialized",
+          "ResourceUsage message of the executors with statistics instead,",
+          "without the rates."));
+}
+
+
+static const string HISTORY_HELP()
+{
+  return HELP(
+      TLDR(
+          "Retrieve the recent history of resource monitoring information."),
+      DESCRIPTION(
+          "Returns the resource consumption data for containers running",
+          "under this slave, as sampled over the last " +
+            stringify(USAGE_HISTORY_WINDOW) + ", oldest first.",
+          "Older samples are downsampled. The history is empty unless the",
+          "slave samples the usage, see '--usage_sampling_interval'.",
+          "",
+          "Example:",
+          "",
+          "```",
+          "{",
+          "  \"executors\":[{",
+          "      \"container_id\":{\"value\":\"container\"},",
+          "      \"executor_info\":{...},",
+          "      \"statistics\":[{",
+          "          \"cpus_system_time_secs\":34501.45,",
+          "          \"cpus_user_time_secs\":96348.84,",
+          "          \"mem_rss_bytes\":5105614848,",
+          "          \"timestamp\":1388534400.0",
+          "      }, ...]",
+          "  }]",
+          "}",
           "```"));
 }
 
 
+// Returns the rates of the usage between the two snapshots of the
+// statistics of a container.
+static JSON::Object rates(
+    const ResourceStatistics& previous,
+    const ResourceStatistics& current)
+{
+  JSON::Object result;
+
+  const double seconds = current.timestamp() - previous.timestamp();
+  if (seconds <= 0) {
+    return result;
+  }
+
+  if (previous.has_cpus_user_time_secs() &&
+      previous.has_cpus_system_time_secs() &&
+      current.has_cpus_user_time_secs() &&
+      current.has_cpus_system_time_secs()) {
+    result.values["cpus_usage"] =
+      (current.cpus_user_time_secs() - previous.cpus_user_time_secs() +
+       current.cpus_system_time_secs() - previous.cpus_system_time_secs()) /
+      seconds;
+  }
+
+  if (previous.has_net_rx_bytes() && current.has_net_rx_bytes()) {
+    result.values["net_rx_bytes_per_second"] =
+      (static_cast<double>(current.net_rx_bytes()) -
+       static_cast<double>(previous.net_rx_bytes())) / seconds;
+  }
+
+  if (previous.has_net_tx_bytes() && current.has_net_tx_bytes()) {
+    result.values["net_tx_bytes_per_second"] =
+      (static_cast<double>(current.net_tx_bytes()) -
+       static_cast<double>(previous.net_tx_bytes())) / seconds;
+  }
+
+  return result;
+}
+
+
 class ResourceMonitorProcess : public Process<ResourceMonitorProcess>
 {
 public:
-  explicit ResourceMonitorProcess(
-      const lambda::function<Future<ResourceUsage>()>& _usage)
+  ResourceMonitorProcess(
+      const lambda::function<Future<ResourceUsage>()>& _collect,
+      const Option<Duration>& _interval)
     : ProcessBase("monitor"),
-      usage(_usage),
+      collect(_collect),
+      interval(_interval),
       limiter(2, Seconds(1)) {} // 2 permits per second.
 
   virtual ~ResourceMonitorProcess() {}
 
+  Future<ResourceUsage> usage()
+  {
+    if (interval.isNone()) {
+      return collect();
+    }
+
+    if (latest.isSome()) {
+      return latest.get();
+    }
+
+    // The sampling starts with the first read, rather than once the
+    // monitor is spawned, since the callback might not be able to
+    // collect the usage until then, e.g., if the slave is not spawned.
+    if (sampling.isNone()) {
+      sample();
+    }
+
+    return sampling.get();
+  }
+
+  ResourceUsageHistory history()
+  {
+    ResourceUsageHistory result;
+
+    foreachpair (const ContainerID& containerId,
+                 const History& history,
+                 histories) {
+      ResourceUsageHistory::Executor* executor = result.add_executors();
+      executor->mutable_executor_info()->CopyFrom(history.info);
+      executor->mutable_container_id()->CopyFrom(containerId);
+
+      foreach (const TimeSeries<ResourceStatistics>::Value& value,
+               history.statistics.get()) {
+        executor->add_statistics()->CopyFrom(value.data);
+      }
+    }
+
+    return result;
+  }
+
 protected:
   virtual void initialize()
   {
@@ -100,9 +240,93 @@ protected:
     route("/statistics",
           STATISTICS_HELP(),
           &ResourceMonitorProcess::statistics);
+
+    route("/history",
+          HISTORY_HELP(),
+          &ResourceMonitorProcess::_history);
   }
 
 private:
+  void sample()
+  {
+    sampling = collect();
+    sampling.get()
+      .onAny(defer(self(), &Self::_sample, lambda::_1));
+  }
+
+  void _sample(const Future<ResourceUsage>& future)
+  {
+    if (future.isReady()) {
+      // Only the rates of the containers that are in both samples can
+      // be computed.
+      hashmap<ContainerID, ResourceStatistics> previous;
+
+      if (latest.isSome()) {
+        foreach (const ResourceUsage::Executor& executor,
+                 latest.get().executors()) {
+          if (executor.has_container_id() && executor.has_statistics()) {
+            previous[executor.container_id()] = executor.statistics();
+          }
+        }
+      }
+
+      latest = future.get();
+      latestRates.clear();
+
+      hashset<ContainerID> sampled;
+
+      foreach (const ResourceUsage::Executor& executor,
+               latest.get().executors()) {
+        if (!executor.has_container_id() || !executor.has_statistics()) {
+          continue;
+        }
+
+        const ContainerID& containerId = executor.container_id();
+
+        if (previous.contains(containerId)) {
+          latestRates[containerId] =
+            rates(previous[containerId], executor.statistics());
+        }
+
+        if (!histories.contains(containerId)) {
+          histories.put(containerId, History(executor.executor_info()));
+        }
+
+        // We leave out the detailed statistics, i.e., those of perf
+        // and traffic control, to bound the size of the history.
+        ResourceStatistics statistics = executor.statistics();
+        statistics.clear_perf();
+        statistics.clear_net_traffic_control_statistics();
+
+        histories.at(containerId).statistics.set(statistics);
+
+        sampled.insert(containerId);
+      }
+
+      // The histories of the containers that are gone are dropped.
+      foreach (const ContainerID& containerId, histories.keys()) {
+        if (!sampled.contains(containerId)) {
+          histories.erase(containerId);
+        }
+      }
+    } else {
+      LOG(WARNING) << "Failed to sample resource usage: "
+                   << (future.isFailed() ? future.failure() : "discarded");
+    }
+
+    CHECK_SOME(interval);
+    delay(interval.get(), self(), &Self::sample);
+  }
+
+  // Returns the history of the monitoring statistics. Requests have
+  // no parameters.
+  Future<http::Response> _history(const http::Request& request)
+  {
+    return http::OK(
+        JSON::protobuf(history()),
+        request.url.query.get("jsonp"));
+  }
+
   // Returns the monitoring statistics. Requests have no parameters.
   Future<http::Response> statistics(const http::Request& request)
   {
@@ -127,6 +351,19 @@ private:
       return http::InternalServerError();
     }
 
+    if (acceptsProtobuf(request)) {
+      ResourceUsage usage;
+
+      foreach (const ResourceUsage::Executor& executor,
+               future.get().executors()) {
+        if (executor.has_statistics()) {
+          usage.add_executors()->CopyFrom(executor);
+        }
+      }
+
+      return protobufResponse(usage);
+    }
+
     JSON::Array result;
 
     foreach (const ResourceUsage::Executor& executor,
@@ -141,6 +378,11 @@ private:
         entry.values["source"] = info.source();
         entry.values["statistics"] = JSON::protobuf(executor.statistics());
 
+        if (executor.has_container_id() &&
+            latestRates.contains(executor.container_id())) {
+          entry.values["rates"] = latestRates[executor.container_id()];
+        }
+
         result.values.push_back(entry);
       }
     }
@@ -149,7 +391,29 @@ private:
   }
 
   // Callback used to retrieve resource usage information from slave.
-  const lambda::function<Future<ResourceUsage>()> usage;
+  const lambda::function<Future<ResourceUsage>()> collect;
+
+  const Option<Duration> interval;
+
+  // The sample being collected, and the latest sample with the rates
+  // of the usage of its containers since the previous one.
+  Option<Future<ResourceUsage>> sampling;
+  Option<ResourceUsage> latest;
+  hashmap<ContainerID, JSON::Object> latestRates;
+
+  struct History
+  {
+    explicit History(const ExecutorInfo& _info)
+      : info(_info),
+        statistics(USAGE_HISTORY_WINDOW, USAGE_HISTORY_CAPACITY) {}
+
+    ExecutorInfo info;
+    TimeSeries<ResourceStatistics> statistics;
+  };
+
+  // The recent history of the statistics of the containers in the
+  // latest sample.
+  hashmap<ContainerID, History> histories;
 
   // Used to rate limit the statistics endpoint.
   RateLimiter limiter;
@@ -157,8 +421,9 @@ private:
 
 
 ResourceMonitor::ResourceMonitor(
-    const lambda::function<Future<ResourceUsage>()>& usage)
-  : process(new ResourceMonitorProcess(usage))
+    const lambda::function<Future<ResourceUsage>()>& usage,
+    const Option<Duration>& interval)
+  : process(new ResourceMonitorProcess(usage, interval))
 {
   spawn(process.get());
 }
@@ -170,6 +435,18 @@ ResourceMonitor::~ResourceMonitor()
   wait(process.get());
 }
 
+
+Future<ResourceUsage> ResourceMonitor::usage()
+{
+  return dispatch(process.get(), &ResourceMonitorProcess::usage);
+}
+
+
+Future<ResourceUsageHistory> ResourceMonitor::history()
+{
+  return dispatch(process.get(), &ResourceMonitorProcess::history);
+}
+
 } // namespace slave {
 } // namespace internal {
 } // namespace mesos {
@@ -22,7 +22,10 @@
 #include <process/future.hpp>
 #include <process/owned.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/lambda.hpp>
+#include <stout/none.hpp>
+#include <stout/option.hpp>
 
 namespace mesos {
 namespace internal {
@@ -33,14 +36,29 @@ class ResourceMonitorProcess;
 
 
 // Exposes resources usage information via a JSON endpoint.
+//
+// If a sampling interval is given, the monitor samples the usage with
+// the callback in the background, once per interval after the first
+// read, and serves the latest sample to the endpoint and to 'usage()'
+// instead of collecting the usage for each of them.
 class ResourceMonitor
 {
 public:
   explicit ResourceMonitor(
-      const lambda::function<process::Future<ResourceUsage>()>& usage);
+      const lambda::function<process::Future<ResourceUsage>()>& usage,
+      const Option<Duration>& interval = None());
 
   ~ResourceMonitor();
 
+  // Returns the latest sample of the usage if sampling, or collects
+  // the usage otherwise.
+  process::Future<ResourceUsage> usage();
+
+  // Returns the history of the samples of the usage of the current
+  // containers over the last 'USAGE_HISTORY_WINDOW', which is empty
+  // if not sampling.
+  process::Future<ResourceUsageHistory> history();
+
 private:
   process::Owned<ResourceMonitorProcess> process;
 };
@@ -31,6 +31,7 @@
 #include <stout/os/rm.hpp>
 #include <stout/os/rmdir.hpp>
 #include <stout/try.hpp>
+#include <stout/unreachable.hpp>
 
 #include "messages/messages.hpp"
 
@@ -56,6 +57,7 @@ const char HTTP_MARKER_FILE[] = "http.marker";
 const char FORKED_PID_FILE[] = "forked.pid";
 const char TASK_INFO_FILE[] = "task.info";
 const char TASK_UPDATES_FILE[] = "task.updates";
+const char TASK_UPDATES_JOURNAL_FILE[] = "task.updates.journal";
 const char RESOURCES_INFO_FILE[] = "resources.info";
 
 
@@ -111,6 +113,14 @@ string getSlaveInfoPath(
 }
 
 
+string getTaskUpdatesJournalPath(
+    const string& rootDir,
+    const SlaveID& slaveId)
+{
+  return path::join(getSlavePath(rootDir, slaveId), TASK_UPDATES_JOURNAL_FILE);
+}
+
+
 Try<list<string>> getFrameworkPaths(
     const string& rootDir,
     const SlaveID& slaveId)
@@ -396,6 +406,34 @@ string getPersistentVolumePath(
 }
 
 
+string getPersistentVolumePath(
+    const string& rootDir,
+    const Resource& volume)
+{
+  CHECK(volume.has_disk());
+  CHECK(volume.disk().has_persistence());
+
+  const string& id = volume.disk().persistence().id();
+
+  if (!volume.disk().has_source()) {
+    return getPersistentVolumePath(rootDir, volume.role(), id);
+  }
+
+  const Resource::DiskInfo::Source& source = volume.disk().source();
+
+  switch (source.type()) {
+    case Resource::DiskInfo::Source::PATH:
+      CHECK(source.has_path());
+      return getPersistentVolumePath(source.path().root(), volume.role(), id);
+    case Resource::DiskInfo::Source::MOUNT:
+      CHECK(source.has_mount());
+      return source.mount().root();
+  }
+
+  UNREACHABLE();
+}
+
+
 string createExecutorDirectory(
     const string& rootDir,
     const SlaveID& slaveId,
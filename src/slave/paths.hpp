@@ -63,6 +63,7 @@ namespace paths {
 //   |       |-- latest (symlink)
 //   |       |-- <slave_id>
 //   |           |-- slave.info
+//   |           |-- task.updates.journal
 //   |           |-- frameworks
 //   |               |-- <framework_id>
 //   |                   |-- framework.info
@@ -80,7 +81,7 @@ namespace paths {
 //   |                                   |-- tasks
 //   |                                       |-- <task_id>
 //   |                                           |-- task.info
-//   |                                           |-- task.updates
+//   |                                           |-- task.updates (older slaves)
 //   |-- boot_id
 //   |-- resources
 //   |   |-- resources.info
@@ -122,6 +123,11 @@ std::string getSlavePath(
     const SlaveID& slaveId);
 
 
+std::string getTaskUpdatesJournalPath(
+    const std::string& rootDir,
+    const SlaveID& slaveId);
+
+
 Try<std::list<std::string>> getFrameworkPaths(
     const std::string& rootDir,
     const SlaveID& slaveId);
@@ -272,6 +278,14 @@ std::string getPersistentVolumePath(
     const std::string& persistenceId);
 
 
+// Returns the path of a persistent volume, which is in the root of
+// the source of its disk if any, and in 'rootDir' otherwise. A MOUNT
+// disk is a volume as a whole.
+std::string getPersistentVolumePath(
+    const std::string& rootDir,
+    const Resource& volume);
+
+
 std::string createExecutorDirectory(
     const std::string& rootDir,
     const SlaveID& slaveId,
@@ -0,0 +1,352 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <list>
+#include <string>
+
+#include <mesos/module/qos_controller.hpp>
+
+#include <mesos/slave/qos_controller.hpp>
+
+#include <process/defer.hpp>
+#include <process/dispatch.hpp>
+#include <process/owned.hpp>
+#include <process/process.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/lambda.hpp>
+#include <stout/numify.hpp>
+#include <stout/option.hpp>
+
+using namespace mesos;
+using namespace process;
+
+using mesos::modules::Module;
+
+using mesos::slave::QoSController;
+using mesos::slave::QoSCorrection;
+
+using std::list;
+using std::string;
+
+
+// The thresholds above which a non-revocable executor is considered
+// to suffer from interference.
+struct Thresholds
+{
+  // The ratio of the CFS periods in which the executor was throttled.
+  double throttledRatio;
+
+  // Whether medium or critical memory pressure events count.
+  bool memoryPressure;
+
+  // The cycles per instruction measured by the perf_event isolator.
+  Option<double> cpi;
+};
+
+
+// Kills the revocable executors while the non-revocable executors
+// suffer from interference: their cpus are throttled, their memory is
+// under pressure, or their cycles per instruction (CPI) are high. The
+// executors are compared between successive samples of their usage.
+//
+// Only one revocable executor is killed at a time, the one that uses
+// the most cpus if the cpus suffer, or the most memory otherwise. For
+// hysteresis, an executor is killed only after 'consecutive_samples'
+// successive samples with interference, and the count starts again
+// after every kill.
+class InterferenceQoSControllerProcess
+  : public Process<InterferenceQoSControllerProcess>
+{
+public:
+  InterferenceQoSControllerProcess(
+      const lambda::function<Future<ResourceUsage>()>& _usage,
+      const Thresholds& _thresholds,
+      size_t _consecutiveSamples)
+    : usage(_usage),
+      thresholds(_thresholds),
+      consecutiveSamples(_consecutiveSamples),
+      interferingSamples(0) {}
+
+  Future<list<QoSCorrection>> corrections()
+  {
+    return usage().then(defer(self(), &Self::_corrections, lambda::_1));
+  }
+
+  Future<list<QoSCorrection>> _corrections(const ResourceUsage& usage)
+  {
+    bool cpuInterference = false;
+    bool memoryInterference = false;
+
+    // The noisiest revocable executors, by cpu and by memory usage.
+    Option<ResourceUsage::Executor> cpuNoisiest;
+    Option<ResourceUsage::Executor> memNoisiest;
+    double maxCpus = 0;
+    double maxMem = 0;
+
+    hashmap<ContainerID, ResourceStatistics> _previous;
+
+    foreach (const ResourceUsage::Executor& executor, usage.executors()) {
+      if (!executor.has_statistics()) {
+        continue;
+      }
+
+      const ResourceStatistics& current = executor.statistics();
+      const Option<ResourceStatistics> last =
+        previous.get(executor.container_id());
+
+      _previous[executor.container_id()] = current;
+
+      // The first sample of an executor has nothing to compare to.
+      if (last.isNone() || current.timestamp() <= last.get().timestamp()) {
+        continue;
+      }
+
+      if (Resources(executor.allocated()).revocable().empty()) {
+        if (throttled(last.get(), current) || cpi(current)) {
+          cpuInterference = true;
+        }
+
+        if (pressure(last.get(), current)) {
+          memoryInterference = true;
+        }
+
+        continue;
+      }
+
+      const double cpus =
+        (cpusTime(current) - cpusTime(last.get())) /
+        (current.timestamp() - last.get().timestamp());
+
+      if (cpuNoisiest.isNone() || cpus > maxCpus) {
+        cpuNoisiest = executor;
+        maxCpus = cpus;
+      }
+
+      const double mem = current.has_mem_total_bytes()
+        ? current.mem_total_bytes()
+        : current.mem_rss_bytes();
+
+      if (memNoisiest.isNone() || mem > maxMem) {
+        memNoisiest = executor;
+        maxMem = mem;
+      }
+    }
+
+    previous = _previous;
+
+    if (!cpuInterference && !memoryInterference) {
+      interferingSamples = 0;
+      return list<QoSCorrection>();
+    }
+
+    interferingSamples++;
+
+    const Option<ResourceUsage::Executor> noisiest =
+      cpuInterference ? cpuNoisiest : memNoisiest;
+
+    if (interferingSamples < consecutiveSamples || noisiest.isNone()) {
+      return list<QoSCorrection>();
+    }
+
+    interferingSamples = 0;
+
+    const ExecutorInfo& executorInfo = noisiest.get().executor_info();
+
+    LOG(INFO) << "Killing revocable executor '" << executorInfo.executor_id()
+              << "' of framework " << executorInfo.framework_id()
+              << " because of " << (cpuInterference ? "cpu" : "memory")
+              << " interference with non-revocable executors";
+
+    QoSCorrection correction;
+    correction.set_type(QoSCorrection::KILL);
+    correction.mutable_kill()->mutable_framework_id()->CopyFrom(
+        executorInfo.framework_id());
+    correction.mutable_kill()->mutable_executor_id()->CopyFrom(
+        executorInfo.executor_id());
+    correction.mutable_kill()->mutable_container_id()->CopyFrom(
+        noisiest.get().container_id());
+
+    return list<QoSCorrection>({correction});
+  }
+
+private:
+  static double cpusTime(const ResourceStatistics& statistics)
+  {
+    return statistics.cpus_user_time_secs() +
+           statistics.cpus_system_time_secs();
+  }
+
+  bool throttled(
+      const ResourceStatistics& last,
+      const ResourceStatistics& current) const
+  {
+    if (current.cpus_nr_periods() <= last.cpus_nr_periods()) {
+      return false;
+    }
+
+    const double periods =
+      current.cpus_nr_periods() - last.cpus_nr_periods();
+    const double throttled =
+      current.cpus_nr_throttled() - last.cpus_nr_throttled();
+
+    return throttled / periods > thresholds.throttledRatio;
+  }
+
+  bool pressure(
+      const ResourceStatistics& last,
+      const ResourceStatistics& current) const
+  {
+    return thresholds.memoryPressure &&
+      (current.mem_medium_pressure_counter() >
+         last.mem_medium_pressure_counter() ||
+       current.mem_critical_pressure_counter() >
+         last.mem_critical_pressure_counter());
+  }
+
+  bool cpi(const ResourceStatistics& current) const
+  {
+    if (thresholds.cpi.isNone() ||
+        !current.has_perf() ||
+        current.perf().instructions() == 0) {
+      return false;
+    }
+
+    return (double) current.perf().cycles() / current.perf().instructions() >
+      thresholds.cpi.get();
+  }
+
+  const lambda::function<Future<ResourceUsage>()> usage;
+  const Thresholds thresholds;
+  const size_t consecutiveSamples;
+
+  // The previous statistics of each executor.
+  hashmap<ContainerID, ResourceStatistics> previous;
+
+  // The number of successive samples with interference since the
+  // last kill.
+  size_t interferingSamples;
+};
+
+
+class InterferenceQoSController : public QoSController
+{
+public:
+  InterferenceQoSController(
+      const Thresholds& _thresholds,
+      size_t _consecutiveSamples)
+    : thresholds(_thresholds),
+      consecutiveSamples(_consecutiveSamples) {}
+
+  virtual ~InterferenceQoSController()
+  {
+    if (process.get() != NULL) {
+      terminate(process.get());
+      wait(process.get());
+    }
+  }
+
+  virtual Try<Nothing> initialize(
+      const lambda::function<Future<ResourceUsage>()>& usage)
+  {
+    if (process.get() != NULL) {
+      return Error(
+          "Interference QoS Controller has already been initialized");
+    }
+
+    process.reset(new InterferenceQoSControllerProcess(
+        usage, thresholds, consecutiveSamples));
+    spawn(process.get());
+
+    return Nothing();
+  }
+
+  virtual Future<list<QoSCorrection>> corrections()
+  {
+    if (process.get() == NULL) {
+      return Failure("Interference QoS Controller is not initialized");
+    }
+
+    return dispatch(
+        process.get(),
+        &InterferenceQoSControllerProcess::corrections);
+  }
+
+private:
+  const Thresholds thresholds;
+  const size_t consecutiveSamples;
+  Owned<InterferenceQoSControllerProcess> process;
+};
+
+
+static bool compatible()
+{
+  return true;
+}
+
+
+static QoSController* create(const Parameters& parameters)
+{
+  Thresholds thresholds;
+  thresholds.throttledRatio = 0.25;
+  thresholds.memoryPressure = true;
+
+  size_t consecutiveSamples = 3;
+
+  foreach (const Parameter& parameter, parameters.parameter()) {
+    if (parameter.key() == "throttled_ratio") {
+      Try<double> value = numify<double>(parameter.value());
+      if (value.isError() || value.get() < 0 || value.get() > 1) {
+        return NULL;
+      }
+
+      thresholds.throttledRatio = value.get();
+    } else if (parameter.key() == "memory_pressure") {
+      if (parameter.value() != "true" && parameter.value() != "false") {
+        return NULL;
+      }
+
+      thresholds.memoryPressure = parameter.value() == "true";
+    } else if (parameter.key() == "cpi") {
+      Try<double> value = numify<double>(parameter.value());
+      if (value.isError() || value.get() <= 0) {
+        return NULL;
+      }
+
+      thresholds.cpi = value.get();
+    } else if (parameter.key() == "consecutive_samples") {
+      Try<size_t> value = numify<size_t>(parameter.value());
+      if (value.isError() || value.get() == 0) {
+        return NULL;
+      }
+
+      consecutiveSamples = value.get();
+    }
+  }
+
+  return new InterferenceQoSController(thresholds, consecutiveSamples);
+}
+
+
+Module<QoSController> org_apache_mesos_InterferenceQoSController(
+    MESOS_MODULE_API_VERSION,
+    MESOS_VERSION,
+    "Apache Mesos",
+    "modules@mesos.apache.org",
+    "Interference QoS Controller Module.",
+    compatible,
+    create);
@@ -0,0 +1,289 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+
+#include <mesos/module/resource_estimator.hpp>
+
+#include <mesos/slave/resource_estimator.hpp>
+
+#include <process/defer.hpp>
+#include <process/dispatch.hpp>
+#include <process/owned.hpp>
+#include <process/process.hpp>
+
+#include <stout/bytes.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/lambda.hpp>
+#include <stout/numify.hpp>
+#include <stout/option.hpp>
+#include <stout/stringify.hpp>
+
+using namespace mesos;
+using namespace process;
+
+using mesos::modules::Module;
+
+using mesos::slave::ResourceEstimator;
+
+
+// Estimates the slack of the allocations of the executors, i.e., the
+// part of their allocated cpus and memory that they do not use, from
+// successive samples of their usage. The slack is offered as revocable
+// resources, less the revocable resources that are already allocated.
+//
+// The usage of an executor is smoothed with an exponentially weighted
+// moving average, where 'smoothing' is the weight of the latest
+// sample, and a 'safety margin' fraction of the allocation of each
+// executor is never considered slack.
+class UsageResourceEstimatorProcess
+  : public Process<UsageResourceEstimatorProcess>
+{
+public:
+  UsageResourceEstimatorProcess(
+      const lambda::function<Future<ResourceUsage>()>& _usage,
+      double _safetyMargin,
+      double _smoothing)
+    : usage(_usage),
+      safetyMargin(_safetyMargin),
+      smoothing(_smoothing) {}
+
+  Future<Resources> oversubscribable()
+  {
+    return usage().then(defer(self(), &Self::_oversubscribable, lambda::_1));
+  }
+
+  Future<Resources> _oversubscribable(const ResourceUsage& usage)
+  {
+    Resources slack;
+    Resources allocatedRevocable;
+
+    // The samples of the executors that are still running.
+    hashmap<ContainerID, Sample> _samples;
+
+    foreach (const ResourceUsage::Executor& executor, usage.executors()) {
+      const Resources allocated = executor.allocated();
+      allocatedRevocable += allocated.revocable();
+
+      // An executor whose usage is unknown has no slack.
+      if (!executor.has_statistics()) {
+        continue;
+      }
+
+      const Sample sample =
+        update(samples.get(executor.container_id()), executor.statistics());
+
+      _samples[executor.container_id()] = sample;
+
+      const Resources nonRevocable = allocated.nonRevocable();
+
+      const Option<double> cpus = nonRevocable.cpus();
+      if (cpus.isSome() && sample.cpus.isSome()) {
+        const double free = cpus.get() * (1 - safetyMargin) - sample.cpus.get();
+
+        if (free > 0) {
+          slack += Resources::parse("cpus", stringify(free), "*").get();
+        }
+      }
+
+      const Option<Bytes> mem = nonRevocable.mem();
+      if (mem.isSome() && sample.mem.isSome()) {
+        const double free =
+          mem.get().megabytes() * (1 - safetyMargin) - sample.mem.get();
+
+        if (free > 0) {
+          slack += Resources::parse("mem", stringify(free), "*").get();
+        }
+      }
+    }
+
+    samples = _samples;
+
+    // Mark all resources as revocable.
+    foreach (Resource& resource, slack) {
+      resource.mutable_revocable();
+    }
+
+    return slack - allocatedRevocable;
+  }
+
+private:
+  // The smoothed usage of an executor, i.e., of its container.
+  struct Sample
+  {
+    Sample() : timestamp(0), cpusTime(0) {}
+
+    // The timestamp and the total cpu time of the latest statistics,
+    // from which the cpu usage rate of the next statistics is derived.
+    double timestamp;
+    double cpusTime;
+
+    // The smoothed cpus and memory, in megabytes, that the executor
+    // uses. The cpus are only known after two samples.
+    Option<double> cpus;
+    Option<double> mem;
+  };
+
+  Sample update(
+      const Option<Sample>& previous,
+      const ResourceStatistics& statistics) const
+  {
+    // The statistics have not been collected again since the last
+    // estimate, e.g., if the monitor caches them.
+    if (previous.isSome() &&
+        statistics.timestamp() <= previous.get().timestamp) {
+      return previous.get();
+    }
+
+    Sample sample;
+    sample.timestamp = statistics.timestamp();
+    sample.cpusTime =
+      statistics.cpus_user_time_secs() + statistics.cpus_system_time_secs();
+
+    if (previous.isSome() &&
+        (statistics.has_cpus_user_time_secs() ||
+         statistics.has_cpus_system_time_secs())) {
+      const double cpus = std::max(
+          0.0,
+          (sample.cpusTime - previous.get().cpusTime) /
+            (sample.timestamp - previous.get().timestamp));
+
+      sample.cpus = previous.get().cpus.isSome()
+        ? smoothing * cpus + (1 - smoothing) * previous.get().cpus.get()
+        : cpus;
+    }
+
+    Option<double> mem;
+    if (statistics.has_mem_total_bytes()) {
+      mem = Bytes(statistics.mem_total_bytes()).megabytes();
+    } else if (statistics.has_mem_rss_bytes()) {
+      mem = Bytes(statistics.mem_rss_bytes()).megabytes();
+    }
+
+    // Unlike with cpus, using more memory than the smoothed usage
+    // can not be throttled, so the memory usage is never estimated
+    // lower than the latest sample.
+    if (mem.isSome()) {
+      sample.mem = mem.get();
+
+      if (previous.isSome() && previous.get().mem.isSome()) {
+        sample.mem = std::max(
+            mem.get(),
+            smoothing * mem.get() + (1 - smoothing) * previous.get().mem.get());
+      }
+    }
+
+    return sample;
+  }
+
+  const lambda::function<Future<ResourceUsage>()> usage;
+  const double safetyMargin;
+  const double smoothing;
+
+  hashmap<ContainerID, Sample> samples;
+};
+
+
+class UsageResourceEstimator : public ResourceEstimator
+{
+public:
+  UsageResourceEstimator(double _safetyMargin, double _smoothing)
+    : safetyMargin(_safetyMargin),
+      smoothing(_smoothing) {}
+
+  virtual ~UsageResourceEstimator()
+  {
+    if (process.get() != NULL) {
+      terminate(process.get());
+      wait(process.get());
+    }
+  }
+
+  virtual Try<Nothing> initialize(
+      const lambda::function<Future<ResourceUsage>()>& usage)
+  {
+    if (process.get() != NULL) {
+      return Error("Usage resource estimator has already been initialized");
+    }
+
+    process.reset(
+        new UsageResourceEstimatorProcess(usage, safetyMargin, smoothing));
+    spawn(process.get());
+
+    return Nothing();
+  }
+
+  virtual Future<Resources> oversubscribable()
+  {
+    if (process.get() == NULL) {
+      return Failure("Usage resource estimator is not initialized");
+    }
+
+    return dispatch(
+        process.get(),
+        &UsageResourceEstimatorProcess::oversubscribable);
+  }
+
+private:
+  const double safetyMargin;
+  const double smoothing;
+  Owned<UsageResourceEstimatorProcess> process;
+};
+
+
+static bool compatible()
+{
+  // TODO(jieyu): Check compatibility.
+  return true;
+}
+
+
+static ResourceEstimator* create(const Parameters& parameters)
+{
+  double safetyMargin = 0.1;
+  double smoothing = 0.5;
+
+  foreach (const Parameter& parameter, parameters.parameter()) {
+    if (parameter.key() == "safety_margin") {
+      Try<double> value = numify<double>(parameter.value());
+      if (value.isError() || value.get() < 0 || value.get() >= 1) {
+        return NULL;
+      }
+
+      safetyMargin = value.get();
+    } else if (parameter.key() == "smoothing") {
+      Try<double> value = numify<double>(parameter.value());
+      if (value.isError() || value.get() <= 0 || value.get() > 1) {
+        return NULL;
+      }
+
+      smoothing = value.get();
+    }
+  }
+
+  return new UsageResourceEstimator(safetyMargin, smoothing);
+}
+
+
+Module<ResourceEstimator> org_apache_mesos_UsageResourceEstimator(
+    MESOS_MODULE_API_VERSION,
+    MESOS_VERSION,
+    "Apache Mesos",
+    "modules@mesos.apache.org",
+    "Usage Resource Estimator Module.",
+    compatible,
+    create);
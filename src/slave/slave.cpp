@@ -61,6 +61,7 @@
 #include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
+#include <stout/unreachable.hpp>
 #include <stout/uuid.hpp>
 #include <stout/utils.hpp>
 
@@ -134,7 +135,7 @@ Slave::Slave(const slave::Flags& _flags,
     files(_files),
     metrics(*this),
     gc(_gc),
-    monitor(defer(self(), &Self::usage)),
+    monitor(defer(self(), &Self::usage), flags.usage_sampling_interval),
     statusUpdateManager(_statusUpdateManager),
     masterPingTimeout(DEFAULT_MASTER_PING_TIMEOUT()),
     metaDir(paths::getMetaRootDir(flags.work_dir)),
@@ -146,7 +147,8 @@ Slave::Slave(const slave::Flags& _flags,
     reauthenticate(false),
     executorDirectoryMaxAllowedAge(age(0)),
     resourceEstimator(_resourceEstimator),
-    qosController(_qosController) {}
+    qosController(_qosController),
+    activeImagePulls(0) {}
 
 
 Slave::~Slave()
@@ -319,21 +321,28 @@ void Slave::initialize()
             << "' for --gc_disk_headroom. Must be between 0.0 and 1.0.";
   }
 
-  Try<Nothing> initialize =
-    resourceEstimator->initialize(defer(self(), &Self::usage));
+  // The resource estimator and the QoS controller read the usage
+  // through the monitor, which serves them its latest sample if the
+  // slave samples the usage.
+  const lambda::function<Future<ResourceUsage>()> readUsage =
+    [this]() { return monitor.usage(); };
+
+  Try<Nothing> initialize = resourceEstimator->initialize(readUsage);
 
   if (initialize.isError()) {
     EXIT(1) << "Failed to initialize the resource estimator: "
             << initialize.error();
   }
 
-  initialize = qosController->initialize(defer(self(), &Self::usage));
+  initialize = qosController->initialize(readUsage);
 
   if (initialize.isError()) {
     EXIT(1) << "Failed to initialize the QoS Controller: "
             << initialize.error();
   }
 
+  qosController->setUsageHistory([this]() { return monitor.history(); });
+
   // Ensure slave work directory exists.
   CHECK_SOME(os::mkdir(flags.work_dir))
     << "Failed to create slave work directory '" << flags.work_dir << "'";
@@ -409,6 +418,9 @@ void Slave::initialize()
 
   startTime = Clock::now();
 
+  // Keep metrics of the protobuf messages the slave handles.
+  instrument("slave/handlers");
+
   // Install protobuf handlers.
   install<SlaveRegisteredMessage>(
       &Slave::registered,
@@ -428,6 +440,12 @@ void Slave::initialize()
       &RunTaskMessage::pid,
       &RunTaskMessage::task);
 
+  install<RunTasksMessage>(
+      &Slave::runTasks,
+      &RunTasksMessage::framework,
+      &RunTasksMessage::pid,
+      &RunTasksMessage::tasks);
+
   install<KillTaskMessage>(
       &Slave::killTask,
       &KillTaskMessage::framework_id,
@@ -465,6 +483,10 @@ void Slave::initialize()
       &StatusUpdateAcknowledgementMessage::task_id,
       &StatusUpdateAcknowledgementMessage::uuid);
 
+  install<StatusUpdateAcknowledgementsMessage>(
+      &Slave::statusUpdateAcknowledgements,
+      &StatusUpdateAcknowledgementsMessage::acknowledgements);
+
   install<RegisterExecutorMessage>(
       &Slave::registerExecutor,
       &RegisterExecutorMessage::framework_id,
@@ -482,6 +504,11 @@ void Slave::initialize()
       &StatusUpdateMessage::update,
       &StatusUpdateMessage::pid);
 
+  install<StatusUpdatesMessage>(
+      &Slave::statusUpdates,
+      &StatusUpdatesMessage::updates,
+      &StatusUpdatesMessage::pid);
+
   install<ExecutorToFrameworkMessage>(
       &Slave::executorMessage,
       &ExecutorToFrameworkMessage::slave_id,
@@ -497,6 +524,14 @@ void Slave::initialize()
       &Slave::ping,
       &PingSlaveMessage::connected);
 
+  install<PullImagesMessage>(
+      &Slave::pullImages,
+      &PullImagesMessage::images);
+
+  // Answer pings promptly even when flooded, otherwise the master
+  // may consider this agent unreachable.
+  prioritize<PingSlaveMessage>();
+
   // Setup HTTP routes.
   Http http = Http(this);
 
@@ -521,12 +556,30 @@ void Slave::initialize()
           Http::log(request);
           return http.state(request);
         });
+  route("/containers",
+        Http::CONTAINERS_HELP(),
+        [http](const process::http::Request& request) {
+          Http::log(request);
+          return http.containers(request);
+        });
   route("/flags",
         Http::FLAGS_HELP(),
         [http](const process::http::Request& request) {
           Http::log(request);
           return http.flags(request);
         });
+  route("/images",
+        Http::IMAGES_HELP(),
+        [http](const process::http::Request& request) {
+          Http::log(request);
+          return http.images(request);
+        });
+  route("/memory",
+        Http::MEMORY_HELP(),
+        [http](const process::http::Request& request) {
+          Http::log(request);
+          return http.memory(request);
+        });
   route("/health",
         Http::HEALTH_HELP(),
         [http](const process::http::Request& request) {
@@ -980,6 +1033,9 @@ void Slave::reregistered(
       state = RUNNING;
       statusUpdateManager->resume(); // Resume status updates.
 
+      // The new master may not know the image pulls yet.
+      sendImagePulls();
+
       // If we don't get a ping from the master, trigger a
       // re-registration. This needs to be done once re-registered,
       // in case we never receive an initial ping.
@@ -1290,6 +1346,94 @@ void Slave::runTask(
     return;
   }
 
+  Future<bool> unschedule = addPendingTasks(frameworkInfo, pid, {task});
+
+  // Run the task after the unschedules are done.
+  unschedule.onAny(
+      defer(self(), &Self::_runTask, lambda::_1, frameworkInfo, task));
+}
+
+
+void Slave::runTasks(
+    const UPID& from,
+    const FrameworkInfo& frameworkInfo,
+    const UPID& pid,
+    const vector<TaskInfo>& tasks)
+{
+  if (master != from) {
+    LOG(WARNING) << "Ignoring run tasks message from " << from
+                 << " because it is not the expected master: "
+                 << (master.isSome() ? stringify(master.get()) : "None");
+    return;
+  }
+
+  if (!frameworkInfo.has_id()) {
+    LOG(ERROR) << "Ignoring run tasks message from " << from
+               << " because it does not have a framework ID";
+    return;
+  }
+
+  const FrameworkID frameworkId = frameworkInfo.id();
+
+  LOG(INFO) << "Got assigned " << tasks.size() << " tasks"
+            << " for framework " << frameworkId;
+
+  CHECK(state == RECOVERING || state == DISCONNECTED ||
+        state == RUNNING || state == TERMINATING)
+    << state;
+
+  // TODO(bmahler): Also ignore if we're DISCONNECTED.
+  if (state == RECOVERING || state == TERMINATING) {
+    LOG(WARNING) << "Ignoring " << tasks.size() << " tasks"
+                 << " because the slave is " << state;
+    return;
+  }
+
+  // The master batches the tasks by executor, but we do not rely on
+  // it: each batch of tasks shares the directories to unschedule and
+  // the update of the container.
+  hashmap<ExecutorID, vector<TaskInfo>> batches;
+
+  foreach (const TaskInfo& task, tasks) {
+    if (!(task.slave_id() == info.id())) {
+      LOG(WARNING)
+        << "Slave " << info.id() << " ignoring task " << task.task_id()
+        << " because it was intended for old slave " << task.slave_id();
+      continue;
+    }
+
+    const ExecutorInfo executorInfo = getExecutorInfo(frameworkInfo, task);
+    batches[executorInfo.executor_id()].push_back(task);
+  }
+
+  foreachpair (const ExecutorID& executorId,
+               vector<TaskInfo>& batch,
+               batches) {
+    LOG(INFO) << "Got assigned " << batch.size() << " tasks for executor '"
+              << executorId << "' of framework " << frameworkId;
+
+    Future<bool> unschedule = addPendingTasks(frameworkInfo, pid, batch);
+
+    // Run the tasks after the unschedules are done.
+    unschedule.onAny(defer(
+        self(),
+        &Self::_runTasks,
+        lambda::_1,
+        frameworkInfo,
+        list<TaskInfo>(batch.begin(), batch.end())));
+  }
+}
+
+
+Future<bool> Slave::addPendingTasks(
+    const FrameworkInfo& frameworkInfo,
+    const UPID& pid,
+    const vector<TaskInfo>& tasks)
+{
+  CHECK(!tasks.empty());
+
+  const FrameworkID frameworkId = frameworkInfo.id();
+
   Future<bool> unschedule = true;
 
   // If we are about to create a new framework, unschedule the work
@@ -1337,20 +1481,30 @@ void Slave::runTask(
     }
   }
 
-  const ExecutorInfo executorInfo = getExecutorInfo(frameworkInfo, task);
+  const ExecutorInfo executorInfo =
+    getExecutorInfo(frameworkInfo, tasks.front());
   const ExecutorID& executorId = executorInfo.executor_id();
 
-  if (HookManager::hooksAvailable()) {
-    // Set task labels from run task label decorator.
-    task.mutable_labels()->CopyFrom(HookManager::slaveRunTaskLabelDecorator(
-        task, executorInfo, frameworkInfo, info));
-  }
-
-  // We add the task to 'pending' to ensure the framework is not
+  // We add the tasks to 'pending' to ensure the framework is not
   // removed and the framework and top level executor directories
-  // are not scheduled for deletion before '_runTask()' is called.
+  // are not scheduled for deletion before '_runTasks()' is called.
   CHECK_NOTNULL(framework);
-  framework->pending[executorId][task.task_id()] = task;
+
+  list<TaskID> taskIds;
+  list<Future<Labels>> decorations;
+
+  foreach (const TaskInfo& task, tasks) {
+    CHECK(getExecutorInfo(frameworkInfo, task).executor_id() == executorId);
+
+    if (HookManager::hooksAvailable()) {
+      // Get task labels from run task label decorator.
+      taskIds.push_back(task.task_id());
+      decorations.push_back(HookManager::slaveRunTaskLabelDecorator(
+          task, executorInfo, frameworkInfo, info, flags.hook_timeout));
+    }
+
+    framework->pending[executorId][task.task_id()] = task;
+  }
 
   // If we are about to create a new executor, unschedule the top
   // level work and meta directories from getting gc'ed.
@@ -1372,9 +1526,31 @@ void Slave::runTask(
     }
   }
 
-  // Run the task after the unschedules are done.
-  unschedule.onAny(
-      defer(self(), &Self::_runTask, lambda::_1, frameworkInfo, task));
+  if (!decorations.empty()) {
+    // Set the labels of the tasks that are still pending once the
+    // hooks are done, '_runTasks()' launches the pending tasks.
+    Future<bool> unscheduled = unschedule;
+
+    unschedule = collect(decorations)
+      .then(defer(self(), [=](const list<Labels>& labels) {
+        Framework* framework = getFramework(frameworkId);
+        if (framework != NULL && framework->pending.contains(executorId)) {
+          list<Labels>::const_iterator label = labels.begin();
+          foreach (const TaskID& taskId, taskIds) {
+            if (framework->pending[executorId].contains(taskId)) {
+              framework->pending[executorId][taskId].mutable_labels()
+                ->CopyFrom(*label);
+            }
+
+            ++label;
+          }
+        }
+
+        return unscheduled;
+      }));
+  }
+
+  return unschedule;
 }
 
 
@@ -1382,52 +1558,83 @@ void Slave::_runTask(
     const Future<bool>& future,
     const FrameworkInfo& frameworkInfo,
     const TaskInfo& task)
+{
+  _runTasks(future, frameworkInfo, {task});
+}
+
+
+void Slave::_runTasks(
+    const Future<bool>& future,
+    const FrameworkInfo& frameworkInfo,
+    const list<TaskInfo>& tasks)
 {
   const FrameworkID frameworkId = frameworkInfo.id();
 
-  LOG(INFO) << "Launching task " << task.task_id()
-            << " for framework " << frameworkId;
+  foreach (const TaskInfo& task, tasks) {
+    LOG(INFO) << "Launching task " << task.task_id()
+              << " for framework " << frameworkId;
+  }
 
   Framework* framework = getFramework(frameworkId);
   if (framework == NULL) {
-    LOG(WARNING) << "Ignoring run task " << task.task_id()
-                 << " because the framework " << frameworkId
-                 << " does not exist";
+    foreach (const TaskInfo& task, tasks) {
+      LOG(WARNING) << "Ignoring run task " << task.task_id()
+                   << " because the framework " << frameworkId
+                   << " does not exist";
+    }
     return;
   }
 
-  const ExecutorInfo executorInfo = getExecutorInfo(frameworkInfo, task);
+  CHECK(!tasks.empty());
+
+  // The tasks share the executor, see 'addPendingTasks()'.
+  const ExecutorInfo executorInfo =
+    getExecutorInfo(frameworkInfo, tasks.front());
   const ExecutorID& executorId = executorInfo.executor_id();
 
-  if (framework->pending.contains(executorId) &&
-      framework->pending[executorId].contains(task.task_id())) {
-    framework->pending[executorId].erase(task.task_id());
-    if (framework->pending[executorId].empty()) {
-      framework->pending.erase(executorId);
-      // NOTE: Ideally we would perform the following check here:
-      //
-      //   if (framework->executors.empty() &&
-      //       framework->pending.empty()) {
-      //     removeFramework(framework);
-      //   }
-      //
-      // However, we need 'framework' to stay valid for the rest of
-      // this function. As such, we perform the check before each of
-      // the 'return' statements below.
+  list<TaskInfo> pending;
+
+  foreach (const TaskInfo& task, tasks) {
+    if (framework->pending.contains(executorId) &&
+        framework->pending[executorId].contains(task.task_id())) {
+      // NOTE: We launch the pending task, which carries the labels
+      // set by the hooks, see 'addPendingTasks()'.
+      pending.push_back(framework->pending[executorId][task.task_id()]);
+      framework->pending[executorId].erase(task.task_id());
+    } else {
+      LOG(WARNING) << "Ignoring run task " << task.task_id()
+                   << " of framework " << frameworkId
+                   << " because the task has been killed in the meantime";
     }
-  } else {
-    LOG(WARNING) << "Ignoring run task " << task.task_id()
-                 << " of framework " << frameworkId
-                 << " because the task has been killed in the meantime";
+  }
+
+  if (framework->pending.contains(executorId) &&
+      framework->pending[executorId].empty()) {
+    framework->pending.erase(executorId);
+    // NOTE: Ideally we would perform the following check here:
+    //
+    //   if (framework->executors.empty() &&
+    //       framework->pending.empty()) {
+    //     removeFramework(framework);
+    //   }
+    //
+    // However, we need 'framework' to stay valid for the rest of
+    // this function. As such, we perform the check before each of
+    // the 'return' statements below.
+  }
+
+  if (pending.empty()) {
     return;
   }
 
   // We don't send a status update here because a terminating
   // framework cannot send acknowledgements.
   if (framework->state == Framework::TERMINATING) {
-    LOG(WARNING) << "Ignoring run task " << task.task_id()
-                 << " of framework " << frameworkId
-                 << " because the framework is terminating";
+    foreach (const TaskInfo& task, pending) {
+      LOG(WARNING) << "Ignoring run task " << task.task_id()
+                   << " of framework " << frameworkId
+                   << " because the framework is terminating";
+    }
 
     // Refer to the comment after 'framework->pending.erase' above
     // for why we need this.
@@ -1442,22 +1649,24 @@ void Slave::_runTask(
     LOG(ERROR) << "Failed to unschedule directories scheduled for gc: "
                << (future.isFailed() ? future.failure() : "future discarded");
 
-    const StatusUpdate update = protobuf::createStatusUpdate(
-        frameworkId,
-        info.id(),
-        task.task_id(),
-        TASK_LOST,
-        TaskStatus::SOURCE_SLAVE,
-        UUID::random(),
-        "Could not launch the task because we failed to unschedule directories"
-        " scheduled for gc",
-        TaskStatus::REASON_GC_ERROR);
-
-    // TODO(vinod): Ensure that the status update manager reliably
-    // delivers this update. Currently, we don't guarantee this
-    // because removal of the framework causes the status update
-    // manager to stop retrying for its un-acked updates.
-    statusUpdate(update, UPID());
+    foreach (const TaskInfo& task, pending) {
+      const StatusUpdate update = protobuf::createStatusUpdate(
+          frameworkId,
+          info.id(),
+          task.task_id(),
+          TASK_LOST,
+          TaskStatus::SOURCE_SLAVE,
+          UUID::random(),
+          "Could not launch the task because we failed to unschedule"
+          " directories scheduled for gc",
+          TaskStatus::REASON_GC_ERROR);
+
+      // TODO(vinod): Ensure that the status update manager reliably
+      // delivers this update. Currently, we don't guarantee this
+      // because removal of the framework causes the status update
+      // manager to stop retrying for its un-acked updates.
+      statusUpdate(update, UPID());
+    }
 
     // Refer to the comment after 'framework->pending.erase' above
     // for why we need this.
@@ -1475,71 +1684,75 @@ void Slave::_runTask(
   // we send TASK_LOST status updates here since restarting the task
   // may succeed in the event that CheckpointResourcesMessage arrives
   // out of order.
-  Resources checkpointedTaskResources =
-    Resources(task.resources()).filter(needCheckpointing);
+  list<TaskInfo> launched;
 
-  foreach (const Resource& resource, checkpointedTaskResources) {
-    if (!checkpointedResources.contains(resource)) {
-      LOG(WARNING) << "Unknown checkpointed resource " << resource
-                   << " for task " << task.task_id()
-                   << " of framework " << frameworkId;
-
-      const StatusUpdate update = protobuf::createStatusUpdate(
-          frameworkId,
-          info.id(),
-          task.task_id(),
-          TASK_LOST,
-          TaskStatus::SOURCE_SLAVE,
-          UUID::random(),
-          "The checkpointed resources being used by the task are unknown to "
-          "the slave",
-          TaskStatus::REASON_RESOURCES_UNKNOWN);
+  foreach (const TaskInfo& task, pending) {
+    Option<StatusUpdate> update;
 
-      statusUpdate(update, UPID());
+    Resources checkpointedTaskResources =
+      Resources(task.resources()).filter(needCheckpointing);
 
-      // Refer to the comment after 'framework->pending.erase' above
-      // for why we need this.
-      if (framework->executors.empty() && framework->pending.empty()) {
-        removeFramework(framework);
-      }
-
-      return;
-    }
-  }
-
-  if (task.has_executor()) {
-    Resources checkpointedExecutorResources =
-      Resources(task.executor().resources()).filter(needCheckpointing);
-
-    foreach (const Resource& resource, checkpointedExecutorResources) {
+    foreach (const Resource& resource, checkpointedTaskResources) {
       if (!checkpointedResources.contains(resource)) {
         LOG(WARNING) << "Unknown checkpointed resource " << resource
-                     << " for executor '" << task.executor().executor_id()
-                     << "' of framework " << frameworkId;
+                     << " for task " << task.task_id()
+                     << " of framework " << frameworkId;
 
-        const StatusUpdate update = protobuf::createStatusUpdate(
+        update = protobuf::createStatusUpdate(
             frameworkId,
             info.id(),
             task.task_id(),
             TASK_LOST,
             TaskStatus::SOURCE_SLAVE,
             UUID::random(),
-            "The checkpointed resources being used by the executor are unknown "
-            "to the slave",
-            TaskStatus::REASON_RESOURCES_UNKNOWN,
-            task.executor().executor_id());
+            "The checkpointed resources being used by the task are unknown to "
+            "the slave",
+            TaskStatus::REASON_RESOURCES_UNKNOWN);
+        break;
+      }
+    }
 
-        statusUpdate(update, UPID());
+    if (update.isNone() && task.has_executor()) {
+      Resources checkpointedExecutorResources =
+        Resources(task.executor().resources()).filter(needCheckpointing);
 
-        // Refer to the comment after 'framework->pending.erase' above
-        // for why we need this.
-        if (framework->executors.empty() && framework->pending.empty()) {
-          removeFramework(framework);
-        }
+      foreach (const Resource& resource, checkpointedExecutorResources) {
+        if (!checkpointedResources.contains(resource)) {
+          LOG(WARNING) << "Unknown checkpointed resource " << resource
+                       << " for executor '" << task.executor().executor_id()
+                       << "' of framework " << frameworkId;
 
-        return;
+          update = protobuf::createStatusUpdate(
+              frameworkId,
+              info.id(),
+              task.task_id(),
+              TASK_LOST,
+              TaskStatus::SOURCE_SLAVE,
+              UUID::random(),
+              "The checkpointed resources being used by the executor are "
+              "unknown to the slave",
+              TaskStatus::REASON_RESOURCES_UNKNOWN,
+              task.executor().executor_id());
+          break;
+        }
       }
     }
+
+    if (update.isSome()) {
+      statusUpdate(update.get(), UPID());
+    } else {
+      launched.push_back(task);
+    }
+  }
+
+  if (launched.empty()) {
+    // Refer to the comment after 'framework->pending.erase' above
+    // for why we need this.
+    if (framework->executors.empty() && framework->pending.empty()) {
+      removeFramework(framework);
+    }
+
+    return;
   }
 
   // NOTE: The slave cannot be in 'RECOVERING' because the task would
@@ -1548,9 +1761,11 @@ void Slave::_runTask(
     << state;
 
   if (state == TERMINATING) {
-    LOG(WARNING) << "Ignoring run task " << task.task_id()
-                 << " of framework " << frameworkId
-                 << " because the slave is terminating";
+    foreach (const TaskInfo& task, launched) {
+      LOG(WARNING) << "Ignoring run task " << task.task_id()
+                   << " of framework " << frameworkId
+                   << " because the slave is terminating";
+    }
 
     // Refer to the comment after 'framework->pending.erase' above
     // for why we need this.
@@ -1565,12 +1780,12 @@ void Slave::_runTask(
 
   CHECK(framework->state == Framework::RUNNING) << framework->state;
 
-  // Either send the task to an executor or start a new executor
-  // and queue the task until the executor has started.
+  // Either send the tasks to an executor or start a new executor
+  // and queue the tasks until the executor has started.
   Executor* executor = framework->getExecutor(executorId);
 
   if (executor == NULL) {
-    executor = framework->launchExecutor(executorInfo, task);
+    executor = framework->launchExecutor(executorInfo, launched.front());
   }
 
   CHECK_NOTNULL(executor);
@@ -1578,53 +1793,59 @@ void Slave::_runTask(
   switch (executor->state) {
     case Executor::TERMINATING:
     case Executor::TERMINATED: {
-      LOG(WARNING) << "Asked to run task '" << task.task_id()
-                   << "' for framework " << frameworkId
-                   << " with executor '" << executorId
-                   << "' which is terminating/terminated";
+      foreach (const TaskInfo& task, launched) {
+        LOG(WARNING) << "Asked to run task '" << task.task_id()
+                     << "' for framework " << frameworkId
+                     << " with executor '" << executorId
+                     << "' which is terminating/terminated";
 
-      const StatusUpdate update = protobuf::createStatusUpdate(
-          frameworkId,
-          info.id(),
-          task.task_id(),
-          TASK_LOST,
-          TaskStatus::SOURCE_SLAVE,
-          UUID::random(),
-          "Executor terminating/terminated",
-          TaskStatus::REASON_EXECUTOR_TERMINATED);
+        const StatusUpdate update = protobuf::createStatusUpdate(
+            frameworkId,
+            info.id(),
+            task.task_id(),
+            TASK_LOST,
+            TaskStatus::SOURCE_SLAVE,
+            UUID::random(),
+            "Executor terminating/terminated",
+            TaskStatus::REASON_EXECUTOR_TERMINATED);
 
-      statusUpdate(update, UPID());
+        statusUpdate(update, UPID());
+      }
       break;
     }
     case Executor::REGISTERING:
-      // Checkpoint the task before we do anything else.
-      if (executor->checkpoint) {
-        executor->checkpointTask(task);
-      }
+      foreach (const TaskInfo& task, launched) {
+        // Checkpoint the task before we do anything else.
+        if (executor->checkpoint) {
+          executor->checkpointTask(task);
+        }
 
-      // Queue task if the executor has not yet registered.
-      LOG(INFO) << "Queuing task '" << task.task_id()
-                << "' for executor " << *executor;
+        // Queue task if the executor has not yet registered.
+        LOG(INFO) << "Queuing task '" << task.task_id()
+                  << "' for executor " << *executor;
 
-      executor->queuedTasks[task.task_id()] = task;
+        executor->queuedTasks[task.task_id()] = task;
+      }
       break;
     case Executor::RUNNING: {
-      // Checkpoint the task before we do anything else.
-      if (executor->checkpoint) {
-        executor->checkpointTask(task);
-      }
+      foreach (const TaskInfo& task, launched) {
+        // Checkpoint the task before we do anything else.
+        if (executor->checkpoint) {
+          executor->checkpointTask(task);
+        }
 
-      // Queue task until the containerizer is updated with new
-      // resource limits (MESOS-998).
-      LOG(INFO) << "Queuing task '" << task.task_id()
-                << "' for executor " << *executor;
+        // Queue task until the containerizer is updated with new
+        // resource limits (MESOS-998).
+        LOG(INFO) << "Queuing task '" << task.task_id()
+                  << "' for executor " << *executor;
 
-      executor->queuedTasks[task.task_id()] = task;
+        executor->queuedTasks[task.task_id()] = task;
+      }
 
-      // Update the resource limits for the container. Note that the
-      // resource limits include the currently queued tasks because we
-      // want the container to have enough resources to hold the
-      // upcoming tasks.
+      // Update the resource limits for the container once for all
+      // the tasks. Note that the resource limits include the currently
+      // queued tasks because we want the container to have enough
+      // resources to hold the upcoming tasks.
       Resources resources = executor->resources;
 
       // TODO(jieyu): Use foreachvalue instead once LinkedHashmap
@@ -1635,12 +1856,12 @@ void Slave::_runTask(
 
       containerizer->update(executor->containerId, resources)
         .onAny(defer(self(),
-                     &Self::runTasks,
+                     &Self::__runTasks,
                      lambda::_1,
                      frameworkId,
                      executorId,
                      executor->containerId,
-                     list<TaskInfo>({task})));
+                     launched));
       break;
     }
     default:
@@ -1656,7 +1877,7 @@ void Slave::_runTask(
 }
 
 
-void Slave::runTasks(
+void Slave::__runTasks(
     const Future<Nothing>& future,
     const FrameworkID& frameworkId,
     const ExecutorID& executorId,
@@ -1753,6 +1974,8 @@ void Slave::runTasks(
     return;
   }
 
+  vector<RunTaskMessage> messages;
+
   foreach (const TaskInfo& task, tasks) {
     // This is the case where the task is killed. No need to send
     // status update because it should be handled in 'killTask'.
@@ -1779,7 +2002,11 @@ void Slave::runTasks(
     // to decode the message, but do not use the field.
     message.set_pid(framework->pid.getOrElse(UPID()));
 
-    executor->send(message);
+    messages.push_back(message);
+  }
+
+  if (!messages.empty()) {
+    executor->send(messages);
   }
 }
 
@@ -2051,6 +2278,7 @@ void Slave::shutdownFramework(
 
 
 void Slave::schedulerMessage(
+    const UPID& from,
     const SlaveID& slaveId,
     const FrameworkID& frameworkId,
     const ExecutorID& executorId,
@@ -2087,6 +2315,33 @@ void Slave::schedulerMessage(
     return;
   }
 
+  // A framework using the HTTP API has its messages relayed by the
+  // master, unless its scheduler is allowed to send them directly.
+  if (framework->pid.isNone() && (master.isNone() || from != master.get())) {
+    if (!flags.direct_framework_messages) {
+      LOG(WARNING) << "Dropping message from framework " << frameworkId
+                   << " sent directly by " << from
+                   << " because direct framework messages are disabled";
+      metrics.invalid_framework_messages++;
+      return;
+    }
+
+    // The master does not know the pid of such a scheduler, so it
+    // cannot vouch for it. To stop another process from redirecting
+    // the executor messages to itself, only the first pid to send a
+    // message is accepted until the framework fails over.
+    if (framework->directPid.isSome() && framework->directPid.get() != from) {
+      LOG(WARNING) << "Dropping message from framework " << frameworkId
+                   << " sent directly by " << from
+                   << " because its messages are sent directly by "
+                   << framework->directPid.get();
+      metrics.invalid_framework_messages++;
+      return;
+    }
+
+    framework->directPid = from;
+  }
+
   Executor* executor = framework->getExecutor(executorId);
   if (executor == NULL) {
     LOG(WARNING) << "Dropping message for executor " << *executor
@@ -2161,6 +2416,9 @@ void Slave::updateFramework(
         framework->pid = pid;
       }
 
+      // A failed over scheduler sends its framework messages anew.
+      framework->directPid = None();
+
       if (framework->info.checkpoint()) {
         // Checkpoint the framework pid, note that when the 'pid'
         // is None, we checkpoint a default UPID() because
@@ -2233,10 +2491,7 @@ void Slave::checkpointResources(const vector<Resource>& _checkpointedResources)
     // This is validated in master.
     CHECK_NE(volume.role(), "*");
 
-    string path = paths::getPersistentVolumePath(
-        flags.work_dir,
-        volume.role(),
-        volume.disk().persistence().id());
+    string path = paths::getPersistentVolumePath(flags.work_dir, volume);
 
     if (!os::exists(path)) {
       CHECK_SOME(os::mkdir(path, true))
@@ -2305,6 +2560,22 @@ void Slave::statusUpdateAcknowledgement(
 }
 
 
+void Slave::statusUpdateAcknowledgements(
+    const UPID& from,
+    const vector<StatusUpdateAcknowledgementMessage>& acknowledgements)
+{
+  foreach (const StatusUpdateAcknowledgementMessage& acknowledgement,
+           acknowledgements) {
+    statusUpdateAcknowledgement(
+        from,
+        acknowledgement.slave_id(),
+        acknowledgement.framework_id(),
+        acknowledgement.task_id(),
+        acknowledgement.uuid());
+  }
+}
+
+
 void Slave::_statusUpdateAcknowledgement(
     const Future<bool>& future,
     const TaskID& taskId,
@@ -2432,10 +2703,15 @@ void Slave::subscribe(
 
       executor->state = Executor::RUNNING;
 
+      reregisteringExecutors.erase(executor->containerId);
+
       // Save the connection for the executor.
       executor->http = http;
       executor->pid = None();
 
+      executor->trace.registered = Clock::now();
+      executor->trace.registration.set(Nothing());
+
       if (framework->info.checkpoint()) {
         // Write a marker file to indicate that this executor
         // is HTTP based.
@@ -2489,7 +2765,7 @@ void Slave::subscribe(
 
       containerizer->update(executor->containerId, resources)
         .onAny(defer(self(),
-                     &Self::runTasks,
+                     &Self::__runTasks,
                      lambda::_1,
                      framework->id(),
                      executor->id,
@@ -2624,6 +2900,9 @@ void Slave::registerExecutor(
       executor->pid = from;
       link(from);
 
+      executor->trace.registered = Clock::now();
+      executor->trace.registration.set(Nothing());
+
       if (framework->info.checkpoint()) {
         // TODO(vinod): This checkpointing should be done
         // asynchronously as it is in the fast path of the slave!
@@ -2664,7 +2943,7 @@ void Slave::registerExecutor(
 
       containerizer->update(executor->containerId, resources)
         .onAny(defer(self(),
-                     &Self::runTasks,
+                     &Self::__runTasks,
                      lambda::_1,
                      frameworkId,
                      executorId,
@@ -2691,10 +2970,12 @@ void Slave::reregisterExecutor(
         state == RUNNING || state == TERMINATING)
     << state;
 
-  if (state != RECOVERING) {
+  // The recovered executors re-register while the slave registers
+  // with the master, until 'reregisterExecutorTimeout()'.
+  if (state == TERMINATING) {
     LOG(WARNING) << "Shutting down executor '" << executorId
                  << "' of framework " << frameworkId
-                 << " because the slave is not in recovery mode";
+                 << " because the slave is terminating";
     reply(ShutdownExecutorMessage());
     return;
   }
@@ -2721,7 +3002,15 @@ void Slave::reregisterExecutor(
   }
 
   Executor* executor = framework->getExecutor(executorId);
-  CHECK_NOTNULL(executor);
+  if (executor == NULL ||
+      !reregisteringExecutors.contains(executor->containerId)) {
+    LOG(WARNING) << "Shutting down executor '" << executorId
+                 << "' of framework " << frameworkId
+                 << " because it is not a recovered executor that is"
+                 << " expected to re-register";
+    reply(ShutdownExecutorMessage());
+    return;
+  }
 
   switch (executor->state) {
     case Executor::TERMINATING:
@@ -2736,6 +3025,8 @@ void Slave::reregisterExecutor(
     case Executor::REGISTERING: {
       executor->state = Executor::RUNNING;
 
+      reregisteringExecutors.erase(executor->containerId);
+
       executor->pid = from; // Update the pid.
       link(from);
 
@@ -2847,7 +3138,9 @@ void Slave::_reregisterExecutor(
 
 void Slave::reregisterExecutorTimeout()
 {
-  CHECK(state == RECOVERING || state == TERMINATING) << state;
+  CHECK(state == RECOVERING || state == DISCONNECTED ||
+        state == RUNNING || state == TERMINATING)
+    << state;
 
   LOG(INFO) << "Cleaning up un-reregistered executors";
 
@@ -2857,6 +3150,11 @@ void Slave::reregisterExecutorTimeout()
       << framework->state;
 
     foreachvalue (Executor* executor, framework->executors) {
+      // Executors launched since the recovery register on their own.
+      if (!reregisteringExecutors.contains(executor->containerId)) {
+        continue;
+      }
+
       switch (executor->state) {
         case Executor::RUNNING:     // Executor re-registered.
         case Executor::TERMINATING:
@@ -2892,8 +3190,7 @@ void Slave::reregisterExecutorTimeout()
     }
   }
 
-  // Signal the end of recovery.
-  recovered.set(Nothing());
+  reregisteringExecutors.clear();
 }
 
 
@@ -3073,6 +3370,11 @@ void Slave::statusUpdate(StatusUpdate update, const Option<UPID>& pid)
   // backed up or is down.
   executor->updateTaskState(status);
 
+  if (status.state() == TASK_RUNNING && executor->trace.running.isNone()) {
+    executor->trace.running = Clock::now();
+    executor->trace.taskRunning.set(Nothing());
+  }
+
   // Handle the task appropriately if it is terminated.
   // TODO(vinod): Revisit these semantics when we disallow duplicate
   // terminal updates (e.g., when slave recovery is always enabled).
@@ -3104,6 +3406,24 @@ void Slave::statusUpdate(StatusUpdate update, const Option<UPID>& pid)
 }
 
 
+void Slave::statusUpdates(
+    const vector<StatusUpdate>& updates,
+    const UPID& pid)
+{
+  LOG(INFO) << "Handling " << updates.size() << " status updates from " << pid;
+
+  // Terminal updates first wait for the container's resources to be
+  // updated, so these still get checkpointed on their own.
+  statusUpdateManager->hold();
+
+  foreach (const StatusUpdate& update, updates) {
+    statusUpdate(update, pid);
+  }
+
+  statusUpdateManager->release();
+}
+
+
 void Slave::_statusUpdate(
     const Option<Future<Nothing>>& future,
     const StatusUpdate& update,
@@ -3272,6 +3592,18 @@ void Slave::forward(StatusUpdate update)
   // re-registration can generate updates when framework/executor/task
   // are unknown.
 
+  if (flags.batch_status_updates) {
+    // We send the updates forwarded while the slave processes the
+    // events that are already queued in one message, by sending them
+    // after those events, see '_forward()'.
+    if (forwardedUpdates.empty()) {
+      dispatch(self(), &Self::_forward);
+    }
+
+    forwardedUpdates.push_back(update);
+    return;
+  }
+
   // Forward the update to master.
   StatusUpdateMessage message;
   message.mutable_update()->MergeFrom(update);
@@ -3281,6 +3613,48 @@ void Slave::forward(StatusUpdate update)
 }
 
 
+void Slave::_forward()
+{
+  if (forwardedUpdates.empty()) {
+    return;
+  }
+
+  // The status update manager retries the updates that do not get
+  // acknowledged, e.g., if the slave got disconnected meanwhile.
+  if (state != RUNNING) {
+    LOG(WARNING) << "Dropping " << forwardedUpdates.size()
+                 << " status updates because the slave is in "
+                 << state << " state";
+
+    forwardedUpdates.clear();
+    return;
+  }
+
+  CHECK_SOME(master);
+
+  if (forwardedUpdates.size() == 1) {
+    StatusUpdateMessage message;
+    message.mutable_update()->MergeFrom(forwardedUpdates.front());
+    message.set_pid(self()); // The ACK will be first received by the slave.
+
+    send(master.get(), message);
+  } else {
+    LOG(INFO) << "Forwarding " << forwardedUpdates.size()
+              << " status updates to " << master.get();
+
+    StatusUpdatesMessage message;
+    foreach (const StatusUpdate& update, forwardedUpdates) {
+      message.add_updates()->MergeFrom(update);
+    }
+    message.set_pid(self()); // The ACKs will be first received by the slave.
+
+    send(master.get(), message);
+  }
+
+  forwardedUpdates.clear();
+}
+
+
 void Slave::executorMessage(
     const SlaveID& slaveId,
     const FrameworkID& frameworkId,
@@ -3332,6 +3706,10 @@ void Slave::executorMessage(
     LOG(INFO) << "Sending message for framework " << frameworkId
               << " to " << framework->pid.get();
     send(framework->pid.get(), message);
+  } else if (framework->directPid.isSome()) {
+    LOG(INFO) << "Sending message for framework " << frameworkId
+              << " directly to " << framework->directPid.get();
+    send(framework->directPid.get(), message);
   } else {
     LOG(INFO) << "Sending message for framework " << frameworkId
               << " through the master " << master.get();
@@ -3373,6 +3751,140 @@ void Slave::ping(const UPID& from, bool connected)
 }
 
 
+static string name(const Image& image)
+{
+  switch (image.type()) {
+    case Image::APPC:
+      return "appc:" + image.appc().name();
+    case Image::DOCKER:
+      return "docker:" + image.docker().name();
+  }
+
+  UNREACHABLE();
+}
+
+
+void Slave::pullImages(const UPID& from, const vector<Image>& images)
+{
+  if (master != from) {
+    LOG(WARNING) << "Ignoring pulling of images from " << from
+                 << " because it is not the expected master: "
+                 << (master.isSome() ? stringify(master.get()) : "None");
+    return;
+  }
+
+  prefetch(images);
+}
+
+
+void Slave::prefetch(const vector<Image>& images)
+{
+  foreach (const Image& image, images) {
+    const string key = image.SerializeAsString();
+
+    // The images being pulled are not pulled twice, but the ones
+    // that are ready or failed are pulled again, e.g., for retries.
+    if (imagePulls.contains(key) &&
+        (imagePulls[key].state() == ImagePull::PENDING ||
+         imagePulls[key].state() == ImagePull::PULLING)) {
+      continue;
+    }
+
+    LOG(INFO) << "Queuing pull of image '" << name(image) << "'";
+
+    ImagePull pull;
+    pull.mutable_image()->CopyFrom(image);
+    pull.set_state(ImagePull::PENDING);
+    pull.set_timestamp(Clock::now().secs());
+
+    // Pulls are started in the order of the requests.
+    imagePulls.erase(key);
+    imagePulls[key] = pull;
+  }
+
+  _prefetch();
+
+  sendImagePulls();
+}
+
+
+void Slave::_prefetch()
+{
+  const size_t limit =
+    std::max<size_t>(1u, flags.image_prefetch_max_concurrent_pulls);
+
+  foreach (const string& key, imagePulls.keys()) {
+    if (activeImagePulls >= limit) {
+      break;
+    }
+
+    ImagePull& pull = imagePulls[key];
+    if (pull.state() != ImagePull::PENDING) {
+      continue;
+    }
+
+    LOG(INFO) << "Pulling image '" << name(pull.image()) << "'";
+
+    pull.set_state(ImagePull::PULLING);
+    pull.set_timestamp(Clock::now().secs());
+
+    ++activeImagePulls;
+
+    containerizer->pull(pull.image())
+      .onAny(defer(self(), &Self::__prefetch, key, lambda::_1));
+  }
+}
+
+
+void Slave::__prefetch(const string& key, const Future<bool>& future)
+{
+  CHECK_GT(activeImagePulls, 0u);
+  --activeImagePulls;
+
+  CHECK(imagePulls.contains(key));
+  ImagePull& pull = imagePulls[key];
+
+  pull.set_timestamp(Clock::now().secs());
+
+  if (future.isReady() && future.get()) {
+    LOG(INFO) << "Pulled image '" << name(pull.image()) << "'";
+
+    pull.set_state(ImagePull::READY);
+  } else {
+    const string message = future.isReady()
+      ? "Unsupported by the containerizer"
+      : (future.isFailed() ? future.failure() : "discarded");
+
+    LOG(WARNING) << "Failed to pull image '" << name(pull.image())
+                 << "': " << message;
+
+    pull.set_state(ImagePull::FAILED);
+    pull.set_message(message);
+  }
+
+  _prefetch();
+
+  sendImagePulls();
+}
+
+
+void Slave::sendImagePulls()
+{
+  if (master.isNone() || state != RUNNING || imagePulls.empty()) {
+    return;
+  }
+
+  ImagePullsMessage message;
+  message.mutable_slave_id()->CopyFrom(info.id());
+
+  foreach (const ImagePull& pull, imagePulls.values()) {
+    message.add_pulls()->CopyFrom(pull);
+  }
+
+  send(master.get(), message);
+}
+
+
 void Slave::pingTimeout(Future<Option<MasterInfo>> future)
 {
   // It's possible that a new ping arrived since the timeout fired
@@ -3504,6 +4016,12 @@ ExecutorInfo Slave::getExecutorInfo(
     executor.set_name("Command Executor " + name);
     executor.set_source(task.task_id().value());
 
+    // The isolators interpret some labels of the executor (e.g., to
+    // pin the container to cores), which are given by the task.
+    if (task.has_labels()) {
+      executor.mutable_labels()->CopyFrom(task.labels());
+    }
+
     // Copy the [uris, environment, container, user] fields from the
     // CommandInfo to get the URIs we need to download, the
     // environment variables that should get set, the necessary
@@ -3688,6 +4206,10 @@ void Slave::executorLaunched(
       break;
     case Executor::REGISTERING:
     case Executor::RUNNING:
+      executor->trace.launched = Clock::now();
+
+      metrics.executor_registration.time(
+          executor->trace.registration.future());
       break;
     case Executor::TERMINATED:
     default:
@@ -3840,6 +4362,8 @@ void Slave::removeExecutor(Framework* framework, Executor* executor)
   // Check that this executor has terminated.
   CHECK(executor->state == Executor::TERMINATED) << executor->state;
 
+  reregisteringExecutors.erase(executor->containerId);
+
   // Check that either 1) the executor has no tasks with pending
   // updates or 2) the slave/framework is terminating, because no
   // acknowledgements might be received.
@@ -4337,6 +4861,10 @@ Future<Nothing> Slave::_recover()
                      lambda::_1));
 
       if (flags.recover == "reconnect") {
+        // The executors that do not re-register (or subscribe) by
+        // 'reregisterExecutorTimeout()' are destroyed.
+        reregisteringExecutors.insert(executor->containerId);
+
         // We send a reconnect message for PID based executors
         // as we can initiate communication with them. Recovered
         // HTTP executors, on the other hand, are responsible for
@@ -4381,13 +4909,15 @@ Future<Nothing> Slave::_recover()
     delay(EXECUTOR_REREGISTER_TIMEOUT,
           self(),
           &Slave::reregisterExecutorTimeout);
-
-    // We set 'recovered' flag inside reregisterExecutorTimeout(),
-    // so that when the slave re-registers with master it can
-    // correctly inform the master about the launched tasks.
-    return recovered.future();
   }
 
+  // NOTE: We do not wait for the executors to re-register: the
+  // checkpointed state already tells the master about the launched
+  // tasks, and the tasks of the executors that do not re-register are
+  // transitioned to TASK_LOST once their executors are destroyed. The
+  // slave thus (re-)registers with the master while the executors
+  // re-register, and their 'containerizer->update()' calls overlap.
+
   return Nothing();
 }
 
@@ -4780,7 +5310,7 @@ Future<ResourceUsage> Slave::usage()
   // constructors. Revisit once we remove the copy constructor for
   // Owned (or C++14 lambda generalized capture is supported).
   Owned<ResourceUsage> usage(new ResourceUsage());
-  list<Future<ResourceStatistics>> futures;
+  vector<Future<ResourceStatistics>> futures;
 
   foreachvalue (const Framework* framework, frameworks) {
     foreachvalue (const Executor* executor, framework->executors) {
@@ -4805,7 +5335,7 @@ Future<ResourceUsage> Slave::usage()
   usage->mutable_total()->CopyFrom(totalResources.get());
 
   return await(futures).then(
-      [usage](const list<Future<ResourceStatistics>>& futures) {
+      [usage](const vector<Future<ResourceStatistics>>& futures) {
         // NOTE: We add ResourceUsage::Executor to 'usage' the same
         // order as we push future to 'futures'. So the variables
         // 'future' and 'executor' below should be in sync.
@@ -5167,14 +5697,26 @@ Executor* Framework::launchExecutor(
     }
   }
 
-  // Create a directory for the executor.
-  const string directory = paths::createExecutorDirectory(
+  // Create a directory for the executor. Creating the deep directory
+  // tree, its 'latest' symlink and its ownership are costly metadata
+  // operations on some file systems, so we do it off the slave actor
+  // and launch the container once the directory exists.
+  const string directory = paths::getExecutorRunPath(
       slave->flags.work_dir,
       slave->info.id(),
       id(),
       executorInfo.executor_id(),
-      containerId,
-      user);
+      containerId);
+
+  const string workDir = slave->flags.work_dir;
+  const SlaveID slaveId = slave->info.id();
+  const FrameworkID frameworkId = id();
+  const ExecutorID executorId = executorInfo.executor_id();
+
+  Future<string> created = async([=]() {
+    return paths::createExecutorDirectory(
+        workDir, slaveId, frameworkId, executorId, containerId, user);
+  });
 
   Executor* executor = new Executor(
       slave, id(), executorInfo, containerId, directory, info.checkpoint());
@@ -5193,8 +5735,14 @@ Executor* Framework::launchExecutor(
             << " with resources " << executorInfo.resources()
             << " in work directory '" << directory << "'";
 
-  slave->files->attach(executor->directory, executor->directory)
-    .onAny(defer(slave, &Slave::fileAttached, lambda::_1, executor->directory));
+  // The callbacks below capture the slave rather than the framework,
+  // which may have been removed by the time they run.
+  Slave* slave = this->slave;
+
+  created.onReady(defer(slave->self(), [=](const string&) {
+    slave->files->attach(directory, directory)
+      .onAny(defer(slave, &Slave::fileAttached, lambda::_1, directory));
+  }));
 
   // Tell the containerizer to launch the executor.
   // NOTE: We modify the ExecutorInfo to include the task's
@@ -5206,6 +5754,8 @@ Executor* Framework::launchExecutor(
   resources += taskInfo.resources();
   executorInfo_.mutable_resources()->CopyFrom(resources);
 
+  const bool checkpoint = info.checkpoint();
+
   // Launch the container.
   Future<bool> launch;
   if (!executor->isCommandExecutor()) {
@@ -5213,14 +5763,16 @@ Executor* Framework::launchExecutor(
     // the task will include the executor to run. The actual task to
     // run will be enqueued and subsequently handled by the executor
     // when it has registered to the slave.
-    launch = slave->containerizer->launch(
-        containerId,
-        executorInfo_, // Modified to include the task's resources, see above.
-        executor->directory,
-        user,
-        slave->info.id(),
-        slave->self(),
-        info.checkpoint());
+    launch = created.then(defer(slave->self(), [=](const string&) {
+      return slave->containerizer->launch(
+          containerId,
+          executorInfo_, // Modified to include the task's resources.
+          directory,
+          user,
+          slaveId,
+          slave->self(),
+          checkpoint);
+    }));
   } else {
     // An executor has _not_ been provided by the task and will
     // instead define a command and/or container to run. Right now,
@@ -5230,17 +5782,24 @@ Executor* Framework::launchExecutor(
     // executor info works as a placeholder.
     // TODO(nnielsen): Obsolete the requirement for executors to run
     // one-off tasks.
-    launch = slave->containerizer->launch(
-        containerId,
-        taskInfo,
-        executorInfo_, // Modified to include the task's resources, see above.
-        executor->directory,
-        user,
-        slave->info.id(),
-        slave->self(),
-        info.checkpoint());
+    launch = created.then(defer(slave->self(), [=](const string&) {
+      return slave->containerizer->launch(
+          containerId,
+          taskInfo,
+          executorInfo_, // Modified to include the task's resources.
+          directory,
+          user,
+          slaveId,
+          slave->self(),
+          checkpoint);
+    }));
   }
 
+  executor->trace.launching = Clock::now();
+
+  slave->metrics.container_launch.time(launch);
+  slave->metrics.task_running.time(executor->trace.taskRunning.future());
+
   launch.onAny(defer(slave,
                      &Slave::executorLaunched,
                      id(),
@@ -5658,6 +6217,24 @@ bool Executor::isCommandExecutor() const
 }
 
 
+bool Executor::writable()
+{
+  CHECK_SOME(http);
+
+  if (http->writable()) {
+    return true;
+  }
+
+  LOG(WARNING) << "Dropping event for executor " << *this << ":"
+               << " more than " << slave->flags.max_http_executor_buffer_size
+               << " of events are buffered, closing its connection";
+
+  closeHttpConnection();
+
+  return false;
+}
+
+
 void Executor::closeHttpConnection()
 {
   CHECK_SOME(http);
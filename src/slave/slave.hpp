@@ -46,6 +46,7 @@
 #include <process/protobuf.hpp>
 
 #include <stout/bytes.hpp>
+#include <stout/foreach.hpp>
 #include <stout/linkedhashmap.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
@@ -133,12 +134,35 @@ public:
       const process::UPID& pid,
       TaskInfo task);
 
+  void runTasks(
+      const process::UPID& from,
+      const FrameworkInfo& frameworkInfo,
+      const process::UPID& pid,
+      const std::vector<TaskInfo>& tasks);
+
+  // Adds the tasks, which share an executor, to the pending tasks of
+  // their framework, which is created if needed, and unschedules the
+  // directories of the framework and of the executor from gc. Returns
+  // the future of the unschedules, which also waits for the label
+  // decorator hooks to set the labels of the pending tasks.
+  process::Future<bool> addPendingTasks(
+      const FrameworkInfo& frameworkInfo,
+      const process::UPID& pid,
+      const std::vector<TaskInfo>& tasks);
+
   // Made 'virtual' for Slave mocking.
   virtual void _runTask(
       const process::Future<bool>& future,
       const FrameworkInfo& frameworkInfo,
       const TaskInfo& task);
 
+  // Launches the tasks, which share an executor, once the unschedules
+  // of 'addPendingTasks' are done.
+  void _runTasks(
+      const process::Future<bool>& future,
+      const FrameworkInfo& frameworkInfo,
+      const std::list<TaskInfo>& tasks);
+
   process::Future<bool> unschedule(const std::string& path);
 
   // Made 'virtual' for Slave mocking.
@@ -157,6 +181,7 @@ public:
       const FrameworkID& frameworkId);
 
   void schedulerMessage(
+      const process::UPID& from,
       const SlaveID& slaveId,
       const FrameworkID& frameworkId,
       const ExecutorID& executorId,
@@ -204,6 +229,14 @@ public:
 
   void ping(const process::UPID& from, bool connected);
 
+  // Handles the request of the master to prefetch images.
+  void pullImages(
+      const process::UPID& from,
+      const std::vector<Image>& images);
+
+  // Queues the pulls of the images, also for the '/images' endpoint.
+  void prefetch(const std::vector<Image>& images);
+
   // Handles the status update.
   // NOTE: If 'pid' is a valid UPID an ACK is sent to this pid
   // after the update is successfully handled. If pid == UPID()
@@ -214,6 +247,13 @@ public:
   // to ensure source field is set.
   void statusUpdate(StatusUpdate update, const Option<process::UPID>& pid);
 
+  // Handles the status updates that an executor driver sent together
+  // in order, as if each was sent on its own. The updates that are
+  // checkpointed right away get checkpointed at once.
+  void statusUpdates(
+      const std::vector<StatusUpdate>& updates,
+      const process::UPID& pid);
+
   // Continue handling the status update after optionally updating the
   // container's resources.
   void _statusUpdate(
@@ -237,6 +277,10 @@ public:
   // added to the update before forwarding.
   void forward(StatusUpdate update);
 
+  // Sends the updates batched by 'forward()' to the master, if the
+  // slave is configured with '--batch_status_updates'.
+  void _forward();
+
   void statusUpdateAcknowledgement(
       const process::UPID& from,
       const SlaveID& slaveId,
@@ -244,6 +288,12 @@ public:
       const TaskID& taskId,
       const std::string& uuid);
 
+  // Handles the acknowledgements that the master batched for a slave
+  // configured with '--batch_status_updates', in order.
+  void statusUpdateAcknowledgements(
+      const process::UPID& from,
+      const std::vector<StatusUpdateAcknowledgementMessage>& acknowledgements);
+
   void _statusUpdateAcknowledgement(
       const process::Future<bool>& future,
       const TaskID& taskId,
@@ -293,10 +343,7 @@ public:
   // This is called when the resource limits of the container have
   // been updated for the given tasks. If the update is successful, we
   // flush the given tasks to the executor by sending RunTaskMessages.
-  // TODO(jieyu): Consider renaming it to '__runTasks' once the slave
-  // starts to support launching multiple tasks in one call (i.e.,
-  // multi-tasks version of 'runTask').
-  void runTasks(
+  void __runTasks(
       const process::Future<Nothing>& future,
       const FrameworkID& frameworkId,
       const ExecutorID& executorId,
@@ -421,6 +468,10 @@ private:
     process::Future<process::http::Response> executor(
         const process::http::Request& request) const;
 
+    // /slave/containers
+    process::Future<process::http::Response> containers(
+        const process::http::Request& request) const;
+
     // /slave/flags
     process::Future<process::http::Response> flags(
         const process::http::Request& request) const;
@@ -429,13 +480,24 @@ private:
     process::Future<process::http::Response> health(
         const process::http::Request& request) const;
 
+    // /slave/images
+    process::Future<process::http::Response> images(
+        const process::http::Request& request) const;
+
+    // /slave/memory
+    process::Future<process::http::Response> memory(
+        const process::http::Request& request) const;
+
     // /slave/state
     process::Future<process::http::Response> state(
         const process::http::Request& request) const;
 
     static std::string EXECUTOR_HELP();
+    static std::string CONTAINERS_HELP();
     static std::string FLAGS_HELP();
     static std::string HEALTH_HELP();
+    static std::string IMAGES_HELP();
+    static std::string MEMORY_HELP();
     static std::string STATE_HELP();
 
   private:
@@ -481,6 +543,14 @@ private:
       const FrameworkID& frameworkId,
       const Executor* executor);
 
+  // Starts pulls of the queued images until the maximum number of
+  // concurrent pulls is reached.
+  void _prefetch();
+  void __prefetch(const std::string& key, const Future<bool>& future);
+
+  // Sends the states of the image pulls to the master.
+  void sendImagePulls();
+
   // Forwards the current total of oversubscribed resources.
   void forwardOversubscribed();
   void _forwardOversubscribed(
@@ -523,6 +593,10 @@ private:
 
   StatusUpdateManager* statusUpdateManager;
 
+  // The updates forwarded to the master in the next batch, if the
+  // slave is configured with '--batch_status_updates'.
+  std::vector<StatusUpdate> forwardedUpdates;
+
   // Master detection future.
   process::Future<Option<MasterInfo>> detection;
 
@@ -533,10 +607,15 @@ private:
   // the master.
   process::Timer pingTimer;
 
-  // Flag to indicate if recovery, including reconciling (i.e., reconnect/kill)
-  // with executors is finished.
+  // Flag to indicate if recovery is finished. The recovered executors
+  // reconnect (or are killed) afterwards, see 'reregisteringExecutors'.
   process::Promise<Nothing> recovered;
 
+  // The containers of the recovered executors which have not
+  // re-registered (or subscribed) yet, until
+  // 'reregisterExecutorTimeout()'.
+  hashset<ContainerID> reregisteringExecutors;
+
   // Root meta directory containing checkpointed data.
   const std::string metaDir;
 
@@ -570,6 +649,13 @@ private:
   // The most recent estimate of the total amount of oversubscribed
   // (allocated and oversubscribable) resources.
   Option<Resources> oversubscribedResources;
+
+  // The pulls of the images to prefetch, by serialized image, in the
+  // order in which they were requested.
+  LinkedHashMap<std::string, ImagePull> imagePulls;
+
+  // The number of images being pulled.
+  size_t activeImagePulls;
 };
 
 
@@ -591,6 +677,19 @@ struct HttpConnection
     return writer.write(encoder.encode(evolve(message)));
   }
 
+  // Sends the messages in a single write, i.e., as a single chunk
+  // of the response, rather than one chunk per event.
+  template <typename Message>
+  bool send(const std::vector<Message>& messages)
+  {
+    std::string records;
+    foreach (const Message& message, messages) {
+      records += encoder.encode(evolve(message));
+    }
+
+    return writer.write(records);
+  }
+
   bool close()
   {
     return writer.close();
@@ -601,6 +700,14 @@ struct HttpConnection
     return writer.readerClosed();
   }
 
+  // Returns false if the executor is not keeping up with reading the
+  // events, i.e., the high-water mark of the pipe has been reached,
+  // or if the connection is closed.
+  bool writable() const
+  {
+    return writer.writable().isReady();
+  }
+
   process::http::Pipe::Writer writer;
   ContentType contentType;
   ::recordio::Encoder<v1::executor::Event> encoder;
@@ -644,6 +751,10 @@ struct Executor
     }
 
     if (http.isSome()) {
+      if (!writable()) {
+        return;
+      }
+
       if (!http->send(message)) {
         LOG(WARNING) << "Unable to send event to executor " << *this
                      << ": connection closed";
@@ -656,6 +767,39 @@ struct Executor
     }
   }
 
+  // Sends the messages to the connected executor, coalesced into a
+  // single write if the executor is HTTP based.
+  template <typename Message>
+  void send(const std::vector<Message>& messages)
+  {
+    if (http.isSome()) {
+      if (state == REGISTERING || state == TERMINATED) {
+        LOG(WARNING) << "Attempting to send messages to disconnected"
+                     << " executor " << *this << " in state " << state;
+      }
+
+      if (!writable()) {
+        return;
+      }
+
+      if (!http->send(messages)) {
+        LOG(WARNING) << "Unable to send events to executor " << *this
+                     << ": connection closed";
+      }
+    } else {
+      foreach (const Message& message, messages) {
+        send(message);
+      }
+    }
+  }
+
+  // Returns false, after closing the HTTP connection, if the HTTP
+  // executor is not keeping up with reading the events. Rather than
+  // buffering events without bound, we drop them and have the
+  // executor subscribe again, upon which the tasks it never received
+  // are transitioned to TASK_LOST (see 'Slave::subscribe').
+  bool writable();
+
   // Returns true if this is a command executor.
   bool isCommandExecutor() const;
 
@@ -732,6 +876,21 @@ struct Executor
   // non-terminal tasks.
   Option<containerizer::Termination> pendingTermination;
 
+  // When the launch of the executor went through its phases, which
+  // the '/containers' endpoint reports. The promises are completed
+  // when the executor registers and when its first task is running,
+  // so the launch metrics of the slave can time them.
+  struct Trace
+  {
+    Option<process::Time> launching; // The containerizer was asked.
+    Option<process::Time> launched;  // The container was launched.
+    Option<process::Time> registered;
+    Option<process::Time> running;   // The first task was running.
+
+    process::Promise<Nothing> registration;
+    process::Promise<Nothing> taskRunning;
+  } trace;
+
 private:
   Executor(const Executor&);              // No copying.
   Executor& operator=(const Executor&); // No assigning.
@@ -781,6 +940,11 @@ struct Framework
   // sent through the master.
   Option<UPID> pid;
 
+  // The scheduler of a framework using the HTTP API which sends its
+  // framework messages directly, to which the executor messages are
+  // then sent directly as well, see '--direct_framework_messages'.
+  Option<UPID> directPid;
+
   // Executors with pending tasks.
   hashmap<ExecutorID, hashmap<TaskID, TaskInfo>> pending;
 
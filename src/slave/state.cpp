@@ -16,7 +16,11 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 #include <process/pid.hpp>
 
@@ -49,6 +53,7 @@ namespace state {
 
 using std::list;
 using std::string;
+using std::vector;
 using std::max;
 
 
@@ -172,13 +177,45 @@ Try<SlaveState> SlaveState::recover(
                  ": " + frameworks.error());
   }
 
-  // Recover each of the frameworks.
-  foreach (const string& path, frameworks.get()) {
+  // Recover the frameworks in parallel, their subtrees of the meta
+  // directory are independent. The threads take the next framework
+  // to recover until there are none left.
+  const vector<string> paths(frameworks.get().begin(), frameworks.get().end());
+  vector<Option<Try<FrameworkState> > > recovered(paths.size());
+
+  std::atomic<size_t> next(0);
+
+  auto recover = [&]() {
+    for (size_t i = next++; i < paths.size(); i = next++) {
+      FrameworkID frameworkId;
+      frameworkId.set_value(Path(paths[i]).basename());
+
+      recovered[i] =
+        FrameworkState::recover(rootDir, slaveId, frameworkId, strict);
+    }
+  };
+
+  const size_t count = std::min(
+      paths.size(),
+      std::max<size_t>(1, std::min(std::thread::hardware_concurrency(), 8u)));
+
+  vector<std::thread> threads;
+  for (size_t i = 1; i < count; i++) {
+    threads.push_back(std::thread(recover));
+  }
+
+  recover();
+
+  foreach (std::thread& thread, threads) {
+    thread.join();
+  }
+
+  for (size_t i = 0; i < paths.size(); i++) {
     FrameworkID frameworkId;
-    frameworkId.set_value(Path(path).basename());
+    frameworkId.set_value(Path(paths[i]).basename());
 
-    Try<FrameworkState> framework =
-      FrameworkState::recover(rootDir, slaveId, frameworkId, strict);
+    CHECK_SOME(recovered[i]);
+    const Try<FrameworkState>& framework = recovered[i].get();
 
     if (framework.isError()) {
       return Error("Failed to recover framework " + frameworkId.value() +
@@ -189,10 +226,134 @@ Try<SlaveState> SlaveState::recover(
     state.errors += framework.get().errors;
   }
 
+  // Read the status updates that were checkpointed to the journal,
+  // which follow those in the 'task.updates' files of older slaves.
+  const string& journal = paths::getTaskUpdatesJournalPath(rootDir, slaveId);
+  if (!os::exists(journal)) {
+    return state;
+  }
+
+  Try<int> fd = os::open(journal, O_RDWR | O_CLOEXEC);
+
+  if (fd.isError()) {
+    const string& message = "Failed to open status updates journal '" +
+                            journal + "': " + fd.error();
+    if (strict) {
+      return Error(message);
+    } else {
+      LOG(WARNING) << message;
+      state.errors++;
+      return state;
+    }
+  }
+
+  // The records are parsed straight from a mapping of the journal.
+  ::protobuf::Reader reader;
+  Try<Nothing> mapped = reader.open(fd.get());
+
+  if (mapped.isError()) {
+    os::close(fd.get());
+
+    const string& message = "Failed to map status updates journal '" +
+                            journal + "': " + mapped.error();
+    if (strict) {
+      return Error(message);
+    } else {
+      LOG(WARNING) << message;
+      state.errors++;
+      return state;
+    }
+  }
+
+  Result<StatusUpdateJournalRecord> record = None();
+  while (true) {
+    // Ignore errors due to partial protobuf read. Failed reads leave
+    // the reader at the end of the last valid record.
+    record = reader.read<StatusUpdateJournalRecord>(true);
+
+    if (!record.isSome()) {
+      break;
+    }
+
+    // The records of the tasks whose state is gone, e.g., because
+    // their executors were garbage collected, are skipped until the
+    // journal gets compacted.
+    TaskState* task = state.task(
+        record.get().framework_id(),
+        record.get().executor_id(),
+        record.get().container_id(),
+        record.get().task_id());
+
+    if (task == NULL) {
+      continue;
+    }
+
+    if (record.get().record().type() == StatusUpdateRecord::UPDATE) {
+      task->updates.push_back(record.get().record().update());
+    } else {
+      task->acks.insert(UUID::fromBytes(record.get().record().uuid()));
+    }
+  }
+
+  // Always truncate the journal to contain only valid records, the
+  // next ones get appended to it.
+  Try<Nothing> truncated = os::ftruncate(fd.get(), reader.offset());
+
+  os::close(fd.get());
+
+  if (truncated.isError()) {
+    return Error(
+        "Failed to truncate status updates journal '" + journal +
+        "': " + truncated.error());
+  }
+
+  if (record.isError()) {
+    const string& message = "Failed to read status updates journal '" +
+                            journal + "': " + record.error();
+    if (strict) {
+      return Error(message);
+    } else {
+      LOG(WARNING) << message;
+      state.errors++;
+    }
+  }
+
   return state;
 }
 
 
+TaskState* SlaveState::task(
+    const FrameworkID& frameworkId,
+    const ExecutorID& executorId,
+    const ContainerID& containerId,
+    const TaskID& taskId)
+{
+  if (!frameworks.contains(frameworkId)) {
+    return NULL;
+  }
+
+  FrameworkState& framework = frameworks[frameworkId];
+
+  if (!framework.executors.contains(executorId)) {
+    return NULL;
+  }
+
+  ExecutorState& executor = framework.executors[executorId];
+
+  if (!executor.runs.contains(containerId)) {
+    return NULL;
+  }
+
+  RunState& run = executor.runs[containerId];
+
+  if (!run.tasks.contains(taskId)) {
+    return NULL;
+  }
+
+  return &run.tasks[taskId];
+}
+
+
 Try<FrameworkState> FrameworkState::recover(
     const string& rootDir,
     const SlaveID& slaveId,
@@ -325,7 +486,7 @@ Try<ExecutorState> ExecutorState::recover(
                  "': " + runs.error());
   }
 
-  // Recover the runs.
+  // Find the latest run first, see below.
   foreach (const string& path, runs.get()) {
     if (Path(path).basename() == paths::LATEST_SYMLINK) {
       const Result<string>& latest = os::realpath(path);
@@ -342,10 +503,30 @@ Try<ExecutorState> ExecutorState::recover(
       ContainerID containerId;
       containerId.set_value(Path(latest.get()).basename());
       state.latest = containerId;
-    } else {
+    }
+  }
+
+  // Recover the runs.
+  foreach (const string& path, runs.get()) {
+    if (Path(path).basename() != paths::LATEST_SYMLINK) {
       ContainerID containerId;
       containerId.set_value(Path(path).basename());
 
+      // The slave only garbage collects the directories of the
+      // completed runs other than the latest, so we skip reading
+      // their tasks and pids, which dominate the recovery of slaves
+      // with many completed executors.
+      if (state.latest != containerId &&
+          os::exists(paths::getExecutorSentinelPath(
+              rootDir, slaveId, frameworkId, executorId, containerId))) {
+        RunState run;
+        run.id = containerId;
+        run.completed = true;
+
+        state.runs[containerId] = run;
+        continue;
+      }
+
       Try<RunState> run = RunState::recover(
           rootDir, slaveId, frameworkId, executorId, containerId, strict);
 
@@ -624,12 +805,30 @@ Try<TaskState> TaskState::recover(
     }
   }
 
+  ::protobuf::Reader reader;
+  Try<Nothing> mapped = reader.open(fd.get());
+
+  if (mapped.isError()) {
+    message = "Failed to map status updates file '" + path +
+              "': " + mapped.error();
+
+    os::close(fd.get());
+
+    if (strict) {
+      return Error(message);
+    } else {
+      LOG(WARNING) << message;
+      state.errors++;
+      return state;
+    }
+  }
+
   // Now, read the updates.
   Result<StatusUpdateRecord> record = None();
   while (true) {
-    // Ignore errors due to partial protobuf read and enable undoing
-    // failed reads by reverting to the previous seek position.
-    record = ::protobuf::read<StatusUpdateRecord>(fd.get(), true, true);
+    // Ignore errors due to partial protobuf read. Failed reads leave
+    // the reader at the end of the last valid update.
+    record = reader.read<StatusUpdateRecord>(true);
 
     if (!record.isSome()) {
       break;
@@ -642,18 +841,11 @@ Try<TaskState> TaskState::recover(
     }
   }
 
-  off_t offset = lseek(fd.get(), 0, SEEK_CUR);
-
-  if (offset < 0) {
-    os::close(fd.get());
-    return ErrnoError("Failed to lseek status updates file '" + path + "'");
-  }
-
   // Always truncate the file to contain only valid updates.
   // NOTE: This is safe even though we ignore partial protobuf read
-  // errors above, because the 'fd' is properly set to the end of the
-  // last valid update by 'protobuf::read()'.
-  Try<Nothing> truncated = os::ftruncate(fd.get(), offset);
+  // errors above, because the offset of the reader is the end of the
+  // last valid update.
+  Try<Nothing> truncated = os::ftruncate(fd.get(), reader.offset());
 
   if (truncated.isError()) {
     os::close(fd.get());
@@ -712,11 +904,28 @@ Try<ResourcesState> ResourcesState::recover(
     }
   }
 
+  ::protobuf::Reader reader;
+  Try<Nothing> mapped = reader.open(fd.get());
+  if (mapped.isError()) {
+    string message =
+      "Failed to map resources file '" + path + "': " + mapped.error();
+
+    os::close(fd.get());
+
+    if (strict) {
+      return Error(message);
+    } else {
+      LOG(WARNING) << message;
+      state.errors++;
+      return state;
+    }
+  }
+
   Result<Resource> resource = None();
   while (true) {
-    // Ignore errors due to partial protobuf read and enable undoing
-    // failed reads by reverting to the previous seek position.
-    resource = ::protobuf::read<Resource>(fd.get(), true, true);
+    // Ignore errors due to partial protobuf read. Failed reads leave
+    // the reader at the end of the last valid resource.
+    resource = reader.read<Resource>(true);
     if (!resource.isSome()) {
       break;
     }
@@ -724,17 +933,11 @@ Try<ResourcesState> ResourcesState::recover(
     state.resources += resource.get();
   }
 
-  off_t offset = lseek(fd.get(), 0, SEEK_CUR);
-  if (offset < 0) {
-    os::close(fd.get());
-    return ErrnoError("Failed to lseek resources file '" + path + "'");
-  }
-
   // Always truncate the file to contain only valid resources.
   // NOTE: This is safe even though we ignore partial protobuf read
-  // errors above, because the 'fd' is properly set to the end of the
-  // last valid resource by 'protobuf::read()'.
-  Try<Nothing> truncated = os::ftruncate(fd.get(), offset);
+  // errors above, because the offset of the reader is the end of the
+  // last valid resource.
+  Try<Nothing> truncated = os::ftruncate(fd.get(), reader.offset());
 
   if (truncated.isError()) {
     os::close(fd.get());
@@ -239,6 +239,10 @@ struct ExecutorState
   ExecutorID id;
   Option<ExecutorInfo> info;
   Option<ContainerID> latest;
+
+  // Only the 'id' and 'completed' of the completed runs other than
+  // the latest are recovered, 'RunState::recover' loads the rest of
+  // such a run if needed.
   hashmap<ContainerID, RunState> runs;
   unsigned int errors;
 };
@@ -288,6 +292,13 @@ struct SlaveState
       const SlaveID& slaveId,
       bool strict);
 
+  // Returns the recovered state of a task, or NULL if there is none.
+  TaskState* task(
+      const FrameworkID& frameworkId,
+      const ExecutorID& executorId,
+      const ContainerID& containerId,
+      const TaskID& taskId);
+
   SlaveID id;
   Option<SlaveInfo> info;
   hashmap<FrameworkID, FrameworkState> frameworks;
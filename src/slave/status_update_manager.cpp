@@ -14,7 +14,10 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <map>
+
 #include <process/delay.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/timer.hpp>
 
@@ -37,18 +40,22 @@
 
 #include "slave/constants.hpp"
 #include "slave/flags.hpp"
+#include "slave/paths.hpp"
 #include "slave/slave.hpp"
 #include "slave/state.hpp"
 #include "slave/status_update_manager.hpp"
 
 using lambda::function;
 
+using std::map;
 using std::string;
 
 using process::wait; // Necessary on some OS's to disambiguate.
 using process::Failure;
 using process::Future;
+using process::Owned;
 using process::PID;
+using process::Promise;
 using process::Timeout;
 using process::UPID;
 
@@ -98,6 +105,9 @@ public:
   void pause();
   void resume();
 
+  void hold();
+  void release();
+
   void cleanup(const FrameworkID& frameworkId);
 
 private:
@@ -112,17 +122,31 @@ private:
   // Status update timeout.
   void timeout(const Duration& duration);
 
+  // Returns a future that is satisfied once the records appended to
+  // the journals so far are on disk. The records appended until then
+  // are written and synced together by 'flush'.
+  Future<Nothing> flushed();
+  void flush();
+
+  // Drops the records of the tasks whose checkpointed state is gone
+  // from the journals, and schedules the next compaction.
+  void compact();
+
   // Forwards the status update to the master and starts a timer based
   // on the 'duration' to check for ACK from the scheduler.
   // NOTE: This should only be used for those messages that expect an
   // ACK (e.g updates from the executor).
   Timeout forward(const StatusUpdate& update, const Duration& duration);
 
+  // Ends the batch of forwarded updates that share the timers to
+  // check for ACKs, see 'forward()'.
+  void _forward();
+
   // Helper functions.
 
-  // Creates a new status update stream (opening the updates file, if path is
-  // present) and adds it to streams.
-  StatusUpdateStream* createStatusUpdateStream(
+  // Creates a new status update stream (opening the journal of the slave,
+  // if checkpointing) and adds it to streams.
+  Try<StatusUpdateStream*> createStatusUpdateStream(
       const TaskID& taskId,
       const FrameworkID& frameworkId,
       const SlaveID& slaveId,
@@ -144,21 +168,58 @@ private:
   function<void(StatusUpdate)> forward_;
 
   hashmap<FrameworkID, hashmap<TaskID, StatusUpdateStream*> > streams;
+
+  hashmap<SlaveID, StatusUpdateJournal*> journals;
+
+  // The promise of the batch of records to be flushed next, if any.
+  Option<Owned<Promise<Nothing> > > flushing;
+
+  // The number of 'hold's without a 'release' yet, while which the
+  // batch of records does not get flushed.
+  size_t holds;
+
+  // The timers to check for ACKs of the updates forwarded in the
+  // current batch, by the duration of the timers.
+  map<Duration, Timeout> timers;
 };
 
 
+// Returns true if the checkpointed state of the task of the record
+// still exists, i.e., the executor has not been garbage collected.
+static bool checkpointed(
+    const string& metaDir,
+    const SlaveID& slaveId,
+    const StatusUpdateJournalRecord& record)
+{
+  return os::exists(paths::getTaskPath(
+      metaDir,
+      slaveId,
+      record.framework_id(),
+      record.executor_id(),
+      record.container_id(),
+      record.task_id()));
+}
+
+
 StatusUpdateManagerProcess::StatusUpdateManagerProcess(const Flags& _flags)
-  : flags(_flags), paused(false) {}
+  : flags(_flags), paused(false), holds(0) {}
 
 
 StatusUpdateManagerProcess::~StatusUpdateManagerProcess()
 {
+  flush();
+
   foreachkey (const FrameworkID& frameworkId, streams) {
     foreachvalue (StatusUpdateStream* stream, streams[frameworkId]) {
       delete stream;
     }
   }
   streams.clear();
+
+  foreachvalue (StatusUpdateJournal* journal, journals) {
+    delete journal;
+  }
+  journals.clear();
 }
 
 
@@ -250,9 +311,18 @@ Future<Nothing> StatusUpdateManagerProcess::recover(
         }
 
         // Create a new status update stream.
-        StatusUpdateStream* stream = createStatusUpdateStream(
+        Try<StatusUpdateStream*> stream_ = createStatusUpdateStream(
             task.id, framework.id, state.get().id, true, executor.id, latest);
 
+        if (stream_.isError()) {
+          return Failure(
+              "Failed to recover status updates for task " +
+              stringify(task.id) + " of framework " + stringify(framework.id) +
+              ": " + stream_.error());
+        }
+
+        StatusUpdateStream* stream = stream_.get();
+
         // Replay the stream.
         Try<Nothing> replay = stream->replay(task.updates, task.acks);
         if (replay.isError()) {
@@ -323,8 +393,14 @@ Future<Nothing> StatusUpdateManagerProcess::_update(
   // Create/Get the status update stream for this task.
   StatusUpdateStream* stream = getStatusUpdateStream(taskId, frameworkId);
   if (stream == NULL) {
-    stream = createStatusUpdateStream(
+    Try<StatusUpdateStream*> created = createStatusUpdateStream(
         taskId, frameworkId, slaveId, checkpoint, executorId, containerId);
+
+    if (created.isError()) {
+      return Failure(created.error());
+    }
+
+    stream = created.get();
   }
 
   // Verify that we didn't get a non-checkpointable update for a
@@ -343,9 +419,9 @@ Future<Nothing> StatusUpdateManagerProcess::_update(
   }
 
   // We don't return a failed future here so that the slave can re-ack
-  // the duplicate update.
+  // the duplicate update, once the original is on disk.
   if (!result.get()) {
-    return Nothing();
+    return flushed();
   }
 
   // Forward the status update to the master if this is the first in the stream.
@@ -361,7 +437,9 @@ Future<Nothing> StatusUpdateManagerProcess::_update(
     stream->timeout = forward(next.get(), STATUS_UPDATE_RETRY_INTERVAL_MIN);
   }
 
-  return Nothing();
+  // The slave acknowledges the update to the executor once it is
+  // checkpointed, i.e., once the batch it was appended to is flushed.
+  return flushed();
 }
 
 
@@ -376,11 +454,29 @@ Timeout StatusUpdateManagerProcess::forward(
   // Forward the update.
   forward_(update);
 
-  // Send a message to self to resend after some delay if no ACK is received.
-  return delay(duration,
-               self(),
-               &StatusUpdateManagerProcess::timeout,
-               duration).timeout();
+  // Send a message to self to resend after some delay if no ACK is
+  // received. The updates forwarded while the manager processes the
+  // events that are already queued, e.g., the acknowledgements that
+  // the master sent in one message, share the message, rather than
+  // each of the updates having its own timer.
+  if (!timers.count(duration)) {
+    if (timers.empty()) {
+      dispatch(self(), &StatusUpdateManagerProcess::_forward);
+    }
+
+    timers[duration] = delay(duration,
+                             self(),
+                             &StatusUpdateManagerProcess::timeout,
+                             duration).timeout();
+  }
+
+  return timers[duration];
+}
+
+
+void StatusUpdateManagerProcess::_forward()
+{
+  timers.clear();
 }
 
 
@@ -453,7 +549,8 @@ Future<bool> StatusUpdateManagerProcess::acknowledgement(
     stream->timeout = forward(next.get(), STATUS_UPDATE_RETRY_INTERVAL_MIN);
   }
 
-  return !terminated;
+  return flushed()
+    .then([terminated]() { return !terminated; });
 }
 
 
@@ -486,7 +583,100 @@ void StatusUpdateManagerProcess::timeout(const Duration& duration)
 }
 
 
-StatusUpdateStream* StatusUpdateManagerProcess::createStatusUpdateStream(
+Future<Nothing> StatusUpdateManagerProcess::flushed()
+{
+  if (flushing.isNone()) {
+    bool empty = true;
+    foreachvalue (StatusUpdateJournal* journal, journals) {
+      empty = empty && journal->empty();
+    }
+
+    if (empty) {
+      return Nothing();
+    }
+
+    flushing = Owned<Promise<Nothing> >(new Promise<Nothing>());
+
+    // The updates and acknowledgements that are already queued for
+    // this process get appended before the flush. While held, the
+    // last 'release' flushes instead.
+    if (holds == 0) {
+      dispatch(self(), &StatusUpdateManagerProcess::flush);
+    }
+  }
+
+  return flushing.get()->future();
+}
+
+
+void StatusUpdateManagerProcess::hold()
+{
+  holds++;
+}
+
+
+void StatusUpdateManagerProcess::release()
+{
+  CHECK_GT(holds, 0u);
+
+  if (--holds == 0) {
+    flush();
+  }
+}
+
+
+void StatusUpdateManagerProcess::flush()
+{
+  if (flushing.isNone()) {
+    return; // Flushed by a compaction already.
+  }
+
+  Owned<Promise<Nothing> > promise = flushing.get();
+  flushing = None();
+
+  foreachvalue (StatusUpdateJournal* journal, journals) {
+    Try<Nothing> flush = journal->flush();
+    if (flush.isError()) {
+      promise->fail(flush.error());
+      return;
+    }
+  }
+
+  promise->set(Nothing());
+}
+
+
+void StatusUpdateManagerProcess::compact()
+{
+  flush();
+
+  const string metaDir = paths::getMetaRootDir(flags.work_dir);
+
+  foreachpair (const SlaveID& slaveId,
+               StatusUpdateJournal* journal,
+               journals) {
+    // We skip the journals that did not change since their last
+    // compaction, which are those of idle slaves.
+    if (!journal->appended()) {
+      continue;
+    }
+
+    Try<Nothing> compact = journal->compact(
+        lambda::bind(&checkpointed, metaDir, slaveId, lambda::_1));
+
+    if (compact.isError()) {
+      LOG(ERROR) << "Failed to compact the status updates journal of slave "
+                 << slaveId << ": " << compact.error();
+    }
+  }
+
+  delay(STATUS_UPDATE_JOURNAL_COMPACTION_INTERVAL,
+        self(),
+        &StatusUpdateManagerProcess::compact);
+}
+
+
+Try<StatusUpdateStream*> StatusUpdateManagerProcess::createStatusUpdateStream(
     const TaskID& taskId,
     const FrameworkID& frameworkId,
     const SlaveID& slaveId,
@@ -497,8 +687,40 @@ StatusUpdateStream* StatusUpdateManagerProcess::createStatusUpdateStream(
   VLOG(1) << "Creating StatusUpdate stream for task " << taskId
           << " of framework " << frameworkId;
 
+  StatusUpdateJournal* journal = NULL;
+
+  if (checkpoint) {
+    if (!journals.contains(slaveId)) {
+      const string path = paths::getTaskUpdatesJournalPath(
+          paths::getMetaRootDir(flags.work_dir), slaveId);
+
+      Try<StatusUpdateJournal*> open = StatusUpdateJournal::open(path);
+      if (open.isError()) {
+        return Error(
+            "Failed to open the status updates journal: " + open.error());
+      }
+
+      if (journals.empty()) {
+        delay(STATUS_UPDATE_JOURNAL_COMPACTION_INTERVAL,
+              self(),
+              &StatusUpdateManagerProcess::compact);
+      }
+
+      journals[slaveId] = open.get();
+    }
+
+    journal = journals[slaveId];
+  }
+
   StatusUpdateStream* stream = new StatusUpdateStream(
-      taskId, frameworkId, slaveId, flags, checkpoint, executorId, containerId);
+      taskId,
+      frameworkId,
+      slaveId,
+      flags,
+      checkpoint,
+      executorId,
+      containerId,
+      journal);
 
   streams[frameworkId][taskId] = stream;
   return stream;
@@ -631,76 +853,245 @@ void StatusUpdateManager::resume()
 }
 
 
+void StatusUpdateManager::hold()
+{
+  dispatch(process, &StatusUpdateManagerProcess::hold);
+}
+
+
+void StatusUpdateManager::release()
+{
+  dispatch(process, &StatusUpdateManagerProcess::release);
+}
+
+
 void StatusUpdateManager::cleanup(const FrameworkID& frameworkId)
 {
   dispatch(process, &StatusUpdateManagerProcess::cleanup, frameworkId);
 }
 
 
+StatusUpdateJournal::StatusUpdateJournal(const string& _path, int _fd)
+  : path(_path),
+    fd(_fd),
+    appended_(false) {}
+
+
+Try<StatusUpdateJournal*> StatusUpdateJournal::open(const string& path)
+{
+  // Create the directory of the journal, if it doesn't exist.
+  Try<Nothing> directory = os::mkdir(Path(path).dirname());
+  if (directory.isError()) {
+    return Error(
+        "Failed to create '" + Path(path).dirname() + "': " +
+        directory.error());
+  }
+
+  Try<int> fd = os::open(
+      path,
+      O_CREAT | O_WRONLY | O_APPEND | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  if (fd.isError()) {
+    return Error("Failed to open '" + path + "': " + fd.error());
+  }
+
+  return new StatusUpdateJournal(path, fd.get());
+}
+
+
+StatusUpdateJournal::~StatusUpdateJournal()
+{
+  if (!buffer.empty()) {
+    LOG(WARNING) << "Dropping status update records that were not written to '"
+                 << path << "'";
+  }
+
+  Try<Nothing> close = os::close(fd);
+  if (close.isError()) {
+    LOG(ERROR) << "Failed to close file '" << path << "': " << close.error();
+  }
+}
+
+
+Try<Nothing> StatusUpdateJournal::append(
+    const StatusUpdateJournalRecord& record)
+{
+  if (error.isSome()) {
+    return Error(error.get());
+  }
+
+  if (!record.IsInitialized()) {
+    return Error(record.InitializationErrorString() +
+                 " is required but not initialized");
+  }
+
+  // The same format as '::protobuf::write', the recovery reads the
+  // records with '::protobuf::read'.
+  uint32_t size = record.ByteSize();
+  buffer.append((char*) &size, sizeof(size));
+
+  if (!record.AppendToString(&buffer)) {
+    return Error("Failed to serialize the record");
+  }
+
+  return Nothing();
+}
+
+
+Try<Nothing> StatusUpdateJournal::flush()
+{
+  if (error.isSome()) {
+    return Error(error.get());
+  } else if (buffer.empty()) {
+    return Nothing();
+  }
+
+  // A failed write may have left a partial record in the journal,
+  // which the recovery truncates, so we don't append after it.
+  Try<Nothing> write = os::write(fd, buffer);
+  if (write.isError()) {
+    error = "Failed to write to '" + path + "': " + write.error();
+    return Error(error.get());
+  }
+
+  if (::fsync(fd) < 0) {
+    error = ErrnoError("Failed to sync '" + path + "'").message;
+    return Error(error.get());
+  }
+
+  buffer.clear();
+  appended_ = true;
+
+  return Nothing();
+}
+
+
+Try<Nothing> StatusUpdateJournal::compact(
+    const lambda::function<bool(const StatusUpdateJournalRecord&)>& keep)
+{
+  if (error.isSome()) {
+    return Error(error.get());
+  }
+
+  CHECK(buffer.empty());
+
+  Try<int> in = os::open(path, O_RDONLY | O_CLOEXEC);
+  if (in.isError()) {
+    return Error("Failed to open '" + path + "': " + in.error());
+  }
+
+  // We write the compacted journal next to the journal and then
+  // rename it, so that a crash leaves one of them in place.
+  const string temporary = path + ".compacted";
+
+  Try<int> out = os::open(
+      temporary,
+      O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  if (out.isError()) {
+    os::close(in.get());
+    return Error("Failed to open '" + temporary + "': " + out.error());
+  }
+
+  size_t kept = 0;
+  size_t dropped = 0;
+
+  Result<StatusUpdateJournalRecord> record = None();
+  while (true) {
+    record = ::protobuf::read<StatusUpdateJournalRecord>(in.get());
+
+    if (!record.isSome()) {
+      break;
+    }
+
+    if (!keep(record.get())) {
+      dropped++;
+      continue;
+    }
+
+    Try<Nothing> write = ::protobuf::write(out.get(), record.get());
+    if (write.isError()) {
+      os::close(in.get());
+      os::close(out.get());
+      return Error(
+          "Failed to write to '" + temporary + "': " + write.error());
+    }
+
+    kept++;
+  }
+
+  os::close(in.get());
+
+  if (record.isError()) {
+    os::close(out.get());
+    return Error("Failed to read '" + path + "': " + record.error());
+  }
+
+  if (::fsync(out.get()) < 0) {
+    ErrnoError error("Failed to sync '" + temporary + "'");
+    os::close(out.get());
+    return error;
+  }
+
+  os::close(out.get());
+
+  Try<Nothing> rename = os::rename(temporary, path);
+  if (rename.isError()) {
+    return Error(
+        "Failed to rename '" + temporary + "' to '" + path + "': " +
+        rename.error());
+  }
+
+  // The next records get appended to the compacted journal.
+  Try<int> fd_ = os::open(path, O_WRONLY | O_APPEND | O_CLOEXEC);
+  if (fd_.isError()) {
+    error = "Failed to open '" + path + "': " + fd_.error();
+    return Error(error.get());
+  }
+
+  os::close(fd);
+  fd = fd_.get();
+
+  appended_ = false;
+
+  VLOG(1) << "Compacted status updates journal '" << path << "' to "
+          << kept << " records (dropped " << dropped << ")";
+
+  return Nothing();
+}
+
+
 StatusUpdateStream::StatusUpdateStream(
     const TaskID& _taskId,
     const FrameworkID& _frameworkId,
     const SlaveID& _slaveId,
     const Flags& _flags,
     bool _checkpoint,
-    const Option<ExecutorID>& executorId,
-    const Option<ContainerID>& containerId)
+    const Option<ExecutorID>& _executorId,
+    const Option<ContainerID>& _containerId,
+    StatusUpdateJournal* _journal)
     : checkpoint(_checkpoint),
       terminated(false),
       taskId(_taskId),
       frameworkId(_frameworkId),
       slaveId(_slaveId),
       flags(_flags),
+      executorId(_executorId),
+      containerId(_containerId),
+      journal(_journal),
       error(None())
 {
   if (checkpoint) {
     CHECK_SOME(executorId);
     CHECK_SOME(containerId);
-
-    path = paths::getTaskUpdatesPath(
-        paths::getMetaRootDir(flags.work_dir),
-        slaveId,
-        frameworkId,
-        executorId.get(),
-        containerId.get(),
-        taskId);
-
-    // Create the base updates directory, if it doesn't exist.
-    Try<Nothing> directory = os::mkdir(Path(path.get()).dirname());
-    if (directory.isError()) {
-      error = "Failed to create " + Path(path.get()).dirname();
-      return;
-    }
-
-    // Open the updates file.
-    Try<int> result = os::open(
-        path.get(),
-        O_CREAT | O_WRONLY | O_APPEND | O_SYNC | O_CLOEXEC,
-        S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
-
-    if (result.isError()) {
-      error = "Failed to open '" + path.get() + "' for status updates";
-      return;
-    }
-
-    // We keep the file open through the lifetime of the task, because it
-    // makes it easy to append status update records to the file.
-    fd = result.get();
+    CHECK_NOTNULL(journal);
   }
 }
 
 
-StatusUpdateStream::~StatusUpdateStream()
-{
-  if (fd.isSome()) {
-    Try<Nothing> close = os::close(fd.get());
-    if (close.isError()) {
-      CHECK_SOME(path);
-      LOG(ERROR) << "Failed to close file '" << path.get() << "': "
-                 << close.error();
-    }
-  }
-}
+StatusUpdateStream::~StatusUpdateStream() {}
 
 
 Try<bool> StatusUpdateStream::update(const StatusUpdate& update)
@@ -823,21 +1214,23 @@ Try<Nothing> StatusUpdateStream::handle(
   if (checkpoint) {
     LOG(INFO) << "Checkpointing " << type << " for status update " << update;
 
-    CHECK_SOME(fd);
-
-    StatusUpdateRecord record;
-    record.set_type(type);
+    StatusUpdateJournalRecord record;
+    record.mutable_framework_id()->CopyFrom(frameworkId);
+    record.mutable_executor_id()->CopyFrom(executorId.get());
+    record.mutable_container_id()->CopyFrom(containerId.get());
+    record.mutable_task_id()->CopyFrom(taskId);
+    record.mutable_record()->set_type(type);
 
     if (type == StatusUpdateRecord::UPDATE) {
-      record.mutable_update()->CopyFrom(update);
+      record.mutable_record()->mutable_update()->CopyFrom(update);
     } else {
-      record.set_uuid(update.uuid());
+      record.mutable_record()->set_uuid(update.uuid());
     }
 
-    Try<Nothing> write = ::protobuf::write(fd.get(), record);
-    if (write.isError()) {
-      error = "Failed to write status update " + stringify(update) +
-              " to '" + path.get() + "': " + write.error();
+    Try<Nothing> append = journal->append(record);
+    if (append.isError()) {
+      error = "Failed to checkpoint status update " + stringify(update) +
+              ": " + append.error();
       return Error(error.get());
     }
   }
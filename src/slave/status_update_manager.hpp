@@ -19,6 +19,7 @@
 
 #include <queue>
 #include <string>
+#include <vector>
 
 #include <mesos/mesos.hpp>
 
@@ -28,6 +29,7 @@
 
 #include <stout/hashset.hpp>
 #include <stout/lambda.hpp>
+#include <stout/nothing.hpp>
 #include <stout/option.hpp>
 #include <stout/try.hpp>
 #include <stout/uuid.hpp>
@@ -47,6 +49,7 @@ struct SlaveState;
 }
 
 class StatusUpdateManagerProcess;
+class StatusUpdateJournal;
 struct StatusUpdateStream;
 
 
@@ -114,6 +117,13 @@ public:
   // no master elected (e.g., during recovery) or framework failed over.
   void resume();
 
+  // Holds back checkpointing the updates and acknowledgements that
+  // follow until the matching 'release', so that they get written
+  // and synced to disk at once, e.g., for a batch of updates from an
+  // executor. Holds nest.
+  void hold();
+  void release();
+
   // Closes all the status update streams corresponding to this framework.
   // NOTE: This stops retrying any pending status updates for this framework.
   void cleanup(const FrameworkID& frameworkId);
@@ -123,6 +133,49 @@ private:
 };
 
 
+// The journal that the status updates and acknowledgements of all the
+// tasks of a slave are checkpointed to. The records are buffered and
+// then written and synced to disk in batches, and the journal gets
+// compacted to the records of the tasks whose checkpointed state still
+// exists. The 'task.updates' files of the tasks of older slaves are
+// still recovered (see slave/state.cpp).
+class StatusUpdateJournal
+{
+public:
+  static Try<StatusUpdateJournal*> open(const std::string& path);
+
+  ~StatusUpdateJournal();
+
+  // Buffers the record, which gets written by the next 'flush'.
+  Try<Nothing> append(const StatusUpdateJournalRecord& record);
+
+  // Writes the buffered records and syncs them to disk.
+  Try<Nothing> flush();
+
+  // Rewrites the journal with the records for which 'keep' is true,
+  // which requires the buffered records to have been flushed.
+  Try<Nothing> compact(
+      const lambda::function<bool(const StatusUpdateJournalRecord&)>& keep);
+
+  // Returns true if there are no buffered records.
+  bool empty() const { return buffer.empty(); }
+
+  // Returns true if records were written since the last compaction.
+  bool appended() const { return appended_; }
+
+private:
+  StatusUpdateJournal(const std::string& path, int fd);
+
+  const std::string path;
+  int fd;
+
+  std::string buffer; // The serialized records to be written.
+  bool appended_;
+
+  Option<std::string> error; // Potential non-retryable error.
+};
+
+
 // StatusUpdateStream handles the status updates and acknowledgements
 // of a task, checkpointing them if necessary. It also holds the information
 // about received, acknowledged and pending status updates.
@@ -136,8 +189,9 @@ struct StatusUpdateStream
                      const SlaveID& _slaveId,
                      const Flags& _flags,
                      bool _checkpoint,
-                     const Option<ExecutorID>& executorId,
-                     const Option<ContainerID>& containerId);
+                     const Option<ExecutorID>& _executorId,
+                     const Option<ContainerID>& _containerId,
+                     StatusUpdateJournal* _journal);
 
   ~StatusUpdateStream();
 
@@ -173,12 +227,8 @@ struct StatusUpdateStream
   std::queue<StatusUpdate> pending;
 
 private:
-  // Handles the status update and writes it to disk, if necessary.
-  // TODO(vinod): The write has to be asynchronous to avoid status updates that
-  // are being checkpointed, blocking the processing of other updates.
-  // One solution is to wrap the protobuf::write inside async, but its probably
-  // too much of an overhead to spin up a new libprocess per status update?
-  // A better solution might be to be have async write capability for file io.
+  // Handles the status update and appends it to the journal, if
+  // necessary. It is on disk once the journal gets flushed.
   Try<Nothing> handle(
       const StatusUpdate& update,
       const StatusUpdateRecord::Type& type);
@@ -193,11 +243,13 @@ private:
 
   const Flags flags;
 
+  const Option<ExecutorID> executorId;
+  const Option<ContainerID> containerId;
+
   hashset<UUID> received;
   hashset<UUID> acknowledged;
 
-  Option<std::string> path; // File path of the update stream.
-  Option<int> fd; // File descriptor to the update stream.
+  StatusUpdateJournal* journal; // Not owned, NULL unless checkpointing.
 
   Option<std::string> error; // Potential non-retryable error.
 };
@@ -21,7 +21,10 @@
 #include <list>
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include <process/clock.hpp>
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
@@ -51,7 +54,9 @@ using namespace process;
 // Note that we don't add 'using std::set' here because we need
 // 'std::' to disambiguate the 'set' member.
 using std::list;
+using std::pair;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -76,13 +81,19 @@ namespace state {
 class LogStorageProcess : public Process<LogStorageProcess>
 {
 public:
-  LogStorageProcess(Log* log, size_t diffsBetweenSnapshots);
+  LogStorageProcess(
+      Log* log,
+      size_t diffsBetweenSnapshots,
+      const Option<Duration>& lease,
+      bool compress);
 
   virtual ~LogStorageProcess();
 
   // Storage implementation.
   Future<Option<state::Entry> > get(const string& name);
+  Future<Option<state::Entry> > follow(const string& name);
   Future<bool> set(const state::Entry& entry, const UUID& uuid);
+  Future<bool> setAll(const vector<pair<state::Entry, UUID> >& entries);
   Future<bool> expunge(const state::Entry& entry);
   Future<std::set<string> > names();
 
@@ -90,12 +101,38 @@ protected:
   virtual void finalize();
 
 private:
+  // Starts the writer, or restarts it if the lease on the cache has
+  // expired, so that the cache can serve reads.
+  Future<Nothing> lookup();
+  Future<Nothing> _lookup();
+
+  // Returns true if the cache can no longer serve reads without
+  // restarting the writer.
+  bool expired() const;
+
+  // Reads and applies the entries that the replica of the log has
+  // learned since the last read, without starting the writer. This
+  // keeps the cache warm while another process writes the log, and
+  // so leaves only the tail of the log to read once we start.
+  Future<Nothing> catchup();
+  Future<Nothing> _catchup(const Log::Position& ending);
+  Future<Nothing> __catchup(
+      const Log::Position& beginning,
+      const Log::Position& ending);
+
   Future<Nothing> start();
   Future<Nothing> _start(const Option<Log::Position>& position);
   Future<Nothing> __start(
       const Log::Position& beginning,
       const Log::Position& position);
 
+  // Helper for reading and applying the log entries up to 'ending'
+  // that we have not read yet, given the current 'beginning' of the
+  // log.
+  Future<Nothing> read(
+      const Log::Position& beginning,
+      const Log::Position& ending);
+
   // Helper for applying log entries.
   Future<Nothing> apply(const list<Log::Entry>& entries);
 
@@ -116,6 +153,12 @@ private:
       size_t diff,
       Option<Log::Position> position);
 
+  Future<bool> _setAll(const vector<pair<state::Entry, UUID> >& entries);
+  Future<bool> __setAll(const vector<pair<state::Entry, UUID> >& entries);
+  Future<bool> ___setAll(
+      const vector<pair<state::Entry, UUID> >& entries,
+      const Option<Log::Position>& position);
+
   Future<bool> _expunge(const state::Entry& entry);
   Future<bool> __expunge(const state::Entry& entry);
   Future<bool> ___expunge(
@@ -129,12 +172,21 @@ private:
 
   const size_t diffsBetweenSnapshots;
 
+  const Option<Duration> lease;
+
+  // When the writer was last known to hold the promise of the log,
+  // i.e., when it got elected or when its last write succeeded.
+  Option<Time> renewed;
+
   // Used to serialize Log::Writer::append/truncate operations.
   Mutex mutex;
 
   // Whether or not we've started the ability to append to log.
   Option<Future<Nothing> > starting;
 
+  // The last catch up with the log, if any, see 'catchup()'.
+  Option<Future<Nothing> > catching;
+
   // Last position in the log that we've read or written.
   Option<Log::Position> index;
 
@@ -214,10 +266,15 @@ private:
 };
 
 
-LogStorageProcess::LogStorageProcess(Log* log, size_t diffsBetweenSnapshots)
+LogStorageProcess::LogStorageProcess(
+    Log* log,
+    size_t diffsBetweenSnapshots,
+    const Option<Duration>& lease,
+    bool compress)
   : reader(log),
-    writer(log),
-    diffsBetweenSnapshots(diffsBetweenSnapshots) {}
+    writer(log, 1, compress),
+    diffsBetweenSnapshots(diffsBetweenSnapshots),
+    lease(lease) {}
 
 
 LogStorageProcess::~LogStorageProcess() {}
@@ -231,6 +288,88 @@ void LogStorageProcess::finalize()
 }
 
 
+Future<Nothing> LogStorageProcess::lookup()
+{
+  if (!expired()) {
+    return start();
+  }
+
+  // Restarting the writer demotes the current one, so we wait for the
+  // operations in progress to finish first.
+  return mutex.lock()
+    .then(defer(self(), &Self::_lookup))
+    .onAny(lambda::bind(&Mutex::unlock, mutex));
+}
+
+
+Future<Nothing> LogStorageProcess::_lookup()
+{
+  // Only restart a writer that started already, and whose lease did
+  // not get renewed while we waited for the mutex.
+  if (starting.isSome() && starting.get().isReady() && expired()) {
+    VLOG(2) << "Lease on the cache expired, restarting the writer";
+
+    starting = None();
+  }
+
+  return start();
+}
+
+
+bool LogStorageProcess::expired() const
+{
+  if (lease.isNone()) {
+    return false;
+  }
+
+  return renewed.isNone() || Clock::now() - renewed.get() >= lease.get();
+}
+
+
+Future<Nothing> LogStorageProcess::catchup()
+{
+  // Once started, the writer keeps the cache up to date itself.
+  if (starting.isSome()) {
+    return Nothing();
+  }
+
+  if (catching.isSome() && catching.get().isPending()) {
+    return catching.get();
+  }
+
+  VLOG(2) << "Catching up with the log";
+
+  catching = reader.ending()
+    .then(defer(self(), &Self::_catchup, lambda::_1));
+
+  return catching.get();
+}
+
+
+Future<Nothing> LogStorageProcess::_catchup(const Log::Position& ending)
+{
+  // NOTE: The entries at the end of the replica might not be learned
+  // yet, in which case the read fails and the next catch up retries
+  // from wherever we got to.
+  if (index.isSome() && ending <= index.get()) {
+    return Nothing();
+  }
+
+  // We get the beginning of the log even if we have read it before
+  // since the writer might have truncated it since then.
+  return reader.beginning()
+    .then(defer(self(), &Self::__catchup, lambda::_1, ending));
+}
+
+
+Future<Nothing> LogStorageProcess::__catchup(
+    const Log::Position& beginning,
+    const Log::Position& ending)
+{
+  return read(beginning, ending);
+}
+
+
 Future<Nothing> LogStorageProcess::start()
 {
   if (starting.isSome()) {
@@ -239,7 +378,17 @@ Future<Nothing> LogStorageProcess::start()
 
   VLOG(2) << "Starting the writer";
 
-  starting = writer.start()
+  // Wait for a catch up in progress to finish first so that only one
+  // read applies entries to the cache at a time. A failed catch up
+  // does not matter since we read from 'index' onwards anyway.
+  Future<Nothing> caughtUp = Nothing();
+  if (catching.isSome()) {
+    caughtUp = catching.get()
+      .repair([](const Future<Nothing>&) { return Nothing(); });
+  }
+
+  starting = caughtUp
+    .then(defer(self(), [this]() { return writer.start(); }))
     .then(defer(self(), &Self::_start, lambda::_1));
 
   return starting.get();
@@ -258,28 +407,22 @@ Future<Nothing> LogStorageProcess::_start(
     return start(); // TODO(benh): Don't try again forever?
   }
 
+  renewed = Clock::now();
+
   VLOG(2) << "Writer got elected at position "
           << position.get().identity();
 
   // Now read and apply log entries. Since 'start' can be called
   // multiple times (i.e., since we reset 'starting' after getting a
-  // None position returned after 'set', 'expunge', etc) we need to
-  // check and see if we've already successfully read the log at least
-  // once by checking 'index'. If we haven't yet read the log (i.e.,
-  // this is the first call to 'start' and 'index' is None) then we
-  // get the beginning of the log first so we can read from that up to
-  // what ever position was known at the time we started the
-  // writer. Note that it should always be safe to read a truncated
-  // entry since a subsequent operation in the log should invalidate
-  // that entry when we read it instead.
-  if (index.isSome()) {
-    // If we've started before (i.e., have an 'index' position) we
-    // should also expect to know the last 'truncated' position.
-    CHECK_SOME(truncated);
-    return reader.read(index.get(), position.get())
-      .then(defer(self(), &Self::apply, lambda::_1));
-  }
-
+  // None position returned after 'set', 'expunge', etc) and since we
+  // might have caught up with the log before, we might have read some
+  // of the log already (see 'index'). Either way we get the beginning
+  // of the log first, as the previous writer might have truncated the
+  // log past what we have read, and then read up to what ever
+  // position was known at the time we started the writer. Note that
+  // it should always be safe to read a truncated entry since a
+  // subsequent operation in the log should invalidate that entry
+  // when we read it instead.
   return reader.beginning()
     .then(defer(self(), &Self::__start, lambda::_1, position.get()));
 }
@@ -291,10 +434,40 @@ Future<Nothing> LogStorageProcess::__start(
 {
   CHECK_SOME(starting);
 
-  truncated = beginning; // Cache for future truncations.
+  return read(beginning, position);
+}
+
+
+Future<Nothing> LogStorageProcess::read(
+    const Log::Position& beginning,
+    const Log::Position& ending)
+{
+  // The replica fails to read the truncated entries, so we read from
+  // the beginning of the log if the writer truncated it past 'index'.
+  // The truncated entries include any expunges that we have not read
+  // yet, so we rebuild the cache from scratch in that case. This is
+  // safe since the writer only truncates the log up to the oldest
+  // snapshot of the entries that are still set.
+  Log::Position from = beginning;
 
-  return reader.read(beginning, position)
-    .then(defer(self(), &Self::apply, lambda::_1));
+  if (index.isSome()) {
+    if (index.get() < beginning) {
+      VLOG(2) << "Log got truncated past the cache, rebuilding the cache";
+
+      snapshots.clear();
+    } else {
+      from = index.get();
+    }
+  }
+
+  truncated = max(truncated, beginning); // Cache for future truncations.
+
+  // Read and apply the entries in batches so that we don't need to
+  // keep the whole log in memory.
+  return reader.read(
+      from,
+      ending,
+      defer(self(), &Self::apply, lambda::_1));
 }
 
 
@@ -351,6 +524,16 @@ Future<Nothing> LogStorageProcess::apply(const list<Log::Entry>& entries)
           break;
         }
 
+        case Operation::BATCH: {
+          CHECK(operation.has_batch());
+
+          // Add or update (override) the snapshot of each entry.
+          foreach (const state::Entry& batched, operation.batch().entries()) {
+            snapshots.put(batched.name(), Snapshot(entry.position, batched));
+          }
+          break;
+        }
+
         default:
           return Failure("Unknown operation: " + stringify(operation.type()));
       }
@@ -425,6 +608,7 @@ Future<Nothing> LogStorageProcess::__truncate(
   if (position.isSome()) {
     truncated = max(truncated, minimum);
     index = max(index, position);
+    renewed = Clock::now();
   }
 
   return Nothing();
@@ -433,7 +617,14 @@ Future<Nothing> LogStorageProcess::__truncate(
 
 Future<Option<state::Entry> > LogStorageProcess::get(const string& name)
 {
-  return start()
+  return lookup()
+    .then(defer(self(), &Self::_get, name));
+}
+
+
+Future<Option<state::Entry> > LogStorageProcess::follow(const string& name)
+{
+  return catchup()
     .then(defer(self(), &Self::_get, name));
 }
 
@@ -550,6 +741,8 @@ Future<bool> LogStorageProcess::___set(
     return false;
   }
 
+  renewed = Clock::now();
+
   // Update index so we don't bother reading anything before this
   // position again (if we don't have to).
   index = max(index, position);
@@ -573,6 +766,83 @@ Future<bool> LogStorageProcess::___set(
 }
 
 
+Future<bool> LogStorageProcess::setAll(
+    const vector<pair<state::Entry, UUID> >& entries)
+{
+  return mutex.lock()
+    .then(defer(self(), &Self::_setAll, entries))
+    .onAny(lambda::bind(&Mutex::unlock, mutex));
+}
+
+
+Future<bool> LogStorageProcess::_setAll(
+    const vector<pair<state::Entry, UUID> >& entries)
+{
+  return start()
+    .then(defer(self(), &Self::__setAll, entries));
+}
+
+
+Future<bool> LogStorageProcess::__setAll(
+    const vector<pair<state::Entry, UUID> >& entries)
+{
+  typedef pair<state::Entry, UUID> EntryAndUUID;
+
+  // Write the entries as whole snapshots in a single operation, so
+  // that readers of the log either apply all of them or none.
+  Operation operation;
+  operation.set_type(Operation::BATCH);
+
+  foreach (const EntryAndUUID& entry, entries) {
+    Option<Snapshot> snapshot = snapshots.get(entry.first.name());
+
+    // Check the version first (if we've already got a snapshot).
+    if (snapshot.isSome() &&
+        UUID::fromBytes(snapshot.get().entry.uuid()) != entry.second) {
+      return false;
+    }
+
+    operation.mutable_batch()->add_entries()->CopyFrom(entry.first);
+  }
+
+  string value;
+  if (!operation.SerializeToString(&value)) {
+    return Failure("Failed to serialize BATCH Operation");
+  }
+
+  return writer.append(value)
+    .then(defer(self(), &Self::___setAll, entries, lambda::_1));
+}
+
+
+Future<bool> LogStorageProcess::___setAll(
+    const vector<pair<state::Entry, UUID> >& entries,
+    const Option<Log::Position>& position)
+{
+  if (position.isNone()) {
+    starting = None(); // Reset 'starting' so we try again.
+    return false;
+  }
+
+  renewed = Clock::now();
+
+  // Update index so we don't bother reading anything before this
+  // position again (if we don't have to).
+  index = max(index, position);
+
+  typedef pair<state::Entry, UUID> EntryAndUUID;
+
+  foreach (const EntryAndUUID& entry, entries) {
+    snapshots.put(entry.first.name(), Snapshot(position.get(), entry.first));
+  }
+
+  // And truncate the log if necessary.
+  truncate();
+
+  return true;
+}
+
+
 Future<bool> LogStorageProcess::expunge(const state::Entry& entry)
 {
   return mutex.lock()
@@ -626,6 +896,8 @@ Future<bool> LogStorageProcess::___expunge(
     return false;
   }
 
+  renewed = Clock::now();
+
   // Remove from snapshots and truncate the log if possible.
   CHECK(snapshots.contains(entry.name()));
   snapshots.erase(entry.name());
@@ -637,7 +909,7 @@ Future<bool> LogStorageProcess::___expunge(
 
 Future<std::set<string> > LogStorageProcess::names()
 {
-  return start()
+  return lookup()
     .then(defer(self(), &Self::_names));
 }
 
@@ -649,9 +921,14 @@ Future<std::set<string> > LogStorageProcess::_names()
 }
 
 
-LogStorage::LogStorage(Log* log, size_t diffsBetweenSnapshots)
+LogStorage::LogStorage(
+    Log* log,
+    size_t diffsBetweenSnapshots,
+    const Option<Duration>& lease,
+    bool compress)
 {
-  process = new LogStorageProcess(log, diffsBetweenSnapshots);
+  process =
+    new LogStorageProcess(log, diffsBetweenSnapshots, lease, compress);
   spawn(process);
 }
 
@@ -670,12 +947,25 @@ Future<Option<state::Entry> > LogStorage::get(const string& name)
 }
 
 
+Future<Option<state::Entry> > LogStorage::follow(const string& name)
+{
+  return dispatch(process, &LogStorageProcess::follow, name);
+}
+
+
 Future<bool> LogStorage::set(const state::Entry& entry, const UUID& uuid)
 {
   return dispatch(process, &LogStorageProcess::set, entry, uuid);
 }
 
 
+Future<bool> LogStorage::set(
+    const vector<pair<state::Entry, UUID> >& entries)
+{
+  return dispatch(process, &LogStorageProcess::setAll, entries);
+}
+
+
 Future<bool> LogStorage::expunge(const state::Entry& entry)
 {
   return dispatch(process, &LogStorageProcess::expunge, entry);
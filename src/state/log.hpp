@@ -19,9 +19,12 @@
 
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <process/future.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/option.hpp>
 #include <stout/uuid.hpp>
 
@@ -42,13 +45,34 @@ class LogStorageProcess;
 class LogStorage : public Storage
 {
 public:
-  LogStorage(log::Log* log, size_t diffsBetweenSnapshots = 0);
+  // The entries are read from a cache that is kept up to date with
+  // the log while this storage holds the promise to write the log. If
+  // a 'lease' is given, the cache only serves reads for that long
+  // after the promise was last known to be held, i.e., after the last
+  // write. The next read then restarts the writer and reads the tail
+  // of the log. Otherwise, the cache serves reads until a write fails
+  // because another writer got the promise.
+  //
+  // Following the storage catches the cache up with the entries that
+  // the local replica learned from another writer, without starting
+  // the writer, so that starting it later only reads what is left.
+  //
+  // If 'compress' is set the entries are compressed in the log, see
+  // 'log::Log::Writer'.
+  LogStorage(
+      log::Log* log,
+      size_t diffsBetweenSnapshots = 0,
+      const Option<Duration>& lease = None(),
+      bool compress = false);
 
   virtual ~LogStorage();
 
   // Storage implementation.
   virtual process::Future<Option<Entry> > get(const std::string& name);
+  virtual process::Future<Option<Entry> > follow(const std::string& name);
   virtual process::Future<bool> set(const Entry& entry, const UUID& uuid);
+  virtual process::Future<bool> set(
+      const std::vector<std::pair<Entry, UUID> >& entries);
   virtual process::Future<bool> expunge(const Entry& entry);
   virtual process::Future<std::set<std::string> > names();
 
@@ -18,10 +18,12 @@
 #define __STATE_PROTOBUF_HPP__
 
 #include <string>
+#include <vector>
 
 #include <process/future.hpp>
 
 #include <stout/lambda.hpp>
+#include <stout/none.hpp>
 #include <stout/option.hpp>
 #include <stout/some.hpp>
 #include <stout/try.hpp>
@@ -80,12 +82,36 @@ public:
   template <typename T>
   process::Future<Variable<T> > fetch(const std::string& name);
 
+  // Like 'fetch', but reuses the value of 'cached' rather than
+  // deserializing the variable again if it still has the version of
+  // 'cached', i.e., if it was not stored since.
+  template <typename T>
+  process::Future<Variable<T> > fetch(
+      const std::string& name,
+      const Option<Variable<T> >& cached);
+
+  // Returns a possibly stale variable from the state without
+  // interfering with whoever stores the state, reusing the value of
+  // 'cached' like 'fetch' does. See Storage::follow.
+  template <typename T>
+  process::Future<Variable<T> > follow(
+      const std::string& name,
+      const Option<Variable<T> >& cached = None());
+
   // Returns the variable specified if it was successfully stored in
   // the state, otherwise returns none if the version of the variable
   // was no longer valid, or an error if one occurs.
   template <typename T>
   process::Future<Option<Variable<T> > > store(const Variable<T>& variable);
 
+  // Returns the variables specified if all of them were successfully
+  // stored in the state at once, otherwise returns none if the
+  // version of any of the variables was no longer valid (in which
+  // case none of them were stored), or an error if one occurs.
+  template <typename T>
+  process::Future<Option<std::vector<Variable<T> > > > store(
+      const std::vector<Variable<T> >& variables);
+
   // Expunges the variable from the state.
   template <typename T>
   process::Future<bool> expunge(const Variable<T>& variable);
@@ -96,27 +122,57 @@ private:
   // constructor.
   template <typename T>
   static process::Future<Variable<T> > _fetch(
-      const state::Variable& option);
+      const state::Variable& option,
+      const Option<Variable<T> >& cached);
 
   template <typename T>
   static process::Future<Option<Variable<T> > > _store(
       const T& t,
       const Option<state::Variable>& variable);
+
+  template <typename T>
+  static process::Future<Option<std::vector<Variable<T> > > > _storeAll(
+      const std::vector<T>& ts,
+      const Option<std::vector<state::Variable> >& variables);
 };
 
 
 template <typename T>
 process::Future<Variable<T> > State::fetch(const std::string& name)
+{
+  return fetch<T>(name, None());
+}
+
+
+template <typename T>
+process::Future<Variable<T> > State::fetch(
+    const std::string& name,
+    const Option<Variable<T> >& cached)
 {
   return state::State::fetch(name)
-    .then(lambda::bind(&State::template _fetch<T>, lambda::_1));
+    .then(lambda::bind(&State::template _fetch<T>, lambda::_1, cached));
+}
+
+
+template <typename T>
+process::Future<Variable<T> > State::follow(
+    const std::string& name,
+    const Option<Variable<T> >& cached)
+{
+  return state::State::follow(name)
+    .then(lambda::bind(&State::template _fetch<T>, lambda::_1, cached));
 }
 
 
 template <typename T>
 process::Future<Variable<T> > State::_fetch(
-    const state::Variable& variable)
+    const state::Variable& variable,
+    const Option<Variable<T> >& cached)
 {
+  if (cached.isSome() && cached.get().variable.uuid() == variable.uuid()) {
+    return Variable<T>(variable, cached.get().t);
+  }
+
   Try<T> t = messages::deserialize<T>(variable.value());
   if (t.isError()) {
     return process::Failure(t.error());
@@ -154,6 +210,50 @@ process::Future<Option<Variable<T> > > State::_store(
 }
 
 
+template <typename T>
+process::Future<Option<std::vector<Variable<T> > > > State::store(
+    const std::vector<Variable<T> >& variables)
+{
+  std::vector<state::Variable> mutated;
+  std::vector<T> ts;
+
+  for (size_t i = 0; i < variables.size(); i++) {
+    Try<std::string> value = messages::serialize(variables[i].t);
+
+    if (value.isError()) {
+      return process::Failure(value.error());
+    }
+
+    mutated.push_back(variables[i].variable.mutate(value.get()));
+    ts.push_back(variables[i].t);
+  }
+
+  return state::State::store(mutated)
+    .then(lambda::bind(&State::template _storeAll<T>, ts, lambda::_1));
+}
+
+
+template <typename T>
+process::Future<Option<std::vector<Variable<T> > > > State::_storeAll(
+    const std::vector<T>& ts,
+    const Option<std::vector<state::Variable> >& variables)
+{
+  if (variables.isNone()) {
+    return None();
+  }
+
+  CHECK_EQ(ts.size(), variables.get().size());
+
+  std::vector<Variable<T> > result;
+
+  for (size_t i = 0; i < ts.size(); i++) {
+    result.push_back(Variable<T>(variables.get()[i], ts[i]));
+  }
+
+  return Some(result);
+}
+
+
 template <typename T>
 process::Future<bool> State::expunge(const Variable<T>& variable)
 {
@@ -19,10 +19,13 @@
 
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <process/deferred.hpp> // TODO(benh): This is required by Clang.
 #include <process/future.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
 #include <stout/none.hpp>
 #include <stout/option.hpp>
@@ -79,6 +82,13 @@ public:
     return variable;
   }
 
+  // Returns the version of the variable, which changes whenever the
+  // variable gets stored.
+  UUID uuid() const
+  {
+    return UUID::fromBytes(entry.uuid());
+  }
+
 private:
   friend class State; // Creates and manages variables.
 
@@ -100,11 +110,22 @@ public:
   // previously did not exist (or an error if one occurs).
   process::Future<Variable> fetch(const std::string& name);
 
+  // Returns a possibly stale variable from the state without
+  // interfering with whoever stores the state, see Storage::follow.
+  process::Future<Variable> follow(const std::string& name);
+
   // Returns the variable specified if it was successfully stored in
   // the state, otherwise returns none if the version of the variable
   // was no longer valid, or an error if one occurs.
   process::Future<Option<Variable> > store(const Variable& variable);
 
+  // Returns the variables specified if all of them were successfully
+  // stored in the state at once, otherwise returns none if the
+  // version of any of the variables was no longer valid (in which
+  // case none of them were stored), or an error if one occurs.
+  process::Future<Option<std::vector<Variable> > > store(
+      const std::vector<Variable>& variables);
+
   // Returns true if successfully expunged the variable from the state.
   process::Future<bool> expunge(const Variable& variable);
 
@@ -123,6 +144,10 @@ private:
       const Entry& entry,
       const bool& b); // TODO(benh): Remove 'const &' after fixing libprocess.
 
+  static process::Future<Option<std::vector<Variable> > > _storeAll(
+      const std::vector<std::pair<Entry, UUID> >& entries,
+      const bool& b); // TODO(benh): Remove 'const &' after fixing libprocess.
+
   Storage* storage;
 };
 
@@ -134,6 +159,13 @@ inline process::Future<Variable> State::fetch(const std::string& name)
 }
 
 
+inline process::Future<Variable> State::follow(const std::string& name)
+{
+  return storage->follow(name)
+    .then(lambda::bind(&State::_fetch, name, lambda::_1));
+}
+
+
 inline process::Future<Variable> State::_fetch(
     const std::string& name,
     const Option<Entry>& option)
@@ -181,6 +213,47 @@ inline process::Future<Option<Variable > > State::_store(
 }
 
 
+inline process::Future<Option<std::vector<Variable> > > State::store(
+    const std::vector<Variable>& variables)
+{
+  std::vector<std::pair<Entry, UUID> > entries;
+
+  foreach (const Variable& variable, variables) {
+    // Like for a single variable, we replace each entry provided its
+    // UUID matches.
+    Entry entry;
+    entry.set_name(variable.entry.name());
+    entry.set_uuid(UUID::random().toBytes());
+    entry.set_value(variable.entry.value());
+
+    entries.push_back(
+        std::make_pair(entry, UUID::fromBytes(variable.entry.uuid())));
+  }
+
+  return storage->set(entries)
+    .then(lambda::bind(&State::_storeAll, entries, lambda::_1));
+}
+
+
+inline process::Future<Option<std::vector<Variable> > > State::_storeAll(
+    const std::vector<std::pair<Entry, UUID> >& entries,
+    const bool& b) // TODO(benh): Remove 'const &' after fixing libprocess.
+{
+  if (!b) {
+    return None();
+  }
+
+  std::vector<Variable> variables;
+  variables.reserve(entries.size());
+
+  for (size_t i = 0; i < entries.size(); i++) {
+    variables.push_back(Variable(entries[i].first));
+  }
+
+  return Some(variables);
+}
+
+
 inline process::Future<bool> State::expunge(const Variable& variable)
 {
   return storage->expunge(variable.entry);
@@ -19,6 +19,8 @@
 
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <process/future.hpp>
 
@@ -44,6 +46,20 @@ public:
   virtual process::Future<Option<Entry> > get(const std::string& name) = 0;
   virtual process::Future<bool> set(const Entry& entry, const UUID& uuid) = 0;
 
+  // Gets a possibly stale state entry without interfering with whoever
+  // writes the state, e.g., so that a standby can keep a warm copy of
+  // it. Storages that read without taking over the writes just 'get'.
+  virtual process::Future<Option<Entry> > follow(const std::string& name)
+  {
+    return get(name);
+  }
+
+  // Sets several state entries at once, each like 'set' above, which
+  // is atomic: either all of the entries are set, or none of them if
+  // any existing entry does not have the specified UUID.
+  virtual process::Future<bool> set(
+      const std::vector<std::pair<Entry, UUID> >& entries) = 0;
+
   // Returns true if successfully expunged the variable from the state.
   virtual process::Future<bool> expunge(const Entry& entry) = 0;
 
@@ -21,6 +21,7 @@
 #include <queue>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <process/dispatch.hpp>
@@ -29,10 +30,14 @@
 
 #include <stout/duration.hpp>
 #include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/none.hpp>
+#include <stout/nothing.hpp>
 #include <stout/option.hpp>
 #include <stout/result.hpp>
 #include <stout/some.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
 #include <stout/uuid.hpp>
@@ -52,6 +57,8 @@ using namespace process;
 
 // Note that we don't add 'using std::set' here because we need
 // 'std::' to disambiguate the 'set' member.
+using std::make_pair;
+using std::pair;
 using std::queue;
 using std::string;
 using std::vector;
@@ -62,6 +69,12 @@ namespace mesos {
 namespace internal {
 namespace state {
 
+// The maximum size of the data of a znode, bigger entries get their
+// value split into chunks, which are children of the znode of the
+// entry (see 'doSet').
+static const size_t MAX_ZNODE_SIZE = 1024 * 1024; // 1 MB
+static const size_t CHUNK_SIZE = 512 * 1024; // 512 KB
+
 
 class ZooKeeperStorageProcess : public Process<ZooKeeperStorageProcess>
 {
@@ -78,6 +91,7 @@ public:
   // Storage implementation.
   Future<Option<Entry> > get(const string& name);
   Future<bool> set(const Entry& entry, const UUID& uuid);
+  Future<bool> setAll(const vector<pair<Entry, UUID> >& entries);
   virtual Future<bool> expunge(const Entry& entry);
   Future<std::set<string> > names();
 
@@ -95,8 +109,23 @@ private:
   Result<std::set<string> > doNames();
   Result<Option<Entry> > doGet(const string& name);
   Result<bool> doSet(const Entry& entry, const UUID& uuid);
+  Result<bool> doSetAll(const vector<pair<Entry, UUID> >& entries);
   Result<bool> doExpunge(const Entry& entry);
 
+  // Helpers for the chunks of the entry stored at 'path'. Getting the
+  // chunks returns none if one is missing, i.e., the entry has been
+  // replaced meanwhile, and setting them returns false if the znode
+  // of the entry has been removed.
+  Result<Option<string> > doGetChunks(const string& path, const Entry& entry);
+  Result<bool> doSetChunks(const string& path, const Entry& entry);
+  Result<Nothing> doRemoveChunks(const string& path, const UUID& uuid);
+
+  // Creates 'znode' and its parents, unless they exist.
+  Result<Nothing> doCreateZnode();
+
+  // Drops what we cached for the znode at 'path'.
+  void invalidate(const string& path);
+
   const string servers;
 
   // The session timeout requested by the client.
@@ -141,6 +170,15 @@ private:
     Promise<bool> promise;
   };
 
+  struct SetAll
+  {
+    explicit SetAll(const vector<pair<Entry, UUID> >& _entries)
+      : entries(_entries) {}
+
+    vector<pair<Entry, UUID> > entries;
+    Promise<bool> promise;
+  };
+
   struct Expunge
   {
     explicit Expunge(const Entry& _entry) : entry(_entry) {}
@@ -155,13 +193,48 @@ private:
     queue<Names*> names;
     queue<Get*> gets;
     queue<Set*> sets;
+    queue<SetAll*> setAlls;
     queue<Expunge*> expunges;
   } pending;
 
   Option<string> error;
+
+  // The entries and names we got, which we keep until ZooKeeper tells
+  // us that they changed via the watches we set when getting them.
+  hashmap<string, Entry> cache;
+  Option<std::set<string> > children;
 };
 
 
+// Returns the entry stored in the data of a znode, or none if the
+// data is empty, i.e., the znode of the entry was created to hold its
+// chunks, which are still being written (see 'doSet').
+static Try<Option<Entry> > parse(const string& data)
+{
+  if (data.empty()) {
+    return None();
+  }
+
+  google::protobuf::io::ArrayInputStream stream(data.data(), data.size());
+
+  Entry entry;
+
+  if (!entry.ParseFromZeroCopyStream(&stream)) {
+    return Error("Failed to deserialize Entry");
+  }
+
+  return Some(entry);
+}
+
+
+// Returns the name of a chunk of an entry, which is prefixed with the
+// UUID of the entry so that the chunks of its versions don't collide.
+static string chunk(const UUID& uuid, size_t index)
+{
+  return uuid.toString() + "-" + stringify(index);
+}
+
+
 // Helper for failing a queue of promises.
 template <typename T>
 void fail(queue<T*>* queue, const string& message)
@@ -198,6 +271,7 @@ ZooKeeperStorageProcess::~ZooKeeperStorageProcess()
   fail(&pending.names, "No longer managing storage");
   fail(&pending.gets, "No longer managing storage");
   fail(&pending.sets, "No longer managing storage");
+  fail(&pending.setAlls, "No longer managing storage");
 
   delete zk;
   delete watcher;
@@ -221,6 +295,8 @@ Future<std::set<string> > ZooKeeperStorageProcess::names()
     Names* names = new Names();
     pending.names.push(names);
     return names->promise.future();
+  } else if (children.isSome()) {
+    return children.get();
   }
 
   Result<std::set<string> > result = doNames();
@@ -245,6 +321,8 @@ Future<Option<Entry> > ZooKeeperStorageProcess::get(const string& name)
     Get* get = new Get(name);
     pending.gets.push(get);
     return get->promise.future();
+  } else if (cache.contains(name)) {
+    return Some(cache.at(name));
   }
 
   Result<Option<Entry> > result = doGet(name);
@@ -285,6 +363,31 @@ Future<bool> ZooKeeperStorageProcess::set(const Entry& entry, const UUID& uuid)
 }
 
 
+Future<bool> ZooKeeperStorageProcess::setAll(
+    const vector<pair<Entry, UUID> >& entries)
+{
+  if (error.isSome()) {
+    return Failure(error.get());
+  } else if (state != CONNECTED) {
+    SetAll* setAll = new SetAll(entries);
+    pending.setAlls.push(setAll);
+    return setAll->promise.future();
+  }
+
+  Result<bool> result = doSetAll(entries);
+
+  if (result.isNone()) { // Try again later.
+    SetAll* setAll = new SetAll(entries);
+    pending.setAlls.push(setAll);
+    return setAll->promise.future();
+  } else if (result.isError()) {
+    return Failure(result.error());
+  }
+
+  return result.get();
+}
+
+
 Future<bool> ZooKeeperStorageProcess::expunge(const Entry& entry)
 {
   if (error.isSome()) {
@@ -373,6 +476,20 @@ void ZooKeeperStorageProcess::connected(int64_t sessionId, bool reconnect)
     pending.sets.pop();
     delete set;
   }
+
+  while (!pending.setAlls.empty()) {
+    SetAll* setAll = pending.setAlls.front();
+    Result<bool> result = doSetAll(setAll->entries);
+    if (result.isNone()) {
+      return; // Try again later.
+    } else if (result.isError()) {
+      setAll->promise.fail(result.error());
+    } else {
+      setAll->promise.set(result.get());
+    }
+    pending.setAlls.pop();
+    delete setAll;
+  }
 }
 
 
@@ -394,6 +511,10 @@ void ZooKeeperStorageProcess::expired(int64_t sessionId)
 
   state = DISCONNECTED;
 
+  // The watches of the session are gone with it.
+  cache.clear();
+  children = None();
+
   delete zk;
   zk = new ZooKeeper(servers, timeout, watcher);
 
@@ -403,19 +524,38 @@ void ZooKeeperStorageProcess::expired(int64_t sessionId)
 
 void ZooKeeperStorageProcess::updated(int64_t sessionId, const string& path)
 {
-  LOG(FATAL) << "Unexpected ZooKeeper event";
+  if (sessionId != zk->getSessionId()) {
+    return;
+  }
+
+  invalidate(path);
 }
 
 
 void ZooKeeperStorageProcess::created(int64_t sessionId, const string& path)
 {
-  LOG(FATAL) << "Unexpected ZooKeeper event";
+  // We only set watches on znodes that exist, so there is nothing we
+  // could have cached for a created znode.
 }
 
 
 void ZooKeeperStorageProcess::deleted(int64_t sessionId, const string& path)
 {
-  LOG(FATAL) << "Unexpected ZooKeeper event";
+  if (sessionId != zk->getSessionId()) {
+    return;
+  }
+
+  invalidate(path);
+}
+
+
+void ZooKeeperStorageProcess::invalidate(const string& path)
+{
+  if (path == znode) {
+    children = None();
+  } else if (strings::startsWith(path, znode + "/")) {
+    cache.erase(path.substr(znode.size() + 1));
+  }
 }
 
 
@@ -424,7 +564,8 @@ Result<std::set<string> > ZooKeeperStorageProcess::doNames()
   // Get all children to determine current memberships.
   vector<string> results;
 
-  int code = zk->getChildren(znode, false, &results);
+  // We watch the children to know when the cached names change.
+  int code = zk->getChildren(znode, true, &results);
 
   if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
     CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
@@ -438,7 +579,9 @@ Result<std::set<string> > ZooKeeperStorageProcess::doNames()
   // TODO(benh): It might make sense to "mangle" the names so that we
   // can determine when a znode has incorrectly been added that
   // actually doesn't store an Entry.
-  return std::set<string>(results.begin(), results.end());
+  children = std::set<string>(results.begin(), results.end());
+
+  return children.get();
 }
 
 
@@ -447,31 +590,53 @@ Result<Option<Entry> > ZooKeeperStorageProcess::doGet(const string& name)
   CHECK_NONE(error) << ": " << error.get();
   CHECK(state == CONNECTED);
 
-  string result;
-  Stat stat;
+  const string path = znode + "/" + name;
 
-  int code = zk->get(znode + "/" + name, false, &result, &stat);
+  while (true) {
+    string result;
+    Stat stat;
 
-  if (code == ZNONODE) {
-    return Option<Entry>::none();
-  } else if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
-    CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
-    return None(); // Try again later.
-  } else if (code != ZOK) {
-    return Error(
-        "Failed to get '" + znode + "/" + name +
-        "' in ZooKeeper: " + zk->message(code));
-  }
+    // We watch the znode to know when the cached entry changes.
+    int code = zk->get(path, true, &result, &stat);
+
+    if (code == ZNONODE) {
+      return Option<Entry>::none();
+    } else if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
+      CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
+      return None(); // Try again later.
+    } else if (code != ZOK) {
+      return Error(
+          "Failed to get '" + path + "' in ZooKeeper: " + zk->message(code));
+    }
 
-  google::protobuf::io::ArrayInputStream stream(result.data(), result.size());
+    Try<Option<Entry> > entry = parse(result);
 
-  Entry entry;
+    if (entry.isError()) {
+      return Error(entry.error());
+    } else if (entry.get().isNone()) {
+      return Option<Entry>::none();
+    } else if (!entry.get().get().has_chunks()) {
+      cache[name] = entry.get().get();
+      return entry.get();
+    }
 
-  if (!entry.ParseFromZeroCopyStream(&stream)) {
-    return Error("Failed to deserialize Entry");
-  }
+    Result<Option<string> > value = doGetChunks(path, entry.get().get());
 
-  return Some(entry);
+    if (value.isError()) {
+      return Error(value.error());
+    } else if (value.isNone()) {
+      return None(); // Try again later.
+    } else if (value.get().isSome()) {
+      Entry assembled = entry.get().get();
+      assembled.clear_chunks();
+      assembled.set_value(value.get().get());
+
+      cache[name] = assembled;
+      return Some(assembled);
+    }
+
+    // The entry got replaced while we were getting its chunks.
+  }
 }
 
 
@@ -481,6 +646,8 @@ Result<bool> ZooKeeperStorageProcess::doSet(const Entry& entry,
   CHECK_NONE(error) << ": " << error.get();
   CHECK(state == CONNECTED);
 
+  const string path = znode + "/" + entry.name();
+
   // Serialize to make sure we're under the 1 MB limit.
   string data;
 
@@ -488,40 +655,45 @@ Result<bool> ZooKeeperStorageProcess::doSet(const Entry& entry,
     return Error("Failed to serialize Entry");
   }
 
-  if (data.size() > 1024 * 1024) { // 1 MB
-    // TODO(benh): Use stout/gzip.hpp for compression.
-    return Error("Serialized data is too big (> 1 MB)");
+  // A bigger entry gets its value written in chunks, before the entry
+  // listing them, so that no one sees a partially written value.
+  // TODO(benh): Use stout/gzip.hpp for compression.
+  bool chunked = false;
+
+  if (data.size() > MAX_ZNODE_SIZE) {
+    Entry manifest;
+    manifest.set_name(entry.name());
+    manifest.set_uuid(entry.uuid());
+    manifest.set_value("");
+    manifest.set_chunks(
+        (entry.value().size() + CHUNK_SIZE - 1) / CHUNK_SIZE);
+
+    if (!manifest.SerializeToString(&data)) {
+      return Error("Failed to serialize Entry");
+    }
+
+    chunked = true;
   }
 
   string result;
   Stat stat;
 
-  int code = zk->get(znode + "/" + entry.name(), false, &result, &stat);
+  Option<Entry> current = None();
+
+  int code = zk->get(path, false, &result, &stat);
 
   if (code == ZNONODE) {
-    // Create directory path znodes as necessary.
-    CHECK(znode.size() == 0 || znode.at(znode.size() - 1) != '/');
-    size_t index = znode.find("/", 0);
-
-    while (index < string::npos) {
-      // Get out the prefix to create.
-      index = znode.find("/", index + 1);
-      string prefix = znode.substr(0, index);
-
-      // Create the znode (even if it already exists).
-      code = zk->create(prefix, "", acl, 0, NULL);
-
-      if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
-        CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
-        return None(); // Try again later.
-      } else if (code != ZOK && code != ZNODEEXISTS) {
-        return Error(
-            "Failed to create '" + prefix +
-            "' in ZooKeeper: " + zk->message(code));
-      }
+    Result<Nothing> created = doCreateZnode();
+
+    if (created.isError()) {
+      return Error(created.error());
+    } else if (created.isNone()) {
+      return None(); // Try again later.
     }
 
-    code = zk->create(znode + "/" + entry.name(), data, acl, 0, NULL);
+    // A chunked entry needs its znode to hold the chunks, which we
+    // create empty, i.e., without an entry yet.
+    code = zk->create(path, chunked ? "" : data, acl, 0, NULL);
 
     if (code == ZNODEEXISTS) {
       return false; // Lost a race with someone else.
@@ -530,44 +702,228 @@ Result<bool> ZooKeeperStorageProcess::doSet(const Entry& entry,
       return None(); // Try again later.
     } else if (code != ZOK) {
       return Error(
-          "Failed to create '" + znode + "/" + entry.name() +
-          "' in ZooKeeper: " + zk->message(code));
+          "Failed to create '" + path + "' in ZooKeeper: " +
+          zk->message(code));
     }
 
-    return true;
+    children = None();
+
+    if (!chunked) {
+      return true;
+    }
+
+    stat.version = 0;
   } else if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
     CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
     return None(); // Try again later.
   } else if (code != ZOK) {
     return Error(
-        "Failed to get '" + znode + "/" + entry.name() +
-        "' in ZooKeeper: " + zk->message(code));
-  }
+        "Failed to get '" + path + "' in ZooKeeper: " + zk->message(code));
+  } else {
+    Try<Option<Entry> > parsed = parse(result);
 
-  google::protobuf::io::ArrayInputStream stream(result.data(), result.size());
+    if (parsed.isError()) {
+      return Error(parsed.error());
+    }
 
-  Entry current;
+    // An empty znode is set like a missing one, the version we
+    // require below decides any race with someone else.
+    current = parsed.get();
 
-  if (!current.ParseFromZeroCopyStream(&stream)) {
-    return Error("Failed to deserialize Entry");
+    if (current.isSome() && UUID::fromBytes(current.get().uuid()) != uuid) {
+      return false;
+    }
   }
 
-  if (UUID::fromBytes(current.uuid()) != uuid) {
-    return false;
+  if (chunked) {
+    Result<bool> written = doSetChunks(path, entry);
+
+    if (written.isError()) {
+      return Error(written.error());
+    } else if (written.isNone()) {
+      return None(); // Try again later.
+    } else if (!written.get()) {
+      return false;
+    }
   }
 
   // Okay, do the set, we get atomicity by requiring 'stat.version'.
-  code = zk->set(znode + "/" + entry.name(), data, stat.version);
+  code = zk->set(path, data, stat.version);
 
   if (code == ZBADVERSION) {
+    if (chunked) {
+      // Best effort, no entry lists these chunks.
+      doRemoveChunks(path, UUID::fromBytes(entry.uuid()));
+    }
     return false;
   } else if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
     CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
     return None(); // Try again later.
   } else if (code != ZOK) {
     return Error(
-        "Failed to set '" + znode + "/" + entry.name() +
-        "' in ZooKeeper: " + zk->message(code));
+        "Failed to set '" + path + "' in ZooKeeper: " + zk->message(code));
+  }
+
+  cache.erase(entry.name());
+
+  // The chunks of the entry we replaced are no longer listed by any
+  // entry, so failing to remove them only wastes space.
+  if (current.isSome() && current.get().has_chunks()) {
+    Result<Nothing> removed =
+      doRemoveChunks(path, UUID::fromBytes(current.get().uuid()));
+
+    if (!removed.isSome()) {
+      LOG(WARNING) << "Failed to remove the chunks of a previous version of '"
+                   << path << "'"
+                   << (removed.isError() ? ": " + removed.error() : "");
+    }
+  }
+
+  return true;
+}
+
+
+Result<bool> ZooKeeperStorageProcess::doSetAll(
+    const vector<pair<Entry, UUID> >& entries)
+{
+  CHECK_NONE(error) << ": " << error.get();
+  CHECK(state == CONNECTED);
+
+  typedef pair<Entry, UUID> EntryAndUUID;
+
+  // The operations of the transaction reference these, so we reserve
+  // them upfront to keep them in place while we add to them.
+  vector<string> paths;
+  vector<string> datas;
+  vector<vector<char> > buffers; // For the paths of created znodes.
+  vector<Stat> stats;
+
+  paths.reserve(entries.size());
+  datas.reserve(entries.size());
+  buffers.reserve(entries.size());
+  stats.reserve(entries.size());
+
+  vector<zoo_op_t> ops(entries.size());
+
+  // The chunked entries we replace, whose chunks we remove afterwards.
+  vector<pair<string, UUID> > replaced;
+
+  bool created = false;
+  size_t size = 0;
+
+  foreach (const EntryAndUUID& entry, entries) {
+    const size_t i = paths.size();
+
+    paths.push_back(znode + "/" + entry.first.name());
+    datas.push_back(string());
+    buffers.push_back(vector<char>(paths[i].size() + 1));
+    stats.push_back(Stat());
+
+    if (!entry.first.SerializeToString(&datas[i])) {
+      return Error("Failed to serialize Entry");
+    }
+
+    // The whole transaction has to be under the 1 MB limit.
+    size += datas[i].size();
+
+    if (size > 1024 * 1024) { // 1 MB
+      return Error("Serialized data is too big (> 1 MB)");
+    }
+
+    string result;
+    Stat stat;
+
+    int code = zk->get(paths[i], false, &result, &stat);
+
+    if (code == ZNONODE) {
+      if (!created) {
+        Result<Nothing> create = doCreateZnode();
+
+        if (create.isError()) {
+          return Error(create.error());
+        } else if (create.isNone()) {
+          return None(); // Try again later.
+        }
+
+        created = true;
+      }
+
+      zoo_create_op_init(
+          &ops[i],
+          paths[i].c_str(),
+          datas[i].data(),
+          datas[i].size(),
+          &acl,
+          0,
+          buffers[i].data(),
+          buffers[i].size());
+
+      continue;
+    } else if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
+      CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
+      return None(); // Try again later.
+    } else if (code != ZOK) {
+      return Error(
+          "Failed to get '" + paths[i] + "' in ZooKeeper: " +
+          zk->message(code));
+    }
+
+    Try<Option<Entry> > current = parse(result);
+
+    if (current.isError()) {
+      return Error(current.error());
+    } else if (current.get().isSome()) {
+      if (UUID::fromBytes(current.get().get().uuid()) != entry.second) {
+        return false;
+      } else if (current.get().get().has_chunks()) {
+        replaced.push_back(make_pair(
+            paths[i],
+            UUID::fromBytes(current.get().get().uuid())));
+      }
+    }
+
+    // We get atomicity by requiring 'stat.version', as for 'set'.
+    zoo_set_op_init(
+        &ops[i],
+        paths[i].c_str(),
+        datas[i].data(),
+        datas[i].size(),
+        stat.version,
+        &stats[i]);
+  }
+
+  vector<zoo_op_result_t> results;
+
+  int code = zk->multi(ops, &results);
+
+  if (code == ZNODEEXISTS || code == ZBADVERSION) {
+    return false; // Lost a race with someone else.
+  } else if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
+    CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
+    return None(); // Try again later.
+  } else if (code != ZOK) {
+    return Error(
+        "Failed to set the entries in ZooKeeper: " + zk->message(code));
+  }
+
+  foreach (const EntryAndUUID& entry, entries) {
+    cache.erase(entry.first.name());
+  }
+
+  if (created) {
+    children = None();
+  }
+
+  typedef pair<string, UUID> PathAndUUID;
+
+  foreach (const PathAndUUID& chunks, replaced) {
+    Result<Nothing> removed = doRemoveChunks(chunks.first, chunks.second);
+
+    if (!removed.isSome()) {
+      LOG(WARNING) << "Failed to remove the chunks of a previous version of '"
+                   << chunks.first << "'"
+                   << (removed.isError() ? ": " + removed.error() : "");
+    }
   }
 
   return true;
@@ -579,10 +935,12 @@ Result<bool> ZooKeeperStorageProcess::doExpunge(const Entry& entry)
   CHECK_NONE(error) << ": " << error.get();
   CHECK(state == CONNECTED);
 
+  const string path = znode + "/" + entry.name();
+
   string result;
   Stat stat;
 
-  int code = zk->get(znode + "/" + entry.name(), false, &result, &stat);
+  int code = zk->get(path, false, &result, &stat);
 
   if (code == ZNONODE) {
     return false;
@@ -591,40 +949,213 @@ Result<bool> ZooKeeperStorageProcess::doExpunge(const Entry& entry)
     return None(); // Try again later.
   } else if (code != ZOK) {
     return Error(
-        "Failed to get '" + znode + "/" + entry.name() +
-        "' in ZooKeeper: " + zk->message(code));
+        "Failed to get '" + path + "' in ZooKeeper: " + zk->message(code));
   }
 
-  google::protobuf::io::ArrayInputStream stream(result.data(), result.size());
+  Try<Option<Entry> > current = parse(result);
 
-  Entry current;
-
-  if (!current.ParseFromZeroCopyStream(&stream)) {
-    return Error("Failed to deserialize Entry");
+  if (current.isError()) {
+    return Error(current.error());
+  } else if (current.get().isNone()) {
+    return false;
   }
 
-  if (UUID::fromBytes(current.uuid()) != UUID::fromBytes(entry.uuid())) {
+  if (UUID::fromBytes(current.get().get().uuid()) !=
+      UUID::fromBytes(entry.uuid())) {
     return false;
   }
 
+  if (current.get().get().has_chunks()) {
+    // The znode can't be removed with its chunks, so we first empty
+    // it, which expunges the entry atomically, and then clean up.
+    code = zk->set(path, "", stat.version);
+
+    if (code == ZBADVERSION) {
+      return false;
+    } else if (code == ZINVALIDSTATE ||
+               (code != ZOK && zk->retryable(code))) {
+      CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
+      return None(); // Try again later.
+    } else if (code != ZOK) {
+      return Error(
+          "Failed to set '" + path + "' in ZooKeeper: " + zk->message(code));
+    }
+
+    cache.erase(entry.name());
+
+    Result<Nothing> removed =
+      doRemoveChunks(path, UUID::fromBytes(entry.uuid()));
+
+    // Requiring the version we set leaves the znode to anyone who
+    // has set a new entry in it meanwhile.
+    if (!removed.isSome() ||
+        zk->remove(path, stat.version + 1) != ZOK) {
+      LOG(WARNING) << "Failed to remove the chunks of expunged '"
+                   << path << "'"
+                   << (removed.isError() ? ": " + removed.error() : "");
+    } else {
+      children = None();
+    }
+
+    return true;
+  }
+
   // Okay, do the remove, we get atomicity by requiring 'stat.version'.
-  code = zk->remove(znode + "/" + entry.name(), stat.version);
+  code = zk->remove(path, stat.version);
 
-  if (code == ZBADVERSION) {
-    return false;
+  if (code == ZBADVERSION || code == ZNOTEMPTY) {
+    return false; // Someone else is setting a new entry.
   } else if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
     CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
     return None(); // Try again later.
   } else if (code != ZOK) {
     return Error(
-        "Failed to remove '" + znode + "/" + entry.name() +
-        "' in ZooKeeper: " + zk->message(code));
+        "Failed to remove '" + path + "' in ZooKeeper: " + zk->message(code));
   }
 
+  cache.erase(entry.name());
+  children = None();
+
   return true;
 }
 
 
+Result<Option<string> > ZooKeeperStorageProcess::doGetChunks(
+    const string& path,
+    const Entry& entry)
+{
+  const UUID uuid = UUID::fromBytes(entry.uuid());
+
+  string value;
+
+  for (size_t i = 0; i < entry.chunks(); i++) {
+    const string name = path + "/" + chunk(uuid, i);
+
+    string result;
+    Stat stat;
+
+    int code = zk->get(name, false, &result, &stat);
+
+    if (code == ZNONODE) {
+      return Option<string>::none();
+    } else if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
+      CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
+      return None(); // Try again later.
+    } else if (code != ZOK) {
+      return Error(
+          "Failed to get '" + name + "' in ZooKeeper: " + zk->message(code));
+    }
+
+    value += result;
+  }
+
+  return Some(value);
+}
+
+
+Result<bool> ZooKeeperStorageProcess::doSetChunks(
+    const string& path,
+    const Entry& entry)
+{
+  const UUID uuid = UUID::fromBytes(entry.uuid());
+
+  for (size_t offset = 0; offset < entry.value().size(); offset += CHUNK_SIZE) {
+    const string name = path + "/" + chunk(uuid, offset / CHUNK_SIZE);
+    const string data = entry.value().substr(offset, CHUNK_SIZE);
+
+    int code = zk->create(name, data, acl, 0, NULL);
+
+    // The chunk exists if we are trying again.
+    if (code == ZNODEEXISTS) {
+      code = zk->set(name, data, -1);
+    }
+
+    if (code == ZNONODE) {
+      return false; // The entry got expunged.
+    } else if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
+      CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
+      return None(); // Try again later.
+    } else if (code != ZOK) {
+      return Error(
+          "Failed to create '" + name + "' in ZooKeeper: " +
+          zk->message(code));
+    }
+  }
+
+  return true;
+}
+
+
+Result<Nothing> ZooKeeperStorageProcess::doRemoveChunks(
+    const string& path,
+    const UUID& uuid)
+{
+  vector<string> results;
+
+  int code = zk->getChildren(path, false, &results);
+
+  if (code == ZNONODE) {
+    return Nothing();
+  } else if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
+    CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
+    return None(); // Try again later.
+  } else if (code != ZOK) {
+    return Error(
+        "Failed to get children of '" + path + "' in ZooKeeper: " +
+        zk->message(code));
+  }
+
+  const string prefix = uuid.toString() + "-";
+
+  foreach (const string& result, results) {
+    if (!strings::startsWith(result, prefix)) {
+      continue;
+    }
+
+    code = zk->remove(path + "/" + result, -1);
+
+    if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
+      CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
+      return None(); // Try again later.
+    } else if (code != ZOK && code != ZNONODE) {
+      return Error(
+          "Failed to remove '" + path + "/" + result + "' in ZooKeeper: " +
+          zk->message(code));
+    }
+  }
+
+  return Nothing();
+}
+
+
+Result<Nothing> ZooKeeperStorageProcess::doCreateZnode()
+{
+  // Create directory path znodes as necessary.
+  CHECK(znode.size() == 0 || znode.at(znode.size() - 1) != '/');
+  size_t index = znode.find("/", 0);
+
+  while (index < string::npos) {
+    // Get out the prefix to create.
+    index = znode.find("/", index + 1);
+    string prefix = znode.substr(0, index);
+
+    // Create the znode (even if it already exists).
+    int code = zk->create(prefix, "", acl, 0, NULL);
+
+    if (code == ZINVALIDSTATE || (code != ZOK && zk->retryable(code))) {
+      CHECK(zk->getState() != ZOO_AUTH_FAILED_STATE);
+      return None(); // Try again later.
+    } else if (code != ZOK && code != ZNODEEXISTS) {
+      return Error(
+          "Failed to create '" + prefix +
+          "' in ZooKeeper: " + zk->message(code));
+    }
+  }
+
+  return Nothing();
+}
+
+
 ZooKeeperStorage::ZooKeeperStorage(
     const string& servers,
     const Duration& timeout,
@@ -656,6 +1187,12 @@ Future<bool> ZooKeeperStorage::set(const Entry& entry, const UUID& uuid)
 }
 
 
+Future<bool> ZooKeeperStorage::set(const vector<pair<Entry, UUID> >& entries)
+{
+  return dispatch(process, &ZooKeeperStorageProcess::setAll, entries);
+}
+
+
 Future<bool> ZooKeeperStorage::expunge(const Entry& entry)
 {
   return dispatch(process, &ZooKeeperStorageProcess::expunge, entry);
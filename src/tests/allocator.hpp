@@ -172,6 +172,12 @@ ACTION_P2(InvokeRecoverResourcesWithFilters, allocator, timeout)
 }
 
 
+ACTION_P(InvokeAcceptResources, allocator)
+{
+  allocator->real->acceptResources(arg0, arg1, arg2);
+}
+
+
 ACTION_P(InvokeSuppressOffers, allocator)
 {
   allocator->real->suppressOffers(arg0);
@@ -323,6 +329,11 @@ public:
     EXPECT_CALL(*this, recoverResources(_, _, _, _))
       .WillRepeatedly(DoDefault());
 
+    ON_CALL(*this, acceptResources(_, _, _))
+      .WillByDefault(InvokeAcceptResources(this));
+    EXPECT_CALL(*this, acceptResources(_, _, _))
+      .WillRepeatedly(DoDefault());
+
     ON_CALL(*this, suppressOffers(_))
       .WillByDefault(InvokeSuppressOffers(this));
     EXPECT_CALL(*this, suppressOffers(_))
@@ -436,6 +447,11 @@ public:
       const Resources&,
       const Option<Filters>& filters));
 
+  MOCK_METHOD3(acceptResources, void(
+      const FrameworkID&,
+      const SlaveID&,
+      const Resources&));
+
   MOCK_METHOD1(suppressOffers, void(
       const FrameworkID&));
 
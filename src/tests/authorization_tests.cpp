@@ -556,6 +556,133 @@ TYPED_TEST(AuthorizationTest, Unreserve)
   AWAIT_EXPECT_FALSE(authorizer.get()->authorize(request6));
 }
 
+
+// This tests that the first ACL which matches a request decides it
+// when there are many ACLs, for principals which are or are not
+// mentioned by the ACLs.
+TYPED_TEST(AuthorizationTest, FirstMatchingACLDecides)
+{
+  ACLs acls;
+
+  // Many principals can each only run as a user of their own.
+  for (int i = 0; i < 1000; i++) {
+    mesos::ACL::RunTask* acl = acls.add_run_tasks();
+    acl->mutable_principals()->add_values("principal" + stringify(i));
+    acl->mutable_users()->add_values("user" + stringify(i));
+  }
+
+  // Principals "foo" and "bar" can run as "guest".
+  mesos::ACL::RunTask* acl1 = acls.add_run_tasks();
+  acl1->mutable_principals()->add_values("foo");
+  acl1->mutable_principals()->add_values("bar");
+  acl1->mutable_users()->add_values("guest");
+
+  // No principal can run as any other user.
+  mesos::ACL::RunTask* acl2 = acls.add_run_tasks();
+  acl2->mutable_principals()->set_type(mesos::ACL::Entity::ANY);
+  acl2->mutable_users()->set_type(mesos::ACL::Entity::NONE);
+
+  // Principal "baz" can run as any user, but this ACL is preceded by
+  // the above ACL which matches all of its requests.
+  mesos::ACL::RunTask* acl3 = acls.add_run_tasks();
+  acl3->mutable_principals()->add_values("baz");
+  acl3->mutable_users()->set_type(mesos::ACL::Entity::ANY);
+
+  // Create an Authorizer with the ACLs.
+  Try<Authorizer*> create = TypeParam::create();
+  ASSERT_SOME(create);
+  Owned<Authorizer> authorizer(create.get());
+
+  Try<Nothing> initialized = authorizer.get()->initialize(acls);
+  ASSERT_SOME(initialized);
+
+  // Principal "principal500" can run as "user500" but not as "user1".
+  mesos::ACL::RunTask request1;
+  request1.mutable_principals()->add_values("principal500");
+  request1.mutable_users()->add_values("user500");
+  AWAIT_EXPECT_TRUE(authorizer.get()->authorize(request1));
+
+  mesos::ACL::RunTask request2;
+  request2.mutable_principals()->add_values("principal500");
+  request2.mutable_users()->add_values("user1");
+  AWAIT_EXPECT_FALSE(authorizer.get()->authorize(request2));
+
+  // Principals "bar" and "foo" can run as "guest", but "foo" and
+  // "principal1" cannot since no single ACL mentions both.
+  mesos::ACL::RunTask request3;
+  request3.mutable_principals()->add_values("bar");
+  request3.mutable_principals()->add_values("foo");
+  request3.mutable_users()->add_values("guest");
+  AWAIT_EXPECT_TRUE(authorizer.get()->authorize(request3));
+
+  mesos::ACL::RunTask request4;
+  request4.mutable_principals()->add_values("foo");
+  request4.mutable_principals()->add_values("principal1");
+  request4.mutable_users()->add_values("guest");
+  AWAIT_EXPECT_FALSE(authorizer.get()->authorize(request4));
+
+  // Principal "baz" cannot run as any user.
+  mesos::ACL::RunTask request5;
+  request5.mutable_principals()->add_values("baz");
+  request5.mutable_users()->add_values("guest");
+  AWAIT_EXPECT_FALSE(authorizer.get()->authorize(request5));
+
+  // Neither can any principal.
+  mesos::ACL::RunTask request6;
+  request6.mutable_principals()->set_type(mesos::ACL::Entity::ANY);
+  request6.mutable_users()->add_values("guest");
+  AWAIT_EXPECT_FALSE(authorizer.get()->authorize(request6));
+}
+
+
+// This tests that a batch of requests is decided as each of the
+// requests would be on its own.
+TYPED_TEST(AuthorizationTest, BatchRunTask)
+{
+  // Principal "foo" can run as "guest", and no principal can run as
+  // "root".
+  ACLs acls;
+  mesos::ACL::RunTask* acl1 = acls.add_run_tasks();
+  acl1->mutable_principals()->add_values("foo");
+  acl1->mutable_users()->add_values("guest");
+
+  mesos::ACL::RunTask* acl2 = acls.add_run_tasks();
+  acl2->mutable_principals()->set_type(mesos::ACL::Entity::NONE);
+  acl2->mutable_users()->add_values("root");
+
+  // Create an Authorizer with the ACLs.
+  Try<Authorizer*> create = TypeParam::create();
+  ASSERT_SOME(create);
+  Owned<Authorizer> authorizer(create.get());
+
+  Try<Nothing> initialized = authorizer.get()->initialize(acls);
+  ASSERT_SOME(initialized);
+
+  std::list<mesos::ACL::RunTask> requests;
+
+  mesos::ACL::RunTask request;
+  request.mutable_principals()->add_values("foo");
+  request.mutable_users()->add_values("guest");
+  requests.push_back(request);
+
+  request.mutable_users()->set_values(0, "root");
+  requests.push_back(request);
+
+  request.mutable_principals()->set_values(0, "bar");
+  request.mutable_users()->set_values(0, "guest");
+  requests.push_back(request);
+
+  Future<std::list<bool>> decisions = authorizer.get()->authorize(requests);
+  AWAIT_READY(decisions);
+
+  EXPECT_EQ(std::list<bool>({true, false, true}), decisions.get());
+
+  // An empty batch is decided right away.
+  AWAIT_EXPECT_EQ(
+      std::list<bool>(),
+      authorizer.get()->authorize(std::list<mesos::ACL::RunTask>()));
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
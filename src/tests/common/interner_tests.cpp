@@ -0,0 +1,115 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <mesos/mesos.hpp>
+#include <mesos/type_utils.hpp>
+
+#include <stout/stringify.hpp>
+
+#include "common/interner.hpp"
+
+using std::shared_ptr;
+using std::vector;
+
+using namespace mesos;
+using namespace mesos::internal;
+
+
+static ExecutorInfo createExecutorInfo(const std::string& executorId)
+{
+  ExecutorInfo executorInfo;
+  executorInfo.mutable_executor_id()->set_value(executorId);
+  executorInfo.mutable_command()->set_value("exit 0");
+
+  Environment::Variable* variable =
+    executorInfo.mutable_command()->mutable_environment()->add_variables();
+
+  variable->set_name("NAME");
+  variable->set_value("value");
+
+  return executorInfo;
+}
+
+
+TEST(InternerTest, Intern)
+{
+  Interner<ExecutorInfo> interner;
+
+  const ExecutorInfo executorInfo = createExecutorInfo("executor");
+
+  shared_ptr<const ExecutorInfo> interned1 = interner.intern(executorInfo);
+  shared_ptr<const ExecutorInfo> interned2 =
+    interner.intern(createExecutorInfo("executor"));
+
+  // Identical messages share a single copy.
+  EXPECT_EQ(interned1.get(), interned2.get());
+  EXPECT_EQ(executorInfo, *interned1);
+  EXPECT_EQ(1u, interner.size());
+
+  // Messages that differ in any field do not.
+  ExecutorInfo executorInfo2 = executorInfo;
+  executorInfo2.mutable_command()->mutable_environment()
+    ->mutable_variables(0)->set_value("value2");
+
+  shared_ptr<const ExecutorInfo> interned3 = interner.intern(executorInfo2);
+
+  EXPECT_NE(interned1.get(), interned3.get());
+  EXPECT_EQ(executorInfo2, *interned3);
+  EXPECT_EQ(2u, interner.size());
+
+  // A message is freed once it is no longer used.
+  interned1.reset();
+  interned2.reset();
+
+  EXPECT_EQ(1u, interner.size());
+
+  shared_ptr<const ExecutorInfo> interned4 = interner.intern(executorInfo);
+
+  EXPECT_EQ(executorInfo, *interned4);
+  EXPECT_EQ(2u, interner.size());
+}
+
+
+// This test verifies that the interner forgets about freed messages.
+TEST(InternerTest, Purge)
+{
+  Interner<ExecutorInfo> interner;
+
+  shared_ptr<const ExecutorInfo> interned =
+    interner.intern(createExecutorInfo("executor"));
+
+  for (int i = 0; i < 10000; i++) {
+    interner.intern(createExecutorInfo(stringify(i)));
+  }
+
+  EXPECT_EQ(1u, interner.size());
+
+  // The message still in use is not purged.
+  EXPECT_EQ(interned.get(),
+            interner.intern(createExecutorInfo("executor")).get());
+
+  vector<shared_ptr<const ExecutorInfo>> executorInfos;
+  for (int i = 0; i < 10000; i++) {
+    executorInfos.push_back(interner.intern(createExecutorInfo(stringify(i))));
+  }
+
+  EXPECT_EQ(10001u, interner.size());
+}
@@ -278,6 +278,9 @@ void TestContainerizer::setup()
 
   EXPECT_CALL(*this, wait(_))
     .WillRepeatedly(Invoke(this, &TestContainerizer::_wait));
+
+  EXPECT_CALL(*this, pull(_))
+    .WillRepeatedly(Return(false));
 }
 
 } // namespace tests {
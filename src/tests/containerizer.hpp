@@ -108,6 +108,10 @@ public:
       wait,
       process::Future<containerizer::Termination>(const ContainerID&));
 
+  MOCK_METHOD1(
+      pull,
+      process::Future<bool>(const Image&));
+
 private:
   void setup();
 
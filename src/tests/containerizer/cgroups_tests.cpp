@@ -22,6 +22,7 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <list>
 #include <set>
 #include <string>
 #include <thread>
@@ -29,15 +30,18 @@
 
 #include <sys/mman.h>
 #include <sys/ptrace.h>
+#include <sys/sysmacros.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 
 #include <gmock/gmock.h>
 
+#include <process/collect.hpp>
 #include <process/gtest.hpp>
 #include <process/latch.hpp>
 #include <process/owned.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/numify.hpp>
@@ -61,8 +65,10 @@ using namespace process;
 using cgroups::memory::pressure::Level;
 using cgroups::memory::pressure::Counter;
 
+using std::list;
 using std::set;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -542,6 +548,108 @@ TEST_F(CgroupsAnyHierarchyWithCpuAcctMemoryTest, ROOT_CGROUPS_Stat)
 }
 
 
+TEST(CgroupsStatTest, Parse)
+{
+  Option<uint64_t> cache;
+  Option<uint64_t> rss;
+  Option<uint64_t> swap;
+
+  EXPECT_SOME(cgroups::stat(
+      "cache 1024\nrss 18446744073709551615\n\nrss_huge 7\n",
+      {{"cache", &cache}, {"rss", &rss}, {"swap", &swap}}));
+
+  EXPECT_SOME_EQ(1024u, cache);
+  EXPECT_SOME_EQ(18446744073709551615u, rss);
+  EXPECT_NONE(swap);
+
+  EXPECT_ERROR(cgroups::stat("cache\n", {{"cache", &cache}}));
+  EXPECT_ERROR(cgroups::stat("cache 1k\n", {{"cache", &cache}}));
+  EXPECT_ERROR(cgroups::stat(" 1\n", {{"cache", &cache}}));
+}
+
+
+TEST(CgroupsCpusetTest, ParseFormat)
+{
+  Try<set<unsigned int>> ids = cgroups::cpuset::parse("0-3,8,10-11\n");
+  ASSERT_SOME(ids);
+  EXPECT_EQ(set<unsigned int>({0, 1, 2, 3, 8, 10, 11}), ids.get());
+  EXPECT_EQ("0-3,8,10-11", cgroups::cpuset::format(ids.get()));
+
+  ids = cgroups::cpuset::parse("\n");
+  ASSERT_SOME(ids);
+  EXPECT_TRUE(ids.get().empty());
+  EXPECT_EQ("", cgroups::cpuset::format(ids.get()));
+
+  EXPECT_ERROR(cgroups::cpuset::parse("3-1"));
+  EXPECT_ERROR(cgroups::cpuset::parse("1-2-3"));
+  EXPECT_ERROR(cgroups::cpuset::parse("a"));
+}
+
+
+TEST(CgroupsBlkioTest, Parse)
+{
+  Try<vector<cgroups::blkio::Value>> values = cgroups::blkio::parse(
+      "8:0 Read 4096\n"
+      "8:16 Write 18446744073709551615\n"
+      "Total 4096\n");
+
+  ASSERT_SOME(values);
+  ASSERT_EQ(3u, values.get().size());
+
+  EXPECT_SOME_EQ(makedev(8, 0), values.get()[0].device);
+  EXPECT_EQ("Read", values.get()[0].operation);
+  EXPECT_EQ(4096u, values.get()[0].value);
+
+  EXPECT_SOME_EQ(makedev(8, 16), values.get()[1].device);
+  EXPECT_EQ(18446744073709551615u, values.get()[1].value);
+
+  EXPECT_NONE(values.get()[2].device);
+  EXPECT_EQ("", values.get()[2].operation);
+  EXPECT_EQ(4096u, values.get()[2].value);
+
+  // The controls which are not broken down by operation.
+  values = cgroups::blkio::parse("8:0 12\n");
+  ASSERT_SOME(values);
+  ASSERT_EQ(1u, values.get().size());
+  EXPECT_EQ("", values.get()[0].operation);
+  EXPECT_EQ(12u, values.get()[0].value);
+
+  EXPECT_ERROR(cgroups::blkio::parse("8 Read 1\n"));
+  EXPECT_ERROR(cgroups::blkio::parse("8:0 Read\n"));
+  EXPECT_ERROR(cgroups::blkio::parse("8:0 Read 1 2\n"));
+}
+
+
+TEST_F(CgroupsAnyHierarchyWithCpuAcctMemoryTest, ROOT_CGROUPS_Control)
+{
+  const string hierarchy = path::join(baseHierarchy, "memory");
+
+  EXPECT_ERROR(cgroups::Control::open(hierarchy, "/", "invalid"));
+
+  Try<Owned<cgroups::Control>> usage =
+    cgroups::Control::open(hierarchy, "/", "memory.usage_in_bytes");
+  ASSERT_SOME(usage);
+
+  Try<Owned<cgroups::Control>> stat =
+    cgroups::Control::open(hierarchy, "/", "memory.stat");
+  ASSERT_SOME(stat);
+
+  // The controls are read repeatedly through the same file.
+  for (int i = 0; i < 3; i++) {
+    Try<uint64_t> value = usage.get()->value();
+    ASSERT_SOME(value);
+    EXPECT_LT(0u, value.get());
+
+    Option<uint64_t> rss;
+    ASSERT_SOME(stat.get()->stat({{"rss", &rss}}));
+    ASSERT_SOME(rss);
+    EXPECT_LT(0u, rss.get());
+
+    EXPECT_SOME(cgroups::stat(stat.get()->contents(), {}));
+  }
+}
+
+
 TEST_F(CgroupsAnyHierarchyWithCpuMemoryTest, ROOT_CGROUPS_Listen)
 {
   string hierarchy = path::join(baseHierarchy, "memory");
@@ -950,6 +1058,58 @@ TEST_F(CgroupsAnyHierarchyWithFreezerTest, ROOT_CGROUPS_DestroyTracedProcess)
 }
 
 
+// Destroys more cgroups at once than the number of tasks killers that
+// may run concurrently, so that some of the destroys are queued.
+TEST_F(CgroupsAnyHierarchyWithFreezerTest, ROOT_CGROUPS_DestroyConcurrently)
+{
+  string hierarchy = path::join(baseHierarchy, "freezer");
+  ASSERT_SOME(cgroups::create(hierarchy, TEST_CGROUPS_ROOT));
+
+  vector<pid_t> pids;
+  vector<string> children;
+
+  for (int i = 0; i < 40; i++) {
+    string cgroup = path::join(TEST_CGROUPS_ROOT, stringify(i));
+    ASSERT_SOME(cgroups::create(hierarchy, cgroup));
+
+    pid_t pid = ::fork();
+    ASSERT_NE(-1, pid);
+
+    if (pid == 0) {
+      // In child process.
+      while (true) { sleep(1); }
+
+      ABORT("Child should not reach this statement");
+    }
+
+    // In parent process.
+    ASSERT_SOME(cgroups::assign(hierarchy, cgroup, pid));
+
+    pids.push_back(pid);
+    children.push_back(cgroup);
+  }
+
+  list<Future<Nothing>> destroys;
+  foreach (const string& cgroup, children) {
+    destroys.push_back(cgroups::destroy(hierarchy, cgroup));
+  }
+
+  AWAIT_READY(collect(destroys));
+
+  foreach (const string& cgroup, children) {
+    EXPECT_FALSE(os::exists(path::join(hierarchy, cgroup)));
+  }
+
+  // cgroups::destroy will reap all processes in the cgroups so we
+  // should *not* be able to reap them now.
+  foreach (pid_t pid, pids) {
+    int status;
+    EXPECT_EQ(-1, ::waitpid(pid, &status, 0));
+    EXPECT_EQ(ECHILD, errno);
+  }
+}
+
+
 class CgroupsAnyHierarchyWithPerfEventTest
   : public CgroupsAnyHierarchyTest
 {
@@ -1267,6 +1427,239 @@ TEST_F(CgroupsAnyHierarchyWithCpuAcctMemoryTest, ROOT_CGROUPS_CpuAcctsStats)
   AWAIT_READY(cgroups::destroy(hierarchy, TEST_CGROUPS_ROOT));
 }
 
+
+// A fixture for the tests of the unified hierarchy (cgroups v2). It
+// uses the unified hierarchy if it is mounted, and mounts it in the
+// sandbox otherwise.
+class CgroupsUnifiedTest : public TemporaryDirectoryTest
+{
+protected:
+  virtual void SetUp()
+  {
+    TemporaryDirectoryTest::SetUp();
+
+    ASSERT_TRUE(cgroups::unified::enabled())
+      << "-------------------------------------------------------------\n"
+      << "We cannot run any unified hierarchy tests because the kernel\n"
+      << "does not support cgroups v2. You can disable this test case\n"
+      << "(i.e., --gtest_filter=-CgroupsUnifiedTest.*).\n"
+      << "-------------------------------------------------------------";
+
+    Result<string> mounted = cgroups::unified::hierarchy();
+    ASSERT_FALSE(mounted.isError());
+
+    if (mounted.isSome()) {
+      hierarchy = mounted.get();
+    } else {
+      hierarchy = path::join(os::getcwd(), "unified");
+      ASSERT_SOME(cgroups::unified::mount(hierarchy));
+      unmount = true;
+    }
+
+    // Remove the cgroups left behind by previous tests.
+    Try<bool> exists = cgroups::unified::exists(hierarchy, TEST_CGROUPS_ROOT);
+    ASSERT_SOME(exists);
+
+    if (exists.get()) {
+      AWAIT_READY(cgroups::unified::destroy(hierarchy, TEST_CGROUPS_ROOT));
+    }
+  }
+
+  virtual void TearDown()
+  {
+    Try<bool> exists = cgroups::unified::exists(hierarchy, TEST_CGROUPS_ROOT);
+    ASSERT_SOME(exists);
+
+    if (exists.get()) {
+      AWAIT_READY(cgroups::unified::destroy(hierarchy, TEST_CGROUPS_ROOT));
+    }
+
+    if (unmount) {
+      ASSERT_SOME(cgroups::unified::unmount(hierarchy));
+    }
+
+    TemporaryDirectoryTest::TearDown();
+  }
+
+  string hierarchy;
+  bool unmount = false;
+};
+
+
+TEST_F(CgroupsUnifiedTest, ROOT_CGROUPS_UNIFIED_Mounted)
+{
+  EXPECT_SOME_TRUE(cgroups::unified::mounted(hierarchy));
+  EXPECT_SOME_FALSE(cgroups::unified::mounted(os::getcwd()));
+
+  // The unified hierarchy is not a cgroups v1 hierarchy.
+  EXPECT_SOME_FALSE(cgroups::mounted(hierarchy));
+
+  EXPECT_SOME(cgroups::unified::controllers(hierarchy));
+}
+
+
+// This test verifies that the controllers of a new cgroup are enabled
+// in its ancestors, and that destroying a cgroup kills its processes
+// and removes it along with its descendants.
+TEST_F(CgroupsUnifiedTest, ROOT_CGROUPS_UNIFIED_CreateDestroy)
+{
+  Try<set<string>> controllers = cgroups::unified::controllers(hierarchy);
+  ASSERT_SOME(controllers);
+
+  const string cgroup = path::join(TEST_CGROUPS_ROOT, "nested");
+  ASSERT_SOME(cgroups::unified::create(hierarchy, cgroup, controllers.get()));
+
+  EXPECT_SOME_EQ(
+      controllers.get(),
+      cgroups::unified::controllers(hierarchy, cgroup));
+
+  EXPECT_SOME_FALSE(cgroups::unified::populated(hierarchy, TEST_CGROUPS_ROOT));
+
+  pid_t pid = ::fork();
+  ASSERT_NE(-1, pid);
+
+  if (pid == 0) {
+    // In child process, wait for the kill signal from the parent.
+    while (true) {
+      ::pause();
+    }
+
+    // Should not reach here.
+    abort();
+  }
+
+  ASSERT_SOME(cgroups::unified::assign(hierarchy, cgroup, pid));
+
+  Try<set<pid_t>> processes = cgroups::unified::processes(hierarchy, cgroup);
+  ASSERT_SOME(processes);
+  EXPECT_EQ(1u, processes->count(pid));
+
+  // The processes of a descendant populate the ancestors too.
+  EXPECT_SOME_TRUE(cgroups::unified::populated(hierarchy, TEST_CGROUPS_ROOT));
+
+  AWAIT_READY(cgroups::unified::destroy(hierarchy, TEST_CGROUPS_ROOT));
+
+  int status;
+  EXPECT_EQ(pid, ::waitpid(pid, &status, 0));
+  EXPECT_TRUE(WIFSIGNALED(status));
+  EXPECT_EQ(SIGKILL, WTERMSIG(status));
+
+  EXPECT_SOME_FALSE(cgroups::unified::exists(hierarchy, TEST_CGROUPS_ROOT));
+}
+
+
+TEST_F(CgroupsUnifiedTest, ROOT_CGROUPS_UNIFIED_Pressure)
+{
+  ASSERT_SOME(cgroups::unified::create(hierarchy, TEST_CGROUPS_ROOT));
+
+  Try<cgroups::unified::Pressure> pressure =
+    cgroups::unified::pressure(hierarchy, TEST_CGROUPS_ROOT, "cpu");
+
+  ASSERT_SOME(pressure);
+  EXPECT_LE(0.0, pressure->some.avg10);
+  EXPECT_LE(Duration::zero(), pressure->some.total);
+
+  EXPECT_ERROR(
+      cgroups::unified::pressure(hierarchy, TEST_CGROUPS_ROOT, "invalid"));
+}
+
+
+// This test verifies that the cgroups under a cgroup are listed with
+// the children before their parents, that the threads of a cgroup are
+// listed, and that the concurrent destroys of a cgroup, e.g., by the
+// Linux launcher and the cgroups isolators, all succeed.
+TEST_F(CgroupsUnifiedTest, ROOT_CGROUPS_UNIFIED_GetThreadsDestroy)
+{
+  const string parent = path::join(TEST_CGROUPS_ROOT, "parent");
+  const string child = path::join(parent, "child");
+
+  ASSERT_SOME(cgroups::unified::create(hierarchy, child));
+
+  Try<vector<string>> cgroups =
+    cgroups::unified::get(hierarchy, TEST_CGROUPS_ROOT);
+
+  ASSERT_SOME(cgroups);
+  ASSERT_EQ(2u, cgroups->size());
+  EXPECT_EQ(strings::trim(child, "/"), cgroups->at(0));
+  EXPECT_EQ(strings::trim(parent, "/"), cgroups->at(1));
+
+  pid_t pid = ::fork();
+  ASSERT_NE(-1, pid);
+
+  if (pid == 0) {
+    // In child process, wait for the kill signal from the parent.
+    while (true) {
+      ::pause();
+    }
+
+    // Should not reach here.
+    abort();
+  }
+
+  ASSERT_SOME(cgroups::unified::assign(hierarchy, child, pid));
+
+  // A single threaded process has a single thread, with its pid.
+  EXPECT_SOME_EQ(set<pid_t>({pid}),
+                 cgroups::unified::threads(hierarchy, child));
+
+  Try<Owned<cgroups::Control>> control =
+    cgroups::Control::open(hierarchy, child, "cgroup.procs", true);
+
+  ASSERT_SOME(control);
+  ASSERT_SOME(control.get()->read());
+  EXPECT_EQ(stringify(pid), strings::trim(control.get()->contents()));
+
+  // The unified hierarchy is not verified as a cgroups v1 hierarchy.
+  EXPECT_ERROR(cgroups::Control::open(hierarchy, child, "cgroup.procs"));
+
+  Future<Nothing> destroy1 = cgroups::unified::destroy(hierarchy, parent);
+  Future<Nothing> destroy2 = cgroups::unified::destroy(hierarchy, parent);
+
+  AWAIT_READY(destroy1);
+  AWAIT_READY(destroy2);
+
+  int status;
+  EXPECT_EQ(pid, ::waitpid(pid, &status, 0));
+  EXPECT_TRUE(WIFSIGNALED(status));
+  EXPECT_EQ(SIGKILL, WTERMSIG(status));
+
+  EXPECT_SOME_FALSE(cgroups::unified::exists(hierarchy, parent));
+}
+
+
+TEST(CgroupsPressureTest, Parse)
+{
+  Try<cgroups::unified::Pressure> pressure =
+    cgroups::unified::Pressure::parse(
+        "some avg10=1.50 avg60=0.75 avg300=0.25 total=123456\n"
+        "full avg10=0.50 avg60=0.00 avg300=0.00 total=1000\n");
+
+  ASSERT_SOME(pressure);
+  EXPECT_DOUBLE_EQ(1.5, pressure->some.avg10);
+  EXPECT_DOUBLE_EQ(0.75, pressure->some.avg60);
+  EXPECT_DOUBLE_EQ(0.25, pressure->some.avg300);
+  EXPECT_EQ(Microseconds(123456), pressure->some.total);
+
+  ASSERT_SOME(pressure->full);
+  EXPECT_DOUBLE_EQ(0.5, pressure->full->avg10);
+  EXPECT_EQ(Milliseconds(1), pressure->full->total);
+
+  // Older kernels only report the 'some' line for the cpu resource.
+  pressure = cgroups::unified::Pressure::parse(
+      "some avg10=0.00 avg60=0.00 avg300=0.00 total=0\n");
+
+  ASSERT_SOME(pressure);
+  EXPECT_NONE(pressure->full);
+
+  EXPECT_ERROR(cgroups::unified::Pressure::parse(""));
+  EXPECT_ERROR(cgroups::unified::Pressure::parse(
+      "some avg10=0.00 avg60=0.00 total=0\n"));
+  EXPECT_ERROR(cgroups::unified::Pressure::parse(
+      "some avg10=x avg60=0.00 avg300=0.00 total=0\n"));
+  EXPECT_ERROR(cgroups::unified::Pressure::parse(
+      "other avg10=0.00 avg60=0.00 avg300=0.00 total=0\n"));
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
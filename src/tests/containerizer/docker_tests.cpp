@@ -16,14 +16,21 @@
 
 #include <gtest/gtest.h>
 
+#include <process/address.hpp>
 #include <process/future.hpp>
 #include <process/gtest.hpp>
 #include <process/owned.hpp>
+#include <process/socket.hpp>
 #include <process/subprocess.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/option.hpp>
 #include <stout/gtest.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/strings.hpp>
+
+#include <stout/tests/utils.hpp>
 
 #include "docker/docker.hpp"
 
@@ -35,6 +42,8 @@
 
 using namespace process;
 
+using process::network::Socket;
+
 using std::list;
 using std::string;
 
@@ -455,6 +464,256 @@ TEST_F(DockerTest, ROOT_DOCKER_MountAbsolute)
 }
 
 
+
+// Tests of the Engine API client against a fake docker daemon that
+// listens on a unix domain socket in the sandbox.
+class DockerEngineTest : public TemporaryDirectoryTest
+{
+protected:
+  virtual void SetUp()
+  {
+    TemporaryDirectoryTest::SetUp();
+
+    socket = path::join(os::getcwd(), "docker.sock");
+
+    Try<network::Address> address = network::Address::create(socket);
+    ASSERT_SOME(address);
+
+    Try<Socket> create = Socket::create(Socket::POLL, None(), AF_UNIX);
+    ASSERT_SOME(create);
+
+    server = create.get();
+
+    ASSERT_SOME(server->bind(address.get()));
+    ASSERT_SOME(server->listen(1));
+  }
+
+  virtual void TearDown()
+  {
+    server = None();
+
+    // The sandbox can only be removed once the socket file is.
+    ASSERT_SOME(os::rm(socket));
+
+    TemporaryDirectoryTest::TearDown();
+  }
+
+  // Reads from 'connection' until 'count' more requests (without
+  // bodies) arrived, and returns them.
+  static Future<string> receive(
+      Socket connection,
+      size_t count,
+      const string& received = "")
+  {
+    size_t requests = 0;
+    for (size_t end = received.find("\r\n\r\n");
+         end != string::npos;
+         end = received.find("\r\n\r\n", end + 4)) {
+      requests++;
+    }
+
+    if (requests >= count) {
+      return received;
+    }
+
+    return connection.recv()
+      .then([=](const string& data) mutable {
+        return receive(connection, count, received + data);
+      });
+  }
+
+  static string response(const string& body)
+  {
+    return "HTTP/1.1 200 OK\r\n"
+           "Content-Length: " + stringify(body.size()) + "\r\n"
+           "\r\n" + body;
+  }
+
+  static string container(const string& name, bool started)
+  {
+    return "{"
+           "\"Id\": \"" + name + "-id\","
+           "\"Name\": \"/" + name + "\","
+           "\"State\": {"
+           "\"Pid\": " + (started ? "42" : "0") + ","
+           "\"StartedAt\": \"" +
+           (started ? "2016-01-01T00:00:00Z" : "0001-01-01T00:00:00Z") +
+           "\"},"
+           "\"NetworkSettings\": {\"IPAddress\": \"\"}"
+           "}";
+  }
+
+  string socket;
+  Option<Socket> server;
+};
+
+
+// Tests that containers get inspected through the Engine API rather
+// than by forking the CLI, which does not exist here.
+TEST_F(DockerEngineTest, Inspect)
+{
+  Try<Docker*> create = Docker::create("/nonexistent/docker", socket, false);
+  ASSERT_SOME(create);
+
+  Owned<Docker> docker(create.get());
+
+  Future<Socket> accept = server->accept();
+
+  Future<Docker::Container> inspect = docker->inspect("mesos-1");
+
+  AWAIT_READY(accept);
+
+  Socket connection = accept.get();
+
+  Future<string> requests = receive(connection, 1);
+  AWAIT_READY(requests);
+  EXPECT_TRUE(strings::startsWith(
+      requests.get(), "GET /containers/mesos-1/json HTTP/1.1\r\n"));
+
+  AWAIT_READY(connection.send(response(container("mesos-1", true))));
+
+  AWAIT_READY(inspect);
+  EXPECT_EQ("mesos-1-id", inspect->id);
+  EXPECT_EQ("/mesos-1", inspect->name);
+  EXPECT_SOME_EQ(42, inspect->pid);
+  EXPECT_TRUE(inspect->started);
+}
+
+
+// Tests that listing containers inspects the containers with the
+// prefix over the same persistent connection.
+TEST_F(DockerEngineTest, Ps)
+{
+  Try<Docker*> create = Docker::create("/nonexistent/docker", socket, false);
+  ASSERT_SOME(create);
+
+  Owned<Docker> docker(create.get());
+
+  Future<Socket> accept = server->accept();
+
+  Future<list<Docker::Container>> ps = docker->ps(true, "mesos-");
+
+  AWAIT_READY(accept);
+
+  Socket connection = accept.get();
+
+  Future<string> requests = receive(connection, 1);
+  AWAIT_READY(requests);
+  EXPECT_TRUE(strings::startsWith(
+      requests.get(), "GET /containers/json?all=1 HTTP/1.1\r\n"));
+
+  AWAIT_READY(connection.send(response(
+      "[{\"Names\": [\"/mesos-1\"]},"
+      " {\"Names\": [\"/other\"]},"
+      " {\"Names\": [\"/mesos-2\"]}]")));
+
+  requests = receive(connection, 2);
+  AWAIT_READY(requests);
+  EXPECT_TRUE(strings::contains(
+      requests.get(), "GET /containers/mesos-1/json HTTP/1.1\r\n"));
+  EXPECT_TRUE(strings::contains(
+      requests.get(), "GET /containers/mesos-2/json HTTP/1.1\r\n"));
+  EXPECT_FALSE(strings::contains(requests.get(), "/containers/other/"));
+
+  AWAIT_READY(connection.send(
+      response(container("mesos-1", true)) +
+      response(container("mesos-2", false))));
+
+  AWAIT_READY(ps);
+  ASSERT_EQ(2u, ps->size());
+  EXPECT_EQ("mesos-1-id", ps->front().id);
+  EXPECT_EQ("mesos-2-id", ps->back().id);
+}
+
+
+// Tests that waiting for a container to start inspects it again on
+// its events rather than after every retry interval.
+TEST_F(DockerEngineTest, InspectUntilStarted)
+{
+  Try<Docker*> create = Docker::create("/nonexistent/docker", socket, false);
+  ASSERT_SOME(create);
+
+  Owned<Docker> docker(create.get());
+
+  Future<Socket> accept = server->accept();
+
+  // Only an event can trigger another inspect within the test.
+  Future<Docker::Container> inspect = docker->inspect("mesos-1", Days(1));
+
+  // The subscription to the events comes first.
+  AWAIT_READY(accept);
+
+  Socket events = accept.get();
+
+  Future<string> requests = receive(events, 1);
+  AWAIT_READY(requests);
+  EXPECT_TRUE(strings::startsWith(requests.get(), "GET /events?filters="));
+
+  accept = server->accept();
+
+  AWAIT_READY(events.send(
+      "HTTP/1.1 200 OK\r\n"
+      "Transfer-Encoding: chunked\r\n"
+      "\r\n"));
+
+  AWAIT_READY(accept);
+
+  Socket connection = accept.get();
+
+  requests = receive(connection, 1);
+  AWAIT_READY(requests);
+  EXPECT_TRUE(strings::startsWith(
+      requests.get(), "GET /containers/mesos-1/json HTTP/1.1\r\n"));
+
+  AWAIT_READY(connection.send(response(container("mesos-1", false))));
+
+  const string event = "{\"status\": \"start\", \"id\": \"mesos-1-id\"}\n";
+
+  std::ostringstream chunk;
+  chunk << std::hex << event.size() << "\r\n" << event << "\r\n";
+
+  requests = receive(connection, 1);
+
+  AWAIT_READY(events.send(chunk.str()));
+
+  AWAIT_READY(requests);
+  EXPECT_TRUE(strings::startsWith(
+      requests.get(), "GET /containers/mesos-1/json HTTP/1.1\r\n"));
+
+  AWAIT_READY(connection.send(response(container("mesos-1", true))));
+
+  AWAIT_READY(inspect);
+  EXPECT_TRUE(inspect->started);
+}
+
+
+// Tests that the CLI is used if the daemon can not be reached through
+// the Engine API.
+TEST_F(DockerEngineTest, FallbackToCLI)
+{
+  const string cli = path::join(os::getcwd(), "docker");
+
+  ASSERT_SOME(os::write(
+      cli,
+      "#!/bin/sh\n"
+      "echo '[" + container("mesos-1", true) + "]'\n"));
+
+  ASSERT_EQ(0, ::chmod(cli.c_str(), S_IRWXU));
+
+  // Nothing accepts connections on a socket that does not exist.
+  Try<Docker*> create = Docker::create(
+      cli, path::join(os::getcwd(), "nonexistent.sock"), false);
+
+  ASSERT_SOME(create);
+
+  Owned<Docker> docker(create.get());
+
+  Future<Docker::Container> inspect = docker->inspect("mesos-1");
+
+  AWAIT_READY(inspect);
+  EXPECT_EQ("mesos-1-id", inspect->id);
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -14,8 +14,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
 
+#include <sys/stat.h>
+
+#include <deque>
 #include <string>
 #include <vector>
 #include <map>
@@ -24,11 +29,18 @@
 
 #include <mesos/resources.hpp>
 
+#include <mesos/containerizer/containerizer.hpp>
+
 #include <process/future.hpp>
 
+#include <stout/duration.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
 
+#include "common/recordio.hpp"
+
 #include "master/master.hpp"
 #include "master/detector.hpp"
 
@@ -45,8 +57,10 @@ using namespace process;
 
 using mesos::internal::master::Master;
 using mesos::internal::slave::Containerizer;
+using mesos::internal::slave::ExternalContainerizer;
 using mesos::internal::slave::Slave;
 
+using std::deque;
 using std::string;
 using std::vector;
 
@@ -259,6 +273,471 @@ TEST_F(ExternalContainerizerTest, DISABLED_Launch)
 
 #endif // MESOS_HAS_PYTHON
 
+
+// The daemon tests start a fake external containerizer daemon, a
+// script which relays the calls from its stdin into a FIFO and the
+// responses from another FIFO to its stdout. The test plays the
+// daemon by reading the calls and writing the responses, which lets
+// it control their order and timing.
+class ExternalContainerizerDaemonTest : public MesosTest
+{
+public:
+  ExternalContainerizerDaemonTest()
+    : encoder([](const containerizer::Response& response) {
+        return response.SerializeAsString();
+      }),
+      decoder([](const string& data) -> Try<containerizer::Call> {
+        containerizer::Call call;
+        if (!call.ParseFromString(data)) {
+          return Error("Failed to parse the call");
+        }
+        return call;
+      }),
+      callsFd(-1),
+      responsesFd(-1) {}
+
+protected:
+  virtual void SetUp()
+  {
+    MesosTest::SetUp();
+
+    calls = path::join(os::getcwd(), "calls");
+    responses = path::join(os::getcwd(), "responses");
+
+    ASSERT_EQ(0, ::mkfifo(calls.c_str(), S_IRUSR | S_IWUSR));
+    ASSERT_EQ(0, ::mkfifo(responses.c_str(), S_IRUSR | S_IWUSR));
+
+    // Opening the FIFOs for both reading and writing does not block
+    // until the daemon opens their other ends. They must not leak
+    // into the daemon as it would then never see the end of the
+    // responses.
+    callsFd = ::open(calls.c_str(), O_RDWR | O_CLOEXEC);
+    ASSERT_NE(-1, callsFd);
+
+    responsesFd = ::open(responses.c_str(), O_RDWR | O_CLOEXEC);
+    ASSERT_NE(-1, responsesFd);
+
+    // The daemon exits once the responses are closed, see 'exit'.
+    // NOTE: The stdin of a background command is '/dev/null' unless
+    // it is redirected explicitly.
+    const string script = path::join(os::getcwd(), "daemon");
+
+    ASSERT_SOME(os::write(
+        script,
+        "#!/bin/sh\n"
+        "exec 3<&0\n"
+        "cat <&3 >" + calls + " &\n"
+        "cat " + responses + "\n"
+        "kill $! 2>/dev/null\n"));
+
+    ASSERT_SOME(os::chmod(script, S_IRWXU));
+
+    flags = CreateSlaveFlags();
+    flags.containerizer_path = script;
+    flags.external_containerizer_daemon = true;
+  }
+
+  virtual void TearDown()
+  {
+    exit();
+
+    if (callsFd != -1) {
+      os::close(callsFd);
+    }
+
+    // The sandbox removal skips the FIFOs.
+    os::rm(calls);
+    os::rm(responses);
+
+    MesosTest::TearDown();
+  }
+
+  // Returns the next call of the containerizer to the daemon.
+  Try<containerizer::Call> receive()
+  {
+    while (pending.empty()) {
+      struct pollfd pollfd;
+      pollfd.fd = callsFd;
+      pollfd.events = POLLIN;
+      pollfd.revents = 0;
+
+      int result =
+        ::poll(&pollfd, 1, static_cast<int>(Seconds(15).ms()));
+      if (result == -1) {
+        return ErrnoError("Failed to poll the calls");
+      } else if (result == 0) {
+        return Error("Timed out waiting for a call");
+      }
+
+      char data[4096];
+      ssize_t length = ::read(callsFd, data, sizeof(data));
+      if (length <= 0) {
+        return ErrnoError("Failed to read the calls");
+      }
+
+      Try<deque<Try<containerizer::Call>>> records =
+        decoder.decode(string(data, length));
+
+      if (records.isError()) {
+        return Error(records.error());
+      }
+
+      foreach (const Try<containerizer::Call>& call, records.get()) {
+        if (call.isError()) {
+          return Error(call.error());
+        }
+        pending.push_back(call.get());
+      }
+    }
+
+    containerizer::Call call = pending.front();
+    pending.pop_front();
+    return call;
+  }
+
+  // Answers all the given calls at once.
+  void respond(const vector<containerizer::Response>& responses)
+  {
+    string data;
+    foreach (const containerizer::Response& response, responses) {
+      data += encoder.encode(response);
+    }
+
+    ASSERT_SOME(os::write(responsesFd, data));
+  }
+
+  void respond(const containerizer::Response& response)
+  {
+    respond(vector<containerizer::Response>({response}));
+  }
+
+  // Makes the daemon exit.
+  void exit()
+  {
+    if (responsesFd != -1) {
+      os::close(responsesFd);
+      responsesFd = -1;
+    }
+  }
+
+  // Answers the calls of the containerizer recovery, which finds no
+  // containers.
+  void recover(ExternalContainerizer* containerizer)
+  {
+    Future<Nothing> recover = containerizer->recover(None());
+
+    Try<containerizer::Call> call = receive();
+    ASSERT_SOME(call);
+    ASSERT_EQ(containerizer::Call::RECOVER, call.get().type());
+
+    containerizer::Response response;
+    response.set_id(call.get().id());
+    respond(response);
+
+    call = receive();
+    ASSERT_SOME(call);
+    ASSERT_EQ(containerizer::Call::CONTAINERS, call.get().type());
+
+    response.set_id(call.get().id());
+    response.mutable_containers();
+    respond(response);
+
+    AWAIT_READY(recover);
+  }
+
+  Future<bool> launch(
+      ExternalContainerizer* containerizer,
+      const ContainerID& containerId)
+  {
+    const string directory = path::join(os::getcwd(), containerId.value());
+    CHECK_SOME(os::mkdir(directory));
+
+    SlaveID slaveId;
+    slaveId.set_value("slave");
+
+    return containerizer->launch(
+        containerId,
+        DEFAULT_EXECUTOR_INFO,
+        directory,
+        None(),
+        slaveId,
+        PID<Slave>(),
+        false);
+  }
+
+  slave::Flags flags;
+
+private:
+  ::recordio::Encoder<containerizer::Response> encoder;
+  ::recordio::Decoder<containerizer::Call> decoder;
+
+  // The paths of the FIFOs.
+  string calls;
+  string responses;
+
+  // The calls which have been read but not yet received.
+  deque<containerizer::Call> pending;
+
+  int callsFd;
+  int responsesFd;
+};
+
+
+// This test verifies that the responses of the daemon are matched to
+// their calls by id rather than by their order.
+TEST_F(ExternalContainerizerDaemonTest, OutOfOrderResponses)
+{
+  ExternalContainerizer containerizer(flags);
+
+  recover(&containerizer);
+
+  ContainerID containerId1;
+  containerId1.set_value("container1");
+
+  ContainerID containerId2;
+  containerId2.set_value("container2");
+
+  Future<bool> launch1 = launch(&containerizer, containerId1);
+  Future<bool> launch2 = launch(&containerizer, containerId2);
+
+  Try<containerizer::Call> call1 = receive();
+  ASSERT_SOME(call1);
+  ASSERT_EQ(containerizer::Call::LAUNCH, call1.get().type());
+  EXPECT_EQ(containerId1, call1.get().launch().container_id());
+
+  Try<containerizer::Call> call2 = receive();
+  ASSERT_SOME(call2);
+  ASSERT_EQ(containerizer::Call::LAUNCH, call2.get().type());
+  EXPECT_EQ(containerId2, call2.get().launch().container_id());
+
+  EXPECT_NE(call1.get().id(), call2.get().id());
+
+  // A response to an unknown call is ignored.
+  containerizer::Response response;
+  response.set_id(call2.get().id() + 1);
+  respond(response);
+
+  response.set_id(call2.get().id());
+  respond(response);
+
+  AWAIT_EXPECT_EQ(true, launch2);
+  EXPECT_TRUE(launch1.isPending());
+
+  response.set_id(call1.get().id());
+  response.set_error("Failed to launch");
+  respond(response);
+
+  AWAIT_EXPECT_FAILED(launch1);
+}
+
+
+// This test verifies that an outstanding 'wait' does not hold up
+// other calls and that it is answered once the container terminates.
+TEST_F(ExternalContainerizerDaemonTest, OutstandingWait)
+{
+  ExternalContainerizer containerizer(flags);
+
+  recover(&containerizer);
+
+  ContainerID containerId;
+  containerId.set_value("container");
+
+  Future<bool> launch = this->launch(&containerizer, containerId);
+
+  Try<containerizer::Call> call = receive();
+  ASSERT_SOME(call);
+  ASSERT_EQ(containerizer::Call::LAUNCH, call.get().type());
+
+  containerizer::Response response;
+  response.set_id(call.get().id());
+  respond(response);
+
+  AWAIT_EXPECT_EQ(true, launch);
+
+  Future<containerizer::Termination> wait = containerizer.wait(containerId);
+
+  Try<containerizer::Call> waitCall = receive();
+  ASSERT_SOME(waitCall);
+  ASSERT_EQ(containerizer::Call::WAIT, waitCall.get().type());
+  EXPECT_EQ(containerId, waitCall.get().wait().container_id());
+
+  // Waiting again does not call the daemon a second time, hence the
+  // next call is the update.
+  Future<containerizer::Termination> wait2 = containerizer.wait(containerId);
+
+  Future<Nothing> update = containerizer.update(
+      containerId,
+      Resources::parse("cpus:1;mem:64").get());
+
+  call = receive();
+  ASSERT_SOME(call);
+  ASSERT_EQ(containerizer::Call::UPDATE, call.get().type());
+
+  response.set_id(call.get().id());
+  respond(response);
+
+  AWAIT_READY(update);
+
+  EXPECT_TRUE(wait.isPending());
+  EXPECT_TRUE(wait2.isPending());
+
+  response.set_id(waitCall.get().id());
+  response.mutable_termination()->set_status(0);
+  respond(response);
+
+  AWAIT_READY(wait);
+  EXPECT_EQ(0, wait.get().status());
+
+  AWAIT_READY(wait2);
+  EXPECT_EQ(0, wait2.get().status());
+
+  // The container is gone once it has been waited on.
+  AWAIT_EXPECT_FAILED(containerizer.usage(containerId));
+}
+
+
+// This test verifies that the usages of several containers are
+// gathered by a single call to the daemon.
+TEST_F(ExternalContainerizerDaemonTest, BatchedUsage)
+{
+  ExternalContainerizer containerizer(flags);
+
+  recover(&containerizer);
+
+  ContainerID containerId1;
+  containerId1.set_value("container1");
+
+  ContainerID containerId2;
+  containerId2.set_value("container2");
+
+  Future<bool> launch1 = launch(&containerizer, containerId1);
+  Future<bool> launch2 = launch(&containerizer, containerId2);
+
+  Try<containerizer::Call> call1 = receive();
+  ASSERT_SOME(call1);
+  ASSERT_EQ(containerizer::Call::LAUNCH, call1.get().type());
+
+  Try<containerizer::Call> call2 = receive();
+  ASSERT_SOME(call2);
+  ASSERT_EQ(containerizer::Call::LAUNCH, call2.get().type());
+
+  // The usages are deferred until the containers are launched, which
+  // the daemon then confirms at once so that the usages are queued
+  // up together.
+  Future<ResourceStatistics> usage1 = containerizer.usage(containerId1);
+  Future<ResourceStatistics> usage2 = containerizer.usage(containerId2);
+
+  containerizer::Response response1;
+  response1.set_id(call1.get().id());
+
+  containerizer::Response response2;
+  response2.set_id(call2.get().id());
+
+  respond({response1, response2});
+
+  AWAIT_EXPECT_EQ(true, launch1);
+  AWAIT_EXPECT_EQ(true, launch2);
+
+  Try<containerizer::Call> call = receive();
+  ASSERT_SOME(call);
+  ASSERT_EQ(containerizer::Call::USAGE, call.get().type());
+  ASSERT_EQ(2, call.get().usage_size());
+
+  hashset<ContainerID> containerIds;
+  containerIds.insert(call.get().usage(0));
+  containerIds.insert(call.get().usage(1));
+
+  EXPECT_TRUE(containerIds.contains(containerId1));
+  EXPECT_TRUE(containerIds.contains(containerId2));
+
+  containerizer::Response response;
+  response.set_id(call.get().id());
+
+  containerizer::Response::Statistics* statistics = response.add_usage();
+  statistics->mutable_container_id()->CopyFrom(containerId1);
+  statistics->mutable_statistics()->set_timestamp(1);
+  statistics->mutable_statistics()->set_mem_rss_bytes(1024);
+
+  statistics = response.add_usage();
+  statistics->mutable_container_id()->CopyFrom(containerId2);
+  statistics->mutable_statistics()->set_timestamp(2);
+  statistics->mutable_statistics()->set_mem_rss_bytes(2048);
+
+  respond(response);
+
+  AWAIT_READY(usage1);
+  EXPECT_EQ(1024u, usage1.get().mem_rss_bytes());
+
+  AWAIT_READY(usage2);
+  EXPECT_EQ(2048u, usage2.get().mem_rss_bytes());
+
+  // A container the daemon omits from its response fails its usage.
+  usage1 = containerizer.usage(containerId1);
+
+  call = receive();
+  ASSERT_SOME(call);
+  ASSERT_EQ(containerizer::Call::USAGE, call.get().type());
+  ASSERT_EQ(1, call.get().usage_size());
+  EXPECT_EQ(containerId1, call.get().usage(0));
+
+  response.Clear();
+  response.set_id(call.get().id());
+  respond(response);
+
+  AWAIT_EXPECT_FAILED(usage1);
+}
+
+
+// This test verifies that all outstanding and subsequent calls fail
+// once the daemon exits.
+TEST_F(ExternalContainerizerDaemonTest, DaemonExit)
+{
+  ExternalContainerizer containerizer(flags);
+
+  recover(&containerizer);
+
+  ContainerID containerId;
+  containerId.set_value("container");
+
+  Future<bool> launch = this->launch(&containerizer, containerId);
+
+  Try<containerizer::Call> call = receive();
+  ASSERT_SOME(call);
+  ASSERT_EQ(containerizer::Call::LAUNCH, call.get().type());
+
+  containerizer::Response response;
+  response.set_id(call.get().id());
+  respond(response);
+
+  AWAIT_EXPECT_EQ(true, launch);
+
+  Future<containerizer::Termination> wait = containerizer.wait(containerId);
+
+  call = receive();
+  ASSERT_SOME(call);
+  ASSERT_EQ(containerizer::Call::WAIT, call.get().type());
+
+  Future<Nothing> update = containerizer.update(
+      containerId,
+      Resources::parse("cpus:1;mem:64").get());
+
+  call = receive();
+  ASSERT_SOME(call);
+  ASSERT_EQ(containerizer::Call::UPDATE, call.get().type());
+
+  exit();
+
+  AWAIT_EXPECT_FAILED(wait);
+  AWAIT_EXPECT_FAILED(update);
+
+  AWAIT_EXPECT_FAILED(containerizer.containers());
+
+  ContainerID containerId2;
+  containerId2.set_value("container2");
+
+  AWAIT_EXPECT_FAILED(this->launch(&containerizer, containerId2));
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
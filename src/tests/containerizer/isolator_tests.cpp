@@ -903,6 +903,74 @@ TEST_F(PerfEventIsolatorTest, ROOT_CGROUPS_Sample)
 }
 
 
+// Tests that the native sampler counts the events of a container
+// without running perf, with samples that cover the whole interval.
+TEST_F(PerfEventIsolatorTest, ROOT_CGROUPS_NativeSample)
+{
+  slave::Flags flags;
+
+  flags.perf_events = "cycles,task-clock";
+  flags.perf_interval = Milliseconds(250);
+  flags.perf_sampler = "native";
+
+  Try<Isolator*> isolator = CgroupsPerfEventIsolatorProcess::create(flags);
+  ASSERT_SOME(isolator);
+
+  ExecutorInfo executorInfo;
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  // Use a relative temporary directory so it gets cleaned up
+  // automatically with the test.
+  Try<string> dir = os::mkdtemp(path::join(os::getcwd(), "XXXXXX"));
+  ASSERT_SOME(dir);
+
+  AWAIT_READY(isolator.get()->prepare(
+      containerId,
+      executorInfo,
+      dir.get(),
+      None()));
+
+  Future<ResourceStatistics> statistics1 = isolator.get()->usage(containerId);
+  AWAIT_READY(statistics1);
+  ASSERT_TRUE(statistics1.get().has_perf());
+
+  // Wait until we get the next sample.
+  ResourceStatistics statistics2;
+  Duration waited = Duration::zero();
+  do {
+    Future<ResourceStatistics> statistics = isolator.get()->usage(containerId);
+    AWAIT_READY(statistics);
+
+    statistics2 = statistics.get();
+
+    ASSERT_TRUE(statistics2.has_perf());
+
+    if (statistics1.get().perf().timestamp() !=
+        statistics2.perf().timestamp()) {
+      break;
+    }
+
+    os::sleep(Milliseconds(50));
+    waited += Milliseconds(50);
+  } while (waited < Seconds(2));
+
+  EXPECT_NE(statistics1.get().perf().timestamp(),
+            statistics2.perf().timestamp());
+
+  // A sample covers the time since the previous one.
+  EXPECT_LT(0.0, statistics2.perf().duration());
+
+  EXPECT_TRUE(statistics2.perf().has_cycles());
+  EXPECT_TRUE(statistics2.perf().has_task_clock());
+
+  AWAIT_READY(isolator.get()->cleanup(containerId));
+
+  delete isolator.get();
+}
+
+
 class SharedFilesystemIsolatorTest : public MesosTest {};
 
 
@@ -1318,6 +1386,235 @@ TYPED_TEST(UserCgroupIsolatorTest, ROOT_CGROUPS_UserCgroup)
 
   delete isolator.get();
 }
+
+
+// A fixture for the tests of the cgroups isolators in the unified
+// hierarchy (cgroups v2), see the '--cgroups_unified' flag.
+class UnifiedCgroupsIsolatorTest : public MesosTest
+{
+protected:
+  virtual void SetUp()
+  {
+    MesosTest::SetUp();
+
+    flags.cgroups_unified = true;
+    flags.cgroups_root = TEST_CGROUPS_ROOT;
+  }
+
+  virtual void TearDown()
+  {
+    Result<string> hierarchy = cgroups::unified::hierarchy();
+    ASSERT_FALSE(hierarchy.isError());
+
+    if (hierarchy.isSome()) {
+      Try<bool> exists =
+        cgroups::unified::exists(hierarchy.get(), TEST_CGROUPS_ROOT);
+      ASSERT_SOME(exists);
+
+      if (exists.get()) {
+        AWAIT_READY(
+            cgroups::unified::destroy(hierarchy.get(), TEST_CGROUPS_ROOT));
+      }
+    }
+
+    MesosTest::TearDown();
+  }
+
+  // Returns the trimmed contents of a control file of the cgroup of a
+  // container.
+  Try<string> read(const ContainerID& containerId, const string& control)
+  {
+    Result<string> hierarchy = cgroups::unified::hierarchy();
+    if (!hierarchy.isSome()) {
+      return Error("The unified hierarchy is not mounted");
+    }
+
+    Try<Owned<cgroups::Control>> open = cgroups::Control::open(
+        hierarchy.get(),
+        path::join(TEST_CGROUPS_ROOT, containerId.value()),
+        control,
+        true);
+
+    if (open.isError()) {
+      return Error(open.error());
+    }
+
+    Try<Nothing> read = open.get()->read();
+    if (read.isError()) {
+      return Error(read.error());
+    }
+
+    return strings::trim(open.get()->contents());
+  }
+
+  slave::Flags flags;
+};
+
+
+// This test verifies that the cpu isolator sets the weight and the
+// bandwidth limit of a container sharing its cgroup with the Linux
+// launcher, and reports the cpu usage and pressure.
+TEST_F(UnifiedCgroupsIsolatorTest, ROOT_CGROUPS_UNIFIED_CPU_Update)
+{
+  flags.cgroups_enable_cfs = true;
+
+  Try<Isolator*> isolator = CgroupsCpushareIsolatorProcess::create(flags);
+  ASSERT_SOME(isolator);
+
+  Try<Launcher*> launcher = LinuxLauncher::create(flags);
+  ASSERT_SOME(launcher);
+
+  ExecutorInfo executorInfo;
+  executorInfo.mutable_resources()->CopyFrom(
+      Resources::parse("cpus:0.5").get());
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  Try<string> dir = os::mkdtemp(path::join(os::getcwd(), "XXXXXX"));
+  ASSERT_SOME(dir);
+
+  AWAIT_READY(isolator.get()->prepare(
+      containerId,
+      executorInfo,
+      dir.get(),
+      None()));
+
+  // The 512 shares of 0.5 cpus map to a weight of 20.
+  EXPECT_SOME_EQ("20", read(containerId, "cpu.weight"));
+  EXPECT_SOME_EQ("50000 100000", read(containerId, "cpu.max"));
+
+  vector<string> argv(3);
+  argv[0] = "sh";
+  argv[1] = "-c";
+  argv[2] = "sleep 1000";
+
+  Try<pid_t> pid = launcher.get()->fork(
+      containerId,
+      "sh",
+      argv,
+      Subprocess::PATH("/dev/null"),
+      Subprocess::FD(STDOUT_FILENO),
+      Subprocess::FD(STDERR_FILENO),
+      None(),
+      None(),
+      None(),
+      0);
+
+  ASSERT_SOME(pid);
+
+  Future<Option<int>> status = process::reap(pid.get());
+
+  AWAIT_READY(isolator.get()->isolate(containerId, pid.get()));
+
+  Resources resources = Resources::parse("cpus:1").get();
+  AWAIT_READY(isolator.get()->update(containerId, resources));
+
+  // The 1024 shares of 1 cpu map to a weight of 39.
+  EXPECT_SOME_EQ("39", read(containerId, "cpu.weight"));
+  EXPECT_SOME_EQ("100000 100000", read(containerId, "cpu.max"));
+
+  Future<ResourceStatistics> usage = isolator.get()->usage(containerId);
+  AWAIT_READY(usage);
+
+  EXPECT_TRUE(usage.get().has_cpus_user_time_secs());
+  EXPECT_TRUE(usage.get().has_cpus_system_time_secs());
+  EXPECT_TRUE(usage.get().has_cpus_nr_periods());
+
+  // The kernel may not support PSI, or have it disabled.
+  if (read(containerId, "cpu.pressure").isSome()) {
+    EXPECT_TRUE(usage.get().has_cpus_pressure_some_total_secs());
+  }
+
+  AWAIT_READY(launcher.get()->destroy(containerId));
+  AWAIT_READY(status);
+
+  // The launcher has removed the cgroup already.
+  AWAIT_READY(isolator.get()->cleanup(containerId));
+
+  delete isolator.get();
+  delete launcher.get();
+}
+
+
+// This test verifies that the memory isolator sets the limits of a
+// container, reports its memory usage and pressure, and reports the
+// memory limitation when the OOM killer kills one of its processes.
+TEST_F(UnifiedCgroupsIsolatorTest, ROOT_CGROUPS_UNIFIED_MEM_OomLimitation)
+{
+  // Swapping would keep the memory of the helper under the limit.
+  Try<string> swaps = os::read("/proc/swaps");
+  ASSERT_SOME(swaps);
+
+  flags.cgroups_limit_swap =
+    strings::split(strings::trim(swaps.get()), "\n").size() > 1;
+
+  Try<Isolator*> isolator = CgroupsMemIsolatorProcess::create(flags);
+  ASSERT_SOME(isolator);
+
+  ExecutorInfo executorInfo;
+  executorInfo.mutable_resources()->CopyFrom(
+      Resources::parse("mem:64").get());
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  Try<string> dir = os::mkdtemp(path::join(os::getcwd(), "XXXXXX"));
+  ASSERT_SOME(dir);
+
+  AWAIT_READY(isolator.get()->prepare(
+      containerId,
+      executorInfo,
+      dir.get(),
+      None()));
+
+  const string limit = stringify(Megabytes(64).bytes());
+
+  EXPECT_SOME_EQ(limit, read(containerId, "memory.max"));
+  EXPECT_SOME_EQ(limit, read(containerId, "memory.low"));
+
+  if (flags.cgroups_limit_swap) {
+    EXPECT_SOME_EQ("0", read(containerId, "memory.swap.max"));
+  }
+
+  Future<mesos::slave::ContainerLimitation> limitation =
+    isolator.get()->watch(containerId);
+
+  MemoryTestHelper helper;
+  ASSERT_SOME(helper.spawn());
+  ASSERT_SOME(helper.pid());
+
+  Future<Option<int>> status = process::reap(helper.pid().get());
+
+  AWAIT_READY(isolator.get()->isolate(containerId, helper.pid().get()));
+
+  EXPECT_SOME(helper.increaseRSS(Megabytes(16)));
+
+  Future<ResourceStatistics> usage = isolator.get()->usage(containerId);
+  AWAIT_READY(usage);
+
+  EXPECT_LE(Megabytes(16).bytes(), usage.get().mem_total_bytes());
+  EXPECT_LE(Megabytes(16).bytes(), usage.get().mem_anon_bytes());
+
+  // The kernel may not support PSI, or have it disabled.
+  if (read(containerId, "memory.pressure").isSome()) {
+    EXPECT_TRUE(usage.get().has_mem_pressure_some_total_secs());
+    EXPECT_TRUE(usage.get().has_mem_pressure_full_total_secs());
+  }
+
+  // The OOM killer kills the helper when it exceeds the limit.
+  EXPECT_ERROR(helper.increaseRSS(Megabytes(128)));
+
+  AWAIT_READY(limitation);
+  EXPECT_EQ(TaskStatus::REASON_CONTAINER_LIMITATION_MEMORY,
+            limitation.get().reason());
+
+  AWAIT_READY(status);
+
+  AWAIT_READY(isolator.get()->cleanup(containerId));
+
+  delete isolator.get();
+}
 #endif // __linux__
 
 } // namespace tests {
@@ -0,0 +1,607 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <sys/wait.h>
+
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <process/future.hpp>
+#include <process/gtest.hpp>
+#include <process/reap.hpp>
+#include <process/subprocess.hpp>
+
+#include <stout/gtest.hpp>
+#include <stout/hashset.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/strings.hpp>
+#include <stout/uuid.hpp>
+
+#include <stout/tests/utils.hpp>
+
+#include "linux/cgroups.hpp"
+
+#include "slave/flags.hpp"
+
+#include "slave/containerizer/mesos/launcher.hpp"
+#include "slave/containerizer/mesos/linux_launcher.hpp"
+#include "slave/containerizer/mesos/zygote.hpp"
+
+#include "tests/flags.hpp"
+#include "tests/mesos.hpp" // For TEST_CGROUPS_ROOT.
+
+using namespace process;
+
+using mesos::internal::slave::Launcher;
+using mesos::internal::slave::LinuxLauncher;
+using mesos::internal::slave::MesosContainerizerZygote;
+using mesos::internal::slave::Zygote;
+
+using mesos::slave::ContainerState;
+
+using std::list;
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace tests {
+
+// A fixture for the tests of the Linux launcher in the unified
+// hierarchy (cgroups v2), see the '--cgroups_unified' flag. The
+// launcher needs no controllers, so these tests also run on the hosts
+// with the controllers attached to cgroups v1 hierarchies.
+class LinuxLauncherUnifiedTest : public TemporaryDirectoryTest
+{
+protected:
+  virtual void SetUp()
+  {
+    TemporaryDirectoryTest::SetUp();
+
+    ASSERT_TRUE(cgroups::unified::enabled())
+      << "-------------------------------------------------------------\n"
+      << "We cannot run any unified hierarchy tests because the kernel\n"
+      << "does not support cgroups v2. You can disable this test case\n"
+      << "(i.e., --gtest_filter=-LinuxLauncherUnifiedTest.*).\n"
+      << "-------------------------------------------------------------";
+
+    flags.cgroups_unified = true;
+    flags.cgroups_root = TEST_CGROUPS_ROOT;
+
+    Try<Launcher*> create = LinuxLauncher::create(flags);
+    ASSERT_SOME(create);
+
+    launcher.reset(create.get());
+
+    // The launcher has mounted the unified hierarchy if needed.
+    Result<string> mounted = cgroups::unified::hierarchy();
+    ASSERT_SOME(mounted);
+
+    hierarchy = mounted.get();
+  }
+
+  virtual void TearDown()
+  {
+    launcher.reset();
+
+    if (!hierarchy.empty()) {
+      Try<bool> exists =
+        cgroups::unified::exists(hierarchy, TEST_CGROUPS_ROOT);
+      ASSERT_SOME(exists);
+
+      if (exists.get()) {
+        AWAIT_READY(cgroups::unified::destroy(hierarchy, TEST_CGROUPS_ROOT));
+      }
+    }
+
+    TemporaryDirectoryTest::TearDown();
+  }
+
+  Try<pid_t> fork(const ContainerID& containerId, const string& command)
+  {
+    vector<string> argv(3);
+    argv[0] = "sh";
+    argv[1] = "-c";
+    argv[2] = command;
+
+    return launcher->fork(
+        containerId,
+        "sh",
+        argv,
+        Subprocess::PATH("/dev/null"),
+        Subprocess::FD(STDOUT_FILENO),
+        Subprocess::FD(STDERR_FILENO),
+        None(),
+        None(),
+        None(),
+        0);
+  }
+
+  slave::Flags flags;
+  Owned<Launcher> launcher;
+  string hierarchy;
+};
+
+
+// This test verifies that the launcher puts the process of a container
+// into the cgroup of the container, and that destroying the container
+// kills the process and removes the cgroup.
+TEST_F(LinuxLauncherUnifiedTest, ROOT_CGROUPS_UNIFIED_ForkDestroy)
+{
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  Try<pid_t> pid = fork(containerId, "sleep 1000");
+  ASSERT_SOME(pid);
+
+  Future<Option<int>> status = process::reap(pid.get());
+
+  const string cgroup = path::join(TEST_CGROUPS_ROOT, containerId.value());
+
+  Try<set<pid_t>> processes = cgroups::unified::processes(hierarchy, cgroup);
+  ASSERT_SOME(processes);
+  EXPECT_EQ(1u, processes->count(pid.get()));
+
+  EXPECT_SOME_TRUE(cgroups::unified::populated(hierarchy, cgroup));
+
+  AWAIT_READY(launcher->destroy(containerId));
+
+  AWAIT_READY(status);
+  ASSERT_SOME(status.get());
+  EXPECT_TRUE(WIFSIGNALED(status.get().get()));
+  EXPECT_EQ(SIGKILL, WTERMSIG(status.get().get()));
+
+  EXPECT_SOME_FALSE(cgroups::unified::exists(hierarchy, cgroup));
+}
+
+
+// This test verifies that the cgroup of a container whose processes
+// have all exited is not populated and is removed on destroy.
+TEST_F(LinuxLauncherUnifiedTest, ROOT_CGROUPS_UNIFIED_DestroyExited)
+{
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  Try<pid_t> pid = fork(containerId, "exit 3");
+  ASSERT_SOME(pid);
+
+  Future<Option<int>> status = process::reap(pid.get());
+
+  AWAIT_READY(status);
+  ASSERT_SOME(status.get());
+  EXPECT_TRUE(WIFEXITED(status.get().get()));
+  EXPECT_EQ(3, WEXITSTATUS(status.get().get()));
+
+  const string cgroup = path::join(TEST_CGROUPS_ROOT, containerId.value());
+
+  EXPECT_SOME_FALSE(cgroups::unified::populated(hierarchy, cgroup));
+
+  AWAIT_READY(launcher->destroy(containerId));
+
+  EXPECT_SOME_FALSE(cgroups::unified::exists(hierarchy, cgroup));
+}
+
+
+// This test verifies that a new launcher reports the cgroups of the
+// unknown containers in the unified hierarchy as orphans, which it
+// can then destroy.
+TEST_F(LinuxLauncherUnifiedTest, ROOT_CGROUPS_UNIFIED_RecoverOrphan)
+{
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  Try<pid_t> pid = fork(containerId, "sleep 1000");
+  ASSERT_SOME(pid);
+
+  Future<Option<int>> status = process::reap(pid.get());
+
+  Try<Launcher*> create = LinuxLauncher::create(flags);
+  ASSERT_SOME(create);
+
+  Owned<Launcher> recovered(create.get());
+
+  Future<hashset<ContainerID>> orphans =
+    recovered->recover(list<ContainerState>());
+
+  AWAIT_READY(orphans);
+  EXPECT_EQ(1u, orphans.get().size());
+  EXPECT_TRUE(orphans.get().contains(containerId));
+
+  AWAIT_READY(recovered->destroy(containerId));
+
+  AWAIT_READY(status);
+  ASSERT_SOME(status.get());
+  EXPECT_TRUE(WIFSIGNALED(status.get().get()));
+
+  EXPECT_SOME_FALSE(cgroups::unified::exists(
+      hierarchy,
+      path::join(TEST_CGROUPS_ROOT, containerId.value())));
+}
+
+
+// A fixture for the tests of the Linux launcher with the zygote, see
+// the '--launcher_zygote' flag.
+//
+// The zygote clones the processes with its own environment, i.e., the
+// one of the agent when the zygote was started, unless the launch has
+// an environment. The tests tell the zygote clones from the direct
+// clones of the launcher by changing an environment variable after
+// the zygote has started.
+class LinuxLauncherZygoteTest : public TemporaryDirectoryTest
+{
+protected:
+  virtual void SetUp()
+  {
+    TemporaryDirectoryTest::SetUp();
+
+    os::setenv(VARIABLE, "zygote");
+
+    flags.launcher_zygote = true;
+    flags.launcher_dir = path::join(tests::flags.build_dir, "src");
+    flags.cgroups_root = TEST_CGROUPS_ROOT;
+
+    Try<Launcher*> create = LinuxLauncher::create(flags);
+    ASSERT_SOME(create);
+
+    launcher.reset(create.get());
+
+    os::setenv(VARIABLE, "agent");
+  }
+
+  virtual void TearDown()
+  {
+    launcher.reset();
+
+    os::unsetenv(VARIABLE);
+
+    // Remove the cgroups of the launcher, and the 'pids' cgroup of
+    // the zygote, see below.
+    const vector<string> subsystems = {"freezer", "pids"};
+
+    foreach (const string& subsystem, subsystems) {
+      Result<string> hierarchy = cgroups::hierarchy(subsystem);
+      ASSERT_FALSE(hierarchy.isError());
+
+      if (hierarchy.isSome()) {
+        Try<bool> exists =
+          cgroups::exists(hierarchy.get(), TEST_CGROUPS_ROOT);
+        ASSERT_SOME(exists);
+
+        if (exists.get()) {
+          AWAIT_READY(cgroups::destroy(hierarchy.get(), TEST_CGROUPS_ROOT));
+        }
+      }
+    }
+
+    TemporaryDirectoryTest::TearDown();
+  }
+
+  // Launches the shell command in a new container, with its stdin from
+  // '/dev/null' and its stdout and stderr redirected to the 'stdout'
+  // and 'stderr' files in the sandbox.
+  Try<pid_t> fork(const ContainerID& containerId, const string& command)
+  {
+    vector<string> argv(3);
+    argv[0] = "sh";
+    argv[1] = "-c";
+    argv[2] = command;
+
+    return launcher->fork(
+        containerId,
+        "sh",
+        argv,
+        Subprocess::PATH("/dev/null"),
+        Subprocess::PATH(path::join(os::getcwd(), "stdout")),
+        Subprocess::PATH(path::join(os::getcwd(), "stderr")),
+        None(),
+        None(),
+        None(),
+        0);
+  }
+
+  // Returns the pid of the zygote, the only 'zygote' child of the test.
+  Try<pid_t> zygote()
+  {
+    Try<set<pid_t>> children = os::children(::getpid(), false);
+    if (children.isError()) {
+      return Error(children.error());
+    }
+
+    foreach (pid_t child, children.get()) {
+      Result<os::Process> process = os::process(child);
+      if (process.isSome() &&
+          strings::contains(
+              process.get().command, MesosContainerizerZygote::NAME)) {
+        return child;
+      }
+    }
+
+    return Error("Failed to find the zygote");
+  }
+
+  static const string VARIABLE;
+
+  slave::Flags flags;
+  Owned<Launcher> launcher;
+};
+
+
+const string LinuxLauncherZygoteTest::VARIABLE = "MESOS_TEST_LAUNCHER";
+
+
+// This test verifies that the zygote clones the process of a
+// container, in the cgroup of the container, with its stdio
+// redirected to the given files.
+TEST_F(LinuxLauncherZygoteTest, ROOT_CGROUPS_Launch)
+{
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  Try<pid_t> pid = fork(
+      containerId,
+      "echo $" + VARIABLE + "; echo error >&2; cat");
+
+  ASSERT_SOME(pid);
+
+  Future<Option<int>> status = process::reap(pid.get());
+
+  AWAIT_READY(status);
+  ASSERT_SOME(status.get());
+  EXPECT_TRUE(WIFEXITED(status.get().get()));
+  EXPECT_EQ(0, WEXITSTATUS(status.get().get()));
+
+  // The stdin is '/dev/null', so 'cat' adds nothing to the stdout.
+  EXPECT_SOME_EQ("zygote\n", os::read(path::join(os::getcwd(), "stdout")));
+  EXPECT_SOME_EQ("error\n", os::read(path::join(os::getcwd(), "stderr")));
+
+  AWAIT_READY(launcher->destroy(containerId));
+}
+
+
+// This test verifies that the processes cloned by the zygote are
+// children of the agent, which reaps them and gets their exit status,
+// and that they are killed when their container is destroyed.
+TEST_F(LinuxLauncherZygoteTest, ROOT_CGROUPS_ReapExitStatus)
+{
+  ContainerID containerId1;
+  containerId1.set_value(UUID::random().toString());
+
+  Try<pid_t> pid1 = fork(containerId1, "exit 42");
+  ASSERT_SOME(pid1);
+
+  ContainerID containerId2;
+  containerId2.set_value(UUID::random().toString());
+
+  Try<pid_t> pid2 = fork(containerId2, "sleep 1000");
+  ASSERT_SOME(pid2);
+
+  Result<os::Process> process = os::process(pid2.get());
+  ASSERT_SOME(process);
+  EXPECT_EQ(::getpid(), process.get().parent);
+
+  Future<Option<int>> status1 = process::reap(pid1.get());
+  Future<Option<int>> status2 = process::reap(pid2.get());
+
+  AWAIT_READY(status1);
+  ASSERT_SOME(status1.get());
+  EXPECT_TRUE(WIFEXITED(status1.get().get()));
+  EXPECT_EQ(42, WEXITSTATUS(status1.get().get()));
+
+  AWAIT_READY(launcher->destroy(containerId2));
+
+  AWAIT_READY(status2);
+  ASSERT_SOME(status2.get());
+  EXPECT_TRUE(WIFSIGNALED(status2.get().get()));
+  EXPECT_EQ(SIGKILL, WTERMSIG(status2.get().get()));
+
+  AWAIT_READY(launcher->destroy(containerId1));
+}
+
+
+// This test verifies that the launcher clones the processes itself
+// once the zygote has died.
+TEST_F(LinuxLauncherZygoteTest, ROOT_CGROUPS_FallbackZygoteDied)
+{
+  Try<pid_t> zygote = this->zygote();
+  ASSERT_SOME(zygote);
+
+  Future<Option<int>> exited = process::reap(zygote.get());
+
+  ASSERT_EQ(0, ::kill(zygote.get(), SIGKILL));
+  AWAIT_READY(exited);
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  Try<pid_t> pid = fork(containerId, "echo $" + VARIABLE + "; exit 7");
+  ASSERT_SOME(pid);
+
+  Future<Option<int>> status = process::reap(pid.get());
+
+  AWAIT_READY(status);
+  ASSERT_SOME(status.get());
+  EXPECT_TRUE(WIFEXITED(status.get().get()));
+  EXPECT_EQ(7, WEXITSTATUS(status.get().get()));
+
+  EXPECT_SOME_EQ("agent\n", os::read(path::join(os::getcwd(), "stdout")));
+
+  AWAIT_READY(launcher->destroy(containerId));
+}
+
+
+// This test verifies that the zygote answers a launch which it fails
+// with an error, after killing the process it cloned, and that it
+// serves the next launches.
+TEST_F(LinuxLauncherZygoteTest, ROOT_CGROUPS_ZygoteError)
+{
+  // Unlike the zygote of the launcher, this one sees the environment
+  // set after the launcher was created.
+  Try<Owned<Zygote>> zygote = Zygote::create(
+      path::join(flags.launcher_dir, "mesos-containerizer"));
+
+  ASSERT_SOME(zygote);
+
+  Try<int> out = os::open(
+      path::join(os::getcwd(), "stdout"),
+      O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+      S_IRUSR | S_IWUSR);
+
+  ASSERT_SOME(out);
+
+  const vector<string> argv = {"sh", "-c", "echo $" + VARIABLE};
+
+  // The zygote fails to move the process into the cgroup of a
+  // hierarchy which does not exist.
+  map<string, string> cgroups;
+  cgroups[path::join(os::getcwd(), "nonexistent")] = TEST_CGROUPS_ROOT;
+
+  EXPECT_ERROR(zygote.get()->clone(
+      "sh",
+      argv,
+      STDIN_FILENO,
+      out.get(),
+      STDERR_FILENO,
+      None(),
+      SIGCHLD,
+      cgroups,
+      map<string, string>()));
+
+  // The killed process has been reaped by the zygote client.
+  Try<set<pid_t>> children = os::children(::getpid(), false);
+  ASSERT_SOME(children);
+
+  foreach (pid_t child, children.get()) {
+    Result<os::Process> process = os::process(child);
+    if (process.isSome()) {
+      EXPECT_FALSE(process.get().zombie);
+    }
+  }
+
+  Try<pid_t> pid = zygote.get()->clone(
+      "sh",
+      argv,
+      STDIN_FILENO,
+      out.get(),
+      STDERR_FILENO,
+      None(),
+      SIGCHLD,
+      map<string, string>(),
+      map<string, string>());
+
+  os::close(out.get());
+
+  ASSERT_SOME(pid);
+
+  Future<Option<int>> status = process::reap(pid.get());
+
+  AWAIT_READY(status);
+  ASSERT_SOME(status.get());
+  EXPECT_TRUE(WIFEXITED(status.get().get()));
+  EXPECT_EQ(0, WEXITSTATUS(status.get().get()));
+
+  EXPECT_SOME_EQ("agent\n", os::read(path::join(os::getcwd(), "stdout")));
+}
+
+
+// This test verifies that the launcher clones the process itself when
+// the zygote fails the launch, here because the zygote is in a 'pids'
+// cgroup which does not allow it to clone, and that the launcher uses
+// the zygote again once it can launch.
+TEST_F(LinuxLauncherZygoteTest, ROOT_CGROUPS_FallbackZygoteError)
+{
+  Result<string> hierarchy = cgroups::hierarchy("pids");
+  ASSERT_SOME(hierarchy) << "The 'pids' cgroups subsystem is not mounted";
+
+  Try<pid_t> zygote = this->zygote();
+  ASSERT_SOME(zygote);
+
+  ASSERT_SOME(cgroups::create(hierarchy.get(), TEST_CGROUPS_ROOT));
+  ASSERT_SOME(
+      cgroups::assign(hierarchy.get(), TEST_CGROUPS_ROOT, zygote.get()));
+
+  Try<string> current =
+    cgroups::read(hierarchy.get(), TEST_CGROUPS_ROOT, "pids.current");
+
+  ASSERT_SOME(current);
+  ASSERT_SOME(cgroups::write(
+      hierarchy.get(),
+      TEST_CGROUPS_ROOT,
+      "pids.max",
+      strings::trim(current.get())));
+
+  ContainerID containerId1;
+  containerId1.set_value(UUID::random().toString());
+
+  Try<pid_t> pid = fork(containerId1, "echo $" + VARIABLE);
+  ASSERT_SOME(pid);
+
+  Future<Option<int>> status = process::reap(pid.get());
+
+  AWAIT_READY(status);
+  ASSERT_SOME(status.get());
+  EXPECT_TRUE(WIFEXITED(status.get().get()));
+  EXPECT_EQ(0, WEXITSTATUS(status.get().get()));
+
+  EXPECT_SOME_EQ("agent\n", os::read(path::join(os::getcwd(), "stdout")));
+
+  // Let the zygote clone again.
+  ASSERT_SOME(cgroups::write(
+      hierarchy.get(), TEST_CGROUPS_ROOT, "pids.max", "max"));
+
+  ContainerID containerId2;
+  containerId2.set_value(UUID::random().toString());
+
+  pid = fork(containerId2, "echo $" + VARIABLE);
+  ASSERT_SOME(pid);
+
+  status = process::reap(pid.get());
+
+  AWAIT_READY(status);
+  ASSERT_SOME(status.get());
+  EXPECT_TRUE(WIFEXITED(status.get().get()));
+
+  // The stdout is appended to.
+  EXPECT_SOME_EQ(
+      "agent\nzygote\n",
+      os::read(path::join(os::getcwd(), "stdout")));
+
+  AWAIT_READY(launcher->destroy(containerId1));
+  AWAIT_READY(launcher->destroy(containerId2));
+
+  // Kill the zygote, and wait for it to exit, before its 'pids'
+  // cgroup is removed.
+  Future<Option<int>> exited = process::reap(zygote.get());
+
+  launcher.reset();
+
+  AWAIT_READY(exited);
+  AWAIT_READY(cgroups::destroy(hierarchy.get(), TEST_CGROUPS_ROOT));
+}
+
+} // namespace tests {
+} // namespace internal {
+} // namespace mesos {
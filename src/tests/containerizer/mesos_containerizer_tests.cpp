@@ -28,6 +28,7 @@
 #include <process/future.hpp>
 #include <process/owned.hpp>
 
+#include <stout/gzip.hpp>
 #include <stout/net.hpp>
 #include <stout/strings.hpp>
 
@@ -433,6 +434,96 @@ TEST_F(MesosContainerizerExecuteTest, IoRedirection)
 }
 
 
+// Tests that the rotating container logger bounds the size of the
+// 'stdout' file of the sandbox, and keeps all the output in it and the
+// compressed rotated files.
+TEST_F(MesosContainerizerExecuteTest, RotatingContainerLogger)
+{
+  string directory = os::getcwd(); // We're inside a temporary sandbox.
+
+  slave::Flags flags;
+  flags.launcher_dir = path::join(tests::flags.build_dir, "src");
+  flags.container_logger = "rotate";
+  flags.container_logger_max_size = Kilobytes(1);
+  flags.container_logger_max_files = 5;
+  flags.container_logger_compress = true;
+
+  Fetcher fetcher;
+
+  Try<MesosContainerizer*> containerizer =
+    MesosContainerizer::create(flags, false, &fetcher);
+
+  ASSERT_SOME(containerizer);
+
+  ContainerID containerId;
+  containerId.set_value("test_container");
+
+  // Writes six lines of 501 bytes.
+  string command = "for i in 1 2 3 4 5 6; do printf '%0500d\\n' 0; done";
+
+  Future<bool> launch = containerizer.get()->launch(
+      containerId,
+      CREATE_EXECUTOR_INFO("executor", command),
+      directory,
+      None(),
+      SlaveID(),
+      PID<Slave>(),
+      false);
+
+  AWAIT_READY(launch);
+
+  Future<containerizer::Termination> wait =
+    containerizer.get()->wait(containerId);
+
+  AWAIT_READY(wait);
+
+  EXPECT_TRUE(wait.get().has_status());
+  EXPECT_EQ(0, wait.get().status());
+
+  // The rotating process may still be writing once the executor has
+  // exited, so we wait for all the output to show up.
+  const string out = path::join(directory, "stdout");
+
+  size_t rotated;
+  size_t total;
+  Duration waited = Duration::zero();
+
+  do {
+    rotated = 0;
+    total = 0;
+
+    Try<string> read = os::read(out);
+    ASSERT_SOME(read);
+    EXPECT_GE(1024u, read.get().size());
+    total += read.get().size();
+
+    for (size_t i = 1; os::exists(out + "." + stringify(i) + ".gz"); i++) {
+      read = os::read(out + "." + stringify(i) + ".gz");
+      ASSERT_SOME(read);
+
+      Try<string> decompressed = gzip::decompress(read.get());
+      ASSERT_SOME(decompressed);
+      EXPECT_GE(1024u, decompressed.get().size());
+
+      rotated++;
+      total += decompressed.get().size();
+    }
+
+    if (total == 6 * 501u) {
+      break;
+    }
+
+    os::sleep(Milliseconds(10));
+    waited += Milliseconds(10);
+  } while (waited < Seconds(15));
+
+  EXPECT_EQ(6 * 501u, total);
+  EXPECT_LE(2u, rotated);
+
+  delete containerizer.get();
+}
+
+
 class MesosContainerizerDestroyTest : public MesosTest {};
 
 
@@ -492,8 +583,13 @@ public:
 
     EXPECT_CALL(*this, prepare(_, _, _, _))
       .WillRepeatedly(Invoke(this, &MockIsolator::_prepare));
+
+    EXPECT_CALL(*this, ordered())
+      .WillRepeatedly(Return(true));
   }
 
+  MOCK_CONST_METHOD0(ordered, bool());
+
   MOCK_METHOD2(
       recover,
       Future<Nothing>(
@@ -671,6 +767,88 @@ TEST_F(MesosContainerizerDestroyTest, DestroyWhilePreparing)
 }
 
 
+class MesosContainerizerPrepareTest : public MesosTest {};
+
+
+// Tests that the isolators that are not ordered are prepared while
+// the isolators before them are still preparing, and that an ordered
+// isolator waits for all the isolators before it.
+TEST_F(MesosContainerizerPrepareTest, UnorderedIsolators)
+{
+  slave::Flags flags = CreateSlaveFlags();
+
+  Try<Launcher*> launcher = PosixLauncher::create(flags);
+  ASSERT_SOME(launcher);
+
+  MockIsolator* isolator1 = new MockIsolator();
+  MockIsolator* isolator2 = new MockIsolator();
+  MockIsolator* isolator3 = new MockIsolator();
+
+  EXPECT_CALL(*isolator2, ordered())
+    .WillRepeatedly(Return(false));
+
+  Future<Nothing> prepare1;
+  Promise<Option<ContainerPrepareInfo>> promise1;
+
+  EXPECT_CALL(*isolator1, prepare(_, _, _, _))
+    .WillOnce(DoAll(FutureSatisfy(&prepare1),
+                    Return(promise1.future())));
+
+  Future<Nothing> prepare2;
+  EXPECT_CALL(*isolator2, prepare(_, _, _, _))
+    .WillOnce(DoAll(FutureSatisfy(&prepare2),
+                    Return(None())));
+
+  Future<Nothing> prepare3;
+  EXPECT_CALL(*isolator3, prepare(_, _, _, _))
+    .WillOnce(DoAll(FutureSatisfy(&prepare3),
+                    Return(None())));
+
+  Fetcher fetcher;
+
+  MockMesosContainerizerProcess* process = new MockMesosContainerizerProcess(
+      flags,
+      true,
+      &fetcher,
+      Owned<Launcher>(launcher.get()),
+      {Owned<Isolator>(isolator1),
+       Owned<Isolator>(isolator2),
+       Owned<Isolator>(isolator3)});
+
+  MesosContainerizer containerizer((Owned<MesosContainerizerProcess>(process)));
+
+  ContainerID containerId;
+  containerId.set_value("test_container");
+
+  containerizer.launch(
+      containerId,
+      CREATE_EXECUTOR_INFO("executor", "exit 0"),
+      os::getcwd(),
+      None(),
+      SlaveID(),
+      PID<Slave>(),
+      false);
+
+  Future<containerizer::Termination> wait = containerizer.wait(containerId);
+
+  AWAIT_READY(prepare1);
+  AWAIT_READY(prepare2);
+
+  // The third isolator waits for the first one.
+  EXPECT_TRUE(prepare3.isPending());
+
+  // Need to help the compiler to disambiguate between overloads.
+  Option<ContainerPrepareInfo> option = None();
+  promise1.set(option);
+
+  AWAIT_READY(prepare3);
+
+  containerizer.destroy(containerId);
+
+  AWAIT_READY(wait);
+}
+
+
 // This action destroys the container using the real launcher and
 // waits until the destroy is complete.
 ACTION_P(InvokeDestroyAndWait, launcher)
@@ -753,6 +931,95 @@ TEST_F(MesosContainerizerDestroyTest, LauncherDestroyFailure)
 }
 
 
+class MesosContainerizerUpdateTest : public MesosTest {};
+
+
+// This test verifies that the updates of a container which arrive
+// while its isolators are being updated are coalesced into a single
+// update with the latest resources, and that an update which does
+// not change the resources does not reach the isolators.
+TEST_F(MesosContainerizerUpdateTest, CoalesceUpdates)
+{
+  slave::Flags flags = CreateSlaveFlags();
+
+  Try<Launcher*> launcher = PosixLauncher::create(flags);
+  ASSERT_SOME(launcher);
+
+  MockIsolator* isolator = new MockIsolator();
+
+  Fetcher fetcher;
+
+  MockMesosContainerizerProcess* process = new MockMesosContainerizerProcess(
+      flags,
+      true,
+      &fetcher,
+      Owned<Launcher>(launcher.get()),
+      {Owned<Isolator>(isolator)});
+
+  MesosContainerizer containerizer((Owned<MesosContainerizerProcess>(process)));
+
+  ContainerID containerId;
+  containerId.set_value("test_container");
+
+  Future<bool> launch = containerizer.launch(
+      containerId,
+      CREATE_EXECUTOR_INFO("executor", "sleep 1000"),
+      os::getcwd(),
+      None(),
+      SlaveID(),
+      PID<Slave>(),
+      false);
+
+  AWAIT_ASSERT_EQ(true, launch);
+
+  Future<containerizer::Termination> wait = containerizer.wait(containerId);
+
+  const Resources resources1 = Resources::parse("cpus:1;mem:64").get();
+  const Resources resources2 = Resources::parse("cpus:2;mem:128").get();
+  const Resources resources3 = Resources::parse("cpus:3;mem:192").get();
+
+  Future<Nothing> isolatorUpdate;
+  Promise<Nothing> promise;
+
+  // Only the first and the latest resources reach the isolator.
+  EXPECT_CALL(*isolator, update(containerId, resources1))
+    .WillOnce(DoAll(FutureSatisfy(&isolatorUpdate),
+                    Return(promise.future())));
+
+  EXPECT_CALL(*isolator, update(containerId, resources3))
+    .WillOnce(Return(Nothing()));
+
+  Future<Nothing> update1 = containerizer.update(containerId, resources1);
+
+  AWAIT_READY(isolatorUpdate);
+
+  Future<Nothing> update2 = containerizer.update(containerId, resources2);
+  Future<Nothing> update3 = containerizer.update(containerId, resources3);
+
+  // Make sure the updates are queued behind the first one.
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  EXPECT_TRUE(update1.isPending());
+  EXPECT_TRUE(update2.isPending());
+  EXPECT_TRUE(update3.isPending());
+
+  promise.set(Nothing());
+
+  AWAIT_READY(update1);
+  AWAIT_READY(update2);
+  AWAIT_READY(update3);
+
+  // The isolator already has these resources.
+  AWAIT_READY(containerizer.update(containerId, resources3));
+
+  containerizer.destroy(containerId);
+
+  AWAIT_READY(wait);
+}
+
+
 class MesosContainerizerRecoverTest : public MesosTest {};
 
 
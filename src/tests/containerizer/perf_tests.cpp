@@ -62,6 +62,17 @@ TEST_F(PerfTest, ROOT_Sample)
 }
 
 
+TEST_F(PerfTest, SamplerEvents)
+{
+  EXPECT_TRUE(perf::Sampler::valid(
+      {"cycles", "task-clock", "L1-dcache-load-misses", "node-stores"}));
+
+  // Events without a field in the PerfStatistics protobuf.
+  EXPECT_FALSE(perf::Sampler::valid({"cycles", "invalid-event"}));
+  EXPECT_FALSE(perf::Sampler::valid({"branch-stores"}));
+}
+
+
 TEST_F(PerfTest, Parse)
 {
   // Parse multiple cgroups with uint64 and floats.
@@ -27,6 +27,7 @@
 
 #include <stout/bytes.hpp>
 #include <stout/gtest.hpp>
+#include <stout/hashset.hpp>
 #include <stout/ip.hpp>
 #include <stout/json.hpp>
 #include <stout/mac.hpp>
@@ -1757,6 +1758,95 @@ TEST_F(PortMappingIsolatorTest, ROOT_NC_PortMappingStatistics)
 }
 
 
+// Test that the traffic control statistics of the ingress rate limit
+// are returned from usage().
+TEST_F(PortMappingIsolatorTest, ROOT_IngressTrafficControlStatistics)
+{
+  flags.ingress_rate_limit_per_container = Bytes(2000);
+
+  Try<Isolator*> isolator = PortMappingIsolatorProcess::create(flags);
+  CHECK_SOME(isolator);
+
+  Try<Launcher*> launcher = LinuxLauncher::create(flags);
+  CHECK_SOME(launcher);
+
+  // Set the executor's resources.
+  ExecutorInfo executorInfo;
+  executorInfo.mutable_resources()->CopyFrom(
+      Resources::parse(container1Ports).get());
+
+  ContainerID containerId;
+  containerId.set_value("container1");
+
+  // Use a relative temporary directory so it gets cleaned up
+  // automatically with the test.
+  Try<string> dir1 = os::mkdtemp(path::join(os::getcwd(), "XXXXXX"));
+  ASSERT_SOME(dir1);
+
+  Future<Option<ContainerPrepareInfo>> preparation1 =
+    isolator.get()->prepare(
+        containerId,
+        executorInfo,
+        dir1.get(),
+        None());
+
+  AWAIT_READY(preparation1);
+  ASSERT_SOME(preparation1.get());
+
+  ostringstream command1;
+  command1 << "touch " << container1Ready << " && sleep 1000";
+
+  int pipes[2];
+  ASSERT_NE(-1, ::pipe(pipes));
+
+  Try<pid_t> pid = launchHelper(
+      launcher.get(),
+      pipes,
+      containerId,
+      command1.str(),
+      preparation1.get());
+
+  ASSERT_SOME(pid);
+
+  // Reap the forked child.
+  Future<Option<int> > reap = process::reap(pid.get());
+
+  // Continue in the parent.
+  ::close(pipes[0]);
+
+  // Isolate the forked child.
+  AWAIT_READY(isolator.get()->isolate(containerId, pid.get()));
+
+  // Now signal the child to continue.
+  char dummy;
+  ASSERT_LT(0, ::write(pipes[1], &dummy, sizeof(dummy)));
+  ::close(pipes[1]);
+
+  ASSERT_TRUE(waitForFileCreation(container1Ready));
+
+  Future<ResourceStatistics> usage = isolator.get()->usage(containerId);
+  AWAIT_READY(usage);
+
+  hashset<string> ids;
+  foreach (const TrafficControlStatistics& statistics,
+           usage.get().net_traffic_control_statistics()) {
+    ids.insert(statistics.id());
+  }
+
+  EXPECT_TRUE(ids.contains(NET_ISOLATOR_INGRESS_BW_LIMIT));
+  EXPECT_TRUE(ids.contains(NET_ISOLATOR_INGRESS_BLOAT_REDUCTION));
+
+  // Ensure all processes are killed.
+  AWAIT_READY(launcher.get()->destroy(containerId));
+
+  // Let the isolator clean up.
+  AWAIT_READY(isolator.get()->cleanup(containerId));
+
+  delete isolator.get();
+  delete launcher.get();
+}
+
+
 class PortMappingMesosTest : public ContainerizerTest<MesosContainerizer>
 {
 public:
@@ -0,0 +1,115 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <set>
+
+#include <gtest/gtest.h>
+
+#include <mesos/mesos.hpp>
+
+#include <process/gtest.hpp>
+#include <process/subprocess.hpp>
+
+#include <stout/gtest.hpp>
+#include <stout/os.hpp>
+#include <stout/uuid.hpp>
+
+#include "slave/containerizer/mesos/process_tracker.hpp"
+
+using namespace process;
+
+using mesos::internal::slave::ProcessTracker;
+
+using std::set;
+
+namespace mesos {
+namespace internal {
+namespace tests {
+
+// Waits for the tracker to report 'count' processes for the container.
+static Option<set<pid_t>> await(
+    ProcessTracker* tracker,
+    const ContainerID& containerId,
+    size_t count)
+{
+  Option<set<pid_t>> pids = None();
+
+  for (int i = 0; i < 100; i++) {
+    Future<Option<set<pid_t>>> future = tracker->pids(containerId);
+    future.await(Seconds(15));
+
+    if (!future.isReady() || future.get().isNone()) {
+      return None();
+    }
+
+    pids = future.get();
+    if (pids.get().size() == count) {
+      break;
+    }
+
+    os::sleep(Milliseconds(100));
+  }
+
+  return pids;
+}
+
+
+// Tests that the processes forked after a container is tracked are
+// followed through the proc connector, and that killing the
+// container kills all of them.
+TEST(ProcessTrackerTest, ROOT_TrackAndKill)
+{
+  Try<ProcessTracker*> tracker = ProcessTracker::instance();
+  ASSERT_SOME(tracker);
+
+  ContainerID containerId;
+  containerId.set_value(UUID::random().toString());
+
+  // The shell forks 'sleep 1000' after the container is tracked.
+  Try<Subprocess> s = subprocess("sleep 1; sleep 1000");
+  ASSERT_SOME(s);
+
+  tracker.get()->track(containerId, s.get().pid());
+
+  Option<set<pid_t>> pids = await(tracker.get(), containerId, 2);
+  ASSERT_SOME(pids);
+  EXPECT_EQ(2u, pids.get().size());
+  EXPECT_EQ(1u, pids.get().count(s.get().pid()));
+
+  Future<bool> killed = tracker.get()->kill(containerId, SIGKILL);
+  AWAIT_EXPECT_TRUE(killed);
+
+  Future<Option<int>> status = s.get().status();
+  AWAIT_READY(status);
+  ASSERT_SOME(status.get());
+  EXPECT_TRUE(WIFSIGNALED(status.get().get()));
+  EXPECT_EQ(SIGKILL, WTERMSIG(status.get().get()));
+
+  // The exits of the processes are followed too.
+  pids = await(tracker.get(), containerId, 0);
+  ASSERT_SOME(pids);
+  EXPECT_TRUE(pids.get().empty());
+
+  tracker.get()->untrack(containerId);
+
+  Future<Option<set<pid_t>>> untracked = tracker.get()->pids(containerId);
+  AWAIT_READY(untracked);
+  EXPECT_NONE(untracked.get());
+}
+
+} // namespace tests {
+} // namespace internal {
+} // namespace mesos {
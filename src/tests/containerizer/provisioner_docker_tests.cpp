@@ -1473,6 +1473,137 @@ TEST_F(ProvisionerDockerLocalStoreTest, PullingSameImageSimutanuously)
   EXPECT_EQ(layers1.get(), layers2.get());
 }
 
+
+// This test verifies that the store moves a layer shared by two
+// images pulled at the same time into the store once, and that both
+// images use it.
+TEST_F(ProvisionerDockerLocalStoreTest, PullingImagesSharingLayers)
+{
+  slave::Flags flags;
+  flags.docker_puller = "local";
+  flags.docker_store_dir = path::join(os::getcwd(), "store");
+  flags.docker_local_archives_dir = path::join(os::getcwd(), "images");
+
+  MockPuller* puller = new MockPuller();
+  Promise<list<pair<string, string>>> promise1;
+  Promise<list<pair<string, string>>> promise2;
+
+  EXPECT_CALL(*puller, pull(_, _))
+    .WillOnce(Return(promise1.future()))
+    .WillOnce(Return(promise2.future()));
+
+  Try<Owned<slave::Store>> store =
+      slave::docker::Store::create(flags, Owned<Puller>(puller));
+  ASSERT_SOME(store);
+
+  Image image1;
+  image1.set_type(Image::DOCKER);
+  image1.mutable_docker()->set_name("abc");
+
+  Image image2;
+  image2.set_type(Image::DOCKER);
+  image2.mutable_docker()->set_name("xyz");
+
+  Future<vector<string>> layers1 = store.get()->get(image1);
+  Future<vector<string>> layers2 = store.get()->get(image2);
+
+  const string basePath = path::join(os::getcwd(), "base");
+  const string rootfsPath1 = path::join(os::getcwd(), "rootfs1");
+  const string rootfsPath2 = path::join(os::getcwd(), "rootfs2");
+
+  ASSERT_SOME(os::mkdir(basePath));
+  ASSERT_SOME(os::mkdir(rootfsPath1));
+  ASSERT_SOME(os::mkdir(rootfsPath2));
+
+  // Both images have the base layer '123'.
+  promise1.set(list<pair<string, string>>(
+      {{"123", basePath}, {"456", rootfsPath1}}));
+  promise2.set(list<pair<string, string>>(
+      {{"123", basePath}, {"789", rootfsPath2}}));
+
+  AWAIT_READY(layers1);
+  AWAIT_READY(layers2);
+
+  const string baseLayerPath =
+    getImageLayerRootfsPath(flags.docker_store_dir, "123");
+
+  ASSERT_EQ(2u, layers1.get().size());
+  ASSERT_EQ(2u, layers2.get().size());
+
+  EXPECT_EQ(baseLayerPath, layers1.get()[0]);
+  EXPECT_EQ(baseLayerPath, layers2.get()[0]);
+
+  EXPECT_TRUE(os::exists(baseLayerPath));
+  EXPECT_FALSE(os::exists(basePath));
+}
+
+// This test verifies that pruning a store that exceeds its size
+// removes the images no container uses, with the layers no other
+// image has, and that a removed image is pulled again.
+TEST_F(ProvisionerDockerLocalStoreTest, PruneUnusedImages)
+{
+  slave::Flags flags;
+  flags.docker_puller = "local";
+  flags.docker_store_dir = path::join(os::getcwd(), "store");
+  flags.docker_store_max_size = Bytes(0);
+  flags.docker_local_archives_dir = path::join(os::getcwd(), "images");
+
+  const string basePath = path::join(os::getcwd(), "base");
+  const string rootfsPath1 = path::join(os::getcwd(), "rootfs1");
+  const string rootfsPath2 = path::join(os::getcwd(), "rootfs2");
+
+  ASSERT_SOME(os::mkdir(basePath));
+  ASSERT_SOME(os::mkdir(rootfsPath1));
+  ASSERT_SOME(os::mkdir(rootfsPath2));
+
+  // Both images have the base layer '123'.
+  MockPuller* puller = new MockPuller();
+  EXPECT_CALL(*puller, pull(_, _))
+    .WillOnce(Return(list<pair<string, string>>(
+        {{"123", basePath}, {"456", rootfsPath1}})))
+    .WillOnce(Return(list<pair<string, string>>(
+        {{"123", basePath}, {"789", rootfsPath2}})))
+    .WillOnce(Return(list<pair<string, string>>()));
+
+  Try<Owned<slave::Store>> store =
+      slave::docker::Store::create(flags, Owned<Puller>(puller));
+  ASSERT_SOME(store);
+
+  Image image1;
+  image1.set_type(Image::DOCKER);
+  image1.mutable_docker()->set_name("abc");
+
+  Image image2;
+  image2.set_type(Image::DOCKER);
+  image2.mutable_docker()->set_name("xyz");
+
+  AWAIT_READY(store.get()->get(image1));
+
+  Future<vector<string>> layers2 = store.get()->get(image2);
+  AWAIT_READY(layers2);
+
+  // Only the second image is used by a container.
+  hashset<string> activeLayers;
+  activeLayers.insert(layers2.get().begin(), layers2.get().end());
+
+  AWAIT_READY(store.get()->prune(activeLayers));
+
+  EXPECT_TRUE(os::exists(
+      getImageLayerRootfsPath(flags.docker_store_dir, "123")));
+  EXPECT_FALSE(os::exists(
+      getImageLayerPath(flags.docker_store_dir, "456")));
+  EXPECT_TRUE(os::exists(
+      getImageLayerRootfsPath(flags.docker_store_dir, "789")));
+
+  EXPECT_FALSE(os::exists(getImagePath(flags.docker_store_dir, "abc:latest")));
+  EXPECT_TRUE(os::exists(getImagePath(flags.docker_store_dir, "xyz:latest")));
+
+  // The second image is still cached, the first one is pulled again.
+  AWAIT_READY(store.get()->get(image2));
+  AWAIT_READY(store.get()->get(image1));
+}
+
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
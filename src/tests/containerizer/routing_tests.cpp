@@ -203,6 +203,26 @@ TEST_F(RoutingTest, LinkStatistics)
 }
 
 
+TEST_F(RoutingTest, LinksStatistics)
+{
+  Try<set<string> > links = net::links();
+  ASSERT_SOME(links);
+
+  Try<hashmap<string, hashmap<string, uint64_t> > > statistics =
+    link::statistics();
+
+  ASSERT_SOME(statistics);
+
+  foreach (const string& link, links.get()) {
+    ASSERT_TRUE(statistics.get().contains(link));
+    EXPECT_TRUE(statistics.get().at(link).contains("rx_packets"));
+    EXPECT_TRUE(statistics.get().at(link).contains("rx_bytes"));
+    EXPECT_TRUE(statistics.get().at(link).contains("tx_packets"));
+    EXPECT_TRUE(statistics.get().at(link).contains("tx_bytes"));
+  }
+}
+
+
 TEST_F(RoutingTest, LinkExists)
 {
   Try<set<string> > links = net::links();
@@ -1260,6 +1280,68 @@ TEST_F(RoutingVethTest, ROOT_IPFilterCreateMultiple)
 }
 
 
+// This test verifies that IP filters with the same priority can be
+// created and removed in a batch, and that they get unique handles.
+TEST_F(RoutingVethTest, ROOT_IPFilterBatch)
+{
+  ASSERT_SOME(link::create(TEST_VETH_LINK, TEST_PEER_LINK, None()));
+
+  EXPECT_SOME_TRUE(link::exists(TEST_VETH_LINK));
+  EXPECT_SOME_TRUE(link::exists(TEST_PEER_LINK));
+
+  ASSERT_SOME_TRUE(ingress::create(TEST_VETH_LINK));
+
+  vector<Filter<ip::Classifier> > filters;
+  vector<ip::Classifier> classifiers;
+
+  for (uint16_t begin = 1024; begin < 1024 + 3 * 4; begin += 4) {
+    Try<ip::PortRange> sourcePorts =
+      ip::PortRange::fromBeginEnd(begin, begin + 3);
+
+    ASSERT_SOME(sourcePorts);
+
+    ip::Classifier classifier(None(), None(), sourcePorts.get(), None());
+
+    classifiers.push_back(classifier);
+    filters.push_back(Filter<ip::Classifier>(
+        ingress::HANDLE,
+        classifier,
+        Priority(2, 1),
+        None(),
+        None(),
+        action::Redirect(TEST_PEER_LINK)));
+  }
+
+  EXPECT_SOME_TRUE(ip::create(TEST_VETH_LINK, filters));
+
+  // None of the filters is created again.
+  EXPECT_SOME_FALSE(ip::create(TEST_VETH_LINK, filters));
+
+  Result<vector<Filter<ip::Classifier> > > created =
+    ip::filters(TEST_VETH_LINK, ingress::HANDLE);
+
+  ASSERT_SOME(created);
+  ASSERT_EQ(3u, created.get().size());
+
+  set<uint32_t> handles;
+  foreach (const Filter<ip::Classifier>& filter, created.get()) {
+    ASSERT_SOME(filter.handle);
+    handles.insert(filter.handle.get().get());
+  }
+
+  EXPECT_EQ(3u, handles.size());
+
+  EXPECT_SOME_EQ(3u, ip::remove(TEST_VETH_LINK, ingress::HANDLE, classifiers));
+  EXPECT_SOME_EQ(0u, ip::remove(TEST_VETH_LINK, ingress::HANDLE, classifiers));
+
+  Result<vector<ip::Classifier> > remaining =
+    ip::classifiers(TEST_VETH_LINK, ingress::HANDLE);
+
+  ASSERT_SOME(remaining);
+  EXPECT_TRUE(remaining.get().empty());
+}
+
+
 TEST_F(RoutingVethTest, ROOT_IPFilterRemove)
 {
   ASSERT_SOME(link::create(TEST_VETH_LINK, TEST_PEER_LINK, None()));
@@ -286,6 +286,108 @@ TYPED_TEST(CRAMMD5AuthenticationTest, AuthenticateeSecretMissing)
   delete authenticatee.get();
 }
 
+
+// This test verifies that an authenticatee resumes the session it was
+// issued a ticket for by a previous authentication instead of going
+// through the SASL exchange, that it answers a fresh challenge each
+// time, and that it falls back to the SASL exchange when its session
+// has expired.
+TEST(CRAMMD5AuthenticationSessionTest, Session)
+{
+  // Launch a dummy process (somebody to send the AuthenticateMessage).
+  UPID pid = spawn(new ProcessBase(), true);
+
+  Credential credential1;
+  credential1.set_principal("session");
+  credential1.set_secret("secret");
+
+  Credentials credentials;
+  Credential* credential2 = credentials.add_credentials();
+  credential2->set_principal(credential1.principal());
+  credential2->set_secret(credential1.secret());
+
+  CRAMMD5Authenticator authenticator(Hours(1));
+  EXPECT_SOME(authenticator.initialize(credentials));
+
+  // Authenticates the principal once, and sets the message with which
+  // the authenticatee started the authentication.
+  auto authenticate = [&](AuthenticationStartMessage* started) {
+    Future<Message> message =
+      FUTURE_MESSAGE(Eq(AuthenticateMessage().GetTypeName()), _, _);
+
+    Future<AuthenticationStartMessage> start =
+      FUTURE_PROTOBUF(AuthenticationStartMessage(), _, _);
+
+    CRAMMD5Authenticatee authenticatee;
+
+    Future<bool> client =
+      authenticatee.authenticate(pid, UPID(), credential1);
+
+    AWAIT_READY(message);
+
+    Future<Option<string>> principal =
+      authenticator.authenticate(message.get().from);
+
+    AWAIT_EQ(true, client);
+    AWAIT_READY(principal);
+    EXPECT_SOME_EQ("session", principal.get());
+
+    AWAIT_READY(start);
+    *started = start.get();
+  };
+
+  AuthenticationStartMessage start1;
+
+  // The first authentication is issued a ticket, if it did not have
+  // one already.
+  authenticate(&start1);
+
+  Clock::pause();
+  Clock::settle();
+
+  // Once the session has expired, the authenticator refuses to resume
+  // it and offers the SASL mechanisms again, with which the
+  // authenticatee goes through the SASL exchange.
+  Clock::advance(Hours(2));
+
+  Future<AuthenticationMechanismsMessage> mechanisms1 =
+    FUTURE_PROTOBUF(AuthenticationMechanismsMessage(), _, _);
+
+  Future<AuthenticationMechanismsMessage> mechanisms2 =
+    FUTURE_PROTOBUF(AuthenticationMechanismsMessage(), _, _);
+
+  AuthenticationStartMessage start2;
+  authenticate(&start2);
+  EXPECT_EQ(SESSION_MECHANISM, start2.mechanism());
+
+  AWAIT_READY(mechanisms1);
+  AWAIT_READY(mechanisms2);
+
+  Clock::resume();
+
+  // The next authentications resume the session that was just issued,
+  // and so do not get to a SASL step. Each of them answers the fresh
+  // challenge of the authenticator, so they cannot be replayed.
+  EXPECT_NO_FUTURE_PROTOBUFS(AuthenticationStepMessage(), _, _);
+
+  AuthenticationStartMessage start3;
+  authenticate(&start3);
+  EXPECT_EQ(SESSION_MECHANISM, start3.mechanism());
+
+  AuthenticationStartMessage start4;
+  authenticate(&start4);
+  EXPECT_EQ(SESSION_MECHANISM, start4.mechanism());
+
+  // Both present the same ticket, but different responses.
+  ASSERT_EQ(start3.data().size(), start4.data().size());
+  EXPECT_NE(start3.data(), start4.data());
+
+  const size_t size = start3.data().size() - 32;
+  EXPECT_EQ(start3.data().substr(0, size), start4.data().substr(0, size));
+
+  terminate(pid);
+}
+
 } // namespace cram_md5 {
 } // namespace internal {
 } // namespace mesos {
@@ -141,6 +141,26 @@ TEST_F(DiskUsageCollectorTest, SymbolicLink)
 }
 
 
+// This test verifies that a file with multiple hard links is only
+// counted once.
+TEST_F(DiskUsageCollectorTest, HardLink)
+{
+  string file = path::join(os::getcwd(), "file");
+  ASSERT_SOME(os::write(file, string(Kilobytes(64).bytes(), 'x')));
+
+  string link = path::join(os::getcwd(), "link");
+  ASSERT_EQ(0, ::link(file.c_str(), link.c_str()));
+
+  DiskUsageCollector collector(Milliseconds(1));
+
+  Future<Bytes> usage = collector.usage(os::getcwd());
+
+  AWAIT_READY(usage);
+  EXPECT_GE(usage.get(), Kilobytes(64));
+  EXPECT_LT(usage.get(), Kilobytes(128));
+}
+
+
 class DiskQuotaTest : public MesosTest {};
 
 
@@ -156,6 +156,68 @@ private:
 };
 
 
+// Disables the tests of the cgroups isolators in the unified hierarchy
+// (cgroups v2) if their controllers are not available in it, e.g.,
+// because they are attached to cgroups v1 hierarchies.
+class UnifiedCgroupsFilter : public TestFilter
+{
+public:
+  UnifiedCgroupsFilter()
+  {
+#ifdef __linux__
+    if (cgroups::unified::enabled()) {
+      if (available("cpu")) {
+        controllers.insert("cpu");
+      }
+
+      if (available("memory")) {
+        controllers.insert("memory");
+      }
+    }
+
+    if (controllers.size() < 2) {
+      std::cerr
+        << "-------------------------------------------------------------\n"
+        << "The 'cpu' and 'memory' controllers are not both available in\n"
+        << "the cgroups v2 unified hierarchy so not all 'UNIFIED_CPU_' and\n"
+        << "'UNIFIED_MEM_' tests will be run\n"
+        << "-------------------------------------------------------------"
+        << std::endl;
+    }
+#endif // __linux__
+  }
+
+  bool disable(const ::testing::TestInfo* test) const
+  {
+    return (matches(test, "UNIFIED_CPU_") && controllers.count("cpu") == 0) ||
+      (matches(test, "UNIFIED_MEM_") && controllers.count("memory") == 0);
+  }
+
+private:
+#ifdef __linux__
+  static bool available(const string& controller)
+  {
+    Result<string> hierarchy = cgroups::unified::hierarchy();
+
+    // A controller attached to a cgroups v1 hierarchy is not available
+    // in the unified hierarchy, which is mounted on demand otherwise.
+    if (hierarchy.isNone()) {
+      return cgroups::hierarchy(controller).isNone();
+    } else if (hierarchy.isError()) {
+      return false;
+    }
+
+    Try<set<string>> controllers =
+      cgroups::unified::controllers(hierarchy.get());
+
+    return controllers.isSome() && controllers.get().count(controller) > 0;
+  }
+#endif // __linux__
+
+  set<string> controllers;
+};
+
+
 class CgroupsFilter : public TestFilter
 {
 public:
@@ -287,6 +349,38 @@ private:
 };
 
 
+class OverlayFSFilter : public TestFilter
+{
+public:
+  OverlayFSFilter()
+  {
+#ifdef __linux__
+    Try<bool> supported = fs::supported("overlay");
+    overlayfsError = !supported.isSome() || !supported.get();
+#else
+    overlayfsError = true;
+#endif // __linux__
+
+    if (overlayfsError) {
+      std::cerr
+        << "-------------------------------------------------------------\n"
+        << "The overlay filesystem is not supported by the kernel so no\n"
+        << "'OVERLAYFS_' tests will be run\n"
+        << "-------------------------------------------------------------"
+        << std::endl;
+    }
+  }
+
+  bool disable(const ::testing::TestInfo* test) const
+  {
+    return matches(test, "OVERLAYFS_") && overlayfsError;
+  }
+
+private:
+  bool overlayfsError;
+};
+
+
 class NetcatFilter : public TestFilter
 {
 public:
@@ -454,10 +548,12 @@ Environment::Environment(const Flags& _flags) : flags(_flags)
   filters.push_back(Owned<TestFilter>(new RootFilter()));
   filters.push_back(Owned<TestFilter>(new CfsFilter()));
   filters.push_back(Owned<TestFilter>(new CgroupsFilter()));
+  filters.push_back(Owned<TestFilter>(new UnifiedCgroupsFilter()));
   filters.push_back(Owned<TestFilter>(new DockerFilter()));
   filters.push_back(Owned<TestFilter>(new BenchmarkFilter()));
   filters.push_back(Owned<TestFilter>(new NetworkIsolatorTestFilter()));
   filters.push_back(Owned<TestFilter>(new PerfFilter()));
+  filters.push_back(Owned<TestFilter>(new OverlayFSFilter()));
   filters.push_back(Owned<TestFilter>(new NetcatFilter()));
   filters.push_back(Owned<TestFilter>(new CurlFilter()));
 
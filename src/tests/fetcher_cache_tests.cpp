@@ -365,6 +365,20 @@ static Future<Nothing> awaitFinished(FetcherCacheTest::Task task)
 }
 
 
+// Create a future that indicates that the task observed by the given
+// status queue has failed.
+static Future<Nothing> awaitFailed(FetcherCacheTest::Task task)
+{
+  return task.statusQueue.get()
+    .then([=](const TaskStatus& status) -> Future<Nothing> {
+      if (status.state() == TASK_FAILED) {
+        return Nothing();
+      }
+      return awaitFailed(task);
+  });
+}
+
+
 // Create a future that indicates that all tasks are finished.
 // TODO(bernd-mesos): Make this abstractions as generic and generally
 // available for all testing as possible.
@@ -444,7 +458,9 @@ Try<FetcherCacheTest::Task> FetcherCacheTest::launchTask(
 
   Queue<TaskStatus> taskStatusQueue;
 
-  EXPECT_CALL(scheduler, statusUpdate(driver, _))
+  // Only the updates of this task go to its queue, since there can
+  // be updates of earlier tasks, e.g., resent after slave recovery.
+  EXPECT_CALL(scheduler, statusUpdate(driver, TaskStatusEq(task)))
     .WillRepeatedly(PushTaskStatus(taskStatusQueue));
 
   driver->launchTasks(offer.id(), tasks);
@@ -786,10 +802,80 @@ TEST_F(FetcherCacheTest, LocalCachedExtract)
     EXPECT_EQ(1u, fetcherProcess->cacheSize());
     ASSERT_SOME(fetcherProcess->cacheFiles(slaveId, flags));
     EXPECT_EQ(1u, fetcherProcess->cacheFiles(slaveId, flags).get().size());
+
+    // The archive is kept extracted in the cache.
+    const Path cacheFile = fetcherProcess->cacheFiles(slaveId, flags)->front();
+    EXPECT_TRUE(os::exists(path::join(
+        cacheFile.value + slave::FETCHER_CACHE_EXTRACTED_SUFFIX,
+        ARCHIVED_COMMAND_NAME)));
   }
 }
 
 
+// Tests that URIs with the same checksum share a cache entry.
+TEST_F(FetcherCacheTest, LocalCachedChecksum)
+{
+  startSlave();
+  driver->start();
+
+  Try<string> sha256sum = os::shell("sha256sum '" + commandPath + "'");
+  ASSERT_SOME(sha256sum);
+
+  const string checksum = strings::tokenize(sha256sum.get(), " ").front();
+
+  for (size_t i = 0; i < 3; i++) {
+    // A different URI for the same file each time.
+    CommandInfo::URI uri;
+    uri.set_value(i % 2 == 0 ? commandPath : "file://" + commandPath);
+    uri.set_executable(true);
+    uri.set_cache(true);
+    uri.set_checksum(checksum);
+
+    CommandInfo commandInfo;
+    commandInfo.set_value("./" + COMMAND_NAME + " " + taskName(i));
+    commandInfo.add_uris()->CopyFrom(uri);
+
+    const Try<Task> task = launchTask(commandInfo, i);
+    ASSERT_SOME(task);
+
+    AWAIT_READY(awaitFinished(task.get()));
+
+    const string path = path::join(task.get().runDirectory.value, COMMAND_NAME);
+    EXPECT_TRUE(isExecutable(path));
+    EXPECT_TRUE(os::exists(path + taskName(i)));
+
+    EXPECT_EQ(1u, fetcherProcess->cacheSize());
+    ASSERT_SOME(fetcherProcess->cacheFiles(slaveId, flags));
+    EXPECT_EQ(1u, fetcherProcess->cacheFiles(slaveId, flags).get().size());
+  }
+}
+
+
+// Tests that fetching fails if the checksum does not match.
+TEST_F(FetcherCacheTest, LocalCachedChecksumMismatch)
+{
+  startSlave();
+  driver->start();
+
+  CommandInfo::URI uri;
+  uri.set_value(commandPath);
+  uri.set_executable(true);
+  uri.set_cache(true);
+  uri.set_checksum(string(64, '0'));
+
+  CommandInfo commandInfo;
+  commandInfo.set_value("./" + COMMAND_NAME + " " + taskName(0));
+  commandInfo.add_uris()->CopyFrom(uri);
+
+  const Try<Task> task = launchTask(commandInfo, 0);
+  ASSERT_SOME(task);
+
+  AWAIT_READY(awaitFailed(task.get()));
+
+  EXPECT_EQ(0u, fetcherProcess->cacheSize());
+}
+
+
 class FetcherCacheHttpTest : public FetcherCacheTest
 {
 public:
@@ -1142,11 +1228,9 @@ TEST_F(FetcherCacheHttpTest, HttpMixed)
 }
 
 
-// Tests slave recovery of the fetcher cache. The cache must be
-// wiped clean on recovery, causing renewed downloads.
-// TODO(bernd-mesos): Debug flaky behavior reported in MESOS-2871,
-// then reenable this test.
-TEST_F(FetcherCacheHttpTest, DISABLED_HttpCachedRecovery)
+// Tests slave recovery of the fetcher cache. The cache files must
+// survive recovery, so that there are no renewed downloads.
+TEST_F(FetcherCacheHttpTest, HttpCachedRecovery)
 {
   startSlave();
   driver->start();
@@ -1184,32 +1268,39 @@ TEST_F(FetcherCacheHttpTest, DISABLED_HttpCachedRecovery)
   // Start over.
   httpServer->resetCounts();
 
-  // Don't reuse the old fetcher, which has stale state after
-  // stopping the slave.
-  Fetcher fetcher2;
+  // Don't reuse the old fetcher, whose cache table would serve the
+  // cache file without any recovery.
+  MockFetcherProcess* fetcherProcess2 = new MockFetcherProcess();
+  Owned<FetcherProcess> process2(fetcherProcess2);
+  Fetcher fetcher2(process2);
 
   Try<MesosContainerizer*> c =
     MesosContainerizer::create(flags, true, &fetcher2);
-  CHECK_SOME(c);
+  ASSERT_SOME(c);
   containerizer = c.get();
 
-  // Set up so we can wait until the new slave updates the container's
-  // resources (this occurs after the executor has re-registered).
-  Future<Nothing> update =
-    FUTURE_DISPATCH(_, &MesosContainerizerProcess::update);
+  // The slave re-registers once its recovery, including the one of
+  // the fetcher cache, is complete. The executors of the finished
+  // tasks may be gone already, so there might be no container to
+  // wait for.
+  Future<SlaveReregisteredMessage> slaveReregisteredMessage =
+    FUTURE_PROTOBUF(SlaveReregisteredMessage(), _, _);
 
   Try<PID<Slave>> pid = StartSlave(containerizer, flags);
-  CHECK_SOME(pid);
+  ASSERT_SOME(pid);
   slavePid = pid.get();
 
-  // Wait until the containerizer is updated.
-  AWAIT_READY(update);
+  AWAIT_READY(slaveReregisteredMessage);
 
-  // Recovery must have cleaned the cache by now.
-  EXPECT_FALSE(os::exists(cacheDirectory));
+  // Recovery must have kept the cache.
+  EXPECT_TRUE(os::exists(cacheDirectory));
+  ASSERT_SOME(fetcherProcess2->cacheFiles(slaveId, flags));
+  EXPECT_EQ(1u, fetcherProcess2->cacheFiles(slaveId, flags).get().size());
 
-  // Repeat of the above to see if it works the same.
-  for (size_t i = 0; i < 3; i++) {
+  // Repeat of the above to see if it works the same. The tasks get
+  // new IDs, since the updates of the previous tasks may be resent
+  // after the recovery.
+  for (size_t i = 3; i < 6; i++) {
     CommandInfo::URI uri;
     uri.set_value(httpServer->url() + COMMAND_NAME);
     uri.set_executable(true);
@@ -1229,14 +1320,17 @@ TEST_F(FetcherCacheHttpTest, DISABLED_HttpCachedRecovery)
     EXPECT_TRUE(isExecutable(path));
     EXPECT_TRUE(os::exists(path + taskName(i)));
 
-    EXPECT_EQ(1u, fetcherProcess->cacheSize());
-    ASSERT_SOME(fetcherProcess->cacheFiles(slaveId, flags));
-    EXPECT_EQ(1u, fetcherProcess->cacheFiles(slaveId, flags).get().size());
+    // The recovered entry is in the cache table of the new fetcher.
+    EXPECT_EQ(1u, fetcherProcess2->cacheSize());
+    ASSERT_SOME(fetcherProcess2->cacheFiles(slaveId, flags));
+    EXPECT_EQ(1u, fetcherProcess2->cacheFiles(slaveId, flags).get().size());
 
-    // content-length requests: 1
-    // downloads: 1
-    EXPECT_EQ(2u, httpServer->countCommandRequests);
+    // The recovered cache file is reused.
+    EXPECT_EQ(0u, httpServer->countCommandRequests);
   }
+
+  // The containerizer must go before the fetcher it uses.
+  stopSlave();
 }
 
 
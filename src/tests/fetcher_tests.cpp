@@ -16,11 +16,13 @@
 
 #include <unistd.h>
 
+#include <list>
 #include <map>
 #include <string>
 
 #include <hdfs/hdfs.hpp>
 
+#include <process/collect.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
@@ -40,8 +42,12 @@
 #include <mesos/fetcher/fetcher.hpp>
 #include <mesos/type_utils.hpp>
 
+#include "messages/messages.hpp"
+
 #include "slave/containerizer/fetcher.hpp"
 #include "slave/flags.hpp"
+#include "slave/paths.hpp"
+#include "slave/state.hpp"
 
 #include "tests/environment.hpp"
 #include "tests/flags.hpp"
@@ -59,6 +65,7 @@ using mesos::internal::slave::Fetcher;
 using process::Subprocess;
 using process::Future;
 
+using std::list;
 using std::map;
 using std::string;
 
@@ -230,6 +237,52 @@ TEST_F(FetcherTest, AbsoluteFilePath)
 }
 
 
+// Tests that the URIs of concurrent fetches are all fetched while
+// the number of concurrent downloads is limited.
+TEST_F(FetcherTest, ConcurrentDownloads)
+{
+  string fromDir = path::join(os::getcwd(), "from");
+  ASSERT_SOME(os::mkdir(fromDir));
+
+  slave::Flags flags;
+  flags.launcher_dir = path::join(tests::flags.build_dir, "src");
+  flags.fetcher_max_concurrent_downloads = 2;
+
+  Fetcher fetcher;
+  SlaveID slaveId;
+
+  list<Future<Nothing>> fetches;
+  list<string> files;
+
+  for (int i = 0; i < 3; i++) {
+    string sandbox = path::join(os::getcwd(), "sandbox" + stringify(i));
+    ASSERT_SOME(os::mkdir(sandbox));
+
+    ContainerID containerId;
+    containerId.set_value(UUID::random().toString());
+
+    CommandInfo commandInfo;
+
+    for (int j = 0; j < 3; j++) {
+      string name = "test" + stringify(j);
+      ASSERT_SOME(os::write(path::join(fromDir, name), "data"));
+
+      commandInfo.add_uris()->set_value(path::join(fromDir, name));
+      files.push_back(path::join(sandbox, name));
+    }
+
+    fetches.push_back(fetcher.fetch(
+        containerId, commandInfo, sandbox, None(), slaveId, flags));
+  }
+
+  AWAIT_READY(collect(fetches));
+
+  foreach (const string& file, files) {
+    EXPECT_SOME_EQ("data", os::read(file));
+  }
+}
+
+
 TEST_F(FetcherTest, RelativeFilePath)
 {
   string fromDir = path::join(os::getcwd(), "from");
@@ -718,6 +771,71 @@ TEST_F(FetcherTest, HdfsURI)
   EXPECT_TRUE(os::exists(localFile));
 }
 
+// Tests that recovery keeps the complete files of the checkpointed
+// index of the fetcher cache, and removes the files of interrupted
+// downloads and the ones that are not in the index.
+TEST_F(FetcherTest, RecoverCache)
+{
+  slave::Flags flags;
+  flags.fetcher_cache_dir = path::join(os::getcwd(), "cache");
+
+  SlaveID slaveId;
+  slaveId.set_value("S0");
+
+  const string cacheDirectory =
+    slave::paths::getSlavePath(flags.fetcher_cache_dir, slaveId);
+
+  const string userDirectory = path::join(cacheDirectory, "user");
+  ASSERT_SOME(os::mkdir(userDirectory));
+
+  const string complete = path::join(userDirectory, "c1-complete");
+  const string partial = path::join(userDirectory, "c2-partial");
+  const string orphan = path::join(cacheDirectory, "c3-orphan");
+  const string temporary = path::join(cacheDirectory, "index.tmp");
+
+  ASSERT_SOME(os::write(complete, "data"));
+  ASSERT_SOME(os::write(partial, "da"));
+  ASSERT_SOME(os::write(orphan, "data"));
+  ASSERT_SOME(os::write(temporary, "data"));
+
+  FetcherCacheIndex index;
+  index.set_serial(3);
+
+  FetcherCacheIndex::Entry* entry = index.add_entries();
+  entry->set_key("complete");
+  entry->set_directory(userDirectory);
+  entry->set_filename("c1-complete");
+  entry->mutable_uri()->set_value("http://host/complete");
+  entry->set_size(4);
+  entry->set_last_used(1);
+
+  entry = index.add_entries();
+  entry->set_key("partial");
+  entry->set_directory(userDirectory);
+  entry->set_filename("c2-partial");
+  entry->mutable_uri()->set_value("http://host/partial");
+  entry->set_size(4);
+  entry->set_last_used(2);
+
+  const string indexPath = path::join(cacheDirectory, "index");
+  ASSERT_SOME(slave::state::checkpoint(indexPath, index));
+
+  ASSERT_SOME(Fetcher::recover(slaveId, flags));
+
+  EXPECT_TRUE(os::exists(complete));
+  EXPECT_FALSE(os::exists(partial));
+  EXPECT_FALSE(os::exists(orphan));
+  EXPECT_FALSE(os::exists(temporary));
+
+  Result<FetcherCacheIndex> recovered =
+    ::protobuf::read<FetcherCacheIndex>(indexPath);
+
+  ASSERT_SOME(recovered);
+  EXPECT_EQ(3u, recovered.get().serial());
+  ASSERT_EQ(1, recovered.get().entries_size());
+  EXPECT_EQ("complete", recovered.get().entries(0).key());
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -27,7 +27,9 @@
 #include <stout/gtest.hpp>
 #include <stout/json.hpp>
 #include <stout/os.hpp>
+#include <stout/path.hpp>
 #include <stout/stringify.hpp>
+#include <stout/strings.hpp>
 
 #include <stout/tests/utils.hpp>
 
@@ -38,6 +40,7 @@ using process::Future;
 using process::http::BadRequest;
 using process::http::NotFound;
 using process::http::OK;
+using process::http::Pipe;
 using process::http::Response;
 
 using std::string;
@@ -263,6 +266,67 @@ TEST_F(FilesTest, BrowseTest)
 }
 
 
+TEST_F(FilesTest, BrowsePaginationTest)
+{
+  Files files;
+  process::UPID upid("files", process::address());
+
+  ASSERT_SOME(os::mkdir("1"));
+
+  // More entries than get listed per batch.
+  JSON::Array expected;
+  for (int i = 0; i < 1500; i++) {
+    const string name = strings::format("%04d", i).get();
+    ASSERT_SOME(os::write(path::join("1", name), name));
+
+    struct stat s;
+    ASSERT_EQ(0, stat(path::join("1", name).c_str(), &s));
+    expected.values.push_back(jsonFileInfo(path::join("one", name), s));
+  }
+
+  AWAIT_EXPECT_READY(files.attach("1", "one"));
+
+  Future<Response> response =
+      process::http::get(upid, "browse", "path=one");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ(stringify(expected), response);
+
+  // A page of the listing.
+  JSON::Array page;
+  page.values.assign(
+      expected.values.begin() + 998,
+      expected.values.begin() + 1003);
+
+  response =
+    process::http::get(upid, "browse", "path=one&offset=998&limit=5");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ(stringify(page), response);
+
+  // The last page is short.
+  page.values.assign(
+      expected.values.begin() + 1498,
+      expected.values.end());
+
+  response =
+    process::http::get(upid, "browse", "path=one&offset=1498&limit=5");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ(stringify(page), response);
+
+  // Beyond the end.
+  response = process::http::get(upid, "browse", "path=one&offset=2000");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ(stringify(JSON::Array()), response);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      BadRequest().status,
+      process::http::get(upid, "browse", "path=one&limit=foo"));
+}
+
+
 TEST_F(FilesTest, DownloadTest)
 {
   Files files;
@@ -295,7 +359,63 @@ TEST_F(FilesTest, DownloadTest)
   AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
   AWAIT_EXPECT_RESPONSE_HEADER_EQ("image/gif", "Content-Type", response);
   AWAIT_EXPECT_RESPONSE_BODY_EQ(data, response);
+
+  // Only the requested range gets downloaded.
+  process::http::Headers headers;
+  headers["Range"] = "bytes=3-6";
+
+  response = process::http::get(upid, "download", "path=binary", headers);
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      process::http::Status::string(process::http::Status::PARTIAL_CONTENT),
+      response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes 3-6/17", "Content-Range", response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("file", response);
+}
+
+
+#ifdef __linux__
+TEST_F(FilesTest, DownloadFollowTest)
+{
+  Files files;
+  process::UPID upid("files", process::address());
+
+  ASSERT_SOME(os::write("file", "body"));
+  AWAIT_EXPECT_READY(files.attach("file", "file"));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      BadRequest().status,
+      process::http::get(upid, "download", "path=file&follow=bogus"));
+
+  Future<Response> response = process::http::streaming::get(
+      upid,
+      "download",
+      "path=file&follow=true&offset=2");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  ASSERT_EQ(Response::PIPE, response->type);
+  ASSERT_SOME(response->reader);
+
+  Pipe::Reader reader = response->reader.get();
+
+  AWAIT_EXPECT_EQ("dy", reader.read());
+
+  // What gets appended to the file gets streamed.
+  Future<string> read = reader.read();
+  EXPECT_TRUE(read.isPending());
+
+  Try<int> fd = os::open("file", O_WRONLY | O_APPEND | O_CLOEXEC);
+  ASSERT_SOME(fd);
+  ASSERT_SOME(os::write(fd.get(), "more"));
+  ASSERT_SOME(os::close(fd.get()));
+
+  AWAIT_EXPECT_EQ("more", read);
+
+  // The stream ends once the file gets removed.
+  ASSERT_SOME(os::rm("file"));
+
+  AWAIT_EXPECT_EQ("", reader.read());
 }
+#endif // __linux__
 
 } // namespace tests {
 } // namespace internal {
@@ -244,6 +244,47 @@ TEST_F(GarbageCollectorTest, Prune)
 }
 
 
+// This test verifies that the garbage collector accounts for the
+// directories it removes and the disk they took up.
+TEST_F(GarbageCollectorTest, Metrics)
+{
+  GarbageCollector gc;
+
+  const string& directory = "directory";
+
+  ASSERT_SOME(os::mkdir(path::join(directory, "subdirectory")));
+  ASSERT_SOME(os::write(
+      path::join(directory, "subdirectory", "file"),
+      string(Kilobytes(64).bytes(), 'x')));
+
+  Future<Nothing> schedule = gc.schedule(Seconds(0), directory);
+
+  AWAIT_READY(schedule);
+
+  EXPECT_FALSE(os::exists(directory));
+
+  // The bogus path fails to be removed.
+  AWAIT_FAILED(gc.schedule(Seconds(0), "bogus"));
+
+  JSON::Object metrics = Metrics();
+
+  EXPECT_EQ(1u, metrics.values.count("gc/path_removals_succeeded"));
+  EXPECT_EQ(1, metrics.values["gc/path_removals_succeeded"]);
+
+  EXPECT_EQ(1u, metrics.values.count("gc/path_removals_failed"));
+  EXPECT_EQ(1, metrics.values["gc/path_removals_failed"]);
+
+  EXPECT_EQ(1u, metrics.values.count("gc/path_removals_pending"));
+  EXPECT_EQ(0, metrics.values["gc/path_removals_pending"]);
+
+  ASSERT_EQ(1u, metrics.values.count("gc/bytes_reclaimed"));
+  ASSERT_TRUE(metrics.values["gc/bytes_reclaimed"].is<JSON::Number>());
+  EXPECT_LE(
+      Kilobytes(64).bytes(),
+      metrics.values["gc/bytes_reclaimed"].as<JSON::Number>().as<uint64_t>());
+}
+
+
 class GarbageCollectorIntegrationTest : public MesosTest {};
 
 
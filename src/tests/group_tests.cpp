@@ -21,6 +21,7 @@
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
+#include <process/owned.hpp>
 
 #include <stout/gtest.hpp>
 #include <stout/option.hpp>
@@ -30,11 +31,13 @@
 
 #include "zookeeper/authentication.hpp"
 #include "zookeeper/group.hpp"
+#include "zookeeper/url.hpp"
 
 using zookeeper::Group;
 using zookeeper::GroupProcess;
 
 using process::Future;
+using process::Owned;
 
 using std::string;
 
@@ -433,6 +436,44 @@ TEST_F(GroupTest, LabelledGroup)
   ASSERT_TRUE(membership.get().cancelled().get());
 }
 
+
+// Groups shared for the same URL and timeout use one session, and
+// the last of them to go away terminates it.
+TEST_F(GroupTest, SharedGroup)
+{
+  Try<zookeeper::URL> url =
+    zookeeper::URL::parse("zk://" + server->connectString() + "/test");
+
+  ASSERT_SOME(url);
+
+  Owned<Group> group1(Group::shared(url.get(), NO_TIMEOUT));
+  Owned<Group> group2(Group::shared(url.get(), NO_TIMEOUT));
+  Group group3(url.get(), NO_TIMEOUT);
+
+  Future<Option<int64_t> > session1 = group1->session();
+  Future<Option<int64_t> > session2 = group2->session();
+  Future<Option<int64_t> > session3 = group3.session();
+
+  AWAIT_READY(session1);
+  AWAIT_READY(session2);
+  AWAIT_READY(session3);
+
+  EXPECT_SOME(session1.get());
+  EXPECT_EQ(session1.get(), session2.get());
+  EXPECT_NE(session1.get(), session3.get());
+
+  Future<Group::Membership> membership = group3.join("hello world");
+  AWAIT_READY(membership);
+
+  group1.reset();
+
+  Future<std::set<Group::Membership> > memberships = group2->watch();
+
+  AWAIT_READY(memberships);
+  EXPECT_EQ(1u, memberships.get().size());
+  EXPECT_EQ(1u, memberships.get().count(membership.get()));
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
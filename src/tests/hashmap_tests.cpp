@@ -0,0 +1,157 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <mesos/mesos.hpp>
+#include <mesos/type_utils.hpp>
+
+#include <stout/flat_hashmap.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
+#include <stout/uuid.hpp>
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+using testing::WithParamInterface;
+
+namespace mesos {
+namespace internal {
+namespace tests {
+
+// Returns 'count' ids that look like those generated by the master,
+// e.g., '<master UUID>-S42' for slaves.
+template <typename ID>
+static vector<ID> createIds(size_t count, const string& suffix)
+{
+  const string prefix = UUID::random().toString();
+
+  vector<ID> ids;
+  ids.reserve(count);
+
+  for (size_t i = 0; i < count; i++) {
+    ID id;
+    id.set_value(prefix + "-" + suffix + stringify(i));
+    ids.push_back(id);
+  }
+
+  return ids;
+}
+
+
+// Measures the operations the master and the allocator perform on
+// their maps keyed by ids, for the given type of map.
+template <typename Map, typename ID>
+static void benchmark(const string& name, const vector<ID>& ids)
+{
+  // Look up and erase the ids in a different order than they were
+  // inserted in, like the master does for the messages of agents.
+  vector<ID> shuffled = ids;
+  std::random_shuffle(shuffled.begin(), shuffled.end());
+
+  Map map;
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t i = 0; i < ids.size(); i++) {
+    map[ids[i]] = i;
+  }
+
+  const Duration insert = watch.elapsed();
+
+  watch.start();
+
+  size_t sum = 0;
+  for (int round = 0; round < 10; round++) {
+    foreach (const ID& id, shuffled) {
+      sum += map.get(id).get();
+    }
+  }
+
+  const Duration lookup = watch.elapsed();
+
+  watch.start();
+
+  for (int round = 0; round < 10; round++) {
+    foreachvalue (size_t value, map) {
+      sum += value;
+    }
+  }
+
+  const Duration iterate = watch.elapsed();
+
+  watch.start();
+
+  foreach (const ID& id, shuffled) {
+    map.erase(id);
+  }
+
+  const Duration erase = watch.elapsed();
+
+  EXPECT_TRUE(map.empty());
+  EXPECT_LT(0u, sum);
+
+  cout << name << ": "
+       << ids.size() << " insertions in " << insert << ", "
+       << 10 * ids.size() << " lookups in " << lookup << ", "
+       << "10 iterations in " << iterate << ", "
+       << ids.size() << " erasures in " << erase << endl;
+}
+
+
+class HashMap_BENCHMARK_Test : public WithParamInterface<size_t>,
+                               public ::testing::Test {};
+
+
+// The hash map benchmark tests are parameterized by the number of
+// entries, e.g., the number of slaves or frameworks in the cluster.
+INSTANTIATE_TEST_CASE_P(
+    EntryCount,
+    HashMap_BENCHMARK_Test,
+    ::testing::Values(100U, 1000U, 10000U, 50000U, 100000U));
+
+
+TEST_P(HashMap_BENCHMARK_Test, SlaveID)
+{
+  const vector<SlaveID> ids = createIds<SlaveID>(GetParam(), "S");
+
+  benchmark<hashmap<SlaveID, size_t>>("hashmap", ids);
+  benchmark<flat_hashmap<SlaveID, size_t>>("flat_hashmap", ids);
+}
+
+
+TEST_P(HashMap_BENCHMARK_Test, FrameworkID)
+{
+  const vector<FrameworkID> ids = createIds<FrameworkID>(GetParam(), "");
+
+  benchmark<hashmap<FrameworkID, size_t>>("hashmap", ids);
+  benchmark<flat_hashmap<FrameworkID, size_t>>("flat_hashmap", ids);
+}
+
+} // namespace tests {
+} // namespace internal {
+} // namespace mesos {
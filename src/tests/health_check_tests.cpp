@@ -19,11 +19,16 @@
 
 #include <process/clock.hpp>
 #include <process/future.hpp>
+#include <process/gmock.hpp>
+#include <process/http.hpp>
+#include <process/id.hpp>
 #include <process/owned.hpp>
 #include <process/pid.hpp>
 
 #include "docker/docker.hpp"
 
+#include "health-check/health_checker.hpp"
+
 #include "slave/slave.hpp"
 
 #include "slave/containerizer/docker.hpp"
@@ -47,6 +52,8 @@ using process::Clock;
 using process::Future;
 using process::Owned;
 using process::PID;
+using process::Process;
+using process::UPID;
 
 using testing::_;
 using testing::AtMost;
@@ -931,6 +938,89 @@ TEST_F(HealthCheckTest, CheckCommandTimeout)
   Shutdown();
 }
 
+
+// A process whose '/health' endpoint the HTTP health checks query.
+class HealthServer : public Process<HealthServer>
+{
+public:
+  HealthServer() : ProcessBase(process::ID::generate("health-server"))
+  {
+    route("/health", None(), [](const process::http::Request&) {
+      return process::http::OK();
+    });
+  }
+};
+
+
+// Tests that the health checker sends HTTP health checks itself,
+// without launching a health check process, and reports the task
+// healthy when the response has an expected status.
+TEST_F(HealthCheckTest, HealthCheckerHTTP)
+{
+  HealthServer server;
+  spawn(server);
+
+  HealthCheck check;
+  check.mutable_http()->set_port(server.self().address.port);
+  check.mutable_http()->set_path("/" + server.self().id + "/health");
+  check.mutable_http()->add_statuses(process::http::Status::OK);
+  check.set_delay_seconds(0);
+
+  const UPID executor(process::ID::generate("executor"), process::address());
+
+  Future<TaskHealthStatus> healthStatus =
+    FUTURE_PROTOBUF(TaskHealthStatus(), _, executor);
+
+  Try<Owned<health::HealthChecker>> checker =
+    health::HealthChecker::create(check, executor, TaskID());
+  ASSERT_SOME(checker);
+
+  checker.get()->healthCheck();
+
+  AWAIT_READY(healthStatus);
+  EXPECT_TRUE(healthStatus.get().healthy());
+
+  terminate(server);
+  wait(server);
+}
+
+
+// Tests that an HTTP health check fails when the response does not
+// have one of the expected statuses.
+TEST_F(HealthCheckTest, HealthCheckerHTTPUnexpectedStatus)
+{
+  HealthServer server;
+  spawn(server);
+
+  HealthCheck check;
+  check.mutable_http()->set_port(server.self().address.port);
+  check.mutable_http()->set_path("/" + server.self().id + "/health");
+  check.mutable_http()->add_statuses(process::http::Status::NOT_FOUND);
+  check.set_delay_seconds(0);
+  check.set_grace_period_seconds(0);
+  check.set_consecutive_failures(1);
+
+  const UPID executor(process::ID::generate("executor"), process::address());
+
+  Future<TaskHealthStatus> healthStatus =
+    FUTURE_PROTOBUF(TaskHealthStatus(), _, executor);
+
+  Try<Owned<health::HealthChecker>> checker =
+    health::HealthChecker::create(check, executor, TaskID());
+  ASSERT_SOME(checker);
+
+  Future<Nothing> checking = checker.get()->healthCheck();
+
+  AWAIT_READY(healthStatus);
+  EXPECT_FALSE(healthStatus.get().healthy());
+  EXPECT_TRUE(healthStatus.get().kill_task());
+
+  AWAIT_FAILED(checking);
+
+  terminate(server);
+  wait(server);
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
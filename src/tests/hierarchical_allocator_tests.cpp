@@ -14,6 +14,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <sys/resource.h>
+
+#include <algorithm>
 #include <atomic>
 #include <iostream>
 #include <queue>
@@ -28,17 +31,23 @@
 #include <process/clock.hpp>
 #include <process/future.hpp>
 #include <process/gtest.hpp>
+#include <process/http.hpp>
+#include <process/pid.hpp>
 #include <process/shared.hpp>
 #include <process/queue.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 #include <stout/gtest.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
+#include <stout/json.hpp>
 #include <stout/os.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/utils.hpp>
 
+#include "common/http.hpp"
+
 #include "master/constants.hpp"
 #include "master/flags.hpp"
 
@@ -51,6 +60,9 @@ using mesos::internal::master::MIN_CPUS;
 using mesos::internal::master::MIN_MEM;
 
 using mesos::internal::master::allocator::HierarchicalDRFAllocator;
+using mesos::internal::master::allocator::HierarchicalDRFMostAvailableAllocator;
+using mesos::internal::master::allocator::HierarchicalDRFOptimisticAllocator;
+using mesos::internal::master::allocator::HierarchicalDRFPackAllocator;
 
 using mesos::master::allocator::Allocator;
 using mesos::master::RoleInfo;
@@ -92,8 +104,9 @@ struct Deallocation
 class HierarchicalAllocatorTestBase : public ::testing::Test
 {
 protected:
-  HierarchicalAllocatorTestBase()
-    : allocator(createAllocator<HierarchicalDRFAllocator>()),
+  explicit HierarchicalAllocatorTestBase(
+      Allocator* _allocator = createAllocator<HierarchicalDRFAllocator>())
+    : allocator(_allocator),
       nextSlaveId(1),
       nextFrameworkId(1) {}
 
@@ -726,6 +739,53 @@ TEST_F(HierarchicalAllocatorTest, RecoverResources)
 }
 
 
+// Checks that the resources recovered in bulk are re-allocated, and
+// that the filters of the individual recoveries are applied.
+TEST_F(HierarchicalAllocatorTest, BulkRecoverResources)
+{
+  Clock::pause();
+
+  initialize(vector<string>{"role1"});
+
+  hashmap<FrameworkID, Resources> EMPTY;
+
+  FrameworkInfo framework = createFrameworkInfo("role1");
+  allocator->addFramework(
+      framework.id(), framework, hashmap<SlaveID, Resources>());
+
+  SlaveInfo slave1 = createSlaveInfo("cpus:1;mem:512;disk:0");
+  allocator->addSlave(slave1.id(), slave1, None(), slave1.resources(), EMPTY);
+
+  Future<Allocation> allocation = allocations.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(slave1.resources(), Resources::sum(allocation.get().resources));
+
+  SlaveInfo slave2 = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(slave2.id(), slave2, None(), slave2.resources(), EMPTY);
+
+  allocation = allocations.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(slave2.resources(), Resources::sum(allocation.get().resources));
+
+  // Decline slave1 for an hour and recover slave2 without a filter.
+  Filters filters;
+  filters.set_refuse_seconds(Hours(1).secs());
+
+  allocator->bulkRecoverResources({
+      {framework.id(), slave1.id(), slave1.resources(), filters},
+      {framework.id(), slave2.id(), slave2.resources(), None()}});
+
+  Clock::advance(flags.allocation_interval);
+
+  allocation = allocations.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  EXPECT_EQ(1u, allocation.get().resources.size());
+  EXPECT_TRUE(allocation.get().resources.contains(slave2.id()));
+  EXPECT_EQ(slave2.resources(), Resources::sum(allocation.get().resources));
+}
+
+
 TEST_F(HierarchicalAllocatorTest, Allocatable)
 {
   // Pausing the clock is not necessary, but ensures that the test
@@ -948,6 +1008,74 @@ TEST_F(HierarchicalAllocatorTest, UpdateAvailableFail)
   AWAIT_EXPECT_FAILED(update);
 }
 
+
+// This test ensures that the resources that an operator reserves on
+// a slave that is not allocated get offered in the next periodic
+// allocation, even though nothing else changed since the last one.
+TEST_F(HierarchicalAllocatorTest, UpdateAvailableReoffered)
+{
+  Clock::pause();
+
+  initialize(vector<string>{"role1"});
+
+  hashmap<FrameworkID, Resources> EMPTY;
+
+  SlaveInfo slave = createSlaveInfo("cpus:100;mem:100;disk:100");
+  allocator->addSlave(slave.id(), slave, None(), slave.resources(), EMPTY);
+
+  FrameworkInfo framework = createFrameworkInfo("role1");
+  allocator->addFramework(
+      framework.id(), framework, hashmap<SlaveID, Resources>());
+
+  Future<Allocation> allocation = allocations.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  EXPECT_EQ(slave.resources(), Resources::sum(allocation.get().resources));
+
+  // Decline the resources for longer than the test runs, so that the
+  // slave stays idle.
+  Filters filters;
+  filters.set_refuse_seconds(Hours(1).secs());
+
+  allocator->recoverResources(
+      framework.id(),
+      slave.id(),
+      slave.resources(),
+      filters);
+
+  // Neither of the next periodic allocations offers anything.
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  allocation = allocations.get();
+  ASSERT_TRUE(allocation.isPending());
+
+  // Reserve some of the resources on behalf of an operator.
+  Resources unreserved = Resources::parse("cpus:25;mem:50").get();
+  Resources dynamicallyReserved =
+    unreserved.flatten("role1", createReservationInfo("ops"));
+
+  Offer::Operation reserve = RESERVE(dynamicallyReserved);
+
+  Future<Nothing> update = allocator->updateAvailable(slave.id(), {reserve});
+  AWAIT_EXPECT_READY(update);
+
+  // The reserved resources are not filtered, so the next periodic
+  // allocation offers the slave's resources again.
+  Clock::advance(flags.allocation_interval);
+
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+
+  Try<Resources> updated = Resources(slave.resources()).apply(reserve);
+  ASSERT_SOME(updated);
+
+  EXPECT_EQ(updated.get(), Resources::sum(allocation.get().resources));
+}
+
 // This test ensures that when oversubscribed resources are updated
 // subsequent allocations properly account for that.
 TEST_F(HierarchicalAllocatorTest, UpdateSlave)
@@ -1138,6 +1266,67 @@ TEST_F(HierarchicalAllocatorTest, Whitelist)
 }
 
 
+// This test ensures that the resources of the slaves which don't
+// satisfy the offer constraints of a framework are not offered to it.
+TEST_F(HierarchicalAllocatorTest, OfferConstraints)
+{
+  Clock::pause();
+
+  initialize(vector<string>{"role1"});
+
+  hashmap<FrameworkID, Resources> EMPTY;
+
+  // slave1 has the wrong rack, slave2 is too small and
+  // slave3 satisfies the constraints.
+  SlaveInfo slave1 = createSlaveInfo("cpus:8;mem:1024");
+  slave1.mutable_attributes()->Add()->CopyFrom(
+      Attributes::parse("rack", "rack2"));
+  allocator->addSlave(slave1.id(), slave1, None(), slave1.resources(), EMPTY);
+
+  SlaveInfo slave2 = createSlaveInfo("cpus:2;mem:1024");
+  slave2.mutable_attributes()->Add()->CopyFrom(
+      Attributes::parse("rack", "rack1"));
+  allocator->addSlave(slave2.id(), slave2, None(), slave2.resources(), EMPTY);
+
+  SlaveInfo slave3 = createSlaveInfo("cpus:8;mem:1024");
+  slave3.mutable_attributes()->Add()->CopyFrom(
+      Attributes::parse("rack", "rack1"));
+  allocator->addSlave(slave3.id(), slave3, None(), slave3.resources(), EMPTY);
+
+  FrameworkInfo framework = createFrameworkInfo("role1");
+
+  FrameworkInfo::OfferConstraints* constraints =
+    framework.mutable_offer_constraints();
+
+  FrameworkInfo::OfferConstraints::Attribute* attribute =
+    constraints->add_attributes();
+  attribute->set_name("rack");
+  attribute->set_value("rack1");
+
+  constraints->mutable_min_resources()->CopyFrom(
+      Resources::parse("cpus:4").get());
+
+  allocator->addFramework(
+      framework.id(), framework, hashmap<SlaveID, Resources>());
+
+  Future<Allocation> allocation = allocations.get();
+
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+  EXPECT_EQ(1u, allocation.get().resources.size());
+  EXPECT_TRUE(allocation.get().resources.contains(slave3.id()));
+  EXPECT_EQ(slave3.resources(), Resources::sum(allocation.get().resources));
+
+  // Neither slave1 nor slave2 get offered in the next batch.
+  allocation = allocations.get();
+
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  EXPECT_TRUE(allocation.isPending());
+}
+
+
 // The quota tests that are specific to the built-in Hierarchical DRF
 // allocator (i.e. the way quota is satisfied) are in this file.
 
@@ -1772,6 +1961,330 @@ TEST_F(HierarchicalAllocatorTest, QuotaAgainstStarvation)
 }
 
 
+// Checks that the allocator serves a snapshot of its state as of the
+// latest allocation run.
+TEST_F(HierarchicalAllocatorTest, State)
+{
+  Clock::pause();
+
+  initialize(vector<string>{"role1"});
+
+  FrameworkInfo framework = createFrameworkInfo("role1");
+  allocator->addFramework(
+      framework.id(), framework, hashmap<SlaveID, Resources>());
+
+  SlaveInfo slave = createSlaveInfo("cpus:2;mem:1024;disk:0");
+  allocator->addSlave(
+      slave.id(),
+      slave,
+      None(),
+      slave.resources(),
+      hashmap<FrameworkID, Resources>());
+
+  Future<Allocation> allocation = allocations.get();
+  AWAIT_READY(allocation);
+  EXPECT_EQ(framework.id(), allocation.get().frameworkId);
+
+  // Wait for the allocator to publish the snapshot.
+  Clock::settle();
+
+  Future<process::http::Response> response = process::http::get(
+      process::UPID("allocator", process::address()), "state");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  Result<JSON::Array> frameworks = parse.get().find<JSON::Array>("frameworks");
+  ASSERT_SOME(frameworks);
+  ASSERT_EQ(1u, frameworks.get().values.size());
+
+  JSON::Object frameworkJSON = frameworks.get().values[0].as<JSON::Object>();
+  EXPECT_SOME_EQ(
+      JSON::String(framework.id().value()),
+      frameworkJSON.find<JSON::String>("id"));
+  EXPECT_SOME_EQ(JSON::Number(1), frameworkJSON.find<JSON::Number>("share"));
+
+  Result<JSON::Array> slaves = parse.get().find<JSON::Array>("slaves");
+  ASSERT_SOME(slaves);
+  ASSERT_EQ(1u, slaves.get().values.size());
+
+  JSON::Object slaveJSON = slaves.get().values[0].as<JSON::Object>();
+  EXPECT_SOME_EQ(
+      JSON::String(slave.id().value()),
+      slaveJSON.find<JSON::String>("id"));
+  EXPECT_SOME_EQ(
+      model(slave.resources()),
+      slaveJSON.find<JSON::Object>("allocated"));
+}
+
+
+class HierarchicalAllocatorSlaveOrderTest
+  : public HierarchicalAllocatorTestBase
+{
+protected:
+  explicit HierarchicalAllocatorSlaveOrderTest(Allocator* _allocator)
+    : HierarchicalAllocatorTestBase(_allocator) {}
+
+  // Adds a small and a big slave while allocation is paused and
+  // returns the resources that framework1 is offered in the allocation
+  // run that follows. framework1 is first in the DRF order, so it is
+  // offered the slave that comes first in the order of the allocator.
+  Resources allocateFirstSlave(const string& small, const string& big)
+  {
+    Clock::pause();
+
+    // Recovering a quota pauses allocation until the expected slaves
+    // reregister, which lets us add both slaves before the allocation
+    // run. The quota does not hold back any of the slaves' resources.
+    const string QUOTA_ROLE{"quota-role"};
+
+    initialize(vector<string>{QUOTA_ROLE});
+
+    hashmap<string, Quota> quotas;
+    quotas[QUOTA_ROLE] = Quota{createQuotaInfo(QUOTA_ROLE, "gpus:1")};
+
+    allocator->recover(10, quotas);
+
+    FrameworkInfo framework1 = createFrameworkInfo("*");
+    allocator->addFramework(
+        framework1.id(), framework1, hashmap<SlaveID, Resources>());
+
+    FrameworkInfo framework2 = createFrameworkInfo("*");
+    allocator->addFramework(
+        framework2.id(), framework2, hashmap<SlaveID, Resources>());
+
+    SlaveInfo slave1 = createSlaveInfo(small);
+    allocator->addSlave(
+        slave1.id(),
+        slave1,
+        None(),
+        slave1.resources(),
+        hashmap<FrameworkID, Resources>());
+
+    SlaveInfo slave2 = createSlaveInfo(big);
+    allocator->addSlave(
+        slave2.id(),
+        slave2,
+        None(),
+        slave2.resources(),
+        hashmap<FrameworkID, Resources>());
+
+    // Resume allocation once the recovery timeout has passed and
+    // trigger the next batch allocation.
+    Clock::settle();
+    Clock::advance(Minutes(10));
+    Clock::settle();
+    Clock::advance(flags.allocation_interval);
+    Clock::settle();
+
+    // framework2 is offered the other slave, in no particular order
+    // with respect to framework1's offer.
+    hashmap<FrameworkID, Allocation> offers;
+    for (int i = 0; i < 2; i++) {
+      Future<Allocation> allocation = allocations.get();
+      AWAIT_EXPECT_READY(allocation);
+
+      if (!allocation.isReady()) {
+        break;
+      }
+
+      EXPECT_EQ(1u, allocation.get().resources.size());
+      offers[allocation.get().frameworkId] = allocation.get();
+    }
+
+    EXPECT_TRUE(offers.contains(framework2.id()));
+
+    if (!offers.contains(framework1.id())) {
+      return Resources();
+    }
+
+    return Resources::sum(offers[framework1.id()].resources);
+  }
+};
+
+
+class HierarchicalAllocatorPackTest
+  : public HierarchicalAllocatorSlaveOrderTest
+{
+protected:
+  HierarchicalAllocatorPackTest()
+    : HierarchicalAllocatorSlaveOrderTest(
+          createAllocator<HierarchicalDRFPackAllocator>()) {}
+};
+
+
+// Checks that the packing allocator offers the slave with the fewest
+// available resources first.
+TEST_F(HierarchicalAllocatorPackTest, LeastAvailableFirst)
+{
+  const string small = "cpus:1;mem:512;disk:0";
+  const string big = "cpus:4;mem:2048;disk:0";
+
+  EXPECT_EQ(Resources::parse(small).get(), allocateFirstSlave(small, big));
+}
+
+
+class HierarchicalAllocatorMostAvailableTest
+  : public HierarchicalAllocatorSlaveOrderTest
+{
+protected:
+  HierarchicalAllocatorMostAvailableTest()
+    : HierarchicalAllocatorSlaveOrderTest(
+          createAllocator<HierarchicalDRFMostAvailableAllocator>()) {}
+};
+
+
+// Checks that the most available allocator offers the slave with the
+// most available resources first.
+TEST_F(HierarchicalAllocatorMostAvailableTest, MostAvailableFirst)
+{
+  const string small = "cpus:1;mem:512;disk:0";
+  const string big = "cpus:4;mem:2048;disk:0";
+
+  EXPECT_EQ(Resources::parse(big).get(), allocateFirstSlave(small, big));
+}
+
+
+class HierarchicalAllocatorOptimisticTest
+  : public HierarchicalAllocatorTestBase
+{
+protected:
+  HierarchicalAllocatorOptimisticTest()
+    : HierarchicalAllocatorTestBase(
+          createAllocator<HierarchicalDRFOptimisticAllocator>()) {}
+};
+
+
+// Checks that the optimistic allocator offers the resources of a
+// slave to several frameworks at once, and that the resources stay
+// allocated as long as one of the frameworks holds on to its offer.
+TEST_F(HierarchicalAllocatorOptimisticTest, OptimisticOffers)
+{
+  // Pause clock to disable periodic allocation.
+  Clock::pause();
+  initialize(vector<string>{});
+
+  FrameworkInfo framework1 = createFrameworkInfo("*");
+  allocator->addFramework(
+      framework1.id(), framework1, hashmap<SlaveID, Resources>());
+
+  FrameworkInfo framework2 = createFrameworkInfo("*");
+  allocator->addFramework(
+      framework2.id(), framework2, hashmap<SlaveID, Resources>());
+
+  SlaveInfo slave = createSlaveInfo("cpus:2;mem:1024;ports:[31000-32000]");
+  allocator->addSlave(
+      slave.id(),
+      slave,
+      None(),
+      slave.resources(),
+      hashmap<FrameworkID, Resources>());
+
+  // Both frameworks are offered all the resources of the slave.
+  hashmap<FrameworkID, Resources> offers;
+  for (int i = 0; i < 2; i++) {
+    Future<Allocation> allocation = allocations.get();
+    AWAIT_READY(allocation);
+
+    offers[allocation.get().frameworkId] =
+      Resources::sum(allocation.get().resources);
+  }
+
+  ASSERT_TRUE(offers.contains(framework1.id()));
+  ASSERT_TRUE(offers.contains(framework2.id()));
+
+  EXPECT_EQ(slave.resources(), offers[framework1.id()]);
+  EXPECT_EQ(slave.resources(), offers[framework2.id()]);
+
+  // The resources are not offered again once framework1 declines,
+  // since framework2 still holds them.
+  allocator->recoverResources(
+      framework1.id(), slave.id(), slave.resources(), None());
+
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  Future<Allocation> allocation = allocations.get();
+  ASSERT_TRUE(allocation.isPending());
+
+  // The resources are offered again once framework2 declines too.
+  allocator->recoverResources(
+      framework2.id(), slave.id(), slave.resources(), None());
+
+  Clock::advance(flags.allocation_interval);
+
+  AWAIT_READY(allocation);
+  EXPECT_EQ(slave.resources(), Resources::sum(allocation.get().resources));
+}
+
+
+// Checks that the resources of an optimistic offer count as allocated
+// to the framework that accepts them, whichever order the master
+// recovers the rescinded offers of the other frameworks in.
+TEST_F(HierarchicalAllocatorOptimisticTest, AcceptOptimisticOffer)
+{
+  // Pause clock to disable periodic allocation.
+  Clock::pause();
+  initialize(vector<string>{});
+
+  for (int i = 0; i < 3; i++) {
+    FrameworkInfo framework = createFrameworkInfo("*");
+    allocator->addFramework(
+        framework.id(), framework, hashmap<SlaveID, Resources>());
+  }
+
+  SlaveInfo slave = createSlaveInfo("cpus:2;mem:1024;ports:[31000-32000]");
+  allocator->addSlave(
+      slave.id(),
+      slave,
+      None(),
+      slave.resources(),
+      hashmap<FrameworkID, Resources>());
+
+  // All frameworks are offered all the resources of the slave. The
+  // resources are allocated to the first framework, the others hold
+  // optimistic copies of them.
+  vector<FrameworkID> frameworks;
+  for (int i = 0; i < 3; i++) {
+    Future<Allocation> allocation = allocations.get();
+    AWAIT_READY(allocation);
+
+    EXPECT_EQ(slave.resources(), Resources::sum(allocation.get().resources));
+
+    frameworks.push_back(allocation.get().frameworkId);
+  }
+
+  // The second framework accepts its copy, so the master rescinds the
+  // offers of the other frameworks. The resources must stay allocated
+  // to the second framework, rather than to the third framework which
+  // takes over the allocation of the first one.
+  allocator->acceptResources(frameworks[1], slave.id(), slave.resources());
+
+  allocator->recoverResources(
+      frameworks[0], slave.id(), slave.resources(), None());
+  allocator->recoverResources(
+      frameworks[2], slave.id(), slave.resources(), None());
+
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  Future<Allocation> allocation = allocations.get();
+  ASSERT_TRUE(allocation.isPending());
+
+  // The resources are offered again once the second framework no
+  // longer uses them.
+  allocator->recoverResources(
+      frameworks[1], slave.id(), slave.resources(), None());
+
+  Clock::advance(flags.allocation_interval);
+
+  AWAIT_READY(allocation);
+  EXPECT_EQ(slave.resources(), Resources::sum(allocation.get().resources));
+}
+
+
 class HierarchicalAllocator_BENCHMARK_Test
   : public HierarchicalAllocatorTestBase,
     public WithParamInterface<std::tr1::tuple<size_t, size_t>>
@@ -1882,6 +2395,300 @@ TEST_P(HierarchicalAllocator_BENCHMARK_Test, AddAndUpdateSlave)
   cout << "Updated " << slaveCount << " slaves in " << watch.elapsed() << endl;
 }
 
+
+
+// Returns the peak resident set size of the test process.
+static Bytes peakRss()
+{
+  struct rusage usage;
+  CHECK_EQ(0, ::getrusage(RUSAGE_SELF, &usage));
+
+#ifdef __APPLE__
+  return Bytes(usage.ru_maxrss);
+#else
+  return Kilobytes(usage.ru_maxrss);
+#endif
+}
+
+
+// Prints the latency percentiles and the throughput of the given
+// allocation cycles, which made 'offers' offers of a slave in total.
+static void report(
+    const string& name,
+    vector<Duration> cycles,
+    size_t offers)
+{
+  CHECK(!cycles.empty());
+
+  std::sort(cycles.begin(), cycles.end());
+
+  Duration total = Duration::zero();
+  foreach (const Duration& cycle, cycles) {
+    total += cycle;
+  }
+
+  auto percentile = [&cycles](double p) {
+    return cycles[std::min(
+        cycles.size() - 1,
+        static_cast<size_t>(p * cycles.size()))];
+  };
+
+  cout << name << ": " << cycles.size() << " cycles"
+       << ", p50 " << percentile(0.5)
+       << ", p90 " << percentile(0.9)
+       << ", p99 " << percentile(0.99)
+       << ", max " << cycles.back()
+       << ", " << static_cast<size_t>(offers / total.secs())
+       << " offers/sec, peak RSS " << peakRss() << endl;
+}
+
+
+// Benchmarks for allocation cycles in clusters of different shapes.
+// Each test adds the slaves and frameworks, and then measures a
+// number of cycles, each until the allocator becomes idle.
+class HierarchicalAllocatorCycle_BENCHMARK_Test
+  : public HierarchicalAllocatorTestBase,
+    public WithParamInterface<std::tr1::tuple<size_t, size_t>>
+{
+protected:
+  static const size_t CYCLES = 10;
+
+  HierarchicalAllocatorCycle_BENCHMARK_Test() : offerCount(0) {}
+
+  // Initializes the allocator, recording the offers in 'offers'
+  // instead of the `allocations` queue to be able to decline them.
+  void initialize(const vector<string>& roles = {})
+  {
+    HierarchicalAllocatorTestBase::initialize(
+        roles,
+        master::Flags(),
+        [this](const FrameworkID& frameworkId,
+               const hashmap<SlaveID, Resources>& resources) {
+          foreachpair (const SlaveID& slaveId,
+                       const Resources& offered,
+                       resources) {
+            offers[frameworkId][slaveId] += offered;
+            offerCount++;
+          }
+        });
+  }
+
+  vector<FrameworkInfo> addFrameworks(const vector<string>& roles)
+  {
+    const size_t frameworkCount = std::tr1::get<1>(GetParam());
+
+    vector<FrameworkInfo> frameworks;
+    for (size_t i = 0; i < frameworkCount; i++) {
+      frameworks.push_back(createFrameworkInfo(roles[i % roles.size()]));
+      allocator->addFramework(frameworks.back().id(), frameworks.back(), {});
+    }
+
+    return frameworks;
+  }
+
+  // Adds the slaves, with the resources of each slave given by
+  // 'resources' for its index.
+  void addSlaves(const lambda::function<string(size_t)>& resources)
+  {
+    const size_t slaveCount = std::tr1::get<0>(GetParam());
+
+    for (size_t i = 0; i < slaveCount; i++) {
+      SlaveInfo slave = createSlaveInfo(resources(i));
+      allocator->addSlave(
+          slave.id(), slave, None(), slave.resources(), {});
+    }
+
+    Clock::settle();
+  }
+
+  // Declines all the outstanding offers with the given filters.
+  void decline(const Option<Filters>& filters = None())
+  {
+    foreachpair (const FrameworkID& frameworkId,
+                 const auto& resources,
+                 offers) {
+      foreachpair (const SlaveID& slaveId,
+                   const Resources& offered,
+                   resources) {
+        allocator->recoverResources(frameworkId, slaveId, offered, filters);
+      }
+    }
+
+    offers.clear();
+
+    Clock::settle();
+  }
+
+  // Triggers the periodic allocation and waits for it to finish.
+  Duration cycle()
+  {
+    Stopwatch watch;
+    watch.start();
+
+    Clock::advance(flags.allocation_interval);
+    Clock::settle();
+
+    return watch.elapsed();
+  }
+
+  // The offers that were not declined yet. Only accessed by the
+  // allocator while it allocates and by the test while the allocator
+  // is idle, i.e., after `Clock::settle()`.
+  hashmap<FrameworkID, hashmap<SlaveID, Resources>> offers;
+
+  // Total number of offers of a slave to a framework.
+  size_t offerCount;
+};
+
+
+INSTANTIATE_TEST_CASE_P(
+    SlaveAndFrameworkCount,
+    HierarchicalAllocatorCycle_BENCHMARK_Test,
+    ::testing::Combine(
+      ::testing::Values(1000U, 10000U, 50000U),
+      ::testing::Values(10U, 500U, 5000U))
+    );
+
+
+// Measures allocation cycles in which all the resources are
+// declined without a filter and offered again.
+TEST_P(HierarchicalAllocatorCycle_BENCHMARK_Test, FullAllocation)
+{
+  Clock::pause();
+
+  initialize();
+
+  addFrameworks({"*"});
+  addSlaves([](size_t) {
+    return "cpus:24;mem:4096;disk:4096;ports:[31000-32000]";
+  });
+
+  vector<Duration> cycles;
+  const size_t offered = offerCount;
+
+  for (size_t i = 0; i < CYCLES; i++) {
+    decline();
+    cycles.push_back(cycle());
+  }
+
+  report("Full allocation", cycles, offerCount - offered);
+}
+
+
+// Measures allocation cycles in which the frameworks decline all
+// their offers with a long filter, so that the filters accumulate
+// and each slave is offered to the next framework in every cycle.
+TEST_P(HierarchicalAllocatorCycle_BENCHMARK_Test, DeclineWithFilters)
+{
+  Clock::pause();
+
+  initialize();
+
+  addFrameworks({"*"});
+  addSlaves([](size_t) {
+    return "cpus:24;mem:4096;disk:4096;ports:[31000-32000]";
+  });
+
+  Filters filters;
+  filters.set_refuse_seconds(Hours(1).secs());
+
+  vector<Duration> cycles;
+  const size_t offered = offerCount;
+
+  for (size_t i = 0; i < CYCLES; i++) {
+    decline(filters);
+    cycles.push_back(cycle());
+  }
+
+  report("Decline with filters", cycles, offerCount - offered);
+}
+
+
+// Measures allocation cycles with reserved resources on each slave
+// and quota for half of the roles.
+TEST_P(HierarchicalAllocatorCycle_BENCHMARK_Test, QuotaAndReservations)
+{
+  const size_t slaveCount = std::tr1::get<0>(GetParam());
+
+  vector<string> roles;
+  for (size_t i = 0; i < 10; i++) {
+    roles.push_back("role" + stringify(i));
+  }
+
+  Clock::pause();
+
+  initialize(roles);
+
+  // Each quota'ed role is guaranteed 2% of the unreserved resources.
+  for (size_t i = 0; i < roles.size(); i += 2) {
+    allocator->setQuota(
+        roles[i],
+        createQuotaInfo(
+            roles[i],
+            "cpus:" + stringify(slaveCount * 16 / 50) +
+            ";mem:" + stringify(slaveCount * 2048 / 50)));
+  }
+
+  addFrameworks(roles);
+  addSlaves([&roles](size_t i) {
+    const string& role = roles[i % roles.size()];
+    return "cpus:16;mem:2048;disk:4096;ports:[31000-32000];"
+           "cpus(" + role + "):8;mem(" + role + "):2048";
+  });
+
+  vector<Duration> cycles;
+  const size_t offered = offerCount;
+
+  for (size_t i = 0; i < CYCLES; i++) {
+    decline();
+    cycles.push_back(cycle());
+  }
+
+  report("Quota and reservations", cycles, offerCount - offered);
+}
+
+
+// Measures how long it takes to allocate after all the frameworks
+// revive their offers at once, e.g., after a master failover.
+TEST_P(HierarchicalAllocatorCycle_BENCHMARK_Test, ReviveStorm)
+{
+  Clock::pause();
+
+  initialize();
+
+  const vector<FrameworkInfo> frameworks = addFrameworks({"*"});
+  addSlaves([](size_t) {
+    return "cpus:24;mem:4096;disk:4096;ports:[31000-32000]";
+  });
+
+  vector<Duration> cycles;
+  size_t offered = 0;
+
+  for (size_t i = 0; i < CYCLES; i++) {
+    foreach (const FrameworkInfo& framework, frameworks) {
+      allocator->suppressOffers(framework.id());
+    }
+
+    decline();
+
+    const size_t before = offerCount;
+
+    Stopwatch watch;
+    watch.start();
+
+    foreach (const FrameworkInfo& framework, frameworks) {
+      allocator->reviveOffers(framework.id());
+    }
+
+    Clock::settle();
+
+    cycles.push_back(watch.elapsed());
+    offered += offerCount - before;
+  }
+
+  report("Revive storm", cycles, offered);
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -15,6 +15,7 @@
 // limitations under the License.
 
 #include <mesos/module.hpp>
+#include <mesos/type_utils.hpp>
 
 #include <process/clock.hpp>
 #include <process/future.hpp>
@@ -213,6 +214,42 @@ TEST_F(HookTest, VerifyMasterLaunchTaskHook)
 }
 
 
+// Test that the asynchronous label decorator hook decorates the task
+// just like the synchronous one.
+TEST_F(HookTest, VerifyMasterLaunchTaskHookAsync)
+{
+  TaskInfo task;
+  task.set_name("");
+  task.mutable_task_id()->set_value("1");
+  task.mutable_slave_id()->set_value("slave");
+  task.mutable_executor()->CopyFrom(DEFAULT_EXECUTOR_INFO);
+
+  // Add label which will be removed by the hook.
+  task.mutable_labels()->add_labels()->CopyFrom(createLabel(
+      testRemoveLabelKey, testRemoveLabelValue));
+
+  const FrameworkInfo frameworkInfo = DEFAULT_FRAMEWORK_INFO;
+
+  SlaveInfo slaveInfo;
+  slaveInfo.set_hostname("localhost");
+
+  Future<Labels> labels = HookManager::masterLaunchTaskLabelDecorator(
+      task, frameworkInfo, slaveInfo, Seconds(15));
+
+  AWAIT_READY(labels);
+
+  EXPECT_EQ(
+      HookManager::masterLaunchTaskLabelDecorator(
+          task, frameworkInfo, slaveInfo),
+      labels.get());
+
+  ASSERT_EQ(1, labels.get().labels_size());
+
+  EXPECT_EQ(testLabelKey, labels.get().labels().Get(0).key());
+  EXPECT_EQ(testLabelValue, labels.get().labels().Get(0).value());
+}
+
+
 // This test forces a `SlaveLost` event. When this happens, we expect the
 // `masterSlaveLostHook` to be invoked and await an internal libprocess event
 // to trigger in the module code.
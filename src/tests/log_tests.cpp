@@ -19,6 +19,7 @@
 #include <list>
 #include <set>
 #include <string>
+#include <vector>
 
 #include <gmock/gmock.h>
 
@@ -65,6 +66,7 @@ using namespace process;
 using std::list;
 using std::set;
 using std::string;
+using std::vector;
 
 using testing::_;
 using testing::Eq;
@@ -316,6 +318,111 @@ TYPED_TEST(LogStorageTest, TruncateWithManyHoles)
 }
 
 
+TYPED_TEST(LogStorageTest, Compact)
+{
+  TypeParam storage;
+
+  Try<Storage::State> state = storage.restore(os::getcwd() + "/.log");
+  ASSERT_SOME(state);
+
+  // Append from position 0 to position 99, and truncate to position
+  // 100 (at position 100).
+  vector<Action> actions;
+
+  for (uint64_t i = 0; i < 100; i++) {
+    Action action;
+    action.set_position(i);
+    action.set_promised(1);
+    action.set_performed(1);
+    action.set_learned(true);
+    action.set_type(Action::APPEND);
+    action.mutable_append()->set_bytes(string(1024, 'a'));
+
+    actions.push_back(action);
+  }
+
+  ASSERT_SOME(storage.persist(actions));
+
+  Action truncate;
+  truncate.set_position(100);
+  truncate.set_promised(1);
+  truncate.set_performed(1);
+  truncate.set_learned(true);
+  truncate.set_type(Action::TRUNCATE);
+  truncate.mutable_truncate()->set_to(100);
+
+  ASSERT_SOME(storage.persist(truncate));
+
+  ASSERT_SOME(storage.compact(100));
+
+  Try<Bytes> size = storage.size();
+  ASSERT_SOME(size);
+  EXPECT_LT(Bytes(0), size.get());
+
+  // The truncated positions are gone, but the truncate is still there.
+  EXPECT_ERROR(storage.read(0));
+  EXPECT_ERROR(storage.read(99));
+  EXPECT_SOME(storage.read(100));
+}
+
+
+TYPED_TEST(LogStorageTest, PersistBatch)
+{
+  TypeParam storage;
+
+  Try<Storage::State> state = storage.restore(os::getcwd() + "/.log");
+  ASSERT_SOME(state);
+
+  // Append from position 0 to position 9, and truncate to position 5
+  // (at position 10), all in one batch.
+  vector<Action> actions;
+
+  for (uint64_t i = 0; i < 10; i++) {
+    Action action;
+    action.set_position(i);
+    action.set_promised(1);
+    action.set_performed(1);
+    action.set_learned(true);
+    action.set_type(Action::APPEND);
+    action.mutable_append()->set_bytes(stringify(i));
+
+    actions.push_back(action);
+  }
+
+  Action truncate;
+  truncate.set_position(10);
+  truncate.set_promised(1);
+  truncate.set_performed(1);
+  truncate.set_learned(true);
+  truncate.set_type(Action::TRUNCATE);
+  truncate.mutable_truncate()->set_to(5);
+
+  actions.push_back(truncate);
+
+  ASSERT_SOME(storage.persist(actions));
+
+  for (uint64_t i = 0; i < 11; i++) {
+    Try<Action> action = storage.read(i);
+
+    if (i < 5) {
+      // Position 0 to 4 have been truncated.
+      EXPECT_ERROR(action);
+    } else if (i == 10) {
+      ASSERT_SOME(action);
+      EXPECT_EQ(Action::TRUNCATE, action.get().type());
+      ASSERT_TRUE(action.get().has_truncate());
+      EXPECT_EQ(5u, action.get().truncate().to());
+    } else {
+      ASSERT_SOME(action);
+      EXPECT_EQ(i, action.get().position());
+      EXPECT_EQ(Action::APPEND, action.get().type());
+      ASSERT_TRUE(action.get().has_append());
+      EXPECT_EQ(stringify(i), action.get().append().bytes());
+    }
+  }
+}
+
+
 class ReplicaTest : public TemporaryDirectoryTest
 {
 protected:
@@ -1193,6 +1300,58 @@ TEST_F(CoordinatorTest, MultipleAppends)
 }
 
 
+// Tests that appends issued before the previous ones have finished
+// are written to consecutive positions, in the order they were issued.
+TEST_F(CoordinatorTest, PipelinedAppends)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network(new Network(pids));
+
+  Coordinator coord(2, replica1, network, 4);
+
+  {
+    Future<Option<uint64_t> > electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  vector<Future<Option<uint64_t> > > appends;
+  for (uint64_t position = 1; position <= 10; position++) {
+    appends.push_back(coord.append(stringify(position)));
+  }
+
+  for (uint64_t position = 1; position <= 10; position++) {
+    AWAIT_READY(appends[position - 1]);
+    EXPECT_SOME_EQ(position, appends[position - 1].get());
+  }
+
+  {
+    Future<list<Action> > actions = replica1->read(1, 10);
+    AWAIT_READY(actions);
+    EXPECT_EQ(10u, actions.get().size());
+    foreach (const Action& action, actions.get()) {
+      ASSERT_TRUE(action.has_type());
+      ASSERT_EQ(Action::APPEND, action.type());
+      EXPECT_EQ(stringify(action.position()), action.append().bytes());
+    }
+  }
+}
+
+
 TEST_F(CoordinatorTest, MultipleAppendsNotLearnedFill)
 {
   const string path1 = os::getcwd() + "/.log1";
@@ -1806,6 +1965,10 @@ TEST_F(RecoverTest, CatchupRetry)
   // promise phase even if replica1 reemerges later.
   DROP_MESSAGE(Eq(PromiseRequest().GetTypeName()), _, Eq(replica1->pid()));
 
+  // Do not let the catch-up process copy the learned actions from
+  // replica1, so that it has to go through consensus.
+  DROP_MESSAGES(Eq(CatchUpRequest().GetTypeName()), _, Eq(replica1->pid()));
+
   Future<Nothing> catching =
     catchup(2, replica3, network2, None(), positions, Seconds(10));
 
@@ -1832,6 +1995,74 @@ TEST_F(RecoverTest, CatchupRetry)
 }
 
 
+// Tests that a replica catches up the positions that the other
+// replicas have learned by copying the actions from them, i.e.,
+// without running consensus on each position.
+TEST_F(RecoverTest, CatchupTransfer)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  const string path3 = os::getcwd() + "/.log3";
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord(2, replica1, network1);
+
+  {
+    Future<Option<uint64_t> > electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  IntervalSet<uint64_t> positions;
+
+  for (uint64_t position = 1; position <= 10; position++) {
+    Future<Option<uint64_t> > appending = coord.append(stringify(position));
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position, appending.get());
+    positions += position;
+  }
+
+  Shared<Replica> replica3(new Replica(path3));
+
+  pids.insert(replica3->pid());
+
+  Shared<Network> network2(new Network(pids));
+
+  // The catch-up process can not get any promises, so it has to copy
+  // the learned actions.
+  DROP_MESSAGES(Eq(PromiseRequest().GetTypeName()), _, _);
+
+  Future<Nothing> catching =
+    catchup(2, replica3, network2, None(), positions, Seconds(10));
+
+  AWAIT_READY(catching);
+
+  Future<list<Action> > actions = replica3->read(1, 10);
+  AWAIT_READY(actions);
+  ASSERT_EQ(10u, actions.get().size());
+
+  foreach (const Action& action, actions.get()) {
+    EXPECT_TRUE(action.learned());
+    ASSERT_EQ(Action::APPEND, action.type());
+    EXPECT_EQ(stringify(action.position()), action.append().bytes());
+  }
+}
+
+
 TEST_F(RecoverTest, AutoInitialization)
 {
   const string path1 = os::getcwd() + "/.log1";
@@ -2020,6 +2251,141 @@ TEST_F(LogTest, WriteRead)
 }
 
 
+// This test verifies that a writer that compresses its entries
+// stores them compressed in the replicas (unless compressing does not
+// make them smaller), and that readers decompress them.
+TEST_F(LogTest, WriteReadCompressed)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  Replica replica1(path1);
+
+  set<UPID> pids;
+  pids.insert(replica1.pid());
+
+  Log log(2, path2, pids);
+
+  Log::Writer writer(&log, 1, true);
+
+  Future<Option<Log::Position> > start = writer.start();
+
+  AWAIT_READY(start);
+  ASSERT_SOME(start.get());
+
+  const string data(4096, 'a');
+
+  Future<Option<Log::Position> > position1 = writer.append(data);
+
+  AWAIT_READY(position1);
+  ASSERT_SOME(position1.get());
+
+  Future<Option<Log::Position> > position2 = writer.append("hello world");
+
+  AWAIT_READY(position2);
+  ASSERT_SOME(position2.get());
+
+  Log::Reader reader(&log);
+
+  Future<list<Log::Entry> > entries =
+    reader.read(position1.get().get(), position2.get().get());
+
+  AWAIT_READY(entries);
+
+  ASSERT_EQ(2u, entries.get().size());
+  EXPECT_EQ(data, entries.get().front().data);
+  EXPECT_EQ("hello world", entries.get().back().data);
+
+  Future<uint64_t> ending = replica1.ending();
+  AWAIT_READY(ending);
+
+  Future<list<Action> > actions = replica1.read(ending.get() - 1, ending.get());
+  AWAIT_READY(actions);
+
+  ASSERT_EQ(2u, actions.get().size());
+
+  const Action::Append& append1 = actions.get().front().append();
+  EXPECT_EQ(Action::Append::GZIP, append1.compression());
+  EXPECT_GT(data.size(), append1.bytes().size());
+
+  const Action::Append& append2 = actions.get().back().append();
+  EXPECT_EQ(Action::Append::NONE, append2.compression());
+  EXPECT_EQ("hello world", append2.bytes());
+}
+
+
+TEST_F(LogTest, ReadInBatches)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  Replica replica1(path1);
+
+  set<UPID> pids;
+  pids.insert(replica1.pid());
+
+  Log log(2, path2, pids);
+
+  Log::Writer writer(&log);
+
+  Future<Option<Log::Position> > start = writer.start();
+
+  AWAIT_READY(start);
+  ASSERT_SOME(start.get());
+
+  vector<Log::Position> positions;
+
+  for (int i = 0; i < 10; i++) {
+    Future<Option<Log::Position> > position = writer.append(stringify(i));
+
+    AWAIT_READY(position);
+    ASSERT_SOME(position.get());
+
+    positions.push_back(position.get().get());
+  }
+
+  Log::Reader reader(&log);
+
+  vector<list<Log::Entry> > batches;
+
+  Future<Nothing> read = reader.read(
+      positions.front(),
+      positions.back(),
+      [&batches](const list<Log::Entry>& entries) -> Future<Nothing> {
+        batches.push_back(entries);
+        return Nothing();
+      },
+      3);
+
+  AWAIT_READY(read);
+
+  ASSERT_EQ(4u, batches.size());
+  EXPECT_EQ(3u, batches[0].size());
+  EXPECT_EQ(1u, batches[3].size());
+
+  int i = 0;
+  foreach (const list<Log::Entry>& entries, batches) {
+    foreach (const Log::Entry& entry, entries) {
+      EXPECT_EQ(positions[i], entry.position);
+      EXPECT_EQ(stringify(i), entry.data);
+      i++;
+    }
+  }
+
+  EXPECT_EQ(10, i);
+}
+
+
 TEST_F(LogTest, Position)
 {
   const string path1 = os::getcwd() + "/.log1";
@@ -14,20 +14,44 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <time.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include <gmock/gmock.h>
 
+#include <glog/logging.h>
+
 #include <process/future.hpp>
 #include <process/gtest.hpp>
 #include <process/http.hpp>
 #include <process/pid.hpp>
 #include <process/process.hpp>
 
+#include <process/metrics/counter.hpp>
+
+#include <stout/stringify.hpp>
+
+#include "logging/async_logger.hpp"
 #include "logging/logging.hpp"
 
+using mesos::internal::logging::AsyncLogger;
+
+using process::metrics::Counter;
+
 using process::http::BadRequest;
 using process::http::OK;
 using process::http::Response;
 
+using std::string;
+using std::vector;
+
 namespace mesos {
 namespace internal {
 namespace tests {
@@ -79,6 +103,223 @@ TEST(LoggingTest, Toggle)
       response);
 }
 
+
+// A logger which records the messages written to it. It can be
+// blocked to stall the background thread of an AsyncLogger, in which
+// case 'Write' returns only once the logger is unblocked.
+class TestLogger : public google::base::Logger
+{
+public:
+  TestLogger() : blocked(false), flushes(0) {}
+
+  virtual void Write(
+      bool forceFlush,
+      time_t timestamp,
+      const char* message,
+      int length)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    messages.push_back(string(message, length));
+    forced.push_back(forceFlush);
+
+    written.notify_all();
+    unblocked.wait(lock, [this]() { return !blocked; });
+  }
+
+  virtual void Flush()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    flushes++;
+  }
+
+  virtual google::uint32 LogSize()
+  {
+    return 0;
+  }
+
+  void block()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    blocked = true;
+  }
+
+  void unblock()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      blocked = false;
+    }
+
+    unblocked.notify_all();
+  }
+
+  // Waits until the given number of messages were written.
+  bool await(size_t count)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    return written.wait_for(lock, std::chrono::seconds(15), [=]() {
+      return messages.size() >= count;
+    });
+  }
+
+  vector<string> messages;
+  vector<bool> forced;
+
+  bool blocked;
+  int flushes;
+
+private:
+  std::mutex mutex;
+  std::condition_variable written;
+  std::condition_variable unblocked;
+};
+
+
+static void write(AsyncLogger* logger, const string& message)
+{
+  logger->Write(false, time(NULL), message.data(), message.size());
+}
+
+
+// This test verifies that the asynchronous logger writes out all the
+// messages, in order, once it is flushed.
+TEST(AsyncLoggerTest, Flush)
+{
+  TestLogger base;
+  Counter dropped("logging/dropped_lines");
+
+  {
+    AsyncLogger logger(&base, 1024, true, dropped);
+
+    write(&logger, "message1");
+    write(&logger, "message2");
+    write(&logger, "message3");
+
+    logger.Flush();
+
+    EXPECT_EQ(
+        vector<string>({"message1", "message2", "message3"}),
+        base.messages);
+
+    EXPECT_EQ(vector<bool>({false, false, false}), base.forced);
+    EXPECT_EQ(1, base.flushes);
+
+    // The messages that glog wants flushed are written synchronously,
+    // after all the buffered messages.
+    write(&logger, "message4");
+    logger.Write(true, time(NULL), "fatal", 5);
+
+    EXPECT_EQ(
+        vector<string>({"message1", "message2", "message3", "message4",
+                        "fatal"}),
+        base.messages);
+
+    EXPECT_TRUE(base.forced.back());
+
+    // A message which does not even fit into an empty buffer is
+    // written synchronously as well.
+    const string message(2048, 'x');
+    write(&logger, message);
+
+    EXPECT_EQ(6u, base.messages.size());
+    EXPECT_EQ(message, base.messages.back());
+
+    // The messages that are still buffered are written out when the
+    // logger is destroyed.
+    write(&logger, "message5");
+  }
+
+  EXPECT_EQ("message5", base.messages.back());
+
+  AWAIT_EXPECT_EQ(0.0, dropped.value());
+}
+
+
+// This test verifies that the messages which do not fit into the
+// buffer anymore are dropped, and counted, in the 'drop' mode.
+TEST(AsyncLoggerTest, OverflowDrop)
+{
+  TestLogger base;
+  Counter dropped("logging/dropped_lines");
+
+  AsyncLogger logger(&base, 1024, true, dropped);
+
+  // Stall the background thread while it writes the first message.
+  base.block();
+  write(&logger, "0");
+  ASSERT_TRUE(base.await(1));
+
+  for (int i = 1; i <= 100; i++) {
+    write(&logger, stringify(i));
+  }
+
+  base.unblock();
+  logger.Flush();
+
+  process::Future<double> value = dropped.value();
+  AWAIT_READY(value);
+
+  EXPECT_LT(0.0, value.get());
+  EXPECT_EQ(101.0, base.messages.size() + value.get());
+
+  // Once the buffer is full no space is freed up as the background
+  // thread is stalled, hence all the subsequent messages are dropped.
+  for (size_t i = 0; i < base.messages.size(); i++) {
+    EXPECT_EQ(stringify(i), base.messages[i]);
+  }
+
+  // The buffer has space again.
+  write(&logger, "101");
+  logger.Flush();
+
+  EXPECT_EQ("101", base.messages.back());
+  AWAIT_EXPECT_EQ(value.get(), dropped.value());
+}
+
+
+// This test verifies that the writer waits for the background thread
+// to make space in the buffer in the 'block' mode.
+TEST(AsyncLoggerTest, OverflowBlock)
+{
+  TestLogger base;
+  Counter dropped("logging/dropped_lines");
+
+  AsyncLogger logger(&base, 1024, false, dropped);
+
+  // Stall the background thread while it writes the first message.
+  base.block();
+  write(&logger, "0");
+  ASSERT_TRUE(base.await(1));
+
+  std::atomic<bool> done(false);
+
+  std::thread writer([&]() {
+    for (int i = 1; i <= 100; i++) {
+      write(&logger, stringify(i));
+    }
+    done = true;
+  });
+
+  // The writer can not finish as long as the buffer is full.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_FALSE(done);
+
+  base.unblock();
+  writer.join();
+
+  logger.Flush();
+
+  ASSERT_EQ(101u, base.messages.size());
+
+  for (size_t i = 0; i < base.messages.size(); i++) {
+    EXPECT_EQ(stringify(i), base.messages[i]);
+  }
+
+  AWAIT_EXPECT_EQ(0.0, dropped.value());
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -0,0 +1,475 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <mesos/mesos.hpp>
+#include <mesos/resources.hpp>
+#include <mesos/scheduler.hpp>
+
+#include <process/clock.hpp>
+#include <process/collect.hpp>
+#include <process/delay.hpp>
+#include <process/future.hpp>
+#include <process/gtest.hpp>
+#include <process/http.hpp>
+#include <process/id.hpp>
+#include <process/owned.hpp>
+#include <process/pid.hpp>
+#include <process/process.hpp>
+#include <process/protobuf.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/json.hpp>
+#include <stout/os.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
+#include <stout/synchronized.hpp>
+#include <stout/uuid.hpp>
+
+#include "common/protobuf_utils.hpp"
+
+#include "master/master.hpp"
+
+#include "messages/messages.hpp"
+
+#include "tests/mesos.hpp"
+
+using mesos::internal::master::Master;
+
+using process::Clock;
+using process::Future;
+using process::Owned;
+using process::PID;
+using process::Promise;
+using process::UPID;
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+using testing::WithParamInterface;
+
+namespace mesos {
+namespace internal {
+namespace tests {
+
+// A simulated agent which registers with the master and "runs" the
+// tasks it gets by sending TASK_RUNNING right away and TASK_FINISHED
+// after the given duration, without any executors, so that a single
+// test process can simulate thousands of agents.
+class TestSlaveProcess : public ProtobufProcess<TestSlaveProcess>
+{
+public:
+  TestSlaveProcess(
+      const UPID& _master,
+      const SlaveInfo& _info,
+      const Duration& _taskDuration)
+    : ProcessBase(process::ID::generate("test-slave")),
+      master(_master),
+      info(_info),
+      taskDuration(_taskDuration) {}
+
+  virtual ~TestSlaveProcess() {}
+
+  Future<Nothing> registered()
+  {
+    return promise.future();
+  }
+
+protected:
+  virtual void initialize()
+  {
+    install<SlaveRegisteredMessage>(
+        &TestSlaveProcess::_registered,
+        &SlaveRegisteredMessage::slave_id);
+
+    install<PingSlaveMessage>(&TestSlaveProcess::ping);
+
+    install<RunTaskMessage>(
+        &TestSlaveProcess::runTask,
+        &RunTaskMessage::framework,
+        &RunTaskMessage::task);
+
+    doRegistration();
+  }
+
+private:
+  void doRegistration()
+  {
+    if (slaveId.isSome()) {
+      return;
+    }
+
+    RegisterSlaveMessage message;
+    message.mutable_slave()->CopyFrom(info);
+    message.set_version(MESOS_VERSION);
+    send(master, message);
+
+    // Retry, e.g., if the master had not recovered yet.
+    process::delay(Seconds(1), self(), &TestSlaveProcess::doRegistration);
+  }
+
+  void _registered(const SlaveID& _slaveId)
+  {
+    if (slaveId.isNone()) {
+      slaveId = _slaveId;
+      promise.set(Nothing());
+    }
+  }
+
+  void ping(const UPID& from)
+  {
+    send(from, PongSlaveMessage());
+  }
+
+  void runTask(const FrameworkInfo& framework, const TaskInfo& task)
+  {
+    update(framework.id(), task.task_id(), TASK_RUNNING);
+
+    process::delay(
+        taskDuration,
+        self(),
+        &TestSlaveProcess::update,
+        framework.id(),
+        task.task_id(),
+        TASK_FINISHED);
+  }
+
+  void update(
+      const FrameworkID& frameworkId,
+      const TaskID& taskId,
+      const TaskState& state)
+  {
+    CHECK_SOME(slaveId);
+
+    StatusUpdateMessage message;
+    message.mutable_update()->CopyFrom(protobuf::createStatusUpdate(
+        frameworkId,
+        slaveId.get(),
+        taskId,
+        state,
+        TaskStatus::SOURCE_EXECUTOR,
+        UUID::random()));
+    message.set_pid(self());
+
+    send(master, message);
+  }
+
+  const UPID master;
+  const SlaveInfo info;
+  const Duration taskDuration;
+
+  Option<SlaveID> slaveId;
+  Promise<Nothing> promise;
+};
+
+
+// A scheduler which launches tasks of 1 cpu on all of the offered
+// resources until it has launched 'tasks' tasks, and records the
+// latencies of the offers and launches.
+class TestScheduler : public Scheduler
+{
+public:
+  explicit TestScheduler(size_t _tasks)
+    : tasks(_tasks), launched(0), terminated(0) {}
+
+  virtual ~TestScheduler() {}
+
+  virtual void registered(
+      SchedulerDriver* driver,
+      const FrameworkID& frameworkId,
+      const MasterInfo& masterInfo)
+  {
+    registeredTime = Clock::now();
+  }
+
+  virtual void reregistered(SchedulerDriver*, const MasterInfo&) {}
+
+  virtual void disconnected(SchedulerDriver* driver) {}
+
+  virtual void resourceOffers(
+      SchedulerDriver* driver,
+      const vector<Offer>& offers)
+  {
+    const process::Time now = Clock::now();
+
+    synchronized (mutex) {
+      foreach (const Offer& offer, offers) {
+        offerLatencies.push_back(now - registeredTime);
+
+        vector<TaskInfo> infos;
+
+        Resources remaining = offer.resources();
+        const Resources resources = Resources::parse("cpus:1;mem:32").get();
+
+        while (launched < tasks && remaining.contains(resources)) {
+          TaskInfo task;
+          task.set_name("");
+          task.mutable_task_id()->set_value(stringify(launched++));
+          task.mutable_slave_id()->CopyFrom(offer.slave_id());
+          task.mutable_resources()->CopyFrom(resources);
+          task.mutable_command()->set_value("exit 0");
+
+          launchTimes[task.task_id()] = now;
+          infos.push_back(task);
+
+          remaining -= resources;
+        }
+
+        driver->launchTasks(offer.id(), infos);
+      }
+    }
+  }
+
+  virtual void offerRescinded(SchedulerDriver*, const OfferID&) {}
+
+  virtual void statusUpdate(SchedulerDriver* driver, const TaskStatus& status)
+  {
+    const process::Time now = Clock::now();
+
+    synchronized (mutex) {
+      if (status.state() == TASK_RUNNING &&
+          launchTimes.contains(status.task_id())) {
+        runningLatencies.push_back(now - launchTimes[status.task_id()]);
+
+        if (runningLatencies.size() == tasks) {
+          running.set(Nothing());
+        }
+      } else if (protobuf::isTerminalState(status.state())) {
+        if (++terminated == tasks) {
+          finished.set(Nothing());
+        }
+      }
+    }
+  }
+
+  virtual void frameworkMessage(
+      SchedulerDriver*, const ExecutorID&, const SlaveID&, const string&) {}
+
+  virtual void slaveLost(SchedulerDriver*, const SlaveID&) {}
+
+  virtual void executorLost(
+      SchedulerDriver*, const ExecutorID&, const SlaveID&, int) {}
+
+  virtual void error(SchedulerDriver*, const string& message)
+  {
+    running.fail(message);
+    finished.fail(message);
+  }
+
+  const size_t tasks;
+
+  std::mutex mutex;
+  process::Time registeredTime;
+  size_t launched;
+  size_t terminated;
+  hashmap<TaskID, process::Time> launchTimes;
+  vector<Duration> offerLatencies;
+  vector<Duration> runningLatencies;
+
+  Promise<Nothing> running;
+  Promise<Nothing> finished;
+};
+
+
+// Prints the percentiles of the given latencies.
+static void report(const string& name, vector<Duration> latencies)
+{
+  if (latencies.empty()) {
+    return;
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+
+  auto percentile = [&latencies](double p) {
+    return latencies[std::min(
+        latencies.size() - 1,
+        static_cast<size_t>(p * latencies.size()))];
+  };
+
+  cout << name << ": p50 " << percentile(0.5)
+       << ", p90 " << percentile(0.9)
+       << ", p99 " << percentile(0.99)
+       << ", max " << latencies.back() << endl;
+}
+
+
+class Master_BENCHMARK_Test
+  : public MesosTest,
+    public WithParamInterface<std::tr1::tuple<size_t, size_t>>
+{
+protected:
+  // Waits for 'future' while sampling the master's event queue,
+  // returning the deepest queue seen. Note that the snapshot endpoint
+  // is rate limited, which bounds the sampling rate.
+  size_t await(const Future<Nothing>& future, const Duration& timeout)
+  {
+    size_t depth = 0;
+
+    Stopwatch watch;
+    watch.start();
+
+    while (!future.isReady() && watch.elapsed() < timeout) {
+      if (future.isFailed() || future.isDiscarded()) {
+        break;
+      }
+
+      JSON::Object snapshot = Metrics();
+
+      foreach (const string& name,
+               vector<string>({"master/event_queue_messages",
+                               "master/event_queue_dispatches",
+                               "master/event_queue_http_requests"})) {
+        Result<JSON::Number> value = snapshot.find<JSON::Number>(name);
+        if (value.isSome()) {
+          depth = std::max(
+              depth,
+              static_cast<size_t>(value.get().as<double>()));
+        }
+      }
+
+      os::sleep(Milliseconds(500));
+    }
+
+    return depth;
+  }
+};
+
+
+// The master benchmarks are parameterized by the number of agents
+// and the number of tasks (of 1 cpu) per agent.
+INSTANTIATE_TEST_CASE_P(
+    SlaveAndTaskCount,
+    Master_BENCHMARK_Test,
+    ::testing::Combine(
+      ::testing::Values(1000U, 5000U, 10000U, 20000U),
+      ::testing::Values(1U, 10U)));
+
+
+// Simulates a cluster of agents and a framework which launches tasks
+// on all of them, which finish after a while. Reports how long the
+// agents took to register, the latencies of the offers and of the
+// launches (until TASK_RUNNING), the deepest master event queue seen
+// and how long the master took to render its state.
+TEST_P(Master_BENCHMARK_Test, Cluster)
+{
+  const size_t slaveCount = std::tr1::get<0>(GetParam());
+  const size_t tasksPerSlave = std::tr1::get<1>(GetParam());
+  const size_t taskCount = slaveCount * tasksPerSlave;
+
+  // The simulated agents and framework do not authenticate, and
+  // the in-memory registry keeps disk latency out of the results.
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.authenticate_frameworks = false;
+  masterFlags.authenticate_slaves = false;
+  masterFlags.registry = "in_memory";
+
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  cout << "Using " << slaveCount << " agents"
+       << " and " << taskCount << " tasks" << endl;
+
+  Stopwatch watch;
+  watch.start();
+
+  vector<Owned<TestSlaveProcess>> slaves;
+  std::list<Future<Nothing>> registered;
+
+  for (size_t i = 0; i < slaveCount; i++) {
+    SlaveInfo info;
+    info.set_hostname("localhost");
+    info.mutable_resources()->CopyFrom(Resources::parse(
+        "cpus:" + stringify(tasksPerSlave) + ";"
+        "mem:" + stringify(tasksPerSlave * 32)).get());
+
+    Owned<TestSlaveProcess> slave(
+        new TestSlaveProcess(master.get(), info, Seconds(10)));
+
+    spawn(slave.get());
+
+    slaves.push_back(slave);
+    registered.push_back(slave->registered());
+  }
+
+  size_t depth = await(
+      process::collect(registered).then([]() { return Nothing(); }),
+      Minutes(10));
+
+  cout << "Registered " << slaveCount << " agents in " << watch.elapsed()
+       << ", deepest master event queue " << depth << endl;
+
+  TestScheduler scheduler(taskCount);
+
+  MesosSchedulerDriver driver(
+      &scheduler, DEFAULT_FRAMEWORK_INFO, master.get());
+
+  watch.start();
+
+  driver.start();
+
+  depth = await(scheduler.running.future(), Minutes(10));
+
+  cout << "Launched " << taskCount << " tasks in " << watch.elapsed()
+       << ", deepest master event queue " << depth << endl;
+
+  synchronized (scheduler.mutex) {
+    report("Offer latency", scheduler.offerLatencies);
+    report("Launch to TASK_RUNNING latency", scheduler.runningLatencies);
+  }
+
+  watch.start();
+
+  Future<process::http::Response> state =
+    process::http::get(master.get(), "state");
+
+  AWAIT_READY_FOR(state, Minutes(5));
+
+  cout << "Rendered /state of " << state.get().body.size() << " bytes in "
+       << watch.elapsed() << endl;
+
+  watch.start();
+
+  depth = await(scheduler.finished.future(), Minutes(10));
+
+  cout << "Finished " << taskCount << " tasks in " << watch.elapsed()
+       << ", deepest master event queue " << depth << endl;
+
+  driver.stop();
+  driver.join();
+
+  foreach (const Owned<TestSlaveProcess>& slave, slaves) {
+    terminate(slave.get());
+    wait(slave.get());
+  }
+
+  Shutdown();
+}
+
+} // namespace tests {
+} // namespace internal {
+} // namespace mesos {
@@ -672,6 +672,76 @@ TEST_F(MasterQuotaTest, InsufficientResourcesMultipleAgents)
 }
 
 
+// Checks that a quota request is rejected if there are sufficient
+// total resources only when counting an agent which is disconnected,
+// as the agents which do not participate in resource allocation do
+// not count towards the capacity of the cluster.
+TEST_F(MasterQuotaTest, InsufficientResourcesDisconnectedAgent)
+{
+  TestAllocator<> allocator;
+  EXPECT_CALL(allocator, initialize(_, _, _, _));
+
+  Try<PID<Master>> master = StartMaster(&allocator);
+  ASSERT_SOME(master);
+
+  // Start one agent and wait until it registers.
+  Future<Resources> agent1TotalResources;
+  EXPECT_CALL(allocator, addSlave(_, _, _, _, _))
+    .WillOnce(DoAll(InvokeAddSlave(&allocator),
+                    FutureArg<3>(&agent1TotalResources)));
+
+  Try<PID<Slave>> agent1 = StartSlave();
+  ASSERT_SOME(agent1);
+
+  AWAIT_READY(agent1TotalResources);
+  EXPECT_EQ(defaultAgentResources, agent1TotalResources.get());
+
+  // Start another agent and wait until it registers.
+  Future<Resources> agent2TotalResources;
+  EXPECT_CALL(allocator, addSlave(_, _, _, _, _))
+    .WillOnce(DoAll(InvokeAddSlave(&allocator),
+                    FutureArg<3>(&agent2TotalResources)));
+
+  Try<PID<Slave>> agent2 = StartSlave();
+  ASSERT_SOME(agent2);
+
+  AWAIT_READY(agent2TotalResources);
+  EXPECT_EQ(defaultAgentResources, agent2TotalResources.get());
+
+  // Stop the second agent and wait until the master deactivates it.
+  Future<Nothing> deactivateSlave;
+  EXPECT_CALL(allocator, deactivateSlave(_))
+    .WillOnce(DoAll(InvokeDeactivateSlave(&allocator),
+                    FutureSatisfy(&deactivateSlave)));
+
+  Stop(agent2.get());
+
+  AWAIT_READY(deactivateSlave);
+
+  // Our quota request requires the resources of both agents.
+  Resources quotaResources =
+    agent1TotalResources.get().filter([=](const Resource& resource) {
+      return (resource.name() == "cpus" || resource.name() == "mem");
+    }) +
+    agent2TotalResources.get().filter([=](const Resource& resource) {
+      return (resource.name() == "cpus" || resource.name() == "mem");
+    });
+
+  quotaResources = quotaResources.flatten(ROLE1);
+
+  Future<Response> response = process::http::post(
+      master.get(),
+      "quota",
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL),
+      createRequestBody(quotaResources));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(Conflict().status, response)
+    << response.get().body;
+
+  Shutdown();
+}
+
+
 // Checks that an operator can request quota when enough resources are
 // available on single agent.
 TEST_F(MasterQuotaTest, AvailableResourcesSingleAgent)
@@ -42,16 +42,21 @@
 #include <stout/net.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
+#include <stout/protobuf.hpp>
+#include <stout/recordio.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 #include <stout/try.hpp>
 
 #include "common/build.hpp"
 #include "common/protobuf_utils.hpp"
+#include "common/recordio.hpp"
 
 #include "master/flags.hpp"
 #include "master/master.hpp"
 
 #include "master/allocator/mesos/allocator.hpp"
+#include "master/allocator/mesos/hierarchical.hpp"
 
 #include "slave/constants.hpp"
 #include "slave/gc.hpp"
@@ -67,6 +72,7 @@
 
 using mesos::internal::master::Master;
 
+using mesos::internal::master::allocator::HierarchicalDRFOptimisticAllocator;
 using mesos::internal::master::allocator::MesosAllocatorProcess;
 
 using mesos::internal::protobuf::createLabel;
@@ -177,6 +183,11 @@ TEST_F(MasterTest, TaskRunning)
 
   AWAIT_READY(update);
 
+  // The task is counted in its new state.
+  JSON::Object stats = Metrics();
+  EXPECT_EQ(0u, stats.values["master/tasks_staging"]);
+  EXPECT_EQ(1u, stats.values["master/tasks_running"]);
+
   EXPECT_CALL(exec, shutdown(_))
     .Times(AtMost(1));
 
@@ -935,6 +946,85 @@ TEST_F(MasterTest, MultipleExecutors)
 }
 
 
+// This test verifies that the master sends the tasks launched onto
+// the same executor to the slave in one RunTasksMessage.
+TEST_F(MasterTest, LaunchTasksOntoSameExecutor)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  TestContainerizer containerizer(&exec);
+
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .Times(1);
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  ASSERT_NE(0u, offers.get().size());
+
+  vector<TaskInfo> tasks;
+  for (int i = 0; i < 2; i++) {
+    TaskInfo task;
+    task.set_name("");
+    task.mutable_task_id()->set_value(stringify(i));
+    task.mutable_slave_id()->MergeFrom(offers.get()[0].slave_id());
+    task.mutable_resources()->MergeFrom(
+        Resources::parse("cpus:1;mem:512").get());
+    task.mutable_executor()->MergeFrom(DEFAULT_EXECUTOR_INFO);
+
+    tasks.push_back(task);
+  }
+
+  EXPECT_CALL(exec, registered(_, _, _, _))
+    .Times(1);
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillRepeatedly(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status1, status2;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status1))
+    .WillOnce(FutureArg<1>(&status2));
+
+  Future<RunTasksMessage> runTasksMessage =
+    FUTURE_PROTOBUF(RunTasksMessage(), master.get(), slave.get());
+
+  driver.launchTasks(offers.get()[0].id(), tasks);
+
+  AWAIT_READY(runTasksMessage);
+  EXPECT_EQ(2, runTasksMessage.get().tasks_size());
+
+  AWAIT_READY(status1);
+  EXPECT_EQ(TASK_RUNNING, status1.get().state());
+
+  AWAIT_READY(status2);
+  EXPECT_EQ(TASK_RUNNING, status2.get().state());
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
+
 TEST_F(MasterTest, MasterInfo)
 {
   Try<PID<Master>> master = StartMaster();
@@ -1617,6 +1707,46 @@ TEST_F(MasterTest, MetricsInMetricsEndpoint)
 }
 
 
+// Ensures that the master and the slave keep metrics of the protobuf
+// messages they handle, per message type.
+TEST_F(MasterTest, MessageHandlerMetrics)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
+
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  // Ensure the slave has handled the message.
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  JSON::Object snapshot = Metrics();
+
+  const string master_ = "master/handlers/mesos.internal.RegisterSlaveMessage";
+
+  EXPECT_EQ(1u, snapshot.values.count(master_ + "/messages"));
+  EXPECT_EQ(1, snapshot.values[master_ + "/messages"]);
+  EXPECT_EQ(1u, snapshot.values.count(master_ + "/bytes"));
+  EXPECT_NE(0, snapshot.values[master_ + "/bytes"]);
+  EXPECT_EQ(1u, snapshot.values.count(master_ + "/time_ms"));
+
+  const string slave_ = "slave/handlers/mesos.internal.SlaveRegisteredMessage";
+
+  EXPECT_EQ(1u, snapshot.values.count(slave_ + "/messages"));
+  EXPECT_EQ(1, snapshot.values[slave_ + "/messages"]);
+  EXPECT_EQ(1u, snapshot.values.count(slave_ + "/time_ms"));
+
+  Shutdown();
+}
+
+
 // Ensures that an empty response arrives if information about
 // registered slaves is requested from a master where no slaves
 // have been registered.
@@ -2024,6 +2154,238 @@ TEST_F(MasterTest, CancelRecoveredSlaveRemoval)
 }
 
 
+// This test ensures that the slaves that fail their health checks
+// together are removed in bulk: with a single registry operation and
+// a single allocator call, with the LOST updates batched for the
+// frameworks that support it. The slave removal rate limit is still
+// honored for every slave.
+TEST_F(MasterTest, BulkRemoveUnhealthySlaves)
+{
+  shared_ptr<MockRateLimiter> slaveRemovalLimiter(new MockRateLimiter());
+  master::Flags masterFlags = CreateMasterFlags();
+  Try<PID<Master>> master = StartMaster(slaveRemovalLimiter, masterFlags);
+  ASSERT_SOME(master);
+
+  // Drop all the PONGs to simulate a partition of the slaves.
+  DROP_MESSAGES(Eq(PongSlaveMessage().GetTypeName()), _, _);
+
+  // Keep the tasks from reaching the slaves, the tasks only need to
+  // be known to the master.
+  DROP_PROTOBUFS(RunTaskMessage(), _, _);
+
+  const size_t SLAVES = 3;
+
+  for (size_t i = 0; i < SLAVES; i++) {
+    Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+      FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
+
+    Try<PID<Slave>> slave = StartSlave();
+    ASSERT_SOME(slave);
+
+    AWAIT_READY(slaveRegisteredMessage);
+  }
+
+  // The first framework gets its LOST updates in batches.
+  FrameworkInfo frameworkInfo1 = DEFAULT_FRAMEWORK_INFO;
+  frameworkInfo1.add_capabilities()->set_type(
+      FrameworkInfo::Capability::RECONCILE_RESULT);
+
+  MockScheduler sched1;
+  MesosSchedulerDriver driver1(
+    &sched1, frameworkInfo1, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched1, registered(&driver1, _, _));
+
+  Future<vector<Offer>> offers1;
+  EXPECT_CALL(sched1, resourceOffers(&driver1, _))
+    .WillOnce(FutureArg<1>(&offers1))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  MockScheduler sched2;
+  MesosSchedulerDriver driver2(
+    &sched2, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<FrameworkID> frameworkId2;
+  EXPECT_CALL(sched2, registered(&driver2, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId2));
+
+  Future<vector<Offer>> offers2;
+  EXPECT_CALL(sched2, resourceOffers(&driver2, _))
+    .WillOnce(FutureArg<1>(&offers2))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  EXPECT_CALL(sched1, offerRescinded(&driver1, _))
+    .WillRepeatedly(Return());
+  EXPECT_CALL(sched2, offerRescinded(&driver2, _))
+    .WillRepeatedly(Return());
+
+  EXPECT_CALL(sched1, slaveLost(&driver1, _))
+    .Times(SLAVES);
+  EXPECT_CALL(sched2, slaveLost(&driver2, _))
+    .Times(SLAVES);
+
+  EXPECT_CALL(sched1, statusUpdate(&driver1, _))
+    .Times(SLAVES);
+  EXPECT_CALL(sched2, statusUpdate(&driver2, _))
+    .Times(SLAVES);
+
+  // Each framework launches a task on every slave. The frameworks
+  // refuse the remaining resources for longer than the test runs.
+  Filters filters;
+  filters.set_refuse_seconds(1000);
+
+  const Resources TASK_RESOURCES = Resources::parse("cpus:1;mem:128").get();
+
+  driver1.start();
+
+  AWAIT_READY(offers1);
+  ASSERT_EQ(SLAVES, offers1.get().size());
+
+  foreach (const Offer& offer, offers1.get()) {
+    TaskInfo task =
+      createTask(offer.slave_id(), TASK_RESOURCES, "sleep 1000");
+
+    driver1.launchTasks(offer.id(), {task}, filters);
+  }
+
+  Clock::pause();
+  Clock::settle();
+
+  driver2.start();
+
+  AWAIT_READY(frameworkId2);
+
+  AWAIT_READY(offers2);
+  ASSERT_EQ(SLAVES, offers2.get().size());
+
+  foreach (const Offer& offer, offers2.get()) {
+    TaskInfo task =
+      createTask(offer.slave_id(), TASK_RESOURCES, "sleep 1000");
+
+    driver2.launchTasks(offer.id(), {task}, filters);
+  }
+
+  Clock::settle();
+
+  // The first slave to fail its health checks gets its own permit,
+  // the others share the second one.
+  Promise<Nothing> promise1;
+  Promise<Nothing> promise2;
+  Future<Nothing> acquire;
+  EXPECT_CALL(*slaveRemovalLimiter, acquire())
+    .WillOnce(Return(promise1.future()))
+    .WillOnce(Return(promise2.future()))
+    .WillOnce(DoAll(FutureSatisfy(&acquire),
+                    Return(promise2.future())));
+
+  // Tick through the ping slots of the slave observer until all the
+  // slaves have failed their health checks.
+  const size_t ticks =
+    (masterFlags.max_slave_ping_timeouts + 2) * master::SLAVE_PING_SLOTS;
+
+  for (size_t i = 0; i < ticks && acquire.isPending(); i++) {
+    Clock::advance(
+        masterFlags.slave_ping_timeout / master::SLAVE_PING_SLOTS);
+    Clock::settle();
+  }
+
+  AWAIT_READY(acquire);
+
+  // No slave is removed before its permit is satisfied.
+  JSON::Object stats = Metrics();
+  EXPECT_EQ(0u, stats.values["master/slave_removals"]);
+
+  const double stores =
+    stats.values["registrar/state_store_ms/count"]
+      .as<JSON::Number>().as<double>();
+
+  // Once the first permit is satisfied, only the first slave is
+  // removed.
+  Future<Nothing> shutdownSlaves1 =
+    FUTURE_DISPATCH(_, &Master::shutdownSlaves);
+  Future<Nothing> bulkRemoveSlaves1 =
+    FUTURE_DISPATCH(_, &MesosAllocatorProcess::bulkRemoveSlaves);
+  Future<ReconcileResultMessage> reconcileResult1 =
+    FUTURE_PROTOBUF(ReconcileResultMessage(), _, _);
+  Future<StatusUpdateMessage> statusUpdate1 =
+    FUTURE_PROTOBUF(StatusUpdateMessage(), _, _);
+
+  promise1.set(Nothing());
+
+  AWAIT_READY(shutdownSlaves1);
+  AWAIT_READY(bulkRemoveSlaves1);
+
+  AWAIT_READY(reconcileResult1);
+  EXPECT_EQ(1, reconcileResult1.get().updates_size());
+
+  AWAIT_READY(statusUpdate1);
+  EXPECT_EQ(frameworkId2.get(), statusUpdate1.get().update().framework_id());
+  EXPECT_EQ(TASK_LOST, statusUpdate1.get().update().status().state());
+
+  Clock::settle();
+
+  stats = Metrics();
+  EXPECT_EQ(1u, stats.values["master/slave_removals"]);
+  EXPECT_EQ(stores + 1, stats.values["registrar/state_store_ms/count"]);
+
+  // Once the second permit is satisfied, the other slaves are removed
+  // together. Each of the futures below is only satisfied by a second
+  // call, which must not happen.
+  Future<Nothing> shutdownSlaves2 =
+    FUTURE_DISPATCH(_, &Master::shutdownSlaves);
+  Future<Nothing> shutdownSlaves3 =
+    FUTURE_DISPATCH(_, &Master::shutdownSlaves);
+  Future<Nothing> bulkRemoveSlaves2 =
+    FUTURE_DISPATCH(_, &MesosAllocatorProcess::bulkRemoveSlaves);
+  Future<Nothing> bulkRemoveSlaves3 =
+    FUTURE_DISPATCH(_, &MesosAllocatorProcess::bulkRemoveSlaves);
+  Future<ReconcileResultMessage> reconcileResult2 =
+    FUTURE_PROTOBUF(ReconcileResultMessage(), _, _);
+  Future<ReconcileResultMessage> reconcileResult3 =
+    FUTURE_PROTOBUF(ReconcileResultMessage(), _, _);
+
+  // The second framework still gets an update per task.
+  Future<StatusUpdateMessage> statusUpdate2 =
+    FUTURE_PROTOBUF(StatusUpdateMessage(), _, _);
+  Future<StatusUpdateMessage> statusUpdate3 =
+    FUTURE_PROTOBUF(StatusUpdateMessage(), _, _);
+
+  promise2.set(Nothing());
+
+  AWAIT_READY(statusUpdate2);
+  AWAIT_READY(statusUpdate3);
+  EXPECT_EQ(frameworkId2.get(), statusUpdate2.get().update().framework_id());
+  EXPECT_EQ(frameworkId2.get(), statusUpdate3.get().update().framework_id());
+
+  Clock::settle();
+
+  // Since newer expectations match first, the last future of each
+  // pair is the one satisfied by the first call.
+  EXPECT_TRUE(shutdownSlaves2.isPending());
+  EXPECT_TRUE(shutdownSlaves3.isReady());
+  EXPECT_TRUE(bulkRemoveSlaves2.isPending());
+  EXPECT_TRUE(bulkRemoveSlaves3.isReady());
+  EXPECT_TRUE(reconcileResult2.isPending());
+
+  ASSERT_TRUE(reconcileResult3.isReady());
+  EXPECT_EQ(2, reconcileResult3.get().updates_size());
+
+  stats = Metrics();
+  EXPECT_EQ(SLAVES, stats.values["master/slave_removals"]);
+  EXPECT_EQ(stores + 2, stats.values["registrar/state_store_ms/count"]);
+
+  driver1.stop();
+  driver1.join();
+
+  driver2.stop();
+  driver2.join();
+
+  Shutdown();
+
+  Clock::resume();
+}
+
+
 // This test ensures that when a slave is recovered from the registry
 // and re-registers with the master, it is *not* removed after the
 // re-registration timeout elapses.
@@ -2548,60 +2910,104 @@ TEST_F(MasterTest, OfferTimeout)
 }
 
 
-// Offer should not be rescinded if it's accepted.
-TEST_F(MasterTest, OfferNotRescindedOnceUsed)
+// Expects the 'master/outstanding_offers' gauge and the offers of
+// the frameworks in the state endpoint to both count 'expected'.
+static void expectOutstandingOffers(const PID<Master>& master, size_t expected)
+{
+  JSON::Object stats = Metrics();
+  EXPECT_EQ(expected, stats.values["master/outstanding_offers"]);
+
+  Future<process::http::Response> response =
+    process::http::get(master, "state");
+  AWAIT_READY(response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  JSON::Array frameworks =
+    parse.get().values["frameworks"].as<JSON::Array>();
+
+  size_t offers = 0;
+  foreach (const JSON::Value& framework, frameworks.values) {
+    offers += framework.as<JSON::Object>()
+      .values.at("offers").as<JSON::Array>().values.size();
+  }
+
+  EXPECT_EQ(expected, offers);
+}
+
+
+// Checks that the outstanding offers gauge follows the offers that
+// are made, declined and rescinded by the offer timeout.
+TEST_F(MasterTest, OutstandingOffersMetric)
 {
   master::Flags masterFlags = MesosTest::CreateMasterFlags();
   masterFlags.offer_timeout = Seconds(30);
   Try<PID<Master>> master = StartMaster(masterFlags);
   ASSERT_SOME(master);
 
-  MockExecutor exec(DEFAULT_EXECUTOR_ID);
-
-  TestContainerizer containerizer(&exec);
-
-  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  Try<PID<Slave>> slave = StartSlave();
   ASSERT_SOME(slave);
 
   MockScheduler sched;
   MesosSchedulerDriver driver(
     &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
 
-  Future<Nothing> registered;
-  EXPECT_CALL(sched, registered(&driver, _, _))
-    .WillOnce(FutureSatisfy(&registered));
+  EXPECT_CALL(sched, registered(&driver, _, _));
 
-  EXPECT_CALL(sched, resourceOffers(_, _))
-    .WillOnce(LaunchTasks(DEFAULT_EXECUTOR_INFO, 1, 1, 64, "*"))
+  Future<vector<Offer>> offers1;
+  Future<vector<Offer>> offers2;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers1))
+    .WillOnce(FutureArg<1>(&offers2))
     .WillRepeatedly(Return()); // Ignore subsequent offers.
 
-  EXPECT_CALL(exec, registered(_, _, _, _));
-
-  EXPECT_CALL(exec, launchTask(_, _))
-    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
-
-  Future<TaskStatus> status;
-  EXPECT_CALL(sched, statusUpdate(&driver, _))
-    .WillOnce(FutureArg<1>(&status))
-    .WillRepeatedly(Return()); // Ignore subsequent updates.
-
-  // We don't expect any rescinds if the offer has been accepted.
+  Future<Nothing> offerRescinded;
   EXPECT_CALL(sched, offerRescinded(&driver, _))
-    .Times(0);
+    .WillOnce(FutureSatisfy(&offerRescinded));
 
   driver.start();
-  AWAIT_READY(registered);
 
-  AWAIT_READY(status);
-  EXPECT_EQ(TASK_RUNNING, status.get().state());
+  AWAIT_READY(offers1);
+  ASSERT_EQ(1u, offers1.get().size());
 
-  // Now advance to the offer timeout, we need to settle the clock to
-  // ensure that the offer rescind timeout would be processed
-  // if triggered.
   Clock::pause();
+  Clock::settle();
+
+  expectOutstandingOffers(master.get(), 1);
+
+  JSON::Object stats = Metrics();
+  EXPECT_EQ(1u, stats.values["master/slaves_active"]);
+  EXPECT_EQ(1u, stats.values["master/frameworks_active"]);
+
+  // The offer timeout rescinds the offer. The resources are not
+  // offered again before the next allocation run.
   Clock::advance(masterFlags.offer_timeout.get());
+
+  AWAIT_READY(offerRescinded);
+  Clock::settle();
+
+  expectOutstandingOffers(master.get(), 0);
+
+  Clock::advance(masterFlags.allocation_interval);
+
+  AWAIT_READY(offers2);
+  ASSERT_EQ(1u, offers2.get().size());
+  Clock::settle();
+
+  expectOutstandingOffers(master.get(), 1);
+
+  // Decline the offer for longer than the test runs.
+  Filters filters;
+  filters.set_refuse_seconds(1000);
+  driver.declineOffer(offers2.get()[0].id(), filters);
+
   Clock::settle();
 
+  expectOutstandingOffers(master.get(), 0);
+
+  Clock::resume();
+
   driver.stop();
   driver.join();
 
@@ -2609,8 +3015,351 @@ TEST_F(MasterTest, OfferNotRescindedOnceUsed)
 }
 
 
-// Offer should not be rescinded if it has been declined.
-TEST_F(MasterTest, OfferNotRescindedOnceDeclined)
+// Checks that the outstanding offers gauge drops the offers that the
+// optimistic allocator made to the other frameworks, which get
+// rescinded once one framework accepts the resources.
+TEST_F(MasterTest, OutstandingOffersMetricOptimistic)
+{
+  Try<mesos::master::allocator::Allocator*> allocator =
+    HierarchicalDRFOptimisticAllocator::create();
+  ASSERT_SOME(allocator);
+
+  master::Flags masterFlags = MesosTest::CreateMasterFlags();
+  masterFlags.allocator = master::OPTIMISTIC_ALLOCATOR;
+  Try<PID<Master>> master = StartMaster(allocator.get(), masterFlags);
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+
+  MockScheduler sched1;
+  MesosSchedulerDriver driver1(
+    &sched1, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<Nothing> registered1;
+  EXPECT_CALL(sched1, registered(&driver1, _, _))
+    .WillOnce(FutureSatisfy(&registered1));
+
+  Future<vector<Offer>> offers1;
+  EXPECT_CALL(sched1, resourceOffers(&driver1, _))
+    .WillOnce(FutureArg<1>(&offers1))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  MockScheduler sched2;
+  MesosSchedulerDriver driver2(
+    &sched2, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<Nothing> registered2;
+  EXPECT_CALL(sched2, registered(&driver2, _, _))
+    .WillOnce(FutureSatisfy(&registered2));
+
+  Future<vector<Offer>> offers2;
+  EXPECT_CALL(sched2, resourceOffers(&driver2, _))
+    .WillOnce(FutureArg<1>(&offers2))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  Future<Nothing> offerRescinded;
+  EXPECT_CALL(sched2, offerRescinded(&driver2, _))
+    .WillOnce(FutureSatisfy(&offerRescinded));
+
+  driver1.start();
+  driver2.start();
+
+  AWAIT_READY(registered1);
+  AWAIT_READY(registered2);
+
+  // The slave registers after the frameworks, so that both of them
+  // are offered its resources in the same allocation run.
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(offers1);
+  ASSERT_EQ(1u, offers1.get().size());
+
+  AWAIT_READY(offers2);
+  ASSERT_EQ(1u, offers2.get().size());
+
+  Clock::pause();
+  Clock::settle();
+
+  expectOutstandingOffers(master.get(), 2);
+
+  // Launching a task with the offer of the first framework rescinds
+  // the offer of the second framework, which holds a copy of the same
+  // resources.
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched1, statusUpdate(&driver1, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  TaskInfo task = createTask(offers1.get()[0], "", DEFAULT_EXECUTOR_ID);
+
+  Filters filters;
+  filters.set_refuse_seconds(1000);
+  driver1.launchTasks(offers1.get()[0].id(), {task}, filters);
+
+  AWAIT_READY(offerRescinded);
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  Clock::settle();
+
+  expectOutstandingOffers(master.get(), 0);
+
+  Clock::resume();
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver1.stop();
+  driver1.join();
+
+  driver2.stop();
+  driver2.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+
+  delete allocator.get();
+}
+
+
+// Checks how the master resolves the conflicts between the offers of
+// the optimistic allocator: declining an offer rescinds no offers,
+// while launching a task with an offer rescinds the offers of the
+// other frameworks. Their resources are offered again without the
+// resources of the task.
+TEST_F(MasterTest, RescindConflictingOptimisticOffers)
+{
+  Try<mesos::master::allocator::Allocator*> allocator =
+    HierarchicalDRFOptimisticAllocator::create();
+  ASSERT_SOME(allocator);
+
+  master::Flags masterFlags = MesosTest::CreateMasterFlags();
+  masterFlags.allocator = master::OPTIMISTIC_ALLOCATOR;
+  Try<PID<Master>> master = StartMaster(allocator.get(), masterFlags);
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+
+  MockScheduler sched1;
+  MesosSchedulerDriver driver1(
+    &sched1, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<Nothing> registered1;
+  EXPECT_CALL(sched1, registered(&driver1, _, _))
+    .WillOnce(FutureSatisfy(&registered1));
+
+  Future<vector<Offer>> offers1;
+  Future<vector<Offer>> reoffers1;
+  EXPECT_CALL(sched1, resourceOffers(&driver1, _))
+    .WillOnce(FutureArg<1>(&offers1))
+    .WillOnce(FutureArg<1>(&reoffers1))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  Future<Nothing> offerRescinded1;
+  EXPECT_CALL(sched1, offerRescinded(&driver1, _))
+    .WillOnce(FutureSatisfy(&offerRescinded1));
+
+  MockScheduler sched2;
+  MesosSchedulerDriver driver2(
+    &sched2, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<Nothing> registered2;
+  EXPECT_CALL(sched2, registered(&driver2, _, _))
+    .WillOnce(FutureSatisfy(&registered2));
+
+  Future<vector<Offer>> offers2;
+  EXPECT_CALL(sched2, resourceOffers(&driver2, _))
+    .WillOnce(FutureArg<1>(&offers2))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  EXPECT_CALL(sched2, offerRescinded(&driver2, _))
+    .Times(0);
+
+  MockScheduler sched3;
+  MesosSchedulerDriver driver3(
+    &sched3, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<Nothing> registered3;
+  EXPECT_CALL(sched3, registered(&driver3, _, _))
+    .WillOnce(FutureSatisfy(&registered3));
+
+  Future<vector<Offer>> offers3;
+  EXPECT_CALL(sched3, resourceOffers(&driver3, _))
+    .WillOnce(FutureArg<1>(&offers3))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  EXPECT_CALL(sched3, offerRescinded(&driver3, _))
+    .Times(0);
+
+  driver1.start();
+  driver2.start();
+  driver3.start();
+
+  AWAIT_READY(registered1);
+  AWAIT_READY(registered2);
+  AWAIT_READY(registered3);
+
+  // The slave registers after the frameworks, so that all of them are
+  // offered its resources in the same allocation run.
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(offers1);
+  ASSERT_EQ(1u, offers1.get().size());
+
+  AWAIT_READY(offers2);
+  ASSERT_EQ(1u, offers2.get().size());
+
+  AWAIT_READY(offers3);
+  ASSERT_EQ(1u, offers3.get().size());
+
+  const Resources total = offers1.get()[0].resources();
+
+  EXPECT_EQ(total, Resources(offers2.get()[0].resources()));
+  EXPECT_EQ(total, Resources(offers3.get()[0].resources()));
+
+  Clock::pause();
+  Clock::settle();
+
+  expectOutstandingOffers(master.get(), 3);
+
+  // The third framework declines its offer, which leaves the offers
+  // of the other frameworks alone.
+  Filters filters;
+  filters.set_refuse_seconds(1000);
+  driver3.acceptOffers({offers3.get()[0].id()}, {}, filters);
+
+  Clock::settle();
+
+  expectOutstandingOffers(master.get(), 2);
+  EXPECT_TRUE(offerRescinded1.isPending());
+
+  // The second framework launches a task, which rescinds the offer
+  // of the first framework.
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched2, statusUpdate(&driver2, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  const Resources taskResources = Resources::parse("cpus:1;mem:128").get();
+
+  TaskInfo task = createTask(
+      offers2.get()[0].slave_id(),
+      taskResources,
+      "",
+      DEFAULT_EXECUTOR_ID);
+
+  driver2.launchTasks(offers2.get()[0].id(), {task}, filters);
+
+  AWAIT_READY(offerRescinded1);
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  // The first framework is offered the resources that the task does
+  // not use, the second and the third framework filter them.
+  Clock::settle();
+  Clock::advance(masterFlags.allocation_interval);
+
+  AWAIT_READY(reoffers1);
+  ASSERT_EQ(1u, reoffers1.get().size());
+
+  EXPECT_EQ(total - taskResources, Resources(reoffers1.get()[0].resources()));
+
+  Clock::resume();
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver1.stop();
+  driver1.join();
+
+  driver2.stop();
+  driver2.join();
+
+  driver3.stop();
+  driver3.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+
+  delete allocator.get();
+}
+
+
+// Offer should not be rescinded if it's accepted.
+TEST_F(MasterTest, OfferNotRescindedOnceUsed)
+{
+  master::Flags masterFlags = MesosTest::CreateMasterFlags();
+  masterFlags.offer_timeout = Seconds(30);
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  TestContainerizer containerizer(&exec);
+
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+    &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<Nothing> registered;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureSatisfy(&registered));
+
+  EXPECT_CALL(sched, resourceOffers(_, _))
+    .WillOnce(LaunchTasks(DEFAULT_EXECUTOR_INFO, 1, 1, 64, "*"))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status))
+    .WillRepeatedly(Return()); // Ignore subsequent updates.
+
+  // We don't expect any rescinds if the offer has been accepted.
+  EXPECT_CALL(sched, offerRescinded(&driver, _))
+    .Times(0);
+
+  driver.start();
+  AWAIT_READY(registered);
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  // Now advance to the offer timeout, we need to settle the clock to
+  // ensure that the offer rescind timeout would be processed
+  // if triggered.
+  Clock::pause();
+  Clock::advance(masterFlags.offer_timeout.get());
+  Clock::settle();
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+// Offer should not be rescinded if it has been declined.
+TEST_F(MasterTest, OfferNotRescindedOnceDeclined)
 {
   master::Flags masterFlags = MesosTest::CreateMasterFlags();
   masterFlags.offer_timeout = Seconds(30);
@@ -2911,195 +3660,166 @@ TEST_F(MasterTest, StateEndpoint)
 }
 
 
-TEST_F(MasterTest, StateSummaryEndpoint)
+// Tests that the master serves the rendered response of '/state'
+// again, for the same query, when '--state_cache_ttl' is set.
+TEST_F(MasterTest, StateEndpointCache)
 {
   master::Flags flags = CreateMasterFlags();
-
-  flags.hostname = "localhost";
-  flags.cluster = "test-cluster";
+  flags.state_cache_ttl = Hours(1);
 
   Try<PID<Master>> master = StartMaster(flags);
   ASSERT_SOME(master);
 
-  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  Future<process::http::Response> response =
+    process::http::get(master.get(), "state", "a=1&b=2");
 
-  Try<PID<Slave>> slave = StartSlave(&exec);
-  ASSERT_SOME(slave);
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
 
-  MockScheduler sched;
-  MesosSchedulerDriver driver(
-      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+  const string body = response.get().body;
 
-  EXPECT_CALL(sched, registered(&driver, _, _))
-    .Times(1);
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
 
-  Future<vector<Offer> > offers;
-  EXPECT_CALL(sched, resourceOffers(&driver, _))
-    .WillOnce(FutureArg<1>(&offers))
-    .WillRepeatedly(Return()); // Ignore subsequent offers.
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
 
-  driver.start();
+  AWAIT_READY(slaveRegisteredMessage);
 
-  AWAIT_READY(offers);
-  EXPECT_NE(0u, offers.get().size());
+  // The order of the query parameters does not matter.
+  response = process::http::get(master.get(), "state", "b=2&a=1");
 
-  TaskID taskId;
-  taskId.set_value("1");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+  EXPECT_EQ(body, response.get().body);
 
-  TaskInfo task;
-  task.set_name("");
-  task.mutable_task_id()->MergeFrom(taskId);
-  task.mutable_slave_id()->MergeFrom(offers.get()[0].slave_id());
-  task.mutable_resources()->MergeFrom(offers.get()[0].resources());
-  task.mutable_executor()->MergeFrom(DEFAULT_EXECUTOR_INFO);
+  // A different query gets a new response, which has the slave.
+  response = process::http::get(master.get(), "state");
 
-  EXPECT_CALL(exec, registered(_, _, _, _))
-    .Times(1);
-
-  EXPECT_CALL(exec, launchTask(_, _))
-    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
-
-  Future<TaskStatus> status;
-  EXPECT_CALL(sched, statusUpdate(&driver, _))
-    .WillOnce(FutureArg<1>(&status));
-
-  driver.launchTasks(offers.get()[0].id(), {task});
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
 
-  AWAIT_READY(status);
-  EXPECT_EQ(TASK_RUNNING, status.get().state());
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
 
-  EXPECT_CALL(exec, killTask(_, _))
-    .WillOnce(SendStatusUpdateFromTaskID(TASK_KILLED));
+  EXPECT_EQ(1, parse.get().values["activated_slaves"]);
 
-  EXPECT_CALL(sched, statusUpdate(&driver, _))
-    .WillOnce(FutureArg<1>(&status));
+  JSON::Object stats = Metrics();
+  EXPECT_EQ(1u, stats.values["master/state_cache_hits"]);
+  EXPECT_EQ(2u, stats.values["master/state_cache_misses"]);
 
-  driver.killTask(taskId);
+  Shutdown();
+}
 
-  AWAIT_READY(status);
-  EXPECT_EQ(TASK_KILLED, status.get().state());
 
-  EXPECT_CALL(exec, shutdown(_))
-    .Times(AtMost(1));
+// Tests that the master responds to a request of '/state' with
+// '304 Not Modified' if the client has the current state.
+TEST_F(MasterTest, StateEndpointETag)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
 
   Future<process::http::Response> response =
-    process::http::get(master.get(), "state-summary");
+    process::http::get(master.get(), "state");
 
   AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
 
-  EXPECT_SOME_EQ(
-      "application/json",
-      response.get().headers.get("Content-Type"));
+  Option<string> etag = response.get().headers.get("ETag");
+  ASSERT_SOME(etag);
 
-  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
-  ASSERT_SOME(parse);
+  process::http::Headers headers;
+  headers["If-None-Match"] = etag.get();
 
-  JSON::Object state = parse.get();
+  response = process::http::get(master.get(), "state", None(), headers);
 
-  EXPECT_EQ(flags.hostname.get(), state.values["hostname"]);
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(
+      process::http::NotModified().status, response);
+  EXPECT_SOME_EQ(etag.get(), response.get().headers.get("ETag"));
+  EXPECT_TRUE(response.get().body.empty());
 
-  EXPECT_EQ(flags.cluster.get(), state.values["cluster"]);
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
 
-  ASSERT_TRUE(state.values["slaves"].is<JSON::Array>());
-  ASSERT_EQ(1u, state.values["slaves"].as<JSON::Array>().values.size());
-  ASSERT_SOME_EQ(0u, state.find<JSON::Number>("slaves[0].TASK_RUNNING"));
-  ASSERT_SOME_EQ(1u, state.find<JSON::Number>("slaves[0].TASK_KILLED"));
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
 
-  ASSERT_TRUE(state.values["frameworks"].is<JSON::Array>());
-  ASSERT_EQ(1u, state.values["frameworks"].as<JSON::Array>().values.size());
-  ASSERT_SOME_EQ(0u, state.find<JSON::Number>("frameworks[0].TASK_RUNNING"));
-  ASSERT_SOME_EQ(1u, state.find<JSON::Number>("frameworks[0].TASK_KILLED"));
+  AWAIT_READY(slaveRegisteredMessage);
 
-  driver.stop();
-  driver.join();
+  // The state changed, so the client gets the new state.
+  response = process::http::get(master.get(), "state", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+  EXPECT_SOME_NE(etag.get(), response.get().headers.get("ETag"));
 
   Shutdown();
 }
 
 
-// This test ensures that the web UI and capabilities of a framework
-// are included in the master's state endpoint, if provided by the
-// framework.
-TEST_F(MasterTest, FrameworkWebUIUrlandCapabilities)
+// Tests that a subscriber of '/state/stream' gets a snapshot of the
+// state followed by the changes.
+TEST_F(MasterTest, StateStream)
 {
   Try<PID<Master>> master = StartMaster();
   ASSERT_SOME(master);
 
-  FrameworkInfo framework = DEFAULT_FRAMEWORK_INFO;
-  framework.set_webui_url("http://localhost:8080/");
-  auto capabilityType = FrameworkInfo::Capability::REVOCABLE_RESOURCES;
-  framework.add_capabilities()->set_type(capabilityType);
-
-  MockScheduler sched;
-  MesosSchedulerDriver driver(
-      &sched, framework, master.get(), DEFAULT_CREDENTIAL);
-
-  Future<Nothing> registered;
-  EXPECT_CALL(sched, registered(&driver, _, _))
-    .WillOnce(FutureSatisfy(&registered));
-
-  driver.start();
+  Future<process::http::Response> response =
+    process::http::streaming::get(master.get(), "state/stream");
 
-  AWAIT_READY(registered);
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+  ASSERT_EQ(process::http::Response::PIPE, response.get().type);
 
-  Future<process::http::Response> masterState =
-    process::http::get(master.get(), "state");
-  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, masterState);
+  Option<process::http::Pipe::Reader> reader = response.get().reader;
+  ASSERT_SOME(reader);
 
-  Try<JSON::Object> parse = JSON::parse<JSON::Object>(masterState.get().body);
-  ASSERT_SOME(parse);
+  auto deserializer = [](const string& record) {
+    return JSON::parse<JSON::Object>(record);
+  };
 
-  // We need a mutable copy of parse to use [].
-  JSON::Object masterStateObject = parse.get();
+  recordio::Reader<JSON::Object> decoder(
+      ::recordio::Decoder<JSON::Object>(deserializer), reader.get());
 
-  EXPECT_EQ(1u, masterStateObject.values.count("frameworks"));
-  JSON::Array frameworks =
-    masterStateObject.values["frameworks"].as<JSON::Array>();
+  Future<Result<JSON::Object>> event = decoder.read();
+  AWAIT_READY(event);
+  ASSERT_SOME(event.get());
 
-  EXPECT_EQ(1u, frameworks.values.size());
-  JSON::Object framework_ = frameworks.values.front().as<JSON::Object>();
+  EXPECT_EQ("SNAPSHOT", event.get().get().values.at("type"));
+  Result<JSON::Array> slaves =
+    event.get().get().find<JSON::Array>("state.slaves");
 
-  EXPECT_EQ(1u, framework_.values.count("webui_url"));
-  JSON::String webui_url =
-    framework_.values["webui_url"].as<JSON::String>();
+  ASSERT_SOME(slaves);
+  EXPECT_TRUE(slaves.get().values.empty());
 
-  EXPECT_EQ("http://localhost:8080/", webui_url.value);
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
 
-  EXPECT_EQ(1u, framework_.values.count("capabilities"));
-  JSON::Array capabilities =
-    framework_.values["capabilities"].as<JSON::Array>();
-  JSON::String capability = capabilities.values.front().as<JSON::String>();
+  event = decoder.read();
+  AWAIT_READY(event);
+  ASSERT_SOME(event.get());
 
-  EXPECT_EQ(FrameworkInfo::Capability::Type_Name(capabilityType),
-            capability.value);
+  EXPECT_EQ("SLAVE_ADDED", event.get().get().values.at("type"));
+  EXPECT_SOME(event.get().get().find<JSON::String>("slave.hostname"));
 
-  driver.stop();
-  driver.join();
+  reader.get().close();
 
   Shutdown();
 }
 
 
-// This test verifies that label values are exposed over the master's
-// state endpoint.
-TEST_F(MasterTest, TaskLabels)
+// Tests the filters and the field projection of '/tasks'.
+TEST_F(MasterTest, TasksEndpoint)
 {
   Try<PID<Master>> master = StartMaster();
   ASSERT_SOME(master);
 
   MockExecutor exec(DEFAULT_EXECUTOR_ID);
 
-  TestContainerizer containerizer(&exec);
-
-  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  Try<PID<Slave>> slave = StartSlave(&exec);
   ASSERT_SOME(slave);
 
   MockScheduler sched;
   MesosSchedulerDriver driver(
       &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
 
+  Future<FrameworkID> frameworkId;
   EXPECT_CALL(sched, registered(&driver, _, _))
-    .Times(1);
+    .WillOnce(FutureArg<1>(&frameworkId));
 
   Future<vector<Offer>> offers;
   EXPECT_CALL(sched, resourceOffers(&driver, _))
@@ -3108,74 +3828,93 @@ TEST_F(MasterTest, TaskLabels)
 
   driver.start();
 
+  AWAIT_READY(frameworkId);
   AWAIT_READY(offers);
   EXPECT_NE(0u, offers.get().size());
 
-  TaskInfo task;
-  task.set_name("");
-  task.mutable_task_id()->set_value("1");
-  task.mutable_slave_id()->MergeFrom(offers.get()[0].slave_id());
-  task.mutable_resources()->MergeFrom(offers.get()[0].resources());
-  task.mutable_executor()->MergeFrom(DEFAULT_EXECUTOR_INFO);
-
-  // Add three labels to the task (two of which share the same key).
-  Labels* labels = task.mutable_labels();
-
-  labels->add_labels()->CopyFrom(createLabel("foo", "bar"));
-  labels->add_labels()->CopyFrom(createLabel("bar", "baz"));
-  labels->add_labels()->CopyFrom(createLabel("bar", "qux"));
+  const SlaveID slaveId = offers.get()[0].slave_id();
 
-  EXPECT_CALL(exec, registered(_, _, _, _))
-    .Times(1);
+  EXPECT_CALL(exec, registered(_, _, _, _));
 
   EXPECT_CALL(exec, launchTask(_, _))
     .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
 
-  Future<Nothing> update;
-  EXPECT_CALL(containerizer,
-              update(_, Resources(offers.get()[0].resources())))
-    .WillOnce(DoAll(FutureSatisfy(&update),
-                    Return(Nothing())));
-
   Future<TaskStatus> status;
   EXPECT_CALL(sched, statusUpdate(&driver, _))
     .WillOnce(FutureArg<1>(&status));
 
+  TaskInfo task = createTask(offers.get()[0], "", DEFAULT_EXECUTOR_ID);
+
   driver.launchTasks(offers.get()[0].id(), {task});
 
   AWAIT_READY(status);
   EXPECT_EQ(TASK_RUNNING, status.get().state());
 
-  AWAIT_READY(update);
+  // Returns the tasks of the response to '/tasks' with the query.
+  auto tasks = [&master](const string& query) -> Try<JSON::Array> {
+    Future<process::http::Response> response =
+      process::http::get(master.get(), "tasks", query);
 
-  // Verify label key and value in the master's state endpoint.
-  Future<process::http::Response> response =
-    process::http::get(master.get(), "state");
-  AWAIT_READY(response);
+    response.await();
 
-  EXPECT_SOME_EQ(
-      "application/json",
-      response.get().headers.get("Content-Type"));
+    if (!response.isReady() ||
+        response.get().status != process::http::OK().status) {
+      return Error("Unexpected response to '/tasks?" + query + "'");
+    }
 
-  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
-  ASSERT_SOME(parse);
+    Try<JSON::Object> object =
+      JSON::parse<JSON::Object>(response.get().body);
 
-  Result<JSON::Array> find = parse.get().find<JSON::Array>(
-      "frameworks[0].tasks[0].labels");
-  EXPECT_SOME(find);
+    if (object.isError()) {
+      return Error(object.error());
+    }
 
-  JSON::Array labelsObject = find.get();
+    Result<JSON::Array> array = object.get().find<JSON::Array>("tasks");
 
-  // Verify the contents of 'foo:bar', 'bar:baz', and 'bar:qux' pairs.
-  EXPECT_EQ(
-      JSON::Value(JSON::protobuf(createLabel("foo", "bar"))),
-      labelsObject.values[0]);
-  EXPECT_EQ(
-      JSON::Value(JSON::protobuf(createLabel("bar", "baz"))),
-      labelsObject.values[1]);
-  EXPECT_EQ(
-      JSON::Value(JSON::protobuf(createLabel("bar", "qux"))),
-      labelsObject.values[2]);
+    if (!array.isSome()) {
+      return Error("Missing 'tasks'");
+    }
+
+    return array.get();
+  };
+
+  Try<JSON::Array> array = tasks("fields=id,state");
+  ASSERT_SOME(array);
+  ASSERT_EQ(1u, array.get().values.size());
+
+  JSON::Object object = array.get().values[0].as<JSON::Object>();
+  EXPECT_EQ(2u, object.values.size());
+  EXPECT_EQ(task.task_id().value(), object.values["id"]);
+  EXPECT_EQ("TASK_RUNNING", object.values["state"]);
+
+  array = tasks("framework_id=" + frameworkId.get().value());
+  ASSERT_SOME(array);
+  EXPECT_EQ(1u, array.get().values.size());
+
+  array = tasks("framework_id=unknown");
+  ASSERT_SOME(array);
+  EXPECT_TRUE(array.get().values.empty());
+
+  array = tasks("slave_id=" + slaveId.value());
+  ASSERT_SOME(array);
+  EXPECT_EQ(1u, array.get().values.size());
+
+  array = tasks("slave_id=unknown");
+  ASSERT_SOME(array);
+  EXPECT_TRUE(array.get().values.empty());
+
+  array = tasks("role=" + DEFAULT_FRAMEWORK_INFO.role());
+  ASSERT_SOME(array);
+  EXPECT_EQ(1u, array.get().values.size());
+
+  array = tasks("role=unknown");
+  ASSERT_SOME(array);
+  EXPECT_TRUE(array.get().values.empty());
+
+  // An offset past the end of the tasks returns none of them.
+  array = tasks("offset=10");
+  ASSERT_SOME(array);
+  EXPECT_TRUE(array.get().values.empty());
 
   EXPECT_CALL(exec, shutdown(_))
     .Times(AtMost(1));
@@ -3183,13 +3922,13 @@ TEST_F(MasterTest, TaskLabels)
   driver.stop();
   driver.join();
 
-  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+  Shutdown();
 }
 
 
-// This test verifies that TaskStatus label values are exposed over
-// the master's state endpoint.
-TEST_F(MasterTest, TaskStatusLabels)
+// Tests that the master handles the status updates that a slave
+// sends in one 'StatusUpdatesMessage' like separately sent ones.
+TEST_F(MasterTest, StatusUpdatesMessage)
 {
   Try<PID<Master>> master = StartMaster();
   ASSERT_SOME(master);
@@ -3203,8 +3942,7 @@ TEST_F(MasterTest, TaskStatusLabels)
   MesosSchedulerDriver driver(
       &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
 
-  EXPECT_CALL(sched, registered(&driver, _, _))
-    .Times(1);
+  EXPECT_CALL(sched, registered(&driver, _, _));
 
   Future<vector<Offer>> offers;
   EXPECT_CALL(sched, resourceOffers(&driver, _))
@@ -3216,15 +3954,16 @@ TEST_F(MasterTest, TaskStatusLabels)
   AWAIT_READY(offers);
   EXPECT_NE(0u, offers.get().size());
 
-  TaskInfo task = createTask(offers.get()[0], "sleep 100", DEFAULT_EXECUTOR_ID);
+  TaskInfo task = createTask(offers.get()[0], "", DEFAULT_EXECUTOR_ID);
 
-  ExecutorDriver* execDriver;
-  EXPECT_CALL(exec, registered(_, _, _, _))
-    .WillOnce(SaveArg<0>(&execDriver));
+  EXPECT_CALL(exec, registered(_, _, _, _));
 
-  Future<TaskInfo> execTask;
   EXPECT_CALL(exec, launchTask(_, _))
-    .WillOnce(FutureArg<1>(&execTask));
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  // Drop the update, the slave would retry it.
+  Future<StatusUpdateMessage> statusUpdateMessage =
+    DROP_PROTOBUF(StatusUpdateMessage(), slave.get(), master.get());
 
   Future<TaskStatus> status;
   EXPECT_CALL(sched, statusUpdate(&driver, _))
@@ -3232,52 +3971,17 @@ TEST_F(MasterTest, TaskStatusLabels)
 
   driver.launchTasks(offers.get()[0].id(), {task});
 
-  AWAIT_READY(execTask);
-
-  // Now send TASK_RUNNING update.
-  TaskStatus runningStatus;
-  runningStatus.mutable_task_id()->MergeFrom(execTask.get().task_id());
-  runningStatus.set_state(TASK_RUNNING);
-
-  // Add three labels to the task (two of which share the same key).
-  Labels* labels = runningStatus.mutable_labels();
+  AWAIT_READY(statusUpdateMessage);
 
-  labels->add_labels()->CopyFrom(createLabel("foo", "bar"));
-  labels->add_labels()->CopyFrom(createLabel("bar", "baz"));
-  labels->add_labels()->CopyFrom(createLabel("bar", "qux"));
+  StatusUpdatesMessage message;
+  message.add_updates()->CopyFrom(statusUpdateMessage.get().update());
+  message.set_pid(statusUpdateMessage.get().pid());
 
-  execDriver->sendStatusUpdate(runningStatus);
+  process::post(slave.get(), master.get(), message);
 
   AWAIT_READY(status);
-
-  // Verify label key and value in master state.json.
-  Future<process::http::Response> response =
-    process::http::get(master.get(), "state.json");
-  AWAIT_READY(response);
-
-  EXPECT_SOME_EQ(
-      "application/json",
-      response.get().headers.get("Content-Type"));
-
-  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
-  ASSERT_SOME(parse);
-
-  Result<JSON::Array> find = parse.get().find<JSON::Array>(
-      "frameworks[0].tasks[0].statuses[0].labels");
-  EXPECT_SOME(find);
-
-  JSON::Array labelsObject = find.get();
-
-  // Verify the content of 'foo:bar' pair.
-  EXPECT_EQ(
-      JSON::Value(JSON::protobuf(createLabel("foo", "bar"))),
-      labelsObject.values[0]);
-  EXPECT_EQ(
-      JSON::Value(JSON::protobuf(createLabel("bar", "baz"))),
-      labelsObject.values[1]);
-  EXPECT_EQ(
-      JSON::Value(JSON::protobuf(createLabel("bar", "qux"))),
-      labelsObject.values[2]);
+  EXPECT_EQ(task.task_id(), status.get().task_id());
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
 
   EXPECT_CALL(exec, shutdown(_))
     .Times(AtMost(1));
@@ -3285,13 +3989,14 @@ TEST_F(MasterTest, TaskStatusLabels)
   driver.stop();
   driver.join();
 
-  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+  Shutdown();
 }
 
 
-// This test verifies that TaskStatus::container_status is exposed over the
-// master state endpoint.
-TEST_F(MasterTest, TaskStatusContainerStatus)
+// Tests that the slave handles the acknowledgements that the master
+// sends in one 'StatusUpdateAcknowledgementsMessage' like separately
+// sent ones.
+TEST_F(MasterTest, StatusUpdateAcknowledgementsMessage)
 {
   Try<PID<Master>> master = StartMaster();
   ASSERT_SOME(master);
@@ -3305,8 +4010,7 @@ TEST_F(MasterTest, TaskStatusContainerStatus)
   MesosSchedulerDriver driver(
       &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
 
-  EXPECT_CALL(sched, registered(&driver, _, _))
-    .Times(1);
+  EXPECT_CALL(sched, registered(&driver, _, _));
 
   Future<vector<Offer>> offers;
   EXPECT_CALL(sched, resourceOffers(&driver, _))
@@ -3318,7 +4022,451 @@ TEST_F(MasterTest, TaskStatusContainerStatus)
   AWAIT_READY(offers);
   EXPECT_NE(0u, offers.get().size());
 
-  TaskInfo task = createTask(offers.get()[0], "sleep 100", DEFAULT_EXECUTOR_ID);
+  TaskInfo task = createTask(offers.get()[0], "", DEFAULT_EXECUTOR_ID);
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  EXPECT_CALL(sched, statusUpdate(&driver, _));
+
+  // Drop the acknowledgement, the master would not resend it.
+  Future<StatusUpdateAcknowledgementMessage> acknowledgementMessage =
+    DROP_PROTOBUF(StatusUpdateAcknowledgementMessage(), master.get(), _);
+
+  driver.launchTasks(offers.get()[0].id(), {task});
+
+  AWAIT_READY(acknowledgementMessage);
+
+  Future<Nothing> _statusUpdateAcknowledgement =
+    FUTURE_DISPATCH(slave.get(), &Slave::_statusUpdateAcknowledgement);
+
+  StatusUpdateAcknowledgementsMessage message;
+  message.add_acknowledgements()->CopyFrom(acknowledgementMessage.get());
+
+  process::post(master.get(), slave.get(), message);
+
+  AWAIT_READY(_statusUpdateAcknowledgement);
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+TEST_F(MasterTest, StateSummaryEndpoint)
+{
+  master::Flags flags = CreateMasterFlags();
+
+  flags.hostname = "localhost";
+  flags.cluster = "test-cluster";
+
+  Try<PID<Master>> master = StartMaster(flags);
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  Try<PID<Slave>> slave = StartSlave(&exec);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .Times(1);
+
+  Future<vector<Offer> > offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  TaskID taskId;
+  taskId.set_value("1");
+
+  TaskInfo task;
+  task.set_name("");
+  task.mutable_task_id()->MergeFrom(taskId);
+  task.mutable_slave_id()->MergeFrom(offers.get()[0].slave_id());
+  task.mutable_resources()->MergeFrom(offers.get()[0].resources());
+  task.mutable_executor()->MergeFrom(DEFAULT_EXECUTOR_INFO);
+
+  EXPECT_CALL(exec, registered(_, _, _, _))
+    .Times(1);
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.launchTasks(offers.get()[0].id(), {task});
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  EXPECT_CALL(exec, killTask(_, _))
+    .WillOnce(SendStatusUpdateFromTaskID(TASK_KILLED));
+
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.killTask(taskId);
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_KILLED, status.get().state());
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  Future<process::http::Response> response =
+    process::http::get(master.get(), "state-summary");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+
+  EXPECT_SOME_EQ(
+      "application/json",
+      response.get().headers.get("Content-Type"));
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  JSON::Object state = parse.get();
+
+  EXPECT_EQ(flags.hostname.get(), state.values["hostname"]);
+
+  EXPECT_EQ(flags.cluster.get(), state.values["cluster"]);
+
+  ASSERT_TRUE(state.values["slaves"].is<JSON::Array>());
+  ASSERT_EQ(1u, state.values["slaves"].as<JSON::Array>().values.size());
+  ASSERT_SOME_EQ(0u, state.find<JSON::Number>("slaves[0].TASK_RUNNING"));
+  ASSERT_SOME_EQ(1u, state.find<JSON::Number>("slaves[0].TASK_KILLED"));
+
+  ASSERT_TRUE(state.values["frameworks"].is<JSON::Array>());
+  ASSERT_EQ(1u, state.values["frameworks"].as<JSON::Array>().values.size());
+  ASSERT_SOME_EQ(0u, state.find<JSON::Number>("frameworks[0].TASK_RUNNING"));
+  ASSERT_SOME_EQ(1u, state.find<JSON::Number>("frameworks[0].TASK_KILLED"));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+// This test ensures that the web UI and capabilities of a framework
+// are included in the master's state endpoint, if provided by the
+// framework.
+TEST_F(MasterTest, FrameworkWebUIUrlandCapabilities)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  FrameworkInfo framework = DEFAULT_FRAMEWORK_INFO;
+  framework.set_webui_url("http://localhost:8080/");
+  auto capabilityType = FrameworkInfo::Capability::REVOCABLE_RESOURCES;
+  framework.add_capabilities()->set_type(capabilityType);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, framework, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<Nothing> registered;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureSatisfy(&registered));
+
+  driver.start();
+
+  AWAIT_READY(registered);
+
+  Future<process::http::Response> masterState =
+    process::http::get(master.get(), "state");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, masterState);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(masterState.get().body);
+  ASSERT_SOME(parse);
+
+  // We need a mutable copy of parse to use [].
+  JSON::Object masterStateObject = parse.get();
+
+  EXPECT_EQ(1u, masterStateObject.values.count("frameworks"));
+  JSON::Array frameworks =
+    masterStateObject.values["frameworks"].as<JSON::Array>();
+
+  EXPECT_EQ(1u, frameworks.values.size());
+  JSON::Object framework_ = frameworks.values.front().as<JSON::Object>();
+
+  EXPECT_EQ(1u, framework_.values.count("webui_url"));
+  JSON::String webui_url =
+    framework_.values["webui_url"].as<JSON::String>();
+
+  EXPECT_EQ("http://localhost:8080/", webui_url.value);
+
+  EXPECT_EQ(1u, framework_.values.count("capabilities"));
+  JSON::Array capabilities =
+    framework_.values["capabilities"].as<JSON::Array>();
+  JSON::String capability = capabilities.values.front().as<JSON::String>();
+
+  EXPECT_EQ(FrameworkInfo::Capability::Type_Name(capabilityType),
+            capability.value);
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+// This test verifies that label values are exposed over the master's
+// state endpoint.
+TEST_F(MasterTest, TaskLabels)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  TestContainerizer containerizer(&exec);
+
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .Times(1);
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  TaskInfo task;
+  task.set_name("");
+  task.mutable_task_id()->set_value("1");
+  task.mutable_slave_id()->MergeFrom(offers.get()[0].slave_id());
+  task.mutable_resources()->MergeFrom(offers.get()[0].resources());
+  task.mutable_executor()->MergeFrom(DEFAULT_EXECUTOR_INFO);
+
+  // Add three labels to the task (two of which share the same key).
+  Labels* labels = task.mutable_labels();
+
+  labels->add_labels()->CopyFrom(createLabel("foo", "bar"));
+  labels->add_labels()->CopyFrom(createLabel("bar", "baz"));
+  labels->add_labels()->CopyFrom(createLabel("bar", "qux"));
+
+  EXPECT_CALL(exec, registered(_, _, _, _))
+    .Times(1);
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<Nothing> update;
+  EXPECT_CALL(containerizer,
+              update(_, Resources(offers.get()[0].resources())))
+    .WillOnce(DoAll(FutureSatisfy(&update),
+                    Return(Nothing())));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.launchTasks(offers.get()[0].id(), {task});
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  AWAIT_READY(update);
+
+  // Verify label key and value in the master's state endpoint.
+  Future<process::http::Response> response =
+    process::http::get(master.get(), "state");
+  AWAIT_READY(response);
+
+  EXPECT_SOME_EQ(
+      "application/json",
+      response.get().headers.get("Content-Type"));
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  Result<JSON::Array> find = parse.get().find<JSON::Array>(
+      "frameworks[0].tasks[0].labels");
+  EXPECT_SOME(find);
+
+  JSON::Array labelsObject = find.get();
+
+  // Verify the contents of 'foo:bar', 'bar:baz', and 'bar:qux' pairs.
+  EXPECT_EQ(
+      JSON::Value(JSON::protobuf(createLabel("foo", "bar"))),
+      labelsObject.values[0]);
+  EXPECT_EQ(
+      JSON::Value(JSON::protobuf(createLabel("bar", "baz"))),
+      labelsObject.values[1]);
+  EXPECT_EQ(
+      JSON::Value(JSON::protobuf(createLabel("bar", "qux"))),
+      labelsObject.values[2]);
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
+
+// This test verifies that TaskStatus label values are exposed over
+// the master's state endpoint.
+TEST_F(MasterTest, TaskStatusLabels)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  Try<PID<Slave>> slave = StartSlave(&exec);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .Times(1);
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  TaskInfo task = createTask(offers.get()[0], "sleep 100", DEFAULT_EXECUTOR_ID);
+
+  ExecutorDriver* execDriver;
+  EXPECT_CALL(exec, registered(_, _, _, _))
+    .WillOnce(SaveArg<0>(&execDriver));
+
+  Future<TaskInfo> execTask;
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(FutureArg<1>(&execTask));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.launchTasks(offers.get()[0].id(), {task});
+
+  AWAIT_READY(execTask);
+
+  // Now send TASK_RUNNING update.
+  TaskStatus runningStatus;
+  runningStatus.mutable_task_id()->MergeFrom(execTask.get().task_id());
+  runningStatus.set_state(TASK_RUNNING);
+
+  // Add three labels to the task (two of which share the same key).
+  Labels* labels = runningStatus.mutable_labels();
+
+  labels->add_labels()->CopyFrom(createLabel("foo", "bar"));
+  labels->add_labels()->CopyFrom(createLabel("bar", "baz"));
+  labels->add_labels()->CopyFrom(createLabel("bar", "qux"));
+
+  execDriver->sendStatusUpdate(runningStatus);
+
+  AWAIT_READY(status);
+
+  // Verify label key and value in master state.json.
+  Future<process::http::Response> response =
+    process::http::get(master.get(), "state.json");
+  AWAIT_READY(response);
+
+  EXPECT_SOME_EQ(
+      "application/json",
+      response.get().headers.get("Content-Type"));
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  Result<JSON::Array> find = parse.get().find<JSON::Array>(
+      "frameworks[0].tasks[0].statuses[0].labels");
+  EXPECT_SOME(find);
+
+  JSON::Array labelsObject = find.get();
+
+  // Verify the content of 'foo:bar' pair.
+  EXPECT_EQ(
+      JSON::Value(JSON::protobuf(createLabel("foo", "bar"))),
+      labelsObject.values[0]);
+  EXPECT_EQ(
+      JSON::Value(JSON::protobuf(createLabel("bar", "baz"))),
+      labelsObject.values[1]);
+  EXPECT_EQ(
+      JSON::Value(JSON::protobuf(createLabel("bar", "qux"))),
+      labelsObject.values[2]);
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
+
+// This test verifies that TaskStatus::container_status is exposed over the
+// master state endpoint.
+TEST_F(MasterTest, TaskStatusContainerStatus)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  Try<PID<Slave>> slave = StartSlave(&exec);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .Times(1);
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  TaskInfo task = createTask(offers.get()[0], "sleep 100", DEFAULT_EXECUTOR_ID);
 
   ExecutorDriver* execDriver;
   EXPECT_CALL(exec, registered(_, _, _, _))
@@ -3782,29 +4930,133 @@ TEST_F(MasterTest, DuplicatedSlaveIdWhenSlaveReregister)
 
   AWAIT_READY(slaveRegisteredMessage1);
 
-  Stop(master.get());
-  master = StartMaster();
+  Stop(master.get());
+  master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage2 =
+      FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  // Start a new slave and make sure it registers before the old slave.
+  slave::Flags slaveFlags2 = CreateSlaveFlags();
+  Try<PID<Slave>> slave2 = StartSlave(slaveFlags2);
+  ASSERT_SOME(slave2);
+
+  AWAIT_READY(slaveRegisteredMessage2);
+
+  Future<SlaveReregisteredMessage> slaveReregisteredMessage1 =
+      FUTURE_PROTOBUF(SlaveReregisteredMessage(), master.get(), _);
+
+  // Now let the first slave re-register.
+  slaveDetector1.appoint(master.get());
+
+  // If both the slaves get the same SlaveID, the re-registration would
+  // fail here.
+  AWAIT_READY(slaveReregisteredMessage1);
+
+  Shutdown();
+}
+
+
+// Tests that the master ignores the re-registration of a slave while
+// '--max_reregistering_slaves' slaves are being readmitted, and that
+// the slave gets readmitted once it retries.
+TEST_F(MasterTest, MaxReregisteringSlaves)
+{
+  master::Flags masterFlags = CreateMasterFlags();
+  masterFlags.max_reregistering_slaves = 1;
+
+  Try<PID<Master>> master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  StandaloneMasterDetector detector1(master.get());
+  StandaloneMasterDetector detector2(master.get());
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage1 =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  Try<PID<Slave>> slave1 = StartSlave(&detector1);
+  ASSERT_SOME(slave1);
+
+  AWAIT_READY(slaveRegisteredMessage1);
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage2 =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  Try<PID<Slave>> slave2 = StartSlave(&detector2);
+  ASSERT_SOME(slave2);
+
+  AWAIT_READY(slaveRegisteredMessage2);
+
+  Stop(master.get());
+
+  master = StartMaster(masterFlags);
+  ASSERT_SOME(master);
+
+  // Intercept the re-registrations so that the master gets both of
+  // them before the registrar readmits the first slave.
+  Future<ReregisterSlaveMessage> reregisterSlaveMessage1 =
+    DROP_PROTOBUF(ReregisterSlaveMessage(), slave1.get(), master.get());
+
+  Future<ReregisterSlaveMessage> reregisterSlaveMessage2 =
+    DROP_PROTOBUF(ReregisterSlaveMessage(), slave2.get(), master.get());
+
+  detector1.appoint(master.get());
+  detector2.appoint(master.get());
+
+  AWAIT_READY(reregisterSlaveMessage1);
+  AWAIT_READY(reregisterSlaveMessage2);
+
+  Future<SlaveReregisteredMessage> slaveReregisteredMessage1 =
+    FUTURE_PROTOBUF(SlaveReregisteredMessage(), master.get(), slave1.get());
+
+  Future<SlaveReregisteredMessage> slaveReregisteredMessage2 =
+    FUTURE_PROTOBUF(SlaveReregisteredMessage(), master.get(), slave2.get());
+
+  process::post(slave1.get(), master.get(), reregisterSlaveMessage1.get());
+  process::post(slave2.get(), master.get(), reregisterSlaveMessage2.get());
+
+  AWAIT_READY(slaveReregisteredMessage1);
+
+  JSON::Object stats = Metrics();
+  EXPECT_EQ(1u, stats.values["master/recovery_slave_reregistrations_deferred"]);
+
+  // The second slave retries.
+  AWAIT_READY(slaveReregisteredMessage2);
+
+  Shutdown();
+}
+
+
+// Tests that the master exports the latency of the health check
+// pings of each slave.
+TEST_F(MasterTest, SlavePingLatency)
+{
+  Try<PID<Master>> master = StartMaster();
   ASSERT_SOME(master);
 
-  Future<SlaveRegisteredMessage> slaveRegisteredMessage2 =
-      FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
 
-  // Start a new slave and make sure it registers before the old slave.
-  slave::Flags slaveFlags2 = CreateSlaveFlags();
-  Try<PID<Slave>> slave2 = StartSlave(slaveFlags2);
-  ASSERT_SOME(slave2);
+  Future<PongSlaveMessage> pong = FUTURE_PROTOBUF(PongSlaveMessage(), _, _);
 
-  AWAIT_READY(slaveRegisteredMessage2);
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
 
-  Future<SlaveReregisteredMessage> slaveReregisteredMessage1 =
-      FUTURE_PROTOBUF(SlaveReregisteredMessage(), master.get(), _);
+  AWAIT_READY(slaveRegisteredMessage);
+  AWAIT_READY(pong);
 
-  // Now let the first slave re-register.
-  slaveDetector1.appoint(master.get());
+  const string key = "master/slaves/" +
+    stringify(slaveRegisteredMessage.get().slave_id()) + "/ping_latency_ms";
 
-  // If both the slaves get the same SlaveID, the re-registration would
-  // fail here.
-  AWAIT_READY(slaveReregisteredMessage1);
+  // Wait for the observer to process the pong.
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  JSON::Object stats = Metrics();
+  EXPECT_EQ(1u, stats.values.count(key));
+  EXPECT_EQ(1u, stats.values.count(key + "/count"));
 
   Shutdown();
 }
@@ -3948,6 +5200,342 @@ TEST_F(MasterTest, FrameworksEndpointOneFramework)
   Shutdown();
 }
 
+
+// Tests that the master asks the slaves to pull images, and reports
+// the progress of the pulls.
+TEST_F(MasterTest, PullImages)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  TestContainerizer containerizer;
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), _, _);
+
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+  const SlaveID slaveId = slaveRegisteredMessage.get().slave_id();
+
+  Image image;
+  image.set_type(Image::DOCKER);
+  image.mutable_docker()->set_name("busybox");
+
+  Promise<bool> promise;
+  EXPECT_CALL(containerizer, pull(_))
+    .WillOnce(Return(promise.future()));
+
+  Future<ImagePullsMessage> pulling =
+    FUTURE_PROTOBUF(ImagePullsMessage(), slave.get(), master.get());
+
+  JSON::Array images;
+  images.values.push_back(JSON::protobuf(image));
+
+  Future<process::http::Response> response = process::http::post(
+      master.get(),
+      "images",
+      None(),
+      "images=" + stringify(images));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+
+  Try<JSON::Value> expected = JSON::parse(
+      "{\"slaveIds\": [\"" + slaveId.value() + "\"]}");
+
+  ASSERT_SOME(expected);
+  EXPECT_SOME_EQ(expected.get(), JSON::parse(response.get().body));
+
+  AWAIT_READY(pulling);
+  ASSERT_EQ(1, pulling.get().pulls_size());
+  EXPECT_EQ(ImagePull::PULLING, pulling.get().pulls(0).state());
+
+  Future<ImagePullsMessage> ready =
+    FUTURE_PROTOBUF(ImagePullsMessage(), slave.get(), master.get());
+
+  promise.set(true);
+
+  AWAIT_READY(ready);
+  ASSERT_EQ(1, ready.get().pulls_size());
+  EXPECT_EQ(ImagePull::READY, ready.get().pulls(0).state());
+
+  response = process::http::get(master.get(), "images");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  Result<JSON::String> state = parse.get().find<JSON::String>(
+      "slaves[0].pulls[0].state");
+
+  EXPECT_SOME_EQ(JSON::String("READY"), state);
+
+  Shutdown();
+}
+
+
+// This test verifies that the '/memory' endpoints of the master and
+// the slave account for a running task.
+TEST_F(MasterTest, Memory)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(LaunchTasks(DEFAULT_EXECUTOR_INFO, 1, 1, 512, "*"))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.start();
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  Future<process::http::Response> response =
+    process::http::get(master.get(), "memory");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  JSON::Object memory = parse.get();
+
+  EXPECT_SOME_EQ(1u, memory.find<JSON::Number>("frameworks.count"));
+  EXPECT_SOME_EQ(1u, memory.find<JSON::Number>("slaves.count"));
+  EXPECT_SOME_EQ(1u, memory.find<JSON::Number>("tasks.count"));
+  EXPECT_SOME_EQ(1u, memory.find<JSON::Number>("executors.count"));
+  EXPECT_SOME_EQ(0u, memory.find<JSON::Number>("completed_tasks.count"));
+
+  Result<JSON::Number> bytes = memory.find<JSON::Number>("tasks.bytes");
+  ASSERT_SOME(bytes);
+  EXPECT_LT(0u, bytes.get().as<uint64_t>());
+
+  response = process::http::get(slave.get(), "memory");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+
+  parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  memory = parse.get();
+
+  EXPECT_SOME_EQ(1u, memory.find<JSON::Number>("frameworks.count"));
+  EXPECT_SOME_EQ(1u, memory.find<JSON::Number>("executors.count"));
+  EXPECT_SOME_EQ(1u, memory.find<JSON::Number>("tasks.count"));
+  EXPECT_SOME_EQ(0u, memory.find<JSON::Number>("queued_tasks.count"));
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
+// This test verifies that the master traces an accepted offer and
+// records the latencies of the offer lifecycle of the framework.
+TEST_F(MasterTest, OfferTraces)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(LaunchTasks(DEFAULT_EXECUTOR_INFO, 1, 1, 512, "*"))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.start();
+
+  AWAIT_READY(frameworkId);
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  Future<process::http::Response> response =
+    process::http::get(master.get(), "offer-traces");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  Result<JSON::Array> completed = parse.get().find<JSON::Array>("completed");
+  ASSERT_SOME(completed);
+  ASSERT_EQ(1u, completed.get().values.size());
+
+  JSON::Object trace = completed.get().values[0].as<JSON::Object>();
+
+  EXPECT_SOME_EQ(
+      JSON::String(frameworkId.get().value()),
+      trace.find<JSON::String>("framework_id"));
+  EXPECT_SOME_EQ(
+      JSON::String("ACCEPTED"),
+      trace.find<JSON::String>("outcome"));
+  EXPECT_SOME(trace.find<JSON::Number>("hold_time_secs"));
+
+  const string prefix = "/frameworks/" + stringify(frameworkId.get());
+
+  JSON::Object stats = Metrics();
+  EXPECT_EQ(1u, stats.values.count("master" + prefix + "/offer_hold_time_ms"));
+  EXPECT_EQ(
+      1u, stats.values.count("master" + prefix + "/accept_to_running_ms"));
+  EXPECT_EQ(
+      1u, stats.values.count("allocator" + prefix + "/time_to_offer_ms"));
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
+// This test verifies that the operator endpoints of the master and
+// the slave return their state as protobuf to the requests that
+// accept it.
+TEST_F(MasterTest, OperatorStateProtobuf)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(LaunchTasks(DEFAULT_EXECUTOR_INFO, 1, 1, 512, "*"))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.start();
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  process::http::Headers headers;
+  headers["Accept"] = APPLICATION_PROTOBUF;
+
+  Future<process::http::Response> response =
+    process::http::get(master.get(), "state", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(
+      APPLICATION_PROTOBUF, "Content-Type", response);
+
+  MasterOperatorState state;
+  ASSERT_TRUE(state.ParseFromString(response.get().body));
+
+  ASSERT_EQ(1, state.slaves_size());
+  ASSERT_EQ(1, state.frameworks_size());
+  ASSERT_EQ(1, state.frameworks(0).tasks_size());
+  EXPECT_EQ(status.get().task_id(), state.frameworks(0).tasks(0).task_id());
+  EXPECT_EQ(TASK_RUNNING, state.frameworks(0).tasks(0).state());
+  EXPECT_EQ(1, state.frameworks(0).executors_size());
+
+  response = process::http::get(master.get(), "tasks", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+
+  state.Clear();
+  ASSERT_TRUE(state.ParseFromString(response.get().body));
+
+  ASSERT_EQ(1, state.tasks_size());
+  EXPECT_EQ(status.get().task_id(), state.tasks(0).task_id());
+
+  // Requests that do not ask for protobuf still get JSON.
+  response = process::http::get(master.get(), "tasks");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(
+      APPLICATION_JSON, "Content-Type", response);
+
+  response = process::http::get(slave.get(), "state", None(), headers);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(
+      APPLICATION_PROTOBUF, "Content-Type", response);
+
+  SlaveOperatorState slaveState;
+  ASSERT_TRUE(slaveState.ParseFromString(response.get().body));
+
+  ASSERT_EQ(1, slaveState.frameworks_size());
+  ASSERT_EQ(1, slaveState.frameworks(0).executors_size());
+  ASSERT_EQ(1, slaveState.frameworks(0).executors(0).tasks_size());
+  EXPECT_EQ(
+      status.get().task_id(),
+      slaveState.frameworks(0).executors(0).tasks(0).task_id());
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
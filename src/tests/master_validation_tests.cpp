@@ -1119,6 +1119,41 @@ TEST_F(TaskValidationTest, TaskUsesRevocableResources)
 }
 
 
+// This test verifies the validation of a task that does not depend on
+// the state of the master.
+TEST_F(TaskValidationTest, StatelessValidation)
+{
+  TaskInfo task;
+  task.set_name("");
+  task.mutable_task_id()->set_value("task");
+  task.mutable_slave_id()->set_value("slave");
+  task.mutable_command()->set_value("sleep 1000");
+  task.add_resources()->CopyFrom(Resources::parse("cpus", "1", "*").get());
+
+  EXPECT_NONE(task::validate(task));
+
+  // A task ID with invalid characters.
+  TaskInfo task_ = task;
+  task_.mutable_task_id()->set_value("task/1");
+  EXPECT_SOME(task::validate(task_));
+
+  // A task with both a command and an executor.
+  task_ = task;
+  task_.mutable_executor()->CopyFrom(DEFAULT_EXECUTOR_INFO);
+  EXPECT_SOME(task::validate(task_));
+
+  // A task with neither a command nor an executor.
+  task_ = task;
+  task_.clear_command();
+  EXPECT_SOME(task::validate(task_));
+
+  // A task with invalid resources.
+  task_ = task;
+  task_.mutable_resources(0)->mutable_scalar()->set_value(-1);
+  EXPECT_SOME(task::validate(task_));
+}
+
+
 // This test verifies that a task and its executor are not allowed to
 // mix revocable and non-revocable resources.
 TEST_F(TaskValidationTest, TaskAndExecutorUseRevocableResources)
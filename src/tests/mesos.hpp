@@ -508,6 +508,30 @@ inline Resource::DiskInfo createDiskInfo(
 }
 
 
+// Helpers for creating the sources of disk resources.
+inline Resource::DiskInfo::Source createDiskSourcePath(const std::string& root)
+{
+  Resource::DiskInfo::Source source;
+
+  source.set_type(Resource::DiskInfo::Source::PATH);
+  source.mutable_path()->set_root(root);
+
+  return source;
+}
+
+
+inline Resource::DiskInfo::Source createDiskSourceMount(
+    const std::string& root)
+{
+  Resource::DiskInfo::Source source;
+
+  source.set_type(Resource::DiskInfo::Source::MOUNT);
+  source.mutable_mount()->set_root(root);
+
+  return source;
+}
+
+
 // Note that `reservationPrincipal` should be specified if and only if
 // the volume uses dynamically reserved resources.
 inline Resource createPersistentVolume(
@@ -958,8 +982,8 @@ public:
           const std::string&,
           const Option<mesos::Resources>&,
           const Option<std::map<std::string, std::string>>&,
-          const Option<std::string>&,
-          const Option<std::string>&));
+          const process::Subprocess::IO&,
+          const process::Subprocess::IO&));
 
   MOCK_CONST_METHOD3(
       pull,
@@ -989,8 +1013,8 @@ public:
       const std::string& mappedDirectory,
       const Option<mesos::Resources>& resources,
       const Option<std::map<std::string, std::string>>& env,
-      const Option<std::string>& stdoutPath,
-      const Option<std::string>& stderrPath) const
+      const process::Subprocess::IO& _stdout,
+      const process::Subprocess::IO& _stderr) const
   {
     return Docker::run(
         containerInfo,
@@ -1000,8 +1024,8 @@ public:
         mappedDirectory,
         resources,
         env,
-        stdoutPath,
-        stderrPath);
+        _stdout,
+        _stderr);
   }
 
   process::Future<Docker::Image> _pull(
@@ -14,7 +14,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <atomic>
 #include <limits>
+#include <memory>
 #include <vector>
 
 #include <gmock/gmock.h>
@@ -182,6 +184,104 @@ TEST(MonitorTest, MissingStatistics)
 }
 
 
+// This test verifies that a sampling monitor serves the latest
+// sample, reports the rates of the usage between samples, and keeps
+// the history of the samples.
+TEST(MonitorTest, Sampling)
+{
+  ExecutorInfo executorInfo;
+  executorInfo.mutable_executor_id()->set_value("executor");
+  executorInfo.mutable_framework_id()->set_value("framework");
+  executorInfo.set_name("name");
+  executorInfo.set_source("source");
+
+  ContainerID containerId;
+  containerId.set_value("container");
+
+  std::shared_ptr<std::atomic<int>> samples(new std::atomic<int>(0));
+
+  Clock::pause();
+
+  ResourceMonitor monitor([=]() -> Future<ResourceUsage> {
+    int sample = ++*samples;
+
+    ResourceStatistics statistics;
+    statistics.set_timestamp(sample);
+    statistics.set_cpus_user_time_secs(1.5 * sample);
+    statistics.set_cpus_system_time_secs(0.5 * sample);
+    statistics.set_net_rx_bytes(1024 * sample);
+
+    ResourceUsage usage;
+    ResourceUsage::Executor* executor = usage.add_executors();
+    executor->mutable_executor_info()->CopyFrom(executorInfo);
+    executor->mutable_container_id()->CopyFrom(containerId);
+    executor->mutable_statistics()->CopyFrom(statistics);
+
+    return usage;
+  },
+  Seconds(1));
+
+  // The first read takes the first sample, which the next reads get
+  // until the interval has passed.
+  Future<ResourceUsage> usage = monitor.usage();
+  AWAIT_READY(usage);
+  ASSERT_EQ(1, usage.get().executors_size());
+  EXPECT_EQ(1, usage.get().executors(0).statistics().timestamp());
+
+  usage = monitor.usage();
+  AWAIT_READY(usage);
+  EXPECT_EQ(1, usage.get().executors(0).statistics().timestamp());
+  EXPECT_EQ(1, samples->load());
+
+  Clock::advance(Seconds(1));
+  Clock::settle();
+
+  EXPECT_EQ(2, samples->load());
+
+  usage = monitor.usage();
+  AWAIT_READY(usage);
+  EXPECT_EQ(2, usage.get().executors(0).statistics().timestamp());
+
+  UPID upid("monitor", process::address());
+
+  Future<http::Response> response = http::get(upid, "statistics");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  Try<JSON::Array> result = JSON::parse<JSON::Array>(response.get().body);
+  ASSERT_SOME(result);
+  ASSERT_EQ(1u, result.get().values.size());
+
+  JSON::Object rates;
+  rates.values["cpus_usage"] = 2.0;
+  rates.values["net_rx_bytes_per_second"] = 1024.0;
+
+  Result<JSON::Object> actual =
+    result.get().values[0].as<JSON::Object>().find<JSON::Object>("rates");
+
+  ASSERT_SOME(actual);
+  EXPECT_EQ(rates, actual.get());
+
+  // Both samples are in the history of the container.
+  Future<ResourceUsageHistory> history = monitor.history();
+  AWAIT_READY(history);
+
+  ASSERT_EQ(1, history.get().executors_size());
+  EXPECT_EQ(containerId, history.get().executors(0).container_id());
+  ASSERT_EQ(2, history.get().executors(0).statistics_size());
+  EXPECT_EQ(1, history.get().executors(0).statistics(0).timestamp());
+  EXPECT_EQ(2, history.get().executors(0).statistics(1).timestamp());
+
+  response = http::get(upid, "history");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+  EXPECT_EQ(JSON::protobuf(history.get()), parse.get());
+
+  Clock::resume();
+}
+
+
 class MonitorIntegrationTest : public MesosTest {};
 
 
@@ -22,6 +22,9 @@
 
 #include <mesos/resources.hpp>
 
+#include <mesos/module/qos_controller.hpp>
+#include <mesos/module/resource_estimator.hpp>
+
 #include <mesos/slave/qos_controller.hpp>
 
 #include <process/clock.hpp>
@@ -56,7 +59,9 @@ using mesos::internal::master::Master;
 using mesos::internal::slave::ResourceMonitor;
 using mesos::internal::slave::Slave;
 
+using mesos::slave::QoSController;
 using mesos::slave::QoSCorrection;
+using mesos::slave::ResourceEstimator;
 
 using std::list;
 using std::string;
@@ -76,6 +81,12 @@ namespace tests {
 const char FIXED_RESOURCE_ESTIMATOR_NAME[] =
   "org_apache_mesos_FixedResourceEstimator";
 
+const char USAGE_RESOURCE_ESTIMATOR_NAME[] =
+  "org_apache_mesos_UsageResourceEstimator";
+
+const char INTERFERENCE_QOS_CONTROLLER_NAME[] =
+  "org_apache_mesos_InterferenceQoSController";
+
 
 class OversubscriptionTest : public MesosTest
 {
@@ -125,6 +136,48 @@ protected:
     ASSERT_SOME(modules::ModuleManager::load(modules));
   }
 
+  void loadUsageResourceEstimatorModule(
+      const string& safetyMargin,
+      const string& smoothing)
+  {
+    Modules::Library* library = modules.add_libraries();
+    library->set_name("usage_resource_estimator");
+
+    Modules::Library::Module* module = library->add_modules();
+    module->set_name(USAGE_RESOURCE_ESTIMATOR_NAME);
+
+    Parameter* parameter = module->add_parameters();
+    parameter->set_key("safety_margin");
+    parameter->set_value(safetyMargin);
+
+    parameter = module->add_parameters();
+    parameter->set_key("smoothing");
+    parameter->set_value(smoothing);
+
+    ASSERT_SOME(modules::ModuleManager::load(modules));
+  }
+
+  void loadInterferenceQoSControllerModule(
+      const string& throttledRatio,
+      const string& consecutiveSamples)
+  {
+    Modules::Library* library = modules.add_libraries();
+    library->set_name("interference_qos_controller");
+
+    Modules::Library::Module* module = library->add_modules();
+    module->set_name(INTERFERENCE_QOS_CONTROLLER_NAME);
+
+    Parameter* parameter = module->add_parameters();
+    parameter->set_key("throttled_ratio");
+    parameter->set_value(throttledRatio);
+
+    parameter = module->add_parameters();
+    parameter->set_key("consecutive_samples");
+    parameter->set_value(consecutiveSamples);
+
+    ASSERT_SOME(modules::ModuleManager::load(modules));
+  }
+
   // TODO(vinod): Make this a global helper that other tests (e.g.,
   // hierarchical allocator tests) can use.
   Resources createRevocableResources(
@@ -601,6 +654,173 @@ TEST_F(OversubscriptionTest, FixedResourceEstimator)
 }
 
 
+// This test verifies that the usage resource estimator estimates the
+// unused part of the allocations of the executors, less the safety
+// margin and the revocable resources that are already allocated.
+TEST_F(OversubscriptionTest, UsageResourceEstimator)
+{
+  loadUsageResourceEstimatorModule("0.25", "1");
+
+  Try<ResourceEstimator*> create =
+    modules::ModuleManager::create<ResourceEstimator>(
+        USAGE_RESOURCE_ESTIMATOR_NAME);
+
+  ASSERT_SOME(create);
+
+  Owned<ResourceEstimator> estimator(create.get());
+
+  ResourceUsage usage;
+
+  ResourceUsage::Executor* executor = usage.add_executors();
+  executor->mutable_executor_info()->CopyFrom(DEFAULT_EXECUTOR_INFO);
+  executor->mutable_container_id()->set_value("container");
+  executor->mutable_allocated()->CopyFrom(
+      Resources::parse("cpus:4;mem:1024").get());
+
+  ResourceStatistics* statistics = executor->mutable_statistics();
+  statistics->set_timestamp(0);
+  statistics->set_cpus_user_time_secs(0);
+  statistics->set_cpus_system_time_secs(0);
+  statistics->set_mem_rss_bytes(Megabytes(256).bytes());
+
+  ASSERT_SOME(estimator->initialize([&usage]() -> Future<ResourceUsage> {
+    return usage;
+  }));
+
+  // The cpu usage is not known from a single sample.
+  Future<Resources> estimate = estimator->oversubscribable();
+  AWAIT_READY(estimate);
+  EXPECT_EQ(createRevocableResources("mem", "512"), estimate.get());
+
+  // The executor used 1 of its 4 cpus in the last 10 seconds, and 3
+  // of its cpus are beyond the safety margin.
+  statistics->set_timestamp(10);
+  statistics->set_cpus_user_time_secs(8);
+  statistics->set_cpus_system_time_secs(2);
+
+  estimate = estimator->oversubscribable();
+  AWAIT_READY(estimate);
+  EXPECT_EQ(createRevocableResources("cpus", "2") +
+            createRevocableResources("mem", "512"),
+            estimate.get());
+
+  // The revocable resources allocated to another executor are not
+  // oversubscribable anymore.
+  executor = usage.add_executors();
+  executor->mutable_executor_info()->CopyFrom(DEFAULT_EXECUTOR_INFO);
+  executor->mutable_container_id()->set_value("revocable");
+  executor->mutable_allocated()->CopyFrom(
+      createRevocableResources("cpus", "1"));
+
+  estimate = estimator->oversubscribable();
+  AWAIT_READY(estimate);
+  EXPECT_EQ(createRevocableResources("cpus", "1") +
+            createRevocableResources("mem", "512"),
+            estimate.get());
+}
+
+
+// This test verifies that the interference QoS controller kills the
+// revocable executor that uses the most cpus once a non-revocable
+// executor is throttled in enough successive samples.
+TEST_F(OversubscriptionTest, InterferenceQoSController)
+{
+  loadInterferenceQoSControllerModule("0.5", "2");
+
+  Try<QoSController*> create =
+    modules::ModuleManager::create<QoSController>(
+        INTERFERENCE_QOS_CONTROLLER_NAME);
+
+  ASSERT_SOME(create);
+
+  Owned<QoSController> controller(create.get());
+
+  ResourceUsage usage;
+
+  auto addExecutor = [&usage](
+      const string& id,
+      const Resources& allocated) {
+    ResourceUsage::Executor* executor = usage.add_executors();
+    executor->mutable_executor_info()->CopyFrom(DEFAULT_EXECUTOR_INFO);
+    executor->mutable_executor_info()->mutable_executor_id()->set_value(id);
+    executor->mutable_executor_info()->mutable_framework_id()->set_value(
+        "framework");
+    executor->mutable_container_id()->set_value(id);
+    executor->mutable_allocated()->CopyFrom(allocated);
+    executor->mutable_statistics()->set_timestamp(0);
+  };
+
+  // Samples an executor which used 'cpus' in the last 10 seconds, and
+  // was throttled in 'throttled' of its last 100 CFS periods.
+  auto sample = [&usage](int index, double cpus, uint32_t throttled) {
+    ResourceStatistics* statistics =
+      usage.mutable_executors(index)->mutable_statistics();
+
+    statistics->set_timestamp(statistics->timestamp() + 10);
+    statistics->set_cpus_user_time_secs(
+        statistics->cpus_user_time_secs() + 10 * cpus);
+    statistics->set_cpus_nr_periods(statistics->cpus_nr_periods() + 100);
+    statistics->set_cpus_nr_throttled(
+        statistics->cpus_nr_throttled() + throttled);
+  };
+
+  addExecutor("latency", Resources::parse("cpus:2;mem:512").get());
+  addExecutor("batch1", createRevocableResources("cpus", "1"));
+  addExecutor("batch2", createRevocableResources("cpus", "1"));
+
+  ASSERT_SOME(controller->initialize([&usage]() -> Future<ResourceUsage> {
+    return usage;
+  }));
+
+  // The first sample has nothing to compare to.
+  Future<list<QoSCorrection>> corrections = controller->corrections();
+  AWAIT_READY(corrections);
+  EXPECT_TRUE(corrections.get().empty());
+
+  // A throttled ratio below the threshold is no interference.
+  sample(0, 1, 20);
+  sample(1, 0.5, 0);
+  sample(2, 1, 0);
+
+  corrections = controller->corrections();
+  AWAIT_READY(corrections);
+  EXPECT_TRUE(corrections.get().empty());
+
+  // The first sample with interference does not kill yet.
+  sample(0, 1, 80);
+  sample(1, 0.5, 0);
+  sample(2, 1, 0);
+
+  corrections = controller->corrections();
+  AWAIT_READY(corrections);
+  EXPECT_TRUE(corrections.get().empty());
+
+  sample(0, 1, 80);
+  sample(1, 0.5, 0);
+  sample(2, 1, 0);
+
+  corrections = controller->corrections();
+  AWAIT_READY(corrections);
+  ASSERT_EQ(1u, corrections.get().size());
+
+  const QoSCorrection correction = corrections.get().front();
+  EXPECT_EQ(QoSCorrection::KILL, correction.type());
+  EXPECT_EQ("batch2", correction.kill().executor_id().value());
+  EXPECT_EQ("batch2", correction.kill().container_id().value());
+  EXPECT_EQ("framework", correction.kill().framework_id().value());
+
+  // The count of the samples with interference starts again after
+  // a kill.
+  sample(0, 1, 80);
+  sample(1, 0.5, 0);
+  sample(2, 1, 0);
+
+  corrections = controller->corrections();
+  AWAIT_READY(corrections);
+  EXPECT_TRUE(corrections.get().empty());
+}
+
+
 // This test verifies that the QoS Controller is able to fetch
 // ResourceUsage statistics about running executor from
 // the ResourceMonitor.
@@ -35,6 +35,7 @@
 
 #include "common/protobuf_utils.hpp"
 
+#include "master/constants.hpp"
 #include "master/flags.hpp"
 #include "master/master.hpp"
 
@@ -44,6 +45,7 @@
 #include "tests/mesos.hpp"
 
 using mesos::internal::master::Master;
+using mesos::internal::master::RECONCILIATION_BATCH_SIZE;
 
 using mesos::internal::slave::Slave;
 
@@ -275,6 +277,76 @@ TEST_F(ReconciliationTest, UnknownSlave)
 }
 
 
+// This test verifies that the master answers the reconciliation of
+// a framework with the RECONCILE_RESULT capability in batches.
+TEST_F(ReconciliationTest, ReconcileResult)
+{
+  Try<PID<Master> > master = StartMaster();
+  ASSERT_SOME(master);
+
+  FrameworkInfo frameworkInfo = DEFAULT_FRAMEWORK_INFO;
+  frameworkInfo.add_capabilities()->set_type(
+      FrameworkInfo::Capability::RECONCILE_RESULT);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+    &sched, frameworkInfo, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  driver.start();
+
+  // Wait until the framework is registered.
+  AWAIT_READY(frameworkId);
+
+  // Reconcile one task more than fit in a single batch.
+  vector<TaskStatus> statuses;
+  for (size_t i = 0; i < RECONCILIATION_BATCH_SIZE + 1; i++) {
+    TaskStatus status;
+    status.mutable_task_id()->set_value(UUID::random().toString());
+    status.mutable_slave_id()->set_value(UUID::random().toString());
+    status.set_state(TASK_RUNNING);
+
+    statuses.push_back(status);
+  }
+
+  Future<ReconcileResultMessage> result1 =
+    FUTURE_PROTOBUF(ReconcileResultMessage(), _, _);
+
+  Future<ReconcileResultMessage> result2 =
+    FUTURE_PROTOBUF(ReconcileResultMessage(), _, _);
+
+  // Framework should receive TASK_LOST because the slaves are unknown.
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .Times(RECONCILIATION_BATCH_SIZE);
+
+  Future<TaskStatus> update;
+  EXPECT_CALL(sched, statusUpdate(&driver, TaskStatusEq(statuses.back())))
+    .WillOnce(FutureArg<1>(&update));
+
+  // No update is sent one by one.
+  EXPECT_NO_FUTURE_PROTOBUFS(StatusUpdateMessage(), _, _);
+
+  driver.reconcileTasks(statuses);
+
+  AWAIT_READY(result1);
+  ASSERT_EQ(RECONCILIATION_BATCH_SIZE, (size_t) result1.get().updates_size());
+
+  AWAIT_READY(result2);
+  ASSERT_EQ(1, result2.get().updates_size());
+
+  // The last task is answered last.
+  AWAIT_READY(update);
+  EXPECT_EQ(TASK_LOST, update.get().state());
+  EXPECT_FALSE(update.get().has_uuid());
+
+  driver.stop();
+  driver.join();
+}
+
+
 // This test verifies that reconciliation of an unknown task that
 // belongs to a known slave results in TASK_LOST.
 TEST_F(ReconciliationTest, UnknownTask)
@@ -330,6 +330,56 @@ TEST_P(RegistrarTest, Remove)
 }
 
 
+// This test verifies that several slaves are removed from the
+// registry by a single operation, leaving the other slaves in place.
+TEST_P(RegistrarTest, BulkRemove)
+{
+  vector<SlaveInfo> infos;
+  for (int i = 0; i < 4; i++) {
+    SlaveInfo info;
+    info.set_hostname("localhost");
+    info.mutable_id()->set_value(stringify(i));
+    infos.push_back(info);
+  }
+
+  {
+    Registrar registrar(flags, state);
+    AWAIT_READY(registrar.recover(master));
+
+    foreach (const SlaveInfo& info, infos) {
+      AWAIT_EQ(true, registrar.apply(Owned<Operation>(new AdmitSlave(info))));
+    }
+
+    AWAIT_EQ(true, registrar.apply(Owned<Operation>(
+        new RemoveSlaves({infos[0], infos[2]}))));
+
+    if (flags.registry_strict) {
+      AWAIT_EQ(false, registrar.apply(Owned<Operation>(
+          new RemoveSlaves({infos[1], infos[2]}))));
+    } else {
+      AWAIT_EQ(true, registrar.apply(Owned<Operation>(
+          new RemoveSlaves({infos[0], infos[2]}))));
+    }
+
+    // A slave admitted after the bulk removal is kept.
+    AWAIT_EQ(true, registrar.apply(Owned<Operation>(
+        new AdmitSlave(infos[0]))));
+  }
+
+  {
+    Registrar registrar(flags, state);
+
+    Future<Registry> registry = registrar.recover(master);
+    AWAIT_READY(registry);
+
+    ASSERT_EQ(3, registry.get().slaves().slaves().size());
+    EXPECT_EQ(infos[1], registry.get().slaves().slaves(0).info());
+    EXPECT_EQ(infos[3], registry.get().slaves().slaves(1).info());
+    EXPECT_EQ(infos[0], registry.get().slaves().slaves(2).info());
+  }
+}
+
+
 // NOTE: For the following tests, the state of the registrar can
 // only be viewed once per instantiation of the registrar.
 // To check the result of each operation, we must re-construct
@@ -900,11 +950,91 @@ TEST_P(RegistrarTest, Bootstrap)
 }
 
 
+// This test verifies that the registrar recovers the registry from
+// the deltas stored after the whole registry, and that it stores the
+// whole registry and expunges the deltas after the maximum number of
+// deltas.
+TEST_P(RegistrarTest, Deltas)
+{
+  flags.registry_max_deltas = 2;
+
+  SlaveInfo info1 = slave;
+
+  SlaveInfo info2 = slave;
+  info2.mutable_id()->set_value("2");
+
+  SlaveInfo info3 = slave;
+  info3.mutable_id()->set_value("3");
+
+  {
+    Registrar registrar(flags, state);
+    AWAIT_READY(registrar.recover(master));
+
+    // The recovery and the first admission are stored as deltas, the
+    // second admission stores the whole registry.
+    AWAIT_EQ(true, registrar.apply(Owned<Operation>(new AdmitSlave(info1))));
+    AWAIT_EQ(true, registrar.apply(Owned<Operation>(new AdmitSlave(info2))));
+
+    Future<set<string>> names = state->names();
+    AWAIT_READY(names);
+    EXPECT_EQ(0u, names.get().count("registry_delta_1"));
+
+    AWAIT_EQ(true, registrar.apply(Owned<Operation>(new AdmitSlave(info3))));
+    AWAIT_EQ(true, registrar.apply(Owned<Operation>(new RemoveSlave(info1))));
+
+    names = state->names();
+    AWAIT_READY(names);
+    EXPECT_EQ(1u, names.get().count("registry_delta_1"));
+    EXPECT_EQ(1u, names.get().count("registry_delta_2"));
+  }
+
+  // Recover from the whole registry and the deltas after it, which
+  // stores the whole registry again as there are 2 deltas already.
+  {
+    Registrar registrar(flags, state);
+
+    Future<Registry> registry = registrar.recover(master);
+    AWAIT_READY(registry);
+
+    ASSERT_EQ(2, registry.get().slaves().slaves().size());
+    EXPECT_EQ(info2, registry.get().slaves().slaves(0).info());
+    EXPECT_EQ(info3, registry.get().slaves().slaves(1).info());
+
+    Future<set<string>> names = state->names();
+    AWAIT_READY(names);
+    EXPECT_EQ(0u, names.get().count("registry_delta_1"));
+    EXPECT_EQ(0u, names.get().count("registry_delta_2"));
+
+    AWAIT_EQ(true, registrar.apply(Owned<Operation>(new RemoveSlave(info2))));
+  }
+
+  // A registrar that does not store deltas still recovers them.
+  flags.registry_max_deltas = 0;
+
+  {
+    Registrar registrar(flags, state);
+
+    Future<Registry> registry = registrar.recover(master);
+    AWAIT_READY(registry);
+
+    ASSERT_EQ(1, registry.get().slaves().slaves().size());
+    EXPECT_EQ(info3, registry.get().slaves().slaves(0).info());
+
+    Future<set<string>> names = state->names();
+    AWAIT_READY(names);
+    EXPECT_EQ(0u, names.get().count("registry_delta_1"));
+  }
+}
+
+
 class MockStorage : public Storage
 {
 public:
+  typedef vector<std::pair<Entry, UUID> > Entries;
+
   MOCK_METHOD1(get, Future<Option<Entry> >(const string&));
   MOCK_METHOD2(set, Future<bool>(const Entry&, const UUID&));
+  MOCK_METHOD1(set, Future<bool>(const Entries&));
   MOCK_METHOD1(expunge, Future<bool>(const Entry&));
   MOCK_METHOD0(names, Future<std::set<string> >(void));
 };
@@ -951,6 +1081,9 @@ TEST_P(RegistrarTest, StoreTimeout)
   EXPECT_CALL(storage, get(_))
     .WillOnce(Return(None()));
 
+  EXPECT_CALL(storage, names())
+    .WillOnce(Return(std::set<string>()));
+
   Future<Nothing> set;
   EXPECT_CALL(storage, set(_, _))
     .WillOnce(DoAll(FutureSatisfy(&set),
@@ -981,6 +1114,9 @@ TEST_P(RegistrarTest, Abort)
   EXPECT_CALL(storage, get(_))
     .WillOnce(Return(None()));
 
+  EXPECT_CALL(storage, names())
+    .WillOnce(Return(std::set<string>()));
+
   EXPECT_CALL(storage, set(_, _))
     .WillOnce(Return(Future<bool>(true)))              // Recovery.
     .WillOnce(Return(Future<bool>::failed("failure"))) // Failure.
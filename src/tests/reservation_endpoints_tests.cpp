@@ -29,7 +29,10 @@
 
 #include <stout/base64.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/json.hpp>
 #include <stout/option.hpp>
+#include <stout/protobuf.hpp>
+#include <stout/stringify.hpp>
 
 #include "master/flags.hpp"
 #include "master/master.hpp"
@@ -713,6 +716,125 @@ TEST_F(ReservationEndpointsTest, InsufficientResources)
 }
 
 
+// This tests that an operator can reserve resources in bulk, and
+// that the operations on a slave are applied all together or not at
+// all.
+TEST_F(ReservationEndpointsTest, BulkOperations)
+{
+  TestAllocator<> allocator;
+
+  EXPECT_CALL(allocator, initialize(_, _, _, _));
+
+  Try<PID<Master>> master = StartMaster(&allocator);
+  ASSERT_SOME(master);
+
+  Future<SlaveID> slaveId;
+  EXPECT_CALL(allocator, addSlave(_, _, _, _, _))
+    .WillOnce(DoAll(InvokeAddSlave(&allocator),
+                    FutureArg<0>(&slaveId)));
+
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  FrameworkInfo frameworkInfo = createFrameworkInfo();
+
+  Resources dynamicallyReserved =
+    Resources::parse("cpus:1;mem:512").get().flatten(
+        frameworkInfo.role(),
+        createReservationInfo(DEFAULT_CREDENTIAL.principal()));
+
+  Resources insufficient =
+    Resources::parse("cpus:4;mem:4096").get().flatten(
+        frameworkInfo.role(),
+        createReservationInfo(DEFAULT_CREDENTIAL.principal()));
+
+  auto reserve = [&slaveId](const Resources& resources) {
+    Offer::Operation operation;
+    operation.set_type(Offer::Operation::RESERVE);
+    operation.mutable_reserve()->mutable_resources()->CopyFrom(resources);
+
+    JSON::Object object;
+    object.values["slaveId"] = slaveId.get().value();
+    object.values["operation"] = JSON::protobuf(operation);
+    return object;
+  };
+
+  JSON::Array operations;
+  operations.values.push_back(reserve(dynamicallyReserved));
+
+  Future<Response> response = process::http::post(
+      master.get(),
+      "operations",
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL),
+      "operations=" + stringify(operations));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  Try<JSON::Value> expected = JSON::parse(
+      "[{\"slaveId\": \"" + slaveId.get().value() + "\", \"code\": 200}]");
+
+  ASSERT_SOME(expected);
+
+  Try<JSON::Value> parse = JSON::parse(response.get().body);
+  ASSERT_SOME(parse);
+  EXPECT_EQ(expected.get(), parse.get());
+
+  // The first operation would succeed on its own, but the second
+  // one does not, so neither of them is applied.
+  operations.values.push_back(reserve(insufficient));
+
+  response = process::http::post(
+      master.get(),
+      "operations",
+      createBasicAuthHeaders(DEFAULT_CREDENTIAL),
+      "operations=" + stringify(operations));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  Try<JSON::Array> outcomes = JSON::parse<JSON::Array>(response.get().body);
+  ASSERT_SOME(outcomes);
+  ASSERT_EQ(1u, outcomes.get().values.size());
+  ASSERT_TRUE(outcomes.get().values[0].is<JSON::Object>());
+
+  Result<JSON::Number> code =
+    outcomes.get().values[0].as<JSON::Object>().find<JSON::Number>("code");
+
+  ASSERT_SOME(code);
+  EXPECT_EQ(Conflict().code, code.get().as<int64_t>());
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, frameworkInfo, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<vector<Offer>> offers;
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers));
+
+  driver.start();
+
+  AWAIT_READY(offers);
+
+  ASSERT_EQ(1u, offers.get().size());
+  Offer offer = offers.get()[0];
+
+  EXPECT_EQ(dynamicallyReserved,
+            Resources(offer.resources()).reserved(frameworkInfo.role()));
+
+  // Ignore subsequent `recoverResources` calls triggered from recovering the
+  // resources that this framework is currently holding onto.
+  EXPECT_CALL(allocator, recoverResources(_, _, _, _))
+    .WillRepeatedly(DoDefault());
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
 // This tests that an attempt to reserve with no authorization header results in
 // an 'Unauthorized' HTTP error.
 TEST_F(ReservationEndpointsTest, NoHeader)
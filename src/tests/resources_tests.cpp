@@ -1523,8 +1523,7 @@ TEST(ResourcesTest, Types)
 }
 
 
-// NOTE: This is disabled due to MESOS-1187.
-TEST(ResourcesTest, DISABLED_Precision)
+TEST(ResourcesTest, Precision)
 {
   Resources cpu = Resources::parse("cpus:0.1").get();
 
@@ -1532,6 +1531,14 @@ TEST(ResourcesTest, DISABLED_Precision)
   Resources r2 = cpu;
 
   EXPECT_EQ(r1, r2);
+
+  // The scalar arithmetic is exact (see MESOS-1187), so the amounts
+  // are equal and not only close to each other.
+  EXPECT_SOME_EQ(0.1, r1.cpus());
+
+  // Subtracting all of the cpus leaves no (tiny) remainder behind.
+  Resources r3 = cpu + cpu + cpu - cpu - cpu - cpu;
+  EXPECT_TRUE(r3.empty());
 }
 
 
@@ -1770,6 +1777,84 @@ TEST(DiskResourcesTest, Contains)
 }
 
 
+TEST(DiskResourcesTest, Sources)
+{
+  Resource path1 = createDiskResource("10", "role", None(), None());
+  path1.mutable_disk()->mutable_source()->CopyFrom(
+      createDiskSourcePath("/mnt/disk1"));
+
+  Resource path2 = path1;
+  path2.mutable_disk()->mutable_source()->CopyFrom(
+      createDiskSourcePath("/mnt/disk2"));
+
+  Resource mount = createDiskResource("10", "role", None(), None());
+  mount.mutable_disk()->mutable_source()->CopyFrom(
+      createDiskSourceMount("/mnt/disk3"));
+
+  EXPECT_NONE(Resources::validate(path1));
+  EXPECT_NONE(Resources::validate(mount));
+
+  Resource invalid = mount;
+  invalid.mutable_disk()->mutable_source()->clear_mount();
+
+  EXPECT_SOME(Resources::validate(invalid));
+
+  // The disks of different sources are distinct resources.
+  Resources plain = createDiskResource("10", "role", None(), None());
+
+  EXPECT_NE(Resources(path1), Resources(path2));
+  EXPECT_NE(Resources(path1), plain);
+  EXPECT_FALSE((plain + path2).contains(path1));
+
+  // A PATH disk is carved up like the default disk.
+  Resource half = createDiskResource("5", "role", None(), None());
+  half.mutable_disk()->mutable_source()->CopyFrom(
+      createDiskSourcePath("/mnt/disk1"));
+
+  EXPECT_EQ(Resources(half), Resources(path1) - half);
+  EXPECT_EQ(Resources(path1), Resources(half) + half);
+
+  // A MOUNT disk is only used as a whole.
+  Resource part = createDiskResource("5", "role", None(), None());
+  part.mutable_disk()->mutable_source()->CopyFrom(
+      createDiskSourceMount("/mnt/disk3"));
+
+  EXPECT_FALSE(Resources(mount).contains(part));
+  EXPECT_TRUE((Resources(mount) - mount).empty());
+  EXPECT_FALSE((Resources(part) + part).contains(mount));
+}
+
+
+TEST(DiskResourcesTest, CreatePersistentVolumeOnMount)
+{
+  Resource disk = createDiskResource("10", "role", None(), None());
+  disk.mutable_disk()->mutable_source()->CopyFrom(
+      createDiskSourceMount("/mnt/disk"));
+
+  Resource volume = disk;
+  volume.mutable_disk()->CopyFrom(createDiskInfo("id1", "path1"));
+  volume.mutable_disk()->mutable_source()->CopyFrom(
+      createDiskSourceMount("/mnt/disk"));
+
+  Offer::Operation create;
+  create.set_type(Offer::Operation::CREATE);
+  create.mutable_create()->add_volumes()->CopyFrom(volume);
+
+  Try<Resources> result = Resources(disk).apply(create);
+  ASSERT_SOME(result);
+  EXPECT_EQ(Resources(volume), result.get());
+
+  // A volume cannot take a part of the MOUNT disk.
+  Resource part = volume;
+  part.mutable_scalar()->set_value(5);
+
+  create.mutable_create()->clear_volumes();
+  create.mutable_create()->add_volumes()->CopyFrom(part);
+
+  EXPECT_ERROR(Resources(disk).apply(create));
+}
+
+
 TEST(DiskResourcesTest, FilterPersistentVolumes)
 {
   Resources resources = Resources::parse("cpus:1;mem:512;disk:1000").get();
@@ -36,6 +36,7 @@
 
 #include <stout/json.hpp>
 #include <stout/lambda.hpp>
+#include <stout/os.hpp>
 #include <stout/try.hpp>
 #include <stout/uuid.hpp>
 
@@ -187,6 +188,67 @@ TEST_F(MesosSchedulerDriverTest, DropAckIfStopCalledBeforeAbort)
 }
 
 
+// Ensures that when the driver delivers its callbacks in batches,
+// the status updates are delivered through 'Scheduler::statusUpdates'
+// (whose default implementation invokes 'Scheduler::statusUpdate')
+// and are implicitly acknowledged once the callback returns.
+TEST_F(MesosSchedulerDriverTest, BatchCallbacks)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  // The driver loads its flags from the environment when it starts.
+  os::setenv("MESOS_BATCH_CALLBACKS", "true");
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(LaunchTasks(DEFAULT_EXECUTOR_INFO, 1, 1, 16, "*"))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  Future<mesos::scheduler::Call> acknowledgement = FUTURE_CALL(
+      mesos::scheduler::Call(),
+      mesos::scheduler::Call::ACKNOWLEDGE,
+      _,
+      master.get());
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.start();
+
+  os::unsetenv("MESOS_BATCH_CALLBACKS");
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  AWAIT_READY(acknowledgement);
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
 // Ensures that when a scheduler enables explicit acknowledgements
 // on the driver, there are no implicit acknowledgements sent, and
 // the call to 'acknowledgeStatusUpdate' sends the ack to the master.
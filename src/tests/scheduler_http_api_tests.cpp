@@ -782,6 +782,43 @@ TEST_P(SchedulerHttpApiTest, DefaultAccept)
 }
 
 
+// This test verifies that the master prefers protobuf over JSON for
+// the events of a scheduler that explicitly accepts both.
+TEST_P(SchedulerHttpApiTest, PreferProtobufAccept)
+{
+  // HTTP schedulers cannot yet authenticate.
+  master::Flags flags = CreateMasterFlags();
+  flags.authenticate_frameworks = false;
+
+  Try<PID<Master> > master = StartMaster(flags);
+  ASSERT_SOME(master);
+
+  process::http::Headers headers;
+  headers["Accept"] = string(APPLICATION_JSON) + ", " + APPLICATION_PROTOBUF;
+
+  Call call;
+  call.set_type(Call::SUBSCRIBE);
+
+  Call::Subscribe* subscribe = call.mutable_subscribe();
+  subscribe->mutable_framework_info()->CopyFrom(DEFAULT_V1_FRAMEWORK_INFO);
+
+  // Retrieve the parameter passed as content type to this test.
+  const string contentType = GetParam();
+
+  Future<Response> response = process::http::streaming::post(
+      master.get(),
+      "api/v1/scheduler",
+      headers,
+      serialize(call, contentType),
+      contentType);
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  EXPECT_SOME_EQ(
+      APPLICATION_PROTOBUF,
+      response.get().headers.get("Content-Type"));
+}
+
+
 TEST_F(SchedulerHttpApiTest, GetRequest)
 {
   master::Flags flags = CreateMasterFlags();
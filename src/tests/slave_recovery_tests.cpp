@@ -503,6 +503,122 @@ TYPED_TEST(SlaveRecoveryTest, ReconnectExecutor)
 }
 
 
+// The slave re-registers with the master as soon as it has recovered
+// its state, before the executors re-register. An executor which does
+// not re-register is still killed once the re-registration timeout
+// expires, and its task is transitioned to LOST.
+TYPED_TEST(SlaveRecoveryTest, ReregisterSlaveBeforeExecutors)
+{
+  Try<PID<Master> > master = this->StartMaster();
+  ASSERT_SOME(master);
+
+  slave::Flags flags = this->CreateSlaveFlags();
+
+  Fetcher fetcher;
+
+  Try<TypeParam*> containerizer1 = TypeParam::create(flags, true, &fetcher);
+  ASSERT_SOME(containerizer1);
+
+  Try<PID<Slave> > slave = this->StartSlave(containerizer1.get(), flags);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+
+  // Enable checkpointing for the framework.
+  FrameworkInfo frameworkInfo = DEFAULT_FRAMEWORK_INFO;
+  frameworkInfo.set_checkpoint(true);
+
+  MesosSchedulerDriver driver(
+      &sched, frameworkInfo, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(_, _, _));
+
+  Future<vector<Offer> > offers;
+  EXPECT_CALL(sched, resourceOffers(_, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return());      // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  TaskInfo task = createTask(offers.get()[0], "sleep 1000");
+
+  Future<TaskStatus> running;
+  EXPECT_CALL(sched, statusUpdate(_, _))
+    .WillOnce(FutureArg<1>(&running));
+
+  driver.launchTasks(offers.get()[0].id(), {task});
+
+  AWAIT_READY(running);
+  ASSERT_EQ(TASK_RUNNING, running.get().state());
+
+  this->Stop(slave.get());
+  delete containerizer1.get();
+
+  // The executor never re-registers.
+  Future<Message> reregisterExecutorMessage =
+    DROP_MESSAGE(Eq(ReregisterExecutorMessage().GetTypeName()), _, _);
+
+  Future<ReregisterSlaveMessage> reregisterSlaveMessage =
+    FUTURE_PROTOBUF(ReregisterSlaveMessage(), _, _);
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(_, _))
+    .WillOnce(FutureArg<1>(&status))
+    .WillRepeatedly(Return());       // Ignore subsequent updates.
+
+  Future<Nothing> _recover = FUTURE_DISPATCH(_, &Slave::_recover);
+
+  // Restart the slave (use same flags) with a new containerizer.
+  Try<TypeParam*> containerizer2 = TypeParam::create(flags, true, &fetcher);
+  ASSERT_SOME(containerizer2);
+
+  slave = this->StartSlave(containerizer2.get(), flags);
+  ASSERT_SOME(slave);
+
+  Clock::pause();
+
+  AWAIT_READY(_recover);
+  AWAIT_READY(reregisterExecutorMessage);
+
+  // The slave re-registers without waiting for the executor.
+  while (reregisterSlaveMessage.isPending()) {
+    Clock::advance(flags.registration_backoff_factor);
+    Clock::settle();
+  }
+
+  AWAIT_READY(reregisterSlaveMessage);
+  ASSERT_EQ(1, reregisterSlaveMessage.get().tasks_size());
+  EXPECT_EQ(task.task_id(), reregisterSlaveMessage.get().tasks(0).task_id());
+
+  EXPECT_TRUE(status.isPending());
+
+  Clock::advance(EXECUTOR_REREGISTER_TIMEOUT);
+
+  // Now advance time until the reaper reaps the executor.
+  while (status.isPending()) {
+    Clock::advance(process::MAX_REAP_INTERVAL());
+    Clock::settle();
+  }
+
+  // Scheduler should receive the TASK_LOST update.
+  AWAIT_READY(status);
+  ASSERT_EQ(TASK_LOST, status->state());
+  EXPECT_EQ(TaskStatus::REASON_EXECUTOR_REREGISTRATION_TIMEOUT,
+            status->reason());
+
+  Clock::resume();
+
+  driver.stop();
+  driver.join();
+
+  this->Shutdown();
+  delete containerizer2.get();
+}
+
+
 // The slave is stopped before the (command) executor is registered.
 // When it comes back up with recovery=reconnect, make sure the
 // executor is killed and the task is transitioned to LOST.
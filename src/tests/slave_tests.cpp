@@ -1307,6 +1307,140 @@ TEST_F(SlaveTest, StateEndpoint)
       parse.get().find<JSON::String>(
           "frameworks[0].executors[0].tasks[0].executor_id"));
 
+  // Only the matching frameworks and executors are shown.
+  response = http::get(
+      slave.get(),
+      "state",
+      "framework_id=" + offers.get()[0].framework_id().value() +
+      "&executor_id=" + DEFAULT_EXECUTOR_ID.value() +
+      "&completed=false");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  EXPECT_SOME_EQ(
+      JSON::String(taskId.value()),
+      parse.get().find<JSON::String>("frameworks[0].executors[0].tasks[0].id"));
+
+  response = http::get(slave.get(), "state", "framework_id=unknown");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  Result<JSON::Array> frameworks =
+    parse.get().find<JSON::Array>("frameworks");
+
+  ASSERT_SOME(frameworks);
+  EXPECT_TRUE(frameworks.get().values.empty());
+
+  response = http::get(slave.get(), "state", "completed=maybe");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::BadRequest().status, response);
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+// This test verifies that the '/containers' endpoint traces the
+// launch of the container of an executor up to its task running.
+TEST_F(SlaveTest, ContainersEndpoint)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  TestContainerizer containerizer(&exec);
+
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  Future<process::http::Response> response =
+    process::http::get(slave.get(), "containers");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::OK().status, response);
+
+  Try<JSON::Array> parse = JSON::parse<JSON::Array>(response.get().body);
+  ASSERT_SOME(parse);
+  EXPECT_TRUE(parse.get().values.empty());
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  TaskInfo task = createTask(offers.get()[0], "", DEFAULT_EXECUTOR_ID);
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status));
+
+  driver.launchTasks(offers.get()[0].id(), {task});
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  response = http::get(slave.get(), "containers");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  parse = JSON::parse<JSON::Array>(response.get().body);
+  ASSERT_SOME(parse);
+  ASSERT_EQ(1u, parse.get().values.size());
+
+  ASSERT_TRUE(parse.get().values[0].is<JSON::Object>());
+  const JSON::Object container = parse.get().values[0].as<JSON::Object>();
+
+  EXPECT_SOME_EQ(
+      JSON::String(DEFAULT_EXECUTOR_ID.value()),
+      container.find<JSON::String>("executor_id"));
+
+  Result<JSON::Number> launching =
+    container.find<JSON::Number>("trace.launching");
+  Result<JSON::Number> launched =
+    container.find<JSON::Number>("trace.launched");
+  Result<JSON::Number> registered =
+    container.find<JSON::Number>("trace.registered");
+  Result<JSON::Number> running =
+    container.find<JSON::Number>("trace.running");
+
+  ASSERT_SOME(launching);
+  ASSERT_SOME(launched);
+  ASSERT_SOME(registered);
+  ASSERT_SOME(running);
+
+  // NOTE: The executor can register before the slave learns that
+  // the container was launched, so we do not order 'launched'.
+  EXPECT_LE(launching.get().as<double>(), launched.get().as<double>());
+  EXPECT_LE(launching.get().as<double>(), registered.get().as<double>());
+  EXPECT_LE(registered.get().as<double>(), running.get().as<double>());
+
   EXPECT_CALL(exec, shutdown(_))
     .Times(AtMost(1));
 
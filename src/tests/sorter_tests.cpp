@@ -26,11 +26,13 @@
 
 #include <stout/gtest.hpp>
 
+#include "master/allocator/sorter/drf/hierarchical.hpp"
 #include "master/allocator/sorter/drf/sorter.hpp"
 
 #include "tests/mesos.hpp"
 
 using mesos::internal::master::allocator::DRFSorter;
+using mesos::internal::master::allocator::HierarchicalDRFSorter;
 
 using std::list;
 using std::string;
@@ -406,6 +408,120 @@ TEST(SorterTest, MultipleSlavesUpdateTotal)
 }
 
 
+// Tests that the shares of clients are updated incrementally once the
+// sorter has recalculated all of them after the total changed.
+TEST(SorterTest, AllocatedAfterUpdateTotal)
+{
+  DRFSorter sorter;
+
+  SlaveID slaveId;
+  slaveId.set_value("slaveId");
+
+  sorter.add("a");
+  sorter.add("b");
+  sorter.add("c");
+
+  sorter.add(slaveId, Resources::parse("cpus:10;mem:100").get());
+
+  // Dominant shares of "a", "b" and "c" are 0.1, 0.2 and 0.3 (cpus).
+  sorter.allocated("a", slaveId, Resources::parse("cpus:1").get());
+  sorter.allocated("b", slaveId, Resources::parse("cpus:2").get());
+  sorter.allocated("c", slaveId, Resources::parse("cpus:3").get());
+
+  EXPECT_EQ(list<string>({"a", "b", "c"}), sorter.sort());
+
+  // Doubling the total halves the shares but keeps the order.
+  sorter.update(slaveId, Resources::parse("cpus:20;mem:100").get());
+
+  EXPECT_EQ(list<string>({"a", "b", "c"}), sorter.sort());
+
+  // Now the dominant share of "a" is 0.4 (cpus).
+  sorter.allocated("a", slaveId, Resources::parse("cpus:7").get());
+
+  EXPECT_EQ(list<string>({"b", "c", "a"}), sorter.sort());
+
+  // Now the dominant share of "a" is 0.05 (cpus).
+  sorter.unallocated("a", slaveId, Resources::parse("cpus:7").get());
+
+  EXPECT_EQ(list<string>({"a", "b", "c"}), sorter.sort());
+
+  sorter.remove("b");
+  sorter.deactivate("c");
+
+  EXPECT_EQ(list<string>({"a"}), sorter.sort());
+
+  sorter.activate("c");
+
+  EXPECT_EQ(list<string>({"a", "c"}), sorter.sort());
+}
+
+
+// Tests that the scalars allocated to a client are summed up across
+// slaves as allocations change.
+TEST(SorterTest, AllocationScalars)
+{
+  DRFSorter sorter;
+
+  SlaveID slaveA;
+  slaveA.set_value("slaveA");
+
+  SlaveID slaveB;
+  slaveB.set_value("slaveB");
+
+  sorter.add("framework");
+
+  sorter.add(slaveA, Resources::parse("cpus:8;mem:1024;ports:[1-10]").get());
+  sorter.add(slaveB, Resources::parse("cpus:8;mem:1024").get());
+
+  EXPECT_EQ(Resources(), sorter.allocationScalars("framework"));
+
+  const Resources allocationA =
+    Resources::parse("cpus:2;mem:256;ports:[1-5]").get();
+
+  sorter.allocated("framework", slaveA, allocationA);
+  sorter.allocated(
+      "framework", slaveB, Resources::parse("cpus:3;mem:512").get());
+
+  EXPECT_EQ(Resources::parse("cpus:5;mem:768").get(),
+            sorter.allocationScalars("framework"));
+
+  sorter.unallocated("framework", slaveA, allocationA);
+
+  EXPECT_EQ(Resources::parse("cpus:3;mem:512").get(),
+            sorter.allocationScalars("framework"));
+}
+
+
+// Tests that the share of a client is its dominant share of the
+// allocations weighted by its weight, and that it is still known
+// once the client is deactivated.
+TEST(SorterTest, Share)
+{
+  DRFSorter sorter;
+
+  SlaveID slaveId;
+  slaveId.set_value("slaveId");
+
+  sorter.add(slaveId, Resources::parse("cpus:10;mem:1000").get());
+
+  sorter.add("a");
+  sorter.add("b", 2);
+
+  EXPECT_DOUBLE_EQ(0, sorter.share("a"));
+
+  sorter.allocated("a", slaveId, Resources::parse("cpus:1;mem:500").get());
+  sorter.allocated("b", slaveId, Resources::parse("cpus:4;mem:100").get());
+
+  EXPECT_DOUBLE_EQ(0.5, sorter.share("a"));
+  EXPECT_DOUBLE_EQ(0.2, sorter.share("b"));
+
+  // The share of a deactivated client is still known.
+  sorter.deactivate("a");
+
+  EXPECT_DOUBLE_EQ(0.5, sorter.share("a"));
+}
+
+
 // This test verifies that revocable resources are properly accounted
 // for in the DRF sorter.
 TEST(SorterTest, RevocableResources)
@@ -447,6 +563,115 @@ TEST(SorterTest, RevocableResources)
   EXPECT_EQ("b", sorted.back());
 }
 
+
+// Tests that the hierarchical sorter sorts each level of the tree of
+// clients by the shares of the subtrees.
+TEST(SorterTest, HierarchicalDRFSorter)
+{
+  HierarchicalDRFSorter sorter;
+
+  SlaveID slaveId;
+  slaveId.set_value("slaveId");
+
+  sorter.add(slaveId, Resources::parse("cpus:100;mem:100").get());
+
+  sorter.add("eng/ads");
+  sorter.add("eng/search");
+  sorter.add("ops");
+
+  EXPECT_EQ(3, sorter.count());
+  EXPECT_TRUE(sorter.contains("eng/ads"));
+  EXPECT_FALSE(sorter.contains("eng"));
+
+  // 'eng' has a share of 0.3 and 'ops' one of 0.2, so the clients of
+  // 'ops' come first, even though 'eng/ads' has a smaller share.
+  sorter.allocated("eng/ads", slaveId, Resources::parse("cpus:10").get());
+  sorter.allocated("eng/search", slaveId, Resources::parse("cpus:20").get());
+  sorter.allocated("ops", slaveId, Resources::parse("cpus:20").get());
+
+  EXPECT_EQ(list<string>({"ops", "eng/ads", "eng/search"}), sorter.sort());
+
+  EXPECT_DOUBLE_EQ(0.1, sorter.share("eng/ads"));
+  EXPECT_EQ(Resources::parse("cpus:10").get(),
+            sorter.allocationScalars("eng/ads"));
+
+  sorter.unallocated("eng/search", slaveId, Resources::parse("cpus:15").get());
+
+  EXPECT_EQ(list<string>({"eng/search", "eng/ads", "ops"}), sorter.sort());
+
+  // A prefix of a client can be a client as well, which is sorted
+  // next to the subtrees of its children.
+  sorter.add("eng");
+  sorter.allocated("eng", slaveId, Resources::parse("cpus:1").get());
+
+  EXPECT_EQ(list<string>({"eng", "eng/search", "eng/ads", "ops"}),
+            sorter.sort());
+
+  hashmap<string, Resources> allocation = sorter.allocation(slaveId);
+  EXPECT_EQ(4u, allocation.size());
+  EXPECT_EQ(Resources::parse("cpus:5").get(), allocation["eng/search"]);
+
+  // A subtree without active clients is not sorted.
+  sorter.deactivate("eng/ads");
+  sorter.deactivate("eng/search");
+  sorter.deactivate("eng");
+
+  EXPECT_EQ(list<string>({"ops"}), sorter.sort());
+
+  sorter.activate("eng/ads");
+
+  EXPECT_EQ(list<string>({"eng/ads", "ops"}), sorter.sort());
+
+  // Removing a client removes its allocation from its ancestors:
+  // 'eng' has a share of 0.1 without 'eng/search' and 'eng'.
+  sorter.remove("eng/search");
+  sorter.remove("eng");
+  sorter.allocated("ops", slaveId, Resources::parse("cpus:1").get());
+
+  EXPECT_EQ(list<string>({"eng/ads", "ops"}), sorter.sort());
+  EXPECT_EQ(2, sorter.count());
+
+  sorter.remove("eng/ads");
+  sorter.remove("ops");
+
+  EXPECT_TRUE(sorter.sort().empty());
+}
+
+
+// Tests that the hierarchical sorter sorts a flat set of clients in
+// the same order as a DRFSorter.
+TEST(SorterTest, HierarchicalDRFSorterFlat)
+{
+  DRFSorter drf;
+  HierarchicalDRFSorter hierarchical;
+
+  SlaveID slaveId;
+  slaveId.set_value("slaveId");
+
+  const Resources total = Resources::parse("cpus:100;mem:100").get();
+
+  drf.add(slaveId, total);
+  hierarchical.add(slaveId, total);
+
+  for (int i = 0; i < 10; i++) {
+    drf.add("client" + stringify(i), 1 + i % 3);
+    hierarchical.add("client" + stringify(i), 1 + i % 3);
+  }
+
+  for (int i = 0; i < 50; i++) {
+    const string client = drf.sort().front();
+
+    const Resources resources = (i % 2 == 0)
+      ? Resources::parse("cpus:1;mem:2").get()
+      : Resources::parse("cpus:2;mem:1").get();
+
+    drf.allocated(client, slaveId, resources);
+    hierarchical.allocated(client, slaveId, resources);
+
+    EXPECT_EQ(drf.sort(), hierarchical.sort());
+  }
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -298,6 +298,59 @@ void FetchAndStoreAndExpungeAndStoreAndFetch(State* state)
 }
 
 
+void FetchAndStoreAllAndFetch(State* state)
+{
+  Future<Variable<Slaves> > future1 = state->fetch<Slaves>("slaves1");
+  AWAIT_READY(future1);
+
+  Variable<Slaves> variable1 = future1.get();
+
+  future1 = state->fetch<Slaves>("slaves2");
+  AWAIT_READY(future1);
+
+  Variable<Slaves> variable2 = future1.get();
+
+  Slaves slaves1;
+  slaves1.add_slaves()->mutable_info()->set_hostname("localhost1");
+
+  Slaves slaves2;
+  slaves2.add_slaves()->mutable_info()->set_hostname("localhost2");
+
+  vector<Variable<Slaves> > variables;
+  variables.push_back(variable1.mutate(slaves1));
+  variables.push_back(variable2.mutate(slaves2));
+
+  Future<Option<vector<Variable<Slaves> > > > future2 =
+    state->store(variables);
+
+  AWAIT_READY(future2);
+  ASSERT_SOME(future2.get());
+  ASSERT_EQ(2u, future2.get().get().size());
+
+  // Storing the stale 'variable1' with the up to date 'variable2'
+  // stores neither of them.
+  variables.clear();
+  variables.push_back(variable1.mutate(slaves2));
+  variables.push_back(future2.get().get()[1].mutate(slaves1));
+
+  future2 = state->store(variables);
+  AWAIT_READY(future2);
+  EXPECT_NONE(future2.get());
+
+  future1 = state->fetch<Slaves>("slaves1");
+  AWAIT_READY(future1);
+
+  ASSERT_EQ(1, future1.get().get().slaves().size());
+  EXPECT_EQ("localhost1", future1.get().get().slaves(0).info().hostname());
+
+  future1 = state->fetch<Slaves>("slaves2");
+  AWAIT_READY(future1);
+
+  ASSERT_EQ(1, future1.get().get().slaves().size());
+  EXPECT_EQ("localhost2", future1.get().get().slaves(0).info().hostname());
+}
+
+
 void Names(State* state)
 {
   Future<Variable<Slaves> > future1 = state->fetch<Slaves>("slaves");
@@ -385,6 +438,12 @@ TEST_F(InMemoryStateTest, FetchAndStoreAndExpungeAndStoreAndFetch)
 }
 
 
+TEST_F(InMemoryStateTest, FetchAndStoreAllAndFetch)
+{
+  FetchAndStoreAllAndFetch(state);
+}
+
+
 TEST_F(InMemoryStateTest, Names)
 {
   Names(state);
@@ -458,6 +517,12 @@ TEST_F(LevelDBStateTest, FetchAndStoreAndExpungeAndStoreAndFetch)
 }
 
 
+TEST_F(LevelDBStateTest, FetchAndStoreAllAndFetch)
+{
+  FetchAndStoreAllAndFetch(state);
+}
+
+
 TEST_F(LevelDBStateTest, Names)
 {
   Names(state);
@@ -557,6 +622,12 @@ TEST_F(LogStateTest, FetchAndStoreAndExpungeAndStoreAndFetch)
 }
 
 
+TEST_F(LogStateTest, FetchAndStoreAllAndFetch)
+{
+  FetchAndStoreAllAndFetch(state);
+}
+
+
 TEST_F(LogStateTest, Names)
 {
   Names(state);
@@ -609,6 +680,183 @@ TEST_F(LogStateTest, Timeout)
 }
 
 
+// Tests that a storage with a lease serves reads from its cache until
+// the lease expires, even if another writer changed the log.
+TEST_F(LogStateTest, Lease)
+{
+  Clock::pause();
+
+  state::LogStorage leasedStorage(log, 1024, Seconds(10));
+  State leased(&leasedStorage);
+
+  Future<Variable<Slaves>> future1 = leased.fetch<Slaves>("slaves");
+  AWAIT_READY(future1);
+
+  Slaves slaves = future1.get().get();
+  slaves.add_slaves()->mutable_info()->set_hostname("localhost1");
+
+  Future<Option<Variable<Slaves>>> future2 =
+    leased.store(future1.get().mutate(slaves));
+
+  AWAIT_READY(future2);
+  ASSERT_SOME(future2.get());
+
+  // Store the entry through the other storage, which takes over the
+  // promise to write the log.
+  Future<Variable<Slaves>> future3 = state->fetch<Slaves>("slaves");
+  AWAIT_READY(future3);
+  EXPECT_EQ(1, future3.get().get().slaves().size());
+
+  slaves = future3.get().get();
+  slaves.add_slaves()->mutable_info()->set_hostname("localhost2");
+
+  Future<Option<Variable<Slaves>>> future4 =
+    state->store(future3.get().mutate(slaves));
+
+  AWAIT_READY(future4);
+  ASSERT_SOME(future4.get());
+
+  // The lease has not expired yet, so the cache serves the read.
+  Future<Variable<Slaves>> future5 = leased.fetch<Slaves>("slaves");
+  AWAIT_READY(future5);
+  EXPECT_EQ(1, future5.get().get().slaves().size());
+
+  // Once the lease expires, reading restarts the writer, which reads
+  // the tail of the log.
+  Clock::advance(Seconds(10));
+
+  Future<Variable<Slaves>> future6 = leased.fetch<Slaves>("slaves");
+  AWAIT_READY(future6);
+  EXPECT_EQ(2, future6.get().get().slaves().size());
+
+  Clock::resume();
+}
+
+
+// Tests that following a storage reads the entries that another
+// writer stored, without taking over the promise to write the log.
+TEST_F(LogStateTest, Follow)
+{
+  state::LogStorage followingStorage(log, 1024);
+  State following(&followingStorage);
+
+  Future<Variable<Slaves>> future1 = state->fetch<Slaves>("slaves");
+  AWAIT_READY(future1);
+
+  Slaves slaves = future1.get().get();
+  slaves.add_slaves()->mutable_info()->set_hostname("localhost1");
+
+  Future<Option<Variable<Slaves>>> future2 =
+    state->store(future1.get().mutate(slaves));
+
+  AWAIT_READY(future2);
+  ASSERT_SOME(future2.get());
+
+  // Wait for the write to be learned, so that the end of the log is
+  // not pending when following it.
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  Future<Variable<Slaves>> future3 = following.follow<Slaves>("slaves");
+  AWAIT_READY(future3);
+  EXPECT_EQ(1, future3.get().get().slaves().size());
+
+  // The writer still holds the promise, so it can keep storing.
+  slaves.add_slaves()->mutable_info()->set_hostname("localhost2");
+
+  Future<Option<Variable<Slaves>>> future4 =
+    state->store(future2.get().get().mutate(slaves));
+
+  AWAIT_READY(future4);
+  ASSERT_SOME(future4.get());
+
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  // Following again only reads the new entries, and fetching starts
+  // the writer, which reads the tail of the log.
+  Future<Variable<Slaves>> future5 =
+    following.follow<Slaves>("slaves", future3.get());
+
+  AWAIT_READY(future5);
+  EXPECT_EQ(2, future5.get().get().slaves().size());
+
+  Future<Variable<Slaves>> future6 = following.fetch<Slaves>("slaves");
+  AWAIT_READY(future6);
+  EXPECT_EQ(2, future6.get().get().slaves().size());
+}
+
+
+// Tests that following a storage keeps working once the writer has
+// truncated the log past the entries that the follower read.
+TEST_F(LogStateTest, FollowTruncated)
+{
+  // Without diffs between snapshots, each store truncates the log up
+  // to the snapshot that it writes.
+  state::LogStorage truncatingStorage(log, 0);
+  State truncating(&truncatingStorage);
+
+  state::LogStorage followingStorage(log, 1024);
+  State following(&followingStorage);
+
+  Future<Variable<Slaves>> future1 = truncating.fetch<Slaves>("slaves");
+  AWAIT_READY(future1);
+
+  Slaves slaves = future1.get().get();
+  slaves.add_slaves()->mutable_info()->set_hostname("localhost1");
+
+  Future<Option<Variable<Slaves>>> future2 =
+    truncating.store(future1.get().mutate(slaves));
+
+  AWAIT_READY(future2);
+  ASSERT_SOME(future2.get());
+
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  Future<Variable<Slaves>> future3 = following.follow<Slaves>("slaves");
+  AWAIT_READY(future3);
+  EXPECT_EQ(1, future3.get().get().slaves().size());
+
+  // Store twice so that the log gets truncated past what the
+  // follower has read.
+  slaves.add_slaves()->mutable_info()->set_hostname("localhost2");
+
+  Future<Option<Variable<Slaves>>> future4 =
+    truncating.store(future2.get().get().mutate(slaves));
+
+  AWAIT_READY(future4);
+  ASSERT_SOME(future4.get());
+
+  slaves.add_slaves()->mutable_info()->set_hostname("localhost3");
+
+  Future<Option<Variable<Slaves>>> future5 =
+    truncating.store(future4.get().get().mutate(slaves));
+
+  AWAIT_READY(future5);
+  ASSERT_SOME(future5.get());
+
+  Clock::pause();
+  Clock::settle();
+  Clock::resume();
+
+  Future<Variable<Slaves>> future6 =
+    following.follow<Slaves>("slaves", future3.get());
+
+  AWAIT_READY(future6);
+  EXPECT_EQ(3, future6.get().get().slaves().size());
+
+  // Fetching starts the writer of the follower, which reads the log
+  // from where the follower got to.
+  Future<Variable<Slaves>> future7 = following.fetch<Slaves>("slaves");
+  AWAIT_READY(future7);
+  EXPECT_EQ(3, future7.get().get().slaves().size());
+}
+
+
 TEST_F(LogStateTest, Diff)
 {
   Future<Variable<Slaves>> future1 = state->fetch<Slaves>("slaves");
@@ -751,10 +999,76 @@ TEST_F(ZooKeeperStateTest, FetchAndStoreAndExpungeAndStoreAndFetch)
 }
 
 
+TEST_F(ZooKeeperStateTest, FetchAndStoreAllAndFetch)
+{
+  FetchAndStoreAllAndFetch(state);
+}
+
+
 TEST_F(ZooKeeperStateTest, Names)
 {
   Names(state);
 }
+
+
+// Entries that don't fit in a znode are stored in chunks, which
+// another storage, i.e., one that has nothing cached, can read.
+TEST_F(ZooKeeperStateTest, FetchAndStoreBigAndFetch)
+{
+  Future<Variable<Slaves> > future1 = state->fetch<Slaves>("slaves");
+  AWAIT_READY(future1);
+
+  Variable<Slaves> variable = future1.get();
+
+  Slaves slaves1 = variable.get();
+  ASSERT_EQ(0, slaves1.slaves().size());
+
+  for (int i = 0; i < 3000; i++) {
+    Slave* slave = slaves1.add_slaves();
+    slave->mutable_info()->set_hostname(string(500, 'a' + i % 26));
+  }
+
+  variable = variable.mutate(slaves1);
+
+  Future<Option<Variable<Slaves> > > future2 = state->store(variable);
+  AWAIT_READY(future2);
+  ASSERT_SOME(future2.get());
+
+  variable = future2.get().get();
+
+  ZooKeeperStorage storage2(server->connectString(), NO_TIMEOUT, "/state/");
+  State state2(&storage2);
+
+  future1 = state2.fetch<Slaves>("slaves");
+  AWAIT_READY(future1);
+
+  Slaves slaves2 = future1.get().get();
+  ASSERT_EQ(3000, slaves2.slaves().size());
+  EXPECT_EQ(string(500, 'z'), slaves2.slaves(25).info().hostname());
+
+  // Replace the big entry with a small one.
+  Slaves slaves3;
+  slaves3.add_slaves()->mutable_info()->set_hostname("localhost");
+
+  future2 = state->store(variable.mutate(slaves3));
+  AWAIT_READY(future2);
+  ASSERT_SOME(future2.get());
+
+  // The second storage may still have the big entry cached until its
+  // watch fires, so we fetch the small one with the first storage.
+  future1 = state->fetch<Slaves>("slaves");
+  AWAIT_READY(future1);
+
+  variable = future1.get();
+
+  Slaves slaves4 = variable.get();
+  ASSERT_EQ(1, slaves4.slaves().size());
+  EXPECT_EQ("localhost", slaves4.slaves(0).info().hostname());
+
+  Future<bool> future3 = state->expunge(variable);
+  AWAIT_READY(future3);
+  EXPECT_TRUE(future3.get());
+}
 #endif // MESOS_HAS_JAVA
 
 } // namespace tests {
@@ -40,6 +40,7 @@
 #include "slave/paths.hpp"
 #include "slave/slave.hpp"
 #include "slave/state.hpp"
+#include "slave/status_update_manager.hpp"
 
 #include "messages/messages.hpp"
 
@@ -48,6 +49,7 @@
 using mesos::internal::master::Master;
 
 using mesos::internal::slave::Slave;
+using mesos::internal::slave::StatusUpdateJournal;
 
 using process::Clock;
 using process::Future;
@@ -59,6 +61,7 @@ using std::vector;
 
 using testing::_;
 using testing::AtMost;
+using testing::DoAll;
 using testing::Return;
 using testing::SaveArg;
 
@@ -950,6 +953,164 @@ TEST_F(StatusUpdateManagerTest, DuplicatedTerminalStatusUpdate)
   Shutdown();
 }
 
+
+
+// This test verifies that an executor driver with a status update
+// window sends the updates of the window to the slave in one message,
+// and that the slave handles (and checkpoints) all of them.
+TEST_F(StatusUpdateManagerTest, BatchedStatusUpdates)
+{
+  Try<PID<Master> > master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  Try<PID<Slave> > slave = StartSlave(&exec);
+  ASSERT_SOME(slave);
+
+  FrameworkInfo frameworkInfo = DEFAULT_FRAMEWORK_INFO;
+  frameworkInfo.set_checkpoint(true); // Enable checkpointing.
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, frameworkInfo, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(_, _, _));
+
+  Future<vector<Offer> > offers;
+  EXPECT_CALL(sched, resourceOffers(_, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  // The test containerizer does not pass the flags of the slave on to
+  // the executor driver, so we set the window in its environment.
+  os::setenv("MESOS_STATUS_UPDATE_WINDOW", "100ms");
+
+  Future<Nothing> registered;
+  EXPECT_CALL(exec, registered(_, _, _, _))
+    .WillOnce(FutureSatisfy(&registered));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(DoAll(SendStatusUpdateFromTask(TASK_RUNNING),
+                    SendStatusUpdateFromTask(TASK_FINISHED)));
+
+  Future<StatusUpdatesMessage> statusUpdatesMessage =
+    FUTURE_PROTOBUF(StatusUpdatesMessage(), _, slave.get());
+
+  Future<TaskStatus> status1;
+  Future<TaskStatus> status2;
+  EXPECT_CALL(sched, statusUpdate(_, _))
+    .WillOnce(FutureArg<1>(&status1))
+    .WillOnce(FutureArg<1>(&status2));
+
+  driver.launchTasks(offers.get()[0].id(), createTasks(offers.get()[0]));
+
+  AWAIT_READY(registered);
+
+  os::unsetenv("MESOS_STATUS_UPDATE_WINDOW");
+
+  AWAIT_READY(statusUpdatesMessage);
+  EXPECT_EQ(2, statusUpdatesMessage.get().updates_size());
+
+  AWAIT_READY(status1);
+  EXPECT_EQ(TASK_RUNNING, status1.get().state());
+
+  AWAIT_READY(status2);
+  EXPECT_EQ(TASK_FINISHED, status2.get().state());
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+// Returns true unless the record is for the given task.
+static bool otherTask(
+    const TaskID& taskId,
+    const StatusUpdateJournalRecord& record)
+{
+  return !(record.task_id() == taskId);
+}
+
+
+// This test verifies that the journal writes the appended records
+// once flushed, and that a compaction drops the records it is told to
+// while the next records get appended to the compacted journal.
+TEST_F(StatusUpdateManagerTest, JournalCompaction)
+{
+  const string path = path::join(os::getcwd(), "journal", "task.updates");
+
+  Try<StatusUpdateJournal*> journal = StatusUpdateJournal::open(path);
+  ASSERT_SOME(journal);
+
+  vector<StatusUpdateJournalRecord> records;
+
+  for (int i = 0; i < 3; i++) {
+    StatusUpdateJournalRecord record;
+    record.mutable_framework_id()->set_value("framework");
+    record.mutable_executor_id()->set_value("executor");
+    record.mutable_container_id()->set_value("container");
+    record.mutable_task_id()->set_value(stringify(i));
+    record.mutable_record()->set_type(StatusUpdateRecord::ACK);
+    record.mutable_record()->set_uuid(UUID::random().toBytes());
+
+    records.push_back(record);
+  }
+
+  ASSERT_SOME(journal.get()->append(records[0]));
+  ASSERT_SOME(journal.get()->append(records[1]));
+
+  EXPECT_FALSE(journal.get()->empty());
+  EXPECT_FALSE(journal.get()->appended());
+
+  // Nothing gets written before the flush.
+  EXPECT_SOME_EQ(Bytes(0), os::stat::size(path));
+
+  ASSERT_SOME(journal.get()->flush());
+
+  EXPECT_TRUE(journal.get()->empty());
+  EXPECT_TRUE(journal.get()->appended());
+
+  ASSERT_SOME(journal.get()->compact(
+      lambda::bind(&otherTask, records[0].task_id(), lambda::_1)));
+
+  EXPECT_FALSE(journal.get()->appended());
+
+  ASSERT_SOME(journal.get()->append(records[2]));
+  ASSERT_SOME(journal.get()->flush());
+
+  delete journal.get();
+
+  Try<int> fd = os::open(path, O_RDONLY | O_CLOEXEC);
+  ASSERT_SOME(fd);
+
+  Result<StatusUpdateJournalRecord> record =
+    ::protobuf::read<StatusUpdateJournalRecord>(fd.get());
+
+  ASSERT_SOME(record);
+  EXPECT_EQ(records[1].task_id(), record.get().task_id());
+
+  record = ::protobuf::read<StatusUpdateJournalRecord>(fd.get());
+
+  ASSERT_SOME(record);
+  EXPECT_EQ(records[2].task_id(), record.get().task_id());
+
+  record = ::protobuf::read<StatusUpdateJournalRecord>(fd.get());
+
+  EXPECT_NONE(record);
+
+  os::close(fd.get());
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -17,6 +17,7 @@
 #include <gmock/gmock.h>
 
 #include <process/future.hpp>
+#include <process/gmock.hpp>
 #include <process/gtest.hpp>
 #include <process/http.hpp>
 #include <process/process.hpp>
@@ -26,17 +27,21 @@
 
 #include <stout/os/exists.hpp>
 #include <stout/os/getcwd.hpp>
+#include <stout/os/read.hpp>
 
 #include <stout/tests/utils.hpp>
 
 #include <mesos/uri/fetcher.hpp>
 #include <mesos/uri/uri.hpp>
 
+#include "uri/utils.hpp"
+
 #include "uri/schemes/http.hpp"
 
 using namespace process;
 
 using testing::_;
+using testing::DoAll;
 using testing::Return;
 
 namespace mesos {
@@ -49,13 +54,28 @@ public:
   TestHttpServer() : ProcessBase("TestHttpServer")
   {
     route("/test", None(), &TestHttpServer::test);
+    route("/redirect", None(), &TestHttpServer::redirect);
   }
 
   MOCK_METHOD1(test, Future<http::Response>(const http::Request&));
+  MOCK_METHOD1(redirect, Future<http::Response>(const http::Request&));
 };
 
 
-class CurlFetcherPluginTest : public TemporaryDirectoryTest
+// Serves the WebHDFS REST API of a namenode, i.e., '/webhdfs/v1'.
+class TestNamenode : public Process<TestNamenode>
+{
+public:
+  TestNamenode() : ProcessBase("webhdfs")
+  {
+    route("/v1", None(), &TestNamenode::v1);
+  }
+
+  MOCK_METHOD1(v1, Future<http::Response>(const http::Request&));
+};
+
+
+class HttpFetcherPluginTest : public TemporaryDirectoryTest
 {
 protected:
   virtual void SetUp()
@@ -77,7 +97,7 @@ protected:
 };
 
 
-TEST_F(CurlFetcherPluginTest, CURL_ValidUri)
+TEST_F(HttpFetcherPluginTest, ValidUri)
 {
   URI uri = uri::http(
       stringify(server.self().address.ip),
@@ -96,7 +116,7 @@ TEST_F(CurlFetcherPluginTest, CURL_ValidUri)
 }
 
 
-TEST_F(CurlFetcherPluginTest, CURL_InvalidUri)
+TEST_F(HttpFetcherPluginTest, InvalidUri)
 {
   URI uri = uri::http(
       stringify(server.self().address.ip),
@@ -112,6 +132,72 @@ TEST_F(CurlFetcherPluginTest, CURL_InvalidUri)
   AWAIT_FAILED(fetcher.get()->fetch(uri, os::getcwd()));
 }
 
+
+// Tests that the redirects are followed, and that the file is
+// downloaded from the final location.
+TEST_F(HttpFetcherPluginTest, Redirect)
+{
+  URI uri = uri::http(
+      stringify(server.self().address.ip),
+      "/TestHttpServer/redirect",
+      server.self().address.port);
+
+  EXPECT_CALL(server, test(_))
+    .WillOnce(Return(http::OK("test")));
+
+  EXPECT_CALL(server, redirect(_))
+    .WillOnce(Return(http::TemporaryRedirect("/TestHttpServer/test")));
+
+  Try<Owned<uri::Fetcher>> fetcher = uri::Fetcher::create();
+  ASSERT_SOME(fetcher);
+
+  AWAIT_READY(fetcher.get()->fetch(uri, os::getcwd()));
+
+  EXPECT_SOME_EQ("test", os::read(path::join(os::getcwd(), "redirect")));
+}
+
+
+class WebHDFSFetcherPluginTest : public HttpFetcherPluginTest {};
+
+
+// Tests that the file is opened through the namenode, and downloaded
+// from the datanode it redirects to.
+TEST_F(WebHDFSFetcherPluginTest, ValidUri)
+{
+  TestNamenode namenode;
+  spawn(namenode);
+
+  URI uri = uri::construct(
+      "webhdfs",
+      "/user/mesos/data",
+      stringify(namenode.self().address.ip),
+      namenode.self().address.port);
+
+  Future<http::Request> request;
+  EXPECT_CALL(namenode, v1(_))
+    .WillOnce(DoAll(FutureArg<0>(&request),
+                    Return(http::TemporaryRedirect(
+                        "http://" + stringify(server.self().address) +
+                        "/TestHttpServer/test"))));
+
+  EXPECT_CALL(server, test(_))
+    .WillOnce(Return(http::OK("data")));
+
+  Try<Owned<uri::Fetcher>> fetcher = uri::Fetcher::create();
+  ASSERT_SOME(fetcher);
+
+  AWAIT_READY(fetcher.get()->fetch(uri, os::getcwd()));
+
+  AWAIT_READY(request);
+  EXPECT_EQ("/webhdfs/v1/user/mesos/data", request->url.path);
+  EXPECT_SOME_EQ("OPEN", request->url.query.get("op"));
+
+  EXPECT_SOME_EQ("data", os::read(path::join(os::getcwd(), "data")));
+
+  terminate(namenode);
+  wait(namenode);
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
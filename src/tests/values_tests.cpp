@@ -408,6 +408,80 @@ TEST(ValuesTest, RangesSubtraction)
   ranges2 = parse("[1-2]").get().ranges();
 
   EXPECT_EQ(parse("[3-8]").get().ranges(), ranges1 - ranges2);
+
+  // Removes from multiple ranges, with a range spanning two of them.
+  ranges1 = parse("[1-10, 20-30, 40-50]").get().ranges();
+  ranges2 = parse("[2-3, 5-5, 9-21, 25-25, 50-60]").get().ranges();
+
+  EXPECT_EQ(
+      parse("[1-1, 4-4, 6-8, 22-24, 26-30, 40-49]").get().ranges(),
+      ranges1 - ranges2);
+
+  // Unsorted and uncoalesced ranges.
+  ranges1 = parse("[20-30, 1-10, 5-15]").get().ranges();
+  ranges2 = parse("[25-35, 2-2]").get().ranges();
+
+  ranges1 -= ranges2;
+
+  EXPECT_EQ(parse("[1-1, 3-15, 20-24]").get().ranges(), ranges1);
+  EXPECT_EQ(3, ranges1.range_size());
+}
+
+
+// Test comparing ranges.
+TEST(ValuesTest, RangesComparison)
+{
+  Value::Ranges ranges1 = parse("[1-10, 20-30]").get().ranges();
+
+  EXPECT_EQ(parse("[20-25, 1-10, 26-30]").get().ranges(), ranges1);
+  EXPECT_FALSE(parse("[1-10, 20-29]").get().ranges() == ranges1);
+
+  EXPECT_TRUE(parse("[]").get().ranges() <= ranges1);
+  EXPECT_TRUE(parse("[2-3, 10-10, 20-30]").get().ranges() <= ranges1);
+  EXPECT_TRUE(parse("[25-30, 1-5]").get().ranges() <= ranges1);
+  EXPECT_FALSE(parse("[10-20]").get().ranges() <= ranges1);
+  EXPECT_FALSE(parse("[5-11]").get().ranges() <= ranges1);
+  EXPECT_FALSE(parse("[31-31]").get().ranges() <= ranges1);
+  EXPECT_FALSE(ranges1 <= parse("[1-30]").get().ranges() - ranges1);
+}
+
+
+// Tests that scalar arithmetic is exact up to three decimal digits.
+TEST(ValuesTest, ScalarArithmetic)
+{
+  Value::Scalar total;
+  total.set_value(0);
+
+  Value::Scalar tenth;
+  tenth.set_value(0.1);
+
+  for (int i = 0; i < 10; i++) {
+    total += tenth;
+  }
+
+  EXPECT_EQ(1.0, total.value());
+
+  for (int i = 0; i < 10; i++) {
+    total -= tenth;
+  }
+
+  EXPECT_EQ(0.0, total.value());
+
+  // Values are compared with a precision of three decimal digits.
+  Value::Scalar left;
+  left.set_value(0.0001);
+
+  Value::Scalar right;
+  right.set_value(0.0002);
+
+  EXPECT_EQ(left, right);
+  EXPECT_TRUE(right <= left);
+
+  right.set_value(0.002);
+
+  EXPECT_FALSE(right <= left);
+  EXPECT_EQ(0.002, (left + right).value());
+  EXPECT_EQ(-0.002, (left - right).value());
 }
 
 } // namespace tests {
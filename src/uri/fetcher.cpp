@@ -17,6 +17,8 @@
 #include <mesos/uri/fetcher.hpp>
 
 #include "uri/fetchers/curl.hpp"
+#include "uri/fetchers/http.hpp"
+#include "uri/fetchers/webhdfs.hpp"
 
 using namespace process;
 
@@ -30,7 +32,14 @@ Try<Owned<Fetcher>> Fetcher::create()
   hashmap<string, Owned<Plugin>> plugins;
 
   hashmap<string, Try<Owned<Plugin>>(*)()> creators;
-  creators.put("http", &CurlFetcherPlugin::create);
+  creators.put("http", &HttpFetcherPlugin::create);
+  creators.put("https", &HttpFetcherPlugin::create);
+  creators.put("webhdfs", &WebHDFSFetcherPlugin::create);
+  creators.put("swebhdfs", &WebHDFSFetcherPlugin::create);
+
+  // The schemes which are not supported natively yet.
+  creators.put("ftp", &CurlFetcherPlugin::create);
+  creators.put("ftps", &CurlFetcherPlugin::create);
 
   foreachkey (const string& scheme, creators) {
     Try<Owned<Plugin>> plugin = creators[scheme]();
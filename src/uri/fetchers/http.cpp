@@ -0,0 +1,265 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <fcntl.h>
+
+#include <string>
+
+#include <process/http.hpp>
+#include <process/io.hpp>
+
+#include <stout/hashmap.hpp>
+#include <stout/numify.hpp>
+#include <stout/path.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+
+#include <stout/os/close.hpp>
+#include <stout/os/exists.hpp>
+#include <stout/os/mkdir.hpp>
+#include <stout/os/open.hpp>
+
+#include "uri/fetchers/http.hpp"
+
+using namespace process;
+
+using std::string;
+
+namespace mesos {
+namespace uri {
+
+// The maximum number of redirects followed by a download, which is
+// what most browsers allow.
+static const size_t MAX_REDIRECTS = 20;
+
+
+// Forward declarations.
+static Future<Nothing> _download(
+    const http::ConnectionPool& pool,
+    const http::URL& url,
+    const string& output,
+    size_t redirects);
+
+
+static Future<Nothing> __download(
+    const http::Pipe::Reader& reader,
+    int fd);
+
+
+Try<Owned<Fetcher::Plugin>> HttpFetcherPlugin::create()
+{
+  return Owned<Fetcher::Plugin>(new HttpFetcherPlugin());
+}
+
+
+Future<Nothing> HttpFetcherPlugin::fetch(
+    const URI& uri,
+    const string& directory)
+{
+  if (!uri.has_host()) {
+    return Failure("URI host is not specified");
+  }
+
+  if (!os::exists(directory)) {
+    Try<Nothing> mkdir = os::mkdir(directory);
+    if (mkdir.isError()) {
+      return Failure(
+          "Failed to create directory '" +
+          directory + "': " + mkdir.error());
+    }
+  }
+
+  // TODO(jieyu): Allow user to specify the name of the output file.
+  const string output = path::join(directory, Path(uri.path()).basename());
+
+  http::URL url(
+      uri.scheme(),
+      uri.host(),
+      uri.has_port() ? uri.port() : (uri.scheme() == "https" ? 443 : 80),
+      strings::startsWith(uri.path(), "/") ? uri.path() : "/" + uri.path());
+
+  if (uri.has_query()) {
+    Try<hashmap<string, string>> query = http::query::decode(uri.query());
+    if (query.isError()) {
+      return Failure("Failed to decode URI query: " + query.error());
+    }
+
+    url.query = query.get();
+  }
+
+  return download(pool, url, output);
+}
+
+
+// Resolves the 'Location' of a redirect against the URL it was the
+// response to. Both absolute URLs and absolute paths are supported.
+static Try<http::URL> resolve(const http::URL& base, const string& location)
+{
+  http::URL url = base;
+  string remainder = location;
+
+  const size_t separator = remainder.find("://");
+  if (separator != string::npos) {
+    url.scheme = remainder.substr(0, separator);
+    remainder = remainder.substr(separator + 3);
+
+    const size_t slash = remainder.find('/');
+    string authority = remainder.substr(0, slash);
+    remainder = slash == string::npos ? "/" : remainder.substr(slash);
+
+    // Drop the user information, if any.
+    const size_t at = authority.rfind('@');
+    if (at != string::npos) {
+      authority = authority.substr(at + 1);
+    }
+
+    const size_t colon = authority.rfind(':');
+    if (colon != string::npos) {
+      Try<uint16_t> port = numify<uint16_t>(authority.substr(colon + 1));
+      if (port.isError()) {
+        return Error("Invalid port in '" + location + "'");
+      }
+
+      url.port = port.get();
+      authority = authority.substr(0, colon);
+    } else {
+      url.port = url.scheme == string("https") ? 443 : 80;
+    }
+
+    url.domain = authority;
+    url.ip = None();
+  } else if (!strings::startsWith(remainder, "/")) {
+    return Error("Relative location '" + location + "' is not supported");
+  }
+
+  remainder = remainder.substr(0, remainder.find('#'));
+
+  const size_t question = remainder.find('?');
+  url.path = remainder.substr(0, question);
+  url.query.clear();
+  url.fragment = None();
+
+  if (question != string::npos) {
+    Try<hashmap<string, string>> query =
+      http::query::decode(remainder.substr(question + 1));
+
+    if (query.isError()) {
+      return Error("Failed to decode query of '" + location + "'");
+    }
+
+    url.query = query.get();
+  }
+
+  return url;
+}
+
+
+Future<Nothing> download(
+    const http::ConnectionPool& pool,
+    const http::URL& url,
+    const string& output)
+{
+  return _download(pool, url, output, 0);
+}
+
+
+static Future<Nothing> _download(
+    const http::ConnectionPool& pool,
+    const http::URL& url,
+    const string& output,
+    size_t redirects)
+{
+  http::Request request;
+  request.method = "GET";
+  request.url = url;
+
+  return pool.send(request, true)
+    .then([=](const http::Response& response) -> Future<Nothing> {
+      CHECK_EQ(http::Response::PIPE, response.type);
+      CHECK_SOME(response.reader);
+
+      http::Pipe::Reader reader = response.reader.get();
+
+      if (response.code >= 300 && response.code < 400 &&
+          response.headers.contains("Location")) {
+        // We are not interested in the body of a redirect.
+        reader.close();
+
+        if (redirects >= MAX_REDIRECTS) {
+          return Failure(
+              "Exceeded the maximum of " + stringify(MAX_REDIRECTS) +
+              " redirects");
+        }
+
+        Try<http::URL> location =
+          resolve(url, response.headers.at("Location"));
+
+        if (location.isError()) {
+          return Failure(
+              "Failed to follow redirect: " + location.error());
+        }
+
+        return _download(pool, location.get(), output, redirects + 1);
+      }
+
+      if (response.code != http::Status::OK) {
+        reader.close();
+
+        return Failure(
+            "Unexpected HTTP response code: " +
+            http::Status::string(response.code));
+      }
+
+      Try<int> fd = os::open(
+          output,
+          O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+          S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+      if (fd.isError()) {
+        reader.close();
+
+        return Failure(
+            "Failed to open '" + output + "': " + fd.error());
+      }
+
+      return __download(reader, fd.get())
+        .onAny([=]() { os::close(fd.get()); });
+    });
+}
+
+
+// Writes the body to the file as it arrives, so that the file never
+// has to be held in memory.
+static Future<Nothing> __download(
+    const http::Pipe::Reader& reader,
+    int fd)
+{
+  http::Pipe::Reader _reader = reader;
+
+  return _reader.read()
+    .then([=](const string& data) -> Future<Nothing> {
+      if (data.empty()) {
+        return Nothing();
+      }
+
+      return io::write(fd, data)
+        .then([=]() { return __download(reader, fd); });
+    });
+}
+
+} // namespace uri {
+} // namespace mesos {
@@ -0,0 +1,70 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef __URI_FETCHERS_HTTP_HPP__
+#define __URI_FETCHERS_HTTP_HPP__
+
+#include <string>
+
+#include <process/future.hpp>
+#include <process/http.hpp>
+#include <process/owned.hpp>
+
+#include <stout/try.hpp>
+
+#include <mesos/uri/fetcher.hpp>
+
+namespace mesos {
+namespace uri {
+
+/**
+ * Fetches 'http' and 'https' URIs in-process with the libprocess HTTP
+ * client. Connections to the same server are reused across fetches
+ * and the response bodies are streamed to disk as they arrive.
+ */
+class HttpFetcherPlugin : public Fetcher::Plugin
+{
+public:
+  virtual ~HttpFetcherPlugin() {}
+
+  static Try<process::Owned<Fetcher::Plugin>> create();
+
+  virtual process::Future<Nothing> fetch(
+      const URI& uri,
+      const std::string& directory);
+
+private:
+  HttpFetcherPlugin() {}
+
+  process::http::ConnectionPool pool;
+};
+
+
+/**
+ * Downloads the given URL into the file at 'output' on one of the
+ * connections of 'pool', following HTTP 3xx redirects. The download
+ * fails unless the (final) response is '200 OK'.
+ */
+process::Future<Nothing> download(
+    const process::http::ConnectionPool& pool,
+    const process::http::URL& url,
+    const std::string& output);
+
+} // namespace uri {
+} // namespace mesos {
+
+#endif // __URI_FETCHERS_HTTP_HPP__
@@ -0,0 +1,91 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <string>
+
+#include <process/http.hpp>
+
+#include <stout/path.hpp>
+#include <stout/strings.hpp>
+
+#include <stout/os/exists.hpp>
+#include <stout/os/mkdir.hpp>
+
+#include "uri/fetchers/http.hpp"
+#include "uri/fetchers/webhdfs.hpp"
+
+using namespace process;
+
+using std::string;
+
+namespace mesos {
+namespace uri {
+
+// The default ports of the namenode HTTP(S) servers.
+static const int DEFAULT_WEBHDFS_PORT = 50070;
+static const int DEFAULT_SWEBHDFS_PORT = 50470;
+
+
+Try<Owned<Fetcher::Plugin>> WebHDFSFetcherPlugin::create()
+{
+  return Owned<Fetcher::Plugin>(new WebHDFSFetcherPlugin());
+}
+
+
+Future<Nothing> WebHDFSFetcherPlugin::fetch(
+    const URI& uri,
+    const string& directory)
+{
+  if (!uri.has_host()) {
+    return Failure("URI host is not specified");
+  }
+
+  if (!os::exists(directory)) {
+    Try<Nothing> mkdir = os::mkdir(directory);
+    if (mkdir.isError()) {
+      return Failure(
+          "Failed to create directory '" +
+          directory + "': " + mkdir.error());
+    }
+  }
+
+  const string output = path::join(directory, Path(uri.path()).basename());
+
+  const bool secure = uri.scheme() == "swebhdfs";
+
+  // See the 'OPEN' operation of the WebHDFS REST API.
+  http::URL url(
+      secure ? "https" : "http",
+      uri.host(),
+      uri.has_port()
+        ? uri.port()
+        : (secure ? DEFAULT_SWEBHDFS_PORT : DEFAULT_WEBHDFS_PORT),
+      path::join(
+          "/webhdfs/v1",
+          strings::remove(uri.path(), "/", strings::PREFIX)));
+
+  url.query["op"] = "OPEN";
+
+  if (uri.has_user()) {
+    url.query["user.name"] = uri.user();
+  }
+
+  return download(pool, url, output);
+}
+
+} // namespace uri {
+} // namespace mesos {
@@ -28,6 +28,36 @@
 namespace mesos {
 namespace internal {
 
+// Adds the usage of the process to the statistics.
+static void add(
+    const os::Process& process,
+    bool mem,
+    bool cpus,
+    ResourceStatistics* statistics)
+{
+  if (mem) {
+    if (process.rss.isSome()) {
+      statistics->set_mem_rss_bytes(
+          statistics->mem_rss_bytes() + process.rss.get().bytes());
+    }
+  }
+
+  // We only show utime and stime when both are available, otherwise
+  // we're exposing a partial view of the CPU times.
+  if (cpus) {
+    if (process.utime.isSome() && process.stime.isSome()) {
+      statistics->set_cpus_user_time_secs(
+          statistics->cpus_user_time_secs() +
+          process.utime.get().secs());
+
+      statistics->set_cpus_system_time_secs(
+          statistics->cpus_system_time_secs() +
+          process.stime.get().secs());
+    }
+  }
+}
+
+
 Try<ResourceStatistics> usage(pid_t pid, bool mem, bool cpus)
 {
   Try<os::ProcessTree> pstree = os::pstree(pid);
@@ -47,26 +77,7 @@ Try<ResourceStatistics> usage(pid_t pid, bool mem, bool cpus)
   while (!trees.empty()) {
     const os::ProcessTree& tree = trees.front();
 
-    if (mem) {
-      if (tree.process.rss.isSome()) {
-        statistics.set_mem_rss_bytes(
-            statistics.mem_rss_bytes() + tree.process.rss.get().bytes());
-      }
-    }
-
-    // We only show utime and stime when both are available, otherwise
-    // we're exposing a partial view of the CPU times.
-    if (cpus) {
-      if (tree.process.utime.isSome() && tree.process.stime.isSome()) {
-        statistics.set_cpus_user_time_secs(
-            statistics.cpus_user_time_secs() +
-            tree.process.utime.get().secs());
-
-        statistics.set_cpus_system_time_secs(
-            statistics.cpus_system_time_secs() +
-            tree.process.stime.get().secs());
-      }
-    }
+    add(tree.process, mem, cpus, &statistics);
 
     foreach (const os::ProcessTree& child, tree.children) {
       trees.push_back(child);
@@ -78,5 +89,26 @@ Try<ResourceStatistics> usage(pid_t pid, bool mem, bool cpus)
   return statistics;
 }
 
+
+Try<ResourceStatistics> usage(const std::set<pid_t>& pids, bool mem, bool cpus)
+{
+  ResourceStatistics statistics;
+
+  // The timestamp is the only required field.
+  statistics.set_timestamp(process::Clock::now().secs());
+
+  foreach (pid_t pid, pids) {
+    // NOTE: Reading a process fails if it exits in the middle of
+    // it, so errors are skipped like the processes which are gone.
+    Result<os::Process> process = os::process(pid);
+
+    if (process.isSome()) {
+      add(process.get(), mem, cpus, &statistics);
+    }
+  }
+
+  return statistics;
+}
+
 } // namespace internal {
 } // namespace mesos {
@@ -19,6 +19,8 @@
 
 #include <unistd.h> // For pid_t.
 
+#include <set>
+
 #include "mesos/mesos.hpp"
 
 namespace mesos {
@@ -29,6 +31,14 @@ namespace internal {
 // values if 'cpus' is true.
 Try<ResourceStatistics> usage(pid_t pid, bool mem = true, bool cpus = true);
 
+
+// Collects resource usage of the given processes, skipping any which
+// have exited.
+Try<ResourceStatistics> usage(
+    const std::set<pid_t>& pids,
+    bool mem = true,
+    bool cpus = true);
+
 } // namespace internal {
 } // namespace mesos {
 
@@ -17,6 +17,7 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <cmath>
 #include <initializer_list>
 #include <ostream>
 #include <string>
@@ -50,47 +51,70 @@ ostream& operator<<(ostream& stream, const Value::Scalar& scalar)
 }
 
 
+// Scalar values are added, subtracted and compared as fixed point
+// integers with three decimal digits, rather than as doubles. This
+// makes the arithmetic exact (e.g., adding and then subtracting the
+// same amount of cpus yields the original amount) and turns the
+// comparisons of 'Resources' into integer comparisons.
+static int64_t convertToFixed(double value)
+{
+  return std::llround(value * 1000);
+}
+
+
+static double convertToFloating(int64_t value)
+{
+  // NOTE: The integer part and the fraction are converted separately
+  // so that the floating point division only applies to [0, 999].
+  return static_cast<double>(value / 1000) +
+         static_cast<double>(value % 1000) / 1000.0;
+}
+
+
 bool operator==(const Value::Scalar& left, const Value::Scalar& right)
 {
-  return left.value() == right.value();
+  return convertToFixed(left.value()) == convertToFixed(right.value());
 }
 
 
 bool operator<=(const Value::Scalar& left, const Value::Scalar& right)
 {
-  return left.value() <= right.value();
+  return convertToFixed(left.value()) <= convertToFixed(right.value());
 }
 
 
 Value::Scalar operator+(const Value::Scalar& left, const Value::Scalar& right)
 {
-  Value::Scalar result;
-  result.set_value(left.value() + right.value());
+  Value::Scalar result = left;
+  result += right;
   return result;
 }
 
 
 Value::Scalar operator-(const Value::Scalar& left, const Value::Scalar& right)
 {
-  Value::Scalar result;
-  result.set_value(left.value() - right.value());
+  Value::Scalar result = left;
+  result -= right;
   return result;
 }
 
 
 Value::Scalar& operator+=(Value::Scalar& left, const Value::Scalar& right)
 {
-  left.set_value(left.value() + right.value());
+  left.set_value(convertToFloating(
+      convertToFixed(left.value()) + convertToFixed(right.value())));
   return left;
 }
 
 
 Value::Scalar& operator-=(Value::Scalar& left, const Value::Scalar& right)
 {
-  left.set_value(left.value() - right.value());
+  left.set_value(convertToFloating(
+      convertToFixed(left.value()) - convertToFixed(right.value())));
   return left;
 }
 
+
 namespace internal {
 
 struct Range
@@ -100,39 +124,37 @@ struct Range
 };
 
 
-// Coalesces the vector of ranges provided and modifies `result` to contain the
-// solution.
+// Coalesces the vector of ranges provided in place, i.e., afterwards
+// the ranges are sorted and neither overlap nor are adjacent.
 // The algorithm first sorts all the individual intervals so that we can iterate
-// over them sequentially.
+// over them sequentially, unless they are sorted already (e.g., because they
+// were produced by one of the operations below).
 // The algorithm does a single pass, after the sort, and builds up the solution
-// in place. It then modifies the `result` with as few steps as possible. The
-// expensive part of this operation is modification of the protobuf, which is
-// why we prefer to build up the solution in a temporary vector.
-void coalesce(Value::Ranges* result, vector<Range> ranges)
+// in place.
+static void coalesce(vector<Range>* ranges)
 {
   // Exit early if empty.
-  if (ranges.empty()) {
-    result->clear_range();
+  if (ranges->empty()) {
     return;
   }
 
-  std::sort(
-      ranges.begin(),
-      ranges.end(),
-      [](const Range& left, const Range& right) {
-        return std::tie(left.start, left.end) <
-               std::tie(right.start, right.end);
-      });
+  auto less = [](const Range& left, const Range& right) {
+    return std::tie(left.start, left.end) < std::tie(right.start, right.end);
+  };
+
+  if (!std::is_sorted(ranges->begin(), ranges->end(), less)) {
+    std::sort(ranges->begin(), ranges->end(), less);
+  }
 
   // We build up initial state of the current range.
-  CHECK(!ranges.empty());
-  int count = 1;
-  Range current = ranges.front();
+  CHECK(!ranges->empty());
+  size_t count = 1;
+  Range current = ranges->front();
 
   // In a single pass, we compute the size of the end result, as well as modify
   // in place the intermediate data structure to build up result as we
   // solve it.
-  foreach (const Range& range, ranges) {
+  foreach (const Range& range, *ranges) {
     // Skip if this range is equivalent to the current range.
     if (range.start == current.start && range.end == current.end) {
       continue;
@@ -148,7 +170,7 @@ void coalesce(Value::Ranges* result, vector<Range> ranges)
         current.end = max(current.end, range.end);
       } else {
         // 2. No overlap and we are adding a new range.
-        ranges[count - 1] = current;
+        (*ranges)[count - 1] = current;
         ++count;
         current = range;
       }
@@ -156,9 +178,37 @@ void coalesce(Value::Ranges* result, vector<Range> ranges)
   }
 
   // Record the state of the last range into of ranges vector.
-  ranges[count - 1] = current;
+  (*ranges)[count - 1] = current;
+
+  CHECK(count <= ranges->size());
+
+  ranges->resize(count);
+}
+
+
+// Returns the coalesced ranges of the protobuf.
+static vector<Range> convert(const Value::Ranges& ranges)
+{
+  vector<Range> result;
+  result.reserve(ranges.range_size());
+
+  foreach (const Value::Range& range, ranges.range()) {
+    result.push_back({range.begin(), range.end()});
+  }
 
-  CHECK(count <= static_cast<int>(ranges.size()));
+  coalesce(&result);
+
+  return result;
+}
+
+
+// Modifies `result` to contain the (coalesced) ranges provided with as few
+// steps as possible. The expensive part of the operations on ranges is the
+// modification of the protobuf, which is why we prefer to build up the
+// solution in a temporary vector.
+static void assign(Value::Ranges* result, const vector<Range>& ranges)
+{
+  const int count = static_cast<int>(ranges.size());
 
   // Shrink result if it is too large by deleting trailing subrange.
   if (count < result->range_size()) {
@@ -184,6 +234,63 @@ void coalesce(Value::Ranges* result, vector<Range> ranges)
   CHECK_EQ(result->range_size(), count);
 }
 
+
+// Coalesces the vector of ranges provided and modifies `result` to contain the
+// solution.
+void coalesce(Value::Ranges* result, vector<Range> ranges)
+{
+  coalesce(&ranges);
+  assign(result, ranges);
+}
+
+
+// Returns the ranges in `left` that are not in `right`, both of which
+// must be coalesced. Since both are sorted this takes a single pass
+// over `left` and `right`, and the result is coalesced as well.
+static vector<Range> subtract(
+    const vector<Range>& left,
+    const vector<Range>& right)
+{
+  vector<Range> result;
+  result.reserve(left.size() + right.size());
+
+  size_t j = 0;
+
+  foreach (const Range& range, left) {
+    // Skip the ranges to remove that end before this range. They end
+    // before all of the following ranges as well.
+    while (j < right.size() && right[j].end < range.start) {
+      ++j;
+    }
+
+    uint64_t start = range.start;
+    bool removed = false;
+
+    // NOTE: We don't advance `j` here, since the last range to remove
+    // that intersects this range might intersect the next one as well.
+    for (size_t k = j; k < right.size() && right[k].start <= range.end; ++k) {
+      // Keep the part in front of the range to remove.
+      if (right[k].start > start) {
+        result.push_back({start, right[k].start - 1});
+      }
+
+      if (right[k].end >= range.end) {
+        removed = true;
+        break;
+      }
+
+      start = right[k].end + 1;
+    }
+
+    // Keep the part after the last range to remove.
+    if (!removed) {
+      result.push_back({start, range.end});
+    }
+  }
+
+  return result;
+}
+
 } // namespace internal {
 
 
@@ -234,49 +341,6 @@ void coalesce(Value::Ranges* result, const Value::Range& addedRange)
 }
 
 
-// Removes a range from already coalesced ranges.
-// The algorithms constructs a new vector of ranges which is then
-// coalesced into a Value::Ranges instance.
-static void remove(Value::Ranges* _ranges, const Value::Range& removal)
-{
-  vector<internal::Range> ranges;
-  ranges.reserve(_ranges->range_size());
-
-  foreach (const Value::Range& range, _ranges->range()) {
-    // Skip if the entire range is subsumed by `removal`.
-    if (range.begin() >= removal.begin() && range.end() <= removal.end()) {
-      continue;
-    }
-
-    // Divide if the range subsumes the `removal`.
-    if (range.begin() < removal.begin() && range.end() > removal.end()) {
-      // Front.
-      ranges.emplace_back(internal::Range{range.begin(), removal.begin() - 1});
-      // Back.
-      ranges.emplace_back(internal::Range{removal.end() + 1, range.end()});
-    }
-
-    // Fully Emplace if the range doesn't intersect.
-    if (range.end() < removal.begin() || range.begin() > removal.end()) {
-      ranges.emplace_back(internal::Range{range.begin(), range.end()});
-    } else {
-      // Trim if the range does intersect.
-      if (range.end() > removal.end()) {
-        // Trim front.
-        ranges.emplace_back(internal::Range{removal.end() + 1, range.end()});
-      } else {
-        // Trim back.
-        CHECK(range.begin() < removal.begin());
-        ranges.emplace_back(
-            internal::Range{range.begin(), removal.begin() - 1});
-      }
-    }
-  }
-
-  internal::coalesce(_ranges, std::move(ranges));
-}
-
-
 ostream& operator<<(ostream& stream, const Value::Ranges& ranges)
 {
   stream << "[";
@@ -291,57 +355,47 @@ ostream& operator<<(ostream& stream, const Value::Ranges& ranges)
 }
 
 
+// NOTE: The comparisons and the subtraction below operate on the
+// coalesced (i.e., sorted) vectors of ranges rather than on copies of
+// the protobufs, since they are done for every offer, launch and
+// recovery of port resources.
 bool operator==(const Value::Ranges& _left, const Value::Ranges& _right)
 {
-  Value::Ranges left;
-  coalesce(&left, {_left});
+  const vector<internal::Range> left = internal::convert(_left);
+  const vector<internal::Range> right = internal::convert(_right);
 
-  Value::Ranges right;
-  coalesce(&right, {_right});
-
-  if (left.range_size() == right.range_size()) {
-    for (int i = 0; i < left.range_size(); i++) {
-      // Make sure this range is equal to a range in the right.
-      bool found = false;
-      for (int j = 0; j < right.range_size(); j++) {
-        if (left.range(i).begin() == right.range(j).begin() &&
-            left.range(i).end() == right.range(j).end()) {
-          found = true;
-          break;
-        }
-      }
+  if (left.size() != right.size()) {
+    return false;
+  }
 
-      if (!found) {
-        return false;
-      }
+  for (size_t i = 0; i < left.size(); i++) {
+    if (left[i].start != right[i].start || left[i].end != right[i].end) {
+      return false;
     }
-
-    return true;
   }
 
-  return false;
+  return true;
 }
 
 
 bool operator<=(const Value::Ranges& _left, const Value::Ranges& _right)
 {
-  Value::Ranges left;
-  coalesce(&left, {_left});
+  const vector<internal::Range> left = internal::convert(_left);
+  const vector<internal::Range> right = internal::convert(_right);
 
-  Value::Ranges right;
-  coalesce(&right, {_right});
+  // Since the ranges on the right neither overlap nor are adjacent,
+  // each range on the left must be a subset of a single range on the
+  // right, which are both sorted.
+  size_t j = 0;
 
-  for (int i = 0; i < left.range_size(); i++) {
-    // Make sure this range is a subset of a range in right.
-    bool matched = false;
-    for (int j = 0; j < right.range_size(); j++) {
-      if (left.range(i).begin() >= right.range(j).begin() &&
-          left.range(i).end() <= right.range(j).end()) {
-        matched = true;
-        break;
-      }
+  foreach (const internal::Range& range, left) {
+    while (j < right.size() && right[j].end < range.start) {
+      ++j;
     }
-    if (!matched) {
+
+    if (j == right.size() ||
+        range.start < right[j].start ||
+        range.end > right[j].end) {
       return false;
     }
   }
@@ -361,8 +415,10 @@ Value::Ranges operator+(const Value::Ranges& left, const Value::Ranges& right)
 Value::Ranges operator-(const Value::Ranges& left, const Value::Ranges& right)
 {
   Value::Ranges result;
-  coalesce(&result, {left});
-  return result -= right;
+  internal::assign(
+      &result,
+      internal::subtract(internal::convert(left), internal::convert(right)));
+  return result;
 }
 
 
@@ -375,10 +431,9 @@ Value::Ranges& operator+=(Value::Ranges& left, const Value::Ranges& right)
 
 Value::Ranges& operator-=(Value::Ranges& left, const Value::Ranges& right)
 {
-  coalesce(&left);
-  for (int i = 0; i < right.range_size(); ++i) {
-    remove(&left, right.range(i));
-  }
+  internal::assign(
+      &left,
+      internal::subtract(internal::convert(left), internal::convert(right)));
   return left;
 }
 
@@ -15,6 +15,7 @@
 // limitations under the License
 
 #include <algorithm>
+#include <mutex>
 #include <queue>
 #include <utility>
 #include <vector>
@@ -27,13 +28,17 @@
 #include <stout/check.hpp>
 #include <stout/duration.hpp>
 #include <stout/error.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/none.hpp>
 #include <stout/numify.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
 #include <stout/result.hpp>
 #include <stout/some.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
+#include <stout/synchronized.hpp>
+#include <stout/unreachable.hpp>
 #include <stout/utils.hpp>
 
 #include "logging/logging.hpp"
@@ -47,6 +52,7 @@ using namespace process;
 using process::wait; // Necessary on some OS's to disambiguate.
 
 using std::make_pair;
+using std::pair;
 using std::queue;
 using std::set;
 using std::string;
@@ -968,6 +974,14 @@ string GroupProcess::zkBasename(const Group::Membership& membership)
 }
 
 
+// The processes of the shared groups by their keys, with the number
+// of groups using each of them. These are never deleted to avoid the
+// static destruction order problem.
+static std::mutex* sharedMutex = new std::mutex();
+static hashmap<string, pair<GroupProcess*, size_t> >* sharedProcesses =
+  new hashmap<string, pair<GroupProcess*, size_t> >();
+
+
 Group::Group(const string& servers,
              const Duration& timeout,
              const string& znode,
@@ -986,8 +1000,50 @@ Group::Group(const URL& url,
 }
 
 
+Group::Group(GroupProcess* _process, const string& _key)
+  : process(_process),
+    key(_key) {}
+
+
+Group* Group::shared(const URL& url, const Duration& timeout)
+{
+  // The URL includes the credentials, so the groups authenticated
+  // differently don't share a session.
+  const string key = stringify(url) + "?timeout=" + stringify(timeout);
+
+  synchronized (sharedMutex) {
+    if (!sharedProcesses->contains(key)) {
+      GroupProcess* process = new GroupProcess(url, timeout);
+      spawn(process);
+
+      (*sharedProcesses)[key] = make_pair(process, 0);
+    }
+
+    pair<GroupProcess*, size_t>& shared = (*sharedProcesses)[key];
+    shared.second++;
+
+    return new Group(shared.first, key);
+  }
+
+  UNREACHABLE();
+}
+
+
 Group::~Group()
 {
+  if (key.isSome()) {
+    synchronized (sharedMutex) {
+      CHECK(sharedProcesses->contains(key.get()));
+
+      // Only the last group using the process terminates it.
+      if (--(*sharedProcesses)[key.get()].second > 0) {
+        return;
+      }
+
+      sharedProcesses->erase(key.get());
+    }
+  }
+
   terminate(process);
   wait(process);
   delete process;
@@ -129,6 +129,14 @@ public:
   Group(const URL& url,
         const Duration& timeout);
 
+  // Returns a group that shares its ZooKeeper session, and thus the
+  // cached memberships, with the other groups in this process that
+  // this returned for the same URL and timeout. This is meant for
+  // groups that are only watched, e.g., by the master detectors of
+  // many frameworks in a scheduler process, as the memberships of a
+  // shared group get cancelled with the session of all of them.
+  static Group* shared(const URL& url, const Duration& timeout);
+
   ~Group();
 
   // Returns the result of trying to join a "group" in ZooKeeper.
@@ -163,6 +171,12 @@ public:
 
   // Made public for testing purposes.
   GroupProcess* process;
+
+private:
+  Group(GroupProcess* process, const std::string& key);
+
+  // The key of a shared group, see 'shared'.
+  const Option<std::string> key;
 };
 
 
@@ -302,6 +302,29 @@ public:
    */
   int set(const std::string& path, const std::string& data, int version);
 
+  /**
+   * \brief performs the operations atomically, i.e., either all of the
+   * operations succeed or none of them are applied.
+   *
+   * This method will create a multi-op transaction, the operations of
+   * which are initialized with zoo_create_op_init, zoo_delete_op_init,
+   * zoo_set_op_init and zoo_check_op_init. Any buffers the operations
+   * reference must stay valid until this method returns.
+   *
+   * \param ops the operations to perform.
+   * \param results the results of the operations, in the same order.
+   * \return the return code for the function call.
+   * ZOK operation completed succesfully
+   * the first failing operation's error code otherwise, e.g.,
+   * ZNODEEXISTS, ZNONODE or ZBADVERSION.
+   * ZBADARGUMENTS - invalid input parameters
+   * ZINVALIDSTATE - zhandle state is either ZOO_SESSION_EXPIRED_STATE or ZOO_AUTH_FAILED_STATE
+   * ZMARSHALLINGERROR - failed to marshall a request; possibly, out of memory
+   */
+  int multi(
+      const std::vector<zoo_op_t>& ops,
+      std::vector<zoo_op_result_t>* results);
+
   /**
    * \brief return a message describing the return code.
    *